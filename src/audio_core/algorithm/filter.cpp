@@ -9,10 +9,83 @@
 #include <cmath>
 #include <vector>
 #include "audio_core/algorithm/filter.h"
+#include "common/assert.h"
 #include "common/common_types.h"
 
+#ifdef ARCHITECTURE_x86_64
+#include <emmintrin.h>
+#endif
+
 namespace AudioCore {
 
+#ifdef ARCHITECTURE_x86_64
+/// Loads the first lane_count floats at source into the low lanes of a vector
+template <size_t lane_count>
+static __m128 LoadLanes(const float* source) {
+    if constexpr (lane_count == 4) {
+        return _mm_loadu_ps(source);
+    } else if constexpr (lane_count == 3) {
+        const __m128 low = _mm_castpd_ps(_mm_load_sd(reinterpret_cast<const double*>(source)));
+        return _mm_movelh_ps(low, _mm_load_ss(source + 2));
+    } else if constexpr (lane_count == 2) {
+        return _mm_castpd_ps(_mm_load_sd(reinterpret_cast<const double*>(source)));
+    } else {
+        return _mm_load_ss(source);
+    }
+}
+
+/// Stores the low lane_count lanes of a vector to destination
+template <size_t lane_count>
+static void StoreLanes(float* destination, __m128 value) {
+    if constexpr (lane_count == 4) {
+        _mm_storeu_ps(destination, value);
+    } else if constexpr (lane_count == 3) {
+        _mm_store_sd(reinterpret_cast<double*>(destination), _mm_castps_pd(value));
+        _mm_store_ss(destination + 2, _mm_movehl_ps(value, value));
+    } else if constexpr (lane_count == 2) {
+        _mm_store_sd(reinterpret_cast<double*>(destination), _mm_castps_pd(value));
+    } else {
+        _mm_store_ss(destination, value);
+    }
+}
+
+/// Biquad history of up to four channels, one per lane
+struct LaneHistory {
+    __m128 in1, in2, out1, out2;
+};
+
+/// Runs a biquad over lane_count adjacent channels of an interleaved signal, one channel per
+/// lane. The history stays in registers for the whole buffer.
+template <size_t lane_count>
+static void ProcessLanes(float* signal, size_t frame_count, size_t stride,
+                         const std::array<float, 5>& coeffs, LaneHistory& history) {
+    const __m128 a1 = _mm_set1_ps(coeffs[0]);
+    const __m128 a2 = _mm_set1_ps(coeffs[1]);
+    const __m128 b0 = _mm_set1_ps(coeffs[2]);
+    const __m128 b1 = _mm_set1_ps(coeffs[3]);
+    const __m128 b2 = _mm_set1_ps(coeffs[4]);
+    __m128 in1 = history.in1, in2 = history.in2;
+    __m128 out1 = history.out1, out2 = history.out2;
+
+    for (size_t i = 0; i < frame_count; i++) {
+        float* const frame = signal + i * stride;
+        const __m128 in0 = LoadLanes<lane_count>(frame);
+        const __m128 feed_forward = _mm_add_ps(
+            _mm_mul_ps(b0, in0), _mm_add_ps(_mm_mul_ps(b1, in1), _mm_mul_ps(b2, in2)));
+        const __m128 feedback = _mm_add_ps(_mm_mul_ps(a1, out1), _mm_mul_ps(a2, out2));
+        const __m128 out0 = _mm_sub_ps(feed_forward, feedback);
+        StoreLanes<lane_count>(frame, out0);
+
+        in2 = in1;
+        in1 = in0;
+        out2 = out1;
+        out1 = out0;
+    }
+
+    history = {in1, in2, out1, out2};
+}
+#endif
+
 Filter Filter::LowPass(double cutoff, double Q) {
     const double w0 = 2.0 * M_PI * cutoff;
     const double sin_w0 = std::sin(w0);
@@ -36,18 +109,106 @@ Filter::Filter(double a0, double a1, double a2, double b0, double b1, double b2)
 
 void Filter::Process(std::vector<s16>& signal) {
     const size_t num_frames = signal.size() / 2;
-    for (size_t i = 0; i < num_frames; i++) {
-        std::rotate(in.begin(), in.end() - 1, in.end());
-        std::rotate(out.begin(), out.end() - 1, out.end());
+    for (size_t ch = 0; ch < channel_count; ch++) {
+        // Keep the history in locals instead of rotating the arrays for every frame
+        double in1 = in[0][ch], in2 = in[1][ch];
+        double out1 = out[0][ch], out2 = out[1][ch];
 
-        for (size_t ch = 0; ch < channel_count; ch++) {
-            in[0][ch] = signal[i * channel_count + ch];
+        for (size_t i = 0; i < num_frames; i++) {
+            const double in0 = signal[i * channel_count + ch];
+            const double out0 = b0 * in0 + b1 * in1 + b2 * in2 - a1 * out1 - a2 * out2;
 
-            out[0][ch] = b0 * in[0][ch] + b1 * in[1][ch] + b2 * in[2][ch] - a1 * out[1][ch] -
-                         a2 * out[2][ch];
+            signal[i * channel_count + ch] = static_cast<s16>(std::clamp(out0, -32768.0, 32767.0));
 
-            signal[i * 2 + ch] = static_cast<s16>(std::clamp(out[0][ch], -32768.0, 32767.0));
+            in2 = in1;
+            in1 = in0;
+            out2 = out1;
+            out1 = out0;
         }
+
+        in[0][ch] = in1;
+        in[1][ch] = in2;
+        out[0][ch] = out1;
+        out[1][ch] = out2;
+    }
+}
+
+void Filter::Process(float* signal, size_t frame_count, size_t num_channels) {
+    ASSERT(num_channels <= max_channel_count);
+    size_t first_channel = 0;
+
+#ifdef ARCHITECTURE_x86_64
+    // The recursion runs across frames, so the parallelism is across channels: up to four of them
+    // are filtered at a time, one per lane. The float mix bus needs no clamping in between.
+    const std::array<float, 5> coeffs{static_cast<float>(a1), static_cast<float>(a2),
+                                      static_cast<float>(b0), static_cast<float>(b1),
+                                      static_cast<float>(b2)};
+
+    for (; first_channel < num_channels; first_channel += 4) {
+        // max_channel_count is a multiple of four, so the history always has four lanes to load
+        const size_t c = first_channel;
+        LaneHistory history{
+            _mm_setr_ps(static_cast<float>(in[0][c]), static_cast<float>(in[0][c + 1]),
+                        static_cast<float>(in[0][c + 2]), static_cast<float>(in[0][c + 3])),
+            _mm_setr_ps(static_cast<float>(in[1][c]), static_cast<float>(in[1][c + 1]),
+                        static_cast<float>(in[1][c + 2]), static_cast<float>(in[1][c + 3])),
+            _mm_setr_ps(static_cast<float>(out[0][c]), static_cast<float>(out[0][c + 1]),
+                        static_cast<float>(out[0][c + 2]), static_cast<float>(out[0][c + 3])),
+            _mm_setr_ps(static_cast<float>(out[1][c]), static_cast<float>(out[1][c + 1]),
+                        static_cast<float>(out[1][c + 2]), static_cast<float>(out[1][c + 3])),
+        };
+
+        float* const lanes_start = signal + first_channel;
+        const size_t lane_count = std::min<size_t>(4, num_channels - first_channel);
+        switch (lane_count) {
+        case 1:
+            ProcessLanes<1>(lanes_start, frame_count, num_channels, coeffs, history);
+            break;
+        case 2:
+            ProcessLanes<2>(lanes_start, frame_count, num_channels, coeffs, history);
+            break;
+        case 3:
+            ProcessLanes<3>(lanes_start, frame_count, num_channels, coeffs, history);
+            break;
+        default:
+            ProcessLanes<4>(lanes_start, frame_count, num_channels, coeffs, history);
+            break;
+        }
+
+        alignas(16) std::array<std::array<float, 4>, 4> stored;
+        _mm_store_ps(stored[0].data(), history.in1);
+        _mm_store_ps(stored[1].data(), history.in2);
+        _mm_store_ps(stored[2].data(), history.out1);
+        _mm_store_ps(stored[3].data(), history.out2);
+        for (size_t lane = 0; lane < lane_count; lane++) {
+            in[0][c + lane] = stored[0][lane];
+            in[1][c + lane] = stored[1][lane];
+            out[0][c + lane] = stored[2][lane];
+            out[1][c + lane] = stored[3][lane];
+        }
+    }
+#endif
+
+    for (size_t ch = first_channel; ch < num_channels; ch++) {
+        double in1 = in[0][ch], in2 = in[1][ch];
+        double out1 = out[0][ch], out2 = out[1][ch];
+
+        for (size_t i = 0; i < frame_count; i++) {
+            float& sample = signal[i * num_channels + ch];
+            const double in0 = sample;
+            const double out0 = b0 * in0 + b1 * in1 + b2 * in2 - a1 * out1 - a2 * out2;
+            sample = static_cast<float>(out0);
+
+            in2 = in1;
+            in1 = in0;
+            out2 = out1;
+            out1 = out0;
+        }
+
+        in[0][ch] = in1;
+        in[1][ch] = in2;
+        out[0][ch] = out1;
+        out[1][ch] = out2;
     }
 }
 
@@ -76,4 +237,12 @@ void CascadingFilter::Process(std::vector<s16>& signal) {
     }
 }
 
+void CascadingFilter::Process(float* signal, size_t frame_count, size_t num_channels) {
+    // Stage by stage over the whole buffer: a mix quantum fits in L1, so each pass keeps its
+    // biquad history in registers without the buffer leaving the cache in between.
+    for (auto& filter : filters) {
+        filter.Process(signal, frame_count, num_channels);
+    }
+}
+
 } // namespace AudioCore
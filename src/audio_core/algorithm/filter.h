@@ -5,6 +5,7 @@
 #pragma once
 
 #include <array>
+#include <cstddef>
 #include <vector>
 #include "common/common_types.h"
 
@@ -27,17 +28,26 @@ public:
 
     Filter(double a0, double a1, double a2, double b0, double b1, double b2);
 
+    /// Maximum number of interleaved channels the float path can filter.
+    static constexpr size_t max_channel_count = 8;
+
     void Process(std::vector<s16>& signal);
 
+    /// Filters interleaved float samples in place, with SIMD across channels where available.
+    /// @param signal Interleaved samples, frame_count * num_channels long.
+    /// @param frame_count Number of frames to filter.
+    /// @param num_channels Number of interleaved channels, at most max_channel_count.
+    void Process(float* signal, size_t frame_count, size_t num_channels);
+
 private:
     static constexpr size_t channel_count = 2;
 
     /// Coefficients are in normalized form (a0 = 1.0).
     double a1, a2, b0, b1, b2;
-    /// Input History
-    std::array<std::array<double, channel_count>, 3> in;
-    /// Output History
-    std::array<std::array<double, channel_count>, 3> out;
+    /// Input History, newest first
+    std::array<std::array<double, max_channel_count>, 2> in{};
+    /// Output History, newest first
+    std::array<std::array<double, max_channel_count>, 2> out{};
 };
 
 /// Cascade filters to build up higher-order filters from lower-order ones.
@@ -55,6 +65,9 @@ public:
 
     void Process(std::vector<s16>& signal);
 
+    /// Filters interleaved float samples in place, see Filter::Process.
+    void Process(float* signal, size_t frame_count, size_t num_channels);
+
 private:
     std::vector<Filter> filters;
 };
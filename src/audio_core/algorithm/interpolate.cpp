@@ -11,6 +11,10 @@
 #include "common/common_types.h"
 #include "common/logging/log.h"
 
+#ifdef ARCHITECTURE_x86_64
+#include <xmmintrin.h>
+#endif
+
 namespace AudioCore {
 
 /// The Lanczos kernel
@@ -21,9 +25,87 @@ static double Lanczos(size_t a, double x) {
     return a * std::sin(px) * std::sin(px / a) / (px * px);
 }
 
-std::vector<s16> Interpolate(InterpolationState& state, std::vector<s16> input, double ratio) {
+namespace {
+
+constexpr size_t taps = InterpolationState::lanczos_taps;
+constexpr size_t history_size = InterpolationState::history_size;
+
+/// Number of frames a single output frame is convolved from, padded to a multiple of four so the
+/// vector loop needs no tail. The padding taps have zero weight.
+constexpr size_t kernel_frames = 8;
+static_assert(kernel_frames >= history_size + 1, "Kernel does not cover the history");
+
+/// Resolution of the precomputed kernel positions, between which the weights are interpolated
+constexpr size_t kernel_phases = 256;
+
+/**
+ * Lanczos weights for kernel_phases + 1 evenly spaced positions in [0, 1]. Each weight is stored
+ * twice, once per channel, so a row lines up with interleaved stereo frames. This takes the sine
+ * evaluations out of the resampling loop entirely.
+ */
+struct KernelTable {
+    KernelTable() {
+        for (size_t phase = 0; phase <= kernel_phases; ++phase) {
+            const double pos = static_cast<double>(phase) / kernel_phases;
+            for (size_t k = 0; k < kernel_frames; ++k) {
+                // Frame k of the window is (history_size - k) frames older than the newest one
+                const float weight =
+                    k <= history_size
+                        ? static_cast<float>(Lanczos(taps, pos + static_cast<double>(taps) -
+                                                               1.0 - static_cast<double>(k)))
+                        : 0.0f;
+                rows[phase][k * 2 + 0] = weight;
+                rows[phase][k * 2 + 1] = weight;
+            }
+        }
+    }
+
+    alignas(16) std::array<std::array<float, kernel_frames * 2>, kernel_phases + 1> rows;
+};
+
+const KernelTable& GetKernelTable() {
+    static const KernelTable table;
+    return table;
+}
+
+/// Convolves kernel_frames interleaved stereo frames with the weights for position pos
+std::array<float, 2> Convolve(const float* frames, const KernelTable& table, double pos) {
+    const double scaled = std::clamp(pos, 0.0, 1.0) * kernel_phases;
+    const size_t phase = std::min(static_cast<size_t>(scaled), kernel_phases - 1);
+    const float fraction = static_cast<float>(scaled - phase);
+    const float* const row0 = table.rows[phase].data();
+    const float* const row1 = table.rows[phase + 1].data();
+
+#ifdef ARCHITECTURE_x86_64
+    const __m128 t = _mm_set1_ps(fraction);
+    __m128 sum = _mm_setzero_ps();
+    for (size_t i = 0; i < kernel_frames * 2; i += 4) {
+        const __m128 w0 = _mm_load_ps(row0 + i);
+        const __m128 w1 = _mm_load_ps(row1 + i);
+        const __m128 weight = _mm_add_ps(w0, _mm_mul_ps(_mm_sub_ps(w1, w0), t));
+        sum = _mm_add_ps(sum, _mm_mul_ps(weight, _mm_loadu_ps(frames + i)));
+    }
+    // Lanes hold {L, R, L, R}, fold the upper frame onto the lower one
+    sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+    alignas(16) std::array<float, 4> result;
+    _mm_store_ps(result.data(), sum);
+    return {result[0], result[1]};
+#else
+    std::array<float, 2> sum{};
+    for (size_t i = 0; i < kernel_frames * 2; ++i) {
+        sum[i % 2] += (row0[i] + (row1[i] - row0[i]) * fraction) * frames[i];
+    }
+    return sum;
+#endif
+}
+
+} // Anonymous namespace
+
+void Interpolate(InterpolationState& state, const std::vector<s16>& input,
+                 std::vector<s16>& output, double ratio) {
+    output.clear();
     if (input.size() < 2)
-        return {};
+        return;
 
     if (ratio <= 0) {
         LOG_CRITICAL(Audio, "Nonsensical interpolation ratio {}", ratio);
@@ -35,37 +117,44 @@ std::vector<s16> Interpolate(InterpolationState& state, std::vector<s16> input,
         state.nyquist = CascadingFilter::LowPass(std::clamp(cutoff_frequency, 0.0, 0.4), 3);
         state.current_ratio = ratio;
     }
-    state.nyquist.Process(input);
 
-    constexpr size_t taps = InterpolationState::lanczos_taps;
     const size_t num_frames = input.size() / 2;
 
-    std::vector<s16> output;
+    // Lay the history and the input out contiguously, followed by the zero padding frames
+    auto& window = state.window;
+    window.resize((history_size + num_frames + kernel_frames - history_size - 1) * 2);
+    for (size_t i = 0; i < history_size; ++i) {
+        window[i * 2 + 0] = state.history[i][0];
+        window[i * 2 + 1] = state.history[i][1];
+    }
+    std::copy(input.begin(), input.begin() + num_frames * 2, window.begin() + history_size * 2);
+    std::fill(window.begin() + (history_size + num_frames) * 2, window.end(), 0.0f);
+
+    // Filter the input once it is in float form, so the stages need no clamping in between
+    state.nyquist.Process(window.data() + history_size * 2, num_frames, 2);
+
     output.reserve(static_cast<size_t>(input.size() / ratio + 4));
 
+    const KernelTable& table = GetKernelTable();
     double& pos = state.position;
-    auto& h = state.history;
     for (size_t i = 0; i < num_frames; ++i) {
-        std::rotate(h.begin(), h.end() - 1, h.end());
-        h[0][0] = input[i * 2 + 0];
-        h[0][1] = input[i * 2 + 1];
+        // Window frame i is the oldest one the kernel needs for input frame i
+        const float* const frames = window.data() + i * 2;
 
         while (pos <= 1.0) {
-            double l = 0.0;
-            double r = 0.0;
-            for (size_t j = 0; j < h.size(); j++) {
-                l += Lanczos(taps, pos + j - taps + 1) * h[j][0];
-                r += Lanczos(taps, pos + j - taps + 1) * h[j][1];
-            }
-            output.emplace_back(static_cast<s16>(std::clamp(l, -32768.0, 32767.0)));
-            output.emplace_back(static_cast<s16>(std::clamp(r, -32768.0, 32767.0)));
+            const auto [l, r] = Convolve(frames, table, pos);
+            output.emplace_back(static_cast<s16>(std::clamp(l, -32768.0f, 32767.0f)));
+            output.emplace_back(static_cast<s16>(std::clamp(r, -32768.0f, 32767.0f)));
 
             pos += ratio;
         }
         pos -= 1.0;
     }
 
-    return output;
+    for (size_t i = 0; i < history_size; ++i) {
+        const float* const frame = window.data() + (num_frames + i) * 2;
+        state.history[i] = {frame[0], frame[1]};
+    }
 }
 
 } // namespace AudioCore
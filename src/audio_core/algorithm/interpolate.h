@@ -13,31 +13,37 @@ namespace AudioCore {
 
 struct InterpolationState {
     static constexpr size_t lanczos_taps = 4;
-    static constexpr size_t history_size = lanczos_taps * 2 - 1;
+    /// Input frames before the current one that the kernel reaches back to
+    static constexpr size_t history_size = lanczos_taps * 2 - 2;
 
     double current_ratio = 0.0;
     CascadingFilter nyquist;
-    std::array<std::array<s16, 2>, history_size> history = {};
+    /// Last filtered input frames of the previous call, oldest first
+    std::array<std::array<float, 2>, history_size> history = {};
     double position = 0;
+    /// History followed by the current input as floats, kept to reuse its storage
+    std::vector<float> window;
 };
 
-/// Interpolates input signal to produce output signal.
+/// Interpolates input signal to produce output signal. Consecutive calls with the same state
+/// continue the same stream.
 /// @param input The signal to interpolate.
+/// @param output Receives the output signal, its storage is reused.
 /// @param ratio Interpolation ratio.
 ///              ratio > 1.0 results in fewer output samples.
 ///              ratio < 1.0 results in more output samples.
-/// @returns Output signal.
-std::vector<s16> Interpolate(InterpolationState& state, std::vector<s16> input, double ratio);
+void Interpolate(InterpolationState& state, const std::vector<s16>& input,
+                 std::vector<s16>& output, double ratio);
 
 /// Interpolates input signal to produce output signal.
 /// @param input The signal to interpolate.
+/// @param output Receives the output signal, its storage is reused.
 /// @param input_rate The sample rate of input.
 /// @param output_rate The desired sample rate of the output.
-/// @returns Output signal.
-inline std::vector<s16> Interpolate(InterpolationState& state, std::vector<s16> input,
-                                    u32 input_rate, u32 output_rate) {
+inline void Interpolate(InterpolationState& state, const std::vector<s16>& input,
+                        std::vector<s16>& output, u32 input_rate, u32 output_rate) {
     const double ratio = static_cast<double>(input_rate) / static_cast<double>(output_rate);
-    return Interpolate(state, std::move(input), ratio);
+    Interpolate(state, input, output, ratio);
 }
 
 } // namespace AudioCore
@@ -0,0 +1,74 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <cmath>
+#include "audio_core/algorithm/mix.h"
+
+#ifdef ARCHITECTURE_x86_64
+#include <emmintrin.h>
+#endif
+
+namespace AudioCore {
+
+void MixStereo(float* bus, const s16* samples, size_t frame_count, const StereoMixMatrix& matrix) {
+    size_t frame = 0;
+
+#ifdef ARCHITECTURE_x86_64
+    // SSE2 is part of the x86-64 baseline, so this needs no runtime detection. Four frames are
+    // mixed at a time: each lane is scaled by its own channel's gain, and the lanes swapped
+    // within each frame by the other channel's gain.
+    const __m128 direct_gain = _mm_setr_ps(matrix[0], matrix[3], matrix[0], matrix[3]);
+    const __m128 cross_gain = _mm_setr_ps(matrix[1], matrix[2], matrix[1], matrix[2]);
+
+    for (; frame + 4 <= frame_count; frame += 4) {
+        const __m128i input = _mm_loadu_si128(reinterpret_cast<const __m128i*>(samples));
+        // Sign-extend the 16-bit samples by placing them in the upper half of each 32-bit lane
+        const __m128 low = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(input, input), 16));
+        const __m128 high = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(input, input), 16));
+        const __m128 low_swapped = _mm_shuffle_ps(low, low, _MM_SHUFFLE(2, 3, 0, 1));
+        const __m128 high_swapped = _mm_shuffle_ps(high, high, _MM_SHUFFLE(2, 3, 0, 1));
+
+        __m128 bus_low = _mm_loadu_ps(bus);
+        __m128 bus_high = _mm_loadu_ps(bus + 4);
+        bus_low = _mm_add_ps(bus_low, _mm_add_ps(_mm_mul_ps(low, direct_gain),
+                                                 _mm_mul_ps(low_swapped, cross_gain)));
+        bus_high = _mm_add_ps(bus_high, _mm_add_ps(_mm_mul_ps(high, direct_gain),
+                                                   _mm_mul_ps(high_swapped, cross_gain)));
+        _mm_storeu_ps(bus, bus_low);
+        _mm_storeu_ps(bus + 4, bus_high);
+
+        samples += 8;
+        bus += 8;
+    }
+#endif
+
+    for (; frame < frame_count; ++frame) {
+        const float left = samples[0];
+        const float right = samples[1];
+        bus[0] += left * matrix[0] + right * matrix[1];
+        bus[1] += left * matrix[2] + right * matrix[3];
+        samples += 2;
+        bus += 2;
+    }
+}
+
+void ConvertToS16(s16* output, const float* bus, size_t sample_count) {
+    size_t index = 0;
+
+#ifdef ARCHITECTURE_x86_64
+    for (; index + 8 <= sample_count; index += 8) {
+        const __m128i low = _mm_cvtps_epi32(_mm_loadu_ps(bus + index));
+        const __m128i high = _mm_cvtps_epi32(_mm_loadu_ps(bus + index + 4));
+        // packs saturates to the s16 range
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(output + index), _mm_packs_epi32(low, high));
+    }
+#endif
+
+    for (; index < sample_count; ++index) {
+        output[index] = static_cast<s16>(std::lrint(std::clamp(bus[index], -32768.0f, 32767.0f)));
+    }
+}
+
+} // namespace AudioCore
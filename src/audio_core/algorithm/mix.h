@@ -0,0 +1,29 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include "common/common_types.h"
+
+namespace AudioCore {
+
+/// Gains from a stereo voice to the stereo mix bus: {L->L, R->L, L->R, R->R}
+using StereoMixMatrix = std::array<float, 4>;
+
+/// Accumulates interleaved stereo PCM16 frames into a float mix bus.
+/// @param bus Interleaved stereo mix bus, frame_count frames long.
+/// @param samples Interleaved stereo samples to mix in.
+/// @param frame_count Number of frames to mix.
+/// @param matrix Gains to apply while mixing.
+void MixStereo(float* bus, const s16* samples, size_t frame_count, const StereoMixMatrix& matrix);
+
+/// Converts a float mix bus to PCM16, saturating samples that are out of range.
+/// @param output Where to write the converted samples.
+/// @param bus Mix bus to convert.
+/// @param sample_count Number of samples (not frames) to convert.
+void ConvertToS16(s16* output, const float* bus, size_t sample_count);
+
+} // namespace AudioCore
@@ -51,8 +51,12 @@ void AudioOut::StopStream(StreamPtr stream) {
     stream->Stop();
 }
 
-bool AudioOut::QueueBuffer(StreamPtr stream, Buffer::Tag tag, std::vector<s16>&& data) {
-    return stream->QueueBuffer(std::make_shared<Buffer>(tag, std::move(data)));
+BufferPtr AudioOut::AcquireBuffer(StreamPtr stream, Buffer::Tag tag) {
+    return stream->AcquireBuffer(tag);
+}
+
+bool AudioOut::QueueBuffer(StreamPtr stream, BufferPtr&& buffer) {
+    return stream->QueueBuffer(std::move(buffer));
 }
 
 } // namespace AudioCore
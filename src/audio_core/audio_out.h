@@ -33,8 +33,11 @@ public:
     /// Stops an audio stream that is currently playing
     void StopStream(StreamPtr stream);
 
+    /// Takes a buffer from the pool of the specified stream, returns nullptr if none is free
+    BufferPtr AcquireBuffer(StreamPtr stream, Buffer::Tag tag);
+
     /// Queues a buffer into the specified audio stream, returns true on success
-    bool QueueBuffer(StreamPtr stream, Buffer::Tag tag, std::vector<s16>&& data);
+    bool QueueBuffer(StreamPtr stream, BufferPtr&& buffer);
 
 private:
     SinkPtr sink;
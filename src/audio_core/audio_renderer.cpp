@@ -2,29 +2,64 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
+#include <cmath>
+
 #include "audio_core/algorithm/interpolate.h"
 #include "audio_core/audio_renderer.h"
 #include "common/assert.h"
 #include "common/logging/log.h"
 #include "core/memory.h"
+#include "core/settings.h"
 
 namespace AudioCore {
 
 constexpr u32 STREAM_SAMPLE_RATE{48000};
 constexpr u32 STREAM_NUM_CHANNELS{2};
+/// Range the mix quantum setting is clamped to, in frames
+constexpr u32 MIN_MIX_BUFFER_FRAMES{64};
+constexpr u32 MAX_MIX_BUFFER_FRAMES{4096};
+/// Range the queue depth setting is clamped to, in buffers
+constexpr u32 MIN_QUEUED_BUFFERS{2};
+constexpr u32 MAX_QUEUED_BUFFERS{8};
+/// Buffers the audio thread mixes ahead of the stream, on top of the ones queued to it
+constexpr size_t MIX_AHEAD_BUFFERS{2};
 
 AudioRenderer::AudioRenderer(AudioRendererParameter params,
                              Kernel::SharedPtr<Kernel::Event> buffer_event)
-    : worker_params{params}, buffer_event{buffer_event}, voices(params.voice_count) {
+    : worker_params{params}, buffer_event{buffer_event}, voice_status(params.voice_count),
+      copied_wave_buffers(params.voice_count), voices(params.voice_count),
+      mix_buffer_frames{std::clamp(Settings::values.audio_mix_quantum, MIN_MIX_BUFFER_FRAMES,
+                                   MAX_MIX_BUFFER_FRAMES)},
+      mix_buffer(mix_buffer_frames * STREAM_NUM_CHANNELS) {
 
     audio_core = std::make_unique<AudioCore::AudioOut>();
     stream = audio_core->OpenStream(STREAM_SAMPLE_RATE, STREAM_NUM_CHANNELS, "AudioRenderer",
                                     [=]() { buffer_event->Signal(); });
     audio_core->StartStream(stream);
 
-    QueueMixedBuffer(0);
-    QueueMixedBuffer(1);
-    QueueMixedBuffer(2);
+    // No voice is playing yet, start the stream with silence. Buffers are only ever released to
+    // be replaced, so this also sets how many stay queued ahead of playback.
+    const u32 queue_depth{
+        std::clamp(Settings::values.audio_queue_depth, MIN_QUEUED_BUFFERS, MAX_QUEUED_BUFFERS)};
+    for (Buffer::Tag tag = 0; tag < queue_depth; ++tag) {
+        BufferPtr buffer{audio_core->AcquireBuffer(stream, tag)};
+        buffer->Samples().assign(mix_buffer_frames * STREAM_NUM_CHANNELS, 0);
+        audio_core->QueueBuffer(stream, std::move(buffer));
+    }
+
+    static_assert(MIX_AHEAD_BUFFERS < MIX_SLOT_COUNT, "Not enough mix slots");
+    for (u32 slot = 0; slot < MIX_SLOT_COUNT; ++slot) {
+        free_slots.Push(&slot, 1);
+    }
+
+    audio_thread = std::thread{[this] { AudioThreadLoop(); }};
+}
+
+AudioRenderer::~AudioRenderer() {
+    stop_audio_thread = true;
+    audio_thread_event.Set();
+    audio_thread.join();
 }
 
 u32 AudioRenderer::GetSampleRate() const {
@@ -51,24 +86,18 @@ std::vector<u8> AudioRenderer::UpdateAudioRenderer(const std::vector<u8>& input_
                 input_params.data() + sizeof(UpdateDataHeader) + config.behavior_size,
                 memory_pool_count * sizeof(MemoryPoolInfo));
 
-    // Copy VoiceInfo structs
-    size_t offset{sizeof(UpdateDataHeader) + config.behavior_size + config.memory_pools_size +
-                  config.voice_resource_size};
-    for (auto& voice : voices) {
-        std::memcpy(&voice.Info(), input_params.data() + offset, sizeof(VoiceInfo));
-        offset += sizeof(VoiceInfo);
-    }
-
-    // Update voices
-    for (auto& voice : voices) {
-        voice.UpdateState();
-        if (!voice.GetInfo().is_in_use) {
-            continue;
-        }
-        if (voice.GetInfo().is_new) {
-            voice.SetWaveIndex(voice.GetInfo().wave_buffer_head);
-        }
+    // Copy VoiceInfo structs and hand them to the audio thread, which owns the voices. The
+    // audio thread never reads guest memory, so the data they point to is copied here as well.
+    const size_t offset{sizeof(UpdateDataHeader) + config.behavior_size +
+                        config.memory_pools_size + config.voice_resource_size};
+    std::vector<VoiceUpdate> voice_update(worker_params.voice_count);
+    for (size_t index = 0; index < voice_update.size(); ++index) {
+        std::memcpy(&voice_update[index].info,
+                    input_params.data() + offset + index * sizeof(VoiceInfo), sizeof(VoiceInfo));
+        CopyVoiceData(index, voice_update[index]);
     }
+    voice_updates.Push(std::move(voice_update));
+    audio_thread_event.Set();
 
     // Update memory pool state
     std::vector<MemoryPoolEntry> memory_pool(memory_pool_count);
@@ -94,32 +123,63 @@ std::vector<u8> AudioRenderer::UpdateAudioRenderer(const std::vector<u8>& input_
 
     // Copy output voice status
     size_t voice_out_status_offset{sizeof(UpdateDataHeader) + response_data.memory_pools_size};
-    for (const auto& voice : voices) {
-        std::memcpy(output_params.data() + voice_out_status_offset, &voice.GetOutStatus(),
-                    sizeof(VoiceOutStatus));
-        voice_out_status_offset += sizeof(VoiceOutStatus);
-    }
+    std::memcpy(output_params.data() + voice_out_status_offset, voice_status.data(),
+                voice_status.size() * sizeof(VoiceOutStatus));
 
     return output_params;
 }
 
+void AudioRenderer::CopyVoiceData(size_t index, VoiceUpdate& update) {
+    const VoiceInfo& info{update.info};
+    if (!info.is_in_use) {
+        return;
+    }
+
+    if (static_cast<Codec::PcmFormat>(info.sample_format) == Codec::PcmFormat::Adpcm) {
+        Memory::ReadBlock(info.additional_params_addr, update.adpcm_coeffs.data(),
+                          sizeof(Codec::ADPCM_Coeff));
+    }
+
+    auto& copied{copied_wave_buffers[index]};
+    for (size_t wave_index = 0; wave_index < info.wave_buffer.size(); ++wave_index) {
+        const auto& wave_buffer{info.wave_buffer[wave_index]};
+        const std::pair<VAddr, u64> key{wave_buffer.buffer_addr, wave_buffer.buffer_sz};
+
+        // Buffers the game appended since the last update are not marked as sent yet. Games
+        // refill the same memory between appends, so an unchanged address does not mean the
+        // copy is still current.
+        if (!info.is_new && wave_buffer.sent_to_server && copied[wave_index] == key) {
+            continue;
+        }
+
+        std::vector<u8> data(wave_buffer.buffer_sz);
+        Memory::ReadBlock(wave_buffer.buffer_addr, data.data(), data.size());
+        update.wave_data[wave_index] = std::move(data);
+        copied[wave_index] = key;
+    }
+}
+
 void AudioRenderer::VoiceState::SetWaveIndex(size_t index) {
     wave_index = index & 3;
     is_refresh_pending = true;
 }
 
-std::vector<s16> AudioRenderer::VoiceState::DequeueSamples(size_t sample_count) {
+size_t AudioRenderer::VoiceState::DequeueSamples(size_t frame_count, const s16*& out_samples) {
     if (!IsPlaying()) {
-        return {};
+        return 0;
     }
 
     if (is_refresh_pending) {
         RefreshBuffer();
     }
 
+    if (offset == samples.size()) {
+        ResampleNextChunk(frame_count);
+    }
+
     const size_t max_size{samples.size() - offset};
     const size_t dequeue_offset{offset};
-    size_t size{sample_count * STREAM_NUM_CHANNELS};
+    size_t size{frame_count * STREAM_NUM_CHANNELS};
     if (size > max_size) {
         size = max_size;
     }
@@ -128,11 +188,11 @@ std::vector<s16> AudioRenderer::VoiceState::DequeueSamples(size_t sample_count)
     offset += size;
 
     const auto& wave_buffer{info.wave_buffer[wave_index]};
-    if (offset == samples.size()) {
-        offset = 0;
-
+    if (offset == samples.size() && IsSourceExhausted()) {
         if (!wave_buffer.is_looping) {
             SetWaveIndex(wave_index + 1);
+        } else {
+            RestartSource();
         }
 
         out_status.wave_buffer_consumed++;
@@ -142,7 +202,9 @@ std::vector<s16> AudioRenderer::VoiceState::DequeueSamples(size_t sample_count)
         }
     }
 
-    return {samples.begin() + dequeue_offset, samples.begin() + dequeue_offset + size};
+    // Samples are only replaced on the next call, so this stays valid until then
+    out_samples = samples.data() + dequeue_offset;
+    return size / STREAM_NUM_CHANNELS;
 }
 
 void AudioRenderer::VoiceState::UpdateState() {
@@ -154,64 +216,188 @@ void AudioRenderer::VoiceState::UpdateState() {
         out_status = {};
     }
     is_in_use = info.is_in_use;
+
+    // Splitter and submix routing is not parsed yet, the voice volume goes to both channels
+    mix_matrix = {info.volume, 0.0f, 0.0f, info.volume};
 }
 
 void AudioRenderer::VoiceState::RefreshBuffer() {
-    std::vector<s16> new_samples(info.wave_buffer[wave_index].buffer_sz / sizeof(s16));
-    Memory::ReadBlock(info.wave_buffer[wave_index].buffer_addr, new_samples.data(),
-                      info.wave_buffer[wave_index].buffer_sz);
+    // Nothing is decoded up front, DequeueSamples decodes as much as each mix needs
+    adpcm_start_state = adpcm_state;
+    RestartSource();
+    samples.clear();
+    offset = 0;
+
+    is_refresh_pending = false;
+}
+
+size_t AudioRenderer::VoiceState::GetSourceFrameCount() const {
+    const size_t buffer_size{wave_data[wave_index].size()};
+    if (info.channel_count == 0) {
+        return 0;
+    }
+
+    switch (static_cast<Codec::PcmFormat>(info.sample_format)) {
+    case Codec::PcmFormat::Adpcm:
+        return buffer_size / Codec::ADPCM_FRAME_SIZE * Codec::ADPCM_SAMPLES_PER_FRAME /
+               info.channel_count;
+    default:
+        return buffer_size / sizeof(s16) / info.channel_count;
+    }
+}
+
+void AudioRenderer::VoiceState::RestartSource() {
+    source_offset = 0;
+    adpcm_state = adpcm_start_state;
+    adpcm_frames_decoded = 0;
+    adpcm_samples.clear();
+    adpcm_offset = 0;
+}
+
+size_t AudioRenderer::VoiceState::DecodeSource(size_t frame_count) {
+    const auto& data{wave_data[wave_index]};
+    const size_t channel_count{info.channel_count};
+    if (channel_count != 1 && channel_count != 2) {
+        LOG_CRITICAL(Audio, "Unimplemented channel_count={}", info.channel_count);
+        UNREACHABLE();
+        return 0;
+    }
+
+    frame_count = std::min(frame_count, GetSourceFrameCount() - source_offset);
+    const size_t sample_count{frame_count * channel_count};
+    source_samples.resize(frame_count * STREAM_NUM_CHANNELS);
 
     switch (static_cast<Codec::PcmFormat>(info.sample_format)) {
     case Codec::PcmFormat::Int16: {
         // PCM16 is played as-is
+        std::memcpy(source_samples.data(),
+                    data.data() + source_offset * channel_count * sizeof(s16),
+                    sample_count * sizeof(s16));
         break;
     }
     case Codec::PcmFormat::Adpcm: {
         // Decode ADPCM to PCM16
-        Codec::ADPCM_Coeff coeffs;
-        Memory::ReadBlock(info.additional_params_addr, coeffs.data(), sizeof(Codec::ADPCM_Coeff));
-        new_samples = Codec::DecodeADPCM(reinterpret_cast<u8*>(new_samples.data()),
-                                         new_samples.size() * sizeof(s16), coeffs, adpcm_state);
+        DecodeADPCMSamples(source_samples.data(), sample_count);
         break;
     }
     default:
         LOG_CRITICAL(Audio, "Unimplemented sample_format={}", info.sample_format);
         UNREACHABLE();
-        break;
+        return 0;
     }
 
-    switch (info.channel_count) {
-    case 1:
-        // 1 channel is upsampled to 2 channel
-        samples.resize(new_samples.size() * 2);
-        for (size_t index = 0; index < new_samples.size(); ++index) {
-            samples[index * 2] = new_samples[index];
-            samples[index * 2 + 1] = new_samples[index];
+    if (channel_count == 1) {
+        // 1 channel is upsampled to 2 channel, back to front so it can be done in place
+        for (size_t index = frame_count; index-- > 0;) {
+            const s16 sample{source_samples[index]};
+            source_samples[index * 2] = sample;
+            source_samples[index * 2 + 1] = sample;
         }
-        break;
-    case 2: {
-        // 2 channel is played as is
-        samples = std::move(new_samples);
-        break;
     }
-    default:
-        LOG_CRITICAL(Audio, "Unimplemented channel_count={}", info.channel_count);
-        UNREACHABLE();
-        break;
+
+    source_offset += frame_count;
+    return frame_count;
+}
+
+void AudioRenderer::VoiceState::DecodeADPCMSamples(s16* output, size_t sample_count) {
+    const auto& data{wave_data[wave_index]};
+    const size_t total_frames{data.size() / Codec::ADPCM_FRAME_SIZE};
+
+    while (sample_count > 0) {
+        if (adpcm_offset == adpcm_samples.size()) {
+            // Decode only the frames this request needs, what is left of the last one is kept
+            const size_t frame_count{
+                std::min(total_frames - adpcm_frames_decoded,
+                         (sample_count + Codec::ADPCM_SAMPLES_PER_FRAME - 1) /
+                             Codec::ADPCM_SAMPLES_PER_FRAME)};
+            if (frame_count == 0) {
+                break;
+            }
+
+            adpcm_samples.resize(frame_count * Codec::ADPCM_SAMPLES_PER_FRAME);
+            Codec::DecodeADPCM(data.data() + adpcm_frames_decoded * Codec::ADPCM_FRAME_SIZE,
+                               frame_count * Codec::ADPCM_FRAME_SIZE, adpcm_coeffs, adpcm_state,
+                               adpcm_samples.data());
+            adpcm_frames_decoded += frame_count;
+            adpcm_offset = 0;
+        }
+
+        const size_t copy_count{std::min(sample_count, adpcm_samples.size() - adpcm_offset)};
+        std::copy_n(adpcm_samples.begin() + adpcm_offset, copy_count, output);
+        adpcm_offset += copy_count;
+        output += copy_count;
+        sample_count -= copy_count;
     }
+}
 
-    samples = Interpolate(interp_state, std::move(samples), Info().sample_rate, STREAM_SAMPLE_RATE);
+void AudioRenderer::VoiceState::ResampleNextChunk(size_t frame_count) {
+    samples.clear();
+    offset = 0;
 
-    is_refresh_pending = false;
+    const double ratio{static_cast<double>(info.sample_rate) / STREAM_SAMPLE_RATE};
+    const size_t source_frames{
+        std::max<size_t>(1, static_cast<size_t>(std::ceil(frame_count * ratio)))};
+
+    // Very low rates can take several source frames before the resampler emits any
+    while (samples.empty() && !IsSourceExhausted()) {
+        if (DecodeSource(source_frames) == 0) {
+            break;
+        }
+        Interpolate(interp_state, source_samples, samples, info.sample_rate, STREAM_SAMPLE_RATE);
+    }
 }
 
-static constexpr s16 ClampToS16(s32 value) {
-    return static_cast<s16>(std::clamp(value, -32768, 32767));
+void AudioRenderer::AudioThreadLoop() {
+    Common::SetCurrentThreadName("AudioRenderer");
+
+    while (!stop_audio_thread) {
+        ApplyVoiceUpdates();
+
+        u32 slot;
+        if (mixed_slots.Size() >= MIX_AHEAD_BUFFERS || free_slots.Pop(&slot, 1) == 0) {
+            audio_thread_event.Wait();
+            continue;
+        }
+
+        MixedBuffer& mixed{mix_slots[slot]};
+        MixVoices(mixed.samples);
+
+        mixed.voice_status.resize(voices.size());
+        for (size_t index = 0; index < voices.size(); ++index) {
+            mixed.voice_status[index] = voices[index].GetOutStatus();
+        }
+
+        mixed_slots.Push(&slot, 1);
+        buffer_mixed_event.Set();
+    }
 }
 
-void AudioRenderer::QueueMixedBuffer(Buffer::Tag tag) {
-    constexpr size_t BUFFER_SIZE{512};
-    std::vector<s16> buffer(BUFFER_SIZE * stream->GetNumChannels());
+void AudioRenderer::ApplyVoiceUpdates() {
+    std::vector<VoiceUpdate> voice_update;
+    while (voice_updates.Pop(voice_update)) {
+        for (size_t index = 0; index < voices.size(); ++index) {
+            auto& voice{voices[index]};
+            auto& update{voice_update[index]};
+            voice.Info() = update.info;
+            voice.UpdateState();
+            if (!voice.GetInfo().is_in_use) {
+                continue;
+            }
+            voice.SetADPCMCoeffs(update.adpcm_coeffs);
+            for (size_t wave_index = 0; wave_index < update.wave_data.size(); ++wave_index) {
+                if (update.wave_data[wave_index]) {
+                    voice.SetWaveData(wave_index, std::move(*update.wave_data[wave_index]));
+                }
+            }
+            if (voice.GetInfo().is_new) {
+                voice.SetWaveIndex(voice.GetInfo().wave_buffer_head);
+            }
+        }
+    }
+}
+
+void AudioRenderer::MixVoices(std::vector<s16>& buffer) {
+    std::fill(mix_buffer.begin(), mix_buffer.end(), 0.0f);
 
     for (auto& voice : voices) {
         if (!voice.IsPlaying()) {
@@ -219,30 +405,48 @@ void AudioRenderer::QueueMixedBuffer(Buffer::Tag tag) {
         }
 
         size_t offset{};
-        s64 samples_remaining{BUFFER_SIZE};
-        while (samples_remaining > 0) {
-            const std::vector<s16> samples{voice.DequeueSamples(samples_remaining)};
+        size_t frames_remaining{mix_buffer_frames};
+        while (frames_remaining > 0) {
+            const s16* samples{};
+            const size_t frame_count{voice.DequeueSamples(frames_remaining, samples)};
 
-            if (samples.empty()) {
+            if (frame_count == 0) {
                 break;
             }
 
-            samples_remaining -= samples.size() / stream->GetNumChannels();
-
-            for (const auto& sample : samples) {
-                const s32 buffer_sample{buffer[offset]};
-                buffer[offset++] =
-                    ClampToS16(buffer_sample + static_cast<s32>(sample * voice.GetInfo().volume));
-            }
+            MixStereo(mix_buffer.data() + offset, samples, frame_count, voice.GetMixMatrix());
+            offset += frame_count * STREAM_NUM_CHANNELS;
+            frames_remaining -= frame_count;
         }
     }
-    audio_core->QueueBuffer(stream, tag, std::move(buffer));
+
+    // Slots keep their capacity, so this only allocates the first time a slot is used
+    buffer.resize(mix_buffer.size());
+    ConvertToS16(buffer.data(), mix_buffer.data(), mix_buffer.size());
 }
 
 void AudioRenderer::ReleaseAndQueueBuffers() {
-    const auto released_buffers{audio_core->GetTagsAndReleaseBuffers(stream, 2)};
-    for (const auto& tag : released_buffers) {
-        QueueMixedBuffer(tag);
+    const auto released_tags{audio_core->GetTagsAndReleaseBuffers(stream, 2)};
+    for (const Buffer::Tag tag : released_tags) {
+        u32 slot;
+        while (mixed_slots.Pop(&slot, 1) == 0) {
+            // The audio thread fell behind, waiting for it is still better than a gap
+            buffer_mixed_event.Wait();
+        }
+        MixedBuffer& mixed{mix_slots[slot]};
+
+        // A buffer was just returned to the pool, so this cannot fail
+        BufferPtr buffer{audio_core->AcquireBuffer(stream, tag)};
+        ASSERT(buffer);
+
+        // Trade storage with the slot instead of copying, both sides keep their capacity
+        buffer->Samples().swap(mixed.samples);
+        voice_status.swap(mixed.voice_status);
+
+        free_slots.Push(&slot, 1);
+        audio_thread_event.Set();
+
+        audio_core->QueueBuffer(stream, std::move(buffer));
     }
 }
 
@@ -5,15 +5,23 @@
 #pragma once
 
 #include <array>
+#include <atomic>
 #include <memory>
+#include <thread>
+#include <utility>
 #include <vector>
 
+#include <boost/optional.hpp>
 #include "audio_core/algorithm/interpolate.h"
+#include "audio_core/algorithm/mix.h"
 #include "audio_core/audio_out.h"
 #include "audio_core/codec.h"
 #include "audio_core/stream.h"
 #include "common/common_types.h"
+#include "common/ring_buffer.h"
 #include "common/swap.h"
+#include "common/thread.h"
+#include "common/threadsafe_queue.h"
 #include "core/hle/kernel/event.h"
 
 namespace AudioCore {
@@ -158,8 +166,9 @@ static_assert(sizeof(UpdateDataHeader) == 0x40, "UpdateDataHeader has wrong size
 class AudioRenderer {
 public:
     AudioRenderer(AudioRendererParameter params, Kernel::SharedPtr<Kernel::Event> buffer_event);
+    ~AudioRenderer();
     std::vector<u8> UpdateAudioRenderer(const std::vector<u8>& input_params);
-    void QueueMixedBuffer(Buffer::Tag tag);
+    /// Queues buffers mixed by the audio thread in place of the ones the stream released
     void ReleaseAndQueueBuffers();
     u32 GetSampleRate() const;
     u32 GetSampleCount() const;
@@ -184,28 +193,131 @@ private:
             return info;
         }
 
+        const StereoMixMatrix& GetMixMatrix() const {
+            return mix_matrix;
+        }
+
         void SetWaveIndex(size_t index);
-        std::vector<s16> DequeueSamples(size_t sample_count);
+
+        /// Replaces the data of the wave buffer at index with a copy taken when it was queued
+        void SetWaveData(size_t index, std::vector<u8> data) {
+            wave_data[index] = std::move(data);
+        }
+
+        void SetADPCMCoeffs(const Codec::ADPCM_Coeff& coeffs) {
+            adpcm_coeffs = coeffs;
+        }
+
+        /**
+         * Dequeues up to frame_count stereo frames of the current wave buffer without copying
+         * them. The samples stay valid until the next call.
+         * @returns Number of frames dequeued
+         */
+        size_t DequeueSamples(size_t frame_count, const s16*& out_samples);
         void UpdateState();
         void RefreshBuffer();
 
     private:
+        /// Returns the number of source frames in the current wave buffer
+        size_t GetSourceFrameCount() const;
+
+        bool IsSourceExhausted() const {
+            return source_offset >= GetSourceFrameCount();
+        }
+
+        /// Rewinds to the start of the current wave buffer, for looping
+        void RestartSource();
+
+        /// Decodes up to frame_count source frames into source_samples as stereo
+        size_t DecodeSource(size_t frame_count);
+
+        /// Decodes sample_count samples of the current ADPCM wave buffer into output
+        void DecodeADPCMSamples(s16* output, size_t sample_count);
+
+        /// Resamples enough source frames for roughly frame_count output frames into samples
+        void ResampleNextChunk(size_t frame_count);
+
         bool is_in_use{};
         bool is_refresh_pending{};
         size_t wave_index{};
         size_t offset{};
+        /// Frames of the current wave buffer that have been decoded so far
+        size_t source_offset{};
         Codec::ADPCMState adpcm_state{};
+        /// ADPCM state at the start of the current wave buffer, restored when it loops
+        Codec::ADPCMState adpcm_start_state{};
+        Codec::ADPCM_Coeff adpcm_coeffs{};
+        /// ADPCM frames of the current wave buffer that have been decoded so far
+        size_t adpcm_frames_decoded{};
+        /// Samples of the last decoded ADPCM frames, of which adpcm_offset have been used
+        std::vector<s16> adpcm_samples;
+        size_t adpcm_offset{};
+        /// Copies of the wave buffer data, taken from guest memory by the emulation thread
+        std::array<std::vector<u8>, 4> wave_data;
+        /// Stereo source frames for the next resampler call
+        std::vector<s16> source_samples;
         InterpolationState interp_state{};
+        /// Resampled frames of the current chunk, of which offset samples have been dequeued
         std::vector<s16> samples;
+        StereoMixMatrix mix_matrix{};
         VoiceOutStatus out_status{};
         VoiceInfo info{};
     };
 
+    /// Number of mix slots cycling between the emulation thread and the audio thread
+    static constexpr size_t MIX_SLOT_COUNT = 4;
+
+    /// Parameters of a voice from one update, with the guest data they point to copied out
+    struct VoiceUpdate {
+        VoiceInfo info;
+        Codec::ADPCM_Coeff adpcm_coeffs;
+        /// Data of the wave buffers queued by this update, unset for the ones copied before
+        std::array<boost::optional<std::vector<u8>>, 4> wave_data;
+    };
+
+    /// A buffer mixed by the audio thread, with the voice status right after mixing it
+    struct MixedBuffer {
+        std::vector<s16> samples;
+        std::vector<VoiceOutStatus> voice_status;
+    };
+
+    /// Mixes buffers ahead of the stream until stopped
+    void AudioThreadLoop();
+    /// Copies the guest data of the voice at index that the audio thread has not seen yet
+    void CopyVoiceData(size_t index, VoiceUpdate& update);
+    /// Applies the voice parameters published by UpdateAudioRenderer, on the audio thread
+    void ApplyVoiceUpdates();
+    /// Mixes all playing voices into buffer, reusing its storage
+    void MixVoices(std::vector<s16>& buffer);
+
     AudioRendererParameter worker_params;
     Kernel::SharedPtr<Kernel::Event> buffer_event;
-    std::vector<VoiceState> voices;
     std::unique_ptr<AudioCore::AudioOut> audio_core;
     AudioCore::StreamPtr stream;
+    /// Voice status as of the last buffer queued to the stream, reported back to the game
+    std::vector<VoiceOutStatus> voice_status;
+    /// Address and size of the wave buffers last copied for each voice, on the emulation thread
+    std::vector<std::array<std::pair<VAddr, u64>, 4>> copied_wave_buffers;
+
+    // Only touched by the audio thread once it is running
+    std::vector<VoiceState> voices;
+    /// Frames mixed per buffer, from the mix quantum setting
+    size_t mix_buffer_frames;
+    /// Interleaved stereo float bus the voices are accumulated into, reused for every buffer
+    std::vector<float> mix_buffer;
+
+    // Lock-free hand-off between the emulation thread and the audio thread. Mixed buffers stay
+    // in their slots and only slot indices change hands, so their storage is never reallocated.
+    Common::SPSCQueue<std::vector<VoiceUpdate>, false> voice_updates;
+    std::array<MixedBuffer, MIX_SLOT_COUNT> mix_slots;
+    Common::RingBuffer<u32, MIX_SLOT_COUNT> mixed_slots;
+    Common::RingBuffer<u32, MIX_SLOT_COUNT> free_slots;
+    /// Wakes the audio thread when there is room for another buffer or a voice update
+    Common::Event audio_thread_event;
+    /// Wakes the emulation thread when it had to wait for a buffer to be mixed
+    Common::Event buffer_mixed_event;
+    std::atomic_bool stop_audio_thread{};
+    std::thread audio_thread;
 };
 
 } // namespace AudioCore
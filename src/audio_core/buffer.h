@@ -8,6 +8,7 @@
 #include <vector>
 
 #include "common/common_types.h"
+#include "common/memory_tracker.h"
 
 namespace AudioCore {
 
@@ -18,7 +19,9 @@ class Buffer {
 public:
     using Tag = u64;
 
-    Buffer(Tag tag, std::vector<s16>&& samples) : tag{tag}, samples{std::move(samples)} {}
+    Buffer(Tag tag, std::vector<s16>&& samples) : tag{tag}, samples{std::move(samples)} {
+        UpdateTrackedMemory();
+    }
 
     /// Returns the raw audio data for the buffer
     std::vector<s16>& Samples() {
@@ -35,9 +38,20 @@ public:
         return tag;
     }
 
+    /// Sets the buffer tag, for when a pooled buffer is reused
+    void SetTag(Tag new_tag) {
+        tag = new_tag;
+    }
+
+    /// Counts the capacity of the samples towards the audio memory, called once they are filled
+    void UpdateTrackedMemory() {
+        samples_memory.Update(samples.capacity() * sizeof(s16));
+    }
+
 private:
     Tag tag;
     std::vector<s16> samples;
+    Common::TrackedMemory samples_memory{Common::MemoryTag::AudioBuffers};
 };
 
 using BufferPtr = std::shared_ptr<Buffer>;
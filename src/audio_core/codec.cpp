@@ -8,28 +8,21 @@
 
 namespace AudioCore::Codec {
 
-std::vector<s16> DecodeADPCM(const u8* const data, size_t size, const ADPCM_Coeff& coeff,
-                             ADPCMState& state) {
+size_t DecodeADPCM(const u8* data, size_t size, const ADPCM_Coeff& coeff, ADPCMState& state,
+                   s16* output) {
     // GC-ADPCM with scale factor and variable coefficients.
-    // Frames are 8 bytes long containing 14 samples each.
     // Samples are 4 bits (one nibble) long.
 
-    constexpr size_t FRAME_LEN = 8;
-    constexpr size_t SAMPLES_PER_FRAME = 14;
     constexpr std::array<int, 16> SIGNED_NIBBLES = {
         {0, 1, 2, 3, 4, 5, 6, 7, -8, -7, -6, -5, -4, -3, -2, -1}};
 
-    const size_t sample_count = (size / FRAME_LEN) * SAMPLES_PER_FRAME;
-    const size_t ret_size =
-        sample_count % 2 == 0 ? sample_count : sample_count + 1; // Ensure multiple of two.
-    std::vector<s16> ret(ret_size);
+    const size_t num_frames = size / ADPCM_FRAME_SIZE;
 
     int yn1 = state.yn1, yn2 = state.yn2;
 
-    const size_t NUM_FRAMES =
-        (sample_count + (SAMPLES_PER_FRAME - 1)) / SAMPLES_PER_FRAME; // Round up.
-    for (size_t framei = 0; framei < NUM_FRAMES; framei++) {
-        const int frame_header = data[framei * FRAME_LEN];
+    for (size_t framei = 0; framei < num_frames; framei++) {
+        const u8* const frame = data + framei * ADPCM_FRAME_SIZE;
+        const int frame_header = frame[0];
         const int scale = 1 << (frame_header & 0xF);
         const int idx = (frame_header >> 4) & 0x7;
 
@@ -53,25 +46,18 @@ std::vector<s16> DecodeADPCM(const u8* const data, size_t size, const ADPCM_Coef
             return static_cast<s16>(val);
         };
 
-        size_t outputi = framei * SAMPLES_PER_FRAME;
-        size_t datai = framei * FRAME_LEN + 1;
-        for (size_t i = 0; i < SAMPLES_PER_FRAME && outputi < sample_count; i += 2) {
-            const s16 sample1 = decode_sample(SIGNED_NIBBLES[data[datai] >> 4]);
-            ret[outputi] = sample1;
-            outputi++;
-
-            const s16 sample2 = decode_sample(SIGNED_NIBBLES[data[datai] & 0xF]);
-            ret[outputi] = sample2;
-            outputi++;
-
-            datai++;
+        // The filter feeds back on every sample, so the frame is decoded serially. The byte
+        // loop is fixed length though, which lets the compiler unroll it.
+        for (size_t i = 1; i < ADPCM_FRAME_SIZE; i++) {
+            *output++ = decode_sample(SIGNED_NIBBLES[frame[i] >> 4]);
+            *output++ = decode_sample(SIGNED_NIBBLES[frame[i] & 0xF]);
         }
     }
 
     state.yn1 = yn1;
     state.yn2 = yn2;
 
-    return ret;
+    return num_frames * ADPCM_SAMPLES_PER_FRAME;
 }
 
 } // namespace AudioCore::Codec
@@ -5,7 +5,7 @@
 #pragma once
 
 #include <array>
-#include <vector>
+#include <cstddef>
 
 #include "common/common_types.h"
 
@@ -31,14 +31,21 @@ struct ADPCMState {
 
 using ADPCM_Coeff = std::array<s16, 16>;
 
+/// ADPCM frames are 8 bytes long containing 14 samples each
+constexpr size_t ADPCM_FRAME_SIZE = 8;
+constexpr size_t ADPCM_SAMPLES_PER_FRAME = 14;
+
 /**
+ * Decodes whole ADPCM frames. The state carries over between calls, so a buffer can be decoded
+ * a few frames at a time.
  * @param data Pointer to buffer that contains ADPCM data to decode
- * @param size Size of buffer in bytes
+ * @param size Size of buffer in bytes, a trailing partial frame is ignored
  * @param coeff ADPCM coefficients
  * @param state ADPCM state, this is updated with new state
- * @return Decoded stereo signed PCM16 data, sample_count in length
+ * @param output Receives the decoded signed PCM16 samples, 14 per frame
+ * @return Number of samples written to output
  */
-std::vector<s16> DecodeADPCM(const u8* const data, size_t size, const ADPCM_Coeff& coeff,
-                             ADPCMState& state);
+size_t DecodeADPCM(const u8* data, size_t size, const ADPCM_Coeff& coeff, ADPCMState& state,
+                   s16* output);
 
 }; // namespace AudioCore::Codec
@@ -3,15 +3,21 @@
 // Refer to the license.txt file included.
 
 #include <algorithm>
+#include <cmath>
 #include <cstring>
-#include <mutex>
 
 #include "audio_core/cubeb_sink.h"
 #include "audio_core/stream.h"
 #include "common/logging/log.h"
+#include "common/microprofile.h"
+#include "common/ring_buffer.h"
+#include "core/core.h"
+#include "core/settings.h"
 
 namespace AudioCore {
 
+MICROPROFILE_COUNTER_DEFINE(Audio_FramesQueued, "Audio", "Frames Queued", PerFrame);
+
 class SinkStreamImpl final : public SinkStream {
 public:
     SinkStreamImpl(cubeb* ctx, u32 sample_rate, u32 num_channels_, cubeb_devid output_device,
@@ -36,8 +42,13 @@ public:
             LOG_CRITICAL(Audio_Sink, "Error getting minimum latency");
         }
 
+        // A latency of 0 asks for the lowest the backend can do
+        const u32 latency_frames{std::max(Settings::values.audio_sink_latency, minimum_latency)};
+        LOG_INFO(Audio_Sink, "Opening stream with a latency of {} frames (minimum {})",
+                 latency_frames, minimum_latency);
+
         if (cubeb_stream_init(ctx, &stream_backend, name.c_str(), nullptr, nullptr, output_device,
-                              &params, std::max(512u, minimum_latency),
+                              &params, latency_frames,
                               &SinkStreamImpl::DataCallback, &SinkStreamImpl::StateCallback,
                               this) != CUBEB_OK) {
             LOG_CRITICAL(Audio_Sink, "Error initializing cubeb stream");
@@ -67,22 +78,47 @@ public:
             return;
         }
 
-        std::lock_guard lock{queue_mutex};
-
-        queue.reserve(queue.size() + samples.size() * GetNumChannels());
+        const s16* input = samples.data();
+        size_t sample_count = samples.size();
 
         if (is_6_channel) {
             // Downsample 6 channels to 2
-            const size_t sample_count_copy_size = samples.size() * 2;
-            queue.reserve(sample_count_copy_size);
-            for (size_t i = 0; i < samples.size(); i += num_channels) {
-                queue.push_back(samples[i]);
-                queue.push_back(samples[i + 1]);
+            downmix_buffer.clear();
+            downmix_buffer.reserve(samples.size() / num_channels * 2);
+            for (size_t i = 0; i + 1 < samples.size(); i += num_channels) {
+                downmix_buffer.push_back(samples[i]);
+                downmix_buffer.push_back(samples[i + 1]);
             }
-        } else {
-            // Copy as-is
-            std::copy(samples.begin(), samples.end(), std::back_inserter(queue));
+            input = downmix_buffer.data();
+            sample_count = downmix_buffer.size();
+        }
+
+        // Only whole frames are queued, so the callback never sees a frame split in two
+        sample_count -= sample_count % GetNumChannels();
+
+        const size_t pushed = queue.Push(input, sample_count);
+        MICROPROFILE_COUNTER_ADD(Audio_FramesQueued, pushed / GetNumChannels());
+        if (pushed < sample_count) {
+            // The device is consuming slower than we produce, drop what does not fit
+            Core::System::GetInstance().perf_stats.ReportAudioOverrun();
+        }
+    }
+
+    size_t SamplesInQueue() const override {
+        return queue.Size() / GetNumChannels();
+    }
+
+    size_t GetLatency() const override {
+        if (!ctx || !stream_backend) {
+            return 0;
         }
+
+        // What is still in our queue, plus what the backend has taken but not played yet
+        u32 backend_latency{};
+        if (cubeb_stream_get_latency(stream_backend, &backend_latency) != CUBEB_OK) {
+            backend_latency = 0;
+        }
+        return SamplesInQueue() + backend_latency;
     }
 
     u32 GetNumChannels() const {
@@ -97,8 +133,12 @@ private:
     u32 num_channels{};
     bool is_6_channel{};
 
-    std::mutex queue_mutex;
-    std::vector<s16> queue;
+    /// Roughly a second of 48kHz stereo audio, shared lock-free with the audio thread
+    Common::RingBuffer<s16, 0x20000> queue;
+    /// Scratch space for downmixing 6-channel audio, only touched by the producer
+    std::vector<s16> downmix_buffer;
+    /// Whether the last callback ran out of samples, only touched by the audio thread
+    bool starved = true;
 
     static long DataCallback(cubeb_stream* stream, void* user_data, const void* input_buffer,
                              void* output_buffer, long num_frames);
@@ -150,6 +190,7 @@ SinkStream& CubebSink::AcquireSinkStream(u32 sample_rate, u32 num_channels,
 
 long SinkStreamImpl::DataCallback(cubeb_stream* stream, void* user_data, const void* input_buffer,
                                   void* output_buffer, long num_frames) {
+    TRACE_SCOPE("Audio Callback");
     SinkStreamImpl* impl = static_cast<SinkStreamImpl*>(user_data);
     u8* buffer = reinterpret_cast<u8*>(output_buffer);
 
@@ -157,19 +198,37 @@ long SinkStreamImpl::DataCallback(cubeb_stream* stream, void* user_data, const v
         return {};
     }
 
-    std::lock_guard lock{impl->queue_mutex};
-
-    const size_t frames_to_write{
-        std::min(impl->queue.size() / impl->GetNumChannels(), static_cast<size_t>(num_frames))};
-
-    memcpy(buffer, impl->queue.data(), frames_to_write * sizeof(s16) * impl->GetNumChannels());
-    impl->queue.erase(impl->queue.begin(),
-                      impl->queue.begin() + frames_to_write * impl->GetNumChannels());
+    // This runs on the real-time audio thread: no locks, no allocations
+    const size_t num_channels = impl->GetNumChannels();
+    const size_t samples_to_write = static_cast<size_t>(num_frames) * num_channels;
+    const size_t samples_written = impl->queue.Pop(buffer, samples_to_write);
+
+    auto& perf_stats = Core::System::GetInstance().perf_stats;
+    perf_stats.ReportAudioQueueLevel(static_cast<double>(impl->queue.Size()) /
+                                     impl->queue.Capacity());
+
+    // Apply the volume while the samples are still hot, instead of in a separate pass earlier
+    const float volume{std::clamp(Settings::values.volume, 0.0f, 1.0f)};
+    if (volume != 1.0f) {
+        // Implementation of a volume slider with a dynamic range of 60 dB
+        const float volume_scale_factor{std::exp(6.90775f * volume) * 0.001f};
+        s16* const samples{reinterpret_cast<s16*>(output_buffer)};
+        for (size_t index = 0; index < samples_written; ++index) {
+            samples[index] = static_cast<s16>(samples[index] * volume_scale_factor);
+        }
+    }
 
-    if (frames_to_write < num_frames) {
+    if (samples_written < samples_to_write) {
         // Fill the rest of the frames with silence
-        memset(buffer + frames_to_write * sizeof(s16) * impl->GetNumChannels(), 0,
-               (num_frames - frames_to_write) * sizeof(s16) * impl->GetNumChannels());
+        std::memset(buffer + samples_written * sizeof(s16), 0,
+                    (samples_to_write - samples_written) * sizeof(s16));
+        // Only count the moment the queue runs dry, not every callback of a silent stretch
+        if (!impl->starved) {
+            perf_stats.ReportAudioUnderrun();
+        }
+        impl->starved = true;
+    } else {
+        impl->starved = false;
     }
 
     return num_frames;
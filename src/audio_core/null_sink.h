@@ -4,6 +4,8 @@
 
 #pragma once
 
+#include <limits>
+
 #include "audio_core/sink.h"
 
 namespace AudioCore {
@@ -21,6 +23,15 @@ public:
 private:
     struct NullSinkStreamImpl final : SinkStream {
         void EnqueueSamples(u32 /*num_channels*/, const std::vector<s16>& /*samples*/) override {}
+
+        size_t SamplesInQueue() const override {
+            // Nothing is played, so this can never run dry
+            return std::numeric_limits<size_t>::max();
+        }
+
+        size_t GetLatency() const override {
+            return 0;
+        }
     } null_sink_stream;
 };
 
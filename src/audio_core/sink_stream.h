@@ -25,6 +25,12 @@ public:
      * @param samples Samples in interleaved stereo PCM16 format.
      */
     virtual void EnqueueSamples(u32 num_channels, const std::vector<s16>& samples) = 0;
+
+    /// Returns the number of frames queued and not played yet
+    virtual size_t SamplesInQueue() const = 0;
+
+    /// Returns the frames between a newly enqueued sample and the speaker, or 0 if unknown
+    virtual size_t GetLatency() const = 0;
 };
 
 using SinkStreamPtr = std::unique_ptr<SinkStream>;
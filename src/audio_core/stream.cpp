@@ -10,14 +10,13 @@
 #include "audio_core/stream.h"
 #include "common/assert.h"
 #include "common/logging/log.h"
+#include "core/core.h"
 #include "core/core_timing.h"
 #include "core/core_timing_util.h"
 #include "core/settings.h"
 
 namespace AudioCore {
 
-constexpr size_t MaxAudioBufferCount{32};
-
 u32 Stream::GetNumChannels() const {
     switch (format) {
     case Format::Mono16:
@@ -35,7 +34,8 @@ u32 Stream::GetNumChannels() const {
 Stream::Stream(u32 sample_rate, Format format, ReleaseCallback&& release_callback,
                SinkStream& sink_stream, std::string&& name_)
     : sample_rate{sample_rate}, format{format}, release_callback{std::move(release_callback)},
-      sink_stream{sink_stream}, name{std::move(name_)} {
+      sink_stream{sink_stream}, name{std::move(name_)},
+      time_stretcher{sample_rate, GetNumChannels()} {
 
     release_event = CoreTiming::RegisterEvent(
         name, [this](u64 userdata, int cycles_late) { ReleaseActiveBuffer(); });
@@ -55,20 +55,6 @@ s64 Stream::GetBufferReleaseCycles(const Buffer& buffer) const {
     return CoreTiming::usToCycles((static_cast<u64>(num_samples) * 1000000) / sample_rate);
 }
 
-static void VolumeAdjustSamples(std::vector<s16>& samples) {
-    const float volume{std::clamp(Settings::values.volume, 0.0f, 1.0f)};
-
-    if (volume == 1.0f) {
-        return;
-    }
-
-    // Implementation of a volume slider with a dynamic range of 60 dB
-    const float volume_scale_factor{std::exp(6.90775f * volume) * 0.001f};
-    for (auto& sample : samples) {
-        sample = static_cast<s16>(sample * volume_scale_factor);
-    }
-}
-
 void Stream::PlayNextBuffer() {
     if (!IsPlaying()) {
         // Ensure we are in playing state before playing the next buffer
@@ -85,25 +71,113 @@ void Stream::PlayNextBuffer() {
         return;
     }
 
-    active_buffer = queued_buffers.front();
-    queued_buffers.pop();
+    active_buffer = std::move(queued_buffers.front());
+    queued_buffers.erase(queued_buffers.begin());
 
-    VolumeAdjustSamples(active_buffer->Samples());
-    sink_stream.EnqueueSamples(GetNumChannels(), active_buffer->GetSamples());
+    // The volume is applied by the sink as it plays the samples
+    EnqueueSamples(active_buffer->GetSamples());
 
     CoreTiming::ScheduleEventThreadsafe(GetBufferReleaseCycles(*active_buffer), release_event, {});
 }
 
 void Stream::ReleaseActiveBuffer() {
     ASSERT(active_buffer);
-    released_buffers.push(std::move(active_buffer));
+    released_buffers.push_back(std::move(active_buffer));
     release_callback();
     PlayNextBuffer();
 }
 
+void Stream::EnqueueSamples(const std::vector<s16>& samples) {
+    // Range of the amount of audio the sink should hold. Slowdowns shorter than this are covered
+    // for free, so it grows each time the sink runs dry and shrinks back while it does not.
+    constexpr double MIN_TARGET_QUEUE_SECONDS{0.02};
+    constexpr double MAX_TARGET_QUEUE_SECONDS{0.2};
+    constexpr double TARGET_QUEUE_SHRINK_SECONDS{0.005};
+    // Buffers to play without the sink running dry before the target shrinks
+    constexpr u32 TARGET_QUEUE_SHRINK_BUFFERS{200};
+    // Slowest tempo to stretch to, any slower sounds worse than the gaps it avoids
+    constexpr double MIN_TEMPO{0.25};
+    // How quickly the tempo follows the sink, per buffer
+    constexpr double TEMPO_SMOOTHING{0.1};
+    // Tempo below which stretching starts, and above which it stops again
+    constexpr double STRETCH_START_TEMPO{0.98};
+    constexpr double STRETCH_STOP_TEMPO{0.995};
+
+    bool stretch{};
+    if (Settings::values.enable_audio_stretching) {
+        // Buffers are released on emulated time, so while emulation is slow the sink drains
+        // faster than it is filled. Playing slower in proportion to how empty it is lets the
+        // queue settle at a level the emulation can sustain.
+        const size_t queued_frames{sink_stream.SamplesInQueue()};
+        const double queued_seconds{static_cast<double>(queued_frames) / sample_rate};
+        if (queued_frames == 0) {
+            // Ran dry, hold at least one more buffer from now on
+            const double buffer_seconds{static_cast<double>(samples.size() / GetNumChannels()) /
+                                        sample_rate};
+            target_queue_seconds = std::min(target_queue_seconds + buffer_seconds,
+                                            MAX_TARGET_QUEUE_SECONDS);
+            clean_buffer_count = 0;
+        } else if (++clean_buffer_count >= TARGET_QUEUE_SHRINK_BUFFERS) {
+            target_queue_seconds = std::max(target_queue_seconds - TARGET_QUEUE_SHRINK_SECONDS,
+                                            MIN_TARGET_QUEUE_SECONDS);
+            clean_buffer_count = 0;
+        }
+
+        const double target_tempo{
+            std::clamp(queued_seconds / target_queue_seconds, MIN_TEMPO, 1.0)};
+        stretch_tempo += (target_tempo - stretch_tempo) * TEMPO_SMOOTHING;
+        Core::System::GetInstance().perf_stats.ReportAudioStretchRatio(stretch_tempo);
+
+        const bool is_stretching{time_stretcher.HasPendingSamples()};
+        stretch = stretch_tempo < (is_stretching ? STRETCH_STOP_TEMPO : STRETCH_START_TEMPO);
+    }
+
+    if (stretch) {
+        time_stretcher.Process(samples, stretch_tempo, stretched_samples);
+        sink_stream.EnqueueSamples(GetNumChannels(), stretched_samples);
+        ReportLatency();
+        return;
+    }
+
+    if (time_stretcher.HasPendingSamples()) {
+        // Back at full speed, hand over what the stretcher held back before the new samples
+        stretched_samples.clear();
+        time_stretcher.Flush(stretched_samples);
+        sink_stream.EnqueueSamples(GetNumChannels(), stretched_samples);
+    }
+    sink_stream.EnqueueSamples(GetNumChannels(), samples);
+    ReportLatency();
+}
+
+void Stream::ReportLatency() const {
+    const size_t latency_frames{sink_stream.GetLatency()};
+    if (latency_frames == 0) {
+        return;
+    }
+    Core::System::GetInstance().perf_stats.ReportAudioLatency(
+        static_cast<double>(latency_frames) / sample_rate);
+}
+
+BufferPtr Stream::AcquireBuffer(Buffer::Tag tag) {
+    BufferPtr buffer;
+    if (!free_buffers.empty()) {
+        buffer = std::move(free_buffers.back());
+        free_buffers.pop_back();
+    } else if (allocated_buffer_count < MaxAudioBufferCount) {
+        buffer = std::make_shared<Buffer>(tag, std::vector<s16>{});
+        ++allocated_buffer_count;
+    } else {
+        return nullptr;
+    }
+
+    buffer->SetTag(tag);
+    return buffer;
+}
+
 bool Stream::QueueBuffer(BufferPtr&& buffer) {
     if (queued_buffers.size() < MaxAudioBufferCount) {
-        queued_buffers.push(std::move(buffer));
+        buffer->UpdateTrackedMemory();
+        queued_buffers.push_back(std::move(buffer));
         PlayNextBuffer();
         return true;
     }
@@ -116,11 +190,14 @@ bool Stream::ContainsBuffer(Buffer::Tag tag) const {
 }
 
 std::vector<Buffer::Tag> Stream::GetTagsAndReleaseBuffers(size_t max_count) {
+    const size_t count{std::min(max_count, released_buffers.size())};
     std::vector<Buffer::Tag> tags;
-    for (size_t count = 0; count < max_count && !released_buffers.empty(); ++count) {
-        tags.push_back(released_buffers.front()->GetTag());
-        released_buffers.pop();
+    tags.reserve(count);
+    for (size_t index = 0; index < count; ++index) {
+        tags.push_back(released_buffers[index]->GetTag());
+        free_buffers.push_back(std::move(released_buffers[index]));
     }
+    released_buffers.erase(released_buffers.begin(), released_buffers.begin() + count);
     return tags;
 }
 
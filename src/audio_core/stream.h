@@ -8,10 +8,11 @@
 #include <memory>
 #include <string>
 #include <vector>
-#include <queue>
 
+#include <boost/container/static_vector.hpp>
 #include "audio_core/buffer.h"
 #include "audio_core/sink_stream.h"
+#include "audio_core/time_stretch.h"
 #include "common/assert.h"
 #include "common/common_types.h"
 #include "core/core_timing.h"
@@ -42,13 +43,23 @@ public:
     /// Stops the audio stream
     void Stop();
 
+    /// Most buffers a stream holds at once, whether queued, playing or released
+    static constexpr size_t MaxAudioBufferCount{32};
+
+    /**
+     * Takes a buffer from the stream's pool. It keeps the sample storage of its previous use, so
+     * refilling it does not allocate once the pool has warmed up.
+     * @returns The buffer, or nullptr if every buffer of the pool is in use
+     */
+    BufferPtr AcquireBuffer(Buffer::Tag tag);
+
     /// Queues a buffer into the audio stream, returns true on success
     bool QueueBuffer(BufferPtr&& buffer);
 
     /// Returns true if the audio stream contains a buffer with the specified tag
     bool ContainsBuffer(Buffer::Tag tag) const;
 
-    /// Returns a vector of recently released buffers specified by tag
+    /// Returns a vector of recently released buffers specified by tag, returning them to the pool
     std::vector<Buffer::Tag> GetTagsAndReleaseBuffers(size_t max_count);
 
     /// Returns true if the stream is currently playing
@@ -82,6 +93,12 @@ private:
     /// Releases the actively playing buffer, signalling that it has been completed
     void ReleaseActiveBuffer();
 
+    /// Sends samples to the sink, time-stretched if the sink is running low
+    void EnqueueSamples(const std::vector<s16>& samples);
+
+    /// Reports the latency measured by the sink to the performance statistics
+    void ReportLatency() const;
+
     /// Gets the number of core cycles when the specified buffer will be released
     s64 GetBufferReleaseCycles(const Buffer& buffer) const;
 
@@ -91,10 +108,18 @@ private:
     State state{State::Stopped};            ///< Playback state of the stream
     CoreTiming::EventType* release_event{}; ///< Core timing release event for the stream
     BufferPtr active_buffer;                ///< Actively playing buffer in the stream
-    std::queue<BufferPtr> queued_buffers;   ///< Buffers queued to be played in the stream
-    std::queue<BufferPtr> released_buffers; ///< Buffers recently released from the stream
+    using BufferQueue = boost::container::static_vector<BufferPtr, MaxAudioBufferCount>;
+    BufferQueue queued_buffers;             ///< Buffers queued to be played in the stream
+    BufferQueue released_buffers;           ///< Buffers recently released from the stream
+    BufferQueue free_buffers;               ///< Pooled buffers ready to be acquired
+    size_t allocated_buffer_count{};        ///< Buffers created for the pool so far
     SinkStream& sink_stream;                ///< Output sink for the stream
     std::string name;                       ///< Name of the stream, must be unique
+    TimeStretcher time_stretcher;           ///< Slows playback down while the sink runs low
+    std::vector<s16> stretched_samples;     ///< Output of the time stretcher, reused
+    double stretch_tempo{1.0};              ///< Current tempo of the time stretcher
+    double target_queue_seconds{0.05};      ///< Sink queue level the stretcher aims for
+    u32 clean_buffer_count{};               ///< Buffers played since the sink last ran dry
 };
 
 using StreamPtr = std::shared_ptr<Stream>;
@@ -0,0 +1,125 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <cmath>
+#include "audio_core/time_stretch.h"
+
+namespace AudioCore {
+
+static s16 ToS16(float sample) {
+    return static_cast<s16>(std::clamp(sample, -32768.0f, 32767.0f));
+}
+
+TimeStretcher::TimeStretcher(u32 sample_rate, u32 channel_count)
+    : channel_count{channel_count}, overlap_frames{sample_rate * 8 / 1000},
+      seek_frames{sample_rate * 15 / 1000}, sequence_frames{sample_rate * 40 / 1000},
+      overlap_buffer(overlap_frames * channel_count) {}
+
+void TimeStretcher::Process(const std::vector<s16>& input, double tempo,
+                            std::vector<s16>& output) {
+    output.clear();
+    input_buffer.insert(input_buffer.end(), input.begin(), input.end());
+
+    // Each segment is sequence_frames long and ends in an overlap, only the part before it is
+    // output directly. Advancing the input by tempo times that much sets the speed.
+    const size_t step_frames = sequence_frames - overlap_frames;
+    const size_t frames_needed = seek_frames + sequence_frames;
+    const size_t total_frames = input_buffer.size() / channel_count;
+
+    size_t consumed_frames = 0;
+    while (total_frames - consumed_frames >= frames_needed) {
+        const float* const segment_input = input_buffer.data() + consumed_frames * channel_count;
+
+        size_t offset = 0;
+        if (has_overlap) {
+            offset = FindBestOffset(segment_input);
+            AppendCrossFade(segment_input + offset * channel_count, output);
+        } else {
+            // Nothing to splice onto yet, start with the beginning of the input as-is
+            std::transform(segment_input, segment_input + overlap_frames * channel_count,
+                           std::back_inserter(output), ToS16);
+        }
+
+        // The middle of the segment is output unchanged
+        const float* const middle = segment_input + (offset + overlap_frames) * channel_count;
+        const float* const tail = segment_input + (offset + step_frames) * channel_count;
+        std::transform(middle, tail, std::back_inserter(output), ToS16);
+
+        // Its tail is kept to be faded into the next segment
+        std::copy(tail, tail + overlap_frames * channel_count, overlap_buffer.begin());
+        has_overlap = true;
+
+        const double skip = tempo * step_frames + skip_remainder;
+        skip_remainder = skip - std::floor(skip);
+        consumed_frames = std::min(consumed_frames + static_cast<size_t>(skip), total_frames);
+    }
+
+    // Drop the consumed input once per call rather than once per segment
+    input_buffer.erase(input_buffer.begin(),
+                       input_buffer.begin() + consumed_frames * channel_count);
+}
+
+void TimeStretcher::Flush(std::vector<s16>& output) {
+    size_t offset = 0;
+    if (has_overlap && input_buffer.size() / channel_count >= overlap_frames) {
+        AppendCrossFade(input_buffer.data(), output);
+        offset = overlap_frames * channel_count;
+    }
+    std::transform(input_buffer.begin() + offset, input_buffer.end(), std::back_inserter(output),
+                   ToS16);
+
+    input_buffer.clear();
+    has_overlap = false;
+    skip_remainder = 0.0;
+}
+
+size_t TimeStretcher::FindBestOffset(const float* input) const {
+    const size_t overlap_samples = overlap_frames * channel_count;
+
+    // Normalised cross-correlation against the overlap. The energy of the candidate window is
+    // kept as a running sum, so each offset costs one pass over the overlap.
+    double energy = 0.0;
+    for (size_t i = 0; i < overlap_samples; ++i) {
+        energy += static_cast<double>(input[i]) * input[i];
+    }
+
+    size_t best_offset = 0;
+    double best_score = -1.0e300;
+    for (size_t offset = 0; offset < seek_frames; ++offset) {
+        const float* const candidate = input + offset * channel_count;
+
+        float correlation = 0.0f;
+        for (size_t i = 0; i < overlap_samples; ++i) {
+            correlation += candidate[i] * overlap_buffer[i];
+        }
+
+        const double score = correlation / std::sqrt(std::max(energy, 1.0));
+        if (score > best_score) {
+            best_score = score;
+            best_offset = offset;
+        }
+
+        for (size_t ch = 0; ch < channel_count; ++ch) {
+            const double removed = candidate[ch];
+            const double added = candidate[overlap_samples + ch];
+            energy += added * added - removed * removed;
+        }
+    }
+    return best_offset;
+}
+
+void TimeStretcher::AppendCrossFade(const float* incoming, std::vector<s16>& output) const {
+    output.reserve(output.size() + overlap_frames * channel_count);
+    for (size_t frame = 0; frame < overlap_frames; ++frame) {
+        const float fade_in = static_cast<float>(frame) / overlap_frames;
+        for (size_t ch = 0; ch < channel_count; ++ch) {
+            const size_t index = frame * channel_count + ch;
+            output.push_back(
+                ToS16(overlap_buffer[index] * (1.0f - fade_in) + incoming[index] * fade_in));
+        }
+    }
+}
+
+} // namespace AudioCore
@@ -0,0 +1,65 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <cstddef>
+#include <vector>
+#include "common/common_types.h"
+
+namespace AudioCore {
+
+/**
+ * Changes the tempo of an audio stream without changing its pitch, using WSOLA (waveform
+ * similarity overlap-add). The input is cut into overlapping segments that are spliced back
+ * together at a different spacing. Each splice point is moved to where the waveforms line up
+ * best, which hides the seams.
+ */
+class TimeStretcher {
+public:
+    TimeStretcher(u32 sample_rate, u32 channel_count);
+
+    /**
+     * Stretches interleaved PCM16 samples. Input is consumed in segments, so a few tens of
+     * milliseconds are held back between calls.
+     * @param input Samples to append to the stream.
+     * @param tempo Playback speed, 1.0 is unchanged and 0.5 plays for twice as long.
+     * @param output Receives the stretched samples that are ready, its storage is reused.
+     */
+    void Process(const std::vector<s16>& input, double tempo, std::vector<s16>& output);
+
+    /// Appends everything held back to output without further stretching and resets the stream
+    void Flush(std::vector<s16>& output);
+
+    /// Returns true if samples are held back from a previous Process call
+    bool HasPendingSamples() const {
+        return !input_buffer.empty();
+    }
+
+private:
+    /// Returns the offset within the seek window at which input best continues the overlap
+    size_t FindBestOffset(const float* input) const;
+
+    /// Cross-fades the overlap buffer into incoming and appends the result to output
+    void AppendCrossFade(const float* incoming, std::vector<s16>& output) const;
+
+    const size_t channel_count;
+    /// Length of the cross-fade between consecutive segments, in frames
+    const size_t overlap_frames;
+    /// How far a segment start may move to find a better splice, in frames
+    const size_t seek_frames;
+    /// Length of each segment taken from the input, including one overlap, in frames
+    const size_t sequence_frames;
+
+    /// Input not yet consumed, as interleaved floats
+    std::vector<float> input_buffer;
+    /// Tail of the last segment, faded out over the start of the next one
+    std::vector<float> overlap_buffer;
+    /// Whether overlap_buffer holds a tail yet
+    bool has_overlap = false;
+    /// Fractional part of the input frames to skip, carried between segments
+    double skip_remainder = 0.0;
+};
+
+} // namespace AudioCore
@@ -0,0 +1,62 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <random>
+#include <vector>
+#include "audio_core/algorithm/filter.h"
+#include "audio_core/algorithm/interpolate.h"
+#include "benchmarks/benchmark.h"
+
+namespace AudioCore {
+
+/// Samples of one audio renderer update at 48 kHz, interleaved stereo
+constexpr std::size_t NUM_FRAMES = 240;
+
+static std::vector<s16> MakeNoise(std::size_t num_samples) {
+    std::vector<s16> samples(num_samples);
+    std::mt19937 rng(1);
+    std::generate(samples.begin(), samples.end(), [&rng] { return static_cast<s16>(rng()); });
+    return samples;
+}
+
+static void CascadingFilterProcess(Benchmark::State& state) {
+    CascadingFilter filter = CascadingFilter::LowPass(0.5, 3);
+    std::vector<s16> signal = MakeNoise(NUM_FRAMES * 2);
+
+    // Filtering in place keeps changing the signal, which doesn't change the cost
+    while (state.KeepRunning()) {
+        filter.Process(signal);
+        Benchmark::DoNotOptimize(signal.front());
+    }
+    state.SetBytesPerIteration(signal.size() * sizeof(s16));
+}
+BENCHMARK(CascadingFilterProcess);
+
+static void InterpolateRatio(Benchmark::State& state, u32 input_rate) {
+    InterpolationState interpolation;
+    const std::vector<s16> source = MakeNoise(NUM_FRAMES * 2);
+    std::vector<s16> input;
+    std::vector<s16> output;
+
+    while (state.KeepRunning()) {
+        // Interpolate filters its input in place, so each iteration starts from the same samples
+        input = source;
+        Interpolate(interpolation, input, output, input_rate, 48000);
+        Benchmark::DoNotOptimize(output.data());
+    }
+    state.SetBytesPerIteration(source.size() * sizeof(s16));
+}
+
+static void Interpolate_32kHzTo48kHz(Benchmark::State& state) {
+    InterpolateRatio(state, 32000);
+}
+BENCHMARK(Interpolate_32kHzTo48kHz);
+
+static void Interpolate_44kHzTo48kHz(Benchmark::State& state) {
+    InterpolateRatio(state, 44100);
+}
+BENCHMARK(Interpolate_44kHzTo48kHz);
+
+} // namespace AudioCore
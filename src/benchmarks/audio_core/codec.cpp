@@ -0,0 +1,33 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <random>
+#include <vector>
+#include "audio_core/codec.h"
+#include "benchmarks/benchmark.h"
+
+namespace AudioCore::Codec {
+
+static void DecodeADPCMFrames(Benchmark::State& state) {
+    constexpr std::size_t num_frames = 1024;
+    std::vector<u8> data(num_frames * ADPCM_FRAME_SIZE);
+    std::mt19937 rng(1);
+    // Every header is valid, they select a coefficient pair and a scale with any value
+    std::generate(data.begin(), data.end(), [&rng] { return static_cast<u8>(rng()); });
+
+    const ADPCM_Coeff coeff{{1024, -512, 2048, -1024, 1536, -768, 512, -256, 3072, -1536, 256,
+                             -128, 1792, -896, 768, -384}};
+    std::vector<s16> output(num_frames * ADPCM_SAMPLES_PER_FRAME);
+
+    while (state.KeepRunning()) {
+        ADPCMState adpcm_state{};
+        DecodeADPCM(data.data(), data.size(), coeff, adpcm_state, output.data());
+        Benchmark::DoNotOptimize(output.front());
+    }
+    state.SetBytesPerIteration(data.size());
+}
+BENCHMARK(DecodeADPCMFrames);
+
+} // namespace AudioCore::Codec
@@ -0,0 +1,143 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <fmt/format.h>
+#include <glad/glad.h>
+#include "benchmarks/benchmark.h"
+
+namespace Benchmark {
+
+namespace Detail {
+const void* volatile sink = nullptr;
+}
+
+/// Minimum duration of a measured run, long enough to hide the timer's resolution
+constexpr std::chrono::milliseconds MIN_RUN_TIME{100};
+/// Runs measured per benchmark, the median of which is reported
+constexpr std::size_t NUM_RUNS = 5;
+constexpr u64 MAX_ITERATIONS = 1'000'000'000;
+
+State::State(u64 iterations) : iterations(iterations), remaining(iterations) {}
+
+bool State::KeepRunning() {
+    if (!started) {
+        started = true;
+        start = Clock::now();
+    }
+    if (remaining == 0) {
+        PauseTiming();
+        return false;
+    }
+    --remaining;
+    return true;
+}
+
+void State::PauseTiming() {
+    if (!paused) {
+        elapsed += Clock::now() - start;
+        paused = true;
+    }
+}
+
+void State::ResumeTiming() {
+    if (paused) {
+        paused = false;
+        start = Clock::now();
+    }
+}
+
+struct Entry {
+    const char* name;
+    Function function;
+};
+
+static std::vector<Entry>& GetRegistry() {
+    static std::vector<Entry> registry;
+    return registry;
+}
+
+void Register(const char* name, Function function) {
+    GetRegistry().push_back({name, function});
+}
+
+static std::chrono::nanoseconds RunOnce(Function function, u64 iterations, u64& bytes) {
+    State state{iterations};
+    function(state);
+    bytes = state.GetBytesPerIteration();
+    return state.GetElapsed();
+}
+
+static void Run(const Entry& entry) {
+    // Grow the iteration count until a run takes long enough to be measured reliably
+    u64 iterations = 1;
+    u64 bytes = 0;
+    while (true) {
+        const auto elapsed = RunOnce(entry.function, iterations, bytes);
+        if (elapsed >= MIN_RUN_TIME || iterations >= MAX_ITERATIONS) {
+            break;
+        }
+        const double scale = elapsed.count() == 0
+                                 ? 10.0
+                                 : std::clamp(1.4 * std::chrono::nanoseconds(MIN_RUN_TIME).count() /
+                                                  elapsed.count(),
+                                              2.0, 10.0);
+        iterations = std::min(MAX_ITERATIONS, static_cast<u64>(iterations * scale));
+    }
+
+    std::vector<double> ns_per_iteration;
+    for (std::size_t run = 0; run < NUM_RUNS; ++run) {
+        const auto elapsed = RunOnce(entry.function, iterations, bytes);
+        ns_per_iteration.push_back(static_cast<double>(elapsed.count()) / iterations);
+    }
+    std::sort(ns_per_iteration.begin(), ns_per_iteration.end());
+    const double median = ns_per_iteration[NUM_RUNS / 2];
+
+    std::string line = fmt::format("{:<44} {:>12} {:>14.1f} ns", entry.name, iterations, median);
+    if (bytes != 0) {
+        const double mib_per_second = bytes / median * 1e9 / (1024.0 * 1024.0);
+        line += fmt::format(" {:>12.1f} MiB/s", mib_per_second);
+    }
+    fmt::print("{}\n", line);
+}
+
+} // namespace Benchmark
+
+/**
+ * Runs every registered benchmark, or only those whose name contains one of the arguments, and
+ * prints the median time of an iteration. "--list" prints the names without running anything.
+ */
+int main(int argc, char** argv) {
+    // Same work-around as the glad fake test of the tests executable, the macOS linker wants an
+    // explicit use of glad when core is linked in
+    Benchmark::DoNotOptimize(&gladLoadGL);
+
+    auto& registry = Benchmark::GetRegistry();
+    std::sort(registry.begin(), registry.end(), [](const auto& a, const auto& b) {
+        return std::strcmp(a.name, b.name) < 0;
+    });
+
+    const std::vector<std::string> filters(argv + 1, argv + argc);
+    const bool list_only = std::find(filters.begin(), filters.end(), "--list") != filters.end();
+
+    for (const auto& entry : registry) {
+        const bool selected =
+            filters.empty() || list_only ||
+            std::any_of(filters.begin(), filters.end(), [&entry](const std::string& filter) {
+                return std::strstr(entry.name, filter.c_str()) != nullptr;
+            });
+        if (!selected) {
+            continue;
+        }
+        if (list_only) {
+            fmt::print("{}\n", entry.name);
+        } else {
+            Benchmark::Run(entry);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,90 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <chrono>
+#include "common/common_types.h"
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace Benchmark {
+
+/**
+ * Passed to every benchmark function, which runs the code it measures once per iteration of a
+ * `while (state.KeepRunning())` loop. Only the loop is timed, setup before it is not.
+ */
+class State {
+public:
+    explicit State(u64 iterations);
+
+    /// Returns true while iterations are left. The first call starts the timer, the last stops it
+    bool KeepRunning();
+
+    /// Stops timing, for work inside the loop that shouldn't be measured
+    void PauseTiming();
+    void ResumeTiming();
+
+    /// Sets how many bytes one iteration processes, to report the throughput
+    void SetBytesPerIteration(u64 bytes) {
+        bytes_per_iteration = bytes;
+    }
+
+    u64 GetIterations() const {
+        return iterations;
+    }
+
+    u64 GetBytesPerIteration() const {
+        return bytes_per_iteration;
+    }
+
+    std::chrono::nanoseconds GetElapsed() const {
+        return elapsed;
+    }
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    const u64 iterations;
+    u64 remaining;
+    u64 bytes_per_iteration = 0;
+    bool started = false;
+    bool paused = false;
+    Clock::time_point start;
+    std::chrono::nanoseconds elapsed{0};
+};
+
+using Function = void (*)(State& state);
+
+/// Adds a benchmark to the ones the benchmarks executable runs, see BENCHMARK
+void Register(const char* name, Function function);
+
+struct Registrar {
+    Registrar(const char* name, Function function) {
+        Register(name, function);
+    }
+};
+
+namespace Detail {
+extern const void* volatile sink;
+}
+
+/// Keeps the compiler from optimizing away the computation of value
+template <typename T>
+inline void DoNotOptimize(const T& value) {
+#ifdef _MSC_VER
+    Detail::sink = &value;
+    _ReadWriteBarrier();
+#else
+    asm volatile("" : : "g"(&value) : "memory");
+#endif
+}
+
+} // namespace Benchmark
+
+/// Registers a `void function(Benchmark::State&)` under its own name
+#define BENCHMARK(function)                                                                        \
+    static const ::Benchmark::Registrar benchmark_registrar_##function{#function, function}
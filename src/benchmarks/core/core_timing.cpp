@@ -0,0 +1,56 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <array>
+#include "benchmarks/benchmark.h"
+#include "core/core_timing.h"
+
+namespace CoreTiming {
+
+/// About how many events a running title keeps scheduled at once
+constexpr u64 NUM_EVENTS = 64;
+
+static void ScheduleUnscheduleEvents(Benchmark::State& state) {
+    Init();
+    EventType* const event_type = RegisterEvent("benchmark", [](u64, int) {});
+
+    while (state.KeepRunning()) {
+        // Spread out over the future so that insertions land all over the queue
+        for (u64 i = 0; i < NUM_EVENTS; ++i) {
+            ScheduleEvent(static_cast<s64>((i * 7919) % 1000 + 1) * 1000, event_type, i);
+        }
+        for (u64 i = 0; i < NUM_EVENTS; ++i) {
+            UnscheduleEvent(event_type, i);
+        }
+    }
+
+    Shutdown();
+}
+BENCHMARK(ScheduleUnscheduleEvents);
+
+static u64 events_run = 0;
+
+static void ScheduleAdvanceEvents(Benchmark::State& state) {
+    Init();
+    EventType* const event_type = RegisterEvent("benchmark", [](u64, int) { ++events_run; });
+    // Ends slice -1, as the CPU cores do before running anything
+    Advance();
+
+    while (state.KeepRunning()) {
+        events_run = 0;
+        for (u64 i = 0; i < NUM_EVENTS; ++i) {
+            ScheduleEvent(static_cast<s64>(i + 1) * 100, event_type, i);
+        }
+        // Pretends the main core ran up to each event in turn
+        while (events_run < NUM_EVENTS) {
+            AddTicks(GetDowncount());
+            Advance();
+        }
+    }
+
+    Shutdown();
+}
+BENCHMARK(ScheduleAdvanceEvents);
+
+} // namespace CoreTiming
@@ -0,0 +1,75 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <memory>
+#include <random>
+#include <vector>
+#include "benchmarks/benchmark.h"
+#include "core/crypto/ctr_encryption_layer.h"
+#include "core/crypto/xts_encryption_layer.h"
+#include "core/file_sys/vfs_vector.h"
+
+namespace Core::Crypto {
+
+constexpr std::size_t FILE_SIZE = 0x800000;
+/// As big as the reads of a title streaming its RomFS
+constexpr std::size_t READ_SIZE = 0x100000;
+
+static FileSys::VirtualFile MakeRandomFile() {
+    std::vector<u8> data(FILE_SIZE);
+    std::mt19937 rng(1);
+    std::generate(data.begin(), data.end(), [&rng] { return static_cast<u8>(rng()); });
+    return std::make_shared<FileSys::VectorVfsFile>(std::move(data));
+}
+
+/// Reads READ_SIZE bytes per iteration, walking through the whole file from offset on
+static void ReadThrough(Benchmark::State& state, const FileSys::VirtualFile& file,
+                        std::size_t offset) {
+    std::vector<u8> buffer(READ_SIZE);
+    while (state.KeepRunning()) {
+        Benchmark::DoNotOptimize(file->Read(buffer.data(), buffer.size(), offset));
+        offset = (offset + READ_SIZE) % (FILE_SIZE - READ_SIZE);
+    }
+    state.SetBytesPerIteration(READ_SIZE);
+}
+
+static std::shared_ptr<CTREncryptionLayer> MakeCTRLayer() {
+    const Key128 key{0x10, 0x32, 0x54, 0x76, 0x98, 0xBA, 0xDC, 0xFE,
+                     0xEF, 0xCD, 0xAB, 0x89, 0x67, 0x45, 0x23, 0x01};
+    auto layer = std::make_shared<CTREncryptionLayer>(MakeRandomFile(), key, 0);
+    layer->SetIV({0xA0, 0xA1, 0xA2, 0xA3, 0xA4, 0xA5, 0xA6, 0xA7});
+    return layer;
+}
+
+static void CTRRead_Aligned(Benchmark::State& state) {
+    ReadThrough(state, MakeCTRLayer(), 0);
+}
+BENCHMARK(CTRRead_Aligned);
+
+static void CTRRead_Unaligned(Benchmark::State& state) {
+    ReadThrough(state, MakeCTRLayer(), 0x7);
+}
+BENCHMARK(CTRRead_Unaligned);
+
+static std::shared_ptr<XTSEncryptionLayer> MakeXTSLayer() {
+    Key256 key;
+    for (std::size_t i = 0; i < key.size(); ++i) {
+        key[i] = static_cast<u8>(i * 0x11);
+    }
+    return std::make_shared<XTSEncryptionLayer>(MakeRandomFile(), key);
+}
+
+static void XTSRead_Aligned(Benchmark::State& state) {
+    ReadThrough(state, MakeXTSLayer(), 0);
+}
+BENCHMARK(XTSRead_Aligned);
+
+static void XTSRead_Unaligned(Benchmark::State& state) {
+    // Starts and ends in the middle of a sector, which is then decrypted whole
+    ReadThrough(state, MakeXTSLayer(), 0x123);
+}
+BENCHMARK(XTSRead_Unaligned);
+
+} // namespace Core::Crypto
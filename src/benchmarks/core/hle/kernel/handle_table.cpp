@@ -0,0 +1,58 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <array>
+#include <memory>
+#include "benchmarks/benchmark.h"
+#include "core/hle/kernel/event.h"
+#include "core/hle/kernel/handle_table.h"
+
+namespace Kernel {
+
+/// About as many handles as a title keeps open
+constexpr std::size_t NUM_HANDLES = 256;
+
+static void HandleTableCreateClose(Benchmark::State& state) {
+    const auto table = std::make_unique<HandleTable>();
+    const SharedPtr<Event> event = Event::Create(ResetType::OneShot);
+    std::array<Handle, NUM_HANDLES> handles;
+
+    while (state.KeepRunning()) {
+        for (auto& handle : handles) {
+            handle = table->Create(event).Unwrap();
+        }
+        for (const auto handle : handles) {
+            table->Close(handle);
+        }
+    }
+}
+BENCHMARK(HandleTableCreateClose);
+
+static void HandleTableGet(Benchmark::State& state) {
+    const auto table = std::make_unique<HandleTable>();
+    std::array<Handle, NUM_HANDLES> handles;
+    for (auto& handle : handles) {
+        handle = table->Create(Event::Create(ResetType::OneShot)).Unwrap();
+    }
+
+    // The lookup every SVC taking a handle starts with
+    while (state.KeepRunning()) {
+        for (const auto handle : handles) {
+            Benchmark::DoNotOptimize(table->Get<Event>(handle));
+        }
+    }
+}
+BENCHMARK(HandleTableGet);
+
+static void HandleTableDuplicate(Benchmark::State& state) {
+    const auto table = std::make_unique<HandleTable>();
+    const Handle original = table->Create(Event::Create(ResetType::OneShot)).Unwrap();
+
+    while (state.KeepRunning()) {
+        table->Close(table->Duplicate(original).Unwrap());
+    }
+}
+BENCHMARK(HandleTableDuplicate);
+
+} // namespace Kernel
@@ -0,0 +1,93 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <memory>
+#include <vector>
+#include "benchmarks/benchmark.h"
+#include "core/core.h"
+#include "core/hle/kernel/process.h"
+#include "core/memory.h"
+
+namespace Memory {
+
+constexpr VAddr BASE_ADDRESS = 0x10000000;
+constexpr u64 REGION_SIZE = 0x100000;
+
+/**
+ * Maps a block of memory into a fresh current process and makes its page table the current one,
+ * optionally marking the pages as cached by the rasterizer so that accesses take the slow path.
+ * With the system powered off, the slow path doesn't call into a rasterizer.
+ */
+class ScopeMemory final {
+public:
+    explicit ScopeMemory(bool rasterizer_cached) {
+        Core::CurrentProcess() = Kernel::Process::Create("");
+        auto& vm_manager = Core::CurrentProcess()->vm_manager;
+        vm_manager
+            .MapMemoryBlock(BASE_ADDRESS, std::make_shared<std::vector<u8>>(REGION_SIZE), 0,
+                            REGION_SIZE, Kernel::MemoryState::Heap)
+            .Unwrap();
+
+        auto& page_table = vm_manager.page_table;
+        if (rasterizer_cached) {
+            const u64 first = BASE_ADDRESS >> PAGE_BITS;
+            const u64 last = (BASE_ADDRESS + REGION_SIZE) >> PAGE_BITS;
+            std::fill(page_table.pointers.begin() + first, page_table.pointers.begin() + last,
+                      nullptr);
+            std::fill(page_table.attributes.begin() + first,
+                      page_table.attributes.begin() + last, PageType::RasterizerCachedMemory);
+        }
+        SetCurrentPageTable(&page_table);
+    }
+
+    ~ScopeMemory() {
+        SetCurrentPageTable(nullptr);
+        Core::CurrentProcess() = nullptr;
+    }
+};
+
+static void ReadWords(Benchmark::State& state, bool rasterizer_cached) {
+    const ScopeMemory memory{rasterizer_cached};
+    while (state.KeepRunning()) {
+        u32 sum = 0;
+        for (VAddr addr = BASE_ADDRESS; addr < BASE_ADDRESS + REGION_SIZE; addr += 4) {
+            sum += Read32(addr);
+        }
+        Benchmark::DoNotOptimize(sum);
+    }
+    state.SetBytesPerIteration(REGION_SIZE);
+}
+
+static void WriteWords(Benchmark::State& state, bool rasterizer_cached) {
+    const ScopeMemory memory{rasterizer_cached};
+    while (state.KeepRunning()) {
+        for (VAddr addr = BASE_ADDRESS; addr < BASE_ADDRESS + REGION_SIZE; addr += 4) {
+            Write32(addr, static_cast<u32>(addr));
+        }
+    }
+    state.SetBytesPerIteration(REGION_SIZE);
+}
+
+static void MemoryRead32_FastPath(Benchmark::State& state) {
+    ReadWords(state, false);
+}
+BENCHMARK(MemoryRead32_FastPath);
+
+static void MemoryRead32_SlowPath(Benchmark::State& state) {
+    ReadWords(state, true);
+}
+BENCHMARK(MemoryRead32_SlowPath);
+
+static void MemoryWrite32_FastPath(Benchmark::State& state) {
+    WriteWords(state, false);
+}
+BENCHMARK(MemoryWrite32_FastPath);
+
+static void MemoryWrite32_SlowPath(Benchmark::State& state) {
+    WriteWords(state, true);
+}
+BENCHMARK(MemoryWrite32_SlowPath);
+
+} // namespace Memory
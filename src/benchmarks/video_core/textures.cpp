@@ -0,0 +1,91 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <random>
+#include <vector>
+#include "benchmarks/benchmark.h"
+#include "video_core/textures/astc.h"
+#include "video_core/textures/decoders.h"
+#include "video_core/utils.h"
+
+namespace Tegra::Texture {
+
+constexpr u32 WIDTH = 1024;
+constexpr u32 HEIGHT = 1024;
+constexpr u32 BYTES_PER_PIXEL = 4;
+
+static std::vector<u8> MakeRandomData(std::size_t size) {
+    std::vector<u8> data(size);
+    std::mt19937 rng(1);
+    std::generate(data.begin(), data.end(), [&rng] { return static_cast<u8>(rng()); });
+    return data;
+}
+
+static void CopySwizzledDataRGBA8(Benchmark::State& state, bool unswizzle) {
+    std::vector<u8> swizzled = MakeRandomData(
+        CalculateBlockLinearSize(WIDTH, HEIGHT, BYTES_PER_PIXEL, TICEntry::DefaultBlockHeight));
+    std::vector<u8> linear = MakeRandomData(WIDTH * HEIGHT * BYTES_PER_PIXEL);
+
+    while (state.KeepRunning()) {
+        CopySwizzledData(WIDTH, HEIGHT, BYTES_PER_PIXEL, BYTES_PER_PIXEL, swizzled.data(),
+                         linear.data(), unswizzle, TICEntry::DefaultBlockHeight);
+        Benchmark::DoNotOptimize(unswizzle ? linear.front() : swizzled.front());
+    }
+    state.SetBytesPerIteration(linear.size());
+}
+
+static void CopySwizzledData_Unswizzle(Benchmark::State& state) {
+    CopySwizzledDataRGBA8(state, true);
+}
+BENCHMARK(CopySwizzledData_Unswizzle);
+
+static void CopySwizzledData_Swizzle(Benchmark::State& state) {
+    CopySwizzledDataRGBA8(state, false);
+}
+BENCHMARK(CopySwizzledData_Swizzle);
+
+static void MortonCopyPixels128RGBA8(Benchmark::State& state, bool morton_to_gl) {
+    // Framebuffers are tiled in 128x128 blocks, so the size is whole tiles
+    constexpr u32 width = 1280;
+    constexpr u32 height = 768;
+    std::vector<u8> morton = MakeRandomData(width * height * BYTES_PER_PIXEL);
+    std::vector<u8> gl = MakeRandomData(width * height * BYTES_PER_PIXEL);
+
+    while (state.KeepRunning()) {
+        VideoCore::MortonCopyPixels128(width, height, BYTES_PER_PIXEL, BYTES_PER_PIXEL,
+                                       morton.data(), gl.data(), morton_to_gl);
+        Benchmark::DoNotOptimize(morton_to_gl ? gl.front() : morton.front());
+    }
+    state.SetBytesPerIteration(gl.size());
+}
+
+static void MortonCopyPixels128_MortonToGL(Benchmark::State& state) {
+    MortonCopyPixels128RGBA8(state, true);
+}
+BENCHMARK(MortonCopyPixels128_MortonToGL);
+
+static void MortonCopyPixels128_GLToMorton(Benchmark::State& state) {
+    MortonCopyPixels128RGBA8(state, false);
+}
+BENCHMARK(MortonCopyPixels128_GLToMorton);
+
+static void ASTCDecompress8x8(Benchmark::State& state) {
+    constexpr u32 width = 256;
+    constexpr u32 height = 256;
+    constexpr u32 block_size = 8;
+    // Random blocks exercise every block mode, including reserved ones, and stay the same between
+    // runs so that the numbers can be compared
+    std::vector<u8> data = MakeRandomData((width / block_size) * (height / block_size) * 16);
+
+    while (state.KeepRunning()) {
+        const std::vector<u8> decoded =
+            ASTC::Decompress(data, width, height, block_size, block_size);
+        Benchmark::DoNotOptimize(decoded.data());
+    }
+    state.SetBytesPerIteration(width * height * 4);
+}
+BENCHMARK(ASTCDecompress8x8);
+
+} // namespace Tegra::Texture
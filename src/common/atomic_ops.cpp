@@ -0,0 +1,90 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <cstring>
+#include <mutex>
+
+#include "common/atomic_ops.h"
+
+#if _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace Common {
+
+#if _MSC_VER
+
+bool AtomicCompareAndSwap(u8* pointer, u8 value, u8 expected) {
+    const u8 result =
+        _InterlockedCompareExchange8(reinterpret_cast<char*>(pointer), value, expected);
+    return result == expected;
+}
+
+bool AtomicCompareAndSwap(u16* pointer, u16 value, u16 expected) {
+    const u16 result =
+        _InterlockedCompareExchange16(reinterpret_cast<short*>(pointer), value, expected);
+    return result == expected;
+}
+
+bool AtomicCompareAndSwap(u32* pointer, u32 value, u32 expected) {
+    const u32 result =
+        _InterlockedCompareExchange(reinterpret_cast<long*>(pointer), value, expected);
+    return result == expected;
+}
+
+bool AtomicCompareAndSwap(u64* pointer, u64 value, u64 expected) {
+    const u64 result =
+        _InterlockedCompareExchange64(reinterpret_cast<__int64*>(pointer), value, expected);
+    return result == expected;
+}
+
+bool AtomicCompareAndSwap(u64* pointer, u128 value, u128 expected) {
+    // The comparand is overwritten with the current value, which is not needed here
+    return _InterlockedCompareExchange128(reinterpret_cast<__int64*>(pointer), value[1], value[0],
+                                          reinterpret_cast<__int64*>(expected.data())) != 0;
+}
+
+#else
+
+bool AtomicCompareAndSwap(u8* pointer, u8 value, u8 expected) {
+    return __sync_bool_compare_and_swap(pointer, expected, value);
+}
+
+bool AtomicCompareAndSwap(u16* pointer, u16 value, u16 expected) {
+    return __sync_bool_compare_and_swap(pointer, expected, value);
+}
+
+bool AtomicCompareAndSwap(u32* pointer, u32 value, u32 expected) {
+    return __sync_bool_compare_and_swap(pointer, expected, value);
+}
+
+bool AtomicCompareAndSwap(u64* pointer, u64 value, u64 expected) {
+    return __sync_bool_compare_and_swap(pointer, expected, value);
+}
+
+bool AtomicCompareAndSwap(u64* pointer, u128 value, u128 expected) {
+#ifdef ARCHITECTURE_x86_64
+    // Emitted by hand so that the build does not depend on -mcx16 or libatomic
+    bool result;
+    __asm__ __volatile__("lock cmpxchg16b %1\n\t"
+                         "sete %0"
+                         : "=q"(result), "+m"(*pointer), "+a"(expected[0]), "+d"(expected[1])
+                         : "b"(value[0]), "c"(value[1])
+                         : "cc");
+    return result;
+#else
+    // Hosts without a 128-bit compare-and-swap serialize these through a lock instead
+    static std::mutex cas_mutex;
+    std::lock_guard<std::mutex> lock(cas_mutex);
+    if (std::memcmp(pointer, expected.data(), sizeof(u128)) != 0) {
+        return false;
+    }
+    std::memcpy(pointer, value.data(), sizeof(u128));
+    return true;
+#endif
+}
+
+#endif
+
+} // namespace Common
@@ -0,0 +1,23 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include "common/common_types.h"
+
+namespace Common {
+
+/**
+ * Atomically replaces the value at `pointer` with `value` if it currently equals `expected`.
+ * The pointer must be naturally aligned for the operation to be atomic on the host.
+ *
+ * @returns true if the value was replaced, false if the comparison failed.
+ */
+bool AtomicCompareAndSwap(u8* pointer, u8 value, u8 expected);
+bool AtomicCompareAndSwap(u16* pointer, u16 value, u16 expected);
+bool AtomicCompareAndSwap(u32* pointer, u32 value, u32 expected);
+bool AtomicCompareAndSwap(u64* pointer, u64 value, u64 expected);
+bool AtomicCompareAndSwap(u64* pointer, u128 value, u128 expected);
+
+} // namespace Common
@@ -139,7 +139,8 @@ public:
      * the results together.
      */
     static constexpr FORCE_INLINE StorageType FormatValue(const T& value) {
-        return ((StorageType)value << position) & mask;
+        return static_cast<StorageType>((static_cast<StorageTypeU>(value) << position) &
+                                        static_cast<StorageTypeU>(mask));
     }
 
     /**
@@ -148,11 +149,15 @@ public:
      * union in a constexpr context.
      */
     static constexpr FORCE_INLINE T ExtractValue(const StorageType& storage) {
-        if (std::numeric_limits<T>::is_signed) {
-            std::size_t shift = 8 * sizeof(T) - bits;
-            return (T)((storage << (shift - position)) >> shift);
+        // Both are a single shift and mask, or two shifts for sign extension. The left shift is
+        // done unsigned, as shifting bits into the sign bit of a signed value is undefined.
+        if constexpr (std::numeric_limits<T>::is_signed) {
+            constexpr std::size_t shift = 8 * sizeof(T) - bits;
+            const auto shifted = static_cast<StorageTypeU>(storage) << (shift - position);
+            return static_cast<T>(static_cast<StorageType>(shifted) >> shift);
         } else {
-            return (T)((storage & mask) >> position);
+            return static_cast<T>((static_cast<StorageTypeU>(storage) >> position) &
+                                  (static_cast<StorageTypeU>(mask) >> position));
         }
     }
 
@@ -174,11 +179,11 @@ public:
         storage = (storage & ~mask) | FormatValue(value);
     }
 
-    constexpr T Value() const {
+    constexpr FORCE_INLINE T Value() const {
         return ExtractValue(storage);
     }
 
-    constexpr explicit operator bool() const {
+    constexpr FORCE_INLINE explicit operator bool() const {
         return Value() != 0;
     }
 
@@ -84,10 +84,14 @@ bool CreateEmptyFile(const std::string& filename);
  * entries, never null
  * @param directory the path to the enclosing directory
  * @param virtual_name the entry name, without any preceding directory info
+ * @param is_directory whether the entry is a directory, following symbolic links as IsDirectory
+ * does. Taken from the directory listing itself where the host provides it, which saves a stat
+ * per entry.
  * @return whether handling the entry succeeded
  */
-using DirectoryEntryCallable = std::function<bool(
-    u64* num_entries_out, const std::string& directory, const std::string& virtual_name)>;
+using DirectoryEntryCallable =
+    std::function<bool(u64* num_entries_out, const std::string& directory,
+                       const std::string& virtual_name, bool is_directory)>;
 
 /**
  * Scans a directory, calling the callback for each file/directory contained within.
@@ -102,7 +106,8 @@ bool ForeachDirectoryEntry(u64* num_entries_out, const std::string& directory,
                            DirectoryEntryCallable callback);
 
 /**
- * Scans the directory tree, storing the results.
+ * Scans the directory tree, storing the results. Subdirectories are scanned in parallel on the
+ * shared thread pool.
  * @param directory the parent directory to start scanning from
  * @param parent_entry FSTEntry where the filesystem tree results will be stored.
  * @param recursion Number of children directories to read before giving up.
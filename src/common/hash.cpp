@@ -0,0 +1,205 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include "common/hash.h"
+
+#ifdef ARCHITECTURE_x86_64
+#include <nmmintrin.h>
+#include "common/x64/cpu_detect.h"
+#elif defined(__ARM_FEATURE_CRC32)
+#include <arm_acle.h>
+#endif
+
+#if defined(ARCHITECTURE_x86_64) && !defined(_MSC_VER)
+// Lets the SSE4.2 path be compiled without requiring SSE4.2 from the whole build
+#define TARGET_SSE42 __attribute__((target("sse4.2")))
+#else
+#define TARGET_SSE42
+#endif
+
+namespace Common {
+
+namespace {
+
+constexpr u64 PRIME64_1 = 0x9E3779B185EBCA87ULL;
+constexpr u64 PRIME64_2 = 0xC2B2AE3D27D4EB4FULL;
+constexpr u64 PRIME64_3 = 0x165667B19E3779F9ULL;
+constexpr u64 PRIME64_4 = 0x85EBCA77C2B2AE63ULL;
+constexpr u64 PRIME64_5 = 0x27D4EB2F165667C5ULL;
+
+constexpr u64 RotateLeft(u64 value, int amount) {
+    return (value << amount) | (value >> (64 - amount));
+}
+
+u64 Read64(const u8* data) {
+    u64 value;
+    std::memcpy(&value, data, sizeof(value));
+    return value;
+}
+
+u32 Read32(const u8* data) {
+    u32 value;
+    std::memcpy(&value, data, sizeof(value));
+    return value;
+}
+
+constexpr u64 Round(u64 accumulator, u64 input) {
+    accumulator += input * PRIME64_2;
+    accumulator = RotateLeft(accumulator, 31);
+    return accumulator * PRIME64_1;
+}
+
+constexpr u64 MergeRound(u64 hash, u64 accumulator) {
+    hash ^= Round(0, accumulator);
+    return hash * PRIME64_1 + PRIME64_4;
+}
+
+/// Consumes every whole 32-byte stripe of data, returns the number of bytes consumed
+size_t ProcessStripes(std::array<u64, 4>& accumulators, const u8* data, size_t len) {
+    const u8* const end = data + len - len % 32;
+    const u8* ptr = data;
+    for (; ptr < end; ptr += 32) {
+        accumulators[0] = Round(accumulators[0], Read64(ptr));
+        accumulators[1] = Round(accumulators[1], Read64(ptr + 8));
+        accumulators[2] = Round(accumulators[2], Read64(ptr + 16));
+        accumulators[3] = Round(accumulators[3], Read64(ptr + 24));
+    }
+    return static_cast<size_t>(ptr - data);
+}
+
+/// Table for the bytewise CRC32C fallback, of the reflected Castagnoli polynomial
+constexpr std::array<u32, 256> MakeCRC32CTable() {
+    std::array<u32, 256> table{};
+    for (u32 i = 0; i < 256; ++i) {
+        u32 crc = i;
+        for (int bit = 0; bit < 8; ++bit) {
+            crc = (crc >> 1) ^ ((crc & 1) != 0 ? 0x82F63B78 : 0);
+        }
+        table[i] = crc;
+    }
+    return table;
+}
+
+constexpr std::array<u32, 256> CRC32C_TABLE = MakeCRC32CTable();
+
+[[maybe_unused]] u32 SoftwareCRC32C(const u8* data, size_t len, u32 crc) {
+    for (size_t i = 0; i < len; ++i) {
+        crc = CRC32C_TABLE[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    }
+    return crc;
+}
+
+#ifdef ARCHITECTURE_x86_64
+TARGET_SSE42 u32 HardwareCRC32C(const u8* data, size_t len, u32 crc) {
+    u64 crc64 = crc;
+    for (; len >= 8; data += 8, len -= 8) {
+        crc64 = _mm_crc32_u64(crc64, Read64(data));
+    }
+    crc = static_cast<u32>(crc64);
+    for (; len > 0; ++data, --len) {
+        crc = _mm_crc32_u8(crc, *data);
+    }
+    return crc;
+}
+#elif defined(__ARM_FEATURE_CRC32)
+u32 HardwareCRC32C(const u8* data, size_t len, u32 crc) {
+    for (; len >= 8; data += 8, len -= 8) {
+        crc = __crc32cd(crc, Read64(data));
+    }
+    for (; len > 0; ++data, --len) {
+        crc = __crc32cb(crc, *data);
+    }
+    return crc;
+}
+#endif
+
+} // Anonymous namespace
+
+XXHash64::XXHash64(u64 seed) : seed(seed) {
+    accumulators = {seed + PRIME64_1 + PRIME64_2, seed + PRIME64_2, seed, seed - PRIME64_1};
+}
+
+void XXHash64::Update(const void* data, size_t len) {
+    const u8* ptr = static_cast<const u8*>(data);
+    total_size += len;
+
+    // Complete the stripe left over by the previous update first
+    if (buffered_size != 0) {
+        const size_t copy_size = std::min(len, buffer.size() - buffered_size);
+        std::memcpy(buffer.data() + buffered_size, ptr, copy_size);
+        buffered_size += copy_size;
+        ptr += copy_size;
+        len -= copy_size;
+        if (buffered_size < buffer.size()) {
+            return;
+        }
+        ProcessStripes(accumulators, buffer.data(), buffer.size());
+        buffered_size = 0;
+    }
+
+    const size_t consumed = ProcessStripes(accumulators, ptr, len);
+    buffered_size = len - consumed;
+    std::memcpy(buffer.data(), ptr + consumed, buffered_size);
+}
+
+u64 XXHash64::Digest() const {
+    u64 hash;
+    if (total_size >= 32) {
+        hash = RotateLeft(accumulators[0], 1) + RotateLeft(accumulators[1], 7) +
+               RotateLeft(accumulators[2], 12) + RotateLeft(accumulators[3], 18);
+        for (const u64 accumulator : accumulators) {
+            hash = MergeRound(hash, accumulator);
+        }
+    } else {
+        hash = seed + PRIME64_5;
+    }
+    hash += total_size;
+
+    const u8* ptr = buffer.data();
+    size_t len = buffered_size;
+    for (; len >= 8; ptr += 8, len -= 8) {
+        hash ^= Round(0, Read64(ptr));
+        hash = RotateLeft(hash, 27) * PRIME64_1 + PRIME64_4;
+    }
+    if (len >= 4) {
+        hash ^= static_cast<u64>(Read32(ptr)) * PRIME64_1;
+        hash = RotateLeft(hash, 23) * PRIME64_2 + PRIME64_3;
+        ptr += 4;
+        len -= 4;
+    }
+    for (; len > 0; ++ptr, --len) {
+        hash ^= *ptr * PRIME64_5;
+        hash = RotateLeft(hash, 11) * PRIME64_1;
+    }
+
+    hash ^= hash >> 33;
+    hash *= PRIME64_2;
+    hash ^= hash >> 29;
+    hash *= PRIME64_3;
+    hash ^= hash >> 32;
+    return hash;
+}
+
+u64 ComputeXXHash64(const void* data, size_t len, u64 seed) {
+    XXHash64 hash(seed);
+    hash.Update(data, len);
+    return hash.Digest();
+}
+
+u32 ComputeCRC32C(const void* data, size_t len, u32 crc) {
+    const u8* ptr = static_cast<const u8*>(data);
+    crc = ~crc;
+#ifdef ARCHITECTURE_x86_64
+    static const bool has_sse42 = GetCPUCaps().sse4_2;
+    crc = has_sse42 ? HardwareCRC32C(ptr, len, crc) : SoftwareCRC32C(ptr, len, crc);
+#elif defined(__ARM_FEATURE_CRC32)
+    crc = HardwareCRC32C(ptr, len, crc);
+#else
+    crc = SoftwareCRC32C(ptr, len, crc);
+#endif
+    return ~crc;
+}
+
+} // namespace Common
@@ -4,8 +4,10 @@
 
 #pragma once
 
+#include <array>
 #include <cstddef>
 #include <cstring>
+#include <type_traits>
 #include "common/cityhash.h"
 #include "common/common_types.h"
 
@@ -21,20 +23,83 @@ static inline u64 ComputeHash64(const void* data, size_t len) {
     return CityHash64(static_cast<const char*>(data), len);
 }
 
+/**
+ * Streaming XXH64. Unlike CityHash64 it can hash data that isn't contiguous, such as texture and
+ * buffer contents spread over several pages, piece by piece, without copying it together first.
+ */
+class XXHash64 final {
+public:
+    explicit XXHash64(u64 seed = 0);
+
+    /// Hashes the next len bytes of the input
+    void Update(const void* data, size_t len);
+
+    /// Returns the hash of everything passed to Update so far
+    u64 Digest() const;
+
+private:
+    std::array<u64, 4> accumulators;
+    /// Tail of the input that doesn't fill a whole stripe yet
+    std::array<u8, 32> buffer;
+    size_t buffered_size = 0;
+    u64 total_size = 0;
+    u64 seed;
+};
+
+/**
+ * Computes the XXH64 hash of a block of data
+ * @param data Block of data to compute hash over
+ * @param len Length of data (in bytes) to compute hash over
+ * @param seed Value to start the hash from
+ * @returns 64-bit hash value that was computed over the data block
+ */
+u64 ComputeXXHash64(const void* data, size_t len, u64 seed = 0);
+
+/**
+ * Computes the CRC32C (Castagnoli) checksum of a block of data, using the SSE4.2 or ARMv8 CRC
+ * instructions when the host has them. Pass the result of a previous call as crc to continue it
+ * over more data.
+ * @param data Block of data to compute the checksum over
+ * @param len Length of data (in bytes) to compute the checksum over
+ * @param crc Checksum of the data preceding this block, 0 to start a new one
+ * @returns 32-bit checksum of the data so far
+ */
+u32 ComputeCRC32C(const void* data, size_t len, u32 crc = 0);
+
+/// Hash functions HashableStruct and ComputeStructHash64 can be parameterized with
+struct CityHasher {
+    static u64 Hash(const void* data, size_t len) {
+        return ComputeHash64(data, len);
+    }
+};
+
+struct XXHasher {
+    static u64 Hash(const void* data, size_t len) {
+        return ComputeXXHash64(data, len);
+    }
+};
+
+/// Only 32 bits wide, so better suited to detecting changes in contents than to keying big caches
+struct CRC32CHasher {
+    static u64 Hash(const void* data, size_t len) {
+        return ComputeCRC32C(data, len);
+    }
+};
+
 /**
  * Computes a 64-bit hash of a struct. In addition to being trivially copyable, it is also critical
  * that either the struct includes no padding, or that any padding is initialized to a known value
  * by memsetting the struct to 0 before filling it in.
  */
-template <typename T>
+template <typename Hasher = CityHasher, typename T>
 static inline u64 ComputeStructHash64(const T& data) {
     static_assert(std::is_trivially_copyable_v<T>,
                   "Type passed to ComputeStructHash64 must be trivially copyable");
-    return ComputeHash64(&data, sizeof(data));
+    return Hasher::Hash(&data, sizeof(data));
 }
 
 /// A helper template that ensures the padding in a struct is initialized by memsetting to 0.
-template <typename T>
+template <typename T, typename Hasher = CityHasher>
 struct HashableStruct {
     // In addition to being trivially copyable, T must also have a trivial default constructor,
     // because any member initialization would be overridden by memset
@@ -55,16 +120,16 @@ struct HashableStruct {
         std::memset(&state, 0, sizeof(T));
     }
 
-    bool operator==(const HashableStruct<T>& o) const {
+    bool operator==(const HashableStruct& o) const {
         return std::memcmp(&state, &o.state, sizeof(T)) == 0;
     };
 
-    bool operator!=(const HashableStruct<T>& o) const {
+    bool operator!=(const HashableStruct& o) const {
         return !(*this == o);
     };
 
     size_t Hash() const {
-        return Common::ComputeStructHash64(state);
+        return Common::ComputeStructHash64<Hasher>(state);
     }
 };
 
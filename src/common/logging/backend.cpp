@@ -7,6 +7,9 @@
 #include <chrono>
 #include <climits>
 #include <condition_variable>
+#include <cstring>
+#include <iterator>
+#include <limits>
 #include <memory>
 #include <mutex>
 #include <thread>
@@ -20,11 +23,41 @@
 #include "common/logging/backend.h"
 #include "common/logging/log.h"
 #include "common/logging/text_formatter.h"
+#include "common/memory_tracker.h"
 #include "common/string_util.h"
+#include "common/thread.h"
 #include "common/threadsafe_queue.h"
 
 namespace Log {
 
+/// Returns the time elapsed since the first message was logged
+static std::chrono::microseconds GetTimestamp() {
+    using std::chrono::duration_cast;
+    using std::chrono::steady_clock;
+
+    static steady_clock::time_point time_origin = steady_clock::now();
+    return duration_cast<std::chrono::microseconds>(steady_clock::now() - time_origin);
+}
+
+/// A message as logged by FmtLogMessage, before it is turned into an Entry by the logging thread
+struct PendingEntry {
+    std::chrono::microseconds timestamp;
+    Class log_class;
+    Level log_level;
+    const char* filename;
+    unsigned int line_num;
+    const char* function;
+    /// Formats the message from format and args, or nullptr if message was already formatted
+    DeferredFormatter formatter;
+    const char* format;
+    std::array<u8, MAX_DEFERRED_ARGS_SIZE> args;
+    std::string message;
+};
+
+/// Messages logged by one thread, read by the logging thread. As there is a single writer and a
+/// single reader, neither ever takes a lock or allocates.
+using EntryRing = Common::SPSCRing<PendingEntry, 1024>;
+
 /**
  * Static state as a singleton.
  */
@@ -39,9 +72,30 @@ public:
     const Impl& operator=(Impl const&) = delete;
 
     void PushEntry(Entry e) {
-        std::lock_guard<std::mutex> lock(message_mutex);
-        message_queue.Push(std::move(e));
-        message_cv.notify_one();
+        while (!message_queue.TryPush(std::move(e))) {
+            if (!running)
+                return;
+            WakeUp();
+            std::this_thread::yield();
+        }
+        WakeUp();
+    }
+
+    void PushEntry(PendingEntry& e) {
+        const bool urgent = e.log_level >= Level::Error;
+        EntryRing& ring = GetThreadRing();
+        while (!ring.TryPush(std::move(e))) {
+            // The logging thread is behind, wait for it to free up some room
+            if (!running)
+                return;
+            WakeUp();
+            std::this_thread::yield();
+        }
+
+        // Everything else is picked up on the logging thread's next poll, errors are written out
+        // right away in case they come right before a crash
+        if (urgent)
+            WakeUp();
     }
 
     void AddBackend(std::unique_ptr<Backend> backend) {
@@ -77,45 +131,123 @@ public:
 private:
     Impl() {
         backend_thread = std::thread([&] {
-            Entry entry;
-            auto write_logs = [&](Entry& e) {
-                std::lock_guard<std::mutex> lock(writing_mutex);
-                for (const auto& backend : backends) {
-                    backend->Write(e);
-                }
-            };
+            // Writing out logs is never latency sensitive, leave the host cores to emulation
+            Common::SetCurrentThreadPriority(Common::ThreadPriority::Low);
+
             while (true) {
                 {
                     std::unique_lock<std::mutex> lock(message_mutex);
-                    message_cv.wait(lock, [&] { return !running || message_queue.Pop(entry); });
+                    message_cv.wait_for(lock, POLL_INTERVAL,
+                                        [&] { return !running || wake_up_pending; });
+                    wake_up_pending = false;
                 }
                 if (!running) {
                     break;
                 }
-                write_logs(entry);
+                WriteEntries(std::numeric_limits<size_t>::max());
             }
-            // Drain the logging queue. Only writes out up to MAX_LOGS_TO_WRITE to prevent a case
+            // Drain the logging queues. Only writes out up to MAX_LOGS_TO_WRITE to prevent a case
             // where a system is repeatedly spamming logs even on close.
-            const int MAX_LOGS_TO_WRITE = filter.IsDebug() ? INT_MAX : 100;
-            int logs_written = 0;
-            while (logs_written++ < MAX_LOGS_TO_WRITE && message_queue.Pop(entry)) {
-                write_logs(entry);
-            }
+            const size_t MAX_LOGS_TO_WRITE = filter.IsDebug() ? INT_MAX : 100;
+            WriteEntries(MAX_LOGS_TO_WRITE);
         });
     }
 
     ~Impl() {
         running = false;
-        message_cv.notify_one();
+        WakeUp();
         backend_thread.join();
     }
 
+    /// How long the logging thread sleeps between looking for new messages
+    static constexpr std::chrono::milliseconds POLL_INTERVAL{10};
+
+    void WakeUp() {
+        {
+            std::lock_guard<std::mutex> lock(message_mutex);
+            wake_up_pending = true;
+        }
+        message_cv.notify_one();
+    }
+
+    /// Returns the ring of the calling thread, registering it the first time
+    EntryRing& GetThreadRing() {
+        thread_local const std::shared_ptr<EntryRing> ring = [this] {
+            auto new_ring = std::make_shared<EntryRing>();
+            Common::AddTrackedMemory(Common::MemoryTag::LogQueues, sizeof(EntryRing));
+            std::lock_guard<std::mutex> lock(rings_mutex);
+            rings.push_back(new_ring);
+            return new_ring;
+        }();
+        return *ring;
+    }
+
+    /// Formats and writes out up to max_entries of the queued messages, oldest first
+    void WriteEntries(size_t max_entries) {
+        std::vector<Entry> entries;
+        Entry entry;
+        while (message_queue.Pop(entry)) {
+            entries.push_back(std::move(entry));
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(rings_mutex);
+            PendingEntry pending;
+            for (const auto& ring : rings) {
+                while (ring->Pop(pending)) {
+                    entries.push_back(FinishEntry(pending));
+                }
+            }
+
+            // Rings of threads that exited are only held here
+            const auto exited = std::remove_if(rings.begin(), rings.end(), [](const auto& ring) {
+                return ring.use_count() == 1 && ring->Empty();
+            });
+            Common::AddTrackedMemory(Common::MemoryTag::LogQueues,
+                                     -static_cast<s64>(sizeof(EntryRing)) *
+                                         std::distance(exited, rings.end()));
+            rings.erase(exited, rings.end());
+        }
+
+        // Every thread logs in order, but they need to be interleaved
+        std::stable_sort(entries.begin(), entries.end(),
+                         [](const Entry& a, const Entry& b) { return a.timestamp < b.timestamp; });
+        if (entries.size() > max_entries) {
+            entries.resize(max_entries);
+        }
+
+        std::lock_guard<std::mutex> lock(writing_mutex);
+        for (const auto& e : entries) {
+            for (const auto& backend : backends) {
+                backend->Write(e);
+            }
+        }
+    }
+
+    static Entry FinishEntry(PendingEntry& pending) {
+        Entry entry;
+        entry.timestamp = pending.timestamp;
+        entry.log_class = pending.log_class;
+        entry.log_level = pending.log_level;
+        entry.filename = Common::TrimSourcePath(pending.filename);
+        entry.line_num = pending.line_num;
+        entry.function = pending.function;
+        if (pending.formatter != nullptr) {
+            entry.message = pending.formatter(pending.format, pending.args.data());
+        } else {
+            entry.message = std::move(pending.message);
+        }
+        return entry;
+    }
+
     std::atomic_bool running{true};
-    std::mutex message_mutex, writing_mutex;
+    std::mutex message_mutex, writing_mutex, rings_mutex;
     std::condition_variable message_cv;
+    bool wake_up_pending = false;
     std::thread backend_thread;
     std::vector<std::unique_ptr<Backend>> backends;
-    Common::MPSCQueue<Log::Entry> message_queue;
+    Common::MPSCRing<Log::Entry, 256> message_queue;
+    std::vector<std::shared_ptr<EntryRing>> rings;
     Filter filter;
 };
 
@@ -266,13 +398,8 @@ const char* GetLevelName(Level log_level) {
 
 Entry CreateEntry(Class log_class, Level log_level, const char* filename, unsigned int line_nr,
                   const char* function, std::string message) {
-    using std::chrono::duration_cast;
-    using std::chrono::steady_clock;
-
-    static steady_clock::time_point time_origin = steady_clock::now();
-
     Entry entry;
-    entry.timestamp = duration_cast<std::chrono::microseconds>(steady_clock::now() - time_origin);
+    entry.timestamp = GetTimestamp();
     entry.log_class = log_class;
     entry.log_level = log_level;
     entry.filename = Common::TrimSourcePath(filename);
@@ -283,8 +410,14 @@ Entry CreateEntry(Class log_class, Level log_level, const char* filename, unsign
     return entry;
 }
 
+std::array<std::atomic<Level>, static_cast<std::size_t>(Class::Count)> global_class_levels{};
+
 void SetGlobalFilter(const Filter& filter) {
     Impl::Instance().SetGlobalFilter(filter);
+    for (size_t i = 0; i < global_class_levels.size(); ++i) {
+        global_class_levels[i].store(filter.GetClassLevel(static_cast<Class>(i)),
+                                     std::memory_order_relaxed);
+    }
 }
 
 void AddBackend(std::unique_ptr<Backend> backend) {
@@ -299,6 +432,18 @@ Backend* GetBackend(std::string_view backend_name) {
     return Impl::Instance().GetBackend(backend_name);
 }
 
+bool CheckGlobalFilter(Class log_class, Level log_level) {
+    return Impl::Instance().GetGlobalFilter().CheckMessage(log_class, log_level);
+}
+
+void QueueEntry(Entry entry) {
+    auto& instance = Impl::Instance();
+    if (!instance.GetGlobalFilter().CheckMessage(entry.log_class, entry.log_level))
+        return;
+
+    instance.PushEntry(std::move(entry));
+}
+
 void FmtLogMessageImpl(Class log_class, Level log_level, const char* filename,
                        unsigned int line_num, const char* function, const char* format,
                        const fmt::format_args& args) {
@@ -307,9 +452,23 @@ void FmtLogMessageImpl(Class log_class, Level log_level, const char* filename,
     if (!filter.CheckMessage(log_class, log_level))
         return;
 
-    Entry entry =
-        CreateEntry(log_class, log_level, filename, line_num, function, fmt::vformat(format, args));
+    PendingEntry entry{GetTimestamp(), log_class, log_level, filename, line_num, function};
+    entry.message = fmt::vformat(format, args);
+    instance.PushEntry(entry);
+}
 
-    instance.PushEntry(std::move(entry));
+void DeferredLogMessageImpl(Class log_class, Level log_level, const char* filename,
+                            unsigned int line_num, const char* function, const char* format,
+                            DeferredFormatter formatter, const u8* args, std::size_t args_size) {
+    auto& instance = Impl::Instance();
+    const auto& filter = instance.GetGlobalFilter();
+    if (!filter.CheckMessage(log_class, log_level))
+        return;
+
+    PendingEntry entry{GetTimestamp(), log_class, log_level, filename, line_num, function};
+    entry.formatter = formatter;
+    entry.format = format;
+    std::memcpy(entry.args.data(), args, args_size);
+    instance.PushEntry(entry);
 }
 } // namespace Log
@@ -124,6 +124,12 @@ const char* GetLevelName(Level log_level);
 Entry CreateEntry(Class log_class, Level log_level, const char* filename, unsigned int line_nr,
                   const char* function, std::string message);
 
+/**
+ * Queues an entry created by the caller for the backends, if the global filter lets it through.
+ * Meant for messages that come with their own source location, like those of emulated programs.
+ */
+void QueueEntry(Entry entry);
+
 /**
  * The global filter will prevent any messages from even being processed if they are filtered. Each
  * backend can have a filter, but if the level is lower than the global filter, the backend will
@@ -45,6 +45,9 @@ public:
     /// Matches class/level combination against the filter, returning true if it passed.
     bool CheckMessage(Class log_class, Level level) const;
 
+    /// Returns the minimum level of messages of `log_class` that pass the filter.
+    Level GetClassLevel(Class log_class) const;
+
     /// Returns true if any logging classes are set to debug
     bool IsDebug() const;
 
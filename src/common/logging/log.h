@@ -4,6 +4,13 @@
 
 #pragma once
 
+#include <array>
+#include <atomic>
+#include <cstring>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <utility>
 #include <fmt/format.h>
 #include "common/common_types.h"
 
@@ -119,40 +126,142 @@ enum class Class : ClassType {
     Count              ///< Total number of logging classes
 };
 
+#ifndef YUZU_LOG_MIN_LEVEL
+#define YUZU_LOG_MIN_LEVEL 0
+#endif
+
+/// Messages below this level are compiled out, it is set by the YUZU_LOG_MIN_LEVEL build option
+constexpr Level COMPILED_MIN_LEVEL = static_cast<Level>(YUZU_LOG_MIN_LEVEL);
+
+/// Minimum level of each class in the global filter, mirrored here to be checked inline
+extern std::array<std::atomic<Level>, static_cast<std::size_t>(Class::Count)> global_class_levels;
+
+/**
+ * Whether a message of the given class and level is logged at all. The logging macros check it
+ * before evaluating their arguments, so filtered out messages cost a load and a compare.
+ */
+inline bool IsLevelEnabled(Class log_class, Level log_level) {
+    if (log_level < COMPILED_MIN_LEVEL)
+        return false;
+    const auto& class_level = global_class_levels[static_cast<std::size_t>(log_class)];
+    return log_level >= class_level.load(std::memory_order_relaxed);
+}
+
+/**
+ * Whether a message of the given class and level passes the global filter. Lets callers skip
+ * gathering the contents of messages that would be dropped anyway.
+ */
+bool CheckGlobalFilter(Class log_class, Level log_level);
+
 /// Logs a message to the global logger, using fmt
 void FmtLogMessageImpl(Class log_class, Level log_level, const char* filename,
                        unsigned int line_num, const char* function, const char* format,
                        const fmt::format_args& args);
 
+/// Largest size of the arguments of a message whose formatting can be deferred
+constexpr std::size_t MAX_DEFERRED_ARGS_SIZE = 64;
+
+/// Formats a message from the format string and the packed values of its arguments
+using DeferredFormatter = std::string (*)(const char* format, const u8* args);
+
+/**
+ * Logs a message to the global logger, leaving it to the logging thread to format it. The format
+ * string must outlive the program, as string literals do.
+ * @param args Packed values of the arguments, which formatter knows the types of.
+ */
+void DeferredLogMessageImpl(Class log_class, Level log_level, const char* filename,
+                            unsigned int line_num, const char* function, const char* format,
+                            DeferredFormatter formatter, const u8* args, std::size_t args_size);
+
+/**
+ * Whether an argument can be copied as is and formatted later from another thread. Anything
+ * that refers to memory the caller owns, like strings, has to be formatted right away.
+ */
+template <typename T>
+constexpr bool IsDeferrableArgument =
+    std::is_arithmetic_v<T> || std::is_enum_v<T> || std::is_same_v<T, const void*> ||
+    std::is_same_v<T, void*>;
+
+/// Returns the offsets of the given types when packed one after the other without padding
+template <typename... Args>
+constexpr std::array<std::size_t, sizeof...(Args)> GetPackedOffsets() {
+    constexpr std::array<std::size_t, sizeof...(Args)> sizes{sizeof(Args)...};
+    std::array<std::size_t, sizeof...(Args)> offsets{};
+    std::size_t offset = 0;
+    for (std::size_t i = 0; i < sizes.size(); ++i) {
+        offsets[i] = offset;
+        offset += sizes[i];
+    }
+    return offsets;
+}
+
+template <typename T>
+T LoadPackedArgument(const u8* data) {
+    T value;
+    std::memcpy(&value, data, sizeof(T));
+    return value;
+}
+
+template <typename... Args, std::size_t... I>
+std::string FormatPackedArguments(const char* format, const u8* args, std::index_sequence<I...>) {
+    [[maybe_unused]] constexpr auto offsets = GetPackedOffsets<Args...>();
+    const std::tuple<Args...> values{LoadPackedArgument<Args>(args + offsets[I])...};
+    return std::apply(
+        [format](const auto&... unpacked) {
+            return fmt::vformat(format, fmt::make_format_args(unpacked...));
+        },
+        values);
+}
+
+template <typename... Args>
+std::string FormatPackedArguments(const char* format, const u8* args) {
+    return FormatPackedArguments<Args...>(format, args, std::index_sequence_for<Args...>{});
+}
+
+/// Returns the size of the arguments once packed, or 0 unless all of them are deferrable, as
+/// others may have no size at all, like arrays of unknown bound
+template <typename... Args>
+constexpr std::size_t GetPackedSize() {
+    if constexpr ((IsDeferrableArgument<Args> && ...)) {
+        return (std::size_t{0} + ... + sizeof(Args));
+    } else {
+        return 0;
+    }
+}
+
 template <typename... Args>
 void FmtLogMessage(Class log_class, Level log_level, const char* filename, unsigned int line_num,
                    const char* function, const char* format, const Args&... args) {
-    FmtLogMessageImpl(log_class, log_level, filename, line_num, function, format,
-                      fmt::make_format_args(args...));
+    constexpr std::size_t args_size = GetPackedSize<Args...>();
+    if constexpr ((IsDeferrableArgument<Args> && ...) && args_size <= MAX_DEFERRED_ARGS_SIZE) {
+        // Only the values are copied, formatting them is left to the logging thread
+        std::array<u8, args_size> packed;
+        [[maybe_unused]] std::size_t offset = 0;
+        ((std::memcpy(packed.data() + offset, &args, sizeof(Args)), offset += sizeof(Args)), ...);
+        DeferredLogMessageImpl(log_class, log_level, filename, line_num, function, format,
+                               &FormatPackedArguments<Args...>, packed.data(), args_size);
+    } else {
+        FmtLogMessageImpl(log_class, log_level, filename, line_num, function, format,
+                          fmt::make_format_args(args...));
+    }
 }
 
 } // namespace Log
 
+#define LOG_GENERIC(log_class, log_level, ...)                                                     \
+    (::Log::IsLevelEnabled(::Log::Class::log_class, ::Log::Level::log_level)                       \
+         ? ::Log::FmtLogMessage(::Log::Class::log_class, ::Log::Level::log_level, __FILE__,        \
+                                __LINE__, __func__, __VA_ARGS__)                                   \
+         : void(0))
+
 #ifdef _DEBUG
-#define LOG_TRACE(log_class, ...)                                                                  \
-    ::Log::FmtLogMessage(::Log::Class::log_class, ::Log::Level::Trace, __FILE__, __LINE__,         \
-                         __func__, __VA_ARGS__)
+#define LOG_TRACE(log_class, ...) LOG_GENERIC(log_class, Trace, __VA_ARGS__)
 #else
 #define LOG_TRACE(log_class, fmt, ...) (void(0))
 #endif
 
-#define LOG_DEBUG(log_class, ...)                                                                  \
-    ::Log::FmtLogMessage(::Log::Class::log_class, ::Log::Level::Debug, __FILE__, __LINE__,         \
-                         __func__, __VA_ARGS__)
-#define LOG_INFO(log_class, ...)                                                                   \
-    ::Log::FmtLogMessage(::Log::Class::log_class, ::Log::Level::Info, __FILE__, __LINE__,          \
-                         __func__, __VA_ARGS__)
-#define LOG_WARNING(log_class, ...)                                                                \
-    ::Log::FmtLogMessage(::Log::Class::log_class, ::Log::Level::Warning, __FILE__, __LINE__,       \
-                         __func__, __VA_ARGS__)
-#define LOG_ERROR(log_class, ...)                                                                  \
-    ::Log::FmtLogMessage(::Log::Class::log_class, ::Log::Level::Error, __FILE__, __LINE__,         \
-                         __func__, __VA_ARGS__)
-#define LOG_CRITICAL(log_class, ...)                                                               \
-    ::Log::FmtLogMessage(::Log::Class::log_class, ::Log::Level::Critical, __FILE__, __LINE__,      \
-                         __func__, __VA_ARGS__)
+#define LOG_DEBUG(log_class, ...) LOG_GENERIC(log_class, Debug, __VA_ARGS__)
+#define LOG_INFO(log_class, ...) LOG_GENERIC(log_class, Info, __VA_ARGS__)
+#define LOG_WARNING(log_class, ...) LOG_GENERIC(log_class, Warning, __VA_ARGS__)
+#define LOG_ERROR(log_class, ...) LOG_GENERIC(log_class, Error, __VA_ARGS__)
+#define LOG_CRITICAL(log_class, ...) LOG_GENERIC(log_class, Critical, __VA_ARGS__)
@@ -0,0 +1,181 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <cstring>
+#include "common/logging/log.h"
+#include "common/mapped_file.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#include "common/string_util.h"
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace FileUtil {
+
+MappedFile::MappedFile(const std::string& path) {
+    Open(path);
+}
+
+MappedFile::~MappedFile() {
+    Close();
+}
+
+#ifdef _WIN32
+
+void MappedFile::Open(const std::string& path) {
+    Close();
+
+    // Sharing deletion keeps the file removable while a game is running from it
+    const HANDLE file = CreateFileW(Common::UTF8ToUTF16W(path).c_str(), GENERIC_READ,
+                                    FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                                    nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        return;
+    }
+    file_handle = file;
+
+    LARGE_INTEGER file_size;
+    if (!GetFileSizeEx(file, &file_size)) {
+        return;
+    }
+    size = static_cast<u64>(file_size.QuadPart);
+    if (size == 0) {
+        // Empty files cannot be mapped, and there is nothing to read anyway
+        return;
+    }
+
+    mapping_handle = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mapping_handle == nullptr) {
+        LOG_WARNING(Common_Filesystem, "Could not map {}, falling back to reads", path);
+        return;
+    }
+    view = static_cast<const u8*>(MapViewOfFile(mapping_handle, FILE_MAP_READ, 0, 0, 0));
+    if (view == nullptr) {
+        LOG_WARNING(Common_Filesystem, "Could not map {}, falling back to reads", path);
+    }
+}
+
+void MappedFile::Close() {
+    if (view != nullptr) {
+        UnmapViewOfFile(view);
+        view = nullptr;
+    }
+    if (mapping_handle != nullptr) {
+        CloseHandle(mapping_handle);
+        mapping_handle = nullptr;
+    }
+    if (file_handle != nullptr) {
+        CloseHandle(file_handle);
+        file_handle = nullptr;
+    }
+    size = 0;
+}
+
+bool MappedFile::IsOpen() const {
+    return file_handle != nullptr;
+}
+
+#else
+
+void MappedFile::Open(const std::string& path) {
+    Close();
+
+    fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd == -1) {
+        return;
+    }
+
+    struct stat file_stat;
+    if (fstat(fd, &file_stat) != 0) {
+        return;
+    }
+    size = static_cast<u64>(file_stat.st_size);
+    if (size == 0) {
+        // Empty files cannot be mapped, and there is nothing to read anyway
+        return;
+    }
+
+    void* const mapping = mmap(nullptr, static_cast<size_t>(size), PROT_READ, MAP_SHARED, fd, 0);
+    if (mapping == MAP_FAILED) {
+        LOG_WARNING(Common_Filesystem, "Could not map {}: {}, falling back to reads", path,
+                    std::strerror(errno));
+        return;
+    }
+    view = static_cast<const u8*>(mapping);
+}
+
+void MappedFile::Close() {
+    if (view != nullptr) {
+        munmap(const_cast<u8*>(view), static_cast<size_t>(size));
+        view = nullptr;
+    }
+    if (fd != -1) {
+        close(fd);
+        fd = -1;
+    }
+    size = 0;
+}
+
+bool MappedFile::IsOpen() const {
+    return fd != -1;
+}
+
+#endif
+
+u64 MappedFile::GetSize() const {
+    return size;
+}
+
+const u8* MappedFile::GetPointer() const {
+    return view;
+}
+
+size_t MappedFile::ReadAt(u8* data, size_t length, u64 offset) const {
+    if (offset >= size) {
+        return 0;
+    }
+    length = static_cast<size_t>(std::min<u64>(length, size - offset));
+
+    if (view != nullptr) {
+        std::memcpy(data, view + offset, length);
+        return length;
+    }
+
+    size_t total_read = 0;
+    while (total_read < length) {
+        const u64 position = offset + total_read;
+#ifdef _WIN32
+        OVERLAPPED overlapped{};
+        overlapped.Offset = static_cast<DWORD>(position);
+        overlapped.OffsetHigh = static_cast<DWORD>(position >> 32);
+        const DWORD chunk =
+            static_cast<DWORD>(std::min<size_t>(length - total_read, 0x80000000));
+        DWORD bytes_read = 0;
+        if (!ReadFile(file_handle, data + total_read, chunk, &bytes_read, &overlapped) ||
+            bytes_read == 0) {
+            break;
+        }
+#else
+        const ssize_t bytes_read = pread(fd, data + total_read, length - total_read,
+                                         static_cast<off_t>(position));
+        if (bytes_read < 0 && errno == EINTR) {
+            continue;
+        }
+        if (bytes_read <= 0) {
+            break;
+        }
+#endif
+        total_read += static_cast<size_t>(bytes_read);
+    }
+    return total_read;
+}
+
+} // namespace FileUtil
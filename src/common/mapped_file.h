@@ -0,0 +1,56 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include "common/common_types.h"
+
+namespace FileUtil {
+
+/**
+ * Read-only view of a host file. The file is memory mapped when possible, so reads are plain
+ * copies out of the page cache; otherwise they fall back to positional reads (pread, or ReadFile
+ * with an OVERLAPPED offset). Either way there is no shared file position, so any number of
+ * threads may read concurrently.
+ */
+class MappedFile final : NonCopyable {
+public:
+    explicit MappedFile(const std::string& path);
+    ~MappedFile();
+
+    /// Opens the file at path, closing the one that was open before
+    void Open(const std::string& path);
+
+    /// Unmaps and closes the file, after which reads return no data
+    void Close();
+
+    /// Returns whether the file was opened, mapped or not
+    bool IsOpen() const;
+
+    /// Returns the size of the file at the time it was opened
+    u64 GetSize() const;
+
+    /// Returns the contents of the file, or nullptr if it could not be mapped
+    const u8* GetPointer() const;
+
+    /**
+     * Reads from the file, without affecting other readers.
+     * @returns The number of bytes read, short only at the end of the file or on error.
+     */
+    size_t ReadAt(u8* data, size_t length, u64 offset) const;
+
+private:
+#ifdef _WIN32
+    void* file_handle = nullptr;
+    void* mapping_handle = nullptr;
+#else
+    int fd = -1;
+#endif
+    const u8* view = nullptr;
+    u64 size = 0;
+};
+
+} // namespace FileUtil
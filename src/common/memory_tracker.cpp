@@ -0,0 +1,92 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <fmt/format.h>
+#include "common/logging/log.h"
+#include "common/memory_tracker.h"
+#include "common/microprofile.h"
+
+namespace Common {
+
+namespace {
+constexpr std::size_t NUM_TAGS = static_cast<std::size_t>(MemoryTag::Count);
+
+constexpr std::array<const char*, NUM_TAGS> TAG_NAMES{{
+    "Surface Buffers",
+    "Guest Memory",
+    "Shader Cache",
+    "VFS Files",
+    "Audio Buffers",
+    "Log Queues",
+}};
+
+std::array<std::atomic<s64>, NUM_TAGS> live_bytes{};
+
+// Graphs of the live bytes, the counters can't be read back so the values are kept above
+std::array<MicroProfileCounter, NUM_TAGS> counters{{
+    {"Memory", TAG_NAMES[0], MicroProfileCounter::Type::Level},
+    {"Memory", TAG_NAMES[1], MicroProfileCounter::Type::Level},
+    {"Memory", TAG_NAMES[2], MicroProfileCounter::Type::Level},
+    {"Memory", TAG_NAMES[3], MicroProfileCounter::Type::Level},
+    {"Memory", TAG_NAMES[4], MicroProfileCounter::Type::Level},
+    {"Memory", TAG_NAMES[5], MicroProfileCounter::Type::Level},
+}};
+
+std::mutex log_mutex;
+std::chrono::seconds log_interval{0};
+std::chrono::steady_clock::time_point last_log;
+} // Anonymous namespace
+
+const char* GetMemoryTagName(MemoryTag tag) {
+    return TAG_NAMES[static_cast<std::size_t>(tag)];
+}
+
+void AddTrackedMemory(MemoryTag tag, s64 bytes) {
+    const auto index = static_cast<std::size_t>(tag);
+    live_bytes[index].fetch_add(bytes, std::memory_order_relaxed);
+    counters[index].Add(bytes);
+}
+
+void SetTrackedMemory(MemoryTag tag, u64 bytes) {
+    const auto index = static_cast<std::size_t>(tag);
+    live_bytes[index].store(static_cast<s64>(bytes), std::memory_order_relaxed);
+    counters[index].Set(static_cast<s64>(bytes));
+}
+
+u64 GetTrackedMemory(MemoryTag tag) {
+    const s64 bytes = live_bytes[static_cast<std::size_t>(tag)].load(std::memory_order_relaxed);
+    return static_cast<u64>(std::max<s64>(bytes, 0));
+}
+
+void SetTrackedMemoryLogInterval(std::chrono::seconds interval) {
+    std::lock_guard<std::mutex> lock(log_mutex);
+    log_interval = interval;
+}
+
+void LogTrackedMemory() {
+    {
+        std::lock_guard<std::mutex> lock(log_mutex);
+        const auto now = std::chrono::steady_clock::now();
+        if (log_interval.count() == 0 || now - last_log < log_interval) {
+            return;
+        }
+        last_log = now;
+    }
+
+    std::string summary;
+    u64 total = 0;
+    for (std::size_t index = 0; index < NUM_TAGS; ++index) {
+        const u64 bytes = GetTrackedMemory(static_cast<MemoryTag>(index));
+        summary += fmt::format(", {}: {:.1f} MiB", TAG_NAMES[index], bytes / (1024.0 * 1024.0));
+        total += bytes;
+    }
+    LOG_INFO(Common_Memory, "Tracked memory: {:.1f} MiB{}", total / (1024.0 * 1024.0), summary);
+}
+
+} // namespace Common
@@ -0,0 +1,69 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include "common/common_types.h"
+
+namespace Common {
+
+/// Big consumers of the emulator's own memory, whose live bytes are tracked
+enum class MemoryTag : std::size_t {
+    SurfaceBuffers, ///< Host copies of the cached GPU surfaces
+    GuestMemory,    ///< Backing blocks of the memory mapped by the current process
+    ShaderCache,    ///< Stages read from the disk shader cache and not yet loaded
+    VfsFiles,       ///< Files held in memory and the indexes of the RomFS read
+    AudioBuffers,   ///< Samples of the buffers of the audio streams, pooled ones included
+    LogQueues,      ///< Messages waiting for the logging thread
+    Count,
+};
+
+/// Returns the name of a tag, as shown in the profiler and the log
+const char* GetMemoryTagName(MemoryTag tag);
+
+/// Adds to the live bytes of a tag, negative amounts free them. Thread-safe.
+void AddTrackedMemory(MemoryTag tag, s64 bytes);
+
+/// Replaces the live bytes of a tag, for the ones measured periodically. Thread-safe.
+void SetTrackedMemory(MemoryTag tag, u64 bytes);
+
+/// Returns the live bytes of a tag
+u64 GetTrackedMemory(MemoryTag tag);
+
+/// Sets how often LogTrackedMemory writes a summary of every tag, zero disables the summaries.
+void SetTrackedMemoryLogInterval(std::chrono::seconds interval);
+
+/// Writes a summary of every tag to the log if the interval has passed. Called once per frame.
+void LogTrackedMemory();
+
+/**
+ * Memory owned by an object, counted towards a tag for as long as the object lives. The owner
+ * calls Update with the new size whenever it changes the capacity of what it tracks.
+ */
+class TrackedMemory final {
+public:
+    explicit TrackedMemory(MemoryTag tag) : tag{tag} {}
+
+    ~TrackedMemory() {
+        Update(0);
+    }
+
+    TrackedMemory(const TrackedMemory&) = delete;
+    TrackedMemory& operator=(const TrackedMemory&) = delete;
+
+    void Update(std::size_t new_bytes) {
+        if (new_bytes != bytes) {
+            AddTrackedMemory(tag, static_cast<s64>(new_bytes) - static_cast<s64>(bytes));
+            bytes = new_bytes;
+        }
+    }
+
+private:
+    MemoryTag tag;
+    std::size_t bytes = 0;
+};
+
+} // namespace Common
@@ -5,3 +5,146 @@
 // Includes the MicroProfile implementation in this file for compilation
 #define MICROPROFILE_IMPL 1
 #include "common/microprofile.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <mutex>
+#include <tuple>
+
+namespace Common {
+
+static std::atomic<MicroProfileGpuTimer*> gpu_timer{nullptr};
+
+void SetMicroProfileGpuTimer(MicroProfileGpuTimer* timer) {
+    gpu_timer = timer;
+}
+
+const char* GetMicroProfileTimerName(MicroProfileToken token) {
+#if MICROPROFILE_ENABLED
+    return MicroProfileGet()->TimerInfo[MicroProfileGetTimerIndex(token)].pName;
+#else
+    return "";
+#endif
+}
+
+namespace {
+/// Every counter that currently exists. It's created by the first counter, and therefore outlives
+/// all of them.
+struct CounterRegistry {
+    std::mutex mutex;
+    std::vector<MicroProfileCounter*> counters;
+};
+
+CounterRegistry& GetCounterRegistry() {
+    static CounterRegistry registry;
+    return registry;
+}
+} // Anonymous namespace
+
+MicroProfileCounter::MicroProfileCounter(const char* group, const char* name, Type type)
+    : group(group), name(name), type(type) {
+    CounterRegistry& registry = GetCounterRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    registry.counters.push_back(this);
+}
+
+MicroProfileCounter::~MicroProfileCounter() {
+    CounterRegistry& registry = GetCounterRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    auto& counters = registry.counters;
+    counters.erase(std::remove(counters.begin(), counters.end(), this), counters.end());
+}
+
+void MicroProfileCounterFlip() {
+    CounterRegistry& registry = GetCounterRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    for (MicroProfileCounter* counter : registry.counters) {
+        const s64 value = counter->type == MicroProfileCounter::Type::PerFrame
+                              ? counter->value.exchange(0, std::memory_order_relaxed)
+                              : counter->value.load(std::memory_order_relaxed);
+        counter->history[counter->next_frame] = value;
+        counter->next_frame = (counter->next_frame + 1) % MICROPROFILE_COUNTER_HISTORY;
+    }
+}
+
+std::vector<MicroProfileCounterHistory> GetMicroProfileCounterHistories() {
+    std::vector<MicroProfileCounterHistory> histories;
+    {
+        CounterRegistry& registry = GetCounterRegistry();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        histories.reserve(registry.counters.size());
+        for (const MicroProfileCounter* counter : registry.counters) {
+            MicroProfileCounterHistory& history =
+                histories.emplace_back(MicroProfileCounterHistory{counter->group, counter->name});
+            const auto next = counter->history.begin() + counter->next_frame;
+            std::rotate_copy(counter->history.begin(), next, counter->history.end(),
+                             history.values.begin());
+        }
+    }
+
+    // The order counters are registered in depends on static initialization, so sort them
+    std::sort(histories.begin(), histories.end(), [](const auto& a, const auto& b) {
+        const int group_order = std::strcmp(a.group, b.group);
+        return group_order != 0 ? group_order < 0 : std::strcmp(a.name, b.name) < 0;
+    });
+    return histories;
+}
+
+MicroProfileTimerTotals GetMicroProfileTimerTotals() {
+    MicroProfileTimerTotals totals{};
+#if MICROPROFILE_ENABLED
+    {
+        std::lock_guard<std::recursive_mutex> lock(MicroProfileGetMutex());
+        const MicroProfile& profile = *MicroProfileGet();
+        const double ticks_to_ms = 1000.0 / MicroProfileTicksPerSecondCpu();
+
+        // MicroProfile copies its running totals to Aggregate on every flip, and never clears them
+        // unless a number of frames to aggregate over was set
+        totals.frames = profile.nAggregateFrames;
+        for (u32 i = 0; i < profile.nTotalTimers; ++i) {
+            const MicroProfileGroupInfo& group = profile.GroupInfo[profile.TimerToGroup[i]];
+            const MicroProfileTimer& aggregate = profile.Aggregate[i];
+            if (group.Type != MicroProfileTokenTypeCpu || aggregate.nCount == 0) {
+                continue;
+            }
+            totals.timers.push_back({group.pName, profile.TimerInfo[i].pName, aggregate.nCount,
+                                     aggregate.nTicks * ticks_to_ms,
+                                     profile.AggregateMax[i] * ticks_to_ms});
+        }
+    }
+
+    std::sort(totals.timers.begin(), totals.timers.end(), [](const auto& a, const auto& b) {
+        const int group_order = std::strcmp(a.group, b.group);
+        return group_order != 0 ? group_order < 0 : std::strcmp(a.name, b.name) < 0;
+    });
+#endif
+    return totals;
+}
+
+} // namespace Common
+
+#if MICROPROFILE_ENABLED
+
+// GPU timestamp hooks MicroProfile expects to be provided when MICROPROFILE_GPU_TIMERS is set
+
+uint32_t MicroProfileGpuInsertTimeStamp() {
+    Common::MicroProfileGpuTimer* const timer = Common::gpu_timer;
+    return timer != nullptr ? timer->InsertTimestamp() : 0;
+}
+
+uint64_t MicroProfileGpuGetTimeStamp(uint32_t key) {
+    Common::MicroProfileGpuTimer* const timer = Common::gpu_timer;
+    return timer != nullptr ? timer->GetTimestamp(key) : 0;
+}
+
+uint64_t MicroProfileTicksPerSecondGpu() {
+    return 1000000000;
+}
+
+int MicroProfileGetGpuTickReference(int64_t* out_cpu, int64_t* out_gpu) {
+    // Only used to line up the GPU lane in HTML dumps, the lane works without it
+    return 0;
+}
+
+#endif
@@ -11,7 +11,7 @@
 // Customized Citra settings.
 // This file wraps the MicroProfile header so that these are consistent everywhere.
 #define MICROPROFILE_WEBSERVER 0
-#define MICROPROFILE_GPU_TIMERS 0 // TODO: Implement timer queries when we upgrade to OpenGL 3.3
+#define MICROPROFILE_GPU_TIMERS 1 // Backed by the renderer, see Common::MicroProfileGpuTimer
 #define MICROPROFILE_CONTEXT_SWITCH_TRACE 0
 #define MICROPROFILE_PER_THREAD_BUFFER_SIZE (2048 << 13) // 16 MB
 
@@ -20,10 +20,142 @@
 typedef void* HANDLE;
 #endif
 
+#include <array>
+#include <atomic>
+#include <vector>
 #include <microprofile.h>
+#include "common/common_types.h"
+#include "common/trace.h"
 
 #define MP_RGB(r, g, b) ((r) << 16 | (g) << 8 | (b) << 0)
 
+namespace Common {
+
+/**
+ * Source of the timestamps recorded by MicroProfile's GPU scopes (MICROPROFILE_SCOPEGPU), which
+ * make up the "GPU" lane of the profiler. It's implemented by the renderer, as only it can issue
+ * queries to the host GPU. Timestamps are only inserted from the thread that renders.
+ */
+class MicroProfileGpuTimer {
+public:
+    virtual ~MicroProfileGpuTimer() = default;
+
+    /// Queues a timestamp query after the commands submitted so far, returns its key
+    virtual u32 InsertTimestamp() = 0;
+
+    /// Returns the GPU time of a timestamp query in nanoseconds
+    virtual u64 GetTimestamp(u32 key) = 0;
+};
+
+/// Sets the source of GPU timestamps, nullptr removes it. GPU scopes record nothing without one.
+void SetMicroProfileGpuTimer(MicroProfileGpuTimer* timer);
+
+/// Returns the name of a MicroProfile timer, which stays valid for the lifetime of the program
+const char* GetMicroProfileTimerName(MicroProfileToken token);
+
+struct MicroProfileCounterHistory;
+
+/// Number of frames of history kept for every counter
+constexpr size_t MICROPROFILE_COUNTER_HISTORY = 256;
+
+/**
+ * Value graphed over time in the profiler, such as the bytes uploaded or the number of surfaces
+ * cached. MicroProfile itself only has timers, so counters are kept here and sampled once every
+ * frame by MicroProfileCounterFlip. Counters are meant to be defined statically through
+ * MICROPROFILE_COUNTER_DEFINE, and can be updated from any thread.
+ */
+class MicroProfileCounter final {
+public:
+    enum class Type {
+        PerFrame, ///< Amount over the last frame, such as bytes uploaded, reset every frame
+        Level,    ///< Current amount, such as surfaces cached, kept across frames
+    };
+
+    MicroProfileCounter(const char* group, const char* name, Type type);
+    ~MicroProfileCounter();
+
+    MicroProfileCounter(const MicroProfileCounter&) = delete;
+    MicroProfileCounter& operator=(const MicroProfileCounter&) = delete;
+
+    void Add(s64 amount) {
+        value.fetch_add(amount, std::memory_order_relaxed);
+    }
+
+    void Set(s64 amount) {
+        value.store(amount, std::memory_order_relaxed);
+    }
+
+private:
+    friend void MicroProfileCounterFlip();
+    friend std::vector<MicroProfileCounterHistory> GetMicroProfileCounterHistories();
+
+    const char* group;
+    const char* name;
+    Type type;
+    std::atomic<s64> value{0};
+
+    /// Values of the past frames, written by MicroProfileCounterFlip only
+    std::array<s64, MICROPROFILE_COUNTER_HISTORY> history{};
+    size_t next_frame = 0;
+};
+
+/// Copy of the values of one counter over the past frames
+struct MicroProfileCounterHistory {
+    const char* group;
+    const char* name;
+    /// Oldest frame first
+    std::array<s64, MICROPROFILE_COUNTER_HISTORY> values;
+};
+
+/// Records the values of every counter for the frame that just ended, call along MicroProfileFlip.
+void MicroProfileCounterFlip();
+
+/// Returns the history of every counter, sorted by group and name
+std::vector<MicroProfileCounterHistory> GetMicroProfileCounterHistories();
+
+/// Time spent in one CPU timer, summed over every frame since profiling started
+struct MicroProfileTimerTotal {
+    const char* group;
+    const char* name;
+    u64 calls;
+    double total_ms;
+    /// Most time spent in the timer within a single frame
+    double max_frame_ms;
+};
+
+struct MicroProfileTimerTotals {
+    /// Number of frames the totals cover
+    u32 frames;
+    /// Every CPU timer that ran, sorted by group and name
+    std::vector<MicroProfileTimerTotal> timers;
+};
+
+/// Returns the totals of the CPU timers, which only grow while their groups are enabled
+MicroProfileTimerTotals GetMicroProfileTimerTotals();
+
+} // namespace Common
+
+#if MICROPROFILE_ENABLED
+// CPU scopes also record a span in the trace, under the name of their timer, while one is recorded
+#undef MICROPROFILE_SCOPE
+#define MICROPROFILE_SCOPE(var)                                                                    \
+    MicroProfileScopeHandler MICROPROFILE_TOKEN_PASTE(foo, __LINE__)(g_mp_##var);                  \
+    Common::Trace::Scope MICROPROFILE_TOKEN_PASTE(trace, __LINE__)(                                \
+        Common::Trace::IsRecording() ? Common::GetMicroProfileTimerName(g_mp_##var) : nullptr)
+
+#define MICROPROFILE_COUNTER_DECLARE(var) extern Common::MicroProfileCounter g_mp_counter_##var
+#define MICROPROFILE_COUNTER_DEFINE(var, group, name, type)                                        \
+    Common::MicroProfileCounter g_mp_counter_##var(group, name,                                    \
+                                                   Common::MicroProfileCounter::Type::type)
+#define MICROPROFILE_COUNTER_ADD(var, amount) g_mp_counter_##var.Add(static_cast<s64>(amount))
+#define MICROPROFILE_COUNTER_SET(var, amount) g_mp_counter_##var.Set(static_cast<s64>(amount))
+#else
+#define MICROPROFILE_COUNTER_DECLARE(var)
+#define MICROPROFILE_COUNTER_DEFINE(var, group, name, type)
+#define MICROPROFILE_COUNTER_ADD(var, amount) do {} while (0)
+#define MICROPROFILE_COUNTER_SET(var, amount) do {} while (0)
+#endif
+
 // On OS X, some Mach header included by MicroProfile defines these as macros, conflicting with
 // identifiers we use.
 #ifdef PAGE_SIZE
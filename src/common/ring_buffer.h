@@ -0,0 +1,106 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstring>
+#include <type_traits>
+#include "common/common_types.h"
+
+namespace Common {
+
+/**
+ * Fixed-capacity ring buffer for a single producer and a single consumer, neither of which ever
+ * blocks or allocates. This makes it suitable for handing data to real-time threads, e.g. audio
+ * callbacks. The producer only writes write_index and the consumer only writes read_index, so no
+ * locks are needed. Both indices increase monotonically and wrap with the capacity, which has to
+ * be a power of two.
+ * @tparam T Element type, copied with memcpy
+ * @tparam capacity Number of slots
+ * @tparam granularity Number of elements in a slot, e.g. the channels of an audio frame. Pushes
+ *                     and pops always move whole slots.
+ */
+template <typename T, std::size_t capacity, std::size_t granularity = 1>
+class RingBuffer {
+    static_assert(capacity != 0 && (capacity & (capacity - 1)) == 0,
+                  "capacity must be a power of two");
+    static_assert(granularity != 0, "granularity must be non-zero");
+    static_assert(std::is_trivially_copyable_v<T>, "T must be trivially copyable");
+
+    static constexpr std::size_t slot_size = granularity * sizeof(T);
+
+public:
+    /**
+     * Pushes slots into the ring buffer, as many as fit.
+     * @param new_slots Pointer to the slots to push
+     * @param slot_count Number of slots to push
+     * @returns Number of slots actually pushed
+     */
+    std::size_t Push(const void* new_slots, std::size_t slot_count) {
+        const std::size_t write = write_index.load(std::memory_order_relaxed);
+        const std::size_t slots_free =
+            capacity + read_index.load(std::memory_order_acquire) - write;
+        const std::size_t push_count = std::min(slot_count, slots_free);
+
+        const std::size_t pos = write % capacity;
+        const std::size_t first_copy = std::min(capacity - pos, push_count);
+        const std::size_t second_copy = push_count - first_copy;
+
+        const char* in = static_cast<const char*>(new_slots);
+        std::memcpy(data.data() + pos * granularity, in, first_copy * slot_size);
+        in += first_copy * slot_size;
+        std::memcpy(data.data(), in, second_copy * slot_size);
+
+        write_index.store(write + push_count, std::memory_order_release);
+        return push_count;
+    }
+
+    /**
+     * Pops slots from the ring buffer, as many as are available.
+     * @param output Where to copy the slots to
+     * @param max_slots Maximum number of slots to pop
+     * @returns Number of slots actually popped
+     */
+    std::size_t Pop(void* output, std::size_t max_slots) {
+        const std::size_t read = read_index.load(std::memory_order_relaxed);
+        const std::size_t slots_filled = write_index.load(std::memory_order_acquire) - read;
+        const std::size_t pop_count = std::min(slots_filled, max_slots);
+
+        const std::size_t pos = read % capacity;
+        const std::size_t first_copy = std::min(capacity - pos, pop_count);
+        const std::size_t second_copy = pop_count - first_copy;
+
+        char* out = static_cast<char*>(output);
+        std::memcpy(out, data.data() + pos * granularity, first_copy * slot_size);
+        out += first_copy * slot_size;
+        std::memcpy(out, data.data(), second_copy * slot_size);
+
+        read_index.store(read + pop_count, std::memory_order_release);
+        return pop_count;
+    }
+
+    /// Number of slots filled. Exact when called by either side, a snapshot for anyone else.
+    std::size_t Size() const {
+        return write_index.load(std::memory_order_acquire) -
+               read_index.load(std::memory_order_acquire);
+    }
+
+    /// Number of slots the ring buffer can hold
+    constexpr std::size_t Capacity() const {
+        return capacity;
+    }
+
+private:
+    // The indices are written by different threads, keep them on separate cache lines
+    alignas(128) std::atomic<std::size_t> read_index{0};
+    alignas(128) std::atomic<std::size_t> write_index{0};
+
+    std::array<T, granularity * capacity> data;
+};
+
+} // namespace Common
@@ -19,13 +19,12 @@
 
 #if defined(_MSC_VER)
 #include <cstdlib>
-#elif defined(__linux__)
-#include <byteswap.h>
 #elif defined(__Bitrig__) || defined(__DragonFly__) || defined(__FreeBSD__) ||                     \
     defined(__NetBSD__) || defined(__OpenBSD__)
 #include <sys/endian.h>
 #endif
 #include <cstring>
+#include "common/common_funcs.h"
 #include "common/common_types.h"
 
 // GCC 4.6+
@@ -69,62 +68,23 @@ inline u32 swap32(u32 _data) {
 inline u64 swap64(u64 _data) {
     return _byteswap_uint64(_data);
 }
-#elif defined(ARCHITECTURE_ARM) && (__ARM_ARCH >= 6)
-inline u16 swap16(u16 _data) {
-    u32 data = _data;
-    __asm__("rev16 %0, %1\n" : "=l"(data) : "l"(data));
-    return (u16)data;
-}
-inline u32 swap32(u32 _data) {
-    __asm__("rev %0, %1\n" : "=l"(_data) : "l"(_data));
-    return _data;
-}
-inline u64 swap64(u64 _data) {
-    return ((u64)swap32(_data) << 32) | swap32(_data >> 32);
-}
-#elif __linux__
-inline u16 swap16(u16 _data) {
-    return bswap_16(_data);
-}
-inline u32 swap32(u32 _data) {
-    return bswap_32(_data);
-}
-inline u64 swap64(u64 _data) {
-    return bswap_64(_data);
-}
-#elif __APPLE__
-inline __attribute__((always_inline)) u16 swap16(u16 _data) {
-    return (_data >> 8) | (_data << 8);
-}
-inline __attribute__((always_inline)) u32 swap32(u32 _data) {
-    return __builtin_bswap32(_data);
-}
-inline __attribute__((always_inline)) u64 swap64(u64 _data) {
-    return __builtin_bswap64(_data);
-}
-#elif defined(__Bitrig__) || defined(__OpenBSD__)
-// redefine swap16, swap32, swap64 as inline functions
+#elif defined(__GNUC__) || defined(__clang__)
+#if defined(__Bitrig__) || defined(__OpenBSD__)
+// sys/endian.h defines swap16, swap32 and swap64 as macros
 #undef swap16
 #undef swap32
 #undef swap64
-inline u16 swap16(u16 _data) {
-    return __swap16(_data);
-}
-inline u32 swap32(u32 _data) {
-    return __swap32(_data);
-}
-inline u64 swap64(u64 _data) {
-    return __swap64(_data);
-}
-#elif defined(__DragonFly__) || defined(__FreeBSD__) || defined(__NetBSD__)
-inline u16 swap16(u16 _data) {
-    return bswap16(_data);
+#endif
+// The builtins compile to a single instruction on every host and, unlike inline assembly or the
+// libc macros, can be constant folded, such as when comparing against a swapped literal.
+constexpr FORCE_INLINE u16 swap16(u16 _data) {
+    return __builtin_bswap16(_data);
 }
-inline u32 swap32(u32 _data) {
-    return bswap32(_data);
+constexpr FORCE_INLINE u32 swap32(u32 _data) {
+    return __builtin_bswap32(_data);
 }
-inline u64 swap64(u64 _data) {
-    return bswap64(_data);
+constexpr FORCE_INLINE u64 swap64(u64 _data) {
+    return __builtin_bswap64(_data);
 }
 #else
 // Slow generic implementation.
@@ -4,6 +4,8 @@
 
 #include <algorithm>
 #include <cstring>
+#include <mutex>
+#include <unordered_map>
 #include "common/assert.h"
 #include "common/scm_rev.h"
 #include "common/telemetry.h"
@@ -14,14 +16,37 @@
 
 namespace Telemetry {
 
+const std::string& InternFieldName(std::string_view name) {
+    // The keys view the strings they map to, which never move
+    static std::mutex mutex;
+    static std::unordered_map<std::string_view, std::unique_ptr<std::string>> names;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    auto iter = names.find(name);
+    if (iter == names.end()) {
+        auto interned = std::make_unique<std::string>(name);
+        const std::string_view key = *interned;
+        iter = names.emplace(key, std::move(interned)).first;
+    }
+    return *iter->second;
+}
+
 void FieldCollection::Accept(VisitorInterface& visitor) const {
     for (const auto& field : fields) {
-        field.second->Accept(visitor);
+        field->Accept(visitor);
     }
 }
 
 void FieldCollection::AddField(std::unique_ptr<FieldInterface> field) {
-    fields[field->GetName()] = std::move(field);
+    const std::string* const name = &field->GetName();
+    const auto iter = std::find_if(fields.begin(), fields.end(), [name](const auto& existing) {
+        return &existing->GetName() == name;
+    });
+    if (iter != fields.end()) {
+        *iter = std::move(field);
+    } else {
+        fields.push_back(std::move(field));
+    }
 }
 
 template <class T>
@@ -5,9 +5,10 @@
 #pragma once
 
 #include <chrono>
-#include <map>
 #include <memory>
 #include <string>
+#include <string_view>
+#include <vector>
 #include "common/common_types.h"
 
 namespace Telemetry {
@@ -25,6 +26,13 @@ enum class FieldType : u8 {
 
 struct VisitorInterface;
 
+/**
+ * Returns the one copy of the given field name shared by every field of that name. Fields only
+ * point to it, so adding a field allocates nothing for its name, and names can be told apart by
+ * their address alone.
+ */
+const std::string& InternFieldName(std::string_view name);
+
 /**
  * Interface class for telemetry data fields.
  */
@@ -52,8 +60,8 @@ public:
 template <typename T>
 class Field : public FieldInterface {
 public:
-    Field(FieldType type, std::string name, T value)
-        : name(std::move(name)), type(type), value(std::move(value)) {}
+    Field(FieldType type, std::string_view name, T value)
+        : name(&InternFieldName(name)), type(type), value(std::move(value)) {}
 
     Field(const Field&) = default;
     Field& operator=(const Field&) = default;
@@ -64,7 +72,7 @@ public:
     void Accept(VisitorInterface& visitor) const override;
 
     const std::string& GetName() const override {
-        return name;
+        return *name;
     }
 
     /**
@@ -90,9 +98,9 @@ public:
     }
 
 private:
-    std::string name; ///< Field name, must be unique
-    FieldType type{}; ///< Field type, used for grouping fields together
-    T value;          ///< Field value
+    const std::string* name; ///< Interned field name, must be unique
+    FieldType type{};        ///< Field type, used for grouping fields together
+    T value;                 ///< Field value
 };
 
 /**
@@ -103,7 +111,8 @@ public:
     FieldCollection() = default;
 
     /**
-     * Accept method for the visitor pattern, visits each field in the collection.
+     * Accept method for the visitor pattern, visits each field in the collection, in the order
+     * they were first added.
      * @param visitor Reference to the visitor that will visit each field.
      */
     void Accept(VisitorInterface& visitor) const;
@@ -120,13 +129,15 @@ public:
     }
 
     /**
-     * Adds a new field to the field collection.
+     * Adds a new field to the field collection, replacing any field of the same name.
      * @param field Field to add to the field collection.
      */
     void AddField(std::unique_ptr<FieldInterface> field);
 
 private:
-    std::map<std::string, std::unique_ptr<FieldInterface>> fields;
+    /// A session only has a few dozen fields, which a linear search over the interned names
+    /// finds faster than a tree keyed by strings
+    std::vector<std::unique_ptr<FieldInterface>> fields;
 };
 
 /**
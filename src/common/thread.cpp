@@ -3,6 +3,7 @@
 // Refer to the license.txt file included.
 
 #include "common/thread.h"
+#include "common/trace.h"
 #ifdef __APPLE__
 #include <mach/mach.h>
 #elif defined(_WIN32)
@@ -15,6 +16,10 @@
 #endif
 #include <sched.h>
 #endif
+#ifdef __linux__
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#endif
 #ifndef _WIN32
 #include <unistd.h>
 #endif
@@ -56,6 +61,26 @@ void SwitchCurrentThread() {
     SwitchToThread();
 }
 
+void SetCurrentThreadPriority(ThreadPriority priority) {
+    int windows_priority = THREAD_PRIORITY_NORMAL;
+    switch (priority) {
+    case ThreadPriority::Low:
+        windows_priority = THREAD_PRIORITY_BELOW_NORMAL;
+        break;
+    case ThreadPriority::Normal:
+        windows_priority = THREAD_PRIORITY_NORMAL;
+        break;
+    case ThreadPriority::High:
+        windows_priority = THREAD_PRIORITY_ABOVE_NORMAL;
+        break;
+    case ThreadPriority::VeryHigh:
+        windows_priority = THREAD_PRIORITY_HIGHEST;
+        break;
+    }
+
+    SetThreadPriority(GetCurrentThread(), windows_priority);
+}
+
 // Sets the debugger-visible name of the current thread.
 // Uses undocumented (actually, it is now documented) trick.
 // http://msdn.microsoft.com/library/default.asp?url=/library/en-us/vsdebug/html/vxtsksettingthreadname.asp
@@ -63,6 +88,8 @@ void SwitchCurrentThread() {
 // This is implemented much nicer in upcoming msvc++, see:
 // http://msdn.microsoft.com/en-us/library/xcb2z8hs(VS.100).aspx
 void SetCurrentThreadName(const char* szThreadName) {
+    Trace::SetCurrentThreadName(szThreadName);
+
     static const DWORD MS_VC_EXCEPTION = 0x406D1388;
 
 #pragma pack(push, 8)
@@ -106,6 +133,44 @@ void SetCurrentThreadAffinity(u32 mask) {
     SetThreadAffinity(pthread_self(), mask);
 }
 
+void SetCurrentThreadPriority(ThreadPriority priority) {
+#ifdef __linux__
+    // Threads under the default SCHED_OTHER policy all share the same static priority on Linux,
+    // but each thread has its own nice value.
+    int nice_value = 0;
+    switch (priority) {
+    case ThreadPriority::Low:
+        nice_value = 5;
+        break;
+    case ThreadPriority::Normal:
+        nice_value = 0;
+        break;
+    case ThreadPriority::High:
+        nice_value = -5;
+        break;
+    case ThreadPriority::VeryHigh:
+        nice_value = -10;
+        break;
+    }
+
+    setpriority(PRIO_PROCESS, static_cast<id_t>(syscall(SYS_gettid)), nice_value);
+#else
+    int policy;
+    sched_param param{};
+    if (pthread_getschedparam(pthread_self(), &policy, &param) != 0)
+        return;
+
+    // Spread the priority classes evenly over the range the current policy allows
+    const int min_priority = sched_get_priority_min(policy);
+    const int max_priority = sched_get_priority_max(policy);
+    const int level = static_cast<int>(priority);
+    const int num_levels = static_cast<int>(ThreadPriority::VeryHigh);
+    param.sched_priority = min_priority + (max_priority - min_priority) * level / num_levels;
+
+    pthread_setschedparam(pthread_self(), policy, &param);
+#endif
+}
+
 #ifndef _WIN32
 void SleepCurrentThread(int ms) {
     usleep(1000 * ms);
@@ -119,6 +184,8 @@ void SwitchCurrentThread() {
 // MinGW with the POSIX threading model does not support pthread_setname_np
 #if !defined(_WIN32) || defined(_MSC_VER)
 void SetCurrentThreadName(const char* szThreadName) {
+    Trace::SetCurrentThreadName(szThreadName);
+
 #ifdef __APPLE__
     pthread_setname_np(szThreadName);
 #elif defined(__Bitrig__) || defined(__DragonFly__) || defined(__FreeBSD__) || defined(__OpenBSD__)
@@ -18,6 +18,17 @@ int CurrentThreadId();
 void SetThreadAffinity(std::thread::native_handle_type thread, u32 mask);
 void SetCurrentThreadAffinity(u32 mask);
 
+enum class ThreadPriority : u32 {
+    Low,
+    Normal,
+    High,
+    VeryHigh,
+};
+
+/// Sets the host scheduling priority of the calling thread. Raising the priority above Normal may
+/// require elevated privileges on some hosts, in which case the request is silently ignored.
+void SetCurrentThreadPriority(ThreadPriority priority);
+
 class Event {
 public:
     Event() : is_set(false) {}
@@ -0,0 +1,203 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include "common/thread.h"
+#include "common/thread_pool.h"
+
+namespace Common {
+
+/// Set while the current thread runs pieces of a job, whichever pool it belongs to
+static thread_local bool running_job = false;
+
+/// Pool the current thread is a worker of, and its index in it
+static thread_local ThreadPool* current_pool = nullptr;
+static thread_local size_t current_worker = 0;
+
+ThreadPool::ThreadPool(size_t num_workers, u32 affinity_mask) {
+    queues.reserve(num_workers);
+    for (size_t i = 0; i < num_workers; ++i) {
+        queues.push_back(std::make_unique<TaskQueues>());
+    }
+
+    workers.reserve(num_workers);
+    for (size_t i = 0; i < num_workers; ++i) {
+        workers.emplace_back([this, i, affinity_mask] { WorkerLoop(i, affinity_mask); });
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        shutting_down = true;
+    }
+    job_cv.notify_all();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+}
+
+void ThreadPool::ParallelFor(size_t count, const std::function<void(size_t)>& func) {
+    // A job started from within a piece of another one could never be picked up by the workers
+    // busy with the outer job, so it runs on the calling thread alone.
+    if (workers.empty() || count < 2 || running_job) {
+        for (size_t i = 0; i < count; ++i) {
+            func(i);
+        }
+        return;
+    }
+
+    std::lock_guard<std::mutex> submit_lock(submit_mutex);
+    Job job{func, count};
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        current_job = &job;
+        ++job_generation;
+    }
+    job_cv.notify_all();
+
+    RunJob(job);
+
+    // Workers that picked up the job may still be running its last pieces. Workers that have not
+    // woken up yet will find no job anymore, so the job can be destroyed once the busy ones return.
+    std::unique_lock<std::mutex> lock(mutex);
+    current_job = nullptr;
+    done_cv.wait(lock, [this] { return busy_workers == 0; });
+}
+
+bool ThreadPool::RunPendingTask() {
+    Task task;
+    if (!PopTask(task)) {
+        return false;
+    }
+    task();
+    return true;
+}
+
+void ThreadPool::WorkerLoop(size_t worker_index, u32 affinity_mask) {
+    SetCurrentThreadName("ThreadPoolWorker");
+    if (affinity_mask != 0) {
+        SetCurrentThreadAffinity(affinity_mask);
+    }
+    current_pool = this;
+    current_worker = worker_index;
+
+    u64 seen_generation = 0;
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        job_cv.wait(lock, [&] {
+            return shutting_down || job_generation != seen_generation || pending_tasks != 0;
+        });
+
+        if (job_generation != seen_generation) {
+            // Jobs come first, their submitter is blocked until they complete
+            seen_generation = job_generation;
+
+            Job* const job = current_job;
+            if (job == nullptr) {
+                continue;
+            }
+
+            ++busy_workers;
+            lock.unlock();
+            RunJob(*job);
+            lock.lock();
+            if (--busy_workers == 0) {
+                done_cv.notify_all();
+            }
+            continue;
+        }
+
+        if (pending_tasks != 0) {
+            lock.unlock();
+            RunPendingTask();
+            lock.lock();
+            continue;
+        }
+
+        // Only exit once every queued task has run, as something may still wait on them
+        if (shutting_down) {
+            return;
+        }
+    }
+}
+
+void ThreadPool::RunJob(Job& job) {
+    running_job = true;
+    size_t index;
+    while ((index = job.next_index.fetch_add(1, std::memory_order_relaxed)) < job.count) {
+        job.func(index);
+    }
+    running_job = false;
+}
+
+void ThreadPool::Enqueue(Task task, TaskPriority priority) {
+    // Workers queue the tasks they spawn themselves, keeping related work on the same thread
+    const size_t queue_index = current_pool == this
+                                   ? current_worker
+                                   : next_queue.fetch_add(1, std::memory_order_relaxed) %
+                                         queues.size();
+    {
+        TaskQueues& queue = *queues[queue_index];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.tasks[static_cast<size_t>(priority)].push_back(std::move(task));
+        pending_tasks.fetch_add(1, std::memory_order_release);
+    }
+
+    // Taking the lock ensures the worker either sees the task or is already waiting
+    { std::lock_guard<std::mutex> lock(mutex); }
+    job_cv.notify_one();
+}
+
+bool ThreadPool::PopTask(Task& task) {
+    if (pending_tasks.load(std::memory_order_acquire) == 0) {
+        return false;
+    }
+
+    const bool is_worker = current_pool == this;
+    const size_t first_queue = is_worker ? current_worker : 0;
+    for (size_t priority = 0; priority < NUM_TASK_PRIORITIES; ++priority) {
+        for (size_t i = 0; i < queues.size(); ++i) {
+            const size_t queue_index = (first_queue + i) % queues.size();
+            TaskQueues& queue = *queues[queue_index];
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            auto& tasks = queue.tasks[priority];
+            if (tasks.empty()) {
+                continue;
+            }
+
+            if (is_worker && queue_index == current_worker) {
+                task = std::move(tasks.back());
+                tasks.pop_back();
+            } else {
+                task = std::move(tasks.front());
+                tasks.pop_front();
+            }
+            pending_tasks.fetch_sub(1, std::memory_order_relaxed);
+            return true;
+        }
+    }
+    return false;
+}
+
+static size_t configured_num_threads = 0;
+static u32 configured_affinity_mask = 0;
+
+void ConfigureSharedThreadPool(size_t num_threads, u32 affinity_mask) {
+    configured_num_threads = num_threads;
+    configured_affinity_mask = affinity_mask;
+}
+
+ThreadPool& GetSharedThreadPool() {
+    // The submitting thread takes part in every job, so it is not counted as a worker.
+    static ThreadPool pool(
+        (configured_num_threads != 0
+             ? configured_num_threads
+             : std::max<size_t>(std::thread::hardware_concurrency(), 2)) -
+            1,
+        configured_affinity_mask);
+    return pool;
+}
+
+} // namespace Common
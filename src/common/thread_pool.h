@@ -0,0 +1,222 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include <boost/optional.hpp>
+#include "common/common_types.h"
+#include "common/thread.h"
+
+namespace Common {
+
+class ThreadPool;
+
+/// Order in which the workers pick up submitted tasks
+enum class TaskPriority : u8 {
+    High = 0,
+    Normal = 1,
+    Low = 2,
+};
+
+constexpr size_t NUM_TASK_PRIORITIES = 3;
+
+namespace Detail {
+
+/// Completion state of a task, shared between the task and its future
+struct TaskStateBase {
+    std::atomic_bool done{false};
+    Event event;
+
+    void MarkDone() {
+        done.store(true, std::memory_order_release);
+        event.Set();
+    }
+};
+
+template <typename T>
+struct TaskState : TaskStateBase {
+    boost::optional<T> result;
+};
+
+template <>
+struct TaskState<void> : TaskStateBase {};
+
+} // namespace Detail
+
+/**
+ * Result of a task submitted to a ThreadPool. Only one thread may wait on it, as with
+ * std::future.
+ */
+template <typename T>
+class Future {
+public:
+    Future() = default;
+
+    bool IsValid() const {
+        return state != nullptr;
+    }
+
+    /// Returns whether the task has completed, without blocking.
+    bool IsReady() const {
+        return state->done.load(std::memory_order_acquire);
+    }
+
+    /// Blocks until the task has completed. The waiting thread runs other pending tasks of the
+    /// pool in the meantime, so tasks may wait on each other without starving the pool.
+    void Wait() const;
+
+    /// Waits for the task and returns its result, which can only be retrieved once.
+    T Get() {
+        Wait();
+        if constexpr (!std::is_void_v<T>) {
+            return std::move(*state->result);
+        }
+    }
+
+private:
+    friend class ThreadPool;
+
+    Future(ThreadPool* pool, std::shared_ptr<Detail::TaskState<T>> state)
+        : pool(pool), state(std::move(state)) {}
+
+    ThreadPool* pool = nullptr;
+    std::shared_ptr<Detail::TaskState<T>> state;
+};
+
+/**
+ * Fixed set of host worker threads shared by every subsystem, so that CPU heavy work never uses
+ * more host cores than configured.
+ *
+ * ParallelFor splits a job, such as texture swizzling, into independent pieces that run on all
+ * workers; only one such job runs at a time and the submitting thread works on it as well.
+ * Submit queues independent tasks, each worker keeping its own queue per priority. A worker that
+ * runs out of tasks steals the oldest ones of the other workers.
+ */
+class ThreadPool final {
+public:
+    /**
+     * @param num_workers Number of worker threads, not counting the threads submitting work.
+     * @param affinity_mask Host cores the workers may run on, 0 to leave it to the host.
+     */
+    explicit ThreadPool(size_t num_workers, u32 affinity_mask = 0);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    /// Calls func(i) once for every i in [0, count), spread across the pool. When called from
+    /// within func of another job, runs every call on the calling thread instead.
+    void ParallelFor(size_t count, const std::function<void(size_t)>& func);
+
+    /**
+     * Queues func to run on one of the workers, or runs it right away if the pool has none.
+     * @param func Copyable callable taking no arguments.
+     * @returns A future for the value func returns.
+     */
+    template <typename F>
+    auto Submit(F&& func, TaskPriority priority = TaskPriority::Normal)
+        -> Future<std::invoke_result_t<std::decay_t<F>&>> {
+        using Result = std::invoke_result_t<std::decay_t<F>&>;
+        auto state = std::make_shared<Detail::TaskState<Result>>();
+        Task task = [state, func = std::forward<F>(func)]() mutable {
+            if constexpr (std::is_void_v<Result>) {
+                func();
+            } else {
+                state->result = func();
+            }
+            state->MarkDone();
+        };
+
+        if (workers.empty()) {
+            task();
+        } else {
+            Enqueue(std::move(task), priority);
+        }
+        return Future<Result>(this, std::move(state));
+    }
+
+    /// Runs one pending task on the calling thread, if there is any. Returns whether it did.
+    bool RunPendingTask();
+
+    /// Returns the number of threads that work on a job, including the submitting thread.
+    size_t GetNumThreads() const {
+        return workers.size() + 1;
+    }
+
+private:
+    using Task = std::function<void()>;
+
+    struct Job {
+        const std::function<void(size_t)>& func;
+        const size_t count;
+        std::atomic<size_t> next_index{0};
+    };
+
+    /// Tasks queued on one worker, the worker itself takes the newest and thieves the oldest
+    struct TaskQueues {
+        std::mutex mutex;
+        std::array<std::deque<Task>, NUM_TASK_PRIORITIES> tasks;
+    };
+
+    void WorkerLoop(size_t worker_index, u32 affinity_mask);
+
+    /// Runs pieces of the job until none are left.
+    static void RunJob(Job& job);
+
+    void Enqueue(Task task, TaskPriority priority);
+
+    /// Takes the pending task of highest priority, preferring the calling worker's own queues.
+    bool PopTask(Task& task);
+
+    std::vector<std::thread> workers;
+    std::vector<std::unique_ptr<TaskQueues>> queues;
+    std::atomic<size_t> pending_tasks{0};
+    std::atomic<size_t> next_queue{0};
+
+    /// Serializes jobs submitted from different threads.
+    std::mutex submit_mutex;
+
+    std::mutex mutex;
+    std::condition_variable job_cv;
+    std::condition_variable done_cv;
+    Job* current_job = nullptr;
+    u64 job_generation = 0;
+    size_t busy_workers = 0;
+    bool shutting_down = false;
+};
+
+template <typename T>
+void Future<T>::Wait() const {
+    while (!IsReady()) {
+        if (!pool->RunPendingTask()) {
+            state->event.Wait();
+        }
+    }
+}
+
+/**
+ * Sets the size and host cores of the shared thread pool. Only has an effect when called before
+ * the pool is first used.
+ * @param num_threads Number of threads working on a job, including the submitting thread. 0 uses
+ * one per host core.
+ * @param affinity_mask Host cores the workers may run on, 0 to leave it to the host.
+ */
+void ConfigureSharedThreadPool(size_t num_threads, u32 affinity_mask);
+
+/// Returns the thread pool shared by the whole emulator, sized to the number of host cores.
+ThreadPool& GetSharedThreadPool();
+
+} // namespace Common
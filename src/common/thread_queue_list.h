@@ -7,6 +7,8 @@
 #include <array>
 #include <deque>
 #include <boost/range/algorithm_ext/erase.hpp>
+#include "common/bit_set.h"
+#include "common/common_types.h"
 
 namespace Common {
 
@@ -21,9 +23,7 @@ struct ThreadQueueList {
     // Number of priority levels. (Valid levels are [0..NUM_QUEUES).)
     static const Priority NUM_QUEUES = N;
 
-    ThreadQueueList() {
-        first = nullptr;
-    }
+    static_assert(NUM_QUEUES <= 64, "The bitmap of non-empty priority levels only has 64 bits");
 
     // Only for debugging, returns priority level.
     Priority contains(const T& uid) const {
@@ -38,65 +38,52 @@ struct ThreadQueueList {
     }
 
     T get_first() const {
-        const Queue* cur = first;
-        while (cur != nullptr) {
-            if (!cur->data.empty()) {
-                return cur->data.front();
-            }
-            cur = cur->next_nonempty;
+        if (nonempty_queues == 0) {
+            return T();
         }
 
-        return T();
+        return queues[LeastSignificantSetBit(nonempty_queues)].data.front();
     }
 
     T pop_first() {
-        Queue* cur = first;
-        while (cur != nullptr) {
-            if (!cur->data.empty()) {
-                auto tmp = std::move(cur->data.front());
-                cur->data.pop_front();
-                return tmp;
-            }
-            cur = cur->next_nonempty;
+        if (nonempty_queues == 0) {
+            return T();
         }
 
-        return T();
+        return pop_front(static_cast<Priority>(LeastSignificantSetBit(nonempty_queues)));
     }
 
     T pop_first_better(Priority priority) {
-        Queue* cur = first;
-        Queue* stop = &queues[priority];
-        while (cur < stop) {
-            if (!cur->data.empty()) {
-                auto tmp = std::move(cur->data.front());
-                cur->data.pop_front();
-                return tmp;
-            }
-            cur = cur->next_nonempty;
+        // Only consider the levels that are strictly better (lower) than the given priority
+        const u64 better_queues = nonempty_queues & ((u64{1} << priority) - 1);
+        if (better_queues == 0) {
+            return T();
         }
 
-        return T();
+        return pop_front(static_cast<Priority>(LeastSignificantSetBit(better_queues)));
     }
 
     void push_front(Priority priority, const T& thread_id) {
         Queue* cur = &queues[priority];
         cur->data.push_front(thread_id);
+        nonempty_queues |= u64{1} << priority;
     }
 
     void push_back(Priority priority, const T& thread_id) {
         Queue* cur = &queues[priority];
         cur->data.push_back(thread_id);
+        nonempty_queues |= u64{1} << priority;
     }
 
     void move(const T& thread_id, Priority old_priority, Priority new_priority) {
         remove(old_priority, thread_id);
-        prepare(new_priority);
         push_back(new_priority, thread_id);
     }
 
     void remove(Priority priority, const T& thread_id) {
         Queue* cur = &queues[priority];
         boost::remove_erase(cur->data, thread_id);
+        update_nonempty(priority);
     }
 
     void rotate(Priority priority) {
@@ -110,50 +97,36 @@ struct ThreadQueueList {
 
     void clear() {
         queues.fill(Queue());
-        first = nullptr;
+        nonempty_queues = 0;
     }
 
     bool empty(Priority priority) const {
-        const Queue* cur = &queues[priority];
-        return cur->data.empty();
-    }
-
-    void prepare(Priority priority) {
-        Queue* cur = &queues[priority];
-        if (cur->next_nonempty == UnlinkedTag())
-            link(priority);
+        return (nonempty_queues & (u64{1} << priority)) == 0;
     }
 
 private:
     struct Queue {
-        // Points to the next active priority, skipping over ones that have never been used.
-        Queue* next_nonempty = UnlinkedTag();
         // Double-ended queue of threads in this priority level
         std::deque<T> data;
     };
 
-    /// Special tag used to mark priority levels that have never been used.
-    static Queue* UnlinkedTag() {
-        return reinterpret_cast<Queue*>(1);
-    }
-
-    void link(Priority priority) {
+    T pop_front(Priority priority) {
         Queue* cur = &queues[priority];
+        auto tmp = std::move(cur->data.front());
+        cur->data.pop_front();
+        update_nonempty(priority);
+        return tmp;
+    }
 
-        for (int i = priority - 1; i >= 0; --i) {
-            if (queues[i].next_nonempty != UnlinkedTag()) {
-                cur->next_nonempty = queues[i].next_nonempty;
-                queues[i].next_nonempty = cur;
-                return;
-            }
+    void update_nonempty(Priority priority) {
+        if (queues[priority].data.empty()) {
+            nonempty_queues &= ~(u64{1} << priority);
         }
-
-        cur->next_nonempty = first;
-        first = cur;
     }
 
-    // The first queue that's ever been used.
-    Queue* first;
+    // Bit N is set when the priority level N has at least one thread queued, so the best
+    // non-empty level can be found with a single bit scan.
+    u64 nonempty_queues = 0;
     // The priority level queues of thread ids.
     std::array<Queue, NUM_QUEUES> queues;
 };
@@ -8,9 +8,11 @@
 // single reader, single writer queue
 
 #include <algorithm>
+#include <array>
 #include <atomic>
 #include <cstddef>
 #include <mutex>
+#include <utility>
 #include "common/common_types.h"
 
 namespace Common {
@@ -106,45 +108,240 @@ private:
     std::atomic<u32> size;
 };
 
-// a simple thread-safe,
+// a lockless thread-safe,
 // single reader, multiple writer queue
 
 template <typename T, bool NeedSize = true>
 class MPSCQueue {
 public:
+    MPSCQueue() : size(0) {
+        read_ptr = new ElementPtr();
+        write_ptr.store(read_ptr);
+    }
+    ~MPSCQueue() {
+        // this will empty out the whole queue
+        delete read_ptr;
+    }
+
     u32 Size() const {
-        return spsc_queue.Size();
+        static_assert(NeedSize, "using Size() on FifoQueue without NeedSize");
+        return size.load();
     }
 
     bool Empty() const {
-        return spsc_queue.Empty();
+        return !read_ptr->next.load(std::memory_order_acquire);
     }
 
     T& Front() const {
-        return spsc_queue.Front();
+        return read_ptr->next.load(std::memory_order_acquire)->current;
     }
 
     template <typename Arg>
     void Push(Arg&& t) {
-        std::lock_guard<std::mutex> lock(write_lock);
-        spsc_queue.Push(t);
+        // The element is fully constructed before it is published. Producers only contend on the
+        // exchange of the write pointer, so no lock is needed between them. The reader can only
+        // observe the element once the previous tail has been linked to it.
+        ElementPtr* new_ptr = new ElementPtr();
+        new_ptr->current = std::forward<Arg>(t);
+        ElementPtr* prev_ptr = write_ptr.exchange(new_ptr, std::memory_order_acq_rel);
+        prev_ptr->next.store(new_ptr, std::memory_order_release);
+        if (NeedSize)
+            size++;
     }
 
     void Pop() {
-        return spsc_queue.Pop();
+        T discarded;
+        Pop(discarded);
     }
 
     bool Pop(T& t) {
-        return spsc_queue.Pop(t);
+        // read_ptr is always a consumed placeholder, the first live element is the one after it
+        ElementPtr* next_ptr = read_ptr->next.load(std::memory_order_acquire);
+        if (!next_ptr)
+            return false;
+
+        if (NeedSize)
+            size--;
+
+        t = std::move(next_ptr->current);
+        // set the next element to nullptr to stop the recursive deletion
+        read_ptr->next.store(nullptr);
+        delete read_ptr;
+        read_ptr = next_ptr;
+        return true;
     }
 
     // not thread-safe
     void Clear() {
-        spsc_queue.Clear();
+        size.store(0);
+        delete read_ptr;
+        read_ptr = new ElementPtr();
+        write_ptr.store(read_ptr);
+    }
+
+private:
+    // stores a pointer to element
+    // and a pointer to the next ElementPtr
+    class ElementPtr {
+    public:
+        ElementPtr() : next(nullptr) {}
+        ~ElementPtr() {
+            ElementPtr* next_ptr = next.load();
+
+            if (next_ptr)
+                delete next_ptr;
+        }
+
+        T current;
+        std::atomic<ElementPtr*> next;
+    };
+
+    std::atomic<ElementPtr*> write_ptr;
+    ElementPtr* read_ptr;
+    std::atomic<u32> size;
+};
+
+/// Size of a host cache line, the read and write sides of the rings are kept this far apart so
+/// that the producers and the consumers don't invalidate each other's cache lines.
+constexpr std::size_t CACHE_LINE_SIZE = 64;
+
+/**
+ * Bounded single reader, single writer queue. Unlike SPSCQueue it never allocates: elements are
+ * moved in and out of a fixed array, and pushing to a full ring fails instead.
+ * @tparam Capacity Number of elements the ring holds, a power of two.
+ */
+template <typename T, std::size_t Capacity>
+class SPSCRing {
+    static_assert(Capacity != 0 && (Capacity & (Capacity - 1)) == 0,
+                  "Capacity must be a power of two");
+
+public:
+    std::size_t Size() const {
+        return write_index.load(std::memory_order_acquire) -
+               read_index.load(std::memory_order_acquire);
+    }
+
+    bool Empty() const {
+        return Size() == 0;
+    }
+
+    /// Adds an element, returns false if the ring is full. Writer only.
+    template <typename Arg>
+    bool TryPush(Arg&& t) {
+        const std::size_t write = write_index.load(std::memory_order_relaxed);
+        if (write - read_index.load(std::memory_order_acquire) == Capacity)
+            return false;
+        slots[write & (Capacity - 1)] = std::forward<Arg>(t);
+        write_index.store(write + 1, std::memory_order_release);
+        return true;
+    }
+
+    /// Takes the oldest element, returns false if the ring is empty. Reader only.
+    bool Pop(T& t) {
+        const std::size_t read = read_index.load(std::memory_order_relaxed);
+        if (read == write_index.load(std::memory_order_acquire))
+            return false;
+        t = std::move(slots[read & (Capacity - 1)]);
+        read_index.store(read + 1, std::memory_order_release);
+        return true;
+    }
+
+private:
+    alignas(CACHE_LINE_SIZE) std::atomic<std::size_t> read_index{0};
+    alignas(CACHE_LINE_SIZE) std::atomic<std::size_t> write_index{0};
+    alignas(CACHE_LINE_SIZE) std::array<T, Capacity> slots{};
+};
+
+/**
+ * Bounded multiple reader, multiple writer queue that never allocates or locks. Each slot carries
+ * a sequence number telling which lap of the ring it is ready for, so producers and consumers only
+ * contend on claiming an index and never wait on each other unless the ring is full or empty.
+ * @tparam Capacity Number of elements the ring holds, a power of two.
+ */
+template <typename T, std::size_t Capacity>
+class MPMCRing {
+    static_assert(Capacity != 0 && (Capacity & (Capacity - 1)) == 0,
+                  "Capacity must be a power of two");
+
+public:
+    MPMCRing() {
+        for (std::size_t i = 0; i < Capacity; ++i) {
+            slots[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    /// Approximate number of elements, as other threads may push and pop at the same time
+    std::size_t Size() const {
+        const std::size_t write = write_index.load(std::memory_order_relaxed);
+        const std::size_t read = read_index.load(std::memory_order_relaxed);
+        return write >= read ? write - read : 0;
+    }
+
+    bool Empty() const {
+        return Size() == 0;
+    }
+
+    /// Adds an element, returns false if the ring is full.
+    template <typename Arg>
+    bool TryPush(Arg&& t) {
+        std::size_t write = write_index.load(std::memory_order_relaxed);
+        while (true) {
+            Slot& slot = slots[write & (Capacity - 1)];
+            const std::size_t sequence = slot.sequence.load(std::memory_order_acquire);
+            const auto lap = static_cast<std::ptrdiff_t>(sequence - write);
+            if (lap == 0) {
+                // The slot is free, claim its index before writing to it
+                if (write_index.compare_exchange_weak(write, write + 1,
+                                                      std::memory_order_relaxed)) {
+                    slot.value = std::forward<Arg>(t);
+                    slot.sequence.store(write + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (lap < 0) {
+                // The slot still holds the element from the previous lap
+                return false;
+            } else {
+                write = write_index.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    /// Takes the oldest element, returns false if the ring is empty.
+    bool Pop(T& t) {
+        std::size_t read = read_index.load(std::memory_order_relaxed);
+        while (true) {
+            Slot& slot = slots[read & (Capacity - 1)];
+            const std::size_t sequence = slot.sequence.load(std::memory_order_acquire);
+            const auto lap = static_cast<std::ptrdiff_t>(sequence - (read + 1));
+            if (lap == 0) {
+                if (read_index.compare_exchange_weak(read, read + 1, std::memory_order_relaxed)) {
+                    t = std::move(slot.value);
+                    // Free the slot for the writer of the next lap
+                    slot.sequence.store(read + Capacity, std::memory_order_release);
+                    return true;
+                }
+            } else if (lap < 0) {
+                return false;
+            } else {
+                read = read_index.load(std::memory_order_relaxed);
+            }
+        }
     }
 
 private:
-    SPSCQueue<T, NeedSize> spsc_queue;
-    std::mutex write_lock;
+    struct Slot {
+        std::atomic<std::size_t> sequence;
+        T value{};
+    };
+
+    alignas(CACHE_LINE_SIZE) std::atomic<std::size_t> read_index{0};
+    alignas(CACHE_LINE_SIZE) std::atomic<std::size_t> write_index{0};
+    alignas(CACHE_LINE_SIZE) std::array<Slot, Capacity> slots;
 };
+
+/// Bounded single reader, multiple writer queue. A dedicated single reader variant would only save
+/// the reader's compare-exchange, which never fails without a second reader, so this is MPMCRing.
+template <typename T, std::size_t Capacity>
+using MPSCRing = MPMCRing<T, Capacity>;
+
 } // namespace Common
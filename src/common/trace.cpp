@@ -0,0 +1,201 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <fmt/format.h>
+#include "common/common_types.h"
+#include "common/file_util.h"
+#include "common/trace.h"
+
+namespace Common::Trace {
+
+namespace Detail {
+std::atomic_bool recording{false};
+} // namespace Detail
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct Event {
+    /// Nanoseconds since recording started
+    s64 timestamp;
+    /// Name of the span, nullptr for the end of one
+    const char* name;
+};
+
+/// Most recent events of one thread. The lock is only ever contended while the trace is written.
+struct ThreadEvents {
+    static constexpr size_t CAPACITY = 1 << 16;
+
+    std::mutex mutex;
+    std::string name;
+    u32 id;
+    std::array<Event, CAPACITY> events;
+    size_t num_written = 0;
+};
+
+struct Recorder {
+    std::mutex mutex;
+    std::vector<std::shared_ptr<ThreadEvents>> threads;
+    Clock::time_point start_time;
+    u32 next_thread_id = 1;
+};
+
+Recorder& GetRecorder() {
+    static Recorder recorder;
+    return recorder;
+}
+
+/// Keeps a thread registered with the recorder for as long as the thread runs
+class ThreadRegistration final {
+public:
+    ThreadRegistration() : events(std::make_shared<ThreadEvents>()) {
+        Recorder& recorder = GetRecorder();
+        std::lock_guard<std::mutex> lock(recorder.mutex);
+        events->id = recorder.next_thread_id++;
+        events->name = fmt::format("Thread {}", events->id);
+        recorder.threads.push_back(events);
+    }
+
+    ~ThreadRegistration() {
+        // Threads come and go with every game, the rings of exited ones are not kept around
+        Recorder& recorder = GetRecorder();
+        std::lock_guard<std::mutex> lock(recorder.mutex);
+        recorder.threads.erase(
+            std::remove(recorder.threads.begin(), recorder.threads.end(), events),
+            recorder.threads.end());
+    }
+
+    ThreadRegistration(const ThreadRegistration&) = delete;
+    ThreadRegistration& operator=(const ThreadRegistration&) = delete;
+
+    ThreadEvents& GetEvents() const {
+        return *events;
+    }
+
+private:
+    std::shared_ptr<ThreadEvents> events;
+};
+
+/// Returns the events of the calling thread, registering the thread the first time
+ThreadEvents& GetThreadEvents() {
+    thread_local const ThreadRegistration registration;
+    return registration.GetEvents();
+}
+
+/// Name the calling thread gave itself, kept until it records its next event
+thread_local std::string pending_thread_name;
+
+s64 GetTimestamp() {
+    const auto elapsed = Clock::now() - GetRecorder().start_time;
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
+}
+
+void Record(const char* name) {
+    const s64 timestamp = GetTimestamp();
+    ThreadEvents& thread = GetThreadEvents();
+    std::lock_guard<std::mutex> lock(thread.mutex);
+    if (!pending_thread_name.empty()) {
+        thread.name = std::move(pending_thread_name);
+        pending_thread_name.clear();
+    }
+    thread.events[thread.num_written % ThreadEvents::CAPACITY] = {timestamp, name};
+    ++thread.num_written;
+}
+
+std::string EscapeJson(const char* text) {
+    std::string escaped;
+    for (; *text != '\0'; ++text) {
+        if (*text == '"' || *text == '\\') {
+            escaped += '\\';
+        }
+        escaped += *text;
+    }
+    return escaped;
+}
+
+} // Anonymous namespace
+
+void Start() {
+    Recorder& recorder = GetRecorder();
+    {
+        std::lock_guard<std::mutex> lock(recorder.mutex);
+        for (const auto& thread : recorder.threads) {
+            std::lock_guard<std::mutex> thread_lock(thread->mutex);
+            thread->num_written = 0;
+        }
+        recorder.start_time = Clock::now();
+    }
+    Detail::recording = true;
+}
+
+void Stop() {
+    Detail::recording = false;
+}
+
+void Begin(const char* name) {
+    Record(name);
+}
+
+void End() {
+    Record(nullptr);
+}
+
+void SetCurrentThreadName(const char* name) {
+    pending_thread_name = name;
+}
+
+bool WriteChromeTrace(const std::string& path) {
+    FileUtil::IOFile file(path, "w");
+    if (!file.IsOpen()) {
+        return false;
+    }
+
+    std::string out = "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n";
+    const char* separator = "";
+    const auto append = [&](const std::string& event) {
+        out += separator;
+        out += event;
+        separator = ",\n";
+    };
+
+    Recorder& recorder = GetRecorder();
+    std::lock_guard<std::mutex> lock(recorder.mutex);
+    for (const auto& thread : recorder.threads) {
+        std::lock_guard<std::mutex> thread_lock(thread->mutex);
+        append(fmt::format("{{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,\"tid\":{},"
+                           "\"args\":{{\"name\":\"{}\"}}}}",
+                           thread->id, EscapeJson(thread->name.c_str())));
+
+        const size_t num_events = std::min(thread->num_written, ThreadEvents::CAPACITY);
+        const size_t first = thread->num_written - num_events;
+        size_t depth = 0;
+        for (size_t i = first; i < thread->num_written; ++i) {
+            const Event& event = thread->events[i % ThreadEvents::CAPACITY];
+            const double timestamp_us = event.timestamp / 1000.0;
+            if (event.name != nullptr) {
+                ++depth;
+                append(fmt::format(
+                    "{{\"ph\":\"B\",\"name\":\"{}\",\"pid\":1,\"tid\":{},\"ts\":{:.3f}}}",
+                    EscapeJson(event.name), thread->id, timestamp_us));
+            } else if (depth > 0) {
+                // Ends of spans that began before the oldest kept event are dropped
+                --depth;
+                append(fmt::format("{{\"ph\":\"E\",\"pid\":1,\"tid\":{},\"ts\":{:.3f}}}",
+                                   thread->id, timestamp_us));
+            }
+        }
+    }
+    out += "\n]}\n";
+
+    return file.WriteBytes(out.data(), out.size()) == out.size();
+}
+
+} // namespace Common::Trace
@@ -0,0 +1,71 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <atomic>
+#include <string>
+
+namespace Common::Trace {
+
+namespace Detail {
+extern std::atomic_bool recording;
+} // namespace Detail
+
+/**
+ * Starts recording begin and end events. Every thread keeps its most recent events in a ring of
+ * its own, so recording can be left on for a whole session and dumped once something went wrong.
+ */
+void Start();
+
+/// Stops recording, the events recorded so far are kept until the next Start
+void Stop();
+
+inline bool IsRecording() {
+    return Detail::recording.load(std::memory_order_relaxed);
+}
+
+/// Records the start of a named span on the calling thread. name must outlive the recording.
+void Begin(const char* name);
+
+/// Records the end of the innermost span the calling thread began
+void End();
+
+/// Names the calling thread in the trace, called by Common::SetCurrentThreadName
+void SetCurrentThreadName(const char* name);
+
+/**
+ * Writes every recorded event in the Chrome trace event format, which chrome://tracing and the
+ * Perfetto UI open
+ * @returns Whether the file could be written
+ */
+bool WriteChromeTrace(const std::string& path);
+
+/// Records a span lasting until the end of the enclosing scope, nothing if name is nullptr
+class Scope final {
+public:
+    explicit Scope(const char* name) : active(name != nullptr && IsRecording()) {
+        if (active) {
+            Begin(name);
+        }
+    }
+
+    ~Scope() {
+        if (active) {
+            End();
+        }
+    }
+
+    Scope(const Scope&) = delete;
+    Scope& operator=(const Scope&) = delete;
+
+private:
+    bool active;
+};
+
+} // namespace Common::Trace
+
+#define TRACE_PASTE0(a, b) a##b
+#define TRACE_PASTE(a, b) TRACE_PASTE0(a, b)
+#define TRACE_SCOPE(name) Common::Trace::Scope TRACE_PASTE(trace_scope_, __LINE__)(name)
@@ -38,6 +38,9 @@ public:
     /// Clear all instruction cache
     virtual void ClearInstructionCache() = 0;
 
+    /// Clears the instruction cache for the code in the given range of memory
+    virtual void InvalidateCacheRange(VAddr addr, std::size_t size) = 0;
+
     /// Notify CPU emulation that page tables have changed
     virtual void PageTableChanged() = 0;
 
@@ -121,4 +124,23 @@ public:
 
     /// Prepare core for thread reschedule (if needed to correctly handle state)
     virtual void PrepareReschedule() = 0;
+
+    /// Counts of the work the CPU did outside of its fast paths, to spot titles that stress them
+    struct Stats {
+        /// Instructions the recompiler couldn't handle, which were interpreted instead
+        u64 interpreted_instructions;
+        /// Memory accesses that went through the slow path, indexed by the Memory::PageType of
+        /// the accessed page
+        std::array<u64, 4> slow_reads;
+        std::array<u64, 4> slow_writes;
+        u64 svc_calls;
+        /// Instructions read by the recompiler to translate them
+        u64 translated_instructions;
+    };
+
+    /// Returns the stats gathered since the last call and resets them, can be called from any
+    /// thread. Backends that don't gather stats return all zeroes.
+    virtual Stats GetAndResetStats() {
+        return {};
+    }
 };
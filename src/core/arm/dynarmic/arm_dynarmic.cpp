@@ -2,61 +2,103 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <array>
+#include <atomic>
 #include <cinttypes>
 #include <memory>
 #include <dynarmic/A64/a64.h>
 #include <dynarmic/A64/config.h>
 #include "common/logging/log.h"
+#include "common/microprofile.h"
 #include "core/arm/dynarmic/arm_dynarmic.h"
 #include "core/core.h"
 #include "core/core_timing.h"
+#include "core/gdbstub/gdbstub.h"
 #include "core/hle/kernel/process.h"
 #include "core/hle/kernel/svc.h"
+#include "core/hle/kernel/thread.h"
 #include "core/memory.h"
 
 using Vector = Dynarmic::A64::Vector;
 
+MICROPROFILE_COUNTER_DEFINE(ARM_Jit_Interpreted, "ARM JIT", "Interpreted Instructions", PerFrame);
+MICROPROFILE_COUNTER_DEFINE(ARM_Jit_Translated, "ARM JIT", "Translated Instructions", PerFrame);
+MICROPROFILE_COUNTER_DEFINE(ARM_Jit_SlowReads, "ARM JIT", "Slow Memory Reads", PerFrame);
+MICROPROFILE_COUNTER_DEFINE(ARM_Jit_SlowWrites, "ARM JIT", "Slow Memory Writes", PerFrame);
+MICROPROFILE_COUNTER_DEFINE(ARM_Jit_CachedAccesses, "ARM JIT", "Rasterizer Cached Accesses",
+                            PerFrame);
+MICROPROFILE_COUNTER_DEFINE(ARM_Jit_SVCs, "ARM JIT", "SVC Calls", PerFrame);
+
+static_assert(static_cast<size_t>(Memory::PageType::Special) + 1 ==
+                  std::tuple_size<decltype(ARM_Interface::Stats::slow_reads)>::value,
+              "Slow access stats must have one entry per page type");
+
 class ARM_Dynarmic_Callbacks : public Dynarmic::A64::UserCallbacks {
 public:
     explicit ARM_Dynarmic_Callbacks(ARM_Dynarmic& parent) : parent(parent) {}
     ~ARM_Dynarmic_Callbacks() = default;
 
     u8 MemoryRead8(u64 vaddr) override {
+        CountSlowRead(vaddr);
         return Memory::Read8(vaddr);
     }
     u16 MemoryRead16(u64 vaddr) override {
+        CountSlowRead(vaddr);
         return Memory::Read16(vaddr);
     }
     u32 MemoryRead32(u64 vaddr) override {
+        CountSlowRead(vaddr);
         return Memory::Read32(vaddr);
     }
     u64 MemoryRead64(u64 vaddr) override {
+        CountSlowRead(vaddr);
         return Memory::Read64(vaddr);
     }
     Vector MemoryRead128(u64 vaddr) override {
-        return {Memory::Read64(vaddr), Memory::Read64(vaddr + 8)};
+        CountSlowRead(vaddr);
+        return Memory::Read128(vaddr);
     }
 
     void MemoryWrite8(u64 vaddr, u8 value) override {
+        CountSlowWrite(vaddr);
         Memory::Write8(vaddr, value);
     }
     void MemoryWrite16(u64 vaddr, u16 value) override {
+        CountSlowWrite(vaddr);
         Memory::Write16(vaddr, value);
     }
     void MemoryWrite32(u64 vaddr, u32 value) override {
+        CountSlowWrite(vaddr);
         Memory::Write32(vaddr, value);
     }
     void MemoryWrite64(u64 vaddr, u64 value) override {
+        CountSlowWrite(vaddr);
         Memory::Write64(vaddr, value);
     }
     void MemoryWrite128(u64 vaddr, Vector value) override {
-        Memory::Write64(vaddr, value[0]);
-        Memory::Write64(vaddr + 8, value[1]);
+        CountSlowWrite(vaddr);
+        Memory::Write128(vaddr, value);
+    }
+
+    u32 MemoryReadCode(u64 vaddr) override {
+        // The recompiler reads the code of every instruction it translates, once
+        translated_instructions.fetch_add(1, std::memory_order_relaxed);
+        MICROPROFILE_COUNTER_ADD(ARM_Jit_Translated, 1);
+
+        // Breakpoints are translated into a BRK, so they cost nothing until they are reached.
+        // Setting or removing one invalidates the code translated from its address.
+        if (GDBStub::CheckBreakpoint(vaddr, GDBStub::BreakpointType::Execute)) {
+            constexpr u32 BRK_INSTRUCTION = 0xD4200000;
+            return BRK_INSTRUCTION;
+        }
+        return Memory::Read32(vaddr);
     }
 
     void InterpreterFallback(u64 pc, size_t num_instructions) override {
         LOG_INFO(Core_ARM, "Unicorn fallback @ 0x{:X} for {} instructions (instr = {:08X})", pc,
-                 num_instructions, MemoryReadCode(pc));
+                 num_instructions, Memory::Read32(pc));
+        interpreted_instructions.fetch_add(num_instructions, std::memory_order_relaxed);
+        MICROPROFILE_COUNTER_ADD(ARM_Jit_Interpreted, num_instructions);
 
         ARM_Interface::ThreadContext ctx;
         parent.SaveContext(ctx);
@@ -75,6 +117,14 @@ public:
         case Dynarmic::A64::Exception::SendEventLocal:
         case Dynarmic::A64::Exception::Yield:
             return;
+        case Dynarmic::A64::Exception::Breakpoint:
+            if (GDBStub::IsServerEnabled()) {
+                breakpoint_hit = true;
+                breakpoint_pc = pc;
+                parent.jit->HaltExecution();
+                return;
+            }
+            [[fallthrough]];
         default:
             ASSERT_MSG(false, "ExceptionRaised(exception = {}, pc = {:X})",
                        static_cast<size_t>(exception), pc);
@@ -82,31 +132,70 @@ public:
     }
 
     void CallSVC(u32 swi) override {
+        svc_calls.fetch_add(1, std::memory_order_relaxed);
+        MICROPROFILE_COUNTER_ADD(ARM_Jit_SVCs, 1);
         Kernel::CallSVC(swi);
     }
 
     void AddTicks(u64 ticks) override {
-        // Divide the number of ticks by the amount of CPU cores. TODO(Subv): This yields only a
-        // rough approximation of the amount of executed ticks in the system, it may be thrown off
-        // if not all cores are doing a similar amount of work. Instead of doing this, we should
-        // device a way so that timing is consistent across all cores without increasing the ticks 4
-        // times.
-        u64 amortized_ticks = (ticks - num_interpreted_instructions) / Core::NUM_CPU_CORES;
+        // Each core keeps its own timing context, so the executed ticks are accounted in full
+        // rather than being averaged across all cores.
+        u64 executed_ticks = ticks - num_interpreted_instructions;
         // Always execute at least one tick.
-        amortized_ticks = std::max<u64>(amortized_ticks, 1);
+        executed_ticks = std::max<u64>(executed_ticks, 1);
 
-        CoreTiming::AddTicks(amortized_ticks);
+        CoreTiming::AddTicks(parent.core_index, executed_ticks);
         num_interpreted_instructions = 0;
     }
     u64 GetTicksRemaining() override {
-        return std::max(CoreTiming::GetDowncount(), 0);
+        return std::max(CoreTiming::GetDowncount(parent.core_index), 0);
     }
     u64 GetCNTPCT() override {
-        return CoreTiming::GetTicks();
+        return CoreTiming::GetTicks(parent.core_index);
+    }
+
+    using AccessCounters = std::array<std::atomic<u64>, 4>;
+
+    /// Counts a memory read the recompiled code couldn't do through the page table
+    void CountSlowRead(u64 vaddr) {
+        const Memory::PageType type = GetPageType(vaddr);
+        slow_reads[static_cast<size_t>(type)].fetch_add(1, std::memory_order_relaxed);
+        MICROPROFILE_COUNTER_ADD(ARM_Jit_SlowReads, 1);
+        if (type == Memory::PageType::RasterizerCachedMemory) {
+            MICROPROFILE_COUNTER_ADD(ARM_Jit_CachedAccesses, 1);
+        }
+    }
+
+    /// Counts a memory write the recompiled code couldn't do through the page table
+    void CountSlowWrite(u64 vaddr) {
+        const Memory::PageType type = GetPageType(vaddr);
+        slow_writes[static_cast<size_t>(type)].fetch_add(1, std::memory_order_relaxed);
+        MICROPROFILE_COUNTER_ADD(ARM_Jit_SlowWrites, 1);
+        if (type == Memory::PageType::RasterizerCachedMemory) {
+            MICROPROFILE_COUNTER_ADD(ARM_Jit_CachedAccesses, 1);
+        }
+    }
+
+    static Memory::PageType GetPageType(u64 vaddr) {
+        const Memory::PageTable& page_table = *Memory::GetCurrentPageTable();
+        const u64 page = vaddr >> Memory::PAGE_BITS;
+        return page < page_table.attributes.size() ? page_table.attributes[page]
+                                                   : Memory::PageType::Unmapped;
     }
 
     ARM_Dynarmic& parent;
     size_t num_interpreted_instructions = 0;
+
+    /// Set when the code ran into a gdb breakpoint, and the address of that breakpoint
+    bool breakpoint_hit = false;
+    u64 breakpoint_pc = 0;
+
+    // Stats, incremented by the thread running the core and reset from any thread
+    std::atomic<u64> interpreted_instructions{0};
+    AccessCounters slow_reads{};
+    AccessCounters slow_writes{};
+    std::atomic<u64> svc_calls{0};
+    std::atomic<u64> translated_instructions{0};
     u64 tpidrro_el0 = 0;
     u64 tpidr_el0 = 0;
 };
@@ -144,6 +233,26 @@ void ARM_Dynarmic::Run() {
     ASSERT(Memory::GetCurrentPageTable() == current_page_table);
 
     jit->Run();
+
+    if (GDBStub::IsServerEnabled()) {
+        // gdb reads the registers of the threads from their saved context
+        Kernel::Thread* const thread = Kernel::GetCurrentThread();
+        if (cb->breakpoint_hit) {
+            // Stop on the breakpoint rather than after it, gdb removes it to step over it
+            cb->breakpoint_hit = false;
+            jit->SetPC(cb->breakpoint_pc);
+            if (!GDBStub::CheckBreakpoint(cb->breakpoint_pc, GDBStub::BreakpointType::Execute)) {
+                // Translated before gdb disconnected, the next slice runs the real instruction
+                jit->InvalidateCacheRange(cb->breakpoint_pc, 4);
+                return;
+            }
+            SaveContext(thread->context);
+            GDBStub::Break();
+            GDBStub::SendTrap(thread, 5);
+            return;
+        }
+        SaveContext(thread->context);
+    }
 }
 
 void ARM_Dynarmic::Step() {
@@ -161,6 +270,18 @@ ARM_Dynarmic::ARM_Dynarmic(std::shared_ptr<ExclusiveMonitor> exclusive_monitor,
 
 ARM_Dynarmic::~ARM_Dynarmic() = default;
 
+ARM_Interface::Stats ARM_Dynarmic::GetAndResetStats() {
+    Stats stats{};
+    stats.interpreted_instructions = cb->interpreted_instructions.exchange(0);
+    for (size_t type = 0; type < stats.slow_reads.size(); ++type) {
+        stats.slow_reads[type] = cb->slow_reads[type].exchange(0);
+        stats.slow_writes[type] = cb->slow_writes[type].exchange(0);
+    }
+    stats.svc_calls = cb->svc_calls.exchange(0);
+    stats.translated_instructions = cb->translated_instructions.exchange(0);
+    return stats;
+}
+
 void ARM_Dynarmic::MapBackingMemory(u64 address, size_t size, u8* memory,
                                     Kernel::VMAPermission perms) {
     inner_unicorn.MapBackingMemory(address, size, memory, perms);
@@ -253,21 +374,30 @@ void ARM_Dynarmic::ClearInstructionCache() {
     jit->ClearCache();
 }
 
+void ARM_Dynarmic::InvalidateCacheRange(VAddr addr, std::size_t size) {
+    jit->InvalidateCacheRange(addr, size);
+}
+
 void ARM_Dynarmic::ClearExclusiveState() {
     jit->ClearExclusiveState();
 }
 
 void ARM_Dynarmic::PageTableChanged() {
+    Memory::PageTable* const new_page_table = Memory::GetCurrentPageTable();
+    if (jit != nullptr && new_page_table == current_page_table) {
+        // The JIT is already bound to this page table, so keep the code compiled so far
+        return;
+    }
+
     jit = MakeJit();
-    current_page_table = Memory::GetCurrentPageTable();
+    current_page_table = new_page_table;
 }
 
 DynarmicExclusiveMonitor::DynarmicExclusiveMonitor(size_t core_count) : monitor(core_count) {}
 DynarmicExclusiveMonitor::~DynarmicExclusiveMonitor() = default;
 
-void DynarmicExclusiveMonitor::SetExclusive(size_t core_index, VAddr addr) {
-    // Size doesn't actually matter.
-    monitor.Mark(core_index, addr, 16);
+void DynarmicExclusiveMonitor::SetExclusive(size_t core_index, VAddr addr, size_t size) {
+    monitor.Mark(core_index, addr, size);
 }
 
 void DynarmicExclusiveMonitor::ClearExclusive() {
@@ -295,8 +425,6 @@ bool DynarmicExclusiveMonitor::ExclusiveWrite64(size_t core_index, VAddr vaddr,
 }
 
 bool DynarmicExclusiveMonitor::ExclusiveWrite128(size_t core_index, VAddr vaddr, u128 value) {
-    return monitor.DoExclusiveOperation(core_index, vaddr, 16, [&] {
-        Memory::Write64(vaddr, value[0]);
-        Memory::Write64(vaddr, value[1]);
-    });
+    return monitor.DoExclusiveOperation(core_index, vaddr, 16,
+                                        [&] { Memory::Write128(vaddr, value); });
 }
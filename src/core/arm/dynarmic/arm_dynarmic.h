@@ -47,8 +47,11 @@ public:
     void ClearExclusiveState() override;
 
     void ClearInstructionCache() override;
+    void InvalidateCacheRange(VAddr addr, std::size_t size) override;
     void PageTableChanged() override;
 
+    Stats GetAndResetStats() override;
+
 private:
     std::unique_ptr<Dynarmic::A64::Jit> MakeJit() const;
 
@@ -68,7 +71,7 @@ public:
     explicit DynarmicExclusiveMonitor(size_t core_count);
     ~DynarmicExclusiveMonitor();
 
-    void SetExclusive(size_t core_index, VAddr addr) override;
+    void SetExclusive(size_t core_index, VAddr addr, size_t size) override;
     void ClearExclusive() override;
 
     bool ExclusiveWrite8(size_t core_index, VAddr vaddr, u8 value) override;
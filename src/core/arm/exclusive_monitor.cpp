@@ -2,6 +2,122 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <cstring>
+#include <type_traits>
+
+#include "common/assert.h"
+#include "common/atomic_ops.h"
 #include "core/arm/exclusive_monitor.h"
+#include "core/memory.h"
 
 ExclusiveMonitor::~ExclusiveMonitor() = default;
+
+HostExclusiveMonitor::HostExclusiveMonitor(size_t core_count) : reservations(core_count) {}
+HostExclusiveMonitor::~HostExclusiveMonitor() = default;
+
+u128 HostExclusiveMonitor::ReadValue(VAddr addr, size_t size) {
+    switch (size) {
+    case 1:
+        return {Memory::Read8(addr), 0};
+    case 2:
+        return {Memory::Read16(addr), 0};
+    case 4:
+        return {Memory::Read32(addr), 0};
+    case 8:
+        return {Memory::Read64(addr), 0};
+    case 16:
+        return Memory::Read128(addr);
+    default:
+        UNREACHABLE_MSG("Invalid exclusive access size {}", size);
+        return {};
+    }
+}
+
+void HostExclusiveMonitor::SetExclusive(size_t core_index, VAddr addr, size_t size) {
+    ASSERT(core_index < reservations.size());
+
+    Reservation& reservation = reservations[core_index];
+    reservation.value = ReadValue(addr, size);
+    reservation.address.store(addr, std::memory_order_release);
+}
+
+void HostExclusiveMonitor::ClearExclusive() {
+    for (auto& reservation : reservations) {
+        reservation.address.store(INVALID_ADDRESS, std::memory_order_release);
+    }
+}
+
+template <typename T>
+bool HostExclusiveMonitor::ExclusiveWrite(size_t core_index, VAddr vaddr, T value) {
+    ASSERT(core_index < reservations.size());
+
+    // A reservation can only be used once, whether the write succeeds or not
+    Reservation& reservation = reservations[core_index];
+    if (reservation.address.exchange(INVALID_ADDRESS, std::memory_order_acq_rel) != vaddr) {
+        return false;
+    }
+
+    T expected;
+    std::memcpy(&expected, reservation.value.data(), sizeof(T));
+
+    bool success;
+    u8* const pointer = Memory::GetContiguousPointer(vaddr, sizeof(T));
+    if (pointer != nullptr && (vaddr % sizeof(T)) == 0) {
+        if constexpr (std::is_same_v<T, u128>) {
+            success = Common::AtomicCompareAndSwap(reinterpret_cast<u64*>(pointer), value,
+                                                   expected);
+        } else {
+            success = Common::AtomicCompareAndSwap(reinterpret_cast<T*>(pointer), value, expected);
+        }
+    } else {
+        // Unaligned or non-plain memory (e.g. rasterizer cached pages) can't be accessed with a
+        // host atomic, so fall back to a regular compare and write through the memory subsystem.
+        u128 current = ReadValue(vaddr, sizeof(T));
+        success = std::memcmp(current.data(), &expected, sizeof(T)) == 0;
+        if (success) {
+            std::memcpy(current.data(), &value, sizeof(T));
+            if constexpr (std::is_same_v<T, u128>) {
+                Memory::Write128(vaddr, current);
+            } else if constexpr (sizeof(T) == 8) {
+                Memory::Write64(vaddr, current[0]);
+            } else if constexpr (sizeof(T) == 4) {
+                Memory::Write32(vaddr, static_cast<u32>(current[0]));
+            } else if constexpr (sizeof(T) == 2) {
+                Memory::Write16(vaddr, static_cast<u16>(current[0]));
+            } else {
+                Memory::Write8(vaddr, static_cast<u8>(current[0]));
+            }
+        }
+    }
+
+    if (success) {
+        // Any other core holding a reservation on this address has now lost it
+        for (auto& other : reservations) {
+            VAddr expected_address = vaddr;
+            other.address.compare_exchange_strong(expected_address, INVALID_ADDRESS,
+                                                  std::memory_order_acq_rel);
+        }
+    }
+
+    return success;
+}
+
+bool HostExclusiveMonitor::ExclusiveWrite8(size_t core_index, VAddr vaddr, u8 value) {
+    return ExclusiveWrite(core_index, vaddr, value);
+}
+
+bool HostExclusiveMonitor::ExclusiveWrite16(size_t core_index, VAddr vaddr, u16 value) {
+    return ExclusiveWrite(core_index, vaddr, value);
+}
+
+bool HostExclusiveMonitor::ExclusiveWrite32(size_t core_index, VAddr vaddr, u32 value) {
+    return ExclusiveWrite(core_index, vaddr, value);
+}
+
+bool HostExclusiveMonitor::ExclusiveWrite64(size_t core_index, VAddr vaddr, u64 value) {
+    return ExclusiveWrite(core_index, vaddr, value);
+}
+
+bool HostExclusiveMonitor::ExclusiveWrite128(size_t core_index, VAddr vaddr, u128 value) {
+    return ExclusiveWrite(core_index, vaddr, value);
+}
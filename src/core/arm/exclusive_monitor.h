@@ -4,13 +4,16 @@
 
 #pragma once
 
+#include <atomic>
+#include <vector>
 #include "common/common_types.h"
 
 class ExclusiveMonitor {
 public:
     virtual ~ExclusiveMonitor();
 
-    virtual void SetExclusive(size_t core_index, VAddr addr) = 0;
+    /// Reserves the size bytes at addr for an exclusive write by the given core
+    virtual void SetExclusive(size_t core_index, VAddr addr, size_t size) = 0;
     virtual void ClearExclusive() = 0;
 
     virtual bool ExclusiveWrite8(size_t core_index, VAddr vaddr, u8 value) = 0;
@@ -19,3 +22,43 @@ public:
     virtual bool ExclusiveWrite64(size_t core_index, VAddr vaddr, u64 value) = 0;
     virtual bool ExclusiveWrite128(size_t core_index, VAddr vaddr, u128 value) = 0;
 };
+
+/**
+ * Exclusive monitor implemented directly on top of host atomics, for CPU backends that don't
+ * provide a monitor of their own. Each core owns a reservation slot on its own cache line, and an
+ * exclusive write succeeds if the core still holds its reservation and the guest memory still
+ * contains the value observed when the reservation was made, which is checked with a host
+ * compare-and-swap.
+ */
+class HostExclusiveMonitor final : public ExclusiveMonitor {
+public:
+    explicit HostExclusiveMonitor(size_t core_count);
+    ~HostExclusiveMonitor() override;
+
+    void SetExclusive(size_t core_index, VAddr addr, size_t size) override;
+    void ClearExclusive() override;
+
+    bool ExclusiveWrite8(size_t core_index, VAddr vaddr, u8 value) override;
+    bool ExclusiveWrite16(size_t core_index, VAddr vaddr, u16 value) override;
+    bool ExclusiveWrite32(size_t core_index, VAddr vaddr, u32 value) override;
+    bool ExclusiveWrite64(size_t core_index, VAddr vaddr, u64 value) override;
+    bool ExclusiveWrite128(size_t core_index, VAddr vaddr, u128 value) override;
+
+private:
+    static constexpr VAddr INVALID_ADDRESS = ~VAddr{0};
+
+    /// Per-core reservation, padded so that cores never share a cache line.
+    struct alignas(64) Reservation {
+        std::atomic<VAddr> address{INVALID_ADDRESS};
+        /// Guest memory contents at the reserved address when the reservation was made.
+        u128 value{};
+    };
+
+    /// Reads a value of the given size through the memory subsystem, zero-extended to 128 bits.
+    static u128 ReadValue(VAddr addr, size_t size);
+
+    template <typename T>
+    bool ExclusiveWrite(size_t core_index, VAddr vaddr, T value);
+
+    std::vector<Reservation> reservations;
+};
@@ -38,6 +38,7 @@ public:
     void Run() override;
     void Step() override;
     void ClearInstructionCache() override;
+    void InvalidateCacheRange(VAddr addr, std::size_t size) override;
     void PageTableChanged() override{};
     void RecordBreak(GDBStub::BreakpointAddress bkpt);
 
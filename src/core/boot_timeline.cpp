@@ -0,0 +1,130 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <fmt/format.h>
+#include "common/logging/log.h"
+#include "core/boot_timeline.h"
+#include "core/core.h"
+
+namespace Core {
+
+using std::chrono::duration_cast;
+using std::chrono::microseconds;
+
+/// Number of boot phases running on the current thread
+static thread_local u32 phase_depth = 0;
+
+void BootTimeline::Start() {
+    std::lock_guard<std::mutex> lock(mutex);
+    recording = true;
+    complete = false;
+    boot_start = Clock::now();
+    total_time = {};
+    phases.clear();
+}
+
+void BootTimeline::FrameCompleted() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!recording) {
+            return;
+        }
+        recording = false;
+        complete = true;
+        total_time = duration_cast<microseconds>(Clock::now() - boot_start);
+    }
+
+    LOG_INFO(Core, "Booted in {} ms:\n{}", total_time.count() / 1000, FormatPhases());
+}
+
+void BootTimeline::Abort() {
+    std::lock_guard<std::mutex> lock(mutex);
+    recording = false;
+}
+
+bool BootTimeline::IsRecording() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return recording;
+}
+
+bool BootTimeline::IsComplete() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return complete;
+}
+
+std::chrono::microseconds BootTimeline::GetTotalTime() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return total_time;
+}
+
+std::vector<BootTimeline::Phase> BootTimeline::GetPhases() const {
+    std::vector<Phase> out;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        out = phases;
+    }
+
+    // Phases are added as they end, so nested phases come before the ones they ran in
+    std::stable_sort(out.begin(), out.end(), [](const Phase& lhs, const Phase& rhs) {
+        return lhs.start < rhs.start || (lhs.start == rhs.start && lhs.depth < rhs.depth);
+    });
+    return out;
+}
+
+std::string BootTimeline::FormatPhases() const {
+    std::string out;
+    for (const auto& phase : GetPhases()) {
+        const std::string name = std::string(phase.depth * 2, ' ') + phase.name;
+        out += fmt::format("{:>9.1f} ms  {:<40} {:>9.1f} ms", phase.start.count() / 1000.0, name,
+                           phase.duration.count() / 1000.0);
+        if (phase.count > 1) {
+            out += fmt::format(" ({}x)", phase.count);
+        }
+        out += '\n';
+    }
+    return out;
+}
+
+void BootTimeline::AddPhase(const char* name, Clock::time_point start, Clock::time_point end,
+                            u32 depth) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!recording) {
+        return;
+    }
+
+    const auto offset = duration_cast<microseconds>(start - boot_start);
+    const auto duration = duration_cast<microseconds>(end - start);
+    const auto iter = std::find_if(phases.begin(), phases.end(),
+                                   [name](const Phase& phase) { return phase.name == name; });
+    if (iter == phases.end()) {
+        phases.push_back({name, offset, duration, 1, depth});
+        return;
+    }
+
+    iter->start = std::min(iter->start, offset);
+    iter->duration += duration;
+    iter->depth = std::min(iter->depth, depth);
+    ++iter->count;
+}
+
+ScopedBootPhase::ScopedBootPhase(const char* name)
+    : name(name), start(BootTimeline::Clock::now()),
+      recording(System::GetInstance().boot_timeline.IsRecording()) {
+    if (recording) {
+        ++phase_depth;
+    }
+}
+
+ScopedBootPhase::~ScopedBootPhase() {
+    if (!recording) {
+        return;
+    }
+
+    --phase_depth;
+    System::GetInstance().boot_timeline.AddPhase(name, start, BootTimeline::Clock::now(),
+                                                 phase_depth);
+}
+
+} // namespace Core
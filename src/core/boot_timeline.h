@@ -0,0 +1,90 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "common/common_types.h"
+
+namespace Core {
+
+/**
+ * Records how long each phase of booting a title takes, from the start of System::Load until the
+ * title presents its first frame. Phases that run many times, such as parsing every installed NCA,
+ * are summed up into a single entry. All public functions of this class are thread-safe.
+ */
+class BootTimeline {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    struct Phase {
+        std::string name;
+        /// Time from the start of the boot to the first time the phase started
+        std::chrono::microseconds start;
+        /// Time spent in the phase, summed over every time it ran
+        std::chrono::microseconds duration;
+        /// Number of times the phase ran
+        u32 count;
+        /// Number of phases the phase ran in
+        u32 depth;
+    };
+
+    /// Starts recording a new boot, dropping the previous one
+    void Start();
+
+    /// Called whenever the title presents a frame. The first one after Start ends the boot.
+    void FrameCompleted();
+
+    /// Stops recording without completing the boot, e.g. because loading failed
+    void Abort();
+
+    /// Whether a boot is being recorded right now
+    bool IsRecording() const;
+
+    /// Whether the last boot recorded reached its first frame
+    bool IsComplete() const;
+
+    /// Time from the start of the last boot to its first frame
+    std::chrono::microseconds GetTotalTime() const;
+
+    /// The phases of the last (or current) boot, ordered by their first start
+    std::vector<Phase> GetPhases() const;
+
+    /// The phases of the last boot as a human readable table, one phase per line
+    std::string FormatPhases() const;
+
+    /// Adds a run of the phase called name that started at start and ended at end
+    void AddPhase(const char* name, Clock::time_point start, Clock::time_point end, u32 depth);
+
+private:
+    mutable std::mutex mutex;
+    bool recording = false;
+    bool complete = false;
+    Clock::time_point boot_start;
+    std::chrono::microseconds total_time{};
+    std::vector<Phase> phases;
+};
+
+/**
+ * Times the scope it lives in as a phase of the boot being recorded by the system's BootTimeline,
+ * if any. Phases nest: one started while another one runs on the same thread is shown below it.
+ */
+class ScopedBootPhase final {
+public:
+    explicit ScopedBootPhase(const char* name);
+    ~ScopedBootPhase();
+
+    ScopedBootPhase(const ScopedBootPhase&) = delete;
+    ScopedBootPhase& operator=(const ScopedBootPhase&) = delete;
+
+private:
+    const char* name;
+    BootTimeline::Clock::time_point start;
+    bool recording;
+};
+
+} // namespace Core
@@ -2,10 +2,14 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
+#include <functional>
 #include <memory>
+#include <numeric>
 #include <utility>
 #include "common/logging/log.h"
 #include "common/string_util.h"
+#include "common/thread.h"
 #include "core/core.h"
 #include "core/core_timing.h"
 #include "core/gdbstub/gdbstub.h"
@@ -17,7 +21,10 @@
 #include "core/hle/service/sm/controller.h"
 #include "core/hle/service/sm/sm.h"
 #include "core/loader/loader.h"
+#include "core/movie.h"
 #include "core/settings.h"
+#include "core/snapshot/snapshot.h"
+#include "core/tracer/gpu_recorder.h"
 #include "file_sys/vfs_concat.h"
 #include "file_sys/vfs_real.h"
 #include "video_core/renderer_base.h"
@@ -27,24 +34,43 @@ namespace Core {
 
 /*static*/ System System::s_instance;
 
-System::System() = default;
+/*static*/ thread_local System* System::current_instance = nullptr;
+
+System::System() : core_timing_state{CoreTiming::CreateState()} {}
 
 System::~System() = default;
 
+std::unique_ptr<System> System::Create() {
+    return std::unique_ptr<System>(new System);
+}
+
+/// CPU core run by the current host thread, used to find it in multicore mode
+static thread_local Cpu* current_cpu_core = nullptr;
+
 /// Runs a CPU core while the system is powered on
-static void RunCpuCore(std::shared_ptr<Cpu> cpu_state) {
-    while (Core::System::GetInstance().IsPoweredOn()) {
+static void RunCpuCore(System& system, std::shared_ptr<Cpu> cpu_state) {
+    system.MakeCurrent();
+    current_cpu_core = cpu_state.get();
+
+    if (Settings::values.pin_cpu_core_threads) {
+        // Keep each emulated core on its own host core, ahead of the less latency sensitive threads
+        const unsigned num_host_cores = std::max(std::thread::hardware_concurrency(), 1U);
+        Common::SetCurrentThreadAffinity(1U << (cpu_state->CoreIndex() % num_host_cores));
+        Common::SetCurrentThreadPriority(Common::ThreadPriority::High);
+    }
+
+    while (system.IsPoweredOn()) {
         cpu_state->RunLoop(true);
     }
+
+    current_cpu_core = nullptr;
 }
 
 Cpu& System::CurrentCpuCore() {
     // If multicore is enabled, use host thread to figure out the current CPU core
     if (Settings::values.use_multi_core) {
-        const auto& search = thread_to_cpu.find(std::this_thread::get_id());
-        ASSERT(search != thread_to_cpu.end());
-        ASSERT(search->second);
-        return *search->second;
+        ASSERT(current_cpu_core != nullptr);
+        return *current_cpu_core;
     }
 
     // Otherwise, use single-threaded mode active_core variable
@@ -52,10 +78,18 @@ Cpu& System::CurrentCpuCore() {
 }
 
 System::ResultStatus System::RunLoop(bool tight_loop) {
+    if (warm_restart_requested.exchange(false)) {
+        const ResultStatus restart_result = WarmRestart();
+        if (restart_result != ResultStatus::Success) {
+            return restart_result;
+        }
+    }
+
     status = ResultStatus::Success;
 
-    // Update thread_to_cpu in case Core 0 is run from a different host thread
-    thread_to_cpu[std::this_thread::get_id()] = cpu_cores[0];
+    // Core 0 may be run from a different host thread than the one the system was loaded on
+    MakeCurrent();
+    current_cpu_core = cpu_cores[0].get();
 
     if (GDBStub::IsServerEnabled()) {
         GDBStub::HandlePacket();
@@ -71,6 +105,9 @@ System::ResultStatus System::RunLoop(bool tight_loop) {
         }
     }
 
+    // No core is in the middle of a slice here, so they can be saved and restored
+    snapshot_manager->HandleRequests(*this);
+
     for (active_core = 0; active_core < NUM_CPU_CORES; ++active_core) {
         cpu_cores[active_core]->RunLoop(tight_loop);
         if (Settings::values.use_multi_core) {
@@ -118,14 +155,27 @@ static FileSys::VirtualFile GetGameFileFromPath(const FileSys::VirtualFilesystem
         return FileSys::ConcatenateFiles(concat, dir->GetName());
     }
 
-    return vfs->OpenFile(path, FileSys::Mode::Read);
+    return vfs->OpenImmutableFile(path);
 }
 
 System::ResultStatus System::Load(Frontend::EmuWindow& emu_window, const std::string& filepath) {
-    app_loader = Loader::GetLoader(GetGameFileFromPath(virtual_filesystem, filepath));
+    boot_timeline.Start();
+
+    FileSys::VirtualFile game_file;
+    {
+        ScopedBootPhase phase("Open game file");
+        game_file = GetGameFileFromPath(virtual_filesystem, filepath);
+    }
+    loaded_path = filepath;
+    loaded_file_size = game_file != nullptr ? game_file->GetSize() : 0;
+    {
+        ScopedBootPhase phase("Identify file type");
+        app_loader = Loader::GetLoader(std::move(game_file));
+    }
 
     if (!app_loader) {
         LOG_CRITICAL(Core, "Failed to obtain loader for {}!", filepath);
+        boot_timeline.Abort();
         return ResultStatus::ErrorGetLoader;
     }
     std::pair<boost::optional<u32>, Loader::ResultStatus> system_mode =
@@ -134,12 +184,23 @@ System::ResultStatus System::Load(Frontend::EmuWindow& emu_window, const std::st
     if (system_mode.second != Loader::ResultStatus::Success) {
         LOG_CRITICAL(Core, "Failed to determine system mode (Error {})!",
                      static_cast<int>(system_mode.second));
+        boot_timeline.Abort();
 
         if (system_mode.second != Loader::ResultStatus::Success)
             return ResultStatus::ErrorSystemMode;
     }
 
-    ResultStatus init_result{Init(emu_window)};
+    // Merged before anything reads them, so the title runs as if they were its global settings
+    u64 title_id{};
+    if (app_loader->ReadProgramId(title_id) == Loader::ResultStatus::Success) {
+        Settings::LoadTitleOverrides(title_id);
+    }
+
+    ResultStatus init_result;
+    {
+        ScopedBootPhase phase("Initialize system");
+        init_result = Init(emu_window);
+    }
     if (init_result != ResultStatus::Success) {
         LOG_CRITICAL(Core, "Failed to initialize system (Error {})!",
                      static_cast<int>(init_result));
@@ -147,7 +208,11 @@ System::ResultStatus System::Load(Frontend::EmuWindow& emu_window, const std::st
         return init_result;
     }
 
-    const Loader::ResultStatus load_result{app_loader->Load(current_process)};
+    Loader::ResultStatus load_result;
+    {
+        ScopedBootPhase phase("Load title");
+        load_result = app_loader->Load(current_process);
+    }
     if (Loader::ResultStatus::Success != load_result) {
         LOG_CRITICAL(Core, "Failed to load ROM (Error {})!", static_cast<int>(load_result));
         System::Shutdown();
@@ -157,10 +222,92 @@ System::ResultStatus System::Load(Frontend::EmuWindow& emu_window, const std::st
                                              static_cast<u32>(load_result));
         }
     }
+
+    // The title is known from here on, and the frontend still holds the renderer's context
+    {
+        ScopedBootPhase phase("Load disk resources");
+        renderer->Rasterizer().LoadDiskResources();
+    }
+
+    status = ResultStatus::Success;
+    return status;
+}
+
+System::ResultStatus System::WarmRestart() {
+    boot_timeline.Start();
+
+    if (Settings::values.validate_warm_restart) {
+        ScopedBootPhase phase("Validate loaded title");
+        if (!IsLoadedTitleUnchanged()) {
+            LOG_WARNING(Core, "{} changed since it was loaded, loading it from scratch",
+                        loaded_path);
+            FileSys::VirtualFile game_file = GetGameFileFromPath(virtual_filesystem, loaded_path);
+            loaded_file_size = game_file != nullptr ? game_file->GetSize() : 0;
+            app_loader = Loader::GetLoader(std::move(game_file));
+            if (!app_loader) {
+                LOG_CRITICAL(Core, "Failed to obtain loader for {}!", loaded_path);
+                boot_timeline.Abort();
+                status = ResultStatus::ErrorGetLoader;
+                return status;
+            }
+        }
+    }
+
+    {
+        ScopedBootPhase phase("Reset guest");
+        // The memory the rasterizer cached from is only mapped until the guest is torn down
+        gpu_core->WaitIdle();
+        renderer->Rasterizer().ResetGuestState();
+        ShutdownGuest();
+        InitGuest();
+        StartGuest();
+    }
+
+    // The title overrides of the settings and the disk caches of the renderer were already
+    // loaded for this title, and stay as they are
+    Loader::ResultStatus load_result;
+    {
+        ScopedBootPhase phase("Load title");
+        app_loader->MarkUnloaded();
+        load_result = app_loader->Load(current_process);
+    }
+    if (load_result != Loader::ResultStatus::Success) {
+        // Shutting down is left to the frontend, which still considers the session running
+        LOG_CRITICAL(Core, "Failed to load ROM (Error {})!", static_cast<int>(load_result));
+        boot_timeline.Abort();
+        status = static_cast<ResultStatus>(static_cast<u32>(ResultStatus::ErrorLoader) +
+                                           static_cast<u32>(load_result));
+        return status;
+    }
+
+    LOG_INFO(Core, "Restarted {}", loaded_path);
+    GetAndResetPerfStats();
+    perf_stats.BeginSystemFrame();
+
     status = ResultStatus::Success;
     return status;
 }
 
+bool System::IsLoadedTitleUnchanged() {
+    const FileSys::VirtualFile game_file = GetGameFileFromPath(virtual_filesystem, loaded_path);
+    if (game_file == nullptr || game_file->GetSize() != loaded_file_size) {
+        return false;
+    }
+
+    // Parsing the file again is what the warm restart avoids, but it shows whether the parsed
+    // contents still match
+    const auto loader = Loader::GetLoader(game_file);
+    if (!loader || loader->GetFileType() != app_loader->GetFileType()) {
+        return false;
+    }
+
+    u64 program_id{};
+    u64 loaded_program_id{};
+    const auto result = loader->ReadProgramId(program_id);
+    const auto loaded_result = app_loader->ReadProgramId(loaded_program_id);
+    return result == loaded_result && program_id == loaded_program_id;
+}
+
 void System::PrepareReschedule() {
     CurrentCpuCore().PrepareReschedule();
 }
@@ -169,6 +316,16 @@ PerfStats::Results System::GetAndResetPerfStats() {
     return perf_stats.GetAndResetStats(CoreTiming::GetGlobalTimeUs());
 }
 
+std::array<ARM_Interface::Stats, NUM_CPU_CORES> System::GetAndResetCpuStats() {
+    std::array<ARM_Interface::Stats, NUM_CPU_CORES> stats{};
+    for (size_t index = 0; index < cpu_cores.size(); ++index) {
+        if (cpu_cores[index]) {
+            stats[index] = cpu_cores[index]->ArmInterface().GetAndResetStats();
+        }
+    }
+    return stats;
+}
+
 const std::shared_ptr<Kernel::Scheduler>& System::Scheduler(size_t core_index) {
     ASSERT(core_index < NUM_CPU_CORES);
     return cpu_cores[core_index]->Scheduler();
@@ -184,15 +341,53 @@ Cpu& System::CpuCore(size_t core_index) {
     return *cpu_cores[core_index];
 }
 
+System::ResultStatus System::InitWithoutApplication(Frontend::EmuWindow& emu_window) {
+    const ResultStatus init_result = Init(emu_window);
+    if (init_result != ResultStatus::Success) {
+        LOG_CRITICAL(Core, "Failed to initialize system (Error {})!",
+                     static_cast<int>(init_result));
+        System::Shutdown();
+        return init_result;
+    }
+
+    status = ResultStatus::Success;
+    return status;
+}
+
 System::ResultStatus System::Init(Frontend::EmuWindow& emu_window) {
     LOG_DEBUG(HW_Memory, "initialized OK");
 
-    CoreTiming::Init();
-
     // Create a default fs if one doesn't already exist.
     if (virtual_filesystem == nullptr)
         virtual_filesystem = std::make_shared<FileSys::RealVfsFilesystem>();
 
+    telemetry_session = std::make_unique<Core::TelemetrySession>();
+
+    InitGuest();
+    GDBStub::Init();
+
+    {
+        ScopedBootPhase phase("Initialize renderer");
+        renderer = VideoCore::CreateRenderer(emu_window);
+        if (!renderer->Init()) {
+            return ResultStatus::ErrorVideoCore;
+        }
+    }
+
+    StartGuest();
+
+    LOG_DEBUG(Core, "Initialized OK");
+
+    // Reset counters and set time origin to current frame
+    GetAndResetPerfStats();
+    perf_stats.BeginSystemFrame();
+
+    return ResultStatus::Success;
+}
+
+void System::InitGuest() {
+    CoreTiming::Init();
+
     current_process = Kernel::Process::Create("main");
 
     cpu_barrier = std::make_shared<CpuBarrier>();
@@ -201,41 +396,34 @@ System::ResultStatus System::Init(Frontend::EmuWindow& emu_window) {
         cpu_cores[index] = std::make_shared<Cpu>(cpu_exclusive_monitor, cpu_barrier, index);
     }
 
-    telemetry_session = std::make_unique<Core::TelemetrySession>();
     service_manager = std::make_shared<Service::SM::ServiceManager>();
 
     Kernel::Init();
-    Service::Init(service_manager, virtual_filesystem);
-    GDBStub::Init();
-
-    renderer = VideoCore::CreateRenderer(emu_window);
-    if (!renderer->Init()) {
-        return ResultStatus::ErrorVideoCore;
+    {
+        ScopedBootPhase phase("Initialize services");
+        Service::Init(service_manager, virtual_filesystem);
     }
+}
 
-    gpu_core = std::make_unique<Tegra::GPU>(renderer->Rasterizer());
+void System::StartGuest() {
+    gpu_core = std::make_unique<Tegra::GPU>(*renderer);
+    snapshot_manager = std::make_unique<Snapshot::Manager>();
 
-    // Create threads for CPU cores 1-3, and build thread_to_cpu map
+    // Create threads for CPU cores 1-3, each of which sets its current core when it starts
     // CPU core 0 is run on the main thread
-    thread_to_cpu[std::this_thread::get_id()] = cpu_cores[0];
+    current_cpu_core = cpu_cores[0].get();
     if (Settings::values.use_multi_core) {
         for (size_t index = 0; index < cpu_core_threads.size(); ++index) {
             cpu_core_threads[index] =
-                std::make_unique<std::thread>(RunCpuCore, cpu_cores[index + 1]);
-            thread_to_cpu[cpu_core_threads[index]->get_id()] = cpu_cores[index + 1];
+                std::make_unique<std::thread>(RunCpuCore, std::ref(*this), cpu_cores[index + 1]);
         }
     }
-
-    LOG_DEBUG(Core, "Initialized OK");
-
-    // Reset counters and set time origin to current frame
-    GetAndResetPerfStats();
-    perf_stats.BeginSystemFrame();
-
-    return ResultStatus::Success;
 }
 
 void System::Shutdown() {
+    // A title stopped before its first frame didn't finish booting
+    boot_timeline.Abort();
+
     // Log last frame performance stats
     auto perf_results = GetAndResetPerfStats();
     Telemetry().AddField(Telemetry::FieldType::Performance, "Shutdown_EmulationSpeed",
@@ -245,24 +433,75 @@ void System::Shutdown() {
     Telemetry().AddField(Telemetry::FieldType::Performance, "Shutdown_Frametime",
                          perf_results.frametime * 1000.0);
 
+    // Totals of every core, titles that keep the CPU off its fast paths stand out by them
+    ARM_Interface::Stats cpu_totals{};
+    for (const auto& core_stats : GetAndResetCpuStats()) {
+        cpu_totals.interpreted_instructions += core_stats.interpreted_instructions;
+        for (size_t type = 0; type < cpu_totals.slow_reads.size(); ++type) {
+            cpu_totals.slow_reads[type] += core_stats.slow_reads[type];
+            cpu_totals.slow_writes[type] += core_stats.slow_writes[type];
+        }
+        cpu_totals.svc_calls += core_stats.svc_calls;
+        cpu_totals.translated_instructions += core_stats.translated_instructions;
+    }
+    const auto cached = static_cast<size_t>(Memory::PageType::RasterizerCachedMemory);
+    const auto special = static_cast<size_t>(Memory::PageType::Special);
+    Telemetry().AddField(Telemetry::FieldType::Performance, "Shutdown_CpuInterpretedInstructions",
+                         cpu_totals.interpreted_instructions);
+    Telemetry().AddField(Telemetry::FieldType::Performance, "Shutdown_CpuTranslatedInstructions",
+                         cpu_totals.translated_instructions);
+    Telemetry().AddField(Telemetry::FieldType::Performance, "Shutdown_CpuSVCCalls",
+                         cpu_totals.svc_calls);
+    Telemetry().AddField(Telemetry::FieldType::Performance, "Shutdown_CpuCachedMemoryAccesses",
+                         cpu_totals.slow_reads[cached] + cpu_totals.slow_writes[cached]);
+    Telemetry().AddField(Telemetry::FieldType::Performance, "Shutdown_CpuSpecialMemoryAccesses",
+                         cpu_totals.slow_reads[special] + cpu_totals.slow_writes[special]);
+    Telemetry().AddField(
+        Telemetry::FieldType::Performance, "Shutdown_CpuSlowMemoryAccesses",
+        std::accumulate(cpu_totals.slow_reads.begin(), cpu_totals.slow_reads.end(), u64{0}) +
+            std::accumulate(cpu_totals.slow_writes.begin(), cpu_totals.slow_writes.end(), u64{0}));
+
     // Shutdown emulation session
+    gpu_recorder.reset();
+    movie.reset();
+    ShutdownGuest();
     renderer.reset();
     GDBStub::Shutdown();
+    telemetry_session.reset();
+
+    // Close app loader
+    app_loader.reset();
+
+    // The next title starts from the global settings, which the teardown above no longer reads
+    Settings::RestoreGlobalValues();
+
+    LOG_DEBUG(Core, "Shutdown OK");
+}
+
+void System::ShutdownGuest() {
+    snapshot_manager.reset();
+    if (gpu_core) {
+        // The GPU thread reports the work it finishes to nvdrv, which goes away with the services
+        gpu_core->WaitIdle();
+    }
     Service::Shutdown();
     Kernel::Shutdown();
     service_manager.reset();
-    telemetry_session.reset();
     gpu_core.reset();
 
     // Close all CPU/threading state
     cpu_barrier->NotifyEnd();
     if (Settings::values.use_multi_core) {
+        // Wake up any core sleeping idle so that its thread can see the end of the session
+        for (auto& cpu_core : cpu_cores) {
+            cpu_core->PrepareReschedule();
+        }
         for (auto& thread : cpu_core_threads) {
             thread->join();
             thread.reset();
         }
     }
-    thread_to_cpu.clear();
+    current_cpu_core = nullptr;
     for (auto& cpu_core : cpu_cores) {
         cpu_core.reset();
     }
@@ -270,11 +509,22 @@ void System::Shutdown() {
 
     // Close core timing
     CoreTiming::Shutdown();
+}
 
-    // Close app loader
-    app_loader.reset();
+void System::StartGPURecording(std::string filename, u32 first_frame, u32 num_frames) {
+    gpu_recorder =
+        std::make_unique<GPUTrace::Recorder>(std::move(filename), first_frame, num_frames);
+}
 
-    LOG_DEBUG(Core, "Shutdown OK");
+void System::StartMovieRecording(std::string filename) {
+    movie.reset();
+    movie = Movie::Record(std::move(filename));
+}
+
+bool System::StartMoviePlayback(const std::string& filename) {
+    movie.reset();
+    movie = Movie::Play(filename);
+    return movie != nullptr;
 }
 
 Service::SM::ServiceManager& System::ServiceManager() {
@@ -5,11 +5,15 @@
 #pragma once
 
 #include <array>
+#include <atomic>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <thread>
 #include "common/common_types.h"
+#include "core/arm/arm_interface.h"
 #include "core/arm/exclusive_monitor.h"
+#include "core/boot_timeline.h"
 #include "core/core_cpu.h"
 #include "core/hle/kernel/object.h"
 #include "core/hle/kernel/scheduler.h"
@@ -22,22 +26,34 @@
 #include "video_core/debug_utils/debug_utils.h"
 #include "video_core/gpu.h"
 
-class ARM_Interface;
-
 namespace Core::Frontend {
 class EmuWindow;
 }
 
+namespace CoreTiming {
+struct State;
+}
+
+namespace GPUTrace {
+class Recorder;
+}
+
 namespace Service::SM {
 class ServiceManager;
 }
 
+namespace Snapshot {
+class Manager;
+}
+
 namespace VideoCore {
 class RendererBase;
 }
 
 namespace Core {
 
+class Movie;
+
 class System {
 public:
     System(const System&) = delete;
@@ -49,11 +65,23 @@ public:
     ~System();
 
     /**
-     * Gets the instance of the System singleton class.
-     * @returns Reference to the instance of the System singleton class.
+     * Gets the system run by the calling thread, see MakeCurrent. Threads that didn't make any
+     * system current get the default one, the only one frontends running a single session use.
+     * @returns Reference to the instance of the System class.
      */
     static System& GetInstance() {
-        return s_instance;
+        return current_instance != nullptr ? *current_instance : s_instance;
+    }
+
+    /// Creates a system besides the default one, for running several sessions in one process
+    static std::unique_ptr<System> Create();
+
+    /**
+     * Makes this the system GetInstance returns on the calling thread. The threads a system
+     * creates for its cores make it current on their own.
+     */
+    void MakeCurrent() {
+        current_instance = this;
     }
 
     /// Enumeration representing the return values of the System Initialize and Load process.
@@ -98,6 +126,13 @@ public:
         }
     }
 
+    /// Invalidates the code the CPUs translated from the given range of memory
+    void InvalidateCpuInstructionCacheRange(VAddr addr, std::size_t size) {
+        for (auto& cpu : cpu_cores) {
+            cpu->ArmInterface().InvalidateCacheRange(addr, size);
+        }
+    }
+
     /// Shutdown the emulated system.
     void Shutdown();
 
@@ -110,6 +145,22 @@ public:
      */
     ResultStatus Load(Frontend::EmuWindow& emu_window, const std::string& filepath);
 
+    /**
+     * Requests the loaded title to be restarted without tearing down the host side of the
+     * session. Thread-safe, the restart is done by the CPU thread before its next slice.
+     */
+    void RequestWarmRestart() {
+        warm_restart_requested = true;
+    }
+
+    /**
+     * Initializes the emulated system without loading an application, for tools that drive the
+     * emulated hardware themselves, like the GPU trace player.
+     * @param emu_window Reference to the host-system window used for video output.
+     * @returns ResultStatus code, indicating if the operation succeeded.
+     */
+    ResultStatus InitWithoutApplication(Frontend::EmuWindow& emu_window);
+
     /**
      * Indicates if the emulated system is powered on (all subsystems initialized and able to run an
      * application).
@@ -133,6 +184,9 @@ public:
     /// Gets and resets core performance statistics
     PerfStats::Results GetAndResetPerfStats();
 
+    /// Gets and resets the stats of the work every CPU core did outside of its fast paths
+    std::array<ARM_Interface::Stats, NUM_CPU_CORES> GetAndResetCpuStats();
+
     /// Gets an ARM interface to the CPU core that is currently running
     ARM_Interface& CurrentArmInterface() {
         return CurrentCpuCore().ArmInterface();
@@ -196,6 +250,7 @@ public:
 
     PerfStats perf_stats;
     FrameLimiter frame_limiter;
+    BootTimeline boot_timeline;
 
     void SetStatus(ResultStatus new_status, const char* details = nullptr) {
         status = new_status;
@@ -223,6 +278,33 @@ public:
         return debug_context;
     }
 
+    /**
+     * Records the GPU work of num_frames frames to a GPU trace file, once first_frame frames were
+     * presented. Replaces any recording in progress.
+     */
+    void StartGPURecording(std::string filename, u32 first_frame, u32 num_frames);
+
+    /// Returns the GPU trace recorder, nullptr if no recording was started
+    GPUTrace::Recorder* GetGPURecorder() const {
+        return gpu_recorder.get();
+    }
+
+    /// Records the input and the event timing of the session to a movie. Replaces any movie.
+    void StartMovieRecording(std::string filename);
+
+    /// Plays back a movie recorded in an earlier session. Returns false if it can't be read.
+    bool StartMoviePlayback(const std::string& filename);
+
+    /// Returns the movie being recorded or played back, nullptr if there's none
+    Movie* GetMovie() const {
+        return movie.get();
+    }
+
+    /// Gets the snapshots taken of the emulated system in this session
+    Snapshot::Manager& SnapshotManager() {
+        return *snapshot_manager;
+    }
+
     void SetFilesystem(FileSys::VirtualFilesystem vfs) {
         virtual_filesystem = std::move(vfs);
     }
@@ -231,6 +313,21 @@ public:
         return virtual_filesystem;
     }
 
+    /// Gets the timing state used by the CoreTiming functions
+    CoreTiming::State& CoreTimingState() {
+        return *core_timing_state;
+    }
+
+    /// Gets the page table of the process the CPU cores run, see Memory::SetCurrentPageTable
+    Memory::PageTable*& CurrentPageTable() {
+        return current_page_table;
+    }
+
+    /// Gets the lock of the HLE kernel state, see HLE::LockGuard
+    std::recursive_mutex& HLELock() {
+        return hle_lock;
+    }
+
 private:
     System();
 
@@ -245,13 +342,40 @@ private:
      */
     ResultStatus Init(Frontend::EmuWindow& emu_window);
 
+    /// Creates the guest side of the session: the CPU cores, the kernel and the services
+    void InitGuest();
+
+    /// Creates the GPU on top of the renderer and starts the CPU core threads
+    void StartGuest();
+
+    /// Tears down what InitGuest and StartGuest created
+    void ShutdownGuest();
+
+    /**
+     * Loads the title again into a new guest, keeping the renderer with its GL objects and
+     * compiled shaders, and the parsed and decrypted contents of the title.
+     */
+    ResultStatus WarmRestart();
+
+    /// Whether the title file on disk still is the one the loader parsed, checked before a warm
+    /// restart reuses the loader when validate_warm_restart is set
+    bool IsLoadedTitleUnchanged();
+
     /// RealVfsFilesystem instance
     FileSys::VirtualFilesystem virtual_filesystem;
     /// AppLoader used to load the current executing application
     std::unique_ptr<Loader::AppLoader> app_loader;
+    /// Path and size of the file app_loader was created from
+    std::string loaded_path;
+    u64 loaded_file_size = 0;
+    /// Lets the CPU thread check for a restart request without taking a lock
+    std::atomic_bool warm_restart_requested{false};
     std::unique_ptr<VideoCore::RendererBase> renderer;
     std::unique_ptr<Tegra::GPU> gpu_core;
     std::shared_ptr<Tegra::DebugContext> debug_context;
+    std::unique_ptr<GPUTrace::Recorder> gpu_recorder;
+    std::unique_ptr<Movie> movie;
+    std::unique_ptr<Snapshot::Manager> snapshot_manager;
     Kernel::SharedPtr<Kernel::Process> current_process;
     std::shared_ptr<ExclusiveMonitor> cpu_exclusive_monitor;
     std::shared_ptr<CpuBarrier> cpu_barrier;
@@ -265,13 +389,15 @@ private:
     /// Telemetry session for this emulation session
     std::unique_ptr<Core::TelemetrySession> telemetry_session;
 
+    std::shared_ptr<CoreTiming::State> core_timing_state;
+    Memory::PageTable* current_page_table = nullptr;
+    std::recursive_mutex hle_lock;
+
     static System s_instance;
+    static thread_local System* current_instance;
 
     ResultStatus status = ResultStatus::Success;
     std::string status_details = "";
-
-    /// Map of guest threads to CPU cores
-    std::map<std::thread::id, std::shared_ptr<Cpu>> thread_to_cpu;
 };
 
 inline ARM_Interface& CurrentArmInterface() {
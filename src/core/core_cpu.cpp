@@ -6,6 +6,7 @@
 #include <mutex>
 
 #include "common/logging/log.h"
+#include "common/trace.h"
 #ifdef ARCHITECTURE_x86_64
 #include "core/arm/dynarmic/arm_dynarmic.h"
 #endif
@@ -31,21 +32,47 @@ bool CpuBarrier::Rendezvous() {
         return true;
     }
 
-    if (!end) {
-        std::unique_lock<std::mutex> lock(mutex);
+    if (end) {
+        return false;
+    }
 
-        --cores_waiting;
-        if (!cores_waiting) {
-            cores_waiting = NUM_CPU_CORES;
-            condition.notify_all();
-            return true;
-        }
+    std::unique_lock<std::mutex> lock(mutex);
 
-        condition.wait(lock);
+    --cores_waiting;
+    if (!cores_waiting) {
+        Release(lock);
         return true;
     }
 
-    return false;
+    // Without the predicate a spurious wakeup would let this core run ahead of the others
+    const u64 current_generation = generation;
+    condition.wait(lock, [&] { return generation != current_generation || end; });
+    return true;
+}
+
+void CpuBarrier::Leave() {
+    std::unique_lock<std::mutex> lock(mutex);
+
+    --num_participants;
+    --cores_waiting;
+    if (!cores_waiting) {
+        // The remaining cores were only waiting for this one
+        Release(lock);
+    }
+}
+
+void CpuBarrier::Join() {
+    std::unique_lock<std::mutex> lock(mutex);
+
+    ++num_participants;
+    ++cores_waiting;
+}
+
+void CpuBarrier::Release(std::unique_lock<std::mutex>& lock) {
+    cores_waiting = num_participants;
+    ++generation;
+    lock.unlock();
+    condition.notify_all();
 }
 
 Cpu::Cpu(std::shared_ptr<ExclusiveMonitor> exclusive_monitor,
@@ -71,10 +98,10 @@ std::shared_ptr<ExclusiveMonitor> Cpu::MakeExclusiveMonitor(size_t num_cores) {
 #ifdef ARCHITECTURE_x86_64
         return std::make_shared<DynarmicExclusiveMonitor>(num_cores);
 #else
-        return nullptr; // TODO(merry): Passthrough exclusive monitor
+        return std::make_shared<HostExclusiveMonitor>(num_cores);
 #endif
     } else {
-        return nullptr; // TODO(merry): Passthrough exclusive monitor
+        return std::make_shared<HostExclusiveMonitor>(num_cores);
     }
 }
 
@@ -85,15 +112,20 @@ void Cpu::RunLoop(bool tight_loop) {
         return;
     }
 
+    TRACE_SCOPE("CPU Slice");
+
     // If we don't have a currently active thread then don't execute instructions,
     // instead advance to the next event and try to yield to the next thread
     if (Kernel::GetCurrentThread() == nullptr) {
         LOG_TRACE(Core, "Core-{} idling", core_index);
 
+        // Only this core skips ahead; the slice still lasts as long as the busiest core needs.
+        CoreTiming::Idle(core_index);
         if (IsMainCore()) {
-            // TODO(Subv): Only let CoreTiming idle if all 4 cores are idling.
-            CoreTiming::Idle();
             CoreTiming::Advance();
+        } else if (Settings::values.use_multi_core) {
+            // The main core keeps driving CoreTiming (and thus wakeups), so the others can sleep
+            SleepUntilWoken();
         }
 
         PrepareReschedule();
@@ -119,6 +151,23 @@ void Cpu::SingleStep() {
 void Cpu::PrepareReschedule() {
     arm_interface->PrepareReschedule();
     reschedule_pending = true;
+    wake_event.Set();
+}
+
+void Cpu::SleepUntilWoken() {
+    // Clear any stale wakeup first. Anything that becomes ready after this point also signals the
+    // event, so checking the ready queue before waiting can't miss a wakeup.
+    wake_event.Reset();
+    if (scheduler->HaveReadyThreads() || !cpu_barrier->IsAlive()) {
+        return;
+    }
+
+    LOG_TRACE(Core, "Core-{} sleeping", core_index);
+
+    // Let the other cores run their slices without waiting for this one in the meantime
+    cpu_barrier->Leave();
+    wake_event.Wait();
+    cpu_barrier->Join();
 }
 
 void Cpu::Reschedule() {
@@ -128,7 +177,7 @@ void Cpu::Reschedule() {
 
     reschedule_pending = false;
     // Lock the global kernel mutex when we manipulate the HLE state
-    std::lock_guard<std::recursive_mutex> lock(HLE::g_hle_lock);
+    HLE::LockGuard lock;
     scheduler->Reschedule();
 }
 
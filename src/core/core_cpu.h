@@ -10,7 +10,9 @@
 #include <mutex>
 #include <string>
 #include "common/common_types.h"
+#include "common/thread.h"
 #include "core/arm/exclusive_monitor.h"
+#include "core/core_timing.h"
 
 class ARM_Interface;
 
@@ -21,6 +23,7 @@ class Scheduler;
 namespace Core {
 
 constexpr unsigned NUM_CPU_CORES{4};
+static_assert(NUM_CPU_CORES <= CoreTiming::MAX_CORES, "Each CPU core needs a timing context");
 
 class CpuBarrier {
 public:
@@ -32,8 +35,22 @@ public:
 
     bool Rendezvous();
 
+    /// Stops waiting for the calling core in future rendezvous, used while the core sleeps idle.
+    void Leave();
+
+    /// Makes the calling core take part in rendezvous again after a previous Leave.
+    void Join();
+
 private:
+    /// Completes the current rendezvous, must be called with the mutex held.
+    void Release(std::unique_lock<std::mutex>& lock);
+
+    /// Number of cores that take part in each rendezvous, i.e. the cores that aren't sleeping.
+    unsigned num_participants{NUM_CPU_CORES};
     unsigned cores_waiting{NUM_CPU_CORES};
+    /// Incremented every time all cores have arrived, so that waiters can tell a completed
+    /// rendezvous apart from a spurious wakeup.
+    u64 generation{};
     std::mutex mutex;
     std::condition_variable condition;
     std::atomic<bool> end{};
@@ -75,11 +92,16 @@ public:
 private:
     void Reschedule();
 
+    /// Blocks the host thread of this idle core until something is scheduled onto it.
+    void SleepUntilWoken();
+
     std::shared_ptr<ARM_Interface> arm_interface;
     std::shared_ptr<CpuBarrier> cpu_barrier;
     std::shared_ptr<Kernel::Scheduler> scheduler;
 
     std::atomic<bool> reschedule_pending = false;
+    /// Signaled by PrepareReschedule, wakes this core up while it sleeps idle.
+    Common::Event wake_event;
     size_t core_index;
 };
 
@@ -5,21 +5,36 @@
 #include "core/core_timing.h"
 
 #include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <iterator>
 #include <mutex>
 #include <string>
 #include <tuple>
 #include <unordered_map>
+#include <unordered_set>
 #include <vector>
 #include "common/assert.h"
+#include "common/logging/log.h"
+#include "common/microprofile.h"
 #include "common/thread.h"
 #include "common/threadsafe_queue.h"
+#include "core/core.h"
 #include "core/core_timing_util.h"
 
 namespace CoreTiming {
 
-static s64 global_timer;
-static int slice_length;
-static int downcount;
+// Each emulated core counts the cycles it has executed in the current slice on its own, so cores
+// never contend on (or overwrite) a shared downcount. Advance() merges them into global_timer.
+struct CoreContext {
+    std::atomic<s64> executed_ticks{};
+    // Set by Idle(). The core is moved forward by Advance() rather than by Idle() itself, because
+    // the slice can still be shortened by events the other cores schedule after the core idled.
+    std::atomic<bool> is_idle{};
+};
 
 struct EventType {
     TimedCallback callback;
@@ -42,69 +57,140 @@ static bool operator<(const Event& left, const Event& right) {
     return std::tie(left.time, left.fifo_order) < std::tie(right.time, right.fifo_order);
 }
 
-// unordered_map stores each element separately as a linked list node so pointers to elements
-// remain stable regardless of rehashes/resizing.
-static std::unordered_map<std::string, EventType> event_types;
-
-// The queue is a min-heap using std::make_heap/push_heap/pop_heap.
-// We don't use std::priority_queue because we need to be able to serialize, unserialize and
-// erase arbitrary events (RemoveEvent()) regardless of the queue order. These aren't accomodated
-// by the standard adaptor class.
-static std::vector<Event> event_queue;
-static u64 event_fifo_id;
-// the queue for storing the events from other threads threadsafe until they will be added
-// to the event_queue by the emu thread
-static Common::MPSCQueue<Event, false> ts_queue;
-
-// the queue for unscheduling the events from other threads threadsafe
-static Common::MPSCQueue<std::pair<const EventType*, u64>, false> unschedule_queue;
+struct EventKeyHash {
+    size_t operator()(const std::pair<const EventType*, u64>& key) const {
+        return std::hash<const EventType*>()(key.first) ^ (std::hash<u64>()(key.second) << 1);
+    }
+};
 
 constexpr int MAX_SLICE_LENGTH = 20000;
 
-static s64 idled_cycles;
+struct State {
+    s64 global_timer = 0;
+    int slice_length = MAX_SLICE_LENGTH;
+
+    std::array<CoreContext, MAX_CORES> core_contexts;
+
+    // unordered_map stores each element separately as a linked list node so pointers to elements
+    // remain stable regardless of rehashes/resizing.
+    std::unordered_map<std::string, EventType> event_types;
+
+    // The queue is a min-heap using std::make_heap/push_heap/pop_heap.
+    // We don't use std::priority_queue because we need to be able to serialize, unserialize and
+    // erase arbitrary events (RemoveEvent()) regardless of the queue order. These aren't
+    // accomodated by the standard adaptor class.
+    std::vector<Event> event_queue;
+    u64 event_fifo_id = 0;
+
+    // Index from (type, userdata) to the fifo ids of the matching events that are still queued.
+    // This lets UnscheduleEvent find the events it has to cancel without scanning the whole queue.
+    std::unordered_map<std::pair<const EventType*, u64>, std::vector<u64>, EventKeyHash>
+        queued_events;
+    // Fifo ids of events that were cancelled but are still physically present in event_queue. They
+    // are lazily discarded once they reach the front of the heap, which keeps cancellation cheap
+    // instead of re-heapifying the whole queue each time.
+    std::unordered_set<u64> cancelled_events;
+    // the queue for storing the events from other threads threadsafe until they will be added
+    // to the event_queue by the emu thread
+    Common::MPSCRing<Event, 1024> ts_queue;
+
+    // the queue for unscheduling the events from other threads threadsafe
+    Common::MPSCRing<std::pair<const EventType*, u64>, 1024> unschedule_queue;
+
+    // Take what doesn't fit in the rings above. The emu thread schedules threadsafe events itself,
+    // so it can't wait for room in them. These allocate, but are only used for bursts between
+    // advances.
+    Common::MPSCQueue<Event, false> ts_overflow_queue;
+    Common::MPSCQueue<std::pair<const EventType*, u64>, false> unschedule_overflow_queue;
+
+    // Arrivals of threadsafe events logged while recording, and the ones left to replay
+    bool is_recording_arrivals = false;
+    std::vector<ThreadsafeArrival> recorded_arrivals;
+    bool is_replaying_arrivals = false;
+    std::deque<ThreadsafeArrival> replayed_arrivals;
+    // Live threadsafe events held back while replaying, until the recorded arrival they match
+    std::vector<Event> held_events;
+    // Set while the emu thread waits for a live event to match a recorded arrival, threads
+    // scheduling threadsafe events then notify it
+    std::atomic<bool> is_waiting_for_arrival{false};
+    std::mutex arrival_mutex;
+    std::condition_variable arrival_cv;
+    // A desynced replay is reported once, the arrivals after the first desync rarely match
+    bool has_reported_desync = false;
+
+    std::atomic<s64> idled_cycles{};
+
+    // Are we in a function that has been called from Advance()
+    // If events are sheduled from a function that gets called from Advance(),
+    // don't change slice_length and downcount.
+    bool is_global_timer_sane = true;
+
+    EventType* ev_lost = nullptr;
+};
 
-// Are we in a function that has been called from Advance()
-// If events are sheduled from a function that gets called from Advance(),
-// don't change slice_length and downcount.
-static bool is_global_timer_sane;
+std::shared_ptr<State> CreateState() {
+    return std::make_shared<State>();
+}
 
-static EventType* ev_lost = nullptr;
+/// Returns the timing state of the system run by the calling thread
+static State& GetState() {
+    return Core::System::GetInstance().CoreTimingState();
+}
+
+static CoreContext& GetCoreContext(size_t core_index) {
+    auto& core_contexts = GetState().core_contexts;
+    ASSERT(core_index < core_contexts.size());
+    return core_contexts[core_index];
+}
 
 static void EmptyTimedCallback(u64 userdata, s64 cyclesLate) {}
 
 EventType* RegisterEvent(const std::string& name, TimedCallback callback) {
+    auto& state = GetState();
     // check for existing type with same name.
     // we want event type names to remain unique so that we can use them for serialization.
-    ASSERT_MSG(event_types.find(name) == event_types.end(),
+    ASSERT_MSG(state.event_types.find(name) == state.event_types.end(),
                "CoreTiming Event \"{}\" is already registered. Events should only be registered "
                "during Init to avoid breaking save states.",
                name.c_str());
 
-    auto info = event_types.emplace(name, EventType{callback, nullptr});
+    auto info = state.event_types.emplace(name, EventType{callback, nullptr});
     EventType* event_type = &info.first->second;
     event_type->name = &info.first->first;
     return event_type;
 }
 
 void UnregisterAllEvents() {
-    ASSERT_MSG(event_queue.empty(), "Cannot unregister events with events pending");
-    event_types.clear();
+    auto& state = GetState();
+    ASSERT_MSG(state.queued_events.empty(), "Cannot unregister events with events pending");
+    state.event_types.clear();
 }
 
 void Init() {
-    downcount = MAX_SLICE_LENGTH;
-    slice_length = MAX_SLICE_LENGTH;
-    global_timer = 0;
-    idled_cycles = 0;
+    auto& state = GetState();
+    for (auto& context : state.core_contexts) {
+        context.executed_ticks = 0;
+        context.is_idle = false;
+    }
+    state.slice_length = MAX_SLICE_LENGTH;
+    state.global_timer = 0;
+    state.idled_cycles = 0;
 
     // The time between CoreTiming being intialized and the first call to Advance() is considered
     // the slice boundary between slice -1 and slice 0. Dispatcher loops must call Advance() before
     // executing the first cycle of each slice to prepare the slice length and downcount for
     // that slice.
-    is_global_timer_sane = true;
+    state.is_global_timer_sane = true;
 
-    event_fifo_id = 0;
-    ev_lost = RegisterEvent("_lost_event", &EmptyTimedCallback);
+    state.event_fifo_id = 0;
+    state.ev_lost = RegisterEvent("_lost_event", &EmptyTimedCallback);
+
+    state.is_recording_arrivals = false;
+    state.recorded_arrivals.clear();
+    state.is_replaying_arrivals = false;
+    state.replayed_arrivals.clear();
+    state.held_events.clear();
+    state.has_reported_desync = false;
 }
 
 void Shutdown() {
@@ -116,64 +202,152 @@ void Shutdown() {
 // This should only be called from the CPU thread. If you are calling
 // it from any other thread, you are doing something evil
 u64 GetTicks() {
-    u64 ticks = static_cast<u64>(global_timer);
-    if (!is_global_timer_sane) {
-        ticks += slice_length - downcount;
+    return GetTicks(0);
+}
+
+u64 GetTicks(size_t core_index) {
+    auto& state = GetState();
+    u64 ticks = static_cast<u64>(state.global_timer);
+    if (!state.is_global_timer_sane) {
+        ticks += GetCoreContext(core_index).executed_ticks.load(std::memory_order_relaxed);
     }
     return ticks;
 }
 
 void AddTicks(u64 ticks) {
-    downcount -= static_cast<int>(ticks);
+    AddTicks(0, ticks);
+}
+
+void AddTicks(size_t core_index, u64 ticks) {
+    GetCoreContext(core_index).executed_ticks.fetch_add(static_cast<s64>(ticks),
+                                                        std::memory_order_relaxed);
 }
 
 u64 GetIdleTicks() {
-    return static_cast<u64>(idled_cycles);
+    auto& state = GetState();
+    return static_cast<u64>(state.idled_cycles.load());
 }
 
 void ClearPendingEvents() {
-    event_queue.clear();
+    auto& state = GetState();
+    state.event_queue.clear();
+    state.queued_events.clear();
+    state.cancelled_events.clear();
+}
+
+static void PushEvent(Event event) {
+    auto& state = GetState();
+    state.queued_events[{event.type, event.userdata}].push_back(event.fifo_order);
+    state.event_queue.emplace_back(std::move(event));
+    std::push_heap(state.event_queue.begin(), state.event_queue.end(), std::greater<>());
+}
+
+/// Removes the front event of the queue. Returns false if the event had been cancelled.
+static bool PopEvent(Event& event) {
+    auto& state = GetState();
+    event = std::move(state.event_queue.front());
+    std::pop_heap(state.event_queue.begin(), state.event_queue.end(), std::greater<>());
+    state.event_queue.pop_back();
+
+    if (state.cancelled_events.erase(event.fifo_order) != 0) {
+        return false;
+    }
+
+    const auto key = std::make_pair(event.type, event.userdata);
+    auto& ids = state.queued_events[key];
+    ids.erase(std::find(ids.begin(), ids.end(), event.fifo_order));
+    if (ids.empty()) {
+        state.queued_events.erase(key);
+    }
+    return true;
+}
+
+/**
+ * Physically removes all cancelled events from the queue once they make up most of it. Cancelled
+ * events normally wait until they reach the front, but events cancelled long before their due time
+ * would otherwise pile up. Compacting only past this threshold keeps cancellation amortized O(1).
+ */
+static void CompactIfMostlyCancelled() {
+    auto& state = GetState();
+    constexpr size_t MIN_EVENTS_TO_COMPACT = 64;
+    if (state.cancelled_events.size() < MIN_EVENTS_TO_COMPACT ||
+        state.cancelled_events.size() * 2 < state.event_queue.size()) {
+        return;
+    }
+
+    const auto is_cancelled = [&state](const Event& e) {
+        return state.cancelled_events.count(e.fifo_order) != 0;
+    };
+    state.event_queue.erase(
+        std::remove_if(state.event_queue.begin(), state.event_queue.end(), is_cancelled),
+        state.event_queue.end());
+    std::make_heap(state.event_queue.begin(), state.event_queue.end(), std::greater<>());
+    state.cancelled_events.clear();
+}
+
+/// Discards cancelled events sitting at the front of the queue, so that front() is a live event.
+static void DiscardCancelledEvents() {
+    auto& state = GetState();
+    while (!state.event_queue.empty() &&
+           state.cancelled_events.count(state.event_queue.front().fifo_order) != 0) {
+        Event event;
+        PopEvent(event);
+    }
 }
 
 void ScheduleEvent(s64 cycles_into_future, const EventType* event_type, u64 userdata) {
+    auto& state = GetState();
     ASSERT(event_type != nullptr);
     s64 timeout = GetTicks() + cycles_into_future;
     // If this event needs to be scheduled before the next advance(), force one early
-    if (!is_global_timer_sane)
+    if (!state.is_global_timer_sane)
         ForceExceptionCheck(cycles_into_future);
-    event_queue.emplace_back(Event{timeout, event_fifo_id++, userdata, event_type});
-    std::push_heap(event_queue.begin(), event_queue.end(), std::greater<>());
+    PushEvent(Event{timeout, state.event_fifo_id++, userdata, event_type});
 }
 
 void ScheduleEventThreadsafe(s64 cycles_into_future, const EventType* event_type, u64 userdata) {
-    ts_queue.Push(Event{global_timer + cycles_into_future, 0, userdata, event_type});
+    auto& state = GetState();
+    Event event{state.global_timer + cycles_into_future, 0, userdata, event_type};
+    if (!state.ts_queue.TryPush(event))
+        state.ts_overflow_queue.Push(event);
+
+    if (state.is_waiting_for_arrival) {
+        // Taking the lock orders the notification after the waiter has started waiting
+        std::lock_guard<std::mutex> lock(state.arrival_mutex);
+        state.arrival_cv.notify_one();
+    }
 }
 
 void UnscheduleEvent(const EventType* event_type, u64 userdata) {
-    auto itr = std::remove_if(event_queue.begin(), event_queue.end(), [&](const Event& e) {
-        return e.type == event_type && e.userdata == userdata;
-    });
-
-    // Removing random items breaks the invariant so we have to re-establish it.
-    if (itr != event_queue.end()) {
-        event_queue.erase(itr, event_queue.end());
-        std::make_heap(event_queue.begin(), event_queue.end(), std::greater<>());
+    auto& state = GetState();
+    const auto itr = state.queued_events.find({event_type, userdata});
+    if (itr == state.queued_events.end()) {
+        return;
     }
+
+    state.cancelled_events.insert(itr->second.begin(), itr->second.end());
+    state.queued_events.erase(itr);
+    CompactIfMostlyCancelled();
 }
 
 void UnscheduleEventThreadsafe(const EventType* event_type, u64 userdata) {
-    unschedule_queue.Push(std::make_pair(event_type, userdata));
+    auto& state = GetState();
+    const auto event = std::make_pair(event_type, userdata);
+    if (!state.unschedule_queue.TryPush(event))
+        state.unschedule_overflow_queue.Push(event);
 }
 
 void RemoveEvent(const EventType* event_type) {
-    auto itr = std::remove_if(event_queue.begin(), event_queue.end(),
-                              [&](const Event& e) { return e.type == event_type; });
-
-    // Removing random items breaks the invariant so we have to re-establish it.
-    if (itr != event_queue.end()) {
-        event_queue.erase(itr, event_queue.end());
-        std::make_heap(event_queue.begin(), event_queue.end(), std::greater<>());
+    auto& state = GetState();
+    for (auto itr = state.queued_events.begin(); itr != state.queued_events.end();) {
+        if (itr->first.first == event_type) {
+            state.cancelled_events.insert(itr->second.begin(), itr->second.end());
+            itr = state.queued_events.erase(itr);
+        } else {
+            ++itr;
+        }
     }
+    CompactIfMostlyCancelled();
 }
 
 void RemoveNormalAndThreadsafeEvent(const EventType* event_type) {
@@ -182,56 +356,235 @@ void RemoveNormalAndThreadsafeEvent(const EventType* event_type) {
 }
 
 void ForceExceptionCheck(s64 cycles) {
+    auto& state = GetState();
     cycles = std::max<s64>(0, cycles);
-    if (downcount > cycles) {
-        // downcount is always (much) smaller than MAX_INT so we can safely cast cycles to an int
-        // here. Account for cycles already executed by adjusting the g.slice_length
-        slice_length -= downcount - static_cast<int>(cycles);
-        downcount = static_cast<int>(cycles);
+    // Events are scheduled relative to the main core's time, so end the slice once it has run
+    // for another `cycles`. The other cores see the shorter slice through their own downcount.
+    const s64 slice_end = GetCoreContext(0).executed_ticks.load(std::memory_order_relaxed) + cycles;
+    if (slice_end < state.slice_length) {
+        // slice_end is always (much) smaller than MAX_INT here so we can safely cast it to an int
+        state.slice_length = static_cast<int>(slice_end);
+    }
+}
+
+/// Moves the events scheduled from other threads to the events held back for the replay
+static void HoldThreadsafeEvents() {
+    auto& state = GetState();
+    for (Event ev; state.ts_queue.Pop(ev) || state.ts_overflow_queue.Pop(ev);) {
+        state.held_events.push_back(std::move(ev));
+    }
+}
+
+/// Removes the held event matching a recorded arrival, waiting for it to be scheduled if needed
+static bool TakeHeldEvent(const EventType* event_type, u64 userdata) {
+    auto& state = GetState();
+    const auto take_event = [&] {
+        HoldThreadsafeEvents();
+        const auto itr =
+            std::find_if(state.held_events.begin(), state.held_events.end(), [&](const Event& e) {
+                return e.type == event_type && e.userdata == userdata;
+            });
+        if (itr == state.held_events.end()) {
+            return false;
+        }
+        state.held_events.erase(itr);
+        return true;
+    };
+    if (take_event()) {
+        return true;
+    }
+
+    // The live event reports work done by a host thread, which may not be done yet
+    constexpr std::chrono::milliseconds MAX_WAIT{100};
+    std::unique_lock<std::mutex> lock(state.arrival_mutex);
+    state.is_waiting_for_arrival = true;
+    const bool arrived = state.arrival_cv.wait_for(lock, MAX_WAIT, take_event);
+    state.is_waiting_for_arrival = false;
+    return arrived;
+}
+
+/// Queues the recorded arrivals due by now
+static void ReplayDueArrivals() {
+    auto& state = GetState();
+    const u64 now = GetTicks();
+    while (!state.replayed_arrivals.empty() && state.replayed_arrivals.front().ticks <= now) {
+        const ThreadsafeArrival arrival = std::move(state.replayed_arrivals.front());
+        state.replayed_arrivals.pop_front();
+
+        const auto type = state.event_types.find(arrival.type_name);
+        if (type == state.event_types.end()) {
+            LOG_ERROR(Core_Timing, "Replayed event type {} isn't registered", arrival.type_name);
+            continue;
+        }
+        if (!TakeHeldEvent(&type->second, arrival.userdata) && !state.has_reported_desync) {
+            LOG_WARNING(Core_Timing,
+                        "Replay desynced, event {} at {} ticks never arrived live, later desyncs "
+                        "aren't reported",
+                        arrival.type_name, arrival.ticks);
+            state.has_reported_desync = true;
+        }
+        PushEvent(Event{arrival.time, state.event_fifo_id++, arrival.userdata, &type->second});
+    }
+
+    if (state.replayed_arrivals.empty()) {
+        LOG_INFO(Core_Timing, "Replay of threadsafe events finished at {} ticks", now);
+        StopReplayingThreadsafeEvents();
     }
 }
 
 void MoveEvents() {
-    for (Event ev; ts_queue.Pop(ev);) {
-        ev.fifo_order = event_fifo_id++;
-        event_queue.emplace_back(std::move(ev));
-        std::push_heap(event_queue.begin(), event_queue.end(), std::greater<>());
+    auto& state = GetState();
+    if (state.is_replaying_arrivals) {
+        HoldThreadsafeEvents();
+        ReplayDueArrivals();
+        return;
+    }
+
+    for (Event ev; state.ts_queue.Pop(ev) || state.ts_overflow_queue.Pop(ev);) {
+        if (state.is_recording_arrivals) {
+            state.recorded_arrivals.push_back({GetTicks(), ev.time, ev.userdata, *ev.type->name});
+        }
+        ev.fifo_order = state.event_fifo_id++;
+        PushEvent(std::move(ev));
+    }
+}
+
+void StartRecordingThreadsafeEvents() {
+    auto& state = GetState();
+    state.is_recording_arrivals = true;
+    state.recorded_arrivals.clear();
+}
+
+std::vector<ThreadsafeArrival> StopRecordingThreadsafeEvents() {
+    auto& state = GetState();
+    state.is_recording_arrivals = false;
+    std::vector<ThreadsafeArrival> arrivals;
+    arrivals.swap(state.recorded_arrivals);
+    return arrivals;
+}
+
+void ReplayThreadsafeEvents(std::vector<ThreadsafeArrival> arrivals) {
+    auto& state = GetState();
+    state.replayed_arrivals.assign(std::make_move_iterator(arrivals.begin()),
+                                   std::make_move_iterator(arrivals.end()));
+    state.is_replaying_arrivals = !state.replayed_arrivals.empty();
+    state.has_reported_desync = false;
+}
+
+void StopReplayingThreadsafeEvents() {
+    auto& state = GetState();
+    state.is_replaying_arrivals = false;
+    state.replayed_arrivals.clear();
+    for (Event& ev : state.held_events) {
+        ev.fifo_order = state.event_fifo_id++;
+        PushEvent(std::move(ev));
+    }
+    state.held_events.clear();
+}
+
+std::vector<QueuedEvent> GetQueuedEvents() {
+    auto& state = GetState();
+    MoveEvents();
+
+    std::vector<Event> live_events;
+    std::copy_if(state.event_queue.begin(), state.event_queue.end(),
+                 std::back_inserter(live_events), [&state](const Event& e) {
+                     return state.cancelled_events.count(e.fifo_order) == 0;
+                 });
+    std::sort(live_events.begin(), live_events.end());
+
+    const s64 now = static_cast<s64>(GetTicks());
+    std::vector<QueuedEvent> events;
+    events.reserve(live_events.size());
+    for (const Event& event : live_events) {
+        events.push_back({*event.type->name, event.time - now, event.userdata});
+    }
+    return events;
+}
+
+bool RestoreQueuedEvents(const std::vector<QueuedEvent>& events) {
+    auto& state = GetState();
+    std::vector<const EventType*> types;
+    types.reserve(events.size());
+    for (const QueuedEvent& event : events) {
+        const auto itr = state.event_types.find(event.type_name);
+        if (itr == state.event_types.end()) {
+            LOG_ERROR(Core_Timing, "Unknown event type {}", event.type_name);
+            return false;
+        }
+        types.push_back(&itr->second);
     }
+
+    MoveEvents();
+    ClearPendingEvents();
+    const s64 now = static_cast<s64>(GetTicks());
+    for (std::size_t i = 0; i < events.size(); ++i) {
+        // Assigning the fifo ids in order keeps the order of events that are due at once
+        PushEvent(Event{now + events[i].cycles_into_future, state.event_fifo_id++,
+                        events[i].userdata, types[i]});
+    }
+    return true;
 }
 
+MICROPROFILE_COUNTER_DEFINE(CoreTiming_Events, "CoreTiming", "Events", PerFrame);
+
 void Advance() {
+    auto& state = GetState();
     MoveEvents();
-    for (std::pair<const EventType*, u64> ev; unschedule_queue.Pop(ev);) {
+    for (std::pair<const EventType*, u64> ev;
+         state.unschedule_queue.Pop(ev) || state.unschedule_overflow_queue.Pop(ev);) {
         UnscheduleEvent(ev.first, ev.second);
     }
 
-    int cycles_executed = slice_length - downcount;
-    global_timer += cycles_executed;
-    slice_length = MAX_SLICE_LENGTH;
+    // Idle cores skip to the earliest pending event, which is never past the end of the slice
+    DiscardCancelledEvents();
+    s64 idle_target = state.slice_length;
+    if (!state.event_queue.empty()) {
+        idle_target = std::clamp<s64>(state.event_queue.front().time - state.global_timer, 0,
+                                      idle_target);
+    }
+
+    // The cores ran the slice in parallel, so time moved forward by as much as the core that got
+    // the furthest. Cores without work have either idled or executed nothing.
+    s64 cycles_executed = 0;
+    for (auto& context : state.core_contexts) {
+        s64 executed = context.executed_ticks.exchange(0);
+        if (context.is_idle.exchange(false) && executed < idle_target) {
+            state.idled_cycles += idle_target - executed;
+            executed = idle_target;
+        }
+        cycles_executed = std::max(cycles_executed, executed);
+    }
+    state.global_timer += cycles_executed;
+    state.slice_length = MAX_SLICE_LENGTH;
 
-    is_global_timer_sane = true;
+    state.is_global_timer_sane = true;
 
-    while (!event_queue.empty() && event_queue.front().time <= global_timer) {
-        Event evt = std::move(event_queue.front());
-        std::pop_heap(event_queue.begin(), event_queue.end(), std::greater<>());
-        event_queue.pop_back();
-        evt.type->callback(evt.userdata, static_cast<int>(global_timer - evt.time));
+    while (!state.event_queue.empty() && state.event_queue.front().time <= state.global_timer) {
+        Event evt;
+        if (PopEvent(evt)) {
+            MICROPROFILE_COUNTER_ADD(CoreTiming_Events, 1);
+            evt.type->callback(evt.userdata, static_cast<int>(state.global_timer - evt.time));
+        }
     }
 
-    is_global_timer_sane = false;
+    state.is_global_timer_sane = false;
+
+    DiscardCancelledEvents();
 
     // Still events left (scheduled in the future)
-    if (!event_queue.empty()) {
-        slice_length = static_cast<int>(
-            std::min<s64>(event_queue.front().time - global_timer, MAX_SLICE_LENGTH));
+    if (!state.event_queue.empty()) {
+        state.slice_length = static_cast<int>(
+            std::min<s64>(state.event_queue.front().time - state.global_timer, MAX_SLICE_LENGTH));
     }
-
-    downcount = slice_length;
 }
 
 void Idle() {
-    idled_cycles += downcount;
-    downcount = 0;
+    Idle(0);
+}
+
+void Idle(size_t core_index) {
+    GetCoreContext(core_index).is_idle.store(true, std::memory_order_relaxed);
 }
 
 std::chrono::microseconds GetGlobalTimeUs() {
@@ -239,7 +592,17 @@ std::chrono::microseconds GetGlobalTimeUs() {
 }
 
 int GetDowncount() {
-    return downcount;
+    return GetDowncount(0);
+}
+
+int GetDowncount(size_t core_index) {
+    auto& state = GetState();
+    const CoreContext& context = GetCoreContext(core_index);
+    if (context.is_idle.load(std::memory_order_relaxed)) {
+        return 0;
+    }
+    const s64 executed = context.executed_ticks.load(std::memory_order_relaxed);
+    return static_cast<int>(state.slice_length - executed);
 }
 
 } // namespace CoreTiming
@@ -18,14 +18,30 @@
  */
 
 #include <chrono>
+#include <cstddef>
 #include <functional>
+#include <memory>
 #include <string>
+#include <vector>
 #include "common/common_types.h"
 
 namespace CoreTiming {
 
+/// Number of emulated cores that keep their own timing context.
+constexpr std::size_t MAX_CORES = 4;
+
 struct EventType;
 
+/**
+ * Timing state of one emulated system: its clock, the queued events and the registered event
+ * types. Every System owns one, and the functions below act on the one of the system the calling
+ * thread runs, see Core::System::GetInstance.
+ */
+struct State;
+
+/// Creates the timing state of a new system
+std::shared_ptr<State> CreateState();
+
 using TimedCallback = std::function<void(u64 userdata, int cycles_late)>;
 
 /**
@@ -43,6 +59,14 @@ u64 GetTicks();
 u64 GetIdleTicks();
 void AddTicks(u64 ticks);
 
+/**
+ * Per-core variants of the above. Every core counts the cycles it executes in the current slice
+ * independently; the overloads without a core index refer to the main core (core 0).
+ * These should only be called from the host thread running the given core.
+ */
+u64 GetTicks(std::size_t core_index);
+void AddTicks(std::size_t core_index, u64 ticks);
+
 /**
  * Returns the event_type identifier. if name is not unique, it will assert.
  */
@@ -83,13 +107,66 @@ void MoveEvents();
 /// Pretend that the main CPU has executed enough cycles to reach the next event.
 void Idle();
 
+/**
+ * Pretend that the given core has executed enough cycles to reach the earliest pending event,
+ * capped at the end of the current slice. The core is moved forward by the next Advance().
+ */
+void Idle(std::size_t core_index);
+
 /// Clear all pending events. This should ONLY be done on exit.
 void ClearPendingEvents();
 
+/// An event waiting in the queue, with its type referred to by name so that it can be saved
+struct QueuedEvent {
+    std::string type_name;
+    s64 cycles_into_future;
+    u64 userdata;
+};
+
+/// Returns the events waiting in the queue in the order they are due, for save states.
+std::vector<QueuedEvent> GetQueuedEvents();
+
+/**
+ * Replaces the events waiting in the queue, keeping their order. Returns false without changing
+ * the queue if any of the event types isn't registered.
+ */
+bool RestoreQueuedEvents(const std::vector<QueuedEvent>& events);
+
+/**
+ * Arrival in the queue of an event scheduled with ScheduleEventThreadsafe. Events from other
+ * threads arrive whenever the CPU thread next moves them into the queue, which depends on host
+ * timing, so arrivals are what has to be recorded to replay a session deterministically.
+ */
+struct ThreadsafeArrival {
+    /// Ticks at which the event was moved into the queue
+    u64 ticks;
+    /// Ticks at which the event is due
+    s64 time;
+    u64 userdata;
+    std::string type_name;
+};
+
+/// Starts logging the arrivals of threadsafe events, discarding any previous log.
+void StartRecordingThreadsafeEvents();
+
+/// Stops logging the arrivals of threadsafe events, returning those arrived since the start.
+std::vector<ThreadsafeArrival> StopRecordingThreadsafeEvents();
+
+/**
+ * Makes threadsafe events arrive at the recorded ticks instead of whenever they are scheduled.
+ * Each recorded arrival waits for the live event it matches, so that the work that event reports
+ * is done, and the events go back to arriving live once the recording runs out.
+ */
+void ReplayThreadsafeEvents(std::vector<ThreadsafeArrival> arrivals);
+
+/// Stops replaying arrivals of threadsafe events, the events held back arrive now.
+void StopReplayingThreadsafeEvents();
+
 void ForceExceptionCheck(s64 cycles);
 
 std::chrono::microseconds GetGlobalTimeUs();
 
 int GetDowncount();
+int GetDowncount(std::size_t core_index);
 
 } // namespace CoreTiming
@@ -0,0 +1,324 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <atomic>
+#include <cstring>
+#include "common/assert.h"
+#include "common/swap.h"
+#include "core/crypto/aes_ni.h"
+
+#ifdef ARCHITECTURE_x86_64
+#include <wmmintrin.h>
+#include "common/x64/cpu_detect.h"
+
+// The rest of the emulator is built for baseline x86-64, so only these functions may use AES-NI.
+// They are only called after checking for it at runtime.
+#if defined(__GNUC__) || defined(__clang__)
+#define AESNI_TARGET __attribute__((target("aes,sse2")))
+#else
+#define AESNI_TARGET
+#endif
+#endif
+
+namespace Core::Crypto::AESNI {
+
+#ifdef ARCHITECTURE_x86_64
+
+/// Blocks transcoded at once, enough to hide the latency of the AES instructions
+constexpr size_t PARALLEL_BLOCKS = 8;
+
+namespace {
+
+AESNI_TARGET __m128i ExpandStep(__m128i key, __m128i generated) {
+    generated = _mm_shuffle_epi32(generated, _MM_SHUFFLE(3, 3, 3, 3));
+    key = _mm_xor_si128(key, _mm_slli_si128(key, 4));
+    key = _mm_xor_si128(key, _mm_slli_si128(key, 4));
+    key = _mm_xor_si128(key, _mm_slli_si128(key, 4));
+    return _mm_xor_si128(key, generated);
+}
+
+struct RoundKeys {
+    __m128i keys[11];
+};
+
+AESNI_TARGET RoundKeys LoadKeys(const std::array<u8, 11 * 16>& source) {
+    RoundKeys round_keys;
+    for (size_t i = 0; i < 11; ++i) {
+        round_keys.keys[i] = _mm_load_si128(reinterpret_cast<const __m128i*>(source.data()) + i);
+    }
+    return round_keys;
+}
+
+template <size_t count>
+AESNI_TARGET void EncryptBlocks(const RoundKeys& round_keys, __m128i* blocks) {
+    for (size_t b = 0; b < count; ++b) {
+        blocks[b] = _mm_xor_si128(blocks[b], round_keys.keys[0]);
+    }
+    for (size_t round = 1; round < 10; ++round) {
+        for (size_t b = 0; b < count; ++b) {
+            blocks[b] = _mm_aesenc_si128(blocks[b], round_keys.keys[round]);
+        }
+    }
+    for (size_t b = 0; b < count; ++b) {
+        blocks[b] = _mm_aesenclast_si128(blocks[b], round_keys.keys[10]);
+    }
+}
+
+template <size_t count>
+AESNI_TARGET void DecryptBlocks(const RoundKeys& round_keys, __m128i* blocks) {
+    for (size_t b = 0; b < count; ++b) {
+        blocks[b] = _mm_xor_si128(blocks[b], round_keys.keys[0]);
+    }
+    for (size_t round = 1; round < 10; ++round) {
+        for (size_t b = 0; b < count; ++b) {
+            blocks[b] = _mm_aesdec_si128(blocks[b], round_keys.keys[round]);
+        }
+    }
+    for (size_t b = 0; b < count; ++b) {
+        blocks[b] = _mm_aesdeclast_si128(blocks[b], round_keys.keys[10]);
+    }
+}
+
+template <size_t count>
+AESNI_TARGET void TranscodeBlocks(const RoundKeys& round_keys, __m128i* blocks, bool encrypt) {
+    if (encrypt) {
+        EncryptBlocks<count>(round_keys, blocks);
+    } else {
+        DecryptBlocks<count>(round_keys, blocks);
+    }
+}
+
+/// Counter block as two native integers, high half first
+struct Counter {
+    u64 high;
+    u64 low;
+
+    void Increment() {
+        if (++low == 0) {
+            ++high;
+        }
+    }
+
+    AESNI_TARGET __m128i ToBlock() const {
+        return _mm_set_epi64x(static_cast<s64>(Common::swap64(low)),
+                              static_cast<s64>(Common::swap64(high)));
+    }
+};
+
+/// XTS tweak as two native integers, low half first, as XTS treats blocks as little-endian
+struct Tweak {
+    u64 low;
+    u64 high;
+
+    /// Multiplies the tweak by x in GF(2^128)
+    void Advance() {
+        const u64 carry = high >> 63;
+        high = (high << 1) | (low >> 63);
+        low = (low << 1) ^ (carry * 0x87);
+    }
+
+    AESNI_TARGET __m128i ToBlock() const {
+        return _mm_set_epi64x(static_cast<s64>(high), static_cast<s64>(low));
+    }
+};
+
+} // Anonymous namespace
+
+bool IsSupported() {
+    static const bool supported = Common::GetCPUCaps().aes;
+    return supported;
+}
+
+AESNI_TARGET void ExpandKey(const u8* key, KeySchedule& schedule) {
+    __m128i keys[11];
+    keys[0] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(key));
+    // The round constant is an immediate operand, so the steps can't be a loop
+    keys[1] = ExpandStep(keys[0], _mm_aeskeygenassist_si128(keys[0], 0x01));
+    keys[2] = ExpandStep(keys[1], _mm_aeskeygenassist_si128(keys[1], 0x02));
+    keys[3] = ExpandStep(keys[2], _mm_aeskeygenassist_si128(keys[2], 0x04));
+    keys[4] = ExpandStep(keys[3], _mm_aeskeygenassist_si128(keys[3], 0x08));
+    keys[5] = ExpandStep(keys[4], _mm_aeskeygenassist_si128(keys[4], 0x10));
+    keys[6] = ExpandStep(keys[5], _mm_aeskeygenassist_si128(keys[5], 0x20));
+    keys[7] = ExpandStep(keys[6], _mm_aeskeygenassist_si128(keys[6], 0x40));
+    keys[8] = ExpandStep(keys[7], _mm_aeskeygenassist_si128(keys[7], 0x80));
+    keys[9] = ExpandStep(keys[8], _mm_aeskeygenassist_si128(keys[8], 0x1B));
+    keys[10] = ExpandStep(keys[9], _mm_aeskeygenassist_si128(keys[9], 0x36));
+
+    auto* const encrypt = reinterpret_cast<__m128i*>(schedule.encrypt.data());
+    auto* const decrypt = reinterpret_cast<__m128i*>(schedule.decrypt.data());
+    for (size_t i = 0; i < 11; ++i) {
+        _mm_store_si128(encrypt + i, keys[i]);
+    }
+    // The equivalent inverse cipher runs the rounds backwards, with InvMixColumns applied to the
+    // inner round keys
+    _mm_store_si128(decrypt, keys[10]);
+    for (size_t i = 1; i < 10; ++i) {
+        _mm_store_si128(decrypt + i, _mm_aesimc_si128(keys[10 - i]));
+    }
+    _mm_store_si128(decrypt + 10, keys[0]);
+}
+
+AESNI_TARGET void TranscodeECB(const KeySchedule& schedule, const u8* src, size_t size, u8* dest,
+                               bool encrypt) {
+    ASSERT(size % 16 == 0);
+    const RoundKeys round_keys = LoadKeys(encrypt ? schedule.encrypt : schedule.decrypt);
+    const auto* in = reinterpret_cast<const __m128i*>(src);
+    auto* out = reinterpret_cast<__m128i*>(dest);
+    size_t count = size / 16;
+
+    for (; count >= PARALLEL_BLOCKS; count -= PARALLEL_BLOCKS) {
+        __m128i blocks[PARALLEL_BLOCKS];
+        for (size_t b = 0; b < PARALLEL_BLOCKS; ++b) {
+            blocks[b] = _mm_loadu_si128(in + b);
+        }
+        TranscodeBlocks<PARALLEL_BLOCKS>(round_keys, blocks, encrypt);
+        for (size_t b = 0; b < PARALLEL_BLOCKS; ++b) {
+            _mm_storeu_si128(out + b, blocks[b]);
+        }
+        in += PARALLEL_BLOCKS;
+        out += PARALLEL_BLOCKS;
+    }
+    for (; count > 0; --count) {
+        __m128i block = _mm_loadu_si128(in++);
+        TranscodeBlocks<1>(round_keys, &block, encrypt);
+        _mm_storeu_si128(out++, block);
+    }
+}
+
+AESNI_TARGET std::array<u8, 16> TranscodeCTR(const KeySchedule& schedule,
+                                             const std::array<u8, 16>& counter_block,
+                                             const u8* src, size_t size, u8* dest) {
+    const RoundKeys round_keys = LoadKeys(schedule.encrypt);
+    Counter counter;
+    std::memcpy(&counter.high, counter_block.data(), sizeof(u64));
+    std::memcpy(&counter.low, counter_block.data() + 8, sizeof(u64));
+    counter.high = Common::swap64(counter.high);
+    counter.low = Common::swap64(counter.low);
+
+    size_t offset = 0;
+    for (; offset + PARALLEL_BLOCKS * 16 <= size; offset += PARALLEL_BLOCKS * 16) {
+        __m128i keystream[PARALLEL_BLOCKS];
+        for (size_t b = 0; b < PARALLEL_BLOCKS; ++b) {
+            keystream[b] = counter.ToBlock();
+            counter.Increment();
+        }
+        EncryptBlocks<PARALLEL_BLOCKS>(round_keys, keystream);
+        for (size_t b = 0; b < PARALLEL_BLOCKS; ++b) {
+            const auto* in = reinterpret_cast<const __m128i*>(src + offset) + b;
+            auto* out = reinterpret_cast<__m128i*>(dest + offset) + b;
+            _mm_storeu_si128(out, _mm_xor_si128(_mm_loadu_si128(in), keystream[b]));
+        }
+    }
+    for (; offset < size; offset += 16) {
+        __m128i keystream = counter.ToBlock();
+        counter.Increment();
+        EncryptBlocks<1>(round_keys, &keystream);
+
+        if (size - offset >= 16) {
+            const auto* in = reinterpret_cast<const __m128i*>(src + offset);
+            auto* out = reinterpret_cast<__m128i*>(dest + offset);
+            _mm_storeu_si128(out, _mm_xor_si128(_mm_loadu_si128(in), keystream));
+        } else {
+            alignas(16) std::array<u8, 16> bytes;
+            _mm_store_si128(reinterpret_cast<__m128i*>(bytes.data()), keystream);
+            for (size_t i = 0; offset + i < size; ++i) {
+                dest[offset + i] = src[offset + i] ^ bytes[i];
+            }
+        }
+    }
+
+    std::array<u8, 16> next;
+    const u64 high = Common::swap64(counter.high);
+    const u64 low = Common::swap64(counter.low);
+    std::memcpy(next.data(), &high, sizeof(u64));
+    std::memcpy(next.data() + 8, &low, sizeof(u64));
+    return next;
+}
+
+AESNI_TARGET void TranscodeXTS(const KeySchedule& data_schedule,
+                               const KeySchedule& tweak_schedule, const u8* src, size_t size,
+                               u8* dest, u64 sector_id, size_t sector_size, bool encrypt) {
+    ASSERT(sector_size % 16 == 0 && size % sector_size == 0);
+    const RoundKeys data_keys =
+        LoadKeys(encrypt ? data_schedule.encrypt : data_schedule.decrypt);
+    const RoundKeys tweak_keys = LoadKeys(tweak_schedule.encrypt);
+
+    for (size_t sector_offset = 0; sector_offset < size; sector_offset += sector_size) {
+        // The initial tweak is the encrypted big-endian sector number
+        __m128i initial_tweak = _mm_set_epi64x(static_cast<s64>(Common::swap64(sector_id++)), 0);
+        EncryptBlocks<1>(tweak_keys, &initial_tweak);
+        Tweak tweak;
+        tweak.low = static_cast<u64>(_mm_cvtsi128_si64(initial_tweak));
+        tweak.high = static_cast<u64>(_mm_cvtsi128_si64(_mm_unpackhi_epi64(initial_tweak,
+                                                                           initial_tweak)));
+
+        const auto* in = reinterpret_cast<const __m128i*>(src + sector_offset);
+        auto* out = reinterpret_cast<__m128i*>(dest + sector_offset);
+        size_t count = sector_size / 16;
+
+        for (; count >= PARALLEL_BLOCKS; count -= PARALLEL_BLOCKS) {
+            __m128i tweaks[PARALLEL_BLOCKS];
+            __m128i blocks[PARALLEL_BLOCKS];
+            for (size_t b = 0; b < PARALLEL_BLOCKS; ++b) {
+                tweaks[b] = tweak.ToBlock();
+                tweak.Advance();
+                blocks[b] = _mm_xor_si128(_mm_loadu_si128(in + b), tweaks[b]);
+            }
+            TranscodeBlocks<PARALLEL_BLOCKS>(data_keys, blocks, encrypt);
+            for (size_t b = 0; b < PARALLEL_BLOCKS; ++b) {
+                _mm_storeu_si128(out + b, _mm_xor_si128(blocks[b], tweaks[b]));
+            }
+            in += PARALLEL_BLOCKS;
+            out += PARALLEL_BLOCKS;
+        }
+        for (; count > 0; --count) {
+            const __m128i block_tweak = tweak.ToBlock();
+            tweak.Advance();
+            __m128i block = _mm_xor_si128(_mm_loadu_si128(in++), block_tweak);
+            TranscodeBlocks<1>(data_keys, &block, encrypt);
+            _mm_storeu_si128(out++, _mm_xor_si128(block, block_tweak));
+        }
+    }
+}
+
+#else
+
+bool IsSupported() {
+    return false;
+}
+
+void ExpandKey(const u8* key, KeySchedule& schedule) {
+    UNREACHABLE();
+}
+
+void TranscodeECB(const KeySchedule& schedule, const u8* src, size_t size, u8* dest,
+                  bool encrypt) {
+    UNREACHABLE();
+}
+
+std::array<u8, 16> TranscodeCTR(const KeySchedule& schedule, const std::array<u8, 16>& counter,
+                                const u8* src, size_t size, u8* dest) {
+    UNREACHABLE();
+    return counter;
+}
+
+void TranscodeXTS(const KeySchedule& data_schedule, const KeySchedule& tweak_schedule,
+                  const u8* src, size_t size, u8* dest, u64 sector_id, size_t sector_size,
+                  bool encrypt) {
+    UNREACHABLE();
+}
+
+#endif
+
+static std::atomic<bool> backend_enabled{true};
+
+bool IsEnabled() {
+    return IsSupported() && backend_enabled;
+}
+
+void SetEnabled(bool enabled) {
+    backend_enabled = enabled;
+}
+
+} // namespace Core::Crypto::AESNI
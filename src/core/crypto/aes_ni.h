@@ -0,0 +1,53 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include "common/common_types.h"
+
+namespace Core::Crypto::AESNI {
+
+/// Expanded AES-128 round keys, for both directions
+struct KeySchedule {
+    alignas(16) std::array<u8, 11 * 16> encrypt;
+    alignas(16) std::array<u8, 11 * 16> decrypt;
+};
+
+/// Returns whether the host supports the AES-NI instructions this backend is built on
+bool IsSupported();
+
+/**
+ * Returns whether ciphers created from now on should use this backend: the host supports it and it
+ * hasn't been disabled with SetEnabled.
+ */
+bool IsEnabled();
+
+/// Allows turning the backend off, so that the mbedtls path can be checked against it
+void SetEnabled(bool enabled);
+
+/// Expands a 128-bit key. Only valid if IsSupported().
+void ExpandKey(const u8* key, KeySchedule& schedule);
+
+/// Transcodes whole 16-byte blocks in ECB mode. size must be a multiple of 16.
+void TranscodeECB(const KeySchedule& schedule, const u8* src, size_t size, u8* dest, bool encrypt);
+
+/**
+ * Transcodes in CTR mode, starting from the given big-endian counter block.
+ * @returns The counter block following the last one used, for a partial last block as well.
+ */
+std::array<u8, 16> TranscodeCTR(const KeySchedule& schedule, const std::array<u8, 16>& counter,
+                                const u8* src, size_t size, u8* dest);
+
+/**
+ * Transcodes whole XTS sectors, starting at sector_id. The tweak of each sector is its number as
+ * a big-endian block, as used by Nintendo. size must be a multiple of sector_size, which must be
+ * a multiple of 16.
+ */
+void TranscodeXTS(const KeySchedule& data_schedule, const KeySchedule& tweak_schedule,
+                  const u8* src, size_t size, u8* dest, u64 sector_id, size_t sector_size,
+                  bool encrypt);
+
+} // namespace Core::Crypto::AESNI
@@ -2,13 +2,26 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
+#include <cstring>
+#include <mutex>
+#include <boost/optional.hpp>
 #include <mbedtls/cipher.h>
 #include "common/assert.h"
 #include "common/logging/log.h"
+#include "common/swap.h"
+#include "common/thread_pool.h"
+#include "core/crypto/aes_ni.h"
 #include "core/crypto/aes_util.h"
 #include "core/crypto/key_manager.h"
 
 namespace Core::Crypto {
+
+/// Transcodes at least this large are split across the shared thread pool
+constexpr size_t PARALLEL_TRANSCODE_THRESHOLD = 0x100000;
+/// Bytes transcoded per thread pool job, a multiple of every XTS sector size in use
+constexpr size_t PARALLEL_TRANSCODE_CHUNK = 0x40000;
+
 namespace {
 std::vector<u8> CalculateNintendoTweak(size_t sector_id) {
     std::vector<u8> out(0x10);
@@ -31,8 +44,120 @@ static_assert(static_cast<size_t>(Mode::XTS) == static_cast<size_t>(MBEDTLS_CIPH
 struct CipherContext {
     mbedtls_cipher_context_t encryption_context;
     mbedtls_cipher_context_t decryption_context;
+
+    /// Whether the cipher runs on AES-NI instead of mbedtls
+    bool use_aesni = false;
+    Mode mode;
+    /// Current IV, or counter block in CTR mode, as seen by the AES-NI backend
+    std::array<u8, 16> iv{};
+    /// Round keys for AES-NI: the data key, and in XTS mode the tweak key
+    AESNI::KeySchedule data_schedule;
+    AESNI::KeySchedule tweak_schedule;
+
+    /// Serializes the use of the mbedtls contexts, which keep state from one call to the next
+    std::mutex mutex;
 };
 
+/// Splits a transcode of size bytes into independent chunks across the shared thread pool
+template <typename Func>
+static void ParallelTranscode(size_t size, Func&& func) {
+    const size_t chunk_count = (size + PARALLEL_TRANSCODE_CHUNK - 1) / PARALLEL_TRANSCODE_CHUNK;
+    Common::GetSharedThreadPool().ParallelFor(chunk_count, [&](size_t chunk) {
+        const size_t offset = chunk * PARALLEL_TRANSCODE_CHUNK;
+        func(offset, std::min(PARALLEL_TRANSCODE_CHUNK, size - offset));
+    });
+}
+
+/// Adds a number of blocks to a big-endian CTR counter block
+static std::array<u8, 16> AdvanceCounter(std::array<u8, 16> counter, u64 blocks) {
+    for (size_t i = counter.size(); i-- > 0 && blocks != 0;) {
+        const u64 sum = counter[i] + (blocks & 0xFF);
+        counter[i] = static_cast<u8>(sum);
+        blocks = (blocks >> 8) + (sum >> 8);
+    }
+    return counter;
+}
+
+/**
+ * Transcodes on AES-NI with the given IV, if the mode and size allow it. Returns the IV that comes
+ * next, which only differs from iv in CTR mode, or boost::none if mbedtls has to do the transcode.
+ * Only reads the key schedules, so it is safe to call from any number of threads.
+ */
+static boost::optional<std::array<u8, 16>> TranscodeWithAESNI(const CipherContext& ctx,
+                                                              const std::array<u8, 16>& iv,
+                                                              const u8* src, size_t size, u8* dest,
+                                                              Op op) {
+    switch (ctx.mode) {
+    case Mode::CTR:
+        if (size < PARALLEL_TRANSCODE_THRESHOLD) {
+            return AESNI::TranscodeCTR(ctx.data_schedule, iv, src, size, dest);
+        }
+        ParallelTranscode(size, [&](size_t offset, size_t length) {
+            AESNI::TranscodeCTR(ctx.data_schedule, AdvanceCounter(iv, offset / 16), src + offset,
+                                length, dest + offset);
+        });
+        return AdvanceCounter(iv, (size + 15) / 16);
+    case Mode::ECB:
+        if (size % 16 == 0) {
+            AESNI::TranscodeECB(ctx.data_schedule, src, size, dest, op == Op::Encrypt);
+            return iv;
+        }
+        break;
+    case Mode::XTS:
+        if (size % 16 == 0) {
+            // A single data unit, whose tweak is the IV
+            u64 sector_id;
+            std::memcpy(&sector_id, iv.data() + 8, sizeof(u64));
+            u64 high;
+            std::memcpy(&high, iv.data(), sizeof(u64));
+            if (high == 0) {
+                AESNI::TranscodeXTS(ctx.data_schedule, ctx.tweak_schedule, src, size, dest,
+                                    Common::swap64(sector_id), size, op == Op::Encrypt);
+                return iv;
+            }
+        }
+        break;
+    }
+    // Anything else, such as XTS ciphertext stealing, is left to mbedtls
+    return boost::none;
+}
+
+/// Sets the IV of both mbedtls contexts. ctx.mutex must be held.
+static void SetMbedtlsIV(CipherContext& ctx, const u8* iv, size_t size) {
+    ASSERT_MSG((mbedtls_cipher_set_iv(&ctx.encryption_context, iv, size) ||
+                mbedtls_cipher_set_iv(&ctx.decryption_context, iv, size)) == 0,
+               "Failed to set IV on mbedtls ciphers.");
+}
+
+/// Transcodes with mbedtls, from the IV last set on its contexts. ctx.mutex must be held.
+static void TranscodeWithMbedtls(CipherContext& ctx, const u8* src, size_t size, u8* dest, Op op) {
+    auto* const context = op == Op::Encrypt ? &ctx.encryption_context : &ctx.decryption_context;
+
+    mbedtls_cipher_reset(context);
+
+    size_t written = 0;
+    if (mbedtls_cipher_get_cipher_mode(context) == MBEDTLS_MODE_XTS) {
+        mbedtls_cipher_update(context, src, size, dest, &written);
+        if (written != size) {
+            LOG_WARNING(Crypto, "Not all data was decrypted requested={:016X}, actual={:016X}.",
+                        size, written);
+        }
+    } else {
+        const auto block_size = mbedtls_cipher_get_block_size(context);
+
+        for (size_t offset = 0; offset < size; offset += block_size) {
+            auto length = std::min<size_t>(block_size, size - offset);
+            mbedtls_cipher_update(context, src + offset, length, dest + offset, &written);
+            if (written != length) {
+                LOG_WARNING(Crypto, "Not all data was decrypted requested={:016X}, actual={:016X}.",
+                            length, written);
+            }
+        }
+    }
+
+    mbedtls_cipher_finish(context, nullptr, nullptr);
+}
+
 template <typename Key, size_t KeySize>
 Crypto::AESCipher<Key, KeySize>::AESCipher(Key key, Mode mode)
     : ctx(std::make_unique<CipherContext>()) {
@@ -52,6 +177,19 @@ Crypto::AESCipher<Key, KeySize>::AESCipher(Key key, Mode mode)
     ASSERT(
         !mbedtls_cipher_setkey(&ctx->decryption_context, key.data(), KeySize * 8, MBEDTLS_DECRYPT));
     //"Failed to set key on mbedtls ciphers.");
+
+    // The AES-NI backend covers the AES-128 modes in use: CTR and ECB with 128-bit keys, and XTS
+    // with a pair of them
+    ctx->mode = mode;
+    const bool is_aes128_mode = KeySize == 0x10 ? (mode == Mode::CTR || mode == Mode::ECB)
+                                                : mode == Mode::XTS;
+    if (is_aes128_mode && AESNI::IsEnabled()) {
+        ctx->use_aesni = true;
+        AESNI::ExpandKey(key.data(), ctx->data_schedule);
+        if (mode == Mode::XTS) {
+            AESNI::ExpandKey(key.data() + 0x10, ctx->tweak_schedule);
+        }
+    }
 }
 
 template <typename Key, size_t KeySize>
@@ -61,49 +199,77 @@ AESCipher<Key, KeySize>::~AESCipher() {
 }
 
 template <typename Key, size_t KeySize>
-void AESCipher<Key, KeySize>::SetIV(std::vector<u8> iv) {
-    ASSERT_MSG((mbedtls_cipher_set_iv(&ctx->encryption_context, iv.data(), iv.size()) ||
-                mbedtls_cipher_set_iv(&ctx->decryption_context, iv.data(), iv.size())) == 0,
-               "Failed to set IV on mbedtls ciphers.");
+void AESCipher<Key, KeySize>::SetIV(const std::vector<u8>& iv) {
+    SetIV(iv.data(), iv.size());
 }
 
 template <typename Key, size_t KeySize>
-void AESCipher<Key, KeySize>::Transcode(const u8* src, size_t size, u8* dest, Op op) const {
-    auto* const context = op == Op::Encrypt ? &ctx->encryption_context : &ctx->decryption_context;
-
-    mbedtls_cipher_reset(context);
-
-    size_t written = 0;
-    if (mbedtls_cipher_get_cipher_mode(context) == MBEDTLS_MODE_XTS) {
-        mbedtls_cipher_update(context, src, size, dest, &written);
-        if (written != size) {
-            LOG_WARNING(Crypto, "Not all data was decrypted requested={:016X}, actual={:016X}.",
-                        size, written);
+void AESCipher<Key, KeySize>::SetIV(const u8* iv, size_t size) {
+    if (ctx->use_aesni) {
+        ctx->iv.fill(0);
+        std::memcpy(ctx->iv.data(), iv, std::min(size, ctx->iv.size()));
+        // mbedtls only needs the IV if it has to take over, see Transcode
+        if (ctx->mode != Mode::XTS) {
+            return;
         }
-    } else {
-        const auto block_size = mbedtls_cipher_get_block_size(context);
+    }
+    std::lock_guard<std::mutex> lock(ctx->mutex);
+    SetMbedtlsIV(*ctx, iv, size);
+}
 
-        for (size_t offset = 0; offset < size; offset += block_size) {
-            auto length = std::min<size_t>(block_size, size - offset);
-            mbedtls_cipher_update(context, src + offset, length, dest + offset, &written);
-            if (written != length) {
-                LOG_WARNING(Crypto, "Not all data was decrypted requested={:016X}, actual={:016X}.",
-                            length, written);
-            }
+template <typename Key, size_t KeySize>
+void AESCipher<Key, KeySize>::Transcode(const u8* src, size_t size, u8* dest, Op op) const {
+    if (ctx->use_aesni) {
+        // Like mbedtls, carry on from where the last call left the counter
+        const auto next_iv = TranscodeWithAESNI(*ctx, ctx->iv, src, size, dest, op);
+        if (next_iv != boost::none) {
+            ctx->iv = *next_iv;
+            return;
         }
     }
 
-    mbedtls_cipher_finish(context, nullptr, nullptr);
+    std::lock_guard<std::mutex> lock(ctx->mutex);
+    TranscodeWithMbedtls(*ctx, src, size, dest, op);
+}
+
+template <typename Key, size_t KeySize>
+void AESCipher<Key, KeySize>::TranscodeWithIV(const u8* src, size_t size, u8* dest, Op op,
+                                              const std::array<u8, 16>& iv) const {
+    if (ctx->use_aesni && TranscodeWithAESNI(*ctx, iv, src, size, dest, op) != boost::none) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(ctx->mutex);
+    SetMbedtlsIV(*ctx, iv.data(), iv.size());
+    TranscodeWithMbedtls(*ctx, src, size, dest, op);
 }
 
 template <typename Key, size_t KeySize>
 void AESCipher<Key, KeySize>::XTSTranscode(const u8* src, size_t size, u8* dest, size_t sector_id,
-                                           size_t sector_size, Op op) {
+                                           size_t sector_size, Op op) const {
     ASSERT_MSG(size % sector_size == 0, "XTS decryption size must be a multiple of sector size.");
 
+    if (ctx->use_aesni && sector_size % 16 == 0) {
+        const bool encrypt = op == Op::Encrypt;
+        if (size < PARALLEL_TRANSCODE_THRESHOLD || PARALLEL_TRANSCODE_CHUNK % sector_size != 0) {
+            AESNI::TranscodeXTS(ctx->data_schedule, ctx->tweak_schedule, src, size, dest,
+                                sector_id, sector_size, encrypt);
+            return;
+        }
+        // Sectors are independent of each other, so large reads are split across the pool
+        ParallelTranscode(size, [&](size_t offset, size_t length) {
+            AESNI::TranscodeXTS(ctx->data_schedule, ctx->tweak_schedule, src + offset, length,
+                                dest + offset, sector_id + offset / sector_size, sector_size,
+                                encrypt);
+        });
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(ctx->mutex);
     for (size_t i = 0; i < size; i += sector_size) {
-        SetIV(CalculateNintendoTweak(sector_id++));
-        Transcode<u8, u8>(src + i, sector_size, dest + i, op);
+        const auto tweak = CalculateNintendoTweak(sector_id++);
+        SetMbedtlsIV(*ctx, tweak.data(), tweak.size());
+        TranscodeWithMbedtls(*ctx, src + i, sector_size, dest + i, op);
     }
 }
 
@@ -4,6 +4,7 @@
 
 #pragma once
 
+#include <array>
 #include <memory>
 #include <type_traits>
 #include <vector>
@@ -35,7 +36,8 @@ public:
 
     ~AESCipher();
 
-    void SetIV(std::vector<u8> iv);
+    void SetIV(const std::vector<u8>& iv);
+    void SetIV(const u8* iv, size_t size);
 
     template <typename Source, typename Dest>
     void Transcode(const Source* src, size_t size, Dest* dest, Op op) const {
@@ -46,17 +48,26 @@ public:
 
     void Transcode(const u8* src, size_t size, u8* dest, Op op) const;
 
+    /**
+     * Transcodes starting from iv instead of the IV set with SetIV. Unlike a SetIV and Transcode
+     * pair, this can be called from several threads at once. It leaves the IV used by Transcode
+     * unspecified.
+     */
+    void TranscodeWithIV(const u8* src, size_t size, u8* dest, Op op,
+                         const std::array<u8, 16>& iv) const;
+
     template <typename Source, typename Dest>
     void XTSTranscode(const Source* src, size_t size, Dest* dest, size_t sector_id,
-                      size_t sector_size, Op op) {
+                      size_t sector_size, Op op) const {
         static_assert(std::is_trivially_copyable_v<Source> && std::is_trivially_copyable_v<Dest>,
                       "XTSTranscode source and destination types must be trivially copyable.");
         XTSTranscode(reinterpret_cast<const u8*>(src), size, reinterpret_cast<u8*>(dest), sector_id,
                      sector_size, op);
     }
 
+    // Safe to call from several threads at once, as every sector has its own tweak
     void XTSTranscode(const u8* src, size_t size, u8* dest, size_t sector_id, size_t sector_size,
-                      Op op);
+                      Op op) const;
 
 private:
     std::unique_ptr<CipherContext> ctx;
@@ -2,15 +2,17 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
+#include <array>
 #include <cstring>
 #include "common/assert.h"
+#include "common/swap.h"
 #include "core/crypto/ctr_encryption_layer.h"
 
 namespace Core::Crypto {
 
 CTREncryptionLayer::CTREncryptionLayer(FileSys::VirtualFile base_, Key128 key_, size_t base_offset)
-    : EncryptionLayer(std::move(base_)), base_offset(base_offset), cipher(key_, Mode::CTR),
-      iv(16, 0) {}
+    : EncryptionLayer(std::move(base_)), base_offset(base_offset), cipher(key_, Mode::CTR) {}
 
 size_t CTREncryptionLayer::Read(u8* data, size_t length, size_t offset) const {
     if (length == 0)
@@ -18,16 +20,17 @@ size_t CTREncryptionLayer::Read(u8* data, size_t length, size_t offset) const {
 
     const auto sector_offset = offset & 0xF;
     if (sector_offset == 0) {
-        UpdateIV(base_offset + offset);
-        std::vector<u8> raw = base->ReadBytes(length, offset);
-        cipher.Transcode(raw.data(), raw.size(), data, Op::Decrypt);
-        return raw.size();
+        // Decrypt in place, instead of reading into a temporary buffer first
+        const size_t read = base->Read(data, length, offset);
+        cipher.TranscodeWithIV(data, read, data, Op::Decrypt, GetCounter(base_offset + offset));
+        return read;
     }
 
     // offset does not fall on block boundary (0x10)
-    std::vector<u8> block = base->ReadBytes(0x10, offset - sector_offset);
-    UpdateIV(base_offset + offset - sector_offset);
-    cipher.Transcode(block.data(), block.size(), block.data(), Op::Decrypt);
+    std::array<u8, 0x10> block{};
+    base->Read(block.data(), block.size(), offset - sector_offset);
+    cipher.TranscodeWithIV(block.data(), block.size(), block.data(), Op::Decrypt,
+                           GetCounter(base_offset + offset - sector_offset));
     size_t read = 0x10 - sector_offset;
 
     if (length + sector_offset < 0x10) {
@@ -40,15 +43,14 @@ size_t CTREncryptionLayer::Read(u8* data, size_t length, size_t offset) const {
 
 void CTREncryptionLayer::SetIV(const std::vector<u8>& iv_) {
     const auto length = std::min(iv_.size(), iv.size());
-    iv.assign(iv_.cbegin(), iv_.cbegin() + length);
+    std::copy_n(iv_.cbegin(), length, iv.begin());
 }
 
-void CTREncryptionLayer::UpdateIV(size_t offset) const {
-    offset >>= 4;
-    for (size_t i = 0; i < 8; ++i) {
-        iv[16 - i - 1] = offset & 0xFF;
-        offset >>= 8;
-    }
-    cipher.SetIV(iv);
+std::array<u8, 16> CTREncryptionLayer::GetCounter(size_t offset) const {
+    // The low half of the counter is the big-endian block number
+    std::array<u8, 16> counter = iv;
+    const u64 block_number = Common::swap64(static_cast<u64>(offset >> 4));
+    std::memcpy(counter.data() + 8, &block_number, sizeof(u64));
+    return counter;
 }
 } // namespace Core::Crypto
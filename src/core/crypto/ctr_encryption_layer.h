@@ -4,6 +4,7 @@
 
 #pragma once
 
+#include <array>
 #include <vector>
 #include "core/crypto/aes_util.h"
 #include "core/crypto/encryption_layer.h"
@@ -11,7 +12,8 @@
 
 namespace Core::Crypto {
 
-// Sits on top of a VirtualFile and provides CTR-mode AES decription.
+// Sits on top of a VirtualFile and provides CTR-mode AES decription. Reads keep their counter to
+// themselves, so they can run from several threads at once once the IV is set.
 class CTREncryptionLayer : public EncryptionLayer {
 public:
     CTREncryptionLayer(FileSys::VirtualFile base, Key128 key, size_t base_offset);
@@ -23,11 +25,11 @@ public:
 private:
     size_t base_offset;
 
-    // Must be mutable as operations modify cipher contexts.
-    mutable AESCipher<Key128> cipher;
-    mutable std::vector<u8> iv;
+    AESCipher<Key128> cipher;
+    std::array<u8, 16> iv{};
 
-    void UpdateIV(size_t offset) const;
+    /// Returns the counter block for the block at offset
+    std::array<u8, 16> GetCounter(size_t offset) const;
 };
 
 } // namespace Core::Crypto
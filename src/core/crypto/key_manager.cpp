@@ -6,12 +6,18 @@
 #include <array>
 #include <fstream>
 #include <locale>
+#include <map>
+#include <mutex>
+#include <shared_mutex>
 #include <sstream>
 #include <string_view>
+#include <tuple>
+#include <unordered_map>
 #include "common/common_paths.h"
 #include "common/file_util.h"
 #include "common/hex_util.h"
 #include "common/logging/log.h"
+#include "core/boot_timeline.h"
 #include "core/crypto/aes_util.h"
 #include "core/crypto/key_manager.h"
 #include "core/settings.h"
@@ -118,24 +124,118 @@ Loader::ResultStatus DeriveSDKeys(std::array<Key256, 2>& sd_keys, const KeyManag
     return Loader::ResultStatus::Success;
 }
 
-KeyManager::KeyManager() {
-    // Initialize keys
+namespace {
+/// A key file as found on disk when the keys were loaded
+struct KeyFile {
+    std::string name;
+    bool title;
+    /// Path the file was loaded from, empty if it didn't exist
+    std::string path;
+    u64 size;
+
+    bool operator==(const KeyFile& other) const {
+        return std::tie(name, title, path, size) ==
+               std::tie(other.name, other.title, other.path, other.size);
+    }
+};
+
+KeyFile FindKeyFile(const std::string& dir1, const std::string& dir2, const std::string& name,
+                    bool title) {
+    for (const auto& dir : {dir1, dir2}) {
+        const std::string path = dir + DIR_SEP + name;
+        if (FileUtil::Exists(path))
+            return {name, title, path, FileUtil::GetSize(path)};
+    }
+    return {name, title, "", 0};
+}
+
+std::vector<KeyFile> FindKeyFiles(bool dev_mode) {
     const std::string hactool_keys_dir = FileUtil::GetHactoolConfigurationPath();
     const std::string yuzu_keys_dir = FileUtil::GetUserPath(FileUtil::UserPath::KeysDir);
-    if (Settings::values.use_dev_keys) {
-        dev_mode = true;
-        AttemptLoadKeyFile(yuzu_keys_dir, hactool_keys_dir, "dev.keys", false);
-        AttemptLoadKeyFile(yuzu_keys_dir, yuzu_keys_dir, "dev.keys_autogenerated", false);
-    } else {
-        dev_mode = false;
-        AttemptLoadKeyFile(yuzu_keys_dir, hactool_keys_dir, "prod.keys", false);
-        AttemptLoadKeyFile(yuzu_keys_dir, yuzu_keys_dir, "prod.keys_autogenerated", false);
+    const std::string prefix = dev_mode ? "dev" : "prod";
+    return {
+        FindKeyFile(yuzu_keys_dir, hactool_keys_dir, prefix + ".keys", false),
+        FindKeyFile(yuzu_keys_dir, yuzu_keys_dir, prefix + ".keys_autogenerated", false),
+        FindKeyFile(yuzu_keys_dir, hactool_keys_dir, "title.keys", true),
+        FindKeyFile(yuzu_keys_dir, yuzu_keys_dir, "title.keys_autogenerated", true),
+    };
+}
+
+/// Rights IDs are random, so their halves need no further mixing
+struct RightsIDHash {
+    size_t operator()(const u128& rights_id) const {
+        return static_cast<size_t>(rights_id[0] ^ rights_id[1]);
+    }
+};
+} // Anonymous namespace
+
+struct KeyManager::KeyStore {
+    /// Guards everything below, as every KeyManager on every thread shares the store
+    mutable std::shared_mutex mutex;
+
+    boost::container::flat_map<KeyIndex<S128KeyType>, Key128> s128_keys;
+    boost::container::flat_map<KeyIndex<S256KeyType>, Key256> s256_keys;
+
+    // Titlekeys are kept apart from the other keys by rights ID. There can be thousands of them,
+    // which inserting into the sorted s128_keys one by one made quadratic to load.
+    std::unordered_map<u128, Key128, RightsIDHash> titlekeys;
+
+    /// Returns the 128-bit key of the index, or nullptr if there is none. mutex must be held.
+    const Key128* FindKey(S128KeyType id, u64 field1, u64 field2) const {
+        if (id == S128KeyType::Titlekey) {
+            const auto iter = titlekeys.find({field2, field1});
+            return iter == titlekeys.end() ? nullptr : &iter->second;
+        }
+        const auto iter = s128_keys.find({id, field1, field2});
+        return iter == s128_keys.end() ? nullptr : &iter->second;
+    }
+
+    /// Adds or replaces the 128-bit key of the index. mutex must be held exclusively.
+    void StoreKey(S128KeyType id, u64 field1, u64 field2, const Key128& key) {
+        if (id == S128KeyType::Titlekey)
+            titlekeys[{field2, field1}] = key;
+        else
+            s128_keys[{id, field1, field2}] = key;
+    }
+
+    /// The key files the keys came from, to notice when they change on disk
+    std::vector<KeyFile> key_files;
+
+    // Keys derived from the ones above. They are only kept in memory: writing decrypted titlekeys
+    // and key areas to disk would leave them readable by anything with access to the user's files.
+    std::map<std::tuple<u64, u64, std::array<u8, 0x40>>, std::array<u8, 0x40>> key_areas;
+    std::map<std::tuple<u64, u64, u64>, Key128> decrypted_titlekeys;
+};
+
+KeyManager::KeyManager() : dev_mode(Settings::values.use_dev_keys) {
+    static std::mutex stores_mutex;
+    static std::array<std::shared_ptr<KeyStore>, 2> stores;
+
+    auto key_files = FindKeyFiles(dev_mode);
+
+    std::lock_guard<std::mutex> lock(stores_mutex);
+    auto& shared = stores[dev_mode ? 1 : 0];
+    if (shared != nullptr) {
+        std::shared_lock<std::shared_mutex> store_lock(shared->mutex);
+        if (shared->key_files == key_files) {
+            store = shared;
+            return;
+        }
     }
 
-    AttemptLoadKeyFile(yuzu_keys_dir, hactool_keys_dir, "title.keys", true);
-    AttemptLoadKeyFile(yuzu_keys_dir, yuzu_keys_dir, "title.keys_autogenerated", true);
+    // First KeyManager, or the key files were changed since they were parsed
+    Core::ScopedBootPhase phase("Load keys");
+    store = std::make_shared<KeyStore>();
+    for (const auto& key_file : key_files) {
+        if (!key_file.path.empty())
+            LoadFromFile(key_file.path, key_file.title);
+    }
+    store->key_files = std::move(key_files);
+    shared = store;
 }
 
+KeyManager::~KeyManager() = default;
+
 void KeyManager::LoadFromFile(const std::string& filename, bool is_title_keys) {
     std::ifstream file(filename);
     if (!file.is_open())
@@ -160,48 +260,91 @@ void KeyManager::LoadFromFile(const std::string& filename, bool is_title_keys) {
             u128 rights_id{};
             std::memcpy(rights_id.data(), rights_id_raw.data(), rights_id_raw.size());
             Key128 key = Common::HexStringToArray<16>(out[1]);
-            s128_keys[{S128KeyType::Titlekey, rights_id[1], rights_id[0]}] = key;
+            store->titlekeys[rights_id] = key;
         } else {
             std::transform(out[0].begin(), out[0].end(), out[0].begin(), ::tolower);
             if (s128_file_id.find(out[0]) != s128_file_id.end()) {
                 const auto index = s128_file_id.at(out[0]);
                 Key128 key = Common::HexStringToArray<16>(out[1]);
-                s128_keys[{index.type, index.field1, index.field2}] = key;
+                store->s128_keys[{index.type, index.field1, index.field2}] = key;
             } else if (s256_file_id.find(out[0]) != s256_file_id.end()) {
                 const auto index = s256_file_id.at(out[0]);
                 Key256 key = Common::HexStringToArray<32>(out[1]);
-                s256_keys[{index.type, index.field1, index.field2}] = key;
+                store->s256_keys[{index.type, index.field1, index.field2}] = key;
             }
         }
     }
 }
 
-void KeyManager::AttemptLoadKeyFile(const std::string& dir1, const std::string& dir2,
-                                    const std::string& filename, bool title) {
-    if (FileUtil::Exists(dir1 + DIR_SEP + filename))
-        LoadFromFile(dir1 + DIR_SEP + filename, title);
-    else if (FileUtil::Exists(dir2 + DIR_SEP + filename))
-        LoadFromFile(dir2 + DIR_SEP + filename, title);
-}
-
 bool KeyManager::HasKey(S128KeyType id, u64 field1, u64 field2) const {
-    return s128_keys.find({id, field1, field2}) != s128_keys.end();
+    std::shared_lock<std::shared_mutex> lock(store->mutex);
+    return store->FindKey(id, field1, field2) != nullptr;
 }
 
 bool KeyManager::HasKey(S256KeyType id, u64 field1, u64 field2) const {
-    return s256_keys.find({id, field1, field2}) != s256_keys.end();
+    std::shared_lock<std::shared_mutex> lock(store->mutex);
+    return store->s256_keys.find({id, field1, field2}) != store->s256_keys.end();
 }
 
 Key128 KeyManager::GetKey(S128KeyType id, u64 field1, u64 field2) const {
-    if (!HasKey(id, field1, field2))
+    std::shared_lock<std::shared_mutex> lock(store->mutex);
+    const Key128* key = store->FindKey(id, field1, field2);
+    if (key == nullptr)
         return {};
-    return s128_keys.at({id, field1, field2});
+    return *key;
 }
 
 Key256 KeyManager::GetKey(S256KeyType id, u64 field1, u64 field2) const {
-    if (!HasKey(id, field1, field2))
+    std::shared_lock<std::shared_mutex> lock(store->mutex);
+    const auto iter = store->s256_keys.find({id, field1, field2});
+    if (iter == store->s256_keys.end())
         return {};
-    return s256_keys.at({id, field1, field2});
+    return iter->second;
+}
+
+boost::optional<std::array<u8, 0x40>> KeyManager::DecryptKeyArea(
+    const std::array<u8, 0x40>& key_area, u64 crypto_revision, u64 key_index) const {
+    const auto cache_key = std::make_tuple(crypto_revision, key_index, key_area);
+    {
+        std::shared_lock<std::shared_mutex> lock(store->mutex);
+        const auto iter = store->key_areas.find(cache_key);
+        if (iter != store->key_areas.end())
+            return iter->second;
+    }
+
+    if (!HasKey(S128KeyType::KeyArea, crypto_revision, key_index))
+        return boost::none;
+
+    std::array<u8, 0x40> out = key_area;
+    AESCipher<Key128> cipher(GetKey(S128KeyType::KeyArea, crypto_revision, key_index), Mode::ECB);
+    cipher.Transcode(out.data(), out.size(), out.data(), Op::Decrypt);
+
+    std::unique_lock<std::shared_mutex> lock(store->mutex);
+    store->key_areas.emplace(cache_key, out);
+    return out;
+}
+
+boost::optional<Key128> KeyManager::DecryptTitlekey(const u128& rights_id,
+                                                    u64 crypto_revision) const {
+    const auto cache_key = std::make_tuple(rights_id[1], rights_id[0], crypto_revision);
+    {
+        std::shared_lock<std::shared_mutex> lock(store->mutex);
+        const auto iter = store->decrypted_titlekeys.find(cache_key);
+        if (iter != store->decrypted_titlekeys.end())
+            return iter->second;
+    }
+
+    if (!HasKey(S128KeyType::Titlekey, rights_id[1], rights_id[0]) ||
+        !HasKey(S128KeyType::Titlekek, crypto_revision))
+        return boost::none;
+
+    Key128 out = GetKey(S128KeyType::Titlekey, rights_id[1], rights_id[0]);
+    AESCipher<Key128> cipher(GetKey(S128KeyType::Titlekek, crypto_revision), Mode::ECB);
+    cipher.Transcode(out.data(), out.size(), out.data(), Op::Decrypt);
+
+    std::unique_lock<std::shared_mutex> lock(store->mutex);
+    store->decrypted_titlekeys.emplace(cache_key, out);
+    return out;
 }
 
 template <size_t Size>
@@ -224,11 +367,23 @@ void KeyManager::WriteKeyToFile(bool title_key, std::string_view keyname,
     }
 
     file << fmt::format("\n{} = {}", keyname, Common::HexArrayToString(key));
-    AttemptLoadKeyFile(yuzu_keys_dir, yuzu_keys_dir, filename, title_key);
+    file.close();
+
+    // The key is added to the store by the caller, so instead of parsing the file again just
+    // remember its new size, for it not to look changed to the next KeyManager
+    const auto iter = std::find_if(store->key_files.begin(), store->key_files.end(),
+                                   [&filename](const KeyFile& key_file) {
+                                       return key_file.name == filename;
+                                   });
+    if (iter != store->key_files.end()) {
+        iter->path = yuzu_keys_dir + DIR_SEP + filename;
+        iter->size = FileUtil::GetSize(iter->path);
+    }
 }
 
 void KeyManager::SetKey(S128KeyType id, Key128 key, u64 field1, u64 field2) {
-    if (s128_keys.find({id, field1, field2}) != s128_keys.end())
+    std::unique_lock<std::shared_mutex> lock(store->mutex);
+    if (store->FindKey(id, field1, field2) != nullptr)
         return;
     if (id == S128KeyType::Titlekey) {
         Key128 rights_id;
@@ -244,11 +399,12 @@ void KeyManager::SetKey(S128KeyType id, Key128 key, u64 field1, u64 field2) {
         });
     if (iter2 != s128_file_id.end())
         WriteKeyToFile(false, iter2->first, key);
-    s128_keys[{id, field1, field2}] = key;
+    store->StoreKey(id, field1, field2, key);
 }
 
 void KeyManager::SetKey(S256KeyType id, Key256 key, u64 field1, u64 field2) {
-    if (s256_keys.find({id, field1, field2}) != s256_keys.end())
+    std::unique_lock<std::shared_mutex> lock(store->mutex);
+    if (store->s256_keys.find({id, field1, field2}) != store->s256_keys.end())
         return;
     const auto iter = std::find_if(
         s256_file_id.begin(), s256_file_id.end(),
@@ -258,7 +414,7 @@ void KeyManager::SetKey(S256KeyType id, Key256 key, u64 field1, u64 field2) {
         });
     if (iter != s256_file_id.end())
         WriteKeyToFile(false, iter->first, key);
-    s256_keys[{id, field1, field2}] = key;
+    store->s256_keys[{id, field1, field2}] = key;
 }
 
 bool KeyManager::KeyFileExists(bool title) {
@@ -5,6 +5,7 @@
 #pragma once
 
 #include <array>
+#include <memory>
 #include <string>
 #include <string_view>
 #include <type_traits>
@@ -80,9 +81,15 @@ bool operator<(const KeyIndex<KeyType>& lhs, const KeyIndex<KeyType>& rhs) {
     return std::tie(lhs.type, lhs.field1, lhs.field2) < std::tie(rhs.type, rhs.field1, rhs.field2);
 }
 
+/**
+ * Gives access to the keys in the key files. The files are parsed once, by the first KeyManager
+ * created, and then shared with all the others until they change on disk. Keys derived from them
+ * are shared as well. Thread-safe.
+ */
 class KeyManager {
 public:
     KeyManager();
+    ~KeyManager();
 
     bool HasKey(S128KeyType id, u64 field1 = 0, u64 field2 = 0) const;
     bool HasKey(S256KeyType id, u64 field1 = 0, u64 field2 = 0) const;
@@ -99,14 +106,29 @@ public:
     // 8*43 and the private file to exist.
     void DeriveSDSeedLazy();
 
+    /**
+     * Decrypts the key area of an NCA with the key area key of the given crypto revision and type.
+     * Results are kept, so an NCA opened again doesn't need its key area decrypted again.
+     * @return The decrypted key area, or none if the key area key is missing
+     */
+    boost::optional<std::array<u8, 0x40>> DecryptKeyArea(const std::array<u8, 0x40>& key_area,
+                                                         u64 crypto_revision, u64 key_index) const;
+
+    /**
+     * Decrypts the titlekey of rights_id with the titlekek of the given crypto revision. Results
+     * are kept like with DecryptKeyArea, shared by all the NCAs of a title.
+     * @return The decrypted titlekey, or none if the titlekey or titlekek is missing
+     */
+    boost::optional<Key128> DecryptTitlekey(const u128& rights_id, u64 crypto_revision) const;
+
 private:
-    boost::container::flat_map<KeyIndex<S128KeyType>, Key128> s128_keys;
-    boost::container::flat_map<KeyIndex<S256KeyType>, Key256> s256_keys;
+    struct KeyStore;
+
+    /// Shared by every KeyManager using the same key files
+    std::shared_ptr<KeyStore> store;
 
     bool dev_mode;
     void LoadFromFile(const std::string& filename, bool is_title_keys);
-    void AttemptLoadKeyFile(const std::string& dir1, const std::string& dir2,
-                            const std::string& filename, bool title);
     template <size_t Size>
     void WriteKeyToFile(bool title_key, std::string_view keyname, const std::array<u8, Size>& key);
 
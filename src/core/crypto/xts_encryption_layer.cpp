@@ -3,6 +3,7 @@
 // Refer to the license.txt file included.
 
 #include <algorithm>
+#include <array>
 #include <cstring>
 #include "common/assert.h"
 #include "core/crypto/xts_encryption_layer.h"
@@ -18,41 +19,64 @@ size_t XTSEncryptionLayer::Read(u8* data, size_t length, size_t offset) const {
     if (length == 0)
         return 0;
 
-    const auto sector_offset = offset & 0x3FFF;
-    if (sector_offset == 0) {
-        if (length % XTS_SECTOR_SIZE == 0) {
-            std::vector<u8> raw = base->ReadBytes(length, offset);
-            cipher.XTSTranscode(raw.data(), raw.size(), data, offset / XTS_SECTOR_SIZE,
+    size_t total = 0;
+
+    // Head of the read, until the next sector boundary
+    const size_t sector_offset = offset % XTS_SECTOR_SIZE;
+    if (sector_offset != 0) {
+        const size_t head = std::min<size_t>(length, XTS_SECTOR_SIZE - sector_offset);
+        const size_t read = ReadPartialSector(data, head, offset / XTS_SECTOR_SIZE, sector_offset);
+        if (read != head)
+            return read;
+        data += read;
+        length -= read;
+        offset += read;
+        total += read;
+    }
+
+    // Whole sectors are read straight into the caller's buffer and decrypted in place
+    const size_t whole = length - length % XTS_SECTOR_SIZE;
+    if (whole != 0) {
+        const size_t read = base->Read(data, whole, offset);
+        const size_t read_whole = read - read % XTS_SECTOR_SIZE;
+        if (read_whole != 0) {
+            cipher.XTSTranscode(data, read_whole, data, offset / XTS_SECTOR_SIZE,
                                 XTS_SECTOR_SIZE, Op::Decrypt);
-            return raw.size();
         }
-        if (length > XTS_SECTOR_SIZE) {
-            const auto rem = length % XTS_SECTOR_SIZE;
-            const auto read = length - rem;
-            return Read(data, read, offset) + Read(data + read, rem, offset + read);
+        total += read_whole;
+        if (read != whole) {
+            // The file ends inside this sector, which can only be decrypted whole
+            return total + ReadPartialSector(data + read_whole, read - read_whole,
+                                             (offset + read_whole) / XTS_SECTOR_SIZE, 0);
         }
-        std::vector<u8> buffer = base->ReadBytes(XTS_SECTOR_SIZE, offset);
-        if (buffer.size() < XTS_SECTOR_SIZE)
-            buffer.resize(XTS_SECTOR_SIZE);
-        cipher.XTSTranscode(buffer.data(), buffer.size(), buffer.data(), offset / XTS_SECTOR_SIZE,
-                            XTS_SECTOR_SIZE, Op::Decrypt);
-        std::memcpy(data, buffer.data(), std::min(buffer.size(), length));
-        return std::min(buffer.size(), length);
+        data += whole;
+        length -= whole;
+        offset += whole;
     }
 
-    // offset does not fall on block boundary (0x4000)
-    std::vector<u8> block = base->ReadBytes(0x4000, offset - sector_offset);
-    if (block.size() < XTS_SECTOR_SIZE)
-        block.resize(XTS_SECTOR_SIZE);
-    cipher.XTSTranscode(block.data(), block.size(), block.data(),
-                        (offset - sector_offset) / XTS_SECTOR_SIZE, XTS_SECTOR_SIZE, Op::Decrypt);
-    const size_t read = XTS_SECTOR_SIZE - sector_offset;
-
-    if (length + sector_offset < XTS_SECTOR_SIZE) {
-        std::memcpy(data, block.data() + sector_offset, std::min<u64>(length, read));
-        return std::min<u64>(length, read);
-    }
-    std::memcpy(data, block.data() + sector_offset, read);
-    return read + Read(data + read, length - read, offset + read);
+    // Tail of the read, in the last sector
+    if (length != 0)
+        total += ReadPartialSector(data, length, offset / XTS_SECTOR_SIZE, 0);
+    return total;
 }
+
+size_t XTSEncryptionLayer::ReadPartialSector(u8* data, size_t length, size_t sector,
+                                             size_t sector_offset) const {
+    // Reused by every partial read on this thread, instead of allocating a sector each time
+    static thread_local std::array<u8, XTS_SECTOR_SIZE> scratch;
+
+    const size_t read = base->Read(scratch.data(), scratch.size(), sector * XTS_SECTOR_SIZE);
+    if (read <= sector_offset)
+        return 0;
+
+    // A sector cut short by the end of the file is decrypted as if padded with zeroes
+    std::fill(scratch.begin() + read, scratch.end(), 0);
+    cipher.XTSTranscode(scratch.data(), scratch.size(), scratch.data(), sector, XTS_SECTOR_SIZE,
+                        Op::Decrypt);
+
+    const size_t out = std::min(length, read - sector_offset);
+    std::memcpy(data, scratch.data() + sector_offset, out);
+    return out;
+}
+
 } // namespace Core::Crypto
@@ -10,7 +10,8 @@
 
 namespace Core::Crypto {
 
-// Sits on top of a VirtualFile and provides XTS-mode AES decription.
+// Sits on top of a VirtualFile and provides XTS-mode AES decription. Every sector is decrypted
+// with its own tweak, so reads can run from several threads at once.
 class XTSEncryptionLayer : public EncryptionLayer {
 public:
     XTSEncryptionLayer(FileSys::VirtualFile base, Key256 key);
@@ -18,8 +19,10 @@ public:
     size_t Read(u8* data, size_t length, size_t offset) const override;
 
 private:
-    // Must be mutable as operations modify cipher contexts.
-    mutable AESCipher<Key256> cipher;
+    /// Reads length bytes from sector_offset into the given sector, which is decrypted whole
+    size_t ReadPartialSector(u8* data, size_t length, size_t sector, size_t sector_offset) const;
+
+    AESCipher<Key256> cipher;
 };
 
 } // namespace Core::Crypto
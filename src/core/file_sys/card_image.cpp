@@ -167,10 +167,13 @@ Loader::ResultStatus XCI::AddNCAFromPartition(XCIPartition part) {
         return Loader::ResultStatus::ErrorXCIMissingPartition;
     }
 
+    std::vector<VirtualFile> nca_files;
     for (const VirtualFile& file : partitions[static_cast<size_t>(part)]->GetFiles()) {
-        if (file->GetExtension() != "nca")
-            continue;
-        auto nca = std::make_shared<NCA>(file);
+        if (file->GetExtension() == "nca")
+            nca_files.push_back(file);
+    }
+
+    for (auto& nca : ParseNCAs(nca_files)) {
         // TODO(DarkLordZach): Add proper Rev1+ Support
         if (nca->IsUpdate())
             continue;
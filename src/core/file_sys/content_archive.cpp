@@ -6,12 +6,17 @@
 #include <utility>
 #include <boost/optional.hpp>
 #include "common/logging/log.h"
+#include "core/boot_timeline.h"
 #include "core/crypto/aes_util.h"
 #include "core/crypto/ctr_encryption_layer.h"
 #include "core/file_sys/content_archive.h"
 #include "core/file_sys/romfs.h"
+#include "core/file_sys/vfs_cached.h"
 #include "core/file_sys/vfs_offset.h"
+#include "core/file_sys/vfs_vector.h"
+#include "core/file_sys/vfs_verified.h"
 #include "core/loader/loader.h"
+#include "core/settings.h"
 
 namespace FileSys {
 
@@ -22,6 +27,8 @@ constexpr u64 SECTION_HEADER_SIZE = 0x200;
 constexpr u64 SECTION_HEADER_OFFSET = 0x400;
 
 constexpr u32 IVFC_MAX_LEVEL = 6;
+/// The hash of the first IVFC level follows the level descriptors in the header
+constexpr size_t IVFC_MASTER_HASH_OFFSET = 0xC0;
 
 enum class NCASectionFilesystemType : u8 {
     PFS0 = 0x2,
@@ -88,20 +95,15 @@ u8 NCA::GetCryptoRevision() const {
 boost::optional<Core::Crypto::Key128> NCA::GetKeyAreaKey(NCASectionCryptoType type) const {
     const auto master_key_id = GetCryptoRevision();
 
-    if (!keys.HasKey(Core::Crypto::S128KeyType::KeyArea, master_key_id, header.key_index))
+    const auto key_area = keys.DecryptKeyArea(header.key_area, master_key_id, header.key_index);
+    if (key_area == boost::none)
         return boost::none;
 
-    std::vector<u8> key_area(header.key_area.begin(), header.key_area.end());
-    Core::Crypto::AESCipher<Core::Crypto::Key128> cipher(
-        keys.GetKey(Core::Crypto::S128KeyType::KeyArea, master_key_id, header.key_index),
-        Core::Crypto::Mode::ECB);
-    cipher.Transcode(key_area.data(), key_area.size(), key_area.data(), Core::Crypto::Op::Decrypt);
-
     Core::Crypto::Key128 out;
     if (type == NCASectionCryptoType::XTS)
-        std::copy(key_area.begin(), key_area.begin() + 0x10, out.begin());
+        std::copy(key_area->begin(), key_area->begin() + 0x10, out.begin());
     else if (type == NCASectionCryptoType::CTR)
-        std::copy(key_area.begin() + 0x20, key_area.begin() + 0x30, out.begin());
+        std::copy(key_area->begin() + 0x20, key_area->begin() + 0x30, out.begin());
     else
         LOG_CRITICAL(Crypto, "Called GetKeyAreaKey on invalid NCASectionCryptoType type={:02X}",
                      static_cast<u8>(type));
@@ -123,8 +125,8 @@ boost::optional<Core::Crypto::Key128> NCA::GetTitlekey() {
         return boost::none;
     }
 
-    auto titlekey = keys.GetKey(Core::Crypto::S128KeyType::Titlekey, rights_id[1], rights_id[0]);
-    if (titlekey == Core::Crypto::Key128{}) {
+    if (keys.GetKey(Core::Crypto::S128KeyType::Titlekey, rights_id[1], rights_id[0]) ==
+        Core::Crypto::Key128{}) {
         status = Loader::ResultStatus::ErrorMissingTitlekey;
         return boost::none;
     }
@@ -134,11 +136,7 @@ boost::optional<Core::Crypto::Key128> NCA::GetTitlekey() {
         return boost::none;
     }
 
-    Core::Crypto::AESCipher<Core::Crypto::Key128> cipher(
-        keys.GetKey(Core::Crypto::S128KeyType::Titlekek, master_key_id), Core::Crypto::Mode::ECB);
-    cipher.Transcode(titlekey.data(), titlekey.size(), titlekey.data(), Core::Crypto::Op::Decrypt);
-
-    return titlekey;
+    return keys.DecryptTitlekey(rights_id, master_key_id);
 }
 
 VirtualFile NCA::Decrypt(NCASectionHeader s_header, VirtualFile in, u64 starting_offset) {
@@ -175,7 +173,8 @@ VirtualFile NCA::Decrypt(NCASectionHeader s_header, VirtualFile in, u64 starting
             for (u8 i = 0; i < 8; ++i)
                 iv[i] = s_header.raw.section_ctr[0x8 - i - 1];
             out->SetIV(iv);
-            return std::static_pointer_cast<VfsFile>(out);
+            // Only decrypt each block once, no matter how often the game reads it
+            return CreateDecryptedCache(std::move(out));
         }
     case NCASectionCryptoType::XTS:
         // TODO(DarkLordZach): Find a test case for XTS-encrypted NCAs
@@ -186,7 +185,65 @@ VirtualFile NCA::Decrypt(NCASectionHeader s_header, VirtualFile in, u64 starting
     }
 }
 
+VirtualFile NCA::VerifyRomFS(const NCASectionHeader& section, u64 section_offset,
+                             VirtualFile data) {
+    const auto& ivfc = section.romfs.ivfc;
+    if (ivfc.magic != Common::MakeMagic('I', 'V', 'F', 'C')) {
+        LOG_WARNING(Loader, "RomFS section of {} has no IVFC tree, it cannot be verified",
+                    file->GetName());
+        return data;
+    }
+
+    std::vector<u8> master_hash(sizeof(Core::Crypto::SHA256Hash));
+    std::memcpy(master_hash.data(), reinterpret_cast<const u8*>(&ivfc) + IVFC_MASTER_HASH_OFFSET,
+                master_hash.size());
+    VirtualFile hashes = std::make_shared<VectorVfsFile>(std::move(master_hash));
+
+    // Every level holds the hashes of the blocks of the level below, the last one is the RomFS
+    for (u32 level = 0; level < IVFC_MAX_LEVEL - 1; ++level) {
+        const auto& descriptor = ivfc.levels[level];
+        const u64 offset = section_offset + descriptor.offset;
+        auto level_file = Decrypt(
+            section, std::make_shared<OffsetVfsFile>(file, descriptor.size, offset), offset);
+        if (level_file == nullptr)
+            return nullptr;
+        hashes = std::make_shared<HashVerifiedVfsFile>(std::move(level_file), std::move(hashes),
+                                                       size_t{1} << descriptor.block_size, true);
+    }
+
+    return std::make_shared<HashVerifiedVfsFile>(
+        std::move(data), std::move(hashes), size_t{1} << ivfc.levels[IVFC_MAX_LEVEL - 1].block_size,
+        true);
+}
+
+VirtualFile NCA::VerifyPFS0(const NCASectionHeader& section, u64 section_offset,
+                            VirtualFile data) {
+    const auto& pfs0 = section.pfs0;
+    if (pfs0.size == 0 || pfs0.hash_table_size == 0) {
+        LOG_WARNING(Loader, "PFS0 section of {} has no hash table, it cannot be verified",
+                    file->GetName());
+        return data;
+    }
+
+    const u64 offset = section_offset + pfs0.hash_table_offset;
+    auto hash_table = Decrypt(
+        section, std::make_shared<OffsetVfsFile>(file, pfs0.hash_table_size, offset), offset);
+    if (hash_table == nullptr)
+        return nullptr;
+
+    // The hash in the superblock covers the whole hash table as a single block
+    const std::vector<u8> master_hash(pfs0.hash.begin(), pfs0.hash.end());
+    hash_table = std::make_shared<HashVerifiedVfsFile>(
+        std::move(hash_table), std::make_shared<VectorVfsFile>(master_hash),
+        pfs0.hash_table_size, false);
+
+    return std::make_shared<HashVerifiedVfsFile>(
+        std::make_shared<OffsetVfsFile>(std::move(data), pfs0.pfs0_size), std::move(hash_table),
+        pfs0.size, false);
+}
+
 NCA::NCA(VirtualFile file_) : file(std::move(file_)) {
+    Core::ScopedBootPhase phase("Parse NCA");
     status = Loader::ResultStatus::Success;
 
     if (file == nullptr) {
@@ -264,6 +321,7 @@ NCA::NCA(VirtualFile file_) : file(std::move(file_)) {
 
     for (std::ptrdiff_t i = 0; i < number_sections; ++i) {
         auto section = sections[i];
+        const u64 section_offset = header.section_tables[i].media_offset * MEDIA_OFFSET_MULTIPLIER;
 
         if (section.raw.header.filesystem_type == NCASectionFilesystemType::ROMFS) {
             const size_t romfs_offset =
@@ -273,6 +331,8 @@ NCA::NCA(VirtualFile file_) : file(std::move(file_)) {
             auto dec =
                 Decrypt(section, std::make_shared<OffsetVfsFile>(file, romfs_size, romfs_offset),
                         romfs_offset);
+            if (dec != nullptr && Settings::values.verify_nca_hashes)
+                dec = VerifyRomFS(section, section_offset, std::move(dec));
             if (dec != nullptr) {
                 files.push_back(std::move(dec));
                 romfs = files.back();
@@ -293,6 +353,8 @@ NCA::NCA(VirtualFile file_) : file(std::move(file_)) {
                                                   header.section_tables[i].media_offset);
             auto dec =
                 Decrypt(section, std::make_shared<OffsetVfsFile>(file, size, offset), offset);
+            if (dec != nullptr && Settings::values.verify_nca_hashes)
+                dec = VerifyPFS0(section, section_offset, std::move(dec));
             if (dec != nullptr) {
                 auto npfs = std::make_shared<PartitionFilesystem>(std::move(dec));
 
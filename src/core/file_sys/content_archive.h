@@ -103,6 +103,8 @@ private:
     boost::optional<Core::Crypto::Key128> GetKeyAreaKey(NCASectionCryptoType type) const;
     boost::optional<Core::Crypto::Key128> GetTitlekey();
     VirtualFile Decrypt(NCASectionHeader header, VirtualFile in, u64 starting_offset);
+    VirtualFile VerifyRomFS(const NCASectionHeader& section, u64 section_offset, VirtualFile data);
+    VirtualFile VerifyPFS0(const NCASectionHeader& section, u64 section_offset, VirtualFile data);
 
     std::vector<VirtualDir> dirs;
     std::vector<VirtualFile> files;
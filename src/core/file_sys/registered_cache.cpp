@@ -2,18 +2,47 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <cstring>
 #include <regex>
 #include <mbedtls/sha256.h>
 #include "common/assert.h"
+#include "common/common_funcs.h"
 #include "common/hex_util.h"
 #include "common/logging/log.h"
+#include "common/thread_pool.h"
 #include "core/crypto/encryption_layer.h"
 #include "core/file_sys/card_image.h"
 #include "core/file_sys/nca_metadata.h"
 #include "core/file_sys/registered_cache.h"
 #include "core/file_sys/vfs_concat.h"
+#include "core/file_sys/vfs_vector.h"
 
 namespace FileSys {
+
+// Name of the index of parsed NCAs, stored in the root of the cache next to yuzu_meta
+constexpr char INDEX_FILE_NAME[] = "yuzu_index.bin";
+constexpr u32 INDEX_MAGIC = Common::MakeMagic('Y', 'R', 'C', 'I');
+constexpr u32 INDEX_VERSION = 1;
+
+struct IndexHeader {
+    u32_le magic;
+    u32_le version;
+    u32_le entry_count;
+    INSERT_PADDING_WORDS(1);
+};
+static_assert(sizeof(IndexHeader) == 0x10, "IndexHeader has incorrect size.");
+
+// Followed by cnmt_size bytes of CNMT
+struct IndexEntryHeader {
+    NcaID nca_id;
+    u64_le size;
+    u64_le title_id;
+    u32_le cnmt_size;
+    u8 is_meta;
+    INSERT_PADDING_BYTES(3);
+};
+static_assert(sizeof(IndexEntryHeader) == 0x28, "IndexEntryHeader has incorrect size.");
+
 std::string RegisteredCacheEntry::DebugInfo() const {
     return fmt::format("title_id={:016X}, content_type={:02X}", title_id, static_cast<u8>(type));
 }
@@ -203,27 +232,121 @@ std::vector<NcaID> RegisteredCache::AccumulateFiles() const {
 }
 
 void RegisteredCache::ProcessFiles(const std::vector<NcaID>& ids) {
+    // Opening the files walks the directories of dir, which is not thread-safe, so only the
+    // parsing of NCAs missing from the index is spread across the thread pool.
+    std::vector<std::pair<NcaID, VirtualFile>> to_parse;
+    std::map<NcaID, IndexEntry> new_index;
     for (const auto& id : ids) {
         const auto file = GetFileAtID(id);
-
         if (file == nullptr)
             continue;
-        const auto nca = std::make_shared<NCA>(parser(file, id));
-        if (nca->GetStatus() != Loader::ResultStatus::Success ||
-            nca->GetType() != NCAContentType::Meta) {
+
+        const auto iter = index.find(id);
+        if (iter != index.end() && iter->second.size == file->GetSize()) {
+            new_index.insert(*iter);
             continue;
         }
 
-        const auto section0 = nca->GetSubdirectories()[0];
+        to_parse.emplace_back(id, file);
+    }
+
+    std::vector<boost::optional<IndexEntry>> parsed(to_parse.size());
+    Common::GetSharedThreadPool().ParallelFor(to_parse.size(), [&](size_t i) {
+        const auto& [id, file] = to_parse[i];
+        const auto nca = std::make_shared<NCA>(parser(file, id));
+        // Failures may be down to missing keys, so they are not remembered
+        if (nca->GetStatus() != Loader::ResultStatus::Success)
+            return;
+
+        IndexEntry entry{file->GetSize(), false, nca->GetTitleId(), {}};
+        if (nca->GetType() == NCAContentType::Meta && !nca->GetSubdirectories().empty()) {
+            const auto section0 = nca->GetSubdirectories()[0];
+            for (const auto& cnmt_file : section0->GetFiles()) {
+                if (cnmt_file->GetExtension() != "cnmt")
+                    continue;
+
+                entry.is_meta = true;
+                entry.cnmt = cnmt_file->ReadAllBytes();
+                break;
+            }
+        }
+        parsed[i] = std::move(entry);
+    });
 
-        for (const auto& file : section0->GetFiles()) {
-            if (file->GetExtension() != "cnmt")
-                continue;
+    for (size_t i = 0; i < to_parse.size(); ++i) {
+        if (parsed[i] != boost::none)
+            new_index.insert_or_assign(to_parse[i].first, std::move(parsed[i].get()));
+    }
+
+    const bool index_changed = new_index.size() != index.size() ||
+                               std::any_of(parsed.begin(), parsed.end(),
+                                           [](const auto& entry) { return entry != boost::none; });
+    index = std::move(new_index);
+
+    for (const auto& [id, entry] : index) {
+        if (!entry.is_meta)
+            continue;
+
+        meta.insert_or_assign(entry.title_id, CNMT(std::make_shared<VectorVfsFile>(entry.cnmt)));
+        meta_id.insert_or_assign(entry.title_id, id);
+    }
+
+    if (index_changed)
+        SaveIndex();
+}
+
+void RegisteredCache::LoadIndex() {
+    const auto file = dir->GetFile(INDEX_FILE_NAME);
+    if (file == nullptr)
+        return;
 
-            meta.insert_or_assign(nca->GetTitleId(), CNMT(file));
-            meta_id.insert_or_assign(nca->GetTitleId(), id);
+    IndexHeader header{};
+    if (file->ReadObject(&header) != sizeof(IndexHeader) || header.magic != INDEX_MAGIC ||
+        header.version != INDEX_VERSION) {
+        return;
+    }
+
+    const auto data = file->ReadAllBytes();
+    size_t offset = sizeof(IndexHeader);
+    for (u32 i = 0; i < header.entry_count; ++i) {
+        IndexEntryHeader entry_header{};
+        if (data.size() - offset < sizeof(IndexEntryHeader))
             break;
-        }
+        std::memcpy(&entry_header, data.data() + offset, sizeof(IndexEntryHeader));
+        offset += sizeof(IndexEntryHeader);
+
+        if (data.size() - offset < entry_header.cnmt_size)
+            break;
+        IndexEntry entry{entry_header.size, entry_header.is_meta != 0, entry_header.title_id,
+                         std::vector<u8>(data.begin() + offset,
+                                         data.begin() + offset + entry_header.cnmt_size)};
+        offset += entry_header.cnmt_size;
+
+        index.insert_or_assign(entry_header.nca_id, std::move(entry));
+    }
+}
+
+void RegisteredCache::SaveIndex() const {
+    std::vector<u8> data(sizeof(IndexHeader));
+    IndexHeader header{INDEX_MAGIC, INDEX_VERSION, static_cast<u32>(index.size())};
+    std::memcpy(data.data(), &header, sizeof(IndexHeader));
+
+    for (const auto& [id, entry] : index) {
+        IndexEntryHeader entry_header{id, entry.size, entry.title_id,
+                                      static_cast<u32>(entry.cnmt.size()), entry.is_meta};
+        const size_t offset = data.size();
+        data.resize(offset + sizeof(IndexEntryHeader) + entry.cnmt.size());
+        std::memcpy(data.data() + offset, &entry_header, sizeof(IndexEntryHeader));
+        std::copy(entry.cnmt.begin(), entry.cnmt.end(),
+                  data.begin() + offset + sizeof(IndexEntryHeader));
+    }
+
+    auto file = dir->GetFile(INDEX_FILE_NAME);
+    if (file == nullptr)
+        file = dir->CreateFile(INDEX_FILE_NAME);
+    if (file == nullptr || !file->Resize(data.size()) || file->WriteBytes(data) != data.size()) {
+        LOG_WARNING(Loader, "Could not write the registered cache index to {}",
+                    dir->GetFullPath());
     }
 }
 
@@ -251,6 +374,8 @@ void RegisteredCache::Refresh() {
 
 RegisteredCache::RegisteredCache(VirtualDir dir_, RegisteredCacheParsingFunction parsing_function)
     : dir(std::move(dir_)), parser(std::move(parsing_function)) {
+    if (dir != nullptr)
+        LoadIndex();
     Refresh();
 }
 
@@ -355,6 +480,11 @@ std::vector<RegisteredCacheEntry> RegisteredCache::ListEntriesFilter(
     return out;
 }
 
+bool DefaultInstallCopy(const VirtualFile& src, const VirtualFile& dest,
+                        Core::Crypto::SHA256Hash* hash) {
+    return VfsPipelinedCopy(src, dest, hash);
+}
+
 static std::shared_ptr<NCA> GetNCAFromNSPForID(std::shared_ptr<NSP> nsp, const NcaID& id) {
     const auto file = nsp->GetFile(fmt::format("{}.nca", Common::HexArrayToString(id, false)));
     if (file == nullptr)
@@ -396,7 +526,8 @@ InstallResult RegisteredCache::InstallEntry(std::shared_ptr<NSP> nsp, bool overw
         const auto nca = GetNCAFromNSPForID(nsp, record.nca_id);
         if (nca == nullptr)
             return InstallResult::ErrorCopyFailed;
-        const auto res2 = RawInstallNCA(nca, copy, overwrite_if_exists, record.nca_id);
+        const auto res2 =
+            RawInstallNCA(nca, copy, overwrite_if_exists, record.nca_id, record.hash);
         if (res2 != InstallResult::Success)
             return res2;
     }
@@ -428,9 +559,9 @@ InstallResult RegisteredCache::InstallEntry(std::shared_ptr<NCA> nca, TitleType
     return RawInstallNCA(nca, copy, overwrite_if_exists, c_rec.nca_id);
 }
 
-InstallResult RegisteredCache::RawInstallNCA(std::shared_ptr<NCA> nca, const VfsCopyFunction& copy,
-                                             bool overwrite_if_exists,
-                                             boost::optional<NcaID> override_id) {
+InstallResult RegisteredCache::RawInstallNCA(
+    std::shared_ptr<NCA> nca, const VfsCopyFunction& copy, bool overwrite_if_exists,
+    boost::optional<NcaID> override_id, boost::optional<Core::Crypto::SHA256Hash> expected_hash) {
     const auto in = nca->GetBaseFile();
     Core::Crypto::SHA256Hash hash{};
 
@@ -464,7 +595,19 @@ InstallResult RegisteredCache::RawInstallNCA(std::shared_ptr<NCA> nca, const Vfs
     auto out = dir->CreateFileRelative(path);
     if (out == nullptr)
         return InstallResult::ErrorCopyFailed;
-    return copy(in, out) ? InstallResult::Success : InstallResult::ErrorCopyFailed;
+
+    Core::Crypto::SHA256Hash copied_hash{};
+    if (!copy(in, out, expected_hash == boost::none ? nullptr : &copied_hash))
+        return InstallResult::ErrorCopyFailed;
+
+    if (expected_hash != boost::none && copied_hash != expected_hash.get()) {
+        LOG_ERROR(Loader, "Hash of installed NCA {} does not match its content record, removing it",
+                  Common::HexArrayToString(id, false));
+        out->GetContainingDirectory()->DeleteFile(out->GetName());
+        return InstallResult::ErrorHashMismatch;
+    }
+
+    return InstallResult::Success;
 }
 
 bool RegisteredCache::RawInstallYuzuMeta(const CNMT& cnmt) {
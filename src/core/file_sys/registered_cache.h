@@ -24,15 +24,23 @@ class CNMT;
 
 using NcaID = std::array<u8, 0x10>;
 using RegisteredCacheParsingFunction = std::function<VirtualFile(const VirtualFile&, const NcaID&)>;
-using VfsCopyFunction = std::function<bool(VirtualFile, VirtualFile)>;
+// Copies the first file to the second. If the last argument is not null, the SHA-256 of the data
+// must be computed during the copy and written to it, so that installs can verify the NCAs.
+using VfsCopyFunction =
+    std::function<bool(const VirtualFile&, const VirtualFile&, Core::Crypto::SHA256Hash*)>;
 
 enum class InstallResult {
     Success,
     ErrorAlreadyExists,
     ErrorCopyFailed,
     ErrorMetaFailed,
+    ErrorHashMismatch,
 };
 
+// The copy used by RegisteredCache::InstallEntry unless another one is given
+bool DefaultInstallCopy(const VirtualFile& src, const VirtualFile& dest,
+                        Core::Crypto::SHA256Hash* hash);
+
 struct RegisteredCacheEntry {
     u64 title_id;
     ContentRecordType type;
@@ -90,9 +98,9 @@ public:
     // Raw copies all the ncas from the xci/nsp to the csache. Does some quick checks to make sure
     // there is a meta NCA and all of them are accessible.
     InstallResult InstallEntry(std::shared_ptr<XCI> xci, bool overwrite_if_exists = false,
-                               const VfsCopyFunction& copy = &VfsRawCopy);
+                               const VfsCopyFunction& copy = &DefaultInstallCopy);
     InstallResult InstallEntry(std::shared_ptr<NSP> nsp, bool overwrite_if_exists = false,
-                               const VfsCopyFunction& copy = &VfsRawCopy);
+                               const VfsCopyFunction& copy = &DefaultInstallCopy);
 
     // Due to the fact that we must use Meta-type NCAs to determine the existance of files, this
     // poses quite a challenge. Instead of creating a new meta NCA for this file, yuzu will create a
@@ -100,9 +108,19 @@ public:
     // TODO(DarkLordZach): Author real meta-type NCAs and install those.
     InstallResult InstallEntry(std::shared_ptr<NCA> nca, TitleType type,
                                bool overwrite_if_exists = false,
-                               const VfsCopyFunction& copy = &VfsRawCopy);
+                               const VfsCopyFunction& copy = &DefaultInstallCopy);
 
 private:
+    // What the index remembers about an NCA of the cache. NcaIDs are derived from the contents of
+    // the NCA, so an entry with the same ID and size describes the same file.
+    struct IndexEntry {
+        u64 size;
+        bool is_meta;
+        u64 title_id;
+        // Raw CNMT from section 0, if is_meta
+        std::vector<u8> cnmt;
+    };
+
     template <typename T>
     void IterateAllMetadata(std::vector<T>& out,
                             std::function<T(const CNMT&, const ContentRecord&)> proc,
@@ -110,12 +128,16 @@ private:
     std::vector<NcaID> AccumulateFiles() const;
     void ProcessFiles(const std::vector<NcaID>& ids);
     void AccumulateYuzuMeta();
+    void LoadIndex();
+    void SaveIndex() const;
     boost::optional<NcaID> GetNcaIDFromMetadata(u64 title_id, ContentRecordType type) const;
     VirtualFile GetFileAtID(NcaID id) const;
     VirtualFile OpenFileOrDirectoryConcat(const VirtualDir& dir, std::string_view path) const;
-    InstallResult RawInstallNCA(std::shared_ptr<NCA> nca, const VfsCopyFunction& copy,
-                                bool overwrite_if_exists,
-                                boost::optional<NcaID> override_id = boost::none);
+    // If expected_hash is given, the copy of the NCA is checked against it and removed on mismatch
+    InstallResult RawInstallNCA(
+        std::shared_ptr<NCA> nca, const VfsCopyFunction& copy, bool overwrite_if_exists,
+        boost::optional<NcaID> override_id = boost::none,
+        boost::optional<Core::Crypto::SHA256Hash> expected_hash = boost::none);
     bool RawInstallYuzuMeta(const CNMT& cnmt);
 
     VirtualDir dir;
@@ -126,6 +148,8 @@ private:
     boost::container::flat_map<u64, CNMT> meta;
     // maps tid -> meta for CNMT in yuzu_meta
     boost::container::flat_map<u64, CNMT> yuzu_meta;
+    // maps NcaID -> last parse of that NCA, kept in the cache directory across boots
+    std::map<NcaID, IndexEntry> index;
 };
 
 } // namespace FileSys
@@ -2,14 +2,24 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <cstring>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include <boost/optional.hpp>
+
 #include "common/common_types.h"
+#include "common/memory_tracker.h"
 #include "common/swap.h"
+#include "core/boot_timeline.h"
 #include "core/file_sys/romfs.h"
 #include "core/file_sys/vfs.h"
 #include "core/file_sys/vfs_offset.h"
-#include "core/file_sys/vfs_vector.h"
 
 namespace FileSys {
+namespace {
 
 constexpr u32 ROMFS_ENTRY_EMPTY = 0xFFFFFFFF;
 
@@ -30,95 +40,220 @@ struct RomFSHeader {
 static_assert(sizeof(RomFSHeader) == 0x50, "RomFSHeader has incorrect size.");
 
 struct DirectoryEntry {
+    u32_le parent;
     u32_le sibling;
     u32_le child_dir;
     u32_le child_file;
-    u32_le hash;
+    u32_le next_in_bucket;
     u32_le name_length;
 };
-static_assert(sizeof(DirectoryEntry) == 0x14, "DirectoryEntry has incorrect size.");
+static_assert(sizeof(DirectoryEntry) == 0x18, "DirectoryEntry has incorrect size.");
 
 struct FileEntry {
     u32_le parent;
     u32_le sibling;
     u64_le offset;
     u64_le size;
-    u32_le hash;
+    u32_le next_in_bucket;
     u32_le name_length;
 };
 static_assert(sizeof(FileEntry) == 0x20, "FileEntry has incorrect size.");
 
-template <typename Entry>
-static std::pair<Entry, std::string> GetEntry(const VirtualFile& file, size_t offset) {
-    Entry entry{};
-    if (file->ReadObject(&entry, offset) != sizeof(Entry))
-        return {};
-    std::string string(entry.name_length, '\0');
-    if (file->ReadArray(&string[0], string.size(), offset + sizeof(Entry)) != string.size())
-        return {};
-    return {entry, string};
+/// Hash of an entry name, salted with the offset of its parent directory, used to find its bucket
+u32 CalculatePathHash(u32 parent, std::string_view name) {
+    u32 hash = parent ^ 123456789;
+    for (const char c : name) {
+        hash = (hash >> 5) | (hash << 27);
+        hash ^= static_cast<u8>(c);
+    }
+    return hash;
 }
 
-void ProcessFile(VirtualFile file, size_t file_offset, size_t data_offset, u32 this_file_offset,
-                 std::shared_ptr<VectorVfsDirectory> parent) {
-    while (true) {
-        auto entry = GetEntry<FileEntry>(file, file_offset + this_file_offset);
+/**
+ * The directory and file tables of a RomFS, read once when it is opened. Entries are only decoded
+ * when looked up, by offset or through the hash buckets, so opening an image costs four reads
+ * regardless of how many files it holds.
+ */
+class RomFSIndex : public std::enable_shared_from_this<RomFSIndex> {
+public:
+    bool Load(VirtualFile file_) {
+        file = std::move(file_);
 
-        parent->AddFile(std::make_shared<OffsetVfsFile>(
-            file, entry.first.size, entry.first.offset + data_offset, entry.second));
+        RomFSHeader header{};
+        if (file->ReadObject(&header) != sizeof(RomFSHeader))
+            return false;
 
-        if (entry.first.sibling == ROMFS_ENTRY_EMPTY)
-            break;
+        if (header.header_size != sizeof(RomFSHeader))
+            return false;
 
-        this_file_offset = entry.first.sibling;
+        data_offset = header.data_offset;
+        const bool success = ReadTable(header.directory_hash, dir_buckets) &&
+                             ReadTable(header.directory_meta, dir_table) &&
+                             ReadTable(header.file_hash, file_buckets) &&
+                             ReadTable(header.file_meta, file_table);
+        tables_memory.Update(dir_buckets.capacity() * sizeof(u32_le) + dir_table.capacity() +
+                             file_buckets.capacity() * sizeof(u32_le) + file_table.capacity());
+        return success;
+    }
+
+    boost::optional<std::pair<DirectoryEntry, std::string_view>> GetDirectory(u32 offset) const {
+        return GetEntry<DirectoryEntry>(dir_table, offset);
+    }
+
+    boost::optional<std::pair<FileEntry, std::string_view>> GetFile(u32 offset) const {
+        return GetEntry<FileEntry>(file_table, offset);
+    }
+
+    /// Returns the offset of the subdirectory of parent named name, if there is one
+    boost::optional<u32> FindDirectory(u32 parent, std::string_view name) const {
+        return Find<DirectoryEntry>(dir_buckets, dir_table, parent, name);
+    }
+
+    /// Returns the offset of the file in parent named name, if there is one
+    boost::optional<u32> FindFile(u32 parent, std::string_view name) const {
+        return Find<FileEntry>(file_buckets, file_table, parent, name);
+    }
+
+    VirtualDir MakeDirectory(u32 offset) const;
+
+    VirtualFile MakeFile(const FileEntry& entry, std::string_view name) const {
+        return std::make_shared<OffsetVfsFile>(file, entry.size, entry.offset + data_offset,
+                                               std::string(name));
+    }
+
+private:
+    template <typename T>
+    bool ReadTable(const TableLocation& location, std::vector<T>& table) const {
+        table.resize(location.size / sizeof(T));
+        const size_t size = table.size() * sizeof(T);
+        return file->ReadBytes(table.data(), size, location.offset) == size;
+    }
+
+    template <typename Entry>
+    static boost::optional<std::pair<Entry, std::string_view>> GetEntry(
+        const std::vector<u8>& table, u32 offset) {
+        if (offset == ROMFS_ENTRY_EMPTY || table.size() < sizeof(Entry) ||
+            offset > table.size() - sizeof(Entry)) {
+            return {};
+        }
+
+        Entry entry;
+        std::memcpy(&entry, table.data() + offset, sizeof(Entry));
+        if (entry.name_length > table.size() - offset - sizeof(Entry))
+            return {};
+
+        const char* name = reinterpret_cast<const char*>(table.data() + offset + sizeof(Entry));
+        return std::make_pair(entry, std::string_view(name, entry.name_length));
     }
-}
 
-void ProcessDirectory(VirtualFile file, size_t dir_offset, size_t file_offset, size_t data_offset,
-                      u32 this_dir_offset, std::shared_ptr<VectorVfsDirectory> parent) {
-    while (true) {
-        auto entry = GetEntry<DirectoryEntry>(file, dir_offset + this_dir_offset);
-        auto current = std::make_shared<VectorVfsDirectory>(
-            std::vector<VirtualFile>{}, std::vector<VirtualDir>{}, entry.second);
+    template <typename Entry>
+    static boost::optional<u32> Find(const std::vector<u32_le>& buckets,
+                                     const std::vector<u8>& table, u32 parent,
+                                     std::string_view name) {
+        if (buckets.empty())
+            return {};
 
-        if (entry.first.child_file != ROMFS_ENTRY_EMPTY) {
-            ProcessFile(file, file_offset, data_offset, entry.first.child_file, current);
+        u32 offset = buckets[CalculatePathHash(parent, name) % buckets.size()];
+        // Bounds the walk should a corrupted image chain the entries into a cycle
+        for (size_t i = 0; i < table.size() / sizeof(Entry); ++i) {
+            const auto entry = GetEntry<Entry>(table, offset);
+            if (!entry)
+                return {};
+            if (entry->first.parent == parent && entry->second == name)
+                return offset;
+            offset = entry->first.next_in_bucket;
         }
+        return {};
+    }
+
+    VirtualFile file;
+    u64 data_offset = 0;
+    std::vector<u32_le> dir_buckets;
+    std::vector<u8> dir_table;
+    std::vector<u32_le> file_buckets;
+    std::vector<u8> file_table;
+    Common::TrackedMemory tables_memory{Common::MemoryTag::VfsFiles};
+};
+
+/// A directory of a RomFS, whose children are looked up in the index whenever they are requested
+class RomFSDirectory : public ReadOnlyVfsDirectory {
+public:
+    RomFSDirectory(std::shared_ptr<const RomFSIndex> index, u32 offset, DirectoryEntry entry,
+                   std::string name)
+        : index(std::move(index)), offset(offset), entry(entry), name(std::move(name)) {}
 
-        if (entry.first.child_dir != ROMFS_ENTRY_EMPTY) {
-            ProcessDirectory(file, dir_offset, file_offset, data_offset, entry.first.child_dir,
-                             current);
+    std::vector<std::shared_ptr<VfsFile>> GetFiles() const override {
+        std::vector<VirtualFile> out;
+        for (auto child = index->GetFile(entry.child_file); child;
+             child = index->GetFile(child->first.sibling)) {
+            out.push_back(index->MakeFile(child->first, child->second));
         }
+        return out;
+    }
 
-        parent->AddDirectory(current);
-        if (entry.first.sibling == ROMFS_ENTRY_EMPTY)
-            break;
-        this_dir_offset = entry.first.sibling;
+    std::shared_ptr<VfsFile> GetFile(std::string_view file_name) const override {
+        const auto child_offset = index->FindFile(offset, file_name);
+        if (!child_offset)
+            return nullptr;
+
+        const auto child = index->GetFile(*child_offset);
+        return index->MakeFile(child->first, child->second);
     }
-}
 
-VirtualDir ExtractRomFS(VirtualFile file) {
-    RomFSHeader header{};
-    if (file->ReadObject(&header) != sizeof(RomFSHeader))
-        return nullptr;
+    std::vector<std::shared_ptr<VfsDirectory>> GetSubdirectories() const override {
+        std::vector<VirtualDir> out;
+        for (u32 child_offset = entry.child_dir;;) {
+            const auto child = index->GetDirectory(child_offset);
+            if (!child)
+                break;
+            out.push_back(index->MakeDirectory(child_offset));
+            child_offset = child->first.sibling;
+        }
+        return out;
+    }
 
-    if (header.header_size != sizeof(RomFSHeader))
-        return nullptr;
+    std::shared_ptr<VfsDirectory> GetSubdirectory(std::string_view dir_name) const override {
+        const auto child_offset = index->FindDirectory(offset, dir_name);
+        return child_offset ? index->MakeDirectory(*child_offset) : nullptr;
+    }
+
+    std::string GetName() const override {
+        return name;
+    }
+
+    std::shared_ptr<VfsDirectory> GetParentDirectory() const override {
+        // The root directory is its own parent in the table
+        return offset == 0 ? nullptr : index->MakeDirectory(entry.parent);
+    }
 
-    const u64 file_offset = header.file_meta.offset;
-    const u64 dir_offset = header.directory_meta.offset + 4;
+protected:
+    bool ReplaceFileWithSubdirectory(VirtualFile file, VirtualDir dir) override {
+        return false;
+    }
 
-    auto root =
-        std::make_shared<VectorVfsDirectory>(std::vector<VirtualFile>{}, std::vector<VirtualDir>{},
-                                             file->GetName(), file->GetContainingDirectory());
+private:
+    std::shared_ptr<const RomFSIndex> index;
+    u32 offset;
+    DirectoryEntry entry;
+    std::string name;
+};
 
-    ProcessDirectory(file, dir_offset, file_offset, header.data_offset, 0, root);
+VirtualDir RomFSIndex::MakeDirectory(u32 offset) const {
+    const auto entry = GetDirectory(offset);
+    if (!entry)
+        return nullptr;
+    return std::make_shared<RomFSDirectory>(shared_from_this(), offset, entry->first,
+                                            std::string(entry->second));
+}
 
-    VirtualDir out = std::move(root);
+} // Anonymous namespace
 
-    while (out->GetSubdirectory("") != nullptr)
-        out = out->GetSubdirectory("");
+VirtualDir ExtractRomFS(VirtualFile file) {
+    Core::ScopedBootPhase phase("Read RomFS tables");
+    auto index = std::make_shared<RomFSIndex>();
+    if (!index->Load(std::move(file)))
+        return nullptr;
 
-    return out;
+    return index->MakeDirectory(0);
 }
 } // namespace FileSys
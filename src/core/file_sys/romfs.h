@@ -28,7 +28,8 @@ struct IVFCHeader {
 };
 static_assert(sizeof(IVFCHeader) == 0xE0, "IVFCHeader has incorrect size.");
 
-// Converts a RomFS binary blob to VFS Filesystem
+// Opens a RomFS binary blob as a read-only VFS Filesystem. Only the directory and file tables are
+// read up front, entries are looked up in them as the tree is walked.
 // Returns nullptr on failure
 VirtualDir ExtractRomFS(VirtualFile file);
 
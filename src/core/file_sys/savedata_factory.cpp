@@ -2,11 +2,13 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <iterator>
 #include <memory>
 #include "common/common_types.h"
 #include "common/logging/log.h"
 #include "core/core.h"
 #include "core/file_sys/savedata_factory.h"
+#include "core/file_sys/vfs_writeback.h"
 #include "core/hle/kernel/process.h"
 
 namespace FileSys {
@@ -53,6 +55,16 @@ ResultVal<VirtualDir> SaveDataFactory::Open(SaveDataSpaceId space, SaveDataDescr
     // TODO(DarkLordZach): Try to not create when opening, there are dedicated create save methods.
     // But, user_ids don't match so this works for now.
 
+    // Saves closed since the last call are forgotten, they are written back already
+    for (auto iter = open_saves.begin(); iter != open_saves.end();) {
+        iter = iter->second.expired() ? open_saves.erase(iter) : std::next(iter);
+    }
+
+    auto& open_save = open_saves[save_directory];
+    if (auto save = open_save.lock()) {
+        return MakeResult<VirtualDir>(std::move(save));
+    }
+
     auto out = dir->GetDirectoryRelative(save_directory);
 
     if (out == nullptr) {
@@ -69,7 +81,10 @@ ResultVal<VirtualDir> SaveDataFactory::Open(SaveDataSpaceId space, SaveDataDescr
         return ResultCode(-1);
     }
 
-    return MakeResult<VirtualDir>(std::move(out));
+    // Writes are kept in memory and written to the host in batches, see IFileSystem::Commit
+    auto save = std::make_shared<WriteBackVfsDirectory>(std::move(out));
+    open_save = save;
+    return MakeResult<VirtualDir>(std::move(save));
 }
 
 std::string SaveDataFactory::GetFullPath(SaveDataSpaceId space, SaveDataType type, u64 title_id,
@@ -4,6 +4,7 @@
 
 #pragma once
 
+#include <map>
 #include <memory>
 #include <string>
 #include "common/common_types.h"
@@ -12,6 +13,8 @@
 
 namespace FileSys {
 
+class WriteBackVfsDirectory;
+
 enum class SaveDataSpaceId : u8 {
     NandSystem = 0,
     NandUser = 1,
@@ -54,6 +57,9 @@ public:
 
 private:
     VirtualDir dir;
+
+    /// Saves currently open, so that opening one twice shares the pending writes
+    std::map<std::string, std::weak_ptr<WriteBackVfsDirectory>> open_saves;
 };
 
 } // namespace FileSys
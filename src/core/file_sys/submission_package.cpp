@@ -5,6 +5,7 @@
 #include <fmt/ostream.h>
 #include "common/assert.h"
 #include "common/hex_util.h"
+#include "common/thread_pool.h"
 #include "core/file_sys/content_archive.h"
 #include "core/file_sys/nca_metadata.h"
 #include "core/file_sys/submission_package.h"
@@ -56,43 +57,63 @@ NSP::NSP(VirtualFile file_)
         }
     }
 
-    for (const auto& outer_file : files) {
-        if (outer_file->GetName().substr(outer_file->GetName().size() - 9) == ".cnmt.nca") {
-            const auto nca = std::make_shared<NCA>(outer_file);
-            if (nca->GetStatus() != Loader::ResultStatus::Success)
+    // Parsing an NCA reads and decrypts its headers, so the NCAs are parsed across the thread
+    // pool: first the metadata ones, then all the ones their content records list
+    std::vector<VirtualFile> meta_files;
+    std::copy_if(files.begin(), files.end(), std::back_inserter(meta_files),
+                 [](const VirtualFile& outer_file) {
+                     const auto& name = outer_file->GetName();
+                     return name.size() >= 9 && name.substr(name.size() - 9) == ".cnmt.nca";
+                 });
+    const auto meta_ncas = ParseNCAs(meta_files);
+
+    struct ContentNCA {
+        u64 title_id;
+        ContentRecordType type;
+        VirtualFile file;
+    };
+    std::vector<ContentNCA> contents;
+    for (const auto& nca : meta_ncas) {
+        if (nca->GetStatus() != Loader::ResultStatus::Success)
+            continue;
+        const auto section0 = nca->GetSubdirectories()[0];
+
+        for (const auto& inner_file : section0->GetFiles()) {
+            if (inner_file->GetExtension() != "cnmt")
                 continue;
-            const auto section0 = nca->GetSubdirectories()[0];
 
-            for (const auto& inner_file : section0->GetFiles()) {
-                if (inner_file->GetExtension() != "cnmt")
+            const CNMT cnmt(inner_file);
+            ncas[cnmt.GetTitleID()][ContentRecordType::Meta] = nca;
+            for (const auto& rec : cnmt.GetContentRecords()) {
+                const auto id_string = Common::HexArrayToString(rec.nca_id, false);
+                const auto next_file = pfs->GetFile(fmt::format("{}.nca", id_string));
+                if (next_file == nullptr) {
+                    LOG_WARNING(Service_FS,
+                                "NCA with ID {}.nca is listed in content metadata, but cannot "
+                                "be found in PFS. NSP appears to be corrupted.",
+                                id_string);
                     continue;
-
-                const CNMT cnmt(inner_file);
-                auto& ncas_title = ncas[cnmt.GetTitleID()];
-
-                ncas_title[ContentRecordType::Meta] = nca;
-                for (const auto& rec : cnmt.GetContentRecords()) {
-                    const auto id_string = Common::HexArrayToString(rec.nca_id, false);
-                    const auto next_file = pfs->GetFile(fmt::format("{}.nca", id_string));
-                    if (next_file == nullptr) {
-                        LOG_WARNING(Service_FS,
-                                    "NCA with ID {}.nca is listed in content metadata, but cannot "
-                                    "be found in PFS. NSP appears to be corrupted.",
-                                    id_string);
-                        continue;
-                    }
-
-                    auto next_nca = std::make_shared<NCA>(next_file);
-                    if (next_nca->GetType() == NCAContentType::Program)
-                        program_status[cnmt.GetTitleID()] = next_nca->GetStatus();
-                    if (next_nca->GetStatus() == Loader::ResultStatus::Success)
-                        ncas_title[rec.type] = std::move(next_nca);
                 }
 
-                break;
+                contents.push_back({cnmt.GetTitleID(), rec.type, next_file});
             }
+
+            break;
         }
     }
+
+    std::vector<VirtualFile> content_files(contents.size());
+    std::transform(contents.begin(), contents.end(), content_files.begin(),
+                   [](const ContentNCA& content) { return content.file; });
+    auto content_ncas = ParseNCAs(content_files);
+
+    for (size_t i = 0; i < contents.size(); ++i) {
+        auto& next_nca = content_ncas[i];
+        if (next_nca->GetType() == NCAContentType::Program)
+            program_status[contents[i].title_id] = next_nca->GetStatus();
+        if (next_nca->GetStatus() == Loader::ResultStatus::Success)
+            ncas[contents[i].title_id][contents[i].type] = std::move(next_nca);
+    }
 }
 
 NSP::~NSP() = default;
@@ -232,4 +253,11 @@ VirtualDir NSP::GetParentDirectory() const {
 bool NSP::ReplaceFileWithSubdirectory(VirtualFile file, VirtualDir dir) {
     return false;
 }
+
+std::vector<std::shared_ptr<NCA>> ParseNCAs(const std::vector<VirtualFile>& files) {
+    std::vector<std::shared_ptr<NCA>> out(files.size());
+    Common::GetSharedThreadPool().ParallelFor(
+        files.size(), [&](size_t i) { out[i] = std::make_shared<NCA>(files[i]); });
+    return out;
+}
 } // namespace FileSys
@@ -69,4 +69,8 @@ private:
     VirtualFile romfs;
     VirtualDir exefs;
 };
+
+/// Parses every file as an NCA, spread across the thread pool. The NCAs are in the order of files.
+std::vector<std::shared_ptr<NCA>> ParseNCAs(const std::vector<VirtualFile>& files);
+
 } // namespace FileSys
@@ -3,11 +3,16 @@
 // Refer to the license.txt file included.
 
 #include <algorithm>
+#include <condition_variable>
+#include <mutex>
 #include <numeric>
 #include <string>
+#include <thread>
+#include <mbedtls/sha256.h>
 #include "common/common_paths.h"
 #include "common/file_util.h"
 #include "common/logging/backend.h"
+#include "common/thread.h"
 #include "core/file_sys/mode.h"
 #include "core/file_sys/vfs.h"
 
@@ -44,6 +49,10 @@ VirtualFile VfsFilesystem::OpenFile(std::string_view path_, Mode perms) {
     return root->GetFileRelative(path);
 }
 
+VirtualFile VfsFilesystem::OpenImmutableFile(std::string_view path) {
+    return OpenFile(path, Mode::Read);
+}
+
 VirtualFile VfsFilesystem::CreateFile(std::string_view path_, Mode perms) {
     const auto path = FileUtil::SanitizePath(path_);
     return root->CreateFileRelative(path);
@@ -286,6 +295,18 @@ bool VfsDirectory::IsRoot() const {
     return GetParentDirectory() == nullptr;
 }
 
+bool VfsDirectory::IterateEntries(const EntryCallback& callback) const {
+    for (const auto& file : GetFiles()) {
+        if (!callback(file->GetName(), VfsEntryType::File, file->GetSize()))
+            return false;
+    }
+    for (const auto& subdirectory : GetSubdirectories()) {
+        if (!callback(subdirectory->GetName(), VfsEntryType::Directory, 0))
+            return false;
+    }
+    return true;
+}
+
 size_t VfsDirectory::GetSize() const {
     const auto& files = GetFiles();
     const auto sum_sizes = [](const auto& range) {
@@ -463,6 +484,109 @@ bool VfsRawCopy(VirtualFile src, VirtualFile dest) {
     return dest->WriteBytes(data, 0) == data.size();
 }
 
+bool VfsPipelinedCopy(const VirtualFile& src, const VirtualFile& dest, std::array<u8, 0x20>* hash,
+                      const VfsCopyProgressCallback& progress) {
+    // Large enough to amortize the per-read cost of the encryption layers, and with three of them
+    // the reader can stay two chunks ahead of the writer.
+    constexpr size_t CHUNK_SIZE = 0x400000;
+    constexpr size_t CHUNK_COUNT = 3;
+
+    if (src == nullptr || dest == nullptr)
+        return false;
+
+    const size_t size = src->GetSize();
+    if (!dest->Resize(size))
+        return false;
+
+    const size_t total_chunks = (size + CHUNK_SIZE - 1) / CHUNK_SIZE;
+    std::array<std::vector<u8>, CHUNK_COUNT> chunks;
+
+    // Chunk i lives in chunks[i % CHUNK_COUNT]. The reader only fills it once the writer is done
+    // with chunk i - CHUNK_COUNT, and the writer only takes it once the reader has filled it.
+    std::mutex mutex;
+    std::condition_variable cv;
+    size_t chunks_read = 0;
+    size_t chunks_written = 0;
+    bool read_failed = false;
+    bool stop = false;
+
+    std::thread reader([&] {
+        Common::SetCurrentThreadName("VfsCopyReader");
+        for (size_t i = 0; i < total_chunks; ++i) {
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                cv.wait(lock, [&] { return stop || i < chunks_written + CHUNK_COUNT; });
+                if (stop)
+                    return;
+            }
+
+            auto& chunk = chunks[i % CHUNK_COUNT];
+            const size_t offset = i * CHUNK_SIZE;
+            chunk.resize(std::min(CHUNK_SIZE, size - offset));
+            const bool ok = src->Read(chunk.data(), chunk.size(), offset) == chunk.size();
+
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (ok) {
+                    ++chunks_read;
+                } else {
+                    read_failed = true;
+                }
+            }
+            cv.notify_all();
+            if (!ok)
+                return;
+        }
+    });
+
+    mbedtls_sha256_context sha_context;
+    if (hash != nullptr) {
+        mbedtls_sha256_init(&sha_context);
+        mbedtls_sha256_starts(&sha_context, 0);
+    }
+
+    bool success = true;
+    for (size_t i = 0; i < total_chunks && success; ++i) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            cv.wait(lock, [&] { return read_failed || i < chunks_read; });
+            if (i >= chunks_read) {
+                success = false;
+                break;
+            }
+        }
+
+        const auto& chunk = chunks[i % CHUNK_COUNT];
+        if (dest->Write(chunk.data(), chunk.size(), i * CHUNK_SIZE) != chunk.size())
+            success = false;
+        if (hash != nullptr)
+            mbedtls_sha256_update(&sha_context, chunk.data(), chunk.size());
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            ++chunks_written;
+        }
+        cv.notify_all();
+
+        if (success && progress && !progress(std::min(size, (i + 1) * CHUNK_SIZE), size))
+            success = false;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stop = true;
+    }
+    cv.notify_all();
+    reader.join();
+
+    if (hash != nullptr) {
+        mbedtls_sha256_finish(&sha_context, hash->data());
+        mbedtls_sha256_free(&sha_context);
+    }
+
+    return success;
+}
+
 VirtualDir GetOrCreateDirectoryRelative(const VirtualDir& rel, std::string_view path) {
     const auto res = rel->GetDirectoryRelative(path);
     if (res == nullptr)
@@ -4,6 +4,8 @@
 
 #pragma once
 
+#include <array>
+#include <functional>
 #include <memory>
 #include <string>
 #include <string_view>
@@ -53,6 +55,10 @@ public:
 
     // Opens the file with path relative to root. If it doesn't exist, returns nullptr.
     virtual VirtualFile OpenFile(std::string_view path, Mode perms);
+    // Opens the file with path relative to root for reading, for large content that isn't
+    // modified while it's open such as title images. Filesystems may serve such files from a
+    // memory mapping. The default implementation opens the file with OpenFile.
+    virtual VirtualFile OpenImmutableFile(std::string_view path);
     // Creates a new, empty file at path
     virtual VirtualFile CreateFile(std::string_view path, Mode perms);
     // Copies the file from old_path to new_path, returning the new file on success and nullptr on
@@ -83,6 +89,11 @@ protected:
 };
 
 // A class representing a file in an abstract filesystem.
+//
+// Concurrency: the const methods, Read and everything built on it included, may be called on the
+// same file from any number of threads at once, so implementations must keep their per-read state
+// (file positions, cipher IVs) to the call or guard it themselves. Write, Resize and Rename must
+// not run concurrently with any other call on the file.
 class VfsFile : NonCopyable {
 public:
     virtual ~VfsFile();
@@ -210,6 +221,16 @@ public:
     // directory with name.
     virtual std::shared_ptr<VfsDirectory> GetSubdirectory(std::string_view name) const;
 
+    // Called by IterateEntries with the name, type and size of each entry. Directories have a size
+    // of 0. Returning false stops the iteration.
+    using EntryCallback =
+        std::function<bool(std::string_view name, VfsEntryType type, size_t size)>;
+
+    // Calls callback for every file, then every subdirectory in this directory, without creating
+    // objects for them when the implementation allows it. Returns false if the callback stopped
+    // the iteration.
+    virtual bool IterateEntries(const EntryCallback& callback) const;
+
     // Returns whether or not the directory can be written to.
     virtual bool IsWritable() const = 0;
     // Returns whether of not the directory can be read from.
@@ -318,6 +339,18 @@ bool DeepEquals(const VirtualFile& file1, const VirtualFile& file2, size_t block
 // directory of src/dest.
 bool VfsRawCopy(VirtualFile src, VirtualFile dest);
 
+// Called after every chunk of a copy with the number of bytes copied so far and the total size.
+// Returning false cancels the copy.
+using VfsCopyProgressCallback = std::function<bool(size_t copied, size_t total)>;
+
+// Copies src to dest like VfsRawCopy, but in fixed-size chunks, reading (and thereby decrypting)
+// the next chunks on another thread while the current one is written. If hash is not null, the
+// SHA-256 of the data is computed as it passes and written to it. Returns false if any read or
+// write fails or progress cancelled the copy, in which case dest is left with partial contents.
+bool VfsPipelinedCopy(const VirtualFile& src, const VirtualFile& dest,
+                      std::array<u8, 0x20>* hash = nullptr,
+                      const VfsCopyProgressCallback& progress = {});
+
 // Checks if the directory at path relative to rel exists. If it does, returns that. If it does not
 // it attempts to create it and returns the new dir or nullptr on failure.
 VirtualDir GetOrCreateDirectoryRelative(const VirtualDir& rel, std::string_view path);
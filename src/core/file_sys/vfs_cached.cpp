@@ -0,0 +1,251 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <iterator>
+#include <list>
+#include <map>
+#include <utility>
+#include <boost/optional.hpp>
+
+#include "core/file_sys/vfs_cached.h"
+#include "core/settings.h"
+
+namespace FileSys {
+
+/// Reads at least this large are streamed past the cache, so they don't flush out the hot blocks
+constexpr size_t UNCACHED_READ_THRESHOLD = 0x100000;
+
+/// Copies the data at block_offset of a block, returning the number of bytes copied
+static size_t CopyFromBlock(const std::vector<u8>& block, size_t block_offset, u8* data,
+                            size_t length) {
+    if (block_offset >= block.size()) {
+        return 0;
+    }
+    const size_t chunk = std::min(length, block.size() - block_offset);
+    std::memcpy(data, block.data() + block_offset, chunk);
+    return chunk;
+}
+
+namespace {
+
+/// Blocks of every CachedVfsFile, within one byte budget
+class BlockCache {
+public:
+    static BlockCache& Get() {
+        static BlockCache instance;
+        return instance;
+    }
+
+    void SetBudget(size_t new_budget) {
+        std::lock_guard<std::mutex> lock(mutex);
+        budget = new_budget;
+        Evict();
+    }
+
+    /// Copies from the block if it's cached, returning the number of bytes copied
+    boost::optional<size_t> Read(u64 owner, size_t index, size_t block_offset, u8* data,
+                                 size_t length) {
+        std::lock_guard<std::mutex> lock(mutex);
+        const auto iter = block_map.find({owner, index});
+        if (iter == block_map.end()) {
+            return boost::none;
+        }
+        blocks.splice(blocks.begin(), blocks, iter->second);
+        return CopyFromBlock(iter->second->data, block_offset, data, length);
+    }
+
+    void Insert(u64 owner, size_t index, std::vector<u8> data) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (block_map.count({owner, index}) != 0) {
+            return;
+        }
+        used += data.size();
+        blocks.push_front({owner, index, std::move(data)});
+        block_map.emplace(BlockKey{owner, index}, blocks.begin());
+        Evict();
+    }
+
+    /// Drops every block of a file
+    void Remove(u64 owner) {
+        std::lock_guard<std::mutex> lock(mutex);
+        const auto begin = block_map.lower_bound({owner, 0});
+        const auto end = block_map.lower_bound({owner + 1, 0});
+        for (auto iter = begin; iter != end; ++iter) {
+            used -= iter->second->data.size();
+            blocks.erase(iter->second);
+        }
+        block_map.erase(begin, end);
+    }
+
+private:
+    using BlockKey = std::pair<u64, size_t>;
+
+    struct Block {
+        u64 owner;
+        size_t index;
+        std::vector<u8> data;
+    };
+
+    /// Evicts the least recently used blocks until the budget is met. mutex must be held.
+    void Evict() {
+        while (used > budget && !blocks.empty()) {
+            const Block& block = blocks.back();
+            used -= block.data.size();
+            block_map.erase({block.owner, block.index});
+            blocks.pop_back();
+        }
+    }
+
+    std::mutex mutex;
+    size_t budget = 0;
+    size_t used = 0;
+    /// Cached blocks, most recently used first
+    std::list<Block> blocks;
+    /// Ordered by file first, so that the blocks of a file can be dropped at once
+    std::map<BlockKey, std::list<Block>::iterator> block_map;
+};
+
+} // Anonymous namespace
+
+static std::atomic<u64> next_cached_file_id{0};
+
+CachedVfsFile::CachedVfsFile(VirtualFile file_)
+    : file(std::move(file_)), id(next_cached_file_id++) {}
+
+CachedVfsFile::~CachedVfsFile() {
+    BlockCache::Get().Remove(id);
+}
+
+std::string CachedVfsFile::GetName() const {
+    return file->GetName();
+}
+
+size_t CachedVfsFile::GetSize() const {
+    return file->GetSize();
+}
+
+bool CachedVfsFile::Resize(size_t new_size) {
+    return false;
+}
+
+std::shared_ptr<VfsDirectory> CachedVfsFile::GetContainingDirectory() const {
+    return file->GetContainingDirectory();
+}
+
+bool CachedVfsFile::IsWritable() const {
+    return false;
+}
+
+bool CachedVfsFile::IsReadable() const {
+    return file->IsReadable();
+}
+
+size_t CachedVfsFile::Read(u8* data, size_t length, size_t offset) const {
+    const size_t size = file->GetSize();
+    if (offset >= size) {
+        return 0;
+    }
+    length = std::min(length, size - offset);
+
+    std::lock_guard<std::mutex> lock(read_mutex);
+
+    if (length >= UNCACHED_READ_THRESHOLD) {
+        return file->Read(data, length, offset);
+    }
+
+    BlockCache& cache = BlockCache::Get();
+    size_t read = 0;
+    while (read < length) {
+        const size_t position = offset + read;
+        const size_t index = position / BLOCK_SIZE;
+        const size_t block_offset = position % BLOCK_SIZE;
+
+        boost::optional<size_t> chunk =
+            cache.Read(id, index, block_offset, data + read, length - read);
+        if (!chunk) {
+            std::vector<u8> block(BLOCK_SIZE);
+            // The read is block aligned, so the decryption layer below decrypts it in one go
+            block.resize(file->Read(block.data(), BLOCK_SIZE, index * BLOCK_SIZE));
+            chunk = CopyFromBlock(block, block_offset, data + read, length - read);
+            cache.Insert(id, index, std::move(block));
+        }
+
+        if (*chunk == 0) {
+            // The wrapped file returned less than it claimed to have
+            break;
+        }
+        read += *chunk;
+    }
+    return read;
+}
+
+size_t CachedVfsFile::Write(const u8* data, size_t length, size_t offset) {
+    return 0;
+}
+
+bool CachedVfsFile::Rename(std::string_view name) {
+    return false;
+}
+
+VirtualFile CreateDecryptedCache(VirtualFile file) {
+    const size_t budget = static_cast<size_t>(Settings::values.decrypted_cache_size) << 20;
+    BlockCache::Get().SetBudget(budget);
+    if (file == nullptr || budget == 0) {
+        return file;
+    }
+    return std::make_shared<CachedVfsFile>(std::move(file));
+}
+
+HeadCachedVfsFile::HeadCachedVfsFile(VirtualFile file_, size_t head_size)
+    : file(std::move(file_)), head(file->ReadBytes(head_size)) {}
+
+std::string HeadCachedVfsFile::GetName() const {
+    return file->GetName();
+}
+
+size_t HeadCachedVfsFile::GetSize() const {
+    return file->GetSize();
+}
+
+bool HeadCachedVfsFile::Resize(size_t new_size) {
+    return false;
+}
+
+std::shared_ptr<VfsDirectory> HeadCachedVfsFile::GetContainingDirectory() const {
+    return file->GetContainingDirectory();
+}
+
+bool HeadCachedVfsFile::IsWritable() const {
+    return false;
+}
+
+bool HeadCachedVfsFile::IsReadable() const {
+    return file->IsReadable();
+}
+
+size_t HeadCachedVfsFile::Read(u8* data, size_t length, size_t offset) const {
+    if (offset >= head.size()) {
+        return file->Read(data, length, offset);
+    }
+
+    const size_t cached = std::min(length, head.size() - offset);
+    std::memcpy(data, head.data() + offset, cached);
+    if (cached == length) {
+        return cached;
+    }
+    return cached + file->Read(data + cached, length - cached, offset + cached);
+}
+
+size_t HeadCachedVfsFile::Write(const u8* data, size_t length, size_t offset) {
+    return 0;
+}
+
+bool HeadCachedVfsFile::Rename(std::string_view name) {
+    return false;
+}
+
+} // namespace FileSys
@@ -0,0 +1,72 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <vector>
+
+#include "core/file_sys/vfs.h"
+
+namespace FileSys {
+
+// An implementation of VfsFile that keeps the most recently read blocks of another VfsFile in
+// memory. Meant to sit on top of a decryption layer, so that regions read over and over (such as
+// hot RomFS assets) are only decrypted once. Read-only. The blocks of every CachedVfsFile share
+// one byte budget, the least recently used block is evicted once it's exceeded.
+class CachedVfsFile : public VfsFile {
+public:
+    /// Size of a cached block, a multiple of both the AES-CTR block and the XTS sector size
+    static constexpr size_t BLOCK_SIZE = 0x4000;
+
+    explicit CachedVfsFile(VirtualFile file);
+    ~CachedVfsFile() override;
+
+    std::string GetName() const override;
+    size_t GetSize() const override;
+    bool Resize(size_t new_size) override;
+    std::shared_ptr<VfsDirectory> GetContainingDirectory() const override;
+    bool IsWritable() const override;
+    bool IsReadable() const override;
+    size_t Read(u8* data, size_t length, size_t offset) const override;
+    size_t Write(const u8* data, size_t length, size_t offset) override;
+    bool Rename(std::string_view name) override;
+
+private:
+    VirtualFile file;
+    /// Identifies the blocks of this file in the shared cache
+    u64 id;
+    /// Held for every read of the wrapped file, decryption layers keep cipher state between reads
+    mutable std::mutex read_mutex;
+};
+
+/// Wraps file in a CachedVfsFile, applying the configured budget, or returns it as is if disabled
+VirtualFile CreateDecryptedCache(VirtualFile file);
+
+// An implementation of VfsFile that reads the start of another VfsFile into memory once, and serves
+// all reads of it from there while passing the others through. Meant for identifying a file, where
+// every format probed reads the same headers again. Read-only.
+class HeadCachedVfsFile : public VfsFile {
+public:
+    HeadCachedVfsFile(VirtualFile file, size_t head_size);
+
+    std::string GetName() const override;
+    size_t GetSize() const override;
+    bool Resize(size_t new_size) override;
+    std::shared_ptr<VfsDirectory> GetContainingDirectory() const override;
+    bool IsWritable() const override;
+    bool IsReadable() const override;
+    size_t Read(u8* data, size_t length, size_t offset) const override;
+    size_t Write(const u8* data, size_t length, size_t offset) override;
+    bool Rename(std::string_view name) override;
+
+private:
+    VirtualFile file;
+    /// Never changes after construction, so reads need no lock
+    std::vector<u8> head;
+};
+
+} // namespace FileSys
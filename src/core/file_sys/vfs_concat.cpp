@@ -3,6 +3,7 @@
 // Refer to the license.txt file included.
 
 #include <algorithm>
+#include <iterator>
 #include <utility>
 
 #include "core/file_sys/vfs_concat.h"
@@ -20,10 +21,14 @@ VirtualFile ConcatenateFiles(std::vector<VirtualFile> files, std::string name) {
 
 ConcatenatedVfsFile::ConcatenatedVfsFile(std::vector<VirtualFile> files_, std::string name)
     : name(std::move(name)) {
-    size_t next_offset = 0;
+    files.reserve(files_.size());
     for (const auto& file : files_) {
-        files[next_offset] = file;
-        next_offset += file->GetSize();
+        const size_t file_size = file->GetSize();
+        // An empty part would share its starting offset with the next one
+        if (file_size == 0)
+            continue;
+        files.emplace_hint(files.end(), size, file);
+        size += file_size;
     }
 }
 
@@ -36,9 +41,7 @@ std::string ConcatenatedVfsFile::GetName() const {
 }
 
 size_t ConcatenatedVfsFile::GetSize() const {
-    if (files.empty())
-        return 0;
-    return files.rbegin()->first + files.rbegin()->second->GetSize();
+    return size;
 }
 
 bool ConcatenatedVfsFile::Resize(size_t new_size) {
@@ -60,28 +63,26 @@ bool ConcatenatedVfsFile::IsReadable() const {
 }
 
 size_t ConcatenatedVfsFile::Read(u8* data, size_t length, size_t offset) const {
-    auto entry = files.end();
-    for (auto iter = files.begin(); iter != files.end(); ++iter) {
-        if (iter->first > offset) {
-            entry = --iter;
-            break;
-        }
-    }
+    if (offset >= size)
+        return 0;
+    length = std::min(length, size - offset);
 
-    // Check if the entry should be the last one. The loop above will make it end().
-    if (entry == files.end() && offset < files.rbegin()->first + files.rbegin()->second->GetSize())
-        --entry;
+    // The part holding offset is the last one starting at or before it.
+    auto entry = std::prev(files.upper_bound(offset));
 
-    if (entry == files.end())
-        return 0;
+    size_t read = 0;
+    while (read < length) {
+        const size_t part_offset = offset + read - entry->first;
+        const size_t part_size = entry->second->GetSize();
+        const size_t to_read = std::min(length - read, part_size - part_offset);
 
-    const auto remaining = entry->second->GetSize() + offset - entry->first;
-    if (length > remaining) {
-        return entry->second->Read(data, remaining, offset - entry->first) +
-               Read(data + remaining, length - remaining, offset + remaining);
+        const size_t part_read = entry->second->Read(data + read, to_read, part_offset);
+        read += part_read;
+        if (part_read != to_read || ++entry == files.end())
+            break;
     }
 
-    return entry->second->Read(data, length, offset - entry->first);
+    return read;
 }
 
 size_t ConcatenatedVfsFile::Write(const u8* data, size_t length, size_t offset) {
@@ -33,8 +33,10 @@ public:
     bool Rename(std::string_view name) override;
 
 private:
-    // Maps starting offset to file -- more efficient.
+    // Maps starting offset to file. Being a sorted vector, this is a prefix sum of the file sizes
+    // that can be binary searched for the file covering an offset.
     boost::container::flat_map<u64, VirtualFile> files;
+    size_t size = 0;
     std::string name;
 };
 
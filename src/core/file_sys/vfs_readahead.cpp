@@ -0,0 +1,241 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <shared_mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "common/thread.h"
+#include "core/file_sys/vfs_readahead.h"
+
+namespace FileSys {
+
+/// Sequential reads in a row after which the file is read ahead
+constexpr size_t SEQUENTIAL_READS_TO_PREFETCH = 2;
+/// Size of the first read ahead of a sequential stretch, doubled on every hit up to the maximum
+constexpr size_t MIN_PREFETCH_SIZE = 0x10000;
+constexpr size_t MAX_PREFETCH_SIZE = 0x100000;
+
+namespace {
+
+/// Single host thread running the prefetches of all files, oldest first
+class PrefetchThread final {
+public:
+    PrefetchThread() : thread{[this] { ThreadLoop(); }} {}
+
+    ~PrefetchThread() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stop = true;
+            jobs.clear();
+        }
+        cv.notify_one();
+        thread.join();
+    }
+
+    void Queue(std::function<void()> job) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            jobs.push_back(std::move(job));
+        }
+        cv.notify_one();
+    }
+
+private:
+    void ThreadLoop() {
+        Common::SetCurrentThreadName("VfsReadAhead");
+        while (true) {
+            std::function<void()> job;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                cv.wait(lock, [this] { return stop || !jobs.empty(); });
+                if (stop) {
+                    return;
+                }
+                job = std::move(jobs.front());
+                jobs.pop_front();
+            }
+            job();
+        }
+    }
+
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::deque<std::function<void()>> jobs;
+    bool stop = false;
+    std::thread thread;
+};
+
+PrefetchThread& GetPrefetchThread() {
+    // Deliberately never destroyed: files may still be read during static destruction
+    static PrefetchThread* const prefetch_thread = new PrefetchThread;
+    return *prefetch_thread;
+}
+
+} // Anonymous namespace
+
+struct ReadAheadVfsFile::State {
+    explicit State(VirtualFile file) : file(std::move(file)) {}
+
+    /// Starts reading [offset, offset + size) in the background. mutex must be held.
+    void StartPrefetch(std::shared_ptr<State> self, size_t offset, size_t size) {
+        in_flight = true;
+        pending_offset = offset;
+        pending_size = size;
+        GetPrefetchThread().Queue([self = std::move(self), offset, size] {
+            std::vector<u8> data(size);
+            {
+                std::shared_lock<std::shared_mutex> lock(self->file_mutex);
+                data.resize(self->file->Read(data.data(), size, offset));
+            }
+
+            std::lock_guard<std::mutex> lock(self->mutex);
+            self->in_flight = false;
+            if (self->generation_at_start == self->generation) {
+                self->window_offset = offset;
+                self->window = std::move(data);
+            }
+            self->prefetch_done.notify_all();
+        });
+        generation_at_start = generation;
+    }
+
+    /// Copies the part of [offset, offset + length) held in the window. mutex must be held.
+    size_t ReadFromWindow(u8* data, size_t length, size_t offset) const {
+        if (offset < window_offset || offset >= window_offset + window.size()) {
+            return 0;
+        }
+        const size_t available = std::min(length, window_offset + window.size() - offset);
+        std::memcpy(data, window.data() + (offset - window_offset), available);
+        return available;
+    }
+
+    VirtualFile file;
+    /// Keeps writes to the wrapped file from overlapping reads, which may run concurrently
+    std::shared_mutex file_mutex;
+
+    std::mutex mutex;
+    std::condition_variable prefetch_done;
+    /// Data read ahead, starting at window_offset
+    size_t window_offset = 0;
+    std::vector<u8> window;
+    /// Range being read ahead, if in_flight
+    bool in_flight = false;
+    size_t pending_offset = 0;
+    size_t pending_size = 0;
+    /// Bumped by writes, so that prefetches started before them are discarded
+    u64 generation = 0;
+    u64 generation_at_start = 0;
+    /// Where the next read starts if it is sequential, and how many were in a row
+    size_t next_offset = 0;
+    size_t sequential_reads = 0;
+    size_t prefetch_size = MIN_PREFETCH_SIZE;
+};
+
+ReadAheadVfsFile::ReadAheadVfsFile(VirtualFile file)
+    : state(std::make_shared<State>(std::move(file))) {}
+
+ReadAheadVfsFile::~ReadAheadVfsFile() = default;
+
+std::string ReadAheadVfsFile::GetName() const {
+    return state->file->GetName();
+}
+
+size_t ReadAheadVfsFile::GetSize() const {
+    return state->file->GetSize();
+}
+
+bool ReadAheadVfsFile::Resize(size_t new_size) {
+    std::lock_guard<std::shared_mutex> lock(state->file_mutex);
+    return state->file->Resize(new_size);
+}
+
+std::shared_ptr<VfsDirectory> ReadAheadVfsFile::GetContainingDirectory() const {
+    return state->file->GetContainingDirectory();
+}
+
+bool ReadAheadVfsFile::IsWritable() const {
+    return state->file->IsWritable();
+}
+
+bool ReadAheadVfsFile::IsReadable() const {
+    return state->file->IsReadable();
+}
+
+size_t ReadAheadVfsFile::Read(u8* data, size_t length, size_t offset) const {
+    const size_t size = state->file->GetSize();
+    if (offset >= size || length == 0) {
+        return 0;
+    }
+    length = std::min(length, size - offset);
+
+    std::unique_lock<std::mutex> lock(state->mutex);
+
+    // Waiting for data already on its way beats reading it a second time
+    state->prefetch_done.wait(lock, [&] {
+        return !state->in_flight || offset < state->pending_offset ||
+               offset >= state->pending_offset + state->pending_size;
+    });
+
+    const size_t from_window = state->ReadFromWindow(data, length, offset);
+    size_t read = from_window;
+    if (read < length) {
+        std::shared_lock<std::shared_mutex> file_lock(state->file_mutex);
+        read += state->file->Read(data + read, length - read, offset + read);
+    }
+
+    if (offset == state->next_offset) {
+        ++state->sequential_reads;
+    } else {
+        state->sequential_reads = 0;
+        state->prefetch_size = MIN_PREFETCH_SIZE;
+    }
+    state->next_offset = offset + read;
+
+    if (from_window == length) {
+        // The stream keeps up with the read ahead, fetch a larger chunk next time
+        state->prefetch_size = std::min(state->prefetch_size * 2, MAX_PREFETCH_SIZE);
+    }
+
+    // Keep at least half a chunk ahead of the stream
+    const size_t window_end = state->window_offset + state->window.size();
+    const size_t ahead = window_end > state->next_offset ? window_end - state->next_offset : 0;
+    if (state->sequential_reads >= SEQUENTIAL_READS_TO_PREFETCH && !state->in_flight &&
+        ahead < state->prefetch_size / 2 && state->next_offset < size) {
+        const size_t prefetch_size = std::min(state->prefetch_size, size - state->next_offset);
+        state->StartPrefetch(state, state->next_offset, prefetch_size);
+    }
+
+    return read;
+}
+
+size_t ReadAheadVfsFile::Write(const u8* data, size_t length, size_t offset) {
+    {
+        std::lock_guard<std::mutex> lock(state->mutex);
+        ++state->generation;
+        state->window.clear();
+    }
+    std::lock_guard<std::shared_mutex> file_lock(state->file_mutex);
+    return state->file->Write(data, length, offset);
+}
+
+bool ReadAheadVfsFile::Rename(std::string_view name) {
+    return state->file->Rename(name);
+}
+
+VirtualFile CreateReadAhead(VirtualFile file) {
+    if (file == nullptr || file->IsWritable()) {
+        return file;
+    }
+    return std::make_shared<ReadAheadVfsFile>(std::move(file));
+}
+
+} // namespace FileSys
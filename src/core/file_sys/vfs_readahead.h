@@ -0,0 +1,43 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <memory>
+#include <string_view>
+
+#include "core/file_sys/vfs.h"
+
+namespace FileSys {
+
+// An implementation of VfsFile that detects sequential reads of another VfsFile and fetches the
+// data that comes next on a background thread, ahead of the reads asking for it. Meant for game
+// assets streamed in many small reads, so that the latency of the layers below (decryption, slow
+// storage) overlaps with the game consuming the previous data. Safe to read from several threads.
+class ReadAheadVfsFile : public VfsFile {
+public:
+    explicit ReadAheadVfsFile(VirtualFile file);
+    ~ReadAheadVfsFile() override;
+
+    std::string GetName() const override;
+    size_t GetSize() const override;
+    bool Resize(size_t new_size) override;
+    std::shared_ptr<VfsDirectory> GetContainingDirectory() const override;
+    bool IsWritable() const override;
+    bool IsReadable() const override;
+    size_t Read(u8* data, size_t length, size_t offset) const override;
+    size_t Write(const u8* data, size_t length, size_t offset) override;
+    bool Rename(std::string_view name) override;
+
+private:
+    struct State;
+
+    /// Shared with prefetches still in flight, which may outlive this file
+    std::shared_ptr<State> state;
+};
+
+/// Wraps file in a ReadAheadVfsFile if it is read-only, otherwise returns it as is
+VirtualFile CreateReadAhead(VirtualFile file);
+
+} // namespace FileSys
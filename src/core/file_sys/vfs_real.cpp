@@ -3,8 +3,11 @@
 // Refer to the license.txt file included.
 
 #include <algorithm>
+#include <array>
 #include <cstddef>
+#include <functional>
 #include <iterator>
+#include <mutex>
 #include <utility>
 #include "common/assert.h"
 #include "common/common_paths.h"
@@ -13,6 +16,16 @@
 
 namespace FileSys {
 
+/**
+ * Reads and writes of an IOFile are a seek followed by the transfer, which must not be interleaved
+ * with those of another thread. RealVfsFiles of the same path share their IOFile, so the lock
+ * belongs to the IOFile rather than to the RealVfsFile: it is picked from a fixed set by address.
+ */
+static std::mutex& GetBackingMutex(const FileUtil::IOFile* backing) {
+    static std::array<std::mutex, 16> mutexes;
+    return mutexes[std::hash<const FileUtil::IOFile*>{}(backing) % mutexes.size()];
+}
+
 static std::string ModeFlagsToString(Mode mode) {
     std::string mode_str;
 
@@ -65,7 +78,7 @@ VfsEntryType RealVfsFilesystem::GetEntryType(std::string_view path_) const {
 VirtualFile RealVfsFilesystem::OpenFile(std::string_view path_, Mode perms) {
     const auto path = FileUtil::SanitizePath(path_, FileUtil::DirectorySeparator::PlatformDefault);
     if (cache.find(path) != cache.end()) {
-        auto weak = cache[path];
+        auto weak = cache[path].file;
         if (!weak.expired()) {
             return std::shared_ptr<RealVfsFile>(new RealVfsFile(*this, weak.lock(), path, perms));
         }
@@ -75,12 +88,36 @@ VirtualFile RealVfsFilesystem::OpenFile(std::string_view path_, Mode perms) {
         FileUtil::CreateEmptyFile(path);
 
     auto backing = std::make_shared<FileUtil::IOFile>(path, ModeFlagsToString(perms).c_str());
-    cache[path] = backing;
+    cache[path].file = backing;
 
     // Cannot use make_shared as RealVfsFile constructor is private
     return std::shared_ptr<RealVfsFile>(new RealVfsFile(*this, backing, path, perms));
 }
 
+VirtualFile RealVfsFilesystem::OpenImmutableFile(std::string_view path_) {
+    const auto path = FileUtil::SanitizePath(path_, FileUtil::DirectorySeparator::PlatformDefault);
+    if (cache.find(path) != cache.end()) {
+        const auto& cached = cache[path];
+        // A file that is open through stdio may be written, so it has to be read the same way
+        if (!cached.file.expired()) {
+            return OpenFile(path, Mode::Read);
+        }
+        if (!cached.mapping.expired()) {
+            return std::shared_ptr<RealVfsReadOnlyFile>(
+                new RealVfsReadOnlyFile(*this, cached.mapping.lock(), path));
+        }
+    }
+
+    auto mapping = std::make_shared<FileUtil::MappedFile>(path);
+    if (!mapping->IsOpen()) {
+        return OpenFile(path, Mode::Read);
+    }
+    cache[path].mapping = mapping;
+
+    // Cannot use make_shared as RealVfsReadOnlyFile constructor is private
+    return std::shared_ptr<RealVfsReadOnlyFile>(new RealVfsReadOnlyFile(*this, mapping, path));
+}
+
 VirtualFile RealVfsFilesystem::CreateFile(std::string_view path_, Mode perms) {
     const auto path = FileUtil::SanitizePath(path_, FileUtil::DirectorySeparator::PlatformDefault);
     const auto path_fwd = FileUtil::SanitizePath(path, FileUtil::DirectorySeparator::ForwardSlash);
@@ -111,17 +148,35 @@ VirtualFile RealVfsFilesystem::MoveFile(std::string_view old_path_, std::string_
         FileUtil::SanitizePath(new_path_, FileUtil::DirectorySeparator::PlatformDefault);
 
     if (!FileUtil::Exists(old_path) || FileUtil::Exists(new_path) ||
-        FileUtil::IsDirectory(old_path) || !FileUtil::Rename(old_path, new_path))
+        FileUtil::IsDirectory(old_path))
+        return nullptr;
+
+    // A mapped file can't be renamed on every host, so the mapping is released for the rename
+    std::shared_ptr<FileUtil::MappedFile> mapping;
+    if (cache.find(old_path) != cache.end()) {
+        mapping = cache[old_path].mapping.lock();
+    }
+    if (mapping != nullptr) {
+        mapping->Close();
+    }
+
+    if (!FileUtil::Rename(old_path, new_path)) {
+        if (mapping != nullptr) {
+            mapping->Open(old_path);
+        }
         return nullptr;
+    }
 
     if (cache.find(old_path) != cache.end()) {
-        auto cached = cache[old_path];
-        if (!cached.expired()) {
-            auto file = cached.lock();
-            file->Open(new_path, "r+b");
-            cache.erase(old_path);
-            cache[new_path] = file;
+        const auto cached = cache[old_path];
+        if (!cached.file.expired()) {
+            cached.file.lock()->Open(new_path, "r+b");
+        }
+        if (mapping != nullptr) {
+            mapping->Open(new_path);
         }
+        cache.erase(old_path);
+        cache[new_path] = cached;
     }
     return OpenFile(new_path, Mode::ReadWrite);
 }
@@ -129,8 +184,10 @@ VirtualFile RealVfsFilesystem::MoveFile(std::string_view old_path_, std::string_
 bool RealVfsFilesystem::DeleteFile(std::string_view path_) {
     const auto path = FileUtil::SanitizePath(path_, FileUtil::DirectorySeparator::PlatformDefault);
     if (cache.find(path) != cache.end()) {
-        if (!cache[path].expired())
-            cache[path].lock()->Close();
+        if (!cache[path].file.expired())
+            cache[path].file.lock()->Close();
+        if (!cache[path].mapping.expired())
+            cache[path].mapping.lock()->Close();
         cache.erase(path);
     }
     return FileUtil::Delete(path);
@@ -186,11 +243,15 @@ VirtualDir RealVfsFilesystem::MoveDirectory(std::string_view old_path_,
                 FileUtil::SanitizePath(new_path + DIR_SEP + kv.first.substr(old_path.size()),
                                        FileUtil::DirectorySeparator::PlatformDefault);
             auto cached = cache[file_old_path];
-            if (!cached.expired()) {
-                auto file = cached.lock();
-                file->Open(file_new_path, "r+b");
+            if (!cached.file.expired()) {
+                cached.file.lock()->Open(file_new_path, "r+b");
+            }
+            if (!cached.mapping.expired()) {
+                cached.mapping.lock()->Open(file_new_path);
+            }
+            if (!cached.file.expired() || !cached.mapping.expired()) {
                 cache.erase(file_old_path);
-                cache[file_new_path] = file;
+                cache[file_new_path] = cached;
             }
         }
     }
@@ -203,8 +264,10 @@ bool RealVfsFilesystem::DeleteDirectory(std::string_view path_) {
     for (auto& kv : cache) {
         // Path in cache starts with old_path
         if (kv.first.rfind(path, 0) == 0) {
-            if (!cache[kv.first].expired())
-                cache[kv.first].lock()->Close();
+            if (!cache[kv.first].file.expired())
+                cache[kv.first].file.lock()->Close();
+            if (!cache[kv.first].mapping.expired())
+                cache[kv.first].mapping.lock()->Close();
             cache.erase(kv.first);
         }
     }
@@ -228,6 +291,7 @@ size_t RealVfsFile::GetSize() const {
 }
 
 bool RealVfsFile::Resize(size_t new_size) {
+    std::lock_guard<std::mutex> lock(GetBackingMutex(backing.get()));
     return backing->Resize(new_size);
 }
 
@@ -244,12 +308,14 @@ bool RealVfsFile::IsReadable() const {
 }
 
 size_t RealVfsFile::Read(u8* data, size_t length, size_t offset) const {
+    std::lock_guard<std::mutex> lock(GetBackingMutex(backing.get()));
     if (!backing->Seek(offset, SEEK_SET))
         return 0;
     return backing->ReadBytes(data, length);
 }
 
 size_t RealVfsFile::Write(const u8* data, size_t length, size_t offset) {
+    std::lock_guard<std::mutex> lock(GetBackingMutex(backing.get()));
     if (!backing->Seek(offset, SEEK_SET))
         return 0;
     return backing->WriteBytes(data, length);
@@ -263,21 +329,71 @@ bool RealVfsFile::Close() {
     return backing->Close();
 }
 
+RealVfsReadOnlyFile::RealVfsReadOnlyFile(RealVfsFilesystem& base_,
+                                         std::shared_ptr<FileUtil::MappedFile> backing_,
+                                         const std::string& path_)
+    : base(base_), backing(std::move(backing_)), path(path_),
+      parent_path(FileUtil::GetParentPath(path_)),
+      path_components(FileUtil::SplitPathComponents(path_)) {}
+
+std::string RealVfsReadOnlyFile::GetName() const {
+    return path_components.back();
+}
+
+size_t RealVfsReadOnlyFile::GetSize() const {
+    return static_cast<size_t>(backing->GetSize());
+}
+
+bool RealVfsReadOnlyFile::Resize(size_t new_size) {
+    return false;
+}
+
+std::shared_ptr<VfsDirectory> RealVfsReadOnlyFile::GetContainingDirectory() const {
+    return base.OpenDirectory(parent_path, Mode::Read);
+}
+
+bool RealVfsReadOnlyFile::IsWritable() const {
+    return false;
+}
+
+bool RealVfsReadOnlyFile::IsReadable() const {
+    return true;
+}
+
+size_t RealVfsReadOnlyFile::Read(u8* data, size_t length, size_t offset) const {
+    return backing->ReadAt(data, length, offset);
+}
+
+size_t RealVfsReadOnlyFile::Write(const u8* data, size_t length, size_t offset) {
+    return 0;
+}
+
+bool RealVfsReadOnlyFile::Rename(std::string_view name) {
+    const std::string new_path = parent_path + DIR_SEP + std::string(name);
+    if (base.MoveFile(path, new_path) == nullptr) {
+        return false;
+    }
+
+    path = FileUtil::SanitizePath(new_path, FileUtil::DirectorySeparator::PlatformDefault);
+    path_components = FileUtil::SplitPathComponents(path);
+    return true;
+}
+
 // TODO(DarkLordZach): MSVC would not let me combine the following two functions using 'if
 // constexpr' because there is a compile error in the branch not used.
 
 template <>
-std::vector<VirtualFile> RealVfsDirectory::IterateEntries<RealVfsFile, VfsFile>() const {
+std::vector<VirtualFile> RealVfsDirectory::OpenEntries<RealVfsFile, VfsFile>() const {
     if (perms == Mode::Append)
         return {};
 
     std::vector<VirtualFile> out;
     FileUtil::ForeachDirectoryEntry(
         nullptr, path,
-        [&out, this](u64* entries_out, const std::string& directory, const std::string& filename) {
-            const std::string full_path = directory + DIR_SEP + filename;
-            if (!FileUtil::IsDirectory(full_path))
-                out.emplace_back(base.OpenFile(full_path, perms));
+        [&out, this](u64* entries_out, const std::string& directory, const std::string& filename,
+                     bool is_directory) {
+            if (!is_directory)
+                out.emplace_back(base.OpenFile(directory + DIR_SEP + filename, perms));
             return true;
         });
 
@@ -285,17 +401,17 @@ std::vector<VirtualFile> RealVfsDirectory::IterateEntries<RealVfsFile, VfsFile>(
 }
 
 template <>
-std::vector<VirtualDir> RealVfsDirectory::IterateEntries<RealVfsDirectory, VfsDirectory>() const {
+std::vector<VirtualDir> RealVfsDirectory::OpenEntries<RealVfsDirectory, VfsDirectory>() const {
     if (perms == Mode::Append)
         return {};
 
     std::vector<VirtualDir> out;
     FileUtil::ForeachDirectoryEntry(
         nullptr, path,
-        [&out, this](u64* entries_out, const std::string& directory, const std::string& filename) {
-            const std::string full_path = directory + DIR_SEP + filename;
-            if (FileUtil::IsDirectory(full_path))
-                out.emplace_back(base.OpenDirectory(full_path, perms));
+        [&out, this](u64* entries_out, const std::string& directory, const std::string& filename,
+                     bool is_directory) {
+            if (is_directory)
+                out.emplace_back(base.OpenDirectory(directory + DIR_SEP + filename, perms));
             return true;
         });
 
@@ -351,11 +467,40 @@ bool RealVfsDirectory::DeleteSubdirectoryRecursive(std::string_view name) {
 }
 
 std::vector<std::shared_ptr<VfsFile>> RealVfsDirectory::GetFiles() const {
-    return IterateEntries<RealVfsFile, VfsFile>();
+    return OpenEntries<RealVfsFile, VfsFile>();
 }
 
 std::vector<std::shared_ptr<VfsDirectory>> RealVfsDirectory::GetSubdirectories() const {
-    return IterateEntries<RealVfsDirectory, VfsDirectory>();
+    return OpenEntries<RealVfsDirectory, VfsDirectory>();
+}
+
+bool RealVfsDirectory::IterateEntries(const EntryCallback& callback) const {
+    if (perms == Mode::Append)
+        return true;
+
+    // Files are reported as they're found, directories once all of them have been
+    std::vector<std::string> subdirectories;
+    bool stopped = false;
+    FileUtil::ForeachDirectoryEntry(
+        nullptr, path,
+        [&](u64* entries_out, const std::string& directory, const std::string& filename,
+            bool is_directory) {
+            if (is_directory) {
+                subdirectories.push_back(filename);
+                return true;
+            }
+            stopped = !callback(filename, VfsEntryType::File,
+                                FileUtil::GetSize(directory + DIR_SEP + filename));
+            return !stopped;
+        });
+    if (stopped)
+        return false;
+
+    for (const auto& subdirectory : subdirectories) {
+        if (!callback(subdirectory, VfsEntryType::Directory, 0))
+            return false;
+    }
+    return true;
 }
 
 bool RealVfsDirectory::IsWritable() const {
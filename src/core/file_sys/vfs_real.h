@@ -7,6 +7,7 @@
 #include <string_view>
 #include <boost/container/flat_map.hpp>
 #include "common/file_util.h"
+#include "common/mapped_file.h"
 #include "core/file_sys/mode.h"
 #include "core/file_sys/vfs.h"
 
@@ -21,6 +22,7 @@ public:
     bool IsWritable() const override;
     VfsEntryType GetEntryType(std::string_view path) const override;
     VirtualFile OpenFile(std::string_view path, Mode perms = Mode::Read) override;
+    VirtualFile OpenImmutableFile(std::string_view path) override;
     VirtualFile CreateFile(std::string_view path, Mode perms = Mode::ReadWrite) override;
     VirtualFile CopyFile(std::string_view old_path, std::string_view new_path) override;
     VirtualFile MoveFile(std::string_view old_path, std::string_view new_path) override;
@@ -32,7 +34,14 @@ public:
     bool DeleteDirectory(std::string_view path) override;
 
 private:
-    boost::container::flat_map<std::string, std::weak_ptr<FileUtil::IOFile>> cache;
+    /// Host files that are open, shared by the VfsFiles of the same path
+    struct CachedFile {
+        std::weak_ptr<FileUtil::IOFile> file;
+        /// Mapping of a file opened with OpenImmutableFile
+        std::weak_ptr<FileUtil::MappedFile> mapping;
+    };
+
+    boost::container::flat_map<std::string, CachedFile> cache;
 };
 
 // An implmentation of VfsFile that represents a file on the user's computer.
@@ -66,6 +75,34 @@ private:
     Mode perms;
 };
 
+// An implementation of VfsFile for files on the user's computer opened with OpenImmutableFile,
+// such as title images. Reads go through a memory mapping, or positional reads if the file could
+// not be mapped, so they neither share a file position nor copy through a stdio buffer.
+class RealVfsReadOnlyFile : public VfsFile {
+    friend class RealVfsFilesystem;
+
+    RealVfsReadOnlyFile(RealVfsFilesystem& base, std::shared_ptr<FileUtil::MappedFile> backing,
+                        const std::string& path);
+
+public:
+    std::string GetName() const override;
+    size_t GetSize() const override;
+    bool Resize(size_t new_size) override;
+    std::shared_ptr<VfsDirectory> GetContainingDirectory() const override;
+    bool IsWritable() const override;
+    bool IsReadable() const override;
+    size_t Read(u8* data, size_t length, size_t offset) const override;
+    size_t Write(const u8* data, size_t length, size_t offset) override;
+    bool Rename(std::string_view name) override;
+
+private:
+    RealVfsFilesystem& base;
+    std::shared_ptr<FileUtil::MappedFile> backing;
+    std::string path;
+    std::string parent_path;
+    std::vector<std::string> path_components;
+};
+
 // An implementation of VfsDirectory that represents a directory on the user's computer.
 class RealVfsDirectory : public VfsDirectory {
     friend class RealVfsFilesystem;
@@ -82,6 +119,7 @@ public:
     bool DeleteSubdirectoryRecursive(std::string_view name) override;
     std::vector<std::shared_ptr<VfsFile>> GetFiles() const override;
     std::vector<std::shared_ptr<VfsDirectory>> GetSubdirectories() const override;
+    bool IterateEntries(const EntryCallback& callback) const override;
     bool IsWritable() const override;
     bool IsReadable() const override;
     std::string GetName() const override;
@@ -98,7 +136,7 @@ protected:
 
 private:
     template <typename T, typename R>
-    std::vector<std::shared_ptr<R>> IterateEntries() const;
+    std::vector<std::shared_ptr<R>> OpenEntries() const;
 
     RealVfsFilesystem& base;
     std::string path;
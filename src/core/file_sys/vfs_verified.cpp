@@ -0,0 +1,136 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <cstring>
+#include <utility>
+#include <mbedtls/sha256.h>
+
+#include "common/logging/log.h"
+#include "core/crypto/key_manager.h"
+#include "core/file_sys/vfs_verified.h"
+
+namespace FileSys {
+
+HashVerifiedVfsFile::HashVerifiedVfsFile(VirtualFile file_, VirtualFile hashes_, size_t block_size,
+                                         bool pad_last_block)
+    : file(std::move(file_)), hashes(std::move(hashes_)), block_size(block_size),
+      pad_last_block(pad_last_block),
+      verified((file->GetSize() + block_size - 1) / block_size, false) {}
+
+std::string HashVerifiedVfsFile::GetName() const {
+    return file->GetName();
+}
+
+size_t HashVerifiedVfsFile::GetSize() const {
+    return file->GetSize();
+}
+
+bool HashVerifiedVfsFile::Resize(size_t new_size) {
+    return false;
+}
+
+std::shared_ptr<VfsDirectory> HashVerifiedVfsFile::GetContainingDirectory() const {
+    return file->GetContainingDirectory();
+}
+
+bool HashVerifiedVfsFile::IsWritable() const {
+    return false;
+}
+
+bool HashVerifiedVfsFile::IsReadable() const {
+    return file->IsReadable();
+}
+
+size_t HashVerifiedVfsFile::Read(u8* data, size_t length, size_t offset) const {
+    const size_t size = file->GetSize();
+    if (offset >= size || length == 0) {
+        return 0;
+    }
+    length = std::min(length, size - offset);
+
+    std::vector<u8> block;
+    size_t done = 0;
+    while (done < length) {
+        const size_t position = offset + done;
+        const size_t index = position / block_size;
+
+        if (IsVerified(index)) {
+            // Runs of blocks that were checked before are read in one go
+            size_t end_block = index + 1;
+            while (end_block * block_size < offset + length && IsVerified(end_block)) {
+                ++end_block;
+            }
+            const size_t run = std::min(offset + length, end_block * block_size) - position;
+            const size_t read = file->Read(data + done, run, position);
+            done += read;
+            if (read != run) {
+                break;
+            }
+            continue;
+        }
+
+        // The block had to be read to hash it, so the data is taken from there
+        if (!VerifyBlock(index, block)) {
+            // Whatever comes before the corrupted block can still be read
+            break;
+        }
+        const size_t block_offset = position - index * block_size;
+        const size_t chunk = std::min(length - done, block_size - block_offset);
+        std::memcpy(data + done, block.data() + block_offset, chunk);
+        done += chunk;
+    }
+
+    return done;
+}
+
+size_t HashVerifiedVfsFile::Write(const u8* data, size_t length, size_t offset) {
+    return 0;
+}
+
+bool HashVerifiedVfsFile::Rename(std::string_view name) {
+    return false;
+}
+
+bool HashVerifiedVfsFile::IsVerified(size_t index) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return verified[index];
+}
+
+bool HashVerifiedVfsFile::VerifyBlock(size_t index, std::vector<u8>& block) const {
+    // The last block is read short, but the caller only copies what the file holds
+    const size_t block_offset = index * block_size;
+    const size_t read_size = std::min(block_size, file->GetSize() - block_offset);
+    block.resize(read_size);
+    if (file->Read(block.data(), read_size, block_offset) != read_size) {
+        LOG_CRITICAL(Service_FS, "Block {} of {} could not be read", index, file->GetName());
+        return false;
+    }
+    if (pad_last_block) {
+        block.resize(block_size);
+    }
+
+    Core::Crypto::SHA256Hash expected{};
+    Core::Crypto::SHA256Hash hash{};
+    if (hashes->Read(expected.data(), expected.size(), index * expected.size()) !=
+        expected.size()) {
+        LOG_CRITICAL(Service_FS,
+                     "The hash of block {} of {} could not be read, the file is corrupt", index,
+                     file->GetName());
+        return false;
+    }
+
+    mbedtls_sha256(block.data(), block.size(), hash.data(), 0);
+    if (hash != expected) {
+        LOG_CRITICAL(Service_FS, "Block {} of {} does not match its hash, the file is corrupt",
+                     index, file->GetName());
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    verified[index] = true;
+    return true;
+}
+
+} // namespace FileSys
@@ -0,0 +1,59 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <vector>
+
+#include "core/file_sys/vfs.h"
+
+namespace FileSys {
+
+// An implementation of VfsFile that checks each block of another VfsFile against a table of
+// SHA-256 hashes the first time it is read, such as a level of the hash tree of an NCA section.
+// Reads stop short at the first block that doesn't match, so corrupted dumps are caught where they
+// are read instead of being handed to the game. Read-only.
+class HashVerifiedVfsFile : public VfsFile {
+public:
+    /**
+     * @param file The file to verify
+     * @param hashes The expected hashes of the blocks of file, one after another. Usually verified
+     *        itself, by the level of the tree above.
+     * @param block_size Size of the blocks a hash covers
+     * @param pad_last_block Whether a last block shorter than block_size is hashed padded to a
+     *        whole block with zeroes, as in IVFC trees, instead of as it is
+     */
+    HashVerifiedVfsFile(VirtualFile file, VirtualFile hashes, size_t block_size,
+                        bool pad_last_block);
+
+    std::string GetName() const override;
+    size_t GetSize() const override;
+    bool Resize(size_t new_size) override;
+    std::shared_ptr<VfsDirectory> GetContainingDirectory() const override;
+    bool IsWritable() const override;
+    bool IsReadable() const override;
+    size_t Read(u8* data, size_t length, size_t offset) const override;
+    size_t Write(const u8* data, size_t length, size_t offset) override;
+    bool Rename(std::string_view name) override;
+
+private:
+    bool IsVerified(size_t index) const;
+
+    /// Reads the block into block and checks it against its hash
+    bool VerifyBlock(size_t index, std::vector<u8>& block) const;
+
+    VirtualFile file;
+    VirtualFile hashes;
+    size_t block_size;
+    bool pad_last_block;
+
+    mutable std::mutex mutex;
+    /// Blocks that matched their hash, which are never hashed again
+    mutable std::vector<bool> verified;
+};
+
+} // namespace FileSys
@@ -0,0 +1,583 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <boost/optional.hpp>
+
+#include "common/logging/log.h"
+#include "common/thread.h"
+#include "core/file_sys/vfs_writeback.h"
+
+namespace FileSys {
+
+/// Suffixes of the files holding the new contents of a file while it is written back
+constexpr std::string_view TEMPORARY_SUFFIX = ".yuzu_wb_tmp";
+constexpr std::string_view JOURNAL_SUFFIX = ".yuzu_wb_journal";
+/// Time after which files written to are written back even if they were not committed
+constexpr std::chrono::seconds WRITE_BACK_INTERVAL{5};
+
+namespace {
+
+bool EndsWith(std::string_view str, std::string_view suffix) {
+    return str.size() >= suffix.size() && str.substr(str.size() - suffix.size()) == suffix;
+}
+
+bool IsInternalFile(std::string_view name) {
+    return EndsWith(name, TEMPORARY_SUFFIX) || EndsWith(name, JOURNAL_SUFFIX);
+}
+
+/// Moves a complete journal over the file it was written for. Returns the replaced file.
+VirtualFile ReplayJournal(const VirtualDir& dir, const VirtualFile& journal,
+                          const std::string& name) {
+    if (dir->GetFile(name) != nullptr && !dir->DeleteFile(name)) {
+        return nullptr;
+    }
+    if (!journal->Rename(name)) {
+        return nullptr;
+    }
+    return dir->GetFile(name);
+}
+
+/// Cleans up after the write backs under dir that were interrupted, e.g. by a crash
+void RecoverJournals(const VirtualDir& dir) {
+    for (const auto& file : dir->GetFiles()) {
+        const std::string name = file->GetName();
+        if (EndsWith(name, TEMPORARY_SUFFIX)) {
+            // Never completed, so the original is still intact
+            dir->DeleteFile(name);
+        } else if (EndsWith(name, JOURNAL_SUFFIX)) {
+            LOG_WARNING(Service_FS, "Completing the interrupted write back of {}",
+                        file->GetFullPath());
+            ReplayJournal(dir, file, name.substr(0, name.size() - JOURNAL_SUFFIX.size()));
+        }
+    }
+
+    for (const auto& subdir : dir->GetSubdirectories()) {
+        RecoverJournals(subdir);
+    }
+}
+
+/**
+ * Replaces the contents of file with data, such that a crash at any point leaves either the old or
+ * the new contents behind. Returns the file holding the new contents, or nullptr on failure.
+ */
+VirtualFile WriteAtomically(const VirtualFile& file, const std::vector<u8>& data) {
+    const auto dir = file->GetContainingDirectory();
+    if (dir == nullptr) {
+        return nullptr;
+    }
+
+    const std::string name = file->GetName();
+    const std::string temporary_name = name + std::string(TEMPORARY_SUFFIX);
+    const std::string journal_name = name + std::string(JOURNAL_SUFFIX);
+
+    auto temporary = dir->GetFile(temporary_name);
+    if (temporary == nullptr) {
+        temporary = dir->CreateFile(temporary_name);
+    }
+    if (temporary == nullptr || !temporary->Resize(data.size()) ||
+        temporary->WriteBytes(data) != data.size()) {
+        dir->DeleteFile(temporary_name);
+        return nullptr;
+    }
+
+    // A journal left by an earlier failed attempt holds older contents
+    if (dir->GetFile(journal_name) != nullptr && !dir->DeleteFile(journal_name)) {
+        return nullptr;
+    }
+    if (!temporary->Rename(journal_name)) {
+        dir->DeleteFile(temporary_name);
+        return nullptr;
+    }
+
+    // From here on, the new contents survive a crash
+    const auto journal = dir->GetFile(journal_name);
+    return journal == nullptr ? nullptr : ReplayJournal(dir, journal, name);
+}
+
+} // Anonymous namespace
+
+// One file of a write back tree, shared by every lookup of the same path. Its contents are loaded
+// on the first change and stay in memory from then on.
+class WriteBackVfsFile final : public VfsFile {
+public:
+    WriteBackVfsFile(std::weak_ptr<WriteBackCache> cache, std::string path, VirtualFile base)
+        : cache(std::move(cache)), path(std::move(path)), base(std::move(base)) {}
+
+    std::string GetName() const override {
+        std::lock_guard<std::mutex> lock(mutex);
+        return base->GetName();
+    }
+
+    size_t GetSize() const override {
+        std::lock_guard<std::mutex> lock(mutex);
+        return contents ? contents->size() : base->GetSize();
+    }
+
+    bool Resize(size_t new_size) override {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (discarded) {
+            return false;
+        }
+        if (detached) {
+            return base->Resize(new_size);
+        }
+
+        Load();
+        contents->resize(new_size);
+        dirty = true;
+        return true;
+    }
+
+    std::shared_ptr<VfsDirectory> GetContainingDirectory() const override;
+
+    bool IsWritable() const override {
+        std::lock_guard<std::mutex> lock(mutex);
+        return base->IsWritable();
+    }
+
+    bool IsReadable() const override {
+        std::lock_guard<std::mutex> lock(mutex);
+        return base->IsReadable();
+    }
+
+    size_t Read(u8* data, size_t length, size_t offset) const override {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (discarded) {
+            return 0;
+        }
+        if (!contents) {
+            return base->Read(data, length, offset);
+        }
+
+        if (offset >= contents->size()) {
+            return 0;
+        }
+        const size_t read_size = std::min(length, contents->size() - offset);
+        std::memcpy(data, contents->data() + offset, read_size);
+        return read_size;
+    }
+
+    size_t Write(const u8* data, size_t length, size_t offset) override {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (discarded) {
+            return 0;
+        }
+        if (detached) {
+            return base->Write(data, length, offset);
+        }
+
+        Load();
+        if (offset + length > contents->size()) {
+            contents->resize(offset + length);
+        }
+        std::memcpy(contents->data() + offset, data, length);
+        dirty = true;
+        return length;
+    }
+
+    bool Rename(std::string_view name) override;
+
+    /// Writes the contents to the backing file if they changed. Returns false if that failed.
+    bool WriteBack() {
+        std::lock_guard<std::mutex> write_back_lock(write_back_mutex);
+        return WriteBackLocked();
+    }
+
+    bool IsDirty() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return dirty;
+    }
+
+    /// Drops the pending changes, as the backing file is about to be deleted
+    void Discard() {
+        std::lock_guard<std::mutex> write_back_lock(write_back_mutex);
+        std::lock_guard<std::mutex> lock(mutex);
+        discarded = true;
+        dirty = false;
+        contents = boost::none;
+    }
+
+    /// Lets every further change through to the backing file, as the cache is gone
+    void Detach() {
+        std::lock_guard<std::mutex> write_back_lock(write_back_mutex);
+        std::lock_guard<std::mutex> lock(mutex);
+        if (dirty) {
+            // The write back failed, a plain write is the last chance to keep the changes
+            LOG_ERROR(Service_FS, "Writing {} back in place", path);
+            base->Resize(contents->size());
+            base->WriteBytes(*contents);
+        }
+        detached = true;
+        dirty = false;
+        contents = boost::none;
+    }
+
+private:
+    /// Loads the backing file into memory unless that happened already. mutex must be held.
+    void Load() {
+        if (!contents) {
+            contents = base->ReadAllBytes();
+        }
+    }
+
+    /// write_back_mutex must be held
+    bool WriteBackLocked() {
+        std::vector<u8> snapshot;
+        VirtualFile target;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!dirty) {
+                return true;
+            }
+            snapshot = *contents;
+            target = base;
+            dirty = false;
+        }
+
+        // Changes made in the meantime make the file dirty again and are written next time
+        auto written = WriteAtomically(target, snapshot);
+
+        std::lock_guard<std::mutex> lock(mutex);
+        if (written == nullptr) {
+            LOG_ERROR(Service_FS, "Could not write back {}", path);
+            dirty = true;
+            return false;
+        }
+        base = std::move(written);
+        if (!dirty) {
+            // Only files with pending changes are kept in memory, the next change loads it again
+            contents = boost::none;
+        }
+        return true;
+    }
+
+    std::weak_ptr<WriteBackCache> cache;
+
+    /// Held while writing to the backing file, so that it is not swapped out in the meantime
+    std::mutex write_back_mutex;
+
+    mutable std::mutex mutex;
+    std::string path;
+    VirtualFile base;
+    boost::optional<std::vector<u8>> contents;
+    bool dirty = false;
+    bool discarded = false;
+    bool detached = false;
+};
+
+// State shared by all the files and directories of a write back tree
+class WriteBackCache final : public std::enable_shared_from_this<WriteBackCache> {
+public:
+    explicit WriteBackCache(std::string root_path)
+        : root_path(std::move(root_path)), thread{[this] { ThreadLoop(); }} {}
+
+    ~WriteBackCache() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stop = true;
+        }
+        cv.notify_one();
+        thread.join();
+
+        WriteBackAll();
+        for (const auto& entry : files) {
+            entry.second->Detach();
+        }
+    }
+
+    const std::string& GetRootPath() const {
+        return root_path;
+    }
+
+    /// Returns the file of dir wrapping file, the same one for every lookup of its path
+    VirtualFile Wrap(const VirtualDir& dir, VirtualFile file) {
+        std::string path = dir->GetFullPath() + '/' + file->GetName();
+
+        std::lock_guard<std::mutex> lock(mutex);
+        auto& entry = files[path];
+        if (entry == nullptr) {
+            entry = std::make_shared<WriteBackVfsFile>(weak_from_this(), std::move(path),
+                                                       std::move(file));
+        }
+        return entry;
+    }
+
+    /// Wakes the write back thread up to write every pending change
+    void RequestWriteBack() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            write_back_requested = true;
+        }
+        cv.notify_one();
+    }
+
+    /// Writes every pending change to the backing tree before returning
+    void WriteBackAll() {
+        for (const auto& file : GetFiles()) {
+            file->WriteBack();
+        }
+        ForgetUnusedFiles();
+    }
+
+    /// Drops the pending changes of the file at path, or of everything under the directory there
+    void Discard(const std::string& path) {
+        for (const auto& file : Remove(path)) {
+            file->Discard();
+        }
+    }
+
+    /// Writes back and forgets the files under the directory at path, which is about to move
+    void Release(const std::string& path) {
+        WriteBackAll();
+        for (const auto& file : Remove(path)) {
+            file->Detach();
+        }
+    }
+
+    /// Files the file at old_path under new_path, after it was renamed
+    void Move(const std::string& old_path, const std::string& new_path) {
+        std::lock_guard<std::mutex> lock(mutex);
+        const auto iter = files.find(old_path);
+        if (iter != files.end()) {
+            files[new_path] = std::move(iter->second);
+            files.erase(iter);
+        }
+    }
+
+private:
+    void ThreadLoop() {
+        Common::SetCurrentThreadName("VfsWriteBack");
+        std::unique_lock<std::mutex> lock(mutex);
+        while (true) {
+            cv.wait_for(lock, WRITE_BACK_INTERVAL, [this] { return stop || write_back_requested; });
+            if (stop) {
+                return;
+            }
+            write_back_requested = false;
+
+            lock.unlock();
+            WriteBackAll();
+            lock.lock();
+        }
+    }
+
+    /// Drops the entries of files that are written back and no longer open, so the map stays small
+    void ForgetUnusedFiles() {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (auto iter = files.begin(); iter != files.end();) {
+            if (iter->second.use_count() == 1 && !iter->second->IsDirty()) {
+                iter = files.erase(iter);
+            } else {
+                ++iter;
+            }
+        }
+    }
+
+    std::vector<std::shared_ptr<WriteBackVfsFile>> GetFiles() {
+        std::lock_guard<std::mutex> lock(mutex);
+        std::vector<std::shared_ptr<WriteBackVfsFile>> out;
+        out.reserve(files.size());
+        for (const auto& entry : files) {
+            out.push_back(entry.second);
+        }
+        return out;
+    }
+
+    /// Takes the entries of path and of everything under it out of the map
+    std::vector<std::shared_ptr<WriteBackVfsFile>> Remove(const std::string& path) {
+        std::lock_guard<std::mutex> lock(mutex);
+        std::vector<std::shared_ptr<WriteBackVfsFile>> out;
+        const std::string prefix = path + '/';
+        for (auto iter = files.lower_bound(path); iter != files.end();) {
+            if (iter->first != path && iter->first.compare(0, prefix.size(), prefix) != 0) {
+                // Siblings such as "path.bin" sort between path and its children
+                if (iter->first.compare(0, path.size(), path) != 0) {
+                    break;
+                }
+                ++iter;
+                continue;
+            }
+            out.push_back(std::move(iter->second));
+            iter = files.erase(iter);
+        }
+        return out;
+    }
+
+    const std::string root_path;
+
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::map<std::string, std::shared_ptr<WriteBackVfsFile>> files;
+    bool write_back_requested = false;
+    bool stop = false;
+    std::thread thread;
+};
+
+std::shared_ptr<VfsDirectory> WriteBackVfsFile::GetContainingDirectory() const {
+    VirtualDir dir;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        dir = base->GetContainingDirectory();
+    }
+
+    const auto locked_cache = cache.lock();
+    if (dir == nullptr || locked_cache == nullptr) {
+        return dir;
+    }
+    return std::make_shared<WriteBackVfsDirectory>(locked_cache, std::move(dir));
+}
+
+bool WriteBackVfsFile::Rename(std::string_view name) {
+    std::lock_guard<std::mutex> write_back_lock(write_back_mutex);
+    if (!WriteBackLocked()) {
+        return false;
+    }
+
+    std::string old_path;
+    std::string new_path;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        const auto dir = base->GetContainingDirectory();
+        if (discarded || dir == nullptr || !base->Rename(name)) {
+            return false;
+        }
+
+        auto renamed = dir->GetFile(name);
+        if (renamed == nullptr) {
+            return false;
+        }
+        base = std::move(renamed);
+        old_path = std::move(path);
+        path = dir->GetFullPath() + '/' + std::string(name);
+        new_path = path;
+    }
+
+    if (const auto locked_cache = cache.lock()) {
+        locked_cache->Move(old_path, new_path);
+    }
+    return true;
+}
+
+WriteBackVfsDirectory::WriteBackVfsDirectory(VirtualDir base_) : base(std::move(base_)) {
+    RecoverJournals(base);
+    cache = std::make_shared<WriteBackCache>(base->GetFullPath());
+}
+
+WriteBackVfsDirectory::WriteBackVfsDirectory(std::shared_ptr<WriteBackCache> cache,
+                                             VirtualDir base)
+    : cache(std::move(cache)), base(std::move(base)) {}
+
+WriteBackVfsDirectory::~WriteBackVfsDirectory() = default;
+
+void WriteBackVfsDirectory::Commit() {
+    cache->RequestWriteBack();
+}
+
+std::shared_ptr<VfsFile> WriteBackVfsDirectory::GetFile(std::string_view name) const {
+    if (IsInternalFile(name)) {
+        return nullptr;
+    }
+
+    auto file = base->GetFile(name);
+    return file == nullptr ? nullptr : cache->Wrap(base, std::move(file));
+}
+
+std::shared_ptr<VfsDirectory> WriteBackVfsDirectory::GetSubdirectory(std::string_view name) const {
+    auto dir = base->GetSubdirectory(name);
+    return dir == nullptr ? nullptr
+                          : std::make_shared<WriteBackVfsDirectory>(cache, std::move(dir));
+}
+
+std::vector<std::shared_ptr<VfsFile>> WriteBackVfsDirectory::GetFiles() const {
+    std::vector<std::shared_ptr<VfsFile>> out;
+    for (auto& file : base->GetFiles()) {
+        if (!IsInternalFile(file->GetName())) {
+            out.push_back(cache->Wrap(base, std::move(file)));
+        }
+    }
+    return out;
+}
+
+std::vector<std::shared_ptr<VfsDirectory>> WriteBackVfsDirectory::GetSubdirectories() const {
+    std::vector<std::shared_ptr<VfsDirectory>> out;
+    for (auto& dir : base->GetSubdirectories()) {
+        out.push_back(std::make_shared<WriteBackVfsDirectory>(cache, std::move(dir)));
+    }
+    return out;
+}
+
+bool WriteBackVfsDirectory::IsWritable() const {
+    return base->IsWritable();
+}
+
+bool WriteBackVfsDirectory::IsReadable() const {
+    return base->IsReadable();
+}
+
+std::string WriteBackVfsDirectory::GetName() const {
+    return base->GetName();
+}
+
+std::shared_ptr<VfsDirectory> WriteBackVfsDirectory::GetParentDirectory() const {
+    // The tree ends at the directory it was created for
+    if (GetFullPath() == cache->GetRootPath()) {
+        return nullptr;
+    }
+
+    auto dir = base->GetParentDirectory();
+    return dir == nullptr ? nullptr
+                          : std::make_shared<WriteBackVfsDirectory>(cache, std::move(dir));
+}
+
+std::shared_ptr<VfsDirectory> WriteBackVfsDirectory::CreateSubdirectory(std::string_view name) {
+    auto dir = base->CreateSubdirectory(name);
+    return dir == nullptr ? nullptr
+                          : std::make_shared<WriteBackVfsDirectory>(cache, std::move(dir));
+}
+
+std::shared_ptr<VfsFile> WriteBackVfsDirectory::CreateFile(std::string_view name) {
+    if (IsInternalFile(name)) {
+        return nullptr;
+    }
+
+    auto file = base->CreateFile(name);
+    return file == nullptr ? nullptr : cache->Wrap(base, std::move(file));
+}
+
+bool WriteBackVfsDirectory::DeleteSubdirectory(std::string_view name) {
+    cache->Discard(GetFullPath() + '/' + std::string(name));
+    return base->DeleteSubdirectory(name);
+}
+
+bool WriteBackVfsDirectory::DeleteFile(std::string_view name) {
+    if (IsInternalFile(name)) {
+        return false;
+    }
+
+    cache->Discard(GetFullPath() + '/' + std::string(name));
+    return base->DeleteFile(name);
+}
+
+bool WriteBackVfsDirectory::Rename(std::string_view name) {
+    cache->Release(GetFullPath());
+    return base->Rename(name);
+}
+
+std::string WriteBackVfsDirectory::GetFullPath() const {
+    return base->GetFullPath();
+}
+
+bool WriteBackVfsDirectory::ReplaceFileWithSubdirectory(VirtualFile file, VirtualDir dir) {
+    return false;
+}
+
+} // namespace FileSys
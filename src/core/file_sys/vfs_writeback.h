@@ -0,0 +1,60 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "core/file_sys/vfs.h"
+
+namespace FileSys {
+
+class WriteBackCache;
+
+/**
+ * An implementation of VfsDirectory that keeps the writes to the files of another directory tree
+ * in memory and writes them to it in batches: in the background when Commit is called, every few
+ * seconds for files left dirty, and synchronously when the last reference to the tree goes away.
+ * Meant for savedata, which games tend to update in many small writes.
+ *
+ * Every file is written to the backing tree as a whole: first to a temporary file, which is renamed
+ * to a journal once complete, which then replaces the original. Journals left over by a crash are
+ * replayed when the tree is opened again, so a file is never found half written.
+ */
+class WriteBackVfsDirectory : public VfsDirectory {
+public:
+    explicit WriteBackVfsDirectory(VirtualDir base);
+    WriteBackVfsDirectory(std::shared_ptr<WriteBackCache> cache, VirtualDir base);
+    ~WriteBackVfsDirectory() override;
+
+    /// Starts writing every pending change to the backing tree and returns immediately
+    void Commit();
+
+    std::shared_ptr<VfsFile> GetFile(std::string_view name) const override;
+    std::shared_ptr<VfsDirectory> GetSubdirectory(std::string_view name) const override;
+    std::vector<std::shared_ptr<VfsFile>> GetFiles() const override;
+    std::vector<std::shared_ptr<VfsDirectory>> GetSubdirectories() const override;
+    bool IsWritable() const override;
+    bool IsReadable() const override;
+    std::string GetName() const override;
+    std::shared_ptr<VfsDirectory> GetParentDirectory() const override;
+    std::shared_ptr<VfsDirectory> CreateSubdirectory(std::string_view name) override;
+    std::shared_ptr<VfsFile> CreateFile(std::string_view name) override;
+    bool DeleteSubdirectory(std::string_view name) override;
+    bool DeleteFile(std::string_view name) override;
+    bool Rename(std::string_view name) override;
+    std::string GetFullPath() const override;
+
+protected:
+    bool ReplaceFileWithSubdirectory(VirtualFile file, VirtualDir dir) override;
+
+private:
+    std::shared_ptr<WriteBackCache> cache;
+    VirtualDir base;
+};
+
+} // namespace FileSys
@@ -4,6 +4,7 @@
 
 #pragma once
 
+#include <chrono>
 #include <memory>
 #include <tuple>
 #include <utility>
@@ -12,6 +13,26 @@
 
 namespace Core::Frontend {
 
+/**
+ * Frames finished by the renderer, handed to a frontend that presents them on a thread of its
+ * own so that waiting for the swap and handling window events don't hold up emulation.
+ */
+class FrameMailbox {
+public:
+    virtual ~FrameMailbox() = default;
+
+    /**
+     * Draws the newest frame the renderer finished to the default framebuffer. Called by the
+     * presentation thread, with a context current that shares objects with the renderer's.
+     * @param timeout Time to wait for a frame when there is no new one yet
+     * @return True if a frame was drawn, in which case the caller swaps buffers
+     */
+    virtual bool TryPresent(std::chrono::milliseconds timeout) = 0;
+
+    /// Frees what TryPresent created in the presentation context, before it stops presenting
+    virtual void ReleasePresentResources() = 0;
+};
+
 /**
  * Abstraction class used to provide an interface between emulation code and the frontend
  * (e.g. SDL, QGLWidget, GLFW, etc...).
@@ -52,6 +73,21 @@ public:
     /// Releases (dunno if this is the "right" word) the GLFW context from the caller thread
     virtual void DoneCurrent() = 0;
 
+    /**
+     * Whether the frontend presents frames on a thread of its own. The renderer then draws each
+     * frame into the mailbox given to SetFrameMailbox instead of the window, and never calls
+     * SwapBuffers. The context made current by MakeCurrent only needs an offscreen surface.
+     */
+    virtual bool HasPresentationThread() const {
+        return false;
+    }
+
+    /**
+     * Called by the renderer with the mailbox its frames are handed over through when
+     * HasPresentationThread is true, and with null before the renderer goes away.
+     */
+    virtual void SetFrameMailbox(std::shared_ptr<FrameMailbox> mailbox) {}
+
     /**
      * Signal that a touch pressed event has occurred (e.g. mouse click pressed)
      * @param framebuffer_x Framebuffer x-coordinate that was pressed
@@ -5,6 +5,7 @@
 // Originally written by Sven Peter <sven@fail0verflow.com> for anergistic.
 
 #include <algorithm>
+#include <array>
 #include <atomic>
 #include <climits>
 #include <csignal>
@@ -13,6 +14,7 @@
 #include <cstring>
 #include <map>
 #include <numeric>
+#include <vector>
 #include <fcntl.h>
 
 #ifdef _WIN32
@@ -43,12 +45,15 @@
 
 namespace GDBStub {
 namespace {
-constexpr int GDB_BUFFER_SIZE = 10000;
+/// Largest packet exchanged with gdb, which bounds the size of memory reads and writes
+constexpr std::size_t GDB_BUFFER_SIZE = 0x20000;
 
 constexpr char GDB_STUB_START = '$';
 constexpr char GDB_STUB_END = '#';
 constexpr char GDB_STUB_ACK = '+';
 constexpr char GDB_STUB_NACK = '-';
+/// Escapes characters of binary data that would otherwise be taken as part of the protocol
+constexpr char GDB_STUB_ESCAPE = '}';
 
 #ifndef SIGTRAP
 constexpr u32 SIGTRAP = 5;
@@ -147,6 +152,11 @@ int gdbserver_socket = -1;
 u8 command_buffer[GDB_BUFFER_SIZE];
 u32 command_length;
 
+/// Data received from gdb that wasn't read yet, received in blocks to spare a call per byte
+std::array<u8, 0x1000> receive_buffer;
+std::size_t receive_position = 0;
+std::size_t receive_size = 0;
+
 u32 latest_signal = 0;
 bool memory_break = false;
 
@@ -173,7 +183,6 @@ struct Breakpoint {
     bool active;
     VAddr addr;
     u64 len;
-    std::array<u8, 4> inst;
 };
 
 using BreakpointMap = std::map<VAddr, Breakpoint>;
@@ -405,14 +414,20 @@ static u64 GdbHexToLong(const u8* src) {
 
 /// Read a byte from the gdb client.
 static u8 ReadByte() {
-    u8 c;
-    size_t received_size = recv(gdbserver_socket, reinterpret_cast<char*>(&c), 1, MSG_WAITALL);
-    if (received_size != 1) {
-        LOG_ERROR(Debug_GDBStub, "recv failed: {}", received_size);
-        Shutdown();
+    if (receive_position == receive_size) {
+        const auto received_size =
+            recv(gdbserver_socket, reinterpret_cast<char*>(receive_buffer.data()),
+                 static_cast<int>(receive_buffer.size()), 0);
+        if (received_size <= 0) {
+            LOG_ERROR(Debug_GDBStub, "recv failed: {}", received_size);
+            Shutdown();
+            return 0;
+        }
+        receive_position = 0;
+        receive_size = static_cast<std::size_t>(received_size);
     }
 
-    return c;
+    return receive_buffer[receive_position++];
 }
 
 /// Calculate the checksum of the current command buffer.
@@ -454,8 +469,10 @@ static void RemoveBreakpoint(BreakpointType type, VAddr addr) {
 
     LOG_DEBUG(Debug_GDBStub, "gdb: removed a breakpoint: {:016X} bytes at {:016X} of type {}",
               bp->second.len, bp->second.addr, static_cast<int>(type));
-    Memory::WriteBlock(bp->second.addr, bp->second.inst.data(), bp->second.inst.size());
-    Core::System::GetInstance().InvalidateCpuInstructionCaches();
+    if (type == BreakpointType::Execute) {
+        // The recompiler checks for breakpoints when translating code
+        Core::System::GetInstance().InvalidateCpuInstructionCacheRange(addr, 4);
+    }
     p.erase(addr);
 }
 
@@ -527,35 +544,32 @@ static void SendPacket(const char packet) {
 /**
  * Send reply to gdb client.
  *
- * @param reply Reply to be sent to client.
+ * @param reply Reply to be sent to client, which may contain binary data.
+ * @param length Length of the reply.
  */
-static void SendReply(const char* reply) {
+static void SendReply(const char* reply, std::size_t length) {
     if (!IsConnected()) {
         return;
     }
 
-    LOG_DEBUG(Debug_GDBStub, "Reply: {}", reply);
-
-    memset(command_buffer, 0, sizeof(command_buffer));
-
-    command_length = static_cast<u32>(strlen(reply));
-    if (command_length + 4 > sizeof(command_buffer)) {
-        LOG_ERROR(Debug_GDBStub, "command_buffer overflow in SendReply");
+    if (length + 4 > GDB_BUFFER_SIZE) {
+        LOG_ERROR(Debug_GDBStub, "Reply of {} bytes is larger than the packet size", length);
         return;
     }
 
-    memcpy(command_buffer + 1, reply, command_length);
-
-    u8 checksum = CalculateChecksum(command_buffer, command_length + 1);
-    command_buffer[0] = GDB_STUB_START;
-    command_buffer[command_length + 1] = GDB_STUB_END;
-    command_buffer[command_length + 2] = NibbleToHex(checksum >> 4);
-    command_buffer[command_length + 3] = NibbleToHex(checksum);
+    std::vector<u8> packet(length + 4);
+    packet[0] = GDB_STUB_START;
+    std::memcpy(packet.data() + 1, reply, length);
+    const u8 checksum = CalculateChecksum(packet.data() + 1, length);
+    packet[length + 1] = GDB_STUB_END;
+    packet[length + 2] = NibbleToHex(checksum >> 4);
+    packet[length + 3] = NibbleToHex(checksum);
 
-    u8* ptr = command_buffer;
-    u32 left = command_length + 4;
+    const u8* ptr = packet.data();
+    std::size_t left = packet.size();
     while (left > 0) {
-        int sent_size = send(gdbserver_socket, reinterpret_cast<char*>(ptr), left, 0);
+        int sent_size = send(gdbserver_socket, reinterpret_cast<const char*>(ptr),
+                             static_cast<int>(left), 0);
         if (sent_size < 0) {
             LOG_ERROR(Debug_GDBStub, "gdb: send failed");
             return Shutdown();
@@ -566,6 +580,16 @@ static void SendReply(const char* reply) {
     }
 }
 
+/**
+ * Send reply to gdb client.
+ *
+ * @param reply Reply to be sent to client.
+ */
+static void SendReply(const char* reply) {
+    LOG_DEBUG(Debug_GDBStub, "Reply: {}", reply);
+    SendReply(reply, strlen(reply));
+}
+
 /// Handle query command from gdb client.
 static void HandleQuery() {
     LOG_DEBUG(Debug_GDBStub, "gdb: query '{}'", command_buffer + 1);
@@ -576,7 +600,8 @@ static void HandleQuery() {
         SendReply("T0");
     } else if (strncmp(query, "Supported", strlen("Supported")) == 0) {
         // PacketSize needs to be large enough for target xml
-        std::string buffer = "PacketSize=2000;qXfer:features:read+;qXfer:threads:read+";
+        std::string buffer = fmt::format("PacketSize={:x};qXfer:features:read+;qXfer:threads:read+",
+                                         GDB_BUFFER_SIZE);
         if (!modules.empty()) {
             buffer += ";qXfer:libraries:read+";
         }
@@ -749,6 +774,10 @@ static bool IsDataAvailable() {
         return false;
     }
 
+    if (receive_position != receive_size) {
+        return true;
+    }
+
     fd_set fd_socket;
 
     FD_ZERO(&fd_socket);
@@ -888,59 +917,161 @@ static void WriteRegisters() {
     SendReply("OK");
 }
 
-/// Read location in memory specified by gdb client.
-static void ReadMemory() {
-    static u8 reply[GDB_BUFFER_SIZE - 4];
+/**
+ * Parse the address and length of a memory packet, formatted as "<cmd>addr,length" and optionally
+ * followed by ':' and the data to be written.
+ *
+ * @param addr Set to the address of the packet.
+ * @param len Set to the length of the packet.
+ * @return Pointer to the ':' separating the data, or to the end of the packet if there's none.
+ */
+static const u8* ParseMemoryPacket(VAddr& addr, u64& len) {
+    const u8* const end = command_buffer + command_length;
+    const u8* start_offset = command_buffer + 1;
+    const u8* const addr_pos = std::find(start_offset, end, ',');
+    addr = HexToLong(start_offset, static_cast<u64>(addr_pos - start_offset));
+
+    start_offset = std::min(addr_pos + 1, end);
+    const u8* const len_pos = std::find(start_offset, end, ':');
+    len = HexToLong(start_offset, static_cast<u64>(len_pos - start_offset));
+    return len_pos;
+}
 
-    auto start_offset = command_buffer + 1;
-    auto addr_pos = std::find(start_offset, command_buffer + command_length, ',');
-    VAddr addr = HexToLong(start_offset, static_cast<u64>(addr_pos - start_offset));
+/// Check if gdb may access a range of guest memory.
+static bool IsValidMemoryRange(VAddr addr, u64 len) {
+    if (addr < Memory::PROCESS_IMAGE_VADDR || addr >= Memory::MAP_REGION_VADDR_END) {
+        return false;
+    }
 
-    start_offset = addr_pos + 1;
-    u64 len =
-        HexToLong(start_offset, static_cast<u64>((command_buffer + command_length) - start_offset));
+    return Memory::IsValidVirtualAddress(addr) &&
+           (len == 0 || Memory::IsValidVirtualAddress(addr + len - 1));
+}
+
+/// Read location in memory specified by gdb client, replying in hex.
+static void ReadMemory() {
+    VAddr addr;
+    u64 len;
+    ParseMemoryPacket(addr, len);
 
     LOG_DEBUG(Debug_GDBStub, "gdb: addr: {:016X} len: {:016X}", addr, len);
 
-    if (len * 2 > sizeof(reply)) {
-        SendReply("E01");
+    if (len > (GDB_BUFFER_SIZE - 4) / 2) {
+        return SendReply("E01");
     }
 
-    if (addr < Memory::PROCESS_IMAGE_VADDR || addr >= Memory::MAP_REGION_VADDR_END) {
+    if (!IsValidMemoryRange(addr, len)) {
         return SendReply("E00");
     }
 
-    if (!Memory::IsValidVirtualAddress(addr)) {
+    std::vector<u8> data(len);
+    Memory::ReadBlock(addr, data.data(), len);
+
+    std::vector<u8> reply(len * 2);
+    MemToGdbHex(reply.data(), data.data(), len);
+    SendReply(reinterpret_cast<const char*>(reply.data()), reply.size());
+}
+
+/**
+ * Read location in memory specified by gdb client, replying in binary. Binary replies are half
+ * the size of hex ones, which matters for the large reads done when dumping memory.
+ */
+static void ReadMemoryBinary() {
+    VAddr addr;
+    u64 len;
+    ParseMemoryPacket(addr, len);
+
+    LOG_DEBUG(Debug_GDBStub, "gdb: addr: {:016X} len: {:016X}", addr, len);
+
+    // Every byte may have to be escaped, taking two characters
+    if (len > (GDB_BUFFER_SIZE - 5) / 2) {
+        return SendReply("E01");
+    }
+
+    if (!IsValidMemoryRange(addr, len)) {
         return SendReply("E00");
     }
 
     std::vector<u8> data(len);
     Memory::ReadBlock(addr, data.data(), len);
 
-    MemToGdbHex(reply, data.data(), len);
-    reply[len * 2] = '\0';
-    SendReply(reinterpret_cast<char*>(reply));
+    // The data is preceded by a 'b', so that empty replies aren't taken as unsupported packets
+    std::vector<u8> reply;
+    reply.reserve(len + 1);
+    reply.push_back('b');
+    for (const u8 byte : data) {
+        if (byte == GDB_STUB_START || byte == GDB_STUB_END || byte == GDB_STUB_ESCAPE ||
+            byte == '*') {
+            reply.push_back(GDB_STUB_ESCAPE);
+            reply.push_back(byte ^ 0x20);
+        } else {
+            reply.push_back(byte);
+        }
+    }
+    SendReply(reinterpret_cast<const char*>(reply.data()), reply.size());
+}
+
+/// Write data to guest memory, invalidating the code translated from it.
+static void WriteGuestMemory(VAddr addr, const std::vector<u8>& data) {
+    Memory::WriteBlock(addr, data.data(), data.size());
+    Core::System::GetInstance().InvalidateCpuInstructionCacheRange(addr, data.size());
 }
 
-/// Modify location in memory with data received from the gdb client.
+/// Modify location in memory with hex data received from the gdb client.
 static void WriteMemory() {
-    auto start_offset = command_buffer + 1;
-    auto addr_pos = std::find(start_offset, command_buffer + command_length, ',');
-    VAddr addr = HexToLong(start_offset, static_cast<u64>(addr_pos - start_offset));
+    VAddr addr;
+    u64 len;
+    const u8* const data_pos = ParseMemoryPacket(addr, len);
 
-    start_offset = addr_pos + 1;
-    auto len_pos = std::find(start_offset, command_buffer + command_length, ':');
-    u64 len = HexToLong(start_offset, static_cast<u64>(len_pos - start_offset));
+    const u8* const end = command_buffer + command_length;
+    if (data_pos == end || static_cast<u64>(end - data_pos - 1) < len * 2) {
+        return SendReply("E01");
+    }
 
-    if (!Memory::IsValidVirtualAddress(addr)) {
+    if (!IsValidMemoryRange(addr, len)) {
         return SendReply("E00");
     }
 
     std::vector<u8> data(len);
+    GdbHexToMem(data.data(), data_pos + 1, len);
+    WriteGuestMemory(addr, data);
+    SendReply("OK");
+}
+
+/// Modify location in memory with binary data received from the gdb client.
+static void WriteMemoryBinary() {
+    VAddr addr;
+    u64 len;
+    const u8* data_pos = ParseMemoryPacket(addr, len);
+
+    const u8* const end = command_buffer + command_length;
+    if (data_pos == end) {
+        return SendReply("E01");
+    }
+
+    // gdb sends an empty write to probe for support of the packet
+    if (len == 0) {
+        return SendReply("OK");
+    }
+
+    if (!IsValidMemoryRange(addr, len)) {
+        return SendReply("E00");
+    }
 
-    GdbHexToMem(data.data(), len_pos + 1, len);
-    Memory::WriteBlock(addr, data.data(), len);
-    Core::System::GetInstance().InvalidateCpuInstructionCaches();
+    std::vector<u8> data;
+    data.reserve(len);
+    for (++data_pos; data_pos != end && data.size() < len; ++data_pos) {
+        if (*data_pos == GDB_STUB_ESCAPE && data_pos + 1 != end) {
+            data.push_back(*++data_pos ^ 0x20);
+        } else {
+            data.push_back(*data_pos);
+        }
+    }
+
+    if (data.size() != len) {
+        return SendReply("E01");
+    }
+
+    WriteGuestMemory(addr, data);
     SendReply("OK");
 }
 
@@ -960,7 +1091,6 @@ static void Step() {
     step_loop = true;
     halt_loop = true;
     send_trap = true;
-    Core::System::GetInstance().InvalidateCpuInstructionCaches();
 }
 
 /// Tell the CPU if we hit a memory breakpoint.
@@ -977,7 +1107,6 @@ static void Continue() {
     memory_break = false;
     step_loop = false;
     halt_loop = false;
-    Core::System::GetInstance().InvalidateCpuInstructionCaches();
 }
 
 /**
@@ -994,12 +1123,13 @@ static bool CommitBreakpoint(BreakpointType type, VAddr addr, u64 len) {
     breakpoint.active = true;
     breakpoint.addr = addr;
     breakpoint.len = len;
-    Memory::ReadBlock(addr, breakpoint.inst.data(), breakpoint.inst.size());
-    static constexpr std::array<u8, 4> btrap{{0xd4, 0x20, 0x7d, 0x0}};
-    Memory::WriteBlock(addr, btrap.data(), btrap.size());
-    Core::System::GetInstance().InvalidateCpuInstructionCaches();
     p.insert({addr, breakpoint});
 
+    if (type == BreakpointType::Execute) {
+        // The recompiler checks for breakpoints when translating code
+        Core::System::GetInstance().InvalidateCpuInstructionCacheRange(addr, 4);
+    }
+
     LOG_DEBUG(Debug_GDBStub, "gdb: added {} breakpoint: {:016X} bytes at {:016X}",
               static_cast<int>(type), breakpoint.len, breakpoint.addr);
 
@@ -1142,6 +1272,12 @@ void HandlePacket() {
     case 'M':
         WriteMemory();
         break;
+    case 'x':
+        ReadMemoryBinary();
+        break;
+    case 'X':
+        WriteMemoryBinary();
+        break;
     case 's':
         Step();
         return;
@@ -1277,6 +1413,8 @@ void Shutdown() {
         shutdown(gdbserver_socket, SHUT_RDWR);
         gdbserver_socket = -1;
     }
+    receive_position = 0;
+    receive_size = 0;
 
 #ifdef _WIN32
     WSACleanup();
@@ -6,11 +6,12 @@
 
 #include "common/common_types.h"
 #include "core/hle/kernel/object.h"
+#include "core/hle/kernel/slab_heap.h"
 #include "core/hle/kernel/wait_object.h"
 
 namespace Kernel {
 
-class Event final : public WaitObject {
+class Event final : public WaitObject, public SlabAllocated<Event> {
 public:
     /**
      * Creates an event
@@ -29,12 +29,12 @@ enum KernelHandle : Handle {
  *
  * To prevent accidental use of a freed Handle whose slot has already been reused, a global counter
  * is kept and incremented every time a Handle is created. This is the Handle's "generation". The
- * value of the counter is stored into the Handle as well as in the handle table (in the
- * "generations" array). When looking up a handle, the Handle's generation must match with the
+ * value of the counter is stored into the Handle as well as in the handle table (in the slot's
+ * "generation" field). When looking up a handle, the Handle's generation must match with the
  * value stored on the class, otherwise the Handle is considered invalid.
  *
  * To find free slots when allocating a Handle without needing to scan the entire object array, the
- * generations field of unallocated slots is re-purposed as a linked list of indices to free slots.
+ * generation field of unallocated slots is re-purposed as a linked list of indices to free slots.
  * When a Handle is created, an index is popped off the list and used for the new Handle. When it
  * is destroyed, it is again pushed onto the list to be re-used by the next allocation. It is
  * likely that this allocation strategy differs from the one used in CTR-OS, but this hasn't been
@@ -102,18 +102,40 @@ private:
         return handle & 0x7FFF;
     }
 
-    /// Stores the Object referenced by the handle or null if the slot is empty.
-    std::array<SharedPtr<Object>, MAX_COUNT> objects;
-
     /**
-     * The value of `next_generation` when the handle was created, used to check for validity. For
-     * empty slots, contains the index of the next free slot in the list.
+     * A handle table entry. The object and the generation it is checked against are kept next to
+     * each other, so that a lookup only touches a single cache line.
      */
-    std::array<u16, MAX_COUNT> generations;
+    struct Slot {
+        /// Stores the Object referenced by the handle or null if the slot is empty.
+        SharedPtr<Object> object;
+
+        /**
+         * The value of `next_generation` when the handle was created, used to check for
+         * validity. For empty slots, contains the index of the next free slot in the list.
+         */
+        u16 generation;
+    };
+
+    /// Returns the slot referenced by a handle, or nullptr if the handle is not valid.
+    const Slot* FindSlot(Handle handle) const {
+        const std::size_t slot = GetSlot(handle);
+        if (slot >= MAX_COUNT) {
+            return nullptr;
+        }
+
+        const Slot& entry = slots[slot];
+        if (entry.object == nullptr || entry.generation != GetGeneration(handle)) {
+            return nullptr;
+        }
+        return &entry;
+    }
+
+    std::array<Slot, MAX_COUNT> slots;
 
     /**
-     * Global counter of the number of created handles. Stored in `generations` when a handle is
-     * created, and wraps around to 1 when it hits 0x8000.
+     * Global counter of the number of created handles. Stored in the slot's `generation` when a
+     * handle is created, and wraps around to 1 when it hits 0x8000.
      */
     u16 next_generation;
 
@@ -121,6 +143,4 @@ private:
     u16 next_free_slot;
 };
 
-extern HandleTable g_handle_table;
-
 } // namespace Kernel
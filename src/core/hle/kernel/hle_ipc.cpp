@@ -17,6 +17,7 @@
 #include "core/hle/kernel/event.h"
 #include "core/hle/kernel/handle_table.h"
 #include "core/hle/kernel/hle_ipc.h"
+#include "core/hle/kernel/hle_worker.h"
 #include "core/hle/kernel/object.h"
 #include "core/hle/kernel/process.h"
 #include "core/hle/kernel/server_session.h"
@@ -56,8 +57,7 @@ SharedPtr<Event> HLERequestContext::SleepClientThread(SharedPtr<Thread> thread,
 
     event->Clear();
     thread->status = ThreadStatus::WaitHLEEvent;
-    thread->wait_objects = {event};
-    event->AddWaitingThread(thread);
+    thread->SetWaitObjects({event});
 
     if (timeout > 0) {
         thread->WakeAfterDelay(timeout);
@@ -66,6 +66,14 @@ SharedPtr<Event> HLERequestContext::SleepClientThread(SharedPtr<Thread> thread,
     return event;
 }
 
+SharedPtr<Event> HLERequestContext::RunAsync(SharedPtr<Thread> thread, const std::string& reason,
+                                             std::function<void()>&& work,
+                                             WakeupCallback&& callback) {
+    SharedPtr<Event> event = SleepClientThread(std::move(thread), reason, 0, std::move(callback));
+    QueueHLEWork(std::move(work), [event] { event->Signal(); });
+    return event;
+}
+
 HLERequestContext::HLERequestContext(SharedPtr<Kernel::ServerSession> server_session)
     : server_session(std::move(server_session)) {
     cmd_buf[0] = 0;
@@ -73,9 +81,10 @@ HLERequestContext::HLERequestContext(SharedPtr<Kernel::ServerSession> server_ses
 
 HLERequestContext::~HLERequestContext() = default;
 
-void HLERequestContext::ParseCommandBuffer(u32_le* src_cmdbuf, bool incoming) {
+void HLERequestContext::ParseCommandBuffer(const HandleTable& handle_table, u32_le* src_cmdbuf,
+                                           bool incoming) {
     IPC::RequestParser rp(src_cmdbuf);
-    command_header = std::make_shared<IPC::CommandHeader>(rp.PopRaw<IPC::CommandHeader>());
+    command_header.emplace(rp.PopRaw<IPC::CommandHeader>());
 
     if (command_header->type == IPC::CommandType::Close) {
         // Close does not populate the rest of the IPC header
@@ -84,18 +93,17 @@ void HLERequestContext::ParseCommandBuffer(u32_le* src_cmdbuf, bool incoming) {
 
     // If handle descriptor is present, add size of it
     if (command_header->enable_handle_descriptor) {
-        handle_descriptor_header =
-            std::make_shared<IPC::HandleDescriptorHeader>(rp.PopRaw<IPC::HandleDescriptorHeader>());
+        handle_descriptor_header.emplace(rp.PopRaw<IPC::HandleDescriptorHeader>());
         if (handle_descriptor_header->send_current_pid) {
             rp.Skip(2, false);
         }
         if (incoming) {
             // Populate the object lists with the data in the IPC request.
             for (u32 handle = 0; handle < handle_descriptor_header->num_handles_to_copy; ++handle) {
-                copy_objects.push_back(Kernel::g_handle_table.GetGeneric(rp.Pop<Handle>()));
+                copy_objects.push_back(handle_table.GetGeneric(rp.Pop<Handle>()));
             }
             for (u32 handle = 0; handle < handle_descriptor_header->num_handles_to_move; ++handle) {
-                move_objects.push_back(Kernel::g_handle_table.GetGeneric(rp.Pop<Handle>()));
+                move_objects.push_back(handle_table.GetGeneric(rp.Pop<Handle>()));
             }
         } else {
             // For responses we just ignore the handles, they're empty and will be populated when
@@ -105,17 +113,27 @@ void HLERequestContext::ParseCommandBuffer(u32_le* src_cmdbuf, bool incoming) {
         }
     }
 
-    for (unsigned i = 0; i < command_header->num_buf_x_descriptors; ++i) {
-        buffer_x_desciptors.push_back(rp.PopRaw<IPC::BufferDescriptorX>());
-    }
-    for (unsigned i = 0; i < command_header->num_buf_a_descriptors; ++i) {
-        buffer_a_desciptors.push_back(rp.PopRaw<IPC::BufferDescriptorABW>());
-    }
-    for (unsigned i = 0; i < command_header->num_buf_b_descriptors; ++i) {
-        buffer_b_desciptors.push_back(rp.PopRaw<IPC::BufferDescriptorABW>());
-    }
-    for (unsigned i = 0; i < command_header->num_buf_w_descriptors; ++i) {
-        buffer_w_desciptors.push_back(rp.PopRaw<IPC::BufferDescriptorABW>());
+    if (incoming) {
+        for (unsigned i = 0; i < command_header->num_buf_x_descriptors; ++i) {
+            buffer_x_desciptors.push_back(rp.PopRaw<IPC::BufferDescriptorX>());
+        }
+        for (unsigned i = 0; i < command_header->num_buf_a_descriptors; ++i) {
+            buffer_a_desciptors.push_back(rp.PopRaw<IPC::BufferDescriptorABW>());
+        }
+        for (unsigned i = 0; i < command_header->num_buf_b_descriptors; ++i) {
+            buffer_b_desciptors.push_back(rp.PopRaw<IPC::BufferDescriptorABW>());
+        }
+        for (unsigned i = 0; i < command_header->num_buf_w_descriptors; ++i) {
+            buffer_w_desciptors.push_back(rp.PopRaw<IPC::BufferDescriptorABW>());
+        }
+    } else {
+        // The descriptors of the request are still needed by the handler's caller, and responses
+        // don't carry any of their own, so only skip over the space reserved for them.
+        rp.Skip(command_header->num_buf_x_descriptors * sizeof(IPC::BufferDescriptorX) / 4, false);
+        rp.Skip((command_header->num_buf_a_descriptors + command_header->num_buf_b_descriptors +
+                 command_header->num_buf_w_descriptors) *
+                    sizeof(IPC::BufferDescriptorABW) / 4,
+                false);
     }
 
     buffer_c_offset = rp.GetCurrentOffset() + command_header->data_size;
@@ -129,16 +147,14 @@ void HLERequestContext::ParseCommandBuffer(u32_le* src_cmdbuf, bool incoming) {
         // If this is an incoming message, only CommandType "Request" has a domain header
         // All outgoing domain messages have the domain header, if only incoming has it
         if (incoming || domain_message_header) {
-            domain_message_header =
-                std::make_shared<IPC::DomainMessageHeader>(rp.PopRaw<IPC::DomainMessageHeader>());
+            domain_message_header.emplace(rp.PopRaw<IPC::DomainMessageHeader>());
         } else {
             if (Session()->IsDomain())
                 LOG_WARNING(IPC, "Domain request has no DomainMessageHeader!");
         }
     }
 
-    data_payload_header =
-        std::make_shared<IPC::DataPayloadHeader>(rp.PopRaw<IPC::DataPayloadHeader>());
+    data_payload_header.emplace(rp.PopRaw<IPC::DataPayloadHeader>());
 
     data_payload_offset = rp.GetCurrentOffset();
 
@@ -186,7 +202,7 @@ void HLERequestContext::ParseCommandBuffer(u32_le* src_cmdbuf, bool incoming) {
 ResultCode HLERequestContext::PopulateFromIncomingCommandBuffer(u32_le* src_cmdbuf,
                                                                 Process& src_process,
                                                                 HandleTable& src_table) {
-    ParseCommandBuffer(src_cmdbuf, true);
+    ParseCommandBuffer(src_table, src_cmdbuf, true);
     if (command_header->type == IPC::CommandType::Close) {
         // Close does not populate the rest of the IPC header
         return RESULT_SUCCESS;
@@ -208,7 +224,8 @@ ResultCode HLERequestContext::WriteToOutgoingCommandBuffer(const Thread& thread)
 
     // The header was already built in the internal command buffer. Attempt to parse it to verify
     // the integrity and then copy it over to the target command buffer.
-    ParseCommandBuffer(cmd_buf.data(), false);
+    HandleTable& handle_table = thread.owner_process->handle_table;
+    ParseCommandBuffer(handle_table, cmd_buf.data(), false);
 
     // The data_size already includes the payload header, the padding and the domain header.
     size_t size = data_payload_offset + command_header->data_size -
@@ -235,12 +252,12 @@ ResultCode HLERequestContext::WriteToOutgoingCommandBuffer(const Thread& thread)
         // for specific values in each of these descriptors.
         for (auto& object : copy_objects) {
             ASSERT(object != nullptr);
-            dst_cmdbuf[current_offset++] = Kernel::g_handle_table.Create(object).Unwrap();
+            dst_cmdbuf[current_offset++] = handle_table.Create(object).Unwrap();
         }
 
         for (auto& object : move_objects) {
             ASSERT(object != nullptr);
-            dst_cmdbuf[current_offset++] = Kernel::g_handle_table.Create(object).Unwrap();
+            dst_cmdbuf[current_offset++] = handle_table.Create(object).Unwrap();
         }
     }
 
@@ -283,6 +300,23 @@ std::vector<u8> HLERequestContext::ReadBuffer(int buffer_index) const {
     return buffer;
 }
 
+InputBufferView HLERequestContext::ReadBufferView(int buffer_index) const {
+    const bool is_buffer_a{BufferDescriptorA().size() && BufferDescriptorA()[buffer_index].Size()};
+    const VAddr address{is_buffer_a ? BufferDescriptorA()[buffer_index].Address()
+                                    : BufferDescriptorX()[buffer_index].Address()};
+
+    InputBufferView view;
+    view.length = GetReadBufferSize(buffer_index);
+    view.pointer = Memory::GetContiguousPointer(address, view.length);
+    if (view.pointer == nullptr) {
+        // The buffer spans unmapped or special memory, fall back to a regular copy
+        view.storage = ReadBuffer(buffer_index);
+        view.pointer = view.storage.data();
+    }
+
+    return view;
+}
+
 size_t HLERequestContext::WriteBuffer(const void* buffer, size_t size, int buffer_index) const {
     if (size == 0) {
         LOG_WARNING(Core, "skip empty buffer write");
@@ -318,6 +352,13 @@ size_t HLERequestContext::GetWriteBufferSize(int buffer_index) const {
                        : BufferDescriptorC()[buffer_index].Size();
 }
 
+u8* HLERequestContext::GetWriteBufferPointer(int buffer_index) const {
+    const bool is_buffer_b{BufferDescriptorB().size() && BufferDescriptorB()[buffer_index].Size()};
+    const VAddr address{is_buffer_b ? BufferDescriptorB()[buffer_index].Address()
+                                    : BufferDescriptorC()[buffer_index].Address()};
+    return Memory::GetContiguousPointer(address, GetWriteBufferSize(buffer_index));
+}
+
 std::string HLERequestContext::Description() const {
     if (!command_header) {
         return "No command header available";
@@ -5,11 +5,13 @@
 #pragma once
 
 #include <array>
+#include <functional>
 #include <memory>
 #include <string>
 #include <type_traits>
 #include <vector>
 #include <boost/container/small_vector.hpp>
+#include <boost/optional.hpp>
 #include "common/common_types.h"
 #include "common/swap.h"
 #include "core/hle/ipc.h"
@@ -69,6 +71,38 @@ protected:
     std::vector<SharedPtr<ServerSession>> connected_sessions;
 };
 
+/**
+ * Read-only view of an IPC input buffer. When the buffer is contiguous in host memory the view
+ * points straight at guest memory, otherwise it holds a private copy of the data.
+ * The view is only valid while the request is being handled.
+ */
+class InputBufferView final {
+public:
+    InputBufferView() = default;
+    InputBufferView(InputBufferView&&) = default;
+    InputBufferView& operator=(InputBufferView&&) = default;
+
+    const u8* data() const {
+        return pointer;
+    }
+
+    size_t size() const {
+        return length;
+    }
+
+    bool empty() const {
+        return length == 0;
+    }
+
+private:
+    friend class HLERequestContext;
+
+    const u8* pointer = nullptr;
+    size_t length = 0;
+    /// Backing storage for the fallback copy, the data pointer refers into it when used.
+    std::vector<u8> storage;
+};
+
 /**
  * Class containing information about an in-flight IPC request being handled by an HLE service
  * implementation. Services should avoid using old global APIs (e.g. Kernel::GetCommandBuffer()) and
@@ -90,6 +124,10 @@ protected:
  */
 class HLERequestContext {
 public:
+    /// Buffer descriptors of one kind, the inline capacity covers all but the largest requests.
+    template <typename T>
+    using BufferDescriptorList = boost::container::small_vector<T, 8>;
+
     explicit HLERequestContext(SharedPtr<ServerSession> session);
     ~HLERequestContext();
 
@@ -126,7 +164,22 @@ public:
                                        u64 timeout, WakeupCallback&& callback,
                                        Kernel::SharedPtr<Kernel::Event> event = nullptr);
 
-    void ParseCommandBuffer(u32_le* src_cmdbuf, bool incoming);
+    /**
+     * Puts the specified guest thread to sleep while blocking work runs on a host worker thread,
+     * and resumes it once the work has completed. This keeps the emulated core free to run other
+     * guest threads while the service waits on the host.
+     * @param thread Thread to be put to sleep.
+     * @param reason Reason for pausing the thread, to be used for debugging purposes.
+     * @param work Function run on a host worker thread. It must not access emulated memory or
+     * kernel state, nor this context.
+     * @param callback Callback invoked on the CPU thread once the work is done. As with
+     * SleepClientThread, it must write the entire command response.
+     * @returns Event that is signaled when the work completes.
+     */
+    SharedPtr<Event> RunAsync(SharedPtr<Thread> thread, const std::string& reason,
+                              std::function<void()>&& work, WakeupCallback&& callback);
+
+    void ParseCommandBuffer(const HandleTable& handle_table, u32_le* src_cmdbuf, bool incoming);
 
     /// Populates this context with data from the requesting process/thread.
     ResultCode PopulateFromIncomingCommandBuffer(u32_le* src_cmdbuf, Process& src_process,
@@ -146,29 +199,35 @@ public:
         return data_payload_offset;
     }
 
-    const std::vector<IPC::BufferDescriptorX>& BufferDescriptorX() const {
+    const BufferDescriptorList<IPC::BufferDescriptorX>& BufferDescriptorX() const {
         return buffer_x_desciptors;
     }
 
-    const std::vector<IPC::BufferDescriptorABW>& BufferDescriptorA() const {
+    const BufferDescriptorList<IPC::BufferDescriptorABW>& BufferDescriptorA() const {
         return buffer_a_desciptors;
     }
 
-    const std::vector<IPC::BufferDescriptorABW>& BufferDescriptorB() const {
+    const BufferDescriptorList<IPC::BufferDescriptorABW>& BufferDescriptorB() const {
         return buffer_b_desciptors;
     }
 
-    const std::vector<IPC::BufferDescriptorC>& BufferDescriptorC() const {
+    const BufferDescriptorList<IPC::BufferDescriptorC>& BufferDescriptorC() const {
         return buffer_c_desciptors;
     }
 
-    const std::shared_ptr<IPC::DomainMessageHeader>& GetDomainMessageHeader() const {
+    const boost::optional<IPC::DomainMessageHeader>& GetDomainMessageHeader() const {
         return domain_message_header;
     }
 
     /// Helper function to read a buffer using the appropriate buffer descriptor
     std::vector<u8> ReadBuffer(int buffer_index = 0) const;
 
+    /**
+     * Helper function to access an input buffer without copying it, if it is contiguous in host
+     * memory. Handlers that only consume the data once should prefer this over ReadBuffer.
+     */
+    InputBufferView ReadBufferView(int buffer_index = 0) const;
+
     /// Helper function to write a buffer using the appropriate buffer descriptor
     size_t WriteBuffer(const void* buffer, size_t size, int buffer_index = 0) const;
 
@@ -198,6 +257,15 @@ public:
     /// Helper function to get the size of the output buffer
     size_t GetWriteBufferSize(int buffer_index = 0) const;
 
+    /**
+     * Helper function to get a host pointer to the output buffer, allowing handlers to produce
+     * their data directly in guest memory instead of going through an intermediate copy.
+     *
+     * @returns The host pointer, or nullptr if the output buffer is not backed by contiguous
+     *          regular memory. Callers must fall back to WriteBuffer in that case.
+     */
+    u8* GetWriteBufferPointer(int buffer_index = 0) const;
+
     template <typename T>
     SharedPtr<T> GetCopyObject(size_t index) {
         ASSERT(index < copy_objects.size());
@@ -224,12 +292,13 @@ public:
 
     template <typename T>
     std::shared_ptr<T> GetDomainRequestHandler(size_t index) const {
-        return std::static_pointer_cast<T>(domain_request_handlers[index]);
+        return std::static_pointer_cast<T>((*domain_request_handlers)[index]);
     }
 
+    /// Sets the handlers of the domain this request was sent to, these must outlive the context.
     void SetDomainRequestHandlers(
         const std::vector<std::shared_ptr<SessionRequestHandler>>& handlers) {
-        domain_request_handlers = handlers;
+        domain_request_handlers = &handlers;
     }
 
     /// Clears the list of objects so that no lingering objects are written accidentally to the
@@ -262,21 +331,23 @@ private:
     boost::container::small_vector<SharedPtr<Object>, 8> copy_objects;
     boost::container::small_vector<std::shared_ptr<SessionRequestHandler>, 8> domain_objects;
 
-    std::shared_ptr<IPC::CommandHeader> command_header;
-    std::shared_ptr<IPC::HandleDescriptorHeader> handle_descriptor_header;
-    std::shared_ptr<IPC::DataPayloadHeader> data_payload_header;
-    std::shared_ptr<IPC::DomainMessageHeader> domain_message_header;
-    std::vector<IPC::BufferDescriptorX> buffer_x_desciptors;
-    std::vector<IPC::BufferDescriptorABW> buffer_a_desciptors;
-    std::vector<IPC::BufferDescriptorABW> buffer_b_desciptors;
-    std::vector<IPC::BufferDescriptorABW> buffer_w_desciptors;
-    std::vector<IPC::BufferDescriptorC> buffer_c_desciptors;
+    // The headers and descriptors are stored inline, so that parsing a request doesn't have to
+    // allocate unless it carries an unusually large number of buffers.
+    boost::optional<IPC::CommandHeader> command_header;
+    boost::optional<IPC::HandleDescriptorHeader> handle_descriptor_header;
+    boost::optional<IPC::DataPayloadHeader> data_payload_header;
+    boost::optional<IPC::DomainMessageHeader> domain_message_header;
+    BufferDescriptorList<IPC::BufferDescriptorX> buffer_x_desciptors;
+    BufferDescriptorList<IPC::BufferDescriptorABW> buffer_a_desciptors;
+    BufferDescriptorList<IPC::BufferDescriptorABW> buffer_b_desciptors;
+    BufferDescriptorList<IPC::BufferDescriptorABW> buffer_w_desciptors;
+    BufferDescriptorList<IPC::BufferDescriptorC> buffer_c_desciptors;
 
     unsigned data_payload_offset{};
     unsigned buffer_c_offset{};
     u32_le command{};
 
-    std::vector<std::shared_ptr<SessionRequestHandler>> domain_request_handlers;
+    const std::vector<std::shared_ptr<SessionRequestHandler>>* domain_request_handlers = nullptr;
 };
 
 } // namespace Kernel
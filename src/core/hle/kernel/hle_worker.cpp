@@ -0,0 +1,120 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "common/assert.h"
+#include "common/threadsafe_queue.h"
+#include "core/core_timing.h"
+#include "core/hle/kernel/hle_worker.h"
+#include "core/hle/lock.h"
+
+namespace Kernel {
+
+/// Number of host threads servicing blocking HLE work
+constexpr std::size_t NUM_HLE_WORKERS = 2;
+
+struct HLEJob {
+    HLEWork work;
+    HLEWork completion;
+};
+
+static std::vector<std::thread> workers;
+static std::mutex queue_mutex;
+static std::condition_variable queue_cv;
+static std::deque<HLEJob> pending_jobs;
+static bool stop_workers = false;
+
+/// Completions of finished jobs, waiting to be run on the CPU thread
+static Common::MPSCQueue<HLEWork, false> finished_jobs;
+static CoreTiming::EventType* completion_event_type = nullptr;
+
+/// Runs the completions of all finished jobs, called on the CPU thread by CoreTiming
+static void HLEWorkCompletionCallback(u64 userdata, int cycles_late) {
+    // Lock the global kernel mutex when we enter the kernel HLE.
+    HLE::LockGuard lock;
+
+    HLEWork completion;
+    while (finished_jobs.Pop(completion)) {
+        completion();
+    }
+}
+
+static void WorkerLoop() {
+    while (true) {
+        HLEJob job;
+        {
+            std::unique_lock<std::mutex> lock(queue_mutex);
+            queue_cv.wait(lock, [] { return stop_workers || !pending_jobs.empty(); });
+            if (stop_workers) {
+                return;
+            }
+            job = std::move(pending_jobs.front());
+            pending_jobs.pop_front();
+        }
+
+        job.work();
+
+        // The completion may signal kernel objects and write guest memory, so it is handed back
+        // to the CPU thread instead of being run here.
+        finished_jobs.Push(std::move(job.completion));
+        CoreTiming::ScheduleEventThreadsafe(0, completion_event_type, 0);
+    }
+}
+
+void QueueHLEWork(HLEWork work, HLEWork completion) {
+    ASSERT(!workers.empty());
+
+    {
+        std::lock_guard<std::mutex> lock(queue_mutex);
+        pending_jobs.push_back({std::move(work), std::move(completion)});
+    }
+    queue_cv.notify_one();
+}
+
+void QueueHLECompletion(HLEWork completion) {
+    {
+        std::lock_guard<std::mutex> lock(queue_mutex);
+        if (stop_workers) {
+            // The kernel is shutting down, nothing is waiting for the completion anymore
+            return;
+        }
+    }
+
+    finished_jobs.Push(std::move(completion));
+    CoreTiming::ScheduleEventThreadsafe(0, completion_event_type, 0);
+}
+
+void HLEWorkersInit() {
+    completion_event_type =
+        CoreTiming::RegisterEvent("HLEWorkCompletionCallback", HLEWorkCompletionCallback);
+
+    stop_workers = false;
+    workers.reserve(NUM_HLE_WORKERS);
+    for (std::size_t i = 0; i < NUM_HLE_WORKERS; ++i) {
+        workers.emplace_back(WorkerLoop);
+    }
+}
+
+void HLEWorkersShutdown() {
+    {
+        std::lock_guard<std::mutex> lock(queue_mutex);
+        stop_workers = true;
+        pending_jobs.clear();
+    }
+    queue_cv.notify_all();
+
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    workers.clear();
+    finished_jobs.Clear();
+}
+
+} // namespace Kernel
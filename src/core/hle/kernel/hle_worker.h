@@ -0,0 +1,35 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <functional>
+
+namespace Kernel {
+
+using HLEWork = std::function<void()>;
+
+/**
+ * Queues blocking host work (file or socket I/O, ...) on the HLE worker pool, so that the emulated
+ * core that issued the request can keep running other guest threads in the meantime.
+ * @param work Function run on a host worker thread. It must not touch emulated memory or kernel
+ * state, and should only operate on data it owns or shares with the completion.
+ * @param completion Function run on the CPU thread, with the HLE lock held, once the work is
+ * done. This is where the results are handed back to the guest.
+ */
+void QueueHLEWork(HLEWork work, HLEWork completion);
+
+/**
+ * Runs completion on the CPU thread, with the HLE lock held, as soon as possible. Meant for host
+ * threads of services that wait on the host themselves, e.g. for socket events. Thread-safe.
+ */
+void QueueHLECompletion(HLEWork completion);
+
+/// Initializes the HLE worker pool
+void HLEWorkersInit();
+
+/// Stops the HLE worker pool, discarding any work that has not completed yet
+void HLEWorkersShutdown();
+
+} // namespace Kernel
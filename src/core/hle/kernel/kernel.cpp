@@ -2,10 +2,13 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include "core/core.h"
 #include "core/hle/kernel/handle_table.h"
+#include "core/hle/kernel/hle_worker.h"
 #include "core/hle/kernel/kernel.h"
 #include "core/hle/kernel/process.h"
 #include "core/hle/kernel/resource_limit.h"
+#include "core/hle/kernel/svc.h"
 #include "core/hle/kernel/thread.h"
 #include "core/hle/kernel/timer.h"
 
@@ -18,6 +21,8 @@ void Init() {
     Kernel::ResourceLimitsInit();
     Kernel::ThreadingInit();
     Kernel::TimersInit();
+    Kernel::HLEWorkersInit();
+    Kernel::ResetSVCStatistics();
 
     Object::next_object_id = 0;
     // TODO(Subv): Start the process ids from 10 for now, as lower PIDs are
@@ -27,8 +32,11 @@ void Init() {
 
 /// Shutdown the kernel
 void Shutdown() {
+    // Stop servicing asynchronous HLE work before the objects it refers to go away
+    Kernel::HLEWorkersShutdown();
+
     // Free all kernel objects
-    g_handle_table.Clear();
+    Core::CurrentProcess()->handle_table.Clear();
 
     Kernel::ThreadingShutdown();
 
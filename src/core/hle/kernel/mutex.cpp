@@ -14,6 +14,7 @@
 #include "core/hle/kernel/handle_table.h"
 #include "core/hle/kernel/mutex.h"
 #include "core/hle/kernel/object.h"
+#include "core/hle/kernel/process.h"
 #include "core/hle/kernel/thread.h"
 #include "core/hle/result.h"
 
@@ -60,13 +61,14 @@ static void TransferMutexOwnership(VAddr mutex_addr, SharedPtr<Thread> current_t
 
 ResultCode Mutex::TryAcquire(VAddr address, Handle holding_thread_handle,
                              Handle requesting_thread_handle) {
+    const auto& handle_table = Core::CurrentProcess()->handle_table;
     // The mutex address must be 4-byte aligned
     if ((address % sizeof(u32)) != 0) {
         return ResultCode(ErrorModule::Kernel, ErrCodes::InvalidAddress);
     }
 
-    SharedPtr<Thread> holding_thread = g_handle_table.Get<Thread>(holding_thread_handle);
-    SharedPtr<Thread> requesting_thread = g_handle_table.Get<Thread>(requesting_thread_handle);
+    SharedPtr<Thread> holding_thread = handle_table.Get<Thread>(holding_thread_handle);
+    SharedPtr<Thread> requesting_thread = handle_table.Get<Thread>(requesting_thread_handle);
 
     // TODO(Subv): It is currently unknown if it is possible to lock a mutex in behalf of another
     // thread.
@@ -128,7 +130,7 @@ ResultCode Mutex::Release(VAddr address) {
     thread->ResumeFromWait();
 
     thread->lock_owner = nullptr;
-    thread->condvar_wait_address = 0;
+    thread->SetCondVarWaitAddress(0);
     thread->mutex_wait_address = 0;
     thread->wait_handle = 0;
 
@@ -162,18 +162,25 @@ ResultVal<VAddr> Process::HeapAllocate(VAddr target, u64 size, VMAPermission per
     }
 
     // If necessary, expand backing vector to cover new heap extents.
+    const u8* const old_heap_data = heap_memory->data();
+    bool heap_moved = false;
     if (target < heap_start) {
         heap_memory->insert(begin(*heap_memory), heap_start - target, 0);
         heap_start = target;
-        vm_manager.RefreshMemoryBlockMappings(heap_memory.get());
+        heap_moved = true;
     }
     if (target + size > heap_end) {
         heap_memory->insert(end(*heap_memory), (target + size) - heap_end, 0);
         heap_end = target + size;
-        vm_manager.RefreshMemoryBlockMappings(heap_memory.get());
     }
     ASSERT(heap_end - heap_start == heap_memory->size());
 
+    // Growing the heap at its end only invalidates existing mappings of the backing block if the
+    // vector had to be reallocated, so avoid re-pointing every page when it didn't.
+    if (heap_moved || heap_memory->data() != old_heap_data) {
+        vm_manager.RefreshMemoryBlockMappings(heap_memory.get());
+    }
+
     CASCADE_RESULT(auto vma, vm_manager.MapMemoryBlock(target, heap_memory, target - heap_start,
                                                        size, MemoryState::Heap));
     vm_manager.Reprotect(vma, perms);
@@ -13,6 +13,7 @@
 #include <boost/container/static_vector.hpp>
 #include "common/bit_field.h"
 #include "common/common_types.h"
+#include "core/hle/kernel/handle_table.h"
 #include "core/hle/kernel/object.h"
 #include "core/hle/kernel/thread.h"
 #include "core/hle/kernel/vm_manager.h"
@@ -173,6 +174,9 @@ public:
 
     void LoadModule(SharedPtr<CodeSet> module_, VAddr base_addr);
 
+    /// Table of the handles the process refers to kernel objects by
+    HandleTable handle_table;
+
     ///////////////////////////////////////////////////////////////////////////////////////////////
     // Memory Management
 
@@ -195,6 +199,9 @@ public:
     /// page as a bitmask.
     /// This vector will grow as more pages are allocated for new threads.
     std::vector<std::bitset<8>> tls_slots;
+    /// Index of the first TLS page that may still have a free slot. Every page before it is known
+    /// to be full, so slot searches can start here instead of at the first page.
+    std::size_t tls_slot_search_start = 0;
 
     std::string name;
 
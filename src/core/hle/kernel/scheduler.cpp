@@ -15,8 +15,6 @@
 
 namespace Kernel {
 
-std::mutex Scheduler::scheduler_mutex;
-
 Scheduler::Scheduler(ARM_Interface* cpu_core) : cpu_core(cpu_core) {}
 
 Scheduler::~Scheduler() {
@@ -123,7 +121,6 @@ void Scheduler::AddThread(SharedPtr<Thread> thread, u32 priority) {
     std::lock_guard<std::mutex> lock(scheduler_mutex);
 
     thread_list.push_back(std::move(thread));
-    ready_queue.prepare(priority);
 }
 
 void Scheduler::RemoveThread(Thread* thread) {
@@ -153,8 +150,6 @@ void Scheduler::SetThreadPriority(Thread* thread, u32 priority) {
     // If thread was ready, adjust queues
     if (thread->status == ThreadStatus::Ready)
         ready_queue.move(thread, thread->current_priority, priority);
-    else
-        ready_queue.prepare(priority);
 }
 
 } // namespace Kernel
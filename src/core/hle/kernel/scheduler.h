@@ -72,7 +72,9 @@ private:
 
     ARM_Interface* cpu_core;
 
-    static std::mutex scheduler_mutex;
+    /// Guards this core's thread lists. Other cores only take it to move threads in or out of this
+    /// scheduler, so independent cores never serialize on each other's reschedules.
+    mutable std::mutex scheduler_mutex;
 };
 
 } // namespace Kernel
@@ -68,23 +68,31 @@ ResultCode ServerSession::HandleDomainSyncRequest(Kernel::HLERequestContext& con
         context.SetDomainRequestHandlers(domain_request_handlers);
 
         // If there is a DomainMessageHeader, then this is CommandType "Request"
-        const u32 object_id{context.GetDomainMessageHeader()->object_id};
+        const u32 object_id{domain_message_header->object_id};
+        if (object_id == 0 || object_id > domain_request_handlers.size()) {
+            LOG_CRITICAL(IPC,
+                         "object_id {} is out of range! This probably means a recent service call "
+                         "to {} needed to return a new interface!",
+                         object_id, name);
+            UNREACHABLE();
+            return RESULT_SUCCESS; // Ignore error if asserts are off
+        }
+
+        // Domain object ids are 1-based indices into the handler table
+        auto& handler = domain_request_handlers[object_id - 1];
         switch (domain_message_header->command) {
         case IPC::DomainMessageHeader::CommandType::SendMessage:
-            if (object_id > domain_request_handlers.size()) {
-                LOG_CRITICAL(IPC,
-                             "object_id {} is too big! This probably means a recent service call "
-                             "to {} needed to return a new interface!",
-                             object_id, name);
+            if (handler == nullptr) {
+                LOG_CRITICAL(IPC, "object_id {} of {} was already closed!", object_id, name);
                 UNREACHABLE();
                 return RESULT_SUCCESS; // Ignore error if asserts are off
             }
-            return domain_request_handlers[object_id - 1]->HandleSyncRequest(context);
+            return handler->HandleSyncRequest(context);
 
         case IPC::DomainMessageHeader::CommandType::CloseVirtualHandle: {
             LOG_DEBUG(IPC, "CloseVirtualHandle, object_id=0x{:08X}", object_id);
 
-            domain_request_handlers[object_id - 1] = nullptr;
+            handler = nullptr;
 
             IPC::ResponseBuilder rb{context, 2};
             rb.Push(RESULT_SUCCESS);
@@ -107,8 +115,8 @@ ResultCode ServerSession::HandleSyncRequest(SharedPtr<Thread> thread) {
 
     Kernel::HLERequestContext context(this);
     u32* cmd_buf = (u32*)Memory::GetPointer(thread->GetTLSAddress());
-    context.PopulateFromIncomingCommandBuffer(cmd_buf, *Core::CurrentProcess(),
-                                              Kernel::g_handle_table);
+    context.PopulateFromIncomingCommandBuffer(cmd_buf, *thread->owner_process,
+                                              thread->owner_process->handle_table);
 
     ResultCode result = RESULT_SUCCESS;
     // If the session has been converted to a domain, handle the domain request
@@ -11,6 +11,7 @@
 #include "common/common_types.h"
 #include "core/hle/kernel/object.h"
 #include "core/hle/kernel/process.h"
+#include "core/hle/kernel/slab_heap.h"
 #include "core/hle/result.h"
 
 namespace Kernel {
@@ -28,7 +29,7 @@ enum class MemoryPermission : u32 {
     DontCare = (1u << 28)
 };
 
-class SharedMemory final : public Object {
+class SharedMemory final : public Object, public SlabAllocated<SharedMemory> {
 public:
     /**
      * Creates a shared memory object.
@@ -0,0 +1,101 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "common/assert.h"
+#include "common/common_types.h"
+
+namespace Kernel {
+
+/**
+ * Free list allocator for kernel objects of a single type. Storage is carved out of chunks of
+ * OBJECTS_PER_CHUNK objects, and freed objects are kept for reuse instead of going back to the
+ * host heap. Objects that are created and destroyed often (sessions, events, threads) thus avoid
+ * a malloc/free pair each and end up close to each other in memory.
+ */
+template <typename T>
+class SlabHeap final {
+public:
+    static void* Allocate(std::size_t size) {
+        // A class deriving from a slab allocated type would need a heap of its own
+        ASSERT(size == sizeof(T));
+
+        SlabHeap& heap = GetInstance();
+        std::lock_guard<std::mutex> lock(heap.mutex);
+
+        if (heap.free_list == nullptr) {
+            heap.Grow();
+        }
+
+        Node* const node = heap.free_list;
+        heap.free_list = node->next;
+        return node;
+    }
+
+    static void Free(void* pointer) {
+        if (pointer == nullptr) {
+            return;
+        }
+
+        SlabHeap& heap = GetInstance();
+        std::lock_guard<std::mutex> lock(heap.mutex);
+
+        Node* const node = static_cast<Node*>(pointer);
+        node->next = heap.free_list;
+        heap.free_list = node;
+    }
+
+private:
+    static constexpr std::size_t OBJECTS_PER_CHUNK = 64;
+
+    union Node {
+        Node* next;
+        alignas(T) u8 storage[sizeof(T)];
+    };
+
+    static SlabHeap& GetInstance() {
+        // Deliberately never destroyed: kernel objects may still be released during static
+        // destruction (e.g. by the System instance), after a function-local static would be gone.
+        static SlabHeap* const heap = new SlabHeap;
+        return *heap;
+    }
+
+    void Grow() {
+        auto chunk = std::make_unique<Node[]>(OBJECTS_PER_CHUNK);
+        for (std::size_t i = 0; i < OBJECTS_PER_CHUNK; ++i) {
+            chunk[i].next = free_list;
+            free_list = &chunk[i];
+        }
+        chunks.push_back(std::move(chunk));
+    }
+
+    std::mutex mutex;
+    Node* free_list = nullptr;
+    std::vector<std::unique_ptr<Node[]>> chunks;
+};
+
+/**
+ * Base class for kernel object types that should be allocated from a SlabHeap. Deleting the
+ * object through a pointer to Object still returns it to the right heap, as the deallocation
+ * function is looked up in the dynamic type.
+ */
+template <typename T>
+class SlabAllocated {
+public:
+    static void* operator new(std::size_t size) {
+        return SlabHeap<T>::Allocate(size);
+    }
+
+    static void operator delete(void* pointer) {
+        SlabHeap<T>::Free(pointer);
+    }
+};
+
+} // namespace Kernel
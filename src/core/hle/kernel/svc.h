@@ -4,6 +4,7 @@
 
 #pragma once
 
+#include <vector>
 #include "common/common_types.h"
 
 namespace Kernel {
@@ -57,4 +58,18 @@ enum class GetInfoType : u64 {
 
 void CallSVC(u32 immediate);
 
+/// Number of calls to an implemented SVC and the host time spent servicing them
+struct SVCStatistics {
+    u32 id;
+    const char* name;
+    u64 call_count;
+    u64 total_time_ns;
+};
+
+/// Returns the statistics of every SVC that has been called since the last reset
+std::vector<SVCStatistics> GetSVCStatistics();
+
+/// Resets the counters returned by GetSVCStatistics
+void ResetSVCStatistics();
+
 } // namespace Kernel
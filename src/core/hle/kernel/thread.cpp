@@ -4,12 +4,14 @@
 
 #include <algorithm>
 #include <cinttypes>
+#include <unordered_map>
 #include <vector>
 
 #include <boost/optional.hpp>
 #include <boost/range/algorithm_ext/erase.hpp>
 
 #include "common/assert.h"
+#include "common/bit_set.h"
 #include "common/common_types.h"
 #include "common/logging/log.h"
 #include "common/math_util.h"
@@ -32,6 +34,51 @@ namespace Kernel {
 /// Event type for the thread wake up event
 static CoreTiming::EventType* ThreadWakeupEventType = nullptr;
 
+using WaiterIndex = std::unordered_map<VAddr, std::vector<Thread*>>;
+
+// Threads waiting on a condition variable or an arbiter address, indexed by that address, so that
+// signaling only has to look at the actual waiters instead of every thread on every core.
+static WaiterIndex condvar_waiters;
+static WaiterIndex arbiter_waiters;
+
+static void UpdateWaiterIndex(WaiterIndex& index, Thread* thread, VAddr old_address,
+                              VAddr new_address) {
+    if (old_address == new_address) {
+        return;
+    }
+
+    if (old_address != 0) {
+        const auto itr = index.find(old_address);
+        ASSERT(itr != index.end());
+        boost::remove_erase(itr->second, thread);
+        if (itr->second.empty()) {
+            index.erase(itr);
+        }
+    }
+
+    if (new_address != 0) {
+        index[new_address].push_back(thread);
+    }
+}
+
+static std::vector<SharedPtr<Thread>> GetWaiters(const WaiterIndex& index, VAddr address) {
+    const auto itr = index.find(address);
+    if (itr == index.end()) {
+        return {};
+    }
+
+    std::vector<SharedPtr<Thread>> threads(itr->second.begin(), itr->second.end());
+
+    // Sort them by priority, such that the highest priority ones come first. Priorities may have
+    // changed while waiting, so this can't be maintained on insertion.
+    std::stable_sort(threads.begin(), threads.end(),
+                     [](const SharedPtr<Thread>& lhs, const SharedPtr<Thread>& rhs) {
+                         return lhs->current_priority < rhs->current_priority;
+                     });
+
+    return threads;
+}
+
 bool Thread::ShouldWait(Thread* thread) const {
     return status != ThreadStatus::Dead;
 }
@@ -56,7 +103,10 @@ inline static u32 const NewThreadId() {
 }
 
 Thread::Thread() {}
-Thread::~Thread() {}
+Thread::~Thread() {
+    // The objects don't keep the threads waiting on them alive
+    ClearWaitObjects();
+}
 
 void Thread::Stop() {
     // Cancel any outstanding wakeup events for this thread
@@ -75,16 +125,37 @@ void Thread::Stop() {
     WakeupAllWaitingThreads();
 
     // Clean up any dangling references in objects that this thread was waiting for
-    for (auto& wait_object : wait_objects) {
-        wait_object->RemoveWaitingThread(this);
-    }
-    wait_objects.clear();
+    ClearWaitObjects();
+
+    SetCondVarWaitAddress(0);
+    SetArbiterWaitAddress(0);
 
     // Mark the TLS slot in the thread's page as free.
     const u64 tls_page = (tls_address - Memory::TLS_AREA_VADDR) / Memory::PAGE_SIZE;
     const u64 tls_slot =
         ((tls_address - Memory::TLS_AREA_VADDR) % Memory::PAGE_SIZE) / Memory::TLS_ENTRY_SIZE;
-    Core::CurrentProcess()->tls_slots[tls_page].reset(tls_slot);
+    auto& process = Core::CurrentProcess();
+    process->tls_slots[tls_page].reset(tls_slot);
+    process->tls_slot_search_start =
+        std::min<std::size_t>(process->tls_slot_search_start, tls_page);
+}
+
+void Thread::SetCondVarWaitAddress(VAddr address) {
+    UpdateWaiterIndex(condvar_waiters, this, condvar_wait_address, address);
+    condvar_wait_address = address;
+}
+
+void Thread::SetArbiterWaitAddress(VAddr address) {
+    UpdateWaiterIndex(arbiter_waiters, this, arb_wait_address, address);
+    arb_wait_address = address;
+}
+
+std::vector<SharedPtr<Thread>> GetThreadsWaitingOnCondVar(VAddr address) {
+    return GetWaiters(condvar_waiters, address);
+}
+
+std::vector<SharedPtr<Thread>> GetThreadsWaitingOnArbiter(VAddr address) {
+    return GetWaiters(arbiter_waiters, address);
 }
 
 void WaitCurrentThread_Sleep() {
@@ -107,7 +178,7 @@ static void ThreadWakeupCallback(u64 thread_handle, int cycles_late) {
     const auto proper_handle = static_cast<Handle>(thread_handle);
 
     // Lock the global kernel mutex when we enter the kernel HLE.
-    std::lock_guard<std::recursive_mutex> lock(HLE::g_hle_lock);
+    HLE::LockGuard lock;
 
     SharedPtr<Thread> thread = wakeup_callback_handle_table.Get<Thread>(proper_handle);
     if (thread == nullptr) {
@@ -121,9 +192,7 @@ static void ThreadWakeupCallback(u64 thread_handle, int cycles_late) {
         thread->status == ThreadStatus::WaitSynchAll ||
         thread->status == ThreadStatus::WaitHLEEvent) {
         // Remove the thread from each of its waiting objects' waitlists
-        for (auto& object : thread->wait_objects)
-            object->RemoveWaitingThread(thread.get());
-        thread->wait_objects.clear();
+        thread->ClearWaitObjects();
 
         // Invoke the wakeup callback before clearing the wait objects
         if (thread->wakeup_callback)
@@ -134,7 +203,7 @@ static void ThreadWakeupCallback(u64 thread_handle, int cycles_late) {
         thread->wait_handle) {
         ASSERT(thread->status == ThreadStatus::WaitMutex);
         thread->mutex_wait_address = 0;
-        thread->condvar_wait_address = 0;
+        thread->SetCondVarWaitAddress(0);
         thread->wait_handle = 0;
 
         auto lock_owner = thread->lock_owner;
@@ -148,7 +217,7 @@ static void ThreadWakeupCallback(u64 thread_handle, int cycles_late) {
 
     if (thread->arb_wait_address != 0) {
         ASSERT(thread->status == ThreadStatus::WaitArb);
-        thread->arb_wait_address = 0;
+        thread->SetArbiterWaitAddress(0);
     }
 
     if (resume)
@@ -259,17 +328,16 @@ void Thread::ResumeFromWait() {
  * alloc_needed: Whether there's a need to allocate a new TLS page (All pages are full).
  */
 static std::tuple<std::size_t, std::size_t, bool> GetFreeThreadLocalSlot(
-    const std::vector<std::bitset<8>>& tls_slots) {
-    // Iterate over all the allocated pages, and try to find one where not all slots are used.
-    for (std::size_t page = 0; page < tls_slots.size(); ++page) {
+    const std::vector<std::bitset<8>>& tls_slots, std::size_t& search_start) {
+    // Iterate over the allocated pages that may have a free slot, and try to find one where not
+    // all slots are used. Pages that turn out to be full are skipped by later searches.
+    for (std::size_t page = search_start; page < tls_slots.size(); ++page, ++search_start) {
         const auto& page_tls_slots = tls_slots[page];
         if (!page_tls_slots.all()) {
-            // We found a page with at least one free slot, find which slot it is
-            for (std::size_t slot = 0; slot < page_tls_slots.size(); ++slot) {
-                if (!page_tls_slots.test(slot)) {
-                    return std::make_tuple(page, slot, false);
-                }
-            }
+            // We found a page with at least one free slot, the lowest clear bit is the first one
+            const u32 free_slots = static_cast<u32>(~page_tls_slots.to_ulong() & 0xFF);
+            const auto slot = static_cast<std::size_t>(Common::LeastSignificantSetBit(free_slots));
+            return std::make_tuple(page, slot, false);
         }
     }
 
@@ -330,7 +398,7 @@ ResultVal<SharedPtr<Thread>> Thread::Create(std::string name, VAddr entry_point,
     thread->affinity_mask = 1ULL << processor_id;
     thread->wait_objects.clear();
     thread->mutex_wait_address = 0;
-    thread->condvar_wait_address = 0;
+    thread->SetCondVarWaitAddress(0);
     thread->wait_handle = 0;
     thread->name = std::move(name);
     thread->callback_handle = wakeup_callback_handle_table.Create(thread).Unwrap();
@@ -341,7 +409,8 @@ ResultVal<SharedPtr<Thread>> Thread::Create(std::string name, VAddr entry_point,
     // Find the next available TLS index, and mark it as used
     auto& tls_slots = owner_process->tls_slots;
 
-    auto [available_page, available_slot, needs_allocation] = GetFreeThreadLocalSlot(tls_slots);
+    auto [available_page, available_slot, needs_allocation] =
+        GetFreeThreadLocalSlot(tls_slots, owner_process->tls_slot_search_start);
     if (needs_allocation) {
         tls_slots.emplace_back(0); // The page is completely available at the start
         available_page = tls_slots.size() - 1;
@@ -349,10 +418,14 @@ ResultVal<SharedPtr<Thread>> Thread::Create(std::string name, VAddr entry_point,
 
         // Allocate some memory from the end of the linear heap for this region.
         const size_t offset = thread->tls_memory->size();
+        const u8* const old_tls_data = thread->tls_memory->data();
         thread->tls_memory->insert(thread->tls_memory->end(), Memory::PAGE_SIZE, 0);
 
+        // Existing mappings only need to be refreshed if the vector was reallocated.
         auto& vm_manager = owner_process->vm_manager;
-        vm_manager.RefreshMemoryBlockMappings(thread->tls_memory.get());
+        if (thread->tls_memory->data() != old_tls_data) {
+            vm_manager.RefreshMemoryBlockMappings(thread->tls_memory.get());
+        }
 
         vm_manager.MapMemoryBlock(Memory::TLS_AREA_VADDR + available_page * Memory::PAGE_SIZE,
                                   thread->tls_memory, 0, Memory::PAGE_SIZE,
@@ -395,7 +468,7 @@ SharedPtr<Thread> SetupMainThread(VAddr entry_point, u32 priority,
     SharedPtr<Thread> thread = std::move(thread_res).Unwrap();
 
     // Register 1 must be a handle to the main thread
-    thread->guest_handle = Kernel::g_handle_table.Create(thread).Unwrap();
+    thread->guest_handle = thread->owner_process->handle_table.Create(thread).Unwrap();
 
     thread->context.cpu_registers[1] = thread->guest_handle;
 
@@ -413,10 +486,28 @@ void Thread::SetWaitSynchronizationOutput(s32 output) {
     context.cpu_registers[1] = output;
 }
 
-s32 Thread::GetWaitObjectIndex(WaitObject* object) const {
-    ASSERT_MSG(!wait_objects.empty(), "Thread is not waiting for anything");
-    auto match = std::find(wait_objects.rbegin(), wait_objects.rend(), object);
-    return static_cast<s32>(std::distance(match, wait_objects.rend()) - 1);
+void Thread::SetWaitObjects(std::vector<SharedPtr<WaitObject>> objects) {
+    ASSERT_MSG(wait_nodes.empty(), "Thread is already waiting for objects");
+    wait_objects = std::move(objects);
+    wait_nodes.reserve(wait_objects.size());
+
+    // Linked from the last object on, a repeated object is then found at the tail of its list
+    for (std::size_t i = wait_objects.size(); i-- > 0;) {
+        WaitObject* const object = wait_objects[i].get();
+        if (object->IsLastWaiter(this))
+            continue;
+
+        wait_nodes.push_back({this, object, static_cast<s32>(i), nullptr, nullptr});
+        object->LinkWaiter(wait_nodes.back());
+    }
+}
+
+void Thread::ClearWaitObjects() {
+    for (auto& node : wait_nodes) {
+        node.object->UnlinkWaiter(node);
+    }
+    wait_nodes.clear();
+    wait_objects.clear();
 }
 
 VAddr Thread::GetCommandBufferAddress() const {
@@ -535,6 +626,8 @@ void ThreadingInit() {
 
 void ThreadingShutdown() {
     Kernel::ClearProcessList();
+    condvar_waiters.clear();
+    arbiter_waiters.clear();
 }
 
 } // namespace Kernel
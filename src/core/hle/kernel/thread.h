@@ -12,6 +12,7 @@
 #include "common/common_types.h"
 #include "core/arm/arm_interface.h"
 #include "core/hle/kernel/object.h"
+#include "core/hle/kernel/slab_heap.h"
 #include "core/hle/kernel/wait_object.h"
 #include "core/hle/result.h"
 
@@ -59,7 +60,7 @@ namespace Kernel {
 class Process;
 class Scheduler;
 
-class Thread final : public WaitObject {
+class Thread final : public WaitObject, public SlabAllocated<Thread> {
 public:
     /**
      * Creates and returns a new thread. The new thread is immediately scheduled
@@ -158,21 +159,36 @@ public:
     void SetWaitSynchronizationOutput(s32 output);
 
     /**
-     * Retrieves the index that this particular object occupies in the list of objects
-     * that the thread passed to WaitSynchronizationN, starting the search from the last element.
-     * It is used to set the output value of WaitSynchronizationN when the thread is awakened.
-     * When a thread wakes up due to an object signal, the kernel will use the index of the last
-     * matching object in the wait objects list in case of having multiple instances of the same
-     * object in the list.
-     * @param object Object to query the index of.
+     * Makes the thread wait on the given objects by adding it to the waiters of each of them.
+     * An object passed more than once gets a single entry, which holds the index of its last
+     * instance. It's the index WaitSynchronizationN outputs when that object wakes the thread,
+     * so waking doesn't need to search the objects.
+     * @param objects Objects in the order they were passed to WaitSynchronization1/N.
      */
-    s32 GetWaitObjectIndex(WaitObject* object) const;
+    void SetWaitObjects(std::vector<SharedPtr<WaitObject>> objects);
+
+    /// Removes the thread from the waiters of the objects it's waiting on
+    void ClearWaitObjects();
 
     /**
      * Stops a thread, invalidating it from further use
      */
     void Stop();
 
+    /**
+     * Sets the condition variable address this thread waits on, keeping the kernel-wide index of
+     * condition variable waiters up to date. Passing 0 removes the thread from the index.
+     * @param address Address of the condition variable
+     */
+    void SetCondVarWaitAddress(VAddr address);
+
+    /**
+     * Sets the address this thread waits on via the AddressArbiter, keeping the kernel-wide index
+     * of arbiter waiters up to date. Passing 0 removes the thread from the index.
+     * @param address Address being waited on
+     */
+    void SetArbiterWaitAddress(VAddr address);
+
     /*
      * Returns the Thread Local Storage address of the current thread
      * @returns VAddr of the thread's TLS
@@ -228,18 +244,24 @@ public:
     // passed to WaitSynchronization1/N.
     std::vector<SharedPtr<WaitObject>> wait_objects;
 
+    /// Entries of the thread in the waiter lists of wait_objects. Reserved up front, so that
+    /// they don't move while linked.
+    std::vector<WaitListNode> wait_nodes;
+
     /// List of threads that are waiting for a mutex that is held by this thread.
     std::vector<SharedPtr<Thread>> wait_mutex_threads;
 
     /// Thread that owns the lock that this thread is waiting for.
     SharedPtr<Thread> lock_owner;
 
-    // If waiting on a ConditionVariable, this is the ConditionVariable  address
-    VAddr condvar_wait_address;
+    // If waiting on a ConditionVariable, this is the ConditionVariable  address.
+    // Only change it through SetCondVarWaitAddress.
+    VAddr condvar_wait_address{0};
     VAddr mutex_wait_address; ///< If waiting on a Mutex, this is the mutex address
     Handle wait_handle;       ///< The handle used to wait for the mutex.
 
     // If waiting for an AddressArbiter, this is the address being waited on.
+    // Only change it through SetArbiterWaitAddress.
     VAddr arb_wait_address{0};
 
     std::string name;
@@ -284,6 +306,18 @@ SharedPtr<Thread> SetupMainThread(VAddr entry_point, u32 priority,
  */
 Thread* GetCurrentThread();
 
+/**
+ * Gets the threads waiting on a condition variable, highest priority first
+ * @param address Address of the condition variable
+ */
+std::vector<SharedPtr<Thread>> GetThreadsWaitingOnCondVar(VAddr address);
+
+/**
+ * Gets the threads waiting on an address via the AddressArbiter, highest priority first
+ * @param address Address being waited on
+ */
+std::vector<SharedPtr<Thread>> GetThreadsWaitingOnArbiter(VAddr address);
+
 /**
  * Waits the current thread on a sleep
  */
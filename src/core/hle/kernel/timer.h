@@ -6,11 +6,12 @@
 
 #include "common/common_types.h"
 #include "core/hle/kernel/object.h"
+#include "core/hle/kernel/slab_heap.h"
 #include "core/hle/kernel/wait_object.h"
 
 namespace Kernel {
 
-class Timer final : public WaitObject {
+class Timer final : public WaitObject, public SlabAllocated<Timer> {
 public:
     /**
      * Creates a timer
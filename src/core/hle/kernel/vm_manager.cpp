@@ -4,6 +4,7 @@
 
 #include <algorithm>
 #include <iterator>
+#include <unordered_set>
 #include <utility>
 #include "common/assert.h"
 #include "common/logging/log.h"
@@ -53,6 +54,12 @@ bool VirtualMemoryArea::CanBeMergedWith(const VirtualMemoryArea& next) const {
     return true;
 }
 
+thread_local VMManager::BackingLookupCache VMManager::lookup_cache;
+
+/// Source of lookup cache generations, shared by all VMManagers so that a new VMManager allocated
+/// at the address of a destroyed one never matches the stale cache of a thread.
+static std::atomic<u64> next_lookup_generation{1};
+
 VMManager::VMManager() {
     Reset();
 }
@@ -63,6 +70,7 @@ VMManager::~VMManager() {
 
 void VMManager::Reset() {
     vma_map.clear();
+    InvalidateLookupCache();
 
     // Initialize the map with a single free region covering the entire managed space.
     VirtualMemoryArea initial_vma;
@@ -72,6 +80,12 @@ void VMManager::Reset() {
     page_table.pointers.fill(nullptr);
     page_table.special_regions.clear();
     page_table.attributes.fill(Memory::PageType::Unmapped);
+    for (auto& word : page_table.flush_pending) {
+        word.store(0, std::memory_order_relaxed);
+    }
+    for (auto& word : page_table.invalidate_pending) {
+        word.store(0, std::memory_order_relaxed);
+    }
 
     UpdatePageTableForVMA(initial_vma);
 }
@@ -84,6 +98,74 @@ VMManager::VMAHandle VMManager::FindVMA(VAddr target) const {
     }
 }
 
+u8* VMManager::GetBackingPointer(VAddr target) const {
+    const BackingLookupEntry* entry = LookupBacking(target);
+    if (entry == nullptr) {
+        return nullptr;
+    }
+
+    return entry->backing + (target - entry->base);
+}
+
+u8* VMManager::GetPointerRange(VAddr target, u64 size) const {
+    const BackingLookupEntry* entry = LookupBacking(target);
+    if (entry == nullptr) {
+        return nullptr;
+    }
+
+    // Adjacent VMAs backed by the same contiguous memory are always merged, so a range that runs
+    // past the end of its VMA is not host-contiguous.
+    const u64 offset = target - entry->base;
+    if (size > entry->size - offset) {
+        return nullptr;
+    }
+
+    return entry->backing + offset;
+}
+
+const VMManager::BackingLookupEntry* VMManager::LookupBacking(VAddr target) const {
+    const u64 generation = lookup_generation.load(std::memory_order_acquire);
+    if (lookup_cache.owner != this || lookup_cache.generation != generation) {
+        lookup_cache = {};
+        lookup_cache.owner = this;
+        lookup_cache.generation = generation;
+    }
+
+    for (const auto& entry : lookup_cache.entries) {
+        if (entry.backing != nullptr && target - entry.base < entry.size) {
+            return &entry;
+        }
+    }
+
+    const auto it = FindVMA(target);
+    if (it == vma_map.end()) {
+        return nullptr;
+    }
+
+    const VirtualMemoryArea& vma = it->second;
+    u8* backing;
+    switch (vma.type) {
+    case VMAType::AllocatedMemoryBlock:
+        backing = vma.backing_block->data() + vma.offset;
+        break;
+    case VMAType::BackingMemory:
+        backing = vma.backing_memory;
+        break;
+    default:
+        return nullptr;
+    }
+
+    BackingLookupEntry& entry = lookup_cache.entries[lookup_cache.next];
+    lookup_cache.next = (lookup_cache.next + 1) % LOOKUP_CACHE_SIZE;
+    entry = {vma.base, vma.size, backing};
+    return &entry;
+}
+
+void VMManager::InvalidateLookupCache() {
+    lookup_generation.store(next_lookup_generation.fetch_add(1, std::memory_order_relaxed),
+                            std::memory_order_release);
+}
+
 ResultVal<VMManager::VMAHandle> VMManager::MapMemoryBlock(VAddr target,
                                                           std::shared_ptr<std::vector<u8>> block,
                                                           size_t offset, u64 size,
@@ -159,6 +241,8 @@ ResultVal<VMManager::VMAHandle> VMManager::MapMMIO(VAddr target, PAddr paddr, u6
 }
 
 VMManager::VMAIter VMManager::Unmap(VMAIter vma_handle) {
+    InvalidateLookupCache();
+
     VirtualMemoryArea& vma = vma_handle->second;
     vma.type = VMAType::Free;
     vma.permissions = VMAPermission::None;
@@ -198,6 +282,7 @@ ResultCode VMManager::UnmapRange(VAddr target, u64 size) {
 
 VMManager::VMAHandle VMManager::Reprotect(VMAHandle vma_handle, VMAPermission new_perms) {
     VMAIter iter = StripIterConstness(vma_handle);
+    InvalidateLookupCache();
 
     VirtualMemoryArea& vma = iter->second;
     vma.permissions = new_perms;
@@ -221,6 +306,9 @@ ResultCode VMManager::ReprotectRange(VAddr target, u64 size, VMAPermission new_p
 }
 
 void VMManager::RefreshMemoryBlockMappings(const std::vector<u8>* block) {
+    // The vector may have been reallocated, so any cached pointer into it is stale now.
+    InvalidateLookupCache();
+
     // If this ever proves to have a noticeable performance impact, allow users of the function to
     // specify a specific range of addresses to limit the scan to.
     for (const auto& p : vma_map) {
@@ -259,6 +347,9 @@ ResultVal<VMManager::VMAIter> VMManager::CarveVMA(VAddr base, u64 size) {
         return ERR_INVALID_ADDRESS;
     }
 
+    // The carved VMA is about to be repurposed by the caller
+    InvalidateLookupCache();
+
     const VirtualMemoryArea& vma = vma_handle->second;
     if (vma.type != VMAType::Free) {
         // Region is already allocated
@@ -314,6 +405,8 @@ ResultVal<VMManager::VMAIter> VMManager::CarveVMARange(VAddr target, u64 size) {
 }
 
 VMManager::VMAIter VMManager::SplitVMA(VMAIter vma_handle, u64 offset_in_vma) {
+    InvalidateLookupCache();
+
     VirtualMemoryArea& old_vma = vma_handle->second;
     VirtualMemoryArea new_vma = old_vma; // Make a copy of the VMA
 
@@ -346,6 +439,8 @@ VMManager::VMAIter VMManager::SplitVMA(VMAIter vma_handle, u64 offset_in_vma) {
 }
 
 VMManager::VMAIter VMManager::MergeAdjacent(VMAIter iter) {
+    InvalidateLookupCache();
+
     const VMAIter next_vma = std::next(iter);
     if (next_vma != vma_map.end() && iter->second.CanBeMergedWith(next_vma->second)) {
         iter->second.size += next_vma->second.size;
@@ -392,6 +487,19 @@ u64 VMManager::GetTotalHeapUsage() const {
     return 0x0;
 }
 
+u64 VMManager::GetBackingMemoryUsage() const {
+    // Blocks are shared between the areas split from them, and between processes
+    std::unordered_set<const std::vector<u8>*> blocks;
+    u64 usage = 0;
+    for (const auto& [base, vma] : vma_map) {
+        if (vma.type == VMAType::AllocatedMemoryBlock &&
+            blocks.insert(vma.backing_block.get()).second) {
+            usage += vma.backing_block->capacity();
+        }
+    }
+    return usage;
+}
+
 VAddr VMManager::GetAddressSpaceBaseAddr() const {
     LOG_WARNING(Kernel, "(STUBBED) called");
     return 0x8000000;
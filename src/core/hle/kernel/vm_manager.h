@@ -4,6 +4,8 @@
 
 #pragma once
 
+#include <array>
+#include <atomic>
 #include <map>
 #include <memory>
 #include <vector>
@@ -135,6 +137,27 @@ public:
     /// Finds the VMA in which the given address is included in, or `vma_map.end()`.
     VMAHandle FindVMA(VAddr target) const;
 
+    /**
+     * Gets a host pointer to the memory backing the given address. Lookups go through a small
+     * cache of recently used VMAs first, so repeated accesses to the same few regions don't have
+     * to walk `vma_map` every time.
+     *
+     * @param target The guest address to look up.
+     * @returns The host pointer, or nullptr if the address isn't backed by host memory.
+     */
+    u8* GetBackingPointer(VAddr target) const;
+
+    /**
+     * Gets a host pointer to a guest range, provided the whole range is backed by one contiguous
+     * host allocation. This allows callers to process a whole buffer with a single lookup.
+     *
+     * @param target The guest address the range starts at.
+     * @param size Size of the range in bytes.
+     * @returns The host pointer to the start of the range, or nullptr if the range is not entirely
+     *          backed by contiguous host memory.
+     */
+    u8* GetPointerRange(VAddr target, u64 size) const;
+
     // TODO(yuriks): Should these functions actually return the handle?
 
     /**
@@ -195,6 +218,9 @@ public:
     /// Gets the total heap usage, used by svcGetInfo
     u64 GetTotalHeapUsage() const;
 
+    /// Gets the host memory allocated for the blocks backing the mapped memory
+    u64 GetBackingMemoryUsage() const;
+
     /// Gets the total address space base address, used by svcGetInfo
     VAddr GetAddressSpaceBaseAddr() const;
 
@@ -208,6 +234,19 @@ public:
 private:
     using VMAIter = decltype(vma_map)::iterator;
 
+    /// A host-memory-backed VMA that was recently resolved by GetBackingPointer.
+    struct BackingLookupEntry {
+        VAddr base = 0;
+        u64 size = 0;
+        u8* backing = nullptr;
+    };
+
+    /// Resolves the host-memory-backed VMA containing the given address, consulting the cache.
+    const BackingLookupEntry* LookupBacking(VAddr target) const;
+
+    /// Drops all cached lookups. Must be called whenever a VMA is split, merged or modified.
+    void InvalidateLookupCache();
+
     /// Converts a VMAHandle to a mutable VMAIter.
     VMAIter StripIterConstness(const VMAHandle& iter);
 
@@ -240,5 +279,22 @@ private:
 
     /// Updates the pages corresponding to this VMA so they match the VMA's attributes.
     void UpdatePageTableForVMA(const VirtualMemoryArea& vma);
+
+    /// Number of entries in the backing pointer lookup cache.
+    static constexpr size_t LOOKUP_CACHE_SIZE = 4;
+
+    /// Recently looked up host-memory-backed VMAs of one VMManager, replaced in round-robin order.
+    struct BackingLookupCache {
+        const VMManager* owner = nullptr;
+        u64 generation = 0;
+        std::array<BackingLookupEntry, LOOKUP_CACHE_SIZE> entries{};
+        size_t next = 0;
+    };
+
+    /// Lookups happen on every emulated core, so each host thread keeps a cache of its own.
+    static thread_local BackingLookupCache lookup_cache;
+
+    /// Changed by every invalidation, a thread's cache is only used while its generation matches.
+    std::atomic<u64> lookup_generation{0};
 };
 } // namespace Kernel
@@ -12,26 +12,39 @@
 
 namespace Kernel {
 
-void WaitObject::AddWaitingThread(SharedPtr<Thread> thread) {
-    auto itr = std::find(waiting_threads.begin(), waiting_threads.end(), thread);
-    if (itr == waiting_threads.end())
-        waiting_threads.push_back(std::move(thread));
+void WaitObject::LinkWaiter(WaitListNode& waiter) {
+    waiter.prev = last_waiter;
+    waiter.next = nullptr;
+    if (last_waiter != nullptr) {
+        last_waiter->next = &waiter;
+    } else {
+        first_waiter = &waiter;
+    }
+    last_waiter = &waiter;
 }
 
-void WaitObject::RemoveWaitingThread(Thread* thread) {
-    auto itr = std::find(waiting_threads.begin(), waiting_threads.end(), thread);
-    // If a thread passed multiple handles to the same object,
-    // the kernel might attempt to remove the thread from the object's
-    // waiting threads list multiple times.
-    if (itr != waiting_threads.end())
-        waiting_threads.erase(itr);
+void WaitObject::UnlinkWaiter(WaitListNode& waiter) {
+    if (waiter.prev != nullptr) {
+        waiter.prev->next = waiter.next;
+    } else {
+        first_waiter = waiter.next;
+    }
+    if (waiter.next != nullptr) {
+        waiter.next->prev = waiter.prev;
+    } else {
+        last_waiter = waiter.prev;
+    }
+    waiter.prev = nullptr;
+    waiter.next = nullptr;
 }
 
-SharedPtr<Thread> WaitObject::GetHighestPriorityReadyThread() {
-    Thread* candidate = nullptr;
+WaitListNode* WaitObject::GetHighestPriorityReadyWaiter() {
+    WaitListNode* candidate = nullptr;
     u32 candidate_priority = THREADPRIO_LOWEST + 1;
 
-    for (const auto& thread : waiting_threads) {
+    for (WaitListNode* waiter = first_waiter; waiter != nullptr; waiter = waiter->next) {
+        Thread* const thread = waiter->thread;
+
         // The list of waiting threads must not contain threads that are not waiting to be awakened.
         ASSERT_MSG(thread->status == ThreadStatus::WaitSynchAny ||
                        thread->status == ThreadStatus::WaitSynchAll ||
@@ -41,7 +54,7 @@ SharedPtr<Thread> WaitObject::GetHighestPriorityReadyThread() {
         if (thread->current_priority >= candidate_priority)
             continue;
 
-        if (ShouldWait(thread.get()))
+        if (ShouldWait(thread))
             continue;
 
         // A thread is ready to run if it's either in ThreadStatus::WaitSynchAny or
@@ -49,13 +62,13 @@ SharedPtr<Thread> WaitObject::GetHighestPriorityReadyThread() {
         bool ready_to_run = true;
         if (thread->status == ThreadStatus::WaitSynchAll) {
             ready_to_run = std::none_of(thread->wait_objects.begin(), thread->wait_objects.end(),
-                                        [&thread](const SharedPtr<WaitObject>& object) {
-                                            return object->ShouldWait(thread.get());
+                                        [thread](const SharedPtr<WaitObject>& object) {
+                                            return object->ShouldWait(thread);
                                         });
         }
 
         if (ready_to_run) {
-            candidate = thread.get();
+            candidate = waiter;
             candidate_priority = thread->current_priority;
         }
     }
@@ -63,12 +76,12 @@ SharedPtr<Thread> WaitObject::GetHighestPriorityReadyThread() {
     return candidate;
 }
 
-void WaitObject::WakeupWaitingThread(SharedPtr<Thread> thread) {
+void WaitObject::WakeupWaitingThread(WaitListNode& waiter) {
+    // The entry is gone once the thread stops waiting
+    const SharedPtr<Thread> thread = waiter.thread;
+    const s32 index = waiter.index;
     ASSERT(!ShouldWait(thread.get()));
 
-    if (!thread)
-        return;
-
     if (!thread->IsSleepingOnWaitAll()) {
         Acquire(thread.get());
     } else {
@@ -78,11 +91,7 @@ void WaitObject::WakeupWaitingThread(SharedPtr<Thread> thread) {
         }
     }
 
-    size_t index = thread->GetWaitObjectIndex(this);
-
-    for (auto& object : thread->wait_objects)
-        object->RemoveWaitingThread(thread.get());
-    thread->wait_objects.clear();
+    thread->ClearWaitObjects();
 
     thread->CancelWakeupTimer();
 
@@ -96,13 +105,17 @@ void WaitObject::WakeupWaitingThread(SharedPtr<Thread> thread) {
 }
 
 void WaitObject::WakeupAllWaitingThreads() {
-    while (auto thread = GetHighestPriorityReadyThread()) {
-        WakeupWaitingThread(thread);
+    while (WaitListNode* waiter = GetHighestPriorityReadyWaiter()) {
+        WakeupWaitingThread(*waiter);
     }
 }
 
-const std::vector<SharedPtr<Thread>>& WaitObject::GetWaitingThreads() const {
-    return waiting_threads;
+std::vector<SharedPtr<Thread>> WaitObject::GetWaitingThreads() const {
+    std::vector<SharedPtr<Thread>> threads;
+    for (const WaitListNode* waiter = first_waiter; waiter != nullptr; waiter = waiter->next) {
+        threads.emplace_back(waiter->thread);
+    }
+    return threads;
 }
 
 } // namespace Kernel
@@ -12,6 +12,21 @@
 namespace Kernel {
 
 class Thread;
+class WaitObject;
+
+/**
+ * Entry of a thread in the waiter list of an object it waits on. The entries are owned by the
+ * thread and linked into the lists of the objects, so that adding and removing a waiter doesn't
+ * search or move the other waiters of the object.
+ */
+struct WaitListNode {
+    Thread* thread;
+    WaitObject* object;
+    /// Index of the object in the objects the thread waits on, the last one if it's repeated
+    s32 index;
+    WaitListNode* prev;
+    WaitListNode* next;
+};
 
 /// Class that represents a Kernel object that a thread can be waiting on
 class WaitObject : public Object {
@@ -27,16 +42,21 @@ public:
     virtual void Acquire(Thread* thread) = 0;
 
     /**
-     * Add a thread to wait on this object
-     * @param thread Pointer to thread to add
+     * Adds a thread to the waiters of this object, see Thread::SetWaitObjects
+     * @param waiter Entry of the thread, which must stay in place until it's unlinked
      */
-    virtual void AddWaitingThread(SharedPtr<Thread> thread);
+    void LinkWaiter(WaitListNode& waiter);
 
     /**
-     * Removes a thread from waiting on this object (e.g. if it was resumed already)
-     * @param thread Pointer to thread to remove
+     * Removes a thread from the waiters of this object (e.g. if it was resumed already)
+     * @param waiter Entry of the thread, linked by LinkWaiter
      */
-    virtual void RemoveWaitingThread(Thread* thread);
+    void UnlinkWaiter(WaitListNode& waiter);
+
+    /// Returns whether the waiter linked last is an entry of the given thread
+    bool IsLastWaiter(const Thread* thread) const {
+        return last_waiter != nullptr && last_waiter->thread == thread;
+    }
 
     /**
      * Wake up all threads waiting on this object that can be awoken, in priority order,
@@ -46,19 +66,21 @@ public:
 
     /**
      * Wakes up a single thread waiting on this object.
-     * @param thread Thread that is waiting on this object to wakeup.
+     * @param waiter Entry of the thread that is waiting on this object to wakeup.
      */
-    void WakeupWaitingThread(SharedPtr<Thread> thread);
+    void WakeupWaitingThread(WaitListNode& waiter);
 
-    /// Obtains the highest priority thread that is ready to run from this object's waiting list.
-    SharedPtr<Thread> GetHighestPriorityReadyThread();
+    /// Obtains the entry of the highest priority thread that is ready to run from this object's
+    /// waiter list, or nullptr if none is.
+    WaitListNode* GetHighestPriorityReadyWaiter();
 
-    /// Get a const reference to the waiting threads list for debug use
-    const std::vector<SharedPtr<Thread>>& GetWaitingThreads() const;
+    /// Get the waiting threads for debug use
+    std::vector<SharedPtr<Thread>> GetWaitingThreads() const;
 
 private:
-    /// Threads waiting for this object to become available
-    std::vector<SharedPtr<Thread>> waiting_threads;
+    /// Threads waiting for this object to become available, in the order they started waiting
+    WaitListNode* first_waiter = nullptr;
+    WaitListNode* last_waiter = nullptr;
 };
 
 // Specialization of DynamicObjectCast for WaitObjects
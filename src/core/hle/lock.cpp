@@ -2,8 +2,31 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
-#include <core/hle/lock.h>
+#include "common/microprofile.h"
+#include "core/core.h"
+#include "core/hle/lock.h"
 
 namespace HLE {
-std::recursive_mutex g_hle_lock;
+
+MICROPROFILE_DEFINE(HLE_LockWait, "HLE", "Lock Wait", MP_RGB(255, 64, 64));
+MICROPROFILE_DEFINE(HLE_LockHeld, "HLE", "Lock Held", MP_RGB(255, 160, 64));
+
+LockGuard::LockGuard() : mutex{Core::System::GetInstance().HLELock()} {
+    {
+        MICROPROFILE_SCOPE(HLE_LockWait);
+        mutex.lock();
+    }
+#if MICROPROFILE_ENABLED
+    hold_start_tick = MicroProfileEnter(g_mp_HLE_LockHeld);
+#else
+    hold_start_tick = 0;
+#endif
+}
+
+LockGuard::~LockGuard() {
+#if MICROPROFILE_ENABLED
+    MicroProfileLeave(g_mp_HLE_LockHeld, hold_start_tick);
+#endif
+    mutex.unlock();
 }
+} // namespace HLE
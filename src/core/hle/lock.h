@@ -5,14 +5,31 @@
 #pragma once
 
 #include <mutex>
+#include "common/common_types.h"
 
 namespace HLE {
-/*
- * Synchronizes access to the internal HLE kernel structures, it is acquired when a guest
+/**
+ * Scoped guard for the HLE lock of the system run by the calling thread, see System::HLELock.
+ *
+ * The lock synchronizes access to the internal HLE kernel structures, it is acquired when a guest
  * application thread performs a syscall. It should be acquired by any host threads that read or
  * modify the HLE kernel state. Note: Any operation that directly or indirectly reads from or writes
  * to the emulated memory is not protected by this mutex, and should be avoided in any threads other
  * than the CPU thread.
+ *
+ * Besides locking, it reports the time spent waiting for the lock and the time it was held to
+ * microprofile, which makes contention between the cores visible.
  */
-extern std::recursive_mutex g_hle_lock;
+class LockGuard final {
+public:
+    LockGuard();
+    ~LockGuard();
+
+    LockGuard(const LockGuard&) = delete;
+    LockGuard& operator=(const LockGuard&) = delete;
+
+private:
+    std::recursive_mutex& mutex;
+    u64 hold_start_tick;
+};
 } // namespace HLE
@@ -5,6 +5,8 @@
 #pragma once
 
 #include <memory>
+#include <queue>
+#include "core/hle/kernel/kernel.h"
 #include "core/hle/service/service.h"
 
 namespace Kernel {
@@ -39,6 +41,34 @@ enum SystemLanguage {
     TraditionalChinese = 16,
 };
 
+/**
+ * Messages the system sends the running applet, which it reads from ICommonStateGetter. The
+ * receive event stays signalled exactly as long as messages are pending, so guests waiting on it
+ * only call ReceiveMessage when there is something to read.
+ */
+class AppletMessageQueue {
+public:
+    enum class AppletMessage : u32 {
+        NoMessage = 0,
+        FocusStateChanged = 15,
+        OperationModeChanged = 30,
+        PerformanceModeChanged = 31,
+    };
+
+    AppletMessageQueue();
+    ~AppletMessageQueue();
+
+    const Kernel::SharedPtr<Kernel::Event>& GetMessageReceiveEvent() const;
+    void PushMessage(AppletMessage msg);
+    /// Returns the oldest pending message, or NoMessage if there is none
+    AppletMessage PopMessage();
+    bool IsEmpty() const;
+
+private:
+    std::queue<AppletMessage> messages;
+    Kernel::SharedPtr<Kernel::Event> on_new_message;
+};
+
 class IWindowController final : public ServiceFramework<IWindowController> {
 public:
     IWindowController();
@@ -97,7 +127,7 @@ private:
 
 class ICommonStateGetter final : public ServiceFramework<ICommonStateGetter> {
 public:
-    ICommonStateGetter();
+    explicit ICommonStateGetter(std::shared_ptr<AppletMessageQueue> msg_queue);
 
 private:
     enum class FocusState : u8 {
@@ -118,7 +148,8 @@ private:
     void GetPerformanceMode(Kernel::HLERequestContext& ctx);
     void GetBootMode(Kernel::HLERequestContext& ctx);
 
-    Kernel::SharedPtr<Kernel::Event> event;
+    std::shared_ptr<AppletMessageQueue> msg_queue;
+    Kernel::SharedPtr<Kernel::Event> display_resolution_change_event;
 };
 
 class ILibraryAppletCreator final : public ServiceFramework<ILibraryAppletCreator> {
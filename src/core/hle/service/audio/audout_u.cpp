@@ -113,14 +113,19 @@ private:
         std::memcpy(&audio_buffer, input_buffer.data(), sizeof(AudioBuffer));
         const u64 tag{rp.Pop<u64>()};
 
-        std::vector<s16> samples(audio_buffer.buffer_size / sizeof(s16));
-        Memory::ReadBlock(audio_buffer.buffer, samples.data(), audio_buffer.buffer_size);
-
-        if (!audio_core.QueueBuffer(stream, tag, std::move(samples))) {
+        // Read straight into a pooled buffer, its storage is reused from earlier appends
+        AudioCore::BufferPtr buffer{audio_core.AcquireBuffer(stream, tag)};
+        if (!buffer) {
             IPC::ResponseBuilder rb{ctx, 2};
             rb.Push(ResultCode(ErrorModule::Audio, ErrCodes::BufferCountExceeded));
+            return;
         }
 
+        auto& samples{buffer->Samples()};
+        samples.resize(audio_buffer.buffer_size / sizeof(s16));
+        Memory::ReadBlock(audio_buffer.buffer, samples.data(), samples.size() * sizeof(s16));
+        audio_core.QueueBuffer(stream, std::move(buffer));
+
         IPC::ResponseBuilder rb{ctx, 2};
         rb.Push(RESULT_SUCCESS);
     }
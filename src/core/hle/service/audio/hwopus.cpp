@@ -2,31 +2,153 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <array>
 #include <cstring>
+#include <memory>
+#include <mutex>
+#include <vector>
 #include <opus.h>
+#include <opus_multistream.h>
 #include "common/logging/log.h"
 #include "core/hle/ipc_helpers.h"
+#include "core/hle/kernel/event.h"
 #include "core/hle/kernel/hle_ipc.h"
+#include "core/hle/kernel/thread.h"
 #include "core/hle/service/audio/hwopus.h"
 
 namespace Service::Audio {
 
+namespace ErrCodes {
+enum {
+    OpusBadArg = 2,
+    BufferTooSmall = 3,
+    OpusInternalError = 4,
+    OpusUnimplemented = 5,
+    OpusInvalidState = 6,
+    OpusAllocFail = 7,
+    InputDataTooSmall = 8,
+    OpusInvalidPacket = 17,
+};
+}
+
+/// Converts an error returned by libopus to the result hwopus reports for it
+static ResultCode ResultFromOpusError(int error) {
+    switch (error) {
+    case OPUS_BAD_ARG:
+        return ResultCode(ErrorModule::Hwopus, ErrCodes::OpusBadArg);
+    case OPUS_BUFFER_TOO_SMALL:
+        return ResultCode(ErrorModule::Hwopus, ErrCodes::BufferTooSmall);
+    case OPUS_INVALID_PACKET:
+        return ResultCode(ErrorModule::Hwopus, ErrCodes::OpusInvalidPacket);
+    case OPUS_UNIMPLEMENTED:
+        return ResultCode(ErrorModule::Hwopus, ErrCodes::OpusUnimplemented);
+    case OPUS_INVALID_STATE:
+        return ResultCode(ErrorModule::Hwopus, ErrCodes::OpusInvalidState);
+    case OPUS_ALLOC_FAIL:
+        return ResultCode(ErrorModule::Hwopus, ErrCodes::OpusAllocFail);
+    default:
+        return ResultCode(ErrorModule::Hwopus, ErrCodes::OpusInternalError);
+    }
+}
+
+/// Packets decoding to at least this many samples (over all channels) are decoded on the HLE
+/// worker pool, so that long multi-frame packets don't stall the calling core.
+constexpr size_t ASYNC_DECODE_THRESHOLD = 960 * 2 * 2;
+
 struct OpusDeleter {
     void operator()(void* ptr) const {
         operator delete(ptr);
     }
 };
 
+struct OpusPacketHeader {
+    u32_be sz; // Needs to be BE for some odd reason
+    INSERT_PADDING_WORDS(1);
+};
+static_assert(sizeof(OpusPacketHeader) == 0x8, "OpusPacketHeader is an invalid size");
+
+struct OpusMultiStreamParameters {
+    u32 sample_rate;
+    u32 channel_count;
+    u32 number_streams;
+    u32 number_stereo_streams;
+    std::array<u8, 0x100> channel_mappings;
+};
+static_assert(sizeof(OpusMultiStreamParameters) == 0x110,
+              "OpusMultiStreamParameters is an invalid size");
+
+/**
+ * libopus decoder state shared between a decoder session and any decode still in flight on the
+ * HLE worker pool. Holds either a single stream or a multistream decoder.
+ */
+class OpusDecoderState final {
+public:
+    OpusDecoderState(std::unique_ptr<OpusDecoder, OpusDeleter> decoder, u32 sample_rate,
+                     u32 channel_count)
+        : decoder(std::move(decoder)), sample_rate(sample_rate), channel_count(channel_count) {}
+
+    OpusDecoderState(std::unique_ptr<OpusMSDecoder, OpusDeleter> ms_decoder, u32 sample_rate,
+                     u32 channel_count)
+        : ms_decoder(std::move(ms_decoder)), sample_rate(sample_rate),
+          channel_count(channel_count) {}
+
+    bool IsMultiStream() const {
+        return ms_decoder != nullptr;
+    }
+
+    u32 GetChannelCount() const {
+        return channel_count;
+    }
+
+    /**
+     * Returns the number of samples per channel the packet decodes to, or 0 if unknown. Only
+     * single stream packets can be inspected without decoding them.
+     */
+    size_t GetPacketSampleCount(const u8* packet, u32 size) const {
+        if (IsMultiStream()) {
+            return 0;
+        }
+        const int count = opus_packet_get_nb_samples(packet, static_cast<opus_int32>(size),
+                                                     static_cast<opus_int32>(sample_rate));
+        return count > 0 ? static_cast<size_t>(count) : 0;
+    }
+
+    /**
+     * Decodes every frame of an Opus packet in a single libopus call. May be called from a host
+     * worker thread.
+     * @param output Interleaved output, its size bounds the number of decoded samples.
+     * @returns The number of samples decoded per channel, or a negative libopus error code.
+     */
+    int Decode(const u8* packet, u32 size, std::vector<opus_int16>& output) {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        const int frame_size = static_cast<int>(output.size() / channel_count);
+        if (IsMultiStream()) {
+            return opus_multistream_decode(ms_decoder.get(), packet, static_cast<opus_int32>(size),
+                                           output.data(), frame_size, 0);
+        }
+        return opus_decode(decoder.get(), packet, static_cast<opus_int32>(size), output.data(),
+                           frame_size, 0);
+    }
+
+private:
+    /// Serializes decodes, as guest threads sharing a session may have several in flight
+    std::mutex mutex;
+    std::unique_ptr<OpusDecoder, OpusDeleter> decoder;
+    std::unique_ptr<OpusMSDecoder, OpusDeleter> ms_decoder;
+    u32 sample_rate;
+    u32 channel_count;
+};
+
 class IHardwareOpusDecoderManager final : public ServiceFramework<IHardwareOpusDecoderManager> {
 public:
-    IHardwareOpusDecoderManager(std::unique_ptr<OpusDecoder, OpusDeleter> decoder, u32 sample_rate,
-                                u32 channel_count)
-        : ServiceFramework("IHardwareOpusDecoderManager"), decoder(std::move(decoder)),
-          sample_rate(sample_rate), channel_count(channel_count) {
+    explicit IHardwareOpusDecoderManager(std::shared_ptr<OpusDecoderState> state)
+        : ServiceFramework("IHardwareOpusDecoderManager"), state(std::move(state)) {
         static const FunctionInfo functions[] = {
             {0, &IHardwareOpusDecoderManager::DecodeInterleaved, "DecodeInterleaved"},
             {1, nullptr, "SetContext"},
-            {2, nullptr, "DecodeInterleavedForMultiStream"},
+            {2, &IHardwareOpusDecoderManager::DecodeInterleavedForMultiStream,
+             "DecodeInterleavedForMultiStream"},
             {3, nullptr, "SetContextForMultiStream"},
             {4, nullptr, "Unknown4"},
             {5, nullptr, "Unknown5"},
@@ -38,71 +160,138 @@ public:
 
 private:
     void DecodeInterleaved(Kernel::HLERequestContext& ctx) {
-        u32 consumed = 0;
-        u32 sample_count = 0;
-        std::vector<opus_int16> samples(ctx.GetWriteBufferSize() / sizeof(opus_int16));
-        if (!Decoder_DecodeInterleaved(consumed, sample_count, ctx.ReadBuffer(), samples)) {
+        LOG_TRACE(Audio, "called");
+        ASSERT_MSG(!state->IsMultiStream(), "Multistream decoder used as a single stream");
+        DecodeInterleavedImpl(ctx);
+    }
+
+    void DecodeInterleavedForMultiStream(Kernel::HLERequestContext& ctx) {
+        LOG_TRACE(Audio, "called");
+        ASSERT_MSG(state->IsMultiStream(), "Single stream decoder used as a multistream");
+        DecodeInterleavedImpl(ctx);
+    }
+
+    void DecodeInterleavedImpl(Kernel::HLERequestContext& ctx) {
+        struct DecodeResult {
+            std::vector<u8> input;
+            std::vector<opus_int16> samples;
+            u32 consumed = 0;
+            u32 sample_count = 0;
+            ResultCode code = RESULT_SUCCESS;
+        };
+        auto result = std::make_shared<DecodeResult>();
+        result->input = ctx.ReadBuffer();
+        result->samples.resize(ctx.GetWriteBufferSize() / sizeof(opus_int16));
+
+        const u8* packet = nullptr;
+        u32 packet_size = 0;
+        if (!GetPacket(result->input, packet, packet_size)) {
+            IPC::ResponseBuilder rb{ctx, 2};
+            rb.Push(ResultCode(ErrorModule::Hwopus, ErrCodes::InputDataTooSmall));
+            return;
+        }
+
+        const size_t packet_samples = state->GetPacketSampleCount(packet, packet_size);
+        if (packet_samples * state->GetChannelCount() > result->samples.size()) {
             IPC::ResponseBuilder rb{ctx, 2};
-            // TODO(ogniK): Use correct error code
-            rb.Push(ResultCode(-1));
+            rb.Push(ResultCode(ErrorModule::Hwopus, ErrCodes::BufferTooSmall));
             return;
         }
-        IPC::ResponseBuilder rb{ctx, 4};
-        rb.Push(RESULT_SUCCESS);
-        rb.Push<u32>(consumed);
-        rb.Push<u32>(sample_count);
-        ctx.WriteBuffer(samples.data(), samples.size() * sizeof(s16));
+
+        auto work = [state = state, result, packet, packet_size] {
+            const int decoded = state->Decode(packet, packet_size, result->samples);
+            if (decoded < 0) {
+                LOG_ERROR(Audio, "Failed to decode packet: {}", opus_strerror(decoded));
+                result->code = ResultFromOpusError(decoded);
+                return;
+            }
+            result->consumed = static_cast<u32>(sizeof(OpusPacketHeader) + packet_size);
+            result->sample_count = static_cast<u32>(decoded);
+        };
+
+        auto write_response = [result](Kernel::HLERequestContext& ctx) {
+            if (result->code.IsError()) {
+                IPC::ResponseBuilder rb{ctx, 2};
+                rb.Push(result->code);
+                return;
+            }
+            IPC::ResponseBuilder rb{ctx, 4};
+            rb.Push(RESULT_SUCCESS);
+            rb.Push<u32>(result->consumed);
+            rb.Push<u32>(result->sample_count);
+            ctx.WriteBuffer(result->samples.data(), result->samples.size() * sizeof(s16));
+        };
+
+        // Multistream packets can't be sized up front, and are the costly ones to decode anyway
+        const bool run_async = state->IsMultiStream() ||
+                               packet_samples * state->GetChannelCount() >= ASYNC_DECODE_THRESHOLD;
+        if (!run_async) {
+            work();
+            write_response(ctx);
+            return;
+        }
+
+        // The packet pointer stays valid as the input vector is owned by the shared result
+        ctx.RunAsync(Kernel::GetCurrentThread(), "IHardwareOpusDecoderManager::DecodeInterleaved",
+                     std::move(work),
+                     [write_response](Kernel::SharedPtr<Kernel::Thread> thread,
+                                      Kernel::HLERequestContext& ctx,
+                                      ThreadWakeupReason reason) { write_response(ctx); });
     }
 
-    bool Decoder_DecodeInterleaved(u32& consumed, u32& sample_count, const std::vector<u8>& input,
-                                   std::vector<opus_int16>& output) {
-        size_t raw_output_sz = output.size() * sizeof(opus_int16);
-        if (sizeof(OpusHeader) > input.size())
-            return false;
-        OpusHeader hdr{};
-        std::memcpy(&hdr, input.data(), sizeof(OpusHeader));
-        if (sizeof(OpusHeader) + static_cast<u32>(hdr.sz) > input.size()) {
+    /// Locates the Opus packet following the header at the start of the input buffer
+    static bool GetPacket(const std::vector<u8>& input, const u8*& packet, u32& packet_size) {
+        if (sizeof(OpusPacketHeader) > input.size()) {
             return false;
         }
-        auto frame = input.data() + sizeof(OpusHeader);
-        auto decoded_sample_count = opus_packet_get_nb_samples(
-            frame, static_cast<opus_int32>(input.size() - sizeof(OpusHeader)),
-            static_cast<opus_int32>(sample_rate));
-        if (decoded_sample_count * channel_count * sizeof(u16) > raw_output_sz)
-            return false;
-        auto out_sample_count =
-            opus_decode(decoder.get(), frame, hdr.sz, output.data(),
-                        (static_cast<int>(raw_output_sz / sizeof(s16) / channel_count)), 0);
-        if (out_sample_count < 0)
+        OpusPacketHeader hdr{};
+        std::memcpy(&hdr, input.data(), sizeof(OpusPacketHeader));
+        if (sizeof(OpusPacketHeader) + static_cast<u32>(hdr.sz) > input.size()) {
             return false;
-        sample_count = out_sample_count;
-        consumed = static_cast<u32>(sizeof(OpusHeader) + hdr.sz);
+        }
+        packet = input.data() + sizeof(OpusPacketHeader);
+        packet_size = hdr.sz;
         return true;
     }
 
-    struct OpusHeader {
-        u32_be sz; // Needs to be BE for some odd reason
-        INSERT_PADDING_WORDS(1);
-    };
-    static_assert(sizeof(OpusHeader) == 0x8, "OpusHeader is an invalid size");
-
-    std::unique_ptr<OpusDecoder, OpusDeleter> decoder;
-    u32 sample_rate;
-    u32 channel_count;
+    std::shared_ptr<OpusDecoderState> state;
 };
 
+static bool IsValidSampleRate(u32 sample_rate) {
+    return sample_rate == 48000 || sample_rate == 24000 || sample_rate == 16000 ||
+           sample_rate == 12000 || sample_rate == 8000;
+}
+
 static size_t WorkerBufferSize(u32 channel_count) {
     ASSERT_MSG(channel_count == 1 || channel_count == 2, "Invalid channel count");
     return opus_decoder_get_size(static_cast<int>(channel_count));
 }
 
+static size_t WorkerBufferSizeForMultiStream(const OpusMultiStreamParameters& params) {
+    ASSERT_MSG(params.number_streams > 0 && params.number_streams <= 255, "Invalid stream count");
+    ASSERT_MSG(params.number_stereo_streams <= params.number_streams,
+               "Invalid stereo stream count");
+    return opus_multistream_decoder_get_size(static_cast<int>(params.number_streams),
+                                             static_cast<int>(params.number_stereo_streams));
+}
+
+static OpusMultiStreamParameters PopMultiStreamParameters(Kernel::HLERequestContext& ctx) {
+    OpusMultiStreamParameters params{};
+    const std::vector<u8> buffer = ctx.ReadBuffer();
+    ASSERT_MSG(buffer.size() >= sizeof(OpusMultiStreamParameters),
+               "Multistream parameters buffer too small");
+    std::memcpy(&params, buffer.data(), sizeof(OpusMultiStreamParameters));
+
+    ASSERT_MSG(IsValidSampleRate(params.sample_rate), "Invalid sample rate");
+    ASSERT_MSG(params.channel_count > 0 && params.channel_count <= 255, "Invalid channel count");
+    return params;
+}
+
 void HwOpus::GetWorkBufferSize(Kernel::HLERequestContext& ctx) {
     IPC::RequestParser rp{ctx};
     auto sample_rate = rp.Pop<u32>();
     auto channel_count = rp.Pop<u32>();
-    ASSERT_MSG(sample_rate == 48000 || sample_rate == 24000 || sample_rate == 16000 ||
-                   sample_rate == 12000 || sample_rate == 8000,
-               "Invalid sample rate");
+    ASSERT_MSG(IsValidSampleRate(sample_rate), "Invalid sample rate");
     ASSERT_MSG(channel_count == 1 || channel_count == 2, "Invalid channel count");
     u32 worker_buffer_sz = static_cast<u32>(WorkerBufferSize(channel_count));
     LOG_DEBUG(Audio, "called worker_buffer_sz={}", worker_buffer_sz);
@@ -112,6 +301,16 @@ void HwOpus::GetWorkBufferSize(Kernel::HLERequestContext& ctx) {
     rb.Push<u32>(worker_buffer_sz);
 }
 
+void HwOpus::GetWorkBufferSizeForMultiStream(Kernel::HLERequestContext& ctx) {
+    const OpusMultiStreamParameters params = PopMultiStreamParameters(ctx);
+    u32 worker_buffer_sz = static_cast<u32>(WorkerBufferSizeForMultiStream(params));
+    LOG_DEBUG(Audio, "called worker_buffer_sz={}", worker_buffer_sz);
+
+    IPC::ResponseBuilder rb{ctx, 3};
+    rb.Push(RESULT_SUCCESS);
+    rb.Push<u32>(worker_buffer_sz);
+}
+
 void HwOpus::OpenOpusDecoder(Kernel::HLERequestContext& ctx) {
     IPC::RequestParser rp{ctx};
     auto sample_rate = rp.Pop<u32>();
@@ -119,34 +318,61 @@ void HwOpus::OpenOpusDecoder(Kernel::HLERequestContext& ctx) {
     auto buffer_sz = rp.Pop<u32>();
     LOG_DEBUG(Audio, "called sample_rate={}, channel_count={}, buffer_size={}", sample_rate,
               channel_count, buffer_sz);
-    ASSERT_MSG(sample_rate == 48000 || sample_rate == 24000 || sample_rate == 16000 ||
-                   sample_rate == 12000 || sample_rate == 8000,
-               "Invalid sample rate");
+    ASSERT_MSG(IsValidSampleRate(sample_rate), "Invalid sample rate");
     ASSERT_MSG(channel_count == 1 || channel_count == 2, "Invalid channel count");
 
     size_t worker_sz = WorkerBufferSize(channel_count);
     ASSERT_MSG(buffer_sz < worker_sz, "Worker buffer too large");
     std::unique_ptr<OpusDecoder, OpusDeleter> decoder{
         static_cast<OpusDecoder*>(operator new(worker_sz))};
-    if (opus_decoder_init(decoder.get(), sample_rate, channel_count)) {
+    const int error = opus_decoder_init(decoder.get(), sample_rate, channel_count);
+    if (error != OPUS_OK) {
+        IPC::ResponseBuilder rb{ctx, 2};
+        rb.Push(ResultFromOpusError(error));
+        return;
+    }
+
+    IPC::ResponseBuilder rb{ctx, 2, 0, 1};
+    rb.Push(RESULT_SUCCESS);
+    rb.PushIpcInterface<IHardwareOpusDecoderManager>(
+        std::make_shared<OpusDecoderState>(std::move(decoder), sample_rate, channel_count));
+}
+
+void HwOpus::OpenOpusDecoderForMultiStream(Kernel::HLERequestContext& ctx) {
+    IPC::RequestParser rp{ctx};
+    auto buffer_sz = rp.Pop<u32>();
+    const OpusMultiStreamParameters params = PopMultiStreamParameters(ctx);
+    LOG_DEBUG(Audio,
+              "called sample_rate={}, channel_count={}, number_streams={}, "
+              "number_stereo_streams={}, buffer_size={}",
+              params.sample_rate, params.channel_count, params.number_streams,
+              params.number_stereo_streams, buffer_sz);
+
+    size_t worker_sz = WorkerBufferSizeForMultiStream(params);
+    std::unique_ptr<OpusMSDecoder, OpusDeleter> decoder{
+        static_cast<OpusMSDecoder*>(operator new(worker_sz))};
+    const int error = opus_multistream_decoder_init(
+        decoder.get(), params.sample_rate, static_cast<int>(params.channel_count),
+        static_cast<int>(params.number_streams), static_cast<int>(params.number_stereo_streams),
+        params.channel_mappings.data());
+    if (error != OPUS_OK) {
         IPC::ResponseBuilder rb{ctx, 2};
-        // TODO(ogniK): Use correct error code
-        rb.Push(ResultCode(-1));
+        rb.Push(ResultFromOpusError(error));
         return;
     }
 
     IPC::ResponseBuilder rb{ctx, 2, 0, 1};
     rb.Push(RESULT_SUCCESS);
-    rb.PushIpcInterface<IHardwareOpusDecoderManager>(std::move(decoder), sample_rate,
-                                                     channel_count);
+    rb.PushIpcInterface<IHardwareOpusDecoderManager>(std::make_shared<OpusDecoderState>(
+        std::move(decoder), params.sample_rate, params.channel_count));
 }
 
 HwOpus::HwOpus() : ServiceFramework("hwopus") {
     static const FunctionInfo functions[] = {
         {0, &HwOpus::OpenOpusDecoder, "OpenOpusDecoder"},
         {1, &HwOpus::GetWorkBufferSize, "GetWorkBufferSize"},
-        {2, nullptr, "OpenOpusDecoderForMultiStream"},
-        {3, nullptr, "GetWorkBufferSizeForMultiStream"},
+        {2, &HwOpus::OpenOpusDecoderForMultiStream, "OpenOpusDecoderForMultiStream"},
+        {3, &HwOpus::GetWorkBufferSizeForMultiStream, "GetWorkBufferSizeForMultiStream"},
     };
     RegisterHandlers(functions);
 }
@@ -39,13 +39,30 @@ static FileSys::VirtualDir GetDirectoryRelativeWrapped(FileSys::VirtualDir base,
 VfsDirectoryServiceWrapper::VfsDirectoryServiceWrapper(FileSys::VirtualDir backing_)
     : backing(std::move(backing_)) {}
 
+FileSys::VirtualDir VfsDirectoryServiceWrapper::GetDirectoryCached(std::string_view path) const {
+    std::string key(FileUtil::SanitizePath(path));
+    const auto iter = directory_cache.find(key);
+    if (iter != directory_cache.end())
+        return iter->second;
+
+    auto dir = GetDirectoryRelativeWrapped(backing, key);
+    if (dir != nullptr)
+        directory_cache.emplace(std::move(key), dir);
+    return dir;
+}
+
+void VfsDirectoryServiceWrapper::InvalidateCache() const {
+    directory_cache.clear();
+    file_cache.clear();
+}
+
 std::string VfsDirectoryServiceWrapper::GetName() const {
     return backing->GetName();
 }
 
 ResultCode VfsDirectoryServiceWrapper::CreateFile(const std::string& path_, u64 size) const {
     std::string path(FileUtil::SanitizePath(path_));
-    auto dir = GetDirectoryRelativeWrapped(backing, FileUtil::GetParentPath(path));
+    auto dir = GetDirectoryCached(FileUtil::GetParentPath(path));
     auto file = dir->CreateFile(FileUtil::GetFilename(path));
     if (file == nullptr) {
         // TODO(DarkLordZach): Find a better error code for this
@@ -60,7 +77,8 @@ ResultCode VfsDirectoryServiceWrapper::CreateFile(const std::string& path_, u64
 
 ResultCode VfsDirectoryServiceWrapper::DeleteFile(const std::string& path_) const {
     std::string path(FileUtil::SanitizePath(path_));
-    auto dir = GetDirectoryRelativeWrapped(backing, FileUtil::GetParentPath(path));
+    InvalidateCache();
+    auto dir = GetDirectoryCached(FileUtil::GetParentPath(path));
     if (path.empty()) {
         // TODO(DarkLordZach): Why do games call this and what should it do? Works as is but...
         return RESULT_SUCCESS;
@@ -76,7 +94,7 @@ ResultCode VfsDirectoryServiceWrapper::DeleteFile(const std::string& path_) cons
 
 ResultCode VfsDirectoryServiceWrapper::CreateDirectory(const std::string& path_) const {
     std::string path(FileUtil::SanitizePath(path_));
-    auto dir = GetDirectoryRelativeWrapped(backing, FileUtil::GetParentPath(path));
+    auto dir = GetDirectoryCached(FileUtil::GetParentPath(path));
     if (dir == nullptr && FileUtil::GetFilename(FileUtil::GetParentPath(path)).empty())
         dir = backing;
     auto new_dir = dir->CreateSubdirectory(FileUtil::GetFilename(path));
@@ -89,7 +107,8 @@ ResultCode VfsDirectoryServiceWrapper::CreateDirectory(const std::string& path_)
 
 ResultCode VfsDirectoryServiceWrapper::DeleteDirectory(const std::string& path_) const {
     std::string path(FileUtil::SanitizePath(path_));
-    auto dir = GetDirectoryRelativeWrapped(backing, FileUtil::GetParentPath(path));
+    InvalidateCache();
+    auto dir = GetDirectoryCached(FileUtil::GetParentPath(path));
     if (!dir->DeleteSubdirectory(FileUtil::GetFilename(path))) {
         // TODO(DarkLordZach): Find a better error code for this
         return ResultCode(-1);
@@ -99,7 +118,8 @@ ResultCode VfsDirectoryServiceWrapper::DeleteDirectory(const std::string& path_)
 
 ResultCode VfsDirectoryServiceWrapper::DeleteDirectoryRecursively(const std::string& path_) const {
     std::string path(FileUtil::SanitizePath(path_));
-    auto dir = GetDirectoryRelativeWrapped(backing, FileUtil::GetParentPath(path));
+    InvalidateCache();
+    auto dir = GetDirectoryCached(FileUtil::GetParentPath(path));
     if (!dir->DeleteSubdirectoryRecursive(FileUtil::GetFilename(path))) {
         // TODO(DarkLordZach): Find a better error code for this
         return ResultCode(-1);
@@ -111,6 +131,7 @@ ResultCode VfsDirectoryServiceWrapper::RenameFile(const std::string& src_path_,
                                                   const std::string& dest_path_) const {
     std::string src_path(FileUtil::SanitizePath(src_path_));
     std::string dest_path(FileUtil::SanitizePath(dest_path_));
+    InvalidateCache();
     auto src = backing->GetFileRelative(src_path);
     if (FileUtil::GetParentPath(src_path) == FileUtil::GetParentPath(dest_path)) {
         // Use more-optimized vfs implementation rename.
@@ -146,7 +167,8 @@ ResultCode VfsDirectoryServiceWrapper::RenameDirectory(const std::string& src_pa
                                                        const std::string& dest_path_) const {
     std::string src_path(FileUtil::SanitizePath(src_path_));
     std::string dest_path(FileUtil::SanitizePath(dest_path_));
-    auto src = GetDirectoryRelativeWrapped(backing, src_path);
+    InvalidateCache();
+    auto src = GetDirectoryCached(src_path);
     if (FileUtil::GetParentPath(src_path) == FileUtil::GetParentPath(dest_path)) {
         // Use more-optimized vfs implementation rename.
         if (src == nullptr)
@@ -174,9 +196,22 @@ ResultVal<FileSys::VirtualFile> VfsDirectoryServiceWrapper::OpenFile(const std::
     auto npath = path;
     while (npath.size() > 0 && (npath[0] == '/' || npath[0] == '\\'))
         npath = npath.substr(1);
-    auto file = backing->GetFileRelative(npath);
-    if (file == nullptr)
+
+    auto file = file_cache[npath].lock();
+    if (file == nullptr) {
+        // Only the file itself needs to be looked up when its directory has been before
+        const auto separator = npath.find_last_of("\\/");
+        if (separator == std::string::npos) {
+            file = backing->GetFileRelative(npath);
+        } else if (const auto dir = GetDirectoryCached(npath.substr(0, separator))) {
+            file = dir->GetFile(npath.substr(separator + 1));
+        }
+    }
+    if (file == nullptr) {
+        file_cache.erase(npath);
         return FileSys::ERROR_PATH_NOT_FOUND;
+    }
+    file_cache[npath] = file;
 
     if (mode == FileSys::Mode::Append) {
         return MakeResult<FileSys::VirtualFile>(
@@ -188,7 +223,7 @@ ResultVal<FileSys::VirtualFile> VfsDirectoryServiceWrapper::OpenFile(const std::
 
 ResultVal<FileSys::VirtualDir> VfsDirectoryServiceWrapper::OpenDirectory(const std::string& path_) {
     std::string path(FileUtil::SanitizePath(path_));
-    auto dir = GetDirectoryRelativeWrapped(backing, path);
+    auto dir = GetDirectoryCached(path);
     if (dir == nullptr) {
         // TODO(DarkLordZach): Find a better error code for this
         return ResultCode(-1);
@@ -206,7 +241,7 @@ u64 VfsDirectoryServiceWrapper::GetFreeSpaceSize() const {
 ResultVal<FileSys::EntryType> VfsDirectoryServiceWrapper::GetEntryType(
     const std::string& path_) const {
     std::string path(FileUtil::SanitizePath(path_));
-    auto dir = GetDirectoryRelativeWrapped(backing, FileUtil::GetParentPath(path));
+    auto dir = GetDirectoryCached(FileUtil::GetParentPath(path));
     if (dir == nullptr)
         return FileSys::ERROR_PATH_NOT_FOUND;
     auto filename = FileUtil::GetFilename(path);
@@ -5,6 +5,9 @@
 #pragma once
 
 #include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
 #include "common/common_types.h"
 #include "core/file_sys/directory.h"
 #include "core/hle/result.h"
@@ -146,7 +149,21 @@ public:
     ResultVal<FileSys::EntryType> GetEntryType(const std::string& path) const;
 
 private:
+    /// Resolves a directory by path, reusing the result of earlier lookups of the same path
+    FileSys::VirtualDir GetDirectoryCached(std::string_view path) const;
+
+    /**
+     * Forgets every path resolved so far. Called whenever entries are deleted or renamed through
+     * the wrapper, creating entries can't make the cache stale as failed lookups aren't cached.
+     */
+    void InvalidateCache() const;
+
     FileSys::VirtualDir backing;
+
+    /// Directories looked up by path. Directory objects are cheap, they are kept alive.
+    mutable std::unordered_map<std::string, FileSys::VirtualDir> directory_cache;
+    /// Files looked up by path, reused as long as the guest still has them open
+    mutable std::unordered_map<std::string, std::weak_ptr<FileSys::VfsFile>> file_cache;
 };
 
 } // namespace FileSystem
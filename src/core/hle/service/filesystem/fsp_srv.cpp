@@ -5,6 +5,9 @@
 #include <cinttypes>
 #include <cstring>
 #include <iterator>
+#include <map>
+#include <memory>
+#include <mutex>
 #include <string>
 #include <utility>
 #include <vector>
@@ -19,17 +22,67 @@
 #include "core/file_sys/nca_metadata.h"
 #include "core/file_sys/savedata_factory.h"
 #include "core/file_sys/vfs.h"
+#include "core/file_sys/vfs_readahead.h"
+#include "core/file_sys/vfs_writeback.h"
 #include "core/hle/ipc_helpers.h"
+#include "core/hle/kernel/event.h"
 #include "core/hle/kernel/process.h"
 #include "core/hle/service/filesystem/filesystem.h"
 #include "core/hle/service/filesystem/fsp_srv.h"
 
 namespace Service::FileSystem {
 
+/**
+ * Reads from a file into the output buffer of a request. If the output buffer is contiguous in
+ * host memory the file is read straight into it, otherwise the data is staged in a temporary
+ * buffer first.
+ *
+ * @returns The number of bytes read from the file.
+ */
+static size_t ReadIntoBuffer(Kernel::HLERequestContext& ctx, const FileSys::VfsFile& file,
+                             size_t length, size_t offset) {
+    u8* const buffer = ctx.GetWriteBufferPointer();
+    if (buffer != nullptr && length <= ctx.GetWriteBufferSize()) {
+        return file.Read(buffer, length, offset);
+    }
+
+    const std::vector<u8> output = file.ReadBytes(length, offset);
+    ctx.WriteBuffer(output);
+    return output.size();
+}
+
+/// Reads at least this large are serviced on the HLE worker pool instead of the CPU thread
+constexpr size_t ASYNC_READ_THRESHOLD = 0x100000;
+
+/**
+ * Returns the mutex serializing the reads of a file. Games open the same file (e.g. the RomFS)
+ * through several IStorages, whose reads may run on the CPU thread and on HLE workers at once, so
+ * the mutex is shared by every IStorage of the file and lives as long as one of them does.
+ */
+static std::shared_ptr<std::mutex> GetReadMutex(const FileSys::VirtualFile& file) {
+    static std::mutex registry_mutex;
+    static std::map<const FileSys::VfsFile*, std::weak_ptr<std::mutex>> read_mutexes;
+
+    std::lock_guard<std::mutex> lock(registry_mutex);
+    std::weak_ptr<std::mutex>& entry = read_mutexes[file.get()];
+    std::shared_ptr<std::mutex> read_mutex = entry.lock();
+    if (read_mutex == nullptr) {
+        read_mutex = std::make_shared<std::mutex>();
+        entry = read_mutex;
+
+        // Drop the entries of files no IStorage reads anymore
+        for (auto it = read_mutexes.begin(); it != read_mutexes.end();) {
+            it = it->second.expired() ? read_mutexes.erase(it) : std::next(it);
+        }
+    }
+    return read_mutex;
+}
+
 class IStorage final : public ServiceFramework<IStorage> {
 public:
     explicit IStorage(FileSys::VirtualFile backend_)
-        : ServiceFramework("IStorage"), backend(std::move(backend_)) {
+        : ServiceFramework("IStorage"), backend_mutex(GetReadMutex(backend_)),
+          backend(FileSys::CreateReadAhead(std::move(backend_))) {
         static const FunctionInfo functions[] = {
             {0, &IStorage::Read, "Read"}, {1, nullptr, "Write"},   {2, nullptr, "Flush"},
             {3, nullptr, "SetSize"},      {4, nullptr, "GetSize"}, {5, nullptr, "OperateRange"},
@@ -38,6 +91,8 @@ public:
     }
 
 private:
+    /// Serializes the reads of the backend, see GetReadMutex
+    std::shared_ptr<std::mutex> backend_mutex;
     FileSys::VirtualFile backend;
 
     void Read(Kernel::HLERequestContext& ctx) {
@@ -59,10 +114,31 @@ private:
             return;
         }
 
-        // Read the data from the Storage backend
-        std::vector<u8> output = backend->ReadBytes(length, offset);
-        // Write the data to memory
-        ctx.WriteBuffer(output);
+        if (static_cast<size_t>(length) >= ASYNC_READ_THRESHOLD) {
+            // Large reads are done on a host worker, letting the core run other guest threads
+            auto data = std::make_shared<std::vector<u8>>();
+            ctx.RunAsync(Kernel::GetCurrentThread(), "IStorage::Read",
+                         [backend = backend, backend_mutex = backend_mutex, data, length,
+                          offset] {
+                             std::lock_guard<std::mutex> lock(*backend_mutex);
+                             *data = backend->ReadBytes(static_cast<size_t>(length),
+                                                        static_cast<size_t>(offset));
+                         },
+                         [data](Kernel::SharedPtr<Kernel::Thread> thread,
+                                Kernel::HLERequestContext& ctx, ThreadWakeupReason reason) {
+                             ctx.WriteBuffer(*data);
+                             IPC::ResponseBuilder rb{ctx, 2};
+                             rb.Push(RESULT_SUCCESS);
+                         });
+            return;
+        }
+
+        // Read the data from the Storage backend, directly into guest memory when possible
+        {
+            std::lock_guard<std::mutex> lock(*backend_mutex);
+            ReadIntoBuffer(ctx, *backend, static_cast<size_t>(length),
+                           static_cast<size_t>(offset));
+        }
 
         IPC::ResponseBuilder rb{ctx, 2};
         rb.Push(RESULT_SUCCESS);
@@ -72,7 +148,7 @@ private:
 class IFile final : public ServiceFramework<IFile> {
 public:
     explicit IFile(FileSys::VirtualFile backend_)
-        : ServiceFramework("IFile"), backend(std::move(backend_)) {
+        : ServiceFramework("IFile"), backend(FileSys::CreateReadAhead(std::move(backend_))) {
         static const FunctionInfo functions[] = {
             {0, &IFile::Read, "Read"},       {1, &IFile::Write, "Write"},
             {2, &IFile::Flush, "Flush"},     {3, &IFile::SetSize, "SetSize"},
@@ -104,15 +180,13 @@ private:
             return;
         }
 
-        // Read the data from the Storage backend
-        std::vector<u8> output = backend->ReadBytes(length, offset);
-
-        // Write the data to memory
-        ctx.WriteBuffer(output);
+        // Read the data from the Storage backend, directly into guest memory when possible
+        const size_t read_size = ReadIntoBuffer(ctx, *backend, static_cast<size_t>(length),
+                                                static_cast<size_t>(offset));
 
         IPC::ResponseBuilder rb{ctx, 4};
         rb.Push(RESULT_SUCCESS);
-        rb.Push(static_cast<u64>(output.size()));
+        rb.Push(static_cast<u64>(read_size));
     }
 
     void Write(Kernel::HLERequestContext& ctx) {
@@ -135,16 +209,15 @@ private:
             return;
         }
 
-        const std::vector<u8> data = ctx.ReadBuffer();
+        const auto data = ctx.ReadBufferView();
 
         ASSERT_MSG(
             static_cast<s64>(data.size()) <= length,
             "Attempting to write more data than requested (requested={:016X}, actual={:016X}).",
             length, data.size());
 
-        // Write the data to the Storage backend
-        const auto write_size =
-            static_cast<std::size_t>(std::distance(data.begin(), data.begin() + length));
+        // Write the data to the Storage backend, straight from guest memory where possible
+        const auto write_size = static_cast<std::size_t>(length);
         const std::size_t written = backend->Write(data.data(), write_size, offset);
 
         ASSERT_MSG(static_cast<s64>(written) == length,
@@ -184,16 +257,6 @@ private:
     }
 };
 
-template <typename T>
-static void BuildEntryIndex(std::vector<FileSys::Entry>& entries, const std::vector<T>& new_data,
-                            FileSys::EntryType type) {
-    entries.reserve(entries.size() + new_data.size());
-
-    for (const auto& new_entry : new_data) {
-        entries.emplace_back(new_entry->GetName(), type, new_entry->GetSize());
-    }
-}
-
 class IDirectory final : public ServiceFramework<IDirectory> {
 public:
     explicit IDirectory(FileSys::VirtualDir backend_)
@@ -205,14 +268,27 @@ public:
         RegisterHandlers(functions);
 
         // TODO(DarkLordZach): Verify that this is the correct behavior.
-        // Build entry index now to save time later.
-        BuildEntryIndex(entries, backend->GetFiles(), FileSys::File);
-        BuildEntryIndex(entries, backend->GetSubdirectories(), FileSys::Directory);
+        // Build entry index now to save time later. Only names, types and sizes are kept, the
+        // entries guest reads are laid out in are only built for the ones it asks for.
+        backend->IterateEntries(
+            [this](std::string_view name, FileSys::VfsEntryType type, size_t size) {
+                const auto entry_type = type == FileSys::VfsEntryType::Directory
+                                            ? FileSys::Directory
+                                            : FileSys::File;
+                entries.push_back({std::string(name), entry_type, size});
+                return true;
+            });
     }
 
 private:
+    struct IndexEntry {
+        std::string name;
+        FileSys::EntryType type;
+        u64 size;
+    };
+
     FileSys::VirtualDir backend;
-    std::vector<FileSys::Entry> entries;
+    std::vector<IndexEntry> entries;
     u64 next_entry_index = 0;
 
     void Read(Kernel::HLERequestContext& ctx) {
@@ -227,15 +303,17 @@ private:
         // Cap at total number of entries.
         const u64 actual_entries = std::min(count_entries, entries.size() - next_entry_index);
 
-        // Determine data start and end
-        const auto* begin = reinterpret_cast<u8*>(entries.data() + next_entry_index);
-        const auto* end = reinterpret_cast<u8*>(entries.data() + next_entry_index + actual_entries);
-        const auto range_size = static_cast<std::size_t>(std::distance(begin, end));
+        std::vector<FileSys::Entry> output;
+        output.reserve(actual_entries);
+        for (u64 i = 0; i < actual_entries; ++i) {
+            const auto& entry = entries[next_entry_index + i];
+            output.emplace_back(entry.name, entry.type, entry.size);
+        }
 
         next_entry_index += actual_entries;
 
         // Write the data to memory
-        ctx.WriteBuffer(begin, range_size);
+        ctx.WriteBuffer(output);
 
         IPC::ResponseBuilder rb{ctx, 4};
         rb.Push(RESULT_SUCCESS);
@@ -256,7 +334,8 @@ private:
 class IFileSystem final : public ServiceFramework<IFileSystem> {
 public:
     explicit IFileSystem(FileSys::VirtualDir backend)
-        : ServiceFramework("IFileSystem"), backend(std::move(backend)) {
+        : ServiceFramework("IFileSystem"), backend(backend),
+          write_back(std::dynamic_pointer_cast<FileSys::WriteBackVfsDirectory>(backend)) {
         static const FunctionInfo functions[] = {
             {0, &IFileSystem::CreateFile, "CreateFile"},
             {1, &IFileSystem::DeleteFile, "DeleteFile"},
@@ -405,7 +484,12 @@ public:
     }
 
     void Commit(Kernel::HLERequestContext& ctx) {
-        LOG_WARNING(Service_FS, "(STUBBED) called");
+        LOG_DEBUG(Service_FS, "called");
+
+        // Only savedata is written back lazily, everything else is already on the host
+        if (write_back != nullptr) {
+            write_back->Commit();
+        }
 
         IPC::ResponseBuilder rb{ctx, 2};
         rb.Push(RESULT_SUCCESS);
@@ -413,6 +497,7 @@ public:
 
 private:
     VfsDirectoryServiceWrapper backend;
+    std::shared_ptr<FileSys::WriteBackVfsDirectory> write_back;
 };
 
 FSP_SRV::FSP_SRV() : ServiceFramework("fsp-srv") {
@@ -4,6 +4,7 @@
 
 #include <atomic>
 #include "common/logging/log.h"
+#include "core/core.h"
 #include "core/core_timing.h"
 #include "core/core_timing_util.h"
 #include "core/frontend/emu_window.h"
@@ -17,6 +18,7 @@
 #include "core/hle/service/hid/irs.h"
 #include "core/hle/service/hid/xcd.h"
 #include "core/hle/service/service.h"
+#include "core/movie.h"
 
 namespace Service::HID {
 
@@ -26,6 +28,96 @@ constexpr u64 pad_update_ticks = CoreTiming::BASE_CLOCK_RATE / 100;
 constexpr u64 accelerometer_update_ticks = CoreTiming::BASE_CLOCK_RATE / 100;
 constexpr u64 gyroscope_update_ticks = CoreTiming::BASE_CLOCK_RATE / 100;
 
+// Controller types supported until the guest says otherwise
+constexpr u32 ALL_NPAD_STYLES = ControllerType_ProController | ControllerType_Handheld |
+                                ControllerType_JoyconPair | ControllerType_JoyconLeft |
+                                ControllerType_JoyconRight;
+
+/// Controller state polled once per pad update, before being written to each layout
+struct PadInput {
+    ControllerPadState buttons;
+    s32 joystick_left_x;
+    s32 joystick_left_y;
+    s32 joystick_right_x;
+    s32 joystick_right_y;
+};
+
+/// Snaps a stick axis to its minimum, center or maximum, as digital layouts report
+static s32 ToDigitalAxis(s32 value) {
+    if (value > HID_JOYSTICK_MAX / 2) {
+        return HID_JOYSTICK_MAX;
+    }
+    if (value < HID_JOYSTICK_MIN / 2) {
+        return HID_JOYSTICK_MIN;
+    }
+    return 0;
+}
+
+/// Appends the polled state as the newest entry of a layout's ring
+template <ControllerLayoutType layout_type>
+static void WriteLayout(ControllerLayout& layout, const PadInput& input, u64 timestamp_ticks) {
+    // HID shared memory stores the state of the past 17 samples in a circlular buffer, each with
+    // a timestamp in number of samples since boot.
+    const ControllerInputEntry& last_entry = layout.entries[layout.header.latest_entry];
+    const u64 next_entry_index = (layout.header.latest_entry + 1) % HID_NUM_ENTRIES;
+
+    ControllerInputEntry& entry = layout.entries[next_entry_index];
+    entry.timestamp = last_entry.timestamp + 1;
+    // TODO(shinyquagsire23): Is this always identical to timestamp?
+    entry.timestamp_2 = entry.timestamp;
+    entry.connection_state = ConnectionState_Connected | ConnectionState_Wired;
+
+    // TODO(shinyquagsire23): Split Joy-Con will rotate the face buttons and directions for
+    // certain layouts. For now everything is just the default handheld layout.
+    entry.buttons.hex = input.buttons.hex;
+    if constexpr (layout_type == Layout_DefaultDigital) {
+        entry.joystick_left_x = ToDigitalAxis(input.joystick_left_x);
+        entry.joystick_left_y = ToDigitalAxis(input.joystick_left_y);
+        entry.joystick_right_x = ToDigitalAxis(input.joystick_right_x);
+        entry.joystick_right_y = ToDigitalAxis(input.joystick_right_y);
+    } else {
+        entry.joystick_left_x = input.joystick_left_x;
+        entry.joystick_left_y = input.joystick_left_y;
+        entry.joystick_right_x = input.joystick_right_x;
+        entry.joystick_right_y = input.joystick_right_y;
+    }
+
+    // Publish the entry only once it is complete, as the guest reads it concurrently
+    layout.header.timestamp_ticks = timestamp_ticks;
+    layout.header.latest_entry = next_entry_index;
+}
+
+using LayoutWriter = void (*)(ControllerLayout&, const PadInput&, u64);
+
+/// Writer of each layout, indexed by ControllerLayoutType
+constexpr std::array<LayoutWriter, HID_NUM_LAYOUTS> layout_writers{{
+    &WriteLayout<Layout_ProController>,
+    &WriteLayout<Layout_Handheld>,
+    &WriteLayout<Layout_Single>,
+    &WriteLayout<Layout_Left>,
+    &WriteLayout<Layout_Right>,
+    &WriteLayout<Layout_DefaultDigital>,
+    &WriteLayout<Layout_Default>,
+}};
+
+/// Returns the mask of the layouts guests supporting the given controller types read
+static u32 GetLayoutsOfStyleSet(u32 style_set) {
+    // Every controller fills in the default layouts
+    u32 layouts = (1U << Layout_Default) | (1U << Layout_DefaultDigital);
+    if (style_set & ControllerType_ProController)
+        layouts |= 1U << Layout_ProController;
+    if (style_set & ControllerType_Handheld)
+        layouts |= 1U << Layout_Handheld;
+    if (style_set & (ControllerType_JoyconPair | ControllerType_JoyconLeft |
+                     ControllerType_JoyconRight))
+        layouts |= 1U << Layout_Single;
+    if (style_set & ControllerType_JoyconLeft)
+        layouts |= 1U << Layout_Left;
+    if (style_set & ControllerType_JoyconRight)
+        layouts |= 1U << Layout_Right;
+    return layouts;
+}
+
 class IAppletResource final : public ServiceFramework<IAppletResource> {
 public:
     IAppletResource() : ServiceFramework("IAppletResource") {
@@ -38,6 +130,16 @@ public:
             nullptr, 0x40000, Kernel::MemoryPermission::ReadWrite, Kernel::MemoryPermission::Read,
             0, Kernel::MemoryRegion::BASE, "HID:SharedMemory");
 
+        // Layouts are only written while a controller using them is connected, but guests may
+        // read any of them
+        SharedMemory& mem = *reinterpret_cast<SharedMemory*>(shared_mem->GetPointer());
+        for (auto& controller : mem.controllers) {
+            for (auto& layout : controller.layouts) {
+                layout.header.num_entries = HID_NUM_ENTRIES;
+                layout.header.max_entry_index = HID_NUM_ENTRIES - 1;
+            }
+        }
+
         // Register update callbacks
         pad_update_event = CoreTiming::RegisterEvent(
             "HID::UpdatePadCallback",
@@ -52,6 +154,11 @@ public:
         CoreTiming::UnscheduleEvent(pad_update_event, 0);
     }
 
+    /// Restricts the controller layouts written on each update to those of the given styles
+    void SetSupportedNpadStyleSet(u32 style_set) {
+        active_layouts = GetLayoutsOfStyleSet(style_set);
+    }
+
 private:
     void GetSharedMemoryHandle(Kernel::HLERequestContext& ctx) {
         IPC::ResponseBuilder rb{ctx, 2, 1};
@@ -71,9 +178,47 @@ private:
         // TODO(shinyquagsire23): gyro, mouse, keyboard
     }
 
+    /// Polls the emulated handheld controller, once per pad update
+    ControllerPadState PollHandheldButtons() const {
+        ControllerPadState state{};
+        using namespace Settings::NativeButton;
+        state.a.Assign(buttons[A - BUTTON_HID_BEGIN]->GetStatus());
+        state.b.Assign(buttons[B - BUTTON_HID_BEGIN]->GetStatus());
+        state.x.Assign(buttons[X - BUTTON_HID_BEGIN]->GetStatus());
+        state.y.Assign(buttons[Y - BUTTON_HID_BEGIN]->GetStatus());
+        state.lstick.Assign(buttons[LStick - BUTTON_HID_BEGIN]->GetStatus());
+        state.rstick.Assign(buttons[RStick - BUTTON_HID_BEGIN]->GetStatus());
+        state.l.Assign(buttons[L - BUTTON_HID_BEGIN]->GetStatus());
+        state.r.Assign(buttons[R - BUTTON_HID_BEGIN]->GetStatus());
+        state.zl.Assign(buttons[ZL - BUTTON_HID_BEGIN]->GetStatus());
+        state.zr.Assign(buttons[ZR - BUTTON_HID_BEGIN]->GetStatus());
+        state.plus.Assign(buttons[Plus - BUTTON_HID_BEGIN]->GetStatus());
+        state.minus.Assign(buttons[Minus - BUTTON_HID_BEGIN]->GetStatus());
+
+        state.dleft.Assign(buttons[DLeft - BUTTON_HID_BEGIN]->GetStatus());
+        state.dup.Assign(buttons[DUp - BUTTON_HID_BEGIN]->GetStatus());
+        state.dright.Assign(buttons[DRight - BUTTON_HID_BEGIN]->GetStatus());
+        state.ddown.Assign(buttons[DDown - BUTTON_HID_BEGIN]->GetStatus());
+
+        state.lstick_left.Assign(buttons[LStick_Left - BUTTON_HID_BEGIN]->GetStatus());
+        state.lstick_up.Assign(buttons[LStick_Up - BUTTON_HID_BEGIN]->GetStatus());
+        state.lstick_right.Assign(buttons[LStick_Right - BUTTON_HID_BEGIN]->GetStatus());
+        state.lstick_down.Assign(buttons[LStick_Down - BUTTON_HID_BEGIN]->GetStatus());
+
+        state.rstick_left.Assign(buttons[RStick_Left - BUTTON_HID_BEGIN]->GetStatus());
+        state.rstick_up.Assign(buttons[RStick_Up - BUTTON_HID_BEGIN]->GetStatus());
+        state.rstick_right.Assign(buttons[RStick_Right - BUTTON_HID_BEGIN]->GetStatus());
+        state.rstick_down.Assign(buttons[RStick_Down - BUTTON_HID_BEGIN]->GetStatus());
+
+        state.sl.Assign(buttons[SL - BUTTON_HID_BEGIN]->GetStatus());
+        state.sr.Assign(buttons[SR - BUTTON_HID_BEGIN]->GetStatus());
+        return state;
+    }
+
     void UpdatePadCallback(u64 userdata, int cycles_late) {
-        SharedMemory mem{};
-        std::memcpy(&mem, shared_mem->GetPointer(), sizeof(SharedMemory));
+        // The shared memory block is updated in place, copying the whole 256KiB structure out and
+        // back in on every update was considerably more expensive than the update itself.
+        SharedMemory& mem = *reinterpret_cast<SharedMemory*>(shared_mem->GetPointer());
 
         if (is_device_reload_pending.exchange(false))
             LoadInputDevices();
@@ -87,71 +232,46 @@ private:
         controller_header.left_color_body = JOYCON_BODY_NEON_BLUE;
         controller_header.left_color_buttons = JOYCON_BUTTONS_NEON_BLUE;
 
-        for (size_t controller = 0; controller < mem.controllers.size(); controller++) {
-            for (auto& layout : mem.controllers[controller].layouts) {
-                layout.header.num_entries = HID_NUM_ENTRIES;
-                layout.header.max_entry_index = HID_NUM_ENTRIES - 1;
+        // The input devices are polled once, the same state is then written to every active layout
+        const auto [stick_l_x_f, stick_l_y_f] = sticks[Joystick_Left]->GetStatus();
+        const auto [stick_r_x_f, stick_r_y_f] = sticks[Joystick_Right]->GetStatus();
+
+        PadInput pad_input{
+            PollHandheldButtons(),
+            static_cast<s32>(stick_l_x_f * HID_JOYSTICK_MAX),
+            static_cast<s32>(stick_l_y_f * HID_JOYSTICK_MAX),
+            static_cast<s32>(stick_r_x_f * HID_JOYSTICK_MAX),
+            static_cast<s32>(stick_r_y_f * HID_JOYSTICK_MAX),
+        };
+        auto [x, y, pressed] = touch_device->GetStatus();
+
+        const u64 timestamp_ticks = CoreTiming::GetTicks();
+        if (Core::Movie* const movie = Core::System::GetInstance().GetMovie()) {
+            Core::Movie::InputSample sample{
+                timestamp_ticks,
+                pad_input.buttons.hex,
+                {pad_input.joystick_left_x, pad_input.joystick_left_y, pad_input.joystick_right_x,
+                 pad_input.joystick_right_y},
+                x,
+                y,
+                pressed,
+            };
+            movie->HandlePadInput(sample);
+            pad_input.buttons.hex = sample.buttons;
+            pad_input.joystick_left_x = sample.joysticks[0];
+            pad_input.joystick_left_y = sample.joysticks[1];
+            pad_input.joystick_right_x = sample.joysticks[2];
+            pad_input.joystick_right_y = sample.joysticks[3];
+            x = sample.touch_x;
+            y = sample.touch_y;
+            pressed = sample.touch_pressed != 0;
+        }
 
-                // HID shared memory stores the state of the past 17 samples in a circlular buffer,
-                // each with a timestamp in number of samples since boot.
-                const ControllerInputEntry& last_entry = layout.entries[layout.header.latest_entry];
-
-                layout.header.timestamp_ticks = CoreTiming::GetTicks();
-                layout.header.latest_entry = (layout.header.latest_entry + 1) % HID_NUM_ENTRIES;
-
-                ControllerInputEntry& entry = layout.entries[layout.header.latest_entry];
-                entry.timestamp = last_entry.timestamp + 1;
-                // TODO(shinyquagsire23): Is this always identical to timestamp?
-                entry.timestamp_2 = entry.timestamp;
-
-                // TODO(shinyquagsire23): More than just handheld input
-                if (controller != Controller_Handheld)
-                    continue;
-
-                entry.connection_state = ConnectionState_Connected | ConnectionState_Wired;
-
-                // TODO(shinyquagsire23): Set up some LUTs for each layout mapping in the future?
-                // For now everything is just the default handheld layout, but split Joy-Con will
-                // rotate the face buttons and directions for certain layouts.
-                ControllerPadState& state = entry.buttons;
-                using namespace Settings::NativeButton;
-                state.a.Assign(buttons[A - BUTTON_HID_BEGIN]->GetStatus());
-                state.b.Assign(buttons[B - BUTTON_HID_BEGIN]->GetStatus());
-                state.x.Assign(buttons[X - BUTTON_HID_BEGIN]->GetStatus());
-                state.y.Assign(buttons[Y - BUTTON_HID_BEGIN]->GetStatus());
-                state.lstick.Assign(buttons[LStick - BUTTON_HID_BEGIN]->GetStatus());
-                state.rstick.Assign(buttons[RStick - BUTTON_HID_BEGIN]->GetStatus());
-                state.l.Assign(buttons[L - BUTTON_HID_BEGIN]->GetStatus());
-                state.r.Assign(buttons[R - BUTTON_HID_BEGIN]->GetStatus());
-                state.zl.Assign(buttons[ZL - BUTTON_HID_BEGIN]->GetStatus());
-                state.zr.Assign(buttons[ZR - BUTTON_HID_BEGIN]->GetStatus());
-                state.plus.Assign(buttons[Plus - BUTTON_HID_BEGIN]->GetStatus());
-                state.minus.Assign(buttons[Minus - BUTTON_HID_BEGIN]->GetStatus());
-
-                state.dleft.Assign(buttons[DLeft - BUTTON_HID_BEGIN]->GetStatus());
-                state.dup.Assign(buttons[DUp - BUTTON_HID_BEGIN]->GetStatus());
-                state.dright.Assign(buttons[DRight - BUTTON_HID_BEGIN]->GetStatus());
-                state.ddown.Assign(buttons[DDown - BUTTON_HID_BEGIN]->GetStatus());
-
-                state.lstick_left.Assign(buttons[LStick_Left - BUTTON_HID_BEGIN]->GetStatus());
-                state.lstick_up.Assign(buttons[LStick_Up - BUTTON_HID_BEGIN]->GetStatus());
-                state.lstick_right.Assign(buttons[LStick_Right - BUTTON_HID_BEGIN]->GetStatus());
-                state.lstick_down.Assign(buttons[LStick_Down - BUTTON_HID_BEGIN]->GetStatus());
-
-                state.rstick_left.Assign(buttons[RStick_Left - BUTTON_HID_BEGIN]->GetStatus());
-                state.rstick_up.Assign(buttons[RStick_Up - BUTTON_HID_BEGIN]->GetStatus());
-                state.rstick_right.Assign(buttons[RStick_Right - BUTTON_HID_BEGIN]->GetStatus());
-                state.rstick_down.Assign(buttons[RStick_Down - BUTTON_HID_BEGIN]->GetStatus());
-
-                state.sl.Assign(buttons[SL - BUTTON_HID_BEGIN]->GetStatus());
-                state.sr.Assign(buttons[SR - BUTTON_HID_BEGIN]->GetStatus());
-
-                const auto [stick_l_x_f, stick_l_y_f] = sticks[Joystick_Left]->GetStatus();
-                const auto [stick_r_x_f, stick_r_y_f] = sticks[Joystick_Right]->GetStatus();
-                entry.joystick_left_x = static_cast<s32>(stick_l_x_f * HID_JOYSTICK_MAX);
-                entry.joystick_left_y = static_cast<s32>(stick_l_y_f * HID_JOYSTICK_MAX);
-                entry.joystick_right_x = static_cast<s32>(stick_r_x_f * HID_JOYSTICK_MAX);
-                entry.joystick_right_y = static_cast<s32>(stick_r_y_f * HID_JOYSTICK_MAX);
+        // TODO(shinyquagsire23): More than just handheld input
+        auto& layouts = mem.controllers[Controller_Handheld].layouts;
+        for (size_t layout = 0; layout < layouts.size(); ++layout) {
+            if ((active_layouts & (1U << layout)) != 0) {
+                layout_writers[layout](layouts[layout], pad_input, timestamp_ticks);
             }
         }
 
@@ -168,7 +288,6 @@ private:
         touchscreen.entries[curr_entry].header.timestamp = sample_counter;
 
         TouchScreenEntryTouch touch_entry{};
-        auto [x, y, pressed] = touch_device->GetStatus();
         touch_entry.timestamp = timestamp;
         touch_entry.x = static_cast<u16>(x * Layout::ScreenUndocked::Width);
         touch_entry.y = static_cast<u16>(y * Layout::ScreenUndocked::Height);
@@ -251,8 +370,6 @@ private:
 
         // TODO(shinyquagsire23): Signal events
 
-        std::memcpy(shared_mem->GetPointer(), &mem, sizeof(SharedMemory));
-
         // Reschedule recurrent event
         CoreTiming::ScheduleEvent(pad_update_ticks - cycles_late, pad_update_event);
     }
@@ -265,6 +382,7 @@ private:
 
     // Stored input state info
     std::atomic<bool> is_device_reload_pending{true};
+    u32 active_layouts = GetLayoutsOfStyleSet(ALL_NPAD_STYLES);
     std::array<std::unique_ptr<Input::ButtonDevice>, Settings::NativeButton::NUM_BUTTONS_HID>
         buttons;
     std::array<std::unique_ptr<Input::AnalogDevice>, Settings::NativeAnalog::NUM_STICKS_HID> sticks;
@@ -407,12 +525,14 @@ public:
 
 private:
     std::shared_ptr<IAppletResource> applet_resource;
+    u32 supported_style_set = ALL_NPAD_STYLES;
     u32 joy_hold_type{0};
     Kernel::SharedPtr<Kernel::Event> event;
 
     void CreateAppletResource(Kernel::HLERequestContext& ctx) {
         if (applet_resource == nullptr) {
             applet_resource = std::make_shared<IAppletResource>();
+            applet_resource->SetSupportedNpadStyleSet(supported_style_set);
         }
 
         IPC::ResponseBuilder rb{ctx, 2, 0, 1};
@@ -466,16 +586,22 @@ private:
     }
 
     void SetSupportedNpadStyleSet(Kernel::HLERequestContext& ctx) {
+        IPC::RequestParser rp{ctx};
+        supported_style_set = rp.Pop<u32>();
+        if (applet_resource != nullptr) {
+            applet_resource->SetSupportedNpadStyleSet(supported_style_set);
+        }
+
         IPC::ResponseBuilder rb{ctx, 2};
         rb.Push(RESULT_SUCCESS);
-        LOG_WARNING(Service_HID, "(STUBBED) called");
+        LOG_DEBUG(Service_HID, "called, supported_style_set=0x{:X}", supported_style_set);
     }
 
     void GetSupportedNpadStyleSet(Kernel::HLERequestContext& ctx) {
         IPC::ResponseBuilder rb{ctx, 3};
         rb.Push(RESULT_SUCCESS);
-        rb.Push<u32>(0);
-        LOG_WARNING(Service_HID, "(STUBBED) called");
+        rb.Push<u32>(supported_style_set);
+        LOG_DEBUG(Service_HID, "called");
     }
 
     void SetSupportedNpadIdType(Kernel::HLERequestContext& ctx) {
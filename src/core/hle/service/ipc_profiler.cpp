@@ -0,0 +1,112 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <utility>
+#include <fmt/format.h>
+#include "core/hle/service/ipc_profiler.h"
+
+namespace Service::IPCProfiler {
+
+namespace {
+std::mutex registry_mutex;
+std::unordered_map<std::string, std::shared_ptr<ServiceStats>> registry;
+
+std::size_t GetBucket(std::chrono::nanoseconds time) {
+    const auto us = std::chrono::duration_cast<std::chrono::microseconds>(time).count();
+    std::size_t bucket = 0;
+    while (bucket < NUM_BUCKETS - 1 && (s64{1} << bucket) <= us) {
+        ++bucket;
+    }
+    return bucket;
+}
+} // Anonymous namespace
+
+std::chrono::microseconds CommandStats::GetPercentile(double fraction) const {
+    const auto target = static_cast<u64>(fraction * calls);
+    u64 count = 0;
+    for (std::size_t bucket = 0; bucket < NUM_BUCKETS - 1; ++bucket) {
+        count += histogram[bucket];
+        if (count > target || count == calls) {
+            return std::chrono::microseconds{s64{1} << bucket};
+        }
+    }
+    return std::chrono::duration_cast<std::chrono::microseconds>(max_time);
+}
+
+ServiceStats::ServiceStats(std::string service_name) : service_name{std::move(service_name)} {}
+
+void ServiceStats::RecordCall(u32 command, const char* command_name,
+                              std::chrono::nanoseconds time) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto [itr, inserted] = commands.try_emplace(command);
+    CommandStats& stats = itr->second;
+    if (inserted) {
+        stats.service_name = service_name;
+        stats.command = command;
+        stats.command_name = command_name != nullptr ? command_name : "";
+    }
+    ++stats.calls;
+    stats.total_time += time;
+    stats.max_time = std::max(stats.max_time, time);
+    ++stats.histogram[GetBucket(time)];
+}
+
+std::shared_ptr<ServiceStats> GetServiceStats(const std::string& service_name) {
+    std::lock_guard<std::mutex> lock(registry_mutex);
+    auto& stats = registry[service_name];
+    if (!stats) {
+        stats = std::make_shared<ServiceStats>(service_name);
+    }
+    return stats;
+}
+
+std::vector<CommandStats> GetStats() {
+    std::vector<CommandStats> stats;
+    {
+        std::lock_guard<std::mutex> lock(registry_mutex);
+        for (const auto& [name, service] : registry) {
+            std::lock_guard<std::mutex> service_lock(service->mutex);
+            for (const auto& [command, command_stats] : service->commands) {
+                stats.push_back(command_stats);
+            }
+        }
+    }
+    std::sort(stats.begin(), stats.end(), [](const CommandStats& a, const CommandStats& b) {
+        return a.total_time > b.total_time;
+    });
+    return stats;
+}
+
+void ResetStats() {
+    std::lock_guard<std::mutex> lock(registry_mutex);
+    for (const auto& [name, service] : registry) {
+        std::lock_guard<std::mutex> service_lock(service->mutex);
+        service->commands.clear();
+    }
+}
+
+std::string StatsToCsv(const std::vector<CommandStats>& stats) {
+    std::string csv = "service,command,name,calls,total_ms,mean_us,p50_us,p99_us,max_us";
+    for (std::size_t bucket = 0; bucket < NUM_BUCKETS - 1; ++bucket) {
+        csv += fmt::format(",under_{}us", u64{1} << bucket);
+    }
+    csv += ",slower\n";
+
+    for (const CommandStats& command : stats) {
+        const double total_us = command.total_time.count() / 1000.0;
+        csv += fmt::format("{},{},{},{},{:.3f},{:.3f},{},{},{:.3f}", command.service_name,
+                           command.command, command.command_name, command.calls,
+                           total_us / 1000.0, command.calls != 0 ? total_us / command.calls : 0.0,
+                           command.GetPercentile(0.5).count(), command.GetPercentile(0.99).count(),
+                           command.max_time.count() / 1000.0);
+        for (const u64 count : command.histogram) {
+            csv += fmt::format(",{}", count);
+        }
+        csv += '\n';
+    }
+    return csv;
+}
+
+} // namespace Service::IPCProfiler
@@ -0,0 +1,73 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "common/common_types.h"
+
+/**
+ * Call counts and host times of the commands handled by the HLE services, to find out which
+ * services the guest spends its time in. Only the synchronous part of a request is timed, work a
+ * handler hands off to the HLE workers isn't.
+ */
+namespace Service::IPCProfiler {
+
+/**
+ * Number of buckets of the time histograms. Bucket i counts the calls that took less than 2^i
+ * microseconds and more than the bucket before it, the last one counts the rest.
+ */
+constexpr std::size_t NUM_BUCKETS = 16;
+
+struct CommandStats {
+    std::string service_name;
+    u32 command = 0;
+    /// Name of the handler, empty for commands without one
+    std::string command_name;
+    u64 calls = 0;
+    std::chrono::nanoseconds total_time{};
+    std::chrono::nanoseconds max_time{};
+    std::array<u64, NUM_BUCKETS> histogram{};
+
+    /// Returns the upper bound of the bucket within which fraction of the calls finished
+    std::chrono::microseconds GetPercentile(double fraction) const;
+};
+
+/// Calls of the commands of the services sharing a name, shared by every instance of them
+class ServiceStats {
+public:
+    explicit ServiceStats(std::string service_name);
+
+    void RecordCall(u32 command, const char* command_name, std::chrono::nanoseconds time);
+
+private:
+    friend std::vector<CommandStats> GetStats();
+    friend void ResetStats();
+
+    /// Taken as the services of a name may be called from several cores
+    std::mutex mutex;
+    std::string service_name;
+    std::unordered_map<u32, CommandStats> commands;
+};
+
+/// Returns the stats of the services named service_name, created on the first call
+std::shared_ptr<ServiceStats> GetServiceStats(const std::string& service_name);
+
+/// Returns the stats of every command called so far, the most time spent in first
+std::vector<CommandStats> GetStats();
+
+/// Clears the stats of every command
+void ResetStats();
+
+/// Formats the stats of the commands as CSV, with a header row
+std::string StatsToCsv(const std::vector<CommandStats>& stats);
+
+} // namespace Service::IPCProfiler
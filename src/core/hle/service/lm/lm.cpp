@@ -2,14 +2,15 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
-#include <sstream>
+#include <algorithm>
+#include <cstring>
 #include <string>
 
+#include "common/logging/backend.h"
 #include "common/logging/log.h"
 #include "core/hle/ipc_helpers.h"
 #include "core/hle/service/lm/lm.h"
 #include "core/hle/service/service.h"
-#include "core/memory.h"
 
 namespace Service::LM {
 
@@ -66,119 +67,151 @@ private:
         Thread = 7,
     };
 
-    /**
-     * ILogger::Initialize service function
-     *  Inputs:
-     *      0: 0x00000000
-     *  Outputs:
-     *      0: ResultCode
-     */
-    void Initialize(Kernel::HLERequestContext& ctx) {
-        // This function only succeeds - Get that out of the way
-        IPC::ResponseBuilder rb{ctx, 2};
-        rb.Push(RESULT_SUCCESS);
-
-        // Read MessageHeader, despite not doing anything with it right now
-        MessageHeader header{};
-        VAddr addr{ctx.BufferDescriptorX()[0].Address()};
-        const VAddr end_addr{addr + ctx.BufferDescriptorX()[0].size};
-        Memory::ReadBlock(addr, &header, sizeof(MessageHeader));
-        addr += sizeof(MessageHeader);
-
-        if (header.IsHeadLog()) {
-            log_stream.str("");
-            log_stream.clear();
-        }
-
-        // Parse out log metadata
-        u32 line{};
-        std::string module;
-        std::string message;
+    /// Fields of the message being received, which may be split over several packets
+    struct PendingMessage {
+        u32 line = 0;
         std::string filename;
         std::string function;
+        std::string module;
         std::string thread;
-        while (addr < end_addr) {
-            const Field field{static_cast<Field>(Memory::Read8(addr++))};
-            const size_t length{Memory::Read8(addr++)};
+        std::string message;
+    };
+
+    static Log::Level GetLogLevel(MessageHeader::Severity severity) {
+        switch (severity) {
+        case MessageHeader::Severity::Trace:
+            return Log::Level::Debug;
+        case MessageHeader::Severity::Info:
+            return Log::Level::Info;
+        case MessageHeader::Severity::Warning:
+            return Log::Level::Warning;
+        case MessageHeader::Severity::Error:
+            return Log::Level::Error;
+        case MessageHeader::Severity::Critical:
+        default:
+            return Log::Level::Critical;
+        }
+    }
 
-            if (static_cast<Field>(Memory::Read8(addr)) == Field::Skip) {
-                ++addr;
+    /// Decodes a ULEB128 encoded field length, returns false if it runs past the end
+    static bool ReadFieldLength(const u8*& data, const u8* end, size_t& length) {
+        length = 0;
+        for (unsigned shift = 0; data < end && shift < 32; shift += 7) {
+            const u8 byte = *data++;
+            length |= static_cast<size_t>(byte & 0x7F) << shift;
+            if ((byte & 0x80) == 0) {
+                return true;
             }
+        }
+        return false;
+    }
+
+    /// Parses the fields of a packet straight from its buffer into the pending message
+    void ParseFields(const u8* data, const u8* end) {
+        while (data < end) {
+            const Field field{static_cast<Field>(*data++)};
+            size_t length;
+            if (!ReadFieldLength(data, end, length)) {
+                break;
+            }
+            length = std::min<size_t>(length, end - data);
+
+            // Strings may or may not be null terminated
+            const char* const text = reinterpret_cast<const char*>(data);
+            const size_t text_length = std::find(text, text + length, '\0') - text;
 
             switch (field) {
             case Field::Skip:
                 break;
             case Field::Message:
-                message = Memory::ReadCString(addr, length);
+                pending.message.append(text, text_length);
                 break;
             case Field::Line:
-                line = Memory::Read32(addr);
+                if (length >= sizeof(u32)) {
+                    std::memcpy(&pending.line, data, sizeof(u32));
+                }
                 break;
             case Field::Filename:
-                filename = Memory::ReadCString(addr, length);
+                pending.filename.assign(text, text_length);
                 break;
             case Field::Function:
-                function = Memory::ReadCString(addr, length);
+                pending.function.assign(text, text_length);
                 break;
             case Field::Module:
-                module = Memory::ReadCString(addr, length);
+                pending.module.assign(text, text_length);
                 break;
             case Field::Thread:
-                thread = Memory::ReadCString(addr, length);
+                pending.thread.assign(text, text_length);
                 break;
             }
 
-            addr += length;
+            data += length;
         }
+    }
 
-        // Empty log - nothing to do here
-        if (log_stream.str().empty() && message.empty()) {
+    /**
+     * ILogger::Initialize service function
+     *  Inputs:
+     *      0: 0x00000000
+     *  Outputs:
+     *      0: ResultCode
+     */
+    void Initialize(Kernel::HLERequestContext& ctx) {
+        // This function only succeeds - Get that out of the way
+        IPC::ResponseBuilder rb{ctx, 2};
+        rb.Push(RESULT_SUCCESS);
+
+        const auto buffer = ctx.ReadBufferView();
+        if (buffer.size() < sizeof(MessageHeader)) {
+            return;
+        }
+
+        MessageHeader header{};
+        std::memcpy(&header, buffer.data(), sizeof(MessageHeader));
+
+        // Chatty titles log a lot, drop whatever the filter rejects before parsing any of it
+        const Log::Level level = GetLogLevel(header.severity);
+        if (!Log::CheckGlobalFilter(Log::Class::Debug_Emulated, level)) {
             return;
         }
 
-        // Format a nicely printable string out of the log metadata
-        if (!filename.empty()) {
-            log_stream << filename << ':';
+        if (header.IsHeadLog()) {
+            pending = {};
         }
-        if (!module.empty()) {
-            log_stream << module << ':';
+        ParseFields(buffer.data() + sizeof(MessageHeader), buffer.data() + buffer.size());
+
+        if (!header.IsTailLog()) {
+            return;
         }
-        if (!function.empty()) {
-            log_stream << function << ':';
+
+        PendingMessage message = std::move(pending);
+        pending = {};
+
+        // Empty log - nothing to do here
+        if (message.message.empty()) {
+            return;
         }
-        if (line) {
-            log_stream << std::to_string(line) << ':';
+
+        // The guest's source location goes into the entry as is, it's only formatted by the
+        // logging thread
+        std::string text;
+        if (!message.module.empty()) {
+            text += message.module + ':';
         }
-        if (!thread.empty()) {
-            log_stream << thread << ':';
+        if (!message.thread.empty()) {
+            text += message.thread + ':';
         }
-        if (log_stream.str().length() > 0 && log_stream.str().back() == ':') {
-            log_stream << ' ';
+        if (!text.empty()) {
+            text += ' ';
         }
-        log_stream << message;
+        text += message.message;
 
-        if (header.IsTailLog()) {
-            switch (header.severity) {
-            case MessageHeader::Severity::Trace:
-                LOG_DEBUG(Debug_Emulated, "{}", log_stream.str());
-                break;
-            case MessageHeader::Severity::Info:
-                LOG_INFO(Debug_Emulated, "{}", log_stream.str());
-                break;
-            case MessageHeader::Severity::Warning:
-                LOG_WARNING(Debug_Emulated, "{}", log_stream.str());
-                break;
-            case MessageHeader::Severity::Error:
-                LOG_ERROR(Debug_Emulated, "{}", log_stream.str());
-                break;
-            case MessageHeader::Severity::Critical:
-                LOG_CRITICAL(Debug_Emulated, "{}", log_stream.str());
-                break;
-            }
-        }
+        Log::QueueEntry(Log::CreateEntry(Log::Class::Debug_Emulated, level,
+                                         message.filename.c_str(), message.line,
+                                         message.function.c_str(), std::move(text)));
     }
 
-    std::ostringstream log_stream;
+    PendingMessage pending;
 };
 
 class LM final : public ServiceFramework<LM> {
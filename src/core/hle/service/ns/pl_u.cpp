@@ -47,6 +47,11 @@ static constexpr FontRegion EMPTY_REGION{0, 0};
 std::vector<FontRegion>
     SHARED_FONT_REGIONS{}; // Automatically populated based on shared_fonts dump or system archives
 
+// The fonts are the same for every title, so they are only loaded once and then shared by every
+// emulation session
+static std::shared_ptr<std::vector<u8>> cached_shared_font;
+static std::vector<FontRegion> cached_shared_font_regions;
+
 const FontRegion& GetSharedFontRegion(size_t index) {
     if (index >= SHARED_FONT_REGIONS.size() || SHARED_FONT_REGIONS.empty()) {
         // No font fallback
@@ -60,28 +65,27 @@ enum class LoadState : u32 {
     Done = 1,
 };
 
-void DecryptSharedFont(const std::vector<u32>& input, std::vector<u8>& output, size_t& offset) {
-    ASSERT_MSG(offset + (input.size() * sizeof(u32)) < SHARED_FONT_MEM_SIZE,
-               "Shared fonts exceeds 17mb!");
-    ASSERT_MSG(input[0] == EXPECTED_MAGIC, "Failed to derive key, unexpected magic number");
-
-    const u32 KEY = input[0] ^ EXPECTED_RESULT; // Derive key using an inverse xor
-    std::vector<u32> transformed_font(input.size());
-    // TODO(ogniK): Figure out a better way to do this
-    std::transform(input.begin(), input.end(), transformed_font.begin(),
-                   [&KEY](u32 font_data) { return Common::swap32(font_data ^ KEY); });
-    transformed_font[1] = Common::swap32(transformed_font[1]) ^ KEY; // "re-encrypt" the size
-    std::memcpy(output.data() + offset, transformed_font.data(),
-                transformed_font.size() * sizeof(u32));
-    offset += transformed_font.size() * sizeof(u32);
-}
-
 static u32 GetU32Swapped(const u8* data) {
     u32 value;
     std::memcpy(&value, data, sizeof(value));
     return Common::swap32(value); // Helper function to make BuildSharedFontsRawRegions a bit nicer
 }
 
+/// Decrypts a font read into the shared memory in place
+static void DecryptSharedFont(u8* data, size_t size) {
+    ASSERT_MSG(GetU32Swapped(data) == EXPECTED_MAGIC,
+               "Failed to derive key, unexpected magic number");
+
+    const u32 KEY = GetU32Swapped(data) ^ EXPECTED_RESULT; // Derive key using an inverse xor
+    for (size_t word = 0; word < size / sizeof(u32); ++word) {
+        // We need to be BigEndian as u32s for the xor encryption
+        const u32 encrypted = GetU32Swapped(data + word * sizeof(u32));
+        // The size is kept "re-encrypted"
+        const u32 decrypted = word == 1 ? encrypted : Common::swap32(encrypted ^ KEY);
+        std::memcpy(data + word * sizeof(u32), &decrypted, sizeof(u32));
+    }
+}
+
 void BuildSharedFontsRawRegions(const std::vector<u8>& input) {
     unsigned cur_offset = 0; // As we can derive the xor key we can just populate the offsets based
                              // on the shared memory dump
@@ -107,6 +111,15 @@ PL_U::PL_U() : ServiceFramework("pl:u") {
         {5, &PL_U::GetSharedFontInOrderOfPriority, "GetSharedFontInOrderOfPriority"},
     };
     RegisterHandlers(functions);
+
+    // The regions are rebuilt by every session, a failed load must not leave stale ones behind
+    if (cached_shared_font != nullptr) {
+        shared_font = cached_shared_font;
+        SHARED_FONT_REGIONS = cached_shared_font_regions;
+        return;
+    }
+    SHARED_FONT_REGIONS.clear();
+
     // Attempt to load shared font data from disk
     const auto nand = FileSystem::GetSystemNANDContents();
     // Rebuild shared fonts from data ncas
@@ -140,16 +153,15 @@ PL_U::PL_U() : ServiceFramework("pl:u") {
                           static_cast<u64>(font.first), font.second);
                 continue;
             }
-            std::vector<u32> font_data_u32(font_fp->GetSize() / sizeof(u32));
-            font_fp->ReadBytes<u32>(font_data_u32.data(), font_fp->GetSize());
-            // We need to be BigEndian as u32s for the xor encryption
-            std::transform(font_data_u32.begin(), font_data_u32.end(), font_data_u32.begin(),
-                           Common::swap32);
-            FontRegion region{
-                static_cast<u32>(offset + 8),
-                static_cast<u32>((font_data_u32.size() * sizeof(u32)) -
-                                 8)}; // Font offset and size do not account for the header
-            DecryptSharedFont(font_data_u32, *shared_font, offset);
+            const size_t font_size = font_fp->GetSize();
+            ASSERT_MSG(offset + font_size < SHARED_FONT_MEM_SIZE, "Shared fonts exceeds 17mb!");
+
+            // Fonts are read straight into the shared memory and decrypted there
+            font_fp->ReadBytes(shared_font->data() + offset, font_size);
+            DecryptSharedFont(shared_font->data() + offset, font_size);
+            // Font offset and size do not account for the header
+            FontRegion region{static_cast<u32>(offset + 8), static_cast<u32>(font_size - 8)};
+            offset += font_size;
             SHARED_FONT_REGIONS.push_back(region);
         }
     } else {
@@ -173,6 +185,11 @@ PL_U::PL_U() : ServiceFramework("pl:u") {
             LOG_WARNING(Service_NS, "Unable to load shared font: {}", filepath);
         }
     }
+
+    if (!SHARED_FONT_REGIONS.empty()) {
+        cached_shared_font = shared_font;
+        cached_shared_font_regions = SHARED_FONT_REGIONS;
+    }
 }
 
 void PL_U::RequestLoad(Kernel::HLERequestContext& ctx) {
@@ -215,15 +232,20 @@ void PL_U::GetSharedMemoryAddressOffset(Kernel::HLERequestContext& ctx) {
 }
 
 void PL_U::GetSharedMemoryNativeHandle(Kernel::HLERequestContext& ctx) {
-    // Map backing memory for the font data
-    Core::CurrentProcess()->vm_manager.MapMemoryBlock(
-        SHARED_FONT_MEM_VADDR, shared_font, 0, SHARED_FONT_MEM_SIZE, Kernel::MemoryState::Shared);
-
-    // Create shared font memory object
-    shared_font_mem = Kernel::SharedMemory::Create(
-        Core::CurrentProcess(), SHARED_FONT_MEM_SIZE, Kernel::MemoryPermission::ReadWrite,
-        Kernel::MemoryPermission::Read, SHARED_FONT_MEM_VADDR, Kernel::MemoryRegion::BASE,
-        "PL_U:shared_font_mem");
+    if (shared_font_mem == nullptr) {
+        // Map backing memory for the font data. It outlives the process and is read-only to it.
+        auto& vm_manager = Core::CurrentProcess()->vm_manager;
+        vm_manager.MapMemoryBlock(SHARED_FONT_MEM_VADDR, shared_font, 0, SHARED_FONT_MEM_SIZE,
+                                  Kernel::MemoryState::Shared);
+        vm_manager.ReprotectRange(SHARED_FONT_MEM_VADDR, SHARED_FONT_MEM_SIZE,
+                                  Kernel::VMAPermission::Read);
+
+        // Create shared font memory object
+        shared_font_mem = Kernel::SharedMemory::Create(
+            Core::CurrentProcess(), SHARED_FONT_MEM_SIZE, Kernel::MemoryPermission::Read,
+            Kernel::MemoryPermission::Read, SHARED_FONT_MEM_VADDR, Kernel::MemoryRegion::BASE,
+            "PL_U:shared_font_mem");
+    }
 
     LOG_DEBUG(Service_NS, "called");
     IPC::ResponseBuilder rb{ctx, 2, 1};
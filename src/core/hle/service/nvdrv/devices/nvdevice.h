@@ -4,13 +4,54 @@
 
 #pragma once
 
-#include <vector>
+#include <cstddef>
 #include "common/bit_field.h"
 #include "common/common_types.h"
 #include "common/swap.h"
+#include "core/hle/kernel/event.h"
 
 namespace Service::Nvidia::Devices {
 
+/**
+ * Non-owning view of the input or output buffer of an ioctl. It points straight at guest memory
+ * whenever the buffer is contiguous in host memory, and is only valid for the duration of the
+ * ioctl. Note that games commonly pass the same buffer as input and output.
+ */
+template <typename T>
+class IoctlBuffer {
+public:
+    IoctlBuffer(T* pointer, std::size_t length) : pointer(pointer), length(length) {}
+
+    T* data() const {
+        return pointer;
+    }
+
+    std::size_t size() const {
+        return length;
+    }
+
+private:
+    T* pointer;
+    std::size_t length;
+};
+
+using IoctlInput = IoctlBuffer<const u8>;
+using IoctlOutput = IoctlBuffer<u8>;
+
+/// Lets an ioctl put the calling thread to sleep and be issued again once the wait is over.
+struct IoctlCtrl {
+    /// Whether this is the first time the ioctl is issued rather than a retry after a wait.
+    bool fresh_call = true;
+    /// Whether the wait before this retry ended because its timeout expired.
+    bool timed_out = false;
+
+    /// Set by the device to retry the ioctl once wait_event is signaled or the timeout expires.
+    bool must_delay = false;
+    /// Timeout of the wait in nanoseconds, 0 to wait without one.
+    u64 timeout = 0;
+    Kernel::SharedPtr<Kernel::Event> wait_event;
+};
+
 /// Represents an abstract nvidia device node. It is to be subclassed by concrete device nodes to
 /// implement the ioctl interface.
 class nvdevice {
@@ -33,7 +74,18 @@ public:
      * @param output A buffer where the output data will be written to.
      * @returns The result code of the ioctl.
      */
-    virtual u32 ioctl(Ioctl command, const std::vector<u8>& input, std::vector<u8>& output) = 0;
+    virtual u32 ioctl(Ioctl command, IoctlInput input, IoctlOutput output) = 0;
+
+    /**
+     * Handles an ioctl request that may have to wait before it completes. Devices that never
+     * block don't need to override this.
+     * @param ctrl Wait state of the request. A device sets must_delay to be called again, with
+     * fresh_call cleared, once the wait is over. The result of a delayed call is ignored.
+     * @returns The result code of the ioctl.
+     */
+    virtual u32 ioctl(Ioctl command, IoctlInput input, IoctlOutput output, IoctlCtrl& ctrl) {
+        return ioctl(command, input, output);
+    }
 };
 
 } // namespace Service::Nvidia::Devices
@@ -7,12 +7,13 @@
 #include "core/core.h"
 #include "core/hle/service/nvdrv/devices/nvdisp_disp0.h"
 #include "core/hle/service/nvdrv/devices/nvmap.h"
+#include "core/tracer/gpu_recorder.h"
 #include "video_core/gpu.h"
 #include "video_core/renderer_base.h"
 
 namespace Service::Nvidia::Devices {
 
-u32 nvdisp_disp0::ioctl(Ioctl command, const std::vector<u8>& input, std::vector<u8>& output) {
+u32 nvdisp_disp0::ioctl(Ioctl command, IoctlInput input, IoctlOutput output) {
     UNIMPLEMENTED_MSG("Unimplemented ioctl");
     return 0;
 }
@@ -20,19 +21,34 @@ u32 nvdisp_disp0::ioctl(Ioctl command, const std::vector<u8>& input, std::vector
 void nvdisp_disp0::flip(u32 buffer_handle, u32 offset, u32 format, u32 width, u32 height,
                         u32 stride, NVFlinger::BufferQueue::BufferTransformFlags transform,
                         const MathUtil::Rectangle<int>& crop_rect) {
-    VAddr addr = nvmap_dev->GetObjectAddress(buffer_handle);
-    LOG_WARNING(Service,
-                "Drawing from address {:X} offset {:08X} Width {} Height {} Stride {} Format {}",
-                addr, offset, width, height, stride, format);
+    const auto object = nvmap_dev->GetObject(buffer_handle);
+    ASSERT(object);
+    LOG_TRACE(Service,
+              "Drawing from address {:X} offset {:08X} Width {} Height {} Stride {} Format {}",
+              object->addr, offset, width, height, stride, format);
+
+    // Buffers the application rendered to are mapped in the GPU address space, passing that
+    // address lets the renderer present the cached surface directly.
+    const Tegra::GPUVAddr gpu_addr = object->gpu_addr != 0 ? object->gpu_addr + offset : 0;
 
     using PixelFormat = Tegra::FramebufferConfig::PixelFormat;
-    const Tegra::FramebufferConfig framebuffer{
-        addr,      offset,   width, height, stride, static_cast<PixelFormat>(format),
-        transform, crop_rect};
+    const Tegra::FramebufferConfig framebuffer{object->addr,
+                                               offset,
+                                               gpu_addr,
+                                               width,
+                                               height,
+                                               stride,
+                                               static_cast<PixelFormat>(format),
+                                               transform,
+                                               crop_rect};
 
     auto& instance = Core::System::GetInstance();
+    if (auto* const recorder = instance.GetGPURecorder()) {
+        recorder->FramePresented(framebuffer);
+    }
     instance.perf_stats.EndGameFrame();
-    instance.Renderer().SwapBuffers(framebuffer);
+    instance.boot_timeline.FrameCompleted();
+    instance.GPU().SwapBuffers(framebuffer);
 }
 
 } // namespace Service::Nvidia::Devices
@@ -8,13 +8,12 @@
 #include "core/core.h"
 #include "core/hle/service/nvdrv/devices/nvhost_as_gpu.h"
 #include "core/hle/service/nvdrv/devices/nvmap.h"
+#include "video_core/gpu.h"
 #include "video_core/memory_manager.h"
-#include "video_core/rasterizer_interface.h"
-#include "video_core/renderer_base.h"
 
 namespace Service::Nvidia::Devices {
 
-u32 nvhost_as_gpu::ioctl(Ioctl command, const std::vector<u8>& input, std::vector<u8>& output) {
+u32 nvhost_as_gpu::ioctl(Ioctl command, IoctlInput input, IoctlOutput output) {
     LOG_DEBUG(Service_NVDRV, "called, command=0x{:08X}, input_size=0x{:X}, output_size=0x{:X}",
               command.raw, input.size(), output.size());
 
@@ -40,20 +39,22 @@ u32 nvhost_as_gpu::ioctl(Ioctl command, const std::vector<u8>& input, std::vecto
     return 0;
 }
 
-u32 nvhost_as_gpu::InitalizeEx(const std::vector<u8>& input, std::vector<u8>& output) {
+u32 nvhost_as_gpu::InitalizeEx(IoctlInput input, IoctlOutput output) {
     IoctlInitalizeEx params{};
     std::memcpy(&params, input.data(), input.size());
     LOG_WARNING(Service_NVDRV, "(STUBBED) called, big_page_size=0x{:X}", params.big_page_size);
     return 0;
 }
 
-u32 nvhost_as_gpu::AllocateSpace(const std::vector<u8>& input, std::vector<u8>& output) {
+u32 nvhost_as_gpu::AllocateSpace(IoctlInput input, IoctlOutput output) {
     IoctlAllocSpace params{};
     std::memcpy(&params, input.data(), input.size());
     LOG_DEBUG(Service_NVDRV, "called, pages={:X}, page_size={:X}, flags={:X}", params.pages,
               params.page_size, params.flags);
 
     auto& gpu = Core::System::GetInstance().GPU();
+    // The memory manager is shared with the GPU thread, which must not be using it meanwhile
+    gpu.WaitIdle();
     const u64 size{static_cast<u64>(params.pages) * static_cast<u64>(params.page_size)};
     if (params.flags & 1) {
         params.offset = gpu.memory_manager->AllocateSpace(params.offset, size, 1);
@@ -65,7 +66,7 @@ u32 nvhost_as_gpu::AllocateSpace(const std::vector<u8>& input, std::vector<u8>&
     return 0;
 }
 
-u32 nvhost_as_gpu::Remap(const std::vector<u8>& input, std::vector<u8>& output) {
+u32 nvhost_as_gpu::Remap(IoctlInput input, IoctlOutput output) {
     size_t num_entries = input.size() / sizeof(IoctlRemapEntry);
 
     LOG_WARNING(Service_NVDRV, "(STUBBED) called, num_entries=0x{:X}", num_entries);
@@ -74,6 +75,7 @@ u32 nvhost_as_gpu::Remap(const std::vector<u8>& input, std::vector<u8>& output)
     std::memcpy(entries.data(), input.data(), input.size());
 
     auto& gpu = Core::System::GetInstance().GPU();
+    gpu.WaitIdle();
 
     for (const auto& entry : entries) {
         LOG_WARNING(Service_NVDRV, "remap entry, offset=0x{:X} handle=0x{:X} pages=0x{:X}",
@@ -95,7 +97,7 @@ u32 nvhost_as_gpu::Remap(const std::vector<u8>& input, std::vector<u8>& output)
     return 0;
 }
 
-u32 nvhost_as_gpu::MapBufferEx(const std::vector<u8>& input, std::vector<u8>& output) {
+u32 nvhost_as_gpu::MapBufferEx(IoctlInput input, IoctlOutput output) {
     IoctlMapBufferEx params{};
     std::memcpy(&params, input.data(), input.size());
 
@@ -123,6 +125,7 @@ u32 nvhost_as_gpu::MapBufferEx(const std::vector<u8>& input, std::vector<u8>& ou
     ASSERT(object->id == params.nvmap_handle);
 
     auto& gpu = Core::System::GetInstance().GPU();
+    gpu.WaitIdle();
 
     if (params.flags & 1) {
         params.offset = gpu.memory_manager->MapBufferEx(object->addr, params.offset, object->size);
@@ -130,6 +133,11 @@ u32 nvhost_as_gpu::MapBufferEx(const std::vector<u8>& input, std::vector<u8>& ou
         params.offset = gpu.memory_manager->MapBufferEx(object->addr, object->size);
     }
 
+    // Surfaces can be registered at GPU addresses that were unmapped at the time, and the CPU
+    // pages behind the new mapping are not marked as cached, so Memory::MapPages never sees them.
+    // Drop whatever the rasterizer holds for the range, it now refers to different memory.
+    gpu.InvalidateRegion(params.offset, object->size);
+
     // Create a new mapping entry for this operation.
     ASSERT_MSG(buffer_mappings.find(params.offset) == buffer_mappings.end(),
                "Offset is already mapped");
@@ -141,11 +149,17 @@ u32 nvhost_as_gpu::MapBufferEx(const std::vector<u8>& input, std::vector<u8>& ou
 
     buffer_mappings[params.offset] = mapping;
 
+    // Remember where the object lives in the GPU's address space, so users of the handle (e.g. a
+    // display flip) don't have to translate its CPU address back.
+    if (object->gpu_addr == 0) {
+        object->gpu_addr = params.offset;
+    }
+
     std::memcpy(output.data(), &params, output.size());
     return 0;
 }
 
-u32 nvhost_as_gpu::UnmapBuffer(const std::vector<u8>& input, std::vector<u8>& output) {
+u32 nvhost_as_gpu::UnmapBuffer(IoctlInput input, IoctlOutput output) {
     IoctlUnmapBuffer params{};
     std::memcpy(&params, input.data(), input.size());
 
@@ -154,22 +168,27 @@ u32 nvhost_as_gpu::UnmapBuffer(const std::vector<u8>& input, std::vector<u8>& ou
     const auto itr = buffer_mappings.find(params.offset);
     ASSERT_MSG(itr != buffer_mappings.end(), "Tried to unmap invalid mapping");
 
-    auto& system_instance = Core::System::GetInstance();
+    auto& gpu = Core::System::GetInstance().GPU();
 
-    // Remove this memory region from the rasterizer cache.
-    system_instance.Renderer().Rasterizer().FlushAndInvalidateRegion(params.offset,
-                                                                     itr->second.size);
+    // Remove this memory region from the rasterizer cache. This waits for the work queued before
+    // it, the GPU thread is done with the memory manager afterwards.
+    gpu.FlushAndInvalidateRegion(params.offset, itr->second.size);
 
-    auto& gpu = system_instance.GPU();
     params.offset = gpu.memory_manager->UnmapBuffer(params.offset, itr->second.size);
 
+    if (auto object = nvmap_dev->GetObject(itr->second.nvmap_handle)) {
+        if (object->gpu_addr == itr->second.offset) {
+            object->gpu_addr = 0;
+        }
+    }
+
     buffer_mappings.erase(itr->second.offset);
 
     std::memcpy(output.data(), &params, output.size());
     return 0;
 }
 
-u32 nvhost_as_gpu::BindChannel(const std::vector<u8>& input, std::vector<u8>& output) {
+u32 nvhost_as_gpu::BindChannel(IoctlInput input, IoctlOutput output) {
     IoctlBindChannel params{};
     std::memcpy(&params, input.data(), input.size());
     LOG_DEBUG(Service_NVDRV, "called, fd={:X}", params.fd);
@@ -177,7 +196,7 @@ u32 nvhost_as_gpu::BindChannel(const std::vector<u8>& input, std::vector<u8>& ou
     return 0;
 }
 
-u32 nvhost_as_gpu::GetVARegions(const std::vector<u8>& input, std::vector<u8>& output) {
+u32 nvhost_as_gpu::GetVARegions(IoctlInput input, IoctlOutput output) {
     IoctlGetVaRegions params{};
     std::memcpy(&params, input.data(), input.size());
     LOG_WARNING(Service_NVDRV, "(STUBBED) called, buf_addr={:X}, buf_size={:X}", params.buf_addr,
@@ -21,7 +21,7 @@ public:
     explicit nvhost_as_gpu(std::shared_ptr<nvmap> nvmap_dev) : nvmap_dev(std::move(nvmap_dev)) {}
     ~nvhost_as_gpu() override = default;
 
-    u32 ioctl(Ioctl command, const std::vector<u8>& input, std::vector<u8>& output) override;
+    u32 ioctl(Ioctl command, IoctlInput input, IoctlOutput output) override;
 
 private:
     enum class IoctlCommand : u32_le {
@@ -116,13 +116,13 @@ private:
 
     u32 channel{};
 
-    u32 InitalizeEx(const std::vector<u8>& input, std::vector<u8>& output);
-    u32 AllocateSpace(const std::vector<u8>& input, std::vector<u8>& output);
-    u32 Remap(const std::vector<u8>& input, std::vector<u8>& output);
-    u32 MapBufferEx(const std::vector<u8>& input, std::vector<u8>& output);
-    u32 UnmapBuffer(const std::vector<u8>& input, std::vector<u8>& output);
-    u32 BindChannel(const std::vector<u8>& input, std::vector<u8>& output);
-    u32 GetVARegions(const std::vector<u8>& input, std::vector<u8>& output);
+    u32 InitalizeEx(IoctlInput input, IoctlOutput output);
+    u32 AllocateSpace(IoctlInput input, IoctlOutput output);
+    u32 Remap(IoctlInput input, IoctlOutput output);
+    u32 MapBufferEx(IoctlInput input, IoctlOutput output);
+    u32 UnmapBuffer(IoctlInput input, IoctlOutput output);
+    u32 BindChannel(IoctlInput input, IoctlOutput output);
+    u32 GetVARegions(IoctlInput input, IoctlOutput output);
 
     std::shared_ptr<nvmap> nvmap_dev;
 };
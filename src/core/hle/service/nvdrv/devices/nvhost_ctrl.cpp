@@ -8,20 +8,40 @@
 #include "common/assert.h"
 #include "common/logging/log.h"
 #include "core/hle/service/nvdrv/devices/nvhost_ctrl.h"
+#include "core/hle/service/nvdrv/syncpoint_manager.h"
+#include "video_core/gpu.h"
 
 namespace Service::Nvidia::Devices {
 
-u32 nvhost_ctrl::ioctl(Ioctl command, const std::vector<u8>& input, std::vector<u8>& output) {
+nvhost_ctrl::nvhost_ctrl(SyncpointManager& syncpoint_manager)
+    : syncpoint_manager(syncpoint_manager) {}
+
+nvhost_ctrl::~nvhost_ctrl() = default;
+
+u32 nvhost_ctrl::ioctl(Ioctl command, IoctlInput input, IoctlOutput output) {
+    IoctlCtrl ctrl{};
+    return ioctl(command, input, output, ctrl);
+}
+
+u32 nvhost_ctrl::ioctl(Ioctl command, IoctlInput input, IoctlOutput output, IoctlCtrl& ctrl) {
     LOG_DEBUG(Service_NVDRV, "called, command=0x{:08X}, input_size=0x{:X}, output_size=0x{:X}",
               command.raw, input.size(), output.size());
 
     switch (static_cast<IoctlCommand>(command.raw)) {
     case IoctlCommand::IocGetConfigCommand:
         return NvOsGetConfigU32(input, output);
+    case IoctlCommand::IocSyncptReadCommand:
+        return IocSyncptRead(input, output, false);
+    case IoctlCommand::IocSyncptReadMaxCommand:
+        return IocSyncptRead(input, output, true);
+    case IoctlCommand::IocSyncptIncrCommand:
+        return IocSyncptIncr(input, output);
+    case IoctlCommand::IocSyncptWaitCommand:
+        return IocSyncptWait(input, output, ctrl);
     case IoctlCommand::IocCtrlEventWaitCommand:
-        return IocCtrlEventWait(input, output, false);
+        return IocCtrlEventWait(input, output, false, ctrl);
     case IoctlCommand::IocCtrlEventWaitAsyncCommand:
-        return IocCtrlEventWait(input, output, true);
+        return IocCtrlEventWait(input, output, true, ctrl);
     case IoctlCommand::IocCtrlEventRegisterCommand:
         return IocCtrlEventRegister(input, output);
     }
@@ -29,7 +49,7 @@ u32 nvhost_ctrl::ioctl(Ioctl command, const std::vector<u8>& input, std::vector<
     return 0;
 }
 
-u32 nvhost_ctrl::NvOsGetConfigU32(const std::vector<u8>& input, std::vector<u8>& output) {
+u32 nvhost_ctrl::NvOsGetConfigU32(IoctlInput input, IoctlOutput output) {
     IocGetConfigParams params{};
     std::memcpy(&params, input.data(), sizeof(params));
     LOG_TRACE(Service_NVDRV, "called, setting={}!{}", params.domain_str.data(),
@@ -37,21 +57,88 @@ u32 nvhost_ctrl::NvOsGetConfigU32(const std::vector<u8>& input, std::vector<u8>&
     return 0x30006; // Returns error on production mode
 }
 
-u32 nvhost_ctrl::IocCtrlEventWait(const std::vector<u8>& input, std::vector<u8>& output,
-                                  bool is_async) {
-    IocCtrlEventWaitParams params{};
+u32 nvhost_ctrl::IocSyncptRead(IoctlInput input, IoctlOutput output,
+                               bool read_max) {
+    IocSyncptReadParams params{};
     std::memcpy(&params, input.data(), sizeof(params));
-    LOG_WARNING(Service_NVDRV,
-                "(STUBBED) called, syncpt_id={}, threshold={}, timeout={}, is_async={}",
-                params.syncpt_id, params.threshold, params.timeout, is_async);
+    LOG_DEBUG(Service_NVDRV, "called, id={}, read_max={}", params.id, read_max);
 
-    // TODO(Subv): Implement actual syncpt waiting.
-    params.value = 0;
+    if (params.id >= Tegra::GPU::NumSyncPoints) {
+        return BadParameter;
+    }
+    params.value = read_max ? syncpoint_manager.GetSyncpointMax(params.id)
+                            : syncpoint_manager.GetSyncpointMin(params.id);
     std::memcpy(output.data(), &params, sizeof(params));
     return 0;
 }
 
-u32 nvhost_ctrl::IocCtrlEventRegister(const std::vector<u8>& input, std::vector<u8>& output) {
+u32 nvhost_ctrl::IocSyncptIncr(IoctlInput input, IoctlOutput output) {
+    IocSyncptIncrParams params{};
+    std::memcpy(&params, input.data(), sizeof(params));
+    LOG_DEBUG(Service_NVDRV, "called, id={}", params.id);
+
+    if (params.id >= Tegra::GPU::NumSyncPoints) {
+        return BadParameter;
+    }
+    // An increment from the CPU completes immediately, so both ends of the syncpoint move.
+    syncpoint_manager.IncreaseSyncpointMaxValue(params.id, 1);
+    syncpoint_manager.IncrementSyncpoint(params.id);
+    return 0;
+}
+
+u32 nvhost_ctrl::WaitSyncpoint(u32 syncpoint_id, u32 threshold, s32 timeout, IoctlCtrl& ctrl) {
+    if (syncpoint_manager.IsSyncpointExpired(syncpoint_id, threshold)) {
+        return 0;
+    }
+    if (timeout == 0 || ctrl.timed_out) {
+        return Timeout;
+    }
+
+    // Another guest thread has to move the syncpoint, by submitting work or by incrementing it
+    // from the CPU. Every increment wakes the caller up to check the threshold again, each time
+    // with the whole timeout as the syncpoint only moves forward.
+    ctrl.must_delay = true;
+    ctrl.timeout = timeout < 0 ? 0 : static_cast<u64>(timeout) * 1000000;
+    ctrl.wait_event = syncpoint_manager.GetSyncpointEvent(syncpoint_id);
+    return 0;
+}
+
+u32 nvhost_ctrl::IocSyncptWait(IoctlInput input, IoctlOutput output, IoctlCtrl& ctrl) {
+    IocSyncptWaitParams params{};
+    std::memcpy(&params, input.data(), sizeof(params));
+    LOG_DEBUG(Service_NVDRV, "called, id={}, threshold={}, timeout={}", params.id, params.thresh,
+              params.timeout);
+
+    if (params.id >= Tegra::GPU::NumSyncPoints) {
+        return BadParameter;
+    }
+    return WaitSyncpoint(params.id, params.thresh, params.timeout, ctrl);
+}
+
+u32 nvhost_ctrl::IocCtrlEventWait(IoctlInput input, IoctlOutput output, bool is_async,
+                                  IoctlCtrl& ctrl) {
+    IocCtrlEventWaitParams params{};
+    std::memcpy(&params, input.data(), sizeof(params));
+    LOG_DEBUG(Service_NVDRV, "called, syncpt_id={}, threshold={}, timeout={}, is_async={}",
+              params.syncpt_id, params.threshold, params.timeout, is_async);
+
+    if (params.syncpt_id >= Tegra::GPU::NumSyncPoints) {
+        return BadParameter;
+    }
+
+    // The async variant signals a user event instead of blocking, but QueryEvent doesn't hand
+    // those out yet, so both variants block the caller until the syncpoint is reached.
+    const u32 result = WaitSyncpoint(params.syncpt_id, params.threshold, params.timeout, ctrl);
+    if (ctrl.must_delay) {
+        return result;
+    }
+
+    params.value = syncpoint_manager.GetSyncpointMin(params.syncpt_id);
+    std::memcpy(output.data(), &params, sizeof(params));
+    return result;
+}
+
+u32 nvhost_ctrl::IocCtrlEventRegister(IoctlInput input, IoctlOutput output) {
     LOG_WARNING(Service_NVDRV, "(STUBBED) called");
     // TODO(bunnei): Implement this.
     return 0;
@@ -9,16 +9,27 @@
 #include "common/common_types.h"
 #include "core/hle/service/nvdrv/devices/nvdevice.h"
 
+namespace Service::Nvidia {
+class SyncpointManager;
+}
+
 namespace Service::Nvidia::Devices {
 
 class nvhost_ctrl final : public nvdevice {
 public:
-    nvhost_ctrl() = default;
-    ~nvhost_ctrl() override = default;
+    explicit nvhost_ctrl(SyncpointManager& syncpoint_manager);
+    ~nvhost_ctrl() override;
 
-    u32 ioctl(Ioctl command, const std::vector<u8>& input, std::vector<u8>& output) override;
+    u32 ioctl(Ioctl command, IoctlInput input, IoctlOutput output) override;
+    u32 ioctl(Ioctl command, IoctlInput input, IoctlOutput output, IoctlCtrl& ctrl) override;
 
 private:
+    /// Error codes returned by the syncpoint ioctls.
+    enum : u32 {
+        BadParameter = 0x4,
+        Timeout = 0x5,
+    };
+
     enum class IoctlCommand : u32_le {
         IocSyncptReadCommand = 0xC0080014,
         IocSyncptIncrCommand = 0x40040015,
@@ -130,11 +141,28 @@ private:
     };
     static_assert(sizeof(IocCtrlEventKill) == 8, "IocCtrlEventKill is incorrect size");
 
-    u32 NvOsGetConfigU32(const std::vector<u8>& input, std::vector<u8>& output);
+    u32 NvOsGetConfigU32(IoctlInput input, IoctlOutput output);
+
+    u32 IocSyncptRead(IoctlInput input, IoctlOutput output, bool read_max);
+
+    u32 IocSyncptIncr(IoctlInput input, IoctlOutput output);
+
+    u32 IocSyncptWait(IoctlInput input, IoctlOutput output, IoctlCtrl& ctrl);
+
+    u32 IocCtrlEventWait(IoctlInput input, IoctlOutput output, bool is_async, IoctlCtrl& ctrl);
+
+    /**
+     * Waits until a syncpoint reaches the threshold, by asking for the ioctl to be issued again
+     * whenever the syncpoint is incremented.
+     * @param timeout Timeout of the wait in milliseconds, negative to wait without one.
+     * @returns 0 once the syncpoint has reached the threshold (or while the ioctl is delayed),
+     * Timeout once the timeout expired.
+     */
+    u32 WaitSyncpoint(u32 syncpoint_id, u32 threshold, s32 timeout, IoctlCtrl& ctrl);
 
-    u32 IocCtrlEventWait(const std::vector<u8>& input, std::vector<u8>& output, bool is_async);
+    u32 IocCtrlEventRegister(IoctlInput input, IoctlOutput output);
 
-    u32 IocCtrlEventRegister(const std::vector<u8>& input, std::vector<u8>& output);
+    SyncpointManager& syncpoint_manager;
 };
 
 } // namespace Service::Nvidia::Devices
@@ -3,17 +3,27 @@
 // Refer to the license.txt file included.
 
 #include <cstring>
+#include <utility>
+#include <vector>
 #include "common/assert.h"
 #include "common/logging/log.h"
 #include "core/core.h"
 #include "core/hle/service/nvdrv/devices/nvhost_gpu.h"
+#include "core/hle/service/nvdrv/syncpoint_manager.h"
 #include "core/memory.h"
+#include "core/tracer/gpu_recorder.h"
 #include "video_core/gpu.h"
 #include "video_core/memory_manager.h"
 
 namespace Service::Nvidia::Devices {
 
-u32 nvhost_gpu::ioctl(Ioctl command, const std::vector<u8>& input, std::vector<u8>& output) {
+nvhost_gpu::nvhost_gpu(std::shared_ptr<nvmap> nvmap_dev, SyncpointManager& syncpoint_manager)
+    : nvmap_dev(std::move(nvmap_dev)), syncpoint_manager(syncpoint_manager),
+      channel_syncpoint(syncpoint_manager.AllocateSyncpoint()) {}
+
+nvhost_gpu::~nvhost_gpu() = default;
+
+u32 nvhost_gpu::ioctl(Ioctl command, IoctlInput input, IoctlOutput output) {
     LOG_DEBUG(Service_NVDRV, "called, command=0x{:08X}, input_size=0x{:X}, output_size=0x{:X}",
               command.raw, input.size(), output.size());
 
@@ -53,7 +63,7 @@ u32 nvhost_gpu::ioctl(Ioctl command, const std::vector<u8>& input, std::vector<u
     return 0;
 };
 
-u32 nvhost_gpu::SetNVMAPfd(const std::vector<u8>& input, std::vector<u8>& output) {
+u32 nvhost_gpu::SetNVMAPfd(IoctlInput input, IoctlOutput output) {
     IoctlSetNvmapFD params{};
     std::memcpy(&params, input.data(), input.size());
     LOG_DEBUG(Service_NVDRV, "called, fd={}", params.nvmap_fd);
@@ -61,7 +71,7 @@ u32 nvhost_gpu::SetNVMAPfd(const std::vector<u8>& input, std::vector<u8>& output
     return 0;
 }
 
-u32 nvhost_gpu::SetClientData(const std::vector<u8>& input, std::vector<u8>& output) {
+u32 nvhost_gpu::SetClientData(IoctlInput input, IoctlOutput output) {
     LOG_DEBUG(Service_NVDRV, "called");
     IoctlClientData params{};
     std::memcpy(&params, input.data(), input.size());
@@ -69,7 +79,7 @@ u32 nvhost_gpu::SetClientData(const std::vector<u8>& input, std::vector<u8>& out
     return 0;
 }
 
-u32 nvhost_gpu::GetClientData(const std::vector<u8>& input, std::vector<u8>& output) {
+u32 nvhost_gpu::GetClientData(IoctlInput input, IoctlOutput output) {
     LOG_DEBUG(Service_NVDRV, "called");
     IoctlClientData params{};
     std::memcpy(&params, input.data(), input.size());
@@ -78,7 +88,7 @@ u32 nvhost_gpu::GetClientData(const std::vector<u8>& input, std::vector<u8>& out
     return 0;
 }
 
-u32 nvhost_gpu::ZCullBind(const std::vector<u8>& input, std::vector<u8>& output) {
+u32 nvhost_gpu::ZCullBind(IoctlInput input, IoctlOutput output) {
     std::memcpy(&zcull_params, input.data(), input.size());
     LOG_DEBUG(Service_NVDRV, "called, gpu_va={:X}, mode={:X}", zcull_params.gpu_va,
               zcull_params.mode);
@@ -86,7 +96,7 @@ u32 nvhost_gpu::ZCullBind(const std::vector<u8>& input, std::vector<u8>& output)
     return 0;
 }
 
-u32 nvhost_gpu::SetErrorNotifier(const std::vector<u8>& input, std::vector<u8>& output) {
+u32 nvhost_gpu::SetErrorNotifier(IoctlInput input, IoctlOutput output) {
     IoctlSetErrorNotifier params{};
     std::memcpy(&params, input.data(), input.size());
     LOG_WARNING(Service_NVDRV, "(STUBBED) called, offset={:X}, size={:X}, mem={:X}", params.offset,
@@ -95,13 +105,13 @@ u32 nvhost_gpu::SetErrorNotifier(const std::vector<u8>& input, std::vector<u8>&
     return 0;
 }
 
-u32 nvhost_gpu::SetChannelPriority(const std::vector<u8>& input, std::vector<u8>& output) {
+u32 nvhost_gpu::SetChannelPriority(IoctlInput input, IoctlOutput output) {
     std::memcpy(&channel_priority, input.data(), input.size());
     LOG_DEBUG(Service_NVDRV, "(STUBBED) called, priority={:X}", channel_priority);
     return 0;
 }
 
-u32 nvhost_gpu::AllocGPFIFOEx2(const std::vector<u8>& input, std::vector<u8>& output) {
+u32 nvhost_gpu::AllocGPFIFOEx2(IoctlInput input, IoctlOutput output) {
     IoctlAllocGpfifoEx2 params{};
     std::memcpy(&params, input.data(), input.size());
     LOG_WARNING(Service_NVDRV,
@@ -109,13 +119,13 @@ u32 nvhost_gpu::AllocGPFIFOEx2(const std::vector<u8>& input, std::vector<u8>& ou
                 "unk1={:X}, unk2={:X}, unk3={:X}",
                 params.num_entries, params.flags, params.unk0, params.unk1, params.unk2,
                 params.unk3);
-    params.fence_out.id = 0;
-    params.fence_out.value = 0;
+    params.fence_out.id = channel_syncpoint;
+    params.fence_out.value = syncpoint_manager.GetSyncpointMax(channel_syncpoint);
     std::memcpy(output.data(), &params, output.size());
     return 0;
 }
 
-u32 nvhost_gpu::AllocateObjectContext(const std::vector<u8>& input, std::vector<u8>& output) {
+u32 nvhost_gpu::AllocateObjectContext(IoctlInput input, IoctlOutput output) {
     IoctlAllocObjCtx params{};
     std::memcpy(&params, input.data(), input.size());
     LOG_WARNING(Service_NVDRV, "(STUBBED) called, class_num={:X}, flags={:X}", params.class_num,
@@ -125,56 +135,82 @@ u32 nvhost_gpu::AllocateObjectContext(const std::vector<u8>& input, std::vector<
     return 0;
 }
 
-u32 nvhost_gpu::SubmitGPFIFO(const std::vector<u8>& input, std::vector<u8>& output) {
+u32 nvhost_gpu::SubmitGPFIFO(IoctlInput input, IoctlOutput output) {
     if (input.size() < sizeof(IoctlSubmitGpfifo)) {
         UNIMPLEMENTED();
     }
     IoctlSubmitGpfifo params{};
     std::memcpy(&params, input.data(), sizeof(IoctlSubmitGpfifo));
-    LOG_WARNING(Service_NVDRV, "(STUBBED) called, gpfifo={:X}, num_entries={:X}, flags={:X}",
-                params.address, params.num_entries, params.flags);
+    LOG_TRACE(Service_NVDRV, "called, gpfifo={:X}, num_entries={:X}, flags={:X}", params.address,
+              params.num_entries, params.flags.raw);
 
     ASSERT_MSG(input.size() ==
                    sizeof(IoctlSubmitGpfifo) + params.num_entries * sizeof(IoctlGpfifoEntry),
                "Incorrect input size");
 
-    std::vector<IoctlGpfifoEntry> entries(params.num_entries);
-    std::memcpy(entries.data(), &input[sizeof(IoctlSubmitGpfifo)],
-                params.num_entries * sizeof(IoctlGpfifoEntry));
-    for (auto entry : entries) {
-        Tegra::GPUVAddr va_addr = entry.Address();
-        Core::System::GetInstance().GPU().ProcessCommandList(va_addr, entry.sz);
-    }
-    params.fence_out.id = 0;
-    params.fence_out.value = 0;
+    // The entries are processed straight out of the ioctl input, without copying them first
+    PushGPFIFOEntries(params, input.data() + sizeof(IoctlSubmitGpfifo));
     std::memcpy(output.data(), &params, sizeof(IoctlSubmitGpfifo));
     return 0;
 }
 
-u32 nvhost_gpu::KickoffPB(const std::vector<u8>& input, std::vector<u8>& output) {
+u32 nvhost_gpu::KickoffPB(IoctlInput input, IoctlOutput output) {
     if (input.size() < sizeof(IoctlSubmitGpfifo)) {
         UNIMPLEMENTED();
     }
     IoctlSubmitGpfifo params{};
     std::memcpy(&params, input.data(), sizeof(IoctlSubmitGpfifo));
-    LOG_WARNING(Service_NVDRV, "(STUBBED) called, gpfifo={:X}, num_entries={:X}, flags={:X}",
-                params.address, params.num_entries, params.flags);
+    LOG_TRACE(Service_NVDRV, "called, gpfifo={:X}, num_entries={:X}, flags={:X}", params.address,
+              params.num_entries, params.flags.raw);
 
     std::vector<IoctlGpfifoEntry> entries(params.num_entries);
     Memory::ReadBlock(params.address, entries.data(),
                       params.num_entries * sizeof(IoctlGpfifoEntry));
 
-    for (auto entry : entries) {
-        Tegra::GPUVAddr va_addr = entry.Address();
-        Core::System::GetInstance().GPU().ProcessCommandList(va_addr, entry.sz);
-    }
-    params.fence_out.id = 0;
-    params.fence_out.value = 0;
+    PushGPFIFOEntries(params, reinterpret_cast<const u8*>(entries.data()));
     std::memcpy(output.data(), &params, output.size());
     return 0;
 }
 
-u32 nvhost_gpu::GetWaitbase(const std::vector<u8>& input, std::vector<u8>& output) {
+void nvhost_gpu::PushGPFIFOEntries(IoctlSubmitGpfifo& params, const u8* entry_data) {
+    auto& system = Core::System::GetInstance();
+    auto& gpu = system.GPU();
+
+    if (params.flags.fence_wait && params.fence_out.id < Tegra::GPU::NumSyncPoints &&
+        static_cast<s32>(params.fence_out.value -
+                         syncpoint_manager.GetSyncpointMax(params.fence_out.id)) > 0) {
+        // The GPU processes submissions in order, so it reaches the fences of the earlier ones
+        // before these command lists. A fence past the maximum is never going to be signalled.
+        LOG_WARNING(Service_NVDRV, "Submission waits on unsignalled fence, id={}, value={}",
+                    params.fence_out.id, params.fence_out.value);
+    }
+
+    auto* const recorder = system.GetGPURecorder();
+    if (recorder != nullptr) {
+        recorder->BeginSubmission();
+    }
+
+    std::vector<Tegra::CommandList> command_lists(params.num_entries);
+    for (u32 i = 0; i < params.num_entries; ++i) {
+        IoctlGpfifoEntry entry;
+        std::memcpy(&entry, entry_data + i * sizeof(IoctlGpfifoEntry), sizeof(IoctlGpfifoEntry));
+        if (recorder != nullptr) {
+            recorder->CommandListSubmitted(entry.Address(), entry.sz);
+        }
+        command_lists[i] = {entry.Address(), entry.sz};
+    }
+
+    // Every submission advances the channel syncpoint, the GPU signals it once the submitted
+    // command lists have been processed.
+    params.fence_out.id = channel_syncpoint;
+    params.fence_out.value = syncpoint_manager.IncreaseSyncpointMaxValue(channel_syncpoint, 1);
+    gpu.PushCommandLists(std::move(command_lists),
+                         [&syncpoint_manager = syncpoint_manager, id = channel_syncpoint] {
+                             syncpoint_manager.IncrementSyncpoint(id);
+                         });
+}
+
+u32 nvhost_gpu::GetWaitbase(IoctlInput input, IoctlOutput output) {
     IoctlGetWaitbase params{};
     std::memcpy(&params, input.data(), sizeof(IoctlGetWaitbase));
     LOG_INFO(Service_NVDRV, "called, unknown=0x{:X}", params.unknown);
@@ -183,7 +219,7 @@ u32 nvhost_gpu::GetWaitbase(const std::vector<u8>& input, std::vector<u8>& outpu
     return 0;
 }
 
-u32 nvhost_gpu::ChannelSetTimeout(const std::vector<u8>& input, std::vector<u8>& output) {
+u32 nvhost_gpu::ChannelSetTimeout(IoctlInput input, IoctlOutput output) {
     IoctlChannelSetTimeout params{};
     std::memcpy(&params, input.data(), sizeof(IoctlChannelSetTimeout));
     LOG_INFO(Service_NVDRV, "called, timeout=0x{:X}", params.timeout);
@@ -11,6 +11,10 @@
 #include "common/swap.h"
 #include "core/hle/service/nvdrv/devices/nvdevice.h"
 
+namespace Service::Nvidia {
+class SyncpointManager;
+}
+
 namespace Service::Nvidia::Devices {
 
 class nvmap;
@@ -20,10 +24,10 @@ constexpr u32 NVGPU_IOCTL_CHANNEL_KICKOFF_PB(0x1b);
 
 class nvhost_gpu final : public nvdevice {
 public:
-    explicit nvhost_gpu(std::shared_ptr<nvmap> nvmap_dev) : nvmap_dev(std::move(nvmap_dev)) {}
-    ~nvhost_gpu() override = default;
+    nvhost_gpu(std::shared_ptr<nvmap> nvmap_dev, SyncpointManager& syncpoint_manager);
+    ~nvhost_gpu() override;
 
-    u32 ioctl(Ioctl command, const std::vector<u8>& input, std::vector<u8>& output) override;
+    u32 ioctl(Ioctl command, IoctlInput input, IoctlOutput output) override;
 
 private:
     enum class IoctlCommand : u32_le {
@@ -169,8 +173,14 @@ private:
     struct IoctlSubmitGpfifo {
         u64_le address;     // pointer to gpfifo entry structs
         u32_le num_entries; // number of fence objects being submitted
-        u32_le flags;
-        IoctlFence fence_out; // returned new fence object for others to wait on
+        union {
+            u32_le raw;
+            BitField<0, 1, u32_le> fence_wait;      // wait on the fence in fence_out first
+            BitField<1, 1, u32_le> fence_increment; // return a fence for this submission
+            BitField<2, 1, u32_le> new_hw_format;
+            BitField<4, 1, u32_le> suppress_wfi;
+        } flags;
+        IoctlFence fence_out; // in: fence to wait on, out: new fence object for others to wait on
     };
     static_assert(sizeof(IoctlSubmitGpfifo) == 16 + sizeof(IoctlFence),
                   "IoctlSubmitGpfifo is incorrect size");
@@ -186,20 +196,32 @@ private:
     IoctlZCullBind zcull_params{};
     u32_le channel_priority{};
 
-    u32 SetNVMAPfd(const std::vector<u8>& input, std::vector<u8>& output);
-    u32 SetClientData(const std::vector<u8>& input, std::vector<u8>& output);
-    u32 GetClientData(const std::vector<u8>& input, std::vector<u8>& output);
-    u32 ZCullBind(const std::vector<u8>& input, std::vector<u8>& output);
-    u32 SetErrorNotifier(const std::vector<u8>& input, std::vector<u8>& output);
-    u32 SetChannelPriority(const std::vector<u8>& input, std::vector<u8>& output);
-    u32 AllocGPFIFOEx2(const std::vector<u8>& input, std::vector<u8>& output);
-    u32 AllocateObjectContext(const std::vector<u8>& input, std::vector<u8>& output);
-    u32 SubmitGPFIFO(const std::vector<u8>& input, std::vector<u8>& output);
-    u32 KickoffPB(const std::vector<u8>& input, std::vector<u8>& output);
-    u32 GetWaitbase(const std::vector<u8>& input, std::vector<u8>& output);
-    u32 ChannelSetTimeout(const std::vector<u8>& input, std::vector<u8>& output);
+    u32 SetNVMAPfd(IoctlInput input, IoctlOutput output);
+    u32 SetClientData(IoctlInput input, IoctlOutput output);
+    u32 GetClientData(IoctlInput input, IoctlOutput output);
+    u32 ZCullBind(IoctlInput input, IoctlOutput output);
+    u32 SetErrorNotifier(IoctlInput input, IoctlOutput output);
+    u32 SetChannelPriority(IoctlInput input, IoctlOutput output);
+    u32 AllocGPFIFOEx2(IoctlInput input, IoctlOutput output);
+    u32 AllocateObjectContext(IoctlInput input, IoctlOutput output);
+    u32 SubmitGPFIFO(IoctlInput input, IoctlOutput output);
+    u32 KickoffPB(IoctlInput input, IoctlOutput output);
+    u32 GetWaitbase(IoctlInput input, IoctlOutput output);
+    u32 ChannelSetTimeout(IoctlInput input, IoctlOutput output);
+
+    /**
+     * Hands the GPFIFO entries of a submission to the GPU and fills in the fence that is signalled
+     * once they complete.
+     * @param params Submission parameters, fence_out is written to.
+     * @param entry_data Pointer to params.num_entries consecutive GPFIFO entries.
+     */
+    void PushGPFIFOEntries(IoctlSubmitGpfifo& params, const u8* entry_data);
 
     std::shared_ptr<nvmap> nvmap_dev;
+    SyncpointManager& syncpoint_manager;
+
+    /// Syncpoint incremented once per submission made on this channel.
+    u32 channel_syncpoint;
 };
 
 } // namespace Service::Nvidia::Devices
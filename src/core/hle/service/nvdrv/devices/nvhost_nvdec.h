@@ -16,7 +16,7 @@ public:
     nvhost_nvdec() = default;
     ~nvhost_nvdec() override = default;
 
-    u32 ioctl(Ioctl command, const std::vector<u8>& input, std::vector<u8>& output) override;
+    u32 ioctl(Ioctl command, IoctlInput input, IoctlOutput output) override;
 
 private:
     enum class IoctlCommand : u32_le {
@@ -30,7 +30,7 @@ private:
 
     u32_le nvmap_fd{};
 
-    u32 SetNVMAPfd(const std::vector<u8>& input, std::vector<u8>& output);
+    u32 SetNVMAPfd(IoctlInput input, IoctlOutput output);
 };
 
 } // namespace Service::Nvidia::Devices
@@ -4,6 +4,7 @@
 
 #include <algorithm>
 #include <cstring>
+#include <iterator>
 
 #include "common/assert.h"
 #include "common/logging/log.h"
@@ -18,7 +19,7 @@ VAddr nvmap::GetObjectAddress(u32 handle) const {
     return object->addr;
 }
 
-u32 nvmap::ioctl(Ioctl command, const std::vector<u8>& input, std::vector<u8>& output) {
+u32 nvmap::ioctl(Ioctl command, IoctlInput input, IoctlOutput output) {
     switch (static_cast<IoctlCommand>(command.raw)) {
     case IoctlCommand::Create:
         return IocCreate(input, output);
@@ -38,7 +39,24 @@ u32 nvmap::ioctl(Ioctl command, const std::vector<u8>& input, std::vector<u8>& o
     return 0;
 }
 
-u32 nvmap::IocCreate(const std::vector<u8>& input, std::vector<u8>& output) {
+u32 nvmap::CreateHandle(std::shared_ptr<Object> object) {
+    if (free_handles.empty()) {
+        handles.push_back(std::move(object));
+        return static_cast<u32>(handles.size());
+    }
+
+    const u32 handle = free_handles.back();
+    free_handles.pop_back();
+    handles[handle - 1] = std::move(object);
+    return handle;
+}
+
+void nvmap::FreeHandle(u32 handle) {
+    handles[handle - 1] = nullptr;
+    free_handles.push_back(handle);
+}
+
+u32 nvmap::IocCreate(IoctlInput input, IoctlOutput output) {
     IocCreateParams params;
     std::memcpy(&params, input.data(), sizeof(params));
 
@@ -49,8 +67,7 @@ u32 nvmap::IocCreate(const std::vector<u8>& input, std::vector<u8>& output) {
     object->status = Object::Status::Created;
     object->refcount = 1;
 
-    u32 handle = next_handle++;
-    handles[handle] = std::move(object);
+    const u32 handle = CreateHandle(std::move(object));
 
     LOG_DEBUG(Service_NVDRV, "size=0x{:08X}", params.size);
 
@@ -60,7 +77,7 @@ u32 nvmap::IocCreate(const std::vector<u8>& input, std::vector<u8>& output) {
     return 0;
 }
 
-u32 nvmap::IocAlloc(const std::vector<u8>& input, std::vector<u8>& output) {
+u32 nvmap::IocAlloc(IoctlInput input, IoctlOutput output) {
     IocAllocParams params;
     std::memcpy(&params, input.data(), sizeof(params));
 
@@ -79,7 +96,7 @@ u32 nvmap::IocAlloc(const std::vector<u8>& input, std::vector<u8>& output) {
     return 0;
 }
 
-u32 nvmap::IocGetId(const std::vector<u8>& input, std::vector<u8>& output) {
+u32 nvmap::IocGetId(IoctlInput input, IoctlOutput output) {
     IocGetIdParams params;
     std::memcpy(&params, input.data(), sizeof(params));
 
@@ -94,26 +111,27 @@ u32 nvmap::IocGetId(const std::vector<u8>& input, std::vector<u8>& output) {
     return 0;
 }
 
-u32 nvmap::IocFromId(const std::vector<u8>& input, std::vector<u8>& output) {
+u32 nvmap::IocFromId(IoctlInput input, IoctlOutput output) {
     IocFromIdParams params;
     std::memcpy(&params, input.data(), sizeof(params));
 
     LOG_WARNING(Service_NVDRV, "(STUBBED) called");
 
-    auto itr = std::find_if(handles.begin(), handles.end(),
-                            [&](const auto& entry) { return entry.second->id == params.id; });
+    auto itr = std::find_if(handles.begin(), handles.end(), [&](const auto& object) {
+        return object != nullptr && object->id == params.id;
+    });
     ASSERT(itr != handles.end());
 
-    itr->second->refcount++;
+    (*itr)->refcount++;
 
     // Return the existing handle instead of creating a new one.
-    params.handle = itr->first;
+    params.handle = static_cast<u32>(std::distance(handles.begin(), itr)) + 1;
 
     std::memcpy(output.data(), &params, sizeof(params));
     return 0;
 }
 
-u32 nvmap::IocParam(const std::vector<u8>& input, std::vector<u8>& output) {
+u32 nvmap::IocParam(IoctlInput input, IoctlOutput output) {
     enum class ParamTypes { Size = 1, Alignment = 2, Base = 3, Heap = 4, Kind = 5, Compr = 6 };
 
     IocParamParams params;
@@ -147,7 +165,7 @@ u32 nvmap::IocParam(const std::vector<u8>& input, std::vector<u8>& output) {
     return 0;
 }
 
-u32 nvmap::IocFree(const std::vector<u8>& input, std::vector<u8>& output) {
+u32 nvmap::IocFree(IoctlInput input, IoctlOutput output) {
     // TODO(Subv): These flags are unconfirmed.
     enum FreeFlags {
         Freed = 0,
@@ -159,26 +177,26 @@ u32 nvmap::IocFree(const std::vector<u8>& input, std::vector<u8>& output) {
 
     LOG_WARNING(Service_NVDRV, "(STUBBED) called");
 
-    auto itr = handles.find(params.handle);
-    ASSERT(itr != handles.end());
+    const auto object = GetObject(params.handle);
+    ASSERT(object);
 
-    ASSERT(itr->second->refcount > 0);
+    ASSERT(object->refcount > 0);
 
-    itr->second->refcount--;
+    object->refcount--;
 
-    params.size = itr->second->size;
+    params.size = object->size;
 
-    if (itr->second->refcount == 0) {
+    if (object->refcount == 0) {
         params.flags = Freed;
         // The address of the nvmap is written to the output if we're finally freeing it, otherwise
         // 0 is written.
-        params.address = itr->second->addr;
+        params.address = object->addr;
     } else {
         params.flags = NotFreedYet;
         params.address = 0;
     }
 
-    handles.erase(params.handle);
+    FreeHandle(params.handle);
 
     std::memcpy(output.data(), &params, sizeof(params));
     return 0;
@@ -5,7 +5,6 @@
 #pragma once
 
 #include <memory>
-#include <unordered_map>
 #include <vector>
 #include "common/common_funcs.h"
 #include "common/common_types.h"
@@ -22,7 +21,7 @@ public:
     /// Returns the allocated address of an nvmap object given its handle.
     VAddr GetObjectAddress(u32 handle) const;
 
-    u32 ioctl(Ioctl command, const std::vector<u8>& input, std::vector<u8>& output) override;
+    u32 ioctl(Ioctl command, IoctlInput input, IoctlOutput output) override;
 
     /// Represents an nvmap object.
     struct Object {
@@ -33,27 +32,35 @@ public:
         u32 align;
         u8 kind;
         VAddr addr;
+        /// GPU virtual address the whole object is mapped at, 0 if it isn't mapped
+        u64 gpu_addr;
         Status status;
         u32 refcount;
     };
 
     std::shared_ptr<Object> GetObject(u32 handle) const {
-        auto itr = handles.find(handle);
-        if (itr != handles.end()) {
-            return itr->second;
+        if (handle == 0 || handle > handles.size()) {
+            return {};
         }
-        return {};
+        return handles[handle - 1];
     }
 
 private:
-    /// Id to use for the next handle that is created.
-    u32 next_handle = 1;
+    /// Creates a handle to the object, reusing the slot of a freed handle if there is one.
+    u32 CreateHandle(std::shared_ptr<Object> object);
+
+    /// Frees the handle so that its slot can be reused.
+    void FreeHandle(u32 handle);
 
     /// Id to use for the next object that is created.
     u32 next_id = 1;
 
-    /// Mapping of currently allocated handles to the objects they represent.
-    std::unordered_map<u32, std::shared_ptr<Object>> handles;
+    /// Objects indexed by their handle minus one, freed handles hold null. Handles are looked up
+    /// on every GPU mapping and display flip, so they index the table directly.
+    std::vector<std::shared_ptr<Object>> handles;
+
+    /// Handles that were freed and can be handed out again.
+    std::vector<u32> free_handles;
 
     enum class IoctlCommand : u32 {
         Create = 0xC0080101,
@@ -117,12 +124,12 @@ private:
     };
     static_assert(sizeof(IocGetIdParams) == 8, "IocGetIdParams has wrong size");
 
-    u32 IocCreate(const std::vector<u8>& input, std::vector<u8>& output);
-    u32 IocAlloc(const std::vector<u8>& input, std::vector<u8>& output);
-    u32 IocGetId(const std::vector<u8>& input, std::vector<u8>& output);
-    u32 IocFromId(const std::vector<u8>& input, std::vector<u8>& output);
-    u32 IocParam(const std::vector<u8>& input, std::vector<u8>& output);
-    u32 IocFree(const std::vector<u8>& input, std::vector<u8>& output);
+    u32 IocCreate(IoctlInput input, IoctlOutput output);
+    u32 IocAlloc(IoctlInput input, IoctlOutput output);
+    u32 IocGetId(IoctlInput input, IoctlOutput output);
+    u32 IocFromId(IoctlInput input, IoctlOutput output);
+    u32 IocParam(IoctlInput input, IoctlOutput output);
+    u32 IocFree(IoctlInput input, IoctlOutput output);
 };
 
 } // namespace Service::Nvidia::Devices
@@ -6,6 +6,7 @@
 #include "common/logging/log.h"
 #include "core/hle/ipc_helpers.h"
 #include "core/hle/kernel/event.h"
+#include "core/hle/kernel/thread.h"
 #include "core/hle/service/nvdrv/interface.h"
 #include "core/hle/service/nvdrv/nvdrv.h"
 
@@ -28,16 +29,52 @@ void NVDRV::Ioctl(Kernel::HLERequestContext& ctx) {
     LOG_DEBUG(Service_NVDRV, "called");
 
     IPC::RequestParser rp{ctx};
-    u32 fd = rp.Pop<u32>();
-    u32 command = rp.Pop<u32>();
+    const u32 fd = rp.Pop<u32>();
+    const u32 command = rp.Pop<u32>();
+
+    Devices::IoctlCtrl ctrl{};
+    IssueIoctl(ctx, fd, command, ctrl);
+}
 
-    std::vector<u8> output(ctx.GetWriteBufferSize());
+void NVDRV::IssueIoctl(Kernel::HLERequestContext& ctx, u32 fd, u32 command,
+                       Devices::IoctlCtrl& ctrl) {
+    // Both buffers are accessed in place in guest memory unless they aren't contiguous in host
+    // memory, in which case the output is staged in a temporary buffer.
+    const auto input = ctx.ReadBufferView();
+    const size_t output_size = ctx.GetWriteBufferSize();
+    u8* const output_pointer = ctx.GetWriteBufferPointer();
+    std::vector<u8> staging;
+    if (output_pointer == nullptr) {
+        staging.resize(output_size);
+    }
+
+    const Devices::IoctlInput ioctl_input{input.data(), input.size()};
+    const Devices::IoctlOutput ioctl_output{output_pointer ? output_pointer : staging.data(),
+                                            output_size};
+
+    const u32 result = nvdrv->Ioctl(fd, command, ioctl_input, ioctl_output, ctrl);
+    if (ctrl.must_delay) {
+        // Issue the ioctl again once the device is done waiting, it writes the response then
+        ctx.SleepClientThread(Kernel::GetCurrentThread(), "NVServices::DelayedResponse",
+                              ctrl.timeout,
+                              [=](Kernel::SharedPtr<Kernel::Thread> thread,
+                                  Kernel::HLERequestContext& ctx, ThreadWakeupReason reason) {
+                                  Devices::IoctlCtrl retry_ctrl{};
+                                  retry_ctrl.fresh_call = false;
+                                  retry_ctrl.timed_out = reason == ThreadWakeupReason::Timeout;
+                                  IssueIoctl(ctx, fd, command, retry_ctrl);
+                              },
+                              ctrl.wait_event);
+        return;
+    }
 
     IPC::ResponseBuilder rb{ctx, 3};
     rb.Push(RESULT_SUCCESS);
-    rb.Push(nvdrv->Ioctl(fd, command, ctx.ReadBuffer(), output));
+    rb.Push(result);
 
-    ctx.WriteBuffer(output);
+    if (output_pointer == nullptr) {
+        ctx.WriteBuffer(staging);
+    }
 }
 
 void NVDRV::Close(Kernel::HLERequestContext& ctx) {
@@ -19,6 +19,8 @@ public:
 private:
     void Open(Kernel::HLERequestContext& ctx);
     void Ioctl(Kernel::HLERequestContext& ctx);
+    /// Issues an ioctl and writes its response, putting the caller to sleep if it has to wait
+    void IssueIoctl(Kernel::HLERequestContext& ctx, u32 fd, u32 command, Devices::IoctlCtrl& ctrl);
     void Close(Kernel::HLERequestContext& ctx);
     void Initialize(Kernel::HLERequestContext& ctx);
     void QueryEvent(Kernel::HLERequestContext& ctx);
@@ -8,6 +8,8 @@
 #include <unordered_map>
 #include <vector>
 #include "common/common_types.h"
+#include "core/hle/service/nvdrv/devices/nvdevice.h"
+#include "core/hle/service/nvdrv/syncpoint_manager.h"
 #include "core/hle/service/service.h"
 
 namespace Service::NVFlinger {
@@ -16,10 +18,6 @@ class NVFlinger;
 
 namespace Service::Nvidia {
 
-namespace Devices {
-class nvdevice;
-}
-
 struct IoctlFence {
     u32 id;
     u32 value;
@@ -44,11 +42,19 @@ public:
     /// Opens a device node and returns a file descriptor to it.
     u32 Open(const std::string& device_name);
     /// Sends an ioctl command to the specified file descriptor.
-    u32 Ioctl(u32 fd, u32 command, const std::vector<u8>& input, std::vector<u8>& output);
+    u32 Ioctl(u32 fd, u32 command, Devices::IoctlInput input, Devices::IoctlOutput output,
+              Devices::IoctlCtrl& ctrl);
     /// Closes a device file descriptor and returns operation success.
     ResultCode Close(u32 fd);
 
+    const SyncpointManager& GetSyncpointManager() const {
+        return syncpoint_manager;
+    }
+
 private:
+    /// Driver side state of the syncpoints, shared by the devices that signal and wait on them.
+    SyncpointManager syncpoint_manager;
+
     /// Id to use for the next open file descriptor.
     u32 next_fd = 1;
 
@@ -0,0 +1,68 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <string>
+
+#include "common/assert.h"
+#include "core/core.h"
+#include "core/hle/kernel/hle_worker.h"
+#include "core/hle/service/nvdrv/syncpoint_manager.h"
+
+namespace Service::Nvidia {
+
+u32 SyncpointManager::AllocateSyncpoint() {
+    ASSERT_MSG(next_syncpoint_id < Tegra::GPU::NumSyncPoints, "Ran out of syncpoints");
+    // Syncpoints are only handed out once and start at zero, like their GPU side counterparts,
+    // so there is nothing to reset here. This may run before the GPU is created.
+    return next_syncpoint_id++;
+}
+
+u32 SyncpointManager::IncreaseSyncpointMaxValue(u32 syncpoint_id, u32 increment) {
+    ASSERT(syncpoint_id < Tegra::GPU::NumSyncPoints);
+    syncpoint_max[syncpoint_id] += increment;
+    return syncpoint_max[syncpoint_id];
+}
+
+u32 SyncpointManager::GetSyncpointMax(u32 syncpoint_id) const {
+    ASSERT(syncpoint_id < Tegra::GPU::NumSyncPoints);
+    return syncpoint_max[syncpoint_id];
+}
+
+u32 SyncpointManager::GetSyncpointMin(u32 syncpoint_id) const {
+    return Core::System::GetInstance().GPU().GetSyncPointValue(syncpoint_id);
+}
+
+bool SyncpointManager::IsSyncpointExpired(u32 syncpoint_id, u32 threshold) const {
+    return Core::System::GetInstance().GPU().IsSyncPointExpired(syncpoint_id, threshold);
+}
+
+void SyncpointManager::IncrementSyncpoint(u32 syncpoint_id) {
+    auto& gpu = Core::System::GetInstance().GPU();
+    gpu.IncrementSyncPoint(syncpoint_id);
+
+    const auto signal_waiters = [this, syncpoint_id] {
+        if (syncpoint_events[syncpoint_id] != nullptr) {
+            syncpoint_events[syncpoint_id]->Signal();
+        }
+    };
+    if (gpu.IsAsynchronous()) {
+        // Called on the GPU thread, kernel objects may only be signaled on the CPU thread
+        Kernel::QueueHLECompletion(signal_waiters);
+    } else {
+        signal_waiters();
+    }
+}
+
+Kernel::SharedPtr<Kernel::Event> SyncpointManager::GetSyncpointEvent(u32 syncpoint_id) {
+    ASSERT(syncpoint_id < Tegra::GPU::NumSyncPoints);
+    auto& event = syncpoint_events[syncpoint_id];
+    if (event == nullptr) {
+        // Every waiter wakes up on an increment and checks its own threshold again
+        event = Kernel::Event::Create(Kernel::ResetType::Pulse,
+                                      "NVDRV Syncpoint " + std::to_string(syncpoint_id));
+    }
+    return event;
+}
+
+} // namespace Service::Nvidia
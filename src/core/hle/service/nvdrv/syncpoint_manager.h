@@ -0,0 +1,57 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <array>
+#include "common/common_types.h"
+#include "core/hle/kernel/event.h"
+#include "video_core/gpu.h"
+
+namespace Service::Nvidia {
+
+/**
+ * Keeps the driver side state of the host1x syncpoints. The current value of a syncpoint lives in
+ * the GPU, which increments it as work completes; the driver tracks the maximum value, i.e. the
+ * value the syncpoint will reach once everything submitted so far is done. A fence is a syncpoint
+ * id together with a value of that syncpoint to wait for.
+ */
+class SyncpointManager final {
+public:
+    /// Reserves a syncpoint for a channel and returns its id.
+    u32 AllocateSyncpoint();
+
+    /// Increases the maximum value of a syncpoint by `increment`, returns the new maximum.
+    u32 IncreaseSyncpointMaxValue(u32 syncpoint_id, u32 increment);
+
+    /// Returns the value the syncpoint will reach once all submitted work completes.
+    u32 GetSyncpointMax(u32 syncpoint_id) const;
+
+    /// Returns the current value of the syncpoint.
+    u32 GetSyncpointMin(u32 syncpoint_id) const;
+
+    /// Returns whether the syncpoint has already reached the threshold of a fence.
+    bool IsSyncpointExpired(u32 syncpoint_id, u32 threshold) const;
+
+    /**
+     * Increments the current value of the syncpoint and wakes up the threads waiting on it. With
+     * asynchronous GPU emulation this is called on the GPU thread, and the waiters are woken up
+     * on the CPU thread afterwards.
+     */
+    void IncrementSyncpoint(u32 syncpoint_id);
+
+    /// Returns the event signaled whenever the syncpoint is incremented.
+    Kernel::SharedPtr<Kernel::Event> GetSyncpointEvent(u32 syncpoint_id);
+
+private:
+    /// Syncpoint 0 is reserved by the driver as an invalid id.
+    u32 next_syncpoint_id = 1;
+
+    std::array<u32, Tegra::GPU::NumSyncPoints> syncpoint_max{};
+
+    /// Events of the syncpoints that were waited on, created on the first wait.
+    std::array<Kernel::SharedPtr<Kernel::Event>, Tegra::GPU::NumSyncPoints> syncpoint_events;
+};
+
+} // namespace Service::Nvidia
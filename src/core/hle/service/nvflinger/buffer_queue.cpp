@@ -6,6 +6,8 @@
 
 #include "common/assert.h"
 #include "common/logging/log.h"
+#include "core/core_timing.h"
+#include "core/hle/service/nvdrv/syncpoint_manager.h"
 #include "core/hle/service/nvflinger/buffer_queue.h"
 
 namespace Service {
@@ -16,73 +18,119 @@ BufferQueue::BufferQueue(u32 id, u64 layer_id) : id(id), layer_id(layer_id) {
         Kernel::Event::Create(Kernel::ResetType::Sticky, "BufferQueue NativeHandle");
 }
 
+bool BufferQueue::TransitionBuffer(Buffer& buffer, Buffer::Status from, Buffer::Status to) {
+    return buffer.status.compare_exchange_strong(from, to, std::memory_order_acq_rel);
+}
+
 void BufferQueue::SetPreallocatedBuffer(u32 slot, const IGBPBuffer& igbp_buffer) {
-    Buffer buffer{};
+    ASSERT(slot < NUM_BUFFER_SLOTS);
+
+    Buffer& buffer = slots[slot];
+    ASSERT(buffer.status == Buffer::Status::Free);
     buffer.slot = slot;
     buffer.igbp_buffer = igbp_buffer;
-    buffer.status = Buffer::Status::Free;
+    buffer.is_preallocated = true;
 
     LOG_WARNING(Service, "Adding graphics buffer {}", slot);
 
-    queue.emplace_back(buffer);
+    if (slot >= num_used_slots) {
+        num_used_slots = slot + 1;
+    }
     buffer_wait_event->Signal();
 }
 
 boost::optional<u32> BufferQueue::DequeueBuffer(u32 width, u32 height) {
-    auto itr = std::find_if(queue.begin(), queue.end(), [&](const Buffer& buffer) {
+    for (u32 slot = 0; slot < num_used_slots; ++slot) {
+        Buffer& buffer = slots[slot];
+
         // Only consider free buffers. Buffers become free once again after they've been Acquired
         // and Released by the compositor, see the NVFlinger::Compose method.
-        if (buffer.status != Buffer::Status::Free) {
-            return false;
+        if (!buffer.is_preallocated || buffer.status != Buffer::Status::Free) {
+            continue;
         }
 
         // Make sure that the parameters match.
-        return buffer.igbp_buffer.width == width && buffer.igbp_buffer.height == height;
-    });
+        if (buffer.igbp_buffer.width != width || buffer.igbp_buffer.height != height) {
+            continue;
+        }
 
-    if (itr == queue.end()) {
-        return boost::none;
+        // The compositor only ever moves buffers to the free state, so the transition can't fail
+        const bool dequeued =
+            TransitionBuffer(buffer, Buffer::Status::Free, Buffer::Status::Dequeued);
+        ASSERT(dequeued);
+        return slot;
     }
 
-    itr->status = Buffer::Status::Dequeued;
-    return itr->slot;
+    return boost::none;
 }
 
 const IGBPBuffer& BufferQueue::RequestBuffer(u32 slot) const {
-    auto itr = std::find_if(queue.begin(), queue.end(),
-                            [&](const Buffer& buffer) { return buffer.slot == slot; });
-    ASSERT(itr != queue.end());
-    ASSERT(itr->status == Buffer::Status::Dequeued);
-    return itr->igbp_buffer;
+    ASSERT(slot < NUM_BUFFER_SLOTS);
+    const Buffer& buffer = slots[slot];
+    ASSERT(buffer.is_preallocated);
+    ASSERT(buffer.status == Buffer::Status::Dequeued);
+    return buffer.igbp_buffer;
 }
 
 void BufferQueue::QueueBuffer(u32 slot, BufferTransformFlags transform,
-                              const MathUtil::Rectangle<int>& crop_rect) {
-    auto itr = std::find_if(queue.begin(), queue.end(),
-                            [&](const Buffer& buffer) { return buffer.slot == slot; });
-    ASSERT(itr != queue.end());
-    ASSERT(itr->status == Buffer::Status::Dequeued);
-    itr->status = Buffer::Status::Queued;
-    itr->transform = transform;
-    itr->crop_rect = crop_rect;
+                              const MathUtil::Rectangle<int>& crop_rect, const MultiFence& fence) {
+    ASSERT(slot < NUM_BUFFER_SLOTS);
+    Buffer& buffer = slots[slot];
+    ASSERT(buffer.is_preallocated);
+    buffer.transform = transform;
+    buffer.crop_rect = crop_rect;
+    buffer.fence = fence;
+
+    // The parameters have to be written before the buffer is handed to the compositor
+    const bool queued = TransitionBuffer(buffer, Buffer::Status::Dequeued, Buffer::Status::Queued);
+    ASSERT(queued);
+    queued_slots.Push(slot);
 }
 
-boost::optional<const BufferQueue::Buffer&> BufferQueue::AcquireBuffer() {
-    auto itr = std::find_if(queue.begin(), queue.end(), [](const Buffer& buffer) {
-        return buffer.status == Buffer::Status::Queued;
-    });
-    if (itr == queue.end())
+boost::optional<const BufferQueue::Buffer&> BufferQueue::AcquireBuffer(
+    const Nvidia::SyncpointManager& syncpoints) {
+    if (queued_slots.Empty()) {
         return boost::none;
-    itr->status = Buffer::Status::Acquired;
-    return *itr;
+    }
+
+    Buffer& buffer = slots[queued_slots.Front()];
+
+    // Keep presenting the previous buffer until the GPU is done rendering to this one
+    const MultiFence& fence = buffer.fence;
+    for (u32 i = 0; i < fence.num_fences; ++i) {
+        const MultiFence::Fence& syncpoint_fence = fence.fences[i];
+        if (syncpoint_fence.id >= Tegra::GPU::NumSyncPoints ||
+            syncpoints.IsSyncpointExpired(syncpoint_fence.id, syncpoint_fence.value)) {
+            continue;
+        }
+
+        const auto now = CoreTiming::GetGlobalTimeUs();
+        if (!fence_wait_start) {
+            fence_wait_start = now;
+        }
+        if (now - *fence_wait_start < FENCE_WAIT_TIMEOUT) {
+            return boost::none;
+        }
+
+        // A fence that never signals would stall the display forever
+        LOG_WARNING(Service, "Presenting buffer {} with syncpoint {} still pending (value={})",
+                    buffer.slot, syncpoint_fence.id, syncpoint_fence.value);
+        break;
+    }
+
+    fence_wait_start = boost::none;
+    queued_slots.Pop();
+    const bool acquired =
+        TransitionBuffer(buffer, Buffer::Status::Queued, Buffer::Status::Acquired);
+    ASSERT(acquired);
+    return buffer;
 }
 
 void BufferQueue::ReleaseBuffer(u32 slot) {
-    auto itr = std::find_if(queue.begin(), queue.end(),
-                            [&](const Buffer& buffer) { return buffer.slot == slot; });
-    ASSERT(itr != queue.end());
-    ASSERT(itr->status == Buffer::Status::Acquired);
-    itr->status = Buffer::Status::Free;
+    ASSERT(slot < NUM_BUFFER_SLOTS);
+    const bool released =
+        TransitionBuffer(slots[slot], Buffer::Status::Acquired, Buffer::Status::Free);
+    ASSERT(released);
 
     buffer_wait_event->Signal();
 }
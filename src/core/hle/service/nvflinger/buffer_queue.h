@@ -4,13 +4,20 @@
 
 #pragma once
 
-#include <vector>
+#include <array>
+#include <atomic>
+#include <chrono>
 #include <boost/optional.hpp>
 #include "common/common_funcs.h"
 #include "common/math_util.h"
 #include "common/swap.h"
+#include "common/threadsafe_queue.h"
 #include "core/hle/kernel/event.h"
 
+namespace Service::Nvidia {
+class SyncpointManager;
+}
+
 namespace CoreTiming {
 struct EventType;
 }
@@ -63,22 +70,53 @@ public:
         Roate270 = 0x07,
     };
 
+    /// Maximum number of buffers a queue can hold, same as the Android BufferQueue
+    static constexpr u32 NUM_BUFFER_SLOTS = 64;
+
+    /// Longest time a queued buffer is held back for its fences before it's presented anyway
+    static constexpr std::chrono::microseconds FENCE_WAIT_TIMEOUT = std::chrono::milliseconds{100};
+
+    /// Fences signaled once the GPU has finished rendering to a queued buffer
+    struct MultiFence {
+        struct Fence {
+            u32 id;
+            u32 value;
+        };
+
+        u32 num_fences = 0;
+        std::array<Fence, 2> fences{};
+    };
+
     struct Buffer {
         enum class Status { Free = 0, Queued = 1, Dequeued = 2, Acquired = 3 };
 
         u32 slot;
-        Status status = Status::Free;
+        /// Changed by the producer and the consumer without a lock, the side that moves the buffer
+        /// into a state owns it until it moves it out of that state
+        std::atomic<Status> status{Status::Free};
+        bool is_preallocated = false;
         IGBPBuffer igbp_buffer;
         BufferTransformFlags transform;
         MathUtil::Rectangle<int> crop_rect;
+        MultiFence fence;
     };
 
+    // DequeueBuffer, RequestBuffer and QueueBuffer are called by the producer, the application,
+    // while AcquireBuffer and ReleaseBuffer are called by the consumer, the compositor. Both sides
+    // may run concurrently.
     void SetPreallocatedBuffer(u32 slot, const IGBPBuffer& igbp_buffer);
     boost::optional<u32> DequeueBuffer(u32 width, u32 height);
     const IGBPBuffer& RequestBuffer(u32 slot) const;
     void QueueBuffer(u32 slot, BufferTransformFlags transform,
-                     const MathUtil::Rectangle<int>& crop_rect);
-    boost::optional<const Buffer&> AcquireBuffer();
+                     const MathUtil::Rectangle<int>& crop_rect, const MultiFence& fence);
+
+    /**
+     * Acquires the buffer that was queued first, if the GPU has finished rendering to it. Buffers
+     * are presented in the order they were queued, a later buffer never overtakes one whose
+     * fences are still pending. A buffer whose fences are still pending after FENCE_WAIT_TIMEOUT
+     * is acquired anyway.
+     */
+    boost::optional<const Buffer&> AcquireBuffer(const Nvidia::SyncpointManager& syncpoints);
     void ReleaseBuffer(u32 slot);
     u32 Query(QueryType type);
 
@@ -91,10 +129,20 @@ public:
     }
 
 private:
+    /// Moves the buffer from one state to another, returning false if it wasn't in `from`
+    static bool TransitionBuffer(Buffer& buffer, Buffer::Status from, Buffer::Status to);
+
     u32 id;
     u64 layer_id;
 
-    std::vector<Buffer> queue;
+    std::array<Buffer, NUM_BUFFER_SLOTS> slots;
+    /// Number of slots up to the last preallocated one, free buffers are only searched below it
+    std::atomic<u32> num_used_slots{0};
+    /// Slots of the queued buffers in the order they were queued
+    Common::SPSCQueue<u32, false> queued_slots;
+    /// Time the compositor started waiting for the fences of the first queued buffer, only
+    /// accessed by the consumer
+    boost::optional<std::chrono::microseconds> fence_wait_start;
     Kernel::SharedPtr<Kernel::Event> buffer_wait_event;
 };
 
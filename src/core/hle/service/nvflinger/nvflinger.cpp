@@ -8,20 +8,25 @@
 #include "common/alignment.h"
 #include "common/assert.h"
 #include "common/logging/log.h"
+#include "common/memory_tracker.h"
 #include "common/microprofile.h"
 #include "common/scope_exit.h"
 #include "core/core.h"
 #include "core/core_timing.h"
 #include "core/core_timing_util.h"
+#include "core/hle/kernel/process.h"
 #include "core/hle/service/nvdrv/devices/nvdisp_disp0.h"
 #include "core/hle/service/nvdrv/nvdrv.h"
 #include "core/hle/service/nvflinger/buffer_queue.h"
 #include "core/hle/service/nvflinger/nvflinger.h"
+#include "video_core/gpu.h"
 #include "video_core/renderer_base.h"
 #include "video_core/video_core.h"
 
 namespace Service::NVFlinger {
 
+MICROPROFILE_COUNTER_DEFINE(Kernel_HeapUsage, "Kernel", "Heap Usage", Level);
+
 constexpr size_t SCREEN_REFRESH_RATE = 60;
 constexpr u64 frame_ticks = static_cast<u64>(CoreTiming::BASE_CLOCK_RATE / SCREEN_REFRESH_RATE);
 
@@ -88,11 +93,9 @@ Kernel::SharedPtr<Kernel::Event> NVFlinger::GetVsyncEvent(u64 display_id) {
 }
 
 std::shared_ptr<BufferQueue> NVFlinger::GetBufferQueue(u32 id) const {
-    auto itr = std::find_if(buffer_queues.begin(), buffer_queues.end(),
-                            [&](const auto& queue) { return queue->GetId() == id; });
-
-    ASSERT(itr != buffer_queues.end());
-    return *itr;
+    // Buffer queues are never destroyed and their ids are handed out in order
+    ASSERT(id != 0 && id <= buffer_queues.size());
+    return buffer_queues[id - 1];
 }
 
 Display& NVFlinger::GetDisplay(u64 display_id) {
@@ -129,16 +132,21 @@ void NVFlinger::Compose() {
         auto& buffer_queue = layer.buffer_queue;
 
         // Search for a queued buffer and acquire it
-        auto buffer = buffer_queue->AcquireBuffer();
+        auto buffer = buffer_queue->AcquireBuffer(nvdrv->GetSyncpointManager());
 
-        MicroProfileFlip();
+        if (const auto& process = Core::CurrentProcess()) {
+            MICROPROFILE_COUNTER_SET(Kernel_HeapUsage, process->vm_manager.GetTotalHeapUsage());
+            Common::SetTrackedMemory(Common::MemoryTag::GuestMemory,
+                                     process->vm_manager.GetBackingMemoryUsage());
+        }
+        Common::LogTrackedMemory();
 
         if (buffer == boost::none) {
             auto& system_instance = Core::System::GetInstance();
 
             // There was no queued buffer to draw, render previous frame
             system_instance.perf_stats.EndGameFrame();
-            system_instance.Renderer().SwapBuffers({});
+            system_instance.GPU().SwapBuffers({});
             continue;
         }
 
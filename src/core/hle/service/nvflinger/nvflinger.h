@@ -80,6 +80,7 @@ private:
     std::shared_ptr<Nvidia::Module> nvdrv;
 
     std::vector<Display> displays;
+    /// Buffer queues indexed by their id minus one.
     std::vector<std::shared_ptr<BufferQueue>> buffer_queues;
 
     /// Id to use for the next layer that is created, this counter is shared among all displays.
@@ -3,9 +3,12 @@
 // Refer to the license.txt file included.
 
 #include <algorithm>
+#include <chrono>
+#include <iterator>
 #include <fmt/format.h>
 #include "common/assert.h"
 #include "common/logging/log.h"
+#include "common/microprofile.h"
 #include "common/string_util.h"
 #include "core/core.h"
 #include "core/hle/ipc.h"
@@ -35,6 +38,7 @@
 #include "core/hle/service/friend/friend.h"
 #include "core/hle/service/grc/grc.h"
 #include "core/hle/service/hid/hid.h"
+#include "core/hle/service/ipc_profiler.h"
 #include "core/hle/service/lbl/lbl.h"
 #include "core/hle/service/ldn/ldn.h"
 #include "core/hle/service/ldr/ldr.h"
@@ -95,7 +99,8 @@ static std::string MakeFunctionString(const char* name, const char* port_name,
 
 ServiceFrameworkBase::ServiceFrameworkBase(const char* service_name, u32 max_sessions,
                                            InvokerFn* handler_invoker)
-    : service_name(service_name), max_sessions(max_sessions), handler_invoker(handler_invoker) {}
+    : service_name(service_name), ipc_stats(IPCProfiler::GetServiceStats(this->service_name)),
+      max_sessions(max_sessions), handler_invoker(handler_invoker) {}
 
 ServiceFrameworkBase::~ServiceFrameworkBase() = default;
 
@@ -131,6 +136,32 @@ void ServiceFrameworkBase::RegisterHandlersBase(const FunctionInfoBase* function
         // Usually this array is sorted by id already, so hint to insert at the end
         handlers.emplace_hint(handlers.cend(), functions[i].expected_header, functions[i]);
     }
+
+    // Inserting into the flat_map may have moved existing entries
+    RebuildDirectHandlerTable();
+}
+
+void ServiceFrameworkBase::RebuildDirectHandlerTable() {
+    // Most services only use small command ids, keep the table just large enough for those
+    const auto limit = handlers.lower_bound(DIRECT_HANDLER_LIMIT);
+    const size_t table_size = limit == handlers.begin() ? 0 : std::prev(limit)->first + 1;
+
+    direct_handlers.assign(table_size, nullptr);
+    for (auto itr = handlers.begin(); itr != limit; ++itr) {
+        direct_handlers[itr->first] = &itr->second;
+    }
+}
+
+const ServiceFrameworkBase::FunctionInfoBase* ServiceFrameworkBase::FindHandler(u32 command) const {
+    if (command < direct_handlers.size()) {
+        return direct_handlers[command];
+    }
+    if (command < DIRECT_HANDLER_LIMIT) {
+        return nullptr;
+    }
+
+    const auto itr = handlers.find(command);
+    return itr == handlers.end() ? nullptr : &itr->second;
 }
 
 void ServiceFrameworkBase::ReportUnimplementedFunction(Kernel::HLERequestContext& ctx,
@@ -151,8 +182,7 @@ void ServiceFrameworkBase::ReportUnimplementedFunction(Kernel::HLERequestContext
 }
 
 void ServiceFrameworkBase::InvokeRequest(Kernel::HLERequestContext& ctx) {
-    auto itr = handlers.find(ctx.GetCommand());
-    const FunctionInfoBase* info = itr == handlers.end() ? nullptr : &itr->second;
+    const FunctionInfoBase* info = FindHandler(ctx.GetCommand());
     if (info == nullptr || info->handler_callback == nullptr) {
         return ReportUnimplementedFunction(ctx, info);
     }
@@ -160,10 +190,16 @@ void ServiceFrameworkBase::InvokeRequest(Kernel::HLERequestContext& ctx) {
     LOG_TRACE(
         Service, "{}",
         MakeFunctionString(info->name, GetServiceName().c_str(), ctx.CommandBuffer()).c_str());
+
+    const auto start = std::chrono::steady_clock::now();
     handler_invoker(this, info->handler_callback, ctx);
+    ipc_stats->RecordCall(ctx.GetCommand(), info->name, std::chrono::steady_clock::now() - start);
 }
 
+MICROPROFILE_COUNTER_DEFINE(HLE_IPCRequests, "HLE", "IPC Requests", PerFrame);
+
 ResultCode ServiceFrameworkBase::HandleSyncRequest(Kernel::HLERequestContext& context) {
+    MICROPROFILE_COUNTER_ADD(HLE_IPCRequests, 1);
     switch (context.GetCommandType()) {
     case IPC::CommandType::Close: {
         IPC::ResponseBuilder rb{context, 2};
@@ -5,8 +5,10 @@
 #pragma once
 
 #include <cstddef>
+#include <memory>
 #include <string>
 #include <unordered_map>
+#include <vector>
 #include <boost/container/flat_map.hpp>
 #include "common/common_types.h"
 #include "core/hle/kernel/hle_ipc.h"
@@ -28,6 +30,10 @@ class VfsFilesystem;
 
 namespace Service {
 
+namespace IPCProfiler {
+class ServiceStats;
+}
+
 namespace SM {
 class ServiceManager;
 }
@@ -90,10 +96,14 @@ private:
     ~ServiceFrameworkBase();
 
     void RegisterHandlersBase(const FunctionInfoBase* functions, size_t n);
+    void RebuildDirectHandlerTable();
+    const FunctionInfoBase* FindHandler(u32 command) const;
     void ReportUnimplementedFunction(Kernel::HLERequestContext& ctx, const FunctionInfoBase* info);
 
     /// Identifier string used to connect to the service.
     std::string service_name;
+    /// Call counts and times of the commands, shared with the other services of the same name
+    std::shared_ptr<IPCProfiler::ServiceStats> ipc_stats;
     /// Maximum number of concurrent sessions that this service can handle.
     u32 max_sessions;
 
@@ -106,6 +116,11 @@ private:
     /// Function used to safely up-cast pointers to the derived class before invoking a handler.
     InvokerFn* handler_invoker;
     boost::container::flat_map<u32, FunctionInfoBase> handlers;
+
+    /// Command ids below this limit are looked up through direct_handlers instead of handlers.
+    static constexpr u32 DIRECT_HANDLER_LIMIT = 1024;
+    /// Entries of handlers indexed by command id, nullptr where no handler is registered.
+    std::vector<const FunctionInfoBase*> direct_handlers;
 };
 
 /**
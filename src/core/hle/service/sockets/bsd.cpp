@@ -2,11 +2,125 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
+#include <cstring>
+#include <utility>
+#include "common/common_funcs.h"
+#include "common/logging/log.h"
 #include "core/hle/ipc_helpers.h"
+#include "core/hle/kernel/event.h"
+#include "core/hle/kernel/thread.h"
 #include "core/hle/service/sockets/bsd.h"
+#include "core/hle/service/sockets/socket_poller.h"
 
 namespace Service::Sockets {
 
+using Host::Errno;
+
+// Flags the guest may combine with the type of a new socket
+constexpr u32 SOCK_NONBLOCK_FLAG = 0x20000000;
+constexpr u32 SOCK_CLOEXEC_FLAG = 0x10000000;
+
+// Fcntl commands and file status flags of the guest
+constexpr s32 FCNTL_GETFL = 3;
+constexpr s32 FCNTL_SETFL = 4;
+constexpr s32 FLAG_O_NONBLOCK = 0x800;
+
+/// Poll entry as laid out by the guest
+struct GuestPollFD {
+    s32 fd;
+    u16 events;
+    u16 revents;
+};
+static_assert(sizeof(GuestPollFD) == 8, "GuestPollFD has incorrect size");
+
+/// Parameters of Select, a struct timeval is made of two 64-bit fields on the guest
+struct SelectParameters {
+    s32 nfds;
+    INSERT_PADDING_WORDS(1);
+    s64 timeout_seconds;
+    s64 timeout_microseconds;
+    bool null_timeout;
+};
+
+/// Read, write and exception sets of Select, in that order
+using SelectSets = std::array<std::vector<u8>, 3>;
+
+/// Poll events Select waits for on the sockets of each of its sets
+constexpr std::array<u16, 3> SELECT_WAIT_EVENTS{Host::POLL_IN, Host::POLL_OUT, Host::POLL_PRI};
+
+/// Poll events that make Select report a socket as ready in each of its sets
+constexpr std::array<u16, 3> SELECT_READY_EVENTS{Host::POLL_IN | Host::POLL_HUP | Host::POLL_ERR,
+                                                 Host::POLL_OUT | Host::POLL_ERR, Host::POLL_PRI};
+
+static void WriteBsdResult(Kernel::HLERequestContext& ctx, s32 ret, Errno bsd_errno) {
+    IPC::ResponseBuilder rb{ctx, 4};
+    rb.Push(RESULT_SUCCESS);
+    rb.Push<s32>(ret);
+    rb.Push(static_cast<u32>(bsd_errno));
+}
+
+/// Writes the result of an operation that also returns the length of a value, e.g. an address
+static void WriteBsdResult(Kernel::HLERequestContext& ctx, s32 ret, Errno bsd_errno, u32 length) {
+    IPC::ResponseBuilder rb{ctx, 5};
+    rb.Push(RESULT_SUCCESS);
+    rb.Push<s32>(ret);
+    rb.Push(static_cast<u32>(bsd_errno));
+    rb.Push<u32>(length);
+}
+
+/// Writes the result of an operation that returns 0 on success and -1 on failure
+static void WriteBsdError(Kernel::HLERequestContext& ctx, Errno bsd_errno) {
+    WriteBsdResult(ctx, bsd_errno == Errno::SUCCESS ? 0 : -1, bsd_errno);
+}
+
+static bool ReadAddress(const Kernel::HLERequestContext& ctx, int buffer_index,
+                        Host::SockAddrIn& address) {
+    const auto buffer = ctx.ReadBufferView(buffer_index);
+    if (buffer.size() < sizeof(address)) {
+        return false;
+    }
+    std::memcpy(&address, buffer.data(), sizeof(address));
+    return true;
+}
+
+/// Writes an address to an output buffer, returns the length of the address
+static u32 WriteAddress(const Kernel::HLERequestContext& ctx, int buffer_index,
+                        const Host::SockAddrIn& address) {
+    const size_t size = std::min(ctx.GetWriteBufferSize(buffer_index), sizeof(address));
+    if (size > 0) {
+        ctx.WriteBuffer(&address, size, buffer_index);
+    }
+    return static_cast<u32>(sizeof(address));
+}
+
+static bool IsBlocking(bool non_blocking, u32 flags) {
+    return !non_blocking && (flags & Host::MSG_FLAG_DONTWAIT) == 0;
+}
+
+static bool TestBit(const std::vector<u8>& set, s32 bit) {
+    const size_t index = static_cast<size_t>(bit) / 8;
+    return index < set.size() && (set[index] & (1 << (bit % 8))) != 0;
+}
+
+static void SetBit(std::vector<u8>& set, s32 bit) {
+    const size_t index = static_cast<size_t>(bit) / 8;
+    if (index < set.size()) {
+        set[index] |= 1 << (bit % 8);
+    }
+}
+
+/// Poll events to wait for on a socket given the sets of Select it is in
+static u16 GetSelectEvents(const SelectSets& sets, s32 fd) {
+    u16 events = 0;
+    for (size_t i = 0; i < sets.size(); ++i) {
+        if (TestBit(sets[i], fd)) {
+            events |= SELECT_WAIT_EVENTS[i];
+        }
+    }
+    return events;
+}
+
 void BSD::RegisterClient(Kernel::HLERequestContext& ctx) {
     LOG_WARNING(Service, "(STUBBED) called");
 
@@ -27,79 +141,627 @@ void BSD::StartMonitoring(Kernel::HLERequestContext& ctx) {
 void BSD::Socket(Kernel::HLERequestContext& ctx) {
     IPC::RequestParser rp{ctx};
 
-    u32 domain = rp.Pop<u32>();
-    u32 type = rp.Pop<u32>();
-    u32 protocol = rp.Pop<u32>();
+    const u32 domain = rp.Pop<u32>();
+    const u32 type = rp.Pop<u32>();
+    const u32 protocol = rp.Pop<u32>();
 
-    LOG_WARNING(Service, "(STUBBED) called domain={} type={} protocol={}", domain, type, protocol);
+    LOG_DEBUG(Service, "called domain={} type={:#x} protocol={}", domain, type, protocol);
 
-    u32 fd = next_fd++;
+    const s32 fd = FindFreeDescriptor();
+    if (fd < 0) {
+        WriteBsdResult(ctx, -1, Errno::MFILE);
+        return;
+    }
 
-    IPC::ResponseBuilder rb{ctx, 4};
+    const auto [socket, bsd_errno] =
+        Host::CreateSocket(domain, type & ~(SOCK_NONBLOCK_FLAG | SOCK_CLOEXEC_FLAG), protocol);
+    if (bsd_errno != Errno::SUCCESS) {
+        WriteBsdResult(ctx, -1, bsd_errno);
+        return;
+    }
 
-    rb.Push(RESULT_SUCCESS);
-    rb.Push<u32>(fd);
-    rb.Push<u32>(0); // bsd errno
+    file_descriptors[fd] = FileDescriptor{socket, (type & SOCK_NONBLOCK_FLAG) != 0};
+    WriteBsdResult(ctx, fd, Errno::SUCCESS);
 }
 
-void BSD::Connect(Kernel::HLERequestContext& ctx) {
-    LOG_WARNING(Service, "(STUBBED) called");
+void BSD::Select(Kernel::HLERequestContext& ctx) {
+    IPC::RequestParser rp{ctx};
+    const auto parameters = rp.PopRaw<SelectParameters>();
 
-    IPC::ResponseBuilder rb{ctx, 4};
+    LOG_DEBUG(Service, "called nfds={}", parameters.nfds);
 
-    rb.Push(RESULT_SUCCESS);
-    rb.Push<u32>(0); // ret
-    rb.Push<u32>(0); // bsd errno
+    s32 timeout = -1;
+    if (!parameters.null_timeout) {
+        timeout = static_cast<s32>(parameters.timeout_seconds * 1000 +
+                                   (parameters.timeout_microseconds + 999) / 1000);
+    }
+
+    // The sets are passed in input buffers 0 to 2, and returned in output buffers 0 to 2
+    const SelectSets sets{ctx.ReadBuffer(0), ctx.ReadBuffer(1), ctx.ReadBuffer(2)};
+    const s32 nfds = std::clamp<s32>(parameters.nfds, 0, static_cast<s32>(MAX_FD));
+
+    std::vector<Host::PollFD> fds;
+    for (s32 fd = 0; fd < nfds; ++fd) {
+        const u16 events = GetSelectEvents(sets, fd);
+        if (events == 0) {
+            continue;
+        }
+
+        const FileDescriptor* const descriptor = GetDescriptor(fd);
+        if (descriptor == nullptr) {
+            WriteBsdResult(ctx, -1, Errno::BADF);
+            return;
+        }
+        fds.push_back({descriptor->socket, events, 0});
+    }
+
+    RunBlocking(ctx, "BSD::Select", fds, timeout,
+                [this, sets, nfds, timeout](Kernel::HLERequestContext& ctx, bool can_block) {
+                    std::vector<s32> polled_fds;
+                    std::vector<Host::PollFD> fds;
+                    for (s32 fd = 0; fd < nfds; ++fd) {
+                        const u16 events = GetSelectEvents(sets, fd);
+                        const FileDescriptor* const descriptor = GetDescriptor(fd);
+                        if (events != 0 && descriptor != nullptr) {
+                            polled_fds.push_back(fd);
+                            fds.push_back({descriptor->socket, events, 0});
+                        }
+                    }
+                    Host::Poll(fds.data(), fds.size(), 0);
+
+                    SelectSets results;
+                    for (size_t i = 0; i < results.size(); ++i) {
+                        results[i].resize(ctx.GetWriteBufferSize(static_cast<int>(i)));
+                    }
+
+                    s32 count = 0;
+                    for (size_t index = 0; index < fds.size(); ++index) {
+                        const s32 fd = polled_fds[index];
+                        for (size_t i = 0; i < sets.size(); ++i) {
+                            if (TestBit(sets[i], fd) &&
+                                (fds[index].revents & SELECT_READY_EVENTS[i]) != 0) {
+                                SetBit(results[i], fd);
+                                ++count;
+                            }
+                        }
+                    }
+
+                    if (count == 0 && can_block && timeout != 0) {
+                        return false;
+                    }
+
+                    for (size_t i = 0; i < results.size(); ++i) {
+                        if (!results[i].empty()) {
+                            ctx.WriteBuffer(results[i], static_cast<int>(i));
+                        }
+                    }
+                    WriteBsdResult(ctx, count, Errno::SUCCESS);
+                    return true;
+                });
+}
+
+void BSD::Poll(Kernel::HLERequestContext& ctx) {
+    IPC::RequestParser rp{ctx};
+    const s32 nfds = rp.Pop<s32>();
+    const s32 timeout = rp.Pop<s32>();
+
+    LOG_DEBUG(Service, "called nfds={} timeout={}", nfds, timeout);
+
+    std::vector<GuestPollFD> guest_fds(ctx.GetReadBufferSize() / sizeof(GuestPollFD));
+    guest_fds.resize(std::min<size_t>(guest_fds.size(), std::max(nfds, 0)));
+    std::memcpy(guest_fds.data(), ctx.ReadBufferView().data(),
+                guest_fds.size() * sizeof(GuestPollFD));
+
+    std::vector<Host::PollFD> fds;
+    for (const auto& guest_fd : guest_fds) {
+        if (const FileDescriptor* const descriptor = GetDescriptor(guest_fd.fd)) {
+            fds.push_back({descriptor->socket, guest_fd.events, 0});
+        }
+    }
+
+    RunBlocking(ctx, "BSD::Poll", fds, timeout,
+                [this, guest_fds, timeout](Kernel::HLERequestContext& ctx, bool can_block) {
+                    auto results = guest_fds;
+                    std::vector<Host::PollFD> fds;
+                    std::vector<size_t> indices;
+                    for (size_t i = 0; i < results.size(); ++i) {
+                        results[i].revents = 0;
+                        if (results[i].fd < 0) {
+                            continue;
+                        }
+
+                        const FileDescriptor* const descriptor = GetDescriptor(results[i].fd);
+                        if (descriptor == nullptr) {
+                            results[i].revents = Host::POLL_NVAL;
+                            continue;
+                        }
+                        indices.push_back(i);
+                        fds.push_back({descriptor->socket, results[i].events, 0});
+                    }
+                    Host::Poll(fds.data(), fds.size(), 0);
+
+                    for (size_t i = 0; i < fds.size(); ++i) {
+                        results[indices[i]].revents = fds[i].revents;
+                    }
+                    const s32 count = static_cast<s32>(
+                        std::count_if(results.begin(), results.end(),
+                                      [](const GuestPollFD& fd) { return fd.revents != 0; }));
+                    if (count == 0 && can_block && timeout != 0) {
+                        return false;
+                    }
+
+                    ctx.WriteBuffer(results);
+                    WriteBsdResult(ctx, count, Errno::SUCCESS);
+                    return true;
+                });
+}
+
+void BSD::Recv(Kernel::HLERequestContext& ctx) {
+    IPC::RequestParser rp{ctx};
+    const s32 fd = rp.Pop<s32>();
+    const u32 flags = rp.Pop<u32>();
+
+    LOG_DEBUG(Service, "called fd={} flags={:#x}", fd, flags);
+    RecvImpl(ctx, fd, flags, false, "BSD::Recv");
+}
+
+void BSD::RecvFrom(Kernel::HLERequestContext& ctx) {
+    IPC::RequestParser rp{ctx};
+    const s32 fd = rp.Pop<s32>();
+    const u32 flags = rp.Pop<u32>();
+
+    LOG_DEBUG(Service, "called fd={} flags={:#x}", fd, flags);
+    RecvImpl(ctx, fd, flags, true, "BSD::RecvFrom");
+}
+
+void BSD::Send(Kernel::HLERequestContext& ctx) {
+    IPC::RequestParser rp{ctx};
+    const s32 fd = rp.Pop<s32>();
+    const u32 flags = rp.Pop<u32>();
+
+    LOG_DEBUG(Service, "called fd={} flags={:#x}", fd, flags);
+    SendImpl(ctx, fd, flags, false, "BSD::Send");
 }
 
 void BSD::SendTo(Kernel::HLERequestContext& ctx) {
-    LOG_WARNING(Service, "(STUBBED) called");
+    IPC::RequestParser rp{ctx};
+    const s32 fd = rp.Pop<s32>();
+    const u32 flags = rp.Pop<u32>();
 
-    IPC::ResponseBuilder rb{ctx, 4};
+    LOG_DEBUG(Service, "called fd={} flags={:#x}", fd, flags);
+    SendImpl(ctx, fd, flags, true, "BSD::SendTo");
+}
 
-    rb.Push(RESULT_SUCCESS);
-    rb.Push<u32>(0); // ret
-    rb.Push<u32>(0); // bsd errno
+void BSD::Accept(Kernel::HLERequestContext& ctx) {
+    IPC::RequestParser rp{ctx};
+    const s32 fd = rp.Pop<s32>();
+
+    LOG_DEBUG(Service, "called fd={}", fd);
+
+    const FileDescriptor* const descriptor = GetDescriptor(fd);
+    if (descriptor == nullptr) {
+        WriteBsdResult(ctx, -1, Errno::BADF, 0);
+        return;
+    }
+
+    RunBlocking(ctx, "BSD::Accept", {{descriptor->socket, Host::POLL_IN, 0}}, -1,
+                [this, fd](Kernel::HLERequestContext& ctx, bool can_block) {
+                    const FileDescriptor* const descriptor = GetDescriptor(fd);
+                    if (descriptor == nullptr) {
+                        WriteBsdResult(ctx, -1, Errno::BADF, 0);
+                        return true;
+                    }
+
+                    const s32 new_fd = FindFreeDescriptor();
+                    if (new_fd < 0) {
+                        WriteBsdResult(ctx, -1, Errno::MFILE, 0);
+                        return true;
+                    }
+
+                    Host::SockAddrIn address{};
+                    const auto [socket, bsd_errno] = Host::Accept(descriptor->socket, address);
+                    if (bsd_errno == Errno::AGAIN && can_block &&
+                        IsBlocking(descriptor->non_blocking, 0)) {
+                        return false;
+                    }
+                    if (bsd_errno != Errno::SUCCESS) {
+                        WriteBsdResult(ctx, -1, bsd_errno, 0);
+                        return true;
+                    }
+
+                    file_descriptors[new_fd] = FileDescriptor{socket, false};
+                    WriteBsdResult(ctx, new_fd, Errno::SUCCESS, WriteAddress(ctx, 0, address));
+                    return true;
+                });
+}
+
+void BSD::Bind(Kernel::HLERequestContext& ctx) {
+    IPC::RequestParser rp{ctx};
+    const s32 fd = rp.Pop<s32>();
+
+    LOG_DEBUG(Service, "called fd={}", fd);
+
+    const FileDescriptor* const descriptor = GetDescriptor(fd);
+    Host::SockAddrIn address;
+    if (descriptor == nullptr) {
+        WriteBsdError(ctx, Errno::BADF);
+    } else if (!ReadAddress(ctx, 0, address)) {
+        WriteBsdError(ctx, Errno::INVAL);
+    } else {
+        WriteBsdError(ctx, Host::Bind(descriptor->socket, address));
+    }
+}
+
+void BSD::Connect(Kernel::HLERequestContext& ctx) {
+    IPC::RequestParser rp{ctx};
+    const s32 fd = rp.Pop<s32>();
+
+    LOG_DEBUG(Service, "called fd={}", fd);
+
+    const FileDescriptor* const descriptor = GetDescriptor(fd);
+    Host::SockAddrIn address;
+    if (descriptor == nullptr) {
+        WriteBsdError(ctx, Errno::BADF);
+        return;
+    }
+    if (!ReadAddress(ctx, 0, address)) {
+        WriteBsdError(ctx, Errno::INVAL);
+        return;
+    }
+
+    const Errno bsd_errno = Host::Connect(descriptor->socket, address);
+    if (bsd_errno != Errno::INPROGRESS || descriptor->non_blocking) {
+        WriteBsdError(ctx, bsd_errno);
+        return;
+    }
+
+    // A blocking connect completes once the socket becomes writable
+    RunBlocking(ctx, "BSD::Connect", {{descriptor->socket, Host::POLL_OUT, 0}}, -1,
+                [this, fd](Kernel::HLERequestContext& ctx, bool can_block) {
+                    const FileDescriptor* const descriptor = GetDescriptor(fd);
+                    if (descriptor == nullptr) {
+                        WriteBsdError(ctx, Errno::BADF);
+                        return true;
+                    }
+
+                    Host::PollFD poll_fd{descriptor->socket, Host::POLL_OUT, 0};
+                    Host::Poll(&poll_fd, 1, 0);
+                    if (poll_fd.revents == 0 && can_block) {
+                        return false;
+                    }
+
+                    WriteBsdError(ctx, Host::GetPendingError(descriptor->socket));
+                    return true;
+                });
+}
+
+void BSD::GetPeerName(Kernel::HLERequestContext& ctx) {
+    IPC::RequestParser rp{ctx};
+    const s32 fd = rp.Pop<s32>();
+
+    LOG_DEBUG(Service, "called fd={}", fd);
+
+    const FileDescriptor* const descriptor = GetDescriptor(fd);
+    if (descriptor == nullptr) {
+        WriteBsdResult(ctx, -1, Errno::BADF, 0);
+        return;
+    }
+
+    Host::SockAddrIn address{};
+    const Errno bsd_errno = Host::GetPeerName(descriptor->socket, address);
+    if (bsd_errno != Errno::SUCCESS) {
+        WriteBsdResult(ctx, -1, bsd_errno, 0);
+        return;
+    }
+    WriteBsdResult(ctx, 0, Errno::SUCCESS, WriteAddress(ctx, 0, address));
+}
+
+void BSD::GetSockName(Kernel::HLERequestContext& ctx) {
+    IPC::RequestParser rp{ctx};
+    const s32 fd = rp.Pop<s32>();
+
+    LOG_DEBUG(Service, "called fd={}", fd);
+
+    const FileDescriptor* const descriptor = GetDescriptor(fd);
+    if (descriptor == nullptr) {
+        WriteBsdResult(ctx, -1, Errno::BADF, 0);
+        return;
+    }
+
+    Host::SockAddrIn address{};
+    const Errno bsd_errno = Host::GetSockName(descriptor->socket, address);
+    if (bsd_errno != Errno::SUCCESS) {
+        WriteBsdResult(ctx, -1, bsd_errno, 0);
+        return;
+    }
+    WriteBsdResult(ctx, 0, Errno::SUCCESS, WriteAddress(ctx, 0, address));
+}
+
+void BSD::GetSockOpt(Kernel::HLERequestContext& ctx) {
+    IPC::RequestParser rp{ctx};
+    const s32 fd = rp.Pop<s32>();
+    const s32 level = rp.Pop<s32>();
+    const s32 name = rp.Pop<s32>();
+
+    LOG_DEBUG(Service, "called fd={} level={:#x} name={:#x}", fd, level, name);
+
+    const FileDescriptor* const descriptor = GetDescriptor(fd);
+    if (descriptor == nullptr) {
+        WriteBsdResult(ctx, -1, Errno::BADF, 0);
+        return;
+    }
+
+    std::vector<u8> value(ctx.GetWriteBufferSize());
+    u32 size = static_cast<u32>(value.size());
+    const Errno bsd_errno = Host::GetSockOpt(descriptor->socket, level, name, value.data(), size);
+    if (bsd_errno != Errno::SUCCESS) {
+        WriteBsdResult(ctx, -1, bsd_errno, 0);
+        return;
+    }
+
+    ctx.WriteBuffer(value.data(), size);
+    WriteBsdResult(ctx, 0, Errno::SUCCESS, size);
+}
+
+void BSD::Listen(Kernel::HLERequestContext& ctx) {
+    IPC::RequestParser rp{ctx};
+    const s32 fd = rp.Pop<s32>();
+    const s32 backlog = rp.Pop<s32>();
+
+    LOG_DEBUG(Service, "called fd={} backlog={}", fd, backlog);
+
+    const FileDescriptor* const descriptor = GetDescriptor(fd);
+    if (descriptor == nullptr) {
+        WriteBsdError(ctx, Errno::BADF);
+        return;
+    }
+    WriteBsdError(ctx, Host::Listen(descriptor->socket, backlog));
+}
+
+void BSD::Fcntl(Kernel::HLERequestContext& ctx) {
+    IPC::RequestParser rp{ctx};
+    const s32 fd = rp.Pop<s32>();
+    const s32 cmd = rp.Pop<s32>();
+    const s32 arg = rp.Pop<s32>();
+
+    LOG_DEBUG(Service, "called fd={} cmd={} arg={:#x}", fd, cmd, arg);
+
+    FileDescriptor* const descriptor = GetDescriptor(fd);
+    if (descriptor == nullptr) {
+        WriteBsdError(ctx, Errno::BADF);
+        return;
+    }
+
+    switch (cmd) {
+    case FCNTL_GETFL:
+        WriteBsdResult(ctx, descriptor->non_blocking ? FLAG_O_NONBLOCK : 0, Errno::SUCCESS);
+        break;
+    case FCNTL_SETFL:
+        // Host sockets are always non-blocking, only the behavior the guest sees changes
+        descriptor->non_blocking = (arg & FLAG_O_NONBLOCK) != 0;
+        WriteBsdResult(ctx, 0, Errno::SUCCESS);
+        break;
+    default:
+        LOG_WARNING(Service, "Unimplemented fcntl command {}", cmd);
+        WriteBsdError(ctx, Errno::INVAL);
+        break;
+    }
+}
+
+void BSD::SetSockOpt(Kernel::HLERequestContext& ctx) {
+    IPC::RequestParser rp{ctx};
+    const s32 fd = rp.Pop<s32>();
+    const s32 level = rp.Pop<s32>();
+    const s32 name = rp.Pop<s32>();
+
+    LOG_DEBUG(Service, "called fd={} level={:#x} name={:#x}", fd, level, name);
+
+    const FileDescriptor* const descriptor = GetDescriptor(fd);
+    if (descriptor == nullptr) {
+        WriteBsdError(ctx, Errno::BADF);
+        return;
+    }
+
+    const auto value = ctx.ReadBufferView();
+    WriteBsdError(ctx,
+                  Host::SetSockOpt(descriptor->socket, level, name, value.data(), value.size()));
+}
+
+void BSD::Shutdown(Kernel::HLERequestContext& ctx) {
+    IPC::RequestParser rp{ctx};
+    const s32 fd = rp.Pop<s32>();
+    const s32 how = rp.Pop<s32>();
+
+    LOG_DEBUG(Service, "called fd={} how={}", fd, how);
+
+    const FileDescriptor* const descriptor = GetDescriptor(fd);
+    if (descriptor == nullptr) {
+        WriteBsdError(ctx, Errno::BADF);
+        return;
+    }
+    WriteBsdError(ctx, Host::Shutdown(descriptor->socket, how));
+}
+
+void BSD::Write(Kernel::HLERequestContext& ctx) {
+    IPC::RequestParser rp{ctx};
+    const s32 fd = rp.Pop<s32>();
+
+    LOG_DEBUG(Service, "called fd={}", fd);
+    SendImpl(ctx, fd, 0, false, "BSD::Write");
+}
+
+void BSD::Read(Kernel::HLERequestContext& ctx) {
+    IPC::RequestParser rp{ctx};
+    const s32 fd = rp.Pop<s32>();
+
+    LOG_DEBUG(Service, "called fd={}", fd);
+    RecvImpl(ctx, fd, 0, false, "BSD::Read");
 }
 
 void BSD::Close(Kernel::HLERequestContext& ctx) {
-    LOG_WARNING(Service, "(STUBBED) called");
+    IPC::RequestParser rp{ctx};
+    const s32 fd = rp.Pop<s32>();
 
-    IPC::ResponseBuilder rb{ctx, 4};
+    LOG_DEBUG(Service, "called fd={}", fd);
 
-    rb.Push(RESULT_SUCCESS);
-    rb.Push<u32>(0); // ret
-    rb.Push<u32>(0); // bsd errno
+    const FileDescriptor* const descriptor = GetDescriptor(fd);
+    if (descriptor == nullptr) {
+        WriteBsdError(ctx, Errno::BADF);
+        return;
+    }
+
+    const Errno bsd_errno = Host::Close(descriptor->socket);
+    file_descriptors[fd] = boost::none;
+    WriteBsdError(ctx, bsd_errno);
 }
 
-BSD::BSD(const char* name) : ServiceFramework(name) {
+void BSD::RunBlocking(Kernel::HLERequestContext& ctx, const char* reason,
+                      std::vector<Host::PollFD> fds, s32 timeout, Operation operation) {
+    if (operation(ctx, true)) {
+        return;
+    }
+
+    // Let the core run other guest threads while the poller waits for the sockets on the host
+    const auto event = ctx.SleepClientThread(
+        Kernel::GetCurrentThread(), reason, 0,
+        [operation](Kernel::SharedPtr<Kernel::Thread> thread, Kernel::HLERequestContext& ctx,
+                    ThreadWakeupReason wakeup_reason) { operation(ctx, false); });
+    poller->Wait(std::move(fds), timeout, [event] { event->Signal(); });
+}
+
+void BSD::RecvImpl(Kernel::HLERequestContext& ctx, s32 fd, u32 flags, bool with_address,
+                   const char* reason) {
+    const auto write_result = [with_address](Kernel::HLERequestContext& ctx, s32 ret,
+                                             Errno bsd_errno, u32 length) {
+        if (with_address) {
+            WriteBsdResult(ctx, ret, bsd_errno, length);
+        } else {
+            WriteBsdResult(ctx, ret, bsd_errno);
+        }
+    };
+
+    const FileDescriptor* const descriptor = GetDescriptor(fd);
+    if (descriptor == nullptr) {
+        write_result(ctx, -1, Errno::BADF, 0);
+        return;
+    }
+
+    RunBlocking(
+        ctx, reason, {{descriptor->socket, Host::POLL_IN, 0}}, -1,
+        [this, fd, flags, with_address, write_result](Kernel::HLERequestContext& ctx,
+                                                      bool can_block) {
+            const FileDescriptor* const descriptor = GetDescriptor(fd);
+            if (descriptor == nullptr) {
+                write_result(ctx, -1, Errno::BADF, 0);
+                return true;
+            }
+
+            // Receive straight into guest memory when the buffer is contiguous in host memory
+            const size_t size = ctx.GetWriteBufferSize();
+            u8* const pointer = ctx.GetWriteBufferPointer();
+            std::vector<u8> staging(pointer == nullptr ? size : 0);
+
+            Host::SockAddrIn address{};
+            const auto [ret, bsd_errno] =
+                Host::Recv(descriptor->socket, pointer ? pointer : staging.data(), size, flags,
+                           with_address ? &address : nullptr);
+            if (bsd_errno == Errno::AGAIN && can_block &&
+                IsBlocking(descriptor->non_blocking, flags)) {
+                return false;
+            }
+            if (bsd_errno != Errno::SUCCESS) {
+                write_result(ctx, -1, bsd_errno, 0);
+                return true;
+            }
+
+            if (pointer == nullptr && ret > 0) {
+                ctx.WriteBuffer(staging.data(), static_cast<size_t>(ret));
+            }
+            write_result(ctx, ret, Errno::SUCCESS,
+                         with_address ? WriteAddress(ctx, 1, address) : 0);
+            return true;
+        });
+}
+
+void BSD::SendImpl(Kernel::HLERequestContext& ctx, s32 fd, u32 flags, bool with_address,
+                   const char* reason) {
+    const FileDescriptor* const descriptor = GetDescriptor(fd);
+    if (descriptor == nullptr) {
+        WriteBsdResult(ctx, -1, Errno::BADF);
+        return;
+    }
+
+    RunBlocking(ctx, reason, {{descriptor->socket, Host::POLL_OUT, 0}}, -1,
+                [this, fd, flags, with_address](Kernel::HLERequestContext& ctx, bool can_block) {
+                    const FileDescriptor* const descriptor = GetDescriptor(fd);
+                    if (descriptor == nullptr) {
+                        WriteBsdResult(ctx, -1, Errno::BADF);
+                        return true;
+                    }
+
+                    Host::SockAddrIn address;
+                    if (with_address && !ReadAddress(ctx, 1, address)) {
+                        WriteBsdResult(ctx, -1, Errno::INVAL);
+                        return true;
+                    }
+
+                    const auto data = ctx.ReadBufferView();
+                    const auto [ret, bsd_errno] =
+                        Host::Send(descriptor->socket, data.data(), data.size(), flags,
+                                   with_address ? &address : nullptr);
+                    if (bsd_errno == Errno::AGAIN && can_block &&
+                        IsBlocking(descriptor->non_blocking, flags)) {
+                        return false;
+                    }
+                    WriteBsdResult(ctx, ret, bsd_errno);
+                    return true;
+                });
+}
+
+BSD::FileDescriptor* BSD::GetDescriptor(s32 fd) {
+    if (fd < 0 || static_cast<size_t>(fd) >= file_descriptors.size() || !file_descriptors[fd]) {
+        return nullptr;
+    }
+    return &*file_descriptors[fd];
+}
+
+s32 BSD::FindFreeDescriptor() const {
+    const auto iter = std::find(file_descriptors.begin(), file_descriptors.end(), boost::none);
+    if (iter == file_descriptors.end()) {
+        return -1;
+    }
+    return static_cast<s32>(std::distance(file_descriptors.begin(), iter));
+}
+
+BSD::BSD(const char* name, std::shared_ptr<SocketPoller> poller)
+    : ServiceFramework(name), poller(std::move(poller)) {
     static const FunctionInfo functions[] = {
         {0, &BSD::RegisterClient, "RegisterClient"},
         {1, &BSD::StartMonitoring, "StartMonitoring"},
         {2, &BSD::Socket, "Socket"},
         {3, nullptr, "SocketExempt"},
         {4, nullptr, "Open"},
-        {5, nullptr, "Select"},
-        {6, nullptr, "Poll"},
+        {5, &BSD::Select, "Select"},
+        {6, &BSD::Poll, "Poll"},
         {7, nullptr, "Sysctl"},
-        {8, nullptr, "Recv"},
-        {9, nullptr, "RecvFrom"},
-        {10, nullptr, "Send"},
+        {8, &BSD::Recv, "Recv"},
+        {9, &BSD::RecvFrom, "RecvFrom"},
+        {10, &BSD::Send, "Send"},
         {11, &BSD::SendTo, "SendTo"},
-        {12, nullptr, "Accept"},
-        {13, nullptr, "Bind"},
+        {12, &BSD::Accept, "Accept"},
+        {13, &BSD::Bind, "Bind"},
         {14, &BSD::Connect, "Connect"},
-        {15, nullptr, "GetPeerName"},
-        {16, nullptr, "GetSockName"},
-        {17, nullptr, "GetSockOpt"},
-        {18, nullptr, "Listen"},
+        {15, &BSD::GetPeerName, "GetPeerName"},
+        {16, &BSD::GetSockName, "GetSockName"},
+        {17, &BSD::GetSockOpt, "GetSockOpt"},
+        {18, &BSD::Listen, "Listen"},
         {19, nullptr, "Ioctl"},
-        {20, nullptr, "Fcntl"},
-        {21, nullptr, "SetSockOpt"},
-        {22, nullptr, "Shutdown"},
+        {20, &BSD::Fcntl, "Fcntl"},
+        {21, &BSD::SetSockOpt, "SetSockOpt"},
+        {22, &BSD::Shutdown, "Shutdown"},
         {23, nullptr, "ShutdownAllSockets"},
-        {24, nullptr, "Write"},
-        {25, nullptr, "Read"},
+        {24, &BSD::Write, "Write"},
+        {25, &BSD::Read, "Read"},
         {26, &BSD::Close, "Close"},
         {27, nullptr, "DuplicateSocket"},
         {28, nullptr, "GetResourceStatistics"},
@@ -109,6 +771,14 @@ BSD::BSD(const char* name) : ServiceFramework(name) {
     RegisterHandlers(functions);
 }
 
+BSD::~BSD() {
+    for (auto& descriptor : file_descriptors) {
+        if (descriptor) {
+            Host::Close(descriptor->socket);
+        }
+    }
+}
+
 BSDCFG::BSDCFG() : ServiceFramework{"bsdcfg"} {
     // clang-format off
     static const FunctionInfo functions[] = {
@@ -4,26 +4,86 @@
 
 #pragma once
 
+#include <array>
+#include <functional>
+#include <memory>
+#include <vector>
+#include <boost/optional.hpp>
 #include "core/hle/kernel/hle_ipc.h"
 #include "core/hle/service/service.h"
+#include "core/hle/service/sockets/host_socket.h"
 
 namespace Service::Sockets {
 
+class SocketPoller;
+
 class BSD final : public ServiceFramework<BSD> {
 public:
-    explicit BSD(const char* name);
-    ~BSD() = default;
+    BSD(const char* name, std::shared_ptr<SocketPoller> poller);
+    ~BSD() override;
 
 private:
+    /// Maximum number of sockets open at once
+    static constexpr std::size_t MAX_FD = 128;
+
+    struct FileDescriptor {
+        Host::Socket socket;
+        /// Whether the guest made the socket non-blocking, host sockets always are
+        bool non_blocking = false;
+    };
+
+    /**
+     * A non-blocking attempt at a socket operation. It writes the response and returns true,
+     * unless the operation would block and can_block is set, in which case it returns false.
+     */
+    using Operation = std::function<bool(Kernel::HLERequestContext& ctx, bool can_block)>;
+
     void RegisterClient(Kernel::HLERequestContext& ctx);
     void StartMonitoring(Kernel::HLERequestContext& ctx);
     void Socket(Kernel::HLERequestContext& ctx);
-    void Connect(Kernel::HLERequestContext& ctx);
+    void Select(Kernel::HLERequestContext& ctx);
+    void Poll(Kernel::HLERequestContext& ctx);
+    void Recv(Kernel::HLERequestContext& ctx);
+    void RecvFrom(Kernel::HLERequestContext& ctx);
+    void Send(Kernel::HLERequestContext& ctx);
     void SendTo(Kernel::HLERequestContext& ctx);
+    void Accept(Kernel::HLERequestContext& ctx);
+    void Bind(Kernel::HLERequestContext& ctx);
+    void Connect(Kernel::HLERequestContext& ctx);
+    void GetPeerName(Kernel::HLERequestContext& ctx);
+    void GetSockName(Kernel::HLERequestContext& ctx);
+    void GetSockOpt(Kernel::HLERequestContext& ctx);
+    void Listen(Kernel::HLERequestContext& ctx);
+    void Fcntl(Kernel::HLERequestContext& ctx);
+    void SetSockOpt(Kernel::HLERequestContext& ctx);
+    void Shutdown(Kernel::HLERequestContext& ctx);
+    void Write(Kernel::HLERequestContext& ctx);
+    void Read(Kernel::HLERequestContext& ctx);
     void Close(Kernel::HLERequestContext& ctx);
 
-    /// Id to use for the next open file descriptor.
-    u32 next_fd = 1;
+    /**
+     * Runs operation and, if it would block, puts the calling guest thread to sleep until any of
+     * the given sockets is ready or the timeout expires, then runs it one last time.
+     * @param timeout Timeout in milliseconds, negative to wait forever.
+     */
+    void RunBlocking(Kernel::HLERequestContext& ctx, const char* reason,
+                     std::vector<Host::PollFD> fds, s32 timeout, Operation operation);
+
+    /// Shared implementation of Recv, RecvFrom and Read
+    void RecvImpl(Kernel::HLERequestContext& ctx, s32 fd, u32 flags, bool with_address,
+                  const char* reason);
+    /// Shared implementation of Send, SendTo and Write
+    void SendImpl(Kernel::HLERequestContext& ctx, s32 fd, u32 flags, bool with_address,
+                  const char* reason);
+
+    /// Returns the open socket with the given number, or nullptr if there is none
+    FileDescriptor* GetDescriptor(s32 fd);
+
+    /// Returns the lowest unused socket number, or -1 if every one is in use
+    s32 FindFreeDescriptor() const;
+
+    std::array<boost::optional<FileDescriptor>, MAX_FD> file_descriptors;
+    std::shared_ptr<SocketPoller> poller;
 };
 
 class BSDCFG final : public ServiceFramework<BSDCFG> {
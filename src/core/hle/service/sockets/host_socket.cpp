@@ -0,0 +1,522 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+#ifdef _WIN32
+#include <winsock2.h>
+// winsock2.h needs to be included first to prevent winsock.h being included by other includes
+#include <ws2tcpip.h>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+#include "common/logging/log.h"
+#include "core/hle/service/sockets/host_socket.h"
+
+namespace Service::Sockets::Host {
+
+#ifdef _WIN32
+using SockLen = int;
+using OptionValue = char;
+#define HOST_ERROR(name) WSAE##name
+#else
+using SockLen = socklen_t;
+using OptionValue = void;
+#define HOST_ERROR(name) E##name
+#endif
+
+namespace {
+
+// Socket levels and options of the guest, as defined by FreeBSD
+constexpr s32 GUEST_SOL_SOCKET = 0xFFFF;
+constexpr s32 GUEST_IPPROTO_TCP = 6;
+constexpr s32 GUEST_SO_REUSEADDR = 0x4;
+constexpr s32 GUEST_SO_KEEPALIVE = 0x8;
+constexpr s32 GUEST_SO_BROADCAST = 0x20;
+constexpr s32 GUEST_SO_LINGER = 0x80;
+constexpr s32 GUEST_SO_OOBINLINE = 0x100;
+constexpr s32 GUEST_SO_SNDBUF = 0x1001;
+constexpr s32 GUEST_SO_RCVBUF = 0x1002;
+constexpr s32 GUEST_SO_ERROR = 0x1007;
+constexpr s32 GUEST_SO_TYPE = 0x1008;
+constexpr s32 GUEST_TCP_NODELAY = 0x1;
+
+constexpr u8 GUEST_AF_INET = 2;
+
+/// Guest linger option, the host's differs on Windows
+struct GuestLinger {
+    s32 onoff;
+    s32 linger;
+};
+
+struct ErrorMapping {
+    int host;
+    Errno guest;
+};
+
+const ErrorMapping error_mappings[] = {
+    {HOST_ERROR(INTR), Errno::INTR},
+    {HOST_ERROR(BADF), Errno::BADF},
+    {HOST_ERROR(FAULT), Errno::FAULT},
+    {HOST_ERROR(INVAL), Errno::INVAL},
+    {HOST_ERROR(MFILE), Errno::MFILE},
+    {HOST_ERROR(WOULDBLOCK), Errno::AGAIN},
+    {HOST_ERROR(INPROGRESS), Errno::INPROGRESS},
+    {HOST_ERROR(ALREADY), Errno::ALREADY},
+    {HOST_ERROR(NOTSOCK), Errno::NOTSOCK},
+    {HOST_ERROR(MSGSIZE), Errno::MSGSIZE},
+    {HOST_ERROR(NOPROTOOPT), Errno::NOPROTOOPT},
+    {HOST_ERROR(PROTONOSUPPORT), Errno::PROTONOSUPPORT},
+    {HOST_ERROR(OPNOTSUPP), Errno::OPNOTSUPP},
+    {HOST_ERROR(AFNOSUPPORT), Errno::AFNOSUPPORT},
+    {HOST_ERROR(ADDRINUSE), Errno::ADDRINUSE},
+    {HOST_ERROR(ADDRNOTAVAIL), Errno::ADDRNOTAVAIL},
+    {HOST_ERROR(NETDOWN), Errno::NETDOWN},
+    {HOST_ERROR(NETUNREACH), Errno::NETUNREACH},
+    {HOST_ERROR(CONNABORTED), Errno::CONNABORTED},
+    {HOST_ERROR(CONNRESET), Errno::CONNRESET},
+    {HOST_ERROR(NOBUFS), Errno::NOBUFS},
+    {HOST_ERROR(ISCONN), Errno::ISCONN},
+    {HOST_ERROR(NOTCONN), Errno::NOTCONN},
+    {HOST_ERROR(TIMEDOUT), Errno::TIMEDOUT},
+    {HOST_ERROR(CONNREFUSED), Errno::CONNREFUSED},
+    {HOST_ERROR(HOSTUNREACH), Errno::HOSTUNREACH},
+#ifndef _WIN32
+    {EAGAIN, Errno::AGAIN},
+    {EPIPE, Errno::PIPE},
+#endif
+};
+
+struct PollMapping {
+    u16 guest;
+    short host;
+};
+
+const PollMapping poll_mappings[] = {
+    {POLL_IN, POLLIN},
+    {POLL_OUT, POLLOUT},
+    {POLL_ERR, POLLERR},
+    {POLL_HUP, POLLHUP},
+    {POLL_NVAL, POLLNVAL},
+#ifndef _WIN32
+    // WSAPoll rejects POLLPRI, out-of-band data can't be polled for there
+    {POLL_PRI, POLLPRI},
+#endif
+};
+
+Errno TranslateError(int error) {
+    const auto iter = std::find_if(std::begin(error_mappings), std::end(error_mappings),
+                                   [error](const ErrorMapping& mapping) {
+                                       return mapping.host == error;
+                                   });
+    if (iter == std::end(error_mappings)) {
+        LOG_ERROR(Service, "Unhandled host socket error {}", error);
+        return Errno::INVAL;
+    }
+    return iter->guest;
+}
+
+/// Translates the error of the last failed host socket call
+Errno LastError() {
+#ifdef _WIN32
+    return TranslateError(WSAGetLastError());
+#else
+    return TranslateError(errno);
+#endif
+}
+
+sockaddr_in TranslateAddress(const SockAddrIn& address) {
+    sockaddr_in result{};
+    result.sin_family = AF_INET;
+    result.sin_port = htons(address.port);
+    std::memcpy(&result.sin_addr, address.address.data(), sizeof(result.sin_addr));
+    return result;
+}
+
+SockAddrIn TranslateAddress(const sockaddr_in& address) {
+    SockAddrIn result{};
+    result.len = sizeof(SockAddrIn);
+    result.family = GUEST_AF_INET;
+    result.port = ntohs(address.sin_port);
+    std::memcpy(result.address.data(), &address.sin_addr, sizeof(result.address));
+    return result;
+}
+
+short TranslatePollEventsToHost(u16 events) {
+    short result = 0;
+    for (const auto& mapping : poll_mappings) {
+        if (events & mapping.guest) {
+            result |= mapping.host;
+        }
+    }
+#ifdef _WIN32
+    // WSAPoll only accepts the events it can wait for
+    result &= POLLIN | POLLOUT;
+#endif
+    return result;
+}
+
+u16 TranslatePollEventsToGuest(short events) {
+    u16 result = 0;
+    for (const auto& mapping : poll_mappings) {
+        if ((events & mapping.host) != 0) {
+            result |= mapping.guest;
+        }
+    }
+    return result;
+}
+
+int TranslateMessageFlags(u32 flags) {
+    int result = 0;
+    if (flags & MSG_FLAG_OOB) {
+        result |= MSG_OOB;
+    }
+    if (flags & MSG_FLAG_PEEK) {
+        result |= MSG_PEEK;
+    }
+    return result;
+}
+
+/// Translates a guest socket option to the host's, returns false if it's not supported
+bool TranslateOption(s32 level, s32 name, int& host_level, int& host_name) {
+    if (level == GUEST_SOL_SOCKET) {
+        host_level = SOL_SOCKET;
+        switch (name) {
+        case GUEST_SO_REUSEADDR:
+            host_name = SO_REUSEADDR;
+            return true;
+        case GUEST_SO_KEEPALIVE:
+            host_name = SO_KEEPALIVE;
+            return true;
+        case GUEST_SO_BROADCAST:
+            host_name = SO_BROADCAST;
+            return true;
+        case GUEST_SO_LINGER:
+            host_name = SO_LINGER;
+            return true;
+        case GUEST_SO_OOBINLINE:
+            host_name = SO_OOBINLINE;
+            return true;
+        case GUEST_SO_SNDBUF:
+            host_name = SO_SNDBUF;
+            return true;
+        case GUEST_SO_RCVBUF:
+            host_name = SO_RCVBUF;
+            return true;
+        case GUEST_SO_ERROR:
+            host_name = SO_ERROR;
+            return true;
+        case GUEST_SO_TYPE:
+            host_name = SO_TYPE;
+            return true;
+        default:
+            return false;
+        }
+    }
+
+    if (level == GUEST_IPPROTO_TCP && name == GUEST_TCP_NODELAY) {
+        host_level = IPPROTO_TCP;
+        host_name = TCP_NODELAY;
+        return true;
+    }
+
+    return false;
+}
+
+bool SetNonBlocking(Socket socket) {
+#ifdef _WIN32
+    u_long enable = 1;
+    return ioctlsocket(socket, FIONBIO, &enable) == 0;
+#else
+    const int flags = fcntl(socket, F_GETFL);
+    return flags != -1 && fcntl(socket, F_SETFL, flags | O_NONBLOCK) == 0;
+#endif
+}
+
+/// Prepares a socket fresh from the host for use by the guest
+Errno SetupSocket(Socket socket) {
+    if (!SetNonBlocking(socket)) {
+        return LastError();
+    }
+#ifdef __APPLE__
+    // There's no MSG_NOSIGNAL on macOS, a write to a closed socket must not raise SIGPIPE
+    int enable = 1;
+    setsockopt(socket, SOL_SOCKET, SO_NOSIGPIPE, &enable, sizeof(enable));
+#endif
+    return Errno::SUCCESS;
+}
+
+bool IsValid(Socket socket) {
+#ifdef _WIN32
+    return socket != INVALID_SOCKET;
+#else
+    return socket >= 0;
+#endif
+}
+
+} // Anonymous namespace
+
+void Initialize() {
+#ifdef _WIN32
+    WSADATA data;
+    WSAStartup(MAKEWORD(2, 2), &data);
+#endif
+}
+
+void Shutdown() {
+#ifdef _WIN32
+    WSACleanup();
+#endif
+}
+
+std::pair<Socket, Errno> CreateSocket(u32 domain, u32 type, u32 protocol) {
+    if (domain != GUEST_AF_INET) {
+        LOG_ERROR(Service, "Unsupported socket domain {}", domain);
+        return {0, Errno::AFNOSUPPORT};
+    }
+
+    // Socket types and protocols have the same values on the guest and every host
+    const Socket socket = ::socket(AF_INET, static_cast<int>(type), static_cast<int>(protocol));
+    if (!IsValid(socket)) {
+        return {0, LastError()};
+    }
+
+    const Errno result = SetupSocket(socket);
+    if (result != Errno::SUCCESS) {
+        Close(socket);
+        return {0, result};
+    }
+    return {socket, Errno::SUCCESS};
+}
+
+Errno Close(Socket socket) {
+#ifdef _WIN32
+    const int result = closesocket(socket);
+#else
+    const int result = close(socket);
+#endif
+    return result == 0 ? Errno::SUCCESS : LastError();
+}
+
+Errno Bind(Socket socket, const SockAddrIn& address) {
+    const sockaddr_in host_address = TranslateAddress(address);
+    if (bind(socket, reinterpret_cast<const sockaddr*>(&host_address), sizeof(host_address)) != 0) {
+        return LastError();
+    }
+    return Errno::SUCCESS;
+}
+
+Errno Connect(Socket socket, const SockAddrIn& address) {
+    const sockaddr_in host_address = TranslateAddress(address);
+    if (connect(socket, reinterpret_cast<const sockaddr*>(&host_address), sizeof(host_address)) ==
+        0) {
+        return Errno::SUCCESS;
+    }
+
+    const Errno error = LastError();
+#ifdef _WIN32
+    // Winsock reports connections in progress as a would-block error
+    if (error == Errno::AGAIN) {
+        return Errno::INPROGRESS;
+    }
+#endif
+    return error;
+}
+
+Errno Listen(Socket socket, s32 backlog) {
+    return listen(socket, backlog) == 0 ? Errno::SUCCESS : LastError();
+}
+
+Errno Shutdown(Socket socket, s32 how) {
+    // SHUT_RD, SHUT_WR and SHUT_RDWR have the same values on the guest and every host
+    return shutdown(socket, how) == 0 ? Errno::SUCCESS : LastError();
+}
+
+Errno GetPeerName(Socket socket, SockAddrIn& address) {
+    sockaddr_in host_address{};
+    SockLen length = sizeof(host_address);
+    if (getpeername(socket, reinterpret_cast<sockaddr*>(&host_address), &length) != 0) {
+        return LastError();
+    }
+    address = TranslateAddress(host_address);
+    return Errno::SUCCESS;
+}
+
+Errno GetSockName(Socket socket, SockAddrIn& address) {
+    sockaddr_in host_address{};
+    SockLen length = sizeof(host_address);
+    if (getsockname(socket, reinterpret_cast<sockaddr*>(&host_address), &length) != 0) {
+        return LastError();
+    }
+    address = TranslateAddress(host_address);
+    return Errno::SUCCESS;
+}
+
+std::pair<Socket, Errno> Accept(Socket socket, SockAddrIn& address) {
+    sockaddr_in host_address{};
+    SockLen length = sizeof(host_address);
+    const Socket accepted = accept(socket, reinterpret_cast<sockaddr*>(&host_address), &length);
+    if (!IsValid(accepted)) {
+        return {0, LastError()};
+    }
+
+    const Errno result = SetupSocket(accepted);
+    if (result != Errno::SUCCESS) {
+        Close(accepted);
+        return {0, result};
+    }
+    address = TranslateAddress(host_address);
+    return {accepted, Errno::SUCCESS};
+}
+
+Errno GetPendingError(Socket socket) {
+    int error = 0;
+    SockLen length = sizeof(error);
+    if (getsockopt(socket, SOL_SOCKET, SO_ERROR, reinterpret_cast<OptionValue*>(&error),
+                   &length) != 0) {
+        return LastError();
+    }
+    return error == 0 ? Errno::SUCCESS : TranslateError(error);
+}
+
+std::pair<s32, Errno> Recv(Socket socket, u8* data, std::size_t size, u32 flags,
+                           SockAddrIn* from) {
+    sockaddr_in host_address{};
+    SockLen length = sizeof(host_address);
+    const auto result =
+        recvfrom(socket, reinterpret_cast<char*>(data), static_cast<int>(size),
+                 TranslateMessageFlags(flags),
+                 from ? reinterpret_cast<sockaddr*>(&host_address) : nullptr,
+                 from ? &length : nullptr);
+    if (result < 0) {
+        return {-1, LastError()};
+    }
+    if (from != nullptr) {
+        *from = TranslateAddress(host_address);
+    }
+    return {static_cast<s32>(result), Errno::SUCCESS};
+}
+
+std::pair<s32, Errno> Send(Socket socket, const u8* data, std::size_t size, u32 flags,
+                           const SockAddrIn* to) {
+    int host_flags = TranslateMessageFlags(flags);
+#if !defined(_WIN32) && !defined(__APPLE__)
+    // Sending to a closed socket must fail with EPIPE instead of raising SIGPIPE
+    host_flags |= MSG_NOSIGNAL;
+#endif
+
+    sockaddr_in host_address{};
+    if (to != nullptr) {
+        host_address = TranslateAddress(*to);
+    }
+    const auto result = sendto(socket, reinterpret_cast<const char*>(data),
+                               static_cast<int>(size), host_flags,
+                               to ? reinterpret_cast<const sockaddr*>(&host_address) : nullptr,
+                               to ? sizeof(host_address) : 0);
+    if (result < 0) {
+        return {-1, LastError()};
+    }
+    return {static_cast<s32>(result), Errno::SUCCESS};
+}
+
+Errno SetSockOpt(Socket socket, s32 level, s32 name, const u8* value, std::size_t size) {
+    int host_level;
+    int host_name;
+    if (!TranslateOption(level, name, host_level, host_name)) {
+        // Most options games set only tune the socket, pretend they took effect
+        LOG_WARNING(Service, "Ignoring unsupported socket option level={:#x} name={:#x}", level,
+                    name);
+        return Errno::SUCCESS;
+    }
+
+    if (host_level == SOL_SOCKET && host_name == SO_LINGER) {
+        GuestLinger guest_linger{};
+        std::memcpy(&guest_linger, value, std::min(size, sizeof(guest_linger)));
+        linger host_linger{};
+        host_linger.l_onoff = static_cast<decltype(host_linger.l_onoff)>(guest_linger.onoff);
+        host_linger.l_linger = static_cast<decltype(host_linger.l_linger)>(guest_linger.linger);
+        if (setsockopt(socket, host_level, host_name,
+                       reinterpret_cast<const OptionValue*>(&host_linger),
+                       sizeof(host_linger)) != 0) {
+            return LastError();
+        }
+        return Errno::SUCCESS;
+    }
+
+    int host_value = 0;
+    std::memcpy(&host_value, value, std::min(size, sizeof(host_value)));
+    if (setsockopt(socket, host_level, host_name, reinterpret_cast<const OptionValue*>(&host_value),
+                   sizeof(host_value)) != 0) {
+        return LastError();
+    }
+    return Errno::SUCCESS;
+}
+
+Errno GetSockOpt(Socket socket, s32 level, s32 name, u8* value, u32& size) {
+    int host_level;
+    int host_name;
+    if (!TranslateOption(level, name, host_level, host_name)) {
+        LOG_WARNING(Service, "Unsupported socket option level={:#x} name={:#x}", level, name);
+        return Errno::NOPROTOOPT;
+    }
+
+    if (host_level == SOL_SOCKET && host_name == SO_LINGER) {
+        linger host_linger{};
+        SockLen length = sizeof(host_linger);
+        if (getsockopt(socket, host_level, host_name, reinterpret_cast<OptionValue*>(&host_linger),
+                       &length) != 0) {
+            return LastError();
+        }
+        const GuestLinger guest_linger{host_linger.l_onoff, host_linger.l_linger};
+        size = std::min<u32>(size, sizeof(guest_linger));
+        std::memcpy(value, &guest_linger, size);
+        return Errno::SUCCESS;
+    }
+
+    int host_value = 0;
+    SockLen length = sizeof(host_value);
+    if (getsockopt(socket, host_level, host_name, reinterpret_cast<OptionValue*>(&host_value),
+                   &length) != 0) {
+        return LastError();
+    }
+    if (host_name == SO_ERROR && host_value != 0) {
+        host_value = static_cast<int>(TranslateError(host_value));
+    }
+    size = std::min<u32>(size, sizeof(host_value));
+    std::memcpy(value, &host_value, size);
+    return Errno::SUCCESS;
+}
+
+std::pair<s32, Errno> Poll(PollFD* fds, std::size_t count, s32 timeout) {
+    std::vector<pollfd> host_fds(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        host_fds[i].fd = fds[i].socket;
+        host_fds[i].events = TranslatePollEventsToHost(fds[i].events);
+    }
+
+#ifdef _WIN32
+    const int result = WSAPoll(host_fds.data(), static_cast<ULONG>(count), timeout);
+#else
+    const int result = poll(host_fds.data(), static_cast<nfds_t>(count), timeout);
+#endif
+    if (result < 0) {
+        return {-1, LastError()};
+    }
+
+    for (std::size_t i = 0; i < count; ++i) {
+        fds[i].revents = TranslatePollEventsToGuest(host_fds[i].revents);
+    }
+    return {result, Errno::SUCCESS};
+}
+
+} // namespace Service::Sockets::Host
@@ -0,0 +1,149 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include "common/common_types.h"
+#include "common/swap.h"
+
+/**
+ * Thin layer over the host's BSD sockets (or Winsock), speaking the guest's ABI: addresses, flags
+ * and error numbers are all translated from and to the values the Switch's BSD service uses, which
+ * come from FreeBSD. Every socket created through it is non-blocking on the host, blocking guest
+ * sockets are emulated on top of it by the BSD service.
+ */
+namespace Service::Sockets::Host {
+
+#ifdef _WIN32
+using Socket = std::uintptr_t;
+#else
+using Socket = int;
+#endif
+
+/// Error numbers of the guest's BSD sockets
+enum class Errno : u32 {
+    SUCCESS = 0,
+    INTR = 4,
+    BADF = 9,
+    FAULT = 14,
+    INVAL = 22,
+    MFILE = 24,
+    PIPE = 32,
+    AGAIN = 35,
+    INPROGRESS = 36,
+    ALREADY = 37,
+    NOTSOCK = 38,
+    MSGSIZE = 40,
+    NOPROTOOPT = 42,
+    PROTONOSUPPORT = 43,
+    OPNOTSUPP = 45,
+    AFNOSUPPORT = 47,
+    ADDRINUSE = 48,
+    ADDRNOTAVAIL = 49,
+    NETDOWN = 50,
+    NETUNREACH = 51,
+    CONNABORTED = 53,
+    CONNRESET = 54,
+    NOBUFS = 55,
+    ISCONN = 56,
+    NOTCONN = 57,
+    TIMEDOUT = 60,
+    CONNREFUSED = 61,
+    HOSTUNREACH = 65,
+};
+
+/// Poll events of the guest's BSD sockets
+enum PollEvents : u16 {
+    POLL_IN = 0x1,
+    POLL_PRI = 0x2,
+    POLL_OUT = 0x4,
+    POLL_ERR = 0x8,
+    POLL_HUP = 0x10,
+    POLL_NVAL = 0x20,
+};
+
+/// Message flags of the guest's BSD sockets
+enum MessageFlags : u32 {
+    MSG_FLAG_OOB = 0x1,
+    MSG_FLAG_PEEK = 0x2,
+    MSG_FLAG_WAITALL = 0x40,
+    MSG_FLAG_DONTWAIT = 0x80,
+};
+
+/// IPv4 socket address as laid out by the guest's BSD sockets
+struct SockAddrIn {
+    u8 len;
+    u8 family;
+    u16_be port;
+    std::array<u8, 4> address;
+    std::array<u8, 8> zero;
+};
+static_assert(sizeof(SockAddrIn) == 0x10, "SockAddrIn has incorrect size");
+
+/// A socket and the guest poll events to wait for on it, along with the ones that occurred
+struct PollFD {
+    Socket socket;
+    u16 events;
+    u16 revents;
+};
+
+/// Initializes the host's socket library, must be called before any other function here
+void Initialize();
+
+/// Releases the host's socket library, once per call to Initialize
+void Shutdown();
+
+/// Creates a new non-blocking socket with the guest's domain, type and protocol
+std::pair<Socket, Errno> CreateSocket(u32 domain, u32 type, u32 protocol);
+
+Errno Close(Socket socket);
+Errno Bind(Socket socket, const SockAddrIn& address);
+Errno Connect(Socket socket, const SockAddrIn& address);
+Errno Listen(Socket socket, s32 backlog);
+Errno Shutdown(Socket socket, s32 how);
+Errno GetPeerName(Socket socket, SockAddrIn& address);
+Errno GetSockName(Socket socket, SockAddrIn& address);
+
+/// Accepts a connection on a listening socket, the new socket is non-blocking as well
+std::pair<Socket, Errno> Accept(Socket socket, SockAddrIn& address);
+
+/// Returns and clears the error left by an asynchronous operation, e.g. a non-blocking connect
+Errno GetPendingError(Socket socket);
+
+/**
+ * Receives data from a socket.
+ * @param flags Guest message flags, MSG_FLAG_DONTWAIT and MSG_FLAG_WAITALL are ignored.
+ * @param from If not null, the address the data came from is written to it.
+ * @returns The number of bytes received, or -1 and the error.
+ */
+std::pair<s32, Errno> Recv(Socket socket, u8* data, std::size_t size, u32 flags,
+                           SockAddrIn* from);
+
+/**
+ * Sends data through a socket.
+ * @param flags Guest message flags, MSG_FLAG_DONTWAIT and MSG_FLAG_WAITALL are ignored.
+ * @param to If not null, the address to send the data to.
+ * @returns The number of bytes sent, or -1 and the error.
+ */
+std::pair<s32, Errno> Send(Socket socket, const u8* data, std::size_t size, u32 flags,
+                           const SockAddrIn* to);
+
+/// Sets a socket option given with the guest's level, name and value layout
+Errno SetSockOpt(Socket socket, s32 level, s32 name, const u8* value, std::size_t size);
+
+/// Gets a socket option given with the guest's level and name, size is updated to the value's
+Errno GetSockOpt(Socket socket, s32 level, s32 name, u8* value, u32& size);
+
+/**
+ * Waits for events on a set of sockets.
+ * @param timeout Timeout in milliseconds, negative to wait forever.
+ * @returns The number of sockets with events, or -1 and the error.
+ */
+std::pair<s32, Errno> Poll(PollFD* fds, std::size_t count, s32 timeout);
+
+} // namespace Service::Sockets::Host
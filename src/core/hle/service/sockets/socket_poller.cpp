@@ -0,0 +1,135 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <iterator>
+#include <tuple>
+#include <utility>
+#include "common/assert.h"
+#include "common/logging/log.h"
+#include "core/hle/kernel/hle_worker.h"
+#include "core/hle/service/sockets/socket_poller.h"
+
+namespace Service::Sockets {
+
+constexpr u32 AF_INET_GUEST = 2;
+constexpr u32 SOCK_DGRAM_GUEST = 2;
+
+SocketPoller::SocketPoller() {
+    Host::Initialize();
+
+    // A datagram socket bound to the loopback interface, which the poller sends bytes to itself
+    // through to interrupt its own poll
+    Host::Errno result;
+    std::tie(wakeup_socket, result) = Host::CreateSocket(AF_INET_GUEST, SOCK_DGRAM_GUEST, 0);
+    ASSERT_MSG(result == Host::Errno::SUCCESS, "Could not create socket poller wakeup socket");
+
+    Host::SockAddrIn loopback{};
+    loopback.len = sizeof(loopback);
+    loopback.family = AF_INET_GUEST;
+    loopback.address = {127, 0, 0, 1};
+    result = Host::Bind(wakeup_socket, loopback);
+    ASSERT_MSG(result == Host::Errno::SUCCESS, "Could not bind socket poller wakeup socket");
+    Host::GetSockName(wakeup_socket, wakeup_address);
+
+    thread = std::thread([this] { Loop(); });
+}
+
+SocketPoller::~SocketPoller() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stop = true;
+    }
+    Interrupt();
+    thread.join();
+
+    Host::Close(wakeup_socket);
+    Host::Shutdown();
+}
+
+void SocketPoller::Wait(std::vector<Host::PollFD> fds, s32 timeout, Callback callback) {
+    Request request{std::move(fds), boost::none, std::move(callback)};
+    if (timeout >= 0) {
+        request.deadline = Clock::now() + std::chrono::milliseconds(timeout);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        new_requests.push_back(std::move(request));
+    }
+    Interrupt();
+}
+
+void SocketPoller::Interrupt() {
+    const u8 byte = 0;
+    Host::Send(wakeup_socket, &byte, sizeof(byte), 0, &wakeup_address);
+}
+
+void SocketPoller::Loop() {
+    std::vector<Request> requests;
+    std::vector<Host::PollFD> fds;
+
+    while (true) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (stop) {
+                return;
+            }
+            std::move(new_requests.begin(), new_requests.end(), std::back_inserter(requests));
+            new_requests.clear();
+        }
+
+        // Poll the wakeup socket and the sockets of every request at once, until the earliest
+        // deadline of any request
+        fds.clear();
+        fds.push_back({wakeup_socket, Host::POLL_IN, 0});
+        boost::optional<Clock::time_point> deadline;
+        for (const auto& request : requests) {
+            fds.insert(fds.end(), request.fds.begin(), request.fds.end());
+            if (request.deadline && (!deadline || *request.deadline < *deadline)) {
+                deadline = request.deadline;
+            }
+        }
+
+        s32 timeout = -1;
+        if (deadline) {
+            const auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(
+                *deadline - Clock::now() + std::chrono::milliseconds(1) -
+                std::chrono::nanoseconds(1));
+            timeout = static_cast<s32>(std::max<s64>(remaining.count(), 0));
+        }
+
+        if (Host::Poll(fds.data(), fds.size(), timeout).second != Host::Errno::SUCCESS) {
+            LOG_ERROR(Service, "Polling sockets failed");
+            continue;
+        }
+
+        if (fds[0].revents != 0) {
+            u8 byte;
+            while (Host::Recv(wakeup_socket, &byte, sizeof(byte), 0, nullptr).first > 0) {
+            }
+        }
+
+        // Hand every request that's ready or timed out back to the CPU thread
+        const auto now = Clock::now();
+        std::size_t fd_index = 1;
+        auto iter = requests.begin();
+        while (iter != requests.end()) {
+            const auto begin = fds.begin() + fd_index;
+            const auto end = begin + iter->fds.size();
+            fd_index += iter->fds.size();
+
+            const bool ready = std::any_of(
+                begin, end, [](const Host::PollFD& fd) { return fd.revents != 0; });
+            if (ready || (iter->deadline && *iter->deadline <= now)) {
+                Kernel::QueueHLECompletion(std::move(iter->callback));
+                iter = requests.erase(iter);
+            } else {
+                ++iter;
+            }
+        }
+    }
+}
+
+} // namespace Service::Sockets
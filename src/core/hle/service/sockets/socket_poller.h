@@ -0,0 +1,67 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <chrono>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <boost/optional.hpp>
+#include "common/common_types.h"
+#include "core/hle/service/sockets/host_socket.h"
+
+namespace Service::Sockets {
+
+/**
+ * Host thread waiting for events on the sockets that blocked guest calls are waiting on, all at
+ * once in a single poll. This lets the BSD service put the calling guest thread to sleep instead
+ * of blocking the emulated core, and resume it once its socket is ready.
+ */
+class SocketPoller final {
+public:
+    using Callback = std::function<void()>;
+
+    SocketPoller();
+    ~SocketPoller();
+
+    SocketPoller(const SocketPoller&) = delete;
+    SocketPoller& operator=(const SocketPoller&) = delete;
+
+    /**
+     * Waits in the background until any of the given sockets is ready for the events it asks for.
+     * @param fds Sockets and the guest poll events to wait for on each of them.
+     * @param timeout Timeout in milliseconds after which to give up, negative to wait forever.
+     * @param callback Function run on the CPU thread, with the HLE lock held, once any socket is
+     * ready or the timeout expired.
+     */
+    void Wait(std::vector<Host::PollFD> fds, s32 timeout, Callback callback);
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Request {
+        std::vector<Host::PollFD> fds;
+        boost::optional<Clock::time_point> deadline;
+        Callback callback;
+    };
+
+    void Loop();
+
+    /// Interrupts the poll of the poller thread, so that it picks up changes to the requests
+    void Interrupt();
+
+    /// Loopback socket the poller thread always polls, written to by Interrupt
+    Host::Socket wakeup_socket{};
+    Host::SockAddrIn wakeup_address{};
+
+    std::mutex mutex;
+    std::vector<Request> new_requests;
+    bool stop = false;
+
+    std::thread thread;
+};
+
+} // namespace Service::Sockets
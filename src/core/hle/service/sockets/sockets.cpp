@@ -6,13 +6,15 @@
 #include "core/hle/service/sockets/ethc.h"
 #include "core/hle/service/sockets/nsd.h"
 #include "core/hle/service/sockets/sfdnsres.h"
+#include "core/hle/service/sockets/socket_poller.h"
 #include "core/hle/service/sockets/sockets.h"
 
 namespace Service::Sockets {
 
 void InstallInterfaces(SM::ServiceManager& service_manager) {
-    std::make_shared<BSD>("bsd:s")->InstallAsService(service_manager);
-    std::make_shared<BSD>("bsd:u")->InstallAsService(service_manager);
+    auto poller = std::make_shared<SocketPoller>();
+    std::make_shared<BSD>("bsd:s", poller)->InstallAsService(service_manager);
+    std::make_shared<BSD>("bsd:u", poller)->InstallAsService(service_manager);
     std::make_shared<BSDCFG>()->InstallAsService(service_manager);
 
     std::make_shared<ETHC_C>()->InstallAsService(service_manager);
@@ -9,6 +9,8 @@
 
 namespace Service::Time {
 
+class SharedMemory;
+
 struct LocationName {
     std::array<u8, 0x24> name;
 };
@@ -55,6 +57,9 @@ static_assert(sizeof(SystemClockContext) == 0x20,
 
 class Module final {
 public:
+    Module();
+    ~Module();
+
     class Interface : public ServiceFramework<Interface> {
     public:
         explicit Interface(std::shared_ptr<Module> time, const char* name);
@@ -64,10 +69,14 @@ public:
         void GetStandardSteadyClock(Kernel::HLERequestContext& ctx);
         void GetTimeZoneService(Kernel::HLERequestContext& ctx);
         void GetStandardLocalSystemClock(Kernel::HLERequestContext& ctx);
+        void GetSharedMemoryNativeHandle(Kernel::HLERequestContext& ctx);
 
     protected:
         std::shared_ptr<Module> time;
     };
+
+private:
+    std::shared_ptr<SharedMemory> shared_memory;
 };
 
 /// Registers all Time services with the specified service manager.
@@ -0,0 +1,98 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <atomic>
+#include <chrono>
+#include "core/core_timing.h"
+#include "core/core_timing_util.h"
+#include "core/hle/kernel/shared_memory.h"
+#include "core/hle/service/time/time_sharedmemory.h"
+
+namespace Service::Time {
+
+constexpr u64 SHARED_MEMORY_SIZE = 0x1000;
+
+// Emulated time drifts away from host time, the system clock contexts are corrected for it this
+// often.
+constexpr u64 update_ticks = CoreTiming::BASE_CLOCK_RATE;
+
+template <typename Atomic, typename T>
+static void StoreToLockFreeAtomicType(Atomic& atomic, const T& value) {
+    const u32 counter = atomic.counter + 1;
+    atomic.storage[counter & 1] = value;
+    std::atomic_thread_fence(std::memory_order_release);
+    atomic.counter = counter;
+}
+
+template <typename Atomic>
+static auto LoadFromLockFreeAtomicType(const Atomic& atomic) {
+    // Only the CPU thread writes the page, and never while reading it
+    return atomic.storage[atomic.counter & 1];
+}
+
+/// Returns the time elapsed on the standard steady clock, in seconds
+static u64 GetSteadyClockSeconds() {
+    return CoreTiming::cyclesToMs(CoreTiming::GetTicks()) / 1000;
+}
+
+SharedMemory::SharedMemory() {
+    shared_memory_holder = Kernel::SharedMemory::Create(
+        nullptr, SHARED_MEMORY_SIZE, Kernel::MemoryPermission::ReadWrite,
+        Kernel::MemoryPermission::Read, 0, Kernel::MemoryRegion::BASE, "Time:SharedMemory");
+
+    // The steady clock starts at the system tick, it never needs updating
+    StoreToLockFreeAtomicType(GetFormat().standard_steady_clock_timepoint, SteadyClockContext{});
+    StoreToLockFreeAtomicType(GetFormat().standard_user_system_clock_automatic_correction, false);
+    UpdateSystemClockContexts();
+
+    update_event = CoreTiming::RegisterEvent(
+        "Time::UpdateSharedMemoryCallback",
+        [this](u64 userdata, int cycles_late) { UpdateCallback(userdata, cycles_late); });
+    CoreTiming::ScheduleEvent(update_ticks, update_event);
+}
+
+SharedMemory::~SharedMemory() {
+    CoreTiming::UnscheduleEvent(update_event, 0);
+}
+
+const Kernel::SharedPtr<Kernel::SharedMemory>& SharedMemory::GetSharedMemoryHolder() const {
+    return shared_memory_holder;
+}
+
+SteadyClockTimePoint SharedMemory::GetStandardSteadyClockTimePoint() const {
+    const auto context = LoadFromLockFreeAtomicType(GetFormat().standard_steady_clock_timepoint);
+    return {GetSteadyClockSeconds() + context.internal_offset / 1000000000};
+}
+
+SystemClockContext SharedMemory::GetStandardLocalSystemClockContext() const {
+    return LoadFromLockFreeAtomicType(GetFormat().standard_local_system_clock_context);
+}
+
+SystemClockContext SharedMemory::GetStandardNetworkSystemClockContext() const {
+    return LoadFromLockFreeAtomicType(GetFormat().standard_network_system_clock_context);
+}
+
+void SharedMemory::UpdateCallback(u64 userdata, int cycles_late) {
+    UpdateSystemClockContexts();
+    CoreTiming::ScheduleEvent(update_ticks - cycles_late, update_event);
+}
+
+void SharedMemory::UpdateSystemClockContexts() {
+    const s64 host_seconds{std::chrono::duration_cast<std::chrono::seconds>(
+                               std::chrono::system_clock::now().time_since_epoch())
+                               .count()};
+    const SteadyClockTimePoint time_point = GetStandardSteadyClockTimePoint();
+
+    // System clocks are an offset from the steady clock
+    const SystemClockContext context{static_cast<u64>(host_seconds) - time_point.value,
+                                     time_point};
+    StoreToLockFreeAtomicType(GetFormat().standard_local_system_clock_context, context);
+    StoreToLockFreeAtomicType(GetFormat().standard_network_system_clock_context, context);
+}
+
+SharedMemory::Format& SharedMemory::GetFormat() const {
+    return *reinterpret_cast<Format*>(shared_memory_holder->GetPointer());
+}
+
+} // namespace Service::Time
@@ -0,0 +1,85 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <array>
+#include "common/common_types.h"
+#include "common/swap.h"
+#include "core/hle/kernel/kernel.h"
+#include "core/hle/service/time/time.h"
+
+namespace CoreTiming {
+struct EventType;
+}
+
+namespace Kernel {
+class SharedMemory;
+}
+
+namespace Service::Time {
+
+/**
+ * The shared memory page of the time services, holding the contexts of the standard clocks so
+ * that guests can read the current time without an IPC round-trip. The service's own clocks read
+ * the same contexts.
+ */
+class SharedMemory final {
+public:
+    SharedMemory();
+    ~SharedMemory();
+
+    SharedMemory(const SharedMemory&) = delete;
+    SharedMemory& operator=(const SharedMemory&) = delete;
+
+    /// Returns the kernel object backing the page, to be handed out to guests
+    const Kernel::SharedPtr<Kernel::SharedMemory>& GetSharedMemoryHolder() const;
+
+    /// Returns the current time point of the standard steady clock
+    SteadyClockTimePoint GetStandardSteadyClockTimePoint() const;
+
+    /// Returns the context of the standard local and user system clocks
+    SystemClockContext GetStandardLocalSystemClockContext() const;
+
+    /// Returns the context of the standard network system clock
+    SystemClockContext GetStandardNetworkSystemClockContext() const;
+
+private:
+    struct SteadyClockContext {
+        u64_le internal_offset; // Nanoseconds added to the system tick to get the steady time
+        std::array<u8, 0x10> clock_source_id;
+    };
+    static_assert(sizeof(SteadyClockContext) == 0x18, "SteadyClockContext is incorrect size");
+
+    /**
+     * Value guests read without locking: the writer fills in the slot the counter doesn't point
+     * to and then advances the counter, readers retry whenever the counter changed under them.
+     */
+    template <typename T>
+    struct LockFreeAtomicType {
+        u32_le counter;
+        std::array<T, 2> storage;
+    };
+
+    struct Format {
+        LockFreeAtomicType<SteadyClockContext> standard_steady_clock_timepoint;
+        LockFreeAtomicType<SystemClockContext> standard_local_system_clock_context;
+        LockFreeAtomicType<SystemClockContext> standard_network_system_clock_context;
+        LockFreeAtomicType<bool> standard_user_system_clock_automatic_correction;
+    };
+    static_assert(sizeof(Format) == 0xD0, "Time shared memory format is incorrect size");
+
+    /// Recomputes the system clock contexts from the host clock, rescheduling itself
+    void UpdateCallback(u64 userdata, int cycles_late);
+
+    /// Writes the system clock contexts matching the current host time
+    void UpdateSystemClockContexts();
+
+    Format& GetFormat() const;
+
+    Kernel::SharedPtr<Kernel::SharedMemory> shared_memory_holder;
+    CoreTiming::EventType* update_event;
+};
+
+} // namespace Service::Time
@@ -35,21 +35,31 @@ struct DisplayInfo {
 };
 static_assert(sizeof(DisplayInfo) == 0x60, "DisplayInfo has wrong size");
 
+/**
+ * Binder parcel, read in place from an IPC input buffer or written to a buffer of its own, so
+ * neither direction needs heap allocations. Transactions of the buffer queue run several times
+ * per frame.
+ */
 class Parcel {
 public:
     // This default size was chosen arbitrarily.
     static constexpr size_t DefaultBufferSize = 0x40;
-    Parcel() : buffer(DefaultBufferSize) {}
-    explicit Parcel(std::vector<u8> data) : buffer(std::move(data)) {}
+    /// Room for the largest parcel written, a buffer too small for one asserts
+    static constexpr size_t MaxBufferSize = 0x400;
+
+    Parcel() = default;
+    /// Reads from input, which must stay valid while the parcel is deserialized
+    explicit Parcel(const Kernel::InputBufferView& input)
+        : read_data(input.data()), read_size(input.size()) {}
     virtual ~Parcel() = default;
 
     template <typename T>
     T Read() {
         static_assert(std::is_trivially_copyable_v<T>, "T must be trivially copyable.");
-        ASSERT(read_index + sizeof(T) <= buffer.size());
+        ASSERT(read_index + sizeof(T) <= read_size);
 
         T val;
-        std::memcpy(&val, buffer.data() + read_index, sizeof(T));
+        std::memcpy(&val, read_data + read_index, sizeof(T));
         read_index += sizeof(T);
         read_index = Common::AlignUp(read_index, 4);
         return val;
@@ -58,45 +68,39 @@ public:
     template <typename T>
     T ReadUnaligned() {
         static_assert(std::is_trivially_copyable_v<T>, "T must be trivially copyable.");
-        ASSERT(read_index + sizeof(T) <= buffer.size());
+        ASSERT(read_index + sizeof(T) <= read_size);
 
         T val;
-        std::memcpy(&val, buffer.data() + read_index, sizeof(T));
+        std::memcpy(&val, read_data + read_index, sizeof(T));
         read_index += sizeof(T);
         return val;
     }
 
-    std::vector<u8> ReadBlock(size_t length) {
-        ASSERT(read_index + length <= buffer.size());
-        const u8* const begin = buffer.data() + read_index;
-        const u8* const end = begin + length;
-        std::vector<u8> data(begin, end);
+    /// Returns a pointer to the next length bytes of the input, valid as long as the input is
+    const u8* ReadBlock(size_t length) {
+        ASSERT(read_index + length <= read_size);
+        const u8* const begin = read_data + read_index;
         read_index += length;
         read_index = Common::AlignUp(read_index, 4);
-        return data;
+        return begin;
     }
 
-    std::u16string ReadInterfaceToken() {
-        u32 unknown = Read<u32_le>();
-        u32 length = Read<u32_le>();
-
-        std::u16string token{};
-
-        for (u32 ch = 0; ch < length + 1; ++ch) {
-            token.push_back(ReadUnaligned<u16_le>());
-        }
-
-        read_index = Common::AlignUp(read_index, 4);
+    /// Skips the interface token, which no transaction needs to look at
+    void SkipInterfaceToken() {
+        Read<u32_le>(); // Unknown
+        const u32 length = Read<u32_le>();
 
-        return token;
+        // The token is a NUL terminated UTF-16 string
+        ReadBlock((length + 1) * sizeof(u16));
     }
 
     template <typename T>
     void Write(const T& val) {
         static_assert(std::is_trivially_copyable_v<T>, "T must be trivially copyable.");
 
-        if (buffer.size() < write_index + sizeof(T)) {
-            buffer.resize(buffer.size() + sizeof(T) + DefaultBufferSize);
+        if (buffer_size < write_index + sizeof(T)) {
+            buffer_size += sizeof(T) + DefaultBufferSize;
+            ASSERT_MSG(buffer_size <= buffer.size(), "Parcel exceeds the maximum size");
         }
 
         std::memcpy(buffer.data() + write_index, &val, sizeof(T));
@@ -116,16 +120,17 @@ public:
     }
 
     void Deserialize() {
-        ASSERT(buffer.size() > sizeof(Header));
+        ASSERT(read_size > sizeof(Header));
 
         Header header{};
-        std::memcpy(&header, buffer.data(), sizeof(Header));
+        std::memcpy(&header, read_data, sizeof(Header));
 
         read_index = header.data_offset;
         DeserializeData();
     }
 
-    std::vector<u8> Serialize() {
+    /// Serializes the parcel into the output buffer of ctx, returning the number of bytes written
+    size_t Serialize(const Kernel::HLERequestContext& ctx) {
         ASSERT(read_index == 0);
         write_index = sizeof(Header);
 
@@ -138,7 +143,7 @@ public:
         header.objects_offset = sizeof(Header) + header.data_size;
         std::memcpy(buffer.data(), &header, sizeof(Header));
 
-        return buffer;
+        return ctx.WriteBuffer(buffer.data(), buffer_size);
     }
 
 protected:
@@ -155,8 +160,14 @@ private:
     };
     static_assert(sizeof(Header) == 16, "ParcelHeader has wrong size");
 
-    std::vector<u8> buffer;
+    const u8* read_data = nullptr;
+    size_t read_size = 0;
     size_t read_index = 0;
+
+    /// Zeroed, as the whole buffer_size bytes are sent even when fewer were written
+    std::array<u8, MaxBufferSize> buffer{};
+    /// Grows in steps like a vector resized on demand would, which guests see in the sent size
+    size_t buffer_size = DefaultBufferSize;
     size_t write_index = 0;
 };
 
@@ -188,13 +199,13 @@ private:
 
 class IGBPConnectRequestParcel : public Parcel {
 public:
-    explicit IGBPConnectRequestParcel(std::vector<u8> buffer) : Parcel(std::move(buffer)) {
+    explicit IGBPConnectRequestParcel(const Kernel::InputBufferView& input) : Parcel(input) {
         Deserialize();
     }
     ~IGBPConnectRequestParcel() override = default;
 
     void DeserializeData() override {
-        std::u16string token = ReadInterfaceToken();
+        SkipInterfaceToken();
         data = Read<Data>();
     }
 
@@ -235,14 +246,14 @@ private:
 
 class IGBPSetPreallocatedBufferRequestParcel : public Parcel {
 public:
-    explicit IGBPSetPreallocatedBufferRequestParcel(std::vector<u8> buffer)
-        : Parcel(std::move(buffer)) {
+    explicit IGBPSetPreallocatedBufferRequestParcel(const Kernel::InputBufferView& input)
+        : Parcel(input) {
         Deserialize();
     }
     ~IGBPSetPreallocatedBufferRequestParcel() override = default;
 
     void DeserializeData() override {
-        std::u16string token = ReadInterfaceToken();
+        SkipInterfaceToken();
         data = Read<Data>();
         buffer = Read<NVFlinger::IGBPBuffer>();
     }
@@ -268,13 +279,13 @@ protected:
 
 class IGBPDequeueBufferRequestParcel : public Parcel {
 public:
-    explicit IGBPDequeueBufferRequestParcel(std::vector<u8> buffer) : Parcel(std::move(buffer)) {
+    explicit IGBPDequeueBufferRequestParcel(const Kernel::InputBufferView& input) : Parcel(input) {
         Deserialize();
     }
     ~IGBPDequeueBufferRequestParcel() override = default;
 
     void DeserializeData() override {
-        std::u16string token = ReadInterfaceToken();
+        SkipInterfaceToken();
         data = Read<Data>();
     }
 
@@ -319,13 +330,13 @@ protected:
 
 class IGBPRequestBufferRequestParcel : public Parcel {
 public:
-    explicit IGBPRequestBufferRequestParcel(std::vector<u8> buffer) : Parcel(std::move(buffer)) {
+    explicit IGBPRequestBufferRequestParcel(const Kernel::InputBufferView& input) : Parcel(input) {
         Deserialize();
     }
     ~IGBPRequestBufferRequestParcel() override = default;
 
     void DeserializeData() override {
-        std::u16string token = ReadInterfaceToken();
+        SkipInterfaceToken();
         slot = Read<u32_le>();
     }
 
@@ -351,13 +362,13 @@ protected:
 
 class IGBPQueueBufferRequestParcel : public Parcel {
 public:
-    explicit IGBPQueueBufferRequestParcel(std::vector<u8> buffer) : Parcel(std::move(buffer)) {
+    explicit IGBPQueueBufferRequestParcel(const Kernel::InputBufferView& input) : Parcel(input) {
         Deserialize();
     }
     ~IGBPQueueBufferRequestParcel() override = default;
 
     void DeserializeData() override {
-        std::u16string token = ReadInterfaceToken();
+        SkipInterfaceToken();
         data = Read<Data>();
     }
 
@@ -386,6 +397,15 @@ public:
         MathUtil::Rectangle<int> GetCropRect() const {
             return {crop_left, crop_top, crop_right, crop_bottom};
         }
+
+        NVFlinger::BufferQueue::MultiFence GetFence() const {
+            NVFlinger::BufferQueue::MultiFence fence{};
+            fence.num_fences = std::min<u32>(fence_is_valid, static_cast<u32>(fences.size()));
+            for (size_t i = 0; i < fences.size(); ++i) {
+                fence.fences[i] = {fences[i].id, fences[i].value};
+            }
+            return fence;
+        }
     };
     static_assert(sizeof(Data) == 80, "ParcelData has wrong size");
 
@@ -420,13 +440,13 @@ private:
 
 class IGBPQueryRequestParcel : public Parcel {
 public:
-    explicit IGBPQueryRequestParcel(std::vector<u8> buffer) : Parcel(std::move(buffer)) {
+    explicit IGBPQueryRequestParcel(const Kernel::InputBufferView& input) : Parcel(input) {
         Deserialize();
     }
     ~IGBPQueryRequestParcel() override = default;
 
     void DeserializeData() override {
-        std::u16string token = ReadInterfaceToken();
+        SkipInterfaceToken();
         type = Read<u32_le>();
     }
 
@@ -489,18 +509,18 @@ private:
         LOG_DEBUG(Service_VI, "called, transaction={:X}", static_cast<u32>(transaction));
 
         if (transaction == TransactionId::Connect) {
-            IGBPConnectRequestParcel request{ctx.ReadBuffer()};
+            IGBPConnectRequestParcel request{ctx.ReadBufferView()};
             IGBPConnectResponseParcel response{1280, 720};
-            ctx.WriteBuffer(response.Serialize());
+            response.Serialize(ctx);
         } else if (transaction == TransactionId::SetPreallocatedBuffer) {
-            IGBPSetPreallocatedBufferRequestParcel request{ctx.ReadBuffer()};
+            IGBPSetPreallocatedBufferRequestParcel request{ctx.ReadBufferView()};
 
             buffer_queue->SetPreallocatedBuffer(request.data.slot, request.buffer);
 
             IGBPSetPreallocatedBufferResponseParcel response{};
-            ctx.WriteBuffer(response.Serialize());
+            response.Serialize(ctx);
         } else if (transaction == TransactionId::DequeueBuffer) {
-            IGBPDequeueBufferRequestParcel request{ctx.ReadBuffer()};
+            IGBPDequeueBufferRequestParcel request{ctx.ReadBufferView()};
             const u32 width{request.data.width};
             const u32 height{request.data.height};
             boost::optional<u32> slot = buffer_queue->DequeueBuffer(width, height);
@@ -508,7 +528,7 @@ private:
             if (slot != boost::none) {
                 // Buffer is available
                 IGBPDequeueBufferResponseParcel response{*slot};
-                ctx.WriteBuffer(response.Serialize());
+                response.Serialize(ctx);
             } else {
                 // Wait the current thread until a buffer becomes available
                 ctx.SleepClientThread(
@@ -519,35 +539,35 @@ private:
                         auto buffer_queue = nv_flinger->GetBufferQueue(id);
                         boost::optional<u32> slot = buffer_queue->DequeueBuffer(width, height);
                         IGBPDequeueBufferResponseParcel response{*slot};
-                        ctx.WriteBuffer(response.Serialize());
+                        response.Serialize(ctx);
                         IPC::ResponseBuilder rb{ctx, 2};
                         rb.Push(RESULT_SUCCESS);
                     },
                     buffer_queue->GetBufferWaitEvent());
             }
         } else if (transaction == TransactionId::RequestBuffer) {
-            IGBPRequestBufferRequestParcel request{ctx.ReadBuffer()};
+            IGBPRequestBufferRequestParcel request{ctx.ReadBufferView()};
 
             auto& buffer = buffer_queue->RequestBuffer(request.slot);
 
             IGBPRequestBufferResponseParcel response{buffer};
-            ctx.WriteBuffer(response.Serialize());
+            response.Serialize(ctx);
         } else if (transaction == TransactionId::QueueBuffer) {
-            IGBPQueueBufferRequestParcel request{ctx.ReadBuffer()};
+            IGBPQueueBufferRequestParcel request{ctx.ReadBufferView()};
 
             buffer_queue->QueueBuffer(request.data.slot, request.data.transform,
-                                      request.data.GetCropRect());
+                                      request.data.GetCropRect(), request.data.GetFence());
 
             IGBPQueueBufferResponseParcel response{1280, 720};
-            ctx.WriteBuffer(response.Serialize());
+            response.Serialize(ctx);
         } else if (transaction == TransactionId::Query) {
-            IGBPQueryRequestParcel request{ctx.ReadBuffer()};
+            IGBPQueryRequestParcel request{ctx.ReadBufferView()};
 
             u32 value =
                 buffer_queue->Query(static_cast<NVFlinger::BufferQueue::QueryType>(request.type));
 
             IGBPQueryResponseParcel response{value};
-            ctx.WriteBuffer(response.Serialize());
+            response.Serialize(ctx);
         } else if (transaction == TransactionId::CancelBuffer) {
             LOG_CRITICAL(Service_VI, "(STUBBED) called, transaction=CancelBuffer");
         } else {
@@ -902,7 +922,7 @@ private:
         NativeWindow native_window{buffer_queue_id};
         IPC::ResponseBuilder rb = rp.MakeBuilder(4, 0, 0);
         rb.Push(RESULT_SUCCESS);
-        rb.Push<u64>(ctx.WriteBuffer(native_window.Serialize()));
+        rb.Push<u64>(native_window.Serialize(ctx));
     }
 
     void CreateStrayLayer(Kernel::HLERequestContext& ctx) {
@@ -922,7 +942,7 @@ private:
         IPC::ResponseBuilder rb = rp.MakeBuilder(6, 0, 0);
         rb.Push(RESULT_SUCCESS);
         rb.Push(layer_id);
-        rb.Push<u64>(ctx.WriteBuffer(native_window.Serialize()));
+        rb.Push<u64>(native_window.Serialize(ctx));
     }
 
     void DestroyStrayLayer(Kernel::HLERequestContext& ctx) {
@@ -103,19 +103,30 @@ ResultStatus AppLoader_DeconstructedRomDirectory::Load(
     }
 
     // Load NSO modules
-    VAddr next_load_addr{Memory::PROCESS_IMAGE_VADDR};
+    std::vector<const char*> module_names;
+    std::vector<FileSys::VirtualFile> module_files;
     for (const auto& module : {"rtld", "main", "subsdk0", "subsdk1", "subsdk2", "subsdk3",
                                "subsdk4", "subsdk5", "subsdk6", "subsdk7", "sdk"}) {
-        const FileSys::VirtualFile module_file = dir->GetFile(module);
+        FileSys::VirtualFile module_file = dir->GetFile(module);
         if (module_file != nullptr) {
-            const VAddr load_addr = next_load_addr;
-            next_load_addr = AppLoader_NSO::LoadModule(module_file, load_addr);
-            LOG_DEBUG(Loader, "loaded module {} @ 0x{:X}", module, load_addr);
-            // Register module with GDBStub
-            GDBStub::RegisterModule(module, load_addr, next_load_addr - 1, false);
+            module_names.push_back(module);
+            module_files.push_back(std::move(module_file));
         }
     }
 
+    const std::vector<VAddr> end_addrs =
+        AppLoader_NSO::LoadModules(module_files, Memory::PROCESS_IMAGE_VADDR);
+    VAddr next_load_addr{Memory::PROCESS_IMAGE_VADDR};
+    for (std::size_t i = 0; i < module_names.size(); ++i) {
+        const VAddr load_addr = next_load_addr;
+        next_load_addr = end_addrs[i];
+        if (next_load_addr == load_addr)
+            continue;
+        LOG_DEBUG(Loader, "loaded module {} @ 0x{:X}", module_names[i], load_addr);
+        // Register module with GDBStub
+        GDBStub::RegisterModule(module_names[i], load_addr, next_load_addr - 1, false);
+    }
+
     title_id = metadata.GetTitleID();
     process->program_id = metadata.GetTitleID();
     process->svc_access_mask.set();
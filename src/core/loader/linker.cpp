@@ -48,12 +48,28 @@ struct Elf64_Sym {
 };
 static_assert(sizeof(Elf64_Sym) == 0x18, "Elf64_Sym has incorrect size.");
 
+size_t Linker::SymbolNameHash::operator()(const std::string& name) const {
+    u32 hash = 5381;
+    for (const char c : name) {
+        hash = hash * 33 + static_cast<u8>(c);
+    }
+    return hash;
+}
+
 void Linker::WriteRelocations(std::vector<u8>& program_image, const std::vector<Symbol>& symbols,
                               u64 relocation_offset, u64 size, VAddr load_base) {
     for (u64 i = 0; i < size; i += sizeof(Elf64_Rela)) {
         Elf64_Rela rela;
         std::memcpy(&rela, &program_image[relocation_offset + i], sizeof(Elf64_Rela));
 
+        // Most relocations of a module are RELATIVE ones against the null symbol, which neither
+        // import nor export anything, so they skip the symbol table entirely
+        if (rela.type == RelocationType::RELATIVE && rela.symbol == 0) {
+            const u64 value = load_base + rela.addend;
+            std::memcpy(&program_image[rela.offset], &value, sizeof(u64));
+            continue;
+        }
+
         const Symbol& symbol = symbols[rela.symbol];
         switch (rela.type) {
         case RelocationType::RELATIVE: {
@@ -6,12 +6,19 @@
 
 #include <map>
 #include <string>
+#include <unordered_map>
+#include <vector>
 #include "common/common_types.h"
 
 namespace Loader {
 
 class Linker {
 protected:
+    /// Hashes symbol names with the function the ELF DT_GNU_HASH section uses, h * 33 + c
+    struct SymbolNameHash {
+        size_t operator()(const std::string& name) const;
+    };
+
     struct Symbol {
         Symbol(std::string&& name, u64 value) : name(std::move(name)), value(value) {}
         std::string name;
@@ -29,8 +36,8 @@ protected:
 
     void ResolveImports();
 
-    std::map<std::string, Import> imports;
-    std::map<std::string, VAddr> exports;
+    std::unordered_map<std::string, Import, SymbolNameHash> imports;
+    std::unordered_map<std::string, VAddr, SymbolNameHash> exports;
 };
 
 } // namespace Loader
@@ -7,7 +7,12 @@
 #include <string>
 #include "common/logging/log.h"
 #include "common/string_util.h"
+#include "core/file_sys/card_image.h"
+#include "core/file_sys/content_archive.h"
+#include "core/file_sys/submission_package.h"
+#include "core/file_sys/vfs_cached.h"
 #include "core/file_sys/vfs_real.h"
+#include "core/file_sys/xts_archive.h"
 #include "core/hle/kernel/process.h"
 #include "core/loader/deconstructed_rom_directory.h"
 #include "core/loader/elf.h"
@@ -20,7 +25,16 @@
 
 namespace Loader {
 
-FileType IdentifyFile(FileSys::VirtualFile file) {
+/// Bytes at the start of a file read once for all probes while identifying it, enough for the
+/// headers of every format as well as the partition table of an XCI
+constexpr size_t IDENTIFICATION_HEAD_SIZE = 0x10000;
+
+static FileSys::VirtualFile CreateIdentificationFile(FileSys::VirtualFile file) {
+    return std::make_shared<FileSys::HeadCachedVfsFile>(std::move(file), IDENTIFICATION_HEAD_SIZE);
+}
+
+FileType IdentifyFile(FileSys::VirtualFile file_) {
+    const FileSys::VirtualFile file = CreateIdentificationFile(std::move(file_));
     FileType type;
 
 #define CHECK_TYPE(loader)                                                                         \
@@ -198,8 +212,60 @@ static std::unique_ptr<AppLoader> GetFileLoader(FileSys::VirtualFile file, FileT
     }
 }
 
+/**
+ * Identifies file like IdentifyFile, and creates the loader for it. The containers parsed to tell
+ * the formats apart are handed to that loader, so none of them is parsed twice.
+ * @return The loader, or nullptr if the file wasn't identified (type is then Unknown)
+ */
+static std::unique_ptr<AppLoader> IdentifyAndCreateLoader(const FileSys::VirtualFile& file,
+                                                          FileType& type) {
+    // These only look at a magic, parsing them again is cheap
+#define CHECK_TYPE(loader)                                                                         \
+    type = AppLoader_##loader::IdentifyType(file);                                                 \
+    if (FileType::Error != type)                                                                   \
+        return std::make_unique<AppLoader_##loader>(file);
+
+    CHECK_TYPE(DeconstructedRomDirectory)
+    CHECK_TYPE(ELF)
+    CHECK_TYPE(NSO)
+    CHECK_TYPE(NRO)
+
+#undef CHECK_TYPE
+
+    auto nca = std::make_shared<FileSys::NCA>(file);
+    type = AppLoader_NCA::IdentifyType(*nca);
+    if (FileType::Error != type)
+        return std::make_unique<AppLoader_NCA>(std::move(nca));
+    nca.reset();
+
+    auto xci = std::make_unique<FileSys::XCI>(file);
+    type = AppLoader_XCI::IdentifyType(*xci);
+    if (FileType::Error != type)
+        return std::make_unique<AppLoader_XCI>(file, std::move(xci));
+    xci.reset();
+
+    auto nax = std::make_unique<FileSys::NAX>(file);
+    auto nax_nca = nax->AsNCA();
+    type = AppLoader_NAX::IdentifyType(*nax, nax_nca.get());
+    if (FileType::Error != type)
+        return std::make_unique<AppLoader_NAX>(file, std::move(nax), std::move(nax_nca));
+    nax_nca.reset();
+    nax.reset();
+
+    auto nsp = std::make_unique<FileSys::NSP>(file);
+    type = AppLoader_NSP::IdentifyType(*nsp);
+    if (FileType::Error != type)
+        return std::make_unique<AppLoader_NSP>(file, std::move(nsp));
+
+    type = FileType::Unknown;
+    return nullptr;
+}
+
 std::unique_ptr<AppLoader> GetLoader(FileSys::VirtualFile file) {
-    FileType type = IdentifyFile(file);
+    file = CreateIdentificationFile(std::move(file));
+
+    FileType type;
+    std::unique_ptr<AppLoader> loader = IdentifyAndCreateLoader(file, type);
     FileType filename_type = GuessFromFilename(file->GetName());
 
     // Special case: 00 is either a NCA or NAX.
@@ -211,6 +277,8 @@ std::unique_ptr<AppLoader> GetLoader(FileSys::VirtualFile file) {
 
     LOG_DEBUG(Loader, "Loading file {} as {}...", file->GetName(), GetFileTypeString(type));
 
+    if (loader != nullptr)
+        return loader;
     return GetFileLoader(std::move(file), type);
 }
 
@@ -132,6 +132,14 @@ public:
      */
     virtual ResultStatus Load(Kernel::SharedPtr<Kernel::Process>& process) = 0;
 
+    /**
+     * Allows the application to be loaded again, into a new process. What the loader parsed and
+     * decrypted from the file is kept, so loading it again is cheaper than the first time.
+     */
+    virtual void MarkUnloaded() {
+        is_loaded = false;
+    }
+
     /**
      * Loads the system mode that this application needs.
      * This function defaults to 2 (96MB allocated to the application) if it can't read the
@@ -13,16 +13,27 @@
 namespace Loader {
 
 AppLoader_NAX::AppLoader_NAX(FileSys::VirtualFile file)
-    : AppLoader(file), nax(std::make_unique<FileSys::NAX>(file)),
-      nca_loader(std::make_unique<AppLoader_NCA>(nax->GetDecrypted())) {}
+    : AppLoader(file), nax(std::make_unique<FileSys::NAX>(file)), nca(nax->AsNCA()),
+      nca_loader(nca == nullptr ? std::make_unique<AppLoader_NCA>(nax->GetDecrypted())
+                                : std::make_unique<AppLoader_NCA>(nca)) {}
+
+AppLoader_NAX::AppLoader_NAX(FileSys::VirtualFile file, std::unique_ptr<FileSys::NAX> nax_,
+                             std::shared_ptr<FileSys::NCA> nca_)
+    : AppLoader(std::move(file)), nax(std::move(nax_)), nca(std::move(nca_)),
+      nca_loader(nca == nullptr ? std::make_unique<AppLoader_NCA>(nax->GetDecrypted())
+                                : std::make_unique<AppLoader_NCA>(nca)) {}
 
 AppLoader_NAX::~AppLoader_NAX() = default;
 
 FileType AppLoader_NAX::IdentifyType(const FileSys::VirtualFile& file) {
-    FileSys::NAX nax(file);
+    const FileSys::NAX nax(file);
+    const auto nca = nax.AsNCA();
+    return IdentifyType(nax, nca.get());
+}
 
-    if (nax.GetStatus() == ResultStatus::Success && nax.AsNCA() != nullptr &&
-        nax.AsNCA()->GetStatus() == ResultStatus::Success) {
+FileType AppLoader_NAX::IdentifyType(const FileSys::NAX& nax, const FileSys::NCA* nca) {
+    if (nax.GetStatus() == ResultStatus::Success && nca != nullptr &&
+        nca->GetStatus() == ResultStatus::Success) {
         return FileType::NAX;
     }
 
@@ -37,7 +48,6 @@ ResultStatus AppLoader_NAX::Load(Kernel::SharedPtr<Kernel::Process>& process) {
     if (nax->GetStatus() != ResultStatus::Success)
         return nax->GetStatus();
 
-    const auto nca = nax->AsNCA();
     if (nca == nullptr) {
         if (!Core::Crypto::KeyManager::KeyFileExists(false))
             return ResultStatus::ErrorMissingProductionKeyFile;
@@ -56,6 +66,11 @@ ResultStatus AppLoader_NAX::Load(Kernel::SharedPtr<Kernel::Process>& process) {
     return ResultStatus::Success;
 }
 
+void AppLoader_NAX::MarkUnloaded() {
+    AppLoader::MarkUnloaded();
+    nca_loader->MarkUnloaded();
+}
+
 ResultStatus AppLoader_NAX::ReadRomFS(FileSys::VirtualFile& dir) {
     return nca_loader->ReadRomFS(dir);
 }
@@ -11,6 +11,7 @@
 namespace FileSys {
 
 class NAX;
+class NCA;
 
 } // namespace FileSys
 
@@ -22,6 +23,9 @@ class AppLoader_NCA;
 class AppLoader_NAX final : public AppLoader {
 public:
     explicit AppLoader_NAX(FileSys::VirtualFile file);
+    /// Takes over the NAX of file and the NCA within parsed already, e.g. while identifying it
+    AppLoader_NAX(FileSys::VirtualFile file, std::unique_ptr<FileSys::NAX> nax,
+                  std::shared_ptr<FileSys::NCA> nca);
     ~AppLoader_NAX() override;
 
     /**
@@ -31,17 +35,25 @@ public:
      */
     static FileType IdentifyType(const FileSys::VirtualFile& file);
 
+    /**
+     * Returns the type of a NAX parsed already, see IdentifyType(const VirtualFile&)
+     * @param nca The NCA within nax, from NAX::AsNCA
+     */
+    static FileType IdentifyType(const FileSys::NAX& nax, const FileSys::NCA* nca);
+
     FileType GetFileType() override {
-        return IdentifyType(file);
+        return IdentifyType(*nax, nca.get());
     }
 
     ResultStatus Load(Kernel::SharedPtr<Kernel::Process>& process) override;
+    void MarkUnloaded() override;
 
     ResultStatus ReadRomFS(FileSys::VirtualFile& dir) override;
     ResultStatus ReadProgramId(u64& out_program_id) override;
 
 private:
     std::unique_ptr<FileSys::NAX> nax;
+    std::shared_ptr<FileSys::NCA> nca;
     std::unique_ptr<AppLoader_NCA> nca_loader;
 };
 
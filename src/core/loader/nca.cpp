@@ -16,13 +16,19 @@
 namespace Loader {
 
 AppLoader_NCA::AppLoader_NCA(FileSys::VirtualFile file_)
-    : AppLoader(std::move(file_)), nca(std::make_unique<FileSys::NCA>(file)) {}
+    : AppLoader(std::move(file_)), nca(std::make_shared<FileSys::NCA>(file)) {}
+
+AppLoader_NCA::AppLoader_NCA(std::shared_ptr<FileSys::NCA> nca_)
+    : AppLoader(nca_ == nullptr ? nullptr : nca_->GetBaseFile()),
+      nca(nca_ == nullptr ? std::make_shared<FileSys::NCA>(nullptr) : std::move(nca_)) {}
 
 AppLoader_NCA::~AppLoader_NCA() = default;
 
 FileType AppLoader_NCA::IdentifyType(const FileSys::VirtualFile& file) {
-    FileSys::NCA nca(file);
+    return IdentifyType(FileSys::NCA(file));
+}
 
+FileType AppLoader_NCA::IdentifyType(const FileSys::NCA& nca) {
     if (nca.GetStatus() == ResultStatus::Success &&
         nca.GetType() == FileSys::NCAContentType::Program)
         return FileType::NCA;
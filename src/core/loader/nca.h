@@ -21,6 +21,8 @@ class AppLoader_DeconstructedRomDirectory;
 class AppLoader_NCA final : public AppLoader {
 public:
     explicit AppLoader_NCA(FileSys::VirtualFile file);
+    /// Takes over an NCA parsed already, e.g. while identifying the file or a container of it
+    explicit AppLoader_NCA(std::shared_ptr<FileSys::NCA> nca);
     ~AppLoader_NCA() override;
 
     /**
@@ -30,8 +32,11 @@ public:
      */
     static FileType IdentifyType(const FileSys::VirtualFile& file);
 
+    /// Returns the type of an NCA parsed already, see IdentifyType(const VirtualFile&)
+    static FileType IdentifyType(const FileSys::NCA& nca);
+
     FileType GetFileType() override {
-        return IdentifyType(file);
+        return IdentifyType(*nca);
     }
 
     ResultStatus Load(Kernel::SharedPtr<Kernel::Process>& process) override;
@@ -40,7 +45,7 @@ public:
     ResultStatus ReadProgramId(u64& out_program_id) override;
 
 private:
-    std::unique_ptr<FileSys::NCA> nca;
+    std::shared_ptr<FileSys::NCA> nca;
     std::unique_ptr<AppLoader_DeconstructedRomDirectory> directory_loader;
 };
 
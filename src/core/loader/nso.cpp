@@ -2,13 +2,18 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
 #include <cinttypes>
+#include <cstring>
 #include <vector>
+#include <boost/optional.hpp>
 #include <lz4.h>
 #include "common/common_funcs.h"
 #include "common/file_util.h"
 #include "common/logging/log.h"
 #include "common/swap.h"
+#include "common/thread_pool.h"
+#include "core/boot_timeline.h"
 #include "core/core.h"
 #include "core/gdbstub/gdbstub.h"
 #include "core/hle/kernel/process.h"
@@ -66,51 +71,64 @@ FileType AppLoader_NSO::IdentifyType(const FileSys::VirtualFile& file) {
     return FileType::NSO;
 }
 
-static std::vector<u8> DecompressSegment(const std::vector<u8>& compressed_data,
-                                         const NsoSegmentHeader& header) {
-    std::vector<u8> uncompressed_data(header.size);
-    const int bytes_uncompressed =
-        LZ4_decompress_safe(reinterpret_cast<const char*>(compressed_data.data()),
-                            reinterpret_cast<char*>(uncompressed_data.data()),
-                            static_cast<int>(compressed_data.size()), header.size);
-
-    ASSERT_MSG(bytes_uncompressed == static_cast<int>(header.size) &&
-                   bytes_uncompressed == static_cast<int>(uncompressed_data.size()),
-               "{} != {} != {}", bytes_uncompressed, header.size, uncompressed_data.size());
-
-    return uncompressed_data;
-}
-
 static constexpr u32 PageAlignSize(u32 size) {
     return (size + Memory::PAGE_MASK) & ~Memory::PAGE_MASK;
 }
 
-VAddr AppLoader_NSO::LoadModule(FileSys::VirtualFile file, VAddr load_base) {
-    if (file == nullptr)
-        return {};
+namespace {
+/// An NSO whose segments are decompressed into program_image before it is loaded
+struct PendingModule {
+    FileSys::VirtualFile file;
+    NsoHeader header;
+    std::vector<u8> program_image;
+};
+} // Anonymous namespace
+
+static boost::optional<PendingModule> PrepareModule(FileSys::VirtualFile file) {
+    if (file == nullptr || file->GetSize() < sizeof(NsoHeader))
+        return boost::none;
 
-    if (file->GetSize() < sizeof(NsoHeader))
-        return {};
+    PendingModule module{std::move(file), {}, {}};
+    if (sizeof(NsoHeader) != module.file->ReadObject(&module.header))
+        return boost::none;
 
-    NsoHeader nso_header{};
-    if (sizeof(NsoHeader) != file->ReadObject(&nso_header))
-        return {};
+    if (module.header.magic != Common::MakeMagic('N', 'S', 'O', '0'))
+        return boost::none;
 
-    if (nso_header.magic != Common::MakeMagic('N', 'S', 'O', '0'))
-        return {};
+    size_t image_size = 0;
+    for (const auto& segment : module.header.segments) {
+        image_size = std::max<size_t>(image_size, segment.location + segment.size);
+    }
+
+    // Leave room for the usual .bss, so that appending it later doesn't move the image
+    module.program_image.reserve(image_size + PageAlignSize(module.header.segments[2].bss_size));
+    module.program_image.resize(image_size);
+    return module;
+}
+
+static void DecompressSegment(const PendingModule& module, std::size_t segment_index, u8* dest) {
+    const NsoSegmentHeader& header = module.header.segments[segment_index];
+    const u32 compressed_size = module.header.segments_compressed_size[segment_index];
+    const std::vector<u8> compressed_data = module.file->ReadBytes(compressed_size, header.offset);
+    const int bytes_uncompressed =
+        LZ4_decompress_safe(reinterpret_cast<const char*>(compressed_data.data()),
+                            reinterpret_cast<char*>(dest),
+                            static_cast<int>(compressed_data.size()), header.size);
+
+    ASSERT_MSG(bytes_uncompressed == static_cast<int>(header.size), "{} != {}", bytes_uncompressed,
+               header.size);
+}
+
+static VAddr LoadPendingModule(PendingModule& module, VAddr load_base) {
+    const NsoHeader& nso_header = module.header;
+    std::vector<u8>& program_image = module.program_image;
 
     // Build program image
     Kernel::SharedPtr<Kernel::CodeSet> codeset = Kernel::CodeSet::Create("");
-    std::vector<u8> program_image;
     for (std::size_t i = 0; i < nso_header.segments.size(); ++i) {
-        const std::vector<u8> compressed_data =
-            file->ReadBytes(nso_header.segments_compressed_size[i], nso_header.segments[i].offset);
-        std::vector<u8> data = DecompressSegment(compressed_data, nso_header.segments[i]);
-        program_image.resize(nso_header.segments[i].location);
-        program_image.insert(program_image.end(), data.begin(), data.end());
         codeset->segments[i].addr = nso_header.segments[i].location;
         codeset->segments[i].offset = nso_header.segments[i].location;
-        codeset->segments[i].size = PageAlignSize(static_cast<u32>(data.size()));
+        codeset->segments[i].size = PageAlignSize(nso_header.segments[i].size);
     }
 
     // MOD header pointer is at .text offset + 4
@@ -132,7 +150,7 @@ VAddr AppLoader_NSO::LoadModule(FileSys::VirtualFile file, VAddr load_base) {
     program_image.resize(image_size);
 
     // Load codeset for current process
-    codeset->name = file->GetName();
+    codeset->name = module.file->GetName();
     codeset->memory = std::make_shared<std::vector<u8>>(std::move(program_image));
     Core::CurrentProcess()->LoadModule(codeset, load_base);
 
@@ -142,6 +160,55 @@ VAddr AppLoader_NSO::LoadModule(FileSys::VirtualFile file, VAddr load_base) {
     return load_base + image_size;
 }
 
+VAddr AppLoader_NSO::LoadModule(FileSys::VirtualFile file, VAddr load_base) {
+    const auto end_addresses = LoadModules({std::move(file)}, load_base);
+    return end_addresses[0] == load_base ? 0 : end_addresses[0];
+}
+
+std::vector<VAddr> AppLoader_NSO::LoadModules(const std::vector<FileSys::VirtualFile>& files,
+                                              VAddr load_base) {
+    Core::ScopedBootPhase phase("Load NSO modules");
+
+    std::vector<boost::optional<PendingModule>> modules;
+    modules.reserve(files.size());
+    for (const auto& file : files) {
+        modules.push_back(PrepareModule(file));
+    }
+
+    // Every segment of every module is independent of the others, so they are all decompressed at
+    // once, right into the program images.
+    struct SegmentRef {
+        const PendingModule* module;
+        std::size_t index;
+        u8* dest;
+    };
+    std::vector<SegmentRef> segments;
+    for (auto& module : modules) {
+        if (!module)
+            continue;
+        for (std::size_t i = 0; i < module->header.segments.size(); ++i) {
+            segments.push_back(
+                {&*module, i, module->program_image.data() + module->header.segments[i].location});
+        }
+    }
+    {
+        Core::ScopedBootPhase decompress_phase("Decompress NSO segments");
+        Common::GetSharedThreadPool().ParallelFor(segments.size(), [&segments](size_t i) {
+            DecompressSegment(*segments[i].module, segments[i].index, segments[i].dest);
+        });
+    }
+
+    std::vector<VAddr> end_addresses;
+    end_addresses.reserve(modules.size());
+    for (auto& module : modules) {
+        if (module) {
+            load_base = LoadPendingModule(*module, load_base);
+        }
+        end_addresses.push_back(load_base);
+    }
+    return end_addresses;
+}
+
 ResultStatus AppLoader_NSO::Load(Kernel::SharedPtr<Kernel::Process>& process) {
     if (is_loaded) {
         return ResultStatus::ErrorAlreadyLoaded;
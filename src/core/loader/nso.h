@@ -5,6 +5,7 @@
 #pragma once
 
 #include <string>
+#include <vector>
 #include "common/common_types.h"
 #include "core/hle/kernel/object.h"
 #include "core/loader/linker.h"
@@ -30,6 +31,15 @@ public:
 
     static VAddr LoadModule(FileSys::VirtualFile file, VAddr load_base);
 
+    /**
+     * Loads each of files as a module, the first at load_base and every other right after the
+     * previous one. The segments of all modules are decompressed in parallel.
+     * @return For every file, the address after its module. Files that are not valid NSOs are
+     * skipped, so their address is that of the previous module.
+     */
+    static std::vector<VAddr> LoadModules(const std::vector<FileSys::VirtualFile>& files,
+                                          VAddr load_base);
+
     ResultStatus Load(Kernel::SharedPtr<Kernel::Process>& process) override;
 };
 
@@ -19,8 +19,10 @@
 namespace Loader {
 
 AppLoader_NSP::AppLoader_NSP(FileSys::VirtualFile file)
-    : AppLoader(file), nsp(std::make_unique<FileSys::NSP>(file)),
-      title_id(nsp->GetProgramTitleID()) {
+    : AppLoader_NSP(file, std::make_unique<FileSys::NSP>(file)) {}
+
+AppLoader_NSP::AppLoader_NSP(FileSys::VirtualFile file, std::unique_ptr<FileSys::NSP> nsp_)
+    : AppLoader(std::move(file)), nsp(std::move(nsp_)), title_id(nsp->GetProgramTitleID()) {
 
     if (nsp->GetStatus() != ResultStatus::Success)
         return;
@@ -51,8 +53,10 @@ AppLoader_NSP::AppLoader_NSP(FileSys::VirtualFile file)
 AppLoader_NSP::~AppLoader_NSP() = default;
 
 FileType AppLoader_NSP::IdentifyType(const FileSys::VirtualFile& file) {
-    FileSys::NSP nsp(file);
+    return IdentifyType(FileSys::NSP(file));
+}
 
+FileType AppLoader_NSP::IdentifyType(const FileSys::NSP& nsp) {
     if (nsp.GetStatus() == ResultStatus::Success) {
         // Extracted Type case
         if (nsp.IsExtractedType() && nsp.GetExeFS() != nullptr &&
@@ -61,11 +65,11 @@ FileType AppLoader_NSP::IdentifyType(const FileSys::VirtualFile& file) {
         }
 
         // Non-Ectracted Type case
-        if (!nsp.IsExtractedType() &&
-            nsp.GetNCA(nsp.GetFirstTitleID(), FileSys::ContentRecordType::Program) != nullptr &&
-            AppLoader_NCA::IdentifyType(nsp.GetNCAFile(
-                nsp.GetFirstTitleID(), FileSys::ContentRecordType::Program)) == FileType::NCA) {
-            return FileType::NSP;
+        if (!nsp.IsExtractedType()) {
+            const auto program =
+                nsp.GetNCA(nsp.GetFirstTitleID(), FileSys::ContentRecordType::Program);
+            if (program != nullptr && AppLoader_NCA::IdentifyType(*program) == FileType::NCA)
+                return FileType::NSP;
         }
     }
 
@@ -84,7 +88,7 @@ ResultStatus AppLoader_NSP::Load(Kernel::SharedPtr<Kernel::Process>& process) {
             return ResultStatus::ErrorNSPMissingProgramNCA;
 
         secondary_loader = std::make_unique<AppLoader_NCA>(
-            nsp->GetNCAFile(title_id, FileSys::ContentRecordType::Program));
+            nsp->GetNCA(title_id, FileSys::ContentRecordType::Program));
 
         if (nsp->GetStatus() != ResultStatus::Success)
             return nsp->GetStatus();
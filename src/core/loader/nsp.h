@@ -22,6 +22,8 @@ class AppLoader_NCA;
 class AppLoader_NSP final : public AppLoader {
 public:
     explicit AppLoader_NSP(FileSys::VirtualFile file);
+    /// Takes over the NSP of file parsed already, e.g. while identifying it
+    AppLoader_NSP(FileSys::VirtualFile file, std::unique_ptr<FileSys::NSP> nsp);
     ~AppLoader_NSP() override;
 
     /**
@@ -31,8 +33,11 @@ public:
      */
     static FileType IdentifyType(const FileSys::VirtualFile& file);
 
+    /// Returns the type of an NSP parsed already, see IdentifyType(const VirtualFile&)
+    static FileType IdentifyType(const FileSys::NSP& nsp);
+
     FileType GetFileType() override {
-        return IdentifyType(file);
+        return IdentifyType(*nsp);
     }
 
     ResultStatus Load(Kernel::SharedPtr<Kernel::Process>& process) override;
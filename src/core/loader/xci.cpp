@@ -16,8 +16,11 @@
 namespace Loader {
 
 AppLoader_XCI::AppLoader_XCI(FileSys::VirtualFile file)
-    : AppLoader(file), xci(std::make_unique<FileSys::XCI>(file)),
-      nca_loader(std::make_unique<AppLoader_NCA>(xci->GetProgramNCAFile())) {
+    : AppLoader_XCI(file, std::make_unique<FileSys::XCI>(file)) {}
+
+AppLoader_XCI::AppLoader_XCI(FileSys::VirtualFile file, std::unique_ptr<FileSys::XCI> xci_)
+    : AppLoader(std::move(file)), xci(std::move(xci_)),
+      nca_loader(std::make_unique<AppLoader_NCA>(xci->GetProgramNCA())) {
     if (xci->GetStatus() != ResultStatus::Success)
         return;
     const auto control_nca = xci->GetNCAByType(FileSys::NCAContentType::Control);
@@ -40,14 +43,16 @@ AppLoader_XCI::AppLoader_XCI(FileSys::VirtualFile file)
 AppLoader_XCI::~AppLoader_XCI() = default;
 
 FileType AppLoader_XCI::IdentifyType(const FileSys::VirtualFile& file) {
-    FileSys::XCI xci(file);
+    return IdentifyType(FileSys::XCI(file));
+}
+
+FileType AppLoader_XCI::IdentifyType(const FileSys::XCI& xci) {
+    if (xci.GetStatus() != ResultStatus::Success)
+        return FileType::Error;
 
-    if (xci.GetStatus() == ResultStatus::Success &&
-        xci.GetNCAByType(FileSys::NCAContentType::Program) != nullptr &&
-        AppLoader_NCA::IdentifyType(xci.GetNCAFileByType(FileSys::NCAContentType::Program)) ==
-            FileType::NCA) {
+    const auto program = xci.GetNCAByType(FileSys::NCAContentType::Program);
+    if (program != nullptr && AppLoader_NCA::IdentifyType(*program) == FileType::NCA)
         return FileType::XCI;
-    }
 
     return FileType::Error;
 }
@@ -76,6 +81,11 @@ ResultStatus AppLoader_XCI::Load(Kernel::SharedPtr<Kernel::Process>& process) {
     return ResultStatus::Success;
 }
 
+void AppLoader_XCI::MarkUnloaded() {
+    AppLoader::MarkUnloaded();
+    nca_loader->MarkUnloaded();
+}
+
 ResultStatus AppLoader_XCI::ReadRomFS(FileSys::VirtualFile& dir) {
     return nca_loader->ReadRomFS(dir);
 }
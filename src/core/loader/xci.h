@@ -22,6 +22,8 @@ class AppLoader_NCA;
 class AppLoader_XCI final : public AppLoader {
 public:
     explicit AppLoader_XCI(FileSys::VirtualFile file);
+    /// Takes over the XCI of file parsed already, e.g. while identifying it
+    AppLoader_XCI(FileSys::VirtualFile file, std::unique_ptr<FileSys::XCI> xci);
     ~AppLoader_XCI();
 
     /**
@@ -31,11 +33,15 @@ public:
      */
     static FileType IdentifyType(const FileSys::VirtualFile& file);
 
+    /// Returns the type of an XCI parsed already, see IdentifyType(const VirtualFile&)
+    static FileType IdentifyType(const FileSys::XCI& xci);
+
     FileType GetFileType() override {
-        return IdentifyType(file);
+        return IdentifyType(*xci);
     }
 
     ResultStatus Load(Kernel::SharedPtr<Kernel::Process>& process) override;
+    void MarkUnloaded() override;
 
     ResultStatus ReadRomFS(FileSys::VirtualFile& dir) override;
     ResultStatus ReadProgramId(u64& out_program_id) override;
@@ -5,6 +5,7 @@
 #include <algorithm>
 #include <array>
 #include <cstring>
+#include <type_traits>
 #include <utility>
 
 #include <boost/optional.hpp>
@@ -23,12 +24,10 @@
 
 namespace Memory {
 
-static PageTable* current_page_table = nullptr;
-
 void SetCurrentPageTable(PageTable* page_table) {
-    current_page_table = page_table;
-
     auto& system = Core::System::GetInstance();
+    system.CurrentPageTable() = page_table;
+
     if (system.IsPoweredOn()) {
         system.ArmInterface(0).PageTableChanged();
         system.ArmInterface(1).PageTableChanged();
@@ -38,26 +37,112 @@ void SetCurrentPageTable(PageTable* page_table) {
 }
 
 PageTable* GetCurrentPageTable() {
-    return current_page_table;
+    return Core::System::GetInstance().CurrentPageTable();
+}
+
+using PageBitmap = std::array<std::atomic<u64>, PAGE_TABLE_NUM_ENTRIES / 64>;
+
+static void SetPageBit(PageBitmap& bitmap, u64 page_index, bool set) {
+    const u64 mask = 1ULL << (page_index % 64);
+    auto& word = bitmap[page_index / 64];
+    if (set) {
+        word.fetch_or(mask, std::memory_order_release);
+    } else {
+        word.fetch_and(~mask, std::memory_order_release);
+    }
+}
+
+static bool IsPageBitSet(const PageBitmap& bitmap, u64 page_index) {
+    const u64 mask = 1ULL << (page_index % 64);
+    return (bitmap[page_index / 64].load(std::memory_order_acquire) & mask) != 0;
+}
+
+/**
+ * Flushes the rasterizer cache for the whole page containing `vaddr`, but only if the page has not
+ * already been flushed since it was last marked as cached. Flushing the full page at once means
+ * that a game streaming through a cached region only pays for the flush on the first access of
+ * each page instead of on every single word.
+ */
+static void FlushCachedPageIfPending(const PageTable& page_table, VAddr vaddr) {
+    const u64 page_index = vaddr >> PAGE_BITS;
+    if (!IsPageBitSet(page_table.flush_pending, page_index)) {
+        return;
+    }
+
+    RasterizerFlushVirtualRegion(vaddr & ~PAGE_MASK, PAGE_SIZE, FlushMode::Flush);
+    SetPageBit(page_table.flush_pending, page_index, false);
+}
+
+/**
+ * Invalidates the rasterizer cache for the whole page containing `vaddr`, unless nothing was
+ * loaded from it since the last CPU write did. The rasterizer writes back what the GPU rendered
+ * to the page before dropping it, so the page doesn't need a flush afterwards either.
+ */
+static void InvalidateCachedPageIfPending(const PageTable& page_table, VAddr vaddr) {
+    const u64 page_index = vaddr >> PAGE_BITS;
+    if (!IsPageBitSet(page_table.invalidate_pending, page_index)) {
+        return;
+    }
+
+    RasterizerFlushVirtualRegion(vaddr & ~PAGE_MASK, PAGE_SIZE, FlushMode::Invalidate);
+    SetPageBit(page_table.invalidate_pending, page_index, false);
+    SetPageBit(page_table.flush_pending, page_index, false);
+}
+
+/**
+ * Takes the HLE lock before the rasterizer cache is flushed or invalidated, unless the calling
+ * thread is the GPU thread. It gets here through the memory it reads, and must never wait for the
+ * lock: a CPU core may hold it while waiting for the GPU thread. The GPU thread only ever touches
+ * the rasterizer cache itself, the CPU side goes through it, so it needs no lock there.
+ */
+static void AcquireHLELockForRasterizer(boost::optional<HLE::LockGuard>& lock) {
+    if (!Core::System::GetInstance().GPU().IsGPUThread()) {
+        lock.emplace();
+    }
+}
+
+/// Clears the bits of the pages in [first, last), a whole bitmap word at a time.
+static void ClearPageBits(PageBitmap& bitmap, u64 first, u64 last) {
+    while (first < last) {
+        const u64 bit = first % 64;
+        const u64 count = std::min<u64>(64 - bit, last - first);
+        const u64 mask = count == 64 ? ~0ULL : ((1ULL << count) - 1) << bit;
+        bitmap[first / 64].fetch_and(~mask, std::memory_order_release);
+        first += count;
+    }
 }
 
 static void MapPages(PageTable& page_table, VAddr base, u64 size, u8* memory, PageType type) {
     LOG_DEBUG(HW_Memory, "Mapping {} onto {:016X}-{:016X}", fmt::ptr(memory), base * PAGE_SIZE,
               (base + size) * PAGE_SIZE);
 
-    RasterizerFlushVirtualRegion(base << PAGE_BITS, size * PAGE_SIZE,
-                                 FlushMode::FlushAndInvalidate);
+    const VAddr end = base + size;
+    ASSERT_MSG(end <= PAGE_TABLE_NUM_ENTRIES, "out of range mapping at {:016X}", end);
 
-    VAddr end = base + size;
-    while (base != end) {
-        ASSERT_MSG(base < PAGE_TABLE_NUM_ENTRIES, "out of range mapping at {:016X}", base);
+    const auto attributes_begin = page_table.attributes.begin() + base;
+    const auto attributes_end = page_table.attributes.begin() + end;
+
+    // Surfaces over mapped GPU memory are only ever registered over pages that have been marked
+    // as cached, so the rasterizer only needs to be consulted if the range contains at least one
+    // such page. Surfaces registered while their GPU range was unmapped are dropped by
+    // nvhost_as_gpu when the range is mapped.
+    if (std::find(attributes_begin, attributes_end, PageType::RasterizerCachedMemory) !=
+        attributes_end) {
+        RasterizerFlushVirtualRegion(base << PAGE_BITS, size * PAGE_SIZE,
+                                     FlushMode::FlushAndInvalidate);
+    }
 
-        page_table.attributes[base] = type;
-        page_table.pointers[base] = memory;
+    std::fill(attributes_begin, attributes_end, type);
+    ClearPageBits(page_table.flush_pending, base, end);
+    ClearPageBits(page_table.invalidate_pending, base, end);
 
-        base += 1;
-        if (memory != nullptr)
-            memory += PAGE_SIZE;
+    if (memory == nullptr) {
+        std::fill(page_table.pointers.begin() + base, page_table.pointers.begin() + end, nullptr);
+        return;
+    }
+
+    for (VAddr page = base; page != end; ++page, memory += PAGE_SIZE) {
+        page_table.pointers[page] = memory;
     }
 }
 
@@ -103,28 +188,7 @@ void RemoveDebugHook(PageTable& page_table, VAddr base, u64 size, MemoryHookPoin
  * using a VMA from the current process
  */
 static u8* GetPointerFromVMA(const Kernel::Process& process, VAddr vaddr) {
-    u8* direct_pointer = nullptr;
-
-    auto& vm_manager = process.vm_manager;
-
-    auto it = vm_manager.FindVMA(vaddr);
-    ASSERT(it != vm_manager.vma_map.end());
-
-    auto& vma = it->second;
-    switch (vma.type) {
-    case Kernel::VMAType::AllocatedMemoryBlock:
-        direct_pointer = vma.backing_block->data() + vma.offset;
-        break;
-    case Kernel::VMAType::BackingMemory:
-        direct_pointer = vma.backing_memory;
-        break;
-    case Kernel::VMAType::Free:
-        return nullptr;
-    default:
-        UNREACHABLE();
-    }
-
-    return direct_pointer + (vaddr - vma.base);
+    return process.vm_manager.GetBackingPointer(vaddr);
 }
 
 /**
@@ -137,6 +201,7 @@ static u8* GetPointerFromVMA(VAddr vaddr) {
 
 template <typename T>
 T Read(const VAddr vaddr) {
+    const PageTable* const current_page_table = GetCurrentPageTable();
     const u8* page_pointer = current_page_table->pointers[vaddr >> PAGE_BITS];
     if (page_pointer) {
         // NOTE: Avoid adding any extra logic to this fast-path block
@@ -145,19 +210,22 @@ T Read(const VAddr vaddr) {
         return value;
     }
 
-    // The memory access might do an MMIO or cached access, so we have to lock the HLE kernel state
-    std::lock_guard<std::recursive_mutex> lock(HLE::g_hle_lock);
-
     PageType type = current_page_table->attributes[vaddr >> PAGE_BITS];
     switch (type) {
     case PageType::Unmapped:
         LOG_ERROR(HW_Memory, "Unmapped Read{} @ 0x{:08X}", sizeof(T) * 8, vaddr);
-        return 0;
+        return {};
     case PageType::Memory:
         ASSERT_MSG(false, "Mapped memory page without a pointer @ {:016X}", vaddr);
         break;
     case PageType::RasterizerCachedMemory: {
-        RasterizerFlushVirtualRegion(vaddr, sizeof(T), FlushMode::Flush);
+        // Flushing touches the rasterizer cache, which is protected by the HLE lock. Once the page
+        // has been flushed, reads skip both until the GPU writes to it again.
+        if (IsPageBitSet(current_page_table->flush_pending, vaddr >> PAGE_BITS)) {
+            boost::optional<HLE::LockGuard> lock;
+            AcquireHLELockForRasterizer(lock);
+            FlushCachedPageIfPending(*current_page_table, vaddr);
+        }
 
         T value;
         std::memcpy(&value, GetPointerFromVMA(vaddr), sizeof(T));
@@ -170,6 +238,7 @@ T Read(const VAddr vaddr) {
 
 template <typename T>
 void Write(const VAddr vaddr, const T data) {
+    PageTable* const current_page_table = GetCurrentPageTable();
     u8* page_pointer = current_page_table->pointers[vaddr >> PAGE_BITS];
     if (page_pointer) {
         // NOTE: Avoid adding any extra logic to this fast-path block
@@ -177,20 +246,27 @@ void Write(const VAddr vaddr, const T data) {
         return;
     }
 
-    // The memory access might do an MMIO or cached access, so we have to lock the HLE kernel state
-    std::lock_guard<std::recursive_mutex> lock(HLE::g_hle_lock);
-
     PageType type = current_page_table->attributes[vaddr >> PAGE_BITS];
     switch (type) {
     case PageType::Unmapped:
-        LOG_ERROR(HW_Memory, "Unmapped Write{} 0x{:08X} @ 0x{:016X}", sizeof(data) * 8,
-                  static_cast<u32>(data), vaddr);
+        if constexpr (std::is_same_v<T, u128>) {
+            LOG_ERROR(HW_Memory, "Unmapped Write128 0x{:016X}{:016X} @ 0x{:016X}", data[1],
+                      data[0], vaddr);
+        } else {
+            LOG_ERROR(HW_Memory, "Unmapped Write{} 0x{:08X} @ 0x{:016X}", sizeof(data) * 8,
+                      static_cast<u64>(data), vaddr);
+        }
         return;
     case PageType::Memory:
         ASSERT_MSG(false, "Mapped memory page without a pointer @ {:016X}", vaddr);
         break;
     case PageType::RasterizerCachedMemory: {
-        RasterizerFlushVirtualRegion(vaddr, sizeof(T), FlushMode::Invalidate);
+        // Same as reads, only the first write after the rasterizer loaded the page invalidates it
+        if (IsPageBitSet(current_page_table->invalidate_pending, vaddr >> PAGE_BITS)) {
+            boost::optional<HLE::LockGuard> lock;
+            AcquireHLELockForRasterizer(lock);
+            InvalidateCachedPageIfPending(*current_page_table, vaddr);
+        }
         std::memcpy(GetPointerFromVMA(vaddr), &data, sizeof(T));
         break;
     }
@@ -224,6 +300,7 @@ bool IsKernelVirtualAddress(const VAddr vaddr) {
 }
 
 u8* GetPointer(const VAddr vaddr) {
+    const PageTable* const current_page_table = GetCurrentPageTable();
     u8* page_pointer = current_page_table->pointers[vaddr >> PAGE_BITS];
     if (page_pointer) {
         return page_pointer + (vaddr & PAGE_MASK);
@@ -237,6 +314,29 @@ u8* GetPointer(const VAddr vaddr) {
     return nullptr;
 }
 
+u8* GetContiguousPointer(const Kernel::Process& process, const VAddr vaddr, const size_t size) {
+    const auto& page_table = process.vm_manager.page_table;
+    const size_t first_page = vaddr >> PAGE_BITS;
+    const size_t last_page = (vaddr + std::max<size_t>(size, 1) - 1) >> PAGE_BITS;
+
+    u8* const first_pointer = page_table.pointers[first_page];
+    if (first_pointer == nullptr) {
+        return nullptr;
+    }
+
+    for (size_t page = first_page + 1; page <= last_page; ++page) {
+        if (page_table.pointers[page] != first_pointer + (page - first_page) * PAGE_SIZE) {
+            return nullptr;
+        }
+    }
+
+    return first_pointer + (vaddr & PAGE_MASK);
+}
+
+u8* GetContiguousPointer(const VAddr vaddr, const size_t size) {
+    return GetContiguousPointer(*Core::CurrentProcess(), vaddr, size);
+}
+
 std::string ReadCString(VAddr vaddr, std::size_t max_length) {
     std::string string;
     string.reserve(max_length);
@@ -251,78 +351,135 @@ std::string ReadCString(VAddr vaddr, std::size_t max_length) {
     return string;
 }
 
-void RasterizerMarkRegionCached(Tegra::GPUVAddr gpu_addr, u64 size, bool cached) {
-    if (gpu_addr == 0) {
-        return;
+/// Switches a single page between the `Memory` and `RasterizerCachedMemory` types.
+static void MarkPageCached(u64 page_index, bool cached) {
+    PageTable* const current_page_table = GetCurrentPageTable();
+    PageType& page_type = current_page_table->attributes[page_index];
+    const bool pending = cached && page_type != PageType::Unmapped;
+    SetPageBit(current_page_table->flush_pending, page_index, pending);
+    SetPageBit(current_page_table->invalidate_pending, page_index, pending);
+
+    if (cached) {
+        // Switch page type to cached if now cached
+        switch (page_type) {
+        case PageType::Unmapped:
+            // It is not necessary for a process to have this region mapped into its address space,
+            // for example, a system module need not have a VRAM mapping.
+            break;
+        case PageType::Memory:
+            page_type = PageType::RasterizerCachedMemory;
+            current_page_table->pointers[page_index] = nullptr;
+            break;
+        case PageType::RasterizerCachedMemory:
+            // There can be more than one GPU region mapped per CPU region, so it's common that this
+            // area is already marked as cached.
+            break;
+        default:
+            UNREACHABLE();
+        }
+    } else {
+        // Switch page type to uncached if now uncached
+        switch (page_type) {
+        case PageType::Unmapped:
+            // It is not necessary for a process to have this region mapped into its address space,
+            // for example, a system module need not have a VRAM mapping.
+            break;
+        case PageType::Memory:
+            // There can be more than one GPU region mapped per CPU region, so it's common that this
+            // area is already unmarked as cached.
+            break;
+        case PageType::RasterizerCachedMemory: {
+            u8* pointer = GetPointerFromVMA(page_index << PAGE_BITS);
+            if (pointer == nullptr) {
+                // It's possible that this function has been called while updating the pagetable
+                // after unmapping a VMA. In that case the underlying VMA will no longer exist, and
+                // we should just leave the pagetable entry blank.
+                page_type = PageType::Unmapped;
+            } else {
+                page_type = PageType::Memory;
+                current_page_table->pointers[page_index] = pointer;
+            }
+            break;
+        }
+        default:
+            UNREACHABLE();
+        }
     }
+}
+
+/**
+ * Calls func with the index of each CPU page backing the GPU region. A GPU page is larger than a
+ * CPU page and always maps onto a contiguous CPU range, so the address only has to be translated
+ * once per GPU page rather than once per CPU page. This assumes the specified GPU address region
+ * is contiguous as well.
+ */
+template <typename Func>
+static void ForEachCpuPageOfRegion(Tegra::GPUVAddr gpu_addr, u64 size, Func&& func) {
 
-    // Iterate over a contiguous CPU address space, which corresponds to the specified GPU address
-    // space, marking the region as un/cached. The region is marked un/cached at a granularity of
-    // CPU pages, hence why we iterate on a CPU page basis (note: GPU page size is different). This
-    // assumes the specified GPU address region is contiguous as well.
+    auto& memory_manager = *Core::System::GetInstance().GPU().memory_manager;
+    const Tegra::GPUVAddr gpu_end = gpu_addr + size;
 
-    u64 num_pages = ((gpu_addr + size - 1) >> PAGE_BITS) - (gpu_addr >> PAGE_BITS) + 1;
-    for (unsigned i = 0; i < num_pages; ++i, gpu_addr += PAGE_SIZE) {
-        boost::optional<VAddr> maybe_vaddr =
-            Core::System::GetInstance().GPU().memory_manager->GpuToCpuAddress(gpu_addr);
+    while (gpu_addr < gpu_end) {
+        const Tegra::GPUVAddr gpu_page_end = std::min<Tegra::GPUVAddr>(
+            (gpu_addr & ~Tegra::MemoryManager::PAGE_MASK) + Tegra::MemoryManager::PAGE_SIZE,
+            gpu_end);
+
+        boost::optional<VAddr> maybe_vaddr = memory_manager.GpuToCpuAddress(gpu_addr);
         // The GPU <-> CPU virtual memory mapping is not 1:1
         if (!maybe_vaddr) {
             LOG_ERROR(HW_Memory,
                       "Trying to flush a cached region to an invalid physical address {:016X}",
                       gpu_addr);
+            gpu_addr = gpu_page_end;
             continue;
         }
-        VAddr vaddr = *maybe_vaddr;
 
-        PageType& page_type = current_page_table->attributes[vaddr >> PAGE_BITS];
+        const VAddr vaddr = *maybe_vaddr;
+        const u64 first_page = vaddr >> PAGE_BITS;
+        const u64 last_page = (vaddr + (gpu_page_end - gpu_addr) - 1) >> PAGE_BITS;
+        for (u64 page_index = first_page; page_index <= last_page; ++page_index) {
+            func(page_index);
+        }
 
-        if (cached) {
-            // Switch page type to cached if now cached
-            switch (page_type) {
-            case PageType::Unmapped:
-                // It is not necessary for a process to have this region mapped into its address
-                // space, for example, a system module need not have a VRAM mapping.
-                break;
-            case PageType::Memory:
-                page_type = PageType::RasterizerCachedMemory;
-                current_page_table->pointers[vaddr >> PAGE_BITS] = nullptr;
-                break;
-            case PageType::RasterizerCachedMemory:
-                // There can be more than one GPU region mapped per CPU region, so it's common that
-                // this area is already marked as cached.
-                break;
-            default:
-                UNREACHABLE();
-            }
-        } else {
-            // Switch page type to uncached if now uncached
-            switch (page_type) {
-            case PageType::Unmapped:
-                // It is not necessary for a process to have this region mapped into its address
-                // space, for example, a system module need not have a VRAM mapping.
-                break;
-            case PageType::Memory:
-                // There can be more than one GPU region mapped per CPU region, so it's common that
-                // this area is already unmarked as cached.
-                break;
-            case PageType::RasterizerCachedMemory: {
-                u8* pointer = GetPointerFromVMA(vaddr & ~PAGE_MASK);
-                if (pointer == nullptr) {
-                    // It's possible that this function has been called while updating the pagetable
-                    // after unmapping a VMA. In that case the underlying VMA will no longer exist,
-                    // and we should just leave the pagetable entry blank.
-                    page_type = PageType::Unmapped;
-                } else {
-                    page_type = PageType::Memory;
-                    current_page_table->pointers[vaddr >> PAGE_BITS] = pointer;
-                }
-                break;
-            }
-            default:
-                UNREACHABLE();
-            }
+        gpu_addr = gpu_page_end;
+    }
+}
+
+void RasterizerMarkRegionCached(Tegra::GPUVAddr gpu_addr, u64 size, bool cached) {
+    if (gpu_addr == 0) {
+        return;
+    }
+
+    // The region is marked un/cached at a granularity of CPU pages
+    ForEachCpuPageOfRegion(gpu_addr, size,
+                           [cached](u64 page_index) { MarkPageCached(page_index, cached); });
+}
+
+void RasterizerMarkRegionModified(Tegra::GPUVAddr gpu_addr, u64 size) {
+    if (gpu_addr == 0) {
+        return;
+    }
+
+    const PageTable& page_table = *GetCurrentPageTable();
+    ForEachCpuPageOfRegion(gpu_addr, size, [&page_table](u64 page_index) {
+        if (page_table.attributes[page_index] == PageType::RasterizerCachedMemory) {
+            SetPageBit(page_table.flush_pending, page_index, true);
+            SetPageBit(page_table.invalidate_pending, page_index, true);
         }
+    });
+}
+
+void RasterizerMarkRegionLoaded(Tegra::GPUVAddr gpu_addr, u64 size) {
+    if (gpu_addr == 0) {
+        return;
     }
+
+    const PageTable& page_table = *GetCurrentPageTable();
+    ForEachCpuPageOfRegion(gpu_addr, size, [&page_table](u64 page_index) {
+        if (page_table.attributes[page_index] == PageType::RasterizerCachedMemory) {
+            SetPageBit(page_table.invalidate_pending, page_index, true);
+        }
+    });
 }
 
 void RasterizerFlushVirtualRegion(VAddr start, u64 size, FlushMode mode) {
@@ -355,16 +512,16 @@ void RasterizerFlushVirtualRegion(VAddr start, u64 size, FlushMode mode) {
         const u64 overlap_size = overlap_end - overlap_start;
 
         for (const auto& gpu_address : gpu_addresses) {
-            auto& rasterizer = system_instance.Renderer().Rasterizer();
+            auto& gpu = system_instance.GPU();
             switch (mode) {
             case FlushMode::Flush:
-                rasterizer.FlushRegion(gpu_address, overlap_size);
+                gpu.FlushRegion(gpu_address, overlap_size);
                 break;
             case FlushMode::Invalidate:
-                rasterizer.InvalidateRegion(gpu_address, overlap_size);
+                gpu.InvalidateRegion(gpu_address, overlap_size);
                 break;
             case FlushMode::FlushAndInvalidate:
-                rasterizer.FlushAndInvalidateRegion(gpu_address, overlap_size);
+                gpu.FlushAndInvalidateRegion(gpu_address, overlap_size);
                 break;
             }
         }
@@ -390,6 +547,14 @@ u64 Read64(const VAddr addr) {
     return Read<u64_le>(addr);
 }
 
+u128 Read128(const VAddr addr) {
+    if ((addr & PAGE_MASK) + sizeof(u128) > PAGE_SIZE) {
+        // The access straddles a page boundary, so each half has to be resolved on its own page
+        return {Read64(addr), Read64(addr + 8)};
+    }
+    return Read<u128>(addr);
+}
+
 void ReadBlock(const Kernel::Process& process, const VAddr src_addr, void* dest_buffer,
                const size_t size) {
     auto& page_table = process.vm_manager.page_table;
@@ -419,8 +584,7 @@ void ReadBlock(const Kernel::Process& process, const VAddr src_addr, void* dest_
             break;
         }
         case PageType::RasterizerCachedMemory: {
-            RasterizerFlushVirtualRegion(current_vaddr, static_cast<u32>(copy_amount),
-                                         FlushMode::Flush);
+            FlushCachedPageIfPending(page_table, current_vaddr);
             std::memcpy(dest_buffer, GetPointerFromVMA(process, current_vaddr), copy_amount);
             break;
         }
@@ -455,6 +619,16 @@ void Write64(const VAddr addr, const u64 data) {
     Write<u64_le>(addr, data);
 }
 
+void Write128(const VAddr addr, const u128 data) {
+    if ((addr & PAGE_MASK) + sizeof(u128) > PAGE_SIZE) {
+        // The access straddles a page boundary, so each half has to be resolved on its own page
+        Write64(addr, data[0]);
+        Write64(addr + 8, data[1]);
+        return;
+    }
+    Write<u128>(addr, data);
+}
+
 void WriteBlock(const Kernel::Process& process, const VAddr dest_addr, const void* src_buffer,
                 const size_t size) {
     auto& page_table = process.vm_manager.page_table;
@@ -544,6 +718,15 @@ void ZeroBlock(const Kernel::Process& process, const VAddr dest_addr, const size
 }
 
 void CopyBlock(const Kernel::Process& process, VAddr dest_addr, VAddr src_addr, const size_t size) {
+    // When both ranges are plain host-contiguous memory, the copy can be done in one go instead of
+    // bouncing every page through WriteBlock.
+    const u8* const src_pointer = GetContiguousPointer(process, src_addr, size);
+    u8* const dest_pointer = GetContiguousPointer(process, dest_addr, size);
+    if (src_pointer != nullptr && dest_pointer != nullptr) {
+        std::memmove(dest_pointer, src_pointer, size);
+        return;
+    }
+
     auto& page_table = process.vm_manager.page_table;
     size_t remaining_size = size;
     size_t page_index = src_addr >> PAGE_BITS;
@@ -569,8 +752,7 @@ void CopyBlock(const Kernel::Process& process, VAddr dest_addr, VAddr src_addr,
             break;
         }
         case PageType::RasterizerCachedMemory: {
-            RasterizerFlushVirtualRegion(current_vaddr, static_cast<u32>(copy_amount),
-                                         FlushMode::Flush);
+            FlushCachedPageIfPending(page_table, current_vaddr);
             WriteBlock(process, dest_addr, GetPointerFromVMA(process, current_vaddr), copy_amount);
             break;
         }
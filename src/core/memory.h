@@ -5,6 +5,7 @@
 #pragma once
 
 #include <array>
+#include <atomic>
 #include <cstddef>
 #include <string>
 #include <tuple>
@@ -80,6 +81,22 @@ struct PageTable {
      * the corresponding entry in `pointers` MUST be set to null.
      */
     std::array<PageType, PAGE_TABLE_NUM_ENTRIES> attributes;
+
+    /**
+     * Bitmap with one bit per page, set while a `RasterizerCachedMemory` page may hold data that
+     * has not been flushed back from the rasterizer yet. Only the first CPU read touching such a
+     * page flushes it; later reads observe a clear bit and skip the rasterizer entirely. The bits
+     * are cache state rather than mapping state, hence mutable.
+     */
+    mutable std::array<std::atomic<u64>, PAGE_TABLE_NUM_ENTRIES / 64> flush_pending;
+
+    /**
+     * Bitmap with one bit per page, set while the rasterizer keeps resources loaded from a
+     * `RasterizerCachedMemory` page that a CPU write has not invalidated yet. Only the first CPU
+     * write touching such a page invalidates it; later writes skip the rasterizer until it loads
+     * from the page again.
+     */
+    mutable std::array<std::atomic<u64>, PAGE_TABLE_NUM_ENTRIES / 64> invalidate_pending;
 };
 
 /// Virtual user-space memory regions
@@ -135,7 +152,7 @@ enum : VAddr {
     KERNEL_REGION_END = KERNEL_REGION_VADDR + KERNEL_REGION_SIZE,
 };
 
-/// Currently active page table
+/// Currently active page table, of the system run by the calling thread
 void SetCurrentPageTable(PageTable* page_table);
 PageTable* GetCurrentPageTable();
 
@@ -149,11 +166,13 @@ u8 Read8(VAddr addr);
 u16 Read16(VAddr addr);
 u32 Read32(VAddr addr);
 u64 Read64(VAddr addr);
+u128 Read128(VAddr addr);
 
 void Write8(VAddr addr, u8 data);
 void Write16(VAddr addr, u16 data);
 void Write32(VAddr addr, u32 data);
 void Write64(VAddr addr, u64 data);
+void Write128(VAddr addr, u128 data);
 
 void ReadBlock(const Kernel::Process& process, VAddr src_addr, void* dest_buffer, size_t size);
 void ReadBlock(VAddr src_addr, void* dest_buffer, size_t size);
@@ -165,6 +184,16 @@ void CopyBlock(VAddr dest_addr, VAddr src_addr, size_t size);
 
 u8* GetPointer(VAddr vaddr);
 
+/**
+ * Gets a host pointer to a guest range if every page in it is regular memory and the pages are
+ * also contiguous in host memory, so that the whole range can be accessed with a single memcpy.
+ *
+ * @returns The host pointer to the start of the range, or nullptr if the range is not
+ *          host-contiguous or touches pages that are unmapped, cached or special.
+ */
+u8* GetContiguousPointer(const Kernel::Process& process, VAddr vaddr, size_t size);
+u8* GetContiguousPointer(VAddr vaddr, size_t size);
+
 std::string ReadCString(VAddr vaddr, std::size_t max_length);
 
 enum class FlushMode {
@@ -181,6 +210,18 @@ enum class FlushMode {
  */
 void RasterizerMarkRegionCached(Tegra::GPUVAddr gpu_addr, u64 size, bool cached);
 
+/**
+ * Marks the cached pages of the region as written by the GPU since they were last flushed, so
+ * that the next CPU read of each of them flushes it and the next CPU write invalidates it again.
+ */
+void RasterizerMarkRegionModified(Tegra::GPUVAddr gpu_addr, u64 size);
+
+/**
+ * Marks the cached pages of the region as loaded into the rasterizer again, so that the next CPU
+ * write to each of them invalidates it again.
+ */
+void RasterizerMarkRegionLoaded(Tegra::GPUVAddr gpu_addr, u64 size);
+
 /**
  * Flushes and invalidates any externally cached rasterizer resources touching the given virtual
  * address region.
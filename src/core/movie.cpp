@@ -0,0 +1,147 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <utility>
+#include "common/file_util.h"
+#include "common/logging/log.h"
+#include "core/core_timing.h"
+#include "core/movie.h"
+#include "core/settings.h"
+
+namespace Core {
+
+namespace {
+constexpr u32 MOVIE_MAGIC = 0x564F4D59; // "YMOV"
+constexpr u32 MOVIE_VERSION = 1;
+
+struct MovieHeader {
+    u32 magic;
+    u32 version;
+    u64 num_samples;
+    u64 num_arrivals;
+};
+
+struct ArrivalHeader {
+    u64 ticks;
+    s64 time;
+    u64 userdata;
+    u64 type_name_length;
+};
+} // Anonymous namespace
+
+Movie::Movie(bool is_playing, std::string filename)
+    : is_playing{is_playing}, filename{std::move(filename)} {
+    if (Settings::values.use_multi_core) {
+        LOG_WARNING(Core, "Movies don't play back in sync with multicore enabled");
+    }
+}
+
+Movie::~Movie() {
+    if (is_playing) {
+        CoreTiming::StopReplayingThreadsafeEvents();
+    } else {
+        Save();
+    }
+}
+
+std::unique_ptr<Movie> Movie::Record(std::string filename) {
+    std::unique_ptr<Movie> movie{new Movie(false, std::move(filename))};
+    CoreTiming::StartRecordingThreadsafeEvents();
+    LOG_INFO(Core, "Recording movie to {}", movie->filename);
+    return movie;
+}
+
+std::unique_ptr<Movie> Movie::Play(const std::string& filename) {
+    FileUtil::IOFile file(filename, "rb");
+    MovieHeader header;
+    if (!file.IsOpen() || file.ReadBytes(&header, sizeof(header)) != sizeof(header) ||
+        header.magic != MOVIE_MAGIC || header.version != MOVIE_VERSION) {
+        LOG_ERROR(Core, "{} isn't a movie of this version", filename);
+        return nullptr;
+    }
+
+    std::unique_ptr<Movie> movie{new Movie(true, filename)};
+    movie->samples.resize(header.num_samples);
+    if (file.ReadArray(movie->samples.data(), movie->samples.size()) != header.num_samples) {
+        LOG_ERROR(Core, "Movie {} is truncated", filename);
+        return nullptr;
+    }
+
+    std::vector<CoreTiming::ThreadsafeArrival> arrivals(header.num_arrivals);
+    for (auto& arrival : arrivals) {
+        ArrivalHeader arrival_header;
+        if (file.ReadBytes(&arrival_header, sizeof(arrival_header)) != sizeof(arrival_header)) {
+            LOG_ERROR(Core, "Movie {} is truncated", filename);
+            return nullptr;
+        }
+        arrival.ticks = arrival_header.ticks;
+        arrival.time = arrival_header.time;
+        arrival.userdata = arrival_header.userdata;
+        arrival.type_name.resize(arrival_header.type_name_length);
+        if (file.ReadBytes(&arrival.type_name[0], arrival.type_name.size()) !=
+            arrival.type_name.size()) {
+            LOG_ERROR(Core, "Movie {} is truncated", filename);
+            return nullptr;
+        }
+    }
+
+    LOG_INFO(Core, "Playing movie {}, {} pad updates and {} event arrivals", filename,
+             header.num_samples, header.num_arrivals);
+    CoreTiming::ReplayThreadsafeEvents(std::move(arrivals));
+    return movie;
+}
+
+void Movie::HandlePadInput(InputSample& sample) {
+    if (!is_playing) {
+        samples.push_back(sample);
+        return;
+    }
+
+    if (next_sample == samples.size()) {
+        return;
+    }
+
+    const u64 ticks = sample.ticks;
+    sample = samples[next_sample++];
+    if (sample.ticks != ticks && !desynced) {
+        LOG_WARNING(Core, "Movie desynced, pad update recorded at {} ticks happened at {}",
+                    sample.ticks, ticks);
+        desynced = true;
+    }
+    sample.ticks = ticks;
+
+    if (next_sample == samples.size()) {
+        LOG_INFO(Core, "Movie playback finished, the input is live from now on");
+    }
+}
+
+void Movie::Save() {
+    const std::vector<CoreTiming::ThreadsafeArrival> arrivals =
+        CoreTiming::StopRecordingThreadsafeEvents();
+
+    FileUtil::IOFile file(filename, "wb");
+    if (!file.IsOpen()) {
+        LOG_ERROR(Core, "Could not open movie file {}", filename);
+        return;
+    }
+
+    const MovieHeader header{MOVIE_MAGIC, MOVIE_VERSION, samples.size(), arrivals.size()};
+    bool success = file.WriteObject(header) == 1 &&
+                   file.WriteArray(samples.data(), samples.size()) == samples.size();
+    for (const auto& arrival : arrivals) {
+        const ArrivalHeader arrival_header{arrival.ticks, arrival.time, arrival.userdata,
+                                           arrival.type_name.size()};
+        success = success && file.WriteObject(arrival_header) == 1 &&
+                  file.WriteString(arrival.type_name) == arrival.type_name.size();
+    }
+
+    if (!success) {
+        LOG_ERROR(Core, "Could not write movie file {}", filename);
+        return;
+    }
+    LOG_INFO(Core, "Saved movie {}, {} pad updates and {} event arrivals", filename,
+             samples.size(), arrivals.size());
+}
+
+} // namespace Core
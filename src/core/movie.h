@@ -0,0 +1,72 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <array>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <vector>
+#include "common/common_types.h"
+
+namespace Core {
+
+/**
+ * Records the parts of a session that vary between runs, the input polled by HID and the arrival
+ * of the events other threads schedule, both by the CoreTiming ticks they happened at. Playing
+ * the recording back runs the same workload every time, so that builds can be compared on real
+ * gameplay.
+ * @note Playback only stays in sync if the rest of the emulation is deterministic, which rules
+ * out multicore and anything reading the host clock.
+ */
+class Movie {
+public:
+    /// Input polled by HID on a pad update
+    struct InputSample {
+        /// Ticks of the pad update
+        u64 ticks;
+        u64 buttons;
+        /// Left X, left Y, right X and right Y
+        std::array<s32, 4> joysticks;
+        float touch_x;
+        float touch_y;
+        u32 touch_pressed;
+    };
+    static_assert(std::is_trivially_copyable<InputSample>::value,
+                  "InputSample is written to the movie as is");
+
+    /// Starts recording a movie, written to filename once the session ends.
+    static std::unique_ptr<Movie> Record(std::string filename);
+
+    /// Starts playing back the movie in filename, returns nullptr if it can't be read.
+    static std::unique_ptr<Movie> Play(const std::string& filename);
+
+    ~Movie();
+
+    /// Records the input of a pad update, or replaces it with the recorded one during playback.
+    void HandlePadInput(InputSample& sample);
+
+    /// Returns whether the movie is being played back rather than recorded
+    bool IsPlaying() const {
+        return is_playing;
+    }
+
+private:
+    Movie(bool is_playing, std::string filename);
+
+    /// Writes the recorded movie to its file
+    void Save();
+
+    bool is_playing;
+    std::string filename;
+
+    std::vector<InputSample> samples;
+    /// Next sample to play back
+    std::size_t next_sample = 0;
+    /// Whether a desync was already reported, it's only reported once
+    bool desynced = false;
+};
+
+} // namespace Core
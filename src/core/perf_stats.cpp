@@ -4,9 +4,19 @@
 
 #include <algorithm>
 #include <chrono>
+#include <cmath>
+#include <functional>
 #include <mutex>
+#include <numeric>
 #include <thread>
+#include <utility>
+#include <fmt/format.h>
+#ifdef _WIN32
+#include <windows.h>
+#include <mmsystem.h>
+#endif
 #include "common/math_util.h"
+#include "common/thread.h"
 #include "core/perf_stats.h"
 #include "core/settings.h"
 
@@ -29,9 +39,35 @@ void PerfStats::EndSystemFrame() {
     auto frame_end = Clock::now();
     accumulated_frametime += frame_end - frame_begin;
     system_frames += 1;
+    total_system_frames.fetch_add(1, std::memory_order_relaxed);
 
     previous_frame_length = frame_end - previous_frame_end;
     previous_frame_end = frame_end;
+
+    const double frame_length = duration_cast<DoubleSecs>(previous_frame_length).count();
+    accumulated_frame_length += frame_length;
+    accumulated_frame_length_squared += frame_length * frame_length;
+
+    const auto bucket = static_cast<std::size_t>(frame_length / HistogramBucketLength);
+    frame_length_histogram[std::min(bucket, NumHistogramBuckets - 1)] += 1;
+
+    const FrameSample sample{
+        frame_length,
+        duration_cast<DoubleSecs>(frame_end - frame_begin).count(),
+        duration_cast<DoubleSecs>(current_gpu_time).count(),
+        duration_cast<DoubleSecs>(current_present_time).count(),
+        duration_cast<DoubleSecs>(current_limiter_time).count(),
+    };
+    current_gpu_time = Clock::duration::zero();
+    current_present_time = Clock::duration::zero();
+    current_limiter_time = Clock::duration::zero();
+
+    frame_history[frame_history_next] = sample;
+    frame_history_next = (frame_history_next + 1) % FrameHistorySize;
+    frame_history_size = std::min(frame_history_size + 1, FrameHistorySize);
+    if (recording_frames) {
+        recorded_frames.push_back(sample);
+    }
 }
 
 void PerfStats::EndGameFrame() {
@@ -40,6 +76,47 @@ void PerfStats::EndGameFrame() {
     game_frames += 1;
 }
 
+void PerfStats::AddPresentTime(Clock::duration present_time) {
+    std::lock_guard<std::mutex> lock(object_mutex);
+
+    accumulated_present_time += present_time;
+    current_present_time += present_time;
+}
+
+void PerfStats::AddGpuTime(Clock::duration gpu_time) {
+    std::lock_guard<std::mutex> lock(object_mutex);
+
+    accumulated_gpu_time += gpu_time;
+    current_gpu_time += gpu_time;
+}
+
+void PerfStats::AddLimiterTime(Clock::duration limiter_time) {
+    std::lock_guard<std::mutex> lock(object_mutex);
+
+    accumulated_limiter_time += limiter_time;
+    current_limiter_time += limiter_time;
+}
+
+void PerfStats::ReportAudioUnderrun() {
+    audio_underruns.fetch_add(1, std::memory_order_relaxed);
+}
+
+void PerfStats::ReportAudioOverrun() {
+    audio_overruns.fetch_add(1, std::memory_order_relaxed);
+}
+
+void PerfStats::ReportAudioQueueLevel(double level) {
+    audio_queue_level.store(level, std::memory_order_relaxed);
+}
+
+void PerfStats::ReportAudioStretchRatio(double ratio) {
+    audio_stretch_ratio.store(ratio, std::memory_order_relaxed);
+}
+
+void PerfStats::ReportAudioLatency(double seconds) {
+    audio_latency.store(seconds, std::memory_order_relaxed);
+}
+
 PerfStats::Results PerfStats::GetAndResetStats(microseconds current_system_time_us) {
     std::lock_guard<std::mutex> lock(object_mutex);
 
@@ -56,16 +133,76 @@ PerfStats::Results PerfStats::GetAndResetStats(microseconds current_system_time_
                         static_cast<double>(system_frames);
     results.emulation_speed = system_us_per_second.count() / 1'000'000.0;
 
+    const double mean_frame_length = accumulated_frame_length / system_frames;
+    const double frame_length_variance =
+        accumulated_frame_length_squared / system_frames - mean_frame_length * mean_frame_length;
+    results.frametime_deviation = std::sqrt(std::max(frame_length_variance, 0.0));
+    results.present_time = duration_cast<DoubleSecs>(accumulated_present_time).count() /
+                           static_cast<double>(system_frames);
+    results.gpu_time = duration_cast<DoubleSecs>(accumulated_gpu_time).count() /
+                       static_cast<double>(system_frames);
+    results.limiter_time = duration_cast<DoubleSecs>(accumulated_limiter_time).count() /
+                           static_cast<double>(system_frames);
+    results.frame_length_histogram = frame_length_histogram;
+
+    // The most recent frames of the history are the ones since the reset
+    std::vector<double> frame_lengths;
+    const std::size_t num_frames = std::min<std::size_t>(system_frames, frame_history_size);
+    for (std::size_t i = 0; i < num_frames; ++i) {
+        const std::size_t index = frame_history_next + FrameHistorySize - 1 - i;
+        frame_lengths.push_back(frame_history[index % FrameHistorySize].length);
+    }
+    results.low_1_percent_fps = LowFrameRate(frame_lengths, 0.01);
+    results.low_0_1_percent_fps = LowFrameRate(std::move(frame_lengths), 0.001);
+    results.audio_underruns = audio_underruns.exchange(0, std::memory_order_relaxed);
+    results.audio_overruns = audio_overruns.exchange(0, std::memory_order_relaxed);
+    results.audio_queue_level = audio_queue_level.load(std::memory_order_relaxed);
+    results.audio_stretch_ratio = audio_stretch_ratio.load(std::memory_order_relaxed);
+    results.audio_latency = audio_latency.load(std::memory_order_relaxed);
+
     // Reset counters
     reset_point = now;
     reset_point_system_us = current_system_time_us;
     accumulated_frametime = Clock::duration::zero();
     system_frames = 0;
     game_frames = 0;
+    accumulated_frame_length = 0.0;
+    accumulated_frame_length_squared = 0.0;
+    accumulated_present_time = Clock::duration::zero();
+    accumulated_gpu_time = Clock::duration::zero();
+    accumulated_limiter_time = Clock::duration::zero();
+    frame_length_histogram.fill(0);
 
     return results;
 }
 
+std::vector<PerfStats::FrameSample> PerfStats::GetFrameHistory() {
+    std::lock_guard<std::mutex> lock(object_mutex);
+
+    std::vector<FrameSample> frames;
+    frames.reserve(frame_history_size);
+    const std::size_t oldest = (frame_history_next + FrameHistorySize - frame_history_size) %
+                               FrameHistorySize;
+    for (std::size_t i = 0; i < frame_history_size; ++i) {
+        frames.push_back(frame_history[(oldest + i) % FrameHistorySize]);
+    }
+    return frames;
+}
+
+void PerfStats::StartRecordingFrames() {
+    std::lock_guard<std::mutex> lock(object_mutex);
+
+    recorded_frames.clear();
+    recording_frames = true;
+}
+
+std::vector<PerfStats::FrameSample> PerfStats::TakeRecordedFrames() {
+    std::lock_guard<std::mutex> lock(object_mutex);
+
+    recording_frames = false;
+    return std::move(recorded_frames);
+}
+
 double PerfStats::GetLastFrameTimeScale() {
     std::lock_guard<std::mutex> lock(object_mutex);
 
@@ -73,6 +210,45 @@ double PerfStats::GetLastFrameTimeScale() {
     return duration_cast<DoubleSecs>(previous_frame_length).count() / FRAME_LENGTH;
 }
 
+double LowFrameRate(std::vector<double> frame_lengths, double fraction) {
+    if (frame_lengths.empty()) {
+        return 0.0;
+    }
+
+    const std::size_t count = std::clamp<std::size_t>(
+        static_cast<std::size_t>(std::ceil(frame_lengths.size() * fraction)), 1,
+        frame_lengths.size());
+    std::partial_sort(frame_lengths.begin(), frame_lengths.begin() + count, frame_lengths.end(),
+                      std::greater<>());
+    const double total_length =
+        std::accumulate(frame_lengths.begin(), frame_lengths.begin() + count, 0.0);
+    return total_length > 0.0 ? count / total_length : 0.0;
+}
+
+std::string FramesToCsv(const std::vector<PerfStats::FrameSample>& frames) {
+    std::string csv = "frame,length_ms,emulation_ms,gpu_ms,present_ms,limiter_ms\n";
+    for (std::size_t i = 0; i < frames.size(); ++i) {
+        const auto& frame = frames[i];
+        csv += fmt::format("{},{:.3f},{:.3f},{:.3f},{:.3f},{:.3f}\n", i, frame.length * 1000.0,
+                           frame.emulation_time * 1000.0, frame.gpu_time * 1000.0,
+                           frame.present_time * 1000.0, frame.limiter_time * 1000.0);
+    }
+    return csv;
+}
+
+FrameLimiter::FrameLimiter() {
+#ifdef _WIN32
+    // Lets sleeps wake up within about a millisecond instead of on the default 15.6 ms tick
+    timeBeginPeriod(1);
+#endif
+}
+
+FrameLimiter::~FrameLimiter() {
+#ifdef _WIN32
+    timeEndPeriod(1);
+#endif
+}
+
 void FrameLimiter::DoFrameLimiting(microseconds current_system_time_us) {
     // Max lag caused by slow frames. Can be adjusted to compensate for too many slow frames. Higher
     // values increase the time needed to recover and limit framerate again after spikes.
@@ -100,7 +276,7 @@ void FrameLimiter::DoFrameLimiting(microseconds current_system_time_us) {
         std::clamp(frame_limiting_delta_err, -max_lag_time_us, max_lag_time_us);
 
     if (frame_limiting_delta_err > microseconds::zero()) {
-        std::this_thread::sleep_for(frame_limiting_delta_err);
+        WaitUntil(now + frame_limiting_delta_err);
         auto now_after_sleep = Clock::now();
         frame_limiting_delta_err -= duration_cast<microseconds>(now_after_sleep - now);
         now = now_after_sleep;
@@ -110,4 +286,27 @@ void FrameLimiter::DoFrameLimiting(microseconds current_system_time_us) {
     previous_walltime = now;
 }
 
+void FrameLimiter::WaitUntil(Clock::time_point time) {
+    // Caps the estimate, so that a single preemption of the thread doesn't make the following
+    // waits spin for long
+    constexpr Clock::duration MAX_SLEEP_OVERSHOOT = 4ms;
+
+    auto now = Clock::now();
+    while (time - now > sleep_overshoot) {
+        const auto requested = time - now - sleep_overshoot;
+        std::this_thread::sleep_for(requested);
+        const auto after_sleep = Clock::now();
+        const auto overshoot =
+            std::clamp<Clock::duration>(after_sleep - now - requested, 0ms, MAX_SLEEP_OVERSHOOT);
+        // Follows a rising overshoot right away and a falling one slowly, as waking up late
+        // causes a visible hitch while spinning too long only costs CPU time
+        sleep_overshoot = std::max(overshoot, sleep_overshoot - sleep_overshoot / 16);
+        now = after_sleep;
+    }
+
+    while (Clock::now() < time) {
+        Common::YieldCPU();
+    }
+}
+
 } // namespace Core
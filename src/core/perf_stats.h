@@ -4,8 +4,12 @@
 
 #pragma once
 
+#include <array>
+#include <atomic>
 #include <chrono>
 #include <mutex>
+#include <string>
+#include <vector>
 #include "common/common_types.h"
 
 namespace Core {
@@ -18,6 +22,25 @@ class PerfStats {
 public:
     using Clock = std::chrono::high_resolution_clock;
 
+    /// Width of a bucket of the frame length histogram, in seconds
+    static constexpr double HistogramBucketLength = 0.004;
+    /// Buckets of the frame length histogram, the last one also holds every longer frame
+    static constexpr std::size_t NumHistogramBuckets = 26;
+
+    /// Timings of one system frame, which lasts from the end of the previous one to its own end
+    struct FrameSample {
+        /// Walltime between the end of the previous frame and the end of this one, in seconds
+        double length;
+        /// Part of it spent emulating, excluding presentation and frame limiting, in seconds
+        double emulation_time;
+        /// Part of the emulation spent processing GPU command lists, in seconds
+        double gpu_time;
+        /// Part of it spent presenting the previous frame, including any v-sync wait, in seconds
+        double present_time;
+        /// Part of it spent sleeping in the frame limiter, in seconds
+        double limiter_time;
+    };
+
     struct Results {
         /// System FPS (LCD VBlanks) in Hz
         double system_fps;
@@ -27,20 +50,83 @@ public:
         double frametime;
         /// Ratio of walltime / emulated time elapsed
         double emulation_speed;
+        /// Standard deviation of the walltime between system frames, in seconds
+        double frametime_deviation;
+        /// Walltime per system frame spent presenting it to the display, in seconds
+        double present_time;
+        /// Walltime per system frame spent processing GPU command lists, in seconds
+        double gpu_time;
+        /// Walltime per system frame spent sleeping in the frame limiter, in seconds
+        double limiter_time;
+        /// Average rate of the slowest 1% and 0.1% of the system frames, in Hz. Stutters show up
+        /// in these long before they move the averages.
+        double low_1_percent_fps;
+        double low_0_1_percent_fps;
+        /// Number of system frames by length, in buckets of HistogramBucketLength seconds
+        std::array<u32, NumHistogramBuckets> frame_length_histogram;
+        /// Times the audio sink ran dry and had to output silence
+        u32 audio_underruns;
+        /// Times the audio sink queue was full and samples had to be dropped
+        u32 audio_overruns;
+        /// Fill level of the audio sink queue as last seen by the audio thread, from 0 to 1
+        double audio_queue_level;
+        /// Tempo audio was last played at, below 1 while stretched to cover a slowdown
+        double audio_stretch_ratio;
+        /// Time from a sample being queued to it being heard, as last measured, in seconds
+        double audio_latency;
     };
 
     void BeginSystemFrame();
     void EndSystemFrame();
     void EndGameFrame();
 
+    /// Records how long presenting the current system frame took, including any v-sync wait
+    void AddPresentTime(Clock::duration present_time);
+
+    /// Records time the current system frame spent processing GPU command lists
+    void AddGpuTime(Clock::duration gpu_time);
+
+    /// Records how long the frame limiter slept after the current system frame
+    void AddLimiterTime(Clock::duration limiter_time);
+
+    /**
+     * Audio sink statistics. These are lock-free so they can be called from the real-time audio
+     * thread.
+     */
+    void ReportAudioUnderrun();
+    void ReportAudioOverrun();
+    void ReportAudioQueueLevel(double level);
+    void ReportAudioStretchRatio(double ratio);
+    void ReportAudioLatency(double seconds);
+
     Results GetAndResetStats(std::chrono::microseconds current_system_time_us);
 
+    /// Returns the number of system frames that ended since the emulation started
+    u64 GetTotalSystemFrames() const {
+        return total_system_frames.load(std::memory_order_relaxed);
+    }
+
+    /// Returns the timings of the most recent system frames, at most FrameHistorySize, oldest first
+    std::vector<FrameSample> GetFrameHistory();
+
+    /**
+     * Keeps the timings of every system frame from now on, as benchmarks need their distribution
+     * and not just the average. Recording stops once they're taken.
+     */
+    void StartRecordingFrames();
+
+    /// Returns the timings of every system frame since recording started
+    std::vector<FrameSample> TakeRecordedFrames();
+
     /**
      * Gets the ratio between walltime and the emulated time of the previous system frame. This is
      * useful for scaling inputs or outputs moving between the two time domains.
      */
     double GetLastFrameTimeScale();
 
+    /// Number of frames GetFrameHistory keeps
+    static constexpr std::size_t FrameHistorySize = 1024;
+
 private:
     std::mutex object_mutex;
 
@@ -55,6 +141,37 @@ private:
     u32 system_frames = 0;
     /// Cumulative number of game frames (GSP frame submissions) since last reset
     u32 game_frames = 0;
+    /// Cumulative visible length of system frames and its square since last reset, in seconds, to
+    /// derive how much the frame pacing varies
+    double accumulated_frame_length = 0.0;
+    double accumulated_frame_length_squared = 0.0;
+    /// Cumulative time spent presenting system frames since last reset
+    Clock::duration accumulated_present_time = Clock::duration::zero();
+    /// Cumulative time spent processing GPU command lists since last reset
+    Clock::duration accumulated_gpu_time = Clock::duration::zero();
+    /// Cumulative time the frame limiter slept since last reset
+    Clock::duration accumulated_limiter_time = Clock::duration::zero();
+    /// Frame lengths since last reset, by HistogramBucketLength
+    std::array<u32, NumHistogramBuckets> frame_length_histogram{};
+
+    /// Cumulative number of system frames since the emulation started, never reset
+    std::atomic<u64> total_system_frames{0};
+
+    /// Ring of the timings of the most recent system frames
+    std::array<FrameSample, FrameHistorySize> frame_history{};
+    /// Index of frame_history the next frame is written to
+    std::size_t frame_history_next = 0;
+    /// Number of valid frames in frame_history
+    std::size_t frame_history_size = 0;
+
+    /// Timings of every system frame while recording
+    std::vector<FrameSample> recorded_frames;
+    bool recording_frames = false;
+
+    /// Parts of the current system frame, as recorded so far
+    Clock::duration current_gpu_time = Clock::duration::zero();
+    Clock::duration current_present_time = Clock::duration::zero();
+    Clock::duration current_limiter_time = Clock::duration::zero();
 
     /// Point when the previous system frame ended
     Clock::time_point previous_frame_end = reset_point;
@@ -62,15 +179,41 @@ private:
     Clock::time_point frame_begin = reset_point;
     /// Total visible duration (including frame-limiting, etc.) of the previous system frame
     Clock::duration previous_frame_length = Clock::duration::zero();
+
+    /// Audio sink counters since last reset, updated without object_mutex
+    std::atomic<u32> audio_underruns{0};
+    std::atomic<u32> audio_overruns{0};
+    std::atomic<double> audio_queue_level{0.0};
+    std::atomic<double> audio_stretch_ratio{1.0};
+    std::atomic<double> audio_latency{0.0};
 };
 
+/**
+ * Returns the average rate of the slowest fraction of the given frames, in Hz, such as the "1%
+ * low" FPS for a fraction of 0.01. At least one frame is always taken.
+ * @param frame_lengths Lengths of the frames in seconds.
+ */
+double LowFrameRate(std::vector<double> frame_lengths, double fraction);
+
+/// Formats frame timings as CSV, with one header line and one line per frame in milliseconds
+std::string FramesToCsv(const std::vector<PerfStats::FrameSample>& frames);
+
 class FrameLimiter {
 public:
     using Clock = std::chrono::high_resolution_clock;
 
+    FrameLimiter();
+    ~FrameLimiter();
+
     void DoFrameLimiting(std::chrono::microseconds current_system_time_us);
 
 private:
+    /**
+     * Waits until the given time. The thread sleeps while the time is further away than host
+     * sleeps have lately been overshooting, then spins for the remainder.
+     */
+    void WaitUntil(Clock::time_point time);
+
     /// Emulated system time (in microseconds) at the last limiter invocation
     std::chrono::microseconds previous_system_time_us{0};
     /// Walltime at the last limiter invocation
@@ -78,6 +221,9 @@ private:
 
     /// Accumulated difference between walltime and emulated time
     std::chrono::microseconds frame_limiting_delta_err{0};
+
+    /// Estimate of how late the host wakes up from sleeps, which the last part of a wait spins for
+    Clock::duration sleep_overshoot = std::chrono::milliseconds{1};
 };
 
 } // namespace Core
@@ -2,6 +2,15 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <functional>
+#include <utility>
+#include <vector>
+#include <fmt/format.h>
+#include <inih/cpp/INIReader.h>
+#include "common/file_util.h"
+#include "common/logging/log.h"
+#include "common/memory_tracker.h"
+#include "common/trace.h"
 #include "core/core.h"
 #include "core/gdbstub/gdbstub.h"
 #include "core/hle/service/hid/hid.h"
@@ -12,10 +21,57 @@ namespace Settings {
 
 Values values = {};
 
+/// Swap the value in use of every setting replaced by the current title's overrides with its
+/// global value
+static std::vector<std::function<void()>> swap_global_values;
+
+template <typename T>
+static bool BeginOverride(const INIReader& reader, const char* section, const char* key,
+                          T& value) {
+    if (reader.Get(section, key, "").empty()) {
+        return false;
+    }
+    swap_global_values.push_back(
+        [&value, global_value = value]() mutable { std::swap(value, global_value); });
+    LOG_INFO(Config, "Overriding {}/{} for this title", section, key);
+    return true;
+}
+
+static void OverrideBool(const INIReader& reader, const char* section, const char* key,
+                         bool& value) {
+    if (BeginOverride(reader, section, key, value)) {
+        value = reader.GetBoolean(section, key, value);
+    }
+}
+
+template <typename T>
+static void OverrideInteger(const INIReader& reader, const char* section, const char* key,
+                            T& value) {
+    if (BeginOverride(reader, section, key, value)) {
+        value = static_cast<T>(reader.GetInteger(section, key, static_cast<long>(value)));
+    }
+}
+
+static void OverrideReal(const INIReader& reader, const char* section, const char* key,
+                         float& value) {
+    if (BeginOverride(reader, section, key, value)) {
+        value = static_cast<float>(reader.GetReal(section, key, value));
+    }
+}
+
 void Apply() {
     GDBStub::SetServerPort(values.gdbstub_port);
     GDBStub::ToggleServer(values.use_gdbstub);
 
+    // Restarting would throw away what was recorded so far
+    if (values.record_trace && !Common::Trace::IsRecording()) {
+        Common::Trace::Start();
+    } else if (!values.record_trace) {
+        Common::Trace::Stop();
+    }
+
+    Common::SetTrackedMemoryLogInterval(std::chrono::seconds{values.memory_log_interval});
+
     auto& system_instance = Core::System::GetInstance();
     if (system_instance.IsPoweredOn()) {
         system_instance.Renderer().RefreshBaseSettings();
@@ -24,4 +80,44 @@ void Apply() {
     Service::HID::ReloadInputDevices();
 }
 
+void LoadTitleOverrides(u64 title_id) {
+    RestoreGlobalValues();
+
+    const std::string path{fmt::format("{}custom/{:016X}.ini",
+                                       FileUtil::GetUserPath(FileUtil::UserPath::ConfigDir),
+                                       title_id)};
+    if (!FileUtil::Exists(path)) {
+        return;
+    }
+
+    const INIReader reader{path};
+    if (reader.ParseError() != 0) {
+        LOG_ERROR(Config, "Failed to parse title overrides {}, using the global settings", path);
+        return;
+    }
+    LOG_INFO(Config, "Loading title overrides from {}", path);
+
+    // Only settings worth trading off per title, and read at boot by the code they configure
+    OverrideBool(reader, "Core", "use_multi_core", values.use_multi_core);
+    OverrideReal(reader, "Renderer", "resolution_factor", values.resolution_factor);
+    OverrideBool(reader, "Renderer", "use_frame_limit", values.use_frame_limit);
+    OverrideInteger(reader, "Renderer", "frame_limit", values.frame_limit);
+    OverrideBool(reader, "Renderer", "use_accurate_framebuffers",
+                 values.use_accurate_framebuffers);
+    OverrideInteger(reader, "Renderer", "max_surface_cache_size", values.max_surface_cache_size);
+    OverrideBool(reader, "Renderer", "use_asynchronous_shaders",
+                 values.use_asynchronous_shaders);
+}
+
+void RestoreGlobalValues() {
+    SwapGlobalValues();
+    swap_global_values.clear();
+}
+
+void SwapGlobalValues() {
+    for (auto& swap : swap_global_values) {
+        swap();
+    }
+}
+
 } // namespace Settings
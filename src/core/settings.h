@@ -109,6 +109,16 @@ static const std::array<const char*, NumAnalogs> mapping = {{
 }};
 } // namespace NativeAnalog
 
+enum class RendererBackend : u32 {
+    OpenGL = 0,
+};
+
+enum class PresentMode : u32 {
+    Immediate = 0,   ///< Presents right away, frames may tear
+    Fifo = 1,        ///< Waits for the vertical blank before presenting
+    FifoRelaxed = 2, ///< Waits for the vertical blank unless the frame is already late
+};
+
 struct Values {
     // System
     bool use_docked_mode;
@@ -124,15 +134,25 @@ struct Values {
     // Core
     bool use_cpu_jit;
     bool use_multi_core;
+    bool pin_cpu_core_threads;
 
     // Data Storage
     bool use_virtual_sd;
+    u32 decrypted_cache_size; ///< In MiB shared by all content, 0 disables the cache
+    bool verify_nca_hashes;
 
     // Renderer
+    RendererBackend renderer_backend;
     float resolution_factor;
     bool use_frame_limit;
     u16 frame_limit;
     bool use_accurate_framebuffers;
+    u32 max_surface_cache_size; ///< In MiB, 0 disables the limit
+    bool use_disk_shader_cache;
+    bool use_asynchronous_shaders;
+    bool use_asynchronous_gpu_emulation;
+    PresentMode present_mode;
+    bool skip_present; ///< Only emulates frames without drawing them, set when benchmarking
 
     float bg_red;
     float bg_green;
@@ -146,11 +166,33 @@ struct Values {
     std::string sink_id;
     std::string audio_device_id;
     float volume;
+    bool enable_audio_stretching;
+    u32 audio_sink_latency;
+    u32 audio_mix_quantum;
+    u32 audio_queue_depth;
 
     // Debugging
     bool use_gdbstub;
     u16 gdbstub_port;
+    bool record_trace;
+    u32 memory_log_interval; ///< In seconds, 0 disables the summaries of the tracked memory
+    bool validate_warm_restart; ///< Checks the title file didn't change before a warm restart
 } extern values;
 
 void Apply();
+
+/**
+ * Replaces values with the ones set in the title's override file, "custom/<title id>.ini" in
+ * the config directory, if it has one. Only the keys present in the file are replaced.
+ */
+void LoadTitleOverrides(u64 title_id);
+
+/// Puts back the global values replaced by LoadTitleOverrides
+void RestoreGlobalValues();
+
+/**
+ * Swaps the values replaced by LoadTitleOverrides with their global values, a second call swaps
+ * them back. Lets the global config be saved while a title with overrides runs.
+ */
+void SwapGlobalValues();
 } // namespace Settings
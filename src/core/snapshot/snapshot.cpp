@@ -0,0 +1,383 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <utility>
+#include <boost/optional.hpp>
+#include <lz4.h>
+#include "common/assert.h"
+#include "common/hash.h"
+#include "common/logging/log.h"
+#include "core/core.h"
+#include "core/hle/kernel/process.h"
+#include "core/hle/kernel/scheduler.h"
+#include "core/hle/kernel/thread.h"
+#include "core/hle/kernel/vm_manager.h"
+#include "core/settings.h"
+#include "core/snapshot/snapshot.h"
+#include "video_core/gpu.h"
+#include "video_core/rasterizer_interface.h"
+#include "video_core/renderer_base.h"
+
+namespace Snapshot {
+
+namespace {
+
+/// Guest memory region and the host memory backing it
+struct HostRegion {
+    VAddr base;
+    u64 size;
+    u8* memory;
+};
+
+/// Chunk of a region, for spreading work on all the chunks of a snapshot across threads
+struct ChunkIndex {
+    std::size_t region;
+    std::size_t chunk;
+};
+
+/// Returns the regions of the address space that are backed by host memory, in address order
+std::vector<HostRegion> GetHostRegions(const Kernel::VMManager& vm_manager) {
+    std::vector<HostRegion> regions;
+    for (const auto& entry : vm_manager.vma_map) {
+        const Kernel::VirtualMemoryArea& vma = entry.second;
+        switch (vma.type) {
+        case Kernel::VMAType::AllocatedMemoryBlock:
+            regions.push_back({vma.base, vma.size, vma.backing_block->data() + vma.offset});
+            break;
+        case Kernel::VMAType::BackingMemory:
+            regions.push_back({vma.base, vma.size, vma.backing_memory});
+            break;
+        default:
+            break;
+        }
+    }
+    return regions;
+}
+
+std::size_t NumChunks(u64 region_size) {
+    return static_cast<std::size_t>((region_size + CHUNK_SIZE - 1) / CHUNK_SIZE);
+}
+
+std::size_t ChunkLength(u64 region_size, std::size_t chunk) {
+    return static_cast<std::size_t>(std::min<u64>(CHUNK_SIZE, region_size - chunk * CHUNK_SIZE));
+}
+
+std::vector<ChunkIndex> GetChunkIndices(const std::vector<HostRegion>& regions) {
+    std::vector<ChunkIndex> indices;
+    for (std::size_t region = 0; region < regions.size(); ++region) {
+        const std::size_t num_chunks = NumChunks(regions[region].size);
+        for (std::size_t chunk = 0; chunk < num_chunks; ++chunk) {
+            indices.push_back({region, chunk});
+        }
+    }
+    return indices;
+}
+
+/// Replaces the contents of the chunk with their LZ4 compressed form, unless it doesn't shrink
+void Compress(Chunk& chunk) {
+    const int size = static_cast<int>(chunk.data.size());
+    std::vector<u8> compressed(LZ4_compressBound(size));
+    const int compressed_size =
+        LZ4_compress_default(reinterpret_cast<const char*>(chunk.data.data()),
+                             reinterpret_cast<char*>(compressed.data()), size,
+                             static_cast<int>(compressed.size()));
+    if (compressed_size <= 0 || compressed_size >= size) {
+        return;
+    }
+    compressed.resize(compressed_size);
+    chunk.data = std::move(compressed);
+    chunk.compressed = true;
+}
+
+void Decompress(const Chunk& chunk, u8* dest, std::size_t length) {
+    if (!chunk.compressed) {
+        ASSERT(chunk.data.size() == length);
+        std::memcpy(dest, chunk.data.data(), length);
+        return;
+    }
+    const int decompressed_size = LZ4_decompress_safe(
+        reinterpret_cast<const char*>(chunk.data.data()), reinterpret_cast<char*>(dest),
+        static_cast<int>(chunk.data.size()), static_cast<int>(length));
+    ASSERT(decompressed_size == static_cast<int>(length));
+}
+
+/// Returns every guest thread, sorted by thread id, along with the core it is running on if any
+std::vector<std::pair<Kernel::Thread*, boost::optional<std::size_t>>> GetThreads(
+    Core::System& system) {
+    std::vector<std::pair<Kernel::Thread*, boost::optional<std::size_t>>> threads;
+    for (std::size_t core = 0; core < Core::NUM_CPU_CORES; ++core) {
+        const auto& scheduler = system.Scheduler(core);
+        const Kernel::Thread* current_thread = scheduler->GetCurrentThread();
+        for (const auto& thread : scheduler->GetThreadList()) {
+            boost::optional<std::size_t> running_core;
+            if (thread.get() == current_thread) {
+                running_core = core;
+            }
+            threads.emplace_back(thread.get(), running_core);
+        }
+    }
+    std::sort(threads.begin(), threads.end(), [](const auto& lhs, const auto& rhs) {
+        return lhs.first->GetThreadId() < rhs.first->GetThreadId();
+    });
+    return threads;
+}
+
+bool IsSameMemoryLayout(const std::vector<HostRegion>& regions,
+                        const std::vector<MemoryRegion>& snapshot_regions) {
+    return std::equal(regions.begin(), regions.end(), snapshot_regions.begin(),
+                      snapshot_regions.end(), [](const HostRegion& lhs, const MemoryRegion& rhs) {
+                          return lhs.base == rhs.base && lhs.size == rhs.size;
+                      });
+}
+
+bool IsSameGpuMapping(const std::vector<Tegra::MemoryManager::MappedRange>& lhs,
+                      const std::vector<Tegra::MemoryManager::MappedRange>& rhs) {
+    return std::equal(lhs.begin(), lhs.end(), rhs.begin(), rhs.end(),
+                      [](const auto& a, const auto& b) {
+                          return a.gpu_addr == b.gpu_addr && a.cpu_addr == b.cpu_addr &&
+                                 a.size == b.size;
+                      });
+}
+
+} // Anonymous namespace
+
+Manager::Manager() = default;
+
+Manager::~Manager() {
+    WaitForCompression();
+}
+
+void Manager::RequestSave(std::size_t slot) {
+    ASSERT(slot < NUM_SLOTS);
+    std::lock_guard<std::mutex> lock(request_mutex);
+    requests.push_back({false, slot});
+    has_requests = true;
+}
+
+void Manager::RequestLoad(std::size_t slot) {
+    ASSERT(slot < NUM_SLOTS);
+    std::lock_guard<std::mutex> lock(request_mutex);
+    requests.push_back({true, slot});
+    has_requests = true;
+}
+
+void Manager::HandleRequests(Core::System& system) {
+    if (!has_requests.load(std::memory_order_relaxed)) {
+        return;
+    }
+
+    std::vector<Request> pending_requests;
+    {
+        std::lock_guard<std::mutex> lock(request_mutex);
+        pending_requests.swap(requests);
+        has_requests = false;
+    }
+
+    if (Settings::values.use_multi_core) {
+        // The other cores keep running guest code while this one would take the snapshot
+        LOG_ERROR(Core, "Snapshots are not supported with multicore CPU emulation");
+        return;
+    }
+
+    for (const Request& request : pending_requests) {
+        if (request.is_load) {
+            Load(system, request.slot);
+        } else {
+            Save(system, request.slot);
+        }
+    }
+}
+
+void Manager::Save(Core::System& system, std::size_t slot) {
+    ASSERT(slot < NUM_SLOTS);
+    const auto start_time = std::chrono::steady_clock::now();
+
+    // Surfaces rendered by the GPU only reach the guest memory once they are flushed, and the
+    // engine state is only complete once the GPU thread is done with the work queued so far
+    system.GPU().WaitIdle();
+    auto& renderer = system.Renderer();
+    renderer.RunWithContext([&renderer] { renderer.Rasterizer().FlushAll(); });
+
+    auto snapshot = std::make_shared<SystemSnapshot>();
+    const std::vector<HostRegion> regions = GetHostRegions(system.CurrentProcess()->vm_manager);
+
+    // Chunks are compared against the ones of the region at the same place in the latest snapshot
+    std::vector<const MemoryRegion*> previous_regions(regions.size());
+    snapshot->memory.reserve(regions.size());
+    for (std::size_t i = 0; i < regions.size(); ++i) {
+        const HostRegion& region = regions[i];
+        snapshot->memory.push_back({region.base, region.size, {}});
+        snapshot->memory.back().chunks.resize(NumChunks(region.size));
+        if (latest == nullptr) {
+            continue;
+        }
+        const auto previous = std::find_if(
+            latest->memory.begin(), latest->memory.end(), [&region](const MemoryRegion& other) {
+                return other.base == region.base && other.size == region.size;
+            });
+        if (previous != latest->memory.end()) {
+            previous_regions[i] = &*previous;
+        }
+    }
+
+    // Only the chunks that changed since the latest snapshot are copied, the rest is shared
+    const std::vector<ChunkIndex> indices = GetChunkIndices(regions);
+    std::vector<std::shared_ptr<Chunk>> new_chunks(indices.size());
+    Common::GetSharedThreadPool().ParallelFor(indices.size(), [&](std::size_t i) {
+        const ChunkIndex& index = indices[i];
+        const u8* const data = regions[index.region].memory + index.chunk * CHUNK_SIZE;
+        const std::size_t length = ChunkLength(regions[index.region].size, index.chunk);
+        const u64 hash = Common::ComputeXXHash64(data, length);
+
+        auto& chunk = snapshot->memory[index.region].chunks[index.chunk];
+        const MemoryRegion* const previous_region = previous_regions[index.region];
+        if (previous_region != nullptr && previous_region->chunks[index.chunk]->hash == hash) {
+            chunk = previous_region->chunks[index.chunk];
+            return;
+        }
+        chunk = std::make_shared<Chunk>();
+        chunk->hash = hash;
+        chunk->data.assign(data, data + length);
+        new_chunks[i] = chunk;
+    });
+    new_chunks.erase(std::remove(new_chunks.begin(), new_chunks.end(), nullptr), new_chunks.end());
+
+    for (const auto& entry : GetThreads(system)) {
+        const Kernel::Thread& thread = *entry.first;
+        ThreadState state{thread.GetThreadId(), static_cast<u32>(thread.status), thread.context,
+                          thread.GetTPIDR_EL0()};
+        if (entry.second) {
+            // The registers of the running threads are only up to date in their CPU cores
+            ARM_Interface& cpu = system.ArmInterface(*entry.second);
+            cpu.SaveContext(state.context);
+            state.tpidr_el0 = cpu.GetTPIDR_EL0();
+        }
+        snapshot->threads.push_back(state);
+    }
+
+    snapshot->events = CoreTiming::GetQueuedEvents();
+    snapshot->gpu_mappings = system.GPU().memory_manager->GetMappedRanges();
+    snapshot->gpu_state = system.GPU().GetEngineState();
+
+    const std::size_t num_new_chunks = new_chunks.size();
+    pending_compression.erase(
+        std::remove_if(pending_compression.begin(), pending_compression.end(),
+                       [](const Common::Future<void>& future) { return future.IsReady(); }),
+        pending_compression.end());
+    pending_compression.push_back(Common::GetSharedThreadPool().Submit(
+        [chunks = std::move(new_chunks)] {
+            for (const auto& chunk : chunks) {
+                Compress(*chunk);
+            }
+        },
+        Common::TaskPriority::Low));
+
+    latest = snapshot;
+    slots[slot] = std::move(snapshot);
+
+    const auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - start_time);
+    LOG_INFO(Core, "Saved snapshot {} in {} ms, {} of {} memory chunks changed", slot,
+             elapsed.count(), num_new_chunks, indices.size());
+}
+
+bool Manager::Load(Core::System& system, std::size_t slot) {
+    ASSERT(slot < NUM_SLOTS);
+    const auto start_time = std::chrono::steady_clock::now();
+
+    const std::shared_ptr<const SystemSnapshot> snapshot = slots[slot];
+    if (snapshot == nullptr) {
+        LOG_ERROR(Core, "There is no snapshot {} to load", slot);
+        return false;
+    }
+
+    // Kernel objects aren't part of snapshots, so the ones they refer to must still be the same
+    const std::vector<HostRegion> regions = GetHostRegions(system.CurrentProcess()->vm_manager);
+    if (!IsSameMemoryLayout(regions, snapshot->memory)) {
+        LOG_ERROR(Core, "Guest memory was mapped or unmapped since snapshot {} was saved", slot);
+        return false;
+    }
+    const auto threads = GetThreads(system);
+    const bool same_threads = std::equal(
+        threads.begin(), threads.end(), snapshot->threads.begin(), snapshot->threads.end(),
+        [](const auto& thread, const ThreadState& state) {
+            return thread.first->GetThreadId() == state.thread_id &&
+                   static_cast<u32>(thread.first->status) == state.status;
+        });
+    if (!same_threads) {
+        LOG_ERROR(Core, "Guest threads were created or changed state since snapshot {} was saved",
+                  slot);
+        return false;
+    }
+    auto& gpu = system.GPU();
+    gpu.WaitIdle();
+    const auto gpu_mappings = gpu.memory_manager->GetMappedRanges();
+    if (!IsSameGpuMapping(gpu_mappings, snapshot->gpu_mappings)) {
+        LOG_ERROR(Core, "GPU memory was mapped or unmapped since snapshot {} was saved", slot);
+        return false;
+    }
+    if (!CoreTiming::RestoreQueuedEvents(snapshot->events)) {
+        return false;
+    }
+
+    const bool restored_gpu_state = gpu.SetEngineState(snapshot->gpu_state);
+    ASSERT_MSG(restored_gpu_state, "GPU engine layout changed within a session");
+
+    WaitForCompression();
+
+    // Only the chunks that differ from the current memory have to be decompressed
+    const std::vector<ChunkIndex> indices = GetChunkIndices(regions);
+    std::atomic<std::size_t> num_restored_chunks{0};
+    Common::GetSharedThreadPool().ParallelFor(indices.size(), [&](std::size_t i) {
+        const ChunkIndex& index = indices[i];
+        u8* const data = regions[index.region].memory + index.chunk * CHUNK_SIZE;
+        const std::size_t length = ChunkLength(regions[index.region].size, index.chunk);
+        const Chunk& chunk = *snapshot->memory[index.region].chunks[index.chunk];
+        if (Common::ComputeXXHash64(data, length) != chunk.hash) {
+            Decompress(chunk, data, length);
+            num_restored_chunks.fetch_add(1, std::memory_order_relaxed);
+        }
+    });
+
+    for (const auto& range : gpu_mappings) {
+        gpu.InvalidateRegion(range.gpu_addr, range.size);
+    }
+
+    for (std::size_t i = 0; i < threads.size(); ++i) {
+        Kernel::Thread& thread = *threads[i].first;
+        const ThreadState& state = snapshot->threads[i];
+        thread.context = state.context;
+        thread.tpidr_el0 = state.tpidr_el0;
+        if (threads[i].second) {
+            ARM_Interface& cpu = system.ArmInterface(*threads[i].second);
+            cpu.LoadContext(state.context);
+            cpu.SetTPIDR_EL0(state.tpidr_el0);
+        }
+    }
+    for (std::size_t core = 0; core < Core::NUM_CPU_CORES; ++core) {
+        system.ArmInterface(core).ClearInstructionCache();
+        system.ArmInterface(core).ClearExclusiveState();
+    }
+
+    latest = snapshot;
+
+    const auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - start_time);
+    LOG_INFO(Core, "Loaded snapshot {} in {} ms, {} of {} memory chunks restored", slot,
+             elapsed.count(), num_restored_chunks.load(), indices.size());
+    return true;
+}
+
+void Manager::WaitForCompression() {
+    for (const auto& future : pending_compression) {
+        future.Wait();
+    }
+    pending_compression.clear();
+}
+
+} // namespace Snapshot
@@ -0,0 +1,117 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "common/common_types.h"
+#include "common/thread_pool.h"
+#include "core/arm/arm_interface.h"
+#include "core/core_timing.h"
+#include "video_core/gpu.h"
+#include "video_core/memory_manager.h"
+
+namespace Core {
+class System;
+}
+
+namespace Snapshot {
+
+/// Guest memory is compared, stored and compressed in chunks of this size
+constexpr std::size_t CHUNK_SIZE = 0x10000;
+
+/**
+ * Contents of a chunk of guest memory. Snapshots share the chunks that didn't change between
+ * them, so a snapshot only stores the chunks written to since the one before it.
+ */
+struct Chunk {
+    u64 hash;
+    /// Contents of the chunk, LZ4 compressed once compressed is set
+    std::vector<u8> data;
+    bool compressed = false;
+};
+
+/// Memory mapped to a range of the guest's address space
+struct MemoryRegion {
+    VAddr base;
+    u64 size;
+    std::vector<std::shared_ptr<Chunk>> chunks;
+};
+
+struct ThreadState {
+    u32 thread_id;
+    u32 status;
+    ARM_Interface::ThreadContext context;
+    u64 tpidr_el0;
+};
+
+/**
+ * State of the emulated system at a point between two CPU slices: the guest memory, the registers
+ * of every guest thread, the pending CoreTiming events and the GPU engine state. Kernel objects
+ * and service state aren't part of it, so snapshots can only be restored into the session that
+ * took them, as long as the guest threads are in the same state as when they were taken.
+ */
+struct SystemSnapshot {
+    std::vector<MemoryRegion> memory;
+    std::vector<ThreadState> threads;
+    std::vector<CoreTiming::QueuedEvent> events;
+    std::vector<Tegra::MemoryManager::MappedRange> gpu_mappings;
+    Tegra::GPU::EngineState gpu_state;
+};
+
+/**
+ * Takes and restores snapshots of the running system in a fixed number of slots. Requests are
+ * queued from any thread and carried out by the CPU thread before its next slice.
+ */
+class Manager {
+public:
+    static constexpr std::size_t NUM_SLOTS = 10;
+
+    Manager();
+    ~Manager();
+
+    /// Requests a snapshot of the system to be saved to the given slot. Thread-safe.
+    void RequestSave(std::size_t slot);
+
+    /// Requests the system to be restored to the snapshot in the given slot. Thread-safe.
+    void RequestLoad(std::size_t slot);
+
+    /// Carries out the pending requests. Called by the CPU thread between slices.
+    void HandleRequests(Core::System& system);
+
+    /// Takes a snapshot of the system into the given slot
+    void Save(Core::System& system, std::size_t slot);
+
+    /// Restores the system to the snapshot in the given slot, returning false if it can't be
+    bool Load(Core::System& system, std::size_t slot);
+
+private:
+    struct Request {
+        bool is_load;
+        std::size_t slot;
+    };
+
+    /// Waits until the chunks of every snapshot are compressed
+    void WaitForCompression();
+
+    std::mutex request_mutex;
+    std::vector<Request> requests;
+    /// Lets the CPU thread check for requests without taking the lock
+    std::atomic_bool has_requests{false};
+
+    std::array<std::shared_ptr<const SystemSnapshot>, NUM_SLOTS> slots;
+
+    /// Snapshot the guest memory matched last, which the next one is compared against
+    std::shared_ptr<const SystemSnapshot> latest;
+
+    /// Compression of the chunks new to each snapshot, done by the shared thread pool
+    std::vector<Common::Future<void>> pending_compression;
+};
+
+} // namespace Snapshot
@@ -2,9 +2,13 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <atomic>
+#include <thread>
 #include "common/assert.h"
 #include "common/common_types.h"
 #include "common/file_util.h"
+#include "common/thread.h"
+#include "common/threadsafe_queue.h"
 
 #include "core/core.h"
 #include "core/settings.h"
@@ -12,6 +16,74 @@
 
 namespace Core {
 
+namespace {
+
+struct Submission {
+    std::unique_ptr<Telemetry::FieldCollection> fields;
+    std::unique_ptr<Telemetry::VisitorInterface> backend;
+};
+
+/**
+ * Thread visiting the fields of finished sessions with their backend, so that shutting down the
+ * emulation never waits on serializing or submitting them. Only a few sessions may be pending,
+ * any beyond those are dropped. Pending sessions are still submitted when the program exits.
+ */
+class TelemetrySubmitter final {
+public:
+    TelemetrySubmitter() : thread([this] { Loop(); }) {}
+
+    ~TelemetrySubmitter() {
+        stop = true;
+        event.Set();
+        thread.join();
+    }
+
+    void Submit(Submission submission) {
+        if (!pending.TryPush(std::move(submission))) {
+            LOG_WARNING(Core, "Too many telemetry sessions pending, dropping one");
+            return;
+        }
+        event.Set();
+    }
+
+private:
+    static constexpr std::size_t MAX_PENDING = 4;
+
+    void Loop();
+
+    Common::MPSCRing<Submission, MAX_PENDING> pending;
+    Common::Event event;
+    std::atomic_bool stop{false};
+    std::thread thread;
+};
+
+TelemetrySubmitter& GetSubmitter() {
+    static TelemetrySubmitter submitter;
+    return submitter;
+}
+
+void TelemetrySubmitter::Loop() {
+    Common::SetCurrentThreadName("TelemetrySubmitter");
+
+    Submission submission;
+    while (true) {
+        while (pending.Pop(submission)) {
+            // Reading the id touches the disk, which the session leaves to this thread as well
+            submission.fields->AddField(Telemetry::FieldType::None, "TelemetryId",
+                                        GetTelemetryId());
+            submission.fields->Accept(*submission.backend);
+            submission.backend->Complete();
+            submission = {};
+        }
+        if (stop) {
+            return;
+        }
+        event.Wait();
+    }
+}
+
+} // Anonymous namespace
+
 static u64 GenerateTelemetryId() {
     u64 telemetry_id{};
     return telemetry_id;
@@ -73,16 +145,16 @@ TelemetrySession::TelemetrySession() {
         backend = std::make_unique<WebService::TelemetryJson>(
             Settings::values.telemetry_endpoint_url, Settings::values.yuzu_username,
             Settings::values.yuzu_token);
-    } else {
-        backend = std::make_unique<Telemetry::NullVisitor>();
     }
-#else
-    backend = std::make_unique<Telemetry::NullVisitor>();
 #endif
-    // Log one-time top-level information
-    AddField(Telemetry::FieldType::None, "TelemetryId", GetTelemetryId());
+    // Without a backend that submits them, the fields would only be dropped, so none are
+    // collected at all
+    if (!backend) {
+        return;
+    }
+    field_collection = std::make_unique<Telemetry::FieldCollection>();
 
-    // Log one-time session start information
+    // Log one-time session start information, the TelemetryId is added on submission
     const s64 init_time{std::chrono::duration_cast<std::chrono::milliseconds>(
                             std::chrono::system_clock::now().time_since_epoch())
                             .count()};
@@ -94,16 +166,18 @@ TelemetrySession::TelemetrySession() {
     }
 
     // Log application information
-    Telemetry::AppendBuildInfo(field_collection);
+    Telemetry::AppendBuildInfo(*field_collection);
 
     // Log user system information
-    Telemetry::AppendCPUInfo(field_collection);
-    Telemetry::AppendOSInfo(field_collection);
+    Telemetry::AppendCPUInfo(*field_collection);
+    Telemetry::AppendOSInfo(*field_collection);
 
     // Log user configuration information
     AddField(Telemetry::FieldType::UserConfig, "Core_UseCpuJit", Settings::values.use_cpu_jit);
     AddField(Telemetry::FieldType::UserConfig, "Core_UseMultiCore",
              Settings::values.use_multi_core);
+    AddField(Telemetry::FieldType::UserConfig, "Renderer_Backend",
+             static_cast<u32>(Settings::values.renderer_backend));
     AddField(Telemetry::FieldType::UserConfig, "Renderer_ResolutionFactor",
              Settings::values.resolution_factor);
     AddField(Telemetry::FieldType::UserConfig, "Renderer_UseFrameLimit",
@@ -111,23 +185,41 @@ TelemetrySession::TelemetrySession() {
     AddField(Telemetry::FieldType::UserConfig, "Renderer_FrameLimit", Settings::values.frame_limit);
     AddField(Telemetry::FieldType::UserConfig, "Renderer_UseAccurateFramebuffers",
              Settings::values.use_accurate_framebuffers);
+    AddField(Telemetry::FieldType::UserConfig, "Renderer_MaxSurfaceCacheSize",
+             Settings::values.max_surface_cache_size);
+    AddField(Telemetry::FieldType::UserConfig, "Renderer_UseDiskShaderCache",
+             Settings::values.use_disk_shader_cache);
+    AddField(Telemetry::FieldType::UserConfig, "Renderer_UseAsynchronousShaders",
+             Settings::values.use_asynchronous_shaders);
+    AddField(Telemetry::FieldType::UserConfig, "Renderer_UseAsynchronousGpuEmulation",
+             Settings::values.use_asynchronous_gpu_emulation);
+    AddField(Telemetry::FieldType::UserConfig, "Renderer_PresentMode",
+             static_cast<u32>(Settings::values.present_mode));
+    AddField(Telemetry::FieldType::UserConfig, "Audio_EnableAudioStretching",
+             Settings::values.enable_audio_stretching);
+    AddField(Telemetry::FieldType::UserConfig, "Audio_SinkLatency",
+             Settings::values.audio_sink_latency);
+    AddField(Telemetry::FieldType::UserConfig, "Audio_MixQuantum",
+             Settings::values.audio_mix_quantum);
+    AddField(Telemetry::FieldType::UserConfig, "Audio_QueueDepth",
+             Settings::values.audio_queue_depth);
     AddField(Telemetry::FieldType::UserConfig, "System_UseDockedMode",
              Settings::values.use_docked_mode);
 }
 
 TelemetrySession::~TelemetrySession() {
+    if (!field_collection) {
+        return;
+    }
+
     // Log one-time session end information
     const s64 shutdown_time{std::chrono::duration_cast<std::chrono::milliseconds>(
                                 std::chrono::system_clock::now().time_since_epoch())
                                 .count()};
     AddField(Telemetry::FieldType::Session, "Shutdown_Time", shutdown_time);
 
-    // Complete the session, submitting to web service if necessary
-    // This is just a placeholder to wrap up the session once the core completes and this is
-    // destroyed. This will be moved elsewhere once we are actually doing real I/O with the service.
-    field_collection.Accept(*backend);
-    backend->Complete();
-    backend = nullptr;
+    // Complete the session in the background, submitting to web service if necessary
+    GetSubmitter().Submit({std::move(field_collection), std::move(backend)});
 }
 
 } // namespace Core
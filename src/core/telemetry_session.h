@@ -13,7 +13,8 @@ namespace Core {
 /**
  * Instruments telemetry for this emulation session. Creates a new set of telemetry fields on each
  * session, logging any one-time fields. Interfaces with the telemetry backend used for submitting
- * data to the web service. Submits session data on close.
+ * data to the web service. Hands session data to a background thread on close, which serializes
+ * and submits it.
  */
 class TelemetrySession : NonCopyable {
 public:
@@ -28,11 +29,14 @@ public:
      */
     template <typename T>
     void AddField(Telemetry::FieldType type, const char* name, T value) {
-        field_collection.AddField(type, name, std::move(value));
+        if (field_collection) {
+            field_collection->AddField(type, name, std::move(value));
+        }
     }
 
 private:
-    Telemetry::FieldCollection field_collection; ///< Tracks all added fields for the session
+    /// Tracks all added fields for the session, null when they aren't submitted anywhere
+    std::unique_ptr<Telemetry::FieldCollection> field_collection;
     std::unique_ptr<Telemetry::VisitorInterface> backend; ///< Backend interface that logs fields
 };
 
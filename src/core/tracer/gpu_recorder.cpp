@@ -0,0 +1,172 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <cstring>
+#include <utility>
+#include "common/alignment.h"
+#include "common/logging/log.h"
+#include "core/core.h"
+#include "core/hle/kernel/process.h"
+#include "core/tracer/gpu_recorder.h"
+#include "video_core/gpu.h"
+#include "video_core/rasterizer_interface.h"
+#include "video_core/renderer_base.h"
+
+namespace GPUTrace {
+
+Recorder::Recorder(std::string filename, u32 first_frame, u32 num_frames)
+    : filename(std::move(filename)), frames_until_start(first_frame), frames_left(num_frames),
+      finished(num_frames == 0) {}
+
+Recorder::~Recorder() {
+    if (file.IsOpen()) {
+        LOG_WARNING(HW_GPU, "GPU trace {} stopped with {} frames left to record", filename,
+                    frames_left);
+        Stop();
+    }
+}
+
+void Recorder::BeginSubmission() {
+    if (!file.IsOpen()) {
+        if (finished || frames_until_start > 0) {
+            return;
+        }
+        Start();
+        if (!file.IsOpen()) {
+            return;
+        }
+    }
+    UpdateMemory();
+}
+
+void Recorder::CommandListSubmitted(Tegra::GPUVAddr address, u32 size) {
+    if (!file.IsOpen()) {
+        return;
+    }
+    const CommandList command_list{address, size};
+    WriteRecord(RecordType::CommandList, &command_list, sizeof(command_list));
+}
+
+void Recorder::FramePresented(const Tegra::FramebufferConfig& framebuffer) {
+    if (!file.IsOpen()) {
+        if (frames_until_start > 0) {
+            --frames_until_start;
+        }
+        return;
+    }
+
+    const Flip flip = EncodeFlip(framebuffer);
+    WriteRecord(RecordType::Flip, &flip, sizeof(flip));
+    if (--frames_left == 0) {
+        Stop();
+    }
+}
+
+bool Recorder::IsFinished() const {
+    return finished;
+}
+
+void Recorder::Start() {
+    auto& system = Core::System::GetInstance();
+
+    // Rendered surfaces may only be in the host GPU's memory, the initial copy of the guest memory
+    // has to hold them for the replay to sample them
+    system.GPU().WaitIdle();
+    auto& renderer = system.Renderer();
+    renderer.RunWithContext([&renderer] { renderer.Rasterizer().FlushAll(); });
+
+    file = FileUtil::IOFile(filename, "wb");
+    if (!file.IsOpen()) {
+        LOG_ERROR(HW_GPU, "Could not create GPU trace {}", filename);
+        finished = true;
+        return;
+    }
+    LOG_INFO(HW_GPU, "Recording {} frames to GPU trace {}", frames_left, filename);
+
+    Header header{};
+    std::memcpy(header.magic, Header::ExpectedMagicWord(), sizeof(header.magic));
+    header.version = Header::ExpectedVersion();
+    header.program_id = system.CurrentProcess()->program_id;
+    file.WriteObject(header);
+
+    const std::vector<u8> engine_state = EncodeEngineState(system.GPU().GetEngineState());
+    WriteRecord(RecordType::EngineState, engine_state.data(), engine_state.size());
+}
+
+void Recorder::Stop() {
+    file.Close();
+    finished = true;
+    mapped_ranges.clear();
+    shadow_pages.clear();
+    LOG_INFO(HW_GPU, "Finished GPU trace {}", filename);
+}
+
+void Recorder::WriteRecord(RecordType type, const void* data, u64 size) {
+    const RecordHeader record_header{type, size};
+    file.WriteObject(record_header);
+    file.WriteBytes(static_cast<const u8*>(data), size);
+}
+
+void Recorder::UpdateMemory() {
+    auto ranges = Core::System::GetInstance().GPU().memory_manager->GetMappedRanges();
+    const bool map_changed =
+        ranges.size() != mapped_ranges.size() ||
+        std::memcmp(ranges.data(), mapped_ranges.data(), ranges.size() * sizeof(ranges[0])) != 0;
+    if (map_changed) {
+        std::vector<MappedRange> records;
+        records.reserve(ranges.size());
+        for (const auto& range : ranges) {
+            records.push_back({range.gpu_addr, range.cpu_addr, range.size});
+        }
+        WriteRecord(RecordType::MemoryMap, records.data(), records.size() * sizeof(records[0]));
+        mapped_ranges = std::move(ranges);
+    }
+
+    // Changed pages are written in runs of contiguous pages, one record per run
+    for (const auto& range : mapped_ranges) {
+        const VAddr begin = Common::AlignDown(range.cpu_addr, Memory::PAGE_SIZE);
+        const VAddr end = Common::AlignUp(range.cpu_addr + range.size, Memory::PAGE_SIZE);
+        VAddr run_begin = begin;
+        u64 run_size = 0;
+        for (VAddr page = begin; page < end; page += Memory::PAGE_SIZE) {
+            const u8* const pointer =
+                Memory::IsValidVirtualAddress(page) ? Memory::GetPointer(page) : nullptr;
+            auto& shadow = shadow_pages[page];
+            bool changed = false;
+            if (pointer != nullptr && (!shadow || std::memcmp(shadow->data(), pointer,
+                                                              Memory::PAGE_SIZE) != 0)) {
+                if (!shadow) {
+                    shadow = std::make_unique<Page>();
+                }
+                std::memcpy(shadow->data(), pointer, Memory::PAGE_SIZE);
+                changed = true;
+            }
+
+            if (changed) {
+                if (run_size == 0) {
+                    run_begin = page;
+                }
+                run_size += Memory::PAGE_SIZE;
+            } else if (run_size != 0) {
+                WriteMemoryUpdate(run_begin, run_size);
+                run_size = 0;
+            }
+        }
+        if (run_size != 0) {
+            WriteMemoryUpdate(run_begin, run_size);
+        }
+    }
+}
+
+void Recorder::WriteMemoryUpdate(VAddr address, u64 pages_size) {
+    const u64 cpu_addr = address;
+    const RecordHeader record_header{RecordType::MemoryUpdate, sizeof(cpu_addr) + pages_size};
+    file.WriteObject(record_header);
+    file.WriteObject(cpu_addr);
+    for (VAddr page = address; page < address + pages_size; page += Memory::PAGE_SIZE) {
+        file.WriteBytes(shadow_pages.at(page)->data(), Memory::PAGE_SIZE);
+    }
+}
+
+} // namespace GPUTrace
@@ -0,0 +1,78 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <array>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "common/common_types.h"
+#include "common/file_util.h"
+#include "core/memory.h"
+#include "core/tracer/gpu_trace.h"
+
+namespace GPUTrace {
+
+/**
+ * Records the GPU work of a range of frames to a trace file. The trace starts with the engine
+ * state and a full copy of the GPU-mapped guest memory, and each submission after that is preceded
+ * by the memory the CPU changed since the previous one.
+ * @note Finding those changes compares all of the mapped memory against a copy of it, so titles
+ * run noticeably slower while they are being recorded.
+ */
+class Recorder {
+public:
+    /**
+     * @param filename Trace file to write.
+     * @param first_frame Number of frames presented before the recording starts.
+     * @param num_frames Number of frames to record.
+     */
+    Recorder(std::string filename, u32 first_frame, u32 num_frames);
+    ~Recorder();
+
+    /// Called before the GPU processes the command lists of a submission.
+    void BeginSubmission();
+
+    /// Called before the GPU processes each command list of a submission.
+    void CommandListSubmitted(Tegra::GPUVAddr address, u32 size);
+
+    /// Called before a frame is presented.
+    void FramePresented(const Tegra::FramebufferConfig& framebuffer);
+
+    /// Returns whether every requested frame has been recorded, or the recording failed.
+    bool IsFinished() const;
+
+private:
+    using Page = std::array<u8, Memory::PAGE_SIZE>;
+
+    /// Opens the trace file and writes the initial state to it
+    void Start();
+
+    /// Closes the trace file
+    void Stop();
+
+    void WriteRecord(RecordType type, const void* data, u64 size);
+
+    /// Writes the GPU memory map if it changed, and the memory that changed since the last call
+    void UpdateMemory();
+
+    /// Writes a MemoryUpdate record for pages_size bytes of memory starting at address
+    void WriteMemoryUpdate(VAddr address, u64 pages_size);
+
+    std::string filename;
+    u32 frames_until_start;
+    u32 frames_left;
+    bool finished = false;
+
+    FileUtil::IOFile file;
+
+    std::vector<Tegra::MemoryManager::MappedRange> mapped_ranges;
+
+    /// Contents of the guest pages as last written to the trace, by CPU address
+    std::unordered_map<VAddr, std::unique_ptr<Page>> shadow_pages;
+};
+
+} // namespace GPUTrace
@@ -0,0 +1,205 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <cstring>
+#include "core/tracer/gpu_trace.h"
+
+namespace GPUTrace {
+
+namespace {
+
+/// Appends values to the payload of a record
+class PayloadWriter {
+public:
+    explicit PayloadWriter(std::vector<u8>& data) : data(data) {}
+
+    template <typename T>
+    void Write(const T& value) {
+        WriteBytes(&value, sizeof(T));
+    }
+
+    /// Writes the number of elements of an array followed by the elements
+    template <typename T>
+    void WriteArray(const std::vector<T>& values) {
+        Write(static_cast<u32>(values.size()));
+        WriteBytes(values.data(), values.size() * sizeof(T));
+    }
+
+private:
+    void WriteBytes(const void* bytes, std::size_t size) {
+        const std::size_t offset = data.size();
+        data.resize(offset + size);
+        std::memcpy(data.data() + offset, bytes, size);
+    }
+
+    std::vector<u8>& data;
+};
+
+/// Reads values from the payload of a record, failing instead of reading past its end
+class PayloadReader {
+public:
+    explicit PayloadReader(const std::vector<u8>& data) : data(data) {}
+
+    template <typename T>
+    bool Read(T& value) {
+        return ReadBytes(&value, sizeof(T));
+    }
+
+    template <typename T>
+    bool ReadArray(std::vector<T>& values) {
+        u32 count;
+        if (!Read(count) || static_cast<u64>(count) * sizeof(T) > data.size() - offset) {
+            return false;
+        }
+        values.resize(count);
+        return ReadBytes(values.data(), count * sizeof(T));
+    }
+
+    bool AtEnd() const {
+        return offset == data.size();
+    }
+
+private:
+    bool ReadBytes(void* bytes, std::size_t size) {
+        if (size > data.size() - offset) {
+            return false;
+        }
+        std::memcpy(bytes, data.data() + offset, size);
+        offset += size;
+        return true;
+    }
+
+    const std::vector<u8>& data;
+    std::size_t offset = 0;
+};
+
+} // Anonymous namespace
+
+std::vector<u8> EncodeEngineState(const Tegra::GPU::EngineState& engine_state) {
+    std::vector<u8> data;
+    PayloadWriter writer(data);
+
+    writer.Write(static_cast<u32>(engine_state.bound_engines.size()));
+    for (const auto& binding : engine_state.bound_engines) {
+        writer.Write(binding.first);
+        writer.Write(static_cast<u32>(binding.second));
+    }
+
+    writer.WriteArray(engine_state.maxwell_3d_regs);
+    writer.WriteArray(engine_state.maxwell_3d_state);
+
+    writer.Write(static_cast<u32>(engine_state.maxwell_3d_macros.size()));
+    for (const auto& macro : engine_state.maxwell_3d_macros) {
+        writer.Write(macro.first);
+        writer.WriteArray(macro.second);
+    }
+
+    writer.WriteArray(engine_state.fermi_2d_regs);
+    writer.WriteArray(engine_state.maxwell_dma_regs);
+    return data;
+}
+
+boost::optional<Tegra::GPU::EngineState> DecodeEngineState(const std::vector<u8>& data) {
+    Tegra::GPU::EngineState engine_state;
+    PayloadReader reader(data);
+
+    u32 num_bound_engines;
+    if (!reader.Read(num_bound_engines)) {
+        return {};
+    }
+    for (u32 i = 0; i < num_bound_engines; ++i) {
+        u32 subchannel;
+        u32 engine;
+        if (!reader.Read(subchannel) || !reader.Read(engine)) {
+            return {};
+        }
+        engine_state.bound_engines.emplace_back(subchannel, static_cast<Tegra::EngineID>(engine));
+    }
+
+    if (!reader.ReadArray(engine_state.maxwell_3d_regs) ||
+        !reader.ReadArray(engine_state.maxwell_3d_state)) {
+        return {};
+    }
+
+    u32 num_macros;
+    if (!reader.Read(num_macros)) {
+        return {};
+    }
+    for (u32 i = 0; i < num_macros; ++i) {
+        u32 method;
+        std::vector<u32> code;
+        if (!reader.Read(method) || !reader.ReadArray(code)) {
+            return {};
+        }
+        engine_state.maxwell_3d_macros.emplace(method, std::move(code));
+    }
+
+    if (!reader.ReadArray(engine_state.fermi_2d_regs) ||
+        !reader.ReadArray(engine_state.maxwell_dma_regs) || !reader.AtEnd()) {
+        return {};
+    }
+    return engine_state;
+}
+
+Flip EncodeFlip(const Tegra::FramebufferConfig& framebuffer) {
+    Flip flip{};
+    flip.address = framebuffer.address;
+    flip.offset = framebuffer.offset;
+    flip.gpu_address = framebuffer.gpu_address;
+    flip.width = framebuffer.width;
+    flip.height = framebuffer.height;
+    flip.stride = framebuffer.stride;
+    flip.pixel_format = static_cast<u32>(framebuffer.pixel_format);
+    flip.transform_flags = static_cast<u32>(framebuffer.transform_flags);
+    flip.crop_left = framebuffer.crop_rect.left;
+    flip.crop_top = framebuffer.crop_rect.top;
+    flip.crop_right = framebuffer.crop_rect.right;
+    flip.crop_bottom = framebuffer.crop_rect.bottom;
+    return flip;
+}
+
+Tegra::FramebufferConfig DecodeFlip(const Flip& flip) {
+    Tegra::FramebufferConfig framebuffer{};
+    framebuffer.address = flip.address;
+    framebuffer.offset = flip.offset;
+    framebuffer.gpu_address = flip.gpu_address;
+    framebuffer.width = flip.width;
+    framebuffer.height = flip.height;
+    framebuffer.stride = flip.stride;
+    framebuffer.pixel_format =
+        static_cast<Tegra::FramebufferConfig::PixelFormat>(flip.pixel_format);
+    framebuffer.transform_flags =
+        static_cast<Tegra::FramebufferConfig::TransformFlags>(flip.transform_flags);
+    framebuffer.crop_rect = {flip.crop_left, flip.crop_top, flip.crop_right, flip.crop_bottom};
+    return framebuffer;
+}
+
+Reader::Reader(const std::string& filename) : file(filename, "rb") {
+    if (!file.IsOpen() || file.ReadBytes(&header, sizeof(header)) != sizeof(header)) {
+        return;
+    }
+    valid = std::memcmp(header.magic, Header::ExpectedMagicWord(), sizeof(header.magic)) == 0 &&
+            header.version == Header::ExpectedVersion();
+}
+
+bool Reader::IsValid() const {
+    return valid;
+}
+
+const Header& Reader::GetHeader() const {
+    return header;
+}
+
+bool Reader::ReadRecord(Record& record) {
+    RecordHeader record_header;
+    if (!valid || file.ReadBytes(&record_header, sizeof(record_header)) != sizeof(record_header)) {
+        return false;
+    }
+
+    record.type = record_header.type;
+    record.data.resize(record_header.size);
+    return file.ReadBytes(record.data.data(), record.data.size()) == record.data.size();
+}
+
+} // namespace GPUTrace
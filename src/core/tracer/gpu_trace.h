@@ -0,0 +1,123 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <boost/optional.hpp>
+#include "common/common_types.h"
+#include "common/file_util.h"
+#include "video_core/gpu.h"
+
+/**
+ * Recordings of the GPU work of a title, which replay without running the title itself. Unlike
+ * CiTrace, which records the register writes of the 3DS GPU, they hold the command lists submitted
+ * to the GPU and the guest memory those read.
+ */
+namespace GPUTrace {
+
+// NOTE: Things are stored in little-endian. A trace is a Header followed by a stream of records,
+// each made of a RecordHeader and its payload, until the end of the file.
+
+#pragma pack(1)
+
+struct Header {
+    static const char* ExpectedMagicWord() {
+        return "YzGt";
+    }
+
+    static u32 ExpectedVersion() {
+        return 1;
+    }
+
+    char magic[4];
+    u32 version;
+    /// Program id of the recorded title
+    u64 program_id;
+};
+
+enum class RecordType : u32 {
+    /// Tegra::GPU::EngineState, see EncodeEngineState
+    EngineState = 0,
+    /// Array of MappedRange, replacing every GPU memory mapping
+    MemoryMap = 1,
+    /// u64 CPU address followed by the bytes stored from it on
+    MemoryUpdate = 2,
+    /// CommandList
+    CommandList = 3,
+    /// Flip, ending a frame
+    Flip = 4,
+};
+
+struct RecordHeader {
+    RecordType type;
+    /// Size of the payload following the header
+    u64 size;
+};
+
+struct MappedRange {
+    u64 gpu_addr;
+    u64 cpu_addr;
+    u64 size;
+};
+
+struct CommandList {
+    u64 gpu_addr;
+    /// Size in words
+    u32 size;
+};
+
+struct Flip {
+    u64 address;
+    u32 offset;
+    u64 gpu_address;
+    u32 width;
+    u32 height;
+    u32 stride;
+    u32 pixel_format;
+    u32 transform_flags;
+    s32 crop_left;
+    s32 crop_top;
+    s32 crop_right;
+    s32 crop_bottom;
+};
+
+#pragma pack()
+
+/// Serializes an engine state into the payload of an EngineState record
+std::vector<u8> EncodeEngineState(const Tegra::GPU::EngineState& engine_state);
+
+/// Deserializes the payload of an EngineState record, returns none if it's malformed
+boost::optional<Tegra::GPU::EngineState> DecodeEngineState(const std::vector<u8>& data);
+
+Flip EncodeFlip(const Tegra::FramebufferConfig& framebuffer);
+
+Tegra::FramebufferConfig DecodeFlip(const Flip& flip);
+
+/// Reads the records of a trace file one after the other
+class Reader {
+public:
+    struct Record {
+        RecordType type;
+        std::vector<u8> data;
+    };
+
+    explicit Reader(const std::string& filename);
+
+    /// Returns whether the file could be opened and has the expected magic word and version
+    bool IsValid() const;
+
+    const Header& GetHeader() const;
+
+    /// Reads the next record, returns false at the end of the trace or if it's truncated
+    bool ReadRecord(Record& record);
+
+private:
+    FileUtil::IOFile file;
+    Header header{};
+    bool valid = false;
+};
+
+} // namespace GPUTrace
@@ -2,18 +2,20 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
 #include <atomic>
-#include <list>
 #include <mutex>
+#include <unordered_map>
 #include <utility>
+#include <vector>
 #include "input_common/keyboard.h"
 
 namespace InputCommon {
 
 class KeyButton final : public Input::ButtonDevice {
 public:
-    explicit KeyButton(std::shared_ptr<KeyButtonList> key_button_list_)
-        : key_button_list(std::move(key_button_list_)) {}
+    KeyButton(std::shared_ptr<KeyButtonList> key_button_list_, int key_code)
+        : key_button_list(std::move(key_button_list_)), key_code(key_code) {}
 
     ~KeyButton() override;
 
@@ -25,56 +27,62 @@ public:
 
 private:
     std::shared_ptr<KeyButtonList> key_button_list;
+    const int key_code;
     std::atomic<bool> status{false};
 };
 
-struct KeyButtonPair {
-    int key_code;
-    KeyButton* key_button;
-};
-
 class KeyButtonList {
 public:
     void AddKeyButton(int key_code, KeyButton* key_button) {
         std::lock_guard<std::mutex> guard(mutex);
-        list.push_back(KeyButtonPair{key_code, key_button});
+        buttons_by_key[key_code].push_back(key_button);
     }
 
-    void RemoveKeyButton(const KeyButton* key_button) {
+    void RemoveKeyButton(int key_code, const KeyButton* key_button) {
         std::lock_guard<std::mutex> guard(mutex);
-        list.remove_if(
-            [key_button](const KeyButtonPair& pair) { return pair.key_button == key_button; });
+        const auto iter = buttons_by_key.find(key_code);
+        if (iter == buttons_by_key.end())
+            return;
+        auto& buttons = iter->second;
+        buttons.erase(std::remove(buttons.begin(), buttons.end(), key_button), buttons.end());
+        if (buttons.empty())
+            buttons_by_key.erase(iter);
     }
 
     void ChangeKeyStatus(int key_code, bool pressed) {
         std::lock_guard<std::mutex> guard(mutex);
-        for (const KeyButtonPair& pair : list) {
-            if (pair.key_code == key_code)
-                pair.key_button->status.store(pressed);
+        const auto iter = buttons_by_key.find(key_code);
+        if (iter == buttons_by_key.end())
+            return;
+        for (KeyButton* key_button : iter->second) {
+            key_button->status.store(pressed);
         }
     }
 
     void ChangeAllKeyStatus(bool pressed) {
         std::lock_guard<std::mutex> guard(mutex);
-        for (const KeyButtonPair& pair : list) {
-            pair.key_button->status.store(pressed);
+        for (const auto& entry : buttons_by_key) {
+            for (KeyButton* key_button : entry.second) {
+                key_button->status.store(pressed);
+            }
         }
     }
 
 private:
     std::mutex mutex;
-    std::list<KeyButtonPair> list;
+    /// Buttons bound to each key code. Frontend key codes are sparse, so they're hashed.
+    std::unordered_map<int, std::vector<KeyButton*>> buttons_by_key;
 };
 
 Keyboard::Keyboard() : key_button_list{std::make_shared<KeyButtonList>()} {}
 
 KeyButton::~KeyButton() {
-    key_button_list->RemoveKeyButton(this);
+    key_button_list->RemoveKeyButton(key_code, this);
 }
 
 std::unique_ptr<Input::ButtonDevice> Keyboard::Create(const Common::ParamPackage& params) {
     int key_code = params.Get("code", 0);
-    std::unique_ptr<KeyButton> button = std::make_unique<KeyButton>(key_button_list);
+    std::unique_ptr<KeyButton> button = std::make_unique<KeyButton>(key_button_list, key_code);
     key_button_list->AddKeyButton(key_code, button.get());
     return std::move(button);
 }
@@ -3,10 +3,13 @@
 // Refer to the license.txt file included.
 
 #include <algorithm>
+#include <array>
+#include <atomic>
 #include <chrono>
 #include <mutex>
 #include <thread>
 #include <tuple>
+#include "common/common_types.h"
 #include "common/math_util.h"
 #include "common/quaternion.h"
 #include "common/thread.h"
@@ -56,9 +59,22 @@ public:
         is_tilting = false;
     }
 
-    std::tuple<Math::Vec3<float>, Math::Vec3<float>> GetStatus() {
-        std::lock_guard<std::mutex> guard(status_mutex);
-        return status;
+    std::tuple<Math::Vec3<float>, Math::Vec3<float>> GetStatus() const {
+        std::array<float, 6> values;
+        u32 sequence_before;
+        u32 sequence_after;
+        do {
+            sequence_before = status_sequence.load(std::memory_order_acquire);
+            for (std::size_t i = 0; i < values.size(); ++i) {
+                values[i] = status[i].load(std::memory_order_relaxed);
+            }
+            std::atomic_thread_fence(std::memory_order_acquire);
+            sequence_after = status_sequence.load(std::memory_order_relaxed);
+            // Retry if the motion thread was updating the status meanwhile
+        } while (sequence_before != sequence_after || (sequence_before & 1) != 0);
+
+        return std::make_tuple(Math::MakeVec(values[0], values[1], values[2]),
+                               Math::MakeVec(values[3], values[4], values[5]));
     }
 
 private:
@@ -76,8 +92,13 @@ private:
 
     Common::Event shutdown_event;
 
-    std::tuple<Math::Vec3<float>, Math::Vec3<float>> status;
-    std::mutex status_mutex;
+    /**
+     * Gravity followed by angular rate, published through a sequence lock so that polling never
+     * waits for the motion thread. Only the motion thread writes them, the sequence is odd while
+     * it is doing so.
+     */
+    std::array<std::atomic<float>, 6> status{};
+    std::atomic<u32> status_sequence{0};
 
     // Note: always keep the thread declaration at the end so that other objects are initialized
     // before this!
@@ -114,10 +135,15 @@ private:
             angular_rate = QuaternionRotate(inv_q, angular_rate);
 
             // Update the sensor state
-            {
-                std::lock_guard<std::mutex> guard(status_mutex);
-                status = std::make_tuple(gravity, angular_rate);
+            const u32 sequence = status_sequence.load(std::memory_order_relaxed);
+            status_sequence.store(sequence + 1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+            const std::array<float, 6> values{gravity.x,      gravity.y,      gravity.z,
+                                              angular_rate.x, angular_rate.y, angular_rate.z};
+            for (std::size_t i = 0; i < values.size(); ++i) {
+                status[i].store(values[i], std::memory_order_relaxed);
             }
+            status_sequence.store(sequence + 2, std::memory_order_release);
         }
     }
 };
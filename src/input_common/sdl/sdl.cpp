@@ -2,15 +2,22 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <cmath>
+#include <mutex>
 #include <string>
+#include <thread>
 #include <tuple>
 #include <unordered_map>
 #include <utility>
+#include <vector>
 #include <SDL.h>
 #include "common/logging/log.h"
 #include "common/math_util.h"
 #include "common/param_package.h"
+#include "common/thread.h"
 #include "input_common/main.h"
 #include "input_common/sdl/sdl.h"
 
@@ -22,32 +29,63 @@ class SDLJoystick;
 class SDLButtonFactory;
 class SDLAnalogFactory;
 static std::unordered_map<int, std::weak_ptr<SDLJoystick>> joystick_list;
+/// Guards joystick_list, and opening joysticks against the poll thread updating them
+static std::mutex joystick_list_mutex;
 static std::shared_ptr<SDLButtonFactory> button_factory;
 static std::shared_ptr<SDLAnalogFactory> analog_factory;
 
 static bool initialized = false;
 
+/// How often the poll thread updates the state of the joysticks
+constexpr std::chrono::milliseconds POLL_INTERVAL{5};
+static std::thread poll_thread;
+static Common::Event poll_thread_stop;
+
+/**
+ * An opened SDL joystick. The poll thread copies the state of all of its inputs after every
+ * SDL_JoystickUpdate, so that querying them is a plain load instead of an update of every SDL
+ * joystick per input.
+ */
 class SDLJoystick {
 public:
     explicit SDLJoystick(int joystick_index)
-        : joystick{SDL_JoystickOpen(joystick_index), SDL_JoystickClose} {
+        : joystick{SDL_JoystickOpen(joystick_index), SDL_JoystickClose},
+          buttons(std::max(SDL_JoystickNumButtons(joystick.get()), 0)),
+          axes(std::max(SDL_JoystickNumAxes(joystick.get()), 0)),
+          hats(std::max(SDL_JoystickNumHats(joystick.get()), 0)) {
         if (!joystick) {
             LOG_ERROR(Input, "failed to open joystick {}", joystick_index);
+            return;
+        }
+        UpdateState();
+    }
+
+    /// Copies the state SDL last read from the joystick, called after SDL_JoystickUpdate.
+    void UpdateState() {
+        for (std::size_t i = 0; i < buttons.size(); ++i) {
+            const bool pressed = SDL_JoystickGetButton(joystick.get(), static_cast<int>(i)) == 1;
+            buttons[i].store(pressed, std::memory_order_relaxed);
+        }
+        for (std::size_t i = 0; i < axes.size(); ++i) {
+            const Sint16 value = SDL_JoystickGetAxis(joystick.get(), static_cast<int>(i));
+            axes[i].store(value, std::memory_order_relaxed);
+        }
+        for (std::size_t i = 0; i < hats.size(); ++i) {
+            const Uint8 value = SDL_JoystickGetHat(joystick.get(), static_cast<int>(i));
+            hats[i].store(value, std::memory_order_relaxed);
         }
     }
 
     bool GetButton(int button) const {
-        if (!joystick)
+        if (button < 0 || static_cast<std::size_t>(button) >= buttons.size())
             return {};
-        SDL_JoystickUpdate();
-        return SDL_JoystickGetButton(joystick.get(), button) == 1;
+        return buttons[button].load(std::memory_order_relaxed);
     }
 
     float GetAxis(int axis) const {
-        if (!joystick)
+        if (axis < 0 || static_cast<std::size_t>(axis) >= axes.size())
             return {};
-        SDL_JoystickUpdate();
-        return SDL_JoystickGetAxis(joystick.get(), axis) / 32767.0f;
+        return axes[axis].load(std::memory_order_relaxed) / 32767.0f;
     }
 
     std::tuple<float, float> GetAnalog(int axis_x, int axis_y) const {
@@ -68,7 +106,9 @@ public:
     }
 
     bool GetHatDirection(int hat, Uint8 direction) const {
-        return (SDL_JoystickGetHat(joystick.get(), hat) & direction) != 0;
+        if (hat < 0 || static_cast<std::size_t>(hat) >= hats.size())
+            return {};
+        return (hats[hat].load(std::memory_order_relaxed) & direction) != 0;
     }
 
     SDL_JoystickID GetJoystickID() const {
@@ -77,6 +117,9 @@ public:
 
 private:
     std::unique_ptr<SDL_Joystick, decltype(&SDL_JoystickClose)> joystick;
+    std::vector<std::atomic<bool>> buttons;
+    std::vector<std::atomic<Sint16>> axes;
+    std::vector<std::atomic<Uint8>> hats;
 };
 
 class SDLButton final : public Input::ButtonDevice {
@@ -145,6 +188,7 @@ private:
 };
 
 static std::shared_ptr<SDLJoystick> GetJoystick(int joystick_index) {
+    std::lock_guard<std::mutex> lock(joystick_list_mutex);
     std::shared_ptr<SDLJoystick> joystick = joystick_list[joystick_index].lock();
     if (!joystick) {
         joystick = std::make_shared<SDLJoystick>(joystick_index);
@@ -233,6 +277,21 @@ public:
     }
 };
 
+/// Updates every open joystick once per POLL_INTERVAL, until Shutdown
+static void PollLoop() {
+    Common::SetCurrentThreadName("SDLJoystickPoll");
+
+    while (!poll_thread_stop.WaitUntil(std::chrono::steady_clock::now() + POLL_INTERVAL)) {
+        std::lock_guard<std::mutex> lock(joystick_list_mutex);
+        SDL_JoystickUpdate();
+        for (const auto& entry : joystick_list) {
+            if (const auto joystick = entry.second.lock()) {
+                joystick->UpdateState();
+            }
+        }
+    }
+}
+
 void Init() {
     if (SDL_Init(SDL_INIT_JOYSTICK) < 0) {
         LOG_CRITICAL(Input, "SDL_Init(SDL_INIT_JOYSTICK) failed with: {}", SDL_GetError());
@@ -240,6 +299,8 @@ void Init() {
         using namespace Input;
         RegisterFactory<ButtonDevice>("sdl", std::make_shared<SDLButtonFactory>());
         RegisterFactory<AnalogDevice>("sdl", std::make_shared<SDLAnalogFactory>());
+        poll_thread_stop.Reset();
+        poll_thread = std::thread(PollLoop);
         initialized = true;
     }
 }
@@ -249,7 +310,10 @@ void Shutdown() {
         using namespace Input;
         UnregisterFactory<ButtonDevice>("sdl");
         UnregisterFactory<AnalogDevice>("sdl");
+        poll_thread_stop.Set();
+        poll_thread.join();
         SDL_QuitSubSystem(SDL_INIT_JOYSTICK);
+        initialized = false;
     }
 }
 
@@ -0,0 +1,78 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <catch2/catch.hpp>
+
+#include <cmath>
+#include <random>
+#include <vector>
+#include "audio_core/algorithm/filter.h"
+
+namespace AudioCore {
+
+constexpr size_t FRAME_COUNT = 1000;
+
+static std::vector<float> MakeRandomSignal(size_t frame_count, size_t num_channels, u32 seed) {
+    // Quiet enough that the s16 path never clamps, and whole numbers so both paths see the same
+    // input
+    std::mt19937 rng(seed);
+    std::uniform_int_distribution<int> distribution(-8000, 8000);
+    std::vector<float> signal(frame_count * num_channels);
+    for (auto& sample : signal) {
+        sample = static_cast<float>(distribution(rng));
+    }
+    return signal;
+}
+
+/**
+ * Filters the interleaved float signal with the float path, and every channel of it on its own
+ * with the scalar s16 path, over two calls to also check the history carried between them. The
+ * s16 path truncates every stage's output, which bounds the difference.
+ */
+template <typename FilterType>
+static void CheckMatchesScalar(const FilterType& filter, size_t num_channels, float tolerance) {
+    const auto signal = MakeRandomSignal(FRAME_COUNT, num_channels, static_cast<u32>(num_channels));
+
+    auto float_filter = filter;
+    auto float_signal = signal;
+    const size_t first_frames = FRAME_COUNT / 3;
+    float_filter.Process(float_signal.data(), first_frames, num_channels);
+    float_filter.Process(float_signal.data() + first_frames * num_channels,
+                         FRAME_COUNT - first_frames, num_channels);
+
+    for (size_t ch = 0; ch < num_channels; ch++) {
+        auto scalar_filter = filter;
+        std::vector<s16> first(first_frames * 2);
+        std::vector<s16> second((FRAME_COUNT - first_frames) * 2);
+        for (size_t i = 0; i < FRAME_COUNT; i++) {
+            auto& target = i < first_frames ? first : second;
+            const size_t frame = i < first_frames ? i : i - first_frames;
+            target[frame * 2] = static_cast<s16>(signal[i * num_channels + ch]);
+        }
+        scalar_filter.Process(first);
+        scalar_filter.Process(second);
+
+        for (size_t i = 0; i < FRAME_COUNT; i++) {
+            const s16 expected = i < first_frames ? first[i * 2] : second[(i - first_frames) * 2];
+            REQUIRE(std::abs(float_signal[i * num_channels + ch] - expected) <= tolerance);
+        }
+    }
+}
+
+TEST_CASE("Filter::Process float matches s16", "[audio_core]") {
+    const auto filter = Filter::LowPass(0.2, 0.7071);
+    // Covers every lane count of the vector path, and more than one group of lanes
+    for (size_t num_channels = 1; num_channels <= Filter::max_channel_count; num_channels++) {
+        CheckMatchesScalar(filter, num_channels, 1.5f);
+    }
+}
+
+TEST_CASE("CascadingFilter::Process float matches s16", "[audio_core]") {
+    const auto filter = CascadingFilter::LowPass(0.3, 3);
+    for (const size_t num_channels : {2, 6}) {
+        CheckMatchesScalar(filter, num_channels, 8.0f);
+    }
+}
+
+} // namespace AudioCore
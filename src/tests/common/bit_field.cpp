@@ -0,0 +1,89 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <chrono>
+#include <random>
+#include <vector>
+#include <catch2/catch.hpp>
+#include "common/bit_field.h"
+#include "common/swap.h"
+
+namespace Common {
+
+/// Same layout as a few of the fields of a shader instruction
+union TestInstruction {
+    constexpr TestInstruction(u64 value) : value{value} {}
+
+    u64 value;
+    BitField<0, 8, u64> gpr0;
+    BitField<8, 8, u64> gpr8;
+    BitField<16, 3, u64> pred_index;
+    BitField<19, 1, u64> negate_pred;
+    BitField<20, 19, u64> imm20_19;
+    BitField<20, 32, s64> imm20_32;
+    BitField<48, 16, u64> opcode;
+    BitField<56, 8, s64> top;
+};
+
+// Fields can be decoded at compile time
+static_assert(decltype(TestInstruction::opcode)::ExtractValue(0xDEADBEEFCAFEF00D) == 0xDEAD);
+static_assert(decltype(TestInstruction::imm20_32)::ExtractValue(0xFFFFFFFFFFF00000) == -1);
+static_assert(decltype(TestInstruction::imm20_32)::FormatValue(-1) == 0x000FFFFFFFF00000);
+static_assert(swap32(0x12345678) == 0x78563412);
+
+TEST_CASE("BitField: Extraction", "[common]") {
+    const TestInstruction instr{0x80123456789ABCDE};
+    REQUIRE(instr.gpr0 == 0xDE);
+    REQUIRE(instr.gpr8 == 0xBC);
+    REQUIRE(instr.pred_index == 2);
+    REQUIRE(instr.negate_pred == 1);
+    REQUIRE(instr.imm20_19 == 0x56789);
+    REQUIRE(instr.opcode == 0x8012);
+
+    // Signed fields are sign extended
+    REQUIRE(instr.imm20_32 == 0x23456789);
+    REQUIRE(instr.top == -128);
+    REQUIRE(TestInstruction{0x0008000000000000}.imm20_32 == -0x80000000LL);
+}
+
+TEST_CASE("BitField: Assignment", "[common]") {
+    TestInstruction instr{0};
+    instr.imm20_32.Assign(-2);
+    REQUIRE(instr.value == 0x000FFFFFFFE00000);
+    REQUIRE(instr.imm20_32 == -2);
+
+    // Assigning a field leaves the others untouched, and values too wide are truncated
+    instr.gpr0.Assign(0x1FF);
+    REQUIRE(instr.gpr0 == 0xFF);
+    REQUIRE(instr.imm20_32 == -2);
+    instr.top.Assign(-1);
+    REQUIRE(instr.value == 0xFF0FFFFFFFE000FF);
+}
+
+// Hidden, run with "[.benchmark]" to measure field decoding as done by the shader decompiler
+TEST_CASE("BitField: Decode benchmark", "[.benchmark]") {
+    std::mt19937_64 random;
+    std::vector<u64> code(1 << 16);
+    for (u64& instr : code) {
+        instr = random();
+    }
+
+    constexpr int num_passes = 256;
+    u64 sum = 0;
+    const auto start = std::chrono::steady_clock::now();
+    for (int pass = 0; pass < num_passes; pass++) {
+        for (const u64 value : code) {
+            const TestInstruction instr{value};
+            sum += instr.gpr0 + instr.gpr8 + instr.pred_index + instr.negate_pred +
+                   instr.imm20_19 + instr.imm20_32 + instr.opcode + instr.top;
+        }
+    }
+    const auto time = std::chrono::steady_clock::now() - start;
+
+    using Nanoseconds = std::chrono::duration<double, std::nano>;
+    const double field_time = Nanoseconds(time).count() / (8.0 * num_passes * code.size());
+    WARN(field_time << " ns per field (checksum " << sum << ")");
+}
+
+} // namespace Common
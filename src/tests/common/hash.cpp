@@ -0,0 +1,54 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <cstring>
+#include <numeric>
+#include <vector>
+#include <catch2/catch.hpp>
+#include "common/hash.h"
+
+namespace Common {
+
+TEST_CASE("Hash: XXHash64 reference values", "[common]") {
+    REQUIRE(ComputeXXHash64("", 0) == 0xEF46DB3751D8E999ULL);
+    REQUIRE(ComputeXXHash64("abc", 3) == 0x44BC2CF5AD770999ULL);
+}
+
+TEST_CASE("Hash: CRC32C reference values", "[common]") {
+    REQUIRE(ComputeCRC32C("", 0) == 0);
+    REQUIRE(ComputeCRC32C("123456789", 9) == 0xE3069283);
+
+    // Checksums can be continued over following blocks
+    REQUIRE(ComputeCRC32C("6789", 4, ComputeCRC32C("12345", 5)) == 0xE3069283);
+}
+
+TEST_CASE("Hash: XXHash64 streaming", "[common]") {
+    std::vector<u8> data(1000);
+    std::iota(data.begin(), data.end(), static_cast<u8>(0));
+    const u64 expected = ComputeXXHash64(data.data(), data.size(), 42);
+
+    // Splitting the input anywhere, in and across stripes, gives the same hash
+    for (size_t split : {0, 1, 7, 31, 32, 33, 100, 999, 1000}) {
+        XXHash64 hash(42);
+        hash.Update(data.data(), split);
+        hash.Update(data.data() + split, data.size() - split);
+        REQUIRE(hash.Digest() == expected);
+    }
+}
+
+TEST_CASE("Hash: HashableStruct hasher", "[common]") {
+    struct Key {
+        u32 a;
+        u64 b;
+    };
+    HashableStruct<Key> city;
+    HashableStruct<Key, XXHasher> xx;
+    city.state.a = xx.state.a = 1;
+    city.state.b = xx.state.b = 2;
+
+    REQUIRE(city.Hash() == ComputeHash64(&city.state, sizeof(Key)));
+    REQUIRE(xx.Hash() == ComputeXXHash64(&xx.state, sizeof(Key)));
+}
+
+} // namespace Common
@@ -0,0 +1,86 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <array>
+#include <numeric>
+#include <thread>
+#include <vector>
+#include <catch2/catch.hpp>
+#include "common/ring_buffer.h"
+
+namespace Common {
+
+TEST_CASE("RingBuffer: Basic Tests", "[common]") {
+    RingBuffer<char, 4, 1> buf;
+
+    // Pushing values into a ring buffer with space should succeed
+    for (std::size_t i = 0; i < 4; i++) {
+        const char elem = static_cast<char>(i);
+        REQUIRE(buf.Push(&elem, 1) == 1);
+    }
+    REQUIRE(buf.Size() == 4);
+
+    // A full ring buffer accepts nothing
+    const char extra = 42;
+    REQUIRE(buf.Push(&extra, 1) == 0);
+
+    std::array<char, 3> out{};
+    REQUIRE(buf.Pop(out.data(), out.size()) == 3);
+    REQUIRE(out == std::array<char, 3>{0, 1, 2});
+    REQUIRE(buf.Size() == 1);
+
+    // Pushes wrap around the end of the storage
+    const std::array<char, 3> more{4, 5, 6};
+    REQUIRE(buf.Push(more.data(), more.size()) == 3);
+
+    std::array<char, 8> rest{};
+    REQUIRE(buf.Pop(rest.data(), rest.size()) == 4);
+    REQUIRE(rest[0] == 3);
+    REQUIRE(rest[1] == 4);
+    REQUIRE(rest[2] == 5);
+    REQUIRE(rest[3] == 6);
+    REQUIRE(buf.Size() == 0);
+}
+
+TEST_CASE("RingBuffer: Granularity", "[common]") {
+    RingBuffer<s16, 4, 2> buf;
+
+    // Sizes are counted in slots of two elements
+    const std::array<s16, 6> frames{1, 2, 3, 4, 5, 6};
+    REQUIRE(buf.Push(frames.data(), 3) == 3);
+    REQUIRE(buf.Push(frames.data(), 3) == 1);
+    REQUIRE(buf.Size() == 4);
+
+    std::array<s16, 8> out{};
+    REQUIRE(buf.Pop(out.data(), 4) == 4);
+    REQUIRE(out == std::array<s16, 8>{1, 2, 3, 4, 5, 6, 1, 2});
+}
+
+TEST_CASE("RingBuffer: Threaded Test", "[common]") {
+    RingBuffer<u32, 1024, 1> buf;
+    constexpr u32 count = 1000000;
+
+    std::thread producer{[&] {
+        u32 next = 0;
+        while (next < count) {
+            next += static_cast<u32>(buf.Push(&next, 1));
+        }
+    }};
+
+    u32 expected = 0;
+    bool in_order = true;
+    while (expected < count) {
+        u32 value;
+        if (buf.Pop(&value, 1) == 1) {
+            in_order &= value == expected;
+            ++expected;
+        }
+    }
+    producer.join();
+
+    REQUIRE(in_order);
+    REQUIRE(buf.Size() == 0);
+}
+
+} // namespace Common
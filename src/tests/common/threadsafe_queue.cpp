@@ -0,0 +1,190 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include <catch2/catch.hpp>
+#include "common/threadsafe_queue.h"
+
+namespace Common {
+
+TEST_CASE("SPSCRing: Basic Tests", "[common]") {
+    SPSCRing<int, 4> ring;
+    REQUIRE(ring.Empty());
+
+    for (int i = 0; i < 4; i++) {
+        REQUIRE(ring.TryPush(i));
+    }
+    REQUIRE(ring.Size() == 4);
+
+    // A full ring accepts nothing
+    REQUIRE(!ring.TryPush(42));
+
+    int value;
+    REQUIRE(ring.Pop(value));
+    REQUIRE(value == 0);
+
+    // Pushes wrap around the end of the storage
+    REQUIRE(ring.TryPush(4));
+    for (int i = 1; i <= 4; i++) {
+        REQUIRE(ring.Pop(value));
+        REQUIRE(value == i);
+    }
+    REQUIRE(!ring.Pop(value));
+    REQUIRE(ring.Empty());
+}
+
+TEST_CASE("MPMCRing: Basic Tests", "[common]") {
+    MPMCRing<int, 4> ring;
+    REQUIRE(ring.Empty());
+
+    for (int i = 0; i < 4; i++) {
+        REQUIRE(ring.TryPush(i));
+    }
+    REQUIRE(!ring.TryPush(42));
+
+    // Every slot can be reused on the following laps
+    int value;
+    for (int i = 0; i < 16; i++) {
+        REQUIRE(ring.Pop(value));
+        REQUIRE(value == i);
+        REQUIRE(ring.TryPush(i + 4));
+    }
+    REQUIRE(ring.Size() == 4);
+}
+
+TEST_CASE("MPMCRing: Threaded Test", "[common]") {
+    MPMCRing<u32, 256> ring;
+    constexpr u32 num_producers = 4;
+    constexpr u32 num_consumers = 2;
+    constexpr u32 count = 100000;
+
+    // Every producer pushes its values in order, tagged with its index in the top bits
+    std::vector<std::thread> producers;
+    for (u32 producer = 0; producer < num_producers; producer++) {
+        producers.emplace_back([&ring, producer] {
+            for (u32 i = 0; i < count; i++) {
+                while (!ring.TryPush(producer << 24 | i)) {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+
+    std::atomic<u32> popped{0};
+    std::vector<std::vector<u32>> received(num_consumers);
+    std::vector<std::thread> consumers;
+    for (u32 consumer = 0; consumer < num_consumers; consumer++) {
+        consumers.emplace_back([&, consumer] {
+            u32 value;
+            while (popped.load() < num_producers * count) {
+                if (ring.Pop(value)) {
+                    received[consumer].push_back(value);
+                    ++popped;
+                }
+            }
+        });
+    }
+
+    for (auto& thread : producers) {
+        thread.join();
+    }
+    for (auto& thread : consumers) {
+        thread.join();
+    }
+
+    // Each consumer sees the values of one producer in the order they were pushed, and every value
+    // is received exactly once
+    std::vector<u32> num_received(num_producers);
+    for (const auto& values : received) {
+        std::vector<s64> last(num_producers, -1);
+        for (const u32 value : values) {
+            const u32 producer = value >> 24;
+            const s64 index = value & 0xFFFFFF;
+            REQUIRE(index > last[producer]);
+            last[producer] = index;
+            ++num_received[producer];
+        }
+    }
+    for (const u32 num : num_received) {
+        REQUIRE(num == count);
+    }
+    REQUIRE(ring.Empty());
+}
+
+/// Returns the time it takes to pass count values through a queue, either from another thread or
+/// in batches on the calling thread, which leaves out the cost of the threads waiting on each other
+template <typename Push, typename Pop>
+static std::chrono::nanoseconds TimeTransfer(u32 count, bool threaded, Push push, Pop pop) {
+    const auto start = std::chrono::steady_clock::now();
+    u32 value;
+    if (threaded) {
+        std::thread producer{[&] {
+            for (u32 i = 0; i < count; i++) {
+                while (!push(i)) {
+                    std::this_thread::yield();
+                }
+            }
+        }};
+        for (u32 received = 0; received < count;) {
+            if (pop(value)) {
+                ++received;
+            } else {
+                std::this_thread::yield();
+            }
+        }
+        producer.join();
+    } else {
+        constexpr u32 batch_size = 512;
+        for (u32 i = 0; i < count; i += batch_size) {
+            for (u32 j = 0; j < batch_size; j++) {
+                push(i + j);
+            }
+            for (u32 j = 0; j < batch_size; j++) {
+                pop(value);
+            }
+        }
+    }
+    return std::chrono::steady_clock::now() - start;
+}
+
+template <typename Push, typename Pop>
+static void ReportTransfer(const char* name, Push push, Pop pop) {
+    constexpr u32 count = 1 << 23;
+    const auto batched = TimeTransfer(count, false, push, pop);
+    const auto threaded = TimeTransfer(count, true, push, pop);
+    WARN(name << ": " << batched.count() / count << " ns per element on one thread, "
+              << threaded.count() / count << " ns between two threads");
+}
+
+// Hidden, run with "[.benchmark]" to compare the rings against the node based queues
+TEST_CASE("Threadsafe queues: Benchmark", "[.benchmark]") {
+    SPSCQueue<u32, false> spsc_queue;
+    ReportTransfer("SPSCQueue",
+                   [&](u32 value) {
+                       spsc_queue.Push(value);
+                       return true;
+                   },
+                   [&](u32& value) { return spsc_queue.Pop(value); });
+
+    SPSCRing<u32, 1024> spsc_ring;
+    ReportTransfer("SPSCRing", [&](u32 value) { return spsc_ring.TryPush(value); },
+                   [&](u32& value) { return spsc_ring.Pop(value); });
+
+    MPSCQueue<u32, false> mpsc_queue;
+    ReportTransfer("MPSCQueue",
+                   [&](u32 value) {
+                       mpsc_queue.Push(value);
+                       return true;
+                   },
+                   [&](u32& value) { return mpsc_queue.Pop(value); });
+
+    MPSCRing<u32, 1024> mpsc_ring;
+    ReportTransfer("MPSCRing", [&](u32 value) { return mpsc_ring.TryPush(value); },
+                   [&](u32& value) { return mpsc_ring.Pop(value); });
+}
+
+} // namespace Common
@@ -7,6 +7,7 @@
 #include <array>
 #include <bitset>
 #include <string>
+#include <thread>
 #include "common/file_util.h"
 #include "core/core.h"
 #include "core/core_timing.h"
@@ -124,6 +125,40 @@ TEST_CASE("CoreTiming[Threadsave]", "[core]") {
     AdvanceAndCheck(4, MAX_SLICE_LENGTH);
 }
 
+TEST_CASE("CoreTiming[ReplayThreadsafeArrivals]", "[core]") {
+    ScopeInit guard;
+
+    CoreTiming::EventType* cb_a = CoreTiming::RegisterEvent("callbackA", CallbackTemplate<0>);
+
+    // Enter slice 0
+    CoreTiming::Advance();
+
+    CoreTiming::StartRecordingThreadsafeEvents();
+    CoreTiming::ScheduleEventThreadsafe(1000, cb_a, CB_IDS[0]);
+    CoreTiming::AddTicks(100);
+    CoreTiming::Advance();
+    const auto arrivals = CoreTiming::StopRecordingThreadsafeEvents();
+    REQUIRE(1 == arrivals.size());
+    REQUIRE(100 == arrivals[0].ticks);
+    REQUIRE(1000 == arrivals[0].time);
+    REQUIRE(CB_IDS[0] == arrivals[0].userdata);
+    REQUIRE("callbackA" == arrivals[0].type_name);
+    AdvanceAndCheck(0, MAX_SLICE_LENGTH);
+
+    // The live event is held back until the recorded arrival, 300 ticks after it was scheduled
+    const u64 now = CoreTiming::GetTicks();
+    CoreTiming::ReplayThreadsafeEvents(
+        {{now + 300, static_cast<s64>(now) + 1000, CB_IDS[0], "callbackA"}});
+    CoreTiming::ScheduleEventThreadsafe(1000, cb_a, CB_IDS[0]);
+    CoreTiming::AddTicks(100);
+    CoreTiming::Advance();
+    REQUIRE(MAX_SLICE_LENGTH == CoreTiming::GetDowncount());
+    CoreTiming::AddTicks(200);
+    CoreTiming::Advance();
+    REQUIRE(700 == CoreTiming::GetDowncount());
+    AdvanceAndCheck(0, MAX_SLICE_LENGTH);
+}
+
 namespace SharedSlotTest {
 static unsigned int counter = 0;
 
@@ -235,3 +270,144 @@ TEST_CASE("CoreTiming[ChainScheduling]", "[core]") {
     REQUIRE(0 == reschedules);
     REQUIRE(MAX_SLICE_LENGTH == CoreTiming::GetDowncount());
 }
+
+namespace ManyEventsTest {
+static u64 max_userdata_seen = 0;
+static unsigned int callbacks_fired = 0;
+
+static void CountingCallback(u64 userdata, s64 cycles_late) {
+    // Only the odd events are left scheduled, and they must fire in the order they were scheduled
+    REQUIRE(userdata % 2 == 1);
+    REQUIRE(userdata > max_userdata_seen);
+    max_userdata_seen = userdata;
+    ++callbacks_fired;
+}
+} // namespace ManyEventsTest
+
+TEST_CASE("CoreTiming[UnscheduleManyEvents]", "[core]") {
+    using namespace ManyEventsTest;
+
+    ScopeInit guard;
+
+    CoreTiming::EventType* cb = CoreTiming::RegisterEvent("callbackCounting", CountingCallback);
+
+    // Enter slice 0
+    CoreTiming::Advance();
+
+    // Schedule thousands of pending events, then cancel every even one, as thread wakeup timers
+    // being cancelled by signalled waits would.
+    constexpr u64 num_events = 10000;
+    for (u64 i = 1; i <= num_events; ++i) {
+        CoreTiming::ScheduleEvent(static_cast<s64>(i), cb, i);
+    }
+    for (u64 i = 2; i <= num_events; i += 2) {
+        CoreTiming::UnscheduleEvent(cb, i);
+    }
+
+    max_userdata_seen = 0;
+    callbacks_fired = 0;
+    while (callbacks_fired < num_events / 2) {
+        CoreTiming::AddTicks(CoreTiming::GetDowncount());
+        CoreTiming::Advance();
+    }
+
+    REQUIRE(max_userdata_seen == num_events - 1);
+    REQUIRE(MAX_SLICE_LENGTH == CoreTiming::GetDowncount());
+}
+
+TEST_CASE("CoreTiming[PerCoreContexts]", "[core]") {
+    ScopeInit guard;
+
+    CoreTiming::EventType* cb_a = CoreTiming::RegisterEvent("callbackA", CallbackTemplate<0>);
+
+    CoreTiming::ScheduleEvent(1000, cb_a, CB_IDS[0]);
+
+    // Enter slice 0
+    CoreTiming::Advance();
+    REQUIRE(1000 == CoreTiming::GetDowncount(0));
+    REQUIRE(1000 == CoreTiming::GetDowncount(1));
+
+    // Cores count their executed cycles independently of each other
+    CoreTiming::AddTicks(0, 300);
+    CoreTiming::AddTicks(1, 700);
+    REQUIRE(700 == CoreTiming::GetDowncount(0));
+    REQUIRE(300 == CoreTiming::GetDowncount(1));
+    REQUIRE(300 == CoreTiming::GetTicks(0));
+    REQUIRE(700 == CoreTiming::GetTicks(1));
+
+    // An idle core skips to the end of the slice without affecting the others
+    CoreTiming::Idle(2);
+    REQUIRE(0 == CoreTiming::GetDowncount(2));
+    REQUIRE(700 == CoreTiming::GetDowncount(0));
+
+    // Time moves forward by the slice, which the idle core fully covered
+    callbacks_ran_flags = 0;
+    expected_callback = CB_IDS[0];
+    lateness = 0;
+    CoreTiming::Advance();
+    REQUIRE(callbacks_ran_flags.test(0));
+    REQUIRE(1000 == CoreTiming::GetTicks(0));
+    REQUIRE(MAX_SLICE_LENGTH == CoreTiming::GetDowncount(1));
+}
+
+TEST_CASE("CoreTiming[IdleStopsAtEarliestEvent]", "[core]") {
+    ScopeInit guard;
+
+    CoreTiming::EventType* cb_a = CoreTiming::RegisterEvent("callbackA", CallbackTemplate<0>);
+    CoreTiming::EventType* cb_b = CoreTiming::RegisterEvent("callbackB", CallbackTemplate<1>);
+
+    CoreTiming::ScheduleEvent(1000, cb_a, CB_IDS[0]);
+
+    // Enter slice 0
+    CoreTiming::Advance();
+
+    // A secondary core idles before the main core schedules an earlier event
+    CoreTiming::Idle(1);
+    REQUIRE(0 == CoreTiming::GetDowncount(1));
+    CoreTiming::AddTicks(0, 100);
+    CoreTiming::ScheduleEvent(200, cb_b, CB_IDS[1]);
+    REQUIRE(200 == CoreTiming::GetDowncount(0));
+
+    // The idle core only covers the slice up to that event, so it doesn't fire late
+    callbacks_ran_flags = 0;
+    expected_callback = CB_IDS[1];
+    lateness = 0;
+    CoreTiming::Advance();
+    REQUIRE(callbacks_ran_flags.test(1));
+    REQUIRE(!callbacks_ran_flags.test(0));
+    REQUIRE(300 == CoreTiming::GetTicks(0));
+    REQUIRE(700 == CoreTiming::GetDowncount(1));
+}
+
+TEST_CASE("CoreTiming[PerSystemState]", "[core]") {
+    ScopeInit guard;
+
+    CoreTiming::EventType* cb_a = CoreTiming::RegisterEvent("callbackA", CallbackTemplate<0>);
+    CoreTiming::ScheduleEvent(1000, cb_a, CB_IDS[0]);
+    CoreTiming::Advance();
+
+    // A second system has its own clock, events and event types
+    const auto other_system = Core::System::Create();
+    u64 other_ticks = 0;
+    int other_downcount = 0;
+    std::thread other_thread([&] {
+        other_system->MakeCurrent();
+        ScopeInit other_guard;
+
+        CoreTiming::EventType* other_cb_a =
+            CoreTiming::RegisterEvent("callbackA", CallbackTemplate<1>);
+        CoreTiming::ScheduleEvent(500, other_cb_a, CB_IDS[1]);
+        CoreTiming::Advance();
+        CoreTiming::AddTicks(200);
+        other_ticks = CoreTiming::GetTicks();
+        other_downcount = CoreTiming::GetDowncount();
+    });
+    other_thread.join();
+
+    REQUIRE(200 == other_ticks);
+    REQUIRE(300 == other_downcount);
+    REQUIRE(0 == CoreTiming::GetTicks());
+    REQUIRE(1000 == CoreTiming::GetDowncount());
+
+    AdvanceAndCheck(0, MAX_SLICE_LENGTH);
+}
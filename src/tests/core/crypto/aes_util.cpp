@@ -0,0 +1,267 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <catch2/catch.hpp>
+
+#include <algorithm>
+#include <array>
+#include <random>
+#include <string>
+#include <vector>
+#include "core/crypto/aes_ni.h"
+#include "core/crypto/aes_util.h"
+#include "core/crypto/key_manager.h"
+
+namespace Core::Crypto {
+
+static std::vector<u8> FromHex(const std::string& hex) {
+    std::vector<u8> out(hex.size() / 2);
+    for (size_t i = 0; i < out.size(); ++i) {
+        out[i] = static_cast<u8>(std::stoul(hex.substr(i * 2, 2), nullptr, 16));
+    }
+    return out;
+}
+
+template <typename Key>
+static Key KeyFromHex(const std::string& hex) {
+    const auto bytes = FromHex(hex);
+    Key key{};
+    std::copy(bytes.begin(), bytes.end(), key.begin());
+    return key;
+}
+
+static std::vector<u8> MakeRandomData(size_t size, u32 seed) {
+    std::vector<u8> data(size);
+    std::mt19937 rng(seed);
+    std::generate(data.begin(), data.end(), [&rng] { return static_cast<u8>(rng()); });
+    return data;
+}
+
+/// Runs func once on the mbedtls path and, if the host supports it, once on the AES-NI path
+template <typename Func>
+static void ForEachBackend(Func func) {
+    AESNI::SetEnabled(false);
+    func();
+    AESNI::SetEnabled(true);
+    if (AESNI::IsSupported()) {
+        func();
+    }
+}
+
+/// Transcodes data with a cipher made on the mbedtls path and with one made on the AES-NI path
+template <typename Key, typename Func>
+static void CheckBackendsMatch(const Key& key, Mode mode, Func transcode) {
+    if (!AESNI::IsSupported()) {
+        WARN("AES-NI is not supported on this host, only the mbedtls path was tested");
+        return;
+    }
+
+    AESNI::SetEnabled(false);
+    const AESCipher<Key> mbedtls_cipher(key, mode);
+    AESNI::SetEnabled(true);
+    const AESCipher<Key> aesni_cipher(key, mode);
+
+    REQUIRE(transcode(aesni_cipher) == transcode(mbedtls_cipher));
+}
+
+// NIST SP 800-38A, F.1
+constexpr char NIST_KEY[] = "2b7e151628aed2a6abf7158809cf4f3c";
+constexpr char NIST_PLAINTEXT[] = "6bc1bee22e409f96e93d7e117393172a"
+                                  "ae2d8a571e03ac9c9eb76fac45af8e51"
+                                  "30c81c46a35ce411e5fbc1191a0a52ef"
+                                  "f69f2445df4f9b17ad2b417be66c3710";
+
+TEST_CASE("AESCipher::ECB known answer", "[core][crypto]") {
+    const auto plaintext = FromHex(NIST_PLAINTEXT);
+    const auto ciphertext = FromHex("3ad77bb40d7a3660a89ecaf32466ef97"
+                                    "f5d3d58503b9699de785895a96fdbaaf"
+                                    "43b1cd7f598ece23881b00e3ed030688"
+                                    "7b0c785e27e8ad3f8223207104725dd4");
+
+    ForEachBackend([&] {
+        const AESCipher<Key128> cipher(KeyFromHex<Key128>(NIST_KEY), Mode::ECB);
+        std::vector<u8> out(plaintext.size());
+        cipher.Transcode(plaintext.data(), plaintext.size(), out.data(), Op::Encrypt);
+        REQUIRE(out == ciphertext);
+        cipher.Transcode(ciphertext.data(), ciphertext.size(), out.data(), Op::Decrypt);
+        REQUIRE(out == plaintext);
+    });
+}
+
+TEST_CASE("AESCipher::CTR known answer", "[core][crypto]") {
+    // NIST SP 800-38A, F.5.1
+    const auto plaintext = FromHex(NIST_PLAINTEXT);
+    const auto counter = FromHex("f0f1f2f3f4f5f6f7f8f9fafbfcfdfeff");
+    const auto ciphertext = FromHex("874d6191b620e3261bef6864990db6ce"
+                                    "9806f66b7970fdff8617187bb9fffdff"
+                                    "5ae4df3edbd5d35e5b4f09020db03eab"
+                                    "1e031dda2fbe03d1792170a0f3009cee");
+
+    const auto key = KeyFromHex<Key128>(NIST_KEY);
+
+    SECTION("whole blocks") {
+        ForEachBackend([&] {
+            AESCipher<Key128> cipher(key, Mode::CTR);
+            cipher.SetIV(counter);
+            std::vector<u8> out(plaintext.size());
+            cipher.Transcode(plaintext.data(), plaintext.size(), out.data(), Op::Encrypt);
+            REQUIRE(out == ciphertext);
+        });
+    }
+
+    SECTION("partial final block") {
+        // The last block only uses the start of its keystream
+        constexpr size_t size = 3 * 16 + 5;
+        ForEachBackend([&] {
+            AESCipher<Key128> cipher(key, Mode::CTR);
+            cipher.SetIV(counter);
+            std::vector<u8> out(size);
+            cipher.Transcode(plaintext.data(), size, out.data(), Op::Encrypt);
+            REQUIRE(std::equal(out.begin(), out.end(), ciphertext.begin()));
+        });
+    }
+
+    SECTION("split across calls") {
+        // Each call carries on from the counter the last one left
+        ForEachBackend([&] {
+            AESCipher<Key128> cipher(key, Mode::CTR);
+            cipher.SetIV(counter);
+            std::vector<u8> out(plaintext.size());
+            cipher.Transcode(plaintext.data(), 16, out.data(), Op::Encrypt);
+            cipher.Transcode(plaintext.data() + 16, plaintext.size() - 16, out.data() + 16,
+                             Op::Encrypt);
+            REQUIRE(out == ciphertext);
+        });
+    }
+
+    SECTION("explicit IV") {
+        std::array<u8, 16> iv;
+        std::copy(counter.begin(), counter.end(), iv.begin());
+        ForEachBackend([&] {
+            const AESCipher<Key128> cipher(key, Mode::CTR);
+            std::vector<u8> out(plaintext.size());
+            cipher.TranscodeWithIV(ciphertext.data(), ciphertext.size(), out.data(), Op::Decrypt,
+                                   iv);
+            REQUIRE(out == plaintext);
+        });
+    }
+}
+
+TEST_CASE("AESCipher::CTR counter carry", "[core][crypto]") {
+    // The counter is a single 128-bit big-endian number, so its low half must carry into the high
+    // half. The keystream is rebuilt from ECB, whose known answer is tested above.
+    const auto key = KeyFromHex<Key128>(NIST_KEY);
+    constexpr size_t block_count = 5;
+    const auto plaintext = MakeRandomData(block_count * 16 + 7, 1);
+
+    std::vector<u8> counters(block_count * 16 + 16);
+    for (size_t block = 0; block < counters.size() / 16; ++block) {
+        // Starts at 0x0000000000000000FFFFFFFFFFFFFFFD
+        const u64 low = 0xFFFFFFFFFFFFFFFD + block;
+        const u64 high = low < block ? 1 : 0;
+        for (size_t i = 0; i < 8; ++i) {
+            counters[block * 16 + i] = static_cast<u8>(high >> (56 - i * 8));
+            counters[block * 16 + 8 + i] = static_cast<u8>(low >> (56 - i * 8));
+        }
+    }
+
+    ForEachBackend([&] {
+        const AESCipher<Key128> ecb(key, Mode::ECB);
+        std::vector<u8> expected(counters.size());
+        ecb.Transcode(counters.data(), counters.size(), expected.data(), Op::Encrypt);
+        expected.resize(plaintext.size());
+        for (size_t i = 0; i < plaintext.size(); ++i) {
+            expected[i] ^= plaintext[i];
+        }
+
+        AESCipher<Key128> ctr(key, Mode::CTR);
+        ctr.SetIV(counters.data(), 16);
+        std::vector<u8> out(plaintext.size());
+        ctr.Transcode(plaintext.data(), plaintext.size(), out.data(), Op::Encrypt);
+        REQUIRE(out == expected);
+    });
+}
+
+TEST_CASE("AESCipher::XTS known answer", "[core][crypto]") {
+    SECTION("IEEE 1619 vector 1") {
+        // Data unit 0, whose tweak is the same whichever way the sector number is encoded
+        const auto plaintext = std::vector<u8>(32);
+        const auto ciphertext = FromHex("917cf69ebd68b2ec9b9fe9a3eadda692"
+                                        "cd43d2f59598ed858c02c2652fbf922e");
+
+        ForEachBackend([&] {
+            const AESCipher<Key256> cipher(Key256{}, Mode::XTS);
+            std::vector<u8> out(plaintext.size());
+            cipher.XTSTranscode(plaintext.data(), plaintext.size(), out.data(), 0,
+                                plaintext.size(), Op::Encrypt);
+            REQUIRE(out == ciphertext);
+            cipher.XTSTranscode(ciphertext.data(), ciphertext.size(), out.data(), 0,
+                                ciphertext.size(), Op::Decrypt);
+            REQUIRE(out == plaintext);
+        });
+    }
+
+    SECTION("IEEE 1619 vector 2") {
+        // Data unit 0x3333333333, given as the little-endian tweak IEEE 1619 uses
+        const auto key = KeyFromHex<Key256>("11111111111111111111111111111111"
+                                            "22222222222222222222222222222222");
+        const auto tweak = FromHex("33333333330000000000000000000000");
+        const auto plaintext = std::vector<u8>(32, 0x44);
+        const auto ciphertext = FromHex("c454185e6a16936e39334038acef838b"
+                                        "fb186fff7480adc4289382ecd6d394f0");
+
+        ForEachBackend([&] {
+            AESCipher<Key256> cipher(key, Mode::XTS);
+            cipher.SetIV(tweak);
+            std::vector<u8> out(plaintext.size());
+            cipher.Transcode(plaintext.data(), plaintext.size(), out.data(), Op::Encrypt);
+            REQUIRE(out == ciphertext);
+        });
+    }
+}
+
+TEST_CASE("AESCipher::AES-NI matches mbedtls", "[core][crypto]") {
+    const auto key128 = KeyFromHex<Key128>(NIST_KEY);
+    const auto key256 = KeyFromHex<Key256>("000102030405060708090a0b0c0d0e0f"
+                                           "f0f1f2f3f4f5f6f7f8f9fafbfcfdfeff");
+    // Large enough to be split across the thread pool, with a partial block at the end
+    const auto data = MakeRandomData(0x100000 + 0x30 + 5, 2);
+    const size_t whole_blocks = data.size() & ~size_t{0xF};
+
+    SECTION("ECB") {
+        for (const auto op : {Op::Encrypt, Op::Decrypt}) {
+            CheckBackendsMatch(key128, Mode::ECB, [&](const AESCipher<Key128>& cipher) {
+                std::vector<u8> out(whole_blocks);
+                cipher.Transcode(data.data(), whole_blocks, out.data(), op);
+                return out;
+            });
+        }
+    }
+
+    SECTION("CTR") {
+        const auto iv = FromHex("00000000000000fffffffffffffffff0");
+        CheckBackendsMatch(key128, Mode::CTR, [&](const AESCipher<Key128>& cipher) {
+            std::array<u8, 16> counter;
+            std::copy(iv.begin(), iv.end(), counter.begin());
+            std::vector<u8> out(data.size());
+            cipher.TranscodeWithIV(data.data(), data.size(), out.data(), Op::Encrypt, counter);
+            return out;
+        });
+    }
+
+    SECTION("XTS") {
+        constexpr size_t sector_size = 0x200;
+        const size_t size = data.size() / sector_size * sector_size;
+        for (const auto op : {Op::Encrypt, Op::Decrypt}) {
+            // A sector number above 0xFF checks the byte order of the Nintendo tweak
+            CheckBackendsMatch(key256, Mode::XTS, [&](const AESCipher<Key256>& cipher) {
+                std::vector<u8> out(size);
+                cipher.XTSTranscode(data.data(), size, out.data(), 0x1234, sector_size, op);
+                return out;
+            });
+        }
+    }
+}
+
+} // namespace Core::Crypto
@@ -0,0 +1,100 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <catch2/catch.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <random>
+#include <thread>
+#include <vector>
+#include "core/crypto/ctr_encryption_layer.h"
+#include "core/crypto/xts_encryption_layer.h"
+#include "core/file_sys/vfs_offset.h"
+#include "core/file_sys/vfs_vector.h"
+
+namespace Core::Crypto {
+
+constexpr size_t TEST_FILE_SIZE = 0x400000;
+constexpr size_t NUM_THREADS = 8;
+constexpr size_t READS_PER_THREAD = 200;
+
+static FileSys::VirtualFile MakeRandomFile(u32 seed) {
+    std::vector<u8> data(TEST_FILE_SIZE);
+    std::mt19937 rng(seed);
+    std::generate(data.begin(), data.end(), [&rng] { return static_cast<u8>(rng()); });
+    return std::make_shared<FileSys::VectorVfsFile>(std::move(data));
+}
+
+/**
+ * Reads random ranges of file from several threads at once, mixing sector aligned and unaligned
+ * offsets and sizes up to over the parallel transcode threshold, and checks them against the same
+ * ranges of expected. Returns the number of reads that did not match.
+ */
+static size_t HammerReads(const FileSys::VirtualFile& file, const std::vector<u8>& expected) {
+    std::atomic<size_t> mismatches{0};
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < NUM_THREADS; ++t) {
+        threads.emplace_back([&, t] {
+            std::mt19937 rng(static_cast<u32>(t));
+            std::vector<u8> buffer;
+            for (size_t i = 0; i < READS_PER_THREAD; ++i) {
+                const size_t max_length = i % 16 == 0 ? 0x180000 : 0x8000;
+                size_t offset = rng() % expected.size();
+                size_t length = rng() % max_length + 1;
+                if (i % 2 == 0) {
+                    offset &= ~size_t{0x3FFF};
+                    length = (length + 0x3FFF) & ~size_t{0x3FFF};
+                }
+                length = std::min(length, expected.size() - offset);
+
+                buffer.assign(length, 0);
+                const size_t read = file->Read(buffer.data(), length, offset);
+                if (read != length ||
+                    !std::equal(buffer.begin(), buffer.end(), expected.begin() + offset)) {
+                    ++mismatches;
+                }
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    return mismatches;
+}
+
+TEST_CASE("CTREncryptionLayer: Concurrent reads", "[core][crypto]") {
+    const auto base = MakeRandomFile(1);
+    const Key128 key{0x10, 0x32, 0x54, 0x76, 0x98, 0xBA, 0xDC, 0xFE,
+                     0xEF, 0xCD, 0xAB, 0x89, 0x67, 0x45, 0x23, 0x01};
+    const std::vector<u8> iv{0xA0, 0xA1, 0xA2, 0xA3, 0xA4, 0xA5, 0xA6, 0xA7};
+
+    // As NCA sections are, a layer over part of the file that starts its counter at base_offset
+    const auto make_layer = [&] {
+        auto layer = std::make_shared<CTREncryptionLayer>(
+            std::make_shared<FileSys::OffsetVfsFile>(base, TEST_FILE_SIZE - 0x4000, 0x4000), key,
+            0x4000);
+        layer->SetIV(iv);
+        return layer;
+    };
+
+    const auto expected = make_layer()->ReadAllBytes();
+    REQUIRE(expected.size() == TEST_FILE_SIZE - 0x4000);
+    REQUIRE(HammerReads(make_layer(), expected) == 0);
+}
+
+TEST_CASE("XTSEncryptionLayer: Concurrent reads", "[core][crypto]") {
+    const auto base = MakeRandomFile(2);
+    Key256 key{};
+    for (size_t i = 0; i < key.size(); ++i) {
+        key[i] = static_cast<u8>(i * 7 + 3);
+    }
+
+    const auto expected = XTSEncryptionLayer(base, key).ReadAllBytes();
+    REQUIRE(expected.size() == TEST_FILE_SIZE);
+    REQUIRE(HammerReads(std::make_shared<XTSEncryptionLayer>(base, key), expected) == 0);
+}
+
+} // namespace Core::Crypto
@@ -0,0 +1,39 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <catch2/catch.hpp>
+
+#include <string>
+#include <vector>
+#include "core/perf_stats.h"
+
+namespace Core {
+
+TEST_CASE("LowFrameRate averages the slowest frames", "[core]") {
+    std::vector<double> frame_lengths(99, 1.0 / 60.0);
+    frame_lengths.push_back(0.1);
+
+    REQUIRE(LowFrameRate({}, 0.01) == 0.0);
+    REQUIRE(LowFrameRate(frame_lengths, 0.01) == Approx(10.0));
+    // Two frames make up 1% of 200, so the slowest is averaged with a regular one
+    frame_lengths.insert(frame_lengths.end(), 100, 1.0 / 60.0);
+    REQUIRE(LowFrameRate(frame_lengths, 0.01) == Approx(2.0 / (0.1 + 1.0 / 60.0)));
+    // At least one frame is always taken into account
+    REQUIRE(LowFrameRate(frame_lengths, 0.001) == Approx(10.0));
+}
+
+TEST_CASE("FramesToCsv writes one line per frame in milliseconds", "[core]") {
+    std::vector<PerfStats::FrameSample> frames(2);
+    frames[1].length = 0.02;
+    frames[1].emulation_time = 0.01;
+    frames[1].gpu_time = 0.005;
+    frames[1].present_time = 0.001;
+    frames[1].limiter_time = 0.004;
+
+    REQUIRE(FramesToCsv(frames) == "frame,length_ms,emulation_ms,gpu_ms,present_ms,limiter_ms\n"
+                                   "0,0.000,0.000,0.000,0.000,0.000\n"
+                                   "1,20.000,10.000,5.000,1.000,4.000\n");
+}
+
+} // namespace Core
@@ -0,0 +1,84 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <catch2/catch.hpp>
+
+#include <unordered_map>
+#include <vector>
+#include "tests/video_core/recording_rasterizer.h"
+#include "video_core/engines/maxwell_3d.h"
+#include "video_core/macro_hle.h"
+#include "video_core/macro_interpreter.h"
+#include "video_core/memory_manager.h"
+
+namespace Tegra {
+
+constexpr u32 MACRO_METHOD = 0xE00;
+
+/// Calls the macro uploaded at MACRO_METHOD the way the command processor does
+static void CallMacro(Engines::Maxwell3D& maxwell3d, const std::vector<u32>& parameters) {
+    for (size_t i = 0; i < parameters.size(); ++i) {
+        const u32 method = MACRO_METHOD + (i == 0 ? 0 : 1);
+        maxwell3d.WriteReg(method, parameters[i], static_cast<u32>(parameters.size() - i - 1));
+    }
+}
+
+static void CheckMatchesInterpreter(const std::vector<std::vector<u32>>& calls) {
+    MemoryManager memory_manager;
+
+    RecordingRasterizer hle_rasterizer;
+    Engines::Maxwell3D hle_maxwell3d(hle_rasterizer, memory_manager);
+    hle_maxwell3d.SetUploadedMacros({{MACRO_METHOD, bind_constant_buffer_macro}});
+
+    RecordingRasterizer interpreter_rasterizer;
+    Engines::Maxwell3D interpreter_maxwell3d(interpreter_rasterizer, memory_manager);
+    MacroInterpreter interpreter(interpreter_maxwell3d);
+
+    for (auto parameters : calls) {
+        CallMacro(hle_maxwell3d, parameters);
+        interpreter.Execute(bind_constant_buffer_macro, parameters);
+    }
+
+    // Every call writes the three const buffer registers and a CB_BIND register
+    REQUIRE(interpreter_rasterizer.changed_registers.size() == calls.size() * 4);
+    REQUIRE(hle_maxwell3d.regs.reg_array == interpreter_maxwell3d.regs.reg_array);
+    REQUIRE(hle_rasterizer.changed_registers == interpreter_rasterizer.changed_registers);
+
+    for (size_t stage = 0; stage < Engines::Maxwell3D::Regs::MaxShaderStage; ++stage) {
+        const auto& hle_buffers = hle_maxwell3d.state.shader_stages[stage].const_buffers;
+        const auto& interpreter_buffers =
+            interpreter_maxwell3d.state.shader_stages[stage].const_buffers;
+        for (size_t i = 0; i < hle_buffers.size(); ++i) {
+            REQUIRE(hle_buffers[i].address == interpreter_buffers[i].address);
+            REQUIRE(hle_buffers[i].index == interpreter_buffers[i].index);
+            REQUIRE(hle_buffers[i].size == interpreter_buffers[i].size);
+            REQUIRE(hle_buffers[i].enabled == interpreter_buffers[i].enabled);
+        }
+    }
+}
+
+TEST_CASE("HLE macros are found by the hash of their code", "[video_core]") {
+    REQUIRE(GetHLEMacro(GetMacroHash(bind_constant_buffer_macro)) != nullptr);
+
+    auto other_code = bind_constant_buffer_macro;
+    other_code.back() ^= 1;
+    REQUIRE(GetHLEMacro(GetMacroHash(other_code)) == nullptr);
+}
+
+TEST_CASE("HLE bind constant buffer macro matches the interpreter", "[video_core]") {
+    SECTION("single bind") {
+        CheckMatchesInterpreter({{4, 0x100, 0x1, 0x20000, (3 << 4) | 1}});
+    }
+
+    SECTION("several stages") {
+        CheckMatchesInterpreter({
+            {0, 0x10000, 0x0, 0x80000, (0 << 4) | 1},
+            {1, 0x400, 0x2, 0x40000, (17 << 4) | 1},
+            {4, 0x200, 0x3, 0xC0000, (5 << 4) | 1},
+            {0, 0x10000, 0x0, 0x80000, (0 << 4) | 0},
+        });
+    }
+}
+
+} // namespace Tegra
@@ -0,0 +1,306 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <catch2/catch.hpp>
+
+#include <random>
+#include <vector>
+#include "tests/video_core/recording_rasterizer.h"
+#include "video_core/engines/maxwell_3d.h"
+#include "video_core/macro_hle.h"
+#include "video_core/macro_interpreter.h"
+#include "video_core/macro_jit_x64.h"
+#include "video_core/memory_manager.h"
+
+namespace Tegra {
+
+using Opcode = MacroInterpreter::Opcode;
+using Operation = MacroInterpreter::Operation;
+using ALUOperation = MacroInterpreter::ALUOperation;
+using ResultOperation = MacroInterpreter::ResultOperation;
+using BranchCondition = MacroInterpreter::BranchCondition;
+
+/// Render target registers, which have no side effects when written
+constexpr u32 SCRATCH_METHOD = 0x200;
+/// Method address increment of one register per Send
+constexpr u32 INCREMENT = 1 << 12;
+
+static u32 ALU(ALUOperation operation, ResultOperation result, u32 dst, u32 src_a, u32 src_b) {
+    Opcode opcode{};
+    opcode.operation.Assign(Operation::ALU);
+    opcode.alu_operation.Assign(operation);
+    opcode.result_operation.Assign(result);
+    opcode.dst.Assign(dst);
+    opcode.src_a.Assign(src_a);
+    opcode.src_b.Assign(src_b);
+    return opcode.raw;
+}
+
+static u32 AddImmediate(ResultOperation result, u32 dst, u32 src_a, s32 immediate) {
+    Opcode opcode{};
+    opcode.operation.Assign(Operation::AddImmediate);
+    opcode.result_operation.Assign(result);
+    opcode.dst.Assign(dst);
+    opcode.src_a.Assign(src_a);
+    opcode.immediate.Assign(immediate);
+    return opcode.raw;
+}
+
+static u32 Bitfield(Operation operation, ResultOperation result, u32 dst, u32 src_a, u32 src_b,
+                    u32 src_bit, u32 size, u32 dst_bit) {
+    Opcode opcode{};
+    opcode.operation.Assign(operation);
+    opcode.result_operation.Assign(result);
+    opcode.dst.Assign(dst);
+    opcode.src_a.Assign(src_a);
+    opcode.src_b.Assign(src_b);
+    opcode.bf_src_bit.Assign(src_bit);
+    opcode.bf_size.Assign(size);
+    opcode.bf_dst_bit.Assign(dst_bit);
+    return opcode.raw;
+}
+
+static u32 Read(ResultOperation result, u32 dst, u32 src_a, s32 immediate) {
+    Opcode opcode{AddImmediate(result, dst, src_a, immediate)};
+    opcode.operation.Assign(Operation::Read);
+    return opcode.raw;
+}
+
+static u32 Branch(BranchCondition condition, bool annul, u32 src_a, s32 offset) {
+    Opcode opcode{};
+    opcode.operation.Assign(Operation::Branch);
+    opcode.branch_condition.Assign(condition);
+    opcode.branch_annul.Assign(annul ? 1 : 0);
+    opcode.src_a.Assign(src_a);
+    opcode.immediate.Assign(offset);
+    return opcode.raw;
+}
+
+static u32 Exit(u32 raw) {
+    Opcode opcode{raw};
+    opcode.is_exit.Assign(1);
+    return opcode.raw;
+}
+
+static u32 Nop() {
+    return AddImmediate(ResultOperation::Move, 0, 0, 0);
+}
+
+/// Sets the method address to the scratch registers
+static u32 SetScratchMethod(u32 offset = 0) {
+    return AddImmediate(ResultOperation::MoveAndSetMethod, 0, 0,
+                        static_cast<s32>((SCRATCH_METHOD + offset) | INCREMENT));
+}
+
+/// Runs a macro on the JIT and on the interpreter, each on its own engine, and checks both ended
+/// up in the same state.
+static void CheckMatchesInterpreter(const std::vector<u32>& code,
+                                    const std::vector<std::vector<u32>>& calls) {
+    MemoryManager memory_manager;
+
+    RecordingRasterizer jit_rasterizer;
+    Engines::Maxwell3D jit_maxwell3d(jit_rasterizer, memory_manager);
+    const MacroJITx64 jit(jit_maxwell3d, code);
+    REQUIRE(jit.IsCompiled());
+
+    RecordingRasterizer interpreter_rasterizer;
+    Engines::Maxwell3D interpreter_maxwell3d(interpreter_rasterizer, memory_manager);
+    MacroInterpreter interpreter(interpreter_maxwell3d);
+
+    for (auto parameters : calls) {
+        jit.Execute(parameters);
+        interpreter.Execute(code, parameters);
+    }
+
+    REQUIRE(!interpreter_rasterizer.changed_registers.empty());
+    REQUIRE(jit_rasterizer.changed_registers == interpreter_rasterizer.changed_registers);
+    REQUIRE(jit_maxwell3d.regs.reg_array == interpreter_maxwell3d.regs.reg_array);
+
+    for (size_t stage = 0; stage < Engines::Maxwell3D::Regs::MaxShaderStage; ++stage) {
+        const auto& jit_buffers = jit_maxwell3d.state.shader_stages[stage].const_buffers;
+        const auto& interpreter_buffers =
+            interpreter_maxwell3d.state.shader_stages[stage].const_buffers;
+        for (size_t i = 0; i < jit_buffers.size(); ++i) {
+            REQUIRE(jit_buffers[i].address == interpreter_buffers[i].address);
+            REQUIRE(jit_buffers[i].index == interpreter_buffers[i].index);
+            REQUIRE(jit_buffers[i].size == interpreter_buffers[i].size);
+            REQUIRE(jit_buffers[i].enabled == interpreter_buffers[i].enabled);
+        }
+    }
+}
+
+TEST_CASE("MacroJITx64 matches the interpreter on branches", "[video_core]") {
+    // Sums the parameters after the first one, which is their count
+    const auto make_loop = [](bool annul) {
+        return std::vector<u32>{
+            SetScratchMethod(),
+            AddImmediate(ResultOperation::IgnoreAndFetch, 2, 0, 0),
+            ALU(ALUOperation::Add, ResultOperation::Move, 3, 3, 2),
+            AddImmediate(ResultOperation::Move, 1, 1, -1),
+            Branch(BranchCondition::NotZero, annul, 1, -3),
+            // Delay slot, which sends the running sum
+            AddImmediate(ResultOperation::MoveAndSend, 0, 3, 0),
+            Exit(AddImmediate(ResultOperation::MoveAndSend, 0, 1, 0)),
+            Nop(),
+        };
+    };
+
+    SECTION("delay slot") {
+        CheckMatchesInterpreter(make_loop(false), {{4, 10, 20, 30, 40}, {1, 5}});
+    }
+
+    SECTION("annulled delay slot") {
+        CheckMatchesInterpreter(make_loop(true), {{4, 10, 20, 30, 40}, {1, 5}});
+    }
+
+    SECTION("forward branch") {
+        const std::vector<u32> code{
+            SetScratchMethod(),
+            Branch(BranchCondition::Zero, true, 1, 3),
+            AddImmediate(ResultOperation::MoveAndSend, 0, 1, 100),
+            AddImmediate(ResultOperation::MoveAndSend, 0, 1, 200),
+            Exit(AddImmediate(ResultOperation::MoveAndSend, 0, 1, 7)),
+            // Exit delay slot
+            AddImmediate(ResultOperation::MoveAndSend, 0, 1, 8),
+        };
+        CheckMatchesInterpreter(code, {{0}, {5}, {0}});
+    }
+}
+
+TEST_CASE("MacroJITx64 matches the interpreter on every operation", "[video_core]") {
+    const std::vector<u32> code{
+        SetScratchMethod(),
+        AddImmediate(ResultOperation::IgnoreAndFetch, 2, 0, 0),
+        AddImmediate(ResultOperation::IgnoreAndFetch, 3, 0, 0),
+        ALU(ALUOperation::Add, ResultOperation::MoveAndSend, 0, 1, 2),
+        ALU(ALUOperation::Subtract, ResultOperation::MoveAndSend, 0, 2, 1),
+        ALU(ALUOperation::Xor, ResultOperation::MoveAndSend, 0, 1, 2),
+        ALU(ALUOperation::Or, ResultOperation::MoveAndSend, 0, 1, 2),
+        ALU(ALUOperation::And, ResultOperation::MoveAndSend, 0, 1, 2),
+        ALU(ALUOperation::AndNot, ResultOperation::MoveAndSend, 0, 1, 2),
+        ALU(ALUOperation::Nand, ResultOperation::MoveAndSend, 0, 1, 2),
+        // Writes to the zero register are dropped
+        ALU(ALUOperation::Add, ResultOperation::Move, 0, 1, 2),
+        AddImmediate(ResultOperation::MoveAndSend, 0, 0, -5),
+        Bitfield(Operation::ExtractInsert, ResultOperation::MoveAndSend, 0, 1, 2, 4, 8, 12),
+        Bitfield(Operation::ExtractShiftLeftImmediate, ResultOperation::MoveAndSend, 0, 3, 2, 0,
+                 5, 7),
+        Bitfield(Operation::ExtractShiftLeftRegister, ResultOperation::MoveAndSend, 0, 3, 2, 3, 6,
+                 0),
+        Read(ResultOperation::Move, 4, 0, SCRATCH_METHOD),
+        AddImmediate(ResultOperation::MoveAndSend, 0, 4, 1),
+        // Sends bits 12:17 of the method address, which are also its increment
+        AddImmediate(ResultOperation::MoveAndSetMethodSend, 5, 0,
+                     (SCRATCH_METHOD + 0x40) | (0x2A << 12)),
+        AddImmediate(ResultOperation::MoveAndSend, 0, 5, 0),
+        AddImmediate(ResultOperation::FetchAndSetMethod, 6, 0, (SCRATCH_METHOD + 0x50) | INCREMENT),
+        AddImmediate(ResultOperation::MoveAndSend, 0, 6, 0),
+        AddImmediate(ResultOperation::MoveAndSetMethodFetchAndSend, 0, 0,
+                     (SCRATCH_METHOD + 0x60) | INCREMENT),
+        AddImmediate(ResultOperation::FetchAndSend, 7, 6, 1),
+        Exit(AddImmediate(ResultOperation::MoveAndSend, 0, 7, 0)),
+        Nop(),
+    };
+    CheckMatchesInterpreter(code, {{0xDEADBEEF, 0x12345678, 9, 0x1111, 0x2222, 0x3333},
+                                   {0x7, 0xFFFFFFF0, 31, 0, 1, 2}});
+}
+
+TEST_CASE("MacroJITx64 matches the interpreter on the bind constant buffer macro",
+          "[video_core]") {
+    CheckMatchesInterpreter(bind_constant_buffer_macro, {
+                                                            {4, 0x100, 0x1, 0x20000, (3 << 4) | 1},
+                                                            {1, 0x400, 0x2, 0x40000, (17 << 4) | 1},
+                                                        });
+}
+
+TEST_CASE("MacroJITx64 matches the interpreter on random programs", "[video_core]") {
+    constexpr std::array<ALUOperation, 7> alu_operations{
+        ALUOperation::Add, ALUOperation::Subtract, ALUOperation::Xor,  ALUOperation::Or,
+        ALUOperation::And, ALUOperation::AndNot,   ALUOperation::Nand,
+    };
+
+    std::mt19937 rng(1234);
+    const auto random = [&rng](u32 max) { return static_cast<u32>(rng() % (max + 1)); };
+
+    for (size_t program = 0; program < 50; ++program) {
+        std::vector<u32> code;
+        std::vector<u32> parameters{static_cast<u32>(rng())};
+        for (size_t i = 0; i < 40; ++i) {
+            const bool fetch = random(3) == 0;
+            const auto result = fetch ? ResultOperation::IgnoreAndFetch : ResultOperation::Move;
+            if (fetch) {
+                parameters.push_back(static_cast<u32>(rng()));
+            }
+            const u32 dst = random(7);
+            const u32 src_a = random(7);
+            const u32 src_b = random(7);
+            switch (random(3)) {
+            case 0:
+                code.push_back(ALU(alu_operations[random(6)], result, dst, src_a, src_b));
+                break;
+            case 1:
+                code.push_back(AddImmediate(result, dst, src_a,
+                                            static_cast<s32>(random(0x3FFFF)) - 0x20000));
+                break;
+            case 2:
+                code.push_back(Bitfield(Operation::ExtractInsert, result, dst, src_a, src_b,
+                                        random(31), random(30), random(31)));
+                break;
+            default:
+                // Shift amounts from registers are kept at zero, the interpreter's C++ shifts are
+                // undefined past 31
+                code.push_back(Bitfield(random(1) ? Operation::ExtractShiftLeftImmediate
+                                                  : Operation::ExtractShiftLeftRegister,
+                                        result, dst, 0, src_b, random(31), random(30),
+                                        random(31)));
+                break;
+            }
+        }
+
+        // Make the registers observable
+        code.push_back(SetScratchMethod());
+        for (u32 reg = 1; reg < MacroInterpreter::NumMacroRegisters; ++reg) {
+            code.push_back(AddImmediate(ResultOperation::MoveAndSend, 0, reg, 0));
+        }
+        code.back() = Exit(code.back());
+        code.push_back(Nop());
+
+        CheckMatchesInterpreter(code, {parameters});
+    }
+}
+
+TEST_CASE("MacroJITx64 leaves unsupported programs to the interpreter", "[video_core]") {
+    MemoryManager memory_manager;
+    RecordingRasterizer rasterizer;
+    Engines::Maxwell3D maxwell3d(rasterizer, memory_manager);
+
+    SECTION("carry operation") {
+        const std::vector<u32> code{
+            Exit(ALU(ALUOperation::AddWithCarry, ResultOperation::Move, 1, 1, 1)),
+            Nop(),
+        };
+        REQUIRE(!MacroJITx64(maxwell3d, code).IsCompiled());
+    }
+
+    SECTION("branch in a delay slot") {
+        const std::vector<u32> code{
+            Branch(BranchCondition::Zero, false, 1, 2),
+            Branch(BranchCondition::Zero, false, 1, 1),
+            Exit(Nop()),
+            Nop(),
+        };
+        REQUIRE(!MacroJITx64(maxwell3d, code).IsCompiled());
+    }
+
+    SECTION("branch out of the program") {
+        const std::vector<u32> code{
+            Branch(BranchCondition::Zero, true, 1, 5),
+            Exit(Nop()),
+            Nop(),
+        };
+        REQUIRE(!MacroJITx64(maxwell3d, code).IsCompiled());
+    }
+}
+
+} // namespace Tegra
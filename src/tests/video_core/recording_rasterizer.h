@@ -0,0 +1,31 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <vector>
+#include "common/common_types.h"
+#include "video_core/rasterizer_interface.h"
+
+namespace Tegra {
+
+/// Rasterizer that only records the registers the engine reports as changed, in order
+class RecordingRasterizer final : public VideoCore::RasterizerInterface {
+public:
+    void DrawArrays() override {}
+    void Clear() override {}
+    void NotifyMaxwellRegisterChanged(u32 method) override {
+        changed_registers.push_back(method);
+    }
+    void FlushAll() override {}
+    void ResetCounter(VideoCore::QueryType type) override {}
+    void Query(GPUVAddr addr, VideoCore::QueryType type, bool long_query) override {}
+    void FlushRegion(GPUVAddr addr, u64 size) override {}
+    void InvalidateRegion(GPUVAddr addr, u64 size) override {}
+    void FlushAndInvalidateRegion(GPUVAddr addr, u64 size) override {}
+
+    std::vector<u32> changed_registers;
+};
+
+} // namespace Tegra
@@ -18,6 +18,7 @@
 #include "video_core/engines/maxwell_compute.h"
 #include "video_core/engines/maxwell_dma.h"
 #include "video_core/gpu.h"
+#include "video_core/rasterizer_interface.h"
 #include "video_core/renderer_base.h"
 #include "video_core/video_core.h"
 
@@ -51,6 +52,12 @@ void GPU::WriteReg(u32 method, u32 subchannel, u32 value, u32 remaining_params)
 
     const EngineID engine = bound_engines[subchannel];
 
+    if (engine != EngineID::MAXWELL_B) {
+        // The other engines may access memory that the draws still deferred by the rasterizer
+        // render to
+        rasterizer.FlushCommands();
+    }
+
     switch (engine) {
     case EngineID::FERMI_TWOD_A:
         fermi_2d->WriteReg(method, value);
@@ -69,47 +76,71 @@ void GPU::WriteReg(u32 method, u32 subchannel, u32 value, u32 remaining_params)
     }
 }
 
+void GPU::WriteRegBatch(u32 method, u32 subchannel, const u32* values, u32 count,
+                        bool increasing) {
+    if (method >= static_cast<u32>(BufferMethods::CountBufferMethods)) {
+        const auto engine = bound_engines.find(subchannel);
+        if (engine != bound_engines.end() && engine->second == EngineID::MAXWELL_B) {
+            maxwell_3d->WriteRegBatch(method, values, count, increasing);
+            return;
+        }
+    }
+
+    for (u32 i = 0; i < count; ++i) {
+        WriteReg(increasing ? method + i : method, subchannel, values[i], count - i - 1);
+    }
+}
+
 void GPU::ProcessCommandList(GPUVAddr address, u32 size) {
+    TRACE_SCOPE("GPU Command List");
     const boost::optional<VAddr> head_address = memory_manager->GpuToCpuAddress(address);
-    VAddr current_addr = *head_address;
-    while (current_addr < *head_address + size * sizeof(CommandHeader)) {
-        const CommandHeader header = {Memory::Read32(current_addr)};
-        current_addr += sizeof(u32);
+
+    // Fetch the whole command list with one block read, instead of going through the page table
+    // for every single word.
+    command_buffer.resize(size);
+    Memory::ReadBlock(*head_address, command_buffer.data(), size * sizeof(u32));
+
+    const u32* current = command_buffer.data();
+    const u32* const end = current + size;
+    while (current < end) {
+        const CommandHeader header = {*current++};
+
+        u32 arg_count = header.arg_count;
+        if (header.mode != SubmissionMode::Inline && arg_count > end - current) {
+            LOG_ERROR(HW_GPU, "Command header with {} arguments overruns the command list",
+                      arg_count);
+            arg_count = static_cast<u32>(end - current);
+        }
 
         switch (header.mode.Value()) {
         case SubmissionMode::IncreasingOld:
         case SubmissionMode::Increasing: {
             // Increase the method value with each argument.
-            for (unsigned i = 0; i < header.arg_count; ++i) {
-                WriteReg(header.method + i, header.subchannel, Memory::Read32(current_addr),
-                         header.arg_count - i - 1);
-                current_addr += sizeof(u32);
-            }
+            WriteRegBatch(header.method, header.subchannel, current, arg_count, true);
+            current += arg_count;
             break;
         }
         case SubmissionMode::NonIncreasingOld:
         case SubmissionMode::NonIncreasing: {
             // Use the same method value for all arguments.
-            for (unsigned i = 0; i < header.arg_count; ++i) {
-                WriteReg(header.method, header.subchannel, Memory::Read32(current_addr),
-                         header.arg_count - i - 1);
-                current_addr += sizeof(u32);
-            }
+            WriteRegBatch(header.method, header.subchannel, current, arg_count, false);
+            current += arg_count;
             break;
         }
         case SubmissionMode::IncreaseOnce: {
-            ASSERT(header.arg_count.Value() >= 1);
+            if (arg_count == 0) {
+                // There is no first argument to read, the next word is already another header
+                LOG_ERROR(HW_GPU, "IncreaseOnce command for method 0x{:X} has no arguments",
+                          header.method.Value());
+                break;
+            }
 
             // Use the original method for the first argument and then the next method for all other
             // arguments.
-            WriteReg(header.method, header.subchannel, Memory::Read32(current_addr),
-                     header.arg_count - 1);
-            current_addr += sizeof(u32);
-
-            for (unsigned i = 1; i < header.arg_count; ++i) {
-                WriteReg(header.method + 1, header.subchannel, Memory::Read32(current_addr),
-                         header.arg_count - i - 1);
-                current_addr += sizeof(u32);
+            WriteReg(header.method, header.subchannel, *current++, arg_count - 1);
+
+            for (u32 i = 1; i < arg_count; ++i) {
+                WriteReg(header.method + 1, header.subchannel, *current++, arg_count - i - 1);
             }
             break;
         }
@@ -122,6 +153,10 @@ void GPU::ProcessCommandList(GPUVAddr address, u32 size) {
             UNIMPLEMENTED();
         }
     }
+
+    // Nothing is left deferred once the command list has been processed, so that the CPU never
+    // has to wait for the rasterizer
+    rasterizer.FlushCommands();
 }
 
 } // namespace Tegra
@@ -26,6 +26,10 @@ namespace Tegra {
 void DebugContext::DoOnEvent(Event event, void* data) {
     {
         std::unique_lock<std::mutex> lock(breakpoint_mutex);
+        {
+            std::lock_guard<std::mutex> task_lock(task_mutex);
+            halted = true;
+        }
 
         // TODO(Subv): Commit the rasterizer's caches so framebuffers, render targets, etc. will
         // show on debug widgets
@@ -40,9 +44,38 @@ void DebugContext::DoOnEvent(Event event, void* data) {
             breakpoint_observer->OnMaxwellBreakPointHit(event, data);
         }
 
-        // Wait until another thread tells us to Resume()
-        resume_from_breakpoint.wait(lock, [&] { return !at_breakpoint; });
+        // Wait until another thread tells us to Resume(), running what it asks for meanwhile
+        lock.unlock();
+        std::unique_lock<std::mutex> task_lock(task_mutex);
+        while (true) {
+            task_available.wait(task_lock, [&] { return !halted || !breakpoint_tasks.empty(); });
+            if (!halted) {
+                breakpoint_tasks.clear();
+                break;
+            }
+
+            auto tasks = std::move(breakpoint_tasks);
+            breakpoint_tasks.clear();
+            task_lock.unlock();
+            for (auto& task : tasks) {
+                task();
+            }
+            task_lock.lock();
+        }
+    }
+}
+
+bool DebugContext::RunAtBreakpoint(std::function<void()> task) {
+    {
+        std::lock_guard<std::mutex> lock(task_mutex);
+        if (!halted) {
+            return false;
+        }
+        breakpoint_tasks.push_back(std::move(task));
     }
+
+    task_available.notify_one();
+    return true;
 }
 
 void DebugContext::Resume() {
@@ -56,9 +89,12 @@ void DebugContext::Resume() {
 
         // Resume the waiting thread (i.e. OnEvent())
         at_breakpoint = false;
+
+        std::lock_guard<std::mutex> task_lock(task_mutex);
+        halted = false;
     }
 
-    resume_from_breakpoint.notify_one();
+    task_available.notify_one();
 }
 
 } // namespace Tegra
@@ -7,6 +7,7 @@
 #include <algorithm>
 #include <array>
 #include <condition_variable>
+#include <functional>
 #include <iterator>
 #include <list>
 #include <map>
@@ -130,6 +131,13 @@ public:
      */
     void Resume();
 
+    /**
+     * Runs a function on the thread halted at the current breakpoint, where the rasterizer can be
+     * used, without waiting for it. Functions still pending on resumption are dropped.
+     * @returns False if no breakpoint is active, in which case the function is dropped right away
+     */
+    bool RunAtBreakpoint(std::function<void()> task);
+
     /**
      * Delete all set breakpoints and resume emulation.
      */
@@ -155,11 +163,20 @@ private:
     /// Mutex protecting current breakpoint state and the observer list.
     std::mutex breakpoint_mutex;
 
-    /// Used by OnEvent to wait for resumption.
-    std::condition_variable resume_from_breakpoint;
-
     /// List of registered observers
     std::list<BreakPointObserver*> breakpoint_observers;
+
+    /**
+     * Protects the state below. It's separate from breakpoint_mutex, which is held while the
+     * observers are notified, so that they can call RunAtBreakpoint from their handlers.
+     */
+    std::mutex task_mutex;
+    /// Used by OnEvent to wait for resumption or for functions to run.
+    std::condition_variable task_available;
+    /// Whether a thread is halted in OnEvent, until Resume() is called.
+    bool halted = false;
+    /// Functions passed to RunAtBreakpoint that the halted thread has yet to run
+    std::vector<std::function<void()>> breakpoint_tasks;
 };
 
 } // namespace Tegra
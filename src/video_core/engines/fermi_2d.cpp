@@ -4,11 +4,13 @@
 
 #include "core/memory.h"
 #include "video_core/engines/fermi_2d.h"
+#include "video_core/rasterizer_interface.h"
 #include "video_core/textures/decoders.h"
 
 namespace Tegra::Engines {
 
-Fermi2D::Fermi2D(MemoryManager& memory_manager) : memory_manager(memory_manager) {}
+Fermi2D::Fermi2D(VideoCore::RasterizerInterface& rasterizer, MemoryManager& memory_manager)
+    : memory_manager(memory_manager), rasterizer(rasterizer) {}
 
 void Fermi2D::WriteReg(u32 method, u32 value) {
     ASSERT_MSG(method < Regs::NUM_REGS,
@@ -38,6 +40,12 @@ void Fermi2D::HandleSurfaceCopy() {
     // TODO(Subv): Only raw copies are implemented.
     ASSERT(regs.operation == Regs::Operation::SrcCopy);
 
+    // Copy on the host GPU when both surfaces are already there, this avoids a round trip through
+    // guest memory.
+    if (rasterizer.AccelerateSurfaceCopy(regs.src, regs.dst)) {
+        return;
+    }
+
     const VAddr source_cpu = *memory_manager.GpuToCpuAddress(source);
     const VAddr dest_cpu = *memory_manager.GpuToCpuAddress(dest);
 
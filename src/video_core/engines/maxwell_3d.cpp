@@ -2,9 +2,13 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <chrono>
 #include <cinttypes>
+#include <cstring>
+#include <utility>
 #include "common/assert.h"
 #include "core/core.h"
+#include "core/core_timing.h"
 #include "video_core/debug_utils/debug_utils.h"
 #include "video_core/engines/maxwell_3d.h"
 #include "video_core/rasterizer_interface.h"
@@ -13,6 +17,10 @@
 #include "video_core/textures/texture.h"
 #include "video_core/video_core.h"
 
+#ifdef ARCHITECTURE_x86_64
+#include "video_core/macro_jit_x64.h"
+#endif
+
 namespace Tegra {
 namespace Engines {
 
@@ -22,7 +30,9 @@ constexpr u32 MacroRegistersStart = 0xE00;
 Maxwell3D::Maxwell3D(VideoCore::RasterizerInterface& rasterizer, MemoryManager& memory_manager)
     : memory_manager(memory_manager), rasterizer{rasterizer}, macro_interpreter(*this) {}
 
-void Maxwell3D::CallMacroMethod(u32 method, std::vector<u32> parameters) {
+Maxwell3D::~Maxwell3D() = default;
+
+void Maxwell3D::CallMacroMethod(u32 method, std::vector<u32>& parameters) {
     // Reset the current macro.
     executing_macro = 0;
 
@@ -33,8 +43,37 @@ void Maxwell3D::CallMacroMethod(u32 method, std::vector<u32> parameters) {
         return;
     }
 
+    // Look up a native replacement the first time the macro is called after being uploaded.
+    auto hle_macro = hle_macros.find(method);
+    if (hle_macro == hle_macros.end()) {
+        const HLEMacroFunction function = GetHLEMacro(GetMacroHash(macro_code->second));
+        hle_macro = hle_macros.emplace(method, function).first;
+    }
+
+    if (hle_macro->second != nullptr) {
+        hle_macro->second(*this, parameters);
+        return;
+    }
+
+#ifdef ARCHITECTURE_x86_64
+    // Compile the macro the first time it is called after being uploaded.
+    auto jit = macro_jits.find(method);
+    if (jit == macro_jits.end()) {
+        auto compiled = std::make_unique<MacroJITx64>(*this, macro_code->second);
+        if (!compiled->IsCompiled()) {
+            compiled.reset();
+        }
+        jit = macro_jits.emplace(method, std::move(compiled)).first;
+    }
+
+    if (jit->second != nullptr) {
+        jit->second->Execute(parameters);
+        return;
+    }
+#endif
+
     // Execute the current macro.
-    macro_interpreter.Execute(macro_code->second, std::move(parameters));
+    macro_interpreter.Execute(macro_code->second, parameters);
 }
 
 void Maxwell3D::WriteReg(u32 method, u32 value, u32 remaining_params) {
@@ -61,7 +100,9 @@ void Maxwell3D::WriteReg(u32 method, u32 value, u32 remaining_params) {
 
         // Call the macro when there are no more parameters in the command buffer
         if (remaining_params == 0) {
-            CallMacroMethod(executing_macro, std::move(macro_params));
+            CallMacroMethod(executing_macro, macro_params);
+            // Keep the allocation around for the next call
+            macro_params.clear();
         }
         return;
     }
@@ -131,6 +172,10 @@ void Maxwell3D::WriteReg(u32 method, u32 value, u32 remaining_params) {
         ProcessQueryGet();
         break;
     }
+    case MAXWELL3D_REG_INDEX(counter_reset): {
+        ProcessCounterReset();
+        break;
+    }
     default:
         break;
     }
@@ -142,10 +187,46 @@ void Maxwell3D::WriteReg(u32 method, u32 value, u32 remaining_params) {
     }
 }
 
+void Maxwell3D::WriteRegBatch(u32 method, const u32* values, u32 count, bool increasing) {
+    constexpr u32 cb_data_begin = MAXWELL3D_REG_INDEX(const_buffer.cb_data[0]);
+    constexpr u32 cb_data_end = cb_data_begin + Regs::NumCBData;
+
+    // Const buffer uploads make up most of the method calls, a run that only writes to the
+    // CB_DATA registers is turned into a single block write.
+    const u32 last_method = increasing ? method + count - 1 : method;
+    const bool is_cb_data_run = method >= cb_data_begin && last_method < cb_data_end;
+    if (count > 1 && is_cb_data_run && executing_macro == 0 &&
+        Core::System::GetInstance().GetGPUDebugContext() == nullptr &&
+        ProcessCBDataBatch(values, count)) {
+
+        if (increasing) {
+            std::memcpy(&regs.reg_array[method], values, count * sizeof(u32));
+            for (u32 i = 0; i < count; ++i) {
+                rasterizer.NotifyMaxwellRegisterChanged(method + i);
+            }
+        } else {
+            regs.reg_array[method] = values[count - 1];
+            rasterizer.NotifyMaxwellRegisterChanged(method);
+        }
+        return;
+    }
+
+    for (u32 i = 0; i < count; ++i) {
+        WriteReg(increasing ? method + i : method, values[i], count - i - 1);
+    }
+}
+
 void Maxwell3D::ProcessMacroUpload(u32 data) {
     // Store the uploaded macro code to interpret them when they're called.
-    auto& macro = uploaded_macros[regs.macros.entry * 2 + MacroRegistersStart];
+    const u32 method = regs.macros.entry * 2 + MacroRegistersStart;
+    auto& macro = uploaded_macros[method];
     macro.push_back(data);
+
+    // The code changed, so does its replacement
+    hle_macros.erase(method);
+#ifdef ARCHITECTURE_x86_64
+    macro_jits.erase(method);
+#endif
 }
 
 void Maxwell3D::ProcessQueryGet() {
@@ -154,23 +235,7 @@ void Maxwell3D::ProcessQueryGet() {
     // VAddr before writing.
     boost::optional<VAddr> address = memory_manager.GpuToCpuAddress(sequence_address);
 
-    // TODO(Subv): Support the other query units.
-    ASSERT_MSG(regs.query.query_get.unit == Regs::QueryUnit::Crop,
-               "Units other than CROP are unimplemented");
-
-    u32 value = Memory::Read32(*address);
-    u64 result = 0;
-
-    // TODO(Subv): Support the other query variables
-    switch (regs.query.query_get.select) {
-    case Regs::QuerySelect::Zero:
-        // This seems to actually write the query sequence to the query address.
-        result = regs.query.query_sequence;
-        break;
-    default:
-        UNIMPLEMENTED_MSG("Unimplemented query select type {}",
-                          static_cast<u32>(regs.query.query_get.select.Value()));
-    }
+    // The unit that records the value isn't emulated, the value only depends on the select.
 
     // TODO(Subv): Research and implement how query sync conditions work.
 
@@ -183,8 +248,23 @@ void Maxwell3D::ProcessQueryGet() {
     switch (regs.query.query_get.mode) {
     case Regs::QueryMode::Write:
     case Regs::QueryMode::Write2: {
+        const bool long_query = regs.query.query_get.short_query == 0;
+
+        switch (regs.query.query_get.select) {
+        case Regs::QuerySelect::Zero:
+            break;
+        case Regs::QuerySelect::SamplesPassed:
+            // The host GPU has yet to execute the draws that are counted, the rasterizer writes
+            // the result once it's available instead of waiting for it here.
+            rasterizer.Query(sequence_address, VideoCore::QueryType::SamplesPassed, long_query);
+            return;
+        default:
+            UNIMPLEMENTED_MSG("Unimplemented query select type {}",
+                              static_cast<u32>(regs.query.query_get.select.Value()));
+        }
+
         u32 sequence = regs.query.query_sequence;
-        if (regs.query.query_get.short_query) {
+        if (!long_query) {
             // Write the current query sequence to the sequence address.
             // TODO(Subv): Find out what happens if you use a long query type but mark it as a short
             // query.
@@ -194,9 +274,9 @@ void Maxwell3D::ProcessQueryGet() {
             // GPU, this command may actually take a while to complete in real hardware due to GPU
             // wait queues.
             LongQueryResult query_result{};
-            query_result.value = result;
-            // TODO(Subv): Generate a real GPU timestamp and write it here instead of 0
-            query_result.timestamp = 0;
+            // This seems to actually write the query sequence to the query address.
+            query_result.value = sequence;
+            query_result.timestamp = GetQueryTimestamp();
             Memory::WriteBlock(*address, &query_result, sizeof(query_result));
         }
         break;
@@ -207,6 +287,25 @@ void Maxwell3D::ProcessQueryGet() {
     }
 }
 
+u64 Maxwell3D::GetQueryTimestamp() {
+    // The GPU timer counts nanoseconds, the emulated time stands in for it
+    return static_cast<u64>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(CoreTiming::GetGlobalTimeUs())
+            .count());
+}
+
+void Maxwell3D::ProcessCounterReset() {
+    switch (regs.counter_reset) {
+    case Regs::CounterReset::SampleCnt:
+        rasterizer.ResetCounter(VideoCore::QueryType::SamplesPassed);
+        break;
+    default:
+        LOG_WARNING(HW_GPU, "Unimplemented counter reset {}",
+                    static_cast<u32>(regs.counter_reset));
+        break;
+    }
+}
+
 void Maxwell3D::DrawArrays() {
     LOG_DEBUG(HW_GPU, "called, topology={}, count={}", static_cast<u32>(regs.draw.topology.Value()),
               regs.vertex_buffer.count);
@@ -280,6 +379,31 @@ void Maxwell3D::ProcessCBData(u32 value) {
     regs.const_buffer.cb_pos = regs.const_buffer.cb_pos + 4;
 }
 
+bool Maxwell3D::ProcessCBDataBatch(const u32* values, u32 count) {
+    const GPUVAddr buffer_address = regs.const_buffer.BufferAddress();
+    ASSERT(buffer_address != 0);
+
+    // Don't allow writing past the end of the buffer.
+    const u32 size = count * sizeof(u32);
+    ASSERT(regs.const_buffer.cb_pos + size <= regs.const_buffer.cb_size);
+
+    const GPUVAddr start = buffer_address + regs.const_buffer.cb_pos;
+    const boost::optional<VAddr> address = memory_manager.GpuToCpuAddress(start);
+    const boost::optional<VAddr> last_address =
+        memory_manager.GpuToCpuAddress(start + size - sizeof(u32));
+
+    // The upload can only be done in one go if the range is contiguous in CPU memory too.
+    if (!address || !last_address || *last_address != *address + size - sizeof(u32)) {
+        return false;
+    }
+
+    Memory::WriteBlock(*address, values, size);
+
+    // Increment the current buffer position.
+    regs.const_buffer.cb_pos = regs.const_buffer.cb_pos + size;
+    return true;
+}
+
 Texture::TICEntry Maxwell3D::GetTICEntry(u32 tic_index) const {
     GPUVAddr tic_base_address = regs.tic.TICAddress();
 
@@ -367,16 +491,7 @@ std::vector<Texture::FullTextureInfo> Maxwell3D::GetStageTextures(Regs::ShaderSt
 }
 
 Texture::FullTextureInfo Maxwell3D::GetStageTexture(Regs::ShaderStage stage, size_t offset) const {
-    auto& shader = state.shader_stages[static_cast<size_t>(stage)];
-    auto& tex_info_buffer = shader.const_buffers[regs.tex_cb_index];
-    ASSERT(tex_info_buffer.enabled && tex_info_buffer.address != 0);
-
-    GPUVAddr tex_info_address = tex_info_buffer.address + offset * sizeof(Texture::TextureHandle);
-
-    ASSERT(tex_info_address < tex_info_buffer.address + tex_info_buffer.size);
-
-    boost::optional<VAddr> tex_address_cpu = memory_manager.GpuToCpuAddress(tex_info_address);
-    Texture::TextureHandle tex_handle{Memory::Read32(*tex_address_cpu)};
+    const Texture::TextureHandle tex_handle = GetStageTextureHandle(stage, offset);
 
     Texture::FullTextureInfo tex_info{};
     tex_info.index = static_cast<u32>(offset);
@@ -400,11 +515,48 @@ Texture::FullTextureInfo Maxwell3D::GetStageTexture(Regs::ShaderStage stage, siz
     return tex_info;
 }
 
+Texture::TextureHandle Maxwell3D::GetStageTextureHandle(Regs::ShaderStage stage,
+                                                       size_t offset) const {
+    auto& shader = state.shader_stages[static_cast<size_t>(stage)];
+    auto& tex_info_buffer = shader.const_buffers[regs.tex_cb_index];
+    ASSERT(tex_info_buffer.enabled && tex_info_buffer.address != 0);
+
+    GPUVAddr tex_info_address = tex_info_buffer.address + offset * sizeof(Texture::TextureHandle);
+
+    ASSERT(tex_info_address < tex_info_buffer.address + tex_info_buffer.size);
+
+    boost::optional<VAddr> tex_address_cpu = memory_manager.GpuToCpuAddress(tex_info_address);
+    return Texture::TextureHandle{Memory::Read32(*tex_address_cpu)};
+}
+
 u32 Maxwell3D::GetRegisterValue(u32 method) const {
     ASSERT_MSG(method < Regs::NUM_REGS, "Invalid Maxwell3D register");
     return regs.reg_array[method];
 }
 
+void Maxwell3D::SetRegisters(const std::array<u32, Regs::NUM_REGS>& values) {
+    regs.reg_array = values;
+    for (u32 method = 0; method < Regs::NUM_REGS; ++method) {
+        rasterizer.NotifyMaxwellRegisterChanged(method);
+    }
+}
+
+const std::unordered_map<u32, std::vector<u32>>& Maxwell3D::GetUploadedMacros() const {
+    return uploaded_macros;
+}
+
+void Maxwell3D::SetUploadedMacros(std::unordered_map<u32, std::vector<u32>> macros) {
+    uploaded_macros = std::move(macros);
+    // The native replacements are looked up, and the macros compiled, again the next time each
+    // macro is called
+    hle_macros.clear();
+#ifdef ARCHITECTURE_x86_64
+    macro_jits.clear();
+#endif
+    executing_macro = 0;
+    macro_params.clear();
+}
+
 void Maxwell3D::ProcessClearBuffers() {
     ASSERT(regs.clear_buffers.R == regs.clear_buffers.G &&
            regs.clear_buffers.R == regs.clear_buffers.B &&
@@ -5,6 +5,7 @@
 #pragma once
 
 #include <array>
+#include <memory>
 #include <unordered_map>
 #include <vector>
 #include "common/assert.h"
@@ -13,6 +14,7 @@
 #include "common/common_types.h"
 #include "common/math_util.h"
 #include "video_core/gpu.h"
+#include "video_core/macro_hle.h"
 #include "video_core/macro_interpreter.h"
 #include "video_core/memory_manager.h"
 #include "video_core/textures/texture.h"
@@ -21,6 +23,10 @@ namespace VideoCore {
 class RasterizerInterface;
 }
 
+namespace Tegra {
+class MacroJITx64;
+}
+
 namespace Tegra::Engines {
 
 #define MAXWELL3D_REG_INDEX(field_name)                                                            \
@@ -29,7 +35,7 @@ namespace Tegra::Engines {
 class Maxwell3D final {
 public:
     explicit Maxwell3D(VideoCore::RasterizerInterface& rasterizer, MemoryManager& memory_manager);
-    ~Maxwell3D() = default;
+    ~Maxwell3D();
 
     /// Register structure of the Maxwell3D engine.
     /// TODO(Subv): This structure will need to be made bigger as more registers are discovered.
@@ -67,6 +73,11 @@ public:
 
         enum class QuerySelect : u32 {
             Zero = 0,
+            SamplesPassed = 0x15,
+        };
+
+        enum class CounterReset : u32 {
+            SampleCnt = 0x01,
         };
 
         enum class QuerySyncCondition : u32 {
@@ -121,6 +132,7 @@ public:
             };
 
             union {
+                u32 raw;
                 BitField<0, 5, u32> buffer;
                 BitField<6, 1, u32> constant;
                 BitField<7, 14, u32> offset;
@@ -611,7 +623,11 @@ public:
 
                 u32 vb_element_base;
 
-                INSERT_PADDING_WORDS(0x40);
+                INSERT_PADDING_WORDS(0x3E);
+
+                CounterReset counter_reset;
+
+                INSERT_PADDING_WORDS(0x1);
 
                 u32 zeta_enable;
 
@@ -897,16 +913,56 @@ public:
     /// Write the value to the register identified by method.
     void WriteReg(u32 method, u32 value, u32 remaining_params);
 
+    /**
+     * Writes a run of values coming from a single command header.
+     * @param method First register of the run.
+     * @param values Values to write, one per register write.
+     * @param count Number of values.
+     * @param increasing Whether the register advances with each value, or all values go to the
+     * same register.
+     */
+    void WriteRegBatch(u32 method, const u32* values, u32 count, bool increasing);
+
     /// Returns a list of enabled textures for the specified shader stage.
     std::vector<Texture::FullTextureInfo> GetStageTextures(Regs::ShaderStage stage) const;
 
     /// Returns the texture information for a specific texture in a specific shader stage.
     Texture::FullTextureInfo GetStageTexture(Regs::ShaderStage stage, size_t offset) const;
 
+    /// Returns the handle of a specific texture in a specific shader stage, read from the texture
+    /// const buffer.
+    Texture::TextureHandle GetStageTextureHandle(Regs::ShaderStage stage, size_t offset) const;
+
+    /// Retrieves information about a specific TIC entry from the TIC buffer.
+    Texture::TICEntry GetTICEntry(u32 tic_index) const;
+
+    /// Retrieves information about a specific TSC entry from the TSC buffer.
+    Texture::TSCEntry GetTSCEntry(u32 tsc_index) const;
+
+    /// Replaces every register, notifying the rasterizer of each of them like regular writes do.
+    void SetRegisters(const std::array<u32, Regs::NUM_REGS>& values);
+
+    /// Returns the code of the uploaded macros, by the method that calls them.
+    const std::unordered_map<u32, std::vector<u32>>& GetUploadedMacros() const;
+
+    /// Replaces every uploaded macro, used to restore a recorded GPU state.
+    void SetUploadedMacros(std::unordered_map<u32, std::vector<u32>> macros);
+
+    /// Returns the GPU timestamp written along long query results, in nanoseconds.
+    static u64 GetQueryTimestamp();
+
 private:
+    friend class Tegra::HLEMacros;
+
     VideoCore::RasterizerInterface& rasterizer;
 
     std::unordered_map<u32, std::vector<u32>> uploaded_macros;
+    /// Native replacements of the uploaded macros, nullptr for macros that are interpreted.
+    std::unordered_map<u32, HLEMacroFunction> hle_macros;
+#ifdef ARCHITECTURE_x86_64
+    /// Compiled versions of the uploaded macros, nullptr for macros the JIT can't compile.
+    std::unordered_map<u32, std::unique_ptr<MacroJITx64>> macro_jits;
+#endif
 
     /// Macro method that is currently being executed / being fed parameters.
     u32 executing_macro = 0;
@@ -916,18 +972,12 @@ private:
     /// Interpreter for the macro codes uploaded to the GPU.
     MacroInterpreter macro_interpreter;
 
-    /// Retrieves information about a specific TIC entry from the TIC buffer.
-    Texture::TICEntry GetTICEntry(u32 tic_index) const;
-
-    /// Retrieves information about a specific TSC entry from the TSC buffer.
-    Texture::TSCEntry GetTSCEntry(u32 tsc_index) const;
-
     /**
      * Call a macro on this engine.
      * @param method Method to call
      * @param parameters Arguments to the method call
      */
-    void CallMacroMethod(u32 method, std::vector<u32> parameters);
+    void CallMacroMethod(u32 method, std::vector<u32>& parameters);
 
     /// Handles writes to the macro uploading registers.
     void ProcessMacroUpload(u32 data);
@@ -938,9 +988,19 @@ private:
     /// Handles a write to the QUERY_GET register.
     void ProcessQueryGet();
 
+    /// Handles a write to the COUNTER_RESET register.
+    void ProcessCounterReset();
+
     /// Handles a write to the CB_DATA[i] register.
     void ProcessCBData(u32 value);
 
+    /**
+     * Handles a run of writes to the CB_DATA registers, uploading all of the values to the current
+     * const buffer at once.
+     * @returns false if the run could not be uploaded as a single block.
+     */
+    bool ProcessCBDataBatch(const u32* values, u32 count);
+
     /// Handles a write to the CB_BIND register.
     void ProcessCBBind(Regs::ShaderStage stage);
 
@@ -984,6 +1044,7 @@ ASSERT_REG_POSITION(stencil_front_func_mask, 0x4E6);
 ASSERT_REG_POSITION(stencil_front_mask, 0x4E7);
 ASSERT_REG_POSITION(screen_y_control, 0x4EB);
 ASSERT_REG_POSITION(vb_element_base, 0x50D);
+ASSERT_REG_POSITION(counter_reset, 0x54C);
 ASSERT_REG_POSITION(zeta_enable, 0x54E);
 ASSERT_REG_POSITION(tsc, 0x557);
 ASSERT_REG_POSITION(tic, 0x55D);
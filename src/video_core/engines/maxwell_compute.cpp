@@ -2,12 +2,56 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include "common/logging/log.h"
+#include "core/memory.h"
 #include "video_core/engines/maxwell_compute.h"
 
-namespace Tegra {
-namespace Engines {
+namespace Tegra::Engines {
 
-void MaxwellCompute::WriteReg(u32 method, u32 value) {}
+MaxwellCompute::MaxwellCompute(MemoryManager& memory_manager) : memory_manager(memory_manager) {}
 
-} // namespace Engines
-} // namespace Tegra
+void MaxwellCompute::WriteReg(u32 method, u32 value) {
+    ASSERT_MSG(method < Regs::NUM_REGS,
+               "Invalid MaxwellCompute register, increase the size of the Regs structure");
+
+    regs.reg_array[method] = value;
+
+    switch (method) {
+    case MAXWELL_COMPUTE_REG_INDEX(launch): {
+        ProcessLaunch();
+        break;
+    }
+    }
+}
+
+void MaxwellCompute::ProcessLaunch() {
+    const boost::optional<VAddr> launch_desc_address =
+        memory_manager.GpuToCpuAddress(regs.launch_desc_loc.Address());
+    if (!launch_desc_address) {
+        LOG_ERROR(HW_GPU, "Compute launch descriptor at 0x{:X} is not mapped",
+                  regs.launch_desc_loc.Address());
+        return;
+    }
+
+    LaunchParams launch{};
+    Memory::ReadBlock(*launch_desc_address, &launch, sizeof(launch));
+
+    const GPUVAddr program_address = regs.code_loc.Address() + launch.program_start;
+    LOG_DEBUG(HW_GPU, "Compute launch, program=0x{:X}, grid={}x{}x{}, block={}x{}x{}, shared={}",
+              program_address, launch.grid_dim_x.Value(), launch.grid_dim_y.Value(),
+              launch.grid_dim_z.Value(), launch.block_dim_x.Value(), launch.block_dim_y.Value(),
+              launch.block_dim_z.Value(), launch.shared_alloc.Value());
+    for (size_t index = 0; index < NumConstBuffers; ++index) {
+        if ((launch.const_buffer_enable_mask >> index) & 1) {
+            const auto& const_buffer = launch.const_buffer_config[index];
+            LOG_DEBUG(HW_GPU, "Compute const buffer {}, address=0x{:X}, size={}", index,
+                      const_buffer.Address(), const_buffer.size.Value());
+        }
+    }
+
+    // The rasterizer has no compute pipeline to run the program on yet, so the dispatch has no
+    // effect. Its decoded descriptor above is what it would be launched with.
+    LOG_CRITICAL(HW_GPU, "Unimplemented compute dispatch of program 0x{:X}", program_address);
+}
+
+} // namespace Tegra::Engines
@@ -4,17 +4,143 @@
 
 #pragma once
 
+#include <array>
+#include <cstddef>
+#include "common/assert.h"
+#include "common/bit_field.h"
+#include "common/common_funcs.h"
 #include "common/common_types.h"
+#include "video_core/gpu.h"
+#include "video_core/memory_manager.h"
 
 namespace Tegra::Engines {
 
+#define MAXWELL_COMPUTE_REG_INDEX(field_name)                                                      \
+    (offsetof(Tegra::Engines::MaxwellCompute::Regs, field_name) / sizeof(u32))
+
 class MaxwellCompute final {
 public:
-    MaxwellCompute() = default;
+    explicit MaxwellCompute(MemoryManager& memory_manager);
     ~MaxwellCompute() = default;
 
+    static constexpr size_t NumConstBuffers = 8;
+
+    struct Regs {
+        static constexpr size_t NUM_REGS = 0xCF8;
+
+        union {
+            struct {
+                INSERT_PADDING_WORDS(0xAD);
+
+                struct {
+                    u32 address;
+                    GPUVAddr Address() const {
+                        return static_cast<GPUVAddr>(address) << 8;
+                    }
+                } launch_desc_loc;
+
+                INSERT_PADDING_WORDS(0x1);
+
+                u32 launch;
+
+                INSERT_PADDING_WORDS(0x4D2);
+
+                struct {
+                    u32 address_high;
+                    u32 address_low;
+                    GPUVAddr Address() const {
+                        return static_cast<GPUVAddr>((static_cast<GPUVAddr>(address_high) << 32) |
+                                                     address_low);
+                    }
+                } code_loc;
+
+                INSERT_PADDING_WORDS(0x774);
+            };
+            std::array<u32, NUM_REGS> reg_array;
+        };
+    } regs{};
+    static_assert(sizeof(Regs) == Regs::NUM_REGS * sizeof(u32),
+                  "MaxwellCompute Regs has wrong size");
+
+    /// Launch descriptor of a dispatch, read from the address in launch_desc_loc
+    struct LaunchParams {
+        static constexpr size_t NUM_LAUNCH_PARAMETERS = 0x40;
+
+        INSERT_PADDING_WORDS(0x8);
+
+        /// Offset of the program from code_loc
+        u32 program_start;
+
+        INSERT_PADDING_WORDS(0x3);
+
+        BitField<0, 31, u32> grid_dim_x;
+        union {
+            BitField<0, 16, u32> grid_dim_y;
+            BitField<16, 16, u32> grid_dim_z;
+        };
+
+        INSERT_PADDING_WORDS(0x3);
+
+        BitField<0, 18, u32> shared_alloc;
+
+        BitField<16, 16, u32> block_dim_x;
+        union {
+            BitField<0, 16, u32> block_dim_y;
+            BitField<16, 16, u32> block_dim_z;
+        };
+
+        BitField<0, 8, u32> const_buffer_enable_mask;
+
+        INSERT_PADDING_WORDS(0x8);
+
+        struct ConstBufferConfig {
+            u32 address_low;
+            union {
+                BitField<0, 8, u32> address_high;
+                BitField<15, 17, u32> size;
+            };
+            GPUVAddr Address() const {
+                return static_cast<GPUVAddr>((static_cast<GPUVAddr>(address_high) << 32) |
+                                             address_low);
+            }
+        };
+        std::array<ConstBufferConfig, NumConstBuffers> const_buffer_config;
+
+        INSERT_PADDING_WORDS(0x13);
+    };
+    static_assert(sizeof(LaunchParams) == LaunchParams::NUM_LAUNCH_PARAMETERS * sizeof(u32),
+                  "LaunchParams has wrong size");
+
+    MemoryManager& memory_manager;
+
     /// Write the value to the register identified by method.
     void WriteReg(u32 method, u32 value);
+
+private:
+    /// Reads the launch descriptor of the dispatch requested by a write to launch, the dispatch
+    /// itself is not implemented yet
+    void ProcessLaunch();
 };
 
+#define ASSERT_REG_POSITION(field_name, position)                                                  \
+    static_assert(offsetof(MaxwellCompute::Regs, field_name) == position * 4,                      \
+                  "Field " #field_name " has invalid position")
+
+ASSERT_REG_POSITION(launch_desc_loc, 0xAD);
+ASSERT_REG_POSITION(launch, 0xAF);
+ASSERT_REG_POSITION(code_loc, 0x582);
+#undef ASSERT_REG_POSITION
+
+#define ASSERT_LAUNCH_PARAM_POSITION(field_name, position)                                         \
+    static_assert(offsetof(MaxwellCompute::LaunchParams, field_name) == position * 4,              \
+                  "Field " #field_name " has invalid position")
+
+ASSERT_LAUNCH_PARAM_POSITION(program_start, 0x8);
+ASSERT_LAUNCH_PARAM_POSITION(grid_dim_x, 0xC);
+ASSERT_LAUNCH_PARAM_POSITION(shared_alloc, 0x11);
+ASSERT_LAUNCH_PARAM_POSITION(block_dim_x, 0x12);
+ASSERT_LAUNCH_PARAM_POSITION(const_buffer_enable_mask, 0x14);
+ASSERT_LAUNCH_PARAM_POSITION(const_buffer_config, 0x1D);
+#undef ASSERT_LAUNCH_PARAM_POSITION
+
 } // namespace Tegra::Engines
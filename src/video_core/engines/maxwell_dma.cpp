@@ -2,6 +2,7 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <vector>
 #include "core/memory.h"
 #include "video_core/engines/maxwell_dma.h"
 #include "video_core/textures/decoders.h"
@@ -9,6 +10,9 @@
 namespace Tegra {
 namespace Engines {
 
+#define MAXWELLDMA_REG_INDEX(field_name)                                                           \
+    (offsetof(Tegra::Engines::MaxwellDMA::Regs, field_name) / sizeof(u32))
+
 MaxwellDMA::MaxwellDMA(MemoryManager& memory_manager) : memory_manager(memory_manager) {}
 
 void MaxwellDMA::WriteReg(u32 method, u32 value) {
@@ -17,21 +21,39 @@ void MaxwellDMA::WriteReg(u32 method, u32 value) {
 
     regs.reg_array[method] = value;
 
-#define MAXWELLDMA_REG_INDEX(field_name)                                                           \
-    (offsetof(Tegra::Engines::MaxwellDMA::Regs, field_name) / sizeof(u32))
-
     switch (method) {
     case MAXWELLDMA_REG_INDEX(exec): {
         HandleCopy();
         break;
     }
     }
+}
 
-#undef MAXWELLDMA_REG_INDEX
+u32 MaxwellDMA::GetBytesPerElement() const {
+    if (regs.exec.enable_swizzle == 0) {
+        // Without component remapping the engine copies bytes.
+        return 1;
+    }
+
+    const auto& config = regs.swizzle_config;
+    const u32 num_components = config.num_src_components_minus_one + 1;
+    const bool is_plain_copy =
+        config.num_dst_components_minus_one == config.num_src_components_minus_one &&
+        config.dst_x == Regs::Swizzle::SrcX &&
+        (num_components < 2 || config.dst_y == Regs::Swizzle::SrcY) &&
+        (num_components < 3 || config.dst_z == Regs::Swizzle::SrcZ) &&
+        (num_components < 4 || config.dst_w == Regs::Swizzle::SrcW);
+    if (!is_plain_copy) {
+        LOG_CRITICAL(HW_GPU, "Unimplemented DMA component remapping 0x{:08X}",
+                     regs.reg_array[MAXWELLDMA_REG_INDEX(swizzle_config)]);
+        UNREACHABLE();
+    }
+
+    return config.BytesPerElement();
 }
 
 void MaxwellDMA::HandleCopy() {
-    LOG_WARNING(HW_GPU, "Requested a DMA copy");
+    LOG_TRACE(HW_GPU, "Requested a DMA copy");
 
     const GPUVAddr source = regs.src_address.Address();
     const GPUVAddr dest = regs.dst_address.Address();
@@ -40,34 +62,58 @@ void MaxwellDMA::HandleCopy() {
     const VAddr dest_cpu = *memory_manager.GpuToCpuAddress(dest);
 
     // TODO(Subv): Perform more research and implement all features of this engine.
-    ASSERT(regs.exec.enable_swizzle == 0);
-    ASSERT(regs.exec.enable_2d == 1);
+    // The copy mode only selects how the transfer is ordered against other work, so it does not
+    // change the result of the copy.
     ASSERT(regs.exec.query_mode == Regs::QueryMode::None);
     ASSERT(regs.exec.query_intr == Regs::QueryIntr::None);
-    ASSERT(regs.exec.copy_mode == Regs::CopyMode::Unk2);
-    ASSERT(regs.src_params.pos_x == 0);
-    ASSERT(regs.src_params.pos_y == 0);
-    ASSERT(regs.dst_params.pos_x == 0);
-    ASSERT(regs.dst_params.pos_y == 0);
-
-    if (regs.exec.is_dst_linear == regs.exec.is_src_linear) {
-        Memory::CopyBlock(dest_cpu, source_cpu, regs.x_count * regs.y_count);
+
+    const u32 bytes_per_element = GetBytesPerElement();
+    const u32 line_size = regs.x_count * bytes_per_element;
+
+    if (regs.exec.enable_2d == 0) {
+        // 1D copies ignore the layout of both buffers.
+        Memory::CopyBlock(dest_cpu, source_cpu, line_size);
+        return;
+    }
+
+    if (regs.exec.is_dst_linear && regs.exec.is_src_linear) {
+        if (regs.src_pitch == line_size && regs.dst_pitch == line_size) {
+            Memory::CopyBlock(dest_cpu, source_cpu, line_size * regs.y_count);
+            return;
+        }
+        for (u32 line = 0; line < regs.y_count; ++line) {
+            Memory::CopyBlock(dest_cpu + line * regs.dst_pitch, source_cpu + line * regs.src_pitch,
+                              line_size);
+        }
         return;
     }
 
     u8* src_buffer = Memory::GetPointer(source_cpu);
     u8* dst_buffer = Memory::GetPointer(dest_cpu);
 
-    if (regs.exec.is_dst_linear && !regs.exec.is_src_linear) {
+    const auto copy_rect = [&](const Regs::Parameters& params, u8* swizzled, u8* linear,
+                               u32 linear_pitch, bool unswizzle) {
+        Texture::CopyBlockLinearRect(regs.x_count, regs.y_count, bytes_per_element, swizzled,
+                                     params.size_x, params.size_y, params.BlockHeight(),
+                                     params.BlockDepth(), params.pos_x, params.pos_y,
+                                     params.pos_z, linear, linear_pitch, unswizzle);
+    };
+
+    if (regs.exec.is_dst_linear) {
         // If the input is tiled and the output is linear, deswizzle the input and copy it over.
-        Texture::CopySwizzledData(regs.src_params.size_x, regs.src_params.size_y, 1, 1, src_buffer,
-                                  dst_buffer, true, regs.src_params.BlockHeight());
-    } else {
+        copy_rect(regs.src_params, src_buffer, dst_buffer, regs.dst_pitch, true);
+    } else if (regs.exec.is_src_linear) {
         // If the input is linear and the output is tiled, swizzle the input and copy it over.
-        Texture::CopySwizzledData(regs.dst_params.size_x, regs.dst_params.size_y, 1, 1, dst_buffer,
-                                  src_buffer, false, regs.dst_params.BlockHeight());
+        copy_rect(regs.dst_params, dst_buffer, src_buffer, regs.src_pitch, false);
+    } else {
+        // Both surfaces are tiled, their layouts may differ so go through a linear buffer.
+        std::vector<u8> staging(line_size * regs.y_count);
+        copy_rect(regs.src_params, src_buffer, staging.data(), line_size, true);
+        copy_rect(regs.dst_params, dst_buffer, staging.data(), line_size, false);
     }
 }
 
+#undef MAXWELLDMA_REG_INDEX
+
 } // namespace Engines
 } // namespace Tegra
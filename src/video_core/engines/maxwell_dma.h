@@ -43,6 +43,10 @@ public:
             u32 BlockHeight() const {
                 return 1 << block_height;
             }
+
+            u32 BlockDepth() const {
+                return 1 << block_depth;
+            }
         };
 
         static_assert(sizeof(Parameters) == 24, "Parameters has wrong size");
@@ -65,6 +69,16 @@ public:
             NonBlock = 2,
         };
 
+        enum class Swizzle : u32 {
+            SrcX = 0,
+            SrcY = 1,
+            SrcZ = 2,
+            SrcW = 3,
+            ConstA = 4,
+            ConstB = 5,
+            NoWrite = 6,
+        };
+
         union {
             struct {
                 INSERT_PADDING_WORDS(0xC0);
@@ -112,7 +126,25 @@ public:
                 u32 x_count;
                 u32 y_count;
 
-                INSERT_PADDING_WORDS(0xBB);
+                INSERT_PADDING_WORDS(0xB8);
+
+                u32 const_a;
+                u32 const_b;
+
+                union {
+                    BitField<0, 3, Swizzle> dst_x;
+                    BitField<4, 3, Swizzle> dst_y;
+                    BitField<8, 3, Swizzle> dst_z;
+                    BitField<12, 3, Swizzle> dst_w;
+                    BitField<16, 2, u32> component_size_minus_one;
+                    BitField<20, 2, u32> num_src_components_minus_one;
+                    BitField<24, 2, u32> num_dst_components_minus_one;
+
+                    /// Size in bytes of a single element when component remapping is enabled.
+                    u32 BytesPerElement() const {
+                        return (component_size_minus_one + 1) * (num_src_components_minus_one + 1);
+                    }
+                } swizzle_config;
 
                 Parameters dst_params;
 
@@ -132,6 +164,10 @@ private:
     /// Performs the copy from the source buffer to the destination buffer as configured in the
     /// registers.
     void HandleCopy();
+
+    /// Returns the size in bytes of the elements being copied, x_count and positions are given in
+    /// elements.
+    u32 GetBytesPerElement() const;
 };
 
 #define ASSERT_REG_POSITION(field_name, position)                                                  \
@@ -145,6 +181,9 @@ ASSERT_REG_POSITION(src_pitch, 0x104);
 ASSERT_REG_POSITION(dst_pitch, 0x105);
 ASSERT_REG_POSITION(x_count, 0x106);
 ASSERT_REG_POSITION(y_count, 0x107);
+ASSERT_REG_POSITION(const_a, 0x1C0);
+ASSERT_REG_POSITION(const_b, 0x1C1);
+ASSERT_REG_POSITION(swizzle_config, 0x1C2);
 ASSERT_REG_POSITION(dst_params, 0x1C3);
 ASSERT_REG_POSITION(src_params, 0x1CA);
 
@@ -4,9 +4,11 @@
 
 #pragma once
 
+#include <array>
 #include <bitset>
 #include <cstring>
 #include <map>
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -746,6 +748,10 @@ public:
             return mask;
         }
 
+        u16 GetExpected() const {
+            return expected;
+        }
+
         Id GetId() const {
             return id;
         }
@@ -773,16 +779,17 @@ public:
 
     static boost::optional<const Matcher&> Decode(Instruction instr) {
         static const auto table{GetDecodeTable()};
+        static const auto lookup{GetLookupTable(table)};
 
-        const auto matches_instruction = [instr](const auto& matcher) {
-            return matcher.Matches(static_cast<u16>(instr.opcode));
-        };
-
-        auto iter = std::find_if(table.begin(), table.end(), matches_instruction);
-        return iter != table.end() ? boost::optional<const Matcher&>(*iter) : boost::none;
+        const u16 index = (*lookup)[static_cast<u16>(instr.opcode)];
+        return index != NO_MATCHER ? boost::optional<const Matcher&>(table[index]) : boost::none;
     }
 
 private:
+    /// Index of the matcher of each opcode into the decode table
+    using LookupTable = std::array<u16, 0x10000>;
+    static constexpr u16 NO_MATCHER = 0xFFFF;
+
     struct Detail {
     private:
         static constexpr size_t opcode_bitsize = 16;
@@ -936,6 +943,32 @@ private:
 
         return table;
     }
+
+    /**
+     * Maps each 16-bit opcode to the first matcher of the decode table that matches it, so that
+     * decoding an instruction is a single lookup.
+     */
+    static std::unique_ptr<LookupTable> GetLookupTable(const std::vector<Matcher>& table) {
+        ASSERT(table.size() < NO_MATCHER);
+        auto lookup = std::make_unique<LookupTable>();
+        lookup->fill(NO_MATCHER);
+
+        // Only the opcodes a matcher matches are visited, by counting through the bits its mask
+        // ignores. Matchers earlier in the table take precedence, as they would when searching it.
+        for (std::size_t index = 0; index < table.size(); ++index) {
+            const Matcher& matcher = table[index];
+            const u16 free_bits = static_cast<u16>(~matcher.GetMask());
+            u16 bits = 0;
+            do {
+                u16& entry = (*lookup)[matcher.GetExpected() | bits];
+                if (entry == NO_MATCHER) {
+                    entry = static_cast<u16>(index);
+                }
+                bits = static_cast<u16>((bits - free_bits) & free_bits);
+            } while (bits != 0);
+        }
+        return lookup;
+    }
 };
 
 } // namespace Tegra::Shader
@@ -2,13 +2,19 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
+#include <cstring>
 #include "common/assert.h"
+#include "core/core.h"
+#include "core/settings.h"
 #include "video_core/engines/fermi_2d.h"
 #include "video_core/engines/maxwell_3d.h"
 #include "video_core/engines/maxwell_compute.h"
 #include "video_core/engines/maxwell_dma.h"
 #include "video_core/gpu.h"
+#include "video_core/gpu_thread.h"
 #include "video_core/rasterizer_interface.h"
+#include "video_core/renderer_base.h"
 
 namespace Tegra {
 
@@ -21,16 +27,90 @@ u32 FramebufferConfig::BytesPerPixel(PixelFormat format) {
     UNREACHABLE();
 }
 
-GPU::GPU(VideoCore::RasterizerInterface& rasterizer) {
+GPU::GPU(VideoCore::RendererBase& renderer)
+    : renderer{renderer}, rasterizer{renderer.Rasterizer()} {
     memory_manager = std::make_unique<MemoryManager>();
     maxwell_3d = std::make_unique<Engines::Maxwell3D>(rasterizer, *memory_manager);
-    fermi_2d = std::make_unique<Engines::Fermi2D>(*memory_manager);
-    maxwell_compute = std::make_unique<Engines::MaxwellCompute>();
+    fermi_2d = std::make_unique<Engines::Fermi2D>(rasterizer, *memory_manager);
+    maxwell_compute = std::make_unique<Engines::MaxwellCompute>(*memory_manager);
     maxwell_dma = std::make_unique<Engines::MaxwellDMA>(*memory_manager);
+
+    if (Settings::values.use_asynchronous_gpu_emulation) {
+        gpu_thread = std::make_unique<GPUThread>(Core::System::GetInstance(), renderer, *this);
+    }
 }
 
 GPU::~GPU() = default;
 
+void GPU::PushCommandLists(std::vector<CommandList> command_lists,
+                           std::function<void()> on_complete) {
+    if (gpu_thread) {
+        gpu_thread->SubmitCommandLists(std::move(command_lists), std::move(on_complete));
+        return;
+    }
+
+    ProcessCommandLists(command_lists);
+    if (on_complete) {
+        on_complete();
+    }
+}
+
+void GPU::SwapBuffers(boost::optional<const FramebufferConfig&> framebuffer) {
+    if (gpu_thread) {
+        gpu_thread->SwapBuffers(framebuffer);
+    } else {
+        renderer.SwapBuffers(framebuffer);
+    }
+}
+
+void GPU::FlushRegion(GPUVAddr addr, u64 size) {
+    // The GPU thread itself gets here through the memory it reads, e.g. when presenting a frame
+    if (gpu_thread && !IsGPUThread()) {
+        gpu_thread->FlushRegion(addr, size);
+    } else {
+        rasterizer.FlushRegion(addr, size);
+    }
+}
+
+void GPU::InvalidateRegion(GPUVAddr addr, u64 size) {
+    if (gpu_thread && !IsGPUThread()) {
+        gpu_thread->InvalidateRegion(addr, size);
+    } else {
+        rasterizer.InvalidateRegion(addr, size);
+    }
+}
+
+void GPU::FlushAndInvalidateRegion(GPUVAddr addr, u64 size) {
+    if (gpu_thread && !IsGPUThread()) {
+        gpu_thread->FlushAndInvalidateRegion(addr, size);
+    } else {
+        rasterizer.FlushAndInvalidateRegion(addr, size);
+    }
+}
+
+void GPU::WaitIdle() {
+    if (gpu_thread) {
+        gpu_thread->WaitIdle();
+    }
+}
+
+bool GPU::IsAsynchronous() const {
+    return gpu_thread != nullptr;
+}
+
+bool GPU::IsGPUThread() const {
+    return gpu_thread && gpu_thread->IsGPUThread();
+}
+
+void GPU::ProcessCommandLists(const std::vector<CommandList>& command_lists) {
+    const auto processing_begin = Core::PerfStats::Clock::now();
+    for (const auto& command_list : command_lists) {
+        ProcessCommandList(command_list.address, command_list.size);
+    }
+    Core::System::GetInstance().perf_stats.AddGpuTime(Core::PerfStats::Clock::now() -
+                                                      processing_begin);
+}
+
 const Engines::Maxwell3D& GPU::Maxwell3D() const {
     return *maxwell_3d;
 }
@@ -39,6 +119,64 @@ Engines::Maxwell3D& GPU::Maxwell3D() {
     return *maxwell_3d;
 }
 
+void GPU::IncrementSyncPoint(u32 syncpoint_id) {
+    ASSERT(syncpoint_id < NumSyncPoints);
+    syncpoints[syncpoint_id].fetch_add(1, std::memory_order_release);
+}
+
+u32 GPU::GetSyncPointValue(u32 syncpoint_id) const {
+    ASSERT(syncpoint_id < NumSyncPoints);
+    return syncpoints[syncpoint_id].load(std::memory_order_acquire);
+}
+
+bool GPU::IsSyncPointExpired(u32 syncpoint_id, u32 threshold) const {
+    // Syncpoint values wrap around, compare them the same way the hardware does.
+    return static_cast<s32>(GetSyncPointValue(syncpoint_id) - threshold) >= 0;
+}
+
+GPU::EngineState GPU::GetEngineState() const {
+    EngineState engine_state;
+    engine_state.bound_engines.assign(bound_engines.begin(), bound_engines.end());
+    engine_state.maxwell_3d_regs.assign(maxwell_3d->regs.reg_array.begin(),
+                                        maxwell_3d->regs.reg_array.end());
+    engine_state.maxwell_3d_state.resize(sizeof(Engines::Maxwell3D::State));
+    std::memcpy(engine_state.maxwell_3d_state.data(), &maxwell_3d->state,
+                sizeof(Engines::Maxwell3D::State));
+    engine_state.maxwell_3d_macros = maxwell_3d->GetUploadedMacros();
+    engine_state.fermi_2d_regs.assign(fermi_2d->regs.reg_array.begin(),
+                                      fermi_2d->regs.reg_array.end());
+    engine_state.maxwell_dma_regs.assign(maxwell_dma->regs.reg_array.begin(),
+                                         maxwell_dma->regs.reg_array.end());
+    return engine_state;
+}
+
+bool GPU::SetEngineState(const EngineState& engine_state) {
+    using Maxwell3DRegs = Engines::Maxwell3D::Regs;
+    if (engine_state.maxwell_3d_regs.size() != Maxwell3DRegs::NUM_REGS ||
+        engine_state.maxwell_3d_state.size() != sizeof(Engines::Maxwell3D::State) ||
+        engine_state.fermi_2d_regs.size() != Engines::Fermi2D::Regs::NUM_REGS ||
+        engine_state.maxwell_dma_regs.size() != Engines::MaxwellDMA::Regs::NUM_REGS) {
+        return false;
+    }
+
+    bound_engines.clear();
+    bound_engines.insert(engine_state.bound_engines.begin(), engine_state.bound_engines.end());
+
+    std::array<u32, Maxwell3DRegs::NUM_REGS> maxwell_3d_regs;
+    std::copy(engine_state.maxwell_3d_regs.begin(), engine_state.maxwell_3d_regs.end(),
+              maxwell_3d_regs.begin());
+    maxwell_3d->SetRegisters(maxwell_3d_regs);
+    std::memcpy(&maxwell_3d->state, engine_state.maxwell_3d_state.data(),
+                sizeof(Engines::Maxwell3D::State));
+    maxwell_3d->SetUploadedMacros(engine_state.maxwell_3d_macros);
+
+    std::copy(engine_state.fermi_2d_regs.begin(), engine_state.fermi_2d_regs.end(),
+              fermi_2d->regs.reg_array.begin());
+    std::copy(engine_state.maxwell_dma_regs.begin(), engine_state.maxwell_dma_regs.end(),
+              maxwell_dma->regs.reg_array.begin());
+    return true;
+}
+
 u32 RenderTargetBytesPerPixel(RenderTargetFormat format) {
     ASSERT(format != RenderTargetFormat::NONE);
 
@@ -4,15 +4,22 @@
 
 #pragma once
 
+#include <array>
+#include <atomic>
+#include <functional>
 #include <memory>
 #include <unordered_map>
+#include <utility>
+#include <vector>
+#include <boost/optional.hpp>
 #include "common/common_types.h"
 #include "core/hle/service/nvflinger/buffer_queue.h"
 #include "video_core/memory_manager.h"
 
 namespace VideoCore {
 class RasterizerInterface;
-}
+class RendererBase;
+} // namespace VideoCore
 
 namespace Tegra {
 
@@ -84,6 +91,9 @@ struct FramebufferConfig {
 
     VAddr address;
     u32 offset;
+    /// GPU address of the framebuffer's first pixel (offset included), 0 if it isn't mapped to
+    /// the GPU. Lets the renderer find the cached surface without translating addresses.
+    GPUVAddr gpu_address;
     u32 width;
     u32 height;
     u32 stride;
@@ -101,6 +111,14 @@ class MaxwellCompute;
 class MaxwellDMA;
 } // namespace Engines
 
+/// A command list in GPU memory, as pointed to by a GPFIFO entry.
+struct CommandList {
+    GPUVAddr address;
+    u32 size;
+};
+
+class GPUThread;
+
 enum class EngineID {
     FERMI_TWOD_A = 0x902D, // 2D Engine
     MAXWELL_B = 0xB197,    // 3D Engine
@@ -111,24 +129,109 @@ enum class EngineID {
 
 class GPU final {
 public:
-    explicit GPU(VideoCore::RasterizerInterface& rasterizer);
+    explicit GPU(VideoCore::RendererBase& renderer);
     ~GPU();
 
     /// Processes a command list stored at the specified address in GPU memory.
     void ProcessCommandList(GPUVAddr address, u32 size);
 
+    /**
+     * Processes a batch of command lists, then runs `on_complete`. With asynchronous GPU emulation
+     * this only queues them and returns, `on_complete` then runs on the GPU thread.
+     */
+    void PushCommandLists(std::vector<CommandList> command_lists,
+                          std::function<void()> on_complete);
+
+    /// Presents a frame, or only ends the emulated frame when there is none to present.
+    void SwapBuffers(boost::optional<const FramebufferConfig&> framebuffer);
+
+    /**
+     * Rasterizer cache operations requested by the CPU side. With asynchronous GPU emulation they
+     * run on the GPU thread, after the work queued before them, and the caller waits for them.
+     */
+    void FlushRegion(GPUVAddr addr, u64 size);
+    void InvalidateRegion(GPUVAddr addr, u64 size);
+    void FlushAndInvalidateRegion(GPUVAddr addr, u64 size);
+
+    /**
+     * Waits until the GPU thread is done with all the work queued so far. The CPU side must call
+     * this before it uses the rasterizer, the engines or the memory manager directly. Does
+     * nothing without asynchronous GPU emulation.
+     */
+    void WaitIdle();
+
+    /// Returns whether command lists are processed on a GPU thread of their own.
+    bool IsAsynchronous() const;
+
+    /// Returns whether the calling thread is the GPU thread, always false without one.
+    bool IsGPUThread() const;
+
     /// Returns a const reference to the Maxwell3D GPU engine.
     const Engines::Maxwell3D& Maxwell3D() const;
 
     /// Returns a reference to the Maxwell3D GPU engine.
     Engines::Maxwell3D& Maxwell3D();
 
+    /// Number of hardware syncpoints available to the host1x.
+    static constexpr u32 NumSyncPoints = 192;
+
+    /// Increments a syncpoint, signalling that the work submitted before it has completed.
+    void IncrementSyncPoint(u32 syncpoint_id);
+
+    /// Returns the current value of a syncpoint.
+    u32 GetSyncPointValue(u32 syncpoint_id) const;
+
+    /// Returns whether a syncpoint has reached the specified threshold.
+    bool IsSyncPointExpired(u32 syncpoint_id, u32 threshold) const;
+
+    /**
+     * Engine state that lives outside of guest memory: the registers of the engines, their
+     * subchannel bindings and the macros uploaded to the 3D engine. Captured between command
+     * lists to record and replay GPU work.
+     */
+    struct EngineState {
+        std::vector<std::pair<u32, EngineID>> bound_engines;
+        std::vector<u32> maxwell_3d_regs;
+        /// Raw bytes of Engines::Maxwell3D::State
+        std::vector<u8> maxwell_3d_state;
+        std::unordered_map<u32, std::vector<u32>> maxwell_3d_macros;
+        std::vector<u32> fermi_2d_regs;
+        std::vector<u32> maxwell_dma_regs;
+    };
+
+    /// Returns the current engine state, which must not be in the middle of a macro call.
+    EngineState GetEngineState() const;
+
+    /// Replaces the engine state, returning false if it doesn't match the layout of the engines.
+    bool SetEngineState(const EngineState& engine_state);
+
     std::unique_ptr<MemoryManager> memory_manager;
 
 private:
+    friend class GPUThread;
+
+    /// Processes command lists on the calling thread and reports the time spent to perf_stats
+    void ProcessCommandLists(const std::vector<CommandList>& command_lists);
+
+    VideoCore::RendererBase& renderer;
+    VideoCore::RasterizerInterface& rasterizer;
+
     /// Writes a single register in the engine bound to the specified subchannel
     void WriteReg(u32 method, u32 subchannel, u32 value, u32 remaining_params);
 
+    /**
+     * Writes the arguments of a single command header to the engine bound to the specified
+     * subchannel, letting the engine handle the whole run at once when it can.
+     */
+    void WriteRegBatch(u32 method, u32 subchannel, const u32* values, u32 count, bool increasing);
+
+    /// Current values of the hardware syncpoints. They are read from the service threads while
+    /// the GPU advances them, hence atomics.
+    std::array<std::atomic<u32>, NumSyncPoints> syncpoints{};
+
+    /// Scratch buffer holding the command list being processed.
+    std::vector<u32> command_buffer;
+
     /// Mapping of command subchannels to their bound engine ids.
     std::unordered_map<u32, EngineID> bound_engines;
 
@@ -140,6 +243,10 @@ private:
     std::unique_ptr<Engines::MaxwellCompute> maxwell_compute;
     /// DMA engine
     std::unique_ptr<Engines::MaxwellDMA> maxwell_dma;
+
+    /// Thread the command lists are processed on with asynchronous GPU emulation, null otherwise.
+    /// Destroyed first, it finishes the queued work with the engines above.
+    std::unique_ptr<GPUThread> gpu_thread;
 };
 
 } // namespace Tegra
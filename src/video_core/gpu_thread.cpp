@@ -0,0 +1,166 @@
+// Copyright 2018 yuzu Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <utility>
+#include "common/assert.h"
+#include "common/microprofile.h"
+#include "core/core.h"
+#include "video_core/gpu_thread.h"
+#include "video_core/rasterizer_interface.h"
+#include "video_core/renderer_base.h"
+
+namespace Tegra {
+
+MICROPROFILE_DEFINE(GPU_WaitThread, "GPU", "Wait for the GPU thread", MP_RGB(128, 128, 192));
+
+GPUThread::GPUThread(Core::System& system, VideoCore::RendererBase& renderer, GPU& gpu)
+    : system{system}, renderer{renderer}, gpu{gpu}, thread{&GPUThread::RunLoop, this} {}
+
+GPUThread::~GPUThread() {
+    // The work queued so far is finished first, its completions may still be waited on
+    PushCommand(EndProcessingCommand{});
+    thread.join();
+}
+
+void GPUThread::SubmitCommandLists(std::vector<CommandList> command_lists,
+                                   std::function<void()> on_complete) {
+    PushCommand(SubmitListCommand{std::move(command_lists), std::move(on_complete)});
+}
+
+void GPUThread::SwapBuffers(boost::optional<const FramebufferConfig&> framebuffer) {
+    u64 previous_swap_fence;
+    {
+        std::lock_guard<std::mutex> lock(push_mutex);
+        previous_swap_fence = last_swap_fence;
+    }
+
+    // The frame limiter runs on the GPU thread along with the presentation, the CPU is held back
+    // by never getting more than a frame ahead of it.
+    WaitForFence(previous_swap_fence);
+
+    boost::optional<FramebufferConfig> framebuffer_copy;
+    if (framebuffer) {
+        framebuffer_copy = *framebuffer;
+    }
+    const u64 fence = PushCommand(SwapBuffersCommand{std::move(framebuffer_copy)});
+
+    std::lock_guard<std::mutex> lock(push_mutex);
+    last_swap_fence = fence;
+}
+
+void GPUThread::FlushRegion(GPUVAddr addr, u64 size) {
+    // The CPU is about to read the region, it has to wait for the GPU to write it back
+    WaitForFence(PushCommand(FlushRegionCommand{addr, size}));
+}
+
+void GPUThread::InvalidateRegion(GPUVAddr addr, u64 size) {
+    // Invalidating writes back what the GPU rendered to the region first, which must not land on
+    // what the CPU is about to write to it
+    WaitForFence(PushCommand(InvalidateRegionCommand{addr, size}));
+}
+
+void GPUThread::FlushAndInvalidateRegion(GPUVAddr addr, u64 size) {
+    WaitForFence(PushCommand(FlushAndInvalidateRegionCommand{addr, size}));
+}
+
+void GPUThread::WaitIdle() {
+    u64 fence;
+    {
+        std::lock_guard<std::mutex> lock(push_mutex);
+        fence = last_fence;
+    }
+    WaitForFence(fence);
+}
+
+bool GPUThread::IsGPUThread() const {
+    return std::this_thread::get_id() == thread.get_id();
+}
+
+u64 GPUThread::PushCommand(CommandData data) {
+    ASSERT_MSG(!IsGPUThread(), "The GPU thread can't queue work for itself");
+
+    u64 fence;
+    {
+        std::lock_guard<std::mutex> lock(push_mutex);
+        fence = ++last_fence;
+        commands.Push(Command{std::move(data), fence});
+    }
+    command_event.Set();
+    return fence;
+}
+
+void GPUThread::WaitForFence(u64 fence) {
+    if (signaled_fence.load(std::memory_order_acquire) >= fence) {
+        return;
+    }
+
+    MICROPROFILE_SCOPE(GPU_WaitThread);
+    std::unique_lock<std::mutex> lock(signal_mutex);
+    signal_condvar.wait(lock, [this, fence] {
+        return signaled_fence.load(std::memory_order_relaxed) >= fence;
+    });
+}
+
+void GPUThread::RunLoop() {
+    // The engines and the rasterizer look up the system through the calling thread
+    system.MakeCurrent();
+    Common::SetCurrentThreadName("GPU");
+    MicroProfileOnThreadCreate("GPU");
+
+    Command command;
+    while (true) {
+        if (!commands.Pop(command)) {
+            command_event.Wait();
+            continue;
+        }
+
+        const bool keep_running = ExecuteCommand(command.data);
+        {
+            std::lock_guard<std::mutex> lock(signal_mutex);
+            signaled_fence.store(command.fence, std::memory_order_release);
+        }
+        signal_condvar.notify_all();
+
+        if (!keep_running) {
+            return;
+        }
+    }
+}
+
+bool GPUThread::ExecuteCommand(CommandData& data) {
+    if (std::holds_alternative<EndProcessingCommand>(data)) {
+        return false;
+    }
+
+    // The context is only held while a command runs, so the CPU side can take it once the GPU
+    // thread is idle
+    renderer.RunWithContext([this, &data] {
+        auto& rasterizer = renderer.Rasterizer();
+        if (auto* submit = std::get_if<SubmitListCommand>(&data)) {
+            gpu.ProcessCommandLists(submit->command_lists);
+            if (submit->on_complete) {
+                submit->on_complete();
+            }
+        } else if (const auto* swap = std::get_if<SwapBuffersCommand>(&data)) {
+            if (swap->framebuffer) {
+                renderer.SwapBuffers(*swap->framebuffer);
+            } else {
+                renderer.SwapBuffers({});
+            }
+        } else if (const auto* flush = std::get_if<FlushRegionCommand>(&data)) {
+            rasterizer.FlushRegion(flush->addr, flush->size);
+        } else if (const auto* invalidate = std::get_if<InvalidateRegionCommand>(&data)) {
+            rasterizer.InvalidateRegion(invalidate->addr, invalidate->size);
+        } else if (const auto* flush_and_invalidate =
+                       std::get_if<FlushAndInvalidateRegionCommand>(&data)) {
+            rasterizer.FlushAndInvalidateRegion(flush_and_invalidate->addr,
+                                                flush_and_invalidate->size);
+        } else {
+            UNREACHABLE();
+        }
+    });
+    return true;
+}
+
+} // namespace Tegra
@@ -0,0 +1,140 @@
+// Copyright 2018 yuzu Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <variant>
+#include <vector>
+#include <boost/optional.hpp>
+#include "common/common_types.h"
+#include "common/thread.h"
+#include "common/threadsafe_queue.h"
+#include "video_core/gpu.h"
+
+namespace Core {
+class System;
+}
+
+namespace VideoCore {
+class RendererBase;
+}
+
+namespace Tegra {
+
+/**
+ * Host thread the GPU processes its command lists on, with asynchronous GPU emulation. The CPU
+ * queues work for it through a lock-free single producer, single consumer queue and only waits
+ * for it when it needs the results: when it reads or writes memory the GPU cached, maps GPU
+ * memory, or gets more than a frame ahead. Every piece of work gets a fence, an increasing
+ * number the GPU thread publishes once it is done with it.
+ *
+ * The rasterizer is only used by this thread while it runs work, the CPU side only touches it
+ * after WaitIdle.
+ */
+class GPUThread final {
+public:
+    GPUThread(Core::System& system, VideoCore::RendererBase& renderer, GPU& gpu);
+    ~GPUThread();
+
+    /// Queues command lists, `on_complete` runs on the GPU thread once they are processed.
+    void SubmitCommandLists(std::vector<CommandList> command_lists,
+                            std::function<void()> on_complete);
+
+    /// Queues a frame for presentation, waiting for the previous one to be presented first.
+    void SwapBuffers(boost::optional<const FramebufferConfig&> framebuffer);
+
+    /// Flushes a region of the rasterizer cache, once the work queued before it is done.
+    void FlushRegion(GPUVAddr addr, u64 size);
+
+    /// Invalidates a region of the rasterizer cache, once the work queued before it is done.
+    void InvalidateRegion(GPUVAddr addr, u64 size);
+
+    /// Flushes and invalidates a region of the rasterizer cache, once the work queued before it is
+    /// done.
+    void FlushAndInvalidateRegion(GPUVAddr addr, u64 size);
+
+    /// Waits until the GPU thread is done with all the work queued so far.
+    void WaitIdle();
+
+    /// Returns whether the calling thread is the GPU thread.
+    bool IsGPUThread() const;
+
+private:
+    struct SubmitListCommand {
+        std::vector<CommandList> command_lists;
+        std::function<void()> on_complete;
+    };
+
+    struct SwapBuffersCommand {
+        boost::optional<FramebufferConfig> framebuffer;
+    };
+
+    struct FlushRegionCommand {
+        GPUVAddr addr;
+        u64 size;
+    };
+
+    struct InvalidateRegionCommand {
+        GPUVAddr addr;
+        u64 size;
+    };
+
+    struct FlushAndInvalidateRegionCommand {
+        GPUVAddr addr;
+        u64 size;
+    };
+
+    /// Asks the GPU thread to return once it reaches it.
+    struct EndProcessingCommand {};
+
+    using CommandData = std::variant<SubmitListCommand, SwapBuffersCommand, FlushRegionCommand,
+                                     InvalidateRegionCommand, FlushAndInvalidateRegionCommand,
+                                     EndProcessingCommand>;
+
+    struct Command {
+        CommandData data;
+        u64 fence;
+    };
+
+    /// Queues a command and wakes up the GPU thread, returns the fence of the command.
+    u64 PushCommand(CommandData data);
+
+    /// Waits until the GPU thread has published the fence.
+    void WaitForFence(u64 fence);
+
+    /// Runs the commands as they are queued, until it reaches an EndProcessingCommand.
+    void RunLoop();
+
+    /// Runs a single command, returns false if it was an EndProcessingCommand.
+    bool ExecuteCommand(CommandData& data);
+
+    Core::System& system;
+    VideoCore::RendererBase& renderer;
+    GPU& gpu;
+
+    /// Work queued for the GPU thread. The CPU cores may push to it concurrently, push_mutex
+    /// makes them a single producer and keeps the fences in the order of the queue.
+    Common::SPSCQueue<Command, false> commands;
+    std::mutex push_mutex;
+    /// Fence of the latest command queued, guarded by push_mutex.
+    u64 last_fence = 0;
+    /// Fence of the latest frame queued for presentation, guarded by push_mutex.
+    u64 last_swap_fence = 0;
+    /// Set whenever a command is queued, the GPU thread sleeps on it once the queue runs dry.
+    Common::Event command_event;
+
+    /// Fence of the latest command the GPU thread is done with.
+    std::atomic<u64> signaled_fence{0};
+    std::mutex signal_mutex;
+    std::condition_variable signal_condvar;
+
+    std::thread thread;
+};
+
+} // namespace Tegra
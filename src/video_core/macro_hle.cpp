@@ -0,0 +1,78 @@
+// Copyright 2018 yuzu Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <array>
+#include <utility>
+#include "common/assert.h"
+#include "common/hash.h"
+#include "video_core/engines/maxwell_3d.h"
+#include "video_core/macro_hle.h"
+#include "video_core/rasterizer_interface.h"
+
+namespace Tegra {
+
+const std::vector<u32> bind_constant_buffer_macro{
+    0x06380061, // maddr 0x18E0 (CB_SIZE, increment 1), send parm (size)
+    0x00000201, // r2 = parm (address high)
+    0x00001231, // send r2, r2 = parm (address low)
+    0x00001041, // send r2
+    0x18C04313, // r3 = (r1 & 7) << 3, the offset of the stage's CB_BIND
+    0x024118E1, // exit maddr r3 + 0x904 (CB_BIND[0]), send parm (bind config)
+    0x00000011, // nop
+};
+
+class HLEMacros {
+public:
+    static void BindConstantBuffer(Engines::Maxwell3D& maxwell3d,
+                                   const std::vector<u32>& parameters) {
+        using Regs = Engines::Maxwell3D::Regs;
+        ASSERT(parameters.size() == 5);
+
+        auto& regs = maxwell3d.regs;
+        const auto set_register = [&](u32 method, u32 value) {
+            regs.reg_array[method] = value;
+            maxwell3d.rasterizer.NotifyMaxwellRegisterChanged(method);
+        };
+        set_register(MAXWELL3D_REG_INDEX(const_buffer.cb_size), parameters[1]);
+        set_register(MAXWELL3D_REG_INDEX(const_buffer.cb_address_high), parameters[2]);
+        set_register(MAXWELL3D_REG_INDEX(const_buffer.cb_address_low), parameters[3]);
+
+        // The macro masks the stage to three bits, which can reach past the CB_BIND registers
+        const u32 stage = parameters[0] & 7;
+        const u32 bind_method = MAXWELL3D_REG_INDEX(cb_bind[0].raw_config) + stage * 8;
+        if (stage >= Regs::MaxShaderStage) {
+            maxwell3d.WriteReg(bind_method, parameters[4], 0);
+            return;
+        }
+        regs.reg_array[bind_method] = parameters[4];
+        maxwell3d.ProcessCBBind(static_cast<Regs::ShaderStage>(stage));
+        maxwell3d.rasterizer.NotifyMaxwellRegisterChanged(bind_method);
+    }
+};
+
+u64 GetMacroHash(const std::vector<u32>& code) {
+    return Common::ComputeHash64(code.data(), code.size() * sizeof(u32));
+}
+
+HLEMacroFunction GetHLEMacro(u64 code_hash) {
+    /**
+     * Macros with a native implementation, keyed by the hash of their code. An entry must
+     * reproduce every register write of the macro it replaces, as the rest of the engine can't
+     * tell the difference between the two.
+     */
+    static const std::array<std::pair<u64, HLEMacroFunction>, 1> hle_macros{{
+        {GetMacroHash(bind_constant_buffer_macro), &HLEMacros::BindConstantBuffer},
+    }};
+
+    const auto it =
+        std::find_if(hle_macros.begin(), hle_macros.end(),
+                     [code_hash](const auto& entry) { return entry.first == code_hash; });
+    if (it == hle_macros.end()) {
+        return nullptr;
+    }
+    return it->second;
+}
+
+} // namespace Tegra
@@ -0,0 +1,39 @@
+// Copyright 2018 yuzu Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <vector>
+#include "common/common_types.h"
+
+namespace Tegra {
+namespace Engines {
+class Maxwell3D;
+}
+
+/// Holds the native macro implementations. A friend of Maxwell3D, to run register side effects.
+class HLEMacros;
+
+/// Native implementation of a macro program, called with the parameters of the macro call
+using HLEMacroFunction = void (*)(Engines::Maxwell3D& maxwell3d,
+                                  const std::vector<u32>& parameters);
+
+/**
+ * Program of the bind constant buffer macro. It sets CB_SIZE, CB_ADDRESS_HIGH and CB_ADDRESS_LOW,
+ * then writes the CB_BIND register of a shader stage.
+ * Parameters: stage, size, address high, address low, bind config.
+ */
+extern const std::vector<u32> bind_constant_buffer_macro;
+
+/// Returns the hash identifying a macro program, as used by GetHLEMacro.
+u64 GetMacroHash(const std::vector<u32>& code);
+
+/**
+ * Looks up a native replacement for a macro program.
+ * @param code_hash Hash of the macro code, as returned by GetMacroHash.
+ * @returns The native implementation, or nullptr if the macro has to be interpreted.
+ */
+HLEMacroFunction GetHLEMacro(u64 code_hash);
+
+} // namespace Tegra
@@ -11,10 +11,12 @@ namespace Tegra {
 
 MacroInterpreter::MacroInterpreter(Engines::Maxwell3D& maxwell3d) : maxwell3d(maxwell3d) {}
 
-void MacroInterpreter::Execute(const std::vector<u32>& code, std::vector<u32> parameters) {
+void MacroInterpreter::Execute(const std::vector<u32>& code, std::vector<u32>& parameters) {
     Reset();
-    registers[1] = parameters[0];
-    this->parameters = std::move(parameters);
+    // Borrow the parameters for the duration of the call. Swapping them in, rather than copying
+    // or moving them, keeps both buffers allocated across macro calls.
+    this->parameters.swap(parameters);
+    registers[1] = this->parameters[0];
 
     // Execute the code until we hit an exit condition.
     bool keep_executing = true;
@@ -24,6 +26,8 @@ void MacroInterpreter::Execute(const std::vector<u32>& code, std::vector<u32> pa
 
     // Assert the the macro used all the input parameters
     ASSERT(next_parameter_index == this->parameters.size());
+
+    this->parameters.swap(parameters);
 }
 
 void MacroInterpreter::Reset() {
@@ -22,11 +22,12 @@ public:
     /**
      * Executes the macro code with the specified input parameters.
      * @param code The macro byte code to execute
-     * @param parameters The parameters of the macro
+     * @param parameters The parameters of the macro. They are handed back unchanged once the
+     * macro has finished executing.
      */
-    void Execute(const std::vector<u32>& code, std::vector<u32> parameters);
+    void Execute(const std::vector<u32>& code, std::vector<u32>& parameters);
 
-private:
+    // The instruction encoding, shared with the macro JIT
     enum class Operation : u32 {
         ALU = 0,
         AddImmediate = 1,
@@ -103,6 +104,10 @@ private:
         BitField<12, 6, u32> increment;
     };
 
+    /// Number of general purpose macro registers, the first of which always reads as zero.
+    static constexpr size_t NumMacroRegisters = 8;
+
+private:
     /// Resets the execution engine state, zeroing registers, etc.
     void Reset();
 
@@ -152,8 +157,6 @@ private:
     boost::optional<u32>
         delayed_pc; ///< Program counter to execute at after the delay slot is executed.
 
-    static constexpr size_t NumMacroRegisters = 8;
-
     /// General purpose macro registers.
     std::array<u32, NumMacroRegisters> registers = {};
 
@@ -0,0 +1,340 @@
+// Copyright 2018 yuzu Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <array>
+#include <cstddef>
+#include "common/assert.h"
+#include "common/logging/log.h"
+#include "common/x64/xbyak_abi.h"
+#include "common/x64/xbyak_util.h"
+#include "video_core/engines/maxwell_3d.h"
+#include "video_core/macro_jit_x64.h"
+
+namespace Tegra {
+
+using Operation = MacroInterpreter::Operation;
+using ALUOperation = MacroInterpreter::ALUOperation;
+using ResultOperation = MacroInterpreter::ResultOperation;
+using BranchCondition = MacroInterpreter::BranchCondition;
+
+namespace {
+
+/// Machine code bytes reserved per macro instruction, enough for one with its delay slot
+constexpr size_t MAX_CODE_SIZE_PER_INSTRUCTION = 256;
+
+/// State of a running macro, pointed to by STATE while the compiled code runs
+struct JITState {
+    Engines::Maxwell3D* maxwell3d;
+    std::array<u32, MacroInterpreter::NumMacroRegisters> registers;
+    MacroInterpreter::MethodAddress method_address;
+    const u32* parameters;
+    u32 parameter_count;
+    u32 next_parameter;
+};
+
+/// Host register holding the JITState pointer, preserved across calls
+const Xbyak::Reg64 STATE = Xbyak::util::rbx;
+/// Host register holding the result of the instruction being run, preserved across calls
+const Xbyak::Reg32 RESULT = Xbyak::util::r12d;
+
+const BitSet32 PERSISTENT_REGISTERS = Common::X64::BuildRegSet({STATE, Xbyak::util::r12});
+
+void SendHelper(JITState* state, u32 value) {
+    auto& method_address = state->method_address;
+    state->maxwell3d->WriteReg(method_address.address, value, 0);
+    // Increment the method address by the method increment.
+    method_address.address.Assign(method_address.address.Value() +
+                                  method_address.increment.Value());
+}
+
+u32 ReadHelper(const JITState* state, u32 method) {
+    return state->maxwell3d->GetRegisterValue(method);
+}
+
+} // Anonymous namespace
+
+MacroJITx64::MacroJITx64(Engines::Maxwell3D& maxwell3d, const std::vector<u32>& code)
+    : Xbyak::CodeGenerator(0x100 + code.size() * MAX_CODE_SIZE_PER_INSTRUCTION),
+      maxwell3d(maxwell3d) {
+    try {
+        if (Compile(code)) {
+            program = getCode<ProgramType>();
+        }
+    } catch (const Xbyak::Error& error) {
+        LOG_ERROR(HW_GPU, "Failed to compile a macro of {} instructions: {}", code.size(),
+                  error.what());
+    }
+}
+
+bool MacroJITx64::IsCompiled() const {
+    return program != nullptr;
+}
+
+void MacroJITx64::Execute(const std::vector<u32>& parameters) const {
+    ASSERT(IsCompiled());
+
+    JITState state{};
+    state.maxwell3d = &maxwell3d;
+    state.registers[1] = parameters[0];
+    state.parameters = parameters.data();
+    state.parameter_count = static_cast<u32>(parameters.size());
+    // $r1 already has the value of the first parameter, as in the interpreter
+    state.next_parameter = 1;
+
+    program(&state);
+
+    // Assert that the macro used all the input parameters
+    ASSERT(state.next_parameter == parameters.size());
+}
+
+bool MacroJITx64::Compile(const std::vector<u32>& code) {
+    // One label per instruction, as every one of them can be a branch target
+    std::vector<Xbyak::Label> labels(code.size());
+    Xbyak::Label end;
+
+    Common::X64::ABI_PushRegistersAndAdjustStack(*this, PERSISTENT_REGISTERS, 8);
+    mov(STATE, Common::X64::ABI_PARAM1);
+
+    for (size_t index = 0; index < code.size(); ++index) {
+        L(labels[index]);
+        const Opcode opcode{code[index]};
+
+        // The instruction in the delay slot of a branch or exit, if it can run there
+        const bool has_delay_slot = index + 1 < code.size();
+        const Opcode delay_slot{has_delay_slot ? code[index + 1] : 0};
+        const bool is_valid_delay_slot = has_delay_slot &&
+                                         delay_slot.operation != Operation::Branch &&
+                                         !delay_slot.is_exit;
+
+        if (opcode.operation == Operation::Branch) {
+            // A branch that is also an exit only exits when it isn't taken
+            if (opcode.is_exit) {
+                return false;
+            }
+            const s64 target = static_cast<s64>(index) + opcode.immediate;
+            if (target < 0 || target >= static_cast<s64>(code.size())) {
+                return false;
+            }
+
+            LoadRegister(eax, opcode.src_a);
+            test(eax, eax);
+            const bool branch_if_zero = opcode.branch_condition == BranchCondition::Zero;
+            if (opcode.branch_annul) {
+                // The delay slot only runs when the branch isn't taken, as the next instruction
+                if (branch_if_zero) {
+                    jz(labels[target], T_NEAR);
+                } else {
+                    jnz(labels[target], T_NEAR);
+                }
+                continue;
+            }
+
+            // When the branch isn't taken, the delay slot runs anyway as the next instruction.
+            // Otherwise it runs here, before jumping to the target.
+            if (!is_valid_delay_slot) {
+                return false;
+            }
+            if (branch_if_zero) {
+                jnz(labels[index + 1], T_NEAR);
+            } else {
+                jz(labels[index + 1], T_NEAR);
+            }
+            if (!CompileOperation(delay_slot)) {
+                return false;
+            }
+            jmp(labels[target], T_NEAR);
+            continue;
+        }
+
+        if (!CompileOperation(opcode)) {
+            return false;
+        }
+
+        if (opcode.is_exit) {
+            // Exit has a delay slot, execute the next instruction
+            if (!is_valid_delay_slot || !CompileOperation(delay_slot)) {
+                return false;
+            }
+            jmp(end, T_NEAR);
+        }
+    }
+
+    // Running past the end of the code would be invalid, stop there instead
+    L(end);
+    Common::X64::ABI_PopRegistersAndAdjustStack(*this, PERSISTENT_REGISTERS, 8);
+    ret();
+    return true;
+}
+
+bool MacroJITx64::CompileOperation(Opcode opcode) {
+    switch (opcode.operation) {
+    case Operation::ALU: {
+        LoadRegister(eax, opcode.src_a);
+        LoadRegister(ecx, opcode.src_b);
+        switch (opcode.alu_operation) {
+        case ALUOperation::Add:
+            add(eax, ecx);
+            break;
+        case ALUOperation::Subtract:
+            sub(eax, ecx);
+            break;
+        case ALUOperation::Xor:
+            xor_(eax, ecx);
+            break;
+        case ALUOperation::Or:
+            or_(eax, ecx);
+            break;
+        case ALUOperation::And:
+            and_(eax, ecx);
+            break;
+        case ALUOperation::AndNot:
+            not_(ecx);
+            and_(eax, ecx);
+            break;
+        case ALUOperation::Nand:
+            and_(eax, ecx);
+            not_(eax);
+            break;
+        default:
+            // The carry and borrow operations aren't implemented by the interpreter either
+            LOG_DEBUG(HW_GPU, "Can't compile ALU operation {}",
+                      static_cast<u32>(opcode.alu_operation.Value()));
+            return false;
+        }
+        break;
+    }
+    case Operation::AddImmediate: {
+        LoadRegister(eax, opcode.src_a);
+        add(eax, static_cast<u32>(opcode.immediate.Value()));
+        break;
+    }
+    case Operation::ExtractInsert: {
+        const u32 mask = opcode.GetBitfieldMask();
+        LoadRegister(ecx, opcode.src_b);
+        shr(ecx, static_cast<int>(opcode.bf_src_bit.Value()));
+        and_(ecx, mask);
+        shl(ecx, static_cast<int>(opcode.bf_dst_bit.Value()));
+        LoadRegister(eax, opcode.src_a);
+        and_(eax, ~(mask << opcode.bf_dst_bit));
+        or_(eax, ecx);
+        break;
+    }
+    case Operation::ExtractShiftLeftImmediate: {
+        LoadRegister(ecx, opcode.src_a);
+        LoadRegister(eax, opcode.src_b);
+        shr(eax, cl);
+        and_(eax, opcode.GetBitfieldMask());
+        shl(eax, static_cast<int>(opcode.bf_dst_bit.Value()));
+        break;
+    }
+    case Operation::ExtractShiftLeftRegister: {
+        LoadRegister(ecx, opcode.src_a);
+        LoadRegister(eax, opcode.src_b);
+        shr(eax, static_cast<int>(opcode.bf_src_bit.Value()));
+        and_(eax, opcode.GetBitfieldMask());
+        shl(eax, cl);
+        break;
+    }
+    case Operation::Read: {
+        LoadRegister(eax, opcode.src_a);
+        add(eax, static_cast<u32>(opcode.immediate.Value()));
+        mov(Common::X64::ABI_PARAM2.cvt32(), eax);
+        mov(Common::X64::ABI_PARAM1, STATE);
+        Common::X64::CallFarFunction(*this, &ReadHelper);
+        break;
+    }
+    default:
+        LOG_DEBUG(HW_GPU, "Can't compile macro operation {}",
+                  static_cast<u32>(opcode.operation.Value()));
+        return false;
+    }
+
+    mov(RESULT, eax);
+    CompileResult(opcode.result_operation, opcode.dst);
+    return true;
+}
+
+void MacroJITx64::CompileResult(ResultOperation operation, u32 reg) {
+    const auto set_method_address = [this] {
+        mov(dword[STATE + offsetof(JITState, method_address)], RESULT);
+    };
+
+    switch (operation) {
+    case ResultOperation::IgnoreAndFetch:
+        FetchParameter();
+        StoreRegister(reg, ecx);
+        break;
+    case ResultOperation::Move:
+        StoreRegister(reg, RESULT);
+        break;
+    case ResultOperation::MoveAndSetMethod:
+        StoreRegister(reg, RESULT);
+        set_method_address();
+        break;
+    case ResultOperation::FetchAndSend:
+        FetchParameter();
+        StoreRegister(reg, ecx);
+        Send(RESULT);
+        break;
+    case ResultOperation::MoveAndSend:
+        StoreRegister(reg, RESULT);
+        Send(RESULT);
+        break;
+    case ResultOperation::FetchAndSetMethod:
+        FetchParameter();
+        StoreRegister(reg, ecx);
+        set_method_address();
+        break;
+    case ResultOperation::MoveAndSetMethodFetchAndSend:
+        StoreRegister(reg, RESULT);
+        set_method_address();
+        FetchParameter();
+        Send(ecx);
+        break;
+    case ResultOperation::MoveAndSetMethodSend:
+        // Sends bits 12:17 of the result
+        StoreRegister(reg, RESULT);
+        set_method_address();
+        mov(ecx, RESULT);
+        shr(ecx, 12);
+        and_(ecx, 0b111111);
+        Send(ecx);
+        break;
+    }
+}
+
+void MacroJITx64::LoadRegister(const Xbyak::Reg32& dest, u32 reg) {
+    // Register 0 is always zero, and is never written
+    mov(dest, dword[STATE + offsetof(JITState, registers) + reg * sizeof(u32)]);
+}
+
+void MacroJITx64::StoreRegister(u32 reg, const Xbyak::Reg32& src) {
+    if (reg == 0) {
+        return;
+    }
+    mov(dword[STATE + offsetof(JITState, registers) + reg * sizeof(u32)], src);
+}
+
+void MacroJITx64::FetchParameter() {
+    Xbyak::Label out_of_parameters, done;
+    mov(eax, dword[STATE + offsetof(JITState, next_parameter)]);
+    cmp(eax, dword[STATE + offsetof(JITState, parameter_count)]);
+    jae(out_of_parameters);
+    mov(rdx, qword[STATE + offsetof(JITState, parameters)]);
+    mov(ecx, dword[rdx + rax * 4]);
+    add(dword[STATE + offsetof(JITState, next_parameter)], 1);
+    jmp(done);
+    // Execute asserts that every parameter was fetched exactly once, which catches this case
+    L(out_of_parameters);
+    xor_(ecx, ecx);
+    L(done);
+}
+
+void MacroJITx64::Send(const Xbyak::Reg32& value) {
+    mov(Common::X64::ABI_PARAM2.cvt32(), value);
+    mov(Common::X64::ABI_PARAM1, STATE);
+    Common::X64::CallFarFunction(*this, &SendHelper);
+}
+
+} // namespace Tegra
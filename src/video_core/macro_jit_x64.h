@@ -0,0 +1,62 @@
+// Copyright 2018 yuzu Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <vector>
+#include <xbyak.h>
+#include "common/common_types.h"
+#include "video_core/macro_interpreter.h"
+
+namespace Tegra {
+namespace Engines {
+class Maxwell3D;
+}
+
+/**
+ * Compiles a macro program to x86-64 code. Programs using encodings the JIT doesn't handle, such
+ * as a branch in a delay slot, are left uncompiled so that the interpreter runs them instead.
+ */
+class MacroJITx64 final : private Xbyak::CodeGenerator {
+public:
+    MacroJITx64(Engines::Maxwell3D& maxwell3d, const std::vector<u32>& code);
+
+    /// Returns whether the program was compiled. Execute may only be called if it was.
+    bool IsCompiled() const;
+
+    /// Runs the compiled program with the specified input parameters, like
+    /// MacroInterpreter::Execute.
+    void Execute(const std::vector<u32>& parameters) const;
+
+private:
+    using Opcode = MacroInterpreter::Opcode;
+
+    /// Emits the whole program. Returns false if it uses an encoding the JIT can't compile.
+    bool Compile(const std::vector<u32>& code);
+
+    /// Emits a non-branch instruction, without its exit. Returns false if it can't be compiled.
+    bool CompileOperation(Opcode opcode);
+
+    /// Emits the result operation of an instruction, whose result is in the result register.
+    void CompileResult(MacroInterpreter::ResultOperation operation, u32 reg);
+
+    /// Emits a load of a macro register into a host register.
+    void LoadRegister(const Xbyak::Reg32& dest, u32 reg);
+
+    /// Emits a store to a macro register, writes to the zero register are dropped.
+    void StoreRegister(u32 reg, const Xbyak::Reg32& src);
+
+    /// Emits a fetch of the next parameter into the ecx register.
+    void FetchParameter();
+
+    /// Emits a Send of the value in a host register to the current method address.
+    void Send(const Xbyak::Reg32& value);
+
+    Engines::Maxwell3D& maxwell3d;
+
+    using ProgramType = void (*)(void* state);
+    ProgramType program = nullptr;
+};
+
+} // namespace Tegra
@@ -2,6 +2,7 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
 #include "common/alignment.h"
 #include "common/assert.h"
 #include "video_core/memory_manager.h"
@@ -37,53 +38,45 @@ GPUVAddr MemoryManager::MapBufferEx(VAddr cpu_addr, u64 size) {
     boost::optional<GPUVAddr> gpu_addr = FindFreeBlock(size, PAGE_SIZE);
     ASSERT(gpu_addr);
 
-    for (u64 offset = 0; offset < size; offset += PAGE_SIZE) {
-        VAddr& slot = PageSlot(*gpu_addr + offset);
-
-        ASSERT(slot == static_cast<u64>(PageStatus::Unmapped));
-        slot = cpu_addr + offset;
-    }
-
-    MappedRegion region{cpu_addr, *gpu_addr, size};
-    mapped_regions.push_back(region);
-
+    MapPages(*gpu_addr, cpu_addr, size, PageStatus::Unmapped);
     return *gpu_addr;
 }
 
 GPUVAddr MemoryManager::MapBufferEx(VAddr cpu_addr, GPUVAddr gpu_addr, u64 size) {
     ASSERT((gpu_addr & PAGE_MASK) == 0);
 
-    for (u64 offset = 0; offset < size; offset += PAGE_SIZE) {
-        VAddr& slot = PageSlot(gpu_addr + offset);
-
-        ASSERT(slot == static_cast<u64>(PageStatus::Allocated));
-        slot = cpu_addr + offset;
-    }
-
-    MappedRegion region{cpu_addr, gpu_addr, size};
-    mapped_regions.push_back(region);
-
+    MapPages(gpu_addr, cpu_addr, size, PageStatus::Allocated);
     return gpu_addr;
 }
 
 GPUVAddr MemoryManager::UnmapBuffer(GPUVAddr gpu_addr, u64 size) {
     ASSERT((gpu_addr & PAGE_MASK) == 0);
 
+    // The range may have been mapped by several calls, remove each contiguous run of it from the
+    // reverse mapping at once
+    GPUVAddr run_gpu_addr = gpu_addr;
+    VAddr run_cpu_addr = 0;
+    u64 run_size = 0;
     for (u64 offset = 0; offset < size; offset += PAGE_SIZE) {
         VAddr& slot = PageSlot(gpu_addr + offset);
 
         ASSERT(slot != static_cast<u64>(PageStatus::Allocated) &&
                slot != static_cast<u64>(PageStatus::Unmapped));
+        if (run_size != 0 && slot != run_cpu_addr + run_size) {
+            UnmapReverseRange(run_gpu_addr, run_cpu_addr, run_size);
+            run_size = 0;
+        }
+        if (run_size == 0) {
+            run_gpu_addr = gpu_addr + offset;
+            run_cpu_addr = slot;
+        }
+        run_size += PAGE_SIZE;
         slot = static_cast<u64>(PageStatus::Unmapped);
     }
+    if (run_size != 0) {
+        UnmapReverseRange(run_gpu_addr, run_cpu_addr, run_size);
+    }
 
-    // Delete the region mappings that are contained within the unmapped region
-    mapped_regions.erase(std::remove_if(mapped_regions.begin(), mapped_regions.end(),
-                                        [&](const MappedRegion& region) {
-                                            return region.gpu_addr <= gpu_addr &&
-                                                   region.gpu_addr + region.size < gpu_addr + size;
-                                        }),
-                         mapped_regions.end());
     return gpu_addr;
 }
 
@@ -93,7 +86,15 @@ boost::optional<GPUVAddr> MemoryManager::FindFreeBlock(u64 size, u64 align) {
     align = (align + PAGE_MASK) & ~PAGE_MASK;
 
     while (gpu_addr + free_space < MAX_ADDRESS) {
-        if (!IsPageMapped(gpu_addr + free_space)) {
+        const GPUVAddr page_addr = gpu_addr + free_space;
+        if (!page_table[(page_addr >> (PAGE_BITS + PAGE_BLOCK_BITS)) & PAGE_TABLE_MASK]) {
+            // Blocks are only created when one of their pages is used, skip over the whole block
+            const u64 block_size = PAGE_SIZE << PAGE_BLOCK_BITS;
+            free_space += block_size - (page_addr & (block_size - 1));
+            if (free_space >= size) {
+                return gpu_addr;
+            }
+        } else if (!IsPageMapped(page_addr)) {
             free_space += PAGE_SIZE;
             if (free_space >= size) {
                 return gpu_addr;
@@ -108,8 +109,8 @@ boost::optional<GPUVAddr> MemoryManager::FindFreeBlock(u64 size, u64 align) {
     return {};
 }
 
-boost::optional<VAddr> MemoryManager::GpuToCpuAddress(GPUVAddr gpu_addr) {
-    VAddr base_addr = PageSlot(gpu_addr);
+boost::optional<VAddr> MemoryManager::GpuToCpuAddress(GPUVAddr gpu_addr) const {
+    const VAddr base_addr = GetPageEntry(gpu_addr);
 
     if (base_addr == static_cast<u64>(PageStatus::Allocated) ||
         base_addr == static_cast<u64>(PageStatus::Unmapped)) {
@@ -121,21 +122,84 @@ boost::optional<VAddr> MemoryManager::GpuToCpuAddress(GPUVAddr gpu_addr) {
 
 std::vector<GPUVAddr> MemoryManager::CpuToGpuAddress(VAddr cpu_addr) const {
     std::vector<GPUVAddr> results;
-    for (const auto& region : mapped_regions) {
-        if (cpu_addr >= region.cpu_addr && cpu_addr < (region.cpu_addr + region.size)) {
-            u64 offset = cpu_addr - region.cpu_addr;
-            results.push_back(region.gpu_addr + offset);
+
+    const auto it = reverse_map.find(cpu_addr);
+    if (it != reverse_map.end()) {
+        for (const u64 gpu_offset : it->second) {
+            results.push_back(cpu_addr + gpu_offset);
         }
     }
     return results;
 }
 
-bool MemoryManager::IsPageMapped(GPUVAddr gpu_addr) {
-    return PageSlot(gpu_addr) != static_cast<u64>(PageStatus::Unmapped);
+std::vector<MemoryManager::MappedRange> MemoryManager::GetMappedRanges() const {
+    std::vector<MappedRange> ranges;
+    for (u64 block_index = 0; block_index < PAGE_TABLE_SIZE; ++block_index) {
+        if (!page_table[block_index]) {
+            continue;
+        }
+
+        const PageBlock& block = *page_table[block_index];
+        for (u64 slot_index = 0; slot_index < PAGE_BLOCK_SIZE; ++slot_index) {
+            const VAddr cpu_addr = block[slot_index];
+            if (cpu_addr == static_cast<u64>(PageStatus::Allocated) ||
+                cpu_addr == static_cast<u64>(PageStatus::Unmapped)) {
+                continue;
+            }
+
+            const GPUVAddr gpu_addr = ((block_index << PAGE_BLOCK_BITS) | slot_index) << PAGE_BITS;
+            if (!ranges.empty()) {
+                MappedRange& last = ranges.back();
+                if (last.gpu_addr + last.size == gpu_addr &&
+                    last.cpu_addr + last.size == cpu_addr) {
+                    last.size += PAGE_SIZE;
+                    continue;
+                }
+            }
+            ranges.push_back({gpu_addr, cpu_addr, PAGE_SIZE});
+        }
+    }
+    return ranges;
+}
+
+void MemoryManager::MapPages(GPUVAddr gpu_addr, VAddr cpu_addr, u64 size, PageStatus status) {
+    const u64 mapped_size = Common::AlignUp(size, PAGE_SIZE);
+
+    GPUVAddr page_addr = gpu_addr;
+    const GPUVAddr end_addr = gpu_addr + mapped_size;
+    while (page_addr < end_addr) {
+        // The slots of a block are contiguous, fill them without looking the block up again
+        VAddr* const slots = &PageSlot(page_addr);
+        const u64 first_slot = (page_addr >> PAGE_BITS) & PAGE_BLOCK_MASK;
+        const u64 num_slots =
+            std::min<u64>(PAGE_BLOCK_SIZE - first_slot, (end_addr - page_addr) >> PAGE_BITS);
+        const VAddr block_cpu_addr = cpu_addr + (page_addr - gpu_addr);
+        for (u64 i = 0; i < num_slots; ++i) {
+            ASSERT(slots[i] == static_cast<u64>(status));
+            slots[i] = block_cpu_addr + (i << PAGE_BITS);
+        }
+        page_addr += num_slots << PAGE_BITS;
+    }
+
+    MapReverseRange(gpu_addr, cpu_addr, mapped_size);
+}
+
+void MemoryManager::MapReverseRange(GPUVAddr gpu_addr, VAddr cpu_addr, u64 size) {
+    reverse_map.add({ReverseMap::interval_type::right_open(cpu_addr, cpu_addr + size),
+                     std::set<u64>{gpu_addr - cpu_addr}});
+}
+
+void MemoryManager::UnmapReverseRange(GPUVAddr gpu_addr, VAddr cpu_addr, u64 size) {
+    reverse_map.subtract({ReverseMap::interval_type::right_open(cpu_addr, cpu_addr + size),
+                          std::set<u64>{gpu_addr - cpu_addr}});
+}
+
+bool MemoryManager::IsPageMapped(GPUVAddr gpu_addr) const {
+    return GetPageEntry(gpu_addr) != static_cast<u64>(PageStatus::Unmapped);
 }
 
 VAddr& MemoryManager::PageSlot(GPUVAddr gpu_addr) {
-    auto& block = page_table[(gpu_addr >> (PAGE_BITS + PAGE_TABLE_BITS)) & PAGE_TABLE_MASK];
+    auto& block = page_table[(gpu_addr >> (PAGE_BITS + PAGE_BLOCK_BITS)) & PAGE_TABLE_MASK];
     if (!block) {
         block = std::make_unique<PageBlock>();
         block->fill(static_cast<VAddr>(PageStatus::Unmapped));
@@ -143,4 +207,12 @@ VAddr& MemoryManager::PageSlot(GPUVAddr gpu_addr) {
     return (*block)[(gpu_addr >> PAGE_BITS) & PAGE_BLOCK_MASK];
 }
 
+VAddr MemoryManager::GetPageEntry(GPUVAddr gpu_addr) const {
+    const auto& block = page_table[(gpu_addr >> (PAGE_BITS + PAGE_BLOCK_BITS)) & PAGE_TABLE_MASK];
+    if (!block) {
+        return static_cast<VAddr>(PageStatus::Unmapped);
+    }
+    return (*block)[(gpu_addr >> PAGE_BITS) & PAGE_BLOCK_MASK];
+}
+
 } // namespace Tegra
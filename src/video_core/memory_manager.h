@@ -6,8 +6,10 @@
 
 #include <array>
 #include <memory>
+#include <set>
 #include <vector>
 
+#include <boost/icl/interval_map.hpp>
 #include <boost/optional.hpp>
 
 #include "common/common_types.h"
@@ -26,23 +28,42 @@ public:
     GPUVAddr MapBufferEx(VAddr cpu_addr, u64 size);
     GPUVAddr MapBufferEx(VAddr cpu_addr, GPUVAddr gpu_addr, u64 size);
     GPUVAddr UnmapBuffer(GPUVAddr gpu_addr, u64 size);
-    boost::optional<VAddr> GpuToCpuAddress(GPUVAddr gpu_addr);
+    boost::optional<VAddr> GpuToCpuAddress(GPUVAddr gpu_addr) const;
     std::vector<GPUVAddr> CpuToGpuAddress(VAddr cpu_addr) const;
 
+    /// A GPU range backed by contiguous CPU memory.
+    struct MappedRange {
+        GPUVAddr gpu_addr;
+        VAddr cpu_addr;
+        u64 size;
+    };
+
+    /// Returns every mapped GPU range in increasing address order, contiguous mappings merged.
+    std::vector<MappedRange> GetMappedRanges() const;
+
     static constexpr u64 PAGE_BITS = 16;
     static constexpr u64 PAGE_SIZE = 1 << PAGE_BITS;
     static constexpr u64 PAGE_MASK = PAGE_SIZE - 1;
 
 private:
-    boost::optional<GPUVAddr> FindFreeBlock(u64 size, u64 align = 1);
-    bool IsPageMapped(GPUVAddr gpu_addr);
-    VAddr& PageSlot(GPUVAddr gpu_addr);
-
     enum class PageStatus : u64 {
         Unmapped = 0xFFFFFFFFFFFFFFFFULL,
         Allocated = 0xFFFFFFFFFFFFFFFEULL,
     };
 
+    boost::optional<GPUVAddr> FindFreeBlock(u64 size, u64 align = 1);
+    bool IsPageMapped(GPUVAddr gpu_addr) const;
+    VAddr& PageSlot(GPUVAddr gpu_addr);
+    /// Returns the page table entry of a GPU page, without allocating its block.
+    VAddr GetPageEntry(GPUVAddr gpu_addr) const;
+
+    /// Maps the pages of a GPU range to contiguous CPU memory, expecting them to be in `status`.
+    void MapPages(GPUVAddr gpu_addr, VAddr cpu_addr, u64 size, PageStatus status);
+    /// Adds a GPU range backed by contiguous CPU memory to the reverse mapping.
+    void MapReverseRange(GPUVAddr gpu_addr, VAddr cpu_addr, u64 size);
+    /// Removes a GPU range backed by contiguous CPU memory from the reverse mapping.
+    void UnmapReverseRange(GPUVAddr gpu_addr, VAddr cpu_addr, u64 size);
+
     static constexpr u64 MAX_ADDRESS{0x10000000000ULL};
     static constexpr u64 PAGE_TABLE_BITS{10};
     static constexpr u64 PAGE_TABLE_SIZE{1 << PAGE_TABLE_BITS};
@@ -50,17 +71,19 @@ private:
     static constexpr u64 PAGE_BLOCK_BITS{14};
     static constexpr u64 PAGE_BLOCK_SIZE{1 << PAGE_BLOCK_BITS};
     static constexpr u64 PAGE_BLOCK_MASK{PAGE_BLOCK_SIZE - 1};
+    static_assert(MAX_ADDRESS == 1ULL << (PAGE_BITS + PAGE_BLOCK_BITS + PAGE_TABLE_BITS),
+                  "The page table must cover the whole GPU address space");
 
     using PageBlock = std::array<VAddr, PAGE_BLOCK_SIZE>;
     std::array<std::unique_ptr<PageBlock>, PAGE_TABLE_SIZE> page_table{};
 
-    struct MappedRegion {
-        VAddr cpu_addr;
-        GPUVAddr gpu_addr;
-        u64 size;
-    };
-
-    std::vector<MappedRegion> mapped_regions;
+    /**
+     * Reverse mapping from CPU memory to the GPU ranges it backs. Each CPU interval holds the
+     * offsets, modulo 2^64, that take its addresses to the GPU addresses they are mapped at. A
+     * mapping is a single interval however many pages it spans.
+     */
+    using ReverseMap = boost::icl::interval_map<VAddr, std::set<u64>>;
+    ReverseMap reverse_map;
 };
 
 } // namespace Tegra
@@ -0,0 +1,30 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <boost/icl/interval_map.hpp>
+#include "common/common_types.h"
+#include "video_core/memory_manager.h"
+
+namespace VideoCore {
+
+/**
+ * Counts how many cached resources live on each GPU page and marks the pages as cached in the
+ * memory system while that count is non-zero. Every cache of a rasterizer has to go through the
+ * same instance, otherwise one cache dropping its last resource on a page would unmark the page
+ * under the resources another cache still keeps there.
+ */
+class RasterizerCachedPages final {
+public:
+    /// Increase/decrease the number of cached resources in pages touching the specified region
+    void UpdateCount(Tegra::GPUVAddr addr, u64 size, int delta);
+
+private:
+    using PageMap = boost::icl::interval_map<u64, int>;
+
+    PageMap cached_pages;
+};
+
+} // namespace VideoCore
@@ -4,12 +4,19 @@
 
 #pragma once
 
+#include <vector>
 #include "common/common_types.h"
+#include "video_core/engines/fermi_2d.h"
 #include "video_core/gpu.h"
 #include "video_core/memory_manager.h"
 
 namespace VideoCore {
 
+/// Counters of the guest GPU that are backed by host queries
+enum class QueryType {
+    SamplesPassed,
+};
+
 class RasterizerInterface {
 public:
     virtual ~RasterizerInterface() {}
@@ -26,6 +33,29 @@ public:
     /// Notify rasterizer that all caches should be flushed to Switch memory
     virtual void FlushAll() = 0;
 
+    /// Issues the work deferred by the rasterizer, e.g. draws it is still batching. Called before
+    /// anything but the 3D engine may access the memory that work renders to.
+    virtual void FlushCommands() {}
+
+    /// Resets a counter of the guest GPU to zero
+    virtual void ResetCounter(QueryType type) = 0;
+
+    /**
+     * Queries the current value of a counter. The value is written to the given address once the
+     * host GPU has produced it, either as a 32-bit value or as a long query result.
+     */
+    virtual void Query(Tegra::GPUVAddr addr, QueryType type, bool long_query) = 0;
+
+    /// Notify rasterizer that a frame has been presented, caches may be trimmed at this point
+    virtual void TickFrame() {}
+
+    /// Loads the resources cached on disk for the title that was just loaded
+    virtual void LoadDiskResources() {}
+
+    /// Drops everything cached from the memory of the guest before it's torn down for a restart.
+    /// Host objects that don't depend on it, e.g. compiled shaders, are kept for the next guest.
+    virtual void ResetGuestState() {}
+
     /// Notify rasterizer that any caches of the specified region should be flushed to Switch memory
     virtual void FlushRegion(Tegra::GPUVAddr addr, u64 size) = 0;
 
@@ -46,6 +76,12 @@ public:
         return false;
     }
 
+    /// Attempt to use a faster method to perform a surface copy
+    virtual bool AccelerateSurfaceCopy(const Tegra::Engines::Fermi2D::Regs::Surface& src,
+                                       const Tegra::Engines::Fermi2D::Regs::Surface& dst) {
+        return false;
+    }
+
     /// Attempt to use a faster method to fill a region
     virtual bool AccelerateFill(const void* config) {
         return false;
@@ -60,5 +96,16 @@ public:
     virtual bool AccelerateDrawBatch(bool is_indexed) {
         return false;
     }
+
+    /**
+     * Reads back the surface cached at the address as RGBA8 pixels in rows from top to bottom,
+     * for debugging tools. Must be called on the thread the rasterizer draws on.
+     * @returns False if no surface of that size is cached there or it can't be converted, the
+     * caller then decodes it from memory
+     */
+    virtual bool ReadCachedSurface(Tegra::GPUVAddr addr, u32 width, u32 height,
+                                   std::vector<u8>& pixels) {
+        return false;
+    }
 };
 } // namespace VideoCore
@@ -5,6 +5,7 @@
 #pragma once
 
 #include <atomic>
+#include <functional>
 #include <memory>
 #include <boost/optional.hpp>
 #include "common/common_types.h"
@@ -35,6 +36,14 @@ public:
     /// Shutdown the renderer
     virtual void ShutDown() = 0;
 
+    /**
+     * Runs func with the graphics context current on the calling thread, so that the rasterizer
+     * calls it makes don't each have to make it current on their own.
+     */
+    virtual void RunWithContext(const std::function<void()>& func) {
+        func();
+    }
+
     // Getter/setter functions:
     // ------------------------
 
@@ -54,6 +63,10 @@ public:
         return *rasterizer;
     }
 
+    const Core::Frontend::EmuWindow& GetRenderWindow() const {
+        return render_window;
+    }
+
     /// Refreshes the settings common to all renderers
     void RefreshBaseSettings();
 
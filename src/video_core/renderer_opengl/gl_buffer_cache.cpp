@@ -0,0 +1,79 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <vector>
+#include <boost/range/iterator_range.hpp>
+#include "video_core/renderer_opengl/gl_buffer_cache.h"
+
+namespace OpenGL {
+
+OGLBufferCache::OGLBufferCache(VideoCore::RasterizerCachedPages& cached_pages)
+    : cached_pages{cached_pages} {}
+
+OGLBufferCache::~OGLBufferCache() {
+    InvalidateAll();
+}
+
+boost::optional<GLintptr> OGLBufferCache::Get(Tegra::GPUVAddr addr, size_t size,
+                                              size_t alignment) const {
+    const auto iter = entries.find({addr, size});
+    if (iter == entries.end() || iter->second % alignment != 0) {
+        return boost::none;
+    }
+    return iter->second;
+}
+
+void OGLBufferCache::Register(Tegra::GPUVAddr addr, size_t size, GLintptr offset) {
+    if (addr == 0 || size == 0) {
+        return;
+    }
+
+    const Key key{addr, size};
+    const auto [iter, inserted] = entries.emplace(key, offset);
+    if (!inserted) {
+        // Uploaded again with a stricter alignment, the region is already being tracked
+        iter->second = offset;
+        return;
+    }
+
+    key_map.add({KeyMap::interval_type::right_open(addr, addr + size), KeySet{key}});
+    cached_pages.UpdateCount(addr, size, 1);
+}
+
+void OGLBufferCache::InvalidateRegion(Tegra::GPUVAddr addr, u64 size) {
+    if (size == 0 || key_map.empty()) {
+        return;
+    }
+
+    // Unregistering modifies the map, so collect the overlapping uploads first
+    std::vector<Key> overlapping;
+    const auto interval = KeyMap::interval_type::right_open(addr, addr + size);
+    for (const auto& pair : boost::make_iterator_range(key_map.equal_range(interval))) {
+        overlapping.insert(overlapping.end(), pair.second.begin(), pair.second.end());
+    }
+
+    for (const Key& key : overlapping) {
+        // Uploads spanning several segments of the map are collected once per segment
+        if (entries.count(key) != 0) {
+            Unregister(key);
+        }
+    }
+}
+
+void OGLBufferCache::InvalidateAll() {
+    for (const auto& entry : entries) {
+        cached_pages.UpdateCount(entry.first.first, entry.first.second, -1);
+    }
+    entries.clear();
+    key_map.clear();
+}
+
+void OGLBufferCache::Unregister(const Key& key) {
+    const auto [addr, size] = key;
+    key_map.subtract({KeyMap::interval_type::right_open(addr, addr + size), KeySet{key}});
+    entries.erase(key);
+    cached_pages.UpdateCount(addr, size, -1);
+}
+
+} // namespace OpenGL
@@ -0,0 +1,58 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <cstddef>
+#include <map>
+#include <set>
+#include <utility>
+#include <boost/icl/interval_map.hpp>
+#include <boost/optional.hpp>
+#include <glad/glad.h>
+#include "common/common_types.h"
+#include "video_core/memory_manager.h"
+#include "video_core/rasterizer_cached_pages.h"
+
+namespace OpenGL {
+
+/**
+ * Remembers where regions of guest memory were uploaded to the stream buffer, so that draws
+ * reading the same unchanged data bind the earlier upload again instead of copying it. The pages
+ * of each region are marked as cached, and guest writes to them invalidate the overlapping
+ * uploads. All uploads are dropped whenever the stream buffer wraps around and overwrites them.
+ */
+class OGLBufferCache final : NonCopyable {
+public:
+    explicit OGLBufferCache(VideoCore::RasterizerCachedPages& cached_pages);
+    ~OGLBufferCache();
+
+    /// Returns the stream buffer offset of a still valid upload of the region, if any exists with
+    /// the requested alignment
+    boost::optional<GLintptr> Get(Tegra::GPUVAddr addr, size_t size, size_t alignment) const;
+
+    /// Records that the region was uploaded to the stream buffer at the specified offset
+    void Register(Tegra::GPUVAddr addr, size_t size, GLintptr offset);
+
+    /// Drops the uploads overlapping the specified region
+    void InvalidateRegion(Tegra::GPUVAddr addr, u64 size);
+
+    /// Drops all the uploads, they are no longer valid once the stream buffer is reused
+    void InvalidateAll();
+
+private:
+    using Key = std::pair<Tegra::GPUVAddr, size_t>;
+    using KeySet = std::set<Key>;
+    using KeyMap = boost::icl::interval_map<Tegra::GPUVAddr, KeySet>;
+
+    void Unregister(const Key& key);
+
+    /// Stream buffer offsets of the uploads, indexed by the region they were read from
+    std::map<Key, GLintptr> entries;
+    /// Regions of the uploads indexed by the GPU address range they cover, for overlap queries
+    KeyMap key_map;
+    VideoCore::RasterizerCachedPages& cached_pages;
+};
+
+} // namespace OpenGL
@@ -0,0 +1,147 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <utility>
+#include "common/assert.h"
+#include "common/scope_exit.h"
+#include "video_core/renderer_opengl/gl_frame_mailbox.h"
+#include "video_core/renderer_opengl/gl_state.h"
+
+namespace OpenGL {
+
+FrameMailbox::FrameMailbox() = default;
+
+FrameMailbox::~FrameMailbox() = default;
+
+FrameMailbox::Frame& FrameMailbox::GetRenderFrame(u32 width, u32 height) {
+    Frame* frame = nullptr;
+    GLsync present_fence = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        // At most two frames are in use by the presentation side, so one is always free
+        for (auto& candidate : frames) {
+            if (&candidate != queued && &candidate != presenting) {
+                frame = &candidate;
+                break;
+            }
+        }
+        present_fence = std::exchange(frame->present_fence, nullptr);
+    }
+
+    // The GPU may still be reading the frame for its last presentation
+    if (present_fence != nullptr) {
+        glWaitSync(present_fence, 0, GL_TIMEOUT_IGNORED);
+        glDeleteSync(present_fence);
+    }
+
+    if (frame->width != width || frame->height != height) {
+        OpenGLState prev_state{OpenGLState::GetCurState()};
+        SCOPE_EXIT({ prev_state.Apply(); });
+
+        frame->color.Create();
+        frame->render_framebuffer.Create();
+
+        OpenGLState state;
+        state.texture_units[0].texture_2d = frame->color.handle;
+        state.draw.draw_framebuffer = frame->render_framebuffer.handle;
+        state.Apply();
+
+        glActiveTexture(GL_TEXTURE0);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, static_cast<GLsizei>(width),
+                     static_cast<GLsizei>(height), 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
+        glFramebufferTexture2D(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D,
+                               frame->color.handle, 0);
+
+        frame->width = width;
+        frame->height = height;
+    }
+
+    return *frame;
+}
+
+void FrameMailbox::ReleaseRenderFrame(Frame& frame) {
+    frame.render_fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    // Fences are only visible to other contexts once the command creating them is flushed
+    glFlush();
+
+    GLsync dropped_fence = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (queued != nullptr) {
+            // The presentation thread had no time for the previous frame, it's never shown
+            dropped_fence = std::exchange(queued->render_fence, nullptr);
+        }
+        queued = &frame;
+    }
+    frame_queued.notify_one();
+
+    if (dropped_fence != nullptr) {
+        glDeleteSync(dropped_fence);
+    }
+}
+
+void FrameMailbox::Close() {
+    std::lock_guard<std::mutex> lock(mutex);
+    closed = true;
+    queued = nullptr;
+    presenting = nullptr;
+
+    for (auto& frame : frames) {
+        if (frame.render_fence != nullptr) {
+            glDeleteSync(std::exchange(frame.render_fence, nullptr));
+        }
+        if (frame.present_fence != nullptr) {
+            glDeleteSync(std::exchange(frame.present_fence, nullptr));
+        }
+        frame.render_framebuffer.Release();
+        frame.color.Release();
+        frame.width = 0;
+        frame.height = 0;
+    }
+    frame_queued.notify_all();
+}
+
+bool FrameMailbox::TryPresent(std::chrono::milliseconds timeout) {
+    std::unique_lock<std::mutex> lock(mutex);
+    if (!frame_queued.wait_for(lock, timeout, [this] { return queued != nullptr || closed; }) ||
+        closed) {
+        return false;
+    }
+
+    // The lock stays held while the commands below are queued so that Close can't free the frame
+    // meanwhile. None of them wait for the GPU.
+    presenting = std::exchange(queued, nullptr);
+    ASSERT(presenting->present_fence == nullptr);
+
+    glWaitSync(presenting->render_fence, 0, GL_TIMEOUT_IGNORED);
+    glDeleteSync(std::exchange(presenting->render_fence, nullptr));
+
+    if (present_read_framebuffer == 0) {
+        glGenFramebuffers(1, &present_read_framebuffer);
+    }
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, present_read_framebuffer);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+    glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D,
+                           presenting->color.handle, 0);
+
+    const auto width = static_cast<GLint>(presenting->width);
+    const auto height = static_cast<GLint>(presenting->height);
+    glBlitFramebuffer(0, 0, width, height, 0, 0, width, height, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+
+    glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, 0, 0);
+
+    // Flushed by the buffer swap the caller does next
+    presenting->present_fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    return true;
+}
+
+void FrameMailbox::ReleasePresentResources() {
+    if (present_read_framebuffer != 0) {
+        glDeleteFramebuffers(1, &present_read_framebuffer);
+        present_read_framebuffer = 0;
+    }
+}
+
+} // namespace OpenGL
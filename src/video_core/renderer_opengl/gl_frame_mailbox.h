@@ -0,0 +1,76 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <glad/glad.h>
+#include "common/common_types.h"
+#include "core/frontend/emu_window.h"
+#include "video_core/renderer_opengl/gl_resource_manager.h"
+
+namespace OpenGL {
+
+/**
+ * Triple buffered hand-off of finished frames from the renderer's context to a presentation
+ * thread with a context of its own in the same share group. The renderer always has a free frame
+ * to draw into, so it never waits for the presentation thread, and the presentation thread only
+ * ever shows the newest frame, dropping the ones it had no time for.
+ */
+class FrameMailbox final : public Core::Frontend::FrameMailbox {
+public:
+    struct Frame {
+        OGLTexture color;
+        /// Framebuffer of the renderer's context the color texture is attached to
+        OGLFramebuffer render_framebuffer;
+        u32 width = 0;
+        u32 height = 0;
+        /// Signaled once the renderer finished drawing the frame
+        GLsync render_fence = nullptr;
+        /// Signaled once the presentation thread finished reading the frame
+        GLsync present_fence = nullptr;
+    };
+
+    FrameMailbox();
+    ~FrameMailbox() override;
+
+    /**
+     * Returns a frame of the given size to draw into, which isn't queued or being presented.
+     * Called by the renderer, with its context current.
+     */
+    Frame& GetRenderFrame(u32 width, u32 height);
+
+    /// Queues a frame returned by GetRenderFrame for presentation, replacing any unshown one
+    void ReleaseRenderFrame(Frame& frame);
+
+    /// Frees the frames and stops presenting them. Called by the renderer with its context current
+    void Close();
+
+    bool TryPresent(std::chrono::milliseconds timeout) override;
+    void ReleasePresentResources() override;
+
+private:
+    static constexpr std::size_t NUM_FRAMES = 3;
+
+    std::mutex mutex;
+    std::condition_variable frame_queued;
+
+    std::array<Frame, NUM_FRAMES> frames;
+    /// Newest frame finished by the renderer and not presented yet
+    Frame* queued = nullptr;
+    /// Frame last drawn by the presentation thread
+    Frame* presenting = nullptr;
+    bool closed = false;
+
+    /**
+     * Read framebuffer of the presentation context, framebuffers aren't shared between contexts.
+     * Managed by hand since OGLFramebuffer updates the renderer's cached state on release.
+     */
+    GLuint present_read_framebuffer = 0;
+};
+
+} // namespace OpenGL
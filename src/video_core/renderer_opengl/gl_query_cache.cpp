@@ -0,0 +1,128 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <utility>
+#include <boost/optional.hpp>
+#include "common/assert.h"
+#include "common/logging/log.h"
+#include "common/swap.h"
+#include "core/core.h"
+#include "core/memory.h"
+#include "video_core/engines/maxwell_3d.h"
+#include "video_core/gpu.h"
+#include "video_core/renderer_opengl/gl_query_cache.h"
+
+namespace OpenGL {
+
+QueryCache::HostCounter::HostCounter(std::shared_ptr<HostCounter> dependency)
+    : dependency{std::move(dependency)} {
+    query.Create();
+}
+
+bool QueryCache::HostCounter::IsAvailable() {
+    if (is_resolved) {
+        return true;
+    }
+    if (dependency != nullptr && !dependency->IsAvailable()) {
+        return false;
+    }
+
+    GLuint is_available = GL_FALSE;
+    glGetQueryObjectuiv(query.handle, GL_QUERY_RESULT_AVAILABLE, &is_available);
+    return is_available == GL_TRUE;
+}
+
+u64 QueryCache::HostCounter::GetValue() {
+    if (is_resolved) {
+        return value;
+    }
+
+    GLuint64 samples = 0;
+    glGetQueryObjectui64v(query.handle, GL_QUERY_RESULT, &samples);
+    value = samples + (dependency != nullptr ? dependency->GetValue() : 0);
+    is_resolved = true;
+
+    // Keeps the chain short, the later segments only need the sum
+    dependency.reset();
+    query.Release();
+    return value;
+}
+
+void QueryCache::StartCounting() {
+    if (!is_counting || current != nullptr) {
+        return;
+    }
+    current = std::make_shared<HostCounter>(last);
+    glBeginQuery(GL_SAMPLES_PASSED, current->GetHandle());
+}
+
+void QueryCache::StopCounting() {
+    if (current == nullptr) {
+        return;
+    }
+    glEndQuery(GL_SAMPLES_PASSED);
+    last = std::move(current);
+    current = nullptr;
+}
+
+void QueryCache::ResetCounter(VideoCore::QueryType type) {
+    ASSERT(type == VideoCore::QueryType::SamplesPassed);
+
+    // Segments before the reset stay alive as long as pending queries refer to them
+    StopCounting();
+    last = nullptr;
+    is_counting = true;
+}
+
+void QueryCache::Query(Tegra::GPUVAddr addr, VideoCore::QueryType type, bool long_query) {
+    ASSERT(type == VideoCore::QueryType::SamplesPassed);
+
+    // The draws after this one belong to the next segment
+    StopCounting();
+    is_counting = true;
+
+    // The timestamp is the time the query was issued at, not the time its result came in
+    pending_queries.push_back(
+        {addr, last, long_query, Tegra::Engines::Maxwell3D::GetQueryTimestamp()});
+    ResolveQueries(false);
+}
+
+void QueryCache::ResolveQueries(bool wait) {
+    while (!pending_queries.empty()) {
+        const PendingQuery& query = pending_queries.front();
+        if (!wait && query.counter != nullptr && !query.counter->IsAvailable()) {
+            return;
+        }
+        WriteResult(query, query.counter != nullptr ? query.counter->GetValue() : 0);
+        pending_queries.pop_front();
+    }
+}
+
+void QueryCache::WriteResult(const PendingQuery& query, u64 value) {
+    const auto& memory_manager = Core::System::GetInstance().GPU().memory_manager;
+    const boost::optional<VAddr> address = memory_manager->GpuToCpuAddress(query.addr);
+    if (!address) {
+        LOG_ERROR(Render_OpenGL, "Query address {:016X} is no longer mapped", query.addr);
+        return;
+    }
+
+    if (!query.long_query) {
+        Memory::Write32(*address, static_cast<u32>(value));
+        return;
+    }
+
+    // Same layout as the long query results written by Maxwell3D
+    struct LongQueryResult {
+        u64_le value;
+        u64_le timestamp;
+    };
+    static_assert(sizeof(LongQueryResult) == 16, "LongQueryResult has wrong size");
+
+    LongQueryResult result{};
+    result.value = value;
+    result.timestamp = query.timestamp;
+    Memory::WriteBlock(*address, &result, sizeof(result));
+}
+
+} // namespace OpenGL
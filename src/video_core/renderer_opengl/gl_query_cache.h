@@ -0,0 +1,84 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <deque>
+#include <memory>
+#include "common/common_types.h"
+#include "video_core/memory_manager.h"
+#include "video_core/rasterizer_interface.h"
+#include "video_core/renderer_opengl/gl_resource_manager.h"
+
+namespace OpenGL {
+
+/**
+ * Emulates the sample counter of the guest GPU with GL_SAMPLES_PASSED queries. The counter is
+ * split into segments, each one a host query spanning the draws between two reads of the counter,
+ * and its value is the sum of the segments since the last reset. Results are written to guest
+ * memory once the host GPU has produced them, nothing waits for a query unless everything is
+ * being flushed.
+ */
+class QueryCache final : NonCopyable {
+public:
+    /// Makes sure the enabled counters are counting, called before the rasterizer draws
+    void StartCounting();
+
+    /// Ends the running segments, draws issued until the next StartCounting aren't counted
+    void StopCounting();
+
+    void ResetCounter(VideoCore::QueryType type);
+
+    void Query(Tegra::GPUVAddr addr, VideoCore::QueryType type, bool long_query);
+
+    /// Writes the results of the queries the host GPU is done with, or of all of them if `wait`
+    void ResolveQueries(bool wait);
+
+private:
+    /// Value of the counter at the end of a segment, including the segments before it
+    class HostCounter {
+    public:
+        explicit HostCounter(std::shared_ptr<HostCounter> dependency);
+
+        /// Whether the value can be read without waiting for the host GPU
+        bool IsAvailable();
+
+        /// Returns the value, waiting for the host GPU if it isn't available yet
+        u64 GetValue();
+
+        GLuint GetHandle() const {
+            return query.handle;
+        }
+
+    private:
+        /// Previous segment since the reset, released once the value is known
+        std::shared_ptr<HostCounter> dependency;
+        OGLQuery query;
+        u64 value = 0;
+        bool is_resolved = false;
+    };
+
+    /// A counter read by the guest, waiting for its value to be written to guest memory
+    struct PendingQuery {
+        Tegra::GPUVAddr addr;
+        /// Null if nothing was drawn since the reset
+        std::shared_ptr<HostCounter> counter;
+        bool long_query;
+        /// GPU timestamp written along the value of a long query
+        u64 timestamp;
+    };
+
+    static void WriteResult(const PendingQuery& query, u64 value);
+
+    /// Whether the guest has used the sample counter, until then draws aren't counted
+    bool is_counting = false;
+    /// Segment whose query is running, null if none is
+    std::shared_ptr<HostCounter> current;
+    /// Last segment that was ended since the reset
+    std::shared_ptr<HostCounter> last;
+    /// Queries are written in the order the guest issued them
+    std::deque<PendingQuery> pending_queries;
+};
+
+} // namespace OpenGL
@@ -3,6 +3,8 @@
 // Refer to the license.txt file included.
 
 #include <algorithm>
+#include <array>
+#include <bitset>
 #include <memory>
 #include <string>
 #include <string_view>
@@ -29,8 +31,10 @@
 namespace OpenGL {
 
 using Maxwell = Tegra::Engines::Maxwell3D::Regs;
-using PixelFormat = SurfaceParams::PixelFormat;
-using SurfaceType = SurfaceParams::SurfaceType;
+using VideoCore::Surface::PixelFormat;
+using VideoCore::Surface::PixelFormatFromGPUPixelFormat;
+using VideoCore::Surface::PixelFormatFromRenderTargetFormat;
+using VideoCore::Surface::SurfaceType;
 
 MICROPROFILE_DEFINE(OpenGL_VAO, "OpenGL", "Vertex Array Setup", MP_RGB(128, 128, 192));
 MICROPROFILE_DEFINE(OpenGL_VS, "OpenGL", "Vertex Shader Setup", MP_RGB(128, 128, 192));
@@ -38,15 +42,92 @@ MICROPROFILE_DEFINE(OpenGL_FS, "OpenGL", "Fragment Shader Setup", MP_RGB(128, 12
 MICROPROFILE_DEFINE(OpenGL_Drawing, "OpenGL", "Drawing", MP_RGB(128, 128, 192));
 MICROPROFILE_DEFINE(OpenGL_Blits, "OpenGL", "Blits", MP_RGB(100, 100, 255));
 MICROPROFILE_DEFINE(OpenGL_CacheManagement, "OpenGL", "Cache Mgmt", MP_RGB(100, 255, 100));
+MICROPROFILE_DEFINE_GPU(GPU_Drawing, "Drawing", MP_RGB(128, 128, 192));
+MICROPROFILE_DEFINE_GPU(GPU_Clears, "Clears", MP_RGB(192, 128, 128));
+MICROPROFILE_DEFINE_GPU(GPU_Blits, "Blits", MP_RGB(100, 100, 255));
+
+/// Returns a table mapping each Maxwell3D register to the DirtyFlags of the state derived from it.
+static const std::array<u32, Maxwell::NUM_REGS>& GetRegisterDirtyFlags() {
+    static const auto table = [] {
+        std::array<u32, Maxwell::NUM_REGS> flags{};
+        const auto mark = [&flags](size_t first, size_t size_in_bytes, u32 flag) {
+            for (size_t reg = first; reg < first + size_in_bytes / sizeof(u32); ++reg) {
+                flags[reg] |= flag;
+            }
+        };
+
+#define MARK_REG(field_name, flag)                                                                 \
+    mark(MAXWELL3D_REG_INDEX(field_name), sizeof(Maxwell::field_name), flag)
+
+        MARK_REG(viewport_transform[0], RasterizerOpenGL::DirtyViewport);
+
+        MARK_REG(cull, RasterizerOpenGL::DirtyCullMode);
+        MARK_REG(screen_y_control, RasterizerOpenGL::DirtyCullMode);
+        MARK_REG(viewport_transform[0].scale_y, RasterizerOpenGL::DirtyCullMode);
+
+        MARK_REG(depth_test_enable, RasterizerOpenGL::DirtyDepthTest);
+        MARK_REG(depth_write_enabled, RasterizerOpenGL::DirtyDepthTest);
+        MARK_REG(depth_test_func, RasterizerOpenGL::DirtyDepthTest);
+
+        MARK_REG(stencil_enable, RasterizerOpenGL::DirtyStencilTest);
+        MARK_REG(stencil_two_side_enable, RasterizerOpenGL::DirtyStencilTest);
+        MARK_REG(stencil_front_op_fail, RasterizerOpenGL::DirtyStencilTest);
+        MARK_REG(stencil_front_op_zfail, RasterizerOpenGL::DirtyStencilTest);
+        MARK_REG(stencil_front_op_zpass, RasterizerOpenGL::DirtyStencilTest);
+        MARK_REG(stencil_front_func_func, RasterizerOpenGL::DirtyStencilTest);
+        MARK_REG(stencil_front_func_ref, RasterizerOpenGL::DirtyStencilTest);
+        MARK_REG(stencil_front_func_mask, RasterizerOpenGL::DirtyStencilTest);
+        MARK_REG(stencil_front_mask, RasterizerOpenGL::DirtyStencilTest);
+        MARK_REG(stencil_back_op_fail, RasterizerOpenGL::DirtyStencilTest);
+        MARK_REG(stencil_back_op_zfail, RasterizerOpenGL::DirtyStencilTest);
+        MARK_REG(stencil_back_op_zpass, RasterizerOpenGL::DirtyStencilTest);
+        MARK_REG(stencil_back_func_func, RasterizerOpenGL::DirtyStencilTest);
+        MARK_REG(stencil_back_func_ref, RasterizerOpenGL::DirtyStencilTest);
+        MARK_REG(stencil_back_func_mask, RasterizerOpenGL::DirtyStencilTest);
+        MARK_REG(stencil_back_mask, RasterizerOpenGL::DirtyStencilTest);
+
+        // Blending and logic ops validate each other's enable bits, so they share registers.
+        MARK_REG(blend, RasterizerOpenGL::DirtyBlend | RasterizerOpenGL::DirtyLogicOp);
+        MARK_REG(independent_blend_enable, RasterizerOpenGL::DirtyBlend);
+        MARK_REG(independent_blend[0], RasterizerOpenGL::DirtyBlend);
+        MARK_REG(logic_op, RasterizerOpenGL::DirtyBlend | RasterizerOpenGL::DirtyLogicOp);
+
+#undef MARK_REG
+
+        return flags;
+    }();
+    return table;
+}
 
-RasterizerOpenGL::RasterizerOpenGL(Core::Frontend::EmuWindow& window, ScreenInfo& info)
-    : emu_window{window}, screen_info{info}, stream_buffer(GL_ARRAY_BUFFER, STREAM_BUFFER_SIZE) {
-    // Create sampler objects
-    for (size_t i = 0; i < texture_samplers.size(); ++i) {
-        texture_samplers[i].Create();
-        state.texture_units[i].sampler = texture_samplers[i].sampler.handle;
-    }
+/// Returns the set of Maxwell3D registers that only describe the vertex range of a draw. Writing
+/// anything else may change the state a pending draw was set up with.
+static const std::bitset<Maxwell::NUM_REGS>& GetDrawParameterRegisters() {
+    static const auto registers = [] {
+        std::bitset<Maxwell::NUM_REGS> set;
+        const auto mark = [&set](size_t first, size_t size_in_bytes) {
+            for (size_t reg = first; reg < first + size_in_bytes / sizeof(u32); ++reg) {
+                set.set(reg);
+            }
+        };
+
+#define MARK_REG(field_name) mark(MAXWELL3D_REG_INDEX(field_name), sizeof(Maxwell::field_name))
+
+        MARK_REG(vertex_buffer);
+        MARK_REG(index_array);
+        MARK_REG(vb_element_base);
+        MARK_REG(draw);
+
+#undef MARK_REG
 
+        return set;
+    }();
+    return registers;
+}
+
+RasterizerOpenGL::RasterizerOpenGL(Core::Frontend::EmuWindow& window, ScreenInfo& info)
+    : res_cache{cached_pages}, emu_window{window}, screen_info{info},
+      stream_buffer(GL_ARRAY_BUFFER, STREAM_BUFFER_SIZE), buffer_cache{cached_pages},
+      texture_descriptor_cache{cached_pages} {
     GLint ext_num;
     glGetIntegerv(GL_NUM_EXTENSIONS, &ext_num);
     for (GLint i = 0; i < ext_num; i++) {
@@ -78,20 +159,49 @@ RasterizerOpenGL::RasterizerOpenGL(Core::Frontend::EmuWindow& window, ScreenInfo
     // Create render framebuffer
     framebuffer.Create();
 
-    hw_vao.Create();
-
     state.draw.vertex_buffer = stream_buffer.GetHandle();
 
-    shader_program_manager = std::make_unique<GLShader::ProgramManager>();
+    // Indirectly accessed const buffers take a storage block in each stage, at bindpoints fixed
+    // per stage, as long as the host has enough of them
+    GLint max_storage_bindings = 0;
+    GLint max_vertex_storage_blocks = 0;
+    GLint max_geometry_storage_blocks = 0;
+    GLint max_fragment_storage_blocks = 0;
+    glGetIntegerv(GL_MAX_SHADER_STORAGE_BUFFER_BINDINGS, &max_storage_bindings);
+    glGetIntegerv(GL_MAX_VERTEX_SHADER_STORAGE_BLOCKS, &max_vertex_storage_blocks);
+    glGetIntegerv(GL_MAX_GEOMETRY_SHADER_STORAGE_BLOCKS, &max_geometry_storage_blocks);
+    glGetIntegerv(GL_MAX_FRAGMENT_SHADER_STORAGE_BLOCKS, &max_fragment_storage_blocks);
+    constexpr GLint required_storage_blocks = static_cast<GLint>(Maxwell::MaxConstBuffers);
+    const bool use_storage_buffers =
+        max_storage_bindings >=
+            required_storage_blocks * GLShader::ConstBufferEntry::NumBindingStages &&
+        max_vertex_storage_blocks >= required_storage_blocks &&
+        max_geometry_storage_blocks >= required_storage_blocks &&
+        max_fragment_storage_blocks >= required_storage_blocks;
+    if (!use_storage_buffers) {
+        LOG_WARNING(Render_OpenGL,
+                    "Reading indirect const buffers from uniform blocks, storage buffer limits "
+                    "too low: bindings={}, vertex={}, geometry={}, fragment={}",
+                    max_storage_bindings, max_vertex_storage_blocks, max_geometry_storage_blocks,
+                    max_fragment_storage_blocks);
+    }
+    GLShader::SetStorageBuffersEnabled(use_storage_buffers);
+
+    // Without the extension, checking whether a link has finished would wait for it
+    const bool use_asynchronous_shaders =
+        Settings::values.use_asynchronous_shaders && GLAD_GL_ARB_parallel_shader_compile;
+    if (use_asynchronous_shaders) {
+        // Let the driver pick the number of compiler threads
+        glMaxShaderCompilerThreadsARB(0xFFFFFFFF);
+    }
+    shader_program_manager = std::make_unique<GLShader::ProgramManager>(use_asynchronous_shaders);
     state.draw.shader_program = 0;
-    state.draw.vertex_array = hw_vao.handle;
     state.Apply();
 
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, stream_buffer.GetHandle());
-
     glEnable(GL_BLEND);
 
     glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &uniform_buffer_alignment);
+    glGetIntegerv(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &storage_buffer_alignment);
 
     LOG_CRITICAL(Render_OpenGL, "Sync fixed function OpenGL state here!");
 }
@@ -104,9 +214,18 @@ std::pair<u8*, GLintptr> RasterizerOpenGL::SetupVertexArrays(u8* array_ptr,
     const auto& gpu = Core::System::GetInstance().GPU().Maxwell3D();
     const auto& regs = gpu.regs;
 
-    state.draw.vertex_array = hw_vao.handle;
-    state.draw.vertex_buffer = stream_buffer.GetHandle();
-    state.Apply();
+    VertexFormatKey key;
+    for (size_t index = 0; index < NumHostVertexAttributes; ++index) {
+        const auto& attrib = regs.vertex_attrib_format[index];
+        if (attrib.IsValid()) {
+            key.state.attributes[index] = attrib.raw;
+        }
+    }
+
+    std::array<GLuint, Maxwell::NumVertexArrays> buffers{};
+    std::array<GLintptr, Maxwell::NumVertexArrays> offsets{};
+    std::array<GLsizei, Maxwell::NumVertexArrays> strides{};
+    u32 num_bindings = 0;
 
     // Upload all guest vertex arrays sequentially to our buffer
     for (u32 index = 0; index < Maxwell::NumVertexArrays; ++index) {
@@ -116,40 +235,71 @@ std::pair<u8*, GLintptr> RasterizerOpenGL::SetupVertexArrays(u8* array_ptr,
 
         Tegra::GPUVAddr start = vertex_array.StartAddress();
         const Tegra::GPUVAddr end = regs.vertex_array_limit[index].LimitAddress();
+        const bool is_instanced{regs.instanced_arrays.IsInstancingEnabled(index) &&
+                                vertex_array.divisor != 0};
 
-        if (regs.instanced_arrays.IsInstancingEnabled(index) && vertex_array.divisor != 0) {
+        if (is_instanced) {
             start += vertex_array.stride * (gpu.state.current_instance / vertex_array.divisor);
+            key.state.instanced_arrays |= 1U << index;
         }
 
         ASSERT(end > start);
         u64 size = end - start + 1;
 
+        // Instanced arrays start somewhere else for every instance, caching those would only fill
+        // the buffer cache with overlapping single use uploads
         GLintptr vertex_buffer_offset;
         std::tie(array_ptr, buffer_offset, vertex_buffer_offset) =
-            UploadMemory(array_ptr, buffer_offset, start, size);
+            UploadMemory(array_ptr, buffer_offset, start, size, 4, !is_instanced);
 
-        // Bind the vertex array to the buffer at the current offset.
-        glBindVertexBuffer(index, stream_buffer.GetHandle(), vertex_buffer_offset,
-                           vertex_array.stride);
+        buffers[index] = stream_buffer.GetHandle();
+        offsets[index] = vertex_buffer_offset;
+        strides[index] = static_cast<GLsizei>(vertex_array.stride);
+        num_bindings = index + 1;
+    }
 
-        if (regs.instanced_arrays.IsInstancingEnabled(index) && vertex_array.divisor != 0) {
-            // Tell OpenGL that this is an instanced vertex buffer to prevent accessing different
-            // indexes on each vertex. We do the instance indexing manually by incrementing the
-            // start address of the vertex buffer.
-            glVertexBindingDivisor(index, 1);
-        } else {
-            // Disable the vertex buffer instancing.
-            glVertexBindingDivisor(index, 0);
+    state.draw.vertex_array = GetVertexArray(key);
+    state.draw.vertex_buffer = stream_buffer.GetHandle();
+    state.Apply();
+
+    // Bind the vertex arrays to the buffer at their offsets, the disabled ones in between to none
+    if (GLAD_GL_ARB_multi_bind) {
+        if (num_bindings != 0) {
+            glBindVertexBuffers(0, static_cast<GLsizei>(num_bindings), buffers.data(),
+                                offsets.data(), strides.data());
+        }
+    } else {
+        for (u32 index = 0; index < num_bindings; ++index) {
+            glBindVertexBuffer(index, buffers[index], offsets[index], strides[index]);
         }
     }
 
+    return {array_ptr, buffer_offset};
+}
+
+GLuint RasterizerOpenGL::GetVertexArray(const VertexFormatKey& key) {
+    auto [iter, inserted] = vertex_arrays.try_emplace(key);
+    OGLVertexArray& vao = iter->second;
+    if (!inserted) {
+        return vao.handle;
+    }
+
+    const auto& regs = Core::System::GetInstance().GPU().Maxwell3D().regs;
+
+    vao.Create();
+    state.draw.vertex_array = vao.handle;
+    state.Apply();
+
+    // The index buffer binding is part of the VAO state
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, stream_buffer.GetHandle());
+
     // Use the vertex array as-is, assumes that the data is formatted correctly for OpenGL.
     // Enables the first 16 vertex attributes always, as we don't know which ones are actually used
     // until shader time. Note, Tegra technically supports 32, but we're capping this to 16 for now
     // to avoid OpenGL errors.
     // TODO(Subv): Analyze the shader to identify which attributes are actually used and don't
     // assume every shader uses them all.
-    for (unsigned index = 0; index < 16; ++index) {
+    for (unsigned index = 0; index < NumHostVertexAttributes; ++index) {
         auto& attrib = regs.vertex_attrib_format[index];
 
         // Ignore invalid attributes.
@@ -175,7 +325,16 @@ std::pair<u8*, GLintptr> RasterizerOpenGL::SetupVertexArrays(u8* array_ptr,
         glVertexAttribBinding(index, attrib.buffer);
     }
 
-    return {array_ptr, buffer_offset};
+    for (u32 index = 0; index < Maxwell::NumVertexArrays; ++index) {
+        if (key.state.instanced_arrays & (1U << index)) {
+            // Tell OpenGL that this is an instanced vertex buffer to prevent accessing different
+            // indexes on each vertex. We do the instance indexing manually by incrementing the
+            // start address of the vertex buffer.
+            glVertexBindingDivisor(index, 1);
+        }
+    }
+
+    return vao.handle;
 }
 
 static GLShader::ProgramCode GetShaderProgramCode(Maxwell::ShaderProgram program) {
@@ -194,9 +353,8 @@ static GLShader::ProgramCode GetShaderProgramCode(Maxwell::ShaderProgram program
 std::pair<u8*, GLintptr> RasterizerOpenGL::SetupShaders(u8* buffer_ptr, GLintptr buffer_offset) {
     auto& gpu = Core::System::GetInstance().GPU().Maxwell3D();
 
-    // Next available bindpoints to use when uploading the const buffers and textures to the GLSL
-    // shaders. The constbuffer bindpoint starts after the shader stage configuration bind points.
-    u32 current_constbuffer_bindpoint = Tegra::Engines::Maxwell3D::Regs::MaxShaderStage;
+    // Next available bindpoint to use when uploading the textures to the GLSL shaders. Const
+    // buffers are bound where the shaders declare them.
     u32 current_texture_bindpoint = 0;
 
     for (size_t index = 0; index < Maxwell::MaxShaderProgram; ++index) {
@@ -259,11 +417,18 @@ std::pair<u8*, GLintptr> RasterizerOpenGL::SetupShaders(u8* buffer_ptr, GLintptr
 
         GLuint gl_stage_program = shader_program_manager->GetCurrentProgramStage(
             static_cast<Maxwell::ShaderStage>(stage));
+        if (gl_stage_program == 0) {
+            // Still compiling, the draw is going to be skipped. Querying the program would wait.
+            if (program == Maxwell::ShaderProgram::VertexA) {
+                index++;
+            }
+            continue;
+        }
 
         // Configure the const buffers for this shader stage.
-        std::tie(buffer_ptr, buffer_offset, current_constbuffer_bindpoint) = SetupConstBuffers(
-            buffer_ptr, buffer_offset, static_cast<Maxwell::ShaderStage>(stage), gl_stage_program,
-            current_constbuffer_bindpoint, shader_resources.const_buffer_entries);
+        std::tie(buffer_ptr, buffer_offset) =
+            SetupConstBuffers(buffer_ptr, buffer_offset, static_cast<Maxwell::ShaderStage>(stage),
+                              shader_resources.const_buffer_entries);
 
         // Configure the textures for this shader stage.
         current_texture_bindpoint =
@@ -346,15 +511,21 @@ std::pair<Surface, Surface> RasterizerOpenGL::ConfigureFramebuffers(bool using_c
     // Bind the framebuffer surfaces
     BindFramebufferSurfaces(color_surface, depth_surface, has_stencil);
 
-    SyncViewport(surfaces_rect);
+    // The rectangles are in guest pixels, render targets may be allocated at a higher or lower
+    // resolution
+    const Surface& scaled_surface = color_surface ? color_surface : depth_surface;
+    const float resolution_scale =
+        scaled_surface ? scaled_surface->GetSurfaceParams().resolution_scale : 1.0f;
+
+    SyncViewport(surfaces_rect, resolution_scale);
 
     // Viewport can have negative offsets or larger dimensions than our framebuffer sub-rect. Enable
     // scissor test to prevent drawing outside of the framebuffer region
     state.scissor.enabled = true;
-    state.scissor.x = draw_rect.left;
-    state.scissor.y = draw_rect.bottom;
-    state.scissor.width = draw_rect.GetWidth();
-    state.scissor.height = draw_rect.GetHeight();
+    state.scissor.x = static_cast<GLint>(draw_rect.left * resolution_scale);
+    state.scissor.y = static_cast<GLint>(draw_rect.bottom * resolution_scale);
+    state.scissor.width = static_cast<GLsizei>(draw_rect.GetWidth() * resolution_scale);
+    state.scissor.height = static_cast<GLsizei>(draw_rect.GetHeight() * resolution_scale);
     state.Apply();
 
     // Only return the surface to be marked as dirty if writing to it is enabled.
@@ -363,6 +534,11 @@ std::pair<Surface, Surface> RasterizerOpenGL::ConfigureFramebuffers(bool using_c
 }
 
 void RasterizerOpenGL::Clear() {
+    ScopeAcquireGLContext acquire_context{emu_window};
+
+    SubmitDrawBatch();
+    MICROPROFILE_SCOPEGPU(GPU_Clears);
+
     const auto prev_state{state};
     SCOPE_EXIT({ prev_state.Apply(); });
 
@@ -416,10 +592,18 @@ void RasterizerOpenGL::Clear() {
         return;
     }
 
-    ScopeAcquireGLContext acquire_context{emu_window};
+    if (ClearSurfacesDirectly(use_color_fb, use_depth_fb)) {
+        return;
+    }
+
+    // Components the clear doesn't write keep their contents
+    const bool is_partial_clear =
+        (use_color_fb && !(regs.clear_buffers.R && regs.clear_buffers.G &&
+                           regs.clear_buffers.B && regs.clear_buffers.A)) ||
+        (use_depth_fb && regs.clear_buffers.Z != regs.clear_buffers.S);
 
     auto [dirty_color_surface, dirty_depth_surface] =
-        ConfigureFramebuffers(use_color_fb, use_depth_fb, false);
+        ConfigureFramebuffers(use_color_fb, use_depth_fb, is_partial_clear);
 
     clear_state.Apply();
 
@@ -433,12 +617,93 @@ void RasterizerOpenGL::Clear() {
     // Mark framebuffer surfaces as dirty
     if (Settings::values.use_accurate_framebuffers) {
         if (dirty_color_surface != nullptr) {
-            res_cache.FlushSurface(dirty_color_surface);
+            res_cache.FlushSurfaceAsync(dirty_color_surface);
         }
         if (dirty_depth_surface != nullptr) {
-            res_cache.FlushSurface(dirty_depth_surface);
+            res_cache.FlushSurfaceAsync(dirty_depth_surface);
+        }
+    }
+}
+
+bool RasterizerOpenGL::ClearSurfacesDirectly(bool use_color_fb, bool use_depth_fb) {
+    if (!GLAD_GL_ARB_clear_texture) {
+        return false;
+    }
+
+    const auto& regs = Core::System::GetInstance().GPU().Maxwell3D().regs;
+
+    // glClear only writes inside the viewport, which ConfigureFramebuffers sets as the scissor
+    const MathUtil::Rectangle<s32> viewport_rect{regs.viewport_transform[0].GetRect()};
+    const auto covers_surface = [&viewport_rect](const SurfaceParams& params) {
+        return viewport_rect.left <= 0 && viewport_rect.bottom <= 0 &&
+               viewport_rect.right >= static_cast<s32>(params.width) &&
+               viewport_rect.top >= static_cast<s32>(params.height);
+    };
+
+    // Check that the whole of each surface is written before looking any of them up, the lookup
+    // drops their previous contents
+    SurfaceParams color_params{};
+    if (use_color_fb) {
+        color_params = SurfaceParams::CreateForFramebuffer(regs.rt[0]);
+        if (!covers_surface(color_params)) {
+            return false;
+        }
+        if (!regs.clear_buffers.R || !regs.clear_buffers.G || !regs.clear_buffers.B ||
+            !regs.clear_buffers.A) {
+            return false;
+        }
+        // The clear color is only specified in floating point
+        if (color_params.component_type == SurfaceParams::ComponentType::SInt ||
+            color_params.component_type == SurfaceParams::ComponentType::UInt) {
+            return false;
+        }
+    }
+
+    SurfaceParams depth_params{};
+    if (use_depth_fb) {
+        depth_params = SurfaceParams::CreateForDepthBuffer(regs.zeta_width, regs.zeta_height,
+                                                           regs.zeta.Address(), regs.zeta.format);
+        if (!covers_surface(depth_params)) {
+            return false;
+        }
+        const bool has_stencil = depth_params.type == SurfaceParams::SurfaceType::DepthStencil;
+        if (!regs.clear_buffers.Z || (has_stencil && !regs.clear_buffers.S)) {
+            return false;
+        }
+    }
+
+    const Surface color_surface = use_color_fb ? res_cache.GetClearSurface(color_params) : nullptr;
+    const Surface depth_surface = use_depth_fb ? res_cache.GetClearSurface(depth_params) : nullptr;
+
+    if (color_surface != nullptr) {
+        glClearTexImage(color_surface->Texture().handle, 0, GL_RGBA, GL_FLOAT, regs.clear_color);
+    }
+
+    if (depth_surface != nullptr) {
+        if (depth_surface->GetSurfaceParams().type == SurfaceParams::SurfaceType::DepthStencil) {
+            // Layout of GL_FLOAT_32_UNSIGNED_INT_24_8_REV, the stencil is in the low 8 bits
+            struct {
+                float depth;
+                u32 stencil;
+            } value{regs.clear_depth, static_cast<u32>(regs.clear_stencil) & 0xFF};
+            glClearTexImage(depth_surface->Texture().handle, 0, GL_DEPTH_STENCIL,
+                            GL_FLOAT_32_UNSIGNED_INT_24_8_REV, &value);
+        } else {
+            glClearTexImage(depth_surface->Texture().handle, 0, GL_DEPTH_COMPONENT, GL_FLOAT,
+                            &regs.clear_depth);
+        }
+    }
+
+    if (Settings::values.use_accurate_framebuffers) {
+        if (color_surface != nullptr) {
+            res_cache.FlushSurfaceAsync(color_surface);
+        }
+        if (depth_surface != nullptr) {
+            res_cache.FlushSurfaceAsync(depth_surface);
         }
     }
+
+    return true;
 }
 
 std::pair<u8*, GLintptr> RasterizerOpenGL::AlignBuffer(u8* buffer_ptr, GLintptr buffer_offset,
@@ -452,7 +717,15 @@ std::pair<u8*, GLintptr> RasterizerOpenGL::AlignBuffer(u8* buffer_ptr, GLintptr
 std::tuple<u8*, GLintptr, GLintptr> RasterizerOpenGL::UploadMemory(u8* buffer_ptr,
                                                                    GLintptr buffer_offset,
                                                                    Tegra::GPUVAddr gpu_addr,
-                                                                   size_t size, size_t alignment) {
+                                                                   size_t size, size_t alignment,
+                                                                   bool cache) {
+    if (cache) {
+        // Bind the earlier upload if the guest hasn't written to the region since
+        if (const auto cached_offset = buffer_cache.Get(gpu_addr, size, alignment)) {
+            return {buffer_ptr, buffer_offset, *cached_offset};
+        }
+    }
+
     std::tie(buffer_ptr, buffer_offset) = AlignBuffer(buffer_ptr, buffer_offset, alignment);
     GLintptr uploaded_offset = buffer_offset;
 
@@ -460,6 +733,10 @@ std::tuple<u8*, GLintptr, GLintptr> RasterizerOpenGL::UploadMemory(u8* buffer_pt
     const boost::optional<VAddr> cpu_addr{memory_manager->GpuToCpuAddress(gpu_addr)};
     Memory::ReadBlock(*cpu_addr, buffer_ptr, size);
 
+    if (cache) {
+        buffer_cache.Register(gpu_addr, size, uploaded_offset);
+    }
+
     buffer_ptr += size;
     buffer_offset += size;
 
@@ -475,14 +752,35 @@ void RasterizerOpenGL::DrawArrays() {
 
     ScopeAcquireGLContext acquire_context{emu_window};
 
-    auto [dirty_color_surface, dirty_depth_surface] =
+    if (TryExtendDrawBatch()) {
+        accelerate_draw = AccelDraw::Disabled;
+        return;
+    }
+    SubmitDrawBatch();
+
+    // Pick up the readbacks of earlier draws while the context is held anyway
+    res_cache.FinishReadyDownloads();
+
+    std::tie(draw_batch.dirty_color_surface, draw_batch.dirty_depth_surface) =
         ConfigureFramebuffers(true, regs.zeta.Address() != 0 && regs.zeta_enable != 0, true);
 
-    SyncDepthTestState();
-    SyncStencilTestState();
-    SyncBlendState();
-    SyncLogicOpState();
-    SyncCullMode();
+    if (dirty_flags & DirtyDepthTest) {
+        SyncDepthTestState();
+    }
+    if (dirty_flags & DirtyStencilTest) {
+        SyncStencilTestState();
+    }
+    if (dirty_flags & DirtyBlend) {
+        SyncBlendState();
+    }
+    if (dirty_flags & DirtyLogicOp) {
+        SyncLogicOpState();
+    }
+    if (dirty_flags & DirtyCullMode) {
+        SyncCullMode();
+    }
+    // The viewport is tracked separately as it also depends on the bound framebuffer.
+    dirty_flags &= DirtyViewport;
 
     // TODO(bunnei): Sync framebuffer_scale uniform here
     // TODO(bunnei): Sync scissorbox uniform(s) here
@@ -511,8 +809,13 @@ void RasterizerOpenGL::DrawArrays() {
 
     u8* buffer_ptr;
     GLintptr buffer_offset;
-    std::tie(buffer_ptr, buffer_offset, std::ignore) =
+    bool invalidated;
+    std::tie(buffer_ptr, buffer_offset, invalidated) =
         stream_buffer.Map(static_cast<GLsizeiptr>(buffer_size), 4);
+    if (invalidated) {
+        // The stream buffer wrapped around, earlier uploads are about to be overwritten
+        buffer_cache.InvalidateAll();
+    }
     u8* buffer_ptr_base = buffer_ptr;
 
     std::tie(buffer_ptr, buffer_offset) = SetupVertexArrays(buffer_ptr, buffer_offset);
@@ -520,8 +823,9 @@ void RasterizerOpenGL::DrawArrays() {
     // If indexed mode, copy the index buffer
     GLintptr index_buffer_offset = 0;
     if (is_indexed) {
-        std::tie(buffer_ptr, buffer_offset, index_buffer_offset) = UploadMemory(
-            buffer_ptr, buffer_offset, regs.index_array.StartAddress(), index_buffer_size);
+        std::tie(buffer_ptr, buffer_offset, index_buffer_offset) =
+            UploadMemory(buffer_ptr, buffer_offset, regs.index_array.StartAddress(),
+                         index_buffer_size, 4, true);
     }
 
     std::tie(buffer_ptr, buffer_offset) = SetupShaders(buffer_ptr, buffer_offset);
@@ -531,25 +835,122 @@ void RasterizerOpenGL::DrawArrays() {
     shader_program_manager->ApplyTo(state);
     state.Apply();
 
-    const GLenum primitive_mode{MaxwellToGL::PrimitiveTopology(regs.draw.topology)};
+    // The draw itself is deferred, so that the following draws that only differ in their vertex
+    // ranges can be submitted along with it
+    draw_batch.primitive_mode = MaxwellToGL::PrimitiveTopology(regs.draw.topology);
+    draw_batch.is_indexed = is_indexed;
+    draw_batch.index_format = is_indexed ? MaxwellToGL::IndexFormat(regs.index_array.format) : 0;
+    draw_batch.instance = Core::System::GetInstance().GPU().Maxwell3D().state.current_instance;
+    draw_batch.skip_draws = !shader_program_manager->AreCurrentStagesReady();
+    if (draw_batch.skip_draws) {
+        // Dropping draws until their shaders are compiled in the background beats a frame spike
+        LOG_TRACE(Render_OpenGL, "Skipping draw, its shaders are still being compiled");
+    }
+    AppendToDrawBatch(index_buffer_offset);
+
+    accelerate_draw = AccelDraw::Disabled;
+}
+
+bool RasterizerOpenGL::TryExtendDrawBatch() {
+    if (draw_batch.counts.empty()) {
+        return false;
+    }
+
+    const auto& gpu = Core::System::GetInstance().GPU().Maxwell3D();
+    const auto& regs = gpu.regs;
+    const bool is_indexed = accelerate_draw == AccelDraw::Indexed;
+
+    // Any other register change has already submitted the batch, see NotifyMaxwellRegisterChanged.
+    // Instanced vertex arrays were uploaded starting at the instance the batch was set up with.
+    if (is_indexed != draw_batch.is_indexed ||
+        MaxwellToGL::PrimitiveTopology(regs.draw.topology) != draw_batch.primitive_mode ||
+        gpu.state.current_instance != draw_batch.instance) {
+        return false;
+    }
+
+    GLintptr index_buffer_offset = 0;
     if (is_indexed) {
-        const GLint base_vertex{static_cast<GLint>(regs.vb_element_base)};
+        if (MaxwellToGL::IndexFormat(regs.index_array.format) != draw_batch.index_format) {
+            return false;
+        }
+
+        // Wrapping around would orphan the data of the earlier draws on drivers without
+        // persistent mapping, so the batch is submitted first in that case
+        const u64 index_buffer_size{regs.index_array.count * regs.index_array.FormatSizeInBytes()};
+        if (!stream_buffer.HasSpace(static_cast<GLsizeiptr>(index_buffer_size), 4)) {
+            return false;
+        }
 
+        u8* buffer_ptr;
+        GLintptr buffer_offset;
+        std::tie(buffer_ptr, buffer_offset, std::ignore) =
+            stream_buffer.Map(static_cast<GLsizeiptr>(index_buffer_size), 4);
+        u8* const buffer_ptr_base = buffer_ptr;
+
+        std::tie(buffer_ptr, buffer_offset, index_buffer_offset) =
+            UploadMemory(buffer_ptr, buffer_offset, regs.index_array.StartAddress(),
+                         index_buffer_size, 4, true);
+
+        stream_buffer.Unmap(buffer_ptr - buffer_ptr_base);
+    }
+
+    AppendToDrawBatch(index_buffer_offset);
+    return true;
+}
+
+void RasterizerOpenGL::AppendToDrawBatch(GLintptr index_buffer_offset) {
+    const auto& regs = Core::System::GetInstance().GPU().Maxwell3D().regs;
+
+    if (draw_batch.is_indexed) {
         // Adjust the index buffer offset so it points to the first desired index.
         index_buffer_offset += regs.index_array.first * regs.index_array.FormatSizeInBytes();
 
-        glDrawElementsBaseVertex(primitive_mode, regs.index_array.count,
-                                 MaxwellToGL::IndexFormat(regs.index_array.format),
-                                 reinterpret_cast<const void*>(index_buffer_offset), base_vertex);
+        draw_batch.counts.push_back(static_cast<GLsizei>(regs.index_array.count));
+        draw_batch.index_offsets.push_back(reinterpret_cast<const void*>(index_buffer_offset));
+        draw_batch.base_vertices.push_back(static_cast<GLint>(regs.vb_element_base));
+    } else {
+        draw_batch.counts.push_back(static_cast<GLsizei>(regs.vertex_buffer.count));
+        draw_batch.firsts.push_back(static_cast<GLint>(regs.vertex_buffer.first));
+    }
+}
+
+void RasterizerOpenGL::SubmitDrawBatch() {
+    if (draw_batch.counts.empty()) {
+        return;
+    }
+
+    MICROPROFILE_SCOPE(OpenGL_Drawing);
+    MICROPROFILE_SCOPEGPU(GPU_Drawing);
+
+    // Other users of the context may have changed the bindings since the batch was set up
+    state.Apply();
+    query_cache.StartCounting();
+
+    const GLsizei draw_count = static_cast<GLsizei>(draw_batch.counts.size());
+    if (draw_batch.skip_draws) {
+        // The stages weren't ready when the batch was set up
+    } else if (draw_batch.is_indexed) {
+        if (draw_count == 1) {
+            glDrawElementsBaseVertex(draw_batch.primitive_mode, draw_batch.counts[0],
+                                     draw_batch.index_format, draw_batch.index_offsets[0],
+                                     draw_batch.base_vertices[0]);
+        } else {
+            glMultiDrawElementsBaseVertex(draw_batch.primitive_mode, draw_batch.counts.data(),
+                                          draw_batch.index_format, draw_batch.index_offsets.data(),
+                                          draw_count, draw_batch.base_vertices.data());
+        }
     } else {
-        glDrawArrays(primitive_mode, regs.vertex_buffer.first, regs.vertex_buffer.count);
+        if (draw_count == 1) {
+            glDrawArrays(draw_batch.primitive_mode, draw_batch.firsts[0], draw_batch.counts[0]);
+        } else {
+            glMultiDrawArrays(draw_batch.primitive_mode, draw_batch.firsts.data(),
+                              draw_batch.counts.data(), draw_count);
+        }
     }
 
     // Disable scissor test
     state.scissor.enabled = false;
 
-    accelerate_draw = AccelDraw::Disabled;
-
     // Unbind textures for potential future use as framebuffer attachments
     for (auto& texture_unit : state.texture_units) {
         texture_unit.Unbind();
@@ -558,36 +959,130 @@ void RasterizerOpenGL::DrawArrays() {
 
     // Mark framebuffer surfaces as dirty
     if (Settings::values.use_accurate_framebuffers) {
-        if (dirty_color_surface != nullptr) {
-            res_cache.FlushSurface(dirty_color_surface);
+        if (draw_batch.dirty_color_surface != nullptr) {
+            res_cache.FlushSurfaceAsync(draw_batch.dirty_color_surface);
         }
-        if (dirty_depth_surface != nullptr) {
-            res_cache.FlushSurface(dirty_depth_surface);
+        if (draw_batch.dirty_depth_surface != nullptr) {
+            res_cache.FlushSurfaceAsync(draw_batch.dirty_depth_surface);
         }
     }
+
+    draw_batch.dirty_color_surface = nullptr;
+    draw_batch.dirty_depth_surface = nullptr;
+    draw_batch.counts.clear();
+    draw_batch.firsts.clear();
+    draw_batch.index_offsets.clear();
+    draw_batch.base_vertices.clear();
 }
 
-void RasterizerOpenGL::NotifyMaxwellRegisterChanged(u32 method) {}
+void RasterizerOpenGL::NotifyMaxwellRegisterChanged(u32 method) {
+    if (!GetDrawParameterRegisters()[method]) {
+        // The state of the pending draws is about to change, they can't be batched with later ones
+        FlushCommands();
+    }
+    dirty_flags |= GetRegisterDirtyFlags()[method];
+}
 
 void RasterizerOpenGL::FlushAll() {
     MICROPROFILE_SCOPE(OpenGL_CacheManagement);
+    ScopeAcquireGLContext acquire_context{emu_window};
+
+    SubmitDrawBatch();
     res_cache.FlushRegion(0, Kernel::VMManager::MAX_ADDRESS);
+    query_cache.ResolveQueries(true);
+}
+
+void RasterizerOpenGL::FlushCommands() {
+    if (draw_batch.counts.empty()) {
+        return;
+    }
+
+    ScopeAcquireGLContext acquire_context{emu_window};
+    SubmitDrawBatch();
+}
+
+void RasterizerOpenGL::ResetCounter(VideoCore::QueryType type) {
+    ScopeAcquireGLContext acquire_context{emu_window};
+
+    // Draws still in the batch were issued before the reset
+    SubmitDrawBatch();
+    query_cache.ResetCounter(type);
+}
+
+void RasterizerOpenGL::Query(Tegra::GPUVAddr addr, VideoCore::QueryType type, bool long_query) {
+    ScopeAcquireGLContext acquire_context{emu_window};
+
+    // Draws still in the batch are part of the counted value
+    SubmitDrawBatch();
+    query_cache.Query(addr, type, long_query);
+}
+
+void RasterizerOpenGL::TickFrame() {
+    // Called by the renderer while presenting, with the context held
+    MICROPROFILE_SCOPE(OpenGL_CacheManagement);
+    SubmitDrawBatch();
+    res_cache.TickFrame();
+    query_cache.ResolveQueries(false);
+}
+
+void RasterizerOpenGL::LoadDiskResources() {
+    if (!Settings::values.use_disk_shader_cache) {
+        return;
+    }
+    shader_program_manager->LoadDiskCache(
+        Core::System::GetInstance().CurrentProcess()->program_id);
+}
+
+void RasterizerOpenGL::ResetGuestState() {
+    MICROPROFILE_SCOPE(OpenGL_CacheManagement);
+    ScopeAcquireGLContext acquire_context{emu_window};
+
+    SubmitDrawBatch();
+    query_cache.StopCounting();
+    query_cache.ResolveQueries(true);
+
+    res_cache.InvalidateAll();
+    buffer_cache.InvalidateAll();
+    texture_descriptor_cache.InvalidateAll();
+
+    // The registers of the next guest start from scratch
+    dirty_flags = DirtyAll;
 }
 
 void RasterizerOpenGL::FlushRegion(Tegra::GPUVAddr addr, u64 size) {
     MICROPROFILE_SCOPE(OpenGL_CacheManagement);
+    boost::optional<ScopeAcquireGLContext> acquire_context;
+    AcquireContextForUnfinishedDownloads(acquire_context, addr, size);
     res_cache.FlushRegion(addr, size);
 }
 
 void RasterizerOpenGL::InvalidateRegion(Tegra::GPUVAddr addr, u64 size) {
     MICROPROFILE_SCOPE(OpenGL_CacheManagement);
+    boost::optional<ScopeAcquireGLContext> acquire_context;
+    AcquireContextForUnfinishedDownloads(acquire_context, addr, size);
     res_cache.InvalidateRegion(addr, size);
+    buffer_cache.InvalidateRegion(addr, size);
+    texture_descriptor_cache.InvalidateRegion(addr, size);
 }
 
 void RasterizerOpenGL::FlushAndInvalidateRegion(Tegra::GPUVAddr addr, u64 size) {
     MICROPROFILE_SCOPE(OpenGL_CacheManagement);
+    boost::optional<ScopeAcquireGLContext> acquire_context;
+    AcquireContextForUnfinishedDownloads(acquire_context, addr, size);
     res_cache.FlushRegion(addr, size);
     res_cache.InvalidateRegion(addr, size);
+    buffer_cache.InvalidateRegion(addr, size);
+    texture_descriptor_cache.InvalidateRegion(addr, size);
+}
+
+void RasterizerOpenGL::AcquireContextForUnfinishedDownloads(
+    boost::optional<ScopeAcquireGLContext>& acquire_context, Tegra::GPUVAddr addr, u64 size) {
+    // Readbacks are finished by the GPU side whenever the host GPU is done with them, so the
+    // CPU usually finds them in memory already. The others have to be waited for here, and
+    // mapping their buffers needs the context.
+    if (res_cache.HasUnfinishedDownloads(addr, size)) {
+        acquire_context.emplace(emu_window);
+    }
 }
 
 bool RasterizerOpenGL::AccelerateDisplayTransfer(const void* config) {
@@ -601,6 +1096,41 @@ bool RasterizerOpenGL::AccelerateTextureCopy(const void* config) {
     return true;
 }
 
+/// Returns whether a cached surface holds exactly the Fermi2D surface described by the registers
+static bool IsSurfaceMatch(const SurfaceParams& params,
+                          const Tegra::Engines::Fermi2D::Regs::Surface& config) {
+    const bool is_tiled = config.linear == 0;
+    return params.pixel_format == PixelFormatFromRenderTargetFormat(config.format) &&
+           params.width == config.width && params.height == config.height &&
+           params.is_tiled == is_tiled &&
+           (!is_tiled || params.block_height == config.BlockHeight()) && params.num_levels == 1;
+}
+
+bool RasterizerOpenGL::AccelerateSurfaceCopy(const Tegra::Engines::Fermi2D::Regs::Surface& src,
+                                             const Tegra::Engines::Fermi2D::Regs::Surface& dst) {
+    MICROPROFILE_SCOPE(OpenGL_Blits);
+    ScopeAcquireGLContext acquire_context{emu_window};
+
+    SubmitDrawBatch();
+    MICROPROFILE_SCOPEGPU(GPU_Blits);
+
+    const Surface src_surface = res_cache.TryGetCachedSurface(src.Address());
+    const Surface dst_surface = res_cache.TryGetCachedSurface(dst.Address());
+    if (src_surface == nullptr || dst_surface == nullptr ||
+        !IsSurfaceMatch(src_surface->GetSurfaceParams(), src) ||
+        !IsSurfaceMatch(dst_surface->GetSurfaceParams(), dst)) {
+        return false;
+    }
+
+    res_cache.CopySurface(src_surface, dst_surface);
+
+    // The destination is now only up to date on the host GPU, like a render target
+    if (Settings::values.use_accurate_framebuffers) {
+        res_cache.FlushSurfaceAsync(dst_surface);
+    }
+    return true;
+}
+
 bool RasterizerOpenGL::AccelerateFill(const void* config) {
     UNREACHABLE();
     return true;
@@ -608,82 +1138,84 @@ bool RasterizerOpenGL::AccelerateFill(const void* config) {
 
 bool RasterizerOpenGL::AccelerateDisplay(const Tegra::FramebufferConfig& config,
                                          VAddr framebuffer_addr, u32 pixel_stride) {
+    // Presenting the frame may draw, those samples aren't the game's. The renderer calls this
+    // with the context held.
+    SubmitDrawBatch();
+    query_cache.StopCounting();
+
     if (!framebuffer_addr) {
         return {};
     }
 
     MICROPROFILE_SCOPE(OpenGL_CacheManagement);
 
-    const auto& surface{res_cache.TryFindFramebufferSurface(framebuffer_addr)};
+    const auto& surface{res_cache.GetDisplaySurface(config, framebuffer_addr)};
     if (!surface) {
         return {};
     }
 
     // Verify that the cached surface is the same size and format as the requested framebuffer
     const auto& params{surface->GetSurfaceParams()};
-    const auto& pixel_format{SurfaceParams::PixelFormatFromGPUPixelFormat(config.pixel_format)};
+    const auto& pixel_format{PixelFormatFromGPUPixelFormat(config.pixel_format)};
     ASSERT_MSG(params.width == config.width, "Framebuffer width is different");
     ASSERT_MSG(params.height == config.height, "Framebuffer height is different");
     ASSERT_MSG(params.pixel_format == pixel_format, "Framebuffer pixel_format is different");
 
     screen_info.display_texture = surface->Texture().handle;
+    screen_info.display_resolution_scale = params.resolution_scale;
 
     return true;
 }
 
-void RasterizerOpenGL::SamplerInfo::Create() {
-    sampler.Create();
-    mag_filter = min_filter = Tegra::Texture::TextureFilter::Linear;
-    wrap_u = wrap_v = Tegra::Texture::WrapMode::Wrap;
-
-    // default is GL_LINEAR_MIPMAP_LINEAR
-    glSamplerParameteri(sampler.handle, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    // Other attributes have correct defaults
-}
-
-void RasterizerOpenGL::SamplerInfo::SyncWithConfig(const Tegra::Texture::TSCEntry& config) {
-    GLuint s = sampler.handle;
+bool RasterizerOpenGL::ReadCachedSurface(Tegra::GPUVAddr addr, u32 width, u32 height,
+                                         std::vector<u8>& pixels) {
+    ScopeAcquireGLContext acquire_context{emu_window};
 
-    if (mag_filter != config.mag_filter) {
-        mag_filter = config.mag_filter;
-        glSamplerParameteri(s, GL_TEXTURE_MAG_FILTER, MaxwellToGL::TextureFilterMode(mag_filter));
-    }
-    if (min_filter != config.min_filter) {
-        min_filter = config.min_filter;
-        glSamplerParameteri(s, GL_TEXTURE_MIN_FILTER, MaxwellToGL::TextureFilterMode(min_filter));
+    const Surface surface = res_cache.TryGetCachedSurface(addr);
+    if (!surface) {
+        return false;
     }
 
-    if (wrap_u != config.wrap_u) {
-        wrap_u = config.wrap_u;
-        glSamplerParameteri(s, GL_TEXTURE_WRAP_S, MaxwellToGL::WrapMode(wrap_u));
-    }
-    if (wrap_v != config.wrap_v) {
-        wrap_v = config.wrap_v;
-        glSamplerParameteri(s, GL_TEXTURE_WRAP_T, MaxwellToGL::WrapMode(wrap_v));
+    const auto& params = surface->GetSurfaceParams();
+    if (params.width != width || params.GetRect().GetHeight() != height) {
+        return false;
     }
 
-    if (wrap_u == Tegra::Texture::WrapMode::Border || wrap_v == Tegra::Texture::WrapMode::Border) {
-        const GLvec4 new_border_color = {{config.border_color_r, config.border_color_g,
-                                          config.border_color_b, config.border_color_a}};
-        if (border_color != new_border_color) {
-            border_color = new_border_color;
-            glSamplerParameterfv(s, GL_TEXTURE_BORDER_COLOR, border_color.data());
-        }
-    }
+    // Draws still batched may render to the surface
+    SubmitDrawBatch();
+    return res_cache.ReadSurfaceRGBA8(surface, pixels);
 }
 
-std::tuple<u8*, GLintptr, u32> RasterizerOpenGL::SetupConstBuffers(
-    u8* buffer_ptr, GLintptr buffer_offset, Maxwell::ShaderStage stage, GLuint program,
-    u32 current_bindpoint, const std::vector<GLShader::ConstBufferEntry>& entries) {
+std::pair<u8*, GLintptr> RasterizerOpenGL::SetupConstBuffers(
+    u8* buffer_ptr, GLintptr buffer_offset, Maxwell::ShaderStage stage,
+    const std::vector<GLShader::ConstBufferEntry>& entries) {
     const auto& gpu = Core::System::GetInstance().GPU();
     const auto& maxwell3d = gpu.Maxwell3D();
 
     // Upload only the enabled buffers from the 16 constbuffers of each shader stage
     const auto& shader_stage = maxwell3d.state.shader_stages[static_cast<size_t>(stage)];
 
-    for (u32 bindpoint = 0; bindpoint < entries.size(); ++bindpoint) {
-        const auto& used_buffer = entries[bindpoint];
+    // Bindings of the stage by guest buffer, submitted with a single call per buffer type when
+    // multi-bind is available. Disabled buffers are left at 0, which unbinds their bindpoint.
+    struct Bindings {
+        std::array<GLuint, Maxwell::MaxConstBuffers> buffers{};
+        std::array<GLintptr, Maxwell::MaxConstBuffers> offsets{};
+        std::array<GLsizeiptr, Maxwell::MaxConstBuffers> sizes{};
+        /// Bindpoint of the guest buffer 0, and the number of guest buffers submitted
+        GLuint first = 0;
+        u32 count = 0;
+    };
+    Bindings uniform_bindings;
+    Bindings storage_bindings;
+
+    for (const auto& used_buffer : entries) {
         const auto& buffer = shader_stage.const_buffers[used_buffer.GetIndex()];
+        const bool is_storage = used_buffer.IsStorageBuffer();
+        Bindings& bindings = is_storage ? storage_bindings : uniform_bindings;
+
+        const u32 slot = used_buffer.GetIndex();
+        bindings.first = used_buffer.GetBinding() - slot;
+        bindings.count = std::max(bindings.count, slot + 1);
 
         if (!buffer.enabled) {
             continue;
@@ -701,7 +1233,8 @@ std::tuple<u8*, GLintptr, u32> RasterizerOpenGL::SetupConstBuffers(
                 size = MaxConstbufferSize;
             }
         } else {
-            // Buffer is accessed directly, upload just what we use
+            // Buffer is accessed directly, upload just what we use. The shader declares the
+            // buffer with this size.
             size = used_buffer.GetSize() * sizeof(float);
         }
 
@@ -710,26 +1243,40 @@ std::tuple<u8*, GLintptr, u32> RasterizerOpenGL::SetupConstBuffers(
         size = Common::AlignUp(size, sizeof(GLvec4));
         ASSERT_MSG(size <= MaxConstbufferSize, "Constbuffer too big");
 
+        const GLint alignment = is_storage ? storage_buffer_alignment : uniform_buffer_alignment;
         GLintptr const_buffer_offset;
         std::tie(buffer_ptr, buffer_offset, const_buffer_offset) =
             UploadMemory(buffer_ptr, buffer_offset, buffer.address, size,
-                         static_cast<size_t>(uniform_buffer_alignment));
+                         static_cast<size_t>(alignment), true);
 
-        glBindBufferRange(GL_UNIFORM_BUFFER, current_bindpoint + bindpoint,
-                          stream_buffer.GetHandle(), const_buffer_offset, size);
+        bindings.buffers[slot] = stream_buffer.GetHandle();
+        bindings.offsets[slot] = const_buffer_offset;
+        bindings.sizes[slot] = static_cast<GLsizeiptr>(size);
+    }
 
-        // Now configure the bindpoint of the buffer inside the shader
-        const std::string buffer_name = used_buffer.GetName();
-        const GLuint index =
-            glGetProgramResourceIndex(program, GL_UNIFORM_BLOCK, buffer_name.c_str());
-        if (index != GL_INVALID_INDEX) {
-            glUniformBlockBinding(program, index, current_bindpoint + bindpoint);
+    const auto bind = [](GLenum target, const Bindings& bindings) {
+        if (bindings.count == 0) {
+            return;
         }
-    }
+        if (GLAD_GL_ARB_multi_bind) {
+            glBindBuffersRange(target, bindings.first, static_cast<GLsizei>(bindings.count),
+                               bindings.buffers.data(), bindings.offsets.data(),
+                               bindings.sizes.data());
+            return;
+        }
+        for (u32 slot = 0; slot < bindings.count; ++slot) {
+            if (bindings.buffers[slot] != 0) {
+                glBindBufferRange(target, bindings.first + slot, bindings.buffers[slot],
+                                  bindings.offsets[slot], bindings.sizes[slot]);
+            }
+        }
+    };
+    bind(GL_UNIFORM_BUFFER, uniform_bindings);
+    bind(GL_SHADER_STORAGE_BUFFER, storage_bindings);
 
     state.Apply();
 
-    return {buffer_ptr, buffer_offset, current_bindpoint + static_cast<u32>(entries.size())};
+    return {buffer_ptr, buffer_offset};
 }
 
 u32 RasterizerOpenGL::SetupTextures(Maxwell::ShaderStage stage, GLuint program, u32 current_unit,
@@ -752,14 +1299,15 @@ u32 RasterizerOpenGL::SetupTextures(Maxwell::ShaderStage stage, GLuint program,
 
         glProgramUniform1i(program, uniform, current_bindpoint);
 
-        const auto texture = maxwell3d.GetStageTexture(entry.GetStage(), entry.GetOffset());
+        const auto texture = texture_descriptor_cache.GetStageTexture(maxwell3d, entry.GetStage(),
+                                                                      entry.GetOffset());
 
         if (!texture.enabled) {
             state.texture_units[current_bindpoint].texture_2d = 0;
             continue;
         }
 
-        texture_samplers[current_bindpoint].SyncWithConfig(texture.tsc);
+        state.texture_units[current_bindpoint].sampler = sampler_cache.GetSampler(texture.tsc);
         Surface surface = res_cache.GetTextureSurface(texture);
         if (surface != nullptr) {
             state.texture_units[current_bindpoint].texture_2d = surface->Texture().handle;
@@ -808,14 +1356,28 @@ void RasterizerOpenGL::BindFramebufferSurfaces(const Surface& color_surface,
     }
 }
 
-void RasterizerOpenGL::SyncViewport(const MathUtil::Rectangle<u32>& surfaces_rect) {
+void RasterizerOpenGL::SyncViewport(const MathUtil::Rectangle<u32>& surfaces_rect,
+                                    float resolution_scale) {
+    const auto& last_rect = viewport_surfaces_rect;
+    if (!(dirty_flags & DirtyViewport) && surfaces_rect.left == last_rect.left &&
+        surfaces_rect.top == last_rect.top && surfaces_rect.right == last_rect.right &&
+        surfaces_rect.bottom == last_rect.bottom &&
+        resolution_scale == viewport_resolution_scale) {
+        return;
+    }
+    dirty_flags &= ~DirtyViewport;
+    viewport_surfaces_rect = surfaces_rect;
+    viewport_resolution_scale = resolution_scale;
+
     const auto& regs = Core::System::GetInstance().GPU().Maxwell3D().regs;
     const MathUtil::Rectangle<s32> viewport_rect{regs.viewport_transform[0].GetRect()};
 
-    state.viewport.x = static_cast<GLint>(surfaces_rect.left) + viewport_rect.left;
-    state.viewport.y = static_cast<GLint>(surfaces_rect.bottom) + viewport_rect.bottom;
-    state.viewport.width = static_cast<GLsizei>(viewport_rect.GetWidth());
-    state.viewport.height = static_cast<GLsizei>(viewport_rect.GetHeight());
+    state.viewport.x = static_cast<GLint>(
+        (static_cast<s32>(surfaces_rect.left) + viewport_rect.left) * resolution_scale);
+    state.viewport.y = static_cast<GLint>(
+        (static_cast<s32>(surfaces_rect.bottom) + viewport_rect.bottom) * resolution_scale);
+    state.viewport.width = static_cast<GLsizei>(viewport_rect.GetWidth() * resolution_scale);
+    state.viewport.height = static_cast<GLsizei>(viewport_rect.GetHeight() * resolution_scale);
 }
 
 void RasterizerOpenGL::SyncClipEnabled() {
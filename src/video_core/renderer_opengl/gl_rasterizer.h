@@ -8,19 +8,27 @@
 #include <cstddef>
 #include <memory>
 #include <tuple>
+#include <unordered_map>
 #include <utility>
 #include <vector>
+#include <boost/optional.hpp>
 #include <glad/glad.h>
 #include "common/common_types.h"
+#include "common/hash.h"
 #include "video_core/engines/maxwell_3d.h"
 #include "video_core/memory_manager.h"
+#include "video_core/rasterizer_cached_pages.h"
 #include "video_core/rasterizer_interface.h"
+#include "video_core/renderer_opengl/gl_buffer_cache.h"
+#include "video_core/renderer_opengl/gl_query_cache.h"
 #include "video_core/renderer_opengl/gl_rasterizer_cache.h"
 #include "video_core/renderer_opengl/gl_resource_manager.h"
+#include "video_core/renderer_opengl/gl_sampler_cache.h"
 #include "video_core/renderer_opengl/gl_shader_gen.h"
 #include "video_core/renderer_opengl/gl_shader_manager.h"
 #include "video_core/renderer_opengl/gl_state.h"
 #include "video_core/renderer_opengl/gl_stream_buffer.h"
+#include "video_core/renderer_opengl/gl_texture_descriptor_cache.h"
 
 namespace Core::Frontend {
 class EmuWindow;
@@ -28,6 +36,7 @@ class EmuWindow;
 
 namespace OpenGL {
 
+class ScopeAcquireGLContext;
 struct ScreenInfo;
 
 class RasterizerOpenGL : public VideoCore::RasterizerInterface {
@@ -39,15 +48,25 @@ public:
     void Clear() override;
     void NotifyMaxwellRegisterChanged(u32 method) override;
     void FlushAll() override;
+    void FlushCommands() override;
+    void ResetCounter(VideoCore::QueryType type) override;
+    void Query(Tegra::GPUVAddr addr, VideoCore::QueryType type, bool long_query) override;
+    void TickFrame() override;
+    void LoadDiskResources() override;
+    void ResetGuestState() override;
     void FlushRegion(Tegra::GPUVAddr addr, u64 size) override;
     void InvalidateRegion(Tegra::GPUVAddr addr, u64 size) override;
     void FlushAndInvalidateRegion(Tegra::GPUVAddr addr, u64 size) override;
     bool AccelerateDisplayTransfer(const void* config) override;
     bool AccelerateTextureCopy(const void* config) override;
+    bool AccelerateSurfaceCopy(const Tegra::Engines::Fermi2D::Regs::Surface& src,
+                               const Tegra::Engines::Fermi2D::Regs::Surface& dst) override;
     bool AccelerateFill(const void* config) override;
     bool AccelerateDisplay(const Tegra::FramebufferConfig& config, VAddr framebuffer_addr,
                            u32 pixel_stride) override;
     bool AccelerateDrawBatch(bool is_indexed) override;
+    bool ReadCachedSurface(Tegra::GPUVAddr addr, u32 width, u32 height,
+                           std::vector<u8>& pixels) override;
 
     /// OpenGL shader generated for a given Maxwell register state
     struct MaxwellShader {
@@ -68,45 +87,44 @@ public:
     static_assert(MaxConstbufferSize % sizeof(GLvec4) == 0,
                   "The maximum size of a constbuffer must be a multiple of the size of GLvec4");
 
-private:
-    class SamplerInfo {
-    public:
-        OGLSampler sampler;
-
-        /// Creates the sampler object, initializing its state so that it's in sync with the
-        /// SamplerInfo struct.
-        void Create();
-        /// Syncs the sampler object with the config, updating any necessary state.
-        void SyncWithConfig(const Tegra::Texture::TSCEntry& config);
-
-    private:
-        Tegra::Texture::TextureFilter mag_filter;
-        Tegra::Texture::TextureFilter min_filter;
-        Tegra::Texture::WrapMode wrap_u;
-        Tegra::Texture::WrapMode wrap_v;
-        GLvec4 border_color;
+    /// Groups of host state that are derived from Maxwell3D registers. A group is only synced
+    /// again once one of the registers it is derived from has been written.
+    enum DirtyFlags : u32 {
+        DirtyViewport = 1 << 0,
+        DirtyCullMode = 1 << 1,
+        DirtyDepthTest = 1 << 2,
+        DirtyStencilTest = 1 << 3,
+        DirtyBlend = 1 << 4,
+        DirtyLogicOp = 1 << 5,
+        DirtyAll = (1 << 6) - 1,
     };
 
+private:
     /// Configures the color and depth framebuffer states and returns the dirty <Color, Depth>
     /// surfaces if writing was enabled.
     std::pair<Surface, Surface> ConfigureFramebuffers(bool using_color_fb, bool using_depth_fb,
                                                       bool preserve_contents);
 
+    /**
+     * Clears the color and depth surfaces of the framebuffer straight through their textures,
+     * without binding them or loading their contents. Returns false without touching them if the
+     * clear only writes part of their contents, the viewport doesn't cover them whole, or their
+     * formats can't be cleared this way.
+     */
+    bool ClearSurfacesDirectly(bool use_color_fb, bool use_depth_fb);
+
     /// Binds the framebuffer color and depth surface
     void BindFramebufferSurfaces(const Surface& color_surface, const Surface& depth_surface,
                                  bool has_stencil);
 
     /*
-     * Configures the current constbuffers to use for the draw command.
+     * Configures the current constbuffers to use for the draw command, at the bindpoints the
+     * shader declares them at.
      * @param stage The shader stage to configure buffers for.
-     * @param program The OpenGL program object that contains the specified stage.
-     * @param current_bindpoint The offset at which to start counting new buffer bindpoints.
      * @param entries Vector describing the buffers that are actually used in the guest shader.
-     * @returns The next available bindpoint for use in the next shader stage.
      */
-    std::tuple<u8*, GLintptr, u32> SetupConstBuffers(
+    std::pair<u8*, GLintptr> SetupConstBuffers(
         u8* buffer_ptr, GLintptr buffer_offset, Tegra::Engines::Maxwell3D::Regs::ShaderStage stage,
-        GLuint program, u32 current_bindpoint,
         const std::vector<GLShader::ConstBufferEntry>& entries);
 
     /*
@@ -120,8 +138,8 @@ private:
     u32 SetupTextures(Tegra::Engines::Maxwell3D::Regs::ShaderStage stage, GLuint program,
                       u32 current_unit, const std::vector<GLShader::SamplerEntry>& entries);
 
-    /// Syncs the viewport to match the guest state
-    void SyncViewport(const MathUtil::Rectangle<u32>& surfaces_rect);
+    /// Syncs the viewport to match the guest state, scaled to the resolution of the render targets
+    void SyncViewport(const MathUtil::Rectangle<u32>& surfaces_rect, float resolution_scale);
 
     /// Syncs the clip enabled status to match the guest state
     void SyncClipEnabled();
@@ -156,6 +174,16 @@ private:
 
     OpenGLState state;
 
+    /// DirtyFlags of the state groups whose registers changed since they were last synced.
+    u32 dirty_flags = DirtyAll;
+
+    /// Framebuffer rectangle the viewport was last synced against.
+    MathUtil::Rectangle<u32> viewport_surfaces_rect{};
+    /// Resolution scale of the render targets the viewport was last synced against.
+    float viewport_resolution_scale = 1.0f;
+
+    /// Page counts shared by the caches below, declared first so it outlives them
+    VideoCore::RasterizerCachedPages cached_pages;
     RasterizerCacheOpenGL res_cache;
 
     Core::Frontend::EmuWindow& emu_window;
@@ -164,30 +192,89 @@ private:
 
     std::unique_ptr<GLShader::ProgramManager> shader_program_manager;
     OGLVertexArray sw_vao;
-    OGLVertexArray hw_vao;
 
-    std::array<SamplerInfo, GLShader::NumTextureSamplers> texture_samplers;
+    /// Number of vertex attributes set up on the host, out of the 32 Tegra has
+    static constexpr size_t NumHostVertexAttributes = 16;
+
+    /// State each cached VAO is set up with, the buffer bindings are set for every draw
+    struct VertexFormat {
+        /// Raw formats of the attributes, 0 for invalid ones
+        std::array<u32, NumHostVertexAttributes> attributes;
+        /// Mask of the vertex arrays that are indexed by instance instead of by vertex
+        u32 instanced_arrays;
+    };
+    using VertexFormatKey = Common::HashableStruct<VertexFormat>;
+    struct VertexFormatHash {
+        size_t operator()(const VertexFormatKey& key) const {
+            return key.Hash();
+        }
+    };
+    std::unordered_map<VertexFormatKey, OGLVertexArray, VertexFormatHash> vertex_arrays;
+
+    SamplerCache sampler_cache;
+    QueryCache query_cache;
 
     static constexpr size_t STREAM_BUFFER_SIZE = 128 * 1024 * 1024;
     OGLStreamBuffer stream_buffer;
+    OGLBufferCache buffer_cache;
+    TextureDescriptorCache texture_descriptor_cache;
     OGLBuffer uniform_buffer;
     OGLFramebuffer framebuffer;
     GLint uniform_buffer_alignment;
+    GLint storage_buffer_alignment;
 
     size_t CalculateVertexArraysSize() const;
 
     std::pair<u8*, GLintptr> SetupVertexArrays(u8* array_ptr, GLintptr buffer_offset);
 
+    /// Returns the VAO set up with the given vertex format, creating it on first use
+    GLuint GetVertexArray(const VertexFormatKey& key);
+
     std::pair<u8*, GLintptr> SetupShaders(u8* buffer_ptr, GLintptr buffer_offset);
 
     std::pair<u8*, GLintptr> AlignBuffer(u8* buffer_ptr, GLintptr buffer_offset, size_t alignment);
 
     std::tuple<u8*, GLintptr, GLintptr> UploadMemory(u8* buffer_ptr, GLintptr buffer_offset,
                                                      Tegra::GPUVAddr gpu_addr, size_t size,
-                                                     size_t alignment = 4);
+                                                     size_t alignment = 4, bool cache = false);
+
+    /// Appends the current draw to the pending batch if only its vertex range differs from the
+    /// draws already in it, returns false if it has to be set up on its own instead
+    bool TryExtendDrawBatch();
+
+    /// Records the vertex range of the current draw in the pending batch
+    void AppendToDrawBatch(GLintptr index_buffer_offset);
+
+    /**
+     * Issues the pending draws with a single (multi) draw call. It must be called with the GL
+     * context held, by the GPU side of the rasterizer: the batch never outlives the command list
+     * it was recorded from, so the flush and invalidation hooks of the CPU never find draws in it.
+     */
+    void SubmitDrawBatch();
+
+    /// Acquires the context if flushing the region has to wait for readbacks of the host GPU
+    void AcquireContextForUnfinishedDownloads(
+        boost::optional<ScopeAcquireGLContext>& acquire_context, Tegra::GPUVAddr addr, u64 size);
 
     enum class AccelDraw { Disabled, Arrays, Indexed };
     AccelDraw accelerate_draw = AccelDraw::Disabled;
+
+    /// Draws set up with the same state, waiting to be submitted together
+    struct DrawBatch {
+        GLenum primitive_mode{};
+        bool is_indexed{};
+        GLenum index_format{};
+        u32 instance{};
+        /// Whether the shader stages were still compiling when the batch was set up
+        bool skip_draws{};
+        Surface dirty_color_surface;
+        Surface dirty_depth_surface;
+
+        std::vector<GLsizei> counts;
+        std::vector<GLint> firsts;
+        std::vector<const void*> index_offsets;
+        std::vector<GLint> base_vertices;
+    } draw_batch;
 };
 
 } // namespace OpenGL
@@ -3,17 +3,23 @@
 // Refer to the license.txt file included.
 
 #include <algorithm>
+#include <unordered_set>
+#include <vector>
 #include <glad/glad.h>
 
 #include "common/alignment.h"
 #include "common/assert.h"
 #include "common/microprofile.h"
 #include "common/scope_exit.h"
+#include "common/thread_pool.h"
 #include "core/core.h"
+#include "core/frontend/emu_window.h"
+#include "core/frontend/framebuffer_layout.h"
 #include "core/hle/kernel/process.h"
 #include "core/memory.h"
 #include "core/settings.h"
 #include "video_core/engines/maxwell_3d.h"
+#include "video_core/renderer_base.h"
 #include "video_core/renderer_opengl/gl_rasterizer_cache.h"
 #include "video_core/textures/astc.h"
 #include "video_core/textures/decoders.h"
@@ -21,9 +27,41 @@
 
 namespace OpenGL {
 
-using SurfaceType = SurfaceParams::SurfaceType;
-using PixelFormat = SurfaceParams::PixelFormat;
-using ComponentType = SurfaceParams::ComponentType;
+using VideoCore::Surface::ComponentType;
+using VideoCore::Surface::ComponentTypeFromDepthFormat;
+using VideoCore::Surface::ComponentTypeFromRenderTarget;
+using VideoCore::Surface::ComponentTypeFromTexture;
+using VideoCore::Surface::MaxPixelFormat;
+using VideoCore::Surface::PixelFormat;
+using VideoCore::Surface::PixelFormatFromDepthFormat;
+using VideoCore::Surface::PixelFormatFromGPUPixelFormat;
+using VideoCore::Surface::PixelFormatFromRenderTargetFormat;
+using VideoCore::Surface::PixelFormatFromTextureFormat;
+using VideoCore::Surface::SurfaceType;
+
+static bool IsPixelFormatASTC(PixelFormat format) {
+    switch (format) {
+    case PixelFormat::ASTC_2D_4X4:
+        return true;
+    default:
+        return false;
+    }
+}
+
+/**
+ * Returns the factor render targets are scaled by. The automatic setting picks the largest whole
+ * multiple of the native resolution that fits the window.
+ */
+static float GetResolutionScale() {
+    if (Settings::values.resolution_factor > 0.0f) {
+        return Settings::values.resolution_factor;
+    }
+
+    const auto& layout{
+        Core::System::GetInstance().Renderer().GetRenderWindow().GetFramebufferLayout()};
+    return static_cast<float>(
+        std::max(1U, layout.screen.GetHeight() / Layout::ScreenUndocked::Height));
+}
 
 struct FormatTuple {
     GLint internal_format;
@@ -47,7 +85,17 @@ struct FormatTuple {
     params.width = Common::AlignUp(config.tic.Width(), GetCompressionFactor(params.pixel_format));
     params.height = Common::AlignUp(config.tic.Height(), GetCompressionFactor(params.pixel_format));
     params.unaligned_height = config.tic.Height();
-    params.size_in_bytes = params.SizeInBytes();
+    params.num_levels = 1;
+
+    // Only block linear 2D textures have their mip chain cached, the decoders don't support
+    // mipmapped ASTC yet
+    if (params.is_tiled && !IsPixelFormatASTC(params.pixel_format) &&
+        config.tic.texture_type == Tegra::Texture::TextureType::Texture2D) {
+        params.num_levels = std::min(config.tic.NumMipLevels(), MaxMipLevels);
+    }
+    params.size_in_bytes =
+        params.num_levels > 1 ? params.GetMipLevelOffset(params.num_levels) : params.SizeInBytes();
+    params.resolution_scale = 1.0f;
     params.cache_width = Common::AlignUp(params.width, 16);
     params.cache_height = Common::AlignUp(params.height, 16);
     return params;
@@ -66,7 +114,30 @@ struct FormatTuple {
     params.width = config.width;
     params.height = config.height;
     params.unaligned_height = config.height;
+    params.num_levels = 1;
+    params.size_in_bytes = params.SizeInBytes();
+    params.resolution_scale = GetResolutionScale();
+    params.cache_width = Common::AlignUp(params.width, 16);
+    params.cache_height = Common::AlignUp(params.height, 16);
+    return params;
+}
+
+/*static*/ SurfaceParams SurfaceParams::CreateForDisplay(const Tegra::FramebufferConfig& config,
+                                                         Tegra::GPUVAddr gpu_addr) {
+
+    SurfaceParams params{};
+    params.addr = gpu_addr;
+    params.is_tiled = true;
+    params.block_height = Tegra::Texture::TICEntry::DefaultBlockHeight;
+    params.pixel_format = PixelFormatFromGPUPixelFormat(config.pixel_format);
+    params.component_type = ComponentType::UNorm;
+    params.type = GetFormatType(params.pixel_format);
+    params.width = config.width;
+    params.height = config.height;
+    params.unaligned_height = config.height;
+    params.num_levels = 1;
     params.size_in_bytes = params.SizeInBytes();
+    params.resolution_scale = 1.0f;
     params.cache_width = Common::AlignUp(params.width, 16);
     params.cache_height = Common::AlignUp(params.height, 16);
     return params;
@@ -87,17 +158,19 @@ struct FormatTuple {
     params.width = zeta_width;
     params.height = zeta_height;
     params.unaligned_height = zeta_height;
+    params.num_levels = 1;
     params.size_in_bytes = params.SizeInBytes();
+    params.resolution_scale = GetResolutionScale();
     params.cache_width = Common::AlignUp(params.width, 16);
     params.cache_height = Common::AlignUp(params.height, 16);
     return params;
 }
 
-static constexpr std::array<FormatTuple, SurfaceParams::MaxPixelFormat> tex_format_tuples = {{
+static constexpr std::array<FormatTuple, MaxPixelFormat> tex_format_tuples = {{
     {GL_RGBA8, GL_RGBA, GL_UNSIGNED_INT_8_8_8_8_REV, ComponentType::UNorm, false}, // ABGR8U
     {GL_RGBA8, GL_RGBA, GL_BYTE, ComponentType::SNorm, false},                     // ABGR8S
     {GL_RGBA8UI, GL_RGBA_INTEGER, GL_UNSIGNED_BYTE, ComponentType::UInt, false},   // ABGR8UI
-    {GL_RGB, GL_RGB, GL_UNSIGNED_SHORT_5_6_5_REV, ComponentType::UNorm, false},    // B5G6R5U
+    {GL_RGB565, GL_RGB, GL_UNSIGNED_SHORT_5_6_5_REV, ComponentType::UNorm, false}, // B5G6R5U
     {GL_RGB10_A2, GL_RGBA, GL_UNSIGNED_INT_2_10_10_10_REV, ComponentType::UNorm,
      false}, // A2B10G10R10U
     {GL_RGB5_A1, GL_RGBA, GL_UNSIGNED_SHORT_1_5_5_5_REV, ComponentType::UNorm, false}, // A1B5G5R5U
@@ -167,18 +240,32 @@ static const FormatTuple& GetFormatTuple(PixelFormat pixel_format, ComponentType
     return format;
 }
 
-VAddr SurfaceParams::GetCpuAddr() const {
-    const auto& gpu = Core::System::GetInstance().GPU();
-    return *gpu.memory_manager->GpuToCpuAddress(addr);
+u32 SurfaceParams::GetMipBlockHeight(u32 level) const {
+    if (level == 0) {
+        return block_height;
+    }
+    return Tegra::Texture::CalculateMipmapBlockHeight(
+        GetMipHeight(level) / GetCompressionFactor(pixel_format), block_height);
 }
 
-static bool IsPixelFormatASTC(PixelFormat format) {
-    switch (format) {
-    case PixelFormat::ASTC_2D_4X4:
-        return true;
-    default:
-        return false;
+size_t SurfaceParams::GetMipLevelOffset(u32 level) const {
+    size_t offset = 0;
+    for (u32 i = 0; i < level; ++i) {
+        offset += GetMipLevelSize(i);
     }
+    return offset;
+}
+
+size_t SurfaceParams::GetMipLevelSize(u32 level) const {
+    const u32 compression_factor{GetCompressionFactor(pixel_format)};
+    return Tegra::Texture::CalculateBlockLinearSize(
+        GetMipWidth(level) / compression_factor, GetMipHeight(level) / compression_factor,
+        VideoCore::Surface::GetFormatBpp(pixel_format) / CHAR_BIT, GetMipBlockHeight(level));
+}
+
+VAddr SurfaceParams::GetCpuAddr() const {
+    const auto& gpu = Core::System::GetInstance().GPU();
+    return *gpu.memory_manager->GpuToCpuAddress(addr);
 }
 
 static std::pair<u32, u32> GetASTCBlockSize(PixelFormat format) {
@@ -200,6 +287,14 @@ MathUtil::Rectangle<u32> SurfaceParams::GetRect() const {
     return {0, actual_height, width, 0};
 }
 
+MathUtil::Rectangle<u32> SurfaceParams::GetScaledRect() const {
+    const auto scale = [this](u32 value) {
+        return value == 0 ? 0 : std::max(1U, static_cast<u32>(value * resolution_scale));
+    };
+    const auto rect{GetRect()};
+    return {scale(rect.left), scale(rect.top), scale(rect.right), scale(rect.bottom)};
+}
+
 /// Returns true if the specified PixelFormat is a BCn format, e.g. DXT or DXN
 static bool IsFormatBCn(PixelFormat format) {
     switch (format) {
@@ -218,7 +313,7 @@ static bool IsFormatBCn(PixelFormat format) {
 template <bool morton_to_gl, PixelFormat format>
 void MortonCopy(u32 stride, u32 block_height, u32 height, std::vector<u8>& gl_buffer,
                 Tegra::GPUVAddr addr) {
-    constexpr u32 bytes_per_pixel = SurfaceParams::GetFormatBpp(format) / CHAR_BIT;
+    constexpr u32 bytes_per_pixel = GetFormatBpp(format) / CHAR_BIT;
     constexpr u32 gl_bytes_per_pixel = CachedSurface::GetGLBytesPerPixel(format);
     const auto& gpu = Core::System::GetInstance().GPU();
 
@@ -235,15 +330,24 @@ void MortonCopy(u32 stride, u32 block_height, u32 height, std::vector<u8>& gl_bu
         // TODO(bunnei): Assumes the default rendering GOB size of 16 (128 lines). We should
         // check the configuration for this and perform more generic un/swizzle
         LOG_WARNING(Render_OpenGL, "need to use correct swizzle/GOB parameters!");
-        VideoCore::MortonCopyPixels128(
-            stride, height, bytes_per_pixel, gl_bytes_per_pixel,
-            Memory::GetPointer(*gpu.memory_manager->GpuToCpuAddress(addr)), gl_buffer.data(),
-            morton_to_gl);
+        u8* const morton_data = Memory::GetPointer(*gpu.memory_manager->GpuToCpuAddress(addr));
+
+        // Every band of 128 lines is laid out independently, so they can be swizzled in parallel.
+        constexpr u32 band_height = 128;
+        const u32 num_bands = (height + band_height - 1) / band_height;
+        Common::GetSharedThreadPool().ParallelFor(num_bands, [&](size_t band) {
+            const u32 y = static_cast<u32>(band) * band_height;
+            VideoCore::MortonCopyPixels128(stride, std::min(band_height, height - y),
+                                           bytes_per_pixel, gl_bytes_per_pixel,
+                                           morton_data + y * stride * bytes_per_pixel,
+                                           gl_buffer.data() + y * stride * gl_bytes_per_pixel,
+                                           morton_to_gl);
+        });
     }
 }
 
 static constexpr std::array<void (*)(u32, u32, u32, std::vector<u8>&, Tegra::GPUVAddr),
-                            SurfaceParams::MaxPixelFormat>
+                            MaxPixelFormat>
     morton_to_gl_fns = {
         // clang-format off
         MortonCopy<true, PixelFormat::ABGR8U>,
@@ -298,7 +402,7 @@ static constexpr std::array<void (*)(u32, u32, u32, std::vector<u8>&, Tegra::GPU
 };
 
 static constexpr std::array<void (*)(u32, u32, u32, std::vector<u8>&, Tegra::GPUVAddr),
-                            SurfaceParams::MaxPixelFormat>
+                            MaxPixelFormat>
     gl_to_morton_fns = {
         // clang-format off
         MortonCopy<false, PixelFormat::ABGR8U>,
@@ -354,9 +458,16 @@ static constexpr std::array<void (*)(u32, u32, u32, std::vector<u8>&, Tegra::GPU
         // clang-format on
 };
 
+static void SetSurfaceTextureParameters(GLuint texture, u32 num_levels) {
+    glTextureParameteri(texture, GL_TEXTURE_MAX_LEVEL, static_cast<GLint>(num_levels - 1));
+    glTextureParameteri(texture, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTextureParameteri(texture, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTextureParameteri(texture, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+}
+
 // Allocate an uninitialized texture of appropriate size and format for the surface
 static void AllocateSurfaceTexture(GLuint texture, const FormatTuple& format_tuple, u32 width,
-                                   u32 height) {
+                                   u32 height, u32 num_levels) {
     OpenGLState cur_state = OpenGLState::GetCurState();
 
     // Keep track of previous texture bindings
@@ -366,21 +477,110 @@ static void AllocateSurfaceTexture(GLuint texture, const FormatTuple& format_tup
     glActiveTexture(GL_TEXTURE0);
 
     if (!format_tuple.compressed) {
-        // Only pre-create the texture for non-compressed textures.
-        glTexImage2D(GL_TEXTURE_2D, 0, format_tuple.internal_format, width, height, 0,
-                     format_tuple.format, format_tuple.type, nullptr);
+        // Only pre-create the texture for non-compressed textures. Immutable storage is required
+        // for other surfaces to alias this one through texture views.
+        if (GLAD_GL_ARB_texture_storage) {
+            glTexStorage2D(GL_TEXTURE_2D, static_cast<GLsizei>(num_levels),
+                           format_tuple.internal_format, width, height);
+        } else {
+            for (u32 level = 0; level < num_levels; ++level) {
+                glTexImage2D(GL_TEXTURE_2D, static_cast<GLint>(level), format_tuple.internal_format,
+                             std::max(1U, width >> level), std::max(1U, height >> level), 0,
+                             format_tuple.format, format_tuple.type, nullptr);
+            }
+        }
     }
 
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    SetSurfaceTextureParameters(texture, num_levels);
 
     // Restore previous texture bindings
     cur_state.texture_units[0].texture_2d = old_tex;
     cur_state.Apply();
 }
 
+/**
+ * Returns the size in bits of the texture view compatibility class the internal format belongs
+ * to, or 0 if it can't be reinterpreted through a texture view. Formats are only view compatible
+ * within the same class.
+ */
+static u32 GetViewClassBits(GLenum internal_format) {
+    switch (internal_format) {
+    case GL_RGBA32F:
+    case GL_RGBA32UI:
+        return 128;
+    case GL_RGB32F:
+        return 96;
+    case GL_RGBA16F:
+    case GL_RGBA16:
+    case GL_RGBA16UI:
+    case GL_RG32F:
+    case GL_RG32UI:
+        return 64;
+    case GL_RGBA8:
+    case GL_RGBA8UI:
+    case GL_SRGB8_ALPHA8:
+    case GL_RGB10_A2:
+    case GL_R11F_G11F_B10F:
+    case GL_RG16:
+    case GL_RG16F:
+    case GL_RG16UI:
+    case GL_RG16I:
+    case GL_RG16_SNORM:
+    case GL_R32F:
+    case GL_R32UI:
+        return 32;
+    case GL_RG8:
+    case GL_R16:
+    case GL_R16F:
+    case GL_R16UI:
+    case GL_R16I:
+    case GL_R16_SNORM:
+        return 16;
+    case GL_R8:
+    case GL_R8UI:
+        return 8;
+    default:
+        return 0;
+    }
+}
+
+/**
+ * Returns whether a surface can be reinterpreted with new parameters through a texture view of its
+ * storage, getting the same texels a round-trip through a pixel buffer would.
+ */
+static bool CanAliasSurface(const SurfaceParams& params, const SurfaceParams& new_params) {
+    if (!GLAD_GL_ARB_texture_storage || !GLAD_GL_ARB_texture_view) {
+        return false;
+    }
+
+    // Depth and stencil data can't be viewed as color, and the views can't be resized
+    const auto& rect{params.GetScaledRect()};
+    const auto& new_rect{new_params.GetScaledRect()};
+    if (params.type != SurfaceType::ColorTexture || new_params.type != SurfaceType::ColorTexture ||
+        params.resolution_scale != new_params.resolution_scale ||
+        rect.GetWidth() != new_rect.GetWidth() || rect.GetHeight() != new_rect.GetHeight()) {
+        return false;
+    }
+
+    // ASTC is decoded on the CPU and BGRA8 is swizzled on upload, so their texels don't match
+    // the bytes in memory
+    if (IsPixelFormatASTC(params.pixel_format) || IsPixelFormatASTC(new_params.pixel_format) ||
+        params.pixel_format == PixelFormat::BGRA8 ||
+        new_params.pixel_format == PixelFormat::BGRA8) {
+        return false;
+    }
+
+    const FormatTuple& tuple = GetFormatTuple(params.pixel_format, params.component_type);
+    const FormatTuple& new_tuple =
+        GetFormatTuple(new_params.pixel_format, new_params.component_type);
+    if (tuple.compressed || new_tuple.compressed) {
+        return false;
+    }
+
+    const u32 view_class = GetViewClassBits(tuple.internal_format);
+    return view_class != 0 && view_class == GetViewClassBits(new_tuple.internal_format);
+}
+
 static bool BlitTextures(GLuint src_tex, const MathUtil::Rectangle<u32>& src_rect, GLuint dst_tex,
                          const MathUtil::Rectangle<u32>& dst_rect, SurfaceType type,
                          GLuint read_fb_handle, GLuint draw_fb_handle) {
@@ -435,12 +635,41 @@ static bool BlitTextures(GLuint src_tex, const MathUtil::Rectangle<u32>& src_rec
     return true;
 }
 
+void CachedSurface::MarkAsModified(bool modified) {
+    if (modified && !is_modified) {
+        // Flushing the surface cleared the flush-pending state of the pages its flush was
+        // triggered by, the next CPU access to any of them has to flush it again
+        Memory::RasterizerMarkRegionModified(params.addr, params.size_in_bytes);
+    }
+    is_modified = modified;
+}
+
 CachedSurface::CachedSurface(const SurfaceParams& params) : params(params) {
     texture.Create();
-    const auto& rect{params.GetRect()};
+    const auto& rect{params.GetScaledRect()};
     AllocateSurfaceTexture(texture.handle,
                            GetFormatTuple(params.pixel_format, params.component_type),
-                           rect.GetWidth(), rect.GetHeight());
+                           rect.GetWidth(), rect.GetHeight(), params.num_levels);
+}
+
+void CachedSurface::InvalidateMipLevels(Tegra::GPUVAddr region_addr, size_t region_size) {
+    const Tegra::GPUVAddr region_end = region_addr + region_size;
+    for (u32 level = 0; level < params.num_levels; ++level) {
+        const Tegra::GPUVAddr level_addr = params.addr + params.GetMipLevelOffset(level);
+        const Tegra::GPUVAddr level_end = level_addr + params.GetMipLevelSize(level);
+        if (region_addr < level_end && level_addr < region_end) {
+            dirty_levels |= 1U << level;
+        }
+    }
+}
+
+CachedSurface::CachedSurface(const SurfaceParams& params, const CachedSurface& aliased_surface)
+    : params(params) {
+    texture.Create();
+    glTextureView(texture.handle, GL_TEXTURE_2D, aliased_surface.texture.handle,
+                  GetFormatTuple(params.pixel_format, params.component_type).internal_format, 0,
+                  params.num_levels, 0, 1);
+    SetSurfaceTextureParameters(texture.handle, params.num_levels);
 }
 
 static void ConvertS8Z24ToZ24S8(std::vector<u8>& data, u32 width, u32 height) {
@@ -529,15 +758,18 @@ static void ConvertFormatAsNeeded_FlushGLBuffer(std::vector<u8>& /*data*/, Pixel
 }
 
 MICROPROFILE_DEFINE(OpenGL_SurfaceLoad, "OpenGL", "Surface Load", MP_RGB(128, 64, 192));
-void CachedSurface::LoadGLBuffer() {
+void CachedSurface::LoadGLBuffer(u32 level) {
     ASSERT(params.type != SurfaceType::Fill);
+    ASSERT(level < params.num_levels);
 
     const u8* const texture_src_data = Memory::GetPointer(params.GetCpuAddr());
 
     ASSERT(texture_src_data);
 
+    const u32 width = params.GetMipWidth(level);
+    const u32 height = params.GetMipHeight(level);
     const u32 bytes_per_pixel = GetGLBytesPerPixel(params.pixel_format);
-    const u32 copy_size = params.width * params.height * bytes_per_pixel;
+    const u32 copy_size = width * height * bytes_per_pixel;
 
     MICROPROFILE_SCOPE(OpenGL_SurfaceLoad);
 
@@ -545,14 +777,16 @@ void CachedSurface::LoadGLBuffer() {
         gl_buffer.resize(copy_size);
 
         morton_to_gl_fns[static_cast<size_t>(params.pixel_format)](
-            params.width, params.block_height, params.height, gl_buffer, params.addr);
+            width, params.GetMipBlockHeight(level), height, gl_buffer,
+            params.addr + params.GetMipLevelOffset(level));
     } else {
         const u8* const texture_src_data_end = texture_src_data + copy_size;
 
         gl_buffer.assign(texture_src_data, texture_src_data_end);
     }
 
-    ConvertFormatAsNeeded_LoadGLBuffer(gl_buffer, params.pixel_format, params.width, params.height);
+    ConvertFormatAsNeeded_LoadGLBuffer(gl_buffer, params.pixel_format, width, height);
+    gl_buffer_memory.Update(gl_buffer.capacity());
 }
 
 MICROPROFILE_DEFINE(OpenGL_SurfaceFlush, "OpenGL", "Surface Flush", MP_RGB(128, 192, 64));
@@ -576,62 +810,155 @@ void CachedSurface::FlushGLBuffer() {
     }
 }
 
+/// Size of the ring used to stage pixel transfers, surfaces larger than this bypass it
+constexpr GLsizeiptr STAGING_BUFFER_SIZE = 32 * 1024 * 1024;
+/// Alignment of staged transfers within the ring, enough for any pixel or block size
+constexpr GLintptr STAGING_BUFFER_ALIGNMENT = 256;
+
 MICROPROFILE_DEFINE(OpenGL_TextureUL, "OpenGL", "Texture Upload", MP_RGB(128, 64, 192));
-void CachedSurface::UploadGLTexture(GLuint read_fb_handle, GLuint draw_fb_handle) {
+MICROPROFILE_COUNTER_DEFINE(OpenGL_TextureULBytes, "OpenGL", "Texture Upload Bytes", PerFrame);
+
+void CachedSurface::UploadGLTexture(u32 level, GLuint read_fb_handle, GLuint draw_fb_handle,
+                                    OGLStagingBuffer& staging_buffer) {
     if (params.type == SurfaceType::Fill)
         return;
 
     MICROPROFILE_SCOPE(OpenGL_TextureUL);
 
-    ASSERT(gl_buffer.size() ==
-           params.width * params.height * GetGLBytesPerPixel(params.pixel_format));
-
-    const auto& rect{params.GetRect()};
+    const u32 width = params.GetMipWidth(level);
+    const u32 height = params.GetMipHeight(level);
+    ASSERT(gl_buffer.size() == width * height * GetGLBytesPerPixel(params.pixel_format));
 
     // Load data from memory to the surface
-    GLint x0 = static_cast<GLint>(rect.left);
-    GLint y0 = static_cast<GLint>(rect.bottom);
-    size_t buffer_offset = (y0 * params.width + x0) * GetGLBytesPerPixel(params.pixel_format);
+    const size_t buffer_offset = GetMipLevelRectOffset(level);
+
+    // Copy the pixels to the staging buffer so the driver can source them asynchronously,
+    // instead of having to copy them out of gl_buffer before the call returns
+    const GLsizeiptr upload_size = static_cast<GLsizeiptr>(gl_buffer.size() - buffer_offset);
+    const bool use_staging =
+        staging_buffer.IsAvailable() && upload_size <= staging_buffer.GetSize();
+    const u8* pixels = &gl_buffer[buffer_offset];
+    if (use_staging) {
+        u8* staging_ptr;
+        GLintptr staging_offset;
+        std::tie(staging_ptr, staging_offset) =
+            staging_buffer.Map(upload_size, STAGING_BUFFER_ALIGNMENT);
+        std::memcpy(staging_ptr, pixels, upload_size);
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, staging_buffer.GetHandle());
+        pixels = reinterpret_cast<const u8*>(staging_offset);
+    }
+
+    WriteGLTexture(level, pixels);
+    MICROPROFILE_COUNTER_ADD(OpenGL_TextureULBytes, upload_size);
+
+    if (use_staging) {
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        staging_buffer.Unmap(upload_size);
+    }
+}
+
+bool CachedSurface::DecodeGLTexture(u32 level, ComputeTextureDecoder& decoder,
+                                    OGLStagingBuffer& staging_buffer) {
+    if (params.type == SurfaceType::Fill || !params.is_tiled ||
+        IsPixelFormatASTC(params.pixel_format)) {
+        return false;
+    }
+
+    // Same conversions as ConvertFormatAsNeeded_LoadGLBuffer
+    ComputeTextureDecoder::Conversion conversion{ComputeTextureDecoder::Conversion::None};
+    switch (params.pixel_format) {
+    case PixelFormat::S8Z24:
+        conversion = ComputeTextureDecoder::Conversion::S8Z24ToZ24S8;
+        break;
+    case PixelFormat::G8R8U:
+    case PixelFormat::G8R8S:
+        conversion = ComputeTextureDecoder::Conversion::G8R8ToR8G8;
+        break;
+    default:
+        break;
+    }
+
+    // BCn surfaces are swizzled as rows of 4x4 blocks instead of rows of pixels
+    const u32 compression_factor{GetCompressionFactor(params.pixel_format)};
+    const u32 pitch{params.GetMipWidth(level) / compression_factor *
+                    GetFormatBpp(params.pixel_format) / CHAR_BIT};
+    const u32 rows{params.GetMipHeight(level) / compression_factor};
+
+    const u8* const swizzled_data =
+        Memory::GetPointer(params.GetCpuAddr() + params.GetMipLevelOffset(level));
+    ASSERT(swizzled_data);
+
+    if (!decoder.Decode(staging_buffer, swizzled_data, params.GetMipLevelSize(level), pitch, rows,
+                        params.GetMipBlockHeight(level), conversion)) {
+        return false;
+    }
+
+    MICROPROFILE_SCOPE(OpenGL_TextureUL);
+
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, decoder.GetOutputHandle());
+    WriteGLTexture(level, reinterpret_cast<const GLvoid*>(GetMipLevelRectOffset(level)));
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    return true;
+}
+
+MathUtil::Rectangle<u32> CachedSurface::GetMipLevelRect(u32 level) const {
+    // Only the base level can be cropped
+    if (level == 0) {
+        return params.GetRect();
+    }
+    return {0, params.GetMipHeight(level), params.GetMipWidth(level), 0};
+}
+
+size_t CachedSurface::GetMipLevelRectOffset(u32 level) const {
+    const auto rect{GetMipLevelRect(level)};
+    return (rect.bottom * params.GetMipWidth(level) + rect.left) *
+           GetGLBytesPerPixel(params.pixel_format);
+}
+
+void CachedSurface::WriteGLTexture(u32 level, const GLvoid* pixels) {
+    const u32 width = params.GetMipWidth(level);
+    const u32 height = params.GetMipHeight(level);
+    const auto rect{GetMipLevelRect(level)};
+    const GLint x0 = static_cast<GLint>(rect.left);
+    const GLint y0 = static_cast<GLint>(rect.bottom);
 
     const FormatTuple& tuple = GetFormatTuple(params.pixel_format, params.component_type);
-    GLuint target_tex = texture.handle;
+    GLuint target_tex = GetTransferTexture();
     OpenGLState cur_state = OpenGLState::GetCurState();
 
     GLuint old_tex = cur_state.texture_units[0].texture_2d;
     cur_state.texture_units[0].texture_2d = target_tex;
     cur_state.Apply();
 
-    // Ensure no bad interactions with GL_UNPACK_ALIGNMENT
-    ASSERT(params.width * GetGLBytesPerPixel(params.pixel_format) % 4 == 0);
-    glPixelStorei(GL_UNPACK_ROW_LENGTH, static_cast<GLint>(params.width));
+    // The rows of small mipmap levels may not be 4 byte aligned, gl_buffer is tightly packed
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, static_cast<GLint>(width));
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
 
     glActiveTexture(GL_TEXTURE0);
     if (tuple.compressed) {
-        glCompressedTexImage2D(
-            GL_TEXTURE_2D, 0, tuple.internal_format, static_cast<GLsizei>(params.width),
-            static_cast<GLsizei>(params.height), 0, static_cast<GLsizei>(params.size_in_bytes),
-            &gl_buffer[buffer_offset]);
+        const u32 compression_factor{GetCompressionFactor(params.pixel_format)};
+        const size_t compressed_size{(width / compression_factor) * (height / compression_factor) *
+                                     GetFormatBpp(params.pixel_format) / CHAR_BIT};
+        // The data covers whole blocks, but the level must have its exact size to be complete
+        glCompressedTexImage2D(GL_TEXTURE_2D, static_cast<GLint>(level), tuple.internal_format,
+                               static_cast<GLsizei>(std::max(1U, params.width >> level)),
+                               static_cast<GLsizei>(std::max(1U, params.height >> level)), 0,
+                               static_cast<GLsizei>(compressed_size), pixels);
     } else {
-        glTexSubImage2D(GL_TEXTURE_2D, 0, x0, y0, static_cast<GLsizei>(rect.GetWidth()),
+        glTexSubImage2D(GL_TEXTURE_2D, static_cast<GLint>(level), x0, y0,
+                        static_cast<GLsizei>(rect.GetWidth()),
                         static_cast<GLsizei>(rect.GetHeight()), tuple.format, tuple.type,
-                        &gl_buffer[buffer_offset]);
+                        pixels);
     }
 
     glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
 
     cur_state.texture_units[0].texture_2d = old_tex;
     cur_state.Apply();
 }
 
-MICROPROFILE_DEFINE(OpenGL_TextureDL, "OpenGL", "Texture Download", MP_RGB(128, 192, 64));
-void CachedSurface::DownloadGLTexture(GLuint read_fb_handle, GLuint draw_fb_handle) {
-    if (params.type == SurfaceType::Fill)
-        return;
-
-    MICROPROFILE_SCOPE(OpenGL_TextureDL);
-
-    gl_buffer.resize(params.width * params.height * GetGLBytesPerPixel(params.pixel_format));
-
+void CachedSurface::ReadGLTexture(GLuint read_fb_handle, GLvoid* pixels) {
     OpenGLState state = OpenGLState::GetCurState();
     OpenGLState prev_state = state;
     SCOPE_EXIT({ prev_state.Apply(); });
@@ -643,48 +970,194 @@ void CachedSurface::DownloadGLTexture(GLuint read_fb_handle, GLuint draw_fb_hand
     glPixelStorei(GL_PACK_ROW_LENGTH, static_cast<GLint>(params.width));
 
     const auto& rect{params.GetRect()};
-    size_t buffer_offset =
-        (rect.bottom * params.width + rect.left) * GetGLBytesPerPixel(params.pixel_format);
+    const GLuint source_tex = GetTransferTexture();
 
-    state.UnbindTexture(texture.handle);
+    state.UnbindTexture(source_tex);
     state.draw.read_framebuffer = read_fb_handle;
     state.Apply();
 
     if (params.type == SurfaceType::ColorTexture) {
-        glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D,
-                               texture.handle, 0);
+        glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, source_tex,
+                               0);
         glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_TEXTURE_2D, 0,
                                0);
     } else if (params.type == SurfaceType::Depth) {
         glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, 0, 0);
-        glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D,
-                               texture.handle, 0);
+        glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, source_tex,
+                               0);
         glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_STENCIL_ATTACHMENT, GL_TEXTURE_2D, 0, 0);
     } else {
         glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, 0, 0);
         glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_TEXTURE_2D,
-                               texture.handle, 0);
+                               source_tex, 0);
     }
     glReadPixels(static_cast<GLint>(rect.left), static_cast<GLint>(rect.bottom),
                  static_cast<GLsizei>(rect.GetWidth()), static_cast<GLsizei>(rect.GetHeight()),
-                 tuple.format, tuple.type, &gl_buffer[buffer_offset]);
+                 tuple.format, tuple.type, pixels);
 
     glPixelStorei(GL_PACK_ROW_LENGTH, 0);
 }
 
-RasterizerCacheOpenGL::RasterizerCacheOpenGL() {
+size_t CachedSurface::ResizeGLBufferForDownload() {
+    gl_buffer.resize(params.width * params.height * GetGLBytesPerPixel(params.pixel_format));
+    gl_buffer_memory.Update(gl_buffer.capacity());
+
+    const auto& rect{params.GetRect()};
+    return (rect.bottom * params.width + rect.left) * GetGLBytesPerPixel(params.pixel_format);
+}
+
+MICROPROFILE_DEFINE(OpenGL_TextureDL, "OpenGL", "Texture Download", MP_RGB(128, 192, 64));
+void CachedSurface::DownloadGLTexture(GLuint read_fb_handle, GLuint draw_fb_handle,
+                                      OGLStagingBuffer& staging_buffer) {
+    if (params.type == SurfaceType::Fill)
+        return;
+
+    MICROPROFILE_SCOPE(OpenGL_TextureDL);
+
+    const size_t buffer_offset = ResizeGLBufferForDownload();
+
+    // Read back into the staging buffer so the transfer is a DMA rather than a driver copy into
+    // client memory, then wait on its fence before copying the pixels out
+    const GLsizeiptr download_size = static_cast<GLsizeiptr>(gl_buffer.size() - buffer_offset);
+    if (!staging_buffer.IsAvailable() || download_size > staging_buffer.GetSize()) {
+        ReadGLTexture(read_fb_handle, &gl_buffer[buffer_offset]);
+        return;
+    }
+
+    u8* staging_ptr;
+    GLintptr staging_offset;
+    std::tie(staging_ptr, staging_offset) =
+        staging_buffer.Map(download_size, STAGING_BUFFER_ALIGNMENT);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, staging_buffer.GetHandle());
+    ReadGLTexture(read_fb_handle, reinterpret_cast<GLvoid*>(staging_offset));
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    staging_buffer.Unmap(download_size);
+
+    staging_buffer.Wait(staging_offset, download_size);
+    std::memcpy(&gl_buffer[buffer_offset], staging_ptr, download_size);
+}
+
+MICROPROFILE_DEFINE(OpenGL_TextureDLBegin, "OpenGL", "Texture Download Begin",
+                    MP_RGB(128, 192, 64));
+void CachedSurface::BeginDownloadGLTexture(GLuint read_fb_handle) {
+    if (params.type == SurfaceType::Fill)
+        return;
+
+    MICROPROFILE_SCOPE(OpenGL_TextureDLBegin);
+
+    const GLsizeiptr download_size = static_cast<GLsizeiptr>(
+        params.width * params.height * GetGLBytesPerPixel(params.pixel_format));
+
+    // The readback can't go through the staging ring, as the chunk could be handed out again
+    // before the guest gets to read the data. Each render target gets a buffer of its own.
+    if (download_pbo.handle == 0 || download_pbo_size < download_size) {
+        download_pbo.Release();
+        download_pbo.Create();
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, download_pbo.handle);
+        glBufferData(GL_PIXEL_PACK_BUFFER, download_size, nullptr, GL_STREAM_READ);
+        download_pbo_size = download_size;
+    } else {
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, download_pbo.handle);
+    }
+
+    const auto& rect{params.GetRect()};
+    const size_t buffer_offset =
+        (rect.bottom * params.width + rect.left) * GetGLBytesPerPixel(params.pixel_format);
+    ReadGLTexture(read_fb_handle, reinterpret_cast<GLvoid*>(buffer_offset));
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    download_fence.Release();
+    download_fence.Create();
+    download_ready = false;
+}
+
+MICROPROFILE_DEFINE(OpenGL_TextureDLFinish, "OpenGL", "Texture Download Finish",
+                    MP_RGB(128, 192, 64));
+void CachedSurface::FinishDownloadGLTexture() {
+    ASSERT(HasPendingDownload());
+
+    MICROPROFILE_SCOPE(OpenGL_TextureDLFinish);
+
+    glClientWaitSync(download_fence.handle, GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED);
+    download_fence.Release();
+
+    const size_t buffer_offset = ResizeGLBufferForDownload();
+    const GLsizeiptr download_size = static_cast<GLsizeiptr>(gl_buffer.size() - buffer_offset);
+
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, download_pbo.handle);
+    const void* const mapped_ptr = glMapBufferRange(
+        GL_PIXEL_PACK_BUFFER, static_cast<GLintptr>(buffer_offset), download_size, GL_MAP_READ_BIT);
+    ASSERT(mapped_ptr);
+    std::memcpy(&gl_buffer[buffer_offset], mapped_ptr, download_size);
+    glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    download_ready = true;
+}
+
+bool CachedSurface::TryFinishDownloadGLTexture() {
+    if (download_fence.handle == 0) {
+        return download_ready;
+    }
+    if (glClientWaitSync(download_fence.handle, GL_SYNC_FLUSH_COMMANDS_BIT, 0) ==
+        GL_TIMEOUT_EXPIRED) {
+        return false;
+    }
+    FinishDownloadGLTexture();
+    return true;
+}
+
+void CachedSurface::CancelPendingDownload() {
+    download_fence.Release();
+    ReleaseGLBuffer();
+}
+
+GLuint CachedSurface::GetTransferTexture() {
+    if (!params.IsScaled()) {
+        return texture.handle;
+    }
+
+    if (native_texture.handle == 0) {
+        native_texture.Create();
+        const auto& rect{params.GetRect()};
+        AllocateSurfaceTexture(native_texture.handle,
+                               GetFormatTuple(params.pixel_format, params.component_type),
+                               rect.GetWidth(), rect.GetHeight(), params.num_levels);
+    }
+    return native_texture.handle;
+}
+
+void CachedSurface::UpscaleFromNativeTexture(GLuint read_fb_handle, GLuint draw_fb_handle) {
+    if (!params.IsScaled() || params.type == SurfaceType::Fill) {
+        return;
+    }
+    BlitTextures(GetTransferTexture(), params.GetRect(), texture.handle, params.GetScaledRect(),
+                 params.type, read_fb_handle, draw_fb_handle);
+}
+
+void CachedSurface::DownscaleToNativeTexture(GLuint read_fb_handle, GLuint draw_fb_handle) {
+    if (!params.IsScaled() || params.type == SurfaceType::Fill) {
+        return;
+    }
+    BlitTextures(texture.handle, params.GetScaledRect(), GetTransferTexture(), params.GetRect(),
+                 params.type, read_fb_handle, draw_fb_handle);
+}
+
+RasterizerCacheOpenGL::RasterizerCacheOpenGL(VideoCore::RasterizerCachedPages& cached_pages)
+    : cached_pages{cached_pages}, staging_buffer(STAGING_BUFFER_SIZE) {
     read_framebuffer.Create();
     draw_framebuffer.Create();
 }
 
 RasterizerCacheOpenGL::~RasterizerCacheOpenGL() {
-    while (!surface_cache.empty()) {
-        UnregisterSurface(surface_cache.begin()->second);
-    }
+    InvalidateAll();
 }
 
 Surface RasterizerCacheOpenGL::GetTextureSurface(const Tegra::Texture::FullTextureInfo& config) {
-    return GetSurface(SurfaceParams::CreateForTexture(config));
+    const Surface surface{GetSurface(SurfaceParams::CreateForTexture(config))};
+    if (surface) {
+        surface->MarkAsUsed(current_frame);
+    }
+    return surface;
 }
 
 SurfaceSurfaceRect_Tuple RasterizerCacheOpenGL::GetFramebufferSurfaces(bool using_color_fb,
@@ -742,17 +1215,93 @@ SurfaceSurfaceRect_Tuple RasterizerCacheOpenGL::GetFramebufferSurfaces(bool usin
         fb_rect = depth_rect;
     }
 
+    // Both surfaces are about to be rendered to, so their contents will be newer than memory's
+    for (const Surface& surface : {color_surface, depth_surface}) {
+        if (surface) {
+            surface->MarkAsUsed(current_frame);
+            surface->MarkAsModified(true);
+        }
+    }
+
     return std::make_tuple(color_surface, depth_surface, fb_rect);
 }
 
-void RasterizerCacheOpenGL::LoadSurface(const Surface& surface) {
-    surface->LoadGLBuffer();
-    surface->UploadGLTexture(read_framebuffer.handle, draw_framebuffer.handle);
+Surface RasterizerCacheOpenGL::GetClearSurface(const SurfaceParams& params) {
+    Surface surface = GetSurface(params, false);
+    if (surface) {
+        surface->MarkAsUsed(current_frame);
+        surface->MarkAsModified(true);
+    }
+    return surface;
+}
+
+void RasterizerCacheOpenGL::LoadSurface(const Surface& surface, u32 level_mask) {
+    for (u32 level = 0; level < surface->GetSurfaceParams().num_levels; ++level) {
+        if ((level_mask & (1U << level)) == 0) {
+            continue;
+        }
+        if (surface->DecodeGLTexture(level, texture_decoder, staging_buffer)) {
+            continue;
+        }
+        surface->LoadGLBuffer(level);
+        surface->UploadGLTexture(level, read_framebuffer.handle, draw_framebuffer.handle,
+                                 staging_buffer);
+    }
+    surface->UpscaleFromNativeTexture(read_framebuffer.handle, draw_framebuffer.handle);
+    surface->ReleaseGLBuffer();
+    surface->ClearDirtyMipLevels();
+    surface->MarkAsModified(false);
+
+    // The surface matches memory again, the next CPU write to it has to invalidate it
+    const auto& params{surface->GetSurfaceParams()};
+    Memory::RasterizerMarkRegionLoaded(params.addr, params.size_in_bytes);
 }
 
 void RasterizerCacheOpenGL::FlushSurface(const Surface& surface) {
-    surface->DownloadGLTexture(read_framebuffer.handle, draw_framebuffer.handle);
+    if (surface->HasPendingDownload()) {
+        if (!surface->IsDownloadReady()) {
+            surface->FinishDownloadGLTexture();
+        }
+    } else {
+        surface->DownscaleToNativeTexture(read_framebuffer.handle, draw_framebuffer.handle);
+        surface->DownloadGLTexture(read_framebuffer.handle, draw_framebuffer.handle,
+                                   staging_buffer);
+    }
     surface->FlushGLBuffer();
+    surface->ReleaseGLBuffer();
+    surface->MarkAsModified(false);
+}
+
+void RasterizerCacheOpenGL::FlushSurfaceAsync(const Surface& surface) {
+    surface->DownscaleToNativeTexture(read_framebuffer.handle, draw_framebuffer.handle);
+    surface->BeginDownloadGLTexture(read_framebuffer.handle);
+    if (std::find(unfinished_downloads.begin(), unfinished_downloads.end(), surface) ==
+        unfinished_downloads.end()) {
+        unfinished_downloads.push_back(surface);
+    }
+}
+
+bool RasterizerCacheOpenGL::HasUnfinishedDownloads(Tegra::GPUVAddr addr, size_t size) const {
+    if (unfinished_downloads.empty()) {
+        return false;
+    }
+    for (const auto& surface : GetSurfacesInRegion(addr, size)) {
+        if (surface->HasPendingDownload() && !surface->IsDownloadReady()) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void RasterizerCacheOpenGL::FinishReadyDownloads() {
+    // Surfaces that were flushed or dropped in the meantime have nothing left to finish
+    unfinished_downloads.erase(
+        std::remove_if(unfinished_downloads.begin(), unfinished_downloads.end(),
+                       [](const Surface& surface) {
+                           return !surface->HasPendingDownload() ||
+                                  surface->TryFinishDownloadGLTexture();
+                       }),
+        unfinished_downloads.end());
 }
 
 Surface RasterizerCacheOpenGL::GetSurface(const SurfaceParams& params, bool preserve_contents) {
@@ -771,17 +1320,30 @@ Surface RasterizerCacheOpenGL::GetSurface(const SurfaceParams& params, bool pres
     if (search != surface_cache.end()) {
         surface = search->second;
         if (Settings::values.use_accurate_framebuffers) {
-            // If use_accurate_framebuffers is enabled, always load from memory
-            FlushSurface(surface);
+            // If use_accurate_framebuffers is enabled, always load from memory. Anything the host
+            // GPU wrote to the surface has a readback pending, the rest already matches memory.
+            if (preserve_contents && surface->HasPendingDownload()) {
+                FlushSurface(surface);
+            }
             UnregisterSurface(surface);
-        } else if (surface->GetSurfaceParams().IsCompatibleSurface(params)) {
-            // Use the cached surface as-is
+        } else if (surface->GetSurfaceParams().IsCompatibleSurface(params) &&
+                   (!params.IsScaled() ||
+                    surface->GetSurfaceParams().resolution_scale == params.resolution_scale)) {
+            // Use the cached surface, only reloading the mipmap levels the guest wrote to. Lookups
+            // at native resolution, like textures, take scaled render targets as they are.
+            const u32 load_levels = surface->GetDirtyMipLevels() & (preserve_contents ? ~0U : ~1U);
+            if (load_levels != 0) {
+                LoadSurface(surface, load_levels);
+            }
+            surface->ClearDirtyMipLevels();
             return surface;
-        } else if (preserve_contents) {
+        } else if (preserve_contents && surface->GetDirtyMipLevels() == 0 &&
+                   surface->GetSurfaceParams().num_levels == 1 && params.num_levels == 1) {
             // If surface parameters changed and we care about keeping the previous data, recreate
             // the surface from the old one
             UnregisterSurface(surface);
             Surface new_surface{RecreateSurface(surface, params)};
+            new_surface->MarkAsModified(surface->IsModified());
             RegisterSurface(new_surface);
             return new_surface;
         } else {
@@ -802,7 +1364,7 @@ Surface RasterizerCacheOpenGL::GetSurface(const SurfaceParams& params, bool pres
 
     // Only load surface from memory if we care about the contents
     if (preserve_contents) {
-        LoadSurface(surface);
+        LoadSurface(surface, params.GetMipLevelMask());
     }
 
     return surface;
@@ -813,17 +1375,31 @@ Surface RasterizerCacheOpenGL::RecreateSurface(const Surface& surface,
     // Verify surface is compatible for blitting
     const auto& params{surface->GetSurfaceParams()};
 
+    // If the new format covers the same texels, alias the previous surface's storage instead of
+    // copying it
+    if (params.pixel_format != new_params.pixel_format && CanAliasSurface(params, new_params)) {
+        return std::make_shared<CachedSurface>(new_params, *surface);
+    }
+
     // Create a new surface with the new parameters, and blit the previous surface to it
     Surface new_surface{std::make_shared<CachedSurface>(new_params)};
 
     // If format is unchanged, we can do a faster blit without reinterpreting pixel data
     if (params.pixel_format == new_params.pixel_format) {
-        BlitTextures(surface->Texture().handle, params.GetRect(), new_surface->Texture().handle,
-                     new_surface->GetSurfaceParams().GetRect(), params.type,
+        BlitTextures(surface->Texture().handle, params.GetScaledRect(),
+                     new_surface->Texture().handle, new_params.GetScaledRect(), params.type,
                      read_framebuffer.handle, draw_framebuffer.handle);
         return new_surface;
     }
 
+    // Reinterpreting the texels below assumes both textures are at the guest's resolution, scaled
+    // surfaces go through Switch memory instead
+    if (params.IsScaled() || new_params.IsScaled()) {
+        FlushSurface(surface);
+        LoadSurface(new_surface, new_params.GetMipLevelMask());
+        return new_surface;
+    }
+
     auto source_format = GetFormatTuple(params.pixel_format, params.component_type);
     auto dest_format = GetFormatTuple(new_params.pixel_format, new_params.component_type);
 
@@ -889,17 +1465,21 @@ Surface RasterizerCacheOpenGL::RecreateSurface(const Surface& surface,
 Surface RasterizerCacheOpenGL::TryFindFramebufferSurface(VAddr cpu_addr) const {
     // Tries to find the GPU address of a framebuffer based on the CPU address. This is because
     // final output framebuffers are specified by CPU address, but internally our GPU cache uses
-    // GPU addresses. We iterate through all cached framebuffers, and compare their starting CPU
-    // address to the one provided. This is obviously not great, and won't work if the
-    // framebuffer overlaps surfaces.
+    // GPU addresses. We search the cached framebuffers, and compare their starting CPU
+    // address to the one provided. Only surfaces around the GPU addresses the CPU address is
+    // mapped to are looked at, but this won't work if the framebuffer overlaps surfaces.
 
     std::vector<Surface> surfaces;
-    for (const auto& surface : surface_cache) {
-        const auto& params = surface.second->GetSurfaceParams();
-        const VAddr surface_cpu_addr = params.GetCpuAddr();
-        if (cpu_addr >= surface_cpu_addr && cpu_addr < (surface_cpu_addr + params.size_in_bytes)) {
-            ASSERT_MSG(cpu_addr == surface_cpu_addr, "overlapping surfaces are unsupported");
-            surfaces.push_back(surface.second);
+    const auto& memory_manager = Core::System::GetInstance().GPU().memory_manager;
+    for (const Tegra::GPUVAddr gpu_addr : memory_manager->CpuToGpuAddress(cpu_addr)) {
+        for (const auto& surface : GetSurfacesInRegion(gpu_addr, 1)) {
+            const auto& params = surface->GetSurfaceParams();
+            const VAddr surface_cpu_addr = params.GetCpuAddr();
+            if (cpu_addr >= surface_cpu_addr &&
+                cpu_addr < (surface_cpu_addr + params.size_in_bytes)) {
+                ASSERT_MSG(cpu_addr == surface_cpu_addr, "overlapping surfaces are unsupported");
+                surfaces.push_back(surface);
+            }
         }
     }
 
@@ -912,25 +1492,242 @@ Surface RasterizerCacheOpenGL::TryFindFramebufferSurface(VAddr cpu_addr) const {
     return surfaces[0];
 }
 
-void RasterizerCacheOpenGL::FlushRegion(Tegra::GPUVAddr /*addr*/, size_t /*size*/) {
-    // TODO(bunnei): This is unused in the current implementation of the rasterizer cache. We should
-    // probably implement this in the future, but for now, the `use_accurate_framebufers` setting
-    // can be used to always flush.
+Surface RasterizerCacheOpenGL::GetDisplaySurface(const Tegra::FramebufferConfig& config,
+                                                 VAddr cpu_addr) {
+    if (config.gpu_address != 0) {
+        // The display told us where the framebuffer is mapped, the surface the application
+        // rendered to is keyed by that same address.
+        const auto iter = surface_cache.find(config.gpu_address);
+        if (iter != surface_cache.end()) {
+            return iter->second;
+        }
+    } else if (Surface surface = TryFindFramebufferSurface(cpu_addr)) {
+        return surface;
+    }
+
+    // Nothing was rendered to the framebuffer, its contents were written by the CPU or copied by
+    // another engine. Caching it still avoids decoding it again for frames where it didn't change.
+    if (config.stride != config.width) {
+        // Surfaces assume the rows are packed, the CPU path handles the padding
+        return {};
+    }
+
+    if (config.gpu_address != 0) {
+        return GetSurface(SurfaceParams::CreateForDisplay(config, config.gpu_address));
+    }
+
+    const auto& memory_manager = Core::System::GetInstance().GPU().memory_manager;
+    const std::vector<Tegra::GPUVAddr> gpu_addrs = memory_manager->CpuToGpuAddress(cpu_addr);
+    if (gpu_addrs.empty()) {
+        return {};
+    }
+    return GetSurface(SurfaceParams::CreateForDisplay(config, gpu_addrs.front()));
+}
+
+Surface RasterizerCacheOpenGL::TryGetCachedSurface(Tegra::GPUVAddr addr) const {
+    const auto iter = surface_cache.find(addr);
+    if (iter == surface_cache.end() || iter->second->GetDirtyMipLevels() != 0) {
+        return {};
+    }
+    return iter->second;
+}
+
+bool RasterizerCacheOpenGL::ReadSurfaceRGBA8(const Surface& surface, std::vector<u8>& pixels) {
+    const auto& params{surface->GetSurfaceParams()};
+    // Integer formats can't be blitted to a normalized one, and depth can't be blitted to color
+    if (params.type != SurfaceType::ColorTexture ||
+        params.component_type == ComponentType::UInt ||
+        params.component_type == ComponentType::SInt) {
+        return false;
+    }
+
+    OpenGLState prev_state{OpenGLState::GetCurState()};
+    SCOPE_EXIT({ prev_state.Apply(); });
+
+    const auto& src_rect{params.GetScaledRect()};
+    const auto& dst_rect{params.GetRect()};
+    const GLsizei width = static_cast<GLsizei>(dst_rect.GetWidth());
+    const GLsizei height = static_cast<GLsizei>(dst_rect.GetHeight());
+
+    // The blit converts the format and scales the surface back to the guest's resolution
+    OGLTexture rgba8_texture;
+    rgba8_texture.Create();
+
+    OpenGLState state;
+    state.texture_units[0].texture_2d = rgba8_texture.handle;
+    state.Apply();
+    glActiveTexture(GL_TEXTURE0);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE,
+                 nullptr);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
+
+    state.texture_units[0].texture_2d = 0;
+    state.draw.read_framebuffer = read_framebuffer.handle;
+    state.draw.draw_framebuffer = draw_framebuffer.handle;
+    state.Apply();
+
+    glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D,
+                           surface->Texture().handle, 0);
+    glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_TEXTURE_2D, 0, 0);
+    glFramebufferTexture2D(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D,
+                           rgba8_texture.handle, 0);
+    glFramebufferTexture2D(GL_DRAW_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_TEXTURE_2D, 0, 0);
+
+    // Compressed formats aren't renderable and can't be attached
+    const bool complete =
+        glCheckFramebufferStatus(GL_READ_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE &&
+        glCheckFramebufferStatus(GL_DRAW_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+    if (complete) {
+        glBlitFramebuffer(src_rect.left, src_rect.bottom, src_rect.right, src_rect.top, 0, 0,
+                          width, height, GL_COLOR_BUFFER_BIT,
+                          params.IsScaled() ? GL_LINEAR : GL_NEAREST);
+
+        // Read the converted copy through the read framebuffer
+        glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D,
+                               rgba8_texture.handle, 0);
+        pixels.resize(static_cast<std::size_t>(width) * height * 4);
+        glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+    }
+
+    glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, 0, 0);
+    glFramebufferTexture2D(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, 0, 0);
+    return complete;
+}
+
+void RasterizerCacheOpenGL::CopySurface(const Surface& src_surface, const Surface& dst_surface) {
+    const auto& src_params{src_surface->GetSurfaceParams()};
+    const auto& dst_params{dst_surface->GetSurfaceParams()};
+    ASSERT(src_params.type == dst_params.type);
+
+    BlitTextures(src_surface->Texture().handle, src_params.GetScaledRect(),
+                 dst_surface->Texture().handle, dst_params.GetScaledRect(), src_params.type,
+                 read_framebuffer.handle, draw_framebuffer.handle);
+
+    src_surface->MarkAsUsed(current_frame);
+    dst_surface->MarkAsUsed(current_frame);
+    dst_surface->MarkAsModified(true);
+}
+
+void RasterizerCacheOpenGL::FlushRegion(Tegra::GPUVAddr addr, size_t size) {
+    // Only surfaces with a readback pending, i.e. those written by the host GPU while the
+    // `use_accurate_framebufers` setting is enabled, are flushed. Other surfaces are not written
+    // back to memory by the current implementation of the rasterizer cache.
+    for (const auto& surface : GetSurfacesInRegion(addr, size)) {
+        if (surface->HasPendingDownload()) {
+            FlushSurface(surface);
+        }
+    }
 }
 
 void RasterizerCacheOpenGL::InvalidateRegion(Tegra::GPUVAddr addr, size_t size) {
-    for (auto iter = surface_cache.cbegin(); iter != surface_cache.cend();) {
-        const auto& surface{iter->second};
+    for (const auto& surface : GetSurfacesInRegion(addr, size)) {
+        // The guest may only be overwriting part of the surface, so the rest of what the host GPU
+        // rendered has to make it to memory first
+        if (surface->HasPendingDownload()) {
+            FlushSurface(surface);
+        }
+
+        // Mipmapped textures stay cached when only some of their levels are overwritten, the
+        // levels are reloaded the next time the texture is used
         const auto& params{surface->GetSurfaceParams()};
+        const bool covers_surface{addr <= params.addr &&
+                                  params.addr + params.size_in_bytes <= addr + size};
+        if (params.num_levels > 1 && !covers_surface) {
+            surface->InvalidateMipLevels(addr, size);
+            continue;
+        }
 
-        ++iter;
+        UnregisterSurface(surface);
+    }
+}
 
-        if (params.IsOverlappingRegion(addr, size)) {
-            UnregisterSurface(surface);
+void RasterizerCacheOpenGL::InvalidateAll() {
+    while (!surface_cache.empty()) {
+        UnregisterSurface(surface_cache.begin()->second);
+    }
+}
+
+MICROPROFILE_DEFINE(OpenGL_SurfaceEviction, "OpenGL", "Surface Eviction", MP_RGB(192, 128, 64));
+void RasterizerCacheOpenGL::TickFrame() {
+    ++current_frame;
+
+    FinishReadyDownloads();
+
+    const size_t budget = static_cast<size_t>(Settings::values.max_surface_cache_size) << 20;
+    if (budget != 0) {
+        EvictSurfaces(budget);
+    }
+}
+
+void RasterizerCacheOpenGL::EvictSurfaces(size_t budget) {
+    MICROPROFILE_SCOPE(OpenGL_SurfaceEviction);
+
+    // A surface can be both registered and reserved, only count it once
+    std::unordered_set<Surface> surfaces;
+    for (const auto& pair : surface_cache) {
+        surfaces.insert(pair.second);
+    }
+    for (const auto& pair : surface_reserve) {
+        surfaces.insert(pair.second);
+    }
+
+    size_t cache_size = 0;
+    std::vector<Surface> candidates;
+    for (const Surface& surface : surfaces) {
+        cache_size += surface->GetHostSizeInBytes();
+
+        // Surfaces used in the frame being recorded may still be bound, and the host GPU holds
+        // the only copy of modified surfaces
+        if (surface->GetLastUsedFrame() < current_frame - 1 && !surface->IsModified() &&
+            !surface->HasPendingDownload()) {
+            candidates.push_back(surface);
         }
     }
+
+    std::sort(candidates.begin(), candidates.end(), [](const Surface& a, const Surface& b) {
+        return a->GetLastUsedFrame() < b->GetLastUsedFrame();
+    });
+
+    size_t num_evicted = 0;
+    for (const Surface& surface : candidates) {
+        if (cache_size <= budget) {
+            break;
+        }
+
+        UnregisterSurface(surface);
+        const auto search{
+            surface_reserve.find(SurfaceReserveKey::Create(surface->GetSurfaceParams()))};
+        if (search != surface_reserve.end() && search->second == surface) {
+            surface_reserve.erase(search);
+        }
+
+        cache_size -= surface->GetHostSizeInBytes();
+        ++num_evicted;
+    }
+
+    MICROPROFILE_META_CPU("Surface Cache KiB", static_cast<int>(cache_size >> 10));
+    MICROPROFILE_META_CPU("Surfaces Evicted", static_cast<int>(num_evicted));
 }
 
+SurfaceSet RasterizerCacheOpenGL::GetSurfacesInRegion(Tegra::GPUVAddr addr, u64 size) const {
+    // IsOverlappingRegion also counts surfaces that only touch the region as overlapping, so
+    // widen the query by one byte on either side and let it make the final decision.
+    const Tegra::GPUVAddr query_start = addr > 0 ? addr - 1 : 0;
+    const auto query = SurfaceMap::interval_type::right_open(query_start, addr + size + 1);
+
+    SurfaceSet surfaces;
+    for (const auto& pair : boost::make_iterator_range(surface_map.equal_range(query))) {
+        for (const auto& surface : pair.second) {
+            if (surface->GetSurfaceParams().IsOverlappingRegion(addr, size)) {
+                surfaces.insert(surface);
+            }
+        }
+    }
+    return surfaces;
+}
+
+MICROPROFILE_COUNTER_DEFINE(OpenGL_CachedSurfaces, "OpenGL", "Cached Surfaces", Level);
+
 void RasterizerCacheOpenGL::RegisterSurface(const Surface& surface) {
     const auto& params{surface->GetSurfaceParams()};
     const auto& search{surface_cache.find(params.addr)};
@@ -941,7 +1738,11 @@ void RasterizerCacheOpenGL::RegisterSurface(const Surface& surface) {
     }
 
     surface_cache[params.addr] = surface;
-    UpdatePagesCachedCount(params.addr, params.size_in_bytes, 1);
+    surface_map.add({SurfaceMap::interval_type::right_open(params.addr,
+                                                            params.addr + params.size_in_bytes),
+                     SurfaceSet{surface}});
+    cached_pages.UpdateCount(params.addr, params.size_in_bytes, 1);
+    MICROPROFILE_COUNTER_SET(OpenGL_CachedSurfaces, surface_cache.size());
 }
 
 void RasterizerCacheOpenGL::UnregisterSurface(const Surface& surface) {
@@ -953,8 +1754,13 @@ void RasterizerCacheOpenGL::UnregisterSurface(const Surface& surface) {
         return;
     }
 
-    UpdatePagesCachedCount(params.addr, params.size_in_bytes, -1);
+    search->second->CancelPendingDownload();
+    cached_pages.UpdateCount(params.addr, params.size_in_bytes, -1);
+    surface_map.subtract({SurfaceMap::interval_type::right_open(
+                              params.addr, params.addr + params.size_in_bytes),
+                          SurfaceSet{search->second}});
     surface_cache.erase(search);
+    MICROPROFILE_COUNTER_SET(OpenGL_CachedSurfaces, surface_cache.size());
 }
 
 void RasterizerCacheOpenGL::ReserveSurface(const Surface& surface) {
@@ -972,43 +1778,4 @@ Surface RasterizerCacheOpenGL::TryGetReservedSurface(const SurfaceParams& params
     return {};
 }
 
-template <typename Map, typename Interval>
-constexpr auto RangeFromInterval(Map& map, const Interval& interval) {
-    return boost::make_iterator_range(map.equal_range(interval));
-}
-
-void RasterizerCacheOpenGL::UpdatePagesCachedCount(Tegra::GPUVAddr addr, u64 size, int delta) {
-    const u64 num_pages = ((addr + size - 1) >> Tegra::MemoryManager::PAGE_BITS) -
-                          (addr >> Tegra::MemoryManager::PAGE_BITS) + 1;
-    const u64 page_start = addr >> Tegra::MemoryManager::PAGE_BITS;
-    const u64 page_end = page_start + num_pages;
-
-    // Interval maps will erase segments if count reaches 0, so if delta is negative we have to
-    // subtract after iterating
-    const auto pages_interval = PageMap::interval_type::right_open(page_start, page_end);
-    if (delta > 0)
-        cached_pages.add({pages_interval, delta});
-
-    for (const auto& pair : RangeFromInterval(cached_pages, pages_interval)) {
-        const auto interval = pair.first & pages_interval;
-        const int count = pair.second;
-
-        const Tegra::GPUVAddr interval_start_addr = boost::icl::first(interval)
-                                                    << Tegra::MemoryManager::PAGE_BITS;
-        const Tegra::GPUVAddr interval_end_addr = boost::icl::last_next(interval)
-                                                  << Tegra::MemoryManager::PAGE_BITS;
-        const u64 interval_size = interval_end_addr - interval_start_addr;
-
-        if (delta > 0 && count == delta)
-            Memory::RasterizerMarkRegionCached(interval_start_addr, interval_size, true);
-        else if (delta < 0 && count == -delta)
-            Memory::RasterizerMarkRegionCached(interval_start_addr, interval_size, false);
-        else
-            ASSERT(count >= 0);
-    }
-
-    if (delta < 0)
-        cached_pages.add({pages_interval, delta});
-}
-
 } // namespace OpenGL
@@ -4,17 +4,25 @@
 
 #pragma once
 
+#include <algorithm>
 #include <array>
 #include <map>
 #include <memory>
+#include <set>
 #include <vector>
 #include <boost/icl/interval_map.hpp>
 
+#include "common/alignment.h"
 #include "common/common_types.h"
 #include "common/hash.h"
 #include "common/math_util.h"
+#include "common/memory_tracker.h"
 #include "video_core/engines/maxwell_3d.h"
+#include "video_core/rasterizer_cached_pages.h"
 #include "video_core/renderer_opengl/gl_resource_manager.h"
+#include "video_core/renderer_opengl/gl_staging_buffer.h"
+#include "video_core/renderer_opengl/gl_texture_decoder.h"
+#include "video_core/surface.h"
 #include "video_core/textures/texture.h"
 
 namespace OpenGL {
@@ -22,611 +30,65 @@ namespace OpenGL {
 class CachedSurface;
 using Surface = std::shared_ptr<CachedSurface>;
 using SurfaceSurfaceRect_Tuple = std::tuple<Surface, Surface, MathUtil::Rectangle<u32>>;
-using PageMap = boost::icl::interval_map<u64, int>;
+using SurfaceSet = std::set<Surface>;
+using SurfaceMap = boost::icl::interval_map<Tegra::GPUVAddr, SurfaceSet>;
 
 struct SurfaceParams {
-    enum class PixelFormat {
-        ABGR8U = 0,
-        ABGR8S = 1,
-        ABGR8UI = 2,
-        B5G6R5U = 3,
-        A2B10G10R10U = 4,
-        A1B5G5R5U = 5,
-        R8U = 6,
-        R8UI = 7,
-        RGBA16F = 8,
-        RGBA16U = 9,
-        RGBA16UI = 10,
-        R11FG11FB10F = 11,
-        RGBA32UI = 12,
-        DXT1 = 13,
-        DXT23 = 14,
-        DXT45 = 15,
-        DXN1 = 16, // This is also known as BC4
-        DXN2UNORM = 17,
-        DXN2SNORM = 18,
-        BC7U = 19,
-        ASTC_2D_4X4 = 20,
-        G8R8U = 21,
-        G8R8S = 22,
-        BGRA8 = 23,
-        RGBA32F = 24,
-        RG32F = 25,
-        R32F = 26,
-        R16F = 27,
-        R16U = 28,
-        R16S = 29,
-        R16UI = 30,
-        R16I = 31,
-        RG16 = 32,
-        RG16F = 33,
-        RG16UI = 34,
-        RG16I = 35,
-        RG16S = 36,
-        RGB32F = 37,
-        SRGBA8 = 38,
-        RG8U = 39,
-        RG8S = 40,
-        RG32UI = 41,
-        R32UI = 42,
-
-        MaxColorFormat,
-
-        // Depth formats
-        Z32F = 43,
-        Z16 = 44,
-
-        MaxDepthFormat,
-
-        // DepthStencil formats
-        Z24S8 = 45,
-        S8Z24 = 46,
-        Z32FS8 = 47,
-
-        MaxDepthStencilFormat,
-
-        Max = MaxDepthStencilFormat,
-        Invalid = 255,
-    };
-
-    static constexpr size_t MaxPixelFormat = static_cast<size_t>(PixelFormat::Max);
-
-    enum class ComponentType {
-        Invalid = 0,
-        SNorm = 1,
-        UNorm = 2,
-        SInt = 3,
-        UInt = 4,
-        Float = 5,
-    };
-
-    enum class SurfaceType {
-        ColorTexture = 0,
-        Depth = 1,
-        DepthStencil = 2,
-        Fill = 3,
-        Invalid = 4,
-    };
+    using PixelFormat = VideoCore::Surface::PixelFormat;
+    using ComponentType = VideoCore::Surface::ComponentType;
+    using SurfaceType = VideoCore::Surface::SurfaceType;
 
-    /**
-     * Gets the compression factor for the specified PixelFormat. This applies to just the
-     * "compressed width" and "compressed height", not the overall compression factor of a
-     * compressed image. This is used for maintaining proper surface sizes for compressed
-     * texture formats.
-     */
-    static constexpr u32 GetCompressionFactor(PixelFormat format) {
-        if (format == PixelFormat::Invalid)
-            return 0;
-
-        constexpr std::array<u32, MaxPixelFormat> compression_factor_table = {{
-            1, // ABGR8U
-            1, // ABGR8S
-            1, // ABGR8UI
-            1, // B5G6R5U
-            1, // A2B10G10R10U
-            1, // A1B5G5R5U
-            1, // R8U
-            1, // R8UI
-            1, // RGBA16F
-            1, // RGBA16U
-            1, // RGBA16UI
-            1, // R11FG11FB10F
-            1, // RGBA32UI
-            4, // DXT1
-            4, // DXT23
-            4, // DXT45
-            4, // DXN1
-            4, // DXN2UNORM
-            4, // DXN2SNORM
-            4, // BC7U
-            4, // ASTC_2D_4X4
-            1, // G8R8U
-            1, // G8R8S
-            1, // BGRA8
-            1, // RGBA32F
-            1, // RG32F
-            1, // R32F
-            1, // R16F
-            1, // R16U
-            1, // R16S
-            1, // R16UI
-            1, // R16I
-            1, // RG16
-            1, // RG16F
-            1, // RG16UI
-            1, // RG16I
-            1, // RG16S
-            1, // RGB32F
-            1, // SRGBA8
-            1, // RG8U
-            1, // RG8S
-            1, // RG32UI
-            1, // R32UI
-            1, // Z32F
-            1, // Z16
-            1, // Z24S8
-            1, // S8Z24
-            1, // Z32FS8
-        }};
-
-        ASSERT(static_cast<size_t>(format) < compression_factor_table.size());
-        return compression_factor_table[static_cast<size_t>(format)];
-    }
-
-    static constexpr u32 GetFormatBpp(PixelFormat format) {
-        if (format == PixelFormat::Invalid)
-            return 0;
-
-        constexpr std::array<u32, MaxPixelFormat> bpp_table = {{
-            32,  // ABGR8U
-            32,  // ABGR8S
-            32,  // ABGR8UI
-            16,  // B5G6R5U
-            32,  // A2B10G10R10U
-            16,  // A1B5G5R5U
-            8,   // R8U
-            8,   // R8UI
-            64,  // RGBA16F
-            64,  // RGBA16U
-            64,  // RGBA16UI
-            32,  // R11FG11FB10F
-            128, // RGBA32UI
-            64,  // DXT1
-            128, // DXT23
-            128, // DXT45
-            64,  // DXN1
-            128, // DXN2UNORM
-            128, // DXN2SNORM
-            128, // BC7U
-            32,  // ASTC_2D_4X4
-            16,  // G8R8U
-            16,  // G8R8S
-            32,  // BGRA8
-            128, // RGBA32F
-            64,  // RG32F
-            32,  // R32F
-            16,  // R16F
-            16,  // R16U
-            16,  // R16S
-            16,  // R16UI
-            16,  // R16I
-            32,  // RG16
-            32,  // RG16F
-            32,  // RG16UI
-            32,  // RG16I
-            32,  // RG16S
-            96,  // RGB32F
-            32,  // SRGBA8
-            16,  // RG8U
-            16,  // RG8S
-            64,  // RG32UI
-            32,  // R32UI
-            32,  // Z32F
-            16,  // Z16
-            32,  // Z24S8
-            32,  // S8Z24
-            64,  // Z32FS8
-        }};
-
-        ASSERT(static_cast<size_t>(format) < bpp_table.size());
-        return bpp_table[static_cast<size_t>(format)];
-    }
+    /// Maximum number of mipmap levels a texture can have, the TIC entry stores the last one in 4
+    /// bits
+    static constexpr u32 MaxMipLevels = 16;
 
     u32 GetFormatBpp() const {
-        return GetFormatBpp(pixel_format);
+        return VideoCore::Surface::GetFormatBpp(pixel_format);
     }
 
-    static PixelFormat PixelFormatFromDepthFormat(Tegra::DepthFormat format) {
-        switch (format) {
-        case Tegra::DepthFormat::S8_Z24_UNORM:
-            return PixelFormat::S8Z24;
-        case Tegra::DepthFormat::Z24_S8_UNORM:
-            return PixelFormat::Z24S8;
-        case Tegra::DepthFormat::Z32_FLOAT:
-            return PixelFormat::Z32F;
-        case Tegra::DepthFormat::Z16_UNORM:
-            return PixelFormat::Z16;
-        case Tegra::DepthFormat::Z32_S8_X24_FLOAT:
-            return PixelFormat::Z32FS8;
-        default:
-            LOG_CRITICAL(HW_GPU, "Unimplemented format={}", static_cast<u32>(format));
-            UNREACHABLE();
-        }
-    }
+    /// Returns the rectangle corresponding to this surface
+    MathUtil::Rectangle<u32> GetRect() const;
 
-    static PixelFormat PixelFormatFromRenderTargetFormat(Tegra::RenderTargetFormat format) {
-        switch (format) {
-        // TODO (Hexagon12): Converting SRGBA to RGBA is a hack and doesn't completely correct the
-        // gamma.
-        case Tegra::RenderTargetFormat::RGBA8_SRGB:
-        case Tegra::RenderTargetFormat::RGBA8_UNORM:
-            return PixelFormat::ABGR8U;
-        case Tegra::RenderTargetFormat::RGBA8_SNORM:
-            return PixelFormat::ABGR8S;
-        case Tegra::RenderTargetFormat::RGBA8_UINT:
-            return PixelFormat::ABGR8UI;
-        case Tegra::RenderTargetFormat::BGRA8_UNORM:
-            return PixelFormat::BGRA8;
-        case Tegra::RenderTargetFormat::RGB10_A2_UNORM:
-            return PixelFormat::A2B10G10R10U;
-        case Tegra::RenderTargetFormat::RGBA16_FLOAT:
-            return PixelFormat::RGBA16F;
-        case Tegra::RenderTargetFormat::RGBA16_UNORM:
-            return PixelFormat::RGBA16U;
-        case Tegra::RenderTargetFormat::RGBA16_UINT:
-            return PixelFormat::RGBA16UI;
-        case Tegra::RenderTargetFormat::RGBA32_FLOAT:
-            return PixelFormat::RGBA32F;
-        case Tegra::RenderTargetFormat::RG32_FLOAT:
-            return PixelFormat::RG32F;
-        case Tegra::RenderTargetFormat::R11G11B10_FLOAT:
-            return PixelFormat::R11FG11FB10F;
-        case Tegra::RenderTargetFormat::B5G6R5_UNORM:
-            return PixelFormat::B5G6R5U;
-        case Tegra::RenderTargetFormat::RGBA32_UINT:
-            return PixelFormat::RGBA32UI;
-        case Tegra::RenderTargetFormat::R8_UNORM:
-            return PixelFormat::R8U;
-        case Tegra::RenderTargetFormat::R8_UINT:
-            return PixelFormat::R8UI;
-        case Tegra::RenderTargetFormat::RG16_FLOAT:
-            return PixelFormat::RG16F;
-        case Tegra::RenderTargetFormat::RG16_UINT:
-            return PixelFormat::RG16UI;
-        case Tegra::RenderTargetFormat::RG16_SINT:
-            return PixelFormat::RG16I;
-        case Tegra::RenderTargetFormat::RG16_UNORM:
-            return PixelFormat::RG16;
-        case Tegra::RenderTargetFormat::RG16_SNORM:
-            return PixelFormat::RG16S;
-        case Tegra::RenderTargetFormat::RG8_UNORM:
-            return PixelFormat::RG8U;
-        case Tegra::RenderTargetFormat::RG8_SNORM:
-            return PixelFormat::RG8S;
-        case Tegra::RenderTargetFormat::R16_FLOAT:
-            return PixelFormat::R16F;
-        case Tegra::RenderTargetFormat::R16_UNORM:
-            return PixelFormat::R16U;
-        case Tegra::RenderTargetFormat::R16_SNORM:
-            return PixelFormat::R16S;
-        case Tegra::RenderTargetFormat::R16_UINT:
-            return PixelFormat::R16UI;
-        case Tegra::RenderTargetFormat::R16_SINT:
-            return PixelFormat::R16I;
-        case Tegra::RenderTargetFormat::R32_FLOAT:
-            return PixelFormat::R32F;
-        case Tegra::RenderTargetFormat::R32_UINT:
-            return PixelFormat::R32UI;
-        case Tegra::RenderTargetFormat::RG32_UINT:
-            return PixelFormat::RG32UI;
-        default:
-            LOG_CRITICAL(HW_GPU, "Unimplemented format={}", static_cast<u32>(format));
-            UNREACHABLE();
-        }
-    }
+    /// Returns the rectangle corresponding to this surface in its host texture, which is rendered
+    /// at resolution_scale times the guest's resolution
+    MathUtil::Rectangle<u32> GetScaledRect() const;
 
-    static PixelFormat PixelFormatFromTextureFormat(Tegra::Texture::TextureFormat format,
-                                                    Tegra::Texture::ComponentType component_type) {
-        // TODO(Subv): Properly implement this
-        switch (format) {
-        case Tegra::Texture::TextureFormat::A8R8G8B8:
-            switch (component_type) {
-            case Tegra::Texture::ComponentType::UNORM:
-                return PixelFormat::ABGR8U;
-            case Tegra::Texture::ComponentType::SNORM:
-                return PixelFormat::ABGR8S;
-            case Tegra::Texture::ComponentType::UINT:
-                return PixelFormat::ABGR8UI;
-            }
-            LOG_CRITICAL(HW_GPU, "Unimplemented component_type={}",
-                         static_cast<u32>(component_type));
-            UNREACHABLE();
-        case Tegra::Texture::TextureFormat::B5G6R5:
-            switch (component_type) {
-            case Tegra::Texture::ComponentType::UNORM:
-                return PixelFormat::B5G6R5U;
-            }
-            LOG_CRITICAL(HW_GPU, "Unimplemented component_type={}",
-                         static_cast<u32>(component_type));
-            UNREACHABLE();
-        case Tegra::Texture::TextureFormat::A2B10G10R10:
-            switch (component_type) {
-            case Tegra::Texture::ComponentType::UNORM:
-                return PixelFormat::A2B10G10R10U;
-            }
-            LOG_CRITICAL(HW_GPU, "Unimplemented component_type={}",
-                         static_cast<u32>(component_type));
-            UNREACHABLE();
-        case Tegra::Texture::TextureFormat::A1B5G5R5:
-            switch (component_type) {
-            case Tegra::Texture::ComponentType::UNORM:
-                return PixelFormat::A1B5G5R5U;
-            }
-            LOG_CRITICAL(HW_GPU, "Unimplemented component_type={}",
-                         static_cast<u32>(component_type));
-            UNREACHABLE();
-        case Tegra::Texture::TextureFormat::R8:
-            switch (component_type) {
-            case Tegra::Texture::ComponentType::UNORM:
-                return PixelFormat::R8U;
-            case Tegra::Texture::ComponentType::UINT:
-                return PixelFormat::R8UI;
-            }
-            LOG_CRITICAL(HW_GPU, "Unimplemented component_type={}",
-                         static_cast<u32>(component_type));
-            UNREACHABLE();
-        case Tegra::Texture::TextureFormat::G8R8:
-            switch (component_type) {
-            case Tegra::Texture::ComponentType::UNORM:
-                return PixelFormat::G8R8U;
-            case Tegra::Texture::ComponentType::SNORM:
-                return PixelFormat::G8R8S;
-            }
-            LOG_CRITICAL(HW_GPU, "Unimplemented component_type={}",
-                         static_cast<u32>(component_type));
-            UNREACHABLE();
-        case Tegra::Texture::TextureFormat::R16_G16_B16_A16:
-            switch (component_type) {
-            case Tegra::Texture::ComponentType::UNORM:
-                return PixelFormat::RGBA16U;
-            case Tegra::Texture::ComponentType::FLOAT:
-                return PixelFormat::RGBA16F;
-            }
-            LOG_CRITICAL(HW_GPU, "Unimplemented component_type={}",
-                         static_cast<u32>(component_type));
-            UNREACHABLE();
-        case Tegra::Texture::TextureFormat::BF10GF11RF11:
-            switch (component_type) {
-            case Tegra::Texture::ComponentType::FLOAT:
-                return PixelFormat::R11FG11FB10F;
-            }
-            LOG_CRITICAL(HW_GPU, "Unimplemented component_type={}",
-                         static_cast<u32>(component_type));
-            UNREACHABLE();
-        case Tegra::Texture::TextureFormat::R32_G32_B32_A32:
-            switch (component_type) {
-            case Tegra::Texture::ComponentType::FLOAT:
-                return PixelFormat::RGBA32F;
-            case Tegra::Texture::ComponentType::UINT:
-                return PixelFormat::RGBA32UI;
-            }
-            LOG_CRITICAL(HW_GPU, "Unimplemented component_type={}",
-                         static_cast<u32>(component_type));
-            UNREACHABLE();
-        case Tegra::Texture::TextureFormat::R32_G32:
-            switch (component_type) {
-            case Tegra::Texture::ComponentType::FLOAT:
-                return PixelFormat::RG32F;
-            case Tegra::Texture::ComponentType::UINT:
-                return PixelFormat::RG32UI;
-            }
-            LOG_CRITICAL(HW_GPU, "Unimplemented component_type={}",
-                         static_cast<u32>(component_type));
-            UNREACHABLE();
-        case Tegra::Texture::TextureFormat::R32_G32_B32:
-            switch (component_type) {
-            case Tegra::Texture::ComponentType::FLOAT:
-                return PixelFormat::RGB32F;
-            }
-            LOG_CRITICAL(HW_GPU, "Unimplemented component_type={}",
-                         static_cast<u32>(component_type));
-            UNREACHABLE();
-        case Tegra::Texture::TextureFormat::R16:
-            switch (component_type) {
-            case Tegra::Texture::ComponentType::FLOAT:
-                return PixelFormat::R16F;
-            case Tegra::Texture::ComponentType::UNORM:
-                return PixelFormat::R16U;
-            case Tegra::Texture::ComponentType::SNORM:
-                return PixelFormat::R16S;
-            case Tegra::Texture::ComponentType::UINT:
-                return PixelFormat::R16UI;
-            case Tegra::Texture::ComponentType::SINT:
-                return PixelFormat::R16I;
-            }
-            LOG_CRITICAL(HW_GPU, "Unimplemented component_type={}",
-                         static_cast<u32>(component_type));
-            UNREACHABLE();
-        case Tegra::Texture::TextureFormat::R32:
-            switch (component_type) {
-            case Tegra::Texture::ComponentType::FLOAT:
-                return PixelFormat::R32F;
-            case Tegra::Texture::ComponentType::UINT:
-                return PixelFormat::R32UI;
-            }
-            LOG_CRITICAL(HW_GPU, "Unimplemented component_type={}",
-                         static_cast<u32>(component_type));
-            UNREACHABLE();
-        case Tegra::Texture::TextureFormat::ZF32:
-            return PixelFormat::Z32F;
-        case Tegra::Texture::TextureFormat::Z16:
-            return PixelFormat::Z16;
-        case Tegra::Texture::TextureFormat::Z24S8:
-            return PixelFormat::Z24S8;
-        case Tegra::Texture::TextureFormat::DXT1:
-            return PixelFormat::DXT1;
-        case Tegra::Texture::TextureFormat::DXT23:
-            return PixelFormat::DXT23;
-        case Tegra::Texture::TextureFormat::DXT45:
-            return PixelFormat::DXT45;
-        case Tegra::Texture::TextureFormat::DXN1:
-            return PixelFormat::DXN1;
-        case Tegra::Texture::TextureFormat::DXN2:
-            switch (component_type) {
-            case Tegra::Texture::ComponentType::UNORM:
-                return PixelFormat::DXN2UNORM;
-            case Tegra::Texture::ComponentType::SNORM:
-                return PixelFormat::DXN2SNORM;
-            }
-            LOG_CRITICAL(HW_GPU, "Unimplemented component_type={}",
-                         static_cast<u32>(component_type));
-            UNREACHABLE();
-        case Tegra::Texture::TextureFormat::BC7U:
-            return PixelFormat::BC7U;
-        case Tegra::Texture::TextureFormat::ASTC_2D_4X4:
-            return PixelFormat::ASTC_2D_4X4;
-        case Tegra::Texture::TextureFormat::R16_G16:
-            switch (component_type) {
-            case Tegra::Texture::ComponentType::FLOAT:
-                return PixelFormat::RG16F;
-            case Tegra::Texture::ComponentType::UNORM:
-                return PixelFormat::RG16;
-            case Tegra::Texture::ComponentType::SNORM:
-                return PixelFormat::RG16S;
-            case Tegra::Texture::ComponentType::UINT:
-                return PixelFormat::RG16UI;
-            case Tegra::Texture::ComponentType::SINT:
-                return PixelFormat::RG16I;
-            }
-            LOG_CRITICAL(HW_GPU, "Unimplemented component_type={}",
-                         static_cast<u32>(component_type));
-            UNREACHABLE();
-        default:
-            LOG_CRITICAL(HW_GPU, "Unimplemented format={}, component_type={}",
-                         static_cast<u32>(format), static_cast<u32>(component_type));
-            UNREACHABLE();
-        }
+    /// Returns whether the host texture has a different resolution than the surface in memory
+    bool IsScaled() const {
+        return resolution_scale != 1.0f;
     }
 
-    static ComponentType ComponentTypeFromTexture(Tegra::Texture::ComponentType type) {
-        // TODO(Subv): Implement more component types
-        switch (type) {
-        case Tegra::Texture::ComponentType::UNORM:
-            return ComponentType::UNorm;
-        case Tegra::Texture::ComponentType::FLOAT:
-            return ComponentType::Float;
-        case Tegra::Texture::ComponentType::SNORM:
-            return ComponentType::SNorm;
-        case Tegra::Texture::ComponentType::UINT:
-            return ComponentType::UInt;
-        case Tegra::Texture::ComponentType::SINT:
-            return ComponentType::SInt;
-        default:
-            LOG_CRITICAL(HW_GPU, "Unimplemented component type={}", static_cast<u32>(type));
-            UNREACHABLE();
-        }
+    /// Returns the size of this surface in bytes, adjusted for compression
+    size_t SizeInBytes() const {
+        const u32 compression_factor{GetCompressionFactor(pixel_format)};
+        ASSERT(width % compression_factor == 0);
+        ASSERT(height % compression_factor == 0);
+        return (width / compression_factor) * (height / compression_factor) *
+               VideoCore::Surface::GetFormatBpp(pixel_format) / CHAR_BIT;
     }
 
-    static ComponentType ComponentTypeFromRenderTarget(Tegra::RenderTargetFormat format) {
-        // TODO(Subv): Implement more render targets
-        switch (format) {
-        case Tegra::RenderTargetFormat::RGBA8_UNORM:
-        case Tegra::RenderTargetFormat::RGBA8_SRGB:
-        case Tegra::RenderTargetFormat::BGRA8_UNORM:
-        case Tegra::RenderTargetFormat::RGB10_A2_UNORM:
-        case Tegra::RenderTargetFormat::R8_UNORM:
-        case Tegra::RenderTargetFormat::RG16_UNORM:
-        case Tegra::RenderTargetFormat::R16_UNORM:
-        case Tegra::RenderTargetFormat::B5G6R5_UNORM:
-        case Tegra::RenderTargetFormat::RG8_UNORM:
-        case Tegra::RenderTargetFormat::RGBA16_UNORM:
-            return ComponentType::UNorm;
-        case Tegra::RenderTargetFormat::RGBA8_SNORM:
-        case Tegra::RenderTargetFormat::RG16_SNORM:
-        case Tegra::RenderTargetFormat::R16_SNORM:
-        case Tegra::RenderTargetFormat::RG8_SNORM:
-            return ComponentType::SNorm;
-        case Tegra::RenderTargetFormat::RGBA16_FLOAT:
-        case Tegra::RenderTargetFormat::R11G11B10_FLOAT:
-        case Tegra::RenderTargetFormat::RGBA32_FLOAT:
-        case Tegra::RenderTargetFormat::RG32_FLOAT:
-        case Tegra::RenderTargetFormat::RG16_FLOAT:
-        case Tegra::RenderTargetFormat::R16_FLOAT:
-        case Tegra::RenderTargetFormat::R32_FLOAT:
-            return ComponentType::Float;
-        case Tegra::RenderTargetFormat::RGBA32_UINT:
-        case Tegra::RenderTargetFormat::RGBA16_UINT:
-        case Tegra::RenderTargetFormat::RG16_UINT:
-        case Tegra::RenderTargetFormat::R8_UINT:
-        case Tegra::RenderTargetFormat::R16_UINT:
-        case Tegra::RenderTargetFormat::RG32_UINT:
-        case Tegra::RenderTargetFormat::R32_UINT:
-        case Tegra::RenderTargetFormat::RGBA8_UINT:
-            return ComponentType::UInt;
-        case Tegra::RenderTargetFormat::RG16_SINT:
-        case Tegra::RenderTargetFormat::R16_SINT:
-            return ComponentType::SInt;
-        default:
-            LOG_CRITICAL(HW_GPU, "Unimplemented format={}", static_cast<u32>(format));
-            UNREACHABLE();
-        }
+    /// Returns the width of the specified mipmap level, adjusted for compression
+    u32 GetMipWidth(u32 level) const {
+        return Common::AlignUp(std::max(1U, width >> level), GetCompressionFactor(pixel_format));
     }
 
-    static PixelFormat PixelFormatFromGPUPixelFormat(Tegra::FramebufferConfig::PixelFormat format) {
-        switch (format) {
-        case Tegra::FramebufferConfig::PixelFormat::ABGR8:
-            return PixelFormat::ABGR8U;
-        default:
-            LOG_CRITICAL(HW_GPU, "Unimplemented format={}", static_cast<u32>(format));
-            UNREACHABLE();
-        }
+    /// Returns the height of the specified mipmap level, adjusted for compression
+    u32 GetMipHeight(u32 level) const {
+        return Common::AlignUp(std::max(1U, height >> level), GetCompressionFactor(pixel_format));
     }
 
-    static ComponentType ComponentTypeFromDepthFormat(Tegra::DepthFormat format) {
-        switch (format) {
-        case Tegra::DepthFormat::Z16_UNORM:
-        case Tegra::DepthFormat::S8_Z24_UNORM:
-        case Tegra::DepthFormat::Z24_S8_UNORM:
-            return ComponentType::UNorm;
-        case Tegra::DepthFormat::Z32_FLOAT:
-        case Tegra::DepthFormat::Z32_S8_X24_FLOAT:
-            return ComponentType::Float;
-        default:
-            LOG_CRITICAL(HW_GPU, "Unimplemented format={}", static_cast<u32>(format));
-            UNREACHABLE();
-        }
-    }
+    /// Returns the block height, in GOBs, the specified mipmap level is swizzled with
+    u32 GetMipBlockHeight(u32 level) const;
 
-    static SurfaceType GetFormatType(PixelFormat pixel_format) {
-        if (static_cast<size_t>(pixel_format) < static_cast<size_t>(PixelFormat::MaxColorFormat)) {
-            return SurfaceType::ColorTexture;
-        }
-
-        if (static_cast<size_t>(pixel_format) < static_cast<size_t>(PixelFormat::MaxDepthFormat)) {
-            return SurfaceType::Depth;
-        }
+    /// Returns the offset of the specified mipmap level from the start of the surface in memory
+    size_t GetMipLevelOffset(u32 level) const;
 
-        if (static_cast<size_t>(pixel_format) <
-            static_cast<size_t>(PixelFormat::MaxDepthStencilFormat)) {
-            return SurfaceType::DepthStencil;
-        }
-
-        // TODO(Subv): Implement the other formats
-        ASSERT(false);
-
-        return SurfaceType::Invalid;
-    }
+    /// Returns the size in bytes of the specified mipmap level in memory, padded to whole blocks
+    size_t GetMipLevelSize(u32 level) const;
 
-    /// Returns the rectangle corresponding to this surface
-    MathUtil::Rectangle<u32> GetRect() const;
-
-    /// Returns the size of this surface in bytes, adjusted for compression
-    size_t SizeInBytes() const {
-        const u32 compression_factor{GetCompressionFactor(pixel_format)};
-        ASSERT(width % compression_factor == 0);
-        ASSERT(height % compression_factor == 0);
-        return (width / compression_factor) * (height / compression_factor) *
-               GetFormatBpp(pixel_format) / CHAR_BIT;
+    /// Returns a mask with a bit set for every mipmap level of the surface
+    u32 GetMipLevelMask() const {
+        return (1U << num_levels) - 1;
     }
 
     /// Returns the CPU virtual address for this surface
@@ -644,6 +106,10 @@ struct SurfaceParams {
     static SurfaceParams CreateForFramebuffer(
         const Tegra::Engines::Maxwell3D::Regs::RenderTargetConfig& config);
 
+    /// Creates SurfaceParams for a framebuffer presented to the display
+    static SurfaceParams CreateForDisplay(const Tegra::FramebufferConfig& config,
+                                          Tegra::GPUVAddr gpu_addr);
+
     /// Creates SurfaceParams for a depth buffer configuration
     static SurfaceParams CreateForDepthBuffer(u32 zeta_width, u32 zeta_height,
                                               Tegra::GPUVAddr zeta_address,
@@ -651,10 +117,11 @@ struct SurfaceParams {
 
     bool operator==(const SurfaceParams& other) const {
         return std::tie(addr, is_tiled, block_height, pixel_format, component_type, type, width,
-                        height, unaligned_height, size_in_bytes) ==
+                        height, unaligned_height, size_in_bytes, num_levels, resolution_scale) ==
                std::tie(other.addr, other.is_tiled, other.block_height, other.pixel_format,
                         other.component_type, other.type, other.width, other.height,
-                        other.unaligned_height, other.size_in_bytes);
+                        other.unaligned_height, other.size_in_bytes, other.num_levels,
+                        other.resolution_scale);
     }
 
     bool operator!=(const SurfaceParams& other) const {
@@ -663,8 +130,9 @@ struct SurfaceParams {
 
     /// Checks if surfaces are compatible for caching
     bool IsCompatibleSurface(const SurfaceParams& other) const {
-        return std::tie(pixel_format, type, cache_width, cache_height) ==
-               std::tie(other.pixel_format, other.type, other.cache_width, other.cache_height);
+        return std::tie(pixel_format, type, cache_width, cache_height, num_levels) ==
+               std::tie(other.pixel_format, other.type, other.cache_width, other.cache_height,
+                        other.num_levels);
     }
 
     Tegra::GPUVAddr addr;
@@ -677,6 +145,9 @@ struct SurfaceParams {
     u32 height;
     u32 unaligned_height;
     size_t size_in_bytes;
+    u32 num_levels;
+    /// Factor the host texture's resolution is scaled by, only render targets are scaled
+    float resolution_scale;
 
     // Parameters used for caching only
     u32 cache_width;
@@ -708,6 +179,9 @@ class CachedSurface final {
 public:
     CachedSurface(const SurfaceParams& params);
 
+    /// Creates a surface reinterpreting the storage of another one through a texture view
+    CachedSurface(const SurfaceParams& params, const CachedSurface& aliased_surface);
+
     const OGLTexture& Texture() const {
         return texture;
     }
@@ -716,30 +190,150 @@ public:
         if (format == SurfaceParams::PixelFormat::Invalid)
             return 0;
 
-        return SurfaceParams::GetFormatBpp(format) / CHAR_BIT;
+        return VideoCore::Surface::GetFormatBpp(format) / CHAR_BIT;
     }
 
     const SurfaceParams& GetSurfaceParams() const {
         return params;
     }
 
-    // Read/Write data in Switch memory to/from gl_buffer
-    void LoadGLBuffer();
+    /// Returns the host memory taken by the surface's texture
+    size_t GetHostSizeInBytes() const {
+        size_t size = 0;
+        for (u32 level = 0; level < params.num_levels; ++level) {
+            size += params.GetMipWidth(level) * params.GetMipHeight(level) *
+                    GetGLBytesPerPixel(params.pixel_format);
+        }
+        const float scale_squared = params.resolution_scale * params.resolution_scale;
+        size = static_cast<size_t>(size * scale_squared);
+        if (native_texture.handle != 0) {
+            size += params.width * params.height * GetGLBytesPerPixel(params.pixel_format);
+        }
+        return size;
+    }
+
+    /// Records the frame in which the surface was last looked up, for LRU eviction
+    void MarkAsUsed(u64 frame) {
+        last_used_frame = frame;
+    }
+
+    u64 GetLastUsedFrame() const {
+        return last_used_frame;
+    }
+
+    /// Marks whether the host GPU holds contents that were not written back to Switch memory
+    void MarkAsModified(bool modified);
+
+    bool IsModified() const {
+        return is_modified;
+    }
+
+    /// Frees the host copy of the surface, it is only needed while uploading or flushing
+    void ReleaseGLBuffer() {
+        std::vector<u8>().swap(gl_buffer);
+        gl_buffer_memory.Update(0);
+        // A finished readback only lives in gl_buffer
+        download_ready = false;
+    }
+
+    /// Marks the mipmap levels overlapping the specified region as out of date with memory
+    void InvalidateMipLevels(Tegra::GPUVAddr region_addr, size_t region_size);
+
+    /// Returns a mask of the mipmap levels that have to be reloaded from memory
+    u32 GetDirtyMipLevels() const {
+        return dirty_levels;
+    }
+
+    void ClearDirtyMipLevels() {
+        dirty_levels = 0;
+    }
+
+    // Read/Write data in Switch memory to/from gl_buffer. Loading works one mipmap level at a time,
+    // flushing only supports the base level, as only render targets are flushed.
+    void LoadGLBuffer(u32 level);
     void FlushGLBuffer();
 
-    // Upload/Download data in gl_buffer in/to this surface's texture
-    void UploadGLTexture(GLuint read_fb_handle, GLuint draw_fb_handle);
-    void DownloadGLTexture(GLuint read_fb_handle, GLuint draw_fb_handle);
+    // Upload/Download data in gl_buffer in/to this surface's texture, going through the staging
+    // buffer when the surface fits in it
+    void UploadGLTexture(u32 level, GLuint read_fb_handle, GLuint draw_fb_handle,
+                         OGLStagingBuffer& staging_buffer);
+    void DownloadGLTexture(GLuint read_fb_handle, GLuint draw_fb_handle,
+                           OGLStagingBuffer& staging_buffer);
+
+    /**
+     * Loads a mipmap level from Switch memory straight into the texture, unswizzling and
+     * converting it on the GPU. Returns false if the level has to go through gl_buffer instead.
+     */
+    bool DecodeGLTexture(u32 level, ComputeTextureDecoder& decoder,
+                         OGLStagingBuffer& staging_buffer);
+
+    /// Starts reading this surface's texture back into a buffer of its own, without waiting
+    void BeginDownloadGLTexture(GLuint read_fb_handle);
+
+    /// Waits for the readback started by BeginDownloadGLTexture and copies it to gl_buffer
+    void FinishDownloadGLTexture();
+
+    /// Finishes the readback if the host GPU is already done with it, returns whether it did
+    bool TryFinishDownloadGLTexture();
+
+    /// Drops the pending readback, if any, for when the surface contents are no longer needed
+    void CancelPendingDownload();
+
+    /**
+     * Scaled surfaces are loaded and read back at the guest's resolution through a texture of
+     * that size. These copy between it and the scaled texture, after loading and before reading
+     * back respectively.
+     */
+    void UpscaleFromNativeTexture(GLuint read_fb_handle, GLuint draw_fb_handle);
+    void DownscaleToNativeTexture(GLuint read_fb_handle, GLuint draw_fb_handle);
+
+    /// Whether the host GPU contents were read back but not written to Switch memory yet
+    bool HasPendingDownload() const {
+        return download_fence.handle != 0 || download_ready;
+    }
+
+    /// Whether the readback is already in gl_buffer, so flushing needs no GL calls
+    bool IsDownloadReady() const {
+        return download_ready;
+    }
 
 private:
+    /// Returns the region of a mipmap level that is loaded, and its offset in the linear data
+    MathUtil::Rectangle<u32> GetMipLevelRect(u32 level) const;
+    size_t GetMipLevelRectOffset(u32 level) const;
+
+    /// Writes pixels into a mipmap level, a client pointer or an offset in the bound unpack buffer
+    void WriteGLTexture(u32 level, const GLvoid* pixels);
+
+    /// Reads the texture into pixels, a client pointer or an offset in the bound pack buffer
+    void ReadGLTexture(GLuint read_fb_handle, GLvoid* pixels);
+
+    /// Sizes gl_buffer for a download and returns the offset of the surface rectangle in it
+    size_t ResizeGLBufferForDownload();
+
+    /// Returns the texture pixel transfers go through, creating the native one if needed
+    GLuint GetTransferTexture();
+
     OGLTexture texture;
+    /// Texture at the guest's resolution, only created for scaled surfaces
+    OGLTexture native_texture;
     std::vector<u8> gl_buffer;
+    Common::TrackedMemory gl_buffer_memory{Common::MemoryTag::SurfaceBuffers};
     SurfaceParams params;
+
+    OGLBuffer download_pbo;
+    GLsizeiptr download_pbo_size = 0;
+    OGLSync download_fence;
+    bool download_ready = false;
+
+    u64 last_used_frame = 0;
+    bool is_modified = false;
+    u32 dirty_levels = 0;
 };
 
 class RasterizerCacheOpenGL final : NonCopyable {
 public:
-    RasterizerCacheOpenGL();
+    explicit RasterizerCacheOpenGL(VideoCore::RasterizerCachedPages& cached_pages);
     ~RasterizerCacheOpenGL();
 
     /// Get a surface based on the texture configuration
@@ -749,20 +343,69 @@ public:
     SurfaceSurfaceRect_Tuple GetFramebufferSurfaces(bool using_color_fb, bool using_depth_fb,
                                                     bool preserve_contents);
 
+    /**
+     * Get a surface to be cleared as a whole. Neither what the guest wrote to it nor what the
+     * host GPU rendered to it is loaded or flushed first, the clear overwrites both.
+     */
+    Surface GetClearSurface(const SurfaceParams& params);
+
     /// Flushes the surface to Switch memory
     void FlushSurface(const Surface& surface);
 
+    /**
+     * Starts reading the surface back from the host GPU without waiting for it. The data is only
+     * written to Switch memory once the region is flushed or invalidated, or the surface is
+     * flushed explicitly.
+     */
+    void FlushSurfaceAsync(const Surface& surface);
+
     /// Tries to find a framebuffer GPU address based on the provided CPU address
     Surface TryFindFramebufferSurface(VAddr cpu_addr) const;
 
+    /// Returns the surface to present for the framebuffer, loading it into the cache if nothing
+    /// was rendered to it. Null if the framebuffer isn't mapped in the GPU address space. The
+    /// CPU address is only translated when the framebuffer's GPU address is unknown.
+    Surface GetDisplaySurface(const Tegra::FramebufferConfig& config, VAddr cpu_addr);
+
+    /// Returns the surface cached at the specified GPU address, if any
+    Surface TryGetCachedSurface(Tegra::GPUVAddr addr) const;
+
+    /**
+     * Reads the base level of a color surface back as RGBA8 pixels at the guest's resolution, in
+     * rows from top to bottom. Returns false if the GPU can't convert the surface's format.
+     */
+    bool ReadSurfaceRGBA8(const Surface& surface, std::vector<u8>& pixels);
+
+    /// Copies the contents of one cached surface to another on the host GPU
+    void CopySurface(const Surface& src_surface, const Surface& dst_surface);
+
     /// Write any cached resources overlapping the region back to memory (if dirty)
     void FlushRegion(Tegra::GPUVAddr addr, size_t size);
 
+    /// Returns whether flushing the region has to wait on the host GPU, which needs the context
+    bool HasUnfinishedDownloads(Tegra::GPUVAddr addr, size_t size) const;
+
+    /**
+     * Copies the readbacks the host GPU is done with to their surfaces' buffers, so that the
+     * flushes of the CPU find them ready. Must be called with the context held.
+     */
+    void FinishReadyDownloads();
+
     /// Mark the specified region as being invalidated
     void InvalidateRegion(Tegra::GPUVAddr addr, size_t size);
 
+    /// Unregisters every surface, their textures are kept in the reserve for reuse
+    void InvalidateAll();
+
+    /// Advances the LRU clock and evicts surfaces if the cache is over its size budget
+    void TickFrame();
+
 private:
-    void LoadSurface(const Surface& surface);
+    /// Loads the mipmap levels in level_mask from memory and uploads them to the surface
+    void LoadSurface(const Surface& surface, u32 level_mask);
+
+    /// Get a surface for the parameters. Without preserve_contents its base level is about to be
+    /// overwritten, so its contents aren't loaded or flushed.
     Surface GetSurface(const SurfaceParams& params, bool preserve_contents = true);
 
     /// Recreates a surface with new parameters
@@ -780,17 +423,31 @@ private:
     /// Tries to get a reserved surface for the specified parameters
     Surface TryGetReservedSurface(const SurfaceParams& params);
 
-    /// Increase/decrease the number of surface in pages touching the specified region
-    void UpdatePagesCachedCount(Tegra::GPUVAddr addr, u64 size, int delta);
+    /// Returns the registered surfaces whose GPU address range overlaps the specified region
+    SurfaceSet GetSurfacesInRegion(Tegra::GPUVAddr addr, u64 size) const;
+
+    /// Drops least recently used surfaces that match Switch memory until the cache fits in budget
+    void EvictSurfaces(size_t budget);
 
     std::unordered_map<Tegra::GPUVAddr, Surface> surface_cache;
-    PageMap cached_pages;
+    /// Registered surfaces indexed by the GPU address range they cover, for overlap queries
+    SurfaceMap surface_map;
+    /// Page counts shared with the other caches of the rasterizer
+    VideoCore::RasterizerCachedPages& cached_pages;
 
     /// The surface reserve is a "backup" cache, this is where we put unique surfaces that have
     /// previously been used. This is to prevent surfaces from being constantly created and
     /// destroyed when used with different surface parameters.
     std::unordered_map<SurfaceReserveKey, Surface> surface_reserve;
 
+    /// Surfaces with a readback that may still be running on the host GPU
+    std::vector<Surface> unfinished_downloads;
+
+    /// Number of frames presented so far, used as the LRU clock of the surfaces
+    u64 current_frame = 1;
+
+    OGLStagingBuffer staging_buffer;
+    ComputeTextureDecoder texture_decoder;
     OGLFramebuffer read_framebuffer;
     OGLFramebuffer draw_framebuffer;
 };
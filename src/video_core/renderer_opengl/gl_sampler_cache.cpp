@@ -0,0 +1,45 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <cstring>
+#include "video_core/renderer_opengl/gl_sampler_cache.h"
+#include "video_core/renderer_opengl/maxwell_to_gl.h"
+
+namespace OpenGL {
+
+GLuint SamplerCache::GetSampler(const Tegra::Texture::TSCEntry& config) {
+    Key key;
+    static_assert(sizeof(Key) == sizeof(config), "Key doesn't cover the whole TSC entry");
+    std::memcpy(key.data(), &config, sizeof(Key));
+
+    auto iter = samplers.find(key);
+    if (iter == samplers.end()) {
+        iter = samplers.emplace(key, CreateSampler(config)).first;
+    }
+    return iter->second.handle;
+}
+
+OGLSampler SamplerCache::CreateSampler(const Tegra::Texture::TSCEntry& config) {
+    OGLSampler sampler;
+    sampler.Create();
+    const GLuint s = sampler.handle;
+
+    glSamplerParameteri(s, GL_TEXTURE_MAG_FILTER,
+                        MaxwellToGL::TextureFilterMode(config.mag_filter));
+    glSamplerParameteri(s, GL_TEXTURE_MIN_FILTER,
+                        MaxwellToGL::TextureFilterMode(config.min_filter, config.mip_filter));
+    glSamplerParameteri(s, GL_TEXTURE_WRAP_S, MaxwellToGL::WrapMode(config.wrap_u));
+    glSamplerParameteri(s, GL_TEXTURE_WRAP_T, MaxwellToGL::WrapMode(config.wrap_v));
+
+    if (config.wrap_u == Tegra::Texture::WrapMode::Border ||
+        config.wrap_v == Tegra::Texture::WrapMode::Border) {
+        const GLvec4 border_color = {{config.border_color_r, config.border_color_g,
+                                      config.border_color_b, config.border_color_a}};
+        glSamplerParameterfv(s, GL_TEXTURE_BORDER_COLOR, border_color.data());
+    }
+
+    return sampler;
+}
+
+} // namespace OpenGL
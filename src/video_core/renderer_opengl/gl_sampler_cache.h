@@ -0,0 +1,42 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <unordered_map>
+#include <glad/glad.h>
+#include "common/common_types.h"
+#include "common/hash.h"
+#include "video_core/renderer_opengl/gl_resource_manager.h"
+#include "video_core/textures/texture.h"
+
+namespace OpenGL {
+
+/**
+ * Keeps one sampler object per distinct TSC entry seen so far. Sampler parameters are only set
+ * when the object is created, so switching the sampler of a texture unit is just a rebind.
+ */
+class SamplerCache final : NonCopyable {
+public:
+    /// Returns the sampler object matching the configuration, creating it the first time
+    GLuint GetSampler(const Tegra::Texture::TSCEntry& config);
+
+private:
+    /// Raw words of the TSC entry, its bitfields can't be compared or hashed directly
+    using Key = std::array<u32, sizeof(Tegra::Texture::TSCEntry) / sizeof(u32)>;
+
+    struct KeyHash {
+        size_t operator()(const Key& key) const {
+            return static_cast<size_t>(Common::ComputeHash64(key.data(), sizeof(Key)));
+        }
+    };
+
+    static OGLSampler CreateSampler(const Tegra::Texture::TSCEntry& config);
+
+    std::unordered_map<Key, OGLSampler, KeyHash> samplers;
+};
+
+} // namespace OpenGL
@@ -3,9 +3,11 @@
 // Refer to the license.txt file included.
 
 #include <map>
+#include <mutex>
 #include <set>
 #include <string>
 #include <string_view>
+#include <tuple>
 
 #include <fmt/format.h>
 
@@ -28,6 +30,11 @@ using Tegra::Shader::SubOp;
 constexpr u32 PROGRAM_END = MAX_PROGRAM_CODE_LENGTH;
 constexpr u32 PROGRAM_HEADER_SIZE = 0x50;
 
+/// Storage reserved up front for the code and the declarations of a decompiled program, enough
+/// for most programs to be written without growing the strings
+constexpr size_t SHADER_CODE_CAPACITY = 64 * 1024;
+constexpr size_t SHADER_DECLARATIONS_CAPACITY = 8 * 1024;
+
 class DecompileFail : public std::runtime_error {
 public:
     using std::runtime_error::runtime_error;
@@ -43,16 +50,15 @@ enum class ExitMethod {
 
 /// A subroutine is a range of code refereced by a CALL, IF or LOOP instruction.
 struct Subroutine {
-    /// Generates a name suitable for GLSL source code.
-    std::string GetName() const {
+    /// Generates a name suitable for GLSL source code, the suffix of the shader makes it unique.
+    std::string GetName(const std::string& suffix) const {
         return "sub_" + std::to_string(begin) + '_' + std::to_string(end) + '_' + suffix;
     }
 
-    u32 begin;                 ///< Entry point of the subroutine.
-    u32 end;                   ///< Return point of the subroutine.
-    const std::string& suffix; ///< Suffix of the shader, used to make a unique subroutine name
-    ExitMethod exit_method;    ///< Exit method of the subroutine.
-    std::set<u32> labels;      ///< Addresses refereced by JMP instructions.
+    u32 begin;              ///< Entry point of the subroutine.
+    u32 end;                ///< Return point of the subroutine.
+    ExitMethod exit_method; ///< Exit method of the subroutine.
+    std::set<u32> labels;   ///< Addresses refereced by JMP instructions.
 
     bool operator<(const Subroutine& rhs) const {
         return std::tie(begin, end) < std::tie(rhs.begin, rhs.end);
@@ -62,11 +68,11 @@ struct Subroutine {
 /// Analyzes shader code and produces a set of subroutines.
 class ControlFlowAnalyzer {
 public:
-    ControlFlowAnalyzer(const ProgramCode& program_code, u32 main_offset, const std::string& suffix)
+    ControlFlowAnalyzer(const ProgramCode& program_code, u32 main_offset)
         : program_code(program_code) {
 
         // Recursively finds all subroutines.
-        const Subroutine& program_main = AddSubroutine(main_offset, PROGRAM_END, suffix);
+        const Subroutine& program_main = AddSubroutine(main_offset, PROGRAM_END);
         if (program_main.exit_method != ExitMethod::AlwaysEnd)
             throw DecompileFail("Program does not always end");
     }
@@ -81,8 +87,8 @@ private:
     std::map<std::pair<u32, u32>, ExitMethod> exit_method_map;
 
     /// Adds and analyzes a new subroutine if it is not added yet.
-    const Subroutine& AddSubroutine(u32 begin, u32 end, const std::string& suffix) {
-        Subroutine subroutine{begin, end, suffix, ExitMethod::Undetermined, {}};
+    const Subroutine& AddSubroutine(u32 begin, u32 end) {
+        Subroutine subroutine{begin, end, ExitMethod::Undetermined, {}};
 
         const auto iter = subroutines.find(subroutine);
         if (iter != subroutines.end()) {
@@ -160,6 +166,10 @@ private:
 
 class ShaderWriter {
 public:
+    explicit ShaderWriter(size_t capacity) {
+        shader_source.reserve(capacity);
+    }
+
     void AddLine(std::string_view text) {
         DEBUG_ASSERT(scope >= 0);
         if (!text.empty()) {
@@ -430,11 +440,27 @@ public:
         }
         declarations.AddNewLine();
 
+        // Directly accessed buffers are declared with the size uploaded for them. The range of an
+        // indirectly accessed one isn't known, it's read from a storage buffer instead, which
+        // takes the size of the range bound to it. Without storage buffers, it's declared with
+        // the maximum size.
         for (const auto& entry : GetConstBuffersDeclarations()) {
-            declarations.AddLine("layout(std140) uniform " + entry.GetName());
-            declarations.AddLine('{');
-            declarations.AddLine("    vec4 c" + std::to_string(entry.GetIndex()) +
-                                 "[MAX_CONSTBUFFER_ELEMENTS];");
+            const std::string binding = std::to_string(entry.GetBinding());
+            const std::string array = 'c' + std::to_string(entry.GetIndex());
+            if (entry.IsStorageBuffer()) {
+                declarations.AddLine("layout(std430, binding = " + binding + ") readonly buffer " +
+                                     entry.GetName());
+                declarations.AddLine('{');
+                declarations.AddLine("    vec4 " + array + "[];");
+            } else {
+                declarations.AddLine("layout(std140, binding = " + binding + ") uniform " +
+                                     entry.GetName());
+                declarations.AddLine('{');
+                const std::string size = entry.IsIndirect()
+                                             ? "MAX_CONSTBUFFER_ELEMENTS"
+                                             : std::to_string(entry.GetDeclaredSize());
+                declarations.AddLine("    vec4 " + array + '[' + size + "];");
+            }
             declarations.AddLine("};");
             declarations.AddNewLine();
         }
@@ -640,7 +666,7 @@ private:
 
     /// Gets the Subroutine object corresponding to the specified address.
     const Subroutine& GetSubroutine(u32 begin, u32 end) const {
-        auto iter = subroutines.find(Subroutine{begin, end, suffix});
+        auto iter = subroutines.find(Subroutine{begin, end});
         ASSERT(iter != subroutines.end());
         return *iter;
     }
@@ -666,12 +692,12 @@ private:
      */
     void CallSubroutine(const Subroutine& subroutine) {
         if (subroutine.exit_method == ExitMethod::AlwaysEnd) {
-            shader.AddLine(subroutine.GetName() + "();");
+            shader.AddLine(subroutine.GetName(suffix) + "();");
             shader.AddLine("return true;");
         } else if (subroutine.exit_method == ExitMethod::Conditional) {
-            shader.AddLine("if (" + subroutine.GetName() + "()) { return true; }");
+            shader.AddLine("if (" + subroutine.GetName(suffix) + "()) { return true; }");
         } else {
-            shader.AddLine(subroutine.GetName() + "();");
+            shader.AddLine(subroutine.GetName(suffix) + "();");
         }
     }
 
@@ -2101,7 +2127,7 @@ private:
     void Generate(const std::string& suffix) {
         // Add declarations for all subroutines
         for (const auto& subroutine : subroutines) {
-            shader.AddLine("bool " + subroutine.GetName() + "();");
+            shader.AddLine("bool " + subroutine.GetName(suffix) + "();");
         }
         shader.AddNewLine();
 
@@ -2116,7 +2142,7 @@ private:
         for (const auto& subroutine : subroutines) {
             std::set<u32> labels = subroutine.labels;
 
-            shader.AddLine("bool " + subroutine.GetName() + "() {");
+            shader.AddLine("bool " + subroutine.GetName(suffix) + "() {");
             ++shader.scope;
 
             if (labels.empty()) {
@@ -2191,8 +2217,8 @@ private:
     Maxwell3D::Regs::ShaderStage stage;
     const std::string& suffix;
 
-    ShaderWriter shader;
-    ShaderWriter declarations;
+    ShaderWriter shader{SHADER_CODE_CAPACITY};
+    ShaderWriter declarations{SHADER_DECLARATIONS_CAPACITY};
     GLSLRegisterManager regs{shader, declarations, stage, suffix};
 
     // Declarations
@@ -2204,11 +2230,39 @@ std::string GetCommonDeclarations() {
                        RasterizerOpenGL::MaxConstbufferSize / sizeof(GLvec4));
 }
 
-boost::optional<ProgramResult> DecompileProgram(const ProgramCode& program_code, u32 main_offset,
+/**
+ * Returns the subroutines of a program, only analyzing its control flow the first time. The
+ * analysis doesn't depend on the shader config, so every variant of a program shares it.
+ */
+static const std::set<Subroutine>& GetSubroutines(const ProgramCode& program_code,
+                                                  u64 program_hash, u32 main_offset,
+                                                  const std::string& suffix) {
+    // Entries are never removed, so references to them stay valid once the lock is released
+    static std::map<std::tuple<u64, u32, std::string>, std::set<Subroutine>> analysis_cache;
+    static std::mutex analysis_mutex;
+
+    auto key = std::make_tuple(program_hash, main_offset, suffix);
+    {
+        std::lock_guard<std::mutex> lock(analysis_mutex);
+        const auto iter = analysis_cache.find(key);
+        if (iter != analysis_cache.end()) {
+            return iter->second;
+        }
+    }
+
+    // Programs whose analysis fails throw before anything is cached
+    auto subroutines = ControlFlowAnalyzer(program_code, main_offset).GetSubroutines();
+
+    std::lock_guard<std::mutex> lock(analysis_mutex);
+    return analysis_cache.emplace(std::move(key), std::move(subroutines)).first->second;
+}
+
+boost::optional<ProgramResult> DecompileProgram(const ProgramCode& program_code, u64 program_hash,
+                                                u32 main_offset,
                                                 Maxwell3D::Regs::ShaderStage stage,
                                                 const std::string& suffix) {
     try {
-        auto subroutines = ControlFlowAnalyzer(program_code, main_offset, suffix).GetSubroutines();
+        const auto& subroutines = GetSubroutines(program_code, program_hash, main_offset, suffix);
         GLSLGenerator generator(subroutines, program_code, main_offset, stage, suffix);
         return ProgramResult{generator.GetShaderCode(), generator.GetEntries()};
     } catch (const DecompileFail& exception) {
@@ -18,7 +18,16 @@ using Tegra::Engines::Maxwell3D;
 
 std::string GetCommonDeclarations();
 
-boost::optional<ProgramResult> DecompileProgram(const ProgramCode& program_code, u32 main_offset,
+/**
+ * Decompiles a program to GLSL
+ * @param program_code Code of the program
+ * @param program_hash Hash identifying program_code, its control flow analysis is reused
+ * @param main_offset Offset of the entry point in program_code
+ * @param stage Shader stage the program is used in
+ * @param suffix Suffix of the GLSL identifiers, unique to the program within a shader
+ */
+boost::optional<ProgramResult> DecompileProgram(const ProgramCode& program_code, u64 program_hash,
+                                                u32 main_offset,
                                                 Maxwell3D::Regs::ShaderStage stage,
                                                 const std::string& suffix);
 
@@ -0,0 +1,221 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <cstring>
+#include <type_traits>
+#include <fmt/format.h>
+#include "common/common_funcs.h"
+#include "common/common_paths.h"
+#include "common/logging/log.h"
+#include "common/scm_rev.h"
+#include "video_core/renderer_opengl/gl_shader_disk_cache.h"
+
+namespace OpenGL::GLShader {
+
+constexpr u32 CACHE_MAGIC = Common::MakeMagic('Y', 'S', 'D', 'C');
+/// Has to be bumped whenever the layout of the file or the generated GLSL changes
+constexpr u32 CACHE_VERSION = 4;
+
+/// Written before each record of the file
+enum class RecordType : u32 {
+    Stage = 0,
+    Pipeline = 1,
+};
+
+// Entries are stored as plain copies of these, the file is only read back by the same build
+static_assert(std::is_trivially_copyable_v<MaxwellShaderConfigCommon>);
+static_assert(std::is_trivially_copyable_v<ConstBufferEntry>);
+
+template <typename T>
+static bool ReadObject(const FileUtil::IOFile& file, T& object) {
+    return file.ReadBytes(&object, sizeof(T)) == sizeof(T);
+}
+
+template <typename T>
+static bool ReadVector(const FileUtil::IOFile& file, std::vector<T>& data) {
+    u32 size;
+    if (!ReadObject(file, size)) {
+        return false;
+    }
+    data.resize(size);
+    return file.ReadArray(data.data(), size) == size;
+}
+
+static bool ReadString(const FileUtil::IOFile& file, std::string& string) {
+    u32 size;
+    if (!ReadObject(file, size)) {
+        return false;
+    }
+    string.resize(size);
+    return file.ReadBytes(string.data(), size) == size;
+}
+
+static bool ReadEntry(const FileUtil::IOFile& file, ShaderDiskCacheEntry& entry) {
+    u32 num_samplers;
+    if (!ReadObject(file, entry.type) || !ReadObject(file, entry.program_hash) ||
+        !ReadVector(file, entry.config) || !ReadString(file, entry.program.first) ||
+        !ReadVector(file, entry.program.second.const_buffer_entries) ||
+        !ReadObject(file, num_samplers)) {
+        return false;
+    }
+
+    auto& samplers = entry.program.second.texture_samplers;
+    samplers.reserve(num_samplers);
+    for (u32 i = 0; i < num_samplers; ++i) {
+        u64 offset;
+        Tegra::Engines::Maxwell3D::Regs::ShaderStage stage;
+        u64 index;
+        if (!ReadObject(file, offset) || !ReadObject(file, stage) || !ReadObject(file, index)) {
+            return false;
+        }
+        samplers.emplace_back(stage, static_cast<size_t>(offset), static_cast<size_t>(index));
+    }
+
+    return ReadObject(file, entry.binary_format) && ReadVector(file, entry.binary);
+}
+
+static bool ReadPipeline(const FileUtil::IOFile& file, ShaderDiskCachePipeline& pipeline) {
+    return ReadVector(file, pipeline.vertex_config) && ReadVector(file, pipeline.fragment_config);
+}
+
+template <typename T>
+static void WriteVector(FileUtil::IOFile& file, const std::vector<T>& data) {
+    file.WriteObject(static_cast<u32>(data.size()));
+    file.WriteArray(data.data(), data.size());
+}
+
+static void WriteString(FileUtil::IOFile& file, const std::string& string) {
+    file.WriteObject(static_cast<u32>(string.size()));
+    file.WriteString(string);
+}
+
+void ShaderDiskCache::Open(u64 title_id) {
+    const std::string path{fmt::format("{}shader" DIR_SEP "{:016X}.bin",
+                                       FileUtil::GetUserPath(FileUtil::UserPath::CacheDir),
+                                       title_id)};
+    if (!FileUtil::CreateFullPath(path)) {
+        LOG_ERROR(Render_OpenGL, "Could not create the shader cache directory for {}", path);
+        return;
+    }
+
+    if (FileUtil::Exists(path) && Read(path)) {
+        std::size_t entries_size = entries.capacity() * sizeof(ShaderDiskCacheEntry) +
+                                   pipelines.capacity() * sizeof(ShaderDiskCachePipeline);
+        for (const ShaderDiskCacheEntry& entry : entries) {
+            entries_size += entry.config.capacity() + entry.program.first.capacity() +
+                            entry.binary.capacity();
+        }
+        for (const ShaderDiskCachePipeline& pipeline : pipelines) {
+            entries_size += pipeline.vertex_config.capacity() + pipeline.fragment_config.capacity();
+        }
+        entries_memory.Update(entries_size);
+
+        LOG_INFO(Render_OpenGL, "Read {} shaders and {} pipelines from the disk cache",
+                 entries.size(), pipelines.size());
+        file.Open(path, "ab");
+        return;
+    }
+
+    entries.clear();
+    pipelines.clear();
+    entries_memory.Update(0);
+    if (!file.Open(path, "wb")) {
+        LOG_ERROR(Render_OpenGL, "Could not create the shader cache file {}", path);
+        return;
+    }
+    file.WriteObject(CACHE_MAGIC);
+    file.WriteObject(CACHE_VERSION);
+    WriteString(file, Common::g_scm_rev);
+    file.WriteObject(static_cast<u8>(AreStorageBuffersEnabled()));
+    file.Flush();
+}
+
+bool ShaderDiskCache::Read(const std::string& path) {
+    const FileUtil::IOFile input(path, "rb");
+
+    u32 magic;
+    u32 version;
+    std::string build;
+    if (!ReadObject(input, magic) || !ReadObject(input, version) || !ReadString(input, build) ||
+        magic != CACHE_MAGIC || version != CACHE_VERSION) {
+        LOG_WARNING(Render_OpenGL, "Shader cache {} is invalid, discarding it", path);
+        return false;
+    }
+    if (build != Common::g_scm_rev) {
+        LOG_INFO(Render_OpenGL, "Shader cache {} was written by a different build, discarding it",
+                 path);
+        return false;
+    }
+    // The generated GLSL declares the indirectly accessed const buffers differently
+    u8 storage_buffers;
+    if (!ReadObject(input, storage_buffers) ||
+        storage_buffers != static_cast<u8>(AreStorageBuffersEnabled())) {
+        LOG_INFO(Render_OpenGL, "Shader cache {} was written for other host limits, discarding it",
+                 path);
+        return false;
+    }
+
+    const u64 file_size = input.GetSize();
+    while (input.Tell() < file_size) {
+        RecordType type;
+        bool is_valid = ReadObject(input, type);
+        if (is_valid && type == RecordType::Stage) {
+            ShaderDiskCacheEntry entry;
+            is_valid = ReadEntry(input, entry);
+            entries.push_back(std::move(entry));
+        } else if (is_valid && type == RecordType::Pipeline) {
+            ShaderDiskCachePipeline pipeline;
+            is_valid = ReadPipeline(input, pipeline);
+            pipelines.push_back(std::move(pipeline));
+        } else {
+            is_valid = false;
+        }
+
+        if (!is_valid) {
+            LOG_WARNING(Render_OpenGL, "Shader cache {} is truncated, discarding it", path);
+            return false;
+        }
+    }
+    return true;
+}
+
+void ShaderDiskCache::Save(const ShaderDiskCacheEntry& entry) {
+    if (!IsOpen()) {
+        return;
+    }
+
+    file.WriteObject(RecordType::Stage);
+    file.WriteObject(entry.type);
+    file.WriteObject(entry.program_hash);
+    WriteVector(file, entry.config);
+    WriteString(file, entry.program.first);
+    WriteVector(file, entry.program.second.const_buffer_entries);
+
+    const auto& samplers = entry.program.second.texture_samplers;
+    file.WriteObject(static_cast<u32>(samplers.size()));
+    for (const SamplerEntry& sampler : samplers) {
+        file.WriteObject(static_cast<u64>(sampler.GetOffset()));
+        file.WriteObject(sampler.GetStage());
+        file.WriteObject(static_cast<u64>(sampler.GetIndex()));
+    }
+
+    file.WriteObject(entry.binary_format);
+    WriteVector(file, entry.binary);
+
+    // Keep the file complete in case emulation doesn't end cleanly
+    file.Flush();
+}
+
+void ShaderDiskCache::SavePipeline(const ShaderDiskCachePipeline& pipeline) {
+    if (!IsOpen()) {
+        return;
+    }
+
+    file.WriteObject(RecordType::Pipeline);
+    WriteVector(file, pipeline.vertex_config);
+    WriteVector(file, pipeline.fragment_config);
+    file.Flush();
+}
+
+} // namespace OpenGL::GLShader
@@ -0,0 +1,86 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <glad/glad.h>
+#include "common/common_types.h"
+#include "common/file_util.h"
+#include "common/memory_tracker.h"
+#include "video_core/engines/maxwell_3d.h"
+#include "video_core/renderer_opengl/gl_shader_gen.h"
+
+namespace OpenGL::GLShader {
+
+/// A shader stage as stored in the disk cache
+struct ShaderDiskCacheEntry {
+    GLenum type;              ///< Shader type, GL_VERTEX_SHADER or GL_FRAGMENT_SHADER
+    u64 program_hash;         ///< Hash of the guest program code, from ShaderSetup
+    std::vector<u8> config;   ///< Bytes of the stage's config key, i.e. MaxwellVSConfig::state
+    ProgramResult program;    ///< Decompiled GLSL source and the resources it uses
+    GLenum binary_format = 0; ///< Format of the program binary, empty if not available
+    std::vector<u8> binary;   ///< Program binary returned by glGetProgramBinary
+};
+
+/// A combination of stages that was drawn with, identified by the config keys of the stages
+struct ShaderDiskCachePipeline {
+    std::vector<u8> vertex_config;   ///< Bytes of the vertex stage's MaxwellVSConfig::state
+    std::vector<u8> fragment_config; ///< Bytes of the fragment stage's MaxwellFSConfig::state
+};
+
+/**
+ * Per-title file of the shaders seen in previous sessions. New shaders are appended as they are
+ * compiled, so the file stays valid even if emulation doesn't end cleanly. The whole file is
+ * discarded when it was written by a different build, as both the decompiler output and the
+ * layout of the shader entries may have changed. Besides the stages, the file records which
+ * stages were used together, so their pipelines can be created before they are drawn with.
+ */
+class ShaderDiskCache {
+public:
+    /// Opens the cache of a title, reading the entries stored by previous sessions
+    void Open(u64 title_id);
+
+    bool IsOpen() const {
+        return file.IsOpen();
+    }
+
+    /// Returns the entries read by Open, in the order they were stored
+    const std::vector<ShaderDiskCacheEntry>& GetEntries() const {
+        return entries;
+    }
+
+    /// Returns the pipelines read by Open, in the order they were stored
+    const std::vector<ShaderDiskCachePipeline>& GetPipelines() const {
+        return pipelines;
+    }
+
+    /// Drops the entries and pipelines read by Open once they have been loaded
+    void ReleaseEntries() {
+        entries.clear();
+        entries.shrink_to_fit();
+        pipelines.clear();
+        pipelines.shrink_to_fit();
+        entries_memory.Update(0);
+    }
+
+    /// Appends an entry to the file
+    void Save(const ShaderDiskCacheEntry& entry);
+
+    /// Appends a pipeline to the file
+    void SavePipeline(const ShaderDiskCachePipeline& pipeline);
+
+private:
+    /// Reads the entries of a cache file, returning false if the file has to be discarded
+    bool Read(const std::string& path);
+
+    FileUtil::IOFile file;
+    std::vector<ShaderDiskCacheEntry> entries;
+    std::vector<ShaderDiskCachePipeline> pipelines;
+    /// Memory held by the entries and pipelines until they are released
+    Common::TrackedMemory entries_memory{Common::MemoryTag::ShaderCache};
+};
+
+} // namespace OpenGL::GLShader
@@ -13,6 +13,16 @@ using Tegra::Engines::Maxwell3D;
 
 static constexpr u32 PROGRAM_OFFSET{10};
 
+static bool storage_buffers_enabled = false;
+
+void SetStorageBuffersEnabled(bool enabled) {
+    storage_buffers_enabled = enabled;
+}
+
+bool AreStorageBuffersEnabled() {
+    return storage_buffers_enabled;
+}
+
 ProgramResult GenerateVertexShader(const ShaderSetup& setup, const MaxwellVSConfig& config) {
     std::string out = "#version 430 core\n";
     out += "#extension GL_ARB_separate_shader_objects : enable\n\n";
@@ -24,7 +34,7 @@ ProgramResult GenerateVertexShader(const ShaderSetup& setup, const MaxwellVSConf
     }
 
     ProgramResult program =
-        Decompiler::DecompileProgram(setup.program.code, PROGRAM_OFFSET,
+        Decompiler::DecompileProgram(setup.program.code, config.state.program_hash, PROGRAM_OFFSET,
                                      Maxwell3D::Regs::ShaderStage::Vertex, "vertex")
             .get_value_or({});
 
@@ -66,8 +76,9 @@ void main() {
 
     if (setup.IsDualProgram()) {
         ProgramResult program_b =
-            Decompiler::DecompileProgram(setup.program.code_b, PROGRAM_OFFSET,
-                                         Maxwell3D::Regs::ShaderStage::Vertex, "vertex_b")
+            Decompiler::DecompileProgram(setup.program.code_b, config.state.program_hash,
+                                         PROGRAM_OFFSET, Maxwell3D::Regs::ShaderStage::Vertex,
+                                         "vertex_b")
                 .get_value_or({});
         out += program_b.first;
     }
@@ -82,7 +93,7 @@ ProgramResult GenerateFragmentShader(const ShaderSetup& setup, const MaxwellFSCo
     out += "bool exec_fragment();\n";
 
     ProgramResult program =
-        Decompiler::DecompileProgram(setup.program.code, PROGRAM_OFFSET,
+        Decompiler::DecompileProgram(setup.program.code, config.state.program_hash, PROGRAM_OFFSET,
                                      Maxwell3D::Regs::ShaderStage::Fragment, "fragment")
             .get_value_or({});
     out += R"(
@@ -10,6 +10,7 @@
 #include <utility>
 #include <vector>
 #include <boost/functional/hash.hpp>
+#include "common/assert.h"
 #include "common/common_types.h"
 #include "common/hash.h"
 
@@ -18,10 +19,23 @@ namespace OpenGL::GLShader {
 constexpr size_t MAX_PROGRAM_CODE_LENGTH{0x1000};
 using ProgramCode = std::vector<u64>;
 
+/**
+ * Sets whether indirectly accessed const buffers are read from shader storage blocks. Decided
+ * once from the limits of the host, before any shader is generated. Otherwise they're declared
+ * as uniform blocks of the maximum size.
+ */
+void SetStorageBuffersEnabled(bool enabled);
+
+/// Returns whether indirectly accessed const buffers are read from shader storage blocks
+bool AreStorageBuffersEnabled();
+
 class ConstBufferEntry {
     using Maxwell = Tegra::Engines::Maxwell3D::Regs;
 
 public:
+    /// Number of host stages that get a range of bindpoints, see GetBinding
+    static constexpr unsigned NumBindingStages = 3;
+
     void MarkAsUsed(u64 index, u64 offset, Maxwell::ShaderStage stage) {
         is_used = true;
         this->index = static_cast<unsigned>(index);
@@ -32,6 +46,7 @@ public:
     void MarkAsUsedIndirect(u64 index, Maxwell::ShaderStage stage) {
         is_used = true;
         is_indirect = true;
+        is_storage = AreStorageBuffersEnabled();
         this->index = static_cast<unsigned>(index);
         this->stage = stage;
     }
@@ -56,13 +71,53 @@ public:
         return BufferBaseNames[static_cast<size_t>(stage)] + std::to_string(index);
     }
 
+    /// Whether the buffer is declared as a shader storage block, sized by the range bound to it
+    bool IsStorageBuffer() const {
+        return is_storage;
+    }
+
+    /// Size of a directly accessed buffer declared by the shader, in vec4s.
+    unsigned GetDeclaredSize() const {
+        return (GetSize() + 3) / 4;
+    }
+
+    /**
+     * Returns the bindpoint the shader declares the buffer at, so that it never has to be
+     * configured. Each host stage has a range of MaxConstBuffers bindpoints, indexed by the
+     * guest buffer. Uniform buffers start after the shader stage configuration blocks.
+     */
+    unsigned GetBinding() const {
+        const unsigned stage_base =
+            GetHostStageIndex() * static_cast<unsigned>(Maxwell::MaxConstBuffers);
+        if (IsStorageBuffer()) {
+            return stage_base + index;
+        }
+        return static_cast<unsigned>(Maxwell::MaxShaderStage) + stage_base + index;
+    }
+
 private:
+    /// Only the host stages that can run guest shaders get bindpoints
+    unsigned GetHostStageIndex() const {
+        switch (stage) {
+        case Maxwell::ShaderStage::Vertex:
+            return 0;
+        case Maxwell::ShaderStage::Geometry:
+            return 1;
+        case Maxwell::ShaderStage::Fragment:
+            return 2;
+        default:
+            UNREACHABLE_MSG("Unsupported shader stage {}", static_cast<u32>(stage));
+            return 0;
+        }
+    }
+
     static constexpr std::array<const char*, Maxwell::MaxShaderStage> BufferBaseNames = {
         "buffer_vs_c", "buffer_tessc_c", "buffer_tesse_c", "buffer_gs_c", "buffer_fs_c",
     };
 
     bool is_used{};
     bool is_indirect{};
+    bool is_storage{};
     unsigned index{};
     unsigned max_offset{};
     Maxwell::ShaderStage stage;
@@ -173,12 +228,18 @@ struct MaxwellShaderConfigCommon {
 };
 
 struct MaxwellVSConfig : Common::HashableStruct<MaxwellShaderConfigCommon> {
+    /// Zeroed key, for configs restored from the disk cache
+    MaxwellVSConfig() = default;
+
     explicit MaxwellVSConfig(ShaderSetup& setup) {
         state.Init(setup);
     }
 };
 
 struct MaxwellFSConfig : Common::HashableStruct<MaxwellShaderConfigCommon> {
+    /// Zeroed key, for configs restored from the disk cache
+    MaxwellFSConfig() = default;
+
     explicit MaxwellFSConfig(ShaderSetup& setup) {
         state.Init(setup);
     }
@@ -2,6 +2,11 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
+#include <cstring>
+#include <string>
+#include "common/logging/log.h"
+#include "common/microprofile.h"
 #include "core/core.h"
 #include "core/hle/kernel/process.h"
 #include "video_core/engines/maxwell_3d.h"
@@ -36,6 +41,148 @@ void SetShaderUniformBlockBindings(GLuint shader) {
 
 } // namespace Impl
 
+MICROPROFILE_COUNTER_DEFINE(OpenGL_ShadersCompiled, "OpenGL", "Shaders Compiled", PerFrame);
+
+void OGLShaderStage::CreateAsync(const ProgramResult& program_result, GLenum type) {
+    // Same as LoadShader and LoadProgram, but without querying any status, as that would wait
+    const char* source = program_result.first.c_str();
+    pending_shader.handle = glCreateShader(type);
+    glShaderSource(pending_shader.handle, 1, &source, nullptr);
+    glCompileShader(pending_shader.handle);
+
+    program.handle = glCreateProgram();
+    glProgramParameteri(program.handle, GL_PROGRAM_SEPARABLE, GL_TRUE);
+    if (GLAD_GL_ARB_get_program_binary) {
+        glProgramParameteri(program.handle, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    }
+    glAttachShader(program.handle, pending_shader.handle);
+    glLinkProgram(program.handle);
+
+    entries = program_result.second;
+    is_pending = true;
+    MICROPROFILE_COUNTER_ADD(OpenGL_ShadersCompiled, 1);
+}
+
+bool OGLShaderStage::IsReady() {
+    if (!is_pending) {
+        return true;
+    }
+
+    GLint completed = GL_FALSE;
+    glGetProgramiv(program.handle, GL_COMPLETION_STATUS_ARB, &completed);
+    if (completed != GL_TRUE) {
+        return false;
+    }
+    is_pending = false;
+
+    GLint link_status = GL_FALSE;
+    glGetProgramiv(program.handle, GL_LINK_STATUS, &link_status);
+    if (link_status != GL_TRUE) {
+        GLint info_log_length = 0;
+        glGetProgramiv(program.handle, GL_INFO_LOG_LENGTH, &info_log_length);
+        std::string program_error(std::max(info_log_length, 1), ' ');
+        glGetProgramInfoLog(program.handle, info_log_length, nullptr, &program_error[0]);
+        LOG_ERROR(Render_OpenGL, "Error linking shader:\n{}", program_error);
+    }
+
+    glDetachShader(program.handle, pending_shader.handle);
+    pending_shader.Release();
+    Impl::SetShaderUniformBlockBindings(program.handle);
+    return true;
+}
+
+bool OGLShaderStage::CreateFromBinary(GLenum binary_format, const std::vector<u8>& binary,
+                                      const ShaderEntries& shader_entries) {
+    if (binary.empty() || !GLAD_GL_ARB_get_program_binary) {
+        return false;
+    }
+
+    OGLProgram new_program;
+    new_program.handle = glCreateProgram();
+    glProgramParameteri(new_program.handle, GL_PROGRAM_SEPARABLE, GL_TRUE);
+    glProgramBinary(new_program.handle, binary_format, binary.data(),
+                    static_cast<GLsizei>(binary.size()));
+
+    GLint link_status = GL_FALSE;
+    glGetProgramiv(new_program.handle, GL_LINK_STATUS, &link_status);
+    if (link_status != GL_TRUE) {
+        return false;
+    }
+
+    program = std::move(new_program);
+    Impl::SetShaderUniformBlockBindings(program.handle);
+    entries = shader_entries;
+    return true;
+}
+
+void OGLShaderStage::GetBinary(GLenum& binary_format, std::vector<u8>& binary) const {
+    GLint binary_length = 0;
+    if (GLAD_GL_ARB_get_program_binary) {
+        glGetProgramiv(program.handle, GL_PROGRAM_BINARY_LENGTH, &binary_length);
+    }
+    binary.resize(static_cast<size_t>(binary_length));
+    if (binary_length > 0) {
+        glGetProgramBinary(program.handle, binary_length, nullptr, &binary_format, binary.data());
+    }
+}
+
+void ProgramManager::LoadDiskCache(u64 title_id) {
+    disk_cache.Open(title_id);
+    vertex_shaders.LoadDiskCache(disk_cache.GetEntries());
+    fragment_shaders.LoadDiskCache(disk_cache.GetEntries());
+
+    size_t num_created = 0;
+    for (const ShaderDiskCachePipeline& pipeline : disk_cache.GetPipelines()) {
+        MaxwellVSConfig vs_config;
+        MaxwellFSConfig fs_config;
+        if (pipeline.vertex_config.size() != sizeof(vs_config.state) ||
+            pipeline.fragment_config.size() != sizeof(fs_config.state)) {
+            continue;
+        }
+        std::memcpy(&vs_config.state, pipeline.vertex_config.data(), sizeof(vs_config.state));
+        std::memcpy(&fs_config.state, pipeline.fragment_config.data(), sizeof(fs_config.state));
+
+        // Stages still compiling asynchronously get their pipeline when they're first drawn with
+        ShaderTuple stages;
+        stages.vs = vertex_shaders.TryGetHandle(vs_config);
+        stages.fs = fragment_shaders.TryGetHandle(fs_config);
+        if (stages.vs == 0 || stages.fs == 0) {
+            continue;
+        }
+
+        // Validating makes drivers do their link-time checks now instead of on the first draw
+        glValidateProgramPipeline(GetPipeline(stages, false));
+        ++num_created;
+    }
+    LOG_INFO(Render_OpenGL, "Created {} pipelines from the disk cache", num_created);
+
+    disk_cache.ReleaseEntries();
+}
+
+GLuint ProgramManager::GetPipeline(const ShaderTuple& stages, bool record_to_disk) {
+    auto [iter, is_new] = pipeline_cache.try_emplace(stages);
+    OGLPipeline& pipeline = iter->second;
+    if (!is_new) {
+        return pipeline.handle;
+    }
+
+    pipeline.Create();
+    glUseProgramStages(pipeline.handle, GL_VERTEX_SHADER_BIT, stages.vs);
+    glUseProgramStages(pipeline.handle, GL_GEOMETRY_SHADER_BIT, stages.gs);
+    glUseProgramStages(pipeline.handle, GL_FRAGMENT_SHADER_BIT, stages.fs);
+
+    if (record_to_disk && disk_cache.IsOpen()) {
+        ShaderDiskCachePipeline entry{std::vector<u8>(sizeof(current_vs_config.state)),
+                                      std::vector<u8>(sizeof(current_fs_config.state))};
+        std::memcpy(entry.vertex_config.data(), &current_vs_config.state,
+                    sizeof(current_vs_config.state));
+        std::memcpy(entry.fragment_config.data(), &current_fs_config.state,
+                    sizeof(current_fs_config.state));
+        disk_cache.SavePipeline(entry);
+    }
+    return pipeline.handle;
+}
+
 void MaxwellUniformData::SetFromRegs(const Maxwell3D::State::ShaderStageInfo& shader_stage) {
     const auto& gpu = Core::System::GetInstance().GPU().Maxwell3D();
     const auto& regs = gpu.regs;
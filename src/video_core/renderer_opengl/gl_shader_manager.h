@@ -4,11 +4,16 @@
 
 #pragma once
 
+#include <cstring>
+#include <deque>
 #include <tuple>
 #include <unordered_map>
+#include <vector>
 #include <boost/functional/hash.hpp>
 #include <glad/glad.h>
+#include "common/cityhash.h"
 #include "video_core/renderer_opengl/gl_resource_manager.h"
+#include "video_core/renderer_opengl/gl_shader_disk_cache.h"
 #include "video_core/renderer_opengl/gl_shader_gen.h"
 #include "video_core/renderer_opengl/maxwell_to_gl.h"
 
@@ -43,10 +48,24 @@ public:
     void Create(const ProgramResult& program_result, GLenum type) {
         OGLShader shader;
         shader.Create(program_result.first.c_str(), type);
-        program.Create(true, shader.handle);
+        program.Create(true, true, shader.handle);
         Impl::SetShaderUniformBlockBindings(program.handle);
         entries = program_result.second;
     }
+
+    /// Starts compiling and linking the stage, without waiting for the driver to finish
+    void CreateAsync(const ProgramResult& program_result, GLenum type);
+
+    /// Whether the stage can be used, completing its setup once an asynchronous link finishes
+    bool IsReady();
+
+    /// Creates the stage from a program binary, returns false if the driver doesn't accept it
+    bool CreateFromBinary(GLenum binary_format, const std::vector<u8>& binary,
+                          const ShaderEntries& shader_entries);
+
+    /// Retrieves the program binary of the stage, left empty if the driver doesn't provide one
+    void GetBinary(GLenum& binary_format, std::vector<u8>& binary) const;
+
     GLuint GetHandle() const {
         return program.handle;
     }
@@ -58,6 +77,10 @@ public:
 private:
     OGLProgram program;
     ShaderEntries entries;
+
+    /// Shader attached to the program while it is compiled asynchronously
+    OGLShader pending_shader;
+    bool is_pending = false;
 };
 
 // TODO(wwylele): beautify this doc
@@ -69,30 +92,121 @@ template <typename KeyConfigType,
           GLenum ShaderType>
 class ShaderCache {
 public:
-    ShaderCache() = default;
+    explicit ShaderCache(bool use_asynchronous_shaders)
+        : use_asynchronous_shaders{use_asynchronous_shaders} {}
 
+    /// The handle is 0 while the stage is still being compiled asynchronously
     using Result = std::pair<GLuint, ShaderEntries>;
 
-    Result Get(const KeyConfigType& key, const ShaderSetup& setup) {
+    Result Get(const KeyConfigType& key, const ShaderSetup& setup, ShaderDiskCache& disk_cache) {
         auto map_it = shader_map.find(key);
         if (map_it == shader_map.end()) {
             ProgramResult program = CodeGenerator(setup, key);
 
-            auto [iter, new_shader] = shader_cache.emplace(program.first, OGLShaderStage{});
+            auto [iter, new_shader] =
+                shader_cache.emplace(HashSource(program.first), OGLShaderStage{});
             OGLShaderStage& cached_shader = iter->second;
             if (new_shader) {
-                cached_shader.Create(program, ShaderType);
+                CreateStage(cached_shader, program);
+            }
+            map_it = shader_map.emplace(key, &cached_shader).first;
+
+            if (disk_cache.IsOpen()) {
+                ShaderDiskCacheEntry entry{ShaderType, key.state.program_hash,
+                                           std::vector<u8>(sizeof(key.state)), program};
+                std::memcpy(entry.config.data(), &key.state, sizeof(key.state));
+                // Keys sharing the GLSL of a stored stage find it when loaded, only store it once
+                pending_entries.push_back(
+                    {std::move(entry), new_shader ? &cached_shader : nullptr});
+            }
+        }
+
+        SavePendingEntries(disk_cache);
+
+        OGLShaderStage& stage = *map_it->second;
+        if (!stage.IsReady()) {
+            return {0, stage.GetEntries()};
+        }
+        return {stage.GetHandle(), stage.GetEntries()};
+    }
+
+    /// Creates the stages of this type stored in the disk cache, from their binaries if possible
+    void LoadDiskCache(const std::vector<ShaderDiskCacheEntry>& disk_entries) {
+        for (const ShaderDiskCacheEntry& entry : disk_entries) {
+            if (entry.type != ShaderType || entry.config.size() != sizeof(KeyConfigType::state)) {
+                continue;
+            }
+            KeyConfigType key;
+            std::memcpy(&key.state, entry.config.data(), entry.config.size());
+
+            auto [iter, new_shader] =
+                shader_cache.emplace(HashSource(entry.program.first), OGLShaderStage{});
+            OGLShaderStage& cached_shader = iter->second;
+            if (new_shader && !cached_shader.CreateFromBinary(entry.binary_format, entry.binary,
+                                                              entry.program.second)) {
+                // The binary is missing or was made by another driver, at least skip decompiling
+                CreateStage(cached_shader, entry.program);
             }
             shader_map[key] = &cached_shader;
-            return {cached_shader.GetHandle(), program.second};
-        } else {
-            return {map_it->second->GetHandle(), map_it->second->GetEntries()};
         }
     }
 
+    /// Returns the handle of the stage created for the key, 0 if there is none or it's still
+    /// being compiled
+    GLuint TryGetHandle(const KeyConfigType& key) {
+        const auto iter = shader_map.find(key);
+        if (iter == shader_map.end() || !iter->second->IsReady()) {
+            return 0;
+        }
+        return iter->second->GetHandle();
+    }
+
 private:
+    /// Stages are deduplicated by a hash of their GLSL, instead of hashing and comparing the
+    /// whole source on every lookup
+    struct SourceHash {
+        size_t operator()(const Common::uint128& hash) const {
+            return static_cast<size_t>(hash.first);
+        }
+    };
+
+    static Common::uint128 HashSource(const std::string& source) {
+        return Common::CityHash128(source.data(), source.size());
+    }
+
+    /// An entry that goes to the disk cache once the binary of its new stage can be retrieved
+    struct PendingEntry {
+        ShaderDiskCacheEntry entry;
+        OGLShaderStage* new_stage;
+    };
+
+    void CreateStage(OGLShaderStage& stage, const ProgramResult& program) {
+        if (use_asynchronous_shaders) {
+            stage.CreateAsync(program, ShaderType);
+        } else {
+            stage.Create(program, ShaderType);
+        }
+    }
+
+    /// Stores the pending entries in order, up to the first one whose stage is still compiling
+    void SavePendingEntries(ShaderDiskCache& disk_cache) {
+        while (!pending_entries.empty()) {
+            PendingEntry& pending = pending_entries.front();
+            if (pending.new_stage != nullptr) {
+                if (!pending.new_stage->IsReady()) {
+                    return;
+                }
+                pending.new_stage->GetBinary(pending.entry.binary_format, pending.entry.binary);
+            }
+            disk_cache.Save(pending.entry);
+            pending_entries.pop_front();
+        }
+    }
+
+    bool use_asynchronous_shaders;
     std::unordered_map<KeyConfigType, OGLShaderStage*> shader_map;
-    std::unordered_map<std::string, OGLShaderStage> shader_cache;
+    std::unordered_map<Common::uint128, OGLShaderStage, SourceHash> shader_cache;
+    std::deque<PendingEntry> pending_entries;
 };
 
 using VertexShaders = ShaderCache<MaxwellVSConfig, &GenerateVertexShader, GL_VERTEX_SHADER>;
@@ -101,24 +215,37 @@ using FragmentShaders = ShaderCache<MaxwellFSConfig, &GenerateFragmentShader, GL
 
 class ProgramManager {
 public:
-    ProgramManager() {
-        pipeline.Create();
-    }
+    explicit ProgramManager(bool use_asynchronous_shaders)
+        : vertex_shaders{use_asynchronous_shaders}, fragment_shaders{use_asynchronous_shaders} {}
 
     ShaderEntries UseProgrammableVertexShader(const MaxwellVSConfig& config,
                                               const ShaderSetup& setup) {
         ShaderEntries result;
-        std::tie(current.vs, result) = vertex_shaders.Get(config, setup);
+        std::tie(current.vs, result) = vertex_shaders.Get(config, setup, disk_cache);
+        current_vs_config = config;
         return result;
     }
 
     ShaderEntries UseProgrammableFragmentShader(const MaxwellFSConfig& config,
                                                 const ShaderSetup& setup) {
         ShaderEntries result;
-        std::tie(current.fs, result) = fragment_shaders.Get(config, setup);
+        std::tie(current.fs, result) = fragment_shaders.Get(config, setup, disk_cache);
+        current_fs_config = config;
         return result;
     }
 
+    /**
+     * Loads the shaders stored by previous sessions of a title, and keeps storing new ones. The
+     * pipelines those sessions drew with are created right away, so neither the stages nor their
+     * combinations have to be built while the game is running.
+     */
+    void LoadDiskCache(u64 title_id);
+
+    /// Whether the stages selected for the next draw have all finished compiling
+    bool AreCurrentStagesReady() const {
+        return current.vs != 0 && current.fs != 0;
+    }
+
     GLuint GetCurrentProgramStage(Maxwell3D::Regs::ShaderStage stage) const {
         switch (stage) {
         case Maxwell3D::Regs::ShaderStage::Vertex:
@@ -135,16 +262,14 @@ public:
     }
 
     void ApplyTo(OpenGLState& state) {
-        // Workaround for AMD bug
-        glUseProgramStages(pipeline.handle,
-                           GL_VERTEX_SHADER_BIT | GL_GEOMETRY_SHADER_BIT | GL_FRAGMENT_SHADER_BIT,
-                           0);
-
-        glUseProgramStages(pipeline.handle, GL_VERTEX_SHADER_BIT, current.vs);
-        glUseProgramStages(pipeline.handle, GL_GEOMETRY_SHADER_BIT, current.gs);
-        glUseProgramStages(pipeline.handle, GL_FRAGMENT_SHADER_BIT, current.fs);
+        // Consecutive draws mostly use the same stages, the pipeline only changes when they don't.
+        // Draws whose stages are still compiling are skipped, they keep the previous pipeline.
+        if (!(current == applied) && AreCurrentStagesReady()) {
+            applied_pipeline = GetPipeline(current, true);
+            applied = current;
+        }
         state.draw.shader_program = 0;
-        state.draw.program_pipeline = pipeline.handle;
+        state.draw.program_pipeline = applied_pipeline;
     }
 
 private:
@@ -163,12 +288,25 @@ private:
             }
         };
     };
+
+    /// Returns the pipeline with the given stages, creating it and optionally recording it in the
+    /// disk cache on first use
+    GLuint GetPipeline(const ShaderTuple& stages, bool record_to_disk);
+
     ShaderTuple current;
+    /// Keys of the current stages, identifying them in the disk cache
+    MaxwellVSConfig current_vs_config;
+    MaxwellFSConfig current_fs_config;
+    /// Stages of the pipeline selected by the last ApplyTo
+    ShaderTuple applied;
+    GLuint applied_pipeline = 0;
     VertexShaders vertex_shaders;
     FragmentShaders fragment_shaders;
+    ShaderDiskCache disk_cache;
 
-    std::unordered_map<ShaderTuple, OGLProgram, ShaderTuple::Hash> program_cache;
-    OGLPipeline pipeline;
+    /// Pipelines are kept for every combination of stages, rebinding stages to a single pipeline
+    /// makes the driver revalidate it on each change
+    std::unordered_map<ShaderTuple, OGLPipeline, ShaderTuple::Hash> pipeline_cache;
 };
 
 } // namespace OpenGL::GLShader
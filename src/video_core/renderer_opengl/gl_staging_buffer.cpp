@@ -0,0 +1,103 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include "common/alignment.h"
+#include "common/assert.h"
+#include "common/microprofile.h"
+#include "video_core/renderer_opengl/gl_staging_buffer.h"
+
+namespace OpenGL {
+
+MICROPROFILE_DEFINE(OpenGL_StagingWait, "OpenGL", "Staging Buffer Wait", MP_RGB(192, 64, 64));
+
+OGLStagingBuffer::OGLStagingBuffer(GLsizeiptr size) : buffer_size(size) {
+    gl_buffer.Create();
+
+    if (!GLAD_GL_ARB_buffer_storage) {
+        // Callers fall back to transfers from client memory
+        return;
+    }
+
+    constexpr GLbitfield flags =
+        GL_MAP_READ_BIT | GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+    glBindBuffer(GL_COPY_WRITE_BUFFER, gl_buffer.handle);
+    glBufferStorage(GL_COPY_WRITE_BUFFER, buffer_size, nullptr, flags);
+    mapped_ptr = static_cast<u8*>(glMapBufferRange(GL_COPY_WRITE_BUFFER, 0, buffer_size, flags));
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+}
+
+OGLStagingBuffer::~OGLStagingBuffer() {
+    in_flight.clear();
+    if (mapped_ptr != nullptr) {
+        glBindBuffer(GL_COPY_WRITE_BUFFER, gl_buffer.handle);
+        glUnmapBuffer(GL_COPY_WRITE_BUFFER);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    }
+    gl_buffer.Release();
+}
+
+GLuint OGLStagingBuffer::GetHandle() const {
+    return gl_buffer.handle;
+}
+
+GLsizeiptr OGLStagingBuffer::GetSize() const {
+    return buffer_size;
+}
+
+bool OGLStagingBuffer::IsAvailable() const {
+    return mapped_ptr != nullptr;
+}
+
+std::pair<u8*, GLintptr> OGLStagingBuffer::Map(GLsizeiptr size, GLintptr alignment) {
+    ASSERT(IsAvailable());
+    ASSERT(size <= buffer_size);
+    ASSERT(alignment <= buffer_size);
+    mapped_size = size;
+
+    if (alignment > 0) {
+        buffer_pos = Common::AlignUp<size_t>(buffer_pos, alignment);
+    }
+
+    if (buffer_pos + size > buffer_size) {
+        buffer_pos = 0;
+    }
+
+    WaitForRange(buffer_pos, buffer_pos + size);
+
+    return {mapped_ptr + buffer_pos, buffer_pos};
+}
+
+void OGLStagingBuffer::Unmap(GLsizeiptr size) {
+    ASSERT(size <= mapped_size);
+
+    if (size > 0) {
+        Chunk chunk{buffer_pos, buffer_pos + size, {}};
+        chunk.fence.Create();
+        in_flight.push_back(std::move(chunk));
+    }
+
+    buffer_pos += size;
+}
+
+void OGLStagingBuffer::Wait(GLintptr offset, GLsizeiptr size) {
+    WaitForRange(offset, offset + size);
+}
+
+void OGLStagingBuffer::WaitForRange(GLintptr begin, GLintptr end) {
+    // Fences signal in submission order, so waiting for the newest chunk overlapping the range
+    // also retires every chunk released before it.
+    const auto last = std::find_if(in_flight.rbegin(), in_flight.rend(), [=](const Chunk& chunk) {
+        return chunk.begin < end && begin < chunk.end;
+    });
+    if (last == in_flight.rend()) {
+        return;
+    }
+
+    MICROPROFILE_SCOPE(OpenGL_StagingWait);
+    glClientWaitSync(last->fence.handle, GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED);
+    in_flight.erase(in_flight.begin(), last.base());
+}
+
+} // namespace OpenGL
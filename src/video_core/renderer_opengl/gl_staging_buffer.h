@@ -0,0 +1,68 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <deque>
+#include <utility>
+#include <glad/glad.h>
+#include "common/common_types.h"
+#include "video_core/renderer_opengl/gl_resource_manager.h"
+
+namespace OpenGL {
+
+/**
+ * Persistently and coherently mapped buffer used as a ring of staging memory for pixel transfers,
+ * bound as GL_PIXEL_UNPACK_BUFFER for texture uploads and as GL_PIXEL_PACK_BUFFER for downloads.
+ * Every chunk handed out is fenced on release, and a chunk is only handed out again once the GPU
+ * is done with all the commands that used it, so transfers don't have to be synchronized with the
+ * driver when they are issued.
+ */
+class OGLStagingBuffer : private NonCopyable {
+public:
+    explicit OGLStagingBuffer(GLsizeiptr size);
+    ~OGLStagingBuffer();
+
+    GLuint GetHandle() const;
+    GLsizeiptr GetSize() const;
+
+    /// Whether the buffer could be mapped, i.e. ARB_buffer_storage is available
+    bool IsAvailable() const;
+
+    /*
+     * Reserves a linear chunk of at least "size" bytes with the optional alignment requirement,
+     * waiting for the GPU to release it first if it is still in use by an earlier transfer.
+     * The return values are the pointer to the chunk and its offset within the buffer.
+     * The chunk must be released with Unmap once the commands using it have been issued.
+     */
+    std::pair<u8*, GLintptr> Map(GLsizeiptr size, GLintptr alignment = 0);
+
+    /// Releases the chunk returned by the last call to Map, fencing the commands issued so far
+    void Unmap(GLsizeiptr size);
+
+    /// Waits until the GPU is done with every released chunk overlapping the specified range
+    void Wait(GLintptr offset, GLsizeiptr size);
+
+private:
+    struct Chunk {
+        GLintptr begin;
+        GLintptr end;
+        OGLSync fence;
+    };
+
+    /// Waits for and retires all the chunks up to the last one overlapping the specified range
+    void WaitForRange(GLintptr begin, GLintptr end);
+
+    OGLBuffer gl_buffer;
+
+    GLintptr buffer_pos = 0;
+    GLsizeiptr buffer_size = 0;
+    GLsizeiptr mapped_size = 0;
+    u8* mapped_ptr = nullptr;
+
+    /// Released chunks the GPU may still be using, oldest first
+    std::deque<Chunk> in_flight;
+};
+
+} // namespace OpenGL
@@ -2,6 +2,7 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
 #include <iterator>
 #include <glad/glad.h>
 #include "common/logging/log.h"
@@ -195,28 +196,7 @@ void OpenGLState::Apply() const {
         glLogicOp(logic_op.operation);
     }
 
-    // Textures
-    for (std::size_t i = 0; i < std::size(texture_units); ++i) {
-        const auto& texture_unit = texture_units[i];
-        const auto& cur_state_texture_unit = cur_state.texture_units[i];
-
-        if (texture_unit.texture_2d != cur_state_texture_unit.texture_2d) {
-            glActiveTexture(TextureUnits::MaxwellTexture(static_cast<int>(i)).Enum());
-            glBindTexture(GL_TEXTURE_2D, texture_unit.texture_2d);
-        }
-        if (texture_unit.sampler != cur_state_texture_unit.sampler) {
-            glBindSampler(static_cast<GLuint>(i), texture_unit.sampler);
-        }
-        // Update the texture swizzle
-        if (texture_unit.swizzle.r != cur_state_texture_unit.swizzle.r ||
-            texture_unit.swizzle.g != cur_state_texture_unit.swizzle.g ||
-            texture_unit.swizzle.b != cur_state_texture_unit.swizzle.b ||
-            texture_unit.swizzle.a != cur_state_texture_unit.swizzle.a) {
-            std::array<GLint, 4> mask = {texture_unit.swizzle.r, texture_unit.swizzle.g,
-                                         texture_unit.swizzle.b, texture_unit.swizzle.a};
-            glTexParameteriv(GL_TEXTURE_2D, GL_TEXTURE_SWIZZLE_RGBA, mask.data());
-        }
-    }
+    ApplyTextures();
 
     // Framebuffer
     if (draw.read_framebuffer != cur_state.draw.read_framebuffer) {
@@ -285,6 +265,70 @@ void OpenGLState::Apply() const {
     cur_state = *this;
 }
 
+void OpenGLState::ApplyTextures() const {
+    // Find the range of units whose texture or sampler changed, multi-bind rebinds the units in
+    // between as well but that's still a single call instead of one or two per unit
+    std::size_t first = std::size(texture_units);
+    std::size_t last = 0;
+    for (std::size_t i = 0; i < std::size(texture_units); ++i) {
+        if (texture_units[i].texture_2d != cur_state.texture_units[i].texture_2d ||
+            texture_units[i].sampler != cur_state.texture_units[i].sampler) {
+            first = std::min(first, i);
+            last = i;
+        }
+    }
+
+    if (first <= last) {
+        if (GLAD_GL_ARB_multi_bind) {
+            const GLsizei count = static_cast<GLsizei>(last - first + 1);
+            std::array<GLuint, std::tuple_size<decltype(texture_units)>::value> textures;
+            std::array<GLuint, std::tuple_size<decltype(texture_units)>::value> samplers;
+            for (std::size_t i = first; i <= last; ++i) {
+                textures[i] = texture_units[i].texture_2d;
+                samplers[i] = texture_units[i].sampler;
+            }
+            glBindTextures(static_cast<GLuint>(first), count, &textures[first]);
+            glBindSamplers(static_cast<GLuint>(first), count, &samplers[first]);
+        } else {
+            for (std::size_t i = first; i <= last; ++i) {
+                const auto& texture_unit = texture_units[i];
+                const auto& cur_state_texture_unit = cur_state.texture_units[i];
+                if (texture_unit.texture_2d != cur_state_texture_unit.texture_2d) {
+                    glActiveTexture(TextureUnits::MaxwellTexture(static_cast<int>(i)).Enum());
+                    glBindTexture(GL_TEXTURE_2D, texture_unit.texture_2d);
+                }
+                if (texture_unit.sampler != cur_state_texture_unit.sampler) {
+                    glBindSampler(static_cast<GLuint>(i), texture_unit.sampler);
+                }
+            }
+        }
+    }
+
+    // Update the texture swizzles
+    for (std::size_t i = 0; i < std::size(texture_units); ++i) {
+        const auto& texture_unit = texture_units[i];
+        const auto& cur_state_texture_unit = cur_state.texture_units[i];
+        if (texture_unit.swizzle.r == cur_state_texture_unit.swizzle.r &&
+            texture_unit.swizzle.g == cur_state_texture_unit.swizzle.g &&
+            texture_unit.swizzle.b == cur_state_texture_unit.swizzle.b &&
+            texture_unit.swizzle.a == cur_state_texture_unit.swizzle.a) {
+            continue;
+        }
+
+        const std::array<GLint, 4> mask = {texture_unit.swizzle.r, texture_unit.swizzle.g,
+                                           texture_unit.swizzle.b, texture_unit.swizzle.a};
+        if (GLAD_GL_ARB_direct_state_access) {
+            // Texture parameters can't be set through DSA on the default texture object
+            if (texture_unit.texture_2d != 0) {
+                glTextureParameteriv(texture_unit.texture_2d, GL_TEXTURE_SWIZZLE_RGBA, mask.data());
+            }
+        } else {
+            glActiveTexture(TextureUnits::MaxwellTexture(static_cast<int>(i)).Enum());
+            glTexParameteriv(GL_TEXTURE_2D, GL_TEXTURE_SWIZZLE_RGBA, mask.data());
+        }
+    }
+}
+
 OpenGLState& OpenGLState::UnbindTexture(GLuint handle) {
     for (auto& unit : texture_units) {
         if (unit.texture_2d == handle) {
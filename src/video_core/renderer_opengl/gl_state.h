@@ -165,6 +165,9 @@ public:
     OpenGLState& ResetFramebuffer(GLuint handle);
 
 private:
+    /// Applies the texture unit bindings, using multi-bind and DSA when they are available
+    void ApplyTextures() const;
+
     static OpenGLState cur_state;
 };
 
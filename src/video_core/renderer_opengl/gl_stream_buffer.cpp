@@ -2,17 +2,22 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
 #include <deque>
 #include <vector>
 #include "common/alignment.h"
 #include "common/assert.h"
+#include "common/microprofile.h"
 #include "video_core/renderer_opengl/gl_state.h"
 #include "video_core/renderer_opengl/gl_stream_buffer.h"
 
 namespace OpenGL {
 
+MICROPROFILE_DEFINE(OpenGL_StreamBufferWait, "OpenGL", "Stream Buffer Wait", MP_RGB(192, 64, 64));
+MICROPROFILE_COUNTER_DEFINE(OpenGL_StreamBufferBytes, "OpenGL", "Stream Buffer Bytes", PerFrame);
+
 OGLStreamBuffer::OGLStreamBuffer(GLenum target, GLsizeiptr size, bool prefer_coherent)
-    : gl_target(target), buffer_size(size) {
+    : gl_target(target), buffer_size(size), segment_size(size / NUM_SEGMENTS) {
     gl_buffer.Create();
     glBindBuffer(gl_target, gl_buffer.handle);
 
@@ -64,19 +69,27 @@ std::tuple<u8*, GLintptr, bool> OGLStreamBuffer::Map(GLsizeiptr size, GLintptr a
         buffer_pos = Common::AlignUp<size_t>(buffer_pos, alignment);
     }
 
+    if (persistent) {
+        // The commands reading the chunks written so far have been issued by now
+        FenceUsedSegments(static_cast<size_t>(buffer_pos / segment_size));
+    }
+
     bool invalidate = false;
     if (buffer_pos + size > buffer_size) {
+        MICROPROFILE_META_CPU("Stream Buffer Wraps", 1);
         buffer_pos = 0;
         invalidate = true;
 
         if (persistent) {
-            glUnmapBuffer(gl_target);
+            FenceUsedSegments(NUM_SEGMENTS);
+            unfenced_segment = 0;
         }
     }
 
-    if (invalidate | !persistent) {
-        GLbitfield flags = GL_MAP_WRITE_BIT | (persistent ? GL_MAP_PERSISTENT_BIT : 0) |
-                           (coherent ? GL_MAP_COHERENT_BIT : GL_MAP_FLUSH_EXPLICIT_BIT) |
+    if (persistent) {
+        WaitForSegments(buffer_pos, buffer_pos + size);
+    } else {
+        GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_FLUSH_EXPLICIT_BIT |
                            (invalidate ? GL_MAP_INVALIDATE_BUFFER_BIT : GL_MAP_UNSYNCHRONIZED_BIT);
         mapped_ptr = static_cast<u8*>(
             glMapBufferRange(gl_target, buffer_pos, buffer_size - buffer_pos, flags));
@@ -97,7 +110,42 @@ void OGLStreamBuffer::Unmap(GLsizeiptr size) {
         glUnmapBuffer(gl_target);
     }
 
+    MICROPROFILE_META_CPU("Stream Buffer Bytes", static_cast<int>(size));
+    MICROPROFILE_COUNTER_ADD(OpenGL_StreamBufferBytes, size);
     buffer_pos += size;
 }
 
+bool OGLStreamBuffer::HasSpace(GLsizeiptr size, GLintptr alignment) const {
+    const GLintptr pos =
+        alignment > 0 ? Common::AlignUp<size_t>(buffer_pos, alignment) : buffer_pos;
+    return pos + size <= buffer_size;
+}
+
+void OGLStreamBuffer::FenceUsedSegments(size_t end_segment) {
+    // The segment holding the current position is only fenced once it has been moved past, or
+    // when the buffer wraps around, as later chunks are still going to be written to it.
+    for (; unfenced_segment < end_segment; ++unfenced_segment) {
+        segment_fences[unfenced_segment].Create();
+    }
+}
+
+void OGLStreamBuffer::WaitForSegments(GLintptr begin, GLintptr end) {
+    const size_t first_segment = static_cast<size_t>(begin / segment_size);
+    const size_t last_segment =
+        std::min(static_cast<size_t>((end - 1) / segment_size), NUM_SEGMENTS - 1);
+    for (size_t segment = first_segment; segment <= last_segment; ++segment) {
+        OGLSync& fence = segment_fences[segment];
+        if (fence.handle == 0) {
+            continue;
+        }
+        if (glClientWaitSync(fence.handle, 0, 0) == GL_TIMEOUT_EXPIRED) {
+            // The GPU is still reading from the previous lap, the ring is too small for the load
+            MICROPROFILE_SCOPE(OpenGL_StreamBufferWait);
+            MICROPROFILE_META_CPU("Stream Buffer Stalls", 1);
+            glClientWaitSync(fence.handle, GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED);
+        }
+        fence.Release();
+    }
+}
+
 } // namespace OpenGL
@@ -4,6 +4,7 @@
 
 #pragma once
 
+#include <array>
 #include <tuple>
 #include <glad/glad.h>
 #include "common/common_types.h"
@@ -22,7 +23,9 @@ public:
     /*
      * Allocates a linear chunk of memory in the GPU buffer with at least "size" bytes
      * and the optional alignment requirement.
-     * If the buffer is full, the whole buffer is reallocated which invalidates old chunks.
+     * If the buffer is full, writing restarts at its beginning which invalidates old chunks.
+     * Persistently mapped buffers wait for the GPU to finish reading the region being reused,
+     * other buffers are orphaned instead.
      * The return values are the pointer to the new chunk, the offset within the buffer,
      * and the invalidation flag for previous chunks.
      * The actual used size must be specified on unmapping the chunk.
@@ -31,7 +34,20 @@ public:
 
     void Unmap(GLsizeiptr size);
 
+    /// Whether a chunk of "size" bytes can be mapped without wrapping around, which would
+    /// invalidate the chunks mapped before it
+    bool HasSpace(GLsizeiptr size, GLintptr alignment = 0) const;
+
 private:
+    /// Number of fenced segments the ring of a persistently mapped buffer is divided into
+    static constexpr size_t NUM_SEGMENTS = 16;
+
+    /// Fences the segments the buffer position has moved past since they were last fenced
+    void FenceUsedSegments(size_t end_segment);
+
+    /// Waits for the GPU to release the segments overlapping the specified range
+    void WaitForSegments(GLintptr begin, GLintptr end);
+
     OGLBuffer gl_buffer;
     GLenum gl_target;
 
@@ -43,6 +59,12 @@ private:
     GLintptr mapped_offset = 0;
     GLsizeiptr mapped_size = 0;
     u8* mapped_ptr = nullptr;
+
+    GLsizeiptr segment_size = 0;
+    /// First segment that was written to but has not been fenced yet
+    size_t unfenced_segment = 0;
+    /// Fences of the segments the GPU may still be reading from, indexed by segment
+    std::array<OGLSync, NUM_SEGMENTS> segment_fences;
 };
 
 } // namespace OpenGL
@@ -0,0 +1,161 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <cstring>
+#include <tuple>
+#include "common/assert.h"
+#include "common/microprofile.h"
+#include "video_core/renderer_opengl/gl_state.h"
+#include "video_core/renderer_opengl/gl_texture_decoder.h"
+
+namespace OpenGL {
+
+MICROPROFILE_DEFINE(OpenGL_ComputeDecode, "OpenGL", "Compute Texture Decode", MP_RGB(64, 128, 192));
+
+/// Number of invocations in a work group, each one handles a 32-bit word of the linear output
+constexpr u32 WORK_GROUP_SIZE = 64;
+/// Maximum number of work groups guaranteed to be supported in a single dimension
+constexpr u32 MAX_WORK_GROUP_COUNT = 65535;
+
+// Each invocation copies the aligned 32-bit word at byte column x of row y. GOB sectors are 16
+// bytes long, so the 4 bytes of a word are always contiguous in the swizzled surface as well.
+constexpr char decode_shader[] = R"(
+#version 430 core
+
+layout(local_size_x = 64) in;
+
+layout(std430, binding = 0) readonly buffer SwizzledData {
+    uint swizzled[];
+};
+
+layout(std430, binding = 1) writeonly buffer LinearData {
+    uint linear[];
+};
+
+// x: pitch in bytes, y: height in rows, z: block height in GOBs, w: conversion
+layout(location = 0) uniform uvec4 surface;
+
+void main() {
+    const uint pitch = surface.x;
+    const uint block_height = surface.z;
+    const uint word = gl_GlobalInvocationID.y * gl_NumWorkGroups.x * gl_WorkGroupSize.x +
+                      gl_GlobalInvocationID.x;
+    if (word >= pitch / 4 * surface.y) {
+        return;
+    }
+
+    const uint x = (word * 4) % pitch;
+    const uint y = (word * 4) / pitch;
+
+    const uint block_size = 512 * block_height;
+    const uint width_in_gobs = (pitch + 63) / 64;
+    const uint block_index = y / (8 * block_height);
+    const uint gob_index = (y / 8) % block_height;
+    const uint offset = block_index * width_in_gobs * block_size + gob_index * 512 +
+                        ((y % 8) / 2) * 64 + (y % 2) * 16 + (x / 64) * block_size +
+                        ((x % 64) / 32) * 256 + ((x % 32) / 16) * 32 + (x % 16);
+
+    uint value = swizzled[offset / 4];
+    switch (surface.w) {
+    case 1:
+        // S8Z24 to Z24S8
+        value = (value << 8) | (value >> 24);
+        break;
+    case 2:
+        // G8R8 to R8G8, a word holds two texels
+        value = ((value & 0x00FF00FFu) << 8) | ((value >> 8) & 0x00FF00FFu);
+        break;
+    }
+    linear[word] = value;
+}
+)";
+
+ComputeTextureDecoder::ComputeTextureDecoder() {
+    if (!GLAD_GL_ARB_compute_shader || !GLAD_GL_ARB_shader_storage_buffer_object) {
+        // Surfaces are decoded on the CPU
+        return;
+    }
+
+    OGLShader shader;
+    shader.Create(decode_shader, GL_COMPUTE_SHADER);
+    program.Create(false, false, shader.handle);
+
+    GLint alignment;
+    glGetIntegerv(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &alignment);
+    storage_alignment = alignment;
+
+    output_buffer.Create();
+}
+
+bool ComputeTextureDecoder::IsAvailable(const OGLStagingBuffer& staging_buffer) const {
+    return program.handle != 0 && staging_buffer.IsAvailable();
+}
+
+GLuint ComputeTextureDecoder::GetOutputHandle() const {
+    return output_buffer.handle;
+}
+
+bool ComputeTextureDecoder::Decode(OGLStagingBuffer& staging_buffer, const u8* swizzled_data,
+                                   size_t swizzled_size, u32 pitch, u32 height, u32 block_height,
+                                   Conversion conversion) {
+    if (!IsAvailable(staging_buffer) || pitch % 4 != 0 || height == 0) {
+        return false;
+    }
+
+    const GLsizeiptr input_size = static_cast<GLsizeiptr>(swizzled_size);
+    if (input_size > staging_buffer.GetSize()) {
+        return false;
+    }
+
+    MICROPROFILE_SCOPE(OpenGL_ComputeDecode);
+
+    const u32 num_words = pitch / 4 * height;
+    const GLsizeiptr linear_size = static_cast<GLsizeiptr>(num_words) * 4;
+    ReserveOutput(linear_size);
+
+    u8* staging_ptr;
+    GLintptr staging_offset;
+    std::tie(staging_ptr, staging_offset) =
+        staging_buffer.Map(input_size, std::max<GLintptr>(storage_alignment, 4));
+    std::memcpy(staging_ptr, swizzled_data, swizzled_size);
+
+    OpenGLState state = OpenGLState::GetCurState();
+    OpenGLState prev_state = state;
+    state.draw.shader_program = program.handle;
+    state.Apply();
+
+    glBindBufferRange(GL_SHADER_STORAGE_BUFFER, 0, staging_buffer.GetHandle(), staging_offset,
+                      input_size);
+    glBindBufferRange(GL_SHADER_STORAGE_BUFFER, 1, output_buffer.handle, 0, linear_size);
+    glProgramUniform4ui(program.handle, 0, pitch, height, block_height,
+                        static_cast<u32>(conversion));
+
+    const u32 num_groups = (num_words + WORK_GROUP_SIZE - 1) / WORK_GROUP_SIZE;
+    const u32 groups_x = std::min(num_groups, MAX_WORK_GROUP_COUNT);
+    const u32 groups_y = (num_groups + groups_x - 1) / groups_x;
+    glDispatchCompute(groups_x, groups_y, 1);
+
+    // The output is consumed as a pixel unpack buffer by the texture update that follows
+    glMemoryBarrier(GL_PIXEL_BUFFER_BARRIER_BIT);
+
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, 0);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, 0);
+    prev_state.Apply();
+
+    staging_buffer.Unmap(input_size);
+    return true;
+}
+
+void ComputeTextureDecoder::ReserveOutput(GLsizeiptr size) {
+    if (size <= output_size) {
+        return;
+    }
+    output_size = size;
+    glBindBuffer(GL_COPY_WRITE_BUFFER, output_buffer.handle);
+    glBufferData(GL_COPY_WRITE_BUFFER, output_size, nullptr, GL_DYNAMIC_COPY);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+}
+
+} // namespace OpenGL
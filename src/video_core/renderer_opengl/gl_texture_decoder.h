@@ -0,0 +1,64 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <cstddef>
+#include <glad/glad.h>
+#include "common/common_types.h"
+#include "video_core/renderer_opengl/gl_resource_manager.h"
+#include "video_core/renderer_opengl/gl_staging_buffer.h"
+
+namespace OpenGL {
+
+/**
+ * Unswizzles block linear textures with a compute shader. The swizzled bytes are copied as-is to
+ * a staging buffer, and the shader writes the linear texels, converted to their host layout, to a
+ * buffer that textures can then be updated from as a GL_PIXEL_UNPACK_BUFFER. This keeps both the
+ * unswizzle and the format conversion off the CPU, which only has to copy the guest data.
+ */
+class ComputeTextureDecoder : private NonCopyable {
+public:
+    /// Conversion applied to each texel after unswizzling it, must match the shader
+    enum class Conversion : u32 {
+        None = 0,
+        S8Z24ToZ24S8 = 1,
+        G8R8ToR8G8 = 2,
+    };
+
+    ComputeTextureDecoder();
+
+    /// Whether the decoder can be used, i.e. compute shaders and a mapped staging buffer exist
+    bool IsAvailable(const OGLStagingBuffer& staging_buffer) const;
+
+    /// Returns the buffer the last decoded texels were written to, starting at offset 0
+    GLuint GetOutputHandle() const;
+
+    /**
+     * Unswizzles height rows of pitch bytes from a block linear surface into the output buffer.
+     * @param staging_buffer Buffer the swizzled data is copied to before being read by the GPU
+     * @param swizzled_data Guest memory of the surface, swizzled_size bytes long
+     * @param swizzled_size Size of the swizzled surface, including the padding of its last blocks
+     * @param pitch Size of a row of texels (or compressed blocks) in bytes, a multiple of 4
+     * @param height Number of rows of texels (or compressed blocks)
+     * @param block_height Block height of the surface in GOBs
+     * @param conversion Conversion applied to every texel
+     * @returns Whether the data was decoded, otherwise the caller has to decode it on the CPU
+     */
+    bool Decode(OGLStagingBuffer& staging_buffer, const u8* swizzled_data, size_t swizzled_size,
+                u32 pitch, u32 height, u32 block_height, Conversion conversion);
+
+private:
+    /// Grows the output buffer to hold at least size bytes
+    void ReserveOutput(GLsizeiptr size);
+
+    OGLProgram program;
+    OGLBuffer output_buffer;
+    GLsizeiptr output_size = 0;
+
+    /// Alignment of the staging buffer ranges bound as shader storage buffers
+    GLintptr storage_alignment = 0;
+};
+
+} // namespace OpenGL
@@ -0,0 +1,102 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <cstring>
+#include "video_core/renderer_opengl/gl_texture_descriptor_cache.h"
+
+namespace OpenGL {
+
+using Tegra::Texture::FullTextureInfo;
+using Tegra::Texture::TICEntry;
+using Tegra::Texture::TSCEntry;
+
+TextureDescriptorCache::TextureDescriptorCache(VideoCore::RasterizerCachedPages& cached_pages)
+    : cached_pages{cached_pages} {}
+
+TextureDescriptorCache::~TextureDescriptorCache() {
+    InvalidateAll();
+}
+
+FullTextureInfo TextureDescriptorCache::GetStageTexture(
+    const Tegra::Engines::Maxwell3D& maxwell3d,
+    Tegra::Engines::Maxwell3D::Regs::ShaderStage stage, size_t offset) {
+    const auto& regs = maxwell3d.regs;
+    const Tegra::Texture::TextureHandle tex_handle =
+        maxwell3d.GetStageTextureHandle(stage, offset);
+
+    FullTextureInfo tex_info{};
+    tex_info.index = static_cast<u32>(offset);
+
+    if (tex_handle.tic_id != 0) {
+        tex_info.enabled = true;
+        const TICEntry& tic_entry =
+            GetEntry(tic_pool, regs.tic.TICAddress(), tex_handle.tic_id,
+                     [&] { return maxwell3d.GetTICEntry(tex_handle.tic_id); });
+        // TODO(Subv): Workaround for BitField's move constructor being deleted.
+        std::memcpy(&tex_info.tic, &tic_entry, sizeof(tic_entry));
+    }
+
+    if (tex_handle.tsc_id != 0) {
+        const TSCEntry& tsc_entry =
+            GetEntry(tsc_pool, regs.tsc.TSCAddress(), tex_handle.tsc_id,
+                     [&] { return maxwell3d.GetTSCEntry(tex_handle.tsc_id); });
+        // TODO(Subv): Workaround for BitField's move constructor being deleted.
+        std::memcpy(&tex_info.tsc, &tsc_entry, sizeof(tsc_entry));
+    }
+
+    return tex_info;
+}
+
+void TextureDescriptorCache::InvalidateRegion(Tegra::GPUVAddr addr, u64 size) {
+    InvalidateRegion(tic_pool, addr, size);
+    InvalidateRegion(tsc_pool, addr, size);
+}
+
+void TextureDescriptorCache::InvalidateAll() {
+    Clear(tic_pool);
+    Clear(tsc_pool);
+}
+
+template <typename Entry, typename Decode>
+const Entry& TextureDescriptorCache::GetEntry(Pool<Entry>& pool, Tegra::GPUVAddr pool_address,
+                                              u32 index, Decode&& decode) {
+    if (pool.address != pool_address) {
+        Clear(pool);
+        pool.address = pool_address;
+    }
+
+    auto iter = pool.entries.find(index);
+    if (iter == pool.entries.end()) {
+        iter = pool.entries.emplace(index, decode()).first;
+        cached_pages.UpdateCount(pool.address + index * sizeof(Entry), sizeof(Entry), 1);
+    }
+    return iter->second;
+}
+
+template <typename Entry>
+void TextureDescriptorCache::InvalidateRegion(Pool<Entry>& pool, Tegra::GPUVAddr addr, u64 size) {
+    if (size == 0 || pool.entries.empty() || addr + size <= pool.address) {
+        return;
+    }
+
+    for (auto iter = pool.entries.begin(); iter != pool.entries.end();) {
+        const Tegra::GPUVAddr entry_addr = pool.address + iter->first * sizeof(Entry);
+        if (entry_addr < addr + size && addr < entry_addr + sizeof(Entry)) {
+            cached_pages.UpdateCount(entry_addr, sizeof(Entry), -1);
+            iter = pool.entries.erase(iter);
+        } else {
+            ++iter;
+        }
+    }
+}
+
+template <typename Entry>
+void TextureDescriptorCache::Clear(Pool<Entry>& pool) {
+    for (const auto& [index, entry] : pool.entries) {
+        cached_pages.UpdateCount(pool.address + index * sizeof(Entry), sizeof(Entry), -1);
+    }
+    pool.entries.clear();
+}
+
+} // namespace OpenGL
@@ -0,0 +1,63 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <cstddef>
+#include <unordered_map>
+#include "common/common_types.h"
+#include "video_core/engines/maxwell_3d.h"
+#include "video_core/memory_manager.h"
+#include "video_core/rasterizer_cached_pages.h"
+#include "video_core/textures/texture.h"
+
+namespace OpenGL {
+
+/**
+ * Keeps the TIC and TSC entries decoded from the descriptor pools, by their index into the pool,
+ * so that textures used by every draw aren't read from guest memory again each time. The pages of
+ * each cached entry are marked as cached, and guest writes to them drop the entry. Moving a pool
+ * to another address drops all of its entries.
+ */
+class TextureDescriptorCache final : NonCopyable {
+public:
+    explicit TextureDescriptorCache(VideoCore::RasterizerCachedPages& cached_pages);
+    ~TextureDescriptorCache();
+
+    /// Returns the texture information for a specific texture in a specific shader stage
+    Tegra::Texture::FullTextureInfo GetStageTexture(
+        const Tegra::Engines::Maxwell3D& maxwell3d,
+        Tegra::Engines::Maxwell3D::Regs::ShaderStage stage, size_t offset);
+
+    /// Drops the entries overlapping the specified region
+    void InvalidateRegion(Tegra::GPUVAddr addr, u64 size);
+
+    /// Drops every entry
+    void InvalidateAll();
+
+private:
+    template <typename Entry>
+    struct Pool {
+        /// Address the entries were read from, they're dropped when the pool is moved
+        Tegra::GPUVAddr address = 0;
+        std::unordered_map<u32, Entry> entries;
+    };
+
+    /// Returns the entry at index in pool, calling decode to read it if it isn't cached yet
+    template <typename Entry, typename Decode>
+    const Entry& GetEntry(Pool<Entry>& pool, Tegra::GPUVAddr pool_address, u32 index,
+                          Decode&& decode);
+
+    template <typename Entry>
+    void InvalidateRegion(Pool<Entry>& pool, Tegra::GPUVAddr addr, u64 size);
+
+    template <typename Entry>
+    void Clear(Pool<Entry>& pool);
+
+    Pool<Tegra::Texture::TICEntry> tic_pool;
+    Pool<Tegra::Texture::TSCEntry> tsc_pool;
+    VideoCore::RasterizerCachedPages& cached_pages;
+};
+
+} // namespace OpenGL
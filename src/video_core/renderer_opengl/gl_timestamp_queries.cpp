@@ -0,0 +1,36 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include "video_core/renderer_opengl/gl_timestamp_queries.h"
+
+namespace OpenGL {
+
+TimestampQueries::TimestampQueries() : queries(NUM_QUERIES), is_issued(NUM_QUERIES) {
+    glGenQueries(static_cast<GLsizei>(queries.size()), queries.data());
+}
+
+TimestampQueries::~TimestampQueries() {
+    glDeleteQueries(static_cast<GLsizei>(queries.size()), queries.data());
+}
+
+u32 TimestampQueries::InsertTimestamp() {
+    const u32 key = next_query;
+    next_query = (next_query + 1) % NUM_QUERIES;
+
+    glQueryCounter(queries[key], GL_TIMESTAMP);
+    is_issued[key] = true;
+    return key;
+}
+
+u64 TimestampQueries::GetTimestamp(u32 key) {
+    if (key >= NUM_QUERIES || !is_issued[key]) {
+        return 0;
+    }
+
+    GLuint64 timestamp = 0;
+    glGetQueryObjectui64v(queries[key], GL_QUERY_RESULT, &timestamp);
+    return timestamp;
+}
+
+} // namespace OpenGL
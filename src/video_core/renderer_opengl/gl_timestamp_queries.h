@@ -0,0 +1,37 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <vector>
+#include <glad/glad.h>
+#include "common/common_types.h"
+#include "common/microprofile.h"
+
+namespace OpenGL {
+
+/**
+ * Ring of GL_TIMESTAMP queries backing the GPU lane of MicroProfile. MicroProfile reads the
+ * queries of a frame back a few frames after it was submitted, by then the GPU is done with them
+ * and the readback doesn't stall. The ring has to be large enough to hold the scopes of those
+ * frames, after that the oldest queries are reused.
+ */
+class TimestampQueries final : public Common::MicroProfileGpuTimer, NonCopyable {
+public:
+    TimestampQueries();
+    ~TimestampQueries() override;
+
+    u32 InsertTimestamp() override;
+    u64 GetTimestamp(u32 key) override;
+
+private:
+    static constexpr u32 NUM_QUERIES = 32 * 1024;
+
+    std::vector<GLuint> queries;
+    /// Queries that have been issued at least once, the others have no result to read
+    std::vector<bool> is_issued;
+    u32 next_query = 0;
+};
+
+} // namespace OpenGL
@@ -136,6 +136,23 @@ inline GLenum TextureFilterMode(Tegra::Texture::TextureFilter filter_mode) {
     return {};
 }
 
+inline GLenum TextureFilterMode(Tegra::Texture::TextureFilter filter_mode,
+                                Tegra::Texture::TextureMipmapFilter mipmap_filter_mode) {
+    const bool linear = filter_mode == Tegra::Texture::TextureFilter::Linear;
+    switch (mipmap_filter_mode) {
+    case Tegra::Texture::TextureMipmapFilter::None:
+        return TextureFilterMode(filter_mode);
+    case Tegra::Texture::TextureMipmapFilter::Nearest:
+        return linear ? GL_LINEAR_MIPMAP_NEAREST : GL_NEAREST_MIPMAP_NEAREST;
+    case Tegra::Texture::TextureMipmapFilter::Linear:
+        return linear ? GL_LINEAR_MIPMAP_LINEAR : GL_NEAREST_MIPMAP_LINEAR;
+    }
+    LOG_CRITICAL(Render_OpenGL, "Unimplemented texture mipmap filter mode={}",
+                 static_cast<u32>(mipmap_filter_mode));
+    UNREACHABLE();
+    return {};
+}
+
 inline GLenum WrapMode(Tegra::Texture::WrapMode wrap_mode) {
     switch (wrap_mode) {
     case Tegra::Texture::WrapMode::Wrap:
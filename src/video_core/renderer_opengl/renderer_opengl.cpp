@@ -7,9 +7,12 @@
 #include <cstdlib>
 #include <cstring>
 #include <memory>
+#include <tuple>
+#include <utility>
 #include <glad/glad.h>
 #include "common/assert.h"
 #include "common/logging/log.h"
+#include "common/microprofile.h"
 #include "core/core.h"
 #include "core/core_timing.h"
 #include "core/frontend/emu_window.h"
@@ -22,6 +25,8 @@
 
 namespace OpenGL {
 
+MICROPROFILE_DEFINE_GPU(GPU_Present, "Present", MP_RGB(192, 192, 128));
+
 static const char vertex_shader[] = R"(
 #version 150 core
 
@@ -94,14 +99,25 @@ static std::array<GLfloat, 3 * 2> MakeOrthographicMatrix(const float width, cons
     return matrix;
 }
 
+/// Number of context scopes open on this thread, only the outermost one switches the context
+static thread_local u32 context_scope_depth = 0;
+
+/**
+ * Whether several threads make GL calls, each taking the context for its scopes. Otherwise the
+ * emulation thread holds the context for the whole session.
+ */
+static bool IsContextShared() {
+    return Settings::values.use_multi_core || Settings::values.use_asynchronous_gpu_emulation;
+}
+
 ScopeAcquireGLContext::ScopeAcquireGLContext(Core::Frontend::EmuWindow& emu_window_)
     : emu_window{emu_window_} {
-    if (Settings::values.use_multi_core) {
+    if (IsContextShared() && context_scope_depth++ == 0) {
         emu_window.MakeCurrent();
     }
 }
 ScopeAcquireGLContext::~ScopeAcquireGLContext() {
-    if (Settings::values.use_multi_core) {
+    if (IsContextShared() && --context_scope_depth == 0) {
         emu_window.DoneCurrent();
     }
 }
@@ -109,19 +125,37 @@ ScopeAcquireGLContext::~ScopeAcquireGLContext() {
 RendererOpenGL::RendererOpenGL(Core::Frontend::EmuWindow& window)
     : VideoCore::RendererBase{window} {}
 
-RendererOpenGL::~RendererOpenGL() = default;
+RendererOpenGL::~RendererOpenGL() {
+    Common::SetMicroProfileGpuTimer(nullptr);
+
+    if (frame_mailbox) {
+        ScopeAcquireGLContext acquire_context{render_window};
+        frame_mailbox->Close();
+        render_window.SetFrameMailbox(nullptr);
+    }
+}
 
 /// Swap buffers (render frame)
 void RendererOpenGL::SwapBuffers(boost::optional<const Tegra::FramebufferConfig&> framebuffer) {
-    ScopeAcquireGLContext acquire_context{render_window};
-
+    TRACE_SCOPE("Present");
     Core::System::GetInstance().perf_stats.EndSystemFrame();
 
-    // Maintain the rasterizer's state as a priority
-    OpenGLState prev_state = OpenGLState::GetCurState();
-    state.Apply();
+    {
+        // MicroProfile inserts and reads back the GPU timestamps of its frames on flip
+        ScopeAcquireGLContext acquire_context{render_window};
+        MicroProfileFlip();
+    }
+    Common::MicroProfileCounterFlip();
 
+    // When the guest didn't queue a new frame, there's nothing to draw. Avoid applying the state
+    // in that case, this runs on the CPU thread on every vsync.
     if (framebuffer != boost::none) {
+        ScopeAcquireGLContext acquire_context{render_window};
+
+        // Maintain the rasterizer's state as a priority
+        OpenGLState prev_state = OpenGLState::GetCurState();
+        state.Apply();
+
         // If framebuffer is provided, reload it from memory to a texture
         if (screen_info.texture.width != (GLsizei)framebuffer->width ||
             screen_info.texture.height != (GLsizei)framebuffer->height ||
@@ -134,17 +168,42 @@ void RendererOpenGL::SwapBuffers(boost::optional<const Tegra::FramebufferConfig&
 
         // Load the framebuffer from memory, draw it to the screen, and swap buffers
         LoadFBToScreenInfo(*framebuffer);
-        DrawScreen();
-        render_window.SwapBuffers();
+        if (!Settings::values.skip_present) {
+            const auto& layout = render_window.GetFramebufferLayout();
+            if (frame_mailbox) {
+                // The frontend's presentation thread shows the frame and waits for the swap
+                auto& frame = frame_mailbox->GetRenderFrame(layout.width, layout.height);
+                {
+                    MICROPROFILE_SCOPEGPU(GPU_Present);
+                    DrawScreen(layout, frame.render_framebuffer.handle);
+                }
+                frame_mailbox->ReleaseRenderFrame(frame);
+            } else {
+                {
+                    MICROPROFILE_SCOPEGPU(GPU_Present);
+                    DrawScreen(layout, 0);
+                }
+
+                const auto present_begin = Core::PerfStats::Clock::now();
+                render_window.SwapBuffers();
+                Core::System::GetInstance().perf_stats.AddPresentTime(
+                    Core::PerfStats::Clock::now() - present_begin);
+            }
+        }
+
+        rasterizer->TickFrame();
+
+        // Restore the rasterizer state
+        prev_state.Apply();
     }
 
     render_window.PollEvents();
 
-    Core::System::GetInstance().frame_limiter.DoFrameLimiting(CoreTiming::GetGlobalTimeUs());
-    Core::System::GetInstance().perf_stats.BeginSystemFrame();
-
-    // Restore the rasterizer state
-    prev_state.Apply();
+    auto& system = Core::System::GetInstance();
+    const auto limiter_begin = Core::PerfStats::Clock::now();
+    system.frame_limiter.DoFrameLimiting(CoreTiming::GetGlobalTimeUs());
+    system.perf_stats.AddLimiterTime(Core::PerfStats::Clock::now() - limiter_begin);
+    system.perf_stats.BeginSystemFrame();
 }
 
 /**
@@ -166,13 +225,22 @@ void RendererOpenGL::LoadFBToScreenInfo(const Tegra::FramebufferConfig& framebuf
     if (!rasterizer->AccelerateDisplay(framebuffer, framebuffer_addr, framebuffer.stride)) {
         // Reset the screen info's display texture to its own permanent texture
         screen_info.display_texture = screen_info.texture.resource.handle;
+        screen_info.display_resolution_scale = 1.0f;
 
         Memory::RasterizerFlushVirtualRegion(framebuffer_addr, size_in_bytes,
                                              Memory::FlushMode::Flush);
 
+        // Decode straight into the unpack buffer, the driver copies it to the texture whenever
+        // the GPU gets to it instead of synchronously from client memory
+        const GLsizeiptr pbo_size = static_cast<GLsizeiptr>(
+            std::max(framebuffer.stride, framebuffer.width) * framebuffer.height * 4);
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, framebuffer_pbo->GetHandle());
+        u8* pbo_ptr;
+        GLintptr pbo_offset;
+        std::tie(pbo_ptr, pbo_offset, std::ignore) = framebuffer_pbo->Map(pbo_size, 4);
         VideoCore::MortonCopyPixels128(framebuffer.width, framebuffer.height, bytes_per_pixel, 4,
-                                       Memory::GetPointer(framebuffer_addr),
-                                       gl_framebuffer_data.data(), true);
+                                       Memory::GetPointer(framebuffer_addr), pbo_ptr, true);
+        framebuffer_pbo->Unmap(pbo_size);
 
         state.texture_units[0].texture_2d = screen_info.texture.resource.handle;
         state.Apply();
@@ -187,9 +255,10 @@ void RendererOpenGL::LoadFBToScreenInfo(const Tegra::FramebufferConfig& framebuf
         //       framebuffer sizes. We should make sure that this cannot happen.
         glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, framebuffer.width, framebuffer.height,
                         screen_info.texture.gl_format, screen_info.texture.gl_type,
-                        gl_framebuffer_data.data());
+                        reinterpret_cast<const void*>(pbo_offset));
 
         glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
 
         state.texture_units[0].texture_2d = 0;
         state.Apply();
@@ -251,6 +320,12 @@ void RendererOpenGL::InitOpenGLObjects() {
     glEnableVertexAttribArray(attrib_position);
     glEnableVertexAttribArray(attrib_tex_coord);
 
+    framebuffer_pbo =
+        std::make_unique<OGLStreamBuffer>(GL_PIXEL_UNPACK_BUFFER, FRAMEBUFFER_PBO_SIZE);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+    screen_read_framebuffer.Create();
+
     // Allocate textures for the screen
     screen_info.texture.resource.Create();
 
@@ -296,7 +371,6 @@ void RendererOpenGL::ConfigureFramebufferTexture(TextureInfo& texture,
         internal_format = GL_RGBA;
         texture.gl_format = GL_RGBA;
         texture.gl_type = GL_UNSIGNED_INT_8_8_8_8_REV;
-        gl_framebuffer_data.resize(texture.width * texture.height * 4);
         break;
     default:
         UNREACHABLE();
@@ -363,14 +437,82 @@ void RendererOpenGL::DrawScreenTriangles(const ScreenInfo& screen_info, float x,
 }
 
 /**
- * Draws the emulated screens to the emulator window.
+ * Copies the display texture to the emulator window with a framebuffer blit, which skips the
+ * shader and vertex setup of a draw. Returns false if the framebuffer's transform can't be
+ * expressed as a blit.
+ */
+bool RendererOpenGL::BlitScreen(const Layout::FramebufferLayout& layout) {
+    using TransformFlags = Tegra::FramebufferConfig::TransformFlags;
+    if (framebuffer_transform_flags != TransformFlags::Unset &&
+        framebuffer_transform_flags != TransformFlags::FlipV) {
+        return false;
+    }
+
+    ASSERT_MSG(framebuffer_crop_rect.top == 0, "Unimplemented");
+    ASSERT_MSG(framebuffer_crop_rect.left == 0, "Unimplemented");
+
+    // Only the cropped part of the framebuffer is shown, see DrawScreenTriangles
+    const float scale = screen_info.display_resolution_scale;
+    const int crop_width = framebuffer_crop_rect.GetWidth() > 0 ? framebuffer_crop_rect.GetWidth()
+                                                                : screen_info.texture.width;
+    const int crop_height = framebuffer_crop_rect.GetHeight() > 0
+                                ? framebuffer_crop_rect.GetHeight()
+                                : screen_info.texture.height;
+    const GLint src_width = static_cast<GLint>(crop_width * scale);
+    const GLint src_height = static_cast<GLint>(crop_height * scale);
+
+    // The first row of the framebuffer is displayed at the top of the screen, while the window's
+    // origin is at the bottom. Blitting to an inverted rectangle flips it.
+    const auto& screen = layout.screen;
+    GLint dst_y0 = static_cast<GLint>(layout.height - screen.top);
+    GLint dst_y1 = static_cast<GLint>(layout.height - screen.bottom);
+    if (framebuffer_transform_flags == TransformFlags::FlipV) {
+        std::swap(dst_y0, dst_y1);
+    }
+
+    state.draw.read_framebuffer = screen_read_framebuffer.handle;
+    state.Apply();
+
+    glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D,
+                           screen_info.display_texture, 0);
+
+    const bool same_size = src_width == static_cast<GLint>(screen.GetWidth()) &&
+                           src_height == static_cast<GLint>(screen.GetHeight());
+    glBlitFramebuffer(0, 0, src_width, src_height, static_cast<GLint>(screen.left), dst_y0,
+                      static_cast<GLint>(screen.right), dst_y1, GL_COLOR_BUFFER_BIT,
+                      same_size ? GL_NEAREST : GL_LINEAR);
+
+    glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, 0, 0);
+    state.draw.read_framebuffer = 0;
+    state.Apply();
+
+    return true;
+}
+
+/**
+ * Draws the emulated screens to the emulator window, or to a framebuffer with the same layout.
  */
-void RendererOpenGL::DrawScreen() {
-    const auto& layout = render_window.GetFramebufferLayout();
+void RendererOpenGL::DrawScreen(const Layout::FramebufferLayout& layout,
+                                GLuint draw_framebuffer) {
     const auto& screen = layout.screen;
 
+    // A full-screen layer overwrites the whole window, clearing it first would be wasted work
+    const bool covers_window = screen.left == 0 && screen.top == 0 &&
+                               screen.GetWidth() == layout.width &&
+                               screen.GetHeight() == layout.height;
+
+    state.draw.draw_framebuffer = draw_framebuffer;
+    state.Apply();
+
     glViewport(0, 0, layout.width, layout.height);
-    glClear(GL_COLOR_BUFFER_BIT);
+    if (!covers_window) {
+        glClear(GL_COLOR_BUFFER_BIT);
+    }
+
+    if (BlitScreen(layout)) {
+        m_current_frame++;
+        return;
+    }
 
     // Set projection matrix
     std::array<GLfloat, 3 * 2> ortho_matrix =
@@ -473,10 +615,25 @@ bool RendererOpenGL::Init() {
     InitOpenGLObjects();
     CreateRasterizer();
 
+    timestamp_queries = std::make_unique<TimestampQueries>();
+    Common::SetMicroProfileGpuTimer(timestamp_queries.get());
+
+    if (render_window.HasPresentationThread()) {
+        frame_mailbox = std::make_shared<FrameMailbox>();
+        render_window.SetFrameMailbox(frame_mailbox);
+    }
+
     return true;
 }
 
 /// Shutdown the renderer
-void RendererOpenGL::ShutDown() {}
+void RendererOpenGL::ShutDown() {
+    Common::SetMicroProfileGpuTimer(nullptr);
+}
+
+void RendererOpenGL::RunWithContext(const std::function<void()>& func) {
+    ScopeAcquireGLContext acquire_context{render_window};
+    func();
+}
 
 } // namespace OpenGL
@@ -4,13 +4,18 @@
 
 #pragma once
 
+#include <memory>
 #include <vector>
 #include <glad/glad.h>
 #include "common/common_types.h"
 #include "common/math_util.h"
+#include "core/frontend/framebuffer_layout.h"
 #include "video_core/renderer_base.h"
+#include "video_core/renderer_opengl/gl_frame_mailbox.h"
 #include "video_core/renderer_opengl/gl_resource_manager.h"
 #include "video_core/renderer_opengl/gl_state.h"
+#include "video_core/renderer_opengl/gl_stream_buffer.h"
+#include "video_core/renderer_opengl/gl_timestamp_queries.h"
 
 namespace Core::Frontend {
 class EmuWindow;
@@ -32,10 +37,12 @@ struct TextureInfo {
 struct ScreenInfo {
     GLuint display_texture;
     const MathUtil::Rectangle<float> display_texcoords{0.0f, 0.0f, 1.0f, 1.0f};
+    /// Resolution scale of the display texture, surfaces from the rasterizer cache may be scaled
+    float display_resolution_scale = 1.0f;
     TextureInfo texture;
 };
 
-/// Helper class to acquire/release OpenGL context within a given scope
+/// Helper class to acquire/release OpenGL context within a given scope, scopes may be nested
 class ScopeAcquireGLContext : NonCopyable {
 public:
     explicit ScopeAcquireGLContext(Core::Frontend::EmuWindow& window);
@@ -59,14 +66,17 @@ public:
     /// Shutdown the renderer
     void ShutDown() override;
 
+    void RunWithContext(const std::function<void()>& func) override;
+
 private:
     void InitOpenGLObjects();
     void CreateRasterizer();
 
     void ConfigureFramebufferTexture(TextureInfo& texture,
                                      const Tegra::FramebufferConfig& framebuffer);
-    void DrawScreen();
+    void DrawScreen(const Layout::FramebufferLayout& layout, GLuint draw_framebuffer);
     void DrawScreenTriangles(const ScreenInfo& screen_info, float x, float y, float w, float h);
+    bool BlitScreen(const Layout::FramebufferLayout& layout);
     void UpdateFramerate();
 
     // Loads framebuffer from emulated memory into the display information structure
@@ -81,12 +91,22 @@ private:
     OGLVertexArray vertex_array;
     OGLBuffer vertex_buffer;
     OGLProgram shader;
+    /// Read framebuffer the display texture is attached to when it's blitted to the window
+    OGLFramebuffer screen_read_framebuffer;
 
     /// Display information for Switch screen
     ScreenInfo screen_info;
 
-    /// OpenGL framebuffer data
-    std::vector<u8> gl_framebuffer_data;
+    /// Pixel unpack buffer the framebuffer is decoded into when it can't be presented from the
+    /// rasterizer cache, so the texture upload doesn't have to copy it out of client memory
+    static constexpr GLsizeiptr FRAMEBUFFER_PBO_SIZE = 32 * 1024 * 1024;
+    std::unique_ptr<OGLStreamBuffer> framebuffer_pbo;
+
+    /// Frames handed to the frontend's presentation thread, null when the renderer presents them
+    std::shared_ptr<FrameMailbox> frame_mailbox;
+
+    /// Timestamps of the GPU scopes shown in the profiler
+    std::unique_ptr<TimestampQueries> timestamp_queries;
 
     // Shader uniform location indices
     GLuint uniform_modelview_matrix;
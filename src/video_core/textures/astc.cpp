@@ -16,11 +16,15 @@
 // <http://gamma.cs.unc.edu/FasTC/>
 
 #include <algorithm>
+#include <array>
 #include <cassert>
 #include <cstdint>
 #include <cstring>
 #include <vector>
 
+#include <boost/container/small_vector.hpp>
+
+#include "common/thread_pool.h"
 #include "video_core/textures/astc.h"
 
 class BitStream {
@@ -134,6 +138,11 @@ private:
 
 enum EIntegerEncoding { eIntegerEncoding_JustBits, eIntegerEncoding_Quint, eIntegerEncoding_Trit };
 
+class IntegerEncodedValue;
+
+// A block holds at most 64 texel weights, so decoding a block never has to go to the heap.
+using IntegerEncodedVector = boost::container::small_vector<IntegerEncodedValue, 64>;
+
 class IntegerEncodedValue {
 private:
     const EIntegerEncoding m_Encoding;
@@ -238,7 +247,7 @@ public:
     // Fills result with the values that are encoded in the given
     // bitstream. We must know beforehand what the maximum possible
     // value is, and how many values we're decoding.
-    static void DecodeIntegerSequence(std::vector<IntegerEncodedValue>& result, BitStream& bits,
+    static void DecodeIntegerSequence(IntegerEncodedVector& result, BitStream& bits,
                                       uint32_t maxRange, uint32_t nValues) {
         // Determine encoding parameters
         IntegerEncodedValue val = IntegerEncodedValue::CreateEncoding(maxRange);
@@ -267,11 +276,97 @@ public:
     }
 
 private:
-    static void DecodeTritBlock(BitStream& bits, std::vector<IntegerEncodedValue>& result,
+    // The five trits of a trit block are packed into 8 bits, and the three quints of a quint
+    // block into 7 bits. Every possible packing is unpacked once, following section C.2.12, so
+    // decoding a block is a single table lookup.
+    static const std::array<std::array<uint8_t, 5>, 256>& GetTritTable() {
+        static const auto table = [] {
+            std::array<std::array<uint8_t, 5>, 256> trits{};
+            for (uint32_t T = 0; T < 256; T++) {
+                uint32_t t[5];
+                uint32_t C = 0;
+
+                Bits<uint32_t> Tb(T);
+                if (Tb(2, 4) == 7) {
+                    C = (Tb(5, 7) << 2) | Tb(0, 1);
+                    t[4] = t[3] = 2;
+                } else {
+                    C = Tb(0, 4);
+                    if (Tb(5, 6) == 3) {
+                        t[4] = 2;
+                        t[3] = Tb[7];
+                    } else {
+                        t[4] = Tb[7];
+                        t[3] = Tb(5, 6);
+                    }
+                }
+
+                Bits<uint32_t> Cb(C);
+                if (Cb(0, 1) == 3) {
+                    t[2] = 2;
+                    t[1] = Cb[4];
+                    t[0] = (Cb[3] << 1) | (Cb[2] & ~Cb[3]);
+                } else if (Cb(2, 3) == 3) {
+                    t[2] = 2;
+                    t[1] = 2;
+                    t[0] = Cb(0, 1);
+                } else {
+                    t[2] = Cb[4];
+                    t[1] = Cb(2, 3);
+                    t[0] = (Cb[1] << 1) | (Cb[0] & ~Cb[1]);
+                }
+
+                for (uint32_t i = 0; i < 5; i++) {
+                    trits[T][i] = static_cast<uint8_t>(t[i]);
+                }
+            }
+            return trits;
+        }();
+        return table;
+    }
+
+    static const std::array<std::array<uint8_t, 3>, 128>& GetQuintTable() {
+        static const auto table = [] {
+            std::array<std::array<uint8_t, 3>, 128> quints{};
+            for (uint32_t Q = 0; Q < 128; Q++) {
+                uint32_t q[3];
+                Bits<uint32_t> Qb(Q);
+                if (Qb(1, 2) == 3 && Qb(5, 6) == 0) {
+                    q[0] = q[1] = 4;
+                    q[2] = (Qb[0] << 2) | ((Qb[4] & ~Qb[0]) << 1) | (Qb[3] & ~Qb[0]);
+                } else {
+                    uint32_t C = 0;
+                    if (Qb(1, 2) == 3) {
+                        q[2] = 4;
+                        C = (Qb(3, 4) << 3) | ((~Qb(5, 6) & 3) << 1) | Qb[0];
+                    } else {
+                        q[2] = Qb(5, 6);
+                        C = Qb(0, 4);
+                    }
+
+                    Bits<uint32_t> Cb(C);
+                    if (Cb(0, 2) == 5) {
+                        q[1] = 4;
+                        q[0] = Cb(3, 4);
+                    } else {
+                        q[1] = Cb(3, 4);
+                        q[0] = Cb(0, 2);
+                    }
+                }
+
+                for (uint32_t i = 0; i < 3; i++) {
+                    quints[Q][i] = static_cast<uint8_t>(q[i]);
+                }
+            }
+            return quints;
+        }();
+        return table;
+    }
+
+    static void DecodeTritBlock(BitStream& bits, IntegerEncodedVector& result,
                                 uint32_t nBitsPerValue) {
         // Implement the algorithm in section C.2.12
         uint32_t m[5];
-        uint32_t t[5];
         uint32_t T;
 
         // Read the trit encoded block according to
@@ -287,37 +382,7 @@ private:
         m[4] = bits.ReadBits(nBitsPerValue);
         T |= bits.ReadBit() << 7;
 
-        uint32_t C = 0;
-
-        Bits<uint32_t> Tb(T);
-        if (Tb(2, 4) == 7) {
-            C = (Tb(5, 7) << 2) | Tb(0, 1);
-            t[4] = t[3] = 2;
-        } else {
-            C = Tb(0, 4);
-            if (Tb(5, 6) == 3) {
-                t[4] = 2;
-                t[3] = Tb[7];
-            } else {
-                t[4] = Tb[7];
-                t[3] = Tb(5, 6);
-            }
-        }
-
-        Bits<uint32_t> Cb(C);
-        if (Cb(0, 1) == 3) {
-            t[2] = 2;
-            t[1] = Cb[4];
-            t[0] = (Cb[3] << 1) | (Cb[2] & ~Cb[3]);
-        } else if (Cb(2, 3) == 3) {
-            t[2] = 2;
-            t[1] = 2;
-            t[0] = Cb(0, 1);
-        } else {
-            t[2] = Cb[4];
-            t[1] = Cb(2, 3);
-            t[0] = (Cb[1] << 1) | (Cb[0] & ~Cb[1]);
-        }
+        const std::array<uint8_t, 5>& t = GetTritTable()[T];
 
         for (uint32_t i = 0; i < 5; i++) {
             IntegerEncodedValue val(eIntegerEncoding_Trit, nBitsPerValue);
@@ -327,11 +392,10 @@ private:
         }
     }
 
-    static void DecodeQuintBlock(BitStream& bits, std::vector<IntegerEncodedValue>& result,
+    static void DecodeQuintBlock(BitStream& bits, IntegerEncodedVector& result,
                                  uint32_t nBitsPerValue) {
         // Implement the algorithm in section C.2.12
         uint32_t m[3];
-        uint32_t q[3];
         uint32_t Q;
 
         // Read the trit encoded block according to
@@ -343,29 +407,7 @@ private:
         m[2] = bits.ReadBits(nBitsPerValue);
         Q |= bits.ReadBits(2) << 5;
 
-        Bits<uint32_t> Qb(Q);
-        if (Qb(1, 2) == 3 && Qb(5, 6) == 0) {
-            q[0] = q[1] = 4;
-            q[2] = (Qb[0] << 2) | ((Qb[4] & ~Qb[0]) << 1) | (Qb[3] & ~Qb[0]);
-        } else {
-            uint32_t C = 0;
-            if (Qb(1, 2) == 3) {
-                q[2] = 4;
-                C = (Qb(3, 4) << 3) | ((~Qb(5, 6) & 3) << 1) | Qb[0];
-            } else {
-                q[2] = Qb(5, 6);
-                C = Qb(0, 4);
-            }
-
-            Bits<uint32_t> Cb(C);
-            if (Cb(0, 2) == 5) {
-                q[1] = 4;
-                q[0] = Cb(3, 4);
-            } else {
-                q[1] = Cb(3, 4);
-                q[0] = Cb(0, 2);
-            }
-        }
+        const std::array<uint8_t, 3>& q = GetQuintTable()[Q];
 
         for (uint32_t i = 0; i < 3; i++) {
             IntegerEncodedValue val(eIntegerEncoding_Quint, nBitsPerValue);
@@ -820,7 +862,7 @@ static void DecodeColorValues(uint32_t* out, uint8_t* data, const uint32_t* mode
     }
 
     // We now have enough to decode our integer sequence.
-    std::vector<IntegerEncodedValue> decodedColorValues;
+    IntegerEncodedVector decodedColorValues;
     BitStream colorStream(data);
     IntegerEncodedValue::DecodeIntegerSequence(decodedColorValues, colorStream, range, nValues);
 
@@ -1050,7 +1092,7 @@ static uint32_t UnquantizeTexelWeight(const IntegerEncodedValue& val) {
 }
 
 static void UnquantizeTexelWeights(uint32_t out[2][144],
-                                   const std::vector<IntegerEncodedValue>& weights,
+                                   const IntegerEncodedVector& weights,
                                    const TexelWeightParams& params, const uint32_t blockWidth,
                                    const uint32_t blockHeight) {
     uint32_t weightIdx = 0;
@@ -1548,7 +1590,7 @@ static void DecompressBlock(uint8_t inBuf[16], const uint32_t blockWidth,
     texelWeightData[clearByteStart - 1] &= (1 << (weightParams.GetPackedBitSize() % 8)) - 1;
     memset(texelWeightData + clearByteStart, 0, 16 - clearByteStart);
 
-    std::vector<IntegerEncodedValue> texelWeightValues;
+    IntegerEncodedVector texelWeightValues;
     BitStream weightStream(texelWeightData);
 
     IntegerEncodedValue::DecodeIntegerSequence(texelWeightValues, weightStream,
@@ -1599,9 +1641,15 @@ namespace Tegra::Texture::ASTC {
 
 std::vector<uint8_t> Decompress(std::vector<uint8_t>& data, uint32_t width, uint32_t height,
                                 uint32_t block_width, uint32_t block_height) {
-    uint32_t blockIdx = 0;
     std::vector<uint8_t> outData(height * width * 4);
-    for (uint32_t j = 0; j < height; j += block_height) {
+    const uint32_t blocksPerRow = (width + block_width - 1) / block_width;
+    const uint32_t numBlockRows = (height + block_height - 1) / block_height;
+
+    // Blocks decode independently and every row of blocks writes its own rows of the output, so
+    // the rows are spread across the host cores.
+    Common::GetSharedThreadPool().ParallelFor(numBlockRows, [&](size_t blockRow) {
+        const uint32_t j = static_cast<uint32_t>(blockRow) * block_height;
+        uint32_t blockIdx = static_cast<uint32_t>(blockRow) * blocksPerRow;
         for (uint32_t i = 0; i < width; i += block_width) {
 
             uint8_t* blockPtr = data.data() + blockIdx * 16;
@@ -1620,7 +1668,7 @@ std::vector<uint8_t> Decompress(std::vector<uint8_t>& data, uint32_t width, uint
 
             blockIdx++;
         }
-    }
+    });
 
     return outData;
 }
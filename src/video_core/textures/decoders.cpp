@@ -2,9 +2,12 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
 #include <cmath>
 #include <cstring>
+#include "common/alignment.h"
 #include "common/assert.h"
+#include "common/thread_pool.h"
 #include "core/memory.h"
 #include "video_core/gpu.h"
 #include "video_core/textures/decoders.h"
@@ -12,33 +15,180 @@
 
 namespace Tegra::Texture {
 
+/// Width of a GOB (group of bytes) in bytes, a block linear surface is made of 64x8 byte GOBs.
+static constexpr u32 GOB_SIZE_X = 64;
+/// Height of a GOB in rows.
+static constexpr u32 GOB_SIZE_Y = 8;
+/// Size of a GOB in bytes.
+static constexpr u32 GOB_SIZE = GOB_SIZE_X * GOB_SIZE_Y;
+/// Inside a GOB, each row is stored as 16 byte sectors that are contiguous in memory.
+static constexpr u32 GOB_SECTOR_SIZE = 16;
+/// Surfaces at least this large in bytes are swizzled on the shared thread pool.
+static constexpr u32 PARALLEL_COPY_THRESHOLD = 1024 * 1024;
+
+/**
+ * Calculates the offset of the start of row (y, z) within a block linear surface, i.e. the offset
+ * of the byte at x = 0. Blocks are block_height x block_depth GOBs stacked vertically, and are laid
+ * out left to right, top to bottom and then slice by slice. Taken from the Tegra X1 TRM.
+ */
+static u32 GetBlockLinearRowOffset(u32 y, u32 z, u32 width_in_gobs, u32 height, u32 block_height,
+                                   u32 block_depth) {
+    const u32 block_size{GOB_SIZE * block_height * block_depth};
+    const u32 block_height_in_rows{GOB_SIZE_Y * block_height};
+    const u32 height_in_blocks{(height + block_height_in_rows - 1) / block_height_in_rows};
+
+    const u32 block_index{(z / block_depth) * height_in_blocks + y / block_height_in_rows};
+    const u32 gob_index{(z % block_depth) * block_height + (y / GOB_SIZE_Y) % block_height};
+
+    return block_index * width_in_gobs * block_size + gob_index * GOB_SIZE +
+           ((y % 8) / 2) * 64 + (y % 2) * 16;
+}
+
 /**
- * Calculates the offset of an (x, y) position within a swizzled texture.
- * Taken from the Tegra X1 TRM.
+ * Calculates the offset of byte column x relative to the start of its row, as returned by
+ * GetBlockLinearRowOffset.
  */
-static u32 GetSwizzleOffset(u32 x, u32 y, u32 image_width, u32 bytes_per_pixel, u32 block_height) {
-    // Round up to the next gob
-    const u32 image_width_in_gobs{(image_width * bytes_per_pixel + 63) / 64};
-
-    u32 GOB_address = 0 + (y / (8 * block_height)) * 512 * block_height * image_width_in_gobs +
-                      (x * bytes_per_pixel / 64) * 512 * block_height +
-                      (y % (8 * block_height) / 8) * 512;
-    x *= bytes_per_pixel;
-    u32 address = GOB_address + ((x % 64) / 32) * 256 + ((y % 8) / 2) * 64 + ((x % 32) / 16) * 32 +
-                  (y % 2) * 16 + (x % 16);
-
-    return address;
+static u32 GetBlockLinearColumnOffset(u32 x, u32 block_size) {
+    return (x / GOB_SIZE_X) * block_size + ((x % 64) / 32) * 256 + ((x % 32) / 16) * 32 + (x % 16);
+}
+
+/// Copies a 16 byte GOB sector. The size is a constant so this compiles to a single vector move.
+template <bool unswizzle>
+static void CopySector(u8* swizzled, u8* linear) {
+    if (unswizzle) {
+        std::memcpy(linear, swizzled, GOB_SECTOR_SIZE);
+    } else {
+        std::memcpy(swizzled, linear, GOB_SECTOR_SIZE);
+    }
+}
+
+/**
+ * Copies length bytes starting at byte column x between a row of a block linear surface and a
+ * linear buffer. Data is moved a whole GOB sector at a time instead of byte by byte.
+ */
+template <bool unswizzle>
+static void CopyBlockLinearRow(u8* swizzled_row, u8* linear_data, u32 x, u32 length,
+                               u32 block_size) {
+    while (length > 0) {
+        const u32 copy_size{std::min(GOB_SECTOR_SIZE - x % GOB_SECTOR_SIZE, length)};
+        u8* const swizzled{swizzled_row + GetBlockLinearColumnOffset(x, block_size)};
+        if (copy_size == GOB_SECTOR_SIZE) {
+            CopySector<unswizzle>(swizzled, linear_data);
+        } else if (unswizzle) {
+            std::memcpy(linear_data, swizzled, copy_size);
+        } else {
+            std::memcpy(swizzled, linear_data, copy_size);
+        }
+        linear_data += copy_size;
+        x += copy_size;
+        length -= copy_size;
+    }
+}
+
+/**
+ * Copies a whole GOB between a block linear surface and 8 lines of a linear buffer. All offsets
+ * are constants once the loops are unrolled, leaving 32 sector copies.
+ */
+template <bool unswizzle>
+static void CopyGOB(u8* gob, u8* linear_data, u32 linear_pitch) {
+    for (u32 y = 0; y < GOB_SIZE_Y; ++y) {
+        u8* const line{linear_data + y * linear_pitch};
+        const u32 row_offset{((y % 8) / 2) * 64 + (y % 2) * 16};
+        for (u32 x = 0; x < GOB_SIZE_X; x += GOB_SECTOR_SIZE) {
+            CopySector<unswizzle>(gob + row_offset + ((x % 64) / 32) * 256 + ((x % 32) / 16) * 32,
+                                  line + x);
+        }
+    }
+}
+
+template <bool unswizzle>
+static void CopyBlockLinearRectImpl(u32 width, u32 height, u32 bytes_per_pixel,
+                                    u8* swizzled_data, u32 surface_width, u32 surface_height,
+                                    u32 block_height, u32 block_depth, u32 origin_x,
+                                    u32 origin_y, u32 origin_z, u8* linear_data,
+                                    u32 linear_pitch) {
+    const u32 width_in_gobs{(surface_width * bytes_per_pixel + GOB_SIZE_X - 1) / GOB_SIZE_X};
+    const u32 block_size{GOB_SIZE * block_height * block_depth};
+    const u32 start_x{origin_x * bytes_per_pixel};
+    const u32 end_x{start_x + width * bytes_per_pixel};
+
+    // Columns covering whole GOBs, these are copied a GOB at a time when 8 lines are available.
+    const u32 gobs_start_x{Common::AlignUp(start_x, GOB_SIZE_X)};
+    const u32 gobs_end_x{std::max(Common::AlignDown(end_x, GOB_SIZE_X), gobs_start_x)};
+
+    const auto row_offset = [&](u32 y) {
+        return GetBlockLinearRowOffset(y, origin_z, width_in_gobs, surface_height, block_height,
+                                       block_depth);
+    };
+
+    u32 line = 0;
+    while (line < height) {
+        const u32 y{origin_y + line};
+        u8* const linear_line{linear_data + line * linear_pitch};
+
+        if (y % GOB_SIZE_Y != 0 || height - line < GOB_SIZE_Y || gobs_start_x == gobs_end_x) {
+            CopyBlockLinearRow<unswizzle>(swizzled_data + row_offset(y), linear_line, start_x,
+                                          end_x - start_x, block_size);
+            ++line;
+            continue;
+        }
+
+        // A full row of GOBs: the unaligned edges go row by row, the middle GOB by GOB.
+        for (u32 gob_line = 0; gob_line < GOB_SIZE_Y; ++gob_line) {
+            u8* const swizzled_row{swizzled_data + row_offset(y + gob_line)};
+            u8* const linear_row{linear_line + gob_line * linear_pitch};
+            CopyBlockLinearRow<unswizzle>(swizzled_row, linear_row, start_x,
+                                          gobs_start_x - start_x, block_size);
+            CopyBlockLinearRow<unswizzle>(swizzled_row, linear_row + (gobs_end_x - start_x),
+                                          gobs_end_x, end_x - gobs_end_x, block_size);
+        }
+
+        u8* const gob_row{swizzled_data + row_offset(y)};
+        for (u32 x = gobs_start_x; x < gobs_end_x; x += GOB_SIZE_X) {
+            CopyGOB<unswizzle>(gob_row + (x / GOB_SIZE_X) * block_size,
+                               linear_line + (x - start_x), linear_pitch);
+        }
+        line += GOB_SIZE_Y;
+    }
 }
 
 void CopySwizzledData(u32 width, u32 height, u32 bytes_per_pixel, u32 out_bytes_per_pixel,
                       u8* swizzled_data, u8* unswizzled_data, bool unswizzle, u32 block_height) {
+    if (bytes_per_pixel == out_bytes_per_pixel) {
+        const u32 pitch{width * bytes_per_pixel};
+        const u32 band_height{GOB_SIZE_Y * block_height};
+        const u32 num_bands{(height + band_height - 1) / band_height};
+
+        // Each row of blocks is stored contiguously and independently of the others, so large
+        // surfaces are split into those bands and spread across the host cores.
+        const auto copy_band = [&](size_t band) {
+            const u32 y{static_cast<u32>(band) * band_height};
+            CopyBlockLinearRect(width, std::min(band_height, height - y), bytes_per_pixel,
+                                swizzled_data, width, height, block_height, 1, 0, y, 0,
+                                unswizzled_data + y * pitch, pitch, unswizzle);
+        };
+        if (pitch * height >= PARALLEL_COPY_THRESHOLD) {
+            Common::GetSharedThreadPool().ParallelFor(num_bands, copy_band);
+        } else {
+            for (u32 band = 0; band < num_bands; ++band) {
+                copy_band(band);
+            }
+        }
+        return;
+    }
+
+    // The linear buffer uses a different pixel stride, copy one pixel at a time.
+    const u32 width_in_gobs{(width * bytes_per_pixel + GOB_SIZE_X - 1) / GOB_SIZE_X};
+    const u32 block_size{GOB_SIZE * block_height};
     u8* data_ptrs[2];
     for (unsigned y = 0; y < height; ++y) {
+        u8* const swizzled_row{swizzled_data + GetBlockLinearRowOffset(y, 0, width_in_gobs, height,
+                                                                       block_height, 1)};
         for (unsigned x = 0; x < width; ++x) {
-            u32 swizzle_offset = GetSwizzleOffset(x, y, width, bytes_per_pixel, block_height);
-            u32 pixel_index = (x + y * width) * out_bytes_per_pixel;
+            const u32 swizzle_offset{GetBlockLinearColumnOffset(x * bytes_per_pixel, block_size)};
+            const u32 pixel_index{(x + y * width) * out_bytes_per_pixel};
 
-            data_ptrs[unswizzle] = swizzled_data + swizzle_offset;
+            data_ptrs[unswizzle] = swizzled_row + swizzle_offset;
             data_ptrs[!unswizzle] = &unswizzled_data[pixel_index];
 
             std::memcpy(data_ptrs[0], data_ptrs[1], bytes_per_pixel);
@@ -46,6 +196,21 @@ void CopySwizzledData(u32 width, u32 height, u32 bytes_per_pixel, u32 out_bytes_
     }
 }
 
+void CopyBlockLinearRect(u32 width, u32 height, u32 bytes_per_pixel, u8* swizzled_data,
+                         u32 surface_width, u32 surface_height, u32 block_height, u32 block_depth,
+                         u32 origin_x, u32 origin_y, u32 origin_z, u8* linear_data,
+                         u32 linear_pitch, bool unswizzle) {
+    if (unswizzle) {
+        CopyBlockLinearRectImpl<true>(width, height, bytes_per_pixel, swizzled_data, surface_width,
+                                      surface_height, block_height, block_depth, origin_x,
+                                      origin_y, origin_z, linear_data, linear_pitch);
+    } else {
+        CopyBlockLinearRectImpl<false>(width, height, bytes_per_pixel, swizzled_data,
+                                       surface_width, surface_height, block_height, block_depth,
+                                       origin_x, origin_y, origin_z, linear_data, linear_pitch);
+    }
+}
+
 u32 BytesPerPixel(TextureFormat format) {
     switch (format) {
     case TextureFormat::DXT1:
@@ -86,6 +251,21 @@ u32 BytesPerPixel(TextureFormat format) {
     }
 }
 
+size_t CalculateBlockLinearSize(u32 width, u32 height, u32 bytes_per_pixel, u32 block_height) {
+    const u32 width_in_gobs{(width * bytes_per_pixel + GOB_SIZE_X - 1) / GOB_SIZE_X};
+    const u32 block_height_in_rows{GOB_SIZE_Y * block_height};
+    const u32 height_in_blocks{(height + block_height_in_rows - 1) / block_height_in_rows};
+    return static_cast<size_t>(width_in_gobs) * height_in_blocks * block_height * GOB_SIZE;
+}
+
+u32 CalculateMipmapBlockHeight(u32 height, u32 block_height) {
+    // The hardware halves the block height of a level as long as half a block still covers it
+    while (block_height > 1 && height <= (block_height / 2) * GOB_SIZE_Y) {
+        block_height /= 2;
+    }
+    return block_height;
+}
+
 std::vector<u8> UnswizzleTexture(VAddr address, u32 tile_size, u32 bytes_per_pixel, u32 width,
                                  u32 height, u32 block_height) {
     std::vector<u8> unswizzled_data(width * height * bytes_per_pixel);
@@ -6,6 +6,7 @@
 
 #include <vector>
 #include "common/common_types.h"
+#include "video_core/gpu.h"
 #include "video_core/textures/texture.h"
 
 namespace Tegra::Texture {
@@ -26,6 +27,37 @@ std::vector<u8> UnswizzleDepthTexture(VAddr address, DepthFormat format, u32 wid
 void CopySwizzledData(u32 width, u32 height, u32 bytes_per_pixel, u32 out_bytes_per_pixel,
                       u8* swizzled_data, u8* unswizzled_data, bool unswizzle, u32 block_height);
 
+/**
+ * Copies a width x height rectangle of pixels between a block linear surface and a pitch linear
+ * buffer, swizzling or unswizzling as requested.
+ * @param swizzled_data Start of the block linear surface.
+ * @param surface_width Width of the whole block linear surface, in pixels.
+ * @param surface_height Height of the whole block linear surface, in pixels.
+ * @param block_height Height of a block, in GOBs.
+ * @param block_depth Depth of a block, in GOBs. Only 3D surfaces use values other than 1.
+ * @param origin_x, origin_y, origin_z Position of the rectangle within the swizzled surface.
+ * @param linear_data Start of the rectangle in the linear buffer.
+ * @param linear_pitch Distance between two lines of the linear buffer, in bytes.
+ * @param unswizzle Whether to copy from the surface into the linear buffer or the other way round.
+ */
+void CopyBlockLinearRect(u32 width, u32 height, u32 bytes_per_pixel, u8* swizzled_data,
+                         u32 surface_width, u32 surface_height, u32 block_height, u32 block_depth,
+                         u32 origin_x, u32 origin_y, u32 origin_z, u8* linear_data,
+                         u32 linear_pitch, bool unswizzle);
+
+/**
+ * Returns the size in bytes of a block linear surface, which is padded to whole blocks.
+ * @param width, height Size of the surface, in elements (pixels, or blocks for compressed formats).
+ * @param block_height Height of a block, in GOBs.
+ */
+size_t CalculateBlockLinearSize(u32 width, u32 height, u32 bytes_per_pixel, u32 block_height);
+
+/**
+ * Returns the block height, in GOBs, of a mipmap level that is height elements high, given the
+ * block height of the surface it belongs to.
+ */
+u32 CalculateMipmapBlockHeight(u32 height, u32 block_height);
+
 /**
  * Decodes an unswizzled texture into a A8R8G8B8 texture.
  */
@@ -165,6 +165,8 @@ struct TICEntry {
 
         // High 16 bits of the pitch value
         BitField<0, 16, u32> pitch_high;
+
+        BitField<28, 4, u32> max_mip_level;
     };
     union {
         BitField<0, 16, u32> width_minus_1;
@@ -199,6 +201,13 @@ struct TICEntry {
         return 1 << block_height;
     }
 
+    u32 NumMipLevels() const {
+        if (texture_type == TextureType::Texture2DNoMipmap) {
+            return 1;
+        }
+        return max_mip_level + 1;
+    }
+
     bool IsTiled() const {
         return header_version == TICHeaderVersion::BlockLinear ||
                header_version == TICHeaderVersion::BlockLinearColorKey;
@@ -3,6 +3,8 @@
 // Refer to the license.txt file included.
 
 #include <memory>
+#include "common/logging/log.h"
+#include "core/settings.h"
 #include "video_core/renderer_base.h"
 #include "video_core/renderer_opengl/renderer_opengl.h"
 #include "video_core/video_core.h"
@@ -10,7 +12,14 @@
 namespace VideoCore {
 
 std::unique_ptr<RendererBase> CreateRenderer(Core::Frontend::EmuWindow& emu_window) {
-    return std::make_unique<OpenGL::RendererOpenGL>(emu_window);
+    switch (Settings::values.renderer_backend) {
+    case Settings::RendererBackend::OpenGL:
+        return std::make_unique<OpenGL::RendererOpenGL>(emu_window);
+    default:
+        LOG_ERROR(HW_GPU, "Unknown renderer backend {}, using OpenGL",
+                  static_cast<u32>(Settings::values.renderer_backend));
+        return std::make_unique<OpenGL::RendererOpenGL>(emu_window);
+    }
 }
 
 } // namespace VideoCore
@@ -15,7 +15,7 @@ namespace VideoCore {
 class RendererBase;
 
 /**
- * Creates a renderer instance.
+ * Creates a renderer instance for the backend selected in the settings.
  *
  * @note The returned renderer instance is simply allocated. Its Init()
  *       function still needs to be called to fully complete its setup.
@@ -1,11 +1,14 @@
 #include <QApplication>
 #include <QHBoxLayout>
 #include <QKeyEvent>
+#include <QOffscreenSurface>
+#include <QOpenGLContext>
 #include <QScreen>
 #include <QWindow>
 
 #include <fmt/format.h>
 
+#include "common/logging/log.h"
 #include "common/microprofile.h"
 #include "common/scm_rev.h"
 #include "common/string_util.h"
@@ -28,38 +31,56 @@ void EmuThread::run() {
     MicroProfileOnThreadCreate("EmuThread");
 
     stop_run = false;
+    Core::System& system = Core::System::GetInstance();
 
-    // holds whether the cpu was running during the last iteration,
-    // so that the DebugModeLeft signal can be emitted before the
-    // next execution step
+    // Holds whether the CPU ran since DebugModeEntered was last emitted, so that the
+    // DebugModeLeft signal is only emitted when execution actually resumes
     bool was_active = false;
+    std::vector<std::function<void()>> pending_tasks;
     while (!stop_run) {
+        control_requested.exchange(false, std::memory_order_acquire);
+
+        {
+            std::lock_guard<std::mutex> lock(running_mutex);
+            pending_tasks.swap(tasks);
+        }
+        for (auto& task : pending_tasks) {
+            task();
+        }
+        pending_tasks.clear();
+
         if (running) {
             if (!was_active)
                 emit DebugModeLeft();
-
-            Core::System::ResultStatus result = Core::System::GetInstance().RunLoop();
-            if (result != Core::System::ResultStatus::Success) {
-                this->SetRunning(false);
-                emit ErrorThrown(result, Core::System::GetInstance().GetStatusDetails());
+            was_active = true;
+
+            // Run slices back to back, until the state of the thread is changed from outside
+            while (!control_requested.load(std::memory_order_relaxed)) {
+                const Core::System::ResultStatus result = system.RunLoop();
+                if (result != Core::System::ResultStatus::Success) {
+                    this->SetRunning(false);
+                    emit ErrorThrown(result, system.GetStatusDetails());
+                }
             }
-
-            was_active = running || exec_step;
-            if (!was_active && !stop_run)
-                emit DebugModeEntered();
         } else if (exec_step) {
             if (!was_active)
                 emit DebugModeLeft();
 
             exec_step = false;
-            Core::System::GetInstance().SingleStep();
+            system.SingleStep();
             emit DebugModeEntered();
             yieldCurrentThread();
 
             was_active = false;
         } else {
+            if (was_active) {
+                emit DebugModeEntered();
+                was_active = false;
+            }
+
             std::unique_lock<std::mutex> lock(running_mutex);
-            running_cv.wait(lock, [this] { return IsRunning() || exec_step || stop_run; });
+            running_cv.wait(
+                lock, [this] { return IsRunning() || exec_step || stop_run || !tasks.empty(); });
         }
     }
 
@@ -104,6 +125,78 @@ private:
     bool do_painting;
 };
 
+/// How long the present thread waits for a frame before checking whether it should stop
+constexpr std::chrono::milliseconds PRESENT_TIMEOUT{50};
+
+PresentThread::PresentThread(GGLWidgetInternal* widget) : widget(widget) {}
+
+void PresentThread::run() {
+    MicroProfileOnThreadCreate("PresentThread");
+
+    widget->makeCurrent();
+
+    std::shared_ptr<Core::Frontend::FrameMailbox> current;
+    while (true) {
+        std::shared_ptr<Core::Frontend::FrameMailbox> latest;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            mailbox_changed.wait(lock, [this, &current] { return stop || mailbox || current; });
+            if (stop) {
+                break;
+            }
+            latest = mailbox;
+        }
+
+        if (latest != current) {
+            if (current) {
+                current->ReleasePresentResources();
+            }
+            current = std::move(latest);
+            continue;
+        }
+
+        if (current->TryPresent(PRESENT_TIMEOUT)) {
+            // In our multi-threaded QGLWidget use case we shouldn't need to call `makeCurrent`,
+            // since we never call `doneCurrent` in this thread.
+            // However:
+            // - The Qt debug runtime prints a bogus warning on the console if `makeCurrent`
+            // wasn't called since the last time `swapBuffers` was executed;
+            // - On macOS, if `makeCurrent` isn't called explicitely, resizing the buffer breaks.
+            widget->makeCurrent();
+
+            widget->swapBuffers();
+        }
+    }
+
+    if (current) {
+        current->ReleasePresentResources();
+        current.reset();
+    }
+
+#if MICROPROFILE_ENABLED
+    MicroProfileOnThreadExit();
+#endif
+
+    widget->doneCurrent();
+    widget->context()->moveToThread(qApp->thread());
+}
+
+void PresentThread::SetMailbox(std::shared_ptr<Core::Frontend::FrameMailbox> mailbox) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        this->mailbox = std::move(mailbox);
+    }
+    mailbox_changed.notify_all();
+}
+
+void PresentThread::RequestStop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stop = true;
+    }
+    mailbox_changed.notify_all();
+}
+
 GRenderWindow::GRenderWindow(QWidget* parent, EmuThread* emu_thread)
     : QWidget(parent), child(nullptr), emu_thread(emu_thread) {
 
@@ -115,6 +208,10 @@ GRenderWindow::GRenderWindow(QWidget* parent, EmuThread* emu_thread)
 }
 
 GRenderWindow::~GRenderWindow() {
+    if (present_thread) {
+        present_thread->RequestStop();
+        present_thread->wait();
+    }
     InputCommon::Shutdown();
 }
 
@@ -126,31 +223,31 @@ void GRenderWindow::moveContext() {
     auto thread = (QThread::currentThread() == qApp->thread() && emu_thread != nullptr)
                       ? emu_thread
                       : qApp->thread();
-    child->context()->moveToThread(thread);
+    shared_context->moveToThread(thread);
 }
 
 void GRenderWindow::SwapBuffers() {
-    // In our multi-threaded QGLWidget use case we shouldn't need to call `makeCurrent`,
-    // since we never call `doneCurrent` in this thread.
-    // However:
-    // - The Qt debug runtime prints a bogus warning on the console if `makeCurrent` wasn't called
-    // since the last time `swapBuffers` was executed;
-    // - On macOS, if `makeCurrent` isn't called explicitely, resizing the buffer breaks.
-    child->makeCurrent();
-
-    child->swapBuffers();
+    // Never called, the renderer hands its frames to the present thread instead
 }
 
 void GRenderWindow::MakeCurrent() {
-    child->makeCurrent();
+    shared_context->makeCurrent(offscreen_surface.get());
 }
 
 void GRenderWindow::DoneCurrent() {
-    child->doneCurrent();
+    shared_context->doneCurrent();
 }
 
 void GRenderWindow::PollEvents() {}
 
+bool GRenderWindow::HasPresentationThread() const {
+    return true;
+}
+
+void GRenderWindow::SetFrameMailbox(std::shared_ptr<Core::Frontend::FrameMailbox> mailbox) {
+    present_thread->SetMailbox(std::move(mailbox));
+}
+
 // On Qt 5.0+, this correctly gets the size of the framebuffer (pixels).
 //
 // Older versions get the window size (density independent pixels),
@@ -243,6 +340,11 @@ void GRenderWindow::OnClientAreaResized(unsigned width, unsigned height) {
 }
 
 void GRenderWindow::InitRenderTarget() {
+    // The previous session's present thread was stopped with the emulation, it owns no context
+    present_thread.reset();
+    offscreen_surface.reset();
+    shared_context.reset();
+
     if (child) {
         delete child;
     }
@@ -260,7 +362,25 @@ void GRenderWindow::InitRenderTarget() {
     // Requests a forward-compatible context, which is required to get a 3.2+ context on OS X
     fmt.setOption(QGL::NoDeprecatedFunctions);
 
+    // Qt has no way to request adaptive v-sync, so relaxed FIFO falls back to regular v-sync
+    fmt.setSwapInterval(Settings::values.present_mode == Settings::PresentMode::Immediate ? 0 : 1);
+
     child = new GGLWidgetInternal(fmt, this);
+
+    // The renderer draws with a context of its own that shares objects with the widget's, which
+    // only the present thread makes current while emulation runs
+    QOpenGLContext* widget_context = child->context()->contextHandle();
+    shared_context = std::make_unique<QOpenGLContext>();
+    shared_context->setFormat(widget_context->format());
+    shared_context->setShareContext(widget_context);
+    if (!shared_context->create()) {
+        LOG_CRITICAL(Frontend, "Failed to create an OpenGL context shared with the render window");
+    }
+    offscreen_surface = std::make_unique<QOffscreenSurface>();
+    offscreen_surface->setFormat(shared_context->format());
+    offscreen_surface->create();
+    present_thread = std::make_unique<PresentThread>(child);
+
     QBoxLayout* layout = new QHBoxLayout(this);
 
     resize(Layout::ScreenUndocked::Width, Layout::ScreenUndocked::Height);
@@ -284,10 +404,18 @@ void GRenderWindow::OnMinimalClientAreaChangeRequest(
 void GRenderWindow::OnEmulationStarting(EmuThread* emu_thread) {
     this->emu_thread = emu_thread;
     child->DisablePainting();
+
+    child->doneCurrent();
+    child->context()->moveToThread(present_thread.get());
+    present_thread->start();
 }
 
 void GRenderWindow::OnEmulationStopping() {
     emu_thread = nullptr;
+
+    present_thread->RequestStop();
+    present_thread->wait();
+
     child->EnablePainting();
 }
 
@@ -6,7 +6,10 @@
 
 #include <atomic>
 #include <condition_variable>
+#include <functional>
+#include <memory>
 #include <mutex>
+#include <vector>
 #include <QGLWidget>
 #include <QThread>
 #include "common/thread.h"
@@ -14,6 +17,8 @@
 #include "core/frontend/emu_window.h"
 
 class QKeyEvent;
+class QOffscreenSurface;
+class QOpenGLContext;
 class QScreen;
 
 class GGLWidgetInternal;
@@ -37,8 +42,10 @@ public:
      * @note This function is thread-safe
      */
     void ExecStep() {
+        std::unique_lock<std::mutex> lock(running_mutex);
         exec_step = true;
-        running_cv.notify_all();
+        lock.unlock();
+        RequestControl();
     }
 
     /**
@@ -50,7 +57,7 @@ public:
         std::unique_lock<std::mutex> lock(running_mutex);
         this->running = running;
         lock.unlock();
-        running_cv.notify_all();
+        RequestControl();
     }
 
     /**
@@ -70,12 +77,34 @@ public:
         SetRunning(false);
     }
 
+    /**
+     * Runs a function on the emulation thread after its current slice, where it can access
+     * emulated state while the game keeps running. Tasks pending when emulation stops are dropped.
+     * @note This function is thread-safe
+     */
+    void RunBetweenSlices(std::function<void()> task) {
+        std::unique_lock<std::mutex> lock(running_mutex);
+        tasks.push_back(std::move(task));
+        lock.unlock();
+        RequestControl();
+    }
+
 private:
-    bool exec_step = false;
-    bool running = false;
+    /// Makes the emulation thread pick up the changes to its state after its current slice
+    void RequestControl() {
+        control_requested.store(true, std::memory_order_release);
+        running_cv.notify_all();
+    }
+
+    std::atomic<bool> exec_step{false};
+    std::atomic<bool> running{false};
     std::atomic<bool> stop_run{false};
+    /// Set whenever the state above changes, the only thing checked between slices while running
+    std::atomic<bool> control_requested{false};
     std::mutex running_mutex;
     std::condition_variable running_cv;
+    /// Functions passed to RunBetweenSlices, guarded by running_mutex
+    std::vector<std::function<void()>> tasks;
 
     GRenderWindow* render_window;
 
@@ -101,6 +130,40 @@ signals:
     void ErrorThrown(Core::System::ResultStatus, std::string);
 };
 
+/**
+ * Thread owning the context of the render window's widget, which shows the frames the renderer
+ * hands over through its mailbox. Waiting for the buffer swaps here keeps vsync and the window
+ * system from stalling the emulation thread, which renders into a shared offscreen context.
+ */
+class PresentThread : public QThread {
+    Q_OBJECT
+
+public:
+    explicit PresentThread(GGLWidgetInternal* widget);
+
+    void run() override;
+
+    /**
+     * Sets the mailbox frames are taken from, or null to present nothing until another is set
+     * @note This function is thread-safe
+     */
+    void SetMailbox(std::shared_ptr<Core::Frontend::FrameMailbox> mailbox);
+
+    /**
+     * Requests for the thread to stop, it hands the widget's context back to the GUI thread
+     * @note This function is thread-safe
+     */
+    void RequestStop();
+
+private:
+    GGLWidgetInternal* widget;
+
+    std::mutex mutex;
+    std::condition_variable mailbox_changed;
+    std::shared_ptr<Core::Frontend::FrameMailbox> mailbox;
+    bool stop = false;
+};
+
 class GRenderWindow : public QWidget, public Core::Frontend::EmuWindow {
     Q_OBJECT
 
@@ -113,6 +176,8 @@ public:
     void MakeCurrent() override;
     void DoneCurrent() override;
     void PollEvents() override;
+    bool HasPresentationThread() const override;
+    void SetFrameMailbox(std::shared_ptr<Core::Frontend::FrameMailbox> mailbox) override;
 
     void BackupGeometry();
     void RestoreGeometry();
@@ -153,6 +218,11 @@ private:
 
     GGLWidgetInternal* child;
 
+    /// Context the renderer uses on the emulation thread, shared with the widget's
+    std::unique_ptr<QOpenGLContext> shared_context;
+    std::unique_ptr<QOffscreenSurface> offscreen_surface;
+    std::unique_ptr<PresentThread> present_thread;
+
     QByteArray geometry;
 
     EmuThread* emu_thread;
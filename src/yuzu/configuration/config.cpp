@@ -79,14 +79,27 @@ void Config::ReadValues() {
     qt_config->beginGroup("Core");
     Settings::values.use_cpu_jit = qt_config->value("use_cpu_jit", true).toBool();
     Settings::values.use_multi_core = qt_config->value("use_multi_core", false).toBool();
+    Settings::values.pin_cpu_core_threads =
+        qt_config->value("pin_cpu_core_threads", false).toBool();
     qt_config->endGroup();
 
     qt_config->beginGroup("Renderer");
+    Settings::values.renderer_backend = static_cast<Settings::RendererBackend>(
+        qt_config->value("renderer_backend", static_cast<u32>(Settings::RendererBackend::OpenGL))
+            .toUInt());
     Settings::values.resolution_factor = qt_config->value("resolution_factor", 1.0).toFloat();
     Settings::values.use_frame_limit = qt_config->value("use_frame_limit", true).toBool();
     Settings::values.frame_limit = qt_config->value("frame_limit", 100).toInt();
     Settings::values.use_accurate_framebuffers =
         qt_config->value("use_accurate_framebuffers", false).toBool();
+    Settings::values.max_surface_cache_size =
+        qt_config->value("max_surface_cache_size", 1024).toUInt();
+    Settings::values.use_disk_shader_cache =
+        qt_config->value("use_disk_shader_cache", true).toBool();
+    Settings::values.use_asynchronous_shaders =
+        qt_config->value("use_asynchronous_shaders", false).toBool();
+    Settings::values.present_mode = static_cast<Settings::PresentMode>(
+        qt_config->value("present_mode", static_cast<u32>(Settings::PresentMode::Fifo)).toUInt());
 
     Settings::values.bg_red = qt_config->value("bg_red", 0.0).toFloat();
     Settings::values.bg_green = qt_config->value("bg_green", 0.0).toFloat();
@@ -98,10 +111,18 @@ void Config::ReadValues() {
     Settings::values.audio_device_id =
         qt_config->value("output_device", "auto").toString().toStdString();
     Settings::values.volume = qt_config->value("volume", 1).toFloat();
+    Settings::values.enable_audio_stretching =
+        qt_config->value("enable_audio_stretching", true).toBool();
+    Settings::values.audio_sink_latency = qt_config->value("sink_latency", 512).toUInt();
+    Settings::values.audio_mix_quantum = qt_config->value("mix_quantum", 512).toUInt();
+    Settings::values.audio_queue_depth = qt_config->value("queue_depth", 3).toUInt();
     qt_config->endGroup();
 
     qt_config->beginGroup("Data Storage");
     Settings::values.use_virtual_sd = qt_config->value("use_virtual_sd", true).toBool();
+    Settings::values.decrypted_cache_size =
+        qt_config->value("decrypted_cache_size", 64).toUInt();
+    Settings::values.verify_nca_hashes = qt_config->value("verify_nca_hashes", false).toBool();
     qt_config->endGroup();
 
     qt_config->beginGroup("System");
@@ -118,6 +139,10 @@ void Config::ReadValues() {
     qt_config->beginGroup("Debugging");
     Settings::values.use_gdbstub = qt_config->value("use_gdbstub", false).toBool();
     Settings::values.gdbstub_port = qt_config->value("gdbstub_port", 24689).toInt();
+    Settings::values.record_trace = qt_config->value("record_trace", false).toBool();
+    Settings::values.memory_log_interval = qt_config->value("memory_log_interval", 0).toUInt();
+    Settings::values.validate_warm_restart =
+        qt_config->value("validate_warm_restart", true).toBool();
     qt_config->endGroup();
 
     qt_config->beginGroup("UI");
@@ -200,13 +225,19 @@ void Config::SaveValues() {
     qt_config->beginGroup("Core");
     qt_config->setValue("use_cpu_jit", Settings::values.use_cpu_jit);
     qt_config->setValue("use_multi_core", Settings::values.use_multi_core);
+    qt_config->setValue("pin_cpu_core_threads", Settings::values.pin_cpu_core_threads);
     qt_config->endGroup();
 
     qt_config->beginGroup("Renderer");
+    qt_config->setValue("renderer_backend", static_cast<u32>(Settings::values.renderer_backend));
     qt_config->setValue("resolution_factor", (double)Settings::values.resolution_factor);
     qt_config->setValue("use_frame_limit", Settings::values.use_frame_limit);
     qt_config->setValue("frame_limit", Settings::values.frame_limit);
     qt_config->setValue("use_accurate_framebuffers", Settings::values.use_accurate_framebuffers);
+    qt_config->setValue("max_surface_cache_size", Settings::values.max_surface_cache_size);
+    qt_config->setValue("use_disk_shader_cache", Settings::values.use_disk_shader_cache);
+    qt_config->setValue("use_asynchronous_shaders", Settings::values.use_asynchronous_shaders);
+    qt_config->setValue("present_mode", static_cast<u32>(Settings::values.present_mode));
 
     // Cast to double because Qt's written float values are not human-readable
     qt_config->setValue("bg_red", (double)Settings::values.bg_red);
@@ -218,10 +249,16 @@ void Config::SaveValues() {
     qt_config->setValue("output_engine", QString::fromStdString(Settings::values.sink_id));
     qt_config->setValue("output_device", QString::fromStdString(Settings::values.audio_device_id));
     qt_config->setValue("volume", Settings::values.volume);
+    qt_config->setValue("enable_audio_stretching", Settings::values.enable_audio_stretching);
+    qt_config->setValue("sink_latency", Settings::values.audio_sink_latency);
+    qt_config->setValue("mix_quantum", Settings::values.audio_mix_quantum);
+    qt_config->setValue("queue_depth", Settings::values.audio_queue_depth);
     qt_config->endGroup();
 
     qt_config->beginGroup("Data Storage");
     qt_config->setValue("use_virtual_sd", Settings::values.use_virtual_sd);
+    qt_config->setValue("decrypted_cache_size", Settings::values.decrypted_cache_size);
+    qt_config->setValue("verify_nca_hashes", Settings::values.verify_nca_hashes);
     qt_config->endGroup();
 
     qt_config->beginGroup("System");
@@ -238,6 +275,9 @@ void Config::SaveValues() {
     qt_config->beginGroup("Debugging");
     qt_config->setValue("use_gdbstub", Settings::values.use_gdbstub);
     qt_config->setValue("gdbstub_port", Settings::values.gdbstub_port);
+    qt_config->setValue("record_trace", Settings::values.record_trace);
+    qt_config->setValue("memory_log_interval", Settings::values.memory_log_interval);
+    qt_config->setValue("validate_warm_restart", Settings::values.validate_warm_restart);
     qt_config->endGroup();
 
     qt_config->beginGroup("UI");
@@ -292,7 +332,10 @@ void Config::Reload() {
 }
 
 void Config::Save() {
+    // The global config keeps the global values of the settings a running title overrides
+    Settings::SwapGlobalValues();
     SaveValues();
+    Settings::SwapGlobalValues();
 }
 
 Config::~Config() {
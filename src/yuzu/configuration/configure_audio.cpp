@@ -61,6 +61,7 @@ void ConfigureAudio::setConfiguration() {
 
     ui->volume_slider->setValue(Settings::values.volume * ui->volume_slider->maximum());
     ui->volume_indicator->setText(tr("%1 %").arg(ui->volume_slider->sliderPosition()));
+    ui->toggle_audio_stretching->setChecked(Settings::values.enable_audio_stretching);
 }
 
 void ConfigureAudio::applyConfiguration() {
@@ -72,6 +73,7 @@ void ConfigureAudio::applyConfiguration() {
             .toStdString();
     Settings::values.volume =
         static_cast<float>(ui->volume_slider->sliderPosition()) / ui->volume_slider->maximum();
+    Settings::values.enable_audio_stretching = ui->toggle_audio_stretching->isChecked();
 }
 
 void ConfigureAudio::updateAudioDevices(int sink_index) {
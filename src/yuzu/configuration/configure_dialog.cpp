@@ -27,5 +27,8 @@ void ConfigureDialog::applyConfiguration() {
     ui->graphicsTab->applyConfiguration();
     ui->audioTab->applyConfiguration();
     ui->debugTab->applyConfiguration();
+    // The tabs show the running title's overrides in place of the global values they replace.
+    // Changes to those settings apply to the running title only, Config::Save writes the global
+    // values back.
     Settings::Apply();
 }
@@ -6,6 +6,7 @@
 #include <QComboBox>
 #include <QDebug>
 #include <QFileDialog>
+#include <QImage>
 #include <QLabel>
 #include <QMouseEvent>
 #include <QPushButton>
@@ -14,6 +15,8 @@
 #include "core/core.h"
 #include "video_core/engines/maxwell_3d.h"
 #include "video_core/gpu.h"
+#include "video_core/rasterizer_interface.h"
+#include "video_core/renderer_base.h"
 #include "video_core/textures/decoders.h"
 #include "video_core/textures/texture.h"
 #include "video_core/utils.h"
@@ -155,6 +158,8 @@ GraphicsSurfaceWidget::GraphicsSurfaceWidget(std::shared_ptr<Tegra::DebugContext
 
     // Connections
     connect(this, &GraphicsSurfaceWidget::Update, this, &GraphicsSurfaceWidget::OnUpdate);
+    connect(this, &GraphicsSurfaceWidget::CachedSurfaceRead, this,
+            &GraphicsSurfaceWidget::OnCachedSurfaceRead, Qt::QueuedConnection);
     connect(surface_source_list,
             static_cast<void (QComboBox::*)(int)>(&QComboBox::currentIndexChanged), this,
             &GraphicsSurfaceWidget::OnSurfaceSourceChanged);
@@ -325,8 +330,6 @@ void GraphicsSurfaceWidget::Pick(int x, int y) {
 void GraphicsSurfaceWidget::OnUpdate() {
     auto& gpu = Core::System::GetInstance().GPU();
 
-    QPixmap pixmap;
-
     switch (surface_source) {
     case Source::RenderTarget0:
     case Source::RenderTarget1:
@@ -378,6 +381,46 @@ void GraphicsSurfaceWidget::OnUpdate() {
         return;
     }
 
+    // Prefer reading the surface back from the rasterizer cache, the host GPU converts it and it
+    // holds what was rendered but not flushed to memory yet. This has to happen on the thread
+    // halted at the breakpoint, which uses the rasterizer.
+    const quint64 request = ++surface_request;
+    const auto context = context_weak.lock();
+    const Tegra::GPUVAddr address = surface_address;
+    const u32 width = surface_width;
+    const u32 height = surface_height;
+    if (context && context->RunAtBreakpoint([this, request, address, width, height] {
+            auto& rasterizer = Core::System::GetInstance().Renderer().Rasterizer();
+            std::vector<u8> pixels;
+            if (!rasterizer.ReadCachedSurface(address, width, height, pixels)) {
+                emit CachedSurfaceRead(request, false, {});
+                return;
+            }
+            const QImage image(pixels.data(), static_cast<int>(width), static_cast<int>(height),
+                               QImage::Format_RGBA8888);
+            emit CachedSurfaceRead(request, true, image.copy());
+        })) {
+        return;
+    }
+
+    DecodeSurface();
+}
+
+void GraphicsSurfaceWidget::OnCachedSurfaceRead(quint64 request, bool cached, QImage image) {
+    // Another surface was selected in the meantime
+    if (request != surface_request)
+        return;
+
+    if (cached) {
+        ShowSurface(image);
+    } else {
+        DecodeSurface();
+    }
+}
+
+void GraphicsSurfaceWidget::DecodeSurface() {
+    auto& gpu = Core::System::GetInstance().GPU();
+
     // TODO: Implement a good way to visualize alpha components!
 
     QImage decoded_image(surface_width, surface_height, QImage::Format_ARGB32);
@@ -391,20 +434,25 @@ void GraphicsSurfaceWidget::OnUpdate() {
     auto texture_data = Tegra::Texture::DecodeTexture(unswizzled_data, surface_format,
                                                       surface_width, surface_height);
 
-    surface_picture_label->show();
-
     for (unsigned int y = 0; y < surface_height; ++y) {
         for (unsigned int x = 0; x < surface_width; ++x) {
+            const std::size_t offset = (x + y * surface_width) * 4;
             Math::Vec4<u8> color;
-            color[0] = texture_data[x + y * surface_width + 0];
-            color[1] = texture_data[x + y * surface_width + 1];
-            color[2] = texture_data[x + y * surface_width + 2];
-            color[3] = texture_data[x + y * surface_width + 3];
+            color[0] = texture_data[offset + 0];
+            color[1] = texture_data[offset + 1];
+            color[2] = texture_data[offset + 2];
+            color[3] = texture_data[offset + 3];
             decoded_image.setPixel(x, y, qRgba(color.r(), color.g(), color.b(), color.a()));
         }
     }
 
-    pixmap = QPixmap::fromImage(decoded_image);
+    ShowSurface(decoded_image);
+}
+
+void GraphicsSurfaceWidget::ShowSurface(const QImage& image) {
+    surface_picture_label->show();
+
+    const QPixmap pixmap = QPixmap::fromImage(image);
     surface_picture_label->setPixmap(pixmap);
     surface_picture_label->resize(pixmap.size());
 
@@ -68,10 +68,22 @@ public slots:
 signals:
     void Update();
 
+    /**
+     * Emitted on the thread halted at the breakpoint with the surface read back from the
+     * rasterizer cache, or with cached unset if it has to be decoded from memory instead
+     */
+    void CachedSurfaceRead(quint64 request, bool cached, QImage image);
+
 private:
     void OnBreakPointHit(Tegra::DebugContext::Event event, void* data) override;
     void OnResumed() override;
 
+    void OnCachedSurfaceRead(quint64 request, bool cached, QImage image);
+
+    /// Unswizzles and decodes the surface from Switch memory on the CPU
+    void DecodeSurface();
+    void ShowSurface(const QImage& image);
+
     void SaveSurface();
 
     QComboBox* surface_source_list;
@@ -93,4 +105,7 @@ private:
     Tegra::Texture::TextureFormat surface_format;
     int surface_picker_x = 0;
     int surface_picker_y = 0;
+
+    /// Incremented for every surface shown, so that readbacks finishing late are discarded
+    quint64 surface_request = 0;
 };
@@ -0,0 +1,114 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <chrono>
+#include <QHeaderView>
+#include <QPushButton>
+#include <QStandardItemModel>
+#include <QTreeView>
+#include <QVBoxLayout>
+#include "core/hle/service/ipc_profiler.h"
+#include "yuzu/debugger/ipc_profiler.h"
+
+namespace {
+constexpr int REFRESH_INTERVAL_MS = 1000;
+
+enum Column {
+    COLUMN_SERVICE,
+    COLUMN_COMMAND,
+    COLUMN_CALLS,
+    COLUMN_TOTAL,
+    COLUMN_MEAN,
+    COLUMN_MAX,
+    COLUMN_P99,
+    COLUMN_COUNT,
+};
+
+/// Makes an item sorted by value rather than by its text
+QStandardItem* CreateNumberItem(double value, int precision) {
+    auto* item = new QStandardItem(QString::number(value, 'f', precision));
+    item->setData(value, Qt::UserRole);
+    item->setTextAlignment(Qt::AlignRight | Qt::AlignVCenter);
+    return item;
+}
+} // Anonymous namespace
+
+IPCProfilerWidget::IPCProfilerWidget(QWidget* parent) : QDockWidget(tr("IPC Profiler"), parent) {
+    setObjectName("IPCProfilerWidget");
+
+    model = new QStandardItemModel(0, COLUMN_COUNT, this);
+    model->setHorizontalHeaderLabels({tr("Service"), tr("Command"), tr("Calls"), tr("Total (ms)"),
+                                      tr("Mean (us)"), tr("Max (us)"), tr("p99 (us)")});
+    model->setSortRole(Qt::UserRole);
+
+    view = new QTreeView;
+    view->setModel(model);
+    view->setRootIsDecorated(false);
+    view->setSortingEnabled(true);
+    view->sortByColumn(COLUMN_TOTAL, Qt::DescendingOrder);
+    view->header()->setSectionResizeMode(QHeaderView::ResizeToContents);
+
+    auto* reset_button = new QPushButton(tr("Reset"));
+    connect(reset_button, &QPushButton::clicked, this, &IPCProfilerWidget::Reset);
+
+    auto* layout = new QVBoxLayout;
+    layout->addWidget(view);
+    layout->addWidget(reset_button);
+
+    auto* main_widget = new QWidget;
+    main_widget->setLayout(layout);
+    setWidget(main_widget);
+
+    refresh_timer.setInterval(REFRESH_INTERVAL_MS);
+    connect(&refresh_timer, &QTimer::timeout, this, &IPCProfilerWidget::Refresh);
+}
+
+IPCProfilerWidget::~IPCProfilerWidget() = default;
+
+void IPCProfilerWidget::showEvent(QShowEvent* ev) {
+    Refresh();
+    refresh_timer.start();
+    QDockWidget::showEvent(ev);
+}
+
+void IPCProfilerWidget::hideEvent(QHideEvent* ev) {
+    refresh_timer.stop();
+    QDockWidget::hideEvent(ev);
+}
+
+void IPCProfilerWidget::Refresh() {
+    using namespace std::chrono;
+
+    model->removeRows(0, model->rowCount());
+    for (const auto& command : Service::IPCProfiler::GetStats()) {
+        const double total_us = command.total_time.count() / 1000.0;
+        const QString command_text =
+            command.command_name.empty()
+                ? QString::number(command.command)
+                : QStringLiteral("%1 (%2)")
+                      .arg(QString::fromStdString(command.command_name))
+                      .arg(command.command);
+
+        auto* service_item = new QStandardItem(QString::fromStdString(command.service_name));
+        service_item->setData(service_item->text(), Qt::UserRole);
+        auto* command_item = new QStandardItem(command_text);
+        command_item->setData(command.command, Qt::UserRole);
+
+        model->appendRow({
+            service_item,
+            command_item,
+            CreateNumberItem(static_cast<double>(command.calls), 0),
+            CreateNumberItem(total_us / 1000.0, 3),
+            CreateNumberItem(command.calls != 0 ? total_us / command.calls : 0.0, 1),
+            CreateNumberItem(command.max_time.count() / 1000.0, 1),
+            CreateNumberItem(static_cast<double>(command.GetPercentile(0.99).count()), 0),
+        });
+    }
+    model->sort(view->header()->sortIndicatorSection(), view->header()->sortIndicatorOrder());
+}
+
+void IPCProfilerWidget::Reset() {
+    Service::IPCProfiler::ResetStats();
+    Refresh();
+}
@@ -0,0 +1,35 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <QDockWidget>
+#include <QTimer>
+
+class QShowEvent;
+class QHideEvent;
+class QStandardItemModel;
+class QTreeView;
+
+/// Lists the call counts and host times of the commands of the HLE services
+class IPCProfilerWidget : public QDockWidget {
+    Q_OBJECT
+
+public:
+    explicit IPCProfilerWidget(QWidget* parent = nullptr);
+    ~IPCProfilerWidget() override;
+
+protected:
+    void showEvent(QShowEvent* ev) override;
+    void hideEvent(QHideEvent* ev) override;
+
+private:
+    /// Fills the rows with the current stats
+    void Refresh();
+    void Reset();
+
+    QTreeView* view;
+    QStandardItemModel* model;
+    QTimer refresh_timer;
+};
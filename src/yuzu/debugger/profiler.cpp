@@ -2,6 +2,7 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
 #include <QAction>
 #include <QLayout>
 #include <QMouseEvent>
@@ -43,6 +44,23 @@ private:
     qreal x_scale = 1.0, y_scale = 1.0;
 };
 
+/// Graphs of the values of the MicroProfile counters over the past frames, below the timers
+class MicroProfileCounterWidget : public QWidget {
+public:
+    explicit MicroProfileCounterWidget(QWidget* parent = nullptr);
+
+protected:
+    void paintEvent(QPaintEvent* ev) override;
+    void showEvent(QShowEvent* ev) override;
+    void hideEvent(QHideEvent* ev) override;
+
+private:
+    static constexpr int GRAPHS_PER_ROW = 4;
+    static constexpr int GRAPH_HEIGHT = 64;
+
+    QTimer update_timer;
+};
+
 #endif
 
 MicroProfileDialog::MicroProfileDialog(QWidget* parent) : QWidget(parent, Qt::Dialog) {
@@ -58,7 +76,9 @@ MicroProfileDialog::MicroProfileDialog(QWidget* parent) : QWidget(parent, Qt::Di
 
     QLayout* layout = new QVBoxLayout(this);
     layout->setContentsMargins(0, 0, 0, 0);
+    layout->setSpacing(0);
     layout->addWidget(widget);
+    layout->addWidget(new MicroProfileCounterWidget(this));
     setLayout(layout);
 
     // Configure focus so that widget is focusable and the dialog automatically forwards focus to
@@ -222,4 +242,67 @@ void MicroProfileDrawLine2D(u32 vertices_length, float* vertices, u32 hex_color)
     mp_painter->drawPolyline(point_buf.data(), vertices_length);
     point_buf.clear();
 }
+
+MicroProfileCounterWidget::MicroProfileCounterWidget(QWidget* parent) : QWidget(parent) {
+    const auto num_counters = static_cast<int>(Common::GetMicroProfileCounterHistories().size());
+    const int num_rows = (num_counters + GRAPHS_PER_ROW - 1) / GRAPHS_PER_ROW;
+    setFixedHeight(num_rows * GRAPH_HEIGHT);
+
+    connect(&update_timer, &QTimer::timeout, this,
+            static_cast<void (MicroProfileCounterWidget::*)()>(&MicroProfileCounterWidget::update));
+}
+
+void MicroProfileCounterWidget::paintEvent(QPaintEvent* ev) {
+    QPainter painter(this);
+    painter.fillRect(rect(), Qt::black);
+
+    QFont font = GetMonospaceFont();
+    font.setPixelSize(MICROPROFILE_TEXT_HEIGHT);
+    painter.setFont(font);
+
+    const int graph_width = width() / GRAPHS_PER_ROW;
+    const auto histories = Common::GetMicroProfileCounterHistories();
+    for (size_t i = 0; i < histories.size(); ++i) {
+        const auto& history = histories[i];
+        const QRect area(static_cast<int>(i % GRAPHS_PER_ROW) * graph_width,
+                         static_cast<int>(i / GRAPHS_PER_ROW) * GRAPH_HEIGHT, graph_width,
+                         GRAPH_HEIGHT);
+        const QRect graph = area.adjusted(4, MICROPROFILE_TEXT_HEIGHT + 4, -4, -4);
+        painter.setPen(QColor(64, 64, 64));
+        painter.drawRect(graph);
+
+        // Scale every graph to its own peak, which is shown in the title
+        const s64 peak = std::max<s64>(
+            *std::max_element(history.values.begin(), history.values.end()), 1);
+        const s64 current = history.values.back();
+
+        QPolygonF points;
+        for (size_t frame = 0; frame < history.values.size(); ++frame) {
+            const qreal x = graph.left() + graph.width() * qreal(frame) /
+                                               (Common::MICROPROFILE_COUNTER_HISTORY - 1);
+            const qreal y = graph.bottom() - graph.height() * qreal(history.values[frame]) / peak;
+            points.append(QPointF(x, y));
+        }
+        painter.setPen(QColor(100, 255, 100));
+        painter.drawPolyline(points);
+
+        painter.setPen(Qt::white);
+        painter.drawText(area.left() + 4, area.top() + MICROPROFILE_TEXT_HEIGHT,
+                         QStringLiteral("%1 %2: %3 (peak %4)")
+                             .arg(QString::fromUtf8(history.group))
+                             .arg(QString::fromUtf8(history.name))
+                             .arg(current)
+                             .arg(peak));
+    }
+}
+
+void MicroProfileCounterWidget::showEvent(QShowEvent* ev) {
+    update_timer.start(100);
+    QWidget::showEvent(ev);
+}
+
+void MicroProfileCounterWidget::hideEvent(QHideEvent* ev) {
+    update_timer.stop();
+    QWidget::hideEvent(ev);
+}
 #endif
@@ -2,6 +2,11 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
+#include <iterator>
+#include <tuple>
+#include <unordered_set>
+#include "yuzu/bootmanager.h"
 #include "yuzu/debugger/wait_tree.h"
 #include "yuzu/util/util.h"
 
@@ -10,10 +15,50 @@
 #include "core/hle/kernel/event.h"
 #include "core/hle/kernel/handle_table.h"
 #include "core/hle/kernel/mutex.h"
+#include "core/hle/kernel/process.h"
 #include "core/hle/kernel/thread.h"
 #include "core/hle/kernel/timer.h"
 #include "core/hle/kernel/wait_object.h"
 
+WaitTreeThreadSnapshot WaitTreeThreadSnapshot::Take(const Kernel::Thread& thread) {
+    return {thread.GetObjectId(), thread.GetName(), thread.status, thread.context.pc,
+            thread.context.cpu_registers[30]};
+}
+
+std::vector<WaitTreeThreadSnapshot> WaitTreeThreadSnapshot::TakeAll() {
+    std::vector<WaitTreeThreadSnapshot> snapshot;
+    for (std::size_t core = 0; core < Core::NUM_CPU_CORES; ++core) {
+        const auto& threads = Core::System::GetInstance().Scheduler(core)->GetThreadList();
+        snapshot.reserve(snapshot.size() + threads.size());
+        std::transform(threads.begin(), threads.end(), std::back_inserter(snapshot),
+                       [](const auto& thread) { return Take(*thread); });
+    }
+    return snapshot;
+}
+
+bool WaitTreeThreadSnapshot::operator==(const WaitTreeThreadSnapshot& other) const {
+    return std::tie(object_id, name, status, pc, lr) ==
+           std::tie(other.object_id, other.name, other.status, other.pc, other.lr);
+}
+
+bool WaitTreeThreadSnapshot::operator!=(const WaitTreeThreadSnapshot& other) const {
+    return !operator==(other);
+}
+
+/// Returns the live thread with the given object id, or nullptr if it's gone
+static const Kernel::Thread* FindThread(u32 object_id) {
+    for (std::size_t core = 0; core < Core::NUM_CPU_CORES; ++core) {
+        const auto& threads = Core::System::GetInstance().Scheduler(core)->GetThreadList();
+        const auto iter = std::find_if(threads.begin(), threads.end(), [object_id](const auto& t) {
+            return t->GetObjectId() == object_id;
+        });
+        if (iter != threads.end()) {
+            return iter->get();
+        }
+    }
+    return nullptr;
+}
+
 WaitTreeItem::~WaitTreeItem() = default;
 
 QColor WaitTreeItem::GetColor() const {
@@ -35,6 +80,11 @@ void WaitTreeItem::Expand() {
     }
 }
 
+void WaitTreeItem::Collapse() {
+    children.clear();
+    expanded = false;
+}
+
 WaitTreeItem* WaitTreeItem::Parent() const {
     return parent;
 }
@@ -51,25 +101,6 @@ std::size_t WaitTreeItem::Row() const {
     return row;
 }
 
-std::vector<std::unique_ptr<WaitTreeThread>> WaitTreeItem::MakeThreadItemList() {
-    std::vector<std::unique_ptr<WaitTreeThread>> item_list;
-    std::size_t row = 0;
-    auto add_threads = [&](const std::vector<Kernel::SharedPtr<Kernel::Thread>>& threads) {
-        for (std::size_t i = 0; i < threads.size(); ++i) {
-            item_list.push_back(std::make_unique<WaitTreeThread>(*threads[i]));
-            item_list.back()->row = row;
-            ++row;
-        }
-    };
-
-    add_threads(Core::System::GetInstance().Scheduler(0)->GetThreadList());
-    add_threads(Core::System::GetInstance().Scheduler(1)->GetThreadList());
-    add_threads(Core::System::GetInstance().Scheduler(2)->GetThreadList());
-    add_threads(Core::System::GetInstance().Scheduler(3)->GetThreadList());
-
-    return item_list;
-}
-
 WaitTreeText::WaitTreeText(const QString& t) : text(t) {}
 
 QString WaitTreeText::GetText() const {
@@ -79,7 +110,7 @@ QString WaitTreeText::GetText() const {
 WaitTreeMutexInfo::WaitTreeMutexInfo(VAddr mutex_address) : mutex_address(mutex_address) {
     mutex_value = Memory::Read32(mutex_address);
     owner_handle = static_cast<Kernel::Handle>(mutex_value & Kernel::Mutex::MutexOwnerMask);
-    owner = Kernel::g_handle_table.Get<Kernel::Thread>(owner_handle);
+    owner = Core::CurrentProcess()->handle_table.Get<Kernel::Thread>(owner_handle);
 }
 
 QString WaitTreeMutexInfo::GetText() const {
@@ -194,9 +225,13 @@ std::vector<std::unique_ptr<WaitTreeItem>> WaitTreeObjectList::GetChildren() con
 WaitTreeThread::WaitTreeThread(const Kernel::Thread& thread) : WaitTreeWaitObject(thread) {}
 
 QString WaitTreeThread::GetText() const {
-    const auto& thread = static_cast<const Kernel::Thread&>(object);
+    return GetSnapshotText(
+        WaitTreeThreadSnapshot::Take(static_cast<const Kernel::Thread&>(object)));
+}
+
+QString WaitTreeThread::GetSnapshotText(const WaitTreeThreadSnapshot& snapshot) {
     QString status;
-    switch (thread.status) {
+    switch (snapshot.status) {
     case ThreadStatus::Running:
         status = tr("running");
         break;
@@ -229,15 +264,21 @@ QString WaitTreeThread::GetText() const {
         status = tr("dead");
         break;
     }
+    QString object_info = tr("[%1]%2 %3")
+                              .arg(snapshot.object_id)
+                              .arg(QStringLiteral("Thread"), QString::fromStdString(snapshot.name));
     QString pc_info = tr(" PC = 0x%1 LR = 0x%2")
-                          .arg(thread.context.pc, 8, 16, QLatin1Char('0'))
-                          .arg(thread.context.cpu_registers[30], 8, 16, QLatin1Char('0'));
-    return WaitTreeWaitObject::GetText() + pc_info + " (" + status + ") ";
+                          .arg(snapshot.pc, 8, 16, QLatin1Char('0'))
+                          .arg(snapshot.lr, 8, 16, QLatin1Char('0'));
+    return object_info + pc_info + " (" + status + ") ";
 }
 
 QColor WaitTreeThread::GetColor() const {
-    const auto& thread = static_cast<const Kernel::Thread&>(object);
-    switch (thread.status) {
+    return GetStatusColor(static_cast<const Kernel::Thread&>(object).status);
+}
+
+QColor WaitTreeThread::GetStatusColor(ThreadStatus status) {
+    switch (status) {
     case ThreadStatus::Running:
         return QColor(Qt::GlobalColor::darkGreen);
     case ThreadStatus::Ready:
@@ -257,7 +298,7 @@ QColor WaitTreeThread::GetColor() const {
     case ThreadStatus::Dead:
         return QColor(Qt::GlobalColor::gray);
     default:
-        return WaitTreeItem::GetColor();
+        return QColor(Qt::GlobalColor::black);
     }
 }
 
@@ -309,6 +350,45 @@ std::vector<std::unique_ptr<WaitTreeItem>> WaitTreeThread::GetChildren() const {
     return list;
 }
 
+WaitTreeThreadRow::WaitTreeThreadRow(WaitTreeThreadSnapshot snapshot)
+    : snapshot(std::move(snapshot)) {}
+
+bool WaitTreeThreadRow::IsExpandable() const {
+    return expandable;
+}
+
+QString WaitTreeThreadRow::GetText() const {
+    return WaitTreeThread::GetSnapshotText(snapshot);
+}
+
+QColor WaitTreeThreadRow::GetColor() const {
+    return WaitTreeThread::GetStatusColor(snapshot.status);
+}
+
+std::vector<std::unique_ptr<WaitTreeItem>> WaitTreeThreadRow::GetChildren() const {
+    const Kernel::Thread* thread = FindThread(snapshot.object_id);
+    if (thread == nullptr) {
+        return {};
+    }
+    return WaitTreeThread(*thread).GetChildren();
+}
+
+const WaitTreeThreadSnapshot& WaitTreeThreadRow::GetSnapshot() const {
+    return snapshot;
+}
+
+bool WaitTreeThreadRow::SetSnapshot(WaitTreeThreadSnapshot new_snapshot) {
+    if (new_snapshot == snapshot) {
+        return false;
+    }
+    snapshot = std::move(new_snapshot);
+    return true;
+}
+
+void WaitTreeThreadRow::SetExpandable(bool expandable) {
+    this->expandable = expandable;
+}
+
 WaitTreeEvent::WaitTreeEvent(const Kernel::Event& object) : WaitTreeWaitObject(object) {}
 
 std::vector<std::unique_ptr<WaitTreeItem>> WaitTreeEvent::GetChildren() const {
@@ -389,6 +469,15 @@ int WaitTreeModel::columnCount(const QModelIndex&) const {
     return 1;
 }
 
+bool WaitTreeModel::hasChildren(const QModelIndex& parent) const {
+    if (!parent.isValid())
+        return !thread_items.empty();
+
+    // Unlike rowCount, this doesn't make the children, so only rows that are expanded pay for it
+    const auto* item = static_cast<WaitTreeItem*>(parent.internalPointer());
+    return item->IsExpandable() && (!item->expanded || !item->Children().empty());
+}
+
 QVariant WaitTreeModel::data(const QModelIndex& index, int role) const {
     if (!index.isValid())
         return {};
@@ -404,11 +493,90 @@ QVariant WaitTreeModel::data(const QModelIndex& index, int role) const {
 }
 
 void WaitTreeModel::ClearItems() {
+    beginResetModel();
     thread_items.clear();
+    endResetModel();
+}
+
+void WaitTreeModel::Update(WaitTreeSnapshot snapshot) {
+    // Remove the rows of the threads that are gone
+    std::unordered_set<u32> live_ids;
+    for (const auto& thread : snapshot) {
+        live_ids.insert(thread.object_id);
+    }
+    for (std::size_t row = thread_items.size(); row-- > 0;) {
+        if (live_ids.count(thread_items[row]->GetSnapshot().object_id) == 0) {
+            const int qrow = static_cast<int>(row);
+            beginRemoveRows({}, qrow, qrow);
+            thread_items.erase(thread_items.begin() + row);
+            endRemoveRows();
+        }
+    }
+
+    // The remaining rows keep their relative order, bring them to the order of the snapshot by
+    // moving the few threads that changed cores and inserting new ones
+    for (std::size_t row = 0; row < snapshot.size(); ++row) {
+        const u32 object_id = snapshot[row].object_id;
+        const auto iter = std::find_if(
+            thread_items.begin() + row, thread_items.end(),
+            [object_id](const auto& item) { return item->GetSnapshot().object_id == object_id; });
+        const int qrow = static_cast<int>(row);
+
+        if (iter == thread_items.end()) {
+            beginInsertRows({}, qrow, qrow);
+            auto item = std::make_unique<WaitTreeThreadRow>(std::move(snapshot[row]));
+            item->SetExpandable(expandable);
+            thread_items.insert(thread_items.begin() + row, std::move(item));
+            endInsertRows();
+            continue;
+        }
+
+        if (iter != thread_items.begin() + row) {
+            const int from = static_cast<int>(std::distance(thread_items.begin(), iter));
+            beginMoveRows({}, from, from, {}, qrow);
+            std::rotate(thread_items.begin() + row, iter, iter + 1);
+            endMoveRows();
+        }
+
+        if (thread_items[row]->SetSnapshot(std::move(snapshot[row]))) {
+            const QModelIndex changed = createIndex(qrow, 0, thread_items[row].get());
+            emit dataChanged(changed, changed);
+        }
+    }
+
+    for (std::size_t row = 0; row < thread_items.size(); ++row) {
+        thread_items[row]->row = row;
+    }
+}
+
+void WaitTreeModel::SetExpandable(bool expandable) {
+    if (this->expandable == expandable)
+        return;
+
+    if (!expandable)
+        CollapseAll();
+
+    // Views cache whether a row has children, which changes with the expandability of all rows
+    emit layoutAboutToBeChanged();
+    for (auto& item : thread_items) {
+        item->SetExpandable(expandable);
+    }
+    this->expandable = expandable;
+    emit layoutChanged();
 }
 
-void WaitTreeModel::InitItems() {
-    thread_items = WaitTreeItem::MakeThreadItemList();
+void WaitTreeModel::CollapseAll() {
+    for (std::size_t row = 0; row < thread_items.size(); ++row) {
+        auto& item = thread_items[row];
+        if (item->Children().empty()) {
+            item->Collapse();
+            continue;
+        }
+        const int last_child = static_cast<int>(item->Children().size()) - 1;
+        beginRemoveRows(createIndex(static_cast<int>(row), 0, item.get()), 0, last_child);
+        item->Collapse();
+        endRemoveRows();
+    }
 }
 
 WaitTreeWidget::WaitTreeWidget(QWidget* parent) : QDockWidget(tr("Wait Tree"), parent) {
@@ -417,30 +585,60 @@ WaitTreeWidget::WaitTreeWidget(QWidget* parent) : QDockWidget(tr("Wait Tree"), p
     view->setHeaderHidden(true);
     setWidget(view);
     setEnabled(false);
+
+    qRegisterMetaType<WaitTreeSnapshot>("WaitTreeSnapshot");
+    connect(this, &WaitTreeWidget::SnapshotTaken, this, &WaitTreeWidget::OnSnapshotTaken,
+            Qt::QueuedConnection);
+
+    refresh_timer.setInterval(LIVE_REFRESH_INTERVAL_MS);
+    connect(&refresh_timer, &QTimer::timeout, this, &WaitTreeWidget::RequestSnapshot);
 }
 
 void WaitTreeWidget::OnDebugModeEntered() {
+    refresh_timer.stop();
     if (!Core::System::GetInstance().IsPoweredOn())
         return;
-    model->InitItems();
-    view->setModel(model);
+    model->Update(WaitTreeThreadSnapshot::TakeAll());
+    model->SetExpandable(true);
     setEnabled(true);
 }
 
 void WaitTreeWidget::OnDebugModeLeft() {
-    setEnabled(false);
-    view->setModel(nullptr);
-    model->ClearItems();
+    // The rows keep showing the last snapshot, and are refreshed live from now on
+    model->SetExpandable(false);
+    setEnabled(true);
+    refresh_timer.start();
 }
 
 void WaitTreeWidget::OnEmulationStarting(EmuThread* emu_thread) {
+    this->emu_thread = emu_thread;
     model = new WaitTreeModel(this);
     view->setModel(model);
     setEnabled(false);
 }
 
 void WaitTreeWidget::OnEmulationStopping() {
+    refresh_timer.stop();
     view->setModel(nullptr);
     delete model;
+    model = nullptr;
+    emu_thread = nullptr;
     setEnabled(false);
 }
+
+void WaitTreeWidget::RequestSnapshot() {
+    if (snapshot_pending || emu_thread == nullptr || !isVisible())
+        return;
+
+    snapshot_pending = true;
+    emu_thread->RunBetweenSlices([this] { emit SnapshotTaken(WaitTreeThreadSnapshot::TakeAll()); });
+}
+
+void WaitTreeWidget::OnSnapshotTaken(WaitTreeSnapshot snapshot) {
+    snapshot_pending = false;
+
+    // Once paused, the snapshot taken on pausing is newer and the rows are expandable
+    if (model == nullptr || emu_thread == nullptr || !emu_thread->IsRunning())
+        return;
+    model->Update(std::move(snapshot));
+}
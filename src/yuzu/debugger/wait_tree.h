@@ -4,12 +4,16 @@
 
 #pragma once
 
+#include <string>
+#include <vector>
 #include <QAbstractItemModel>
 #include <QDockWidget>
+#include <QTimer>
 #include <QTreeView>
 #include <boost/container/flat_set.hpp>
 #include "core/core.h"
 #include "core/hle/kernel/object.h"
+#include "core/hle/kernel/thread.h"
 
 class EmuThread;
 
@@ -20,7 +24,30 @@ class Thread;
 class Timer;
 } // namespace Kernel
 
-class WaitTreeThread;
+/**
+ * Copy of the state of a kernel thread shown on its top level row of the wait tree. Taking one
+ * is cheap, so that the rows can be refreshed while the game runs.
+ */
+struct WaitTreeThreadSnapshot {
+    u32 object_id;
+    std::string name;
+    ThreadStatus status;
+    u64 pc;
+    u64 lr;
+
+    static WaitTreeThreadSnapshot Take(const Kernel::Thread& thread);
+
+    /**
+     * Takes a snapshot of the threads of every scheduler. Only call this while the emulated CPUs
+     * are stopped, either paused or between two slices on the emulation thread.
+     */
+    static std::vector<WaitTreeThreadSnapshot> TakeAll();
+
+    bool operator==(const WaitTreeThreadSnapshot& other) const;
+    bool operator!=(const WaitTreeThreadSnapshot& other) const;
+};
+
+using WaitTreeSnapshot = std::vector<WaitTreeThreadSnapshot>;
 
 class WaitTreeItem : public QObject {
     Q_OBJECT
@@ -33,12 +60,15 @@ public:
     virtual QColor GetColor() const;
 
     void Expand();
+    /// Drops the children, so that they are made anew from current state on the next Expand
+    void Collapse();
     WaitTreeItem* Parent() const;
     const std::vector<std::unique_ptr<WaitTreeItem>>& Children() const;
     std::size_t Row() const;
-    static std::vector<std::unique_ptr<WaitTreeThread>> MakeThreadItemList();
 
 private:
+    friend class WaitTreeModel;
+
     std::size_t row;
     bool expanded = false;
     WaitTreeItem* parent = nullptr;
@@ -120,6 +150,32 @@ public:
     QString GetText() const override;
     QColor GetColor() const override;
     std::vector<std::unique_ptr<WaitTreeItem>> GetChildren() const override;
+
+    static QString GetSnapshotText(const WaitTreeThreadSnapshot& snapshot);
+    static QColor GetStatusColor(ThreadStatus status);
+};
+
+/**
+ * Top level row of a thread, showing a snapshot of it. The children are only available while
+ * emulation is paused, they are made from the live kernel thread when the row is expanded.
+ */
+class WaitTreeThreadRow : public WaitTreeItem {
+    Q_OBJECT
+public:
+    explicit WaitTreeThreadRow(WaitTreeThreadSnapshot snapshot);
+    bool IsExpandable() const override;
+    QString GetText() const override;
+    QColor GetColor() const override;
+    std::vector<std::unique_ptr<WaitTreeItem>> GetChildren() const override;
+
+    const WaitTreeThreadSnapshot& GetSnapshot() const;
+    /// Replaces the snapshot shown, returns whether it differs from the previous one
+    bool SetSnapshot(WaitTreeThreadSnapshot new_snapshot);
+    void SetExpandable(bool expandable);
+
+private:
+    WaitTreeThreadSnapshot snapshot;
+    bool expandable = false;
 };
 
 class WaitTreeEvent : public WaitTreeWaitObject {
@@ -158,12 +214,27 @@ public:
     QModelIndex parent(const QModelIndex& index) const override;
     int rowCount(const QModelIndex& parent) const override;
     int columnCount(const QModelIndex& parent) const override;
+    bool hasChildren(const QModelIndex& parent) const override;
 
     void ClearItems();
-    void InitItems();
+
+    /**
+     * Brings the thread rows up to date with a snapshot. Rows of threads that are still there
+     * are kept and only repainted if their snapshot changed, so refreshing is cheap.
+     */
+    void Update(WaitTreeSnapshot snapshot);
+
+    /**
+     * Sets whether the rows can be expanded, only allowed while emulation is paused since their
+     * children are made from live kernel state. Making them unexpandable drops the children.
+     */
+    void SetExpandable(bool expandable);
 
 private:
-    std::vector<std::unique_ptr<WaitTreeThread>> thread_items;
+    void CollapseAll();
+
+    std::vector<std::unique_ptr<WaitTreeThreadRow>> thread_items;
+    bool expandable = false;
 };
 
 class WaitTreeWidget : public QDockWidget {
@@ -179,7 +250,22 @@ public slots:
     void OnEmulationStarting(EmuThread* emu_thread);
     void OnEmulationStopping();
 
+signals:
+    /// Emitted on the emulation thread with a snapshot taken between two slices
+    void SnapshotTaken(WaitTreeSnapshot snapshot);
+
 private:
+    /// Interval at which the threads are refreshed while the game runs
+    static constexpr int LIVE_REFRESH_INTERVAL_MS = 500;
+
+    void RequestSnapshot();
+    void OnSnapshotTaken(WaitTreeSnapshot snapshot);
+
     QTreeView* view;
-    WaitTreeModel* model;
+    WaitTreeModel* model = nullptr;
+    EmuThread* emu_thread = nullptr;
+
+    QTimer refresh_timer;
+    /// Whether a snapshot was requested from the emulation thread and hasn't arrived yet
+    bool snapshot_pending = false;
 };
@@ -4,7 +4,10 @@
 
 #include <regex>
 #include <QApplication>
+#include <QDataStream>
+#include <QDateTime>
 #include <QDir>
+#include <QFile>
 #include <QFileInfo>
 #include <QHeaderView>
 #include <QKeyEvent>
@@ -12,8 +15,10 @@
 #include <QThreadPool>
 #include <boost/container/flat_map.hpp>
 #include "common/common_paths.h"
+#include "common/file_util.h"
 #include "common/logging/log.h"
 #include "common/string_util.h"
+#include "common/thread_pool.h"
 #include "core/file_sys/content_archive.h"
 #include "core/file_sys/control_metadata.h"
 #include "core/file_sys/registered_cache.h"
@@ -33,7 +38,6 @@ bool GameList::SearchField::KeyReleaseEater::eventFilter(QObject* obj, QEvent* e
         return QObject::eventFilter(obj, event);
 
     QKeyEvent* keyEvent = static_cast<QKeyEvent*>(event);
-    int rowCount = gamelist->tree_view->model()->rowCount();
     QString edit_filter_text = gamelist->search_field->edit_filter->text().toLower();
 
     // If the searchfield's text hasn't changed special function keys get checked
@@ -55,19 +59,10 @@ bool GameList::SearchField::KeyReleaseEater::eventFilter(QObject* obj, QEvent* e
         // If there is only one result launch this game
         case Qt::Key_Return:
         case Qt::Key_Enter: {
-            QStandardItemModel* item_model = new QStandardItemModel(gamelist->tree_view);
-            QModelIndex root_index = item_model->invisibleRootItem()->index();
-            QStandardItem* child_file;
-            QString file_path;
-            int resultCount = 0;
-            for (int i = 0; i < rowCount; ++i) {
-                if (!gamelist->tree_view->isRowHidden(i, root_index)) {
-                    ++resultCount;
-                    child_file = gamelist->item_model->item(i, 0);
-                    file_path = child_file->data(GameListItemPath::FullPathRole).toString();
-                }
-            }
-            if (resultCount == 1) {
+            if (gamelist->proxy_model->rowCount() == 1) {
+                const QString file_path = gamelist->proxy_model->index(0, COLUMN_NAME)
+                                              .data(GameListItemPath::FullPathRole)
+                                              .toString();
                 // To avoid loading error dialog loops while confirming them using enter
                 // Also users usually want to run a diffrent game after closing one
                 gamelist->search_field->edit_filter->setText("");
@@ -137,63 +132,45 @@ GameList::SearchField::SearchField(GameList* parent) : QWidget{parent} {
     setLayout(layout_filter);
 }
 
-/**
- * Checks if all words separated by spaces are contained in another string
- * This offers a word order insensitive search function
- *
- * @param haystack String that gets checked if it contains all words of the userinput string
- * @param userinput String containing all words getting checked
- * @return true if the haystack contains all words of userinput
- */
-static bool ContainsAllWords(const QString& haystack, const QString& userinput) {
-    const QStringList userinput_split =
-        userinput.split(' ', QString::SplitBehavior::SkipEmptyParts);
+GameListFilterModel::GameListFilterModel(QStandardItemModel* item_model, QObject* parent)
+    : QSortFilterProxyModel{parent}, item_model{item_model} {
+    setSourceModel(item_model);
+}
 
-    return std::all_of(userinput_split.begin(), userinput_split.end(),
-                       [&haystack](const QString& s) { return haystack.contains(s); });
+void GameListFilterModel::SetFilterText(const QString& text) {
+    filter_text = text.toLower();
+    filter_words = filter_text.split(' ', QString::SplitBehavior::SkipEmptyParts);
+    invalidateFilter();
 }
 
-// Event in order to filter the gamelist after editing the searchfield
-void GameList::onTextChanged(const QString& newText) {
-    int rowCount = tree_view->model()->rowCount();
-    QString edit_filter_text = newText.toLower();
+bool GameListFilterModel::filterAcceptsRow(int source_row,
+                                           const QModelIndex& source_parent) const {
+    if (filter_words.isEmpty())
+        return true;
 
-    QModelIndex root_index = item_model->invisibleRootItem()->index();
+    const QModelIndex index = item_model->index(source_row, GameList::COLUMN_NAME, source_parent);
 
-    // If the searchfield is empty every item is visible
-    // Otherwise the filter gets applied
-    if (edit_filter_text.isEmpty()) {
-        for (int i = 0; i < rowCount; ++i) {
-            tree_view->setRowHidden(i, root_index, false);
-        }
-        search_field->setFilterResult(rowCount, rowCount);
-    } else {
-        int result_count = 0;
-        for (int i = 0; i < rowCount; ++i) {
-            const QStandardItem* child_file = item_model->item(i, 0);
-            const QString file_path =
-                child_file->data(GameListItemPath::FullPathRole).toString().toLower();
-            QString file_name = file_path.mid(file_path.lastIndexOf('/') + 1);
-            const QString file_title =
-                child_file->data(GameListItemPath::TitleRole).toString().toLower();
-            const QString file_programmid =
-                child_file->data(GameListItemPath::ProgramIdRole).toString().toLower();
-
-            // Only items which filename in combination with its title contains all words
-            // that are in the searchfield will be visible in the gamelist
-            // The search is case insensitive because of toLower()
-            // I decided not to use Qt::CaseInsensitive in containsAllWords to prevent
-            // multiple conversions of edit_filter_text for each game in the gamelist
-            if (ContainsAllWords(file_name.append(' ').append(file_title), edit_filter_text) ||
-                (file_programmid.count() == 16 && edit_filter_text.contains(file_programmid))) {
-                tree_view->setRowHidden(i, root_index, false);
-                ++result_count;
-            } else {
-                tree_view->setRowHidden(i, root_index, true);
-            }
-            search_field->setFilterResult(result_count, rowCount);
-        }
-    }
+    // Only items which filename in combination with its title contains all words
+    // that are in the searchfield will be visible in the gamelist
+    // The search is case insensitive because both sides are lowercase
+    const QString search_text = index.data(GameListItemPath::SearchTextRole).toString();
+    if (std::all_of(filter_words.begin(), filter_words.end(),
+                    [&search_text](const QString& word) { return search_text.contains(word); }))
+        return true;
+
+    const QString program_id = index.data(GameListItemPath::ProgramIdTextRole).toString();
+    return !program_id.isEmpty() && filter_text.contains(program_id);
+}
+
+bool GameListFilterModel::lessThan(const QModelIndex& left, const QModelIndex& right) const {
+    // Keeps the ordering the items define, like sizes sorting by value instead of by text
+    return *item_model->itemFromIndex(left) < *item_model->itemFromIndex(right);
+}
+
+// Event in order to filter the gamelist after editing the searchfield
+void GameList::onTextChanged(const QString& newText) {
+    proxy_model->SetFilterText(newText);
+    search_field->setFilterResult(proxy_model->rowCount(), item_model->rowCount());
 }
 
 void GameList::onFilterCloseClicked() {
@@ -210,7 +187,8 @@ GameList::GameList(FileSys::VirtualFilesystem vfs, GMainWindow* parent)
     tree_view = new QTreeView;
     search_field = new SearchField(this);
     item_model = new QStandardItemModel(tree_view);
-    tree_view->setModel(item_model);
+    proxy_model = new GameListFilterModel(item_model, tree_view);
+    tree_view->setModel(proxy_model);
 
     tree_view->setAlternatingRowColors(true);
     tree_view->setSelectionMode(QHeaderView::SingleSelection);
@@ -232,7 +210,7 @@ GameList::GameList(FileSys::VirtualFilesystem vfs, GMainWindow* parent)
 
     // We must register all custom types with the Qt Automoc system so that we are able to use it
     // with signals/slots. In this case, QList falls under the umbrells of custom types.
-    qRegisterMetaType<QList<QStandardItem*>>("QList<QStandardItem*>");
+    qRegisterMetaType<QList<QList<QStandardItem*>>>("QList<QList<QStandardItem*>>");
 
     layout->setContentsMargins(0, 0, 0, 0);
     layout->setSpacing(0);
@@ -259,13 +237,16 @@ void GameList::clearFilter() {
     search_field->clear();
 }
 
-void GameList::AddEntry(const QList<QStandardItem*>& entry_items) {
-    item_model->invisibleRootItem()->appendRow(entry_items);
+void GameList::AddEntries(const QList<QList<QStandardItem*>>& entries) {
+    QStandardItem* const root = item_model->invisibleRootItem();
+    for (const auto& entry_items : entries) {
+        root->appendRow(entry_items);
+    }
 }
 
 void GameList::ValidateEntry(const QModelIndex& item) {
     // We don't care about the individual QStandardItem that was selected, but its row.
-    const int row = item_model->itemFromIndex(item)->row();
+    const int row = proxy_model->mapToSource(item).row();
     const QStandardItem* child_file = item_model->invisibleRootItem()->child(row, COLUMN_NAME);
     const QString file_path = child_file->data(GameListItemPath::FullPathRole).toString();
 
@@ -307,8 +288,8 @@ void GameList::DonePopulating(QStringList watch_list) {
         QCoreApplication::processEvents();
     }
     tree_view->setEnabled(true);
-    int rowCount = tree_view->model()->rowCount();
-    search_field->setFilterResult(rowCount, rowCount);
+    int rowCount = item_model->rowCount();
+    search_field->setFilterResult(proxy_model->rowCount(), rowCount);
     if (rowCount > 0) {
         search_field->setFocus();
     }
@@ -319,7 +300,7 @@ void GameList::PopupContextMenu(const QPoint& menu_location) {
     if (!item.isValid())
         return;
 
-    int row = item_model->itemFromIndex(item)->row();
+    int row = proxy_model->mapToSource(item).row();
     QStandardItem* child_file = item_model->invisibleRootItem()->child(row, COLUMN_NAME);
     u64 program_id = child_file->data(GameListItemPath::ProgramIdRole).toULongLong();
 
@@ -345,9 +326,13 @@ void GameList::PopulateAsync(const QString& dir_path, bool deep_scan) {
 
     emit ShouldCancelWorker();
 
-    GameListWorker* worker = new GameListWorker(vfs, dir_path, deep_scan);
+    if (cache == nullptr)
+        cache = std::make_shared<GameListCache>();
+
+    GameListWorker* worker = new GameListWorker(vfs, dir_path, deep_scan, cache);
 
-    connect(worker, &GameListWorker::EntryReady, this, &GameList::AddEntry, Qt::QueuedConnection);
+    connect(worker, &GameListWorker::EntriesReady, this, &GameList::AddEntries,
+            Qt::QueuedConnection);
     connect(worker, &GameListWorker::Finished, this, &GameList::DonePopulating,
             Qt::QueuedConnection);
     // Use DirectConnection here because worker->Cancel() is thread-safe and we want it to cancel
@@ -371,7 +356,7 @@ void GameList::LoadInterfaceLayout() {
         header->resizeSection(COLUMN_NAME, header->width());
     }
 
-    item_model->sort(header->sortIndicatorSection(), header->sortIndicatorOrder());
+    proxy_model->sort(header->sortIndicatorSection(), header->sortIndicatorOrder());
 }
 
 const QStringList GameList::supported_file_extensions = {"nso", "nro", "nca", "xci", "nsp"};
@@ -426,6 +411,94 @@ static void GetMetadataFromControlNCA(const std::shared_ptr<FileSys::NCA>& nca,
     }
 }
 
+/// Has to be bumped whenever the layout of the cache file changes
+constexpr quint32 GAME_LIST_CACHE_VERSION = 1;
+
+static QString GetGameListCachePath() {
+    return QString::fromStdString(FileUtil::GetUserPath(FileUtil::UserPath::CacheDir) +
+                                  "game_list" DIR_SEP "metadata.bin");
+}
+
+GameListCache::GameListCache() {
+    QFile file(GetGameListCachePath());
+    if (!file.open(QIODevice::ReadOnly))
+        return;
+
+    QDataStream stream(&file);
+    quint32 version = 0;
+    quint32 num_entries = 0;
+    stream >> version >> num_entries;
+    if (version != GAME_LIST_CACHE_VERSION)
+        return;
+
+    for (quint32 i = 0; i < num_entries && stream.status() == QDataStream::Ok; ++i) {
+        QString path;
+        quint64 size;
+        qint64 mtime;
+        quint64 program_id;
+        QString file_type;
+        QString name;
+        QByteArray icon;
+        stream >> path >> size >> mtime >> program_id >> file_type >> name >> icon;
+
+        GameListMetadata metadata{program_id, file_type, name,
+                                  std::vector<u8>(icon.begin(), icon.end())};
+        entries.insert_or_assign(path, Entry{size, mtime, std::move(metadata)});
+    }
+
+    if (stream.status() != QDataStream::Ok) {
+        LOG_WARNING(Frontend, "Game list cache is corrupted, discarding it");
+        entries.clear();
+    }
+}
+
+boost::optional<GameListMetadata> GameListCache::Find(const QString& path, u64 size,
+                                                      s64 mtime) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    const auto iter = entries.find(path);
+    if (iter == entries.end() || iter->second.size != size || iter->second.mtime != mtime)
+        return boost::none;
+    return iter->second.metadata;
+}
+
+void GameListCache::Insert(const QString& path, u64 size, s64 mtime, GameListMetadata metadata) {
+    std::lock_guard<std::mutex> lock(mutex);
+    entries.insert_or_assign(path, Entry{size, mtime, std::move(metadata)});
+}
+
+void GameListCache::Save(const QSet<QString>& paths) {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (auto iter = entries.begin(); iter != entries.end();) {
+        if (paths.contains(iter->first))
+            ++iter;
+        else
+            iter = entries.erase(iter);
+    }
+
+    const QString path = GetGameListCachePath();
+    if (!FileUtil::CreateFullPath(path.toStdString())) {
+        LOG_ERROR(Frontend, "Could not create the game list cache directory for {}",
+                  path.toStdString());
+        return;
+    }
+
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        LOG_ERROR(Frontend, "Could not write the game list cache to {}", path.toStdString());
+        return;
+    }
+
+    QDataStream stream(&file);
+    stream << GAME_LIST_CACHE_VERSION << static_cast<quint32>(entries.size());
+    for (const auto& [entry_path, entry] : entries) {
+        const auto& metadata = entry.metadata;
+        stream << entry_path << static_cast<quint64>(entry.size) << static_cast<qint64>(entry.mtime)
+               << static_cast<quint64>(metadata.program_id) << metadata.file_type << metadata.name
+               << QByteArray(reinterpret_cast<const char*>(metadata.icon.data()),
+                             static_cast<int>(metadata.icon.size()));
+    }
+}
+
 void GameListWorker::AddInstalledTitlesToGameList(std::shared_ptr<FileSys::RegisteredCache> cache) {
     const auto installed_games = cache->ListEntriesFilter(FileSys::TitleType::Application,
                                                           FileSys::ContentRecordType::Program);
@@ -444,7 +517,7 @@ void GameListWorker::AddInstalledTitlesToGameList(std::shared_ptr<FileSys::Regis
         const auto& control = cache->GetEntry(game.title_id, FileSys::ContentRecordType::Control);
         if (control != nullptr)
             GetMetadataFromControlNCA(control, icon, name);
-        emit EntryReady({
+        QueueEntry({
             new GameListItemPath(
                 FormatGameName(file->GetFullPath()), icon, QString::fromStdString(name),
                 QString::fromStdString(Loader::GetFileTypeString(loader->GetFileType())),
@@ -467,19 +540,19 @@ void GameListWorker::AddInstalledTitlesToGameList(std::shared_ptr<FileSys::Regis
 
 void GameListWorker::FillControlMap(const std::string& dir_path) {
     const auto nca_control_callback = [this](u64* num_entries_out, const std::string& directory,
-                                             const std::string& virtual_name) -> bool {
+                                             const std::string& virtual_name, bool is_dir) -> bool {
         std::string physical_name = directory + DIR_SEP + virtual_name;
 
         if (stop_processing)
             return false; // Breaks the callback loop.
 
-        bool is_dir = FileUtil::IsDirectory(physical_name);
         QFileInfo file_info(physical_name.c_str());
         if (!is_dir && file_info.suffix().toStdString() == "nca") {
             auto nca =
                 std::make_shared<FileSys::NCA>(vfs->OpenFile(physical_name, FileSys::Mode::Read));
+            // Installed titles come first, as with the installed games themselves
             if (nca->GetType() == FileSys::NCAContentType::Control)
-                nca_control_map.insert_or_assign(nca->GetTitleId(), nca);
+                nca_control_map.emplace(nca->GetTitleId(), nca);
         }
         return true;
     };
@@ -489,49 +562,15 @@ void GameListWorker::FillControlMap(const std::string& dir_path) {
 
 void GameListWorker::AddFstEntriesToGameList(const std::string& dir_path, unsigned int recursion) {
     const auto callback = [this, recursion](u64* num_entries_out, const std::string& directory,
-                                            const std::string& virtual_name) -> bool {
+                                            const std::string& virtual_name, bool is_dir) -> bool {
         std::string physical_name = directory + DIR_SEP + virtual_name;
 
         if (stop_processing)
             return false; // Breaks the callback loop.
 
-        bool is_dir = FileUtil::IsDirectory(physical_name);
         if (!is_dir &&
             (HasSupportedFileExtension(physical_name) || IsExtractedNCAMain(physical_name))) {
-            std::unique_ptr<Loader::AppLoader> loader =
-                Loader::GetLoader(vfs->OpenFile(physical_name, FileSys::Mode::Read));
-            if (!loader || ((loader->GetFileType() == Loader::FileType::Unknown ||
-                             loader->GetFileType() == Loader::FileType::Error) &&
-                            !UISettings::values.show_unknown))
-                return true;
-
-            std::vector<u8> icon;
-            const auto res1 = loader->ReadIcon(icon);
-
-            u64 program_id = 0;
-            const auto res2 = loader->ReadProgramId(program_id);
-
-            std::string name = " ";
-            const auto res3 = loader->ReadTitle(name);
-
-            if (res1 != Loader::ResultStatus::Success && res3 != Loader::ResultStatus::Success &&
-                res2 == Loader::ResultStatus::Success) {
-                // Use from metadata pool.
-                if (nca_control_map.find(program_id) != nca_control_map.end()) {
-                    const auto nca = nca_control_map[program_id];
-                    GetMetadataFromControlNCA(nca, icon, name);
-                }
-            }
-
-            emit EntryReady({
-                new GameListItemPath(
-                    FormatGameName(physical_name), icon, QString::fromStdString(name),
-                    QString::fromStdString(Loader::GetFileTypeString(loader->GetFileType())),
-                    program_id),
-                new GameListItem(
-                    QString::fromStdString(Loader::GetFileTypeString(loader->GetFileType()))),
-                new GameListItemSize(FileUtil::GetSize(physical_name)),
-            });
+            game_files.push_back(std::move(physical_name));
         } else if (is_dir && recursion > 0) {
             watch_list.append(QString::fromStdString(physical_name));
             AddFstEntriesToGameList(physical_name, recursion - 1);
@@ -543,15 +582,139 @@ void GameListWorker::AddFstEntriesToGameList(const std::string& dir_path, unsign
     FileUtil::ForeachDirectoryEntry(nullptr, dir_path, callback);
 }
 
+void GameListWorker::AddGameFilesToGameList() {
+    std::vector<std::pair<std::string, FileSys::VirtualFile>> uncached;
+    for (const auto& physical_name : game_files) {
+        if (stop_processing)
+            return;
+
+        const QFileInfo file_info(QString::fromStdString(physical_name));
+        const auto metadata = cache->Find(file_info.absoluteFilePath(), file_info.size(),
+                                          file_info.lastModified().toMSecsSinceEpoch());
+        if (metadata) {
+            EmitGameFileEntry(physical_name, *metadata);
+            continue;
+        }
+
+        // Opening files isn't thread-safe, so only the parsing is left to the thread pool
+        uncached.emplace_back(physical_name, vfs->OpenFile(physical_name, FileSys::Mode::Read));
+    }
+
+    if (uncached.empty())
+        return;
+
+    // Only games that aren't cached might need their metadata from a loose control NCA
+    FillControlMap(dir_path.toStdString());
+
+    // Parsing runs on the shared pool below anything the emulation itself may have queued
+    auto& pool = Common::GetSharedThreadPool();
+    std::vector<Common::Future<void>> parsed;
+    parsed.reserve(uncached.size());
+    for (auto& [physical_name, file] : uncached) {
+        parsed.push_back(pool.Submit(
+            [this, physical_name = std::move(physical_name), file = std::move(file)] {
+                AddGameFile(physical_name, file);
+            },
+            Common::TaskPriority::Low));
+    }
+    for (auto& future : parsed) {
+        future.Wait();
+    }
+}
+
+void GameListWorker::AddGameFile(const std::string& physical_name, FileSys::VirtualFile file) {
+    if (stop_processing)
+        return;
+
+    std::unique_ptr<Loader::AppLoader> loader = Loader::GetLoader(std::move(file));
+    if (!loader || ((loader->GetFileType() == Loader::FileType::Unknown ||
+                     loader->GetFileType() == Loader::FileType::Error) &&
+                    !UISettings::values.show_unknown))
+        return;
+
+    GameListMetadata metadata;
+    metadata.file_type = QString::fromStdString(Loader::GetFileTypeString(loader->GetFileType()));
+
+    const auto res1 = loader->ReadIcon(metadata.icon);
+    const auto res2 = loader->ReadProgramId(metadata.program_id);
+
+    std::string name = " ";
+    const auto res3 = loader->ReadTitle(name);
+
+    if (res1 != Loader::ResultStatus::Success && res3 != Loader::ResultStatus::Success &&
+        res2 == Loader::ResultStatus::Success) {
+        // Use from metadata pool.
+        const auto iter = nca_control_map.find(metadata.program_id);
+        if (iter != nca_control_map.end())
+            GetMetadataFromControlNCA(iter->second, metadata.icon, name);
+    }
+    metadata.name = QString::fromStdString(name);
+
+    // Games that can't be read, most often for missing keys, are read again on the next refresh
+    if (res2 == Loader::ResultStatus::Success) {
+        const QFileInfo file_info(QString::fromStdString(physical_name));
+        cache->Insert(file_info.absoluteFilePath(), file_info.size(),
+                      file_info.lastModified().toMSecsSinceEpoch(), metadata);
+    }
+
+    EmitGameFileEntry(physical_name, metadata);
+}
+
+void GameListWorker::EmitGameFileEntry(const std::string& physical_name,
+                                       const GameListMetadata& metadata) {
+    QueueEntry({
+        new GameListItemPath(FormatGameName(physical_name), metadata.icon, metadata.name,
+                             metadata.file_type, metadata.program_id),
+        new GameListItem(metadata.file_type),
+        new GameListItemSize(FileUtil::GetSize(physical_name)),
+    });
+}
+
+void GameListWorker::QueueEntry(QList<QStandardItem*> entry_items) {
+    // Large enough that a big library is inserted in a few dozen steps, small enough that the
+    // first games show up right away
+    constexpr int ENTRY_BATCH_SIZE = 64;
+
+    QList<QList<QStandardItem*>> entries;
+    {
+        std::lock_guard<std::mutex> lock(pending_entries_mutex);
+        pending_entries.append(std::move(entry_items));
+        if (pending_entries.size() < ENTRY_BATCH_SIZE)
+            return;
+        entries.swap(pending_entries);
+    }
+    emit EntriesReady(std::move(entries));
+}
+
+void GameListWorker::EmitPendingEntries() {
+    QList<QList<QStandardItem*>> entries;
+    {
+        std::lock_guard<std::mutex> lock(pending_entries_mutex);
+        entries.swap(pending_entries);
+    }
+    if (!entries.isEmpty())
+        emit EntriesReady(std::move(entries));
+}
+
 void GameListWorker::run() {
     stop_processing = false;
     watch_list.append(dir_path);
-    FillControlMap(dir_path.toStdString());
     AddInstalledTitlesToGameList(Service::FileSystem::GetUserNANDContents());
     AddInstalledTitlesToGameList(Service::FileSystem::GetSystemNANDContents());
     AddInstalledTitlesToGameList(Service::FileSystem::GetSDMCContents());
     AddFstEntriesToGameList(dir_path.toStdString(), deep_scan ? 256 : 0);
+    AddGameFilesToGameList();
+    EmitPendingEntries();
     nca_control_map.clear();
+
+    // Only a complete scan knows which games are gone
+    if (!stop_processing) {
+        QSet<QString> paths;
+        for (const auto& physical_name : game_files)
+            paths.insert(QFileInfo(QString::fromStdString(physical_name)).absoluteFilePath());
+        cache->Save(paths);
+    }
+
     emit Finished(watch_list);
 }
 
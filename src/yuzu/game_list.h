@@ -4,6 +4,7 @@
 
 #pragma once
 
+#include <memory>
 #include <QFileSystemWatcher>
 #include <QHBoxLayout>
 #include <QLabel>
@@ -19,6 +20,8 @@
 #include <QWidget>
 #include "main.h"
 
+class GameListCache;
+class GameListFilterModel;
 class GameListWorker;
 
 enum class GameListOpenTarget { SaveData };
@@ -85,7 +88,7 @@ private slots:
     void onFilterCloseClicked();
 
 private:
-    void AddEntry(const QList<QStandardItem*>& entry_items);
+    void AddEntries(const QList<QList<QStandardItem*>>& entries);
     void ValidateEntry(const QModelIndex& item);
     void DonePopulating(QStringList watch_list);
 
@@ -98,8 +101,11 @@ private:
     QVBoxLayout* layout = nullptr;
     QTreeView* tree_view = nullptr;
     QStandardItemModel* item_model = nullptr;
+    /// Sorted and filtered view of item_model, which is what tree_view shows
+    GameListFilterModel* proxy_model = nullptr;
     GameListWorker* current_worker = nullptr;
     QFileSystemWatcher* watcher = nullptr;
+    std::shared_ptr<GameListCache> cache;
 };
 
 Q_DECLARE_METATYPE(GameListOpenTarget);
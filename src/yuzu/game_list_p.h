@@ -8,11 +8,19 @@
 #include <atomic>
 #include <map>
 #include <memory>
+#include <mutex>
 #include <utility>
+#include <vector>
+#include <QByteArray>
 #include <QImage>
+#include <QPixmap>
 #include <QRunnable>
+#include <QSet>
+#include <QSortFilterProxyModel>
 #include <QStandardItem>
+#include <QStandardItemModel>
 #include <QString>
+#include <boost/optional.hpp>
 #include "common/string_util.h"
 #include "core/file_sys/content_archive.h"
 #include "ui_settings.h"
@@ -48,24 +56,27 @@ public:
     static const int TitleRole = Qt::UserRole + 2;
     static const int ProgramIdRole = Qt::UserRole + 3;
     static const int FileTypeRole = Qt::UserRole + 4;
+    /// Lowercase file name and title, computed once so that filtering doesn't build them
+    static const int SearchTextRole = Qt::UserRole + 5;
+    /// Lowercase program ID as 16 hex digits, or empty if the game has none
+    static const int ProgramIdTextRole = Qt::UserRole + 6;
 
     GameListItemPath() = default;
     GameListItemPath(const QString& game_path, const std::vector<u8>& picture_data,
-                     const QString& game_name, const QString& game_type, u64 program_id) {
+                     const QString& game_name, const QString& game_type, u64 program_id)
+        : icon_data(reinterpret_cast<const char*>(picture_data.data()),
+                    static_cast<int>(picture_data.size())) {
         setData(game_path, FullPathRole);
         setData(game_name, TitleRole);
         setData(qulonglong(program_id), ProgramIdRole);
         setData(game_type, FileTypeRole);
 
-        const u32 size = UISettings::values.icon_size;
-
-        QPixmap picture;
-        if (!picture.loadFromData(picture_data.data(), static_cast<u32>(picture_data.size()))) {
-            picture = GetDefaultIcon(size);
+        const QString file_name = game_path.mid(game_path.lastIndexOf('/') + 1);
+        setData(QString(file_name + ' ' + game_name).toLower(), SearchTextRole);
+        if (program_id != 0) {
+            setData(QString::fromStdString(fmt::format("{:016x}", program_id)),
+                    ProgramIdTextRole);
         }
-        picture = picture.scaled(size, size);
-
-        setData(picture, Qt::DecorationRole);
     }
 
     QVariant data(int role) const override {
@@ -92,8 +103,26 @@ public:
             return row1 + "\n    " + row2;
         }
 
+        if (role == Qt::DecorationRole) {
+            // Only decoded once the view first shows the row, which large libraries mostly don't
+            if (icon.isNull()) {
+                const u32 size = UISettings::values.icon_size;
+                if (!icon.loadFromData(icon_data)) {
+                    icon = GetDefaultIcon(size);
+                }
+                icon = icon.scaled(size, size);
+                icon_data.clear();
+            }
+            return icon;
+        }
+
         return GameListItem::data(role);
     }
+
+private:
+    /// Encoded icon of the game, until it is decoded to icon
+    mutable QByteArray icon_data;
+    mutable QPixmap icon;
 };
 
 /**
@@ -133,6 +162,66 @@ public:
     }
 };
 
+/**
+ * Sorts and filters the rows of the game list without touching the items themselves. Filtering
+ * only compares the search text that every GameListItemPath precomputed.
+ */
+class GameListFilterModel : public QSortFilterProxyModel {
+public:
+    GameListFilterModel(QStandardItemModel* item_model, QObject* parent);
+
+    /// Shows only the games matching text, or every game if it is empty
+    void SetFilterText(const QString& text);
+
+protected:
+    bool filterAcceptsRow(int source_row, const QModelIndex& source_parent) const override;
+    bool lessThan(const QModelIndex& left, const QModelIndex& right) const override;
+
+private:
+    QStandardItemModel* item_model;
+    /// Lowercase words of the filter text
+    QStringList filter_words;
+    /// Lowercase filter text, which matches a program ID it contains
+    QString filter_text;
+};
+
+/// What the game list shows for a game file
+struct GameListMetadata {
+    u64 program_id = 0;
+    QString file_type;
+    QString name;
+    std::vector<u8> icon;
+};
+
+/**
+ * Remembers the metadata of game files by their path, size and modification time, so refreshing
+ * the game list doesn't open every unchanged game again. Kept in the cache directory between runs.
+ * Thread-safe.
+ */
+class GameListCache {
+public:
+    /// Loads the cache written by the last run, if any
+    GameListCache();
+
+    /// Returns the metadata of the file at path, unless it changed since it was inserted
+    boost::optional<GameListMetadata> Find(const QString& path, u64 size, s64 mtime) const;
+
+    void Insert(const QString& path, u64 size, s64 mtime, GameListMetadata metadata);
+
+    /// Drops the entries of files that aren't in paths and writes the others to disk
+    void Save(const QSet<QString>& paths);
+
+private:
+    struct Entry {
+        u64 size;
+        s64 mtime;
+        GameListMetadata metadata;
+    };
+
+    mutable std::mutex mutex;
+    std::map<QString, Entry> entries;
+};
+
 /**
  * Asynchronous worker object for populating the game list.
  * Communicates with other threads through Qt's signal/slot system.
@@ -141,8 +230,10 @@ class GameListWorker : public QObject, public QRunnable {
     Q_OBJECT
 
 public:
-    GameListWorker(FileSys::VirtualFilesystem vfs, QString dir_path, bool deep_scan)
-        : vfs(std::move(vfs)), dir_path(std::move(dir_path)), deep_scan(deep_scan) {}
+    GameListWorker(FileSys::VirtualFilesystem vfs, QString dir_path, bool deep_scan,
+                   std::shared_ptr<GameListCache> cache)
+        : vfs(std::move(vfs)), dir_path(std::move(dir_path)), deep_scan(deep_scan),
+          cache(std::move(cache)) {}
 
 public slots:
     /// Starts the processing of directory tree information.
@@ -152,11 +243,12 @@ public slots:
 
 signals:
     /**
-     * The `EntryReady` signal is emitted once an entry has been prepared and is ready
+     * The `EntriesReady` signal is emitted once a batch of entries has been prepared and is ready
      * to be added to the game list.
-     * @param entry_items a list with `QStandardItem`s that make up the columns of the new entry.
+     * @param entries a list of entries, each a list with the `QStandardItem`s that make up the
+     *                columns of the entry.
      */
-    void EntryReady(QList<QStandardItem*> entry_items);
+    void EntriesReady(QList<QList<QStandardItem*>> entries);
 
     /**
      * After the worker has traversed the game directory looking for entries, this signal is emmited
@@ -170,9 +262,23 @@ private:
     QStringList watch_list;
     QString dir_path;
     bool deep_scan;
+    std::shared_ptr<GameListCache> cache;
     std::atomic_bool stop_processing;
 
+    /// Game files found in the game directory, in the order they were found
+    std::vector<std::string> game_files;
+
+    /// Entries prepared since the last EntriesReady, batched to spare the GUI a queued call each
+    std::mutex pending_entries_mutex;
+    QList<QList<QStandardItem*>> pending_entries;
+
     void AddInstalledTitlesToGameList(std::shared_ptr<FileSys::RegisteredCache> cache);
     void FillControlMap(const std::string& dir_path);
     void AddFstEntriesToGameList(const std::string& dir_path, unsigned int recursion = 0);
+    void AddGameFilesToGameList();
+    void AddGameFile(const std::string& physical_name, FileSys::VirtualFile file);
+    void EmitGameFileEntry(const std::string& physical_name, const GameListMetadata& metadata);
+    /// Adds an entry to the next EntriesReady batch, emitting the batch once it is full
+    void QueueEntry(QList<QStandardItem*> entry_items);
+    void EmitPendingEntries();
 };
@@ -25,6 +25,7 @@
 #include "common/scm_rev.h"
 #include "common/scope_exit.h"
 #include "common/string_util.h"
+#include "common/trace.h"
 #include "core/core.h"
 #include "core/crypto/key_manager.h"
 #include "core/file_sys/bis_factory.h"
@@ -35,6 +36,7 @@
 #include "core/gdbstub/gdbstub.h"
 #include "core/loader/loader.h"
 #include "core/settings.h"
+#include "core/snapshot/snapshot.h"
 #include "video_core/debug_utils/debug_utils.h"
 #include "yuzu/about_dialog.h"
 #include "yuzu/bootmanager.h"
@@ -43,6 +45,7 @@
 #include "yuzu/debugger/console.h"
 #include "yuzu/debugger/graphics/graphics_breakpoints.h"
 #include "yuzu/debugger/graphics/graphics_surface.h"
+#include "yuzu/debugger/ipc_profiler.h"
 #include "yuzu/debugger/profiler.h"
 #include "yuzu/debugger/wait_tree.h"
 #include "yuzu/game_list.h"
@@ -178,8 +181,20 @@ void GMainWindow::InitializeWidgets() {
     emu_frametime_label->setToolTip(
         tr("Time taken to emulate a Switch frame, not counting framelimiting or v-sync. For "
            "full-speed emulation this should be at most 16.67 ms."));
-
-    for (auto& label : {emu_speed_label, game_fps_label, emu_frametime_label}) {
+    emu_present_label = new QLabel();
+    emu_present_label->setToolTip(
+        tr("Time spent presenting a frame, including any v-sync wait, and how much the time "
+           "between frames varies. A high variation shows up as stutter even at full speed."));
+    emu_audio_label = new QLabel();
+    emu_audio_label->setToolTip(
+        tr("How full the audio output queue is, the tempo audio is stretched to while emulation "
+           "is slow, the time from a sample being queued to it being heard, and how often the "
+           "queue ran dry (underruns) or overflowed (overruns) since the last update. Either one "
+           "is heard as crackling."));
+    boot_time_label = new QLabel();
+
+    for (auto& label : {emu_speed_label, game_fps_label, emu_frametime_label, emu_present_label,
+                        emu_audio_label, boot_time_label}) {
         label->setVisible(false);
         label->setFrameStyle(QFrame::NoFrame);
         label->setContentsMargins(4, 0, 4, 0);
@@ -216,6 +231,11 @@ void GMainWindow::InitializeDebugWidgets() {
             &WaitTreeWidget::OnEmulationStarting);
     connect(this, &GMainWindow::EmulationStopping, waitTreeWidget,
             &WaitTreeWidget::OnEmulationStopping);
+
+    ipcProfilerWidget = new IPCProfilerWidget(this);
+    addDockWidget(Qt::LeftDockWidgetArea, ipcProfilerWidget);
+    ipcProfilerWidget->hide();
+    debug_menu->addAction(ipcProfilerWidget->toggleViewAction());
 }
 
 void GMainWindow::InitializeRecentFileMenuActions() {
@@ -243,9 +263,12 @@ void GMainWindow::InitializeHotkeys() {
     hotkey_registry.RegisterHotkey("Main Window", "Start Emulation");
     hotkey_registry.RegisterHotkey("Main Window", "Continue/Pause", QKeySequence(Qt::Key_F4));
     hotkey_registry.RegisterHotkey("Main Window", "Restart", QKeySequence(Qt::Key_F5));
+    hotkey_registry.RegisterHotkey("Main Window", "Warm Restart", QKeySequence("CTRL+F5"));
     hotkey_registry.RegisterHotkey("Main Window", "Fullscreen", QKeySequence::FullScreen);
     hotkey_registry.RegisterHotkey("Main Window", "Exit Fullscreen", QKeySequence(Qt::Key_Escape),
                                    Qt::ApplicationShortcut);
+    hotkey_registry.RegisterHotkey("Main Window", "Save State", QKeySequence("SHIFT+F1"));
+    hotkey_registry.RegisterHotkey("Main Window", "Load State", QKeySequence(Qt::Key_F1));
     hotkey_registry.RegisterHotkey("Main Window", "Toggle Speed Limit", QKeySequence("CTRL+Z"),
                                    Qt::ApplicationShortcut);
     hotkey_registry.RegisterHotkey("Main Window", "Increase Speed Limit", QKeySequence("+"),
@@ -274,6 +297,13 @@ void GMainWindow::InitializeHotkeys() {
                     return;
                 BootGame(QString(game_path));
             });
+    connect(hotkey_registry.GetHotkey("Main Window", "Warm Restart", this), &QShortcut::activated,
+            this, [this] {
+                // Keeps the renderer and the parsed title, only the guest is started anew
+                if (emulation_running) {
+                    Core::System::GetInstance().RequestWarmRestart();
+                }
+            });
     connect(hotkey_registry.GetHotkey("Main Window", "Fullscreen", render_window),
             &QShortcut::activated, ui.action_Fullscreen, &QAction::trigger);
     connect(hotkey_registry.GetHotkey("Main Window", "Fullscreen", render_window),
@@ -285,6 +315,18 @@ void GMainWindow::InitializeHotkeys() {
                     ToggleFullscreen();
                 }
             });
+    connect(hotkey_registry.GetHotkey("Main Window", "Save State", this), &QShortcut::activated,
+            this, [this] {
+                if (emulation_running) {
+                    Core::System::GetInstance().SnapshotManager().RequestSave(0);
+                }
+            });
+    connect(hotkey_registry.GetHotkey("Main Window", "Load State", this), &QShortcut::activated,
+            this, [this] {
+                if (emulation_running) {
+                    Core::System::GetInstance().SnapshotManager().RequestLoad(0);
+                }
+            });
     connect(hotkey_registry.GetHotkey("Main Window", "Toggle Speed Limit", this),
             &QShortcut::activated, this, [&] {
                 Settings::values.use_frame_limit = !Settings::values.use_frame_limit;
@@ -339,6 +381,8 @@ void GMainWindow::RestoreUIState() {
     OnDisplayTitleBars(ui.action_Display_Dock_Widget_Headers->isChecked());
 
     ui.action_Show_Filter_Bar->setChecked(UISettings::values.show_filter_bar);
+    ui.action_Record_Trace->setChecked(Settings::values.record_trace);
+    ui.action_Save_Trace->setEnabled(Settings::values.record_trace);
     game_list->setFilterVisible(ui.action_Show_Filter_Bar->isChecked());
 
     ui.action_Show_Status_Bar->setChecked(UISettings::values.show_status_bar);
@@ -374,6 +418,8 @@ void GMainWindow::ConnectMenuEvents() {
     connect(ui.action_Stop, &QAction::triggered, this, &GMainWindow::OnStopGame);
     connect(ui.action_Restart, &QAction::triggered, this, [this] { BootGame(QString(game_path)); });
     connect(ui.action_Configure, &QAction::triggered, this, &GMainWindow::OnConfigure);
+    connect(ui.action_Record_Trace, &QAction::toggled, this, &GMainWindow::OnToggleRecordTrace);
+    connect(ui.action_Save_Trace, &QAction::triggered, this, &GMainWindow::OnSaveTrace);
 
     // View
     connect(ui.action_Single_Window_Mode, &QAction::triggered, this,
@@ -604,6 +650,9 @@ void GMainWindow::ShutdownGame() {
     emu_speed_label->setVisible(false);
     game_fps_label->setVisible(false);
     emu_frametime_label->setVisible(false);
+    emu_present_label->setVisible(false);
+    emu_audio_label->setVisible(false);
+    boot_time_label->setVisible(false);
 
     emulation_running = false;
 
@@ -727,34 +776,27 @@ void GMainWindow::OnMenuInstallToNAND() {
         return;
     }
 
-    const auto qt_raw_copy = [this](FileSys::VirtualFile src, FileSys::VirtualFile dest) {
+    const auto qt_raw_copy = [this](const FileSys::VirtualFile& src,
+                                    const FileSys::VirtualFile& dest,
+                                    Core::Crypto::SHA256Hash* hash) {
         if (src == nullptr || dest == nullptr)
             return false;
-        if (!dest->Resize(src->GetSize()))
-            return false;
-
-        std::array<u8, 0x1000> buffer{};
-        const int progress_maximum = static_cast<int>(src->GetSize() / buffer.size());
 
+        // Counted in MiB, as the size in bytes of large titles does not fit in an int
         QProgressDialog progress(
             tr("Installing file \"%1\"...").arg(QString::fromStdString(src->GetName())),
-            tr("Cancel"), 0, progress_maximum, this);
+            tr("Cancel"), 0, static_cast<int>(src->GetSize() >> 20), this);
         progress.setWindowModality(Qt::WindowModal);
 
-        for (size_t i = 0; i < src->GetSize(); i += buffer.size()) {
-            if (progress.wasCanceled()) {
-                dest->Resize(0);
-                return false;
-            }
-
-            const int progress_value = static_cast<int>(i / buffer.size());
-            progress.setValue(progress_value);
-
-            const auto read = src->Read(buffer.data(), buffer.size(), i);
-            dest->Write(buffer.data(), read, i);
-        }
+        const bool copied = FileSys::VfsPipelinedCopy(
+            src, dest, hash, [&progress](size_t copied_bytes, size_t total_bytes) {
+                progress.setValue(static_cast<int>(copied_bytes >> 20));
+                return !progress.wasCanceled();
+            });
 
-        return true;
+        if (!copied)
+            dest->Resize(0);
+        return copied;
     };
 
     const auto success = [this]() {
@@ -994,6 +1036,25 @@ void GMainWindow::OnConfigure() {
     }
 }
 
+void GMainWindow::OnToggleRecordTrace(bool checked) {
+    Settings::values.record_trace = checked;
+    Settings::Apply();
+    ui.action_Save_Trace->setEnabled(checked);
+}
+
+void GMainWindow::OnSaveTrace() {
+    const QString path = QFileDialog::getSaveFileName(this, tr("Save Trace"), QString(),
+                                                      tr("Chrome Trace (*.json)"));
+    if (path.isEmpty()) {
+        return;
+    }
+
+    if (!Common::Trace::WriteChromeTrace(path.toStdString())) {
+        QMessageBox::critical(this, tr("Error while saving trace"),
+                              tr("The trace could not be written to %1.").arg(path));
+    }
+}
+
 void GMainWindow::OnAbout() {
     AboutDialog aboutDialog(this);
     aboutDialog.exec();
@@ -1014,7 +1075,8 @@ void GMainWindow::UpdateStatusBar() {
         return;
     }
 
-    auto results = Core::System::GetInstance().GetAndResetPerfStats();
+    auto& system = Core::System::GetInstance();
+    auto results = system.GetAndResetPerfStats();
 
     if (Settings::values.use_frame_limit) {
         emu_speed_label->setText(tr("Speed: %1% / %2%")
@@ -1024,11 +1086,53 @@ void GMainWindow::UpdateStatusBar() {
         emu_speed_label->setText(tr("Speed: %1%").arg(results.emulation_speed * 100.0, 0, 'f', 0));
     }
     game_fps_label->setText(tr("Game: %1 FPS").arg(results.game_fps, 0, 'f', 0));
-    emu_frametime_label->setText(tr("Frame: %1 ms").arg(results.frametime * 1000.0, 0, 'f', 2));
+    emu_frametime_label->setText(tr("Frame: %1 ms (1% low: %2 FPS)")
+                                     .arg(results.frametime * 1000.0, 0, 'f', 2)
+                                     .arg(results.low_1_percent_fps, 0, 'f', 0));
+    QString histogram;
+    for (std::size_t i = 0; i < results.frame_length_histogram.size(); ++i) {
+        const u32 count = results.frame_length_histogram[i];
+        if (count == 0) {
+            continue;
+        }
+        const double bucket_ms = Core::PerfStats::HistogramBucketLength * 1000.0;
+        histogram += tr("\n%1 ms: %2 frames").arg(i * bucket_ms, 0, 'f', 0).arg(count);
+    }
+    emu_frametime_label->setToolTip(
+        tr("Time taken to emulate a Switch frame, not counting framelimiting or v-sync. For "
+           "full-speed emulation this should be at most 16.67 ms.\n\n"
+           "GPU command processing: %1 ms, frame limiter: %2 ms\n"
+           "Average of the slowest 1% of frames: %3 FPS, of the slowest 0.1%: %4 FPS\n\n"
+           "Frame lengths:%5")
+            .arg(results.gpu_time * 1000.0, 0, 'f', 2)
+            .arg(results.limiter_time * 1000.0, 0, 'f', 2)
+            .arg(results.low_1_percent_fps, 0, 'f', 1)
+            .arg(results.low_0_1_percent_fps, 0, 'f', 1)
+            .arg(histogram));
+    emu_present_label->setText(tr("Present: %1 ms (\u00B1%2 ms)")
+                                   .arg(results.present_time * 1000.0, 0, 'f', 2)
+                                   .arg(results.frametime_deviation * 1000.0, 0, 'f', 2));
+    emu_audio_label->setText(tr("Audio: %1% @ %2x, %3 ms (%4 under, %5 over)")
+                                 .arg(results.audio_queue_level * 100.0, 0, 'f', 0)
+                                 .arg(results.audio_stretch_ratio, 0, 'f', 2)
+                                 .arg(results.audio_latency * 1000.0, 0, 'f', 0)
+                                 .arg(results.audio_underruns)
+                                 .arg(results.audio_overruns));
 
     emu_speed_label->setVisible(true);
     game_fps_label->setVisible(true);
     emu_frametime_label->setVisible(true);
+    emu_present_label->setVisible(true);
+    emu_audio_label->setVisible(true);
+
+    if (!boot_time_label->isVisible() && system.boot_timeline.IsComplete()) {
+        boot_time_label->setText(
+            tr("Boot: %1 ms").arg(system.boot_timeline.GetTotalTime().count() / 1000));
+        boot_time_label->setToolTip(
+            tr("Time from starting the game to its first frame, split up by phase:\n\n%1")
+                .arg(QString::fromStdString(system.boot_timeline.FormatPhases())));
+        boot_time_label->setVisible(true);
+    }
 }
 
 void GMainWindow::OnCoreError(Core::System::ResultStatus result, std::string details) {
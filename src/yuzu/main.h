@@ -18,6 +18,7 @@ class GImageInfo;
 class GraphicsBreakPointsWidget;
 class GraphicsSurfaceWidget;
 class GRenderWindow;
+class IPCProfilerWidget;
 class MicroProfileDialog;
 class ProfilerWidget;
 class WaitTreeWidget;
@@ -131,6 +132,8 @@ private slots:
     void OnMenuSelectGameListRoot();
     void OnMenuRecentFile();
     void OnConfigure();
+    void OnToggleRecordTrace(bool checked);
+    void OnSaveTrace();
     void OnAbout();
     void OnToggleFilterBar();
     void OnDisplayTitleBars(bool);
@@ -155,6 +158,9 @@ private:
     QLabel* emu_speed_label = nullptr;
     QLabel* game_fps_label = nullptr;
     QLabel* emu_frametime_label = nullptr;
+    QLabel* emu_present_label = nullptr;
+    QLabel* emu_audio_label = nullptr;
+    QLabel* boot_time_label = nullptr;
     QTimer status_bar_update_timer;
 
     std::unique_ptr<Config> config;
@@ -174,6 +180,7 @@ private:
     GraphicsBreakPointsWidget* graphicsBreakpointsWidget;
     GraphicsSurfaceWidget* graphicsSurfaceWidget;
     WaitTreeWidget* waitTreeWidget;
+    IPCProfilerWidget* ipcProfilerWidget;
 
     QAction* actions_recent_files[max_recent_files_item];
 
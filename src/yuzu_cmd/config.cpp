@@ -92,8 +92,13 @@ void Config::ReadValues() {
     // Core
     Settings::values.use_cpu_jit = sdl2_config->GetBoolean("Core", "use_cpu_jit", true);
     Settings::values.use_multi_core = sdl2_config->GetBoolean("Core", "use_multi_core", false);
+    Settings::values.pin_cpu_core_threads =
+        sdl2_config->GetBoolean("Core", "pin_cpu_core_threads", false);
 
     // Renderer
+    Settings::values.renderer_backend = static_cast<Settings::RendererBackend>(
+        sdl2_config->GetInteger("Renderer", "renderer_backend",
+                                static_cast<long>(Settings::RendererBackend::OpenGL)));
     Settings::values.resolution_factor =
         (float)sdl2_config->GetReal("Renderer", "resolution_factor", 1.0);
     Settings::values.use_frame_limit = sdl2_config->GetBoolean("Renderer", "use_frame_limit", true);
@@ -101,6 +106,16 @@ void Config::ReadValues() {
         static_cast<u16>(sdl2_config->GetInteger("Renderer", "frame_limit", 100));
     Settings::values.use_accurate_framebuffers =
         sdl2_config->GetBoolean("Renderer", "use_accurate_framebuffers", false);
+    Settings::values.max_surface_cache_size = static_cast<u32>(
+        sdl2_config->GetInteger("Renderer", "max_surface_cache_size", 1024));
+    Settings::values.use_disk_shader_cache =
+        sdl2_config->GetBoolean("Renderer", "use_disk_shader_cache", true);
+    Settings::values.use_asynchronous_shaders =
+        sdl2_config->GetBoolean("Renderer", "use_asynchronous_shaders", false);
+    Settings::values.use_asynchronous_gpu_emulation =
+        sdl2_config->GetBoolean("Renderer", "use_asynchronous_gpu_emulation", false);
+    Settings::values.present_mode = static_cast<Settings::PresentMode>(sdl2_config->GetInteger(
+        "Renderer", "present_mode", static_cast<long>(Settings::PresentMode::Fifo)));
 
     Settings::values.bg_red = (float)sdl2_config->GetReal("Renderer", "bg_red", 0.0);
     Settings::values.bg_green = (float)sdl2_config->GetReal("Renderer", "bg_green", 0.0);
@@ -110,10 +125,22 @@ void Config::ReadValues() {
     Settings::values.sink_id = sdl2_config->Get("Audio", "output_engine", "auto");
     Settings::values.audio_device_id = sdl2_config->Get("Audio", "output_device", "auto");
     Settings::values.volume = sdl2_config->GetReal("Audio", "volume", 1);
+    Settings::values.enable_audio_stretching =
+        sdl2_config->GetBoolean("Audio", "enable_audio_stretching", true);
+    Settings::values.audio_sink_latency =
+        static_cast<u32>(sdl2_config->GetInteger("Audio", "sink_latency", 512));
+    Settings::values.audio_mix_quantum =
+        static_cast<u32>(sdl2_config->GetInteger("Audio", "mix_quantum", 512));
+    Settings::values.audio_queue_depth =
+        static_cast<u32>(sdl2_config->GetInteger("Audio", "queue_depth", 3));
 
     // Data Storage
     Settings::values.use_virtual_sd =
         sdl2_config->GetBoolean("Data Storage", "use_virtual_sd", true);
+    Settings::values.decrypted_cache_size =
+        static_cast<u32>(sdl2_config->GetInteger("Data Storage", "decrypted_cache_size", 64));
+    Settings::values.verify_nca_hashes =
+        sdl2_config->GetBoolean("Data Storage", "verify_nca_hashes", false);
 
     // System
     Settings::values.use_docked_mode = sdl2_config->GetBoolean("System", "use_docked_mode", false);
@@ -126,6 +153,11 @@ void Config::ReadValues() {
     Settings::values.use_gdbstub = sdl2_config->GetBoolean("Debugging", "use_gdbstub", false);
     Settings::values.gdbstub_port =
         static_cast<u16>(sdl2_config->GetInteger("Debugging", "gdbstub_port", 24689));
+    Settings::values.record_trace = sdl2_config->GetBoolean("Debugging", "record_trace", false);
+    Settings::values.memory_log_interval =
+        static_cast<u32>(sdl2_config->GetInteger("Debugging", "memory_log_interval", 0));
+    Settings::values.validate_warm_restart =
+        sdl2_config->GetBoolean("Debugging", "validate_warm_restart", true);
 }
 
 void Config::Reload() {
@@ -84,10 +84,14 @@ use_cpu_jit =
 # 0 (default): Disabled, 1: Enabled
 use_multi_core=
 
+# Whether to pin the host threads of emulated CPU cores 1-3 to the host cores of the same index
+# 0 (default): Disabled, 1: Enabled
+pin_cpu_core_threads =
+
 [Renderer]
-# Whether to use software or hardware rendering.
-# 0: Software, 1 (default): Hardware
-use_hw_renderer =
+# Which graphics API the GPU is emulated with.
+# 0 (default): OpenGL
+renderer_backend =
 
 # Whether to use the Just-In-Time (JIT) compiler for shader emulation
 # 0: Interpreter (slow), 1 (default): JIT (fast)
@@ -98,9 +102,12 @@ use_shader_jit =
 # factor for the Switch resolution
 resolution_factor =
 
-# Whether to enable V-Sync (caps the framerate at 60FPS) or not.
-# 0 (default): Off, 1: On
-use_vsync =
+# How frames are presented to the display.
+# 0: Immediate, presents right away and may tear
+# 1 (default): FIFO, waits for the vertical blank (V-Sync)
+# 2: Relaxed FIFO, waits for the vertical blank unless the frame is late, which tears instead of
+#    stalling for a whole refresh. Falls back to FIFO if the driver doesn't support it.
+present_mode =
 
 # Turns on the frame limiter, which will limit frames output to the target game speed
 # 0: Off, 1: On (default)
@@ -114,6 +121,27 @@ frame_limit =
 # 0 (default): Off (fast), 1 : On (slow)
 use_accurate_framebuffers =
 
+# Host memory the rasterizer cache may hold in surfaces before evicting the least recently used
+# ones, in MiB. Surfaces the GPU rendered to are only evicted once written back to memory.
+# 0: No limit, 1024 (default)
+max_surface_cache_size =
+
+# Whether to store the shaders of each title on disk and load them when it boots, instead of
+# compiling them again when they are first used
+# 0: Off, 1 (default): On
+use_disk_shader_cache =
+
+# What to do with draws whose shaders are not compiled yet. Skipping them needs a driver that can
+# compile shaders in the background (GL_ARB_parallel_shader_compile), and shows up as missing
+# geometry for a few frames instead of a stutter.
+# 0 (default): Wait for the shaders to compile, 1: Skip the draw
+use_asynchronous_shaders =
+
+# Whether to process the command lists of the guest on a host thread of their own, which lets the
+# emulated CPU run ahead of the GPU by up to a frame
+# 0 (default): Off, 1: On
+use_asynchronous_gpu_emulation =
+
 # The clear color for the renderer. What shows up on the sides of the bottom screen.
 # Must be in range of 0.0-1.0. Defaults to 1.0 for all.
 bg_red =
@@ -158,11 +186,40 @@ output_device =
 # 1.0 (default): 100%, 0.0; mute
 volume =
 
+# Whether to slow audio down while emulation runs below full speed, to avoid crackling.
+# This adds up to 200ms of latency while it is active, less while audio plays without gaps.
+# 0: No, 1 (default): Yes
+enable_audio_stretching =
+
+# Latency requested from the audio backend, in frames at 48kHz. Lower values need more CPU
+# headroom to avoid crackling. Never goes below the minimum the backend supports.
+# 0: Backend minimum, 512 (default)
+sink_latency =
+
+# Frames mixed per audio renderer buffer, from 64 to 4096. Smaller buffers lower the latency.
+# 512 (default)
+mix_quantum =
+
+# Number of mixed buffers queued ahead of playback, from 2 to 8. Larger queues ride out longer
+# hiccups at the cost of latency.
+# 3 (default)
+queue_depth =
+
 [Data Storage]
 # Whether to create a virtual SD card.
 # 1 (default): Yes, 0: No
 use_virtual_sd =
 
+# Memory kept for recently read decrypted game data, in MiB shared by all content.
+# Data read again from this cache is not decrypted again.
+# 0: Disabled, 64 (default)
+decrypted_cache_size =
+
+# Whether to check game data against the hashes in its NCAs as it is read, to catch corrupted dumps.
+# Each block is only checked the first time it is read.
+# 0 (default): No, 1: Yes
+verify_nca_hashes =
+
 [System]
 # Whether the system is docked
 # 1: Yes, 0 (default): No
@@ -191,6 +248,16 @@ log_filter = *:Trace
 # Port for listening to GDB connections.
 use_gdbstub=false
 gdbstub_port=24689
+# Records a timeline of the emulator threads, written out as a Chrome trace with F12
+# 0 (default): Off, 1: On
+record_trace =
+# Interval in seconds between the summaries of the emulator's memory use written to the log
+# 0 (default): No summaries
+memory_log_interval =
+# Whether to check that the title file is unchanged before a warm restart (F11) reuses what was
+# parsed from it, the title is loaded from scratch if it changed
+# 0: No, 1 (default): Yes
+validate_warm_restart =
 
 [WebService]
 # Whether or not to enable telemetry
@@ -0,0 +1,198 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <cstdlib>
+#include <utility>
+#include <vector>
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#include <fmt/format.h>
+#include <glad/glad.h>
+#include "common/file_util.h"
+#include "common/logging/log.h"
+#include "common/scm_rev.h"
+#include "core/frontend/framebuffer_layout.h"
+#include "core/settings.h"
+#include "input_common/main.h"
+#include "yuzu_cmd/emu_window/emu_window_egl.h"
+#include "yuzu_cmd/emu_window/emu_window_sdl2.h"
+
+/// Opens a display needing neither a display server nor a window system, if the driver has one
+static EGLDisplay OpenDisplay() {
+#if defined(EGL_EXT_platform_base) && defined(EGL_EXT_device_enumeration)
+    const auto get_platform_display = reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(
+        eglGetProcAddress("eglGetPlatformDisplayEXT"));
+    const auto query_devices =
+        reinterpret_cast<PFNEGLQUERYDEVICESEXTPROC>(eglGetProcAddress("eglQueryDevicesEXT"));
+
+    // Drivers that don't need a display server expose each GPU as a device, use the first one
+    EGLDeviceEXT device;
+    EGLint num_devices = 0;
+    if (get_platform_display != nullptr && query_devices != nullptr &&
+        query_devices(1, &device, &num_devices) && num_devices > 0) {
+        const EGLDisplay display = get_platform_display(EGL_PLATFORM_DEVICE_EXT, device, nullptr);
+        if (display != EGL_NO_DISPLAY) {
+            return display;
+        }
+    }
+
+#ifdef EGL_MESA_platform_surfaceless
+    if (get_platform_display != nullptr) {
+        const EGLDisplay display =
+            get_platform_display(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+        if (display != EGL_NO_DISPLAY) {
+            return display;
+        }
+    }
+#endif
+#endif
+    return eglGetDisplay(EGL_DEFAULT_DISPLAY);
+}
+
+static void* GetGLProcAddress(const char* name) {
+    return reinterpret_cast<void*>(eglGetProcAddress(name));
+}
+
+EmuWindow_EGL::EmuWindow_EGL(u32 dump_interval, std::string dump_dir)
+    : dump_interval(dump_interval), dump_dir(std::move(dump_dir)) {
+    InputCommon::Init();
+
+    display = OpenDisplay();
+    if (display == EGL_NO_DISPLAY || !eglInitialize(display, nullptr, nullptr)) {
+        LOG_CRITICAL(Frontend, "Failed to initialize EGL! Exiting...");
+        exit(1);
+    }
+    if (!eglBindAPI(EGL_OPENGL_API)) {
+        LOG_CRITICAL(Frontend, "EGL does not support desktop OpenGL! Exiting...");
+        exit(1);
+    }
+
+    // Prefer a config with pbuffers, settle for one without any surface otherwise
+    EGLint config_attributes[] = {
+        EGL_SURFACE_TYPE, EGL_PBUFFER_BIT, EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT, EGL_RED_SIZE, 8,
+        EGL_GREEN_SIZE,   8,               EGL_BLUE_SIZE,       8,              EGL_NONE,
+    };
+    EGLConfig config;
+    EGLint num_configs = 0;
+    const bool has_pbuffer =
+        eglChooseConfig(display, config_attributes, &config, 1, &num_configs) && num_configs > 0;
+    if (!has_pbuffer) {
+        config_attributes[1] = 0;
+        if (!eglChooseConfig(display, config_attributes, &config, 1, &num_configs) ||
+            num_configs == 0) {
+            LOG_CRITICAL(Frontend, "No suitable EGL config! Exiting...");
+            exit(1);
+        }
+    }
+
+    const EGLint context_attributes[] = {
+        EGL_CONTEXT_MAJOR_VERSION,
+        3,
+        EGL_CONTEXT_MINOR_VERSION,
+        3,
+        EGL_CONTEXT_OPENGL_PROFILE_MASK,
+        EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+        EGL_NONE,
+    };
+    context = eglCreateContext(display, config, EGL_NO_CONTEXT, context_attributes);
+    if (context == EGL_NO_CONTEXT) {
+        LOG_CRITICAL(Frontend, "Failed to create EGL GL context! Error {:#x}", eglGetError());
+        exit(1);
+    }
+
+    const EGLint width = Layout::ScreenUndocked::Width;
+    const EGLint height = Layout::ScreenUndocked::Height;
+    if (has_pbuffer) {
+        const EGLint surface_attributes[] = {EGL_WIDTH, width, EGL_HEIGHT, height, EGL_NONE};
+        surface = eglCreatePbufferSurface(display, config, surface_attributes);
+        if (surface == EGL_NO_SURFACE) {
+            LOG_CRITICAL(Frontend, "Failed to create EGL pbuffer! Error {:#x}", eglGetError());
+            exit(1);
+        }
+    } else {
+        // Without a default framebuffer there's nothing to present to
+        LOG_WARNING(Frontend, "EGL has no pbuffers, frames will not be presented");
+        Settings::values.skip_present = true;
+    }
+
+    MakeCurrent();
+    if (!gladLoadGLLoader(GetGLProcAddress)) {
+        LOG_CRITICAL(Frontend, "Failed to initialize GL functions! Exiting...");
+        exit(1);
+    }
+    if (!EmuWindow_SDL2::SupportsRequiredGLExtensions()) {
+        LOG_CRITICAL(Frontend, "GPU does not support all required OpenGL extensions! Exiting...");
+        exit(1);
+    }
+
+    UpdateCurrentFramebufferLayout(width, height);
+    if (this->dump_interval != 0) {
+        FileUtil::CreateFullPath(this->dump_dir);
+    }
+    LOG_INFO(Frontend, "yuzu Version: {} | {}-{}", Common::g_build_name, Common::g_scm_branch,
+             Common::g_scm_desc);
+    LOG_INFO(Frontend, "Rendering offscreen with EGL {}", eglQueryString(display, EGL_VERSION));
+
+    DoneCurrent();
+}
+
+EmuWindow_EGL::~EmuWindow_EGL() {
+    if (surface != EGL_NO_SURFACE) {
+        eglDestroySurface(display, surface);
+    }
+    eglDestroyContext(display, context);
+    eglTerminate(display);
+
+    InputCommon::Shutdown();
+}
+
+void EmuWindow_EGL::SwapBuffers() {
+    if (dump_interval != 0 && presented_frames % dump_interval == 0) {
+        DumpFrame();
+    }
+    ++presented_frames;
+
+    // A pbuffer is single buffered, this only flushes the rendering
+    eglSwapBuffers(display, surface);
+}
+
+void EmuWindow_EGL::MakeCurrent() {
+    eglMakeCurrent(display, surface, surface, context);
+}
+
+void EmuWindow_EGL::DoneCurrent() {
+    eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+}
+
+void EmuWindow_EGL::DumpFrame() {
+    const auto& layout = GetFramebufferLayout();
+    const u32 width = layout.width;
+    const u32 height = layout.height;
+
+    // Rows of RGBA pixels are always aligned, so the pack alignment doesn't matter
+    std::vector<u8> pixels(width * height * 4);
+    GLint read_framebuffer;
+    glGetIntegerv(GL_READ_FRAMEBUFFER_BINDING, &read_framebuffer);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+    glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, read_framebuffer);
+
+    // PPM stores the top row first and no alpha, GL returns the bottom row first
+    std::vector<u8> image;
+    image.reserve(width * height * 3);
+    for (u32 y = height; y-- > 0;) {
+        const u8* row = pixels.data() + y * width * 4;
+        for (u32 x = 0; x < width; ++x) {
+            image.insert(image.end(), row + x * 4, row + x * 4 + 3);
+        }
+    }
+
+    const std::string path = fmt::format("{}frame_{:08}.ppm", dump_dir, presented_frames);
+    FileUtil::IOFile file(path, "wb");
+    const std::string header = fmt::format("P6\n{} {}\n255\n", width, height);
+    if (!file.IsOpen() || file.WriteBytes(header.data(), header.size()) != header.size() ||
+        file.WriteBytes(image.data(), image.size()) != image.size()) {
+        LOG_ERROR(Frontend, "Could not write frame to {}", path);
+    }
+}
@@ -0,0 +1,55 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <string>
+#include "common/common_types.h"
+#include "core/frontend/emu_window.h"
+
+/**
+ * Window that renders offscreen through EGL, for running without a display, such as on GPU
+ * servers. Frames are drawn to a pbuffer the size of the undocked screen, which can be dumped to
+ * disk. On platforms without pbuffers, such as Mesa's surfaceless one, there's no surface at all
+ * and frames are never presented.
+ */
+class EmuWindow_EGL final : public Core::Frontend::EmuWindow {
+public:
+    /**
+     * @param dump_interval Writes every dump_interval-th presented frame to dump_dir as a PPM
+     * image, 0 dumps none.
+     * @param dump_dir Directory to write the frames to, ending in a separator.
+     */
+    EmuWindow_EGL(u32 dump_interval, std::string dump_dir);
+    ~EmuWindow_EGL();
+
+    /// Presents the next frame, dumping it if it's due
+    void SwapBuffers() override;
+
+    /// There are no window events to poll
+    void PollEvents() override {}
+
+    /// Makes the graphics context current for the caller thread
+    void MakeCurrent() override;
+
+    /// Releases the GL context from the caller thread
+    void DoneCurrent() override;
+
+private:
+    /// Writes the current contents of the pbuffer to the next file in dump_dir
+    void DumpFrame();
+
+    using EGLDisplay = void*;
+    using EGLSurface = void*;
+    using EGLContext = void*;
+
+    EGLDisplay display = nullptr;
+    /// Pbuffer frames are drawn to, null without one
+    EGLSurface surface = nullptr;
+    EGLContext context = nullptr;
+
+    u32 dump_interval;
+    std::string dump_dir;
+    u64 presented_frames = 0;
+};
@@ -9,10 +9,14 @@
 #include <SDL.h>
 #include <fmt/format.h>
 #include <glad/glad.h>
+#include "common/file_util.h"
 #include "common/logging/log.h"
 #include "common/scm_rev.h"
 #include "common/string_util.h"
+#include "common/trace.h"
+#include "core/core.h"
 #include "core/settings.h"
+#include "core/snapshot/snapshot.h"
 #include "input_common/keyboard.h"
 #include "input_common/main.h"
 #include "input_common/motion_emu.h"
@@ -40,6 +44,40 @@ void EmuWindow_SDL2::OnMouseButton(u32 button, u8 state, s32 x, s32 y) {
 }
 
 void EmuWindow_SDL2::OnKeyEvent(int key, u8 state) {
+    if (key == SDL_SCANCODE_F12 && state == SDL_PRESSED && Common::Trace::IsRecording()) {
+        const std::string path =
+            FileUtil::GetUserPath(FileUtil::UserPath::LogDir) + "yuzu_trace.json";
+        if (Common::Trace::WriteChromeTrace(path)) {
+            LOG_INFO(Frontend, "Wrote trace to {}", path);
+        } else {
+            LOG_ERROR(Frontend, "Could not write trace to {}", path);
+        }
+        return;
+    }
+
+    if (key == SDL_SCANCODE_F11) {
+        // F11 restarts the title, keeping the renderer and what was parsed from the title file
+        auto& system = Core::System::GetInstance();
+        if (state == SDL_PRESSED && system.IsPoweredOn()) {
+            system.RequestWarmRestart();
+        }
+        return;
+    }
+
+    if (key >= SDL_SCANCODE_F1 && key <= SDL_SCANCODE_F10) {
+        // F1-F10 load the snapshot in their slot, and save it with shift held
+        auto& system = Core::System::GetInstance();
+        if (state == SDL_PRESSED && system.IsPoweredOn()) {
+            const std::size_t slot = static_cast<std::size_t>(key - SDL_SCANCODE_F1);
+            if (SDL_GetModState() & KMOD_SHIFT) {
+                system.SnapshotManager().RequestSave(slot);
+            } else {
+                system.SnapshotManager().RequestLoad(slot);
+            }
+        }
+        return;
+    }
+
     if (state == SDL_PRESSED) {
         InputCommon::GetKeyboard()->PressKey(key);
     } else if (state == SDL_RELEASED) {
@@ -163,6 +201,8 @@ EmuWindow_SDL2::EmuWindow_SDL2(bool fullscreen) {
         exit(1);
     }
 
+    SetSwapInterval();
+
     OnResize();
     OnMinimalClientAreaChangeRequest(GetActiveConfig().min_client_area_size);
     SDL_PumpEvents();
@@ -172,6 +212,26 @@ EmuWindow_SDL2::EmuWindow_SDL2(bool fullscreen) {
     DoneCurrent();
 }
 
+void EmuWindow_SDL2::SetSwapInterval() {
+    switch (Settings::values.present_mode) {
+    case Settings::PresentMode::Immediate:
+        SDL_GL_SetSwapInterval(0);
+        break;
+    case Settings::PresentMode::FifoRelaxed:
+        // Adaptive v-sync needs EXT_swap_control_tear, fall back to regular v-sync without it
+        if (SDL_GL_SetSwapInterval(-1) == 0) {
+            break;
+        }
+        LOG_WARNING(Frontend, "Adaptive v-sync is not supported, using regular v-sync instead");
+        SDL_GL_SetSwapInterval(1);
+        break;
+    case Settings::PresentMode::Fifo:
+    default:
+        SDL_GL_SetSwapInterval(1);
+        break;
+    }
+}
+
 EmuWindow_SDL2::~EmuWindow_SDL2() {
     SDL_GL_DeleteContext(gl_context);
     SDL_Quit();
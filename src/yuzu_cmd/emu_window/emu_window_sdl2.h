@@ -30,6 +30,9 @@ public:
     /// Whether the window is still open, and a close request hasn't yet been sent
     bool IsOpen() const;
 
+    /// Whether the GPU and driver of the current GL context support the required extensions
+    static bool SupportsRequiredGLExtensions();
+
 private:
     /// Called by PollEvents when a key is pressed or released.
     void OnKeyEvent(int key, u8 state);
@@ -43,12 +46,12 @@ private:
     /// Called by PollEvents when any event that may cause the window to be resized occurs
     void OnResize();
 
+    /// Applies the configured present mode to the current GL context
+    void SetSwapInterval();
+
     /// Called when user passes the fullscreen parameter flag
     void Fullscreen();
 
-    /// Whether the GPU and driver supports the OpenGL extension required
-    bool SupportsRequiredGLExtensions();
-
     /// Called when a configuration change affects the minimal size of the window
     void OnMinimalClientAreaChangeRequest(
         const std::pair<unsigned, unsigned>& minimal_size) override;
@@ -0,0 +1,470 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <numeric>
+#include <string>
+#include <vector>
+
+#include <boost/icl/interval_set.hpp>
+#include <fmt/format.h>
+#include <glad/glad.h>
+
+#include "common/alignment.h"
+#include "common/assert.h"
+#include "common/common_paths.h"
+#include "common/file_util.h"
+#include "common/logging/backend.h"
+#include "common/logging/filter.h"
+#include "common/logging/log.h"
+#include "common/scm_rev.h"
+#include "common/scope_exit.h"
+#include "core/core.h"
+#include "core/hle/kernel/process.h"
+#include "core/hle/kernel/vm_manager.h"
+#include "core/memory.h"
+#include "core/settings.h"
+#include "core/tracer/gpu_trace.h"
+#include "video_core/gpu.h"
+#include "video_core/rasterizer_interface.h"
+#include "video_core/renderer_base.h"
+#include "yuzu_cmd/config.h"
+#include "yuzu_cmd/emu_window/emu_window_sdl2.h"
+#ifdef HAS_EGL
+#include "yuzu_cmd/emu_window/emu_window_egl.h"
+#endif
+
+#include <getopt.h>
+
+#ifdef _WIN32
+extern "C" {
+// tells Nvidia and AMD drivers to use the dedicated GPU by default on laptops with switchable
+// graphics
+__declspec(dllexport) unsigned long NvOptimusEnablement = 0x00000001;
+__declspec(dllexport) int AmdPowerXpressRequestHighPerformance = 1;
+}
+#endif
+
+static void PrintHelp(const char* argv0) {
+    std::cout << "Usage: " << argv0
+              << " [options] <trace file>\n"
+                 "Replays a GPU trace recorded with yuzu-cmd --trace-gpu and prints the CPU and\n"
+                 "GPU time of every frame.\n"
+                 "-l, --loops=NUMBER    Replay the trace NUMBER times and report the last one,\n"
+                 "                      the earlier ones warm up the caches (default 1)\n"
+                 "-r, --report=FORMAT   Print the statistics as text (default) or json\n"
+                 "-o, --offscreen       Render offscreen through EGL, without a window\n"
+                 "-h, --help            Display this help and exit\n"
+                 "-v, --version         Output version information and exit\n";
+}
+
+static void PrintVersion() {
+    std::cout << "yuzu-gpu-replay " << Common::g_scm_branch << " " << Common::g_scm_desc
+              << std::endl;
+}
+
+enum class ReportFormat {
+    Text,
+    Json,
+};
+
+struct FrameTimes {
+    /// Time spent processing the command lists of the frame and presenting it, in milliseconds
+    double cpu_ms;
+    /// Time the host GPU spent on the commands issued for the frame, in milliseconds
+    double gpu_ms;
+};
+
+/// Value below which the given fraction of the sorted samples lies, by nearest rank
+static double Percentile(const std::vector<double>& sorted, double fraction) {
+    if (sorted.empty()) {
+        return 0.0;
+    }
+    const auto rank = static_cast<std::size_t>(std::ceil(fraction * sorted.size()));
+    return sorted[std::clamp<std::size_t>(rank, 1, sorted.size()) - 1];
+}
+
+struct Summary {
+    double mean;
+    double p50;
+    double p90;
+    double max;
+};
+
+static Summary Summarize(std::vector<double> samples) {
+    std::sort(samples.begin(), samples.end());
+    if (samples.empty()) {
+        return {};
+    }
+    const double mean = std::accumulate(samples.begin(), samples.end(), 0.0) / samples.size();
+    return {mean, Percentile(samples, 0.50), Percentile(samples, 0.90), samples.back()};
+}
+
+/// Prints the times of the replayed frames to stdout
+static void PrintReport(ReportFormat format, const std::vector<FrameTimes>& frames) {
+    std::vector<double> cpu_times;
+    std::vector<double> gpu_times;
+    for (const auto& frame : frames) {
+        cpu_times.push_back(frame.cpu_ms);
+        gpu_times.push_back(frame.gpu_ms);
+    }
+    const Summary cpu = Summarize(std::move(cpu_times));
+    const Summary gpu = Summarize(std::move(gpu_times));
+
+    if (format == ReportFormat::Text) {
+        fmt::print("Frame    CPU ms    GPU ms\n");
+        for (std::size_t i = 0; i < frames.size(); ++i) {
+            fmt::print("{:5} {:9.3f} {:9.3f}\n", i, frames[i].cpu_ms, frames[i].gpu_ms);
+        }
+        fmt::print("Frames: {}\n", frames.size());
+        fmt::print("CPU time: mean {:.3f} ms, p50 {:.3f} ms, p90 {:.3f} ms, max {:.3f} ms\n",
+                   cpu.mean, cpu.p50, cpu.p90, cpu.max);
+        fmt::print("GPU time: mean {:.3f} ms, p50 {:.3f} ms, p90 {:.3f} ms, max {:.3f} ms\n",
+                   gpu.mean, gpu.p50, gpu.p90, gpu.max);
+        return;
+    }
+
+    std::string frame_list;
+    for (const auto& frame : frames) {
+        if (!frame_list.empty()) {
+            frame_list += ',';
+        }
+        frame_list += fmt::format("{{\"cpu_ms\":{:.6f},\"gpu_ms\":{:.6f}}}", frame.cpu_ms,
+                                  frame.gpu_ms);
+    }
+    const auto format_summary = [](const Summary& summary) {
+        return fmt::format("{{\"mean\":{:.6f},\"p50\":{:.6f},\"p90\":{:.6f},\"max\":{:.6f}}}",
+                           summary.mean, summary.p50, summary.p90, summary.max);
+    };
+    fmt::print("{{\"frames\":[{}],\"cpu_ms\":{},\"gpu_ms\":{}}}\n", frame_list,
+               format_summary(cpu), format_summary(gpu));
+}
+
+static void InitializeLogging() {
+    Log::Filter log_filter(Log::Level::Debug);
+    log_filter.ParseFilterString(Settings::values.log_filter);
+    Log::SetGlobalFilter(log_filter);
+
+    Log::AddBackend(std::make_unique<Log::ColorConsoleBackend>());
+
+    const std::string& log_dir = FileUtil::GetUserPath(FileUtil::UserPath::LogDir);
+    FileUtil::CreateFullPath(log_dir);
+    Log::AddBackend(std::make_unique<Log::FileBackend>(log_dir + LOG_FILE));
+}
+
+/**
+ * Feeds the records of a GPU trace to the emulated GPU. Guest memory is backed by blocks mapped
+ * into the current process, so the GPU and the rasterizer read it the way they do when a title
+ * runs.
+ */
+class TraceReplayer {
+public:
+    explicit TraceReplayer(Core::System& system) : system(system) {
+        Memory::SetCurrentPageTable(&system.CurrentProcess()->vm_manager.page_table);
+    }
+
+    /// Replays the whole trace once into an empty list of frames, returns false if it's malformed
+    bool Replay(const std::string& filename, const EmuWindow_SDL2* sdl_window,
+                std::vector<FrameTimes>& frames) {
+        GPUTrace::Reader reader(filename);
+        if (!reader.IsValid()) {
+            LOG_CRITICAL(Frontend, "{} is not a GPU trace of a supported version", filename);
+            return false;
+        }
+
+        using Clock = std::chrono::steady_clock;
+        Clock::duration cpu_time{};
+        GLuint query = 0;
+
+        GPUTrace::Reader::Record record;
+        while (reader.ReadRecord(record)) {
+            if (sdl_window != nullptr && !sdl_window->IsOpen()) {
+                break;
+            }
+            if (query == 0) {
+                glGenQueries(1, &query);
+                glBeginQuery(GL_TIME_ELAPSED, query);
+            }
+
+            switch (record.type) {
+            case GPUTrace::RecordType::EngineState: {
+                const auto engine_state = GPUTrace::DecodeEngineState(record.data);
+                if (!engine_state || !system.GPU().SetEngineState(*engine_state)) {
+                    LOG_CRITICAL(Frontend, "Malformed engine state");
+                    return false;
+                }
+                break;
+            }
+            case GPUTrace::RecordType::MemoryMap:
+                if (record.data.size() % sizeof(GPUTrace::MappedRange) != 0) {
+                    LOG_CRITICAL(Frontend, "Malformed memory map");
+                    return false;
+                }
+                ApplyMemoryMap(record.data);
+                break;
+            case GPUTrace::RecordType::MemoryUpdate:
+                if (record.data.size() < sizeof(u64)) {
+                    LOG_CRITICAL(Frontend, "Malformed memory update");
+                    return false;
+                }
+                ApplyMemoryUpdate(record.data);
+                break;
+            case GPUTrace::RecordType::CommandList: {
+                GPUTrace::CommandList command_list;
+                if (record.data.size() != sizeof(command_list)) {
+                    LOG_CRITICAL(Frontend, "Malformed command list");
+                    return false;
+                }
+                std::memcpy(&command_list, record.data.data(), sizeof(command_list));
+
+                const auto start = Clock::now();
+                system.GPU().ProcessCommandList(command_list.gpu_addr, command_list.size);
+                cpu_time += Clock::now() - start;
+                break;
+            }
+            case GPUTrace::RecordType::Flip: {
+                GPUTrace::Flip flip;
+                if (record.data.size() != sizeof(flip)) {
+                    LOG_CRITICAL(Frontend, "Malformed flip");
+                    return false;
+                }
+                std::memcpy(&flip, record.data.data(), sizeof(flip));
+
+                const Tegra::FramebufferConfig framebuffer = GPUTrace::DecodeFlip(flip);
+                const auto start = Clock::now();
+                system.Renderer().SwapBuffers(framebuffer);
+                cpu_time += Clock::now() - start;
+
+                glEndQuery(GL_TIME_ELAPSED);
+                frame_queries.push_back(query);
+                query = 0;
+                frames.push_back(
+                    {std::chrono::duration<double, std::milli>(cpu_time).count(), 0.0});
+                cpu_time = {};
+                break;
+            }
+            default:
+                LOG_WARNING(Frontend, "Skipping unknown record type {}",
+                            static_cast<u32>(record.type));
+                break;
+            }
+        }
+
+        if (query != 0) {
+            // Work after the last flip belongs to no frame
+            glEndQuery(GL_TIME_ELAPSED);
+            glDeleteQueries(1, &query);
+        }
+
+        // Waits for the GPU to finish the frames
+        for (std::size_t i = 0; i < frame_queries.size(); ++i) {
+            GLuint64 elapsed_ns = 0;
+            glGetQueryObjectui64v(frame_queries[i], GL_QUERY_RESULT, &elapsed_ns);
+            frames[i].gpu_ms = elapsed_ns / 1000000.0;
+        }
+        glDeleteQueries(static_cast<GLsizei>(frame_queries.size()), frame_queries.data());
+        frame_queries.clear();
+        return true;
+    }
+
+private:
+    static bool SameRange(const GPUTrace::MappedRange& a, const GPUTrace::MappedRange& b) {
+        return a.gpu_addr == b.gpu_addr && a.cpu_addr == b.cpu_addr && a.size == b.size;
+    }
+
+    /// Replaces the GPU mappings with the recorded ones, backing the memory they use
+    void ApplyMemoryMap(const std::vector<u8>& data) {
+        std::vector<GPUTrace::MappedRange> ranges(data.size() / sizeof(GPUTrace::MappedRange));
+        std::memcpy(ranges.data(), data.data(), data.size());
+
+        auto& memory_manager = *system.GPU().memory_manager;
+        auto& rasterizer = system.Renderer().Rasterizer();
+
+        // Mappings that stay the same are left alone, so the caches of their memory stay valid
+        for (const auto& range : mapped_ranges) {
+            if (std::none_of(ranges.begin(), ranges.end(),
+                             [&](const auto& other) { return SameRange(range, other); })) {
+                rasterizer.FlushAndInvalidateRegion(range.gpu_addr, range.size);
+                memory_manager.UnmapBuffer(range.gpu_addr, range.size);
+            }
+        }
+        for (const auto& range : ranges) {
+            if (std::any_of(mapped_ranges.begin(), mapped_ranges.end(),
+                            [&](const auto& other) { return SameRange(range, other); })) {
+                continue;
+            }
+            BackMemory(range.cpu_addr, range.size);
+            memory_manager.AllocateSpace(range.gpu_addr, range.size,
+                                         Tegra::MemoryManager::PAGE_SIZE);
+            memory_manager.MapBufferEx(range.cpu_addr, range.gpu_addr, range.size);
+        }
+        mapped_ranges = std::move(ranges);
+    }
+
+    /// Maps zeroed memory to the parts of a CPU range that aren't backed yet
+    void BackMemory(VAddr address, u64 size) {
+        using Interval = boost::icl::interval_set<VAddr>::interval_type;
+        const VAddr begin = Common::AlignDown(address, Memory::PAGE_SIZE);
+        const VAddr end = Common::AlignUp(address + size, Memory::PAGE_SIZE);
+
+        boost::icl::interval_set<VAddr> missing;
+        missing.add(Interval::right_open(begin, end));
+        missing -= backed_memory;
+
+        auto& vm_manager = system.CurrentProcess()->vm_manager;
+        for (const auto& interval : missing) {
+            const u64 block_size = interval.upper() - interval.lower();
+            const auto result = vm_manager.MapMemoryBlock(
+                interval.lower(), std::make_shared<std::vector<u8>>(block_size), 0, block_size,
+                Kernel::MemoryState::Heap);
+            ASSERT(result.Succeeded());
+        }
+        backed_memory.add(Interval::right_open(begin, end));
+    }
+
+    /// Writes the pages of a memory update that differ from the current memory contents
+    void ApplyMemoryUpdate(const std::vector<u8>& data) {
+        u64 address;
+        std::memcpy(&address, data.data(), sizeof(address));
+        const u8* const contents = data.data() + sizeof(address);
+        const u64 size = data.size() - sizeof(address);
+
+        // Unchanged pages are skipped, writing them would invalidate the caches of their memory
+        for (u64 offset = 0; offset < size; offset += Memory::PAGE_SIZE) {
+            const u64 page_size = std::min<u64>(Memory::PAGE_SIZE, size - offset);
+            const u8* const current = Memory::GetPointer(address + offset);
+            if (current == nullptr || std::memcmp(current, contents + offset, page_size) != 0) {
+                Memory::WriteBlock(address + offset, contents + offset, page_size);
+            }
+        }
+    }
+
+    Core::System& system;
+    std::vector<GPUTrace::MappedRange> mapped_ranges;
+    boost::icl::interval_set<VAddr> backed_memory;
+    /// Time elapsed queries of the frames replayed so far
+    std::vector<GLuint> frame_queries;
+};
+
+/// Application entry point
+int main(int argc, char** argv) {
+    Config config;
+
+    int option_index = 0;
+    char* endarg;
+    std::string filepath;
+
+    u32 loops = 1;
+    ReportFormat report_format = ReportFormat::Text;
+    bool offscreen = false;
+
+    static struct option long_options[] = {
+        {"loops", required_argument, 0, 'l'},
+        {"report", required_argument, 0, 'r'},
+        {"offscreen", no_argument, 0, 'o'},
+        {"help", no_argument, 0, 'h'},
+        {"version", no_argument, 0, 'v'},
+        {0, 0, 0, 0},
+    };
+
+    while (optind < argc) {
+        char arg = getopt_long(argc, argv, "l:r:ohv", long_options, &option_index);
+        if (arg != -1) {
+            switch (arg) {
+            case 'l':
+                errno = 0;
+                loops = strtoul(optarg, &endarg, 0);
+                if (endarg == optarg || loops == 0)
+                    errno = EINVAL;
+                if (errno != 0) {
+                    perror("--loops");
+                    exit(1);
+                }
+                break;
+            case 'r':
+                if (std::string(optarg) == "text") {
+                    report_format = ReportFormat::Text;
+                } else if (std::string(optarg) == "json") {
+                    report_format = ReportFormat::Json;
+                } else {
+                    std::cerr << "--report: Unknown format " << optarg << '\n';
+                    exit(1);
+                }
+                break;
+            case 'o':
+#ifdef HAS_EGL
+                offscreen = true;
+#else
+                std::cerr << "--offscreen: yuzu-gpu-replay was built without EGL\n";
+                exit(1);
+#endif
+                break;
+            case 'h':
+                PrintHelp(argv[0]);
+                return 0;
+            case 'v':
+                PrintVersion();
+                return 0;
+            }
+        } else {
+            filepath = argv[optind];
+            optind++;
+        }
+    }
+
+    InitializeLogging();
+
+    if (filepath.empty()) {
+        LOG_CRITICAL(Frontend, "No GPU trace specified");
+        return -1;
+    }
+
+    // The trace is replayed on this thread, which holds the context throughout, as fast as it can
+    Settings::values.use_multi_core = false;
+    Settings::values.use_asynchronous_gpu_emulation = false;
+    Settings::values.use_frame_limit = false;
+    Settings::Apply();
+
+    std::unique_ptr<EmuWindow_SDL2> sdl_window;
+#ifdef HAS_EGL
+    std::unique_ptr<EmuWindow_EGL> egl_window;
+    if (offscreen) {
+        egl_window = std::make_unique<EmuWindow_EGL>(0, std::string{});
+    }
+#endif
+    if (!offscreen) {
+        sdl_window = std::make_unique<EmuWindow_SDL2>(false);
+    }
+#ifdef HAS_EGL
+    Core::Frontend::EmuWindow* const emu_window =
+        offscreen ? static_cast<Core::Frontend::EmuWindow*>(egl_window.get()) : sdl_window.get();
+#else
+    Core::Frontend::EmuWindow* const emu_window = sdl_window.get();
+#endif
+    emu_window->MakeCurrent();
+
+    Core::System& system{Core::System::GetInstance()};
+    if (system.InitWithoutApplication(*emu_window) != Core::System::ResultStatus::Success) {
+        LOG_CRITICAL(Frontend, "Failed to initialize the emulated system");
+        return -1;
+    }
+    SCOPE_EXIT({ system.Shutdown(); });
+
+    TraceReplayer replayer(system);
+    std::vector<FrameTimes> frames;
+    for (u32 loop = 0; loop < loops; ++loop) {
+        frames.clear();
+        if (!replayer.Replay(filepath, sdl_window.get(), frames)) {
+            return -1;
+        }
+    }
+
+    PrintReport(report_format, frames);
+    return 0;
+}
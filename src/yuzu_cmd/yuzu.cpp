@@ -2,14 +2,19 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
+#include <cmath>
 #include <iostream>
 #include <memory>
+#include <numeric>
 #include <string>
 #include <thread>
+#include <vector>
 
 #include <fmt/ostream.h>
 
 #include "common/common_paths.h"
+#include "common/file_util.h"
 #include "common/logging/backend.h"
 #include "common/logging/filter.h"
 #include "common/logging/log.h"
@@ -19,10 +24,14 @@
 #include "common/string_util.h"
 #include "core/core.h"
 #include "core/gdbstub/gdbstub.h"
+#include "core/hle/service/ipc_profiler.h"
 #include "core/loader/loader.h"
 #include "core/settings.h"
 #include "yuzu_cmd/config.h"
 #include "yuzu_cmd/emu_window/emu_window_sdl2.h"
+#ifdef HAS_EGL
+#include "yuzu_cmd/emu_window/emu_window_egl.h"
+#endif
 
 #include <getopt.h>
 #include "core/crypto/key_manager.h"
@@ -51,6 +60,29 @@ static void PrintHelp(const char* argv0) {
               << " [options] <filename>\n"
                  "-g, --gdbport=NUMBER  Enable gdb stub on port NUMBER\n"
                  "-f, --fullscreen     Start in fullscreen mode\n"
+                 "-p, --profile-boot    Exit after the first frame and print the boot times\n"
+                 "-b, --benchmark-frames=NUMBER\n"
+                 "                      Run NUMBER frames without frame limiting, then print the\n"
+                 "                      performance statistics and exit\n"
+                 "-n, --no-present      Emulate frames without drawing them to the window\n"
+                 "-r, --report=FORMAT   Print the benchmark statistics as text (default) or json\n"
+                 "-c, --frames-csv=FILE Write the timings of the benchmarked frames, or of the\n"
+                 "                      last frames before exiting, to FILE as CSV\n"
+                 "-o, --offscreen       Render offscreen through EGL, without a window\n"
+                 "-d, --dump-frames=NUMBER\n"
+                 "                      With --offscreen, write every NUMBER-th frame to the\n"
+                 "                      frames directory of the user directory\n"
+                 "-t, --trace-gpu=FILE  Record the GPU work of some frames to FILE, for\n"
+                 "                      yuzu-gpu-replay\n"
+                 "-T, --trace-frames=FIRST,COUNT\n"
+                 "                      With --trace-gpu, record COUNT frames after the first\n"
+                 "                      FIRST ones (default 0,1)\n"
+                 "-m, --movie-record=FILE\n"
+                 "                      Record the input and event timing of the session to FILE\n"
+                 "-M, --movie-play=FILE Play back the input and event timing recorded to FILE,\n"
+                 "                      which with --benchmark-frames gives repeatable benchmarks\n"
+                 "-s, --ipc-stats=FILE  Write the call counts and host times of the HLE service\n"
+                 "                      commands to FILE as CSV before exiting\n"
                  "-h, --help            Display this help and exit\n"
                  "-v, --version         Output version information and exit\n";
 }
@@ -59,6 +91,145 @@ static void PrintVersion() {
     std::cout << "yuzu " << Common::g_scm_branch << " " << Common::g_scm_desc << std::endl;
 }
 
+enum class ReportFormat {
+    Text,
+    Json,
+};
+
+/// Quotes a string for JSON, the names reported only ever need quotes and backslashes escaped
+static std::string JsonString(const char* str) {
+    std::string quoted = "\"";
+    for (; *str != '\0'; ++str) {
+        if (*str == '"' || *str == '\\') {
+            quoted += '\\';
+        }
+        quoted += *str;
+    }
+    return quoted + '"';
+}
+
+/// Value below which the given fraction of the sorted samples lies, by nearest rank
+static double Percentile(const std::vector<double>& sorted, double fraction) {
+    if (sorted.empty()) {
+        return 0.0;
+    }
+    const auto rank = static_cast<std::size_t>(std::ceil(fraction * sorted.size()));
+    return sorted[std::clamp<std::size_t>(rank, 1, sorted.size()) - 1];
+}
+
+/// Prints the performance statistics of a benchmark run to stdout
+static void PrintBenchmarkReport(ReportFormat format, u64 frames,
+                                 const Core::PerfStats::Results& results,
+                                 const std::vector<Core::PerfStats::FrameSample>& samples) {
+    std::vector<double> frame_times;
+    std::vector<double> frame_lengths;
+    double gpu_time = 0.0;
+    double present_time = 0.0;
+    double limiter_time = 0.0;
+    for (const auto& sample : samples) {
+        frame_times.push_back(sample.emulation_time);
+        frame_lengths.push_back(sample.length);
+        gpu_time += sample.gpu_time;
+        present_time += sample.present_time;
+        limiter_time += sample.limiter_time;
+    }
+    std::sort(frame_times.begin(), frame_times.end());
+    const double mean_ms =
+        frame_times.empty()
+            ? 0.0
+            : std::accumulate(frame_times.begin(), frame_times.end(), 0.0) / frame_times.size() *
+                  1000.0;
+    const double p50_ms = Percentile(frame_times, 0.50) * 1000.0;
+    const double p90_ms = Percentile(frame_times, 0.90) * 1000.0;
+    const double p99_ms = Percentile(frame_times, 0.99) * 1000.0;
+    const double max_ms = frame_times.empty() ? 0.0 : frame_times.back() * 1000.0;
+    const double low_1_percent_fps = Core::LowFrameRate(frame_lengths, 0.01);
+    const double low_0_1_percent_fps = Core::LowFrameRate(std::move(frame_lengths), 0.001);
+    const double per_frame_ms = samples.empty() ? 0.0 : 1000.0 / samples.size();
+    const double gpu_ms = gpu_time * per_frame_ms;
+    const double present_ms = present_time * per_frame_ms;
+    const double limiter_ms = limiter_time * per_frame_ms;
+    const Common::MicroProfileTimerTotals profile = Common::GetMicroProfileTimerTotals();
+    const auto bucket_ms = Core::PerfStats::HistogramBucketLength * 1000.0;
+    const auto& histogram = results.frame_length_histogram;
+
+    if (format == ReportFormat::Text) {
+        fmt::print("Frames: {}\n", frames);
+        fmt::print("Emulation speed: {:.1f}%\n", results.emulation_speed * 100.0);
+        fmt::print("Game: {:.1f} FPS, system: {:.1f} FPS\n", results.game_fps,
+                   results.system_fps);
+        fmt::print("Frame time: mean {:.3f} ms, p50 {:.3f} ms, p90 {:.3f} ms, p99 {:.3f} ms, "
+                   "max {:.3f} ms\n",
+                   mean_ms, p50_ms, p90_ms, p99_ms, max_ms);
+        fmt::print("Lows: 1% {:.1f} FPS, 0.1% {:.1f} FPS\n", low_1_percent_fps,
+                   low_0_1_percent_fps);
+        fmt::print("Per frame: GPU {:.3f} ms, present {:.3f} ms, limiter {:.3f} ms\n", gpu_ms,
+                   present_ms, limiter_ms);
+        fmt::print("Frame length histogram:\n");
+        for (std::size_t i = 0; i < histogram.size(); ++i) {
+            if (histogram[i] == 0) {
+                continue;
+            }
+            if (i + 1 == histogram.size()) {
+                fmt::print("  {:>3.0f}+ ms: {}\n", i * bucket_ms, histogram[i]);
+            } else {
+                fmt::print("  {:>3.0f}-{:.0f} ms: {}\n", i * bucket_ms, (i + 1) * bucket_ms,
+                           histogram[i]);
+            }
+        }
+        fmt::print("Profiled over {} frames:\n", profile.frames);
+        for (const auto& timer : profile.timers) {
+            fmt::print("  {}/{}: {} calls, {:.3f} ms total, {:.3f} ms at most per frame\n",
+                       timer.group, timer.name, timer.calls, timer.total_ms, timer.max_frame_ms);
+        }
+        return;
+    }
+
+    std::string timers;
+    for (const auto& timer : profile.timers) {
+        if (!timers.empty()) {
+            timers += ',';
+        }
+        timers += fmt::format(
+            "{{\"group\":{},\"name\":{},\"calls\":{},\"total_ms\":{:.6f},\"max_frame_ms\":{:.6f}}}",
+            JsonString(timer.group), JsonString(timer.name), timer.calls, timer.total_ms,
+            timer.max_frame_ms);
+    }
+    std::string buckets;
+    for (const u32 count : histogram) {
+        if (!buckets.empty()) {
+            buckets += ',';
+        }
+        buckets += std::to_string(count);
+    }
+    fmt::print("{{\"frames\":{},\"emulation_speed\":{:.6f},\"game_fps\":{:.6f},"
+               "\"system_fps\":{:.6f},\"frametime_ms\":{{\"mean\":{:.6f},\"p50\":{:.6f},"
+               "\"p90\":{:.6f},\"p99\":{:.6f},\"max\":{:.6f}}},"
+               "\"low_fps\":{{\"1%\":{:.6f},\"0.1%\":{:.6f}}},"
+               "\"per_frame_ms\":{{\"gpu\":{:.6f},\"present\":{:.6f},\"limiter\":{:.6f}}},"
+               "\"histogram\":{{\"bucket_ms\":{:.1f},\"counts\":[{}]}},"
+               "\"microprofile\":{{\"frames\":{},\"timers\":[{}]}}}}\n",
+               frames, results.emulation_speed, results.game_fps, results.system_fps, mean_ms,
+               p50_ms, p90_ms, p99_ms, max_ms, low_1_percent_fps, low_0_1_percent_fps, gpu_ms,
+               present_ms, limiter_ms, bucket_ms, buckets, profile.frames, timers);
+}
+
+/// Writes frame timings to a CSV file, returns false if it couldn't be written
+static bool WriteFramesCsv(const std::string& path,
+                           const std::vector<Core::PerfStats::FrameSample>& frames) {
+    const std::string csv = Core::FramesToCsv(frames);
+    FileUtil::IOFile file(path, "w");
+    return file.IsOpen() && file.WriteString(csv) == csv.size();
+}
+
+/// Writes the stats of the HLE service commands to a CSV file, returns false if it couldn't be
+/// written
+static bool WriteIPCStatsCsv(const std::string& path) {
+    const std::string csv = Service::IPCProfiler::StatsToCsv(Service::IPCProfiler::GetStats());
+    FileUtil::IOFile file(path, "w");
+    return file.IsOpen() && file.WriteString(csv) == csv.size();
+}
+
 static void InitializeLogging() {
     Log::Filter log_filter(Log::Level::Debug);
     log_filter.ParseFilterString(Settings::values.log_filter);
@@ -91,17 +262,43 @@ int main(int argc, char** argv) {
     std::string filepath;
 
     bool fullscreen = false;
+    bool profile_boot = false;
+    u64 benchmark_frames = 0;
+    bool skip_present = false;
+    ReportFormat report_format = ReportFormat::Text;
+    std::string frames_csv_path;
+    bool offscreen = false;
+    u32 dump_interval = 0;
+    std::string gpu_trace_path;
+    u32 gpu_trace_first_frame = 0;
+    u32 gpu_trace_num_frames = 1;
+    std::string movie_record_path;
+    std::string movie_play_path;
+    std::string ipc_stats_path;
 
     static struct option long_options[] = {
         {"gdbport", required_argument, 0, 'g'},
         {"fullscreen", no_argument, 0, 'f'},
+        {"profile-boot", no_argument, 0, 'p'},
+        {"benchmark-frames", required_argument, 0, 'b'},
+        {"no-present", no_argument, 0, 'n'},
+        {"report", required_argument, 0, 'r'},
+        {"frames-csv", required_argument, 0, 'c'},
+        {"offscreen", no_argument, 0, 'o'},
+        {"dump-frames", required_argument, 0, 'd'},
+        {"trace-gpu", required_argument, 0, 't'},
+        {"trace-frames", required_argument, 0, 'T'},
+        {"movie-record", required_argument, 0, 'm'},
+        {"movie-play", required_argument, 0, 'M'},
+        {"ipc-stats", required_argument, 0, 's'},
         {"help", no_argument, 0, 'h'},
         {"version", no_argument, 0, 'v'},
         {0, 0, 0, 0},
     };
 
     while (optind < argc) {
-        char arg = getopt_long(argc, argv, "g:fhv", long_options, &option_index);
+        char arg =
+            getopt_long(argc, argv, "g:fpb:nr:c:od:t:T:m:M:s:hv", long_options, &option_index);
         if (arg != -1) {
             switch (arg) {
             case 'g':
@@ -119,6 +316,81 @@ int main(int argc, char** argv) {
                 fullscreen = true;
                 LOG_INFO(Frontend, "Starting in fullscreen mode...");
                 break;
+            case 'p':
+                profile_boot = true;
+                break;
+            case 'b':
+                errno = 0;
+                benchmark_frames = strtoull(optarg, &endarg, 0);
+                if (endarg == optarg || benchmark_frames == 0)
+                    errno = EINVAL;
+                if (errno != 0) {
+                    perror("--benchmark-frames");
+                    exit(1);
+                }
+                break;
+            case 'n':
+                skip_present = true;
+                break;
+            case 'r':
+                if (std::string(optarg) == "text") {
+                    report_format = ReportFormat::Text;
+                } else if (std::string(optarg) == "json") {
+                    report_format = ReportFormat::Json;
+                } else {
+                    std::cerr << "--report: Unknown format " << optarg << '\n';
+                    exit(1);
+                }
+                break;
+            case 'c':
+                frames_csv_path = optarg;
+                break;
+            case 'o':
+#ifdef HAS_EGL
+                offscreen = true;
+#else
+                std::cerr << "--offscreen: yuzu-cmd was built without EGL\n";
+                exit(1);
+#endif
+                break;
+            case 'd':
+                errno = 0;
+                dump_interval = strtoul(optarg, &endarg, 0);
+                if (endarg == optarg)
+                    errno = EINVAL;
+                if (errno != 0) {
+                    perror("--dump-frames");
+                    exit(1);
+                }
+                break;
+            case 't':
+                gpu_trace_path = optarg;
+                break;
+            case 'T':
+                errno = 0;
+                gpu_trace_first_frame = strtoul(optarg, &endarg, 0);
+                if (endarg == optarg || *endarg != ',')
+                    errno = EINVAL;
+                if (errno == 0) {
+                    const char* const count_arg = endarg + 1;
+                    gpu_trace_num_frames = strtoul(count_arg, &endarg, 0);
+                    if (endarg == count_arg || gpu_trace_num_frames == 0)
+                        errno = EINVAL;
+                }
+                if (errno != 0) {
+                    perror("--trace-frames");
+                    exit(1);
+                }
+                break;
+            case 'm':
+                movie_record_path = optarg;
+                break;
+            case 'M':
+                movie_play_path = optarg;
+                break;
+            case 's':
+                ipc_stats_path = optarg;
+                break;
             case 'h':
                 PrintHelp(argv[0]);
                 return 0;
@@ -153,12 +425,34 @@ int main(int argc, char** argv) {
     // Apply the command line arguments
     Settings::values.gdbstub_port = gdb_port;
     Settings::values.use_gdbstub = use_gdbstub;
+    Settings::values.skip_present = skip_present;
+    if (benchmark_frames != 0) {
+        Settings::values.use_frame_limit = false;
+    }
     Settings::Apply();
 
-    std::unique_ptr<EmuWindow_SDL2> emu_window{std::make_unique<EmuWindow_SDL2>(fullscreen)};
+    // Only a real window can be closed, the offscreen one runs until the emulation stops
+    std::unique_ptr<EmuWindow_SDL2> sdl_window;
+#ifdef HAS_EGL
+    std::unique_ptr<EmuWindow_EGL> egl_window;
+    if (offscreen) {
+        egl_window = std::make_unique<EmuWindow_EGL>(
+            dump_interval, FileUtil::GetUserPath(FileUtil::UserPath::UserDir) + "frames" DIR_SEP);
+    }
+#endif
+    if (!offscreen) {
+        sdl_window = std::make_unique<EmuWindow_SDL2>(fullscreen);
+    }
+#ifdef HAS_EGL
+    Core::Frontend::EmuWindow* const emu_window =
+        offscreen ? static_cast<Core::Frontend::EmuWindow*>(egl_window.get()) : sdl_window.get();
+#else
+    Core::Frontend::EmuWindow* const emu_window = sdl_window.get();
+#endif
 
-    if (!Settings::values.use_multi_core) {
-        // Single core mode must acquire OpenGL context for entire emulation session
+    if (!Settings::values.use_multi_core && !Settings::values.use_asynchronous_gpu_emulation) {
+        // Single core mode must acquire OpenGL context for entire emulation session. A GPU thread
+        // takes it whenever it needs it instead, as the cores do in multi core mode.
         emu_window->MakeCurrent();
     }
 
@@ -202,8 +496,59 @@ int main(int argc, char** argv) {
 
     Core::Telemetry().AddField(Telemetry::FieldType::App, "Frontend", "SDL");
 
-    while (emu_window->IsOpen()) {
+    if (!gpu_trace_path.empty()) {
+        system.StartGPURecording(gpu_trace_path, gpu_trace_first_frame, gpu_trace_num_frames);
+    }
+
+    if (!movie_play_path.empty()) {
+        if (!system.StartMoviePlayback(movie_play_path)) {
+            LOG_CRITICAL(Frontend, "Failed to play movie {}", movie_play_path);
+            return -1;
+        }
+    } else if (!movie_record_path.empty()) {
+        system.StartMovieRecording(movie_record_path);
+    }
+
+    if (benchmark_frames != 0) {
+        // Profile everything, MicroProfile keeps its totals until the program exits
+        MicroProfileSetEnableAllGroups(true);
+        system.GetAndResetPerfStats();
+        system.perf_stats.StartRecordingFrames();
+    }
+
+    std::vector<Core::PerfStats::FrameSample> frames;
+
+    while (!sdl_window || sdl_window->IsOpen()) {
         system.RunLoop();
+
+        if (benchmark_frames != 0 && system.perf_stats.GetTotalSystemFrames() >= benchmark_frames) {
+            // A slice may end a few frames past the target, only the first ones are reported
+            frames = system.perf_stats.TakeRecordedFrames();
+            frames.resize(std::min<std::size_t>(frames.size(), benchmark_frames));
+            PrintBenchmarkReport(report_format, benchmark_frames, system.GetAndResetPerfStats(),
+                                 frames);
+            break;
+        }
+
+        if (profile_boot && system.boot_timeline.IsComplete()) {
+            std::cout << "Booted in " << system.boot_timeline.GetTotalTime().count() / 1000
+                      << " ms\n"
+                      << system.boot_timeline.FormatPhases();
+            break;
+        }
+    }
+
+    if (!frames_csv_path.empty()) {
+        if (frames.empty()) {
+            frames = system.perf_stats.GetFrameHistory();
+        }
+        if (!WriteFramesCsv(frames_csv_path, frames)) {
+            LOG_ERROR(Frontend, "Could not write the frame timings to {}", frames_csv_path);
+        }
+    }
+
+    if (!ipc_stats_path.empty() && !WriteIPCStatsCsv(ipc_stats_path)) {
+        LOG_ERROR(Frontend, "Could not write the IPC stats to {}", ipc_stats_path);
     }
 
     return 0;